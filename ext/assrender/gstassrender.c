@@ -107,6 +107,7 @@ static void gst_ass_render_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static void gst_ass_render_finalize (GObject * object);
+static void gst_ass_render_clear_cached_images (GstAssRender * render);
 
 static GstStateChangeReturn gst_ass_render_change_state (GstElement * element,
     GstStateChange transition);
@@ -287,11 +288,37 @@ gst_ass_render_finalize (GObject * object)
     ass_library_done (render->ass_library);
   }
 
+  gst_ass_render_clear_cached_images (render);
+
   g_mutex_clear (&render->ass_mutex);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* Up to this many images, each one gets its own overlay rectangle that is
+ * kept between compositions. Above, they are all blitted into one. */
+#define MAX_CACHED_IMAGES 128
+
+typedef struct
+{
+  /* the image, as returned by libass */
+  const guint8 *bitmap;
+  gint w, h, stride;
+  guint32 color;
+  gint dst_x, dst_y;
+
+  GstBuffer *buffer;
+  GstVideoOverlayRectangle *rectangle;
+} GstAssRenderCachedImage;
+
+static void
+gst_ass_render_cached_image_free (GstAssRenderCachedImage * cached)
+{
+  gst_buffer_unref (cached->buffer);
+  gst_video_overlay_rectangle_unref (cached->rectangle);
+  g_slice_free (GstAssRenderCachedImage, cached);
+}
+
 static void
 gst_ass_render_reset_composition (GstAssRender * render)
 {
@@ -301,6 +328,14 @@ gst_ass_render_reset_composition (GstAssRender * render)
   }
 }
 
+static void
+gst_ass_render_clear_cached_images (GstAssRender * render)
+{
+  g_list_free_full (render->cached_images,
+      (GDestroyNotify) gst_ass_render_cached_image_free);
+  render->cached_images = NULL;
+}
+
 static void
 gst_ass_render_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -398,6 +433,7 @@ gst_ass_render_change_state (GstElement * element, GstStateChange transition)
       render->track_init_ok = FALSE;
       render->renderer_init_ok = FALSE;
       gst_ass_render_reset_composition (render);
+      gst_ass_render_clear_cached_images (render);
       g_mutex_unlock (&render->ass_mutex);
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
@@ -783,6 +819,7 @@ gst_ass_render_negotiate (GstAssRender * render, GstCaps * caps)
 
   /* Clear cached composition */
   gst_ass_render_reset_composition (render);
+  gst_ass_render_clear_cached_images (render);
 
   /* Clear any pending reconfigure flag */
   gst_pad_check_reconfigure (render->srcpad);
@@ -1053,7 +1090,8 @@ gst_ass_render_process_text (GstAssRender * render, GstBuffer * buffer,
 }
 
 static GstVideoOverlayComposition *
-gst_ass_render_composite_overlay (GstAssRender * render, ASS_Image * images)
+gst_ass_render_composite_single_overlay (GstAssRender * render,
+    ASS_Image * images)
 {
   GstVideoOverlayComposition *composition;
   GstVideoOverlayRectangle *rectangle;
@@ -1125,6 +1163,136 @@ gst_ass_render_composite_overlay (GstAssRender * render, ASS_Image * images)
   return composition;
 }
 
+static GstAssRenderCachedImage *
+gst_ass_render_take_cached_image (GstAssRender * render, ASS_Image * image)
+{
+  GList *l;
+
+  for (l = render->cached_images; l; l = l->next) {
+    GstAssRenderCachedImage *cached = l->data;
+
+    if (cached->bitmap == image->bitmap && cached->w == image->w
+        && cached->h == image->h && cached->stride == image->stride
+        && cached->color == image->color) {
+      render->cached_images = g_list_delete_link (render->cached_images, l);
+      return cached;
+    }
+  }
+
+  return NULL;
+}
+
+/* Builds an overlay rectangle for @image, reusing the one of the previous
+ * composition if libass returned the same bitmap again */
+static GstAssRenderCachedImage *
+gst_ass_render_get_cached_image (GstAssRender * render, ASS_Image * image,
+    gdouble hscale, gdouble vscale)
+{
+  GstAssRenderCachedImage *cached;
+  GstVideoOverlayRectangle *rectangle;
+
+  cached = gst_ass_render_take_cached_image (render, image);
+
+  if (!cached) {
+    GstVideoMeta *vmeta;
+    GstMapInfo map;
+    ASS_Image single;
+    gpointer data;
+    gint stride;
+
+    cached = g_slice_new0 (GstAssRenderCachedImage);
+    cached->bitmap = image->bitmap;
+    cached->w = image->w;
+    cached->h = image->h;
+    cached->stride = image->stride;
+    cached->color = image->color;
+
+    cached->buffer = gst_buffer_new_and_alloc (4 * image->w * image->h);
+    vmeta = gst_buffer_add_video_meta (cached->buffer,
+        GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB,
+        image->w, image->h);
+
+    if (!gst_video_meta_map (vmeta, 0, &map, &data, &stride,
+            GST_MAP_READWRITE)) {
+      GST_ERROR_OBJECT (render, "Failed to map overlay buffer");
+      gst_buffer_unref (cached->buffer);
+      g_slice_free (GstAssRenderCachedImage, cached);
+      return NULL;
+    }
+
+    single = *image;
+    single.next = NULL;
+    blit_bgra_premultiplied (render, &single, data, image->w, image->h,
+        stride, -image->dst_x, -image->dst_y);
+    gst_video_meta_unmap (vmeta, 0, &map);
+  } else if (cached->dst_x == image->dst_x && cached->dst_y == image->dst_y) {
+    return cached;
+  }
+
+  /* new image, or the same one at another position */
+  rectangle = gst_video_overlay_rectangle_new_raw (cached->buffer,
+      hscale * image->dst_x, vscale * image->dst_y, hscale * image->w,
+      vscale * image->h, GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
+  if (cached->rectangle)
+    gst_video_overlay_rectangle_unref (cached->rectangle);
+  cached->rectangle = rectangle;
+  cached->dst_x = image->dst_x;
+  cached->dst_y = image->dst_y;
+
+  return cached;
+}
+
+static GstVideoOverlayComposition *
+gst_ass_render_composite_overlay (GstAssRender * render, ASS_Image * images)
+{
+  GstVideoOverlayComposition *composition = NULL;
+  GList *cached_images = NULL;
+  ASS_Image *image;
+  gdouble hscale, vscale;
+  guint n_images = 0;
+
+  for (image = images; image; image = image->next)
+    n_images++;
+
+  if (n_images > MAX_CACHED_IMAGES) {
+    gst_ass_render_clear_cached_images (render);
+    return gst_ass_render_composite_single_overlay (render, images);
+  }
+
+  hscale = (gdouble) render->info.width / (gdouble) render->ass_frame_width;
+  vscale = (gdouble) render->info.height / (gdouble) render->ass_frame_height;
+
+  /* The rectangles are blended in the order of the images, which gives the
+   * same result as blitting them all into a single one. Only the images
+   * that weren't part of the previous composition are blitted again. */
+  for (image = images; image; image = image->next) {
+    GstAssRenderCachedImage *cached;
+
+    if (image->w <= 0 || image->h <= 0 || (image->color & 0xff) == 0xff)
+      continue;
+
+    cached = gst_ass_render_get_cached_image (render, image, hscale, vscale);
+    if (!cached)
+      continue;
+
+    if (!composition)
+      composition = gst_video_overlay_composition_new (cached->rectangle);
+    else
+      gst_video_overlay_composition_add_rectangle (composition,
+          cached->rectangle);
+
+    cached_images = g_list_prepend (cached_images, cached);
+  }
+
+  GST_LOG_OBJECT (render, "composited %u images, dropping %u unused ones",
+      n_images, g_list_length (render->cached_images));
+
+  gst_ass_render_clear_cached_images (render);
+  render->cached_images = g_list_reverse (cached_images);
+
+  return composition;
+}
+
 static gboolean
 gst_ass_render_push_frame (GstAssRender * render, GstBuffer * video_frame)
 {
@@ -83,6 +83,8 @@ struct _GstAssRender
 
   /* overlay stuff */
   GstVideoOverlayComposition *composition;
+  /* overlay rectangles of the last composited images, for reuse */
+  GList *cached_images;
   guint window_width, window_height;
   gboolean attach_compo_to_buffer;
 };
@@ -70,6 +70,7 @@
 #define DEFAULT_URL                    "localhost:5555"
 #define DEFAULT_TIMEOUT                30
 #define DEFAULT_QOS_DSCP               0
+#define DEFAULT_QUEUE_SIZE             0
 
 #define DSCP_MIN                       0
 #define DSCP_MAX                       63
@@ -91,7 +92,8 @@ enum
   PROP_USER_PASSWD,
   PROP_FILE_NAME,
   PROP_TIMEOUT,
-  PROP_QOS_DSCP
+  PROP_QOS_DSCP,
+  PROP_QUEUE_SIZE
 };
 
 /* Object class function declarations */
@@ -143,6 +145,9 @@ static void gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
 static void gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_wait_for_response (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_got_response_notify (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_queue_next_unlocked (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_queue_clear_unlocked (GstCurlBaseSink * sink);
+static GstFlowReturn gst_curl_base_sink_queue_drain (GstCurlBaseSink * sink);
 
 static void handle_transfer (GstCurlBaseSink * sink);
 static size_t transfer_data_buffer (void *curl_ptr, TransferBuffer * buf,
@@ -234,6 +239,23 @@ gst_curl_base_sink_class_init (GstCurlBaseSinkClass * klass)
           "Quality of Service, differentiated services code point (0 default)",
           DSCP_MIN, DSCP_MAX, DEFAULT_QOS_DSCP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstCurlBaseSink:queue-size:
+   *
+   * Number of buffers that can be queued for the transfer thread. With 0,
+   * each buffer is uploaded before the next one is accepted. Otherwise the
+   * streaming thread only blocks once the queue is full, and the transfer
+   * does not stall while upstream produces the next buffer. As buffers are
+   * uploaded later, a file name set while playing may also apply to
+   * buffers that were queued before it.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+      g_param_spec_uint ("queue-size", "Queue size",
+          "Number of buffers to queue for the upload (0 = upload every "
+          "buffer before accepting the next one)", 0, G_MAXUINT,
+          DEFAULT_QUEUE_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (element_class, &sinktemplate);
 }
@@ -255,6 +277,10 @@ gst_curl_base_sink_init (GstCurlBaseSink * sink)
   sink->error = NULL;
   sink->flow_ret = GST_FLOW_OK;
   sink->is_live = FALSE;
+  sink->queue_size = DEFAULT_QUEUE_SIZE;
+  g_queue_init (&sink->queue);
+  sink->queued_buffer = NULL;
+  sink->flushing = FALSE;
 }
 
 static void
@@ -334,6 +360,121 @@ gst_curl_base_sink_is_live (GstCurlBaseSink * sink)
   return result;
 }
 
+/* Hands the error of the transfer thread over to the streaming thread,
+ * called with the lock taken, which it releases */
+static GstFlowReturn
+gst_curl_base_sink_take_flow_return_unlocked (GstCurlBaseSink * sink)
+{
+  GstFlowReturn ret;
+  gchar *error;
+
+  error = sink->error;
+  sink->error = NULL;
+  ret = sink->flow_ret;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (error != NULL) {
+    GST_ERROR_OBJECT (sink, "%s", error);
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, ("%s", error), (NULL));
+    g_free (error);
+  }
+
+  return ret;
+}
+
+/* Makes the next queued buffer available to the transfer thread, if it is
+ * not busy with one already */
+static void
+gst_curl_base_sink_queue_next_unlocked (GstCurlBaseSink * sink)
+{
+  GstBuffer *buf;
+
+  if (sink->queued_buffer != NULL)
+    return;
+
+  while ((buf = g_queue_pop_head (&sink->queue))) {
+    if (!gst_buffer_map (buf, &sink->queued_map, GST_MAP_READ)) {
+      GST_WARNING_OBJECT (sink, "failed to map queued buffer");
+      gst_buffer_unref (buf);
+      continue;
+    }
+
+    sink->queued_buffer = buf;
+    sink->transfer_buf->ptr = sink->queued_map.data;
+    sink->transfer_buf->len = sink->queued_map.size;
+    sink->transfer_buf->offset = 0;
+    gst_curl_base_sink_transfer_thread_notify_unlocked (sink);
+    break;
+  }
+
+  /* wake up the streaming thread waiting for room in the queue */
+  g_cond_broadcast (&sink->transfer_cond->cond);
+}
+
+static void
+gst_curl_base_sink_queue_clear_unlocked (GstCurlBaseSink * sink)
+{
+  if (sink->queued_buffer != NULL) {
+    gst_buffer_unmap (sink->queued_buffer, &sink->queued_map);
+    gst_buffer_unref (sink->queued_buffer);
+    sink->queued_buffer = NULL;
+  }
+  g_queue_foreach (&sink->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&sink->queue);
+  g_cond_broadcast (&sink->transfer_cond->cond);
+}
+
+static GstFlowReturn
+gst_curl_base_sink_render_queued (GstCurlBaseSink * sink, GstBuffer * buf)
+{
+  if (gst_buffer_get_size (buf) == 0)
+    return GST_FLOW_OK;
+
+  GST_OBJECT_LOCK (sink);
+
+  if (sink->flow_ret != GST_FLOW_OK)
+    goto done;
+
+  if (sink->transfer_thread == NULL) {
+    if (!gst_curl_base_sink_transfer_start_unlocked (sink)) {
+      sink->flow_ret = GST_FLOW_ERROR;
+      goto done;
+    }
+  }
+
+  while (g_queue_get_length (&sink->queue) >= sink->queue_size &&
+      sink->flow_ret == GST_FLOW_OK && !sink->flushing) {
+    GST_LOG_OBJECT (sink, "queue full, waiting");
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+
+  if (sink->flushing) {
+    GST_OBJECT_UNLOCK (sink);
+    return GST_FLOW_FLUSHING;
+  }
+
+  if (sink->flow_ret == GST_FLOW_OK) {
+    g_queue_push_tail (&sink->queue, gst_buffer_ref (buf));
+    gst_curl_base_sink_queue_next_unlocked (sink);
+  }
+
+done:
+  return gst_curl_base_sink_take_flow_return_unlocked (sink);
+}
+
+/* Waits for the queued buffers to be uploaded */
+static GstFlowReturn
+gst_curl_base_sink_queue_drain (GstCurlBaseSink * sink)
+{
+  GST_OBJECT_LOCK (sink);
+  while ((sink->queued_buffer != NULL || !g_queue_is_empty (&sink->queue)) &&
+      sink->flow_ret == GST_FLOW_OK && !sink->flushing) {
+    GST_LOG_OBJECT (sink, "waiting for the queue to drain");
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+  return gst_curl_base_sink_take_flow_return_unlocked (sink);
+}
+
 static GstFlowReturn
 gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
@@ -342,12 +483,18 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   guint8 *data;
   size_t size;
   GstFlowReturn ret;
-  gchar *error;
 
   GST_LOG ("enter render");
 
   sink = GST_CURL_BASE_SINK (bsink);
 
+  GST_OBJECT_LOCK (sink);
+  if (sink->queue_size > 0) {
+    GST_OBJECT_UNLOCK (sink);
+    return gst_curl_base_sink_render_queued (sink, buf);
+  }
+  GST_OBJECT_UNLOCK (sink);
+
   gst_buffer_map (buf, &map, GST_MAP_READ);
   data = map.data;
   size = map.size;
@@ -390,16 +537,7 @@ done:
   gst_buffer_unmap (buf, &map);
 
   /* Hand over error from transfer thread to streaming thread */
-  error = sink->error;
-  sink->error = NULL;
-  ret = sink->flow_ret;
-  GST_OBJECT_UNLOCK (sink);
-
-  if (error != NULL) {
-    GST_ERROR_OBJECT (sink, "%s", error);
-    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, ("%s", error), (NULL));
-    g_free (error);
-  }
+  ret = gst_curl_base_sink_take_flow_return_unlocked (sink);
 
   GST_LOG ("exit render");
 
@@ -415,6 +553,7 @@ gst_curl_base_sink_event (GstBaseSink * bsink, GstEvent * event)
   switch (event->type) {
     case GST_EVENT_EOS:
       GST_DEBUG_OBJECT (sink, "received EOS");
+      gst_curl_base_sink_queue_drain (sink);
       gst_curl_base_sink_transfer_thread_close (sink);
       gst_curl_base_sink_wait_for_response (sink);
       break;
@@ -446,6 +585,7 @@ gst_curl_base_sink_start (GstBaseSink * bsink)
   sink->transfer_thread_close = FALSE;
   sink->new_file = TRUE;
   sink->flow_ret = GST_FLOW_OK;
+  sink->flushing = FALSE;
 
   if ((sink->fdset = gst_poll_new (TRUE)) == NULL) {
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
@@ -469,6 +609,10 @@ gst_curl_base_sink_stop (GstBaseSink * bsink)
     sink->fdset = NULL;
   }
 
+  GST_OBJECT_LOCK (sink);
+  gst_curl_base_sink_queue_clear_unlocked (sink);
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -482,6 +626,11 @@ gst_curl_base_sink_unlock (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "Flushing");
   gst_poll_set_flushing (sink->fdset, TRUE);
 
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = TRUE;
+  g_cond_broadcast (&sink->transfer_cond->cond);
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -495,6 +644,10 @@ gst_curl_base_sink_unlock_stop (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "No longer flushing");
   gst_poll_set_flushing (sink->fdset, FALSE);
 
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = FALSE;
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -542,6 +695,10 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
         gst_curl_base_sink_setup_dscp_unlocked (sink);
         GST_DEBUG_OBJECT (sink, "dscp set to %d", sink->qos_dscp);
         break;
+      case PROP_QUEUE_SIZE:
+        sink->queue_size = g_value_get_uint (value);
+        GST_DEBUG_OBJECT (sink, "queue size set to %u", sink->queue_size);
+        break;
       default:
         GST_DEBUG_OBJECT (sink, "invalid property id %d", prop_id);
         break;
@@ -607,6 +764,9 @@ gst_curl_base_sink_get_property (GObject * object, guint prop_id,
     case PROP_QOS_DSCP:
       g_value_set_int (value, sink->qos_dscp);
       break;
+    case PROP_QUEUE_SIZE:
+      g_value_set_uint (value, sink->queue_size);
+      break;
     default:
       GST_DEBUG_OBJECT (sink, "invalid property id");
       break;
@@ -1346,6 +1506,18 @@ gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink)
   sink->transfer_cond->data_available = FALSE;
   sink->transfer_cond->data_sent = TRUE;
   g_cond_signal (&sink->transfer_cond->cond);
+
+  /* in queued mode, continue with the next buffer right away, unless the
+   * transfer thread failed and there is nobody to send it anymore */
+  if (sink->queued_buffer != NULL) {
+    gst_buffer_unmap (sink->queued_buffer, &sink->queued_map);
+    gst_buffer_unref (sink->queued_buffer);
+    sink->queued_buffer = NULL;
+  }
+  if (sink->flow_ret == GST_FLOW_OK)
+    gst_curl_base_sink_queue_next_unlocked (sink);
+  else
+    gst_curl_base_sink_queue_clear_unlocked (sink);
   GST_OBJECT_UNLOCK (sink);
 }
 
@@ -83,6 +83,14 @@ struct _GstCurlBaseSink
   gboolean transfer_thread_close;
   gboolean new_file;
   gboolean is_live;
+
+  /* queued upload: buffers waiting for the transfer thread, and the one
+   * transfer_buf currently points into */
+  guint queue_size;
+  GQueue queue;
+  GstBuffer *queued_buffer;
+  GstMapInfo queued_map;
+  gboolean flushing;
 };
 
 struct _GstCurlBaseSinkClass
@@ -73,6 +73,7 @@
 #else
 #define GSTCURL_HANDLE_DEFAULT_CURLOPT_HTTP_VERSION 1.1
 #endif
+#define GSTCURL_HANDLE_DEFAULT_CURLOPT_STREAM_WEIGHT 16L
 
 /* Defaults from http://curl.haxx.se/libcurl/c/curl_multi_setopt.html */
 #define GSTCURL_HANDLE_DEFAULT_CURLMOPT_PIPELINING 1L
@@ -107,6 +108,8 @@
 #else
 #define GSTCURL_HANDLE_MAX_CURLOPT_HTTP_VERSION CURL_HTTP_VERSION_1_1
 #endif
+#define GSTCURL_HANDLE_MIN_CURLOPT_STREAM_WEIGHT 1L
+#define GSTCURL_HANDLE_MAX_CURLOPT_STREAM_WEIGHT 256L
 
 #define GSTCURL_HANDLE_MIN_CURLMOPT_PIPELINING 0L
 #define GSTCURL_HANDLE_MAX_CURLMOPT_PIPELINING 1L
@@ -137,6 +140,8 @@
 #define GSTCURL_DEFAULT_CONNECTIONS_SERVER 5
 #define GSTCURL_DEFAULT_CONNECTIONS_PROXY 30
 #define GSTCURL_DEFAULT_CONNECTIONS_GLOBAL 255
+/* Size of the memory blocks the received body is appended to */
+#define GSTCURL_BODY_BLOCK_SIZE (64 * 1024)
 #define GSTCURL_INFO_RESPONSE(x) ((x >= 100) && (x <= 199))
 #define GSTCURL_SUCCESS_RESPONSE(x) ((x >= 200) && (x <=299))
 #define GSTCURL_REDIRECT_RESPONSE(x) ((x >= 300) && (x <= 399))
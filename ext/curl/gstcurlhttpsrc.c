@@ -103,6 +103,8 @@ static void gst_curl_http_src_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void gst_curl_http_src_ref_multi (GstCurlHttpSrc * src);
 static void gst_curl_http_src_unref_multi (GstCurlHttpSrc * src);
+static void gst_curl_http_src_apply_multi_options
+    (GstCurlHttpSrcMultiTaskContext * context);
 static void gst_curl_http_src_finalize (GObject * obj);
 static GstFlowReturn gst_curl_http_src_create (GstPushSrc * psrc,
     GstBuffer ** outbuf);
@@ -328,6 +330,23 @@ gst_curl_http_src_class_init (GstCurlHttpSrcClass * klass)
           GSTCURL_MIN_CONNECTIONS_GLOBAL, GSTCURL_MAX_CONNECTIONS_GLOBAL,
           GSTCURL_DEFAULT_CONNECTIONS_GLOBAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstCurlHttpSrc:stream-weight:
+   *
+   * Relative share of the bandwidth of an HTTP/2 connection that this
+   * element's requests get, compared to the other requests multiplexed on the
+   * same connection. Ignored for HTTP/1.x.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_STREAM_WEIGHT,
+      g_param_spec_int ("stream-weight", "Stream-Weight",
+          "HTTP/2 stream weight of the requests, relative to others sharing the"
+          " same connection", GSTCURL_HANDLE_MIN_CURLOPT_STREAM_WEIGHT,
+          GSTCURL_HANDLE_MAX_CURLOPT_STREAM_WEIGHT,
+          GSTCURL_HANDLE_DEFAULT_CURLOPT_STREAM_WEIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
 #ifdef CURL_VERSION_HTTP2
   if (gst_curl_http_src_curl_capabilities->features & CURL_VERSION_HTTP2) {
     GST_INFO_OBJECT (klass, "Our curl version (%s) supports HTTP2!",
@@ -470,6 +489,9 @@ gst_curl_http_src_set_property (GObject * object, guint prop_id,
         source->preferred_http_version = GSTCURL_HTTP_VERSION_1_1;
       }
       break;
+    case PROP_STREAM_WEIGHT:
+      source->stream_weight = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -565,6 +587,9 @@ gst_curl_http_src_get_property (GObject * object, guint prop_id,
           GST_WARNING_OBJECT (source, "Bad HTTP version in object");
       }
       break;
+    case PROP_STREAM_WEIGHT:
+      g_value_set_int (value, source->stream_weight);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -600,6 +625,7 @@ gst_curl_http_src_init (GstCurlHttpSrc * source)
   source->strict_ssl = GSTCURL_HANDLE_DEFAULT_CURLOPT_SSL_VERIFYPEER;
   source->custom_ca_file = NULL;
   source->preferred_http_version = pref_http_ver;
+  source->stream_weight = GSTCURL_HANDLE_DEFAULT_CURLOPT_STREAM_WEIGHT;
   source->total_retries = GSTCURL_HANDLE_DEFAULT_RETRIES;
   source->retries_remaining = source->total_retries;
   source->slist = NULL;
@@ -646,6 +672,8 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
   g_mutex_lock (&klass->multi_task_context.mutex);
   if (klass->multi_task_context.refcount == 0) {
     /* Set up various in-task properties */
+    klass->multi_task_context.max_host_connections = src->max_conns_per_server;
+    klass->multi_task_context.max_total_connections = src->max_conns_global;
 
     /* NULL is treated as the start of the list, no need to allocate. */
     klass->multi_task_context.queue = NULL;
@@ -653,12 +681,16 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
     /* set up curl */
     klass->multi_task_context.multi_handle = curl_multi_init ();
 
+    /* Multiplex transfers over a single HTTP/2 connection when the server
+     * supports it */
+#ifdef CURLPIPE_MULTIPLEX
     curl_multi_setopt (klass->multi_task_context.multi_handle,
-        CURLMOPT_PIPELINING, 1);
-#ifdef CURLMOPT_MAX_HOST_CONNECTIONS
+        CURLMOPT_PIPELINING, CURLPIPE_HTTP1 | CURLPIPE_MULTIPLEX);
+#else
     curl_multi_setopt (klass->multi_task_context.multi_handle,
-        CURLMOPT_MAX_HOST_CONNECTIONS, 1);
+        CURLMOPT_PIPELINING, 1);
 #endif
+    gst_curl_http_src_apply_multi_options (&klass->multi_task_context);
 
     /* Start the thread */
     klass->multi_task_context.task = gst_task_new (
@@ -675,6 +707,18 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
       abort ();
     }
     GSTCURL_INFO_PRINT ("Curl multi loop has been correctly initialised!");
+  } else if (src->max_conns_per_server >
+      klass->multi_task_context.max_host_connections
+      || src->max_conns_global >
+      klass->multi_task_context.max_total_connections) {
+    /* the multi handle is only used from the loop thread once started */
+    klass->multi_task_context.max_host_connections =
+        MAX (klass->multi_task_context.max_host_connections,
+        src->max_conns_per_server);
+    klass->multi_task_context.max_total_connections =
+        MAX (klass->multi_task_context.max_total_connections,
+        src->max_conns_global);
+    klass->multi_task_context.options_changed = TRUE;
   }
   klass->multi_task_context.refcount++;
   g_mutex_unlock (&klass->multi_task_context.mutex);
@@ -682,6 +726,27 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
   GSTCURL_FUNCTION_EXIT (src);
 }
 
+/*
+ * Set the connection limits of the multi handle. Requests to a server that
+ * speaks HTTP/2 are multiplexed on one connection anyway thanks to
+ * CURLOPT_PIPEWAIT, the per-host limit is what HTTP/1.x servers get.
+ */
+static void
+gst_curl_http_src_apply_multi_options (GstCurlHttpSrcMultiTaskContext *
+    context)
+{
+  GSTCURL_INFO_PRINT ("Using up to %ld connections per host, %ld in total",
+      context->max_host_connections, context->max_total_connections);
+
+  curl_multi_setopt (context->multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS,
+      context->max_host_connections);
+  curl_multi_setopt (context->multi_handle, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+      context->max_total_connections);
+  curl_multi_setopt (context->multi_handle, CURLMOPT_MAXCONNECTS,
+      context->max_total_connections);
+  context->options_changed = FALSE;
+}
+
 /*
  * Decrement the reference count on the curl multi loop. If this is called by
  * the last instance to hold a reference, shut down the worker. (Otherwise
@@ -802,7 +867,7 @@ retry:
 
   if (src->state == GSTCURL_UNLOCK) {
     if (src->buffer_len > 0) {
-      g_free (src->buffer);
+      gst_buffer_unref (src->buffer);
       src->buffer = NULL;
       src->buffer_len = 0;
     }
@@ -856,10 +921,8 @@ retry:
 
     GST_DEBUG_OBJECT (src, "Pushing %u bytes of transfer for URI %s to pad",
         src->buffer_len, src->uri);
-    *outbuf = gst_buffer_new_allocate (NULL, src->buffer_len, NULL);
-    gst_buffer_fill (*outbuf, 0, src->buffer, src->buffer_len);
-
-    g_free (src->buffer);
+    /* Hand out the received memory blocks as they are */
+    *outbuf = src->buffer;
     src->buffer = NULL;
     src->buffer_len = 0;
     src->data_received = TRUE;
@@ -990,6 +1053,16 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
   gst_curl_setopt_int_default (s, handle, CURLOPT_MAXREDIRS,
       s->max_3xx_redirects);
   gst_curl_setopt_bool (s, handle, CURLOPT_TCP_KEEPALIVE, s->keep_alive);
+#ifdef CURLPIPE_MULTIPLEX
+  /* Rather wait for a connection that is still being set up than open a new
+   * one, so that consecutive requests to a server share a connection.
+   * CURLOPT_PIPEWAIT was added together with CURLPIPE_MULTIPLEX. */
+  gst_curl_setopt_bool (s, handle, CURLOPT_PIPEWAIT, TRUE);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072e00
+  /* CURLOPT_STREAM_WEIGHT was added in 7.46.0 */
+  gst_curl_setopt_int (s, handle, CURLOPT_STREAM_WEIGHT, s->stream_weight);
+#endif
   gst_curl_setopt_int (s, handle, CURLOPT_TIMEOUT, s->timeout_secs);
   gst_curl_setopt_bool (s, handle, CURLOPT_SSL_VERIFYPEER, s->strict_ssl);
   gst_curl_setopt_str (s, handle, CURLOPT_CAINFO, s->custom_ca_file);
@@ -1145,6 +1218,17 @@ gst_curl_http_src_handle_response (GstCurlHttpSrc * src)
     }
   }
 
+  /*
+   * Tell downstream whether the transfer went over an existing connection
+   */
+  if (curl_easy_getinfo (src->curl_handle, CURLINFO_NUM_CONNECTS,
+          &curl_info_long) == CURLE_OK) {
+    GST_DEBUG_OBJECT (src, "Transfer needed %ld new connection(s)",
+        curl_info_long);
+    gst_structure_set (src->http_headers, CONNECTION_REUSED_NAME,
+        G_TYPE_BOOLEAN, curl_info_long == 0, NULL);
+  }
+
   /*
    * Push all the received headers down via a sicky event
    */
@@ -1300,8 +1384,10 @@ gst_curl_http_src_cleanup_instance (GstCurlHttpSrc * src)
 
   g_cond_clear (&src->signal);
 
-  g_free (src->buffer);
-  src->buffer = NULL;
+  if (src->buffer != NULL) {
+    gst_buffer_unref (src->buffer);
+    src->buffer = NULL;
+  }
 
   if (src->http_headers != NULL) {
     gst_structure_free (src->http_headers);
@@ -1509,6 +1595,9 @@ gst_curl_http_src_curl_multi_loop (gpointer thread_data)
     GSTCURL_DEBUG_PRINT ("Received wake up call!");
   }
 
+  if (context->options_changed)
+    gst_curl_http_src_apply_multi_options (context);
+
   if (context->state == GSTCURL_MULTI_LOOP_STATE_QUEUE_EVENT) {
     GSTCURL_DEBUG_PRINT ("Received a new item on the queue!");
     if (context->queue == NULL) {
@@ -1807,13 +1896,16 @@ gst_curl_http_src_strcasestr (const char *haystack, const char *needle)
 
 /*
  * Receive chunks of the requested body and pass these back to the ::create()
- * loop
+ * loop. The chunks are appended to the free space of the last memory block of
+ * the pending buffer, a new block being added when the chunk doesn't fit, so
+ * that ::create() can push the buffer without copying it again.
  */
 static size_t
 gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
 {
   GstCurlHttpSrc *s = src;
   size_t chunk_len = size * nmemb;
+  gsize buffer_size, offset, maxsize;
   GST_TRACE_OBJECT (s,
       "Received curl chunk for URI %s of size %d", s->uri, (int) chunk_len);
   g_mutex_lock (&s->buffer_mutex);
@@ -1821,13 +1913,18 @@ gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
     g_mutex_unlock (&s->buffer_mutex);
     return chunk_len;
   }
-  s->buffer =
-      g_realloc (s->buffer, (s->buffer_len + chunk_len + 1) * sizeof (char));
   if (s->buffer == NULL) {
-    GST_ERROR_OBJECT (s, "Realloc for cURL response message failed!\n");
-    return 0;
+    s->buffer = gst_buffer_new ();
+  }
+  buffer_size = gst_buffer_get_sizes (s->buffer, &offset, &maxsize);
+  if (maxsize - offset - buffer_size < chunk_len) {
+    GstMemory *mem = gst_allocator_alloc (NULL,
+        MAX (GSTCURL_BODY_BLOCK_SIZE, chunk_len), NULL);
+    gst_memory_resize (mem, 0, 0);
+    gst_buffer_append_memory (s->buffer, mem);
   }
-  memcpy (s->buffer + s->buffer_len, chunk, chunk_len);
+  gst_buffer_set_size (s->buffer, buffer_size + chunk_len);
+  gst_buffer_fill (s->buffer, buffer_size, chunk, chunk_len);
   s->buffer_len += chunk_len;
   g_cond_signal (&s->signal);
   g_mutex_unlock (&s->buffer_mutex);
@@ -90,6 +90,7 @@ typedef struct _GstCurlHttpSrcQueueElement GstCurlHttpSrcQueueElement;
 #define REQUEST_HEADERS_NAME    "request-headers"
 #define RESPONSE_HEADERS_NAME   "response-headers"
 #define REDIRECT_URI_NAME       "redirection-uri"
+#define CONNECTION_REUSED_NAME  "connection-reused"
 
 struct _GstCurlHttpSrcMultiTaskContext
 {
@@ -113,6 +114,12 @@ struct _GstCurlHttpSrcMultiTaskContext
     GSTCURL_MULTI_LOOP_STATE_MAX
   } state;
 
+  /* Options of the shared multi handle, the largest ones requested by the
+   * instances. Applied from the loop thread when options_changed is set */
+  glong max_host_connections;   /* CURLMOPT_MAX_HOST_CONNECTIONS */
+  glong max_total_connections;  /* CURLMOPT_MAX_TOTAL_CONNECTIONS */
+  gboolean options_changed;
+
   /* < private > */
   CURLM *multi_handle;
 };
@@ -183,6 +190,7 @@ struct _GstCurlHttpSrc
     GSTCURL_HTTP_NOT,           /* For future use, incase not HTTP protocol! */
     GSTCURL_HTTP_VERSION_MAX
   } preferred_http_version;     /* CURLOPT_HTTP_VERSION */
+  glong stream_weight;          /* CURLOPT_STREAM_WEIGHT */
 
   enum
   {
@@ -199,7 +207,7 @@ struct _GstCurlHttpSrc
   CURL *curl_handle;
   GMutex buffer_mutex;
   GCond signal;
-  gchar *buffer;
+  GstBuffer *buffer;            /* body received since the last ::create() */
   guint buffer_len;
   gboolean transfer_begun;
   gboolean data_received;
@@ -243,6 +251,7 @@ enum
   PROP_MAXCONCURRENT_PROXY,
   PROP_MAXCONCURRENT_GLOBAL,
   PROP_HTTPVERSION,
+  PROP_STREAM_WEIGHT,
   PROP_MAX
 };
 
@@ -399,6 +399,7 @@ gst_dash_demux_stream_get_fragment_waiting_time (GstAdaptiveDemuxStream *
     stream);
 static void gst_dash_demux_advance_period (GstAdaptiveDemux * demux);
 static gboolean gst_dash_demux_has_next_period (GstAdaptiveDemux * demux);
+static GList *gst_dash_demux_peek_next_period (GstAdaptiveDemux * demux);
 static GstFlowReturn gst_dash_demux_data_received (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstBuffer * buffer);
 static gboolean
@@ -626,6 +627,7 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
 
   gstadaptivedemux_class->has_next_period = gst_dash_demux_has_next_period;
   gstadaptivedemux_class->advance_period = gst_dash_demux_advance_period;
+  gstadaptivedemux_class->peek_next_period = gst_dash_demux_peek_next_period;
   gstadaptivedemux_class->stream_has_next_fragment =
       gst_dash_demux_stream_has_next_fragment;
   gstadaptivedemux_class->stream_advance_fragment =
@@ -1041,6 +1043,10 @@ gst_dash_demux_process_manifest (GstAdaptiveDemux * demux, GstBuffer * buf)
     if (gst_mpd_parse (dashdemux->client, manifest, mapinfo.size)) {
       if (gst_mpd_client_setup_media_presentation (dashdemux->client, 0, 0,
               NULL)) {
+        g_free (dashdemux->manifest_checksum);
+        dashdemux->manifest_checksum =
+            g_compute_checksum_for_data (G_CHECKSUM_SHA1, mapinfo.data,
+            mapinfo.size);
         ret = TRUE;
       } else {
         GST_ELEMENT_ERROR (demux, STREAM, DECODE,
@@ -1114,6 +1120,8 @@ gst_dash_demux_reset (GstAdaptiveDemux * ademux)
   }
   gst_dash_demux_clock_drift_free (demux->clock_drift);
   demux->clock_drift = NULL;
+  g_free (demux->manifest_checksum);
+  demux->manifest_checksum = NULL;
   demux->client = gst_mpd_client_new ();
   gst_mpd_client_set_uri_downloader (demux->client, ademux->downloader);
 
@@ -2396,15 +2404,30 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
   GstDashDemux *dashdemux = GST_DASH_DEMUX_CAST (demux);
   GstMpdClient *new_client = NULL;
   GstMapInfo mapinfo;
+  gchar *checksum;
 
   GST_DEBUG_OBJECT (demux, "Updating manifest file from URL");
 
+  gst_buffer_map (buffer, &mapinfo, GST_MAP_READ);
+
+  /* Live MPDs are often refreshed more frequently than they change, and
+   * parsing them and setting up the streams again is costly for long
+   * SegmentTimelines. The current client is still valid if nothing changed */
+  checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, mapinfo.data,
+      mapinfo.size);
+  if (dashdemux->manifest_checksum
+      && g_str_equal (checksum, dashdemux->manifest_checksum)) {
+    GST_DEBUG_OBJECT (demux, "Manifest unchanged, not parsing it again");
+    g_free (checksum);
+    gst_buffer_unmap (buffer, &mapinfo);
+    return GST_FLOW_OK;
+  }
+
   /* parse the manifest file */
   new_client = gst_mpd_client_new ();
   gst_mpd_client_set_uri_downloader (new_client, demux->downloader);
   new_client->mpd_uri = g_strdup (demux->manifest_uri);
   new_client->mpd_base_uri = g_strdup (demux->manifest_base_uri);
-  gst_buffer_map (buffer, &mapinfo, GST_MAP_READ);
 
   if (gst_mpd_parse (new_client, (gchar *) mapinfo.data, mapinfo.size)) {
     const gchar *period_id;
@@ -2413,6 +2436,22 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     GList *streams_iter;
     GList *streams;
 
+    /* live refreshes usually only add segments, they can be merged into the
+     * current client without setting up the streams again */
+    if (gst_mpd_client_merge_update (dashdemux->client, new_client)) {
+      GST_DEBUG_OBJECT (demux, "Merged the new segments of the manifest");
+      gst_mpd_client_free (new_client);
+
+      g_free (dashdemux->manifest_checksum);
+      dashdemux->manifest_checksum = checksum;
+
+      if (dashdemux->clock_drift) {
+        gst_dash_demux_poll_clock_drift (dashdemux);
+      }
+      gst_buffer_unmap (buffer, &mapinfo);
+      return GST_FLOW_OK;
+    }
+
     /* prepare the new manifest and try to transfer the stream position
      * status from the old manifest client  */
 
@@ -2431,6 +2470,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
       if (!gst_mpd_client_set_period_id (new_client, period_id)) {
         GST_DEBUG_OBJECT (demux, "Error setting up the updated manifest file");
         gst_mpd_client_free (new_client);
+        g_free (checksum);
         gst_buffer_unmap (buffer, &mapinfo);
         return GST_FLOW_EOS;
       }
@@ -2438,6 +2478,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
       if (!gst_mpd_client_set_period_index (new_client, period_idx)) {
         GST_DEBUG_OBJECT (demux, "Error setting up the updated manifest file");
         gst_mpd_client_free (new_client);
+        g_free (checksum);
         gst_buffer_unmap (buffer, &mapinfo);
         return GST_FLOW_EOS;
       }
@@ -2446,6 +2487,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     if (!gst_dash_demux_setup_mpdparser_streams (dashdemux, new_client)) {
       GST_ERROR_OBJECT (demux, "Failed to setup streams on manifest " "update");
       gst_mpd_client_free (new_client);
+      g_free (checksum);
       gst_buffer_unmap (buffer, &mapinfo);
       return GST_FLOW_ERROR;
     }
@@ -2473,6 +2515,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
             "Stream of index %d is missing from manifest update",
             demux_stream->index);
         gst_mpd_client_free (new_client);
+        g_free (checksum);
         gst_buffer_unmap (buffer, &mapinfo);
         return GST_FLOW_EOS;
       }
@@ -2503,6 +2546,10 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     gst_mpd_client_free (dashdemux->client);
     dashdemux->client = new_client;
 
+    g_free (dashdemux->manifest_checksum);
+    dashdemux->manifest_checksum = checksum;
+    checksum = NULL;
+
     GST_DEBUG_OBJECT (demux, "Manifest file successfully updated");
     if (dashdemux->clock_drift) {
       gst_dash_demux_poll_clock_drift (dashdemux);
@@ -2513,10 +2560,13 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
      * the manifest */
     GST_WARNING_OBJECT (demux, "Error parsing the manifest.");
     gst_mpd_client_free (new_client);
+    g_free (checksum);
     gst_buffer_unmap (buffer, &mapinfo);
     return GST_FLOW_ERROR;
   }
 
+  g_free (checksum);
+
   gst_buffer_unmap (buffer, &mapinfo);
 
   return GST_FLOW_OK;
@@ -2591,6 +2641,93 @@ gst_dash_demux_advance_period (GstAdaptiveDemux * demux)
   gst_mpd_client_seek_to_first_segment (dashdemux->client);
 }
 
+static GstFragment *
+gst_dash_demux_new_fragment (gchar * uri, gint64 range_start,
+    gint64 range_end)
+{
+  GstFragment *fragment = gst_fragment_new ();
+
+  fragment->uri = uri;
+  fragment->range_start = range_start;
+  fragment->range_end = range_end;
+
+  return fragment;
+}
+
+static GList *
+gst_dash_demux_peek_next_period (GstAdaptiveDemux * demux)
+{
+  GstDashDemux *dashdemux = GST_DASH_DEMUX_CAST (demux);
+  GstMpdClient *client = dashdemux->client;
+  GList *active_streams, *iter, *fragments = NULL;
+  guint period_idx, i;
+  gboolean isoff_ondemand;
+
+  /* set up the streams of the next period like advance_period() does, in
+   * place of the current ones, and put those back afterwards. This also
+   * resolves the external adaptation sets of the next period. */
+  period_idx = gst_mpd_client_get_period_index (client);
+  active_streams = client->active_streams;
+  client->active_streams = NULL;
+
+  if (!gst_mpd_client_set_period_index (client, period_idx + 1))
+    goto done;
+
+  for (iter = gst_mpd_client_get_adaptation_sets (client); iter;
+      iter = g_list_next (iter))
+    gst_mpd_client_setup_streaming (client, iter->data);
+  gst_mpd_client_seek_to_first_segment (client);
+
+  isoff_ondemand = gst_mpd_client_has_isoff_ondemand_profile (client);
+
+  for (i = 0; i < gst_mpdparser_get_nb_active_stream (client); i++) {
+    GstActiveStream *active_stream;
+    GstMediaFragmentInfo info;
+    gchar *path = NULL;
+    gint64 range_start, range_end;
+
+    active_stream = gst_mpdparser_get_active_stream_by_index (client, i);
+    if (active_stream == NULL || (dashdemux->trickmode_no_audio
+            && active_stream->mimeType == GST_STREAM_AUDIO))
+      continue;
+
+    if (gst_mpd_client_get_next_header (client, &path, i, &range_start,
+            &range_end)) {
+      fragments = g_list_append (fragments,
+          gst_dash_demux_new_fragment (gst_uri_join_strings
+              (gst_mpdparser_get_baseURL (client, i), path), range_start,
+              range_end));
+      g_free (path);
+      path = NULL;
+    }
+
+    if (gst_mpd_client_get_next_header_index (client, &path, i, &range_start,
+            &range_end)) {
+      fragments = g_list_append (fragments,
+          gst_dash_demux_new_fragment (gst_uri_join_strings
+              (gst_mpdparser_get_baseURL (client, i), path), range_start,
+              range_end));
+      g_free (path);
+    }
+
+    /* with the on-demand profile the fragment ranges come from the index */
+    if (!isoff_ondemand && gst_mpd_client_get_next_fragment (client, i, &info)) {
+      fragments = g_list_append (fragments,
+          gst_dash_demux_new_fragment (g_strdup (info.uri), info.range_start,
+              info.range_end));
+      gst_media_fragment_info_clear (&info);
+    }
+  }
+
+  gst_active_streams_free (client);
+  gst_mpd_client_set_period_index (client, period_idx);
+
+done:
+  client->active_streams = active_streams;
+
+  return fragments;
+}
+
 static GstBuffer *
 _gst_buffer_split (GstBuffer * buffer, gint offset, gsize size)
 {
@@ -3094,6 +3231,22 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
 
         sample_offset = prev_sample_end;
 
+        /* The offsets of all following samples depend on the size, even
+         * of samples whose flags aren't known */
+        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT) {
+          prev_sample_end += sample->sample_size;
+        } else if (traf->
+            tfhd.flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_SIZE_PRESENT) {
+          prev_sample_end += traf->tfhd.default_sample_size;
+        } else {
+          GST_FIXME_OBJECT (stream->pad,
+              "Sample size given by trex - can't download only keyframes");
+          g_array_free (dash_stream->moof_sync_samples, TRUE);
+          dash_stream->moof_sync_samples = NULL;
+          dashdemux->allow_trickmode_key_units = FALSE;
+          return FALSE;
+        }
+
         if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT) {
           sample_flags = sample->sample_flags;
         } else if ((trun->flags & GST_TRUN_FLAGS_FIRST_SAMPLE_FLAGS_PRESENT)
@@ -3122,20 +3275,6 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
         }
 #endif
 
-        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT) {
-          prev_sample_end += sample->sample_size;
-        } else if (traf->
-            tfhd.flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_SIZE_PRESENT) {
-          prev_sample_end += traf->tfhd.default_sample_size;
-        } else {
-          GST_FIXME_OBJECT (stream->pad,
-              "Sample size given by trex - can't download only keyframes");
-          g_array_free (dash_stream->moof_sync_samples, TRUE);
-          dash_stream->moof_sync_samples = NULL;
-          dashdemux->allow_trickmode_key_units = FALSE;
-          return FALSE;
-        }
-
         /* Non-non-sync sample aka sync sample */
         if (!GST_ISOFF_SAMPLE_FLAGS_SAMPLE_IS_NON_SYNC_SAMPLE (sample_flags) ||
             GST_ISOFF_SAMPLE_FLAGS_SAMPLE_DEPENDS_ON (sample_flags) == 2) {
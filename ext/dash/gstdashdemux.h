@@ -129,6 +129,7 @@ struct _GstDashDemux
   GMutex client_lock;
 
   GstDashDemuxClockDrift *clock_drift;
+  gchar *manifest_checksum;     /* checksum of the last parsed manifest */
 
   gboolean end_of_period;
   gboolean end_of_manifest;
@@ -163,6 +163,8 @@ gst_isoff_tfhd_box_parse (GstTfhdBox * tfhd, GstByteReader * reader)
 static gboolean
 gst_isoff_trun_box_parse (GstTrunBox * trun, GstByteReader * reader)
 {
+  GstTrunSample *samples;
+  guint sample_size;
   gint i;
 
   memset (trun, 0, sizeof (*trun));
@@ -179,10 +181,6 @@ gst_isoff_trun_box_parse (GstTrunBox * trun, GstByteReader * reader)
   if (!gst_byte_reader_get_uint32_be (reader, &trun->sample_count))
     return FALSE;
 
-  trun->samples =
-      g_array_sized_new (FALSE, FALSE, sizeof (GstTrunSample),
-      trun->sample_count);
-
   if ((trun->flags & GST_TRUN_FLAGS_DATA_OFFSET_PRESENT) &&
       !gst_byte_reader_get_uint32_be (reader, (guint32 *) & trun->data_offset))
     return FALSE;
@@ -191,34 +189,49 @@ gst_isoff_trun_box_parse (GstTrunBox * trun, GstByteReader * reader)
       !gst_byte_reader_get_uint32_be (reader, &trun->first_sample_flags))
     return FALSE;
 
-  for (i = 0; i < trun->sample_count; i++) {
-    GstTrunSample sample = { 0, };
+  /* All samples have the same fields, so the box has to be large enough for
+   * all of them before anything is allocated for the sample count, which
+   * could be anything in a broken or truncated box */
+  sample_size = 0;
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT)
+    sample_size += 4;
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT)
+    sample_size += 4;
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT)
+    sample_size += 4;
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT)
+    sample_size += 4;
+
+  if (gst_byte_reader_get_remaining (reader) / MAX (sample_size, 1) <
+      trun->sample_count)
+    return FALSE;
+  if (sample_size == 0 && trun->sample_count > G_MAXUINT16)
+    return FALSE;
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT) &&
-        !gst_byte_reader_get_uint32_be (reader, &sample.sample_duration))
-      goto error;
+  trun->samples =
+      g_array_sized_new (FALSE, TRUE, sizeof (GstTrunSample),
+      trun->sample_count);
+  g_array_set_size (trun->samples, trun->sample_count);
+  samples = (GstTrunSample *) trun->samples->data;
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT) &&
-        !gst_byte_reader_get_uint32_be (reader, &sample.sample_size))
-      goto error;
+  for (i = 0; i < trun->sample_count; i++) {
+    GstTrunSample *sample = &samples[i];
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT) &&
-        !gst_byte_reader_get_uint32_be (reader, &sample.sample_flags))
-      goto error;
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT)
+      sample->sample_duration = gst_byte_reader_get_uint32_be_unchecked (reader);
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT)
-        && !gst_byte_reader_get_uint32_be (reader,
-            &sample.sample_composition_time_offset.u))
-      goto error;
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT)
+      sample->sample_size = gst_byte_reader_get_uint32_be_unchecked (reader);
 
-    g_array_append_val (trun->samples, sample);
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT)
+      sample->sample_flags = gst_byte_reader_get_uint32_be_unchecked (reader);
+
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT)
+      sample->sample_composition_time_offset.u =
+          gst_byte_reader_get_uint32_be_unchecked (reader);
   }
 
   return TRUE;
-
-error:
-  gst_isoff_trun_box_clear (trun);
-  return FALSE;
 }
 
 static gboolean
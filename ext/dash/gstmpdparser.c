@@ -1441,6 +1441,7 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
   guint intval;
   guint64 int64val;
   gboolean boolval;
+  gdouble doubleval;
   GstRange *rangeval;
 
   gst_mpdparser_free_seg_base_type_ext (*pointer);
@@ -1456,6 +1457,7 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
     seg_base_type->presentationTimeOffset = parent->presentationTimeOffset;
     seg_base_type->indexRange = gst_mpdparser_clone_range (parent->indexRange);
     seg_base_type->indexRangeExact = parent->indexRangeExact;
+    seg_base_type->availabilityTimeOffset = parent->availabilityTimeOffset;
     seg_base_type->Initialization =
         gst_mpdparser_clone_URL (parent->Initialization);
     seg_base_type->RepresentationIndex =
@@ -1483,6 +1485,11 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
           FALSE, &boolval)) {
     seg_base_type->indexRangeExact = boolval;
   }
+  /* "INF" parses as infinity, meaning that all segments are available */
+  if (gst_mpdparser_get_xml_prop_double (a_node, "availabilityTimeOffset",
+          &doubleval)) {
+    seg_base_type->availabilityTimeOffset = doubleval;
+  }
 
   /* explore children nodes */
   for (cur_node = a_node->children; cur_node; cur_node = cur_node->next) {
@@ -3795,8 +3802,11 @@ gst_mpd_parse (GstMpdClient * client, const gchar * data, gint size)
      */
     LIBXML_TEST_VERSION;
 
-    /* parse "data" into a document (which is a libxml2 tree structure xmlDoc) */
-    doc = xmlReadMemory (data, size, "noname.xml", NULL, XML_PARSE_NONET);
+    /* parse "data" into a document (which is a libxml2 tree structure xmlDoc).
+     * The whitespace between elements is not needed, dropping it roughly
+     * halves the number of nodes of long SegmentTimelines */
+    doc = xmlReadMemory (data, size, "noname.xml", NULL,
+        XML_PARSE_NONET | XML_PARSE_NOBLANKS | XML_PARSE_COMPACT);
     if (doc == NULL) {
       GST_ERROR ("failed to parse the MPD file");
       ret = FALSE;
@@ -3889,6 +3899,34 @@ gst_mpd_client_add_media_segment (GstActiveStream * stream,
   return TRUE;
 }
 
+/* Extends the last segment with the repetitions of @S if @S directly follows
+ * it with the same duration. Timelines listing every segment with its own S
+ * element are then stored as compactly as the ones using S@r */
+static gboolean
+gst_mpd_client_extend_media_segment (GstActiveStream * stream, GstSNode * S,
+    guint64 scale_start)
+{
+  GstMediaSegment *last;
+
+  g_return_val_if_fail (stream->segments != NULL, FALSE);
+
+  if (stream->segments->len == 0 || S->r < 0)
+    return FALSE;
+
+  last = g_ptr_array_index (stream->segments, stream->segments->len - 1);
+  if (last->SegmentURL != NULL || last->repeat < 0
+      || last->scale_duration != S->d
+      || last->scale_start + last->scale_duration * (last->repeat + 1) !=
+      scale_start)
+    return FALSE;
+
+  last->repeat += S->r + 1;
+  GST_LOG ("Extended segment: number %d, repeat %d", last->number,
+      last->repeat);
+
+  return TRUE;
+}
+
 static void
 gst_mpd_client_stream_update_presentation_time_offset (GstMpdClient * client,
     GstActiveStream * stream)
@@ -4102,8 +4140,9 @@ gst_mpd_client_setup_representation (GstMpdClient * client,
             start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale);
           }
 
-          if (!gst_mpd_client_add_media_segment (stream, NULL, i, S->r, start,
-                  S->d, start_time, duration)) {
+          if (!gst_mpd_client_extend_media_segment (stream, S, start)
+              && !gst_mpd_client_add_media_segment (stream, NULL, i, S->r,
+                  start, S->d, start_time, duration)) {
             return FALSE;
           }
           i += S->r + 1;
@@ -4174,6 +4213,379 @@ gst_mpd_client_setup_representation (GstMpdClient * client,
   return TRUE;
 }
 
+static gboolean
+gst_mpdparser_base_urls_equal (GList * list, GList * update)
+{
+  for (; list && update;
+      list = g_list_next (list), update = g_list_next (update)) {
+    GstBaseURL *base_url = list->data;
+    GstBaseURL *update_url = update->data;
+
+    if (g_strcmp0 (base_url->baseURL, update_url->baseURL) != 0
+        || g_strcmp0 (base_url->byteRange, update_url->byteRange) != 0)
+      return FALSE;
+  }
+
+  return list == NULL && update == NULL;
+}
+
+/* Appends the segments of the S elements in @list, the first of which starts
+ * at @start and has the number @number, to the streams built from
+ * @mult_seg, and drops their segments that end before @window_start and
+ * precede the current one */
+static void
+gst_mpdparser_extend_stream_segments (GstMpdClient * client,
+    GstMultSegmentBaseType * mult_seg, GList * list, guint64 start,
+    guint number, guint64 window_start)
+{
+  GList *iter;
+
+  for (iter = client->active_streams; iter; iter = g_list_next (iter)) {
+    GstActiveStream *stream = iter->data;
+    guint timescale = mult_seg->SegBaseType->timescale;
+    GstClockTime start_time, duration;
+    guint64 scale_start = start;
+    guint i = number;
+    GList *S_list;
+    guint n;
+
+    if (stream->segments == NULL || stream->cur_seg_template == NULL
+        || stream->cur_seg_template->MultSegBaseType != mult_seg)
+      continue;
+
+    start_time = gst_util_uint64_scale (start, GST_SECOND, timescale);
+    for (S_list = list; S_list; S_list = g_list_next (S_list)) {
+      GstSNode *S = S_list->data;
+
+      duration = gst_util_uint64_scale (S->d, GST_SECOND, timescale);
+      if (S->t > 0) {
+        scale_start = S->t;
+        start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale);
+      }
+
+      if (!gst_mpd_client_extend_media_segment (stream, S, scale_start))
+        gst_mpd_client_add_media_segment (stream, NULL, i, S->r, scale_start,
+            S->d, start_time, duration);
+      i += S->r + 1;
+      scale_start += S->d * (S->r + 1);
+      start_time += duration * (S->r + 1);
+    }
+
+    for (n = 0; n < stream->segments->len && (gint) n < stream->segment_index;
+        n++) {
+      GstMediaSegment *segment = g_ptr_array_index (stream->segments, n);
+
+      if (segment->scale_start +
+          segment->scale_duration * (segment->repeat + 1) > window_start)
+        break;
+    }
+    if (n > 0) {
+      GST_LOG ("Dropping %u segments before the time shift buffer", n);
+      g_ptr_array_remove_range (stream->segments, 0, n);
+      stream->segment_index -= n;
+    }
+  }
+}
+
+/* Merges the SegmentTimeline of @update into the one of @mult_seg: the S
+ * elements of @update that end after the last segment of @mult_seg are
+ * appended to it, and its leading S elements that end before the first one
+ * of @update are dropped. Fails, without modifying anything, if @update does
+ * not continue the timeline of @mult_seg. Nothing is modified either unless
+ * @apply is set */
+static gboolean
+gst_mpdparser_merge_segment_timeline (GstMpdClient * client,
+    GstMultSegmentBaseType * mult_seg, GstMultSegmentBaseType * update,
+    gboolean apply)
+{
+  GstSegmentTimelineNode *timeline = mult_seg->SegmentTimeline;
+  GQueue new_S = G_QUEUE_INIT;
+  guint64 start = 0, end = 0, window_start = 0;
+  guint number, end_number;
+  GList *list;
+  GstSNode *S;
+
+  if (g_queue_is_empty (&timeline->S)
+      || g_queue_is_empty (&update->SegmentTimeline->S))
+    return FALSE;
+
+  /* find the end of the current timeline */
+  number = mult_seg->startNumber;
+  for (list = g_queue_peek_head_link (&timeline->S); list;
+      list = g_list_next (list)) {
+    S = list->data;
+    if (S->r < 0 || S->d == 0)
+      return FALSE;
+    if (S->t > 0)
+      end = S->t;
+    end += S->d * (S->r + 1);
+    number += S->r + 1;
+  }
+  end_number = number;
+
+  /* collect the segments of the update that follow it */
+  number = update->startNumber;
+  for (list = g_queue_peek_head_link (&update->SegmentTimeline->S); list;
+      list = g_list_next (list)) {
+    guint64 S_end;
+
+    S = list->data;
+    if (S->r < 0 || S->d == 0)
+      goto not_continued;
+    if (S->t > 0)
+      start = S->t;
+    if (list == g_queue_peek_head_link (&update->SegmentTimeline->S)) {
+      if (start > end)
+        goto not_continued;
+      window_start = start;
+    }
+
+    S_end = start + S->d * (S->r + 1);
+    if (S_end > end) {
+      GstSNode *tail;
+      guint skip = 0;
+
+      if (start < end) {
+        if ((end - start) % S->d != 0)
+          goto not_continued;
+        skip = (end - start) / S->d;
+      }
+      /* with $Number$ templates, the first new segment must keep the number
+       * it would have had in the current timeline */
+      if (g_queue_is_empty (&new_S) && number + skip != end_number)
+        goto not_continued;
+
+      tail = gst_mpdparser_clone_s_node (S);
+      tail->t = start + skip * S->d;
+      tail->r -= skip;
+      g_queue_push_tail (&new_S, tail);
+    }
+    number += S->r + 1;
+    start = S_end;
+  }
+
+  if (!apply || g_queue_is_empty (&new_S)) {
+    g_queue_foreach (&new_S, (GFunc) gst_mpdparser_free_s_node, NULL);
+    g_queue_clear (&new_S);
+    return TRUE;
+  }
+
+  /* drop the S elements that left the time shift buffer */
+  while (g_queue_get_length (&timeline->S) > 1) {
+    GstSNode *next;
+
+    S = g_queue_peek_head (&timeline->S);
+    if (S->t + S->d * (S->r + 1) > window_start)
+      break;
+
+    g_queue_pop_head (&timeline->S);
+    next = g_queue_peek_head (&timeline->S);
+    if (next->t == 0)
+      next->t = S->t + S->d * (S->r + 1);
+    mult_seg->startNumber += S->r + 1;
+    gst_mpdparser_free_s_node (S);
+  }
+
+  GST_LOG ("Appending %u S nodes from segment %u", g_queue_get_length (&new_S),
+      end_number);
+  g_queue_push_tail (&timeline->S, g_queue_pop_head (&new_S));
+  list = g_queue_peek_tail_link (&timeline->S);
+  while (!g_queue_is_empty (&new_S))
+    g_queue_push_tail (&timeline->S, g_queue_pop_head (&new_S));
+
+  gst_mpdparser_extend_stream_segments (client, mult_seg, list, end,
+      end_number, window_start);
+
+  return TRUE;
+
+not_continued:
+  GST_DEBUG ("SegmentTimeline of the update does not continue the current one");
+  g_queue_foreach (&new_S, (GFunc) gst_mpdparser_free_s_node, NULL);
+  g_queue_clear (&new_S);
+  return FALSE;
+}
+
+static gboolean
+gst_mpdparser_merge_segment_template (GstMpdClient * client,
+    GstSegmentTemplateNode * template, GstSegmentTemplateNode * update,
+    gboolean apply)
+{
+  GstMultSegmentBaseType *mult_seg, *mult_update;
+
+  if (template == NULL || update == NULL)
+    return template == update;
+
+  if (g_strcmp0 (template->media, update->media) != 0
+      || g_strcmp0 (template->index, update->index) != 0
+      || g_strcmp0 (template->initialization, update->initialization) != 0)
+    return FALSE;
+
+  mult_seg = template->MultSegBaseType;
+  mult_update = update->MultSegBaseType;
+  if (mult_seg == NULL || mult_update == NULL)
+    return mult_seg == mult_update;
+
+  if (mult_seg->duration != mult_update->duration
+      || mult_seg->SegBaseType->timescale !=
+      mult_update->SegBaseType->timescale
+      || mult_seg->SegBaseType->presentationTimeOffset !=
+      mult_update->SegBaseType->presentationTimeOffset)
+    return FALSE;
+
+  if (mult_seg->SegmentTimeline == NULL || mult_update->SegmentTimeline == NULL)
+    return mult_seg->SegmentTimeline == mult_update->SegmentTimeline
+        && mult_seg->startNumber == mult_update->startNumber;
+
+  return gst_mpdparser_merge_segment_timeline (client, mult_seg, mult_update,
+      apply);
+}
+
+static gboolean
+gst_mpdparser_merge_period (GstMpdClient * client, GstPeriodNode * period,
+    GstPeriodNode * update, gboolean apply)
+{
+  GList *list, *update_list;
+
+  if (g_strcmp0 (period->id, update->id) != 0
+      || period->start != update->start
+      || period->duration != update->duration
+      || update->xlink_href != NULL
+      || period->SegmentList != NULL || update->SegmentList != NULL
+      || !gst_mpdparser_base_urls_equal (period->BaseURLs, update->BaseURLs)
+      || g_list_length (period->AdaptationSets) !=
+      g_list_length (update->AdaptationSets)
+      || !gst_mpdparser_merge_segment_template (client,
+          period->SegmentTemplate, update->SegmentTemplate, apply))
+    return FALSE;
+
+  for (list = period->AdaptationSets, update_list = update->AdaptationSets;
+      list;
+      list = g_list_next (list), update_list = g_list_next (update_list)) {
+    GstAdaptationSetNode *adapt_set = list->data;
+    GstAdaptationSetNode *adapt_update = update_list->data;
+    GList *rep_list, *rep_update_list;
+
+    if (adapt_set->id != adapt_update->id
+        || adapt_update->xlink_href != NULL
+        || adapt_set->SegmentList != NULL || adapt_update->SegmentList != NULL
+        || !gst_mpdparser_base_urls_equal (adapt_set->BaseURLs,
+            adapt_update->BaseURLs)
+        || g_list_length (adapt_set->Representations) !=
+        g_list_length (adapt_update->Representations)
+        || !gst_mpdparser_merge_segment_template (client,
+            adapt_set->SegmentTemplate, adapt_update->SegmentTemplate, apply))
+      return FALSE;
+
+    for (rep_list = adapt_set->Representations,
+        rep_update_list = adapt_update->Representations; rep_list;
+        rep_list = g_list_next (rep_list),
+        rep_update_list = g_list_next (rep_update_list)) {
+      GstRepresentationNode *representation = rep_list->data;
+      GstRepresentationNode *rep_update = rep_update_list->data;
+
+      if (g_strcmp0 (representation->id, rep_update->id) != 0
+          || representation->bandwidth != rep_update->bandwidth
+          || representation->SegmentList != NULL
+          || rep_update->SegmentList != NULL
+          || !gst_mpdparser_base_urls_equal (representation->BaseURLs,
+              rep_update->BaseURLs)
+          || !gst_mpdparser_merge_segment_template (client,
+              representation->SegmentTemplate, rep_update->SegmentTemplate,
+              apply))
+        return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+ * gst_mpd_client_merge_update:
+ * @client: #GstMpdClient of a dynamic MPD, set up for streaming
+ * @update: #GstMpdClient holding a refresh of that MPD, only parsed
+ *
+ * Refreshes of a live MPD usually only add segments to the SegmentTimelines
+ * and drop the ones that left the time shift buffer. When the Periods,
+ * AdaptationSets and Representations of @update are the ones of @client,
+ * the new S elements are merged into the SegmentTimelines of @client and
+ * appended to the segment lists of its active streams, which keep their
+ * position. Otherwise, @client is left untouched and the caller has to set
+ * up @update instead.
+ *
+ * Returns: %TRUE if @update was merged into @client
+ */
+gboolean
+gst_mpd_client_merge_update (GstMpdClient * client, GstMpdClient * update)
+{
+  GstMPDNode *mpd_node, *mpd_update;
+  GstStreamPeriod *stream_period;
+  GList *list, *update_list;
+  GList *tmp;
+  gint pass;
+
+  g_return_val_if_fail (client != NULL, FALSE);
+  g_return_val_if_fail (update != NULL, FALSE);
+
+  mpd_node = client->mpd_node;
+  mpd_update = update->mpd_node;
+  if (mpd_node == NULL || mpd_update == NULL || client->periods == NULL)
+    return FALSE;
+
+  if (mpd_node->type != GST_MPD_FILE_TYPE_DYNAMIC
+      || mpd_update->type != GST_MPD_FILE_TYPE_DYNAMIC
+      || mpd_node->mediaPresentationDuration !=
+      mpd_update->mediaPresentationDuration
+      || !gst_mpdparser_base_urls_equal (mpd_node->BaseURLs,
+          mpd_update->BaseURLs)
+      || g_list_length (mpd_node->Periods) !=
+      g_list_length (mpd_update->Periods))
+    return FALSE;
+
+  if (mpd_node->availabilityStartTime == NULL
+      || mpd_update->availabilityStartTime == NULL) {
+    if (mpd_node->availabilityStartTime != mpd_update->availabilityStartTime)
+      return FALSE;
+  } else if (gst_mpd_client_calculate_time_difference
+      (mpd_node->availabilityStartTime,
+          mpd_update->availabilityStartTime) != 0) {
+    return FALSE;
+  }
+
+  /* the segments are not clipped to the end of the Period */
+  stream_period = gst_mpdparser_get_stream_period (client);
+  if (stream_period == NULL
+      || GST_CLOCK_TIME_IS_VALID (stream_period->duration))
+    return FALSE;
+
+  /* check that all the timelines can be merged before modifying any */
+  for (pass = 0; pass < 2; pass++) {
+    for (list = mpd_node->Periods, update_list = mpd_update->Periods; list;
+        list = g_list_next (list), update_list = g_list_next (update_list)) {
+      if (!gst_mpdparser_merge_period (client, list->data, update_list->data,
+              pass == 1)) {
+        g_assert (pass == 0);
+        return FALSE;
+      }
+    }
+  }
+
+  mpd_node->minimumUpdatePeriod = mpd_update->minimumUpdatePeriod;
+  mpd_node->minBufferTime = mpd_update->minBufferTime;
+  mpd_node->timeShiftBufferDepth = mpd_update->timeShiftBufferDepth;
+  mpd_node->suggestedPresentationDelay = mpd_update->suggestedPresentationDelay;
+  mpd_node->maxSegmentDuration = mpd_update->maxSegmentDuration;
+  mpd_node->maxSubsegmentDuration = mpd_update->maxSubsegmentDuration;
+
+  tmp = mpd_node->Locations;
+  mpd_node->Locations = mpd_update->Locations;
+  mpd_update->Locations = tmp;
+  tmp = mpd_node->UTCTiming;
+  mpd_node->UTCTiming = mpd_update->UTCTiming;
+  mpd_update->UTCTiming = tmp;
+
+  return TRUE;
+}
+
 #define CUSTOM_WRAPPER_START "<custom_wrapper>"
 #define CUSTOM_WRAPPER_END "</custom_wrapper>"
 
@@ -5932,6 +6344,26 @@ gst_mpdparser_get_list_and_nb_of_audio_language (GstMpdClient * client,
   return nb_adaptation_set;
 }
 
+/* availabilityTimeOffset of the segment information used by @stream, in
+ * seconds */
+static gdouble
+gst_mpd_client_get_availability_time_offset (GstActiveStream * stream)
+{
+  GstMultSegmentBaseType *mult_seg = NULL;
+
+  if (stream->cur_segment_list)
+    mult_seg = stream->cur_segment_list->MultSegBaseType;
+  else if (stream->cur_seg_template)
+    mult_seg = stream->cur_seg_template->MultSegBaseType;
+
+  if (mult_seg && mult_seg->SegBaseType)
+    return mult_seg->SegBaseType->availabilityTimeOffset;
+
+  if (stream->cur_segment_base)
+    return stream->cur_segment_base->availabilityTimeOffset;
+
+  return 0;
+}
 
 GstDateTime *
 gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client,
@@ -5942,6 +6374,7 @@ gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client,
   GstStreamPeriod *stream_period;
   GstMediaSegment *segment;
   GstClockTime segmentEndTime;
+  gdouble availability_time_offset;
 
   g_return_val_if_fail (client != NULL, NULL);
   g_return_val_if_fail (stream != NULL, NULL);
@@ -5973,6 +6406,17 @@ gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client,
     segmentEndTime = (1 + seg_idx) * seg_duration;
   }
 
+  /* Low-latency streams make a segment available before its end, it is
+   * then sent as it is produced */
+  availability_time_offset =
+      gst_mpd_client_get_availability_time_offset (stream) * GST_SECOND;
+  if (availability_time_offset > 0) {
+    if (availability_time_offset >= segmentEndTime)
+      segmentEndTime = 0;
+    else
+      segmentEndTime -= availability_time_offset;
+  }
+
   availability_start_time = gst_mpd_client_get_availability_start_time (client);
   if (availability_start_time == NULL) {
     GST_WARNING_OBJECT (client, "Failed to get availability_start_time");
@@ -169,6 +169,8 @@ struct _GstSegmentBaseType
   guint64 presentationTimeOffset;
   GstRange *indexRange;
   gboolean indexRangeExact;
+  /* in seconds, how long before its end a segment becomes available */
+  gdouble availabilityTimeOffset;
   /* Initialization node */
   GstURLType *Initialization;
   /* RepresentationIndex node */
@@ -532,6 +534,7 @@ void gst_mpd_client_set_uri_downloader (GstMpdClient * client, GstUriDownloader
 
 /* MPD file parsing */
 gboolean gst_mpd_parse (GstMpdClient *client, const gchar *data, gint size);
+gboolean gst_mpd_client_merge_update (GstMpdClient * client, GstMpdClient * update);
 
 /* Streaming management */
 gboolean gst_mpd_client_setup_media_presentation (GstMpdClient *client, GstClockTime time, gint period_index, const gchar *period_id);
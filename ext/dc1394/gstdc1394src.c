@@ -53,6 +53,20 @@
 GST_DEBUG_CATEGORY_STATIC (dc1394_debug);
 #define GST_CAT_DEFAULT dc1394_debug
 
+/* ring frames always left to the camera, one being filled and one ready,
+ * frames beyond those are copied instead of handed downstream */
+#define DMA_FREE_FRAMES 2
+
+/* how long stopping the capture waits for the ring frames to come back */
+#define FRAMES_RELEASE_TIMEOUT (2 * G_TIME_SPAN_SECOND)
+
+typedef struct
+{
+  GstDC1394Src *src;
+  dc1394camera_t *camera;
+  dc1394video_frame_t *frame;
+} GstDC1394Frame;
+
 
 enum
 {
@@ -89,6 +103,7 @@ gst_dc1394_iso_speed_get_type (void)
 #define gst_dc1394_src_parent_class parent_class
 G_DEFINE_TYPE (GstDC1394Src, gst_dc1394_src, GST_TYPE_PUSH_SRC);
 
+static void gst_dc1394_src_finalize (GObject * object);
 static void gst_dc1394_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_dc1394_src_get_property (GObject * object, guint prop_id,
@@ -140,6 +155,7 @@ gst_dc1394_src_class_init (GstDC1394SrcClass * klass)
   basesrc_class = GST_BASE_SRC_CLASS (klass);
   pushsrc_class = GST_PUSH_SRC_CLASS (klass);
 
+  gobject_class->finalize = gst_dc1394_src_finalize;
   gobject_class->set_property = gst_dc1394_src_set_property;
   gobject_class->get_property = gst_dc1394_src_get_property;
   g_object_class_install_property (gobject_class, PROP_CAMERA_GUID,
@@ -195,6 +211,12 @@ gst_dc1394_src_init (GstDC1394Src * src)
   src->dc1394 = NULL;
   src->camera = NULL;
   src->caps = NULL;
+  g_mutex_init (&src->frames_lock);
+  g_cond_init (&src->frames_cond);
+  src->n_wrapped_frames = 0;
+  src->stop_pending = FALSE;
+  src->pending_camera = NULL;
+  src->pending_dc1394 = NULL;
 
   gst_base_src_set_live (GST_BASE_SRC (src), TRUE);
   gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
@@ -202,6 +224,18 @@ gst_dc1394_src_init (GstDC1394Src * src)
 }
 
 
+static void
+gst_dc1394_src_finalize (GObject * object)
+{
+  GstDC1394Src *src = GST_DC1394_SRC (object);
+
+  g_mutex_clear (&src->frames_lock);
+  g_cond_clear (&src->frames_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+
 static void
 gst_dc1394_src_get_property (GObject * object, guint prop_id, GValue * value,
     GParamSpec * pspec)
@@ -313,6 +347,86 @@ gst_dc1394_src_set_caps (GstBaseSrc * bsrc, GstCaps * caps)
 }
 
 
+/* Called with frames_lock, once the last frame of a stopped capture is
+ * back */
+static void
+gst_dc1394_src_clear_capture (GstDC1394Src * src, dc1394camera_t * camera)
+{
+  dc1394error_t ret;
+
+  GST_DEBUG_OBJECT (src, "Clear capture resources.");
+  ret = dc1394_capture_stop (camera);
+  if (ret != DC1394_SUCCESS && ret != DC1394_CAPTURE_IS_NOT_SET) {
+    GST_WARNING_OBJECT (src, "Could not clear capture: %s.",
+        dc1394_error_get_string (ret));
+  }
+  src->stop_pending = FALSE;
+
+  if (src->pending_camera) {
+    GST_DEBUG_OBJECT (src, "Free closed camera.");
+    dc1394_camera_free (src->pending_camera);
+    src->pending_camera = NULL;
+    dc1394_free (src->pending_dc1394);
+    src->pending_dc1394 = NULL;
+  }
+}
+
+
+static void
+gst_dc1394_src_release_frame (GstDC1394Frame * wrapped)
+{
+  GstDC1394Src *src = wrapped->src;
+  dc1394error_t ret;
+
+  g_mutex_lock (&src->frames_lock);
+  src->n_wrapped_frames--;
+  if (!src->stop_pending) {
+    ret = dc1394_capture_enqueue (wrapped->camera, wrapped->frame);
+    if (ret != DC1394_SUCCESS) {
+      GST_WARNING_OBJECT (src, "Could not enqueue frame: %s.",
+          dc1394_error_get_string (ret));
+    }
+  } else if (src->n_wrapped_frames == 0) {
+    /* the ring was only kept for this frame */
+    gst_dc1394_src_clear_capture (src, wrapped->camera);
+  }
+  g_cond_broadcast (&src->frames_cond);
+  g_mutex_unlock (&src->frames_lock);
+
+  gst_object_unref (src);
+  g_slice_free (GstDC1394Frame, wrapped);
+}
+
+
+/* Waits for the wrapped frames to come back. If they don't in time, the
+ * capture is stopped by the release of the last one instead. */
+static gboolean
+gst_dc1394_src_wait_frames (GstDC1394Src * src)
+{
+  gint64 end_time;
+  gboolean released;
+
+  end_time = g_get_monotonic_time () + FRAMES_RELEASE_TIMEOUT;
+
+  g_mutex_lock (&src->frames_lock);
+  while (src->n_wrapped_frames > 0) {
+    GST_DEBUG_OBJECT (src, "Wait for %u frames to be released.",
+        src->n_wrapped_frames);
+    if (!g_cond_wait_until (&src->frames_cond, &src->frames_lock, end_time))
+      break;
+  }
+  released = src->n_wrapped_frames == 0;
+  if (!released) {
+    GST_WARNING_OBJECT (src, "%u frames are still used downstream, the "
+        "capture is cleared when they are released", src->n_wrapped_frames);
+    src->stop_pending = TRUE;
+  }
+  g_mutex_unlock (&src->frames_lock);
+
+  return released;
+}
+
+
 static GstFlowReturn
 gst_dc1394_src_create (GstPushSrc * psrc, GstBuffer ** obuf)
 {
@@ -320,6 +434,7 @@ gst_dc1394_src_create (GstPushSrc * psrc, GstBuffer ** obuf)
   GstBuffer *buffer;
   dc1394video_frame_t *frame;
   dc1394error_t ret;
+  gboolean wrap;
 
   src = GST_DC1394_SRC (psrc);
   buffer = NULL;
@@ -330,24 +445,43 @@ gst_dc1394_src_create (GstPushSrc * psrc, GstBuffer ** obuf)
         ("Could not dequeue frame: %s.", dc1394_error_get_string (ret)));
     goto error;
   }
+
   /*
-   * TODO: We could create the buffer by wrapping the image bytes in the frame
-   * (enqueing the frame in the notify function) to save the copy operation.
-   * It will only work if all the buffers are disposed before closing the camera
-   * when state changes from PAUSED to READY.
+   * The buffer wraps the image bytes in the frame, which goes back to the
+   * ring when the buffer is released, unless downstream already holds so
+   * many frames that the camera would run out of them.
    */
-  buffer = gst_buffer_new_allocate (NULL, frame->image_bytes, NULL);
-  gst_buffer_fill (buffer, 0, frame->image, frame->image_bytes);
+  g_mutex_lock (&src->frames_lock);
+  wrap = src->n_wrapped_frames + DMA_FREE_FRAMES < src->dma_buffer_size;
+  if (wrap)
+    src->n_wrapped_frames++;
+  g_mutex_unlock (&src->frames_lock);
+
   /*
    * TODO: There is a field timestamp in the frame structure,
    * It is not sure if it could be used as PTS or DTS:
    * we are not sure if it comes from a monotonic clock,
    * and it seems to be left undefined under MS Windows.
    */
-  ret = dc1394_capture_enqueue (src->camera, frame);
-  if (ret != DC1394_SUCCESS) {
-    GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
-        ("Could not enqueue frame: %s.", dc1394_error_get_string (ret)));
+  if (wrap) {
+    GstDC1394Frame *wrapped = g_slice_new (GstDC1394Frame);
+
+    wrapped->src = gst_object_ref (src);
+    wrapped->camera = src->camera;
+    wrapped->frame = frame;
+    buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        frame->image, frame->image_bytes, 0, frame->image_bytes, wrapped,
+        (GDestroyNotify) gst_dc1394_src_release_frame);
+  } else {
+    GST_LOG_OBJECT (src, "%u frames held downstream, copying",
+        src->n_wrapped_frames);
+    buffer = gst_buffer_new_allocate (NULL, frame->image_bytes, NULL);
+    gst_buffer_fill (buffer, 0, frame->image, frame->image_bytes);
+    ret = dc1394_capture_enqueue (src->camera, frame);
+    if (ret != DC1394_SUCCESS) {
+      GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
+          ("Could not enqueue frame: %s.", dc1394_error_get_string (ret)));
+    }
   }
   *obuf = buffer;
   return GST_FLOW_OK;
@@ -572,10 +706,18 @@ gst_dc1394_src_close_cam (GstDC1394Src * src)
     gst_caps_unref (src->caps);
     src->caps = NULL;
   }
-  dc1394_camera_free (src->camera);
+  g_mutex_lock (&src->frames_lock);
+  if (src->stop_pending) {
+    /* the frames still used downstream need the camera */
+    src->pending_camera = src->camera;
+    src->pending_dc1394 = src->dc1394;
+  } else {
+    dc1394_camera_free (src->camera);
+    dc1394_free (src->dc1394);
+  }
   src->camera = NULL;
-  dc1394_free (src->dc1394);
   src->dc1394 = NULL;
+  g_mutex_unlock (&src->frames_lock);
   GST_DEBUG_OBJECT (src, "Camera closed.");
 }
 
@@ -586,6 +728,17 @@ gst_dc1394_src_start_cam (GstDC1394Src * src)
   dc1394error_t ret;
   dc1394switch_t status;
   guint trials;
+  gboolean stop_pending;
+
+  g_mutex_lock (&src->frames_lock);
+  stop_pending = src->stop_pending;
+  g_mutex_unlock (&src->frames_lock);
+  if (stop_pending) {
+    GST_ELEMENT_ERROR (src, RESOURCE, FAILED, (NULL),
+        ("Could not setup capture: frames of the previous capture are "
+            "still used downstream."));
+    goto error_capture;
+  }
 
   GST_DEBUG_OBJECT (src, "Setup capture with a DMA buffer of %d frames",
       src->dma_buffer_size);
@@ -690,6 +843,10 @@ gst_dc1394_src_stop_cam (GstDC1394Src * src)
         dc1394_error_get_string (ret));
   }
 
+  /* the ring is unmapped with the capture, while frames may still be used */
+  if (!gst_dc1394_src_wait_frames (src))
+    return TRUE;
+
   GST_DEBUG_OBJECT (src, "Clear capture resources.");
   ret = dc1394_capture_stop (src->camera);
   if (ret != DC1394_SUCCESS && ret != DC1394_CAPTURE_IS_NOT_SET) {
@@ -47,6 +47,18 @@ struct _GstDC1394Src {
   uint32_t dma_buffer_size;
   dc1394camera_t * camera;
   dc1394_t * dc1394;
+
+  /* ring frames held by buffers downstream, they go back to the ring when
+   * the buffers are released */
+  GMutex frames_lock;
+  GCond frames_cond;
+  guint n_wrapped_frames;
+  /* the capture was stopped while frames were still held downstream, the
+   * ring is cleared when the last one is released, and the camera is freed
+   * then too if it was closed meanwhile */
+  gboolean stop_pending;
+  dc1394camera_t * pending_camera;
+  dc1394_t * pending_dc1394;
 };
 
 struct _GstDC1394SrcClass {
@@ -55,6 +55,9 @@ enum
 
 static GParamSpec *properties[NUM_PROPERTIES];
 
+#define GST_DTLS_SESSION_ID_CONTEXT "gstdtls"
+#define GST_DTLS_SESSION_TIMEOUT 300    /* seconds */
+
 struct _GstDtlsAgentPrivate
 {
   SSL_CTX *ssl_context;
@@ -200,6 +203,16 @@ gst_dtls_agent_init (GstDtlsAgent * self)
 #if OPENSSL_VERSION_NUMBER >= 0x1000200fL
   SSL_CTX_set_ecdh_auto (priv->ssl_context, 1);
 #endif
+
+  /* Let peers that join again resume their session, through a session id
+   * or a ticket, instead of doing a full handshake. The cache is shared by
+   * all the connections of the agent, the peer certificate is checked again
+   * by the connection when a session is resumed. */
+  SSL_CTX_set_session_cache_mode (priv->ssl_context, SSL_SESS_CACHE_SERVER);
+  SSL_CTX_set_session_id_context (priv->ssl_context,
+      (const unsigned char *) GST_DTLS_SESSION_ID_CONTEXT,
+      sizeof (GST_DTLS_SESSION_ID_CONTEXT) - 1);
+  SSL_CTX_set_timeout (priv->ssl_context, GST_DTLS_SESSION_TIMEOUT);
 }
 
 static void
@@ -107,6 +107,7 @@ static void gst_dtls_connection_set_property (GObject *, guint prop_id,
 static void log_state (GstDtlsConnection *, const gchar * str);
 static void export_srtp_keys (GstDtlsConnection *);
 static void openssl_poll (GstDtlsConnection *);
+static gboolean verify_resumed_session (GstDtlsConnection *);
 static int openssl_verify_callback (int preverify_ok,
     X509_STORE_CTX * x509_ctx);
 
@@ -724,6 +725,12 @@ openssl_poll (GstDtlsConnection * self)
 
   if (ret == 1) {
     if (!self->priv->keys_exported) {
+      if (SSL_session_reused (self->priv->ssl)
+          && !verify_resumed_session (self)) {
+        GST_WARNING_OBJECT (self, "peer certificate of the resumed session "
+            "was not accepted");
+        return;
+      }
       GST_INFO_OBJECT (self,
           "handshake just completed successfully, exporting keys");
       export_srtp_keys (self);
@@ -766,6 +773,39 @@ openssl_poll (GstDtlsConnection * self)
   }
 }
 
+/* The verify callback is not called when the handshake resumes a session,
+ * so give the application a chance to check the certificate the peer
+ * authenticated with in the first place */
+static gboolean
+verify_resumed_session (GstDtlsConnection * self)
+{
+  X509 *cert;
+  gchar *pem;
+  gboolean accepted = FALSE;
+
+  cert = SSL_get_peer_certificate (self->priv->ssl);
+  if (!cert) {
+    GST_WARNING_OBJECT (self, "resumed session has no peer certificate");
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (self, "session resumed, checking peer certificate");
+
+  pem = _gst_dtls_x509_to_pem (cert);
+  X509_free (cert);
+
+  if (!pem) {
+    GST_WARNING_OBJECT (self,
+        "failed to convert peer certificate to pem format");
+    return FALSE;
+  }
+
+  g_signal_emit (self, signals[SIGNAL_ON_PEER_CERTIFICATE], 0, pem, &accepted);
+  g_free (pem);
+
+  return accepted;
+}
+
 static int
 openssl_verify_callback (int preverify_ok, X509_STORE_CTX * x509_ctx)
 {
@@ -37,10 +37,33 @@
 enum
 {
   PROP_0,
-  PROP_BITRATE
+  PROP_BITRATE,
+  PROP_THREADS
 };
 
 #define DEFAULT_BITRATE (0)
+#define DEFAULT_THREADS (1)
+
+/* In the parallel mode the input is split into segments of SEGMENT_FRAMES
+ * frames that are encoded by separate encoder instances. Each of them is
+ * first fed the OVERLAP_FRAMES frames before its segment so that its state
+ * matches the one of a single encoder, and LOOKAHEAD_FRAMES frames after
+ * it to get the packets delayed by the encoder out of it. */
+#define SEGMENT_FRAMES 256
+#define OVERLAP_FRAMES 4
+#define LOOKAHEAD_FRAMES 4
+
+typedef struct
+{
+  GBytes *data;
+  guint skip;
+  guint keep;
+  gboolean eos;
+
+  GPtrArray *packets;
+  gboolean done;
+  gboolean failed;
+} GstFdkAacEncJob;
 
 #define SAMPLE_RATES " 8000, " \
                     "11025, " \
@@ -152,6 +175,8 @@ static GstFlowReturn gst_fdkaacenc_handle_frame (GstAudioEncoder * enc,
     GstBuffer * in_buf);
 static GstCaps *gst_fdkaacenc_get_caps (GstAudioEncoder * enc,
     GstCaps * filter);
+static void gst_fdkaacenc_flush (GstAudioEncoder * enc);
+static void gst_fdkaacenc_finalize (GObject * object);
 
 G_DEFINE_TYPE (GstFdkAacEnc, gst_fdkaacenc, GST_TYPE_AUDIO_ENCODER);
 
@@ -165,6 +190,9 @@ gst_fdkaacenc_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE:
       self->bitrate = g_value_get_int (value);
       break;
+    case PROP_THREADS:
+      self->threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -182,6 +210,9 @@ gst_fdkaacenc_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE:
       g_value_set_int (value, self->bitrate);
       break;
+    case PROP_THREADS:
+      g_value_set_uint (value, self->threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -189,13 +220,329 @@ gst_fdkaacenc_get_property (GObject * object, guint prop_id,
   return;
 }
 
+static void
+gst_fdkaacenc_job_free (GstFdkAacEncJob * job)
+{
+  g_bytes_unref (job->data);
+  g_ptr_array_unref (job->packets);
+  g_slice_free (GstFdkAacEncJob, job);
+}
+
+static HANDLE_AACENCODER
+gst_fdkaacenc_open_encoder (GstFdkAacEnc * self)
+{
+  HANDLE_AACENCODER enc = NULL;
+  AACENC_ERROR err;
+  gint aot = AOT_AAC_LC;
+
+  if ((err = aacEncOpen (&enc, 0, self->channels)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to open encoder: %d\n", err);
+    return NULL;
+  }
+
+  if ((err = aacEncoder_SetParam (enc, AACENC_AOT, aot)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set AOT %d: %d\n", aot, err);
+    goto error;
+  }
+
+  if ((err = aacEncoder_SetParam (enc, AACENC_SAMPLERATE,
+              self->rate)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set sample rate %d: %d\n",
+        self->rate, err);
+    goto error;
+  }
+
+  if ((err = aacEncoder_SetParam (enc, AACENC_CHANNELMODE,
+              self->channel_mode)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set channel mode %d: %d",
+        self->channel_mode, err);
+    goto error;
+  }
+
+  /* MPEG channel order */
+  if ((err = aacEncoder_SetParam (enc, AACENC_CHANNELORDER, 0)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set channel order %d: %d",
+        self->channel_mode, err);
+    goto error;
+  }
+
+  if ((err = aacEncoder_SetParam (enc, AACENC_TRANSMUX,
+              self->transmux)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set transmux %d: %d", self->transmux,
+        err);
+    goto error;
+  }
+
+  if ((err = aacEncoder_SetParam (enc, AACENC_BITRATE,
+              self->actual_bitrate)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set bitrate %d: %d",
+        self->actual_bitrate, err);
+    goto error;
+  }
+
+  if ((err = aacEncEncode (enc, NULL, NULL, NULL, NULL)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to initialize encoder: %d", err);
+    goto error;
+  }
+
+  return enc;
+
+error:
+  aacEncClose (&enc);
+  return NULL;
+}
+
+/* Runs in the thread pool: encodes the data of one job with a new encoder
+ * and keeps the packets of its segment */
+static void
+gst_fdkaacenc_encode_job (GstFdkAacEncJob * job, GstFdkAacEnc * self)
+{
+  HANDLE_AACENCODER enc;
+  AACENC_BufDesc in_desc = { 0 };
+  AACENC_BufDesc out_desc = { 0 };
+  AACENC_InArgs in_args = { 0 };
+  AACENC_OutArgs out_args = { 0 };
+  gint in_id = IN_AUDIO_DATA, out_id = OUT_BITSTREAM_DATA;
+  gint in_sizes, out_sizes;
+  gint in_el_sizes = 2, out_el_sizes = 1;
+  AACENC_ERROR err;
+  const guint8 *data;
+  guint8 *out_data;
+  gsize size, offset = 0, frame_size;
+  guint n_packets = 0;
+
+  data = g_bytes_get_data (job->data, &size);
+  frame_size = self->samples_per_frame * self->channels * 2;
+
+  enc = gst_fdkaacenc_open_encoder (self);
+  if (!enc) {
+    job->failed = TRUE;
+    goto done;
+  }
+
+  out_data = g_malloc (self->outbuf_size);
+  out_desc.bufferIdentifiers = &out_id;
+  out_desc.numBufs = 1;
+  out_desc.bufs = (void *) &out_data;
+  out_desc.bufSizes = &out_sizes;
+  out_desc.bufElSizes = &out_el_sizes;
+
+  in_desc.bufferIdentifiers = &in_id;
+  in_desc.numBufs = 1;
+  in_desc.bufs = (void *) &data;
+  in_desc.bufSizes = &in_sizes;
+  in_desc.bufElSizes = &in_el_sizes;
+
+  while (n_packets < job->skip + job->keep) {
+    AACENC_BufDesc *in = &in_desc;
+
+    if (offset < size) {
+      in_sizes = MIN (frame_size, size - offset);
+      in_args.numInSamples = in_sizes / 2;
+    } else if (job->eos) {
+      in = NULL;
+      in_args.numInSamples = -1;
+    } else {
+      break;
+    }
+
+    out_sizes = self->outbuf_size;
+    err = aacEncEncode (enc, in, &out_desc, &in_args, &out_args);
+    if (err == AACENC_ENCODE_EOF && !in)
+      break;
+    if (err != AACENC_OK) {
+      GST_ERROR_OBJECT (self, "Failed to encode data: %d", err);
+      job->failed = TRUE;
+      break;
+    }
+
+    if (in) {
+      offset += in_sizes;
+      data += in_sizes;
+    } else if (!out_args.numOutBytes) {
+      break;
+    }
+
+    if (out_args.numOutBytes) {
+      if (n_packets >= job->skip)
+        g_ptr_array_add (job->packets,
+            gst_buffer_new_wrapped (g_memdup (out_data, out_args.numOutBytes),
+                out_args.numOutBytes));
+      n_packets++;
+    }
+  }
+
+  if (!job->failed && !job->eos && job->packets->len < job->keep)
+    GST_WARNING_OBJECT (self, "Segment only produced %u of %u packets",
+        job->packets->len, job->keep);
+
+  g_free (out_data);
+  aacEncClose (&enc);
+
+done:
+  g_mutex_lock (&self->lock);
+  job->done = TRUE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_fdkaacenc_submit_job (GstFdkAacEnc * self, gsize size, guint skip,
+    guint keep, gboolean eos)
+{
+  GstFdkAacEncJob *job;
+
+  job = g_slice_new0 (GstFdkAacEncJob);
+  job->data = gst_adapter_copy_bytes (self->adapter, 0, size);
+  job->skip = skip;
+  job->keep = keep;
+  job->eos = eos;
+  job->packets = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_buffer_unref);
+
+  g_mutex_lock (&self->lock);
+  g_queue_push_tail (&self->jobs, job);
+  g_mutex_unlock (&self->lock);
+
+  g_thread_pool_push (self->pool, job, NULL);
+}
+
+/* Pushes the packets of the finished jobs in order. Unless wait_all is set,
+ * this only blocks while more jobs are queued than there are threads. */
+static GstFlowReturn
+gst_fdkaacenc_finish_jobs (GstFdkAacEnc * self, gboolean wait_all)
+{
+  GstAudioEncoder *enc = GST_AUDIO_ENCODER (self);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstFdkAacEncJob *job;
+  guint i;
+
+  while (ret == GST_FLOW_OK) {
+    g_mutex_lock (&self->lock);
+    job = g_queue_peek_head (&self->jobs);
+    while (job && !job->done && (wait_all
+            || g_queue_get_length (&self->jobs) >
+            g_thread_pool_get_max_threads (self->pool)))
+      g_cond_wait (&self->cond, &self->lock);
+    if (!job || !job->done) {
+      g_mutex_unlock (&self->lock);
+      break;
+    }
+    g_queue_pop_head (&self->jobs);
+    g_mutex_unlock (&self->lock);
+
+    if (job->failed) {
+      GST_ELEMENT_ERROR (self, STREAM, ENCODE, (NULL),
+          ("Failed to encode a segment"));
+      ret = GST_FLOW_ERROR;
+    }
+
+    for (i = 0; ret == GST_FLOW_OK && i < job->packets->len; i++) {
+      GstBuffer *outbuf = g_ptr_array_index (job->packets, i);
+
+      ret = gst_audio_encoder_finish_frame (enc, gst_buffer_ref (outbuf),
+          self->samples_per_frame);
+    }
+
+    gst_fdkaacenc_job_free (job);
+  }
+
+  return ret;
+}
+
+/* Waits for all jobs and drops their output */
+static void
+gst_fdkaacenc_discard_jobs (GstFdkAacEnc * self)
+{
+  GstFdkAacEncJob *job;
+
+  g_mutex_lock (&self->lock);
+  while ((job = g_queue_peek_head (&self->jobs))) {
+    while (!job->done)
+      g_cond_wait (&self->cond, &self->lock);
+    g_queue_pop_head (&self->jobs);
+    gst_fdkaacenc_job_free (job);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (self->adapter)
+    gst_adapter_clear (self->adapter);
+  self->next_segment = 0;
+}
+
+static GstFlowReturn
+gst_fdkaacenc_handle_frame_parallel (GstFdkAacEnc * self, GstBuffer * inbuf)
+{
+  GstAudioInfo *info = gst_audio_encoder_get_audio_info (GST_AUDIO_ENCODER
+      (self));
+  gsize frame_size = self->samples_per_frame * GST_AUDIO_INFO_BPF (info);
+  guint prime = self->next_segment == 0 ? 0 : OVERLAP_FRAMES;
+  GstFlowReturn ret;
+
+  if (inbuf) {
+    if (self->need_reorder) {
+      GstMapInfo map;
+
+      inbuf = gst_buffer_copy (inbuf);
+      gst_buffer_map (inbuf, &map, GST_MAP_READWRITE);
+      gst_audio_reorder_channels (map.data, map.size,
+          GST_AUDIO_INFO_FORMAT (info), GST_AUDIO_INFO_CHANNELS (info),
+          &GST_AUDIO_INFO_POSITION (info, 0), self->aac_positions);
+      gst_buffer_unmap (inbuf, &map);
+    } else {
+      inbuf = gst_buffer_ref (inbuf);
+    }
+    gst_adapter_push (self->adapter, inbuf);
+
+    /* the adapter starts OVERLAP_FRAMES before the next segment, except for
+     * the first one */
+    while (gst_adapter_available (self->adapter) >=
+        (prime + SEGMENT_FRAMES + LOOKAHEAD_FRAMES) * frame_size) {
+      gst_fdkaacenc_submit_job (self,
+          (prime + SEGMENT_FRAMES + LOOKAHEAD_FRAMES) * frame_size, prime,
+          SEGMENT_FRAMES, FALSE);
+      gst_adapter_flush (self->adapter,
+          (prime + SEGMENT_FRAMES - OVERLAP_FRAMES) * frame_size);
+      self->next_segment += SEGMENT_FRAMES;
+      prime = OVERLAP_FRAMES;
+    }
+
+    return gst_fdkaacenc_finish_jobs (self, FALSE);
+  }
+
+  /* drain: the last segment is flushed out of its encoder */
+  if (gst_adapter_available (self->adapter) > prime * frame_size)
+    gst_fdkaacenc_submit_job (self, gst_adapter_available (self->adapter),
+        prime, G_MAXUINT - prime, TRUE);
+  gst_adapter_clear (self->adapter);
+  self->next_segment = 0;
+
+  ret = gst_fdkaacenc_finish_jobs (self, TRUE);
+  if (ret != GST_FLOW_OK)
+    gst_fdkaacenc_discard_jobs (self);
+
+  return ret;
+}
+
 static gboolean
 gst_fdkaacenc_start (GstAudioEncoder * enc)
 {
   GstFdkAacEnc *self = GST_FDKAACENC (enc);
+  guint threads = self->threads;
 
   GST_DEBUG_OBJECT (self, "start");
 
+  if (threads == 0)
+    threads = g_get_num_processors ();
+
+  if (threads > 1) {
+    self->pool =
+        g_thread_pool_new ((GFunc) gst_fdkaacenc_encode_job, self, threads,
+        FALSE, NULL);
+    self->adapter = gst_adapter_new ();
+    self->next_segment = 0;
+  }
+
   return TRUE;
 }
 
@@ -206,12 +553,31 @@ gst_fdkaacenc_stop (GstAudioEncoder * enc)
 
   GST_DEBUG_OBJECT (self, "stop");
 
+  if (self->pool) {
+    gst_fdkaacenc_discard_jobs (self);
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+    self->pool = NULL;
+  }
+  if (self->adapter) {
+    g_object_unref (self->adapter);
+    self->adapter = NULL;
+  }
+
   if (self->enc)
     aacEncClose (&self->enc);
 
   return TRUE;
 }
 
+static void
+gst_fdkaacenc_flush (GstAudioEncoder * enc)
+{
+  GstFdkAacEnc *self = GST_FDKAACENC (enc);
+
+  if (self->pool)
+    gst_fdkaacenc_discard_jobs (self);
+}
+
 static GstCaps *
 gst_fdkaacenc_get_caps (GstAudioEncoder * enc, GstCaps * filter)
 {
@@ -254,7 +620,7 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
   GstCaps *allowed_caps;
   GstCaps *src_caps;
   AACENC_ERROR err;
-  gint transmux = 0, aot = AOT_AAC_LC;
+  gint transmux = 0;
   gint mpegversion = 4;
   CHANNEL_MODE channel_mode;
   AACENC_InfoStruct enc_info = { 0 };
@@ -292,27 +658,6 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
   if (allowed_caps)
     gst_caps_unref (allowed_caps);
 
-  if ((err =
-          aacEncOpen (&self->enc, 0,
-              GST_AUDIO_INFO_CHANNELS (info))) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to open encoder: %d\n", err);
-    return FALSE;
-  }
-
-  aot = AOT_AAC_LC;
-
-  if ((err = aacEncoder_SetParam (self->enc, AACENC_AOT, aot)) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to set AOT %d: %d\n", aot, err);
-    return FALSE;
-  }
-
-  if ((err = aacEncoder_SetParam (self->enc, AACENC_SAMPLERATE,
-              GST_AUDIO_INFO_RATE (info))) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to set sample rate %d: %d\n",
-        GST_AUDIO_INFO_RATE (info), err);
-    return FALSE;
-  }
-
   if (GST_AUDIO_INFO_CHANNELS (info) == 1) {
     channel_mode = MODE_1;
     self->need_reorder = FALSE;
@@ -347,21 +692,6 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
     }
   }
 
-  if ((err = aacEncoder_SetParam (self->enc, AACENC_CHANNELMODE,
-              channel_mode)) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to set channel mode %d: %d", channel_mode,
-        err);
-    return FALSE;
-  }
-
-  /* MPEG channel order */
-  if ((err = aacEncoder_SetParam (self->enc, AACENC_CHANNELORDER,
-              0)) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to set channel order %d: %d", channel_mode,
-        err);
-    return FALSE;
-  }
-
   bitrate = self->bitrate;
   /* See
    * http://wiki.hydrogenaud.io/index.php?title=Fraunhofer_FDK_AAC#Recommended_Sampling_Rate_and_Bitrate_Combinations
@@ -409,22 +739,15 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
     }
   }
 
-  if ((err = aacEncoder_SetParam (self->enc, AACENC_TRANSMUX,
-              transmux)) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to set transmux %d: %d", transmux, err);
-    return FALSE;
-  }
+  self->rate = GST_AUDIO_INFO_RATE (info);
+  self->channels = GST_AUDIO_INFO_CHANNELS (info);
+  self->channel_mode = channel_mode;
+  self->transmux = transmux;
+  self->actual_bitrate = bitrate;
 
-  if ((err = aacEncoder_SetParam (self->enc, AACENC_BITRATE,
-              bitrate)) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to set bitrate %d: %d", bitrate, err);
+  self->enc = gst_fdkaacenc_open_encoder (self);
+  if (!self->enc)
     return FALSE;
-  }
-
-  if ((err = aacEncEncode (self->enc, NULL, NULL, NULL, NULL)) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to initialize encoder: %d", err);
-    return FALSE;
-  }
 
   if ((err = aacEncInfo (self->enc, &enc_info)) != AACENC_OK) {
     GST_ERROR_OBJECT (self, "Unable to get encoder info: %d", err);
@@ -488,6 +811,9 @@ gst_fdkaacenc_handle_frame (GstAudioEncoder * enc, GstBuffer * inbuf)
   gint in_el_sizes, out_el_sizes;
   AACENC_ERROR err;
 
+  if (self->pool)
+    return gst_fdkaacenc_handle_frame_parallel (self, inbuf);
+
   info = gst_audio_encoder_get_audio_info (enc);
 
   if (!inbuf) {
@@ -573,11 +899,26 @@ static void
 gst_fdkaacenc_init (GstFdkAacEnc * self)
 {
   self->bitrate = DEFAULT_BITRATE;
+  self->threads = DEFAULT_THREADS;
   self->enc = NULL;
+  g_queue_init (&self->jobs);
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
 
   gst_audio_encoder_set_drainable (GST_AUDIO_ENCODER (self), TRUE);
 }
 
+static void
+gst_fdkaacenc_finalize (GObject * object)
+{
+  GstFdkAacEnc *self = GST_FDKAACENC (object);
+
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (gst_fdkaacenc_parent_class)->finalize (object);
+}
+
 static void
 gst_fdkaacenc_class_init (GstFdkAacEncClass * klass)
 {
@@ -587,12 +928,14 @@ gst_fdkaacenc_class_init (GstFdkAacEncClass * klass)
 
   object_class->set_property = GST_DEBUG_FUNCPTR (gst_fdkaacenc_set_property);
   object_class->get_property = GST_DEBUG_FUNCPTR (gst_fdkaacenc_get_property);
+  object_class->finalize = gst_fdkaacenc_finalize;
 
   base_class->start = GST_DEBUG_FUNCPTR (gst_fdkaacenc_start);
   base_class->stop = GST_DEBUG_FUNCPTR (gst_fdkaacenc_stop);
   base_class->set_format = GST_DEBUG_FUNCPTR (gst_fdkaacenc_set_format);
   base_class->getcaps = GST_DEBUG_FUNCPTR (gst_fdkaacenc_get_caps);
   base_class->handle_frame = GST_DEBUG_FUNCPTR (gst_fdkaacenc_handle_frame);
+  base_class->flush = GST_DEBUG_FUNCPTR (gst_fdkaacenc_flush);
 
   g_object_class_install_property (object_class, PROP_BITRATE,
       g_param_spec_int ("bitrate",
@@ -602,6 +945,23 @@ gst_fdkaacenc_class_init (GstFdkAacEncClass * klass)
           0, G_MAXINT, DEFAULT_BITRATE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFdkAacEnc:threads:
+   *
+   * Number of threads used to encode. With more than one thread, the input
+   * is split into segments that are encoded in parallel by separate
+   * encoders, each primed with the audio preceding its segment, and the
+   * packets are pushed in order. This adds several seconds of latency and is
+   * meant for file based encoding. 0 uses one thread per CPU.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (object_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads used to encode (0 = automatic)", 0, G_MAXINT,
+          DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
 
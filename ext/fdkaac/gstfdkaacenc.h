@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <gst/audio/gstaudioencoder.h>
+#include <gst/base/gstadapter.h>
 
 #include <fdk-aac/aacenc_lib.h>
 
@@ -50,6 +51,21 @@ struct _GstFdkAacEnc {
   guint outbuf_size, samples_per_frame;
   gboolean need_reorder;
   const GstAudioChannelPosition *aac_positions;
+
+  /* configuration, to open more encoders for the parallel mode */
+  gint rate, channels;
+  CHANNEL_MODE channel_mode;
+  gint transmux;
+  gint actual_bitrate;
+
+  /* parallel mode */
+  guint threads;
+  GThreadPool *pool;
+  GstAdapter *adapter;
+  guint64 next_segment;
+  GQueue jobs;
+  GMutex lock;
+  GCond cond;
 };
 
 struct _GstFdkAacEncClass {
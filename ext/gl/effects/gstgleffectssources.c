@@ -438,6 +438,27 @@ const gchar *rgb_to_curve_fragment_source_gles2 =
   "  gl_FragColor = outcolor;"
   "}";
 
+/* mixes the color with its luma, except for reds */
+#define SIN_MIX \
+  "  float luma = dot(color.rgb, vec3(0.2125, 0.7154, 0.0721));" \
+/* calculate hue with the Preucil formula */ \
+  "  float cosh = color.r - 0.5*(color.g + color.b);" \
+/* sqrt(3)/2 = 0.866 */ \
+  "  float sinh = 0.866*(color.g - color.b);" \
+/* hue = atan2 h */ \
+  "  float sch = (1.0-sinh)*cosh;" \
+/* ok this is a little trick I came up because I didn't find any \
+ * detailed proof of the Preucil formula. The issue is that tan(h) is \
+ * pi-periodic so the smoothstep thing gives both reds (h = 0) and \
+ * cyans (h = 180). I don't want to use atan since it requires \
+ * branching and doesn't work on i915. So take only the right half of \
+ * the circle where cosine is positive */ \
+/* take a slightly purple color trying to get rid of human skin reds */ \
+/* tanh = +-1.0 for h = +-45, where yellow=60, magenta=-60 */ \
+  "  float a = smoothstep (0.3, 1.0, sch);" \
+  "  float b = smoothstep (-0.4, -0.1, sinh);" \
+  "  float mix = a * b;"
+
 const gchar *sin_fragment_source_gles2 =
   "#ifdef GL_ES\n"
   "precision mediump float;\n"
@@ -446,27 +467,22 @@ const gchar *sin_fragment_source_gles2 =
   "uniform sampler2D tex;"
   "void main () {"
   "  vec4 color = texture2D (tex, vec2(v_texcoord.xy));"
-  "  float luma = dot(color.rgb, vec3(0.2125, 0.7154, 0.0721));"
-/* calculate hue with the Preucil formula */
-  "  float cosh = color.r - 0.5*(color.g + color.b);"
-/* sqrt(3)/2 = 0.866 */
-  "  float sinh = 0.866*(color.g - color.b);"
-/* hue = atan2 h */
-  "  float sch = (1.0-sinh)*cosh;"
-/* ok this is a little trick I came up because I didn't find any
- * detailed proof of the Preucil formula. The issue is that tan(h) is
- * pi-periodic so the smoothstep thing gives both reds (h = 0) and
- * cyans (h = 180). I don't want to use atan since it requires
- * branching and doesn't work on i915. So take only the right half of
- * the circle where cosine is positive */
-/* take a slightly purple color trying to get rid of human skin reds */
-/* tanh = +-1.0 for h = +-45, where yellow=60, magenta=-60 */
-  "  float a = smoothstep (0.3, 1.0, sch);"
-  "  float b = smoothstep (-0.4, -0.1, sinh);"
-  "  float mix = a * b;"
+  SIN_MIX
   "  gl_FragColor = color * mix + luma * (1.0 - mix);"
   "}";
 
+/* the same as a snippet for fusing, see gstglfusable.h */
+const gchar *sin_fusable_snippet =
+  "vec4 @apply (vec4 color) {"
+  SIN_MIX
+  "  return color * mix + luma * (1.0 - mix);"
+  "}";
+
+const gchar *identity_fusable_snippet =
+  "vec4 @apply (vec4 rgba) {"
+  "  return rgba;"
+  "}";
+
 const gchar *interpolate_fragment_source =
   "#ifdef GL_ES\n"
   "precision mediump float;\n"
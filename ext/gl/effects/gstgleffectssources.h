@@ -36,6 +36,8 @@ extern const gchar *sum_fragment_source_gles2;
 extern const gchar *luma_to_curve_fragment_source_gles2;
 extern const gchar *rgb_to_curve_fragment_source_gles2;
 extern const gchar *sin_fragment_source_gles2;
+extern const gchar *sin_fusable_snippet;
+extern const gchar *identity_fusable_snippet;
 extern const gchar *desaturate_fragment_source_gles2;
 extern const gchar *sep_sobel_hconv3_fragment_source_gles2;
 extern const gchar *sep_sobel_vconv3_fragment_source_gles2;
@@ -41,6 +41,7 @@
 #include <gst/math-compat.h>
 
 #include "gstglcolorbalance.h"
+#include "gstglfusable.h"
 #include <string.h>
 
 #include <gst/video/colorbalance.h>
@@ -55,64 +56,62 @@ GST_DEBUG_CATEGORY_STATIC (glcolorbalance_debug);
 #define DEFAULT_PROP_SATURATION	    1.0
 
 /* *INDENT-OFF* */
-static const gchar *color_balance_frag =
-  "#ifdef GL_ES\n"
-  "precision mediump float;\n"
-  "#endif\n"
-  "uniform float brightness;\n"
-  "uniform float contrast;\n"
-  "uniform float saturation;\n"
-  "uniform float hue;\n"
-  "varying vec2 v_texcoord;\n"
-  "uniform sampler2D tex;\n"
-  "#define from_yuv_bt601_offset vec3(-0.0625, -0.5, -0.5)\n"
-  "#define from_yuv_bt601_rcoeff vec3(1.164, 0.000, 1.596)\n"
-  "#define from_yuv_bt601_gcoeff vec3(1.164,-0.391,-0.813)\n"
-  "#define from_yuv_bt601_bcoeff vec3(1.164, 2.018, 0.000)\n"
-  "#define from_rgb_bt601_offset vec3(0.0625, 0.5, 0.5)\n"
-  "#define from_rgb_bt601_ycoeff vec3(0.256816, 0.504154, 0.0979137)\n"
-  "#define from_rgb_bt601_ucoeff vec3(-0.148246, -0.29102, 0.439266)\n"
-  "#define from_rgb_bt601_vcoeff vec3(0.439271, -0.367833, -0.071438)\n"
-  "#define PI 3.14159265\n"
+/* "@" is replaced by the prefix of the names, see gstglfusable.h */
+static const gchar *color_balance_snippet =
+  "uniform float @brightness;\n"
+  "uniform float @contrast;\n"
+  "uniform float @saturation;\n"
+  "uniform float @hue;\n"
+  "uniform bool @passthrough;\n"
+  "#define @from_yuv_bt601_offset vec3(-0.0625, -0.5, -0.5)\n"
+  "#define @from_yuv_bt601_rcoeff vec3(1.164, 0.000, 1.596)\n"
+  "#define @from_yuv_bt601_gcoeff vec3(1.164,-0.391,-0.813)\n"
+  "#define @from_yuv_bt601_bcoeff vec3(1.164, 2.018, 0.000)\n"
+  "#define @from_rgb_bt601_offset vec3(0.0625, 0.5, 0.5)\n"
+  "#define @from_rgb_bt601_ycoeff vec3(0.256816, 0.504154, 0.0979137)\n"
+  "#define @from_rgb_bt601_ucoeff vec3(-0.148246, -0.29102, 0.439266)\n"
+  "#define @from_rgb_bt601_vcoeff vec3(0.439271, -0.367833, -0.071438)\n"
+  "#define @PI 3.14159265\n"
   "\n"
-  "vec3 yuv_to_rgb (vec3 val) {\n"
+  "vec3 @yuv_to_rgb (vec3 val) {\n"
   "  vec3 rgb;\n"
-  "  val += from_yuv_bt601_offset;\n"
-  "  rgb.r = dot(val, from_yuv_bt601_rcoeff);\n"
-  "  rgb.g = dot(val, from_yuv_bt601_gcoeff);\n"
-  "  rgb.b = dot(val, from_yuv_bt601_bcoeff);\n"
+  "  val += @from_yuv_bt601_offset;\n"
+  "  rgb.r = dot(val, @from_yuv_bt601_rcoeff);\n"
+  "  rgb.g = dot(val, @from_yuv_bt601_gcoeff);\n"
+  "  rgb.b = dot(val, @from_yuv_bt601_bcoeff);\n"
   "  return rgb;\n"
   "}\n"
-  "vec3 rgb_to_yuv (vec3 val) {\n"
+  "vec3 @rgb_to_yuv (vec3 val) {\n"
   "  vec3 yuv;\n"
-  "  yuv.r = dot(val.rgb, from_rgb_bt601_ycoeff);\n"
-  "  yuv.g = dot(val.rgb, from_rgb_bt601_ucoeff);\n"
-  "  yuv.b = dot(val.rgb, from_rgb_bt601_vcoeff);\n"
-  "  yuv += from_rgb_bt601_offset;\n"
+  "  yuv.r = dot(val.rgb, @from_rgb_bt601_ycoeff);\n"
+  "  yuv.g = dot(val.rgb, @from_rgb_bt601_ucoeff);\n"
+  "  yuv.b = dot(val.rgb, @from_rgb_bt601_vcoeff);\n"
+  "  yuv += @from_rgb_bt601_offset;\n"
   "  return yuv;\n"
   "}\n"
   /* 224 = 256 - (256 - 240) - 16*/
-  "float luma_to_narrow (float luma) {\n"
+  "float @luma_to_narrow (float luma) {\n"
   "  return (luma + 16.0 / 256.0) * 219.0 / 256.0;"
   "}\n"
-  "float luma_to_full (float luma) {\n"
+  "float @luma_to_full (float luma) {\n"
   "  return (luma * 256.0 / 219.0) - 16.0 / 256.0;"
   "}\n"
-  "void main () {\n"
+  "vec4 @apply (vec4 rgba) {\n"
   "  vec3 yuv;\n"
+  "  if (@passthrough)\n"
+  "    return rgba;\n"
   /* operations translated from videobalanceand tested with glvideomixer
    * with one pad's paremeters blend-equation-rgb={subtract,reverse-subtract},
    * blend-function-src-rgb=src-color and blend-function-dst-rgb=dst-color */
-  "  float hue_cos = cos (PI * hue);\n"
-  "  float hue_sin = sin (PI * hue);\n"
-  "  vec4 rgba = texture2D (tex, v_texcoord);\n"
-  "  yuv = rgb_to_yuv (rgba.rgb);\n"
-  "  yuv.x = clamp (luma_to_narrow (luma_to_full(yuv.x) * contrast) + brightness, 0.0, 1.0);\n"
+  "  float hue_cos = cos (@PI * @hue);\n"
+  "  float hue_sin = sin (@PI * @hue);\n"
+  "  yuv = @rgb_to_yuv (rgba.rgb);\n"
+  "  yuv.x = clamp (@luma_to_narrow (@luma_to_full(yuv.x) * @contrast) + @brightness, 0.0, 1.0);\n"
   "  vec2 uv = yuv.yz;\n"
-  "  yuv.y = clamp (0.5 + (((uv.x - 0.5) * hue_cos + (uv.y - 0.5) * hue_sin) * saturation), 0.0, 1.0);\n"
-  "  yuv.z = clamp (0.5 + (((0.5 - uv.x) * hue_sin + (uv.y - 0.5) * hue_cos) * saturation), 0.0, 1.0);\n"
-  "  rgba.rgb = yuv_to_rgb (yuv);\n"
-  "  gl_FragColor = rgba;\n"
+  "  yuv.y = clamp (0.5 + (((uv.x - 0.5) * hue_cos + (uv.y - 0.5) * hue_sin) * @saturation), 0.0, 1.0);\n"
+  "  yuv.z = clamp (0.5 + (((0.5 - uv.x) * hue_sin + (uv.y - 0.5) * hue_cos) * @saturation), 0.0, 1.0);\n"
+  "  rgba.rgb = @yuv_to_rgb (yuv);\n"
+  "  return rgba;\n"
   "}\n";
 /* *INDENT-ON* */
 
@@ -127,6 +126,7 @@ enum
 
 static void gst_gl_color_balance_colorbalance_init (GstColorBalanceInterface *
     iface);
+static void gst_gl_color_balance_fusable_init (GstGLFusableInterface * iface);
 
 static void gst_gl_color_balance_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -137,7 +137,9 @@ static void gst_gl_color_balance_get_property (GObject * object, guint prop_id,
 G_DEFINE_TYPE_WITH_CODE (GstGLColorBalance, gst_gl_color_balance,
     GST_TYPE_GL_FILTER,
     G_IMPLEMENT_INTERFACE (GST_TYPE_COLOR_BALANCE,
-        gst_gl_color_balance_colorbalance_init));
+        gst_gl_color_balance_colorbalance_init);
+    G_IMPLEMENT_INTERFACE (GST_TYPE_GL_FUSABLE,
+        gst_gl_color_balance_fusable_init));
 
 static gboolean
 gst_gl_color_balance_is_passthrough (GstGLColorBalance * glcolorbalance)
@@ -169,17 +171,23 @@ _create_shader (GstGLColorBalance * balance)
   GstGLBaseFilter *base_filter = GST_GL_BASE_FILTER (balance);
   GstGLFilter *filter = GST_GL_FILTER (balance);
   GError *error = NULL;
+  GList fusables = { balance, NULL, NULL };
+  gchar *frag;
 
   if (balance->shader)
     gst_object_unref (balance->shader);
 
-  if (!(balance->shader =
-          gst_gl_shader_new_link_with_stages (base_filter->context, &error,
-              gst_glsl_stage_new_default_vertex (base_filter->context),
-              gst_glsl_stage_new_with_string (base_filter->context,
-                  GL_FRAGMENT_SHADER, GST_GLSL_VERSION_NONE,
-                  GST_GLSL_PROFILE_ES | GST_GLSL_PROFILE_COMPATIBILITY,
-                  color_balance_frag), NULL))) {
+  /* the same code as when fused with other filters, on its own */
+  frag = gst_gl_fusable_build_fragment_source (&fusables);
+  balance->shader =
+      gst_gl_shader_new_link_with_stages (base_filter->context, &error,
+      gst_glsl_stage_new_default_vertex (base_filter->context),
+      gst_glsl_stage_new_with_string (base_filter->context,
+          GL_FRAGMENT_SHADER, GST_GLSL_VERSION_NONE,
+          GST_GLSL_PROFILE_ES | GST_GLSL_PROFILE_COMPATIBILITY, frag), NULL);
+  g_free (frag);
+
+  if (!balance->shader) {
     GST_ELEMENT_ERROR (balance, RESOURCE, NOT_FOUND, ("%s",
             "Failed to initialize colorbalance shader"), ("%s",
             error ? error->message : "Unknown error"));
@@ -239,19 +247,16 @@ gst_gl_color_balance_filter_texture (GstGLFilter * filter, GstGLMemory * in_tex,
     GstGLMemory * out_tex)
 {
   GstGLColorBalance *balance = GST_GL_COLOR_BALANCE (filter);
+  gchar *prefix;
 
   if (!balance->shader)
     _create_shader (balance);
 
   gst_gl_shader_use (balance->shader);
-  GST_OBJECT_LOCK (balance);
-  gst_gl_shader_set_uniform_1f (balance->shader, "brightness",
-      balance->brightness);
-  gst_gl_shader_set_uniform_1f (balance->shader, "contrast", balance->contrast);
-  gst_gl_shader_set_uniform_1f (balance->shader, "saturation",
-      balance->saturation);
-  gst_gl_shader_set_uniform_1f (balance->shader, "hue", balance->hue);
-  GST_OBJECT_UNLOCK (balance);
+  prefix = gst_gl_fusable_get_prefix (0);
+  gst_gl_fusable_set_uniforms (GST_GL_FUSABLE (balance), balance->shader,
+      prefix);
+  g_free (prefix);
 
   gst_gl_filter_render_to_target_with_shader (filter, in_tex, out_tex,
       balance->shader);
@@ -452,6 +457,48 @@ gst_gl_color_balance_colorbalance_init (GstColorBalanceInterface * iface)
   iface->get_balance_type = gst_gl_color_balance_colorbalance_get_balance_type;
 }
 
+static const gchar *
+gst_gl_color_balance_fusable_get_snippet (GstGLFusable * fusable)
+{
+  return color_balance_snippet;
+}
+
+static void
+_set_uniform_1f (GstGLShader * shader, const gchar * prefix,
+    const gchar * name, gfloat value)
+{
+  gchar *uniform = g_strconcat (prefix, name, NULL);
+
+  gst_gl_shader_set_uniform_1f (shader, uniform, value);
+  g_free (uniform);
+}
+
+static void
+gst_gl_color_balance_fusable_set_uniforms (GstGLFusable * fusable,
+    GstGLShader * shader, const gchar * prefix)
+{
+  GstGLColorBalance *balance = GST_GL_COLOR_BALANCE (fusable);
+  gchar *uniform;
+
+  GST_OBJECT_LOCK (balance);
+  _set_uniform_1f (shader, prefix, "brightness", balance->brightness);
+  _set_uniform_1f (shader, prefix, "contrast", balance->contrast);
+  _set_uniform_1f (shader, prefix, "saturation", balance->saturation);
+  _set_uniform_1f (shader, prefix, "hue", balance->hue);
+  uniform = g_strconcat (prefix, "passthrough", NULL);
+  gst_gl_shader_set_uniform_1i (shader, uniform,
+      gst_gl_color_balance_is_passthrough (balance));
+  g_free (uniform);
+  GST_OBJECT_UNLOCK (balance);
+}
+
+static void
+gst_gl_color_balance_fusable_init (GstGLFusableInterface * iface)
+{
+  iface->get_snippet = gst_gl_color_balance_fusable_get_snippet;
+  iface->set_uniforms = gst_gl_color_balance_fusable_set_uniforms;
+}
+
 static GstColorBalanceChannel *
 gst_gl_color_balance_find_channel (GstGLColorBalance * balance,
     const gchar * label)
@@ -25,6 +25,17 @@
 #include <gst/gl/gl.h>
 #include "gstgldownloadelement.h"
 
+#if GST_GL_HAVE_DMABUF
+#include <gst/allocators/gstdmabuf.h>
+#include <gst/gl/egl/gsteglimage.h>
+#include <gst/gl/egl/gstglmemoryegl.h>
+#include <unistd.h>
+
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR 0ULL
+#endif
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_gl_download_element_debug);
 #define GST_CAT_DEFAULT gst_gl_download_element_debug
 
@@ -34,6 +45,29 @@ G_DEFINE_TYPE_WITH_CODE (GstGLDownloadElement, gst_gl_download_element,
     GST_DEBUG_CATEGORY_INIT (gst_gl_download_element_debug, "gldownloadelement",
         0, "download element"););
 
+#define DEFAULT_DOWNLOAD_DEPTH 0
+#define DEFAULT_DMABUF_EXPORT FALSE
+
+enum
+{
+  PROP_0,
+  PROP_DOWNLOAD_DEPTH,
+  PROP_DMABUF_EXPORT
+};
+
+static void gst_gl_download_element_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_gl_download_element_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_gl_download_element_finalize (GObject * object);
+static gboolean gst_gl_download_element_stop (GstBaseTransform * bt);
+static gboolean gst_gl_download_element_sink_event (GstBaseTransform * bt,
+    GstEvent * event);
+static gboolean gst_gl_download_element_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query);
+static gboolean gst_gl_download_element_decide_allocation (GstBaseTransform *
+    bt, GstQuery * query);
+
 static gboolean gst_gl_download_element_get_unit_size (GstBaseTransform * trans,
     GstCaps * caps, gsize * size);
 static GstCaps *gst_gl_download_element_transform_caps (GstBaseTransform * bt,
@@ -46,11 +80,18 @@ gst_gl_download_element_prepare_output_buffer (GstBaseTransform * bt,
 static GstFlowReturn gst_gl_download_element_transform (GstBaseTransform * bt,
     GstBuffer * buffer, GstBuffer * outbuf);
 
+#if GST_GL_HAVE_DMABUF
+#define EXTRA_CAPS_TEMPL "video/x-raw(" GST_CAPS_FEATURE_MEMORY_DMABUF "); "
+#else
+#define EXTRA_CAPS_TEMPL
+#endif
+
 static GstStaticPadTemplate gst_gl_download_element_src_pad_template =
     GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("video/x-raw; video/x-raw(memory:GLMemory)"));
+    GST_STATIC_CAPS (EXTRA_CAPS_TEMPL
+        "video/x-raw; video/x-raw(memory:GLMemory)"));
 
 static GstStaticPadTemplate gst_gl_download_element_sink_pad_template =
     GST_STATIC_PAD_TEMPLATE ("sink",
@@ -61,15 +102,61 @@ static GstStaticPadTemplate gst_gl_download_element_sink_pad_template =
 static void
 gst_gl_download_element_class_init (GstGLDownloadElementClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstBaseTransformClass *bt_class = GST_BASE_TRANSFORM_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->set_property = gst_gl_download_element_set_property;
+  gobject_class->get_property = gst_gl_download_element_get_property;
+  gobject_class->finalize = gst_gl_download_element_finalize;
+
+  /**
+   * GstGLDownloadElement:download-depth:
+   *
+   * The number of frames whose readback can be in flight at the same time.
+   * Each readback into system memory is fenced and the frame is only output
+   * once that many newer frames have been submitted, so that mapping it
+   * does not stall on the GPU. This adds as many frames of latency.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DOWNLOAD_DEPTH,
+      g_param_spec_uint ("download-depth", "Download depth",
+          "Number of frames to delay the output by to hide the download "
+          "latency (0 = map each frame right away)", 0, 16,
+          DEFAULT_DOWNLOAD_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGLDownloadElement:dmabuf-export:
+   *
+   * When outputting system memory, export the textures as linear dmabufs
+   * instead of reading them back, if the GL implementation supports
+   * EGL_MESA_image_dma_buf_export and downstream handles #GstVideoMeta.
+   * Sinks that import dmabufs such as kmssink can then scan out the GL
+   * output without any copy. Frames that can not be exported are read back
+   * as usual.
+   *
+   * Output caps with the memory:DMABuf feature always export.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DMABUF_EXPORT,
+      g_param_spec_boolean ("dmabuf-export", "DMABuf export",
+          "Export the textures as dmabufs instead of reading them back into "
+          "system memory when possible", DEFAULT_DMABUF_EXPORT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   bt_class->transform_caps = gst_gl_download_element_transform_caps;
   bt_class->set_caps = gst_gl_download_element_set_caps;
   bt_class->get_unit_size = gst_gl_download_element_get_unit_size;
   bt_class->prepare_output_buffer =
       gst_gl_download_element_prepare_output_buffer;
   bt_class->transform = gst_gl_download_element_transform;
+  bt_class->stop = gst_gl_download_element_stop;
+  bt_class->sink_event = gst_gl_download_element_sink_event;
+  bt_class->query = gst_gl_download_element_query;
+  bt_class->decide_allocation = gst_gl_download_element_decide_allocation;
 
   bt_class->passthrough_on_same_caps = TRUE;
 
@@ -88,17 +175,198 @@ gst_gl_download_element_init (GstGLDownloadElement * download)
 {
   gst_base_transform_set_prefer_passthrough (GST_BASE_TRANSFORM (download),
       TRUE);
+
+  download->download_depth = DEFAULT_DOWNLOAD_DEPTH;
+  download->dmabuf_export = DEFAULT_DMABUF_EXPORT;
+  g_queue_init (&download->pending);
+  gst_video_info_init (&download->out_info);
+#if GST_GL_HAVE_DMABUF
+  download->dmabuf_allocator = gst_dmabuf_allocator_new ();
+#endif
+}
+
+static void
+gst_gl_download_element_finalize (GObject * object)
+{
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (object);
+
+  g_queue_foreach (&download->pending, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&download->pending);
+
+  if (download->dmabuf_allocator)
+    gst_object_unref (download->dmabuf_allocator);
+  download->dmabuf_allocator = NULL;
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_gl_download_element_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (object);
+
+  switch (prop_id) {
+    case PROP_DOWNLOAD_DEPTH:
+      GST_OBJECT_LOCK (download);
+      download->download_depth = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (download);
+      break;
+    case PROP_DMABUF_EXPORT:
+      GST_OBJECT_LOCK (download);
+      download->dmabuf_export = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (download);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_download_element_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (object);
+
+  switch (prop_id) {
+    case PROP_DOWNLOAD_DEPTH:
+      GST_OBJECT_LOCK (download);
+      g_value_set_uint (value, download->download_depth);
+      GST_OBJECT_UNLOCK (download);
+      break;
+    case PROP_DMABUF_EXPORT:
+      GST_OBJECT_LOCK (download);
+      g_value_set_boolean (value, download->dmabuf_export);
+      GST_OBJECT_UNLOCK (download);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* waits for the readback of the oldest pending buffer to complete */
+static GstBuffer *
+gst_gl_download_element_pop_pending (GstGLDownloadElement * download)
+{
+  GstGLContext *context = GST_GL_BASE_FILTER (download)->context;
+  GstBuffer *buffer;
+  GstGLSyncMeta *sync_meta;
+
+  buffer = g_queue_pop_head (&download->pending);
+  if (!buffer)
+    return NULL;
+
+  sync_meta = gst_buffer_get_gl_sync_meta (buffer);
+  if (sync_meta && context)
+    gst_gl_sync_meta_wait_cpu (sync_meta, context);
+
+  return buffer;
+}
+
+static void
+gst_gl_download_element_flush_pending (GstGLDownloadElement * download)
+{
+  g_queue_foreach (&download->pending, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&download->pending);
+}
+
+static GstFlowReturn
+gst_gl_download_element_drain (GstGLDownloadElement * download)
+{
+  GstPad *srcpad = GST_BASE_TRANSFORM_SRC_PAD (download);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buffer;
+
+  while ((buffer = gst_gl_download_element_pop_pending (download))) {
+    if (ret == GST_FLOW_OK)
+      ret = gst_pad_push (srcpad, buffer);
+    else
+      gst_buffer_unref (buffer);
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_gl_download_element_sink_event (GstBaseTransform * bt, GstEvent * event)
+{
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (bt);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+    case GST_EVENT_CAPS:
+    case GST_EVENT_SEGMENT:
+      gst_gl_download_element_drain (download);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_gl_download_element_flush_pending (download);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (bt, event);
+}
+
+static gboolean
+gst_gl_download_element_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query)
+{
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (bt);
+  gboolean ret;
+
+  ret = GST_BASE_TRANSFORM_CLASS (parent_class)->query (bt, direction, query);
+
+  if (ret && direction == GST_PAD_SRC
+      && GST_QUERY_TYPE (query) == GST_QUERY_LATENCY) {
+    GstClockTime min, max, latency = 0;
+    gboolean live;
+    guint depth;
+
+    GST_OBJECT_LOCK (download);
+    depth = download->download_depth;
+    if (depth > 0 && GST_VIDEO_INFO_FPS_N (&download->out_info) > 0)
+      latency = gst_util_uint64_scale_int (depth * GST_SECOND,
+          GST_VIDEO_INFO_FPS_D (&download->out_info),
+          GST_VIDEO_INFO_FPS_N (&download->out_info));
+    GST_OBJECT_UNLOCK (download);
+
+    if (latency > 0) {
+      gst_query_parse_latency (query, &live, &min, &max);
+      min += latency;
+      if (GST_CLOCK_TIME_IS_VALID (max))
+        max += latency;
+      gst_query_set_latency (query, live, min, max);
+    }
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_gl_download_element_stop (GstBaseTransform * bt)
+{
+  gst_gl_download_element_flush_pending (GST_GL_DOWNLOAD_ELEMENT (bt));
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->stop (bt);
 }
 
 static gboolean
 gst_gl_download_element_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
     GstCaps * out_caps)
 {
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (bt);
   GstVideoInfo out_info;
 
   if (!gst_video_info_from_caps (&out_info, out_caps))
     return FALSE;
 
+  GST_OBJECT_LOCK (download);
+  download->out_info = out_info;
+  GST_OBJECT_UNLOCK (download);
+
   return TRUE;
 }
 
@@ -126,8 +394,13 @@ gst_gl_download_element_transform_caps (GstBaseTransform * bt,
     tmp = _set_caps_features (caps, GST_CAPS_FEATURE_MEMORY_GL_MEMORY);
     tmp = gst_caps_merge (gst_caps_ref (caps), tmp);
   } else {
-    tmp = _set_caps_features (caps, GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY);
-    tmp = gst_caps_merge (gst_caps_ref (caps), tmp);
+    tmp = gst_caps_ref (caps);
+#if GST_GL_HAVE_DMABUF
+    tmp = gst_caps_merge (tmp, _set_caps_features (caps,
+            GST_CAPS_FEATURE_MEMORY_DMABUF));
+#endif
+    tmp = gst_caps_merge (tmp, _set_caps_features (caps,
+            GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY));
   }
 
   if (filter) {
@@ -156,12 +429,190 @@ gst_gl_download_element_get_unit_size (GstBaseTransform * trans, GstCaps * caps,
   return TRUE;
 }
 
+static gboolean
+gst_gl_download_element_decide_allocation (GstBaseTransform * bt,
+    GstQuery * query)
+{
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (bt);
+  gboolean video_meta;
+
+  video_meta =
+      gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  GST_OBJECT_LOCK (download);
+  download->dmabuf_video_meta = video_meta;
+  GST_OBJECT_UNLOCK (download);
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (bt,
+      query);
+}
+
+#if GST_GL_HAVE_DMABUF
+/* the export of a texture, cached on the GstGLMemory since pooled memories
+ * keep their texture and the importers downstream (e.g. kmssink) cache their
+ * own objects on the dmabuf memory */
+typedef struct
+{
+  GstMemory *dmabuf;            /* NULL if the texture is not linear */
+  gint stride;
+  gsize offset;
+} DmabufExport;
+
+static GQuark
+_dmabuf_export_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstGLDownloadDmabufExport");
+
+  return quark;
+}
+
+static void
+_dmabuf_export_free (DmabufExport * export)
+{
+  if (export->dmabuf)
+    gst_memory_unref (export->dmabuf);
+  g_slice_free (DmabufExport, export);
+}
+
+struct ExportDmabuf
+{
+  GstGLDownloadElement *download;
+  GstGLMemory *mem;
+  gboolean linear_only;
+  DmabufExport *result;
+};
+
+static void
+_export_dmabuf_gl (GstGLContext * context, struct ExportDmabuf *data)
+{
+  GstEGLImage *image;
+  guint64 modifier;
+  gint fd, stride;
+  gsize offset, size;
+  off_t end;
+  gboolean ret;
+
+  if (gst_is_gl_memory_egl ((GstMemory *) data->mem))
+    image = gst_egl_image_ref (((GstGLMemoryEGL *) data->mem)->image);
+  else
+    image = gst_egl_image_from_texture (context, data->mem, NULL);
+  if (!image)
+    return;
+
+  ret = gst_egl_image_export_dmabuf (image, &fd, &stride, &offset, &modifier);
+  gst_egl_image_unref (image);
+  if (!ret)
+    return;
+
+  if (data->linear_only && modifier != DRM_FORMAT_MOD_LINEAR) {
+    GST_DEBUG_OBJECT (data->download, "texture %u exported with the non-linear "
+        "modifier 0x%" G_GINT64_MODIFIER "x", data->mem->tex_id, modifier);
+    close (fd);
+    /* remember it so that the next frames do not try again */
+    data->result = g_slice_new0 (DmabufExport);
+    return;
+  }
+
+  end = lseek (fd, 0, SEEK_END);
+  if (end > 0)
+    size = end;
+  else
+    size = offset + stride * gst_gl_memory_get_texture_height (data->mem);
+
+  data->result = g_slice_new0 (DmabufExport);
+  data->result->dmabuf =
+      gst_dmabuf_allocator_alloc (data->download->dmabuf_allocator, fd, size);
+  data->result->stride = stride;
+  data->result->offset = offset;
+}
+
+/* wraps the dmabuf exported from the texture of @inbuf in a new buffer,
+ * keeping @inbuf alive until downstream is done with it */
+static GstBuffer *
+gst_gl_download_element_export_dmabuf (GstGLDownloadElement * download,
+    GstBuffer * inbuf, gboolean linear_only)
+{
+  GstGLContext *context = GST_GL_BASE_FILTER (download)->context;
+  gsize offset[GST_VIDEO_MAX_PLANES] = { 0, };
+  gint stride[GST_VIDEO_MAX_PLANES] = { 0, };
+  GstVideoInfo *out_info = &download->out_info;
+  DmabufExport *export;
+  GstGLSyncMeta *sync_meta;
+  GstGLMemory *mem;
+  GstBuffer *outbuf;
+
+  if (!context || gst_buffer_n_memory (inbuf) != 1
+      || GST_VIDEO_INFO_N_PLANES (out_info) != 1)
+    return NULL;
+
+  mem = (GstGLMemory *) gst_buffer_peek_memory (inbuf, 0);
+  if (!gst_is_gl_memory ((GstMemory *) mem)
+      || mem->tex_target != GST_GL_TEXTURE_TARGET_2D)
+    return NULL;
+
+  export = gst_mini_object_get_qdata (GST_MINI_OBJECT (mem),
+      _dmabuf_export_quark ());
+  if (export && !export->dmabuf && !linear_only) {
+    gst_mini_object_set_qdata (GST_MINI_OBJECT (mem), _dmabuf_export_quark (),
+        NULL, NULL);
+    export = NULL;
+  }
+
+  if (!export) {
+    struct ExportDmabuf data;
+
+    data.download = download;
+    data.mem = mem;
+    data.linear_only = linear_only;
+    data.result = NULL;
+
+    gst_gl_context_thread_add (context,
+        (GstGLContextThreadFunc) _export_dmabuf_gl, &data);
+    if (!data.result)
+      return NULL;
+
+    export = data.result;
+    gst_mini_object_set_qdata (GST_MINI_OBJECT (mem), _dmabuf_export_quark (),
+        export, (GDestroyNotify) _dmabuf_export_free);
+  }
+
+  if (!export->dmabuf)
+    return NULL;
+
+  /* the consumer reads the texture storage directly */
+  sync_meta = gst_buffer_get_gl_sync_meta (inbuf);
+  if (sync_meta)
+    gst_gl_sync_meta_wait_cpu (sync_meta, context);
+
+  outbuf = gst_buffer_new ();
+  gst_buffer_append_memory (outbuf, gst_memory_ref (export->dmabuf));
+  gst_buffer_copy_into (outbuf, inbuf,
+      GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+  offset[0] = export->offset;
+  stride[0] = export->stride;
+  gst_buffer_add_video_meta_full (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (out_info), GST_VIDEO_INFO_WIDTH (out_info),
+      GST_VIDEO_INFO_HEIGHT (out_info), 1, offset, stride);
+  gst_buffer_add_parent_buffer_meta (outbuf, inbuf);
+
+  return outbuf;
+}
+#endif
+
 static GstFlowReturn
 gst_gl_download_element_prepare_output_buffer (GstBaseTransform * bt,
     GstBuffer * inbuf, GstBuffer ** outbuf)
 {
+  GstGLDownloadElement *download = GST_GL_DOWNLOAD_ELEMENT (bt);
+  GstGLContext *context = GST_GL_BASE_FILTER (bt)->context;
   GstCaps *src_caps = gst_pad_get_current_caps (bt->srcpad);
   GstCapsFeatures *features = NULL;
+  gboolean downloading = FALSE;
+  guint depth;
   gint i, n;
 
   *outbuf = inbuf;
@@ -169,6 +620,43 @@ gst_gl_download_element_prepare_output_buffer (GstBaseTransform * bt,
   if (src_caps)
     features = gst_caps_get_features (src_caps, 0);
 
+#if GST_GL_HAVE_DMABUF
+  if (features) {
+    gboolean export_required, export_linear;
+
+    GST_OBJECT_LOCK (download);
+    export_required = gst_caps_features_contains (features,
+        GST_CAPS_FEATURE_MEMORY_DMABUF);
+    export_linear = download->dmabuf_export && download->dmabuf_video_meta
+        && gst_caps_features_contains (features,
+        GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY);
+    GST_OBJECT_UNLOCK (download);
+
+    if (export_required || export_linear) {
+      GstBuffer *exported;
+
+      exported = gst_gl_download_element_export_dmabuf (download, inbuf,
+          export_linear);
+
+      if (exported) {
+        gst_caps_unref (src_caps);
+        if (!g_queue_is_empty (&download->pending))
+          gst_gl_download_element_drain (download);
+        *outbuf = exported;
+        return GST_FLOW_OK;
+      }
+
+      if (export_required) {
+        gst_caps_unref (src_caps);
+        *outbuf = NULL;
+        GST_ELEMENT_ERROR (download, RESOURCE, FAILED,
+            ("Failed to export the GL memory as a dmabuf"), (NULL));
+        return GST_FLOW_ERROR;
+      }
+    }
+  }
+#endif
+
   n = gst_buffer_n_memory (*outbuf);
   for (i = 0; i < n; i++) {
     GstMemory *mem = gst_buffer_peek_memory (*outbuf, i);
@@ -176,8 +664,10 @@ gst_gl_download_element_prepare_output_buffer (GstBaseTransform * bt,
     if (gst_is_gl_memory (mem)) {
       if (!features || gst_caps_features_contains (features,
               GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY)) {
-        if (gst_is_gl_memory_pbo (mem))
+        if (gst_is_gl_memory_pbo (mem)) {
           gst_gl_memory_pbo_download_transfer ((GstGLMemoryPBO *) mem);
+          downloading = TRUE;
+        }
       }
     }
   }
@@ -185,6 +675,33 @@ gst_gl_download_element_prepare_output_buffer (GstBaseTransform * bt,
   if (src_caps)
     gst_caps_unref (src_caps);
 
+  GST_OBJECT_LOCK (download);
+  depth = download->download_depth;
+  GST_OBJECT_UNLOCK (download);
+
+  if (downloading && depth > 0 && context) {
+    GstBuffer *pending = gst_buffer_make_writable (gst_buffer_ref (inbuf));
+    GstGLSyncMeta *sync_meta;
+
+    /* fence the readbacks that were just started and only hand out the
+     * frame once enough newer ones are queued behind it */
+    sync_meta = gst_buffer_get_gl_sync_meta (pending);
+    if (!sync_meta)
+      sync_meta = gst_buffer_add_gl_sync_meta (context, pending);
+    gst_gl_sync_meta_set_sync_point (sync_meta, context);
+    g_queue_push_tail (&download->pending, pending);
+
+    if (g_queue_get_length (&download->pending) <= depth) {
+      *outbuf = NULL;
+      return GST_BASE_TRANSFORM_FLOW_DROPPED;
+    }
+
+    *outbuf = gst_gl_download_element_pop_pending (download);
+  } else if (!g_queue_is_empty (&download->pending)) {
+    /* the depth was lowered or the output changed, keep the order */
+    gst_gl_download_element_drain (download);
+  }
+
   return GST_FLOW_OK;
 }
 
@@ -43,6 +43,15 @@ struct _GstGLDownloadElement
 {
   /* <private> */
   GstGLBaseFilter  parent;
+
+  guint            download_depth;
+  GQueue           pending;     /* buffers with a readback in flight */
+  GstVideoInfo     out_info;
+
+  gboolean         dmabuf_export;
+  /* downstream handles the strides and offsets of exported dmabufs */
+  gboolean         dmabuf_video_meta;
+  GstAllocator    *dmabuf_allocator;
 };
 
 struct _GstGLDownloadElementClass
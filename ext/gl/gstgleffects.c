@@ -38,6 +38,7 @@
 
 #include <gst/gl/gstglconfig.h>
 #include "gstgleffects.h"
+#include "gstglfusable.h"
 
 #define GST_CAT_DEFAULT gst_gl_effects_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -53,9 +54,12 @@ enum
 #define DEBUG_INIT \
   GST_DEBUG_CATEGORY_INIT (gst_gl_effects_debug, "gleffects", 0, "gleffects element");
 
+static void gst_gl_effects_fusable_init (GstGLFusableInterface * iface);
+
 #define gst_gl_effects_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstGLEffects, gst_gl_effects, GST_TYPE_GL_FILTER,
-    DEBUG_INIT);
+    DEBUG_INIT;
+    G_IMPLEMENT_INTERFACE (GST_TYPE_GL_FUSABLE, gst_gl_effects_fusable_init));
 
 static void gst_gl_effects_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -529,6 +533,32 @@ gst_gl_effects_on_init_gl_context (GstGLFilter * filter)
   return TRUE;
 }
 
+/* only the effects that do not look at other pixels and need no lookup
+ * tables can be fused */
+static const gchar *
+gst_gl_effects_fusable_get_snippet (GstGLFusable * fusable)
+{
+  GstGLEffects *effects = GST_GL_EFFECTS (fusable);
+
+  if (effects->horizontal_swap)
+    return NULL;
+
+  switch (effects->current_effect) {
+    case GST_GL_EFFECT_IDENTITY:
+      return identity_fusable_snippet;
+    case GST_GL_EFFECT_SIN:
+      return sin_fusable_snippet;
+    default:
+      return NULL;
+  }
+}
+
+static void
+gst_gl_effects_fusable_init (GstGLFusableInterface * iface)
+{
+  iface->get_snippet = gst_gl_effects_fusable_get_snippet;
+}
+
 static gboolean
 gst_gl_effects_filter_texture (GstGLFilter * filter, GstGLMemory * in_tex,
     GstGLMemory * out_tex)
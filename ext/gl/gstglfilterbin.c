@@ -23,6 +23,7 @@
 #endif
 
 #include "gstglfilterbin.h"
+#include "gstglfusedfilter.h"
 
 #define GST_CAT_DEFAULT gst_gl_filter_bin_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -32,8 +33,11 @@ enum
 {
   PROP_0,
   PROP_FILTER,
+  PROP_FUSE,
 };
 
+#define DEFAULT_FUSE FALSE
+
 enum
 {
   SIGNAL_0,
@@ -53,6 +57,8 @@ static void gst_gl_filter_bin_get_property (GObject * object, guint prop_id,
 static void gst_gl_filter_bin_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 
+static void gst_gl_filter_bin_dispose (GObject * object);
+
 static GstStateChangeReturn gst_gl_filter_bin_change_state (GstElement *
     element, GstStateChange transition);
 
@@ -72,6 +78,7 @@ gst_gl_filter_bin_class_init (GstGLFilterBinClass * klass)
 
   gobject_class->set_property = gst_gl_filter_bin_set_property;
   gobject_class->get_property = gst_gl_filter_bin_get_property;
+  gobject_class->dispose = gst_gl_filter_bin_dispose;
 
   gst_element_class_add_static_pad_template (element_class, &_src_pad_template);
 
@@ -88,6 +95,22 @@ gst_gl_filter_bin_class_init (GstGLFilterBinClass * klass)
           GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE |
           G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGLFilterBin:fuse:
+   *
+   * When the filter is a bin with a chain of filters that only change each
+   * pixel by itself, like glcolorbalance, run the whole chain as one shader
+   * instead of rendering every filter to its own texture. Other filters are
+   * used as they are.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_FUSE,
+      g_param_spec_boolean ("fuse", "Fuse",
+          "Run a chain of per-pixel GL filters in a single pass",
+          DEFAULT_FUSE, GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE |
+          G_PARAM_STATIC_STRINGS));
+
   /**
    * GstFilterBin::create-element:
    * @object: the #GstGLFilterBin
@@ -122,6 +145,8 @@ gst_gl_filter_bin_init (GstGLFilterBin * self)
   gst_bin_add (GST_BIN (self), self->out_convert);
   gst_bin_add (GST_BIN (self), self->download);
 
+  self->fuse = DEFAULT_FUSE;
+
   gst_element_link_pads (self->upload, "src", self->in_convert, "sink");
   gst_element_link_pads (self->out_convert, "src", self->download, "sink");
 
@@ -142,16 +167,123 @@ gst_gl_filter_bin_init (GstGLFilterBin * self)
   }
 }
 
+/* Returns the elements of the filter bin in stream order if they are linked
+ * one after the other */
+static GList *
+_get_filter_chain (GstGLFilterBin * self)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GList *chain = NULL, *iter;
+  gboolean done = FALSE, linear = TRUE;
+
+  if (!GST_IS_BIN (self->filter))
+    return NULL;
+
+  /* sinks come first */
+  it = gst_bin_iterate_sorted (GST_BIN (self->filter));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        chain = g_list_prepend (chain, g_value_dup_object (&item));
+        g_value_reset (&item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        g_list_free_full (chain, gst_object_unref);
+        chain = NULL;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  for (iter = chain; iter && iter->next && linear; iter = iter->next) {
+    GstPad *srcpad, *peer = NULL;
+
+    srcpad = gst_element_get_static_pad (iter->data, "src");
+    if (srcpad) {
+      peer = gst_pad_get_peer (srcpad);
+      gst_object_unref (srcpad);
+    }
+
+    linear = peer && GST_OBJECT_PARENT (peer) == iter->next->data;
+    if (peer)
+      gst_object_unref (peer);
+  }
+
+  if (!linear) {
+    g_list_free_full (chain, gst_object_unref);
+    chain = NULL;
+  }
+
+  return chain;
+}
+
+/* a single element is not worth fusing */
+static GstElement *
+_create_fused_element (GstGLFilterBin * self)
+{
+  GstElement *fused = NULL;
+  GList *chain;
+
+  if (!self->fuse)
+    return NULL;
+
+  chain = _get_filter_chain (self);
+  if (chain && chain->next && gst_gl_fused_filter_can_fuse (chain)) {
+    GST_INFO_OBJECT (self, "fusing the %u filters of %" GST_PTR_FORMAT,
+        g_list_length (chain), self->filter);
+    fused = gst_gl_fused_filter_new (chain);
+  } else {
+    GST_DEBUG_OBJECT (self, "cannot fuse %" GST_PTR_FORMAT, self->filter);
+  }
+  g_list_free_full (chain, gst_object_unref);
+
+  return fused;
+}
+
+static GstElement *
+_get_linked_element (GstGLFilterBin * self)
+{
+  return self->fused ? self->fused : self->filter;
+}
+
+static void
+_disconnect_filter_element (GstGLFilterBin * self)
+{
+  if (self->fused) {
+    gst_bin_remove (GST_BIN (self), self->fused);
+    self->fused = NULL;
+    gst_object_unref (self->filter);
+  } else {
+    gst_bin_remove (GST_BIN (self), self->filter);
+  }
+}
+
 static gboolean
 _connect_filter_element (GstGLFilterBin * self)
 {
+  GstElement *element;
   gboolean res = TRUE;
 
   gst_object_set_name (GST_OBJECT (self->filter), "filter");
-  res &= gst_bin_add (GST_BIN (self), self->filter);
 
-  res &= gst_element_link_pads (self->in_convert, "src", self->filter, "sink");
-  res &= gst_element_link_pads (self->filter, "src", self->out_convert, "sink");
+  self->fused = _create_fused_element (self);
+  if (self->fused) {
+    gst_object_set_name (GST_OBJECT (self->fused), "fused");
+    /* the bin does not hold the filter then */
+    gst_object_ref_sink (self->filter);
+  }
+
+  element = _get_linked_element (self);
+  res &= gst_bin_add (GST_BIN (self), element);
+
+  res &= gst_element_link_pads (self->in_convert, "src", element, "sink");
+  res &= gst_element_link_pads (element, "src", self->out_convert, "sink");
 
   if (!res)
     GST_ERROR_OBJECT (self, "Failed to link filter element into the pipeline");
@@ -159,6 +291,21 @@ _connect_filter_element (GstGLFilterBin * self)
   return res;
 }
 
+static void
+gst_gl_filter_bin_dispose (GObject * object)
+{
+  GstGLFilterBin *self = GST_GL_FILTER_BIN (object);
+
+  /* the fused element itself goes away with the bin */
+  if (self->fused) {
+    self->fused = NULL;
+    gst_object_unref (self->filter);
+    self->filter = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
 void
 gst_gl_filter_bin_finish_init_with_element (GstGLFilterBin * self,
     GstElement * element)
@@ -168,7 +315,10 @@ gst_gl_filter_bin_finish_init_with_element (GstGLFilterBin * self,
   self->filter = element;
 
   if (!_connect_filter_element (self)) {
-    gst_object_unref (self->filter);
+    if (self->fused)
+      _disconnect_filter_element (self);
+    else
+      gst_object_unref (self->filter);
     self->filter = NULL;
   }
 }
@@ -196,6 +346,9 @@ gst_gl_filter_bin_get_property (GObject * object, guint prop_id,
     case PROP_FILTER:
       g_value_set_object (value, self->filter);
       break;
+    case PROP_FUSE:
+      g_value_set_boolean (value, self->fuse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -213,7 +366,7 @@ gst_gl_filter_bin_set_property (GObject * object, guint prop_id,
     {
       GstElement *filter = g_value_get_object (value);
       if (self->filter)
-        gst_bin_remove (GST_BIN (self), self->filter);
+        _disconnect_filter_element (self);
       self->filter = filter;
       if (filter) {
         gst_object_ref_sink (filter);
@@ -221,6 +374,16 @@ gst_gl_filter_bin_set_property (GObject * object, guint prop_id,
       }
       break;
     }
+    case PROP_FUSE:
+      self->fuse = g_value_get_boolean (value);
+      /* link the filter again, fused or not */
+      if (self->filter) {
+        gst_object_ref (self->filter);
+        _disconnect_filter_element (self);
+        _connect_filter_element (self);
+        gst_object_unref (self->filter);
+      }
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
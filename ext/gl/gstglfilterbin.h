@@ -56,8 +56,13 @@ struct _GstGLFilterBin
   GstElement *upload;
   GstElement *in_convert;
   GstElement *filter;
+  /* runs the chain of filter when it was fused, filter is not in the bin
+   * then */
+  GstElement *fused;
   GstElement *out_convert;
   GstElement *download;
+
+  gboolean fuse;
 };
 
 /**
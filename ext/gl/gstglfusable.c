@@ -0,0 +1,107 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstglfusable.h"
+
+G_DEFINE_INTERFACE (GstGLFusable, gst_gl_fusable, G_TYPE_OBJECT);
+
+static void
+gst_gl_fusable_default_init (GstGLFusableInterface * iface)
+{
+}
+
+const gchar *
+gst_gl_fusable_get_snippet (GstGLFusable * fusable)
+{
+  GstGLFusableInterface *iface;
+
+  g_return_val_if_fail (GST_IS_GL_FUSABLE (fusable), NULL);
+
+  iface = GST_GL_FUSABLE_GET_INTERFACE (fusable);
+  g_return_val_if_fail (iface->get_snippet != NULL, NULL);
+
+  return iface->get_snippet (fusable);
+}
+
+void
+gst_gl_fusable_set_uniforms (GstGLFusable * fusable, GstGLShader * shader,
+    const gchar * prefix)
+{
+  GstGLFusableInterface *iface;
+
+  g_return_if_fail (GST_IS_GL_FUSABLE (fusable));
+
+  iface = GST_GL_FUSABLE_GET_INTERFACE (fusable);
+  if (iface->set_uniforms)
+    iface->set_uniforms (fusable, shader, prefix);
+}
+
+/* the prefix of the names of the snippet at @index in a fused shader */
+gchar *
+gst_gl_fusable_get_prefix (guint index)
+{
+  return g_strdup_printf ("f%u_", index);
+}
+
+/* Generates a fragment shader that samples the input texture once and runs
+ * the snippets of @fusables on the pixel in list order. Returns NULL if one
+ * of them is not per-pixel in its current configuration. */
+gchar *
+gst_gl_fusable_build_fragment_source (GList * fusables)
+{
+  GString *decls, *body;
+  GList *iter;
+  guint i;
+
+  decls = g_string_new ("#ifdef GL_ES\n"
+      "precision mediump float;\n"
+      "#endif\n" "varying vec2 v_texcoord;\n" "uniform sampler2D tex;\n");
+  body = g_string_new ("void main () {\n"
+      "  vec4 rgba = texture2D (tex, v_texcoord);\n");
+
+  for (iter = fusables, i = 0; iter; iter = g_list_next (iter), i++) {
+    const gchar *snippet = gst_gl_fusable_get_snippet (iter->data);
+    gchar **parts, *prefix, *code;
+
+    if (snippet == NULL) {
+      g_string_free (decls, TRUE);
+      g_string_free (body, TRUE);
+      return NULL;
+    }
+
+    prefix = gst_gl_fusable_get_prefix (i);
+    parts = g_strsplit (snippet, "@", -1);
+    code = g_strjoinv (prefix, parts);
+    g_string_append_printf (decls, "%s\n", code);
+    g_string_append_printf (body, "  rgba = %sapply (rgba);\n", prefix);
+    g_free (code);
+    g_strfreev (parts);
+    g_free (prefix);
+  }
+
+  g_string_append (body, "  gl_FragColor = rgba;\n}\n");
+  g_string_append (decls, body->str);
+  g_string_free (body, TRUE);
+
+  return g_string_free (decls, FALSE);
+}
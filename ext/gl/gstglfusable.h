@@ -0,0 +1,74 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_GL_FUSABLE_H__
+#define __GST_GL_FUSABLE_H__
+
+#include <gst/gst.h>
+#include <gst/gl/gl.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_FUSABLE \
+  (gst_gl_fusable_get_type())
+#define GST_GL_FUSABLE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_FUSABLE,GstGLFusable))
+#define GST_IS_GL_FUSABLE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_FUSABLE))
+#define GST_GL_FUSABLE_GET_INTERFACE(obj) \
+  (G_TYPE_INSTANCE_GET_INTERFACE((obj),GST_TYPE_GL_FUSABLE,GstGLFusableInterface))
+
+typedef struct _GstGLFusable GstGLFusable;
+typedef struct _GstGLFusableInterface GstGLFusableInterface;
+
+/*
+ * GstGLFusableInterface:
+ * @get_snippet: returns the GLSL code of the per-pixel operation of the
+ *     filter in its current configuration, or %NULL if it is not per-pixel.
+ *     The code declares its uniforms and defines a
+ *     "vec4 @apply (vec4 rgba)" function, where "@" stands for a prefix
+ *     added to all of its global names. It does not sample any texture.
+ * @set_uniforms: sets the values of the uniforms of the snippet, named with
+ *     @prefix, on the currently used @shader
+ *
+ * Implemented by the GL filters whose output pixel only depends on the input
+ * pixel at the same position, so that several of them can be run as one
+ * shader.
+ */
+struct _GstGLFusableInterface
+{
+  GTypeInterface parent_iface;
+
+  const gchar * (*get_snippet)  (GstGLFusable * fusable);
+  void          (*set_uniforms) (GstGLFusable * fusable, GstGLShader * shader,
+                                 const gchar * prefix);
+};
+
+GType gst_gl_fusable_get_type (void);
+
+const gchar * gst_gl_fusable_get_snippet (GstGLFusable * fusable);
+void gst_gl_fusable_set_uniforms (GstGLFusable * fusable, GstGLShader * shader,
+    const gchar * prefix);
+
+gchar * gst_gl_fusable_get_prefix (guint index);
+gchar * gst_gl_fusable_build_fragment_source (GList * fusables);
+
+G_END_DECLS
+
+#endif /* __GST_GL_FUSABLE_H__ */
@@ -0,0 +1,253 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstglfusedfilter.h"
+#include "gstglfusable.h"
+
+#define GST_CAT_DEFAULT gst_gl_fused_filter_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define gst_gl_fused_filter_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstGLFusedFilter, gst_gl_fused_filter,
+    GST_TYPE_GL_FILTER, GST_DEBUG_CATEGORY_INIT (gst_gl_fused_filter_debug,
+        "glfusedfilter", 0, "glfusedfilter element"););
+
+static void gst_gl_fused_filter_finalize (GObject * object);
+static void gst_gl_fused_filter_before_transform (GstBaseTransform * trans,
+    GstBuffer * buf);
+static gboolean gst_gl_fused_filter_gl_start (GstGLBaseFilter * base);
+static void gst_gl_fused_filter_gl_stop (GstGLBaseFilter * base);
+static gboolean gst_gl_fused_filter_filter_texture (GstGLFilter * filter,
+    GstGLMemory * in_tex, GstGLMemory * out_tex);
+
+static void
+gst_gl_fused_filter_class_init (GstGLFusedFilterClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_gl_filter_add_rgba_pad_templates (GST_GL_FILTER_CLASS (klass));
+
+  gobject_class->finalize = gst_gl_fused_filter_finalize;
+
+  GST_BASE_TRANSFORM_CLASS (klass)->before_transform =
+      gst_gl_fused_filter_before_transform;
+
+  GST_GL_BASE_FILTER_CLASS (klass)->gl_start = gst_gl_fused_filter_gl_start;
+  GST_GL_BASE_FILTER_CLASS (klass)->gl_stop = gst_gl_fused_filter_gl_stop;
+
+  GST_GL_FILTER_CLASS (klass)->filter_texture =
+      gst_gl_fused_filter_filter_texture;
+
+  gst_element_class_set_metadata (element_class,
+      "OpenGL fused filter", "Filter/Effect/Video",
+      "Runs several per-pixel GL filters in one pass",
+      "Matthew Waters <matthew@centricular.com>");
+}
+
+static void
+gst_gl_fused_filter_init (GstGLFusedFilter * self)
+{
+  self->snippets = g_ptr_array_new ();
+}
+
+static void
+gst_gl_fused_filter_finalize (GObject * object)
+{
+  GstGLFusedFilter *self = GST_GL_FUSED_FILTER (object);
+
+  g_list_free_full (self->fusables, gst_object_unref);
+  g_ptr_array_free (self->snippets, TRUE);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* Whether @elements, in stream order, can be run by a fused filter in their
+ * current configuration. */
+gboolean
+gst_gl_fused_filter_can_fuse (GList * elements)
+{
+  GList *iter;
+
+  if (elements == NULL)
+    return FALSE;
+
+  for (iter = elements; iter; iter = g_list_next (iter)) {
+    if (!GST_IS_GL_FUSABLE (iter->data)
+        || gst_gl_fusable_get_snippet (iter->data) == NULL)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Takes a reference on the @elements, which must not be in a pipeline. */
+GstElement *
+gst_gl_fused_filter_new (GList * elements)
+{
+  GstGLFusedFilter *self;
+
+  g_return_val_if_fail (gst_gl_fused_filter_can_fuse (elements), NULL);
+
+  self = g_object_new (GST_TYPE_GL_FUSED_FILTER, NULL);
+  self->fusables = g_list_copy_deep (elements, (GCopyFunc) gst_object_ref,
+      NULL);
+
+  return GST_ELEMENT_CAST (self);
+}
+
+/* the controlled properties of the fused elements are not synced by
+ * themselves anymore */
+static void
+gst_gl_fused_filter_before_transform (GstBaseTransform * trans,
+    GstBuffer * buf)
+{
+  GstGLFusedFilter *self = GST_GL_FUSED_FILTER (trans);
+  GstClockTime stream_time;
+  GList *iter;
+
+  stream_time = gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (buf));
+  if (!GST_CLOCK_TIME_IS_VALID (stream_time))
+    return;
+
+  for (iter = self->fusables; iter; iter = g_list_next (iter))
+    gst_object_sync_values (GST_OBJECT (iter->data), stream_time);
+}
+
+/* whether a fused element changed its per-pixel operation since the shader
+ * was built */
+static gboolean
+_snippets_changed (GstGLFusedFilter * self)
+{
+  GList *iter;
+  guint i;
+
+  if (self->snippets->len != g_list_length (self->fusables))
+    return TRUE;
+
+  for (iter = self->fusables, i = 0; iter; iter = g_list_next (iter), i++) {
+    if (gst_gl_fusable_get_snippet (iter->data) !=
+        g_ptr_array_index (self->snippets, i))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static gboolean
+_create_shader (GstGLFusedFilter * self)
+{
+  GstGLBaseFilter *base_filter = GST_GL_BASE_FILTER (self);
+  GstGLFilter *filter = GST_GL_FILTER (self);
+  GError *error = NULL;
+  GList *iter;
+  gchar *frag;
+
+  if (self->shader)
+    gst_object_unref (self->shader);
+  self->shader = NULL;
+
+  g_ptr_array_set_size (self->snippets, 0);
+  for (iter = self->fusables; iter; iter = g_list_next (iter))
+    g_ptr_array_add (self->snippets,
+        (gpointer) gst_gl_fusable_get_snippet (iter->data));
+
+  frag = gst_gl_fusable_build_fragment_source (self->fusables);
+  if (!frag) {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, ("%s",
+            "The filters cannot be fused anymore"), (NULL));
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (self, "fused %u filters into %s",
+      g_list_length (self->fusables), frag);
+
+  self->shader = gst_gl_shader_new_link_with_stages (base_filter->context,
+      &error, gst_glsl_stage_new_default_vertex (base_filter->context),
+      gst_glsl_stage_new_with_string (base_filter->context, GL_FRAGMENT_SHADER,
+          GST_GLSL_VERSION_NONE,
+          GST_GLSL_PROFILE_ES | GST_GLSL_PROFILE_COMPATIBILITY, frag), NULL);
+  g_free (frag);
+
+  if (!self->shader) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, ("%s",
+            "Failed to initialize fused shader"), ("%s",
+            error ? error->message : "Unknown error"));
+    g_clear_error (&error);
+    return FALSE;
+  }
+
+  filter->draw_attr_position_loc =
+      gst_gl_shader_get_attribute_location (self->shader, "a_position");
+  filter->draw_attr_texture_loc =
+      gst_gl_shader_get_attribute_location (self->shader, "a_texcoord");
+
+  return TRUE;
+}
+
+static gboolean
+gst_gl_fused_filter_gl_start (GstGLBaseFilter * base)
+{
+  if (!_create_shader (GST_GL_FUSED_FILTER (base)))
+    return FALSE;
+
+  return GST_GL_BASE_FILTER_CLASS (parent_class)->gl_start (base);
+}
+
+static void
+gst_gl_fused_filter_gl_stop (GstGLBaseFilter * base)
+{
+  GstGLFusedFilter *self = GST_GL_FUSED_FILTER (base);
+
+  if (self->shader)
+    gst_object_unref (self->shader);
+  self->shader = NULL;
+
+  GST_GL_BASE_FILTER_CLASS (parent_class)->gl_stop (base);
+}
+
+static gboolean
+gst_gl_fused_filter_filter_texture (GstGLFilter * filter, GstGLMemory * in_tex,
+    GstGLMemory * out_tex)
+{
+  GstGLFusedFilter *self = GST_GL_FUSED_FILTER (filter);
+  GList *iter;
+  guint i;
+
+  if ((!self->shader || _snippets_changed (self)) && !_create_shader (self))
+    return FALSE;
+
+  gst_gl_shader_use (self->shader);
+  for (iter = self->fusables, i = 0; iter; iter = g_list_next (iter), i++) {
+    gchar *prefix = gst_gl_fusable_get_prefix (i);
+
+    gst_gl_fusable_set_uniforms (iter->data, self->shader, prefix);
+    g_free (prefix);
+  }
+
+  gst_gl_filter_render_to_target_with_shader (filter, in_tex, out_tex,
+      self->shader);
+
+  return TRUE;
+}
@@ -0,0 +1,62 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_FUSED_FILTER_H_
+#define _GST_GL_FUSED_FILTER_H_
+
+#include <gst/gl/gstglfilter.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_FUSED_FILTER            (gst_gl_fused_filter_get_type())
+#define GST_GL_FUSED_FILTER(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_FUSED_FILTER,GstGLFusedFilter))
+#define GST_IS_GL_FUSED_FILTER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_FUSED_FILTER))
+#define GST_GL_FUSED_FILTER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_FUSED_FILTER,GstGLFusedFilterClass))
+#define GST_IS_GL_FUSED_FILTER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_FUSED_FILTER))
+
+typedef struct _GstGLFusedFilter GstGLFusedFilter;
+typedef struct _GstGLFusedFilterClass GstGLFusedFilterClass;
+
+/* Runs a chain of GstGLFusable filters, which are not in the pipeline
+ * themselves, as one shader */
+struct _GstGLFusedFilter
+{
+  GstGLFilter filter;
+
+  /* the fused elements in stream order, and the snippets the shader was
+   * built from */
+  GList *fusables;
+  GPtrArray *snippets;
+
+  GstGLShader *shader;
+};
+
+struct _GstGLFusedFilterClass
+{
+  GstGLFilterClass filter_class;
+};
+
+GType gst_gl_fused_filter_get_type (void);
+
+gboolean gst_gl_fused_filter_can_fuse (GList * elements);
+GstElement * gst_gl_fused_filter_new (GList * elements);
+
+G_END_DECLS
+
+#endif /* _GST_GL_FUSED_FILTER_H_ */
@@ -25,6 +25,7 @@
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
+#include <string.h>
 
 #include "gstglmixer.h"
 
@@ -570,15 +571,22 @@ _upload_frames (GstAggregator * agg, GstAggregatorPad * agg_pad,
   GstGLMixer *mix = GST_GL_MIXER (agg);
 
   pad->current_texture = 0;
+  memset (pad->current_textures, 0, sizeof (pad->current_textures));
   if (vaggpad->buffer != NULL) {
     GstVideoInfo gl_info;
     GstVideoFrame gl_frame;
     GstGLSyncMeta *sync_meta;
-
-    gst_video_info_set_format (&gl_info,
-        GST_VIDEO_FORMAT_RGBA,
-        GST_VIDEO_INFO_WIDTH (&vaggpad->info),
-        GST_VIDEO_INFO_HEIGHT (&vaggpad->info));
+    guint i;
+
+    /* subclasses that accept YUV sample the planes themselves */
+    if (GST_VIDEO_INFO_FORMAT (&vaggpad->info) == GST_VIDEO_FORMAT_NV12
+        || GST_VIDEO_INFO_FORMAT (&vaggpad->info) == GST_VIDEO_FORMAT_I420)
+      gl_info = vaggpad->info;
+    else
+      gst_video_info_set_format (&gl_info,
+          GST_VIDEO_FORMAT_RGBA,
+          GST_VIDEO_INFO_WIDTH (&vaggpad->info),
+          GST_VIDEO_INFO_HEIGHT (&vaggpad->info));
 
     sync_meta = gst_buffer_get_gl_sync_meta (vaggpad->buffer);
     if (sync_meta)
@@ -590,13 +598,38 @@ _upload_frames (GstAggregator * agg, GstAggregatorPad * agg_pad,
       return FALSE;
     }
 
-    pad->current_texture = *(guint *) gl_frame.data[0];
+    for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&gl_frame); i++)
+      pad->current_textures[i] = *(guint *) gl_frame.data[i];
+    pad->current_texture = pad->current_textures[0];
     gst_video_frame_unmap (&gl_frame);
   }
 
   return TRUE;
 }
 
+typedef struct
+{
+  GstGLMixer *mix;
+  GstGLMemory *out_tex;
+  gboolean res;
+} ProcessTexturesData;
+
+static void
+_upload_frames_gl (GstGLContext * context, ProcessTexturesData * data)
+{
+  data->res = gst_aggregator_iterate_sinkpads (GST_AGGREGATOR (data->mix),
+      (GstAggregatorPadForeachFunc) _upload_frames, NULL);
+}
+
+static void
+_process_textures_gl (GstGLContext * context, ProcessTexturesData * data)
+{
+  GstGLMixerClass *mix_class = GST_GL_MIXER_GET_CLASS (data->mix);
+
+  if (data->res)
+    mix_class->process_textures (data->mix, data->out_tex);
+}
+
 gboolean
 gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
 {
@@ -604,8 +637,10 @@ gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
   gboolean res = TRUE;
   GstVideoFrame out_frame;
   GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (mix);
-  GstGLMixerClass *mix_class = GST_GL_MIXER_GET_CLASS (mix);
   GstGLMixerPrivate *priv = mix->priv;
+  GstGLContextThreadFunc funcs[2];
+  gpointer funcs_data[2];
+  ProcessTexturesData data;
 
   GST_TRACE ("Processing buffers");
 
@@ -616,10 +651,6 @@ gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
 
   out_tex = (GstGLMemory *) out_frame.map[0].memory;
 
-  if (!gst_aggregator_iterate_sinkpads (GST_AGGREGATOR (mix),
-          (GstAggregatorPadForeachFunc) _upload_frames, NULL))
-    return FALSE;
-
   g_mutex_lock (&priv->gl_resource_lock);
   if (!priv->gl_resource_ready)
     g_cond_wait (&priv->gl_resource_cond, &priv->gl_resource_lock);
@@ -632,7 +663,17 @@ gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
     goto out;
   }
 
-  mix_class->process_textures (mix, out_tex);
+  /* upload all the input frames and render them with a single trip to the
+   * GL thread, the GL calls made along the way then run directly */
+  data.mix = mix;
+  data.out_tex = out_tex;
+  data.res = TRUE;
+  funcs[0] = (GstGLContextThreadFunc) _upload_frames_gl;
+  funcs[1] = (GstGLContextThreadFunc) _process_textures_gl;
+  funcs_data[0] = funcs_data[1] = &data;
+  gst_gl_context_thread_add_batch (GST_GL_BASE_MIXER (mix)->context, 2, funcs,
+      funcs_data);
+  res = data.res;
 
   g_mutex_unlock (&priv->gl_resource_lock);
 
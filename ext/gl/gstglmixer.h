@@ -53,6 +53,8 @@ struct _GstGLMixerPad
   GstGLBaseMixerPad parent;
 
   guint current_texture;
+  /* one texture per plane when the pad receives multi-planar YUV */
+  guint current_textures[GST_VIDEO_MAX_PLANES];
 };
 
 struct _GstGLMixerPadClass
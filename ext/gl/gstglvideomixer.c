@@ -448,6 +448,15 @@ enum
 G_DEFINE_TYPE_WITH_CODE (GstGLVideoMixer, gst_gl_video_mixer, GST_TYPE_GL_MIXER,
     DEBUG_INIT);
 
+/* NV12 and I420 are sampled plane by plane by the blending shader */
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_GL_MEMORY,
+            "{ RGBA, NV12, I420 }"))
+    );
+
 static void gst_gl_video_mixer_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_gl_video_mixer_get_property (GObject * object, guint prop_id,
@@ -481,6 +490,41 @@ static const gchar *video_mixer_f_src =
     "  gl_FragColor = vec4(rgba.rgb, rgba.a * alpha);\n"
     "}                                                   \n";
 
+/* fragment source for YUV pads, converting to RGB while blending so the
+ * frame does not need to go through an RGBA intermediate texture first */
+static const gchar *video_mixer_yuv_f_src_templ =
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform sampler2D tex_y;\n"
+    "uniform sampler2D tex_u;\n"
+    "uniform sampler2D tex_v;\n"
+    "uniform vec3 offset;\n"
+    "uniform vec3 coeff1;\n"
+    "uniform vec3 coeff2;\n"
+    "uniform vec3 coeff3;\n"
+    "uniform float alpha;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main()\n"
+    "{\n"
+    "  vec3 yuv;\n"
+    "  yuv.x = texture2D(tex_y, v_texcoord).r;\n"
+    "  %s\n"
+    "  yuv += offset;\n"
+    "  gl_FragColor = vec4(dot(yuv, coeff1), dot(yuv, coeff2),\n"
+    "      dot(yuv, coeff3), alpha);\n"
+    "}\n";
+
+static const gfloat from_yuv_bt601_offset[] = {-0.0625f, -0.5f, -0.5f};
+static const gfloat from_yuv_bt601_rcoeff[] = {1.164f, 0.000f, 1.596f};
+static const gfloat from_yuv_bt601_gcoeff[] = {1.164f,-0.391f,-0.813f};
+static const gfloat from_yuv_bt601_bcoeff[] = {1.164f, 2.018f, 0.000f};
+
+static const gfloat from_yuv_bt709_offset[] = {-0.0625f, -0.5f, -0.5f};
+static const gfloat from_yuv_bt709_rcoeff[] = {1.164f, 0.000f, 1.787f};
+static const gfloat from_yuv_bt709_gcoeff[] = {1.164f,-0.213f,-0.531f};
+static const gfloat from_yuv_bt709_bcoeff[] = {1.164f, 2.112f, 0.000f};
+
 /* checker vertex source */
 static const gchar *checker_v_src =
     "attribute vec4 a_position;\n"
@@ -860,6 +904,9 @@ gst_gl_video_mixer_class_init (GstGLVideoMixerClass * klass)
       "Filter/Effect/Video/Compositor", "OpenGL video_mixer",
       "Matthew Waters <matthew@centricular.com>");
 
+  /* replaces the RGBA only template of the parent class */
+  gst_element_class_add_static_pad_template (element_class, &sink_factory);
+
   g_object_class_install_property (gobject_class, PROP_BACKGROUND,
       g_param_spec_enum ("background", "Background", "Background type",
           GST_TYPE_GL_VIDEO_MIXER_BACKGROUND,
@@ -1142,6 +1189,14 @@ gst_gl_video_mixer_reset (GstGLMixer * mixer)
     gst_object_unref (video_mixer->shader);
   video_mixer->shader = NULL;
 
+  if (video_mixer->nv12_shader)
+    gst_object_unref (video_mixer->nv12_shader);
+  video_mixer->nv12_shader = NULL;
+
+  if (video_mixer->i420_shader)
+    gst_object_unref (video_mixer->i420_shader);
+  video_mixer->i420_shader = NULL;
+
   if (video_mixer->checker)
     gst_object_unref (video_mixer->checker);
   video_mixer->checker = NULL;
@@ -1400,6 +1455,78 @@ _set_blend_state (GstGLVideoMixer * video_mixer, GstGLVideoMixerPad * mix_pad)
   return TRUE;
 }
 
+/* returns the shader sampling the planes of @v_info, creating it on first
+ * use. Must be called from the GL thread */
+static GstGLShader *
+_get_pad_shader (GstGLVideoMixer * video_mixer, GstVideoInfo * v_info)
+{
+  GstGLContext *context = GST_GL_BASE_MIXER (video_mixer)->context;
+  GstGLShader **shader;
+  gchar *chroma, *frag_src;
+
+  switch (GST_VIDEO_INFO_FORMAT (v_info)) {
+    case GST_VIDEO_FORMAT_NV12:{
+      GstGLFormat uv_format = gst_gl_format_from_video_info (context, v_info,
+          1);
+
+      shader = &video_mixer->nv12_shader;
+      chroma = g_strdup_printf ("yuv.yz = texture2D(tex_u, v_texcoord).%s;",
+          uv_format == GST_GL_LUMINANCE_ALPHA ? "ra" : "rg");
+      break;
+    }
+    case GST_VIDEO_FORMAT_I420:
+      shader = &video_mixer->i420_shader;
+      chroma = g_strdup ("yuv.y = texture2D(tex_u, v_texcoord).r;\n"
+          "  yuv.z = texture2D(tex_v, v_texcoord).r;");
+      break;
+    default:
+      return video_mixer->shader;
+  }
+
+  if (*shader)
+    goto done;
+
+  frag_src = g_strdup_printf (video_mixer_yuv_f_src_templ, chroma);
+  if (!gst_gl_context_gen_shader (context,
+          gst_gl_shader_string_vertex_mat4_vertex_transform, frag_src,
+          shader)) {
+    GST_ERROR_OBJECT (video_mixer, "Failed to create shader for %s",
+        gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (v_info)));
+    *shader = NULL;
+  }
+  g_free (frag_src);
+
+done:
+  g_free (chroma);
+  return *shader;
+}
+
+static void
+_set_yuv_uniforms (GstGLShader * shader, GstVideoInfo * v_info)
+{
+  const gfloat *offset, *rcoeff, *gcoeff, *bcoeff;
+
+  if (v_info->colorimetry.matrix == GST_VIDEO_COLOR_MATRIX_BT709) {
+    offset = from_yuv_bt709_offset;
+    rcoeff = from_yuv_bt709_rcoeff;
+    gcoeff = from_yuv_bt709_gcoeff;
+    bcoeff = from_yuv_bt709_bcoeff;
+  } else {
+    offset = from_yuv_bt601_offset;
+    rcoeff = from_yuv_bt601_rcoeff;
+    gcoeff = from_yuv_bt601_gcoeff;
+    bcoeff = from_yuv_bt601_bcoeff;
+  }
+
+  gst_gl_shader_set_uniform_1i (shader, "tex_y", 0);
+  gst_gl_shader_set_uniform_1i (shader, "tex_u", 1);
+  gst_gl_shader_set_uniform_1i (shader, "tex_v", 2);
+  gst_gl_shader_set_uniform_3fv (shader, "offset", 1, (gfloat *) offset);
+  gst_gl_shader_set_uniform_3fv (shader, "coeff1", 1, (gfloat *) rcoeff);
+  gst_gl_shader_set_uniform_3fv (shader, "coeff2", 1, (gfloat *) gcoeff);
+  gst_gl_shader_set_uniform_3fv (shader, "coeff3", 1, (gfloat *) bcoeff);
+}
+
 /* opengl scene, params: input texture (not the output mixer->texture) */
 static gboolean
 gst_gl_video_mixer_callback (gpointer stuff)
@@ -1408,6 +1535,7 @@ gst_gl_video_mixer_callback (gpointer stuff)
   GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (stuff);
   GstGLMixer *mixer = GST_GL_MIXER (video_mixer);
   GstGLFuncs *gl = GST_GL_BASE_MIXER (mixer)->context->gl_vtable;
+  GstGLShader *shader, *last_shader = NULL;
   GLint attr_position_loc = 0;
   GLint attr_texture_loc = 0;
   guint out_width, out_height;
@@ -1431,13 +1559,6 @@ gst_gl_video_mixer_callback (gpointer stuff)
   if (!_draw_background (video_mixer))
     return FALSE;
 
-  gst_gl_shader_use (video_mixer->shader);
-
-  attr_position_loc =
-      gst_gl_shader_get_attribute_location (video_mixer->shader, "a_position");
-  attr_texture_loc =
-      gst_gl_shader_get_attribute_location (video_mixer->shader, "a_texcoord");
-
   gl->Enable (GL_BLEND);
 
   GST_OBJECT_LOCK (video_mixer);
@@ -1449,6 +1570,7 @@ gst_gl_video_mixer_callback (gpointer stuff)
     GstVideoInfo *v_info;
     guint in_tex;
     guint in_width, in_height;
+    guint i;
 
     /* *INDENT-OFF* */
     gfloat v_vertices[] = {
@@ -1477,6 +1599,27 @@ gst_gl_video_mixer_callback (gpointer stuff)
       continue;
     }
 
+    shader = _get_pad_shader (video_mixer, v_info);
+    if (!shader) {
+      walk = g_list_next (walk);
+      continue;
+    }
+
+    if (shader != last_shader) {
+      if (last_shader) {
+        gl->DisableVertexAttribArray (attr_position_loc);
+        gl->DisableVertexAttribArray (attr_texture_loc);
+      }
+
+      gst_gl_shader_use (shader);
+
+      attr_position_loc =
+          gst_gl_shader_get_attribute_location (shader, "a_position");
+      attr_texture_loc =
+          gst_gl_shader_get_attribute_location (shader, "a_texcoord");
+      last_shader = shader;
+    }
+
     in_tex = mix_pad->current_texture;
 
     _init_vbo_indices (video_mixer);
@@ -1520,10 +1663,15 @@ gst_gl_video_mixer_callback (gpointer stuff)
     }
     gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, video_mixer->vbo_indices);
 
-    gl->ActiveTexture (GL_TEXTURE0);
-    gl->BindTexture (GL_TEXTURE_2D, in_tex);
-    gst_gl_shader_set_uniform_1i (video_mixer->shader, "texture", 0);
-    gst_gl_shader_set_uniform_1f (video_mixer->shader, "alpha", pad->alpha);
+    for (i = 0; i < GST_VIDEO_INFO_N_PLANES (v_info); i++) {
+      gl->ActiveTexture (GL_TEXTURE0 + i);
+      gl->BindTexture (GL_TEXTURE_2D, mix_pad->current_textures[i]);
+    }
+    if (shader == video_mixer->shader)
+      gst_gl_shader_set_uniform_1i (shader, "texture", 0);
+    else
+      _set_yuv_uniforms (shader, v_info);
+    gst_gl_shader_set_uniform_1f (shader, "alpha", pad->alpha);
 
     {
       GstVideoAffineTransformationMeta *af_meta;
@@ -1532,7 +1680,7 @@ gst_gl_video_mixer_callback (gpointer stuff)
       af_meta =
           gst_buffer_get_video_affine_transformation_meta (vagg_pad->buffer);
       gst_gl_get_affine_transformation_meta_as_ndc_ext (af_meta, matrix);
-      gst_gl_shader_set_uniform_matrix_4fv (video_mixer->shader,
+      gst_gl_shader_set_uniform_matrix_4fv (shader,
           "u_transformation", 1, FALSE, matrix);
     }
 
@@ -1551,8 +1699,11 @@ gst_gl_video_mixer_callback (gpointer stuff)
   }
   GST_OBJECT_UNLOCK (video_mixer);
 
-  gl->DisableVertexAttribArray (attr_position_loc);
-  gl->DisableVertexAttribArray (attr_texture_loc);
+  if (last_shader) {
+    gl->DisableVertexAttribArray (attr_position_loc);
+    gl->DisableVertexAttribArray (attr_texture_loc);
+  }
+  gl->ActiveTexture (GL_TEXTURE0);
 
   if (gl->GenVertexArrays)
     gl->BindVertexArray (0);
@@ -120,6 +120,8 @@ struct _GstGLVideoMixer
     GstGLVideoMixerBackground background;
 
     GstGLShader *shader;
+    GstGLShader *nv12_shader;
+    GstGLShader *i420_shader;
     GstGLShader *checker;
 
     GLuint vao;
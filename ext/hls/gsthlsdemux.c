@@ -103,6 +103,9 @@ static GstFlowReturn gst_hls_demux_data_received (GstAdaptiveDemux * demux,
 static void gst_hls_demux_stream_free (GstAdaptiveDemuxStream * stream);
 static gboolean gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream *
     stream);
+static gboolean gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream *
+    stream, guint offset, gchar ** uri, gint64 * range_start,
+    gint64 * range_end);
 static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
@@ -126,10 +129,15 @@ gst_hls_demux_finalize (GObject * obj)
 
   gst_hls_demux_reset (GST_ADAPTIVE_DEMUX_CAST (demux));
   g_mutex_clear (&demux->keys_lock);
+  g_cond_clear (&demux->keys_cond);
   if (demux->keys) {
     g_hash_table_unref (demux->keys);
     demux->keys = NULL;
   }
+  if (demux->pending_keys) {
+    g_hash_table_unref (demux->pending_keys);
+    demux->pending_keys = NULL;
+  }
 
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -172,6 +180,8 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_has_next_fragment =
       gst_hls_demux_stream_has_next_fragment;
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
+  adaptivedemux_class->stream_peek_fragment =
+      gst_hls_demux_stream_peek_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
@@ -192,7 +202,10 @@ gst_hls_demux_init (GstHLSDemux * demux)
       sizeof (GstHLSDemuxStream));
 
   demux->keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  demux->pending_keys =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
   g_mutex_init (&demux->keys_lock);
+  g_cond_init (&demux->keys_cond);
 }
 
 static GstStateChangeReturn
@@ -308,6 +321,12 @@ gst_hls_demux_set_current (GstHLSDemux * self, GstM3U8 * m3u8)
 			      GST_SEEK_FLAG_TRICKMODE_KEY_UNITS | \
 			      GST_SEEK_FLAG_KEY_UNIT))
 
+/* I-frame variants are used for reverse playback, and for fast forward when
+ * only key units are requested, so that only the I-frames are downloaded */
+#define IS_IFRAME_TRICKMODE(r, f) ((r) < -1.0 || \
+                                   ((r) > 1.0 && \
+                                    ((f) & GST_SEEK_FLAG_TRICKMODE_KEY_UNITS)))
+
 static gboolean
 gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek)
 {
@@ -316,10 +335,11 @@ gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek)
   GstSeekFlags flags;
   GstSeekType start_type, stop_type;
   gint64 start, stop;
-  gdouble rate, old_rate;
+  gdouble rate;
   GList *walk;
   GstClockTime current_pos, target_pos, final_pos;
   guint64 bitrate;
+  gboolean use_iframes;
 
   gst_event_parse_seek (seek, &rate, &format, &flags, &start_type, &start,
       &stop_type, &stop);
@@ -329,13 +349,13 @@ gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek)
     return TRUE;
   }
 
-  old_rate = demux->segment.rate;
-
   bitrate = gst_hls_demux_get_bitrate (hlsdemux);
 
+  use_iframes = hlsdemux->master->iframe_variants != NULL
+      && IS_IFRAME_TRICKMODE (rate, flags);
+
   /* Use I-frame variants for trick modes */
-  if (hlsdemux->master->iframe_variants != NULL
-      && rate < -1.0 && old_rate >= -1.0 && old_rate <= 1.0) {
+  if (use_iframes && !hlsdemux->current_variant->iframe) {
     GError *err = NULL;
 
     /* Switch to I-frame variant */
@@ -349,7 +369,7 @@ gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek)
     //hlsdemux->discont = TRUE;
 
     gst_hls_demux_change_playlist (hlsdemux, bitrate / ABS (rate), NULL);
-  } else if (rate > -1.0 && rate <= 1.0 && (old_rate < -1.0 || old_rate > 1.0)) {
+  } else if (!use_iframes && hlsdemux->current_variant->iframe) {
     GError *err = NULL;
     /* Switch to normal variant */
     gst_hls_demux_set_current_variant (hlsdemux,
@@ -450,6 +470,7 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
   hls_stream->playlist->sequence = current_sequence;
+  hls_stream->playlist->part = -1;
   hls_stream->playlist->current_file = walk;
   hls_stream->playlist->sequence_position = current_pos;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
@@ -572,6 +593,7 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
     variant->m3u8->sequence_position =
         hlsdemux->current_variant->m3u8->sequence_position;
     variant->m3u8->sequence = hlsdemux->current_variant->m3u8->sequence;
+    variant->m3u8->part = hlsdemux->current_variant->m3u8->part;
 
     GST_DEBUG_OBJECT (hlsdemux,
         "Switching Variant. Copying over sequence %" G_GINT64_FORMAT
@@ -588,6 +610,7 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
 
         if (new_media) {
           new_media->playlist->sequence = old_media->playlist->sequence;
+          new_media->playlist->part = old_media->playlist->part;
           new_media->playlist->sequence_position =
               old_media->playlist->sequence_position;
         }
@@ -701,6 +724,14 @@ gst_hls_demux_get_key (GstHLSDemux * demux, const gchar * key_url,
 
   key = g_hash_table_lookup (demux->keys, key_url);
 
+  /* wait for the background fetch, if it fails the key is requested again
+   * below */
+  while (key == NULL && g_hash_table_contains (demux->pending_keys, key_url)) {
+    GST_LOG_OBJECT (demux, "Waiting for key %s", key_url);
+    g_cond_wait (&demux->keys_cond, &demux->keys_lock);
+    key = g_hash_table_lookup (demux->keys, key_url);
+  }
+
   if (key != NULL) {
     GST_LOG_OBJECT (demux, "Found key for key url %s in key cache", key_url);
     goto out;
@@ -740,6 +771,78 @@ out:
   return key;
 }
 
+typedef struct
+{
+  GstHLSDemux *demux;
+  gchar *key_url;
+} GstHLSKeyRequest;
+
+static void
+gst_hls_key_request_free (GstHLSKeyRequest * request)
+{
+  gst_object_unref (request->demux);
+  g_free (request->key_url);
+  g_slice_free (GstHLSKeyRequest, request);
+}
+
+static void
+gst_hls_demux_key_fetched (GstUriDownloader * downloader,
+    GstFragment * key_fragment, const GError * err, GstHLSKeyRequest * request)
+{
+  GstHLSDemux *demux = request->demux;
+  GstBuffer *key_buffer = NULL;
+  GstHLSKey *key;
+
+  if (key_fragment) {
+    key_buffer = gst_fragment_get_buffer (key_fragment);
+    g_object_unref (key_fragment);
+  }
+
+  g_mutex_lock (&demux->keys_lock);
+  if (key_buffer) {
+    key = g_new0 (GstHLSKey, 1);
+    if (gst_buffer_extract (key_buffer, 0, key->data, 16) < 16)
+      GST_WARNING_OBJECT (demux, "Download decryption key is too short!");
+    g_hash_table_insert (demux->keys, g_strdup (request->key_url), key);
+    gst_buffer_unref (key_buffer);
+  } else {
+    GST_DEBUG_OBJECT (demux, "Background fetch of key %s failed: %s",
+        request->key_url, err ? err->message : "error");
+  }
+  g_hash_table_remove (demux->pending_keys, request->key_url);
+  g_cond_broadcast (&demux->keys_cond);
+  g_mutex_unlock (&demux->keys_lock);
+}
+
+/* Starts fetching a key in the background, so that it is usually available
+ * by the time the fragment data arrives and is not serialized with playlist
+ * updates */
+static void
+gst_hls_demux_prefetch_key (GstHLSDemux * demux, const gchar * key_url,
+    const gchar * referer, gboolean allow_cache)
+{
+  GstHLSKeyRequest *request;
+
+  g_mutex_lock (&demux->keys_lock);
+  if (g_hash_table_contains (demux->keys, key_url)
+      || g_hash_table_contains (demux->pending_keys, key_url)) {
+    g_mutex_unlock (&demux->keys_lock);
+    return;
+  }
+
+  GST_INFO_OBJECT (demux, "Fetching key %s in the background", key_url);
+  g_hash_table_add (demux->pending_keys, g_strdup (key_url));
+  g_mutex_unlock (&demux->keys_lock);
+
+  request = g_slice_new (GstHLSKeyRequest);
+  request->demux = gst_object_ref (demux);
+  request->key_url = g_strdup (key_url);
+  gst_uri_downloader_fetch_uri_async (GST_ADAPTIVE_DEMUX (demux)->downloader,
+      key_url, referer, FALSE, FALSE, allow_cache, 0, -1,
+      (GstUriDownloaderCallback) gst_hls_demux_key_fetched, request,
+      (GDestroyNotify) gst_hls_key_request_free);
+}
+
 static gboolean
 gst_hls_demux_start_fragment (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream)
@@ -1055,6 +1158,32 @@ gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream * stream)
   return has_next;
 }
 
+static gboolean
+gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream,
+    guint offset, gchar ** uri, gint64 * range_start, gint64 * range_end)
+{
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (GST_HLS_DEMUX_STREAM_CAST (stream));
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0,
+      offset);
+  if (file == NULL)
+    return FALSE;
+
+  *uri = g_strdup (file->uri);
+  *range_start = file->offset;
+  if (file->size != -1)
+    *range_end = file->offset + file->size - 1;
+  else
+    *range_end = -1;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream * stream)
 {
@@ -1093,8 +1222,11 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
     discont = TRUE;
 
   /* set up our source for download */
+  /* I-frame playlists only contain parts of the media, every fragment has to
+   * be placed at its own position */
   if (hlsdemux_stream->reset_pts || discont
-      || stream->demux->segment.rate < 0.0) {
+      || stream->demux->segment.rate < 0.0
+      || hlsdemux->current_variant->iframe) {
     stream->fragment.timestamp = sequence_pos;
   } else {
     stream->fragment.timestamp = GST_CLOCK_TIME_NONE;
@@ -1102,6 +1234,9 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
 
   g_free (hlsdemux_stream->current_key);
   hlsdemux_stream->current_key = g_strdup (file->key);
+  if (file->key)
+    gst_hls_demux_prefetch_key (hlsdemux, file->key, m3u8->uri,
+        m3u8->allowcache);
   g_free (hlsdemux_stream->current_iv);
   hlsdemux_stream->current_iv = g_memdup (file->iv, sizeof (file->iv));
 
@@ -1317,19 +1452,27 @@ gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
   const gchar *main_uri;
   GstM3U8 *m3u8;
   gchar *uri = media->uri;
+  gchar *blocking_uri;
+
+  m3u8 = media->playlist;
+
+  blocking_uri = gst_m3u8_get_blocking_reload_uri (m3u8, uri);
 
   main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
   download =
-      gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
-      TRUE, TRUE, TRUE, err);
+      gst_uri_downloader_fetch_uri (adaptive_demux->downloader,
+      blocking_uri ? blocking_uri : uri, main_uri, TRUE, TRUE, TRUE, err);
 
-  if (download == NULL)
+  if (download == NULL) {
+    g_free (blocking_uri);
     return FALSE;
+  }
 
-  m3u8 = media->playlist;
-
-  /* Set the base URI of the playlist to the redirect target if any */
-  if (download->redirect_permanent && download->redirect_uri) {
+  /* Set the base URI of the playlist to the redirect target if any. The
+   * blocking reload directives must not stick to the playlist URI */
+  if (blocking_uri) {
+    g_free (blocking_uri);
+  } else if (download->redirect_permanent && download->redirect_uri) {
     gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL, media->name);
   } else {
     gst_m3u8_set_uri (m3u8, download->uri, download->redirect_uri, media->name);
@@ -1368,11 +1511,21 @@ gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
   gboolean main_checked = FALSE;
   const gchar *main_uri;
   GstM3U8 *m3u8;
-  gchar *uri;
+  gchar *uri, *blocking_uri;
+  gboolean blocking = FALSE;
   gint i;
 
 retry:
   uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
+  blocking_uri = update ?
+      gst_m3u8_get_blocking_reload_uri (demux->current_variant->m3u8,
+      uri) : NULL;
+  blocking = (blocking_uri != NULL);
+  if (blocking) {
+    GST_LOG_OBJECT (demux, "Blocking playlist reload %s", blocking_uri);
+    g_free (uri);
+    uri = blocking_uri;
+  }
   main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
   download =
       gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
@@ -1436,8 +1589,11 @@ retry:
 
   m3u8 = demux->current_variant->m3u8;
 
-  /* Set the base URI of the playlist to the redirect target if any */
-  if (download->redirect_permanent && download->redirect_uri) {
+  /* Set the base URI of the playlist to the redirect target if any. The
+   * blocking reload directives must not stick to the playlist URI */
+  if (blocking) {
+    /* keep the current URIs */
+  } else if (download->redirect_permanent && download->redirect_uri) {
     gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL,
         demux->current_variant->name);
   } else {
@@ -1489,7 +1645,7 @@ retry:
 
   /* If it's a live source, do not let the sequence number go beyond
    * three fragments before the end of the list */
-  if (update == FALSE && gst_m3u8_is_live (m3u8)) {
+  if (update == FALSE && gst_m3u8_is_live (m3u8) && m3u8->part < 0) {
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
@@ -1752,8 +1908,13 @@ decrypt_fragment (GstHLSDemuxStream * stream, gsize length,
 {
   gcry_error_t err = 0;
 
-  err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
-      encrypted_data, length);
+  /* in place decryption is requested with a NULL input */
+  if (encrypted_data == decrypted_data)
+    err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
+        NULL, 0);
+  else
+    err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
+        encrypted_data, length);
 
   return err == 0;
 }
@@ -1768,42 +1929,36 @@ gst_hls_demux_stream_decrypt_end (GstHLSDemuxStream * stream)
 }
 #endif
 
+/* All the backends can decrypt CBC in place, so the downloaded data is
+ * overwritten with the decrypted data. Mapping for writing only copies the
+ * memory if it is shared with another buffer. */
 static GstBuffer *
 gst_hls_demux_decrypt_fragment (GstHLSDemux * demux, GstHLSDemuxStream * stream,
     GstBuffer * encrypted_buffer, GError ** err)
 {
-  GstBuffer *decrypted_buffer = NULL;
-  GstMapInfo encrypted_info, decrypted_info;
+  GstBuffer *buffer;
+  GstMapInfo info;
 
-  decrypted_buffer =
-      gst_buffer_new_allocate (NULL, gst_buffer_get_size (encrypted_buffer),
-      NULL);
+  buffer = gst_buffer_make_writable (encrypted_buffer);
 
-  gst_buffer_map (encrypted_buffer, &encrypted_info, GST_MAP_READ);
-  gst_buffer_map (decrypted_buffer, &decrypted_info, GST_MAP_WRITE);
+  if (!gst_buffer_map (buffer, &info, GST_MAP_READWRITE))
+    goto map_error;
 
-  if (!decrypt_fragment (stream, encrypted_info.size,
-          encrypted_info.data, decrypted_info.data))
+  if (!decrypt_fragment (stream, info.size, info.data, info.data))
     goto decrypt_error;
 
+  gst_buffer_unmap (buffer, &info);
 
-  gst_buffer_unmap (decrypted_buffer, &decrypted_info);
-  gst_buffer_unmap (encrypted_buffer, &encrypted_info);
-
-  gst_buffer_unref (encrypted_buffer);
-
-  return decrypted_buffer;
+  return buffer;
 
 decrypt_error:
+  gst_buffer_unmap (buffer, &info);
+map_error:
   GST_ERROR_OBJECT (demux, "Failed to decrypt fragment");
   g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_DECRYPT,
       "Failed to decrypt fragment");
 
-  gst_buffer_unmap (decrypted_buffer, &decrypted_info);
-  gst_buffer_unmap (encrypted_buffer, &encrypted_info);
-
-  gst_buffer_unref (encrypted_buffer);
-  gst_buffer_unref (decrypted_buffer);
+  gst_buffer_unref (buffer);
 
   return NULL;
 }
@@ -1814,7 +1969,16 @@ gst_hls_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
   GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
   GstClockTime target_duration;
 
-  if (hlsdemux->current_variant) {
+  if (hlsdemux->current_variant
+      && gst_m3u8_is_low_latency (hlsdemux->current_variant->m3u8)) {
+    GstM3U8 *m3u8 = hlsdemux->current_variant->m3u8;
+
+    /* Blocking reloads are only answered once the next partial segment is
+     * available, so they can be issued well before that */
+    target_duration = m3u8->part_target;
+    if (m3u8->can_block_reload)
+      target_duration /= 2;
+  } else if (hlsdemux->current_variant) {
     target_duration =
         gst_m3u8_get_target_duration (hlsdemux->current_variant->m3u8);
   } else {
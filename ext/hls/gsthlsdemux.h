@@ -137,6 +137,10 @@ struct _GstHLSDemux
   /* Decryption key cache: url => GstHLSKey */
   GHashTable *keys;
   GMutex      keys_lock;
+  /* urls of the keys being fetched in the background, protected by
+   * keys_lock. keys_cond is signalled when one of them is done */
+  GHashTable *pending_keys;
+  GCond       keys_cond;
 
   /* FIXME: check locking, protected automatically by manifest_lock already? */
   /* The master playlist with the available variant streams */
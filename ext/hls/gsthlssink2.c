@@ -24,6 +24,10 @@
  *
  * HTTP Live Streaming sink/server
  *
+ * The playlist is written and the old segments are deleted from a separate
+ * thread, so that slow file system operations don't hold back the muxing of
+ * the next segment.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! hlssink max-files=5
@@ -87,6 +91,24 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans);
 static GstPad *gst_hls_sink2_request_new_pad (GstElement * element,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 static void gst_hls_sink2_release_pad (GstElement * element, GstPad * pad);
+static void gst_hls_sink2_flush_writes (GstHlsSink2 * sink);
+
+/* A playlist update, done from the writer thread */
+typedef struct
+{
+  gchar *playlist_location;
+  gchar *playlist_content;
+  GList *remove_locations;
+} GstHlsSink2Write;
+
+static void
+gst_hls_sink2_write_free (GstHlsSink2Write * write)
+{
+  g_free (write->playlist_location);
+  g_free (write->playlist_content);
+  g_list_free_full (write->remove_locations, g_free);
+  g_slice_free (GstHlsSink2Write, write);
+}
 
 static void
 gst_hls_sink2_dispose (GObject * object)
@@ -104,6 +126,7 @@ gst_hls_sink2_finalize (GObject * object)
   g_free (sink->location);
   g_free (sink->playlist_location);
   g_free (sink->playlist_root);
+  gst_hls_sink2_flush_writes (sink);
   if (sink->playlist)
     gst_m3u8_playlist_free (sink->playlist);
 
@@ -209,6 +232,8 @@ gst_hls_sink2_reset (GstHlsSink2 * sink)
 {
   sink->index = 0;
 
+  gst_hls_sink2_flush_writes (sink);
+
   if (sink->playlist)
     gst_m3u8_playlist_free (sink->playlist);
   sink->playlist =
@@ -220,22 +245,56 @@ gst_hls_sink2_reset (GstHlsSink2 * sink)
 }
 
 static void
-gst_hls_sink2_write_playlist (GstHlsSink2 * sink)
+gst_hls_sink2_do_write (GstHlsSink2Write * write, GstHlsSink2 * sink)
 {
-  char *playlist_content;
   GError *error = NULL;
+  GList *l;
 
-  playlist_content = gst_m3u8_playlist_render (sink->playlist);
-  if (!g_file_set_contents (sink->playlist_location,
-          playlist_content, -1, &error)) {
+  /* g_file_set_contents() replaces the playlist atomically, through a
+   * temporary file that is renamed over the old one */
+  if (!g_file_set_contents (write->playlist_location,
+          write->playlist_content, -1, &error)) {
     GST_ERROR ("Failed to write playlist: %s", error->message);
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
         (("Failed to write playlist '%s'."), error->message), (NULL));
     g_error_free (error);
     error = NULL;
   }
-  g_free (playlist_content);
 
+  for (l = write->remove_locations; l; l = l->next)
+    g_remove (l->data);
+
+  gst_hls_sink2_write_free (write);
+}
+
+/* Waits for the pending playlist writes to be done */
+static void
+gst_hls_sink2_flush_writes (GstHlsSink2 * sink)
+{
+  if (sink->writer) {
+    g_thread_pool_free (sink->writer, FALSE, TRUE);
+    sink->writer = NULL;
+  }
+}
+
+/* Queues the current playlist for writing, after which @remove_locations
+ * are deleted. Takes ownership of @remove_locations */
+static void
+gst_hls_sink2_write_playlist (GstHlsSink2 * sink, GList * remove_locations)
+{
+  GstHlsSink2Write *write;
+
+  write = g_slice_new (GstHlsSink2Write);
+  write->playlist_location = g_strdup (sink->playlist_location);
+  write->playlist_content = gst_m3u8_playlist_render (sink->playlist);
+  write->remove_locations = remove_locations;
+
+  if (!sink->writer) {
+    /* A single thread, so that the writes happen in order */
+    sink->writer = g_thread_pool_new ((GFunc) gst_hls_sink2_do_write, sink, 1,
+        FALSE, NULL);
+  }
+  g_thread_pool_push (sink->writer, write, NULL);
 }
 
 static void
@@ -257,6 +316,7 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
         } else if (gst_structure_has_name (s, "splitmuxsink-fragment-closed")) {
           GstClockTime running_time;
           gchar *entry_location;
+          GList *remove_locations = NULL;
 
           g_assert (strcmp (sink->current_location, gst_structure_get_string (s,
                       "location")) == 0);
@@ -277,24 +337,26 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
               sink->index++, FALSE);
           g_free (entry_location);
 
-          gst_hls_sink2_write_playlist (sink);
-
           g_queue_push_tail (&sink->old_locations,
               g_strdup (sink->current_location));
 
           while (g_queue_get_length (&sink->old_locations) >
               g_queue_get_length (sink->playlist->entries)) {
-            gchar *old_location = g_queue_pop_head (&sink->old_locations);
-            g_remove (old_location);
-            g_free (old_location);
+            remove_locations = g_list_prepend (remove_locations,
+                g_queue_pop_head (&sink->old_locations));
           }
+          remove_locations = g_list_reverse (remove_locations);
+
+          gst_hls_sink2_write_playlist (sink, remove_locations);
         }
       }
       break;
     }
     case GST_MESSAGE_EOS:{
       sink->playlist->end_list = TRUE;
-      gst_hls_sink2_write_playlist (sink);
+      gst_hls_sink2_write_playlist (sink, NULL);
+      /* the playlist is complete once EOS is posted */
+      gst_hls_sink2_flush_writes (sink);
       break;
     }
     default:
@@ -54,6 +54,9 @@ struct _GstHlsSink2
   gchar *current_location;
   GstClockTime current_running_time_start;
   GQueue old_locations;
+
+  /* writes the playlist and deletes old segments */
+  GThreadPool *writer;
 };
 
 struct _GstHlsSink2Class
@@ -45,6 +45,7 @@ gst_m3u8_new (void)
   m3u8->current_file = NULL;
   m3u8->current_file_duration = GST_CLOCK_TIME_NONE;
   m3u8->sequence = -1;
+  m3u8->part = -1;
   m3u8->sequence_position = 0;
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
@@ -106,8 +107,12 @@ gst_m3u8_unref (GstM3U8 * self)
 
     g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
     g_list_free (self->files);
+    if (self->pending_file)
+      gst_m3u8_media_file_unref (self->pending_file);
+    g_free (self->preload_hint_uri);
 
     g_free (self->last_data);
+    g_free (self->last_base_uri);
     g_free (self);
   }
 }
@@ -146,10 +151,47 @@ gst_m3u8_media_file_unref (GstM3U8MediaFile * self)
     g_free (self->title);
     g_free (self->uri);
     g_free (self->key);
+    if (self->partial_segments)
+      g_ptr_array_unref (self->partial_segments);
     g_free (self);
   }
 }
 
+static GstM3U8PartialSegment *
+gst_m3u8_partial_segment_new (void)
+{
+  GstM3U8PartialSegment *part;
+
+  part = g_new0 (GstM3U8PartialSegment, 1);
+  part->offset = -1;
+  part->size = -1;
+
+  return part;
+}
+
+static void
+gst_m3u8_partial_segment_free (GstM3U8PartialSegment * part)
+{
+  g_free (part->uri);
+  g_free (part);
+}
+
+/* Sets the encryption params of @file from the last EXT-X-KEY */
+static void
+gst_m3u8_media_file_set_key (GstM3U8MediaFile * file, const gchar * key,
+    gboolean have_iv, const guint8 * iv)
+{
+  file->key = key ? g_strdup (key) : NULL;
+  if (file->key) {
+    if (have_iv) {
+      memcpy (file->iv, iv, sizeof (file->iv));
+    } else {
+      guint8 *iv = file->iv + 12;
+      GST_WRITE_UINT32_BE (iv, file->sequence);
+    }
+  }
+}
+
 static gboolean
 int_from_string (gchar * ptr, gchar ** endptr, gint * val)
 {
@@ -441,6 +483,90 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
   return TRUE;
 }
 
+/* call with M3U8_LOCK held.
+ * Segments keep their URI for a media sequence number (6.2.2), so entries of
+ * a playlist update that were already known don't need to be resolved and
+ * allocated again. @iter walks the previous files in order; returns the
+ * previous file matching the new entry, or NULL */
+static GstM3U8MediaFile *
+m3u8_find_previous_file (GList ** iter, gint64 sequence, const gchar * uri,
+    GstClockTime duration)
+{
+  GstM3U8MediaFile *file;
+  gsize len, uri_len;
+
+  while (*iter && GST_M3U8_MEDIA_FILE ((*iter)->data)->sequence < sequence)
+    *iter = (*iter)->next;
+
+  if (*iter == NULL)
+    return NULL;
+
+  file = (*iter)->data;
+  if (file->sequence != sequence || file->duration != duration)
+    return NULL;
+
+  /* the stored URI is resolved, the new one might be relative */
+  len = strlen (file->uri);
+  uri_len = strlen (uri);
+  if (uri_len > len || strcmp (file->uri + len - uri_len, uri) != 0)
+    return NULL;
+  if (uri_len < len && file->uri[len - uri_len - 1] != '/')
+    return NULL;
+
+  return file;
+}
+
+/* call with M3U8_LOCK held.
+ * Low-latency playlists are started PART-HOLD-BACK from their live edge, on
+ * the closest independent partial segment before that. Returns FALSE if the
+ * playlist doesn't have enough usable partial segments for this. */
+static gboolean
+m3u8_find_low_latency_start (GstM3U8 * self)
+{
+  GstClockTime hold_back, held = 0;
+  GstClockTime segment_start = self->last_file_end;
+  GstM3U8MediaFile *file = self->pending_file;
+  GList *link = NULL, *l = g_list_last (self->files);
+
+  /* PART-HOLD-BACK is at least three times the PART-TARGET */
+  hold_back = MAX (self->part_hold_back, 3 * self->part_target);
+
+  while (TRUE) {
+    if (file) {
+      gint i;
+
+      if (file->partial_segments == NULL || file->key != NULL)
+        return FALSE;
+
+      for (i = (gint) file->partial_segments->len - 1; i >= 0; i--) {
+        GstM3U8PartialSegment *part =
+            g_ptr_array_index (file->partial_segments, i);
+
+        held += part->duration;
+        if (held >= hold_back && (part->independent || i == 0)) {
+          self->current_file = link;
+          self->current_file_duration = GST_CLOCK_TIME_NONE;
+          self->sequence = file->sequence;
+          self->part = i;
+          self->sequence_position = segment_start;
+          return TRUE;
+        }
+      }
+    }
+
+    if (l == NULL)
+      return FALSE;
+
+    link = l;
+    l = l->prev;
+    file = link->data;
+    if (segment_start >= file->duration)
+      segment_start -= file->duration;
+    else
+      segment_start = 0;
+  }
+}
+
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
@@ -456,8 +582,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   guint8 iv[16] = { 0, };
   gint64 size = -1, offset = -1;
   gint64 mediasequence;
-  GList *previous_files = NULL;
+  GList *previous_files = NULL, *previous_iter;
   gboolean have_mediasequence = FALSE;
+  gboolean reuse_files;
+  GPtrArray *parts = NULL;
 
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
@@ -492,13 +620,32 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   self->current_file = NULL;
   previous_files = self->files;
+  previous_iter = previous_files;
   self->files = NULL;
+
+  /* Known files can only be reused if relative URIs resolve the same way */
+  reuse_files = (g_strcmp0 (self->last_base_uri,
+          self->base_uri ? self->base_uri : self->uri) == 0);
+  g_free (self->last_base_uri);
+  self->last_base_uri = g_strdup (self->base_uri ? self->base_uri : self->uri);
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
 
+  if (self->pending_file) {
+    gst_m3u8_media_file_unref (self->pending_file);
+    self->pending_file = NULL;
+  }
+  g_free (self->preload_hint_uri);
+  self->preload_hint_uri = NULL;
+
   /* By default, allow caching */
   self->allowcache = TRUE;
 
+  /* Low-latency extensions must be repeated in every playlist update */
+  self->part_target = 0;
+  self->part_hold_back = 0;
+  self->can_block_reload = FALSE;
+
   duration = 0;
   title = NULL;
   data += 7;
@@ -519,21 +666,42 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         goto next_line;
       }
 
+      if (have_mediasequence && reuse_files) {
+        GstM3U8MediaFile *file;
+
+        file = m3u8_find_previous_file (&previous_iter, mediasequence, data,
+            duration);
+        if (file) {
+          GST_TRACE ("Reusing fragment %" G_GINT64_FORMAT, mediasequence);
+          mediasequence++;
+          self->files = g_list_prepend (self->files,
+              gst_m3u8_media_file_ref (file));
+
+          /* complete files don't change, their parts were parsed already */
+          if (parts) {
+            g_ptr_array_unref (parts);
+            parts = NULL;
+          }
+          g_free (title);
+          duration = 0;
+          title = NULL;
+          discontinuity = FALSE;
+          size = offset = -1;
+          goto next_line;
+        }
+      }
+
       data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
       if (data != NULL) {
         GstM3U8MediaFile *file;
         file = gst_m3u8_media_file_new (data, title, duration, mediasequence++);
 
         /* set encryption params */
-        file->key = current_key ? g_strdup (current_key) : NULL;
-        if (file->key) {
-          if (have_iv) {
-            memcpy (file->iv, iv, sizeof (iv));
-          } else {
-            guint8 *iv = file->iv + 12;
-            GST_WRITE_UINT32_BE (iv, file->sequence);
-          }
-        }
+        gst_m3u8_media_file_set_key (file, current_key, have_iv, iv);
+
+        /* the partial segments listed since the previous file */
+        file->partial_segments = parts;
+        parts = NULL;
 
         if (size != -1) {
           file->size = size;
@@ -672,6 +840,117 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         } else {
           goto next_line;
         }
+      } else if (g_str_has_prefix (data_ext_x, "SERVER-CONTROL:")) {
+        gchar *v, *a;
+
+        data = data + 22;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "CAN-BLOCK-RELOAD")) {
+            self->can_block_reload = g_ascii_strcasecmp (v, "YES") == 0;
+          } else if (g_str_equal (a, "PART-HOLD-BACK")) {
+            gdouble fval;
+
+            if (double_from_string (v, NULL, &fval))
+              self->part_hold_back = fval * (gdouble) GST_SECOND;
+          }
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART-INF:")) {
+        gchar *v, *a;
+
+        data = data + 16;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "PART-TARGET")) {
+            gdouble fval;
+
+            if (double_from_string (v, NULL, &fval))
+              self->part_target = fval * (gdouble) GST_SECOND;
+          }
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART:")) {
+        GstM3U8PartialSegment *part;
+        gchar *v, *a;
+
+        part = gst_m3u8_partial_segment_new ();
+
+        data = data + 12;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "URI")) {
+            g_free (part->uri);
+            part->uri =
+                uri_join (self->base_uri ? self->base_uri : self->uri, v);
+          } else if (g_str_equal (a, "DURATION")) {
+            gdouble fval;
+
+            if (double_from_string (v, NULL, &fval))
+              part->duration = fval * (gdouble) GST_SECOND;
+          } else if (g_str_equal (a, "INDEPENDENT")) {
+            part->independent = g_ascii_strcasecmp (v, "YES") == 0;
+          } else if (g_str_equal (a, "BYTERANGE")) {
+            if (!int64_from_string (v, &v, &part->size))
+              part->size = -1;
+            else if (*v == '@' && !int64_from_string (v + 1, &v, &part->offset))
+              part->offset = -1;
+          }
+        }
+
+        if (part->uri == NULL || part->duration == 0) {
+          GST_WARNING ("Ignoring partial segment without URI or DURATION");
+          gst_m3u8_partial_segment_free (part);
+          goto next_line;
+        }
+
+        if (part->size == -1) {
+          part->offset = 0;
+        } else if (part->offset == -1) {
+          GstM3U8PartialSegment *prev = NULL;
+          GstM3U8MediaFile *prev_file = self->files ? self->files->data : NULL;
+
+          /* the range follows the previous partial segment of the same
+           * resource */
+          if (parts && parts->len > 0)
+            prev = g_ptr_array_index (parts, parts->len - 1);
+          else if (prev_file && prev_file->partial_segments
+              && prev_file->partial_segments->len > 0)
+            prev = g_ptr_array_index (prev_file->partial_segments,
+                prev_file->partial_segments->len - 1);
+
+          if (prev && prev->size != -1 && g_str_equal (prev->uri, part->uri))
+            part->offset = prev->offset + prev->size;
+          else
+            part->offset = 0;
+        }
+
+        if (parts == NULL)
+          parts = g_ptr_array_new_with_free_func ((GDestroyNotify)
+              gst_m3u8_partial_segment_free);
+        g_ptr_array_add (parts, part);
+      } else if (g_str_has_prefix (data_ext_x, "PRELOAD-HINT:")) {
+        gchar *v, *a, *uri = NULL;
+        gboolean is_part = FALSE;
+        gint64 start = 0, length = -1;
+
+        data = data + 20;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "TYPE")) {
+            is_part = g_str_equal (v, "PART");
+          } else if (g_str_equal (a, "URI")) {
+            g_free (uri);
+            uri = uri_join (self->base_uri ? self->base_uri : self->uri, v);
+          } else if (g_str_equal (a, "BYTERANGE-START")) {
+            int64_from_string (v, NULL, &start);
+          } else if (g_str_equal (a, "BYTERANGE-LENGTH")) {
+            int64_from_string (v, NULL, &length);
+          }
+        }
+
+        if (is_part && uri) {
+          g_free (self->preload_hint_uri);
+          self->preload_hint_uri = uri;
+          self->preload_hint_offset = start;
+          self->preload_hint_size = length;
+        } else {
+          g_free (uri);
+        }
       } else {
         GST_LOG ("Ignored line: %s", data);
       }
@@ -685,6 +964,27 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
     data = g_utf8_next_char (end);      /* skip \n */
   }
 
+  /* partial segments after the last file belong to the segment that is
+   * currently being produced */
+  if (parts || self->preload_hint_uri) {
+    GstM3U8MediaFile *file;
+    guint i;
+
+    file = gst_m3u8_media_file_new (NULL, NULL, 0, mediasequence);
+    if (parts == NULL)
+      parts = g_ptr_array_new_with_free_func ((GDestroyNotify)
+          gst_m3u8_partial_segment_free);
+    for (i = 0; i < parts->len; i++)
+      file->duration +=
+          ((GstM3U8PartialSegment *) g_ptr_array_index (parts, i))->duration;
+    file->partial_segments = parts;
+    parts = NULL;
+    gst_m3u8_media_file_set_key (file, current_key, have_iv, iv);
+    file->discont = discontinuity;
+    file->size = -1;
+    self->pending_file = file;
+  }
+
   g_free (current_key);
   current_key = NULL;
 
@@ -758,7 +1058,11 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   }
 
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
+  if (self->files && self->sequence == -1 && GST_M3U8_IS_LIVE (self)
+      && self->part_target > 0 && m3u8_find_low_latency_start (self)) {
+    GST_DEBUG ("first sequence: %u, partial segment %d",
+        (guint) self->sequence, self->part);
+  } else if (self->files && self->sequence == -1) {
     GList *file;
 
     if (GST_M3U8_IS_LIVE (self)) {
@@ -830,6 +1134,128 @@ m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
   return l;
 }
 
+/* Partial segments of encrypted files are not decryptable on their own */
+#define M3U8_FILE_HAS_PARTS(f) \
+    ((f)->partial_segments != NULL && (f)->key == NULL)
+
+/* call with M3U8_LOCK held */
+static GstM3U8MediaFile *
+m3u8_find_file (GstM3U8 * m3u8, gint64 sequence, GList ** link)
+{
+  GList *l;
+
+  for (l = m3u8->files; l; l = l->next) {
+    if (GST_M3U8_MEDIA_FILE (l->data)->sequence == sequence)
+      break;
+  }
+  *link = l;
+
+  if (l)
+    return l->data;
+  if (m3u8->pending_file && m3u8->pending_file->sequence == sequence)
+    return m3u8->pending_file;
+
+  return NULL;
+}
+
+/* call with M3U8_LOCK held.
+ * Moves on to the next file once all partial segments of a complete file
+ * were used, or falls back to whole files if the partial segments of the
+ * current one are not available (anymore). Returns the file the current
+ * partial segment belongs to, or NULL if whole files are used */
+static GstM3U8MediaFile *
+m3u8_sync_part (GstM3U8 * m3u8)
+{
+  GstM3U8MediaFile *file;
+  GList *link;
+
+  while (m3u8->part >= 0) {
+    file = m3u8_find_file (m3u8, m3u8->sequence, &link);
+
+    if (file == NULL || (!M3U8_FILE_HAS_PARTS (file) && (link == NULL
+                || m3u8->part == 0))) {
+      GST_DEBUG ("No partial segments for sequence %" G_GINT64_FORMAT
+          ", using whole fragments", m3u8->sequence);
+      m3u8->part = -1;
+      m3u8->current_file = link;
+      return NULL;
+    }
+
+    /* complete files have no more partial segments coming */
+    if (link != NULL && (!M3U8_FILE_HAS_PARTS (file)
+            || (guint) m3u8->part >= file->partial_segments->len)) {
+      m3u8->sequence_position += file->duration;
+      m3u8->sequence++;
+      m3u8->part = 0;
+      continue;
+    }
+
+    m3u8->current_file = link;
+    return file;
+  }
+
+  return NULL;
+}
+
+/* call with M3U8_LOCK held */
+static void
+m3u8_maybe_start_parts (GstM3U8 * m3u8)
+{
+  /* once all complete files are used up, continue with the partial
+   * segments of the one that is currently being produced */
+  if (m3u8->part < 0 && m3u8->current_file == NULL && m3u8->pending_file
+      && m3u8->pending_file->sequence == m3u8->sequence
+      && M3U8_FILE_HAS_PARTS (m3u8->pending_file)) {
+    GST_DEBUG ("Switching to partial segments at sequence %" G_GINT64_FORMAT,
+        m3u8->sequence);
+    m3u8->part = 0;
+  }
+}
+
+/* call with M3U8_LOCK held */
+static GstM3U8MediaFile *
+m3u8_get_part_file (GstM3U8 * m3u8, GstM3U8MediaFile * parent)
+{
+  GPtrArray *parts = parent->partial_segments;
+  GstM3U8MediaFile *file;
+
+  if ((guint) m3u8->part < parts->len) {
+    GstM3U8PartialSegment *part = g_ptr_array_index (parts, m3u8->part);
+
+    file = gst_m3u8_media_file_new (g_strdup (part->uri), NULL,
+        part->duration, parent->sequence);
+    file->offset = part->offset;
+    file->size = part->size;
+  } else if (parent == m3u8->pending_file && (guint) m3u8->part == parts->len
+      && m3u8->preload_hint_uri) {
+    /* the server holds the response until the hinted part is complete */
+    file = gst_m3u8_media_file_new (g_strdup (m3u8->preload_hint_uri), NULL,
+        m3u8->part_target, parent->sequence);
+    file->offset = m3u8->preload_hint_offset;
+    file->size = m3u8->preload_hint_size;
+  } else {
+    return NULL;
+  }
+
+  file->discont = parent->discont && m3u8->part == 0;
+
+  return file;
+}
+
+/* call with M3U8_LOCK held */
+static GstClockTime
+m3u8_get_part_position (GstM3U8 * m3u8, GstM3U8MediaFile * parent)
+{
+  GstClockTime position = m3u8->sequence_position;
+  guint i;
+
+  for (i = 0; i < (guint) m3u8->part && i < parent->partial_segments->len; i++)
+    position += ((GstM3U8PartialSegment *)
+        g_ptr_array_index (parent->partial_segments, i))->duration;
+
+  return position;
+}
+
 GstM3U8MediaFile *
 gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
     GstClockTime * sequence_position, gboolean * discont)
@@ -845,6 +1271,28 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
+  if (!forward)
+    m3u8->part = -1;
+  else
+    m3u8_maybe_start_parts (m3u8);
+
+  if (m3u8->part >= 0) {
+    GstM3U8MediaFile *parent = m3u8_sync_part (m3u8);
+
+    if (parent) {
+      file = m3u8_get_part_file (m3u8, parent);
+      if (file) {
+        GST_DEBUG ("Got partial segment %d of sequence %u", m3u8->part,
+            (guint) file->sequence);
+        if (sequence_position)
+          *sequence_position = m3u8_get_part_position (m3u8, parent);
+        if (discont)
+          *discont = file->discont;
+      }
+      goto out;
+    }
+  }
+
   if (m3u8->current_file == NULL)
     m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
 
@@ -884,6 +1332,23 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   GST_DEBUG ("Checking next fragment %" G_GINT64_FORMAT,
       m3u8->sequence + (forward ? 1 : -1));
 
+  if (forward && m3u8->part >= 0) {
+    GstM3U8MediaFile *parent = m3u8_sync_part (m3u8);
+
+    if (parent) {
+      GList *link;
+
+      if ((guint) m3u8->part + 1 < parent->partial_segments->len)
+        have_next = TRUE;
+      else if (parent == m3u8->pending_file)
+        have_next = (guint) m3u8->part + 1 == parent->partial_segments->len
+            && m3u8->preload_hint_uri != NULL;
+      else
+        have_next = m3u8_find_file (m3u8, parent->sequence + 1, &link) != NULL;
+      goto out;
+    }
+  }
+
   if (m3u8->current_file) {
     cur = m3u8->current_file;
   } else {
@@ -892,11 +1357,54 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
 
   have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
 
+  /* the partial segments of the file being produced come next */
+  if (!have_next && forward && cur && m3u8->pending_file
+      && M3U8_FILE_HAS_PARTS (m3u8->pending_file)
+      && m3u8->pending_file->partial_segments->len > 0
+      && m3u8->pending_file->sequence ==
+      GST_M3U8_MEDIA_FILE (cur->data)->sequence + 1)
+    have_next = TRUE;
+
+out:
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+/* Returns the fragment @offset fragments after the current one, without
+ * changing the current position */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint offset)
+{
+  GstM3U8MediaFile *file = NULL;
+  GList *cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  /* partial segments are requested as soon as they are published */
+  if (m3u8->part >= 0)
+    goto out;
+
+  if (m3u8->current_file) {
+    cur = m3u8->current_file;
+  } else {
+    cur = m3u8_find_next_fragment (m3u8, forward);
+  }
+
+  for (; cur && offset > 0; offset--)
+    cur = forward ? cur->next : cur->prev;
+
+  if (cur)
+    file = gst_m3u8_media_file_ref (cur->data);
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
@@ -934,6 +1442,17 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
 
   GST_M3U8_LOCK (m3u8);
 
+  if (m3u8->part >= 0) {
+    if (forward && m3u8_sync_part (m3u8)) {
+      m3u8->part++;
+      m3u8_sync_part (m3u8);
+      GST_DEBUG ("Advanced to partial segment %d of sequence %u", m3u8->part,
+          (guint) m3u8->sequence);
+      goto out;
+    }
+    m3u8->part = -1;
+  }
+
   GST_DEBUG ("Sequence position was %" GST_TIME_FORMAT,
       GST_TIME_ARGS (m3u8->sequence_position));
   if (GST_CLOCK_TIME_IS_VALID (m3u8->current_file_duration)) {
@@ -1077,6 +1596,63 @@ gst_m3u8_is_live (GstM3U8 * m3u8)
   return is_live;
 }
 
+/* Whether this is a live playlist advertising partial segments */
+gboolean
+gst_m3u8_is_low_latency (GstM3U8 * m3u8)
+{
+  gboolean is_low_latency;
+
+  g_return_val_if_fail (m3u8 != NULL, FALSE);
+
+  GST_M3U8_LOCK (m3u8);
+  is_low_latency = GST_M3U8_IS_LIVE (m3u8) && m3u8->part_target > 0;
+  GST_M3U8_UNLOCK (m3u8);
+
+  return is_low_latency;
+}
+
+/* Returns @uri with the _HLS_msn and _HLS_part directives asking the server
+ * to hold the response until the (partial) segment following the last
+ * published one is available, or NULL if the server can't block reloads */
+gchar *
+gst_m3u8_get_blocking_reload_uri (GstM3U8 * m3u8, const gchar * uri)
+{
+  gchar *ret = NULL;
+  gint64 msn;
+  gchar sep;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  if (uri == NULL)
+    return NULL;
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (!m3u8->can_block_reload || !GST_M3U8_IS_LIVE (m3u8)
+      || m3u8->highest_sequence_number < 0)
+    goto out;
+
+  msn = m3u8->highest_sequence_number + 1;
+  sep = strchr (uri, '?') ? '&' : '?';
+
+  if (m3u8->part_target > 0) {
+    guint part = 0;
+
+    if (m3u8->pending_file && m3u8->pending_file->sequence == msn)
+      part = m3u8->pending_file->partial_segments->len;
+
+    ret = g_strdup_printf ("%s%c_HLS_msn=%" G_GINT64_FORMAT "&_HLS_part=%u",
+        uri, sep, msn, part);
+  } else {
+    ret = g_strdup_printf ("%s%c_HLS_msn=%" G_GINT64_FORMAT, uri, sep, msn);
+  }
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return ret;
+}
+
 gchar *
 uri_join (const gchar * uri1, const gchar * uri2)
 {
@@ -30,6 +30,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstM3U8 GstM3U8;
 typedef struct _GstM3U8MediaFile GstM3U8MediaFile;
+typedef struct _GstM3U8PartialSegment GstM3U8PartialSegment;
 typedef struct _GstHLSMedia GstHLSMedia;
 typedef struct _GstM3U8Client GstM3U8Client;
 typedef struct _GstHLSVariantStream GstHLSVariantStream;
@@ -62,13 +63,24 @@ struct _GstM3U8
   gint version;                 /* last EXT-X-VERSION */
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
+  GstClockTime part_target;     /* last EXT-X-PART-INF PART-TARGET, 0 if the
+                                 * playlist doesn't advertise partial segments */
+  GstClockTime part_hold_back;  /* last EXT-X-SERVER-CONTROL PART-HOLD-BACK */
+  gboolean can_block_reload;    /* last EXT-X-SERVER-CONTROL CAN-BLOCK-RELOAD */
 
   GList *files;
+  GstM3U8MediaFile *pending_file; /* the segment after the last complete one,
+                                   * only made of the partial segments and
+                                   * preload hint published so far */
+  gchar *preload_hint_uri;      /* last EXT-X-PRELOAD-HINT of TYPE=PART */
+  gint64 preload_hint_offset, preload_hint_size;
 
   /* state */
   GList *current_file;
   GstClockTime current_file_duration; /* Duration of current fragment */
   gint64 sequence;                    /* the next sequence for this client */
+  gint part;                          /* the next partial segment of sequence,
+                                       * -1 when whole segments are used */
   GstClockTime sequence_position;     /* position of this sequence */
   gint64 highest_sequence_number;     /* largest seen sequence number */
   GstClockTime first_file_start;      /* timecode of the start of the first fragment in the current media playlist */
@@ -78,6 +90,7 @@ struct _GstM3U8
 
   /*< private > */
   gchar *last_data;
+  gchar *last_base_uri;         /* the URI the files were resolved against */
   GMutex lock;
 
   gint ref_count;               /* ATOMIC */
@@ -98,9 +111,18 @@ struct _GstM3U8MediaFile
   gchar *key;
   guint8 iv[16];
   gint64 offset, size;
+  GPtrArray *partial_segments;  /* EXT-X-PART entries of this file, or NULL */
   gint ref_count;               /* ATOMIC */
 };
 
+struct _GstM3U8PartialSegment
+{
+  gchar *uri;
+  GstClockTime duration;
+  gint64 offset, size;
+  gboolean independent;         /* starts with an independent frame */
+};
+
 GstM3U8MediaFile * gst_m3u8_media_file_ref   (GstM3U8MediaFile * mfile);
 
 void               gst_m3u8_media_file_unref (GstM3U8MediaFile * mfile);
@@ -123,6 +145,10 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     offset);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
@@ -134,6 +160,11 @@ gchar *            gst_m3u8_get_uri              (GstM3U8 * m3u8);
 
 gboolean           gst_m3u8_is_live              (GstM3U8 * m3u8);
 
+gboolean           gst_m3u8_is_low_latency       (GstM3U8 * m3u8);
+
+gchar *            gst_m3u8_get_blocking_reload_uri (GstM3U8     * m3u8,
+                                                     const gchar * uri);
+
 gboolean           gst_m3u8_get_seek_range       (GstM3U8 * m3u8,
                                                   gint64  * start,
                                                   gint64  * stop);
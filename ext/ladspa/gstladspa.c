@@ -33,6 +33,11 @@
  * element classification. The functionality you get depends on the LADSPA plugins
  * you have installed.
  *
+ * What is found while scanning is kept in
+ * `$XDG_CACHE_HOME/gstreamer-1.0/ladspa-descriptors.cache`, so that libraries
+ * that did not change since the last scan are not loaded again. A library is
+ * only loaded once one of its elements is used.
+ *
  * ## Example LADSPA line without this plugins
  * |[
  * (padsp) listplugins
@@ -115,6 +120,7 @@
 #include "gstladspasource.h"
 #include "gstladspasink.h"
 #include <gst/gst-i18n-plugin.h>
+#include <glib/gstdio.h>
 
 #include <string.h>
 #include <ladspa.h>
@@ -138,6 +144,8 @@ GST_DEBUG_CATEGORY (ladspa_debug);
   "/usr/local/lib/ladspa" G_SEARCHPATH_SEPARATOR_S \
   LIBDIR "/ladspa"
 
+#define GST_LADSPA_CACHE_FILE "ladspa-descriptors.cache"
+
 GstStructure *ladspa_meta_all = NULL;
 
 static void
@@ -183,9 +191,72 @@ ladspa_count_ports (const LADSPA_Descriptor * descriptor,
   }
 }
 
+/* stores what the elements need to set up their class, which then don't
+ * have to load the library */
+static void
+ladspa_describe_ports (GstStructure * ladspa_meta,
+    const LADSPA_Descriptor * desc)
+{
+  GValue descriptors = { 0, }, hints = { 0, }, names = { 0, };
+  GValue lower = { 0, }, upper = { 0, };
+  GValue value = { 0, };
+  guint i;
+
+  gst_value_array_init (&descriptors, desc->PortCount);
+  gst_value_array_init (&hints, desc->PortCount);
+  gst_value_array_init (&names, desc->PortCount);
+  gst_value_array_init (&lower, desc->PortCount);
+  gst_value_array_init (&upper, desc->PortCount);
+
+  for (i = 0; i < desc->PortCount; i++) {
+    g_value_init (&value, G_TYPE_INT);
+    g_value_set_int (&value, desc->PortDescriptors[i]);
+    gst_value_array_append_value (&descriptors, &value);
+    g_value_set_int (&value, desc->PortRangeHints[i].HintDescriptor);
+    gst_value_array_append_value (&hints, &value);
+    g_value_unset (&value);
+
+    g_value_init (&value, G_TYPE_STRING);
+    g_value_set_string (&value, desc->PortNames[i]);
+    gst_value_array_append_value (&names, &value);
+    g_value_unset (&value);
+
+    g_value_init (&value, G_TYPE_FLOAT);
+    g_value_set_float (&value, desc->PortRangeHints[i].LowerBound);
+    gst_value_array_append_value (&lower, &value);
+    g_value_set_float (&value, desc->PortRangeHints[i].UpperBound);
+    gst_value_array_append_value (&upper, &value);
+    g_value_unset (&value);
+  }
+
+  gst_structure_set (ladspa_meta,
+      "unique-id", G_TYPE_UINT64, (guint64) desc->UniqueID,
+      "label", G_TYPE_STRING, desc->Label,
+      "name", G_TYPE_STRING, desc->Name,
+      "maker", G_TYPE_STRING, desc->Maker,
+      "copyright", G_TYPE_STRING, desc->Copyright,
+      "properties", G_TYPE_INT, (gint) desc->Properties, NULL);
+  gst_structure_take_value (ladspa_meta, "port-descriptors", &descriptors);
+  gst_structure_take_value (ladspa_meta, "port-hints", &hints);
+  gst_structure_take_value (ladspa_meta, "port-names", &names);
+  gst_structure_take_value (ladspa_meta, "port-lower-bounds", &lower);
+  gst_structure_take_value (ladspa_meta, "port-upper-bounds", &upper);
+}
+
+static void
+ladspa_add_meta (GstStructure * ladspa_meta)
+{
+  GValue value = { 0, };
+
+  g_value_init (&value, GST_TYPE_STRUCTURE);
+  g_value_take_boxed (&value, ladspa_meta);
+  gst_structure_take_value (ladspa_meta_all,
+      gst_structure_get_string (ladspa_meta, "element-type-name"), &value);
+}
+
 static void
 ladspa_describe_plugin (const gchar * file_name, const gchar * entry_name,
-    LADSPA_Descriptor_Function descriptor_function)
+    LADSPA_Descriptor_Function descriptor_function, GPtrArray * cached)
 {
   const LADSPA_Descriptor *desc;
   guint i;
@@ -193,7 +264,6 @@ ladspa_describe_plugin (const gchar * file_name, const gchar * entry_name,
   /* walk through all the plugins in this plugin library */
   for (i = 0; (desc = descriptor_function (i)); i++) {
     GstStructure *ladspa_meta = NULL;
-    GValue value = { 0, };
     gchar *tmp;
     gchar *type_name;
     guint audio_in, audio_out, control_in, control_out;
@@ -233,14 +303,76 @@ ladspa_describe_plugin (const gchar * file_name, const gchar * entry_name,
         "audio-out", G_TYPE_UINT, audio_out,
         "control-in", G_TYPE_UINT, control_in,
         "control-out", G_TYPE_UINT, control_out, NULL);
+    ladspa_describe_ports (ladspa_meta, desc);
+    g_free (type_name);
 
-    g_value_init (&value, GST_TYPE_STRUCTURE);
-    g_value_set_boxed (&value, ladspa_meta);
-    gst_structure_set_value (ladspa_meta_all, type_name, &value);
-    g_value_unset (&value);
+    g_ptr_array_add (cached, gst_structure_to_string (ladspa_meta));
+    ladspa_add_meta (ladspa_meta);
   }
 }
 
+/* Registers the elements of a library that did not change since the last
+ * scan without loading it. Libraries that turned out not to contain any
+ * LADSPA plugin are in the cache as well, without descriptors. */
+static gboolean
+ladspa_describe_plugin_from_cache (GKeyFile * cache, const gchar * file_name,
+    GStatBuf * st, GPtrArray * cached)
+{
+  gchar **descriptors;
+  GPtrArray *metas;
+  gsize i, n = 0;
+
+  if (g_key_file_get_int64 (cache, file_name, "mtime", NULL) != st->st_mtime ||
+      g_key_file_get_uint64 (cache, file_name, "size", NULL) != st->st_size ||
+      !g_key_file_has_key (cache, file_name, "descriptors", NULL))
+    return FALSE;
+
+  descriptors = g_key_file_get_string_list (cache, file_name, "descriptors",
+      &n, NULL);
+
+  /* all or nothing, a broken entry gets the library scanned again */
+  metas = g_ptr_array_new ();
+  for (i = 0; i < n; i++) {
+    GstStructure *ladspa_meta = gst_structure_from_string (descriptors[i],
+        NULL);
+
+    if (!ladspa_meta)
+      break;
+    g_ptr_array_add (metas, ladspa_meta);
+    if (!gst_structure_has_field (ladspa_meta, "port-names") ||
+        !gst_structure_get_string (ladspa_meta, "element-type-name"))
+      break;
+  }
+  if (i < n) {
+    g_ptr_array_foreach (metas, (GFunc) gst_structure_free, NULL);
+    g_ptr_array_free (metas, TRUE);
+    g_strfreev (descriptors);
+    return FALSE;
+  }
+
+  for (i = 0; i < n; i++) {
+    GstStructure *ladspa_meta = g_ptr_array_index (metas, i);
+    const gchar *type_name =
+        gst_structure_get_string (ladspa_meta, "element-type-name");
+
+    if (g_type_from_name (type_name)) {
+      GST_WARNING ("Plugin identifier collision for %s (%s)", type_name,
+          file_name);
+      gst_structure_free (ladspa_meta);
+      continue;
+    }
+
+    g_ptr_array_add (cached, g_strdup (descriptors[i]));
+    ladspa_add_meta (ladspa_meta);
+  }
+  g_ptr_array_free (metas, TRUE);
+  g_strfreev (descriptors);
+
+  GST_INFO ("described %s from the cache", file_name);
+
+  return TRUE;
+}
+
 #ifdef HAVE_LRDF
 static gboolean
 ladspa_rdf_directory_search (const char *dir_name)
@@ -272,13 +404,16 @@ ladspa_rdf_directory_search (const char *dir_name)
 
 /* search just the one directory */
 static gboolean
-ladspa_plugin_directory_search (GstPlugin * ladspa_plugin, const char *dir_name)
+ladspa_plugin_directory_search (GstPlugin * ladspa_plugin, const char *dir_name,
+    GKeyFile * old_cache, GKeyFile * new_cache)
 {
   GDir *dir;
   gchar *file_name;
   const gchar *entry_name;
   LADSPA_Descriptor_Function descriptor_function;
   GModule *plugin;
+  GPtrArray *cached;
+  GStatBuf st;
   gboolean ok = FALSE;
 
   GST_INFO ("scanning directory for plugins \"%s\"", dir_name);
@@ -289,21 +424,43 @@ ladspa_plugin_directory_search (GstPlugin * ladspa_plugin, const char *dir_name)
 
   while ((entry_name = g_dir_read_name (dir))) {
     file_name = g_build_filename (dir_name, entry_name, NULL);
-    plugin =
-        g_module_open (file_name, G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
-    if (plugin) {
-      /* the file is a shared library */
-      if (g_module_symbol (plugin, "ladspa_descriptor",
-              (gpointer *) & descriptor_function)) {
-        /* we've found a ladspa_descriptor function, now introspect it. */
-        GST_INFO ("describe %s", file_name);
-        ladspa_describe_plugin (file_name, entry_name, descriptor_function);
-        ok = TRUE;
-      } else {
-        /* it was a library, but not a LADSPA one. Unload it. */
-        g_module_close (plugin);
+    if (g_stat (file_name, &st) != 0 || g_key_file_has_group (new_cache,
+            file_name)) {
+      g_free (file_name);
+      continue;
+    }
+
+    cached = g_ptr_array_new_with_free_func (g_free);
+    if (g_key_file_has_group (old_cache, file_name) &&
+        ladspa_describe_plugin_from_cache (old_cache, file_name, &st,
+            cached)) {
+      ok |= cached->len > 0;
+    } else {
+      plugin =
+          g_module_open (file_name, G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
+      if (plugin) {
+        /* the file is a shared library */
+        if (g_module_symbol (plugin, "ladspa_descriptor",
+                (gpointer *) & descriptor_function)) {
+          /* we've found a ladspa_descriptor function, now introspect it. */
+          GST_INFO ("describe %s", file_name);
+          ladspa_describe_plugin (file_name, entry_name, descriptor_function,
+              cached);
+          ok = TRUE;
+        } else {
+          /* it was a library, but not a LADSPA one. Unload it. */
+          g_module_close (plugin);
+        }
       }
     }
+
+    g_key_file_set_int64 (new_cache, file_name, "mtime", st.st_mtime);
+    g_key_file_set_uint64 (new_cache, file_name, "size", st.st_size);
+    g_ptr_array_add (cached, NULL);
+    g_key_file_set_string_list (new_cache, file_name, "descriptors",
+        (const gchar * const *) cached->pdata, cached->len - 1);
+    g_ptr_array_free (cached, TRUE);
+
     g_free (file_name);
   }
   g_dir_close (dir);
@@ -320,6 +477,9 @@ ladspa_plugin_path_search (GstPlugin * plugin)
   gchar **paths;
   gint i, j, path_entries;
   gboolean res = FALSE, skip;
+  gchar *cache_file, *cache_dir, *cache_data;
+  GKeyFile *old_cache, *new_cache;
+  gsize cache_len;
 #ifdef HAVE_LRDF
   gchar *pos, *prefix, *rdf_path;
 #endif
@@ -362,6 +522,14 @@ ladspa_plugin_path_search (GstPlugin * plugin)
   }
 #endif
 
+  cache_file = g_build_filename (g_get_user_cache_dir (),
+      "gstreamer-" GST_API_VERSION, GST_LADSPA_CACHE_FILE, NULL);
+  old_cache = g_key_file_new ();
+  if (!g_key_file_load_from_file (old_cache, cache_file, G_KEY_FILE_NONE,
+          NULL))
+    GST_INFO ("no descriptor cache in %s", cache_file);
+  new_cache = g_key_file_new ();
+
   for (i = 0; i < path_entries; i++) {
     skip = FALSE;
     for (j = 0; j < i; j++) {
@@ -372,10 +540,23 @@ ladspa_plugin_path_search (GstPlugin * plugin)
     }
     if (skip)
       break;
-    res |= ladspa_plugin_directory_search (plugin, paths[i]);
+    res |= ladspa_plugin_directory_search (plugin, paths[i], old_cache,
+        new_cache);
   }
   g_strfreev (paths);
 
+  /* only what was found in this scan, libraries that are gone are dropped */
+  cache_data = g_key_file_to_data (new_cache, &cache_len, NULL);
+  cache_dir = g_path_get_dirname (cache_file);
+  g_mkdir_with_parents (cache_dir, 0755);
+  g_free (cache_dir);
+  if (!g_file_set_contents (cache_file, cache_data, cache_len, NULL))
+    GST_WARNING ("could not write the descriptor cache to %s", cache_file);
+  g_free (cache_data);
+  g_free (cache_file);
+  g_key_file_free (new_cache);
+  g_key_file_free (old_cache);
+
   g_free (ladspa_path);
 
   return res;
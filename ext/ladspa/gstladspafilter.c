@@ -158,7 +158,7 @@ gst_ladspa_filter_type_setup (GstAudioFilter * audio, const GstAudioInfo * info)
 {
   GstLADSPAFilter *ladspa = GST_LADSPA_FILTER (audio);
 
-  return gst_ladspa_setup (&ladspa->ladspa, GST_AUDIO_INFO_RATE (info));
+  return gst_ladspa_setup (&ladspa->ladspa, info);
 }
 
 static gboolean
@@ -85,7 +85,7 @@ gst_ladspa_sink_type_set_caps (GstBaseSink * base, GstCaps * caps)
 
   ladspa->info = info;
 
-  return gst_ladspa_setup (&ladspa->ladspa, GST_AUDIO_INFO_RATE (&info));
+  return gst_ladspa_setup (&ladspa->ladspa, &info);
 }
 
 static gboolean
@@ -116,7 +116,7 @@ gst_ladspa_source_type_set_caps (GstBaseSrc * base, GstCaps * caps)
   gst_base_src_set_blocksize (base,
       GST_AUDIO_INFO_BPF (&info) * ladspa->samples_per_buffer);
 
-  return gst_ladspa_setup (&ladspa->ladspa, GST_AUDIO_INFO_RATE (&info));
+  return gst_ladspa_setup (&ladspa->ladspa, &info);
 }
 
 static gboolean
@@ -138,6 +138,18 @@ gst_ladspa_run (GstLADSPA * ladspa, guint nframes)
   ladspa->klass->descriptor->run (ladspa->handle, nframes);
 }
 
+static LADSPA_Data *
+gst_ladspa_get_scratch (GstLADSPA * ladspa, gsize size)
+{
+  if (size > ladspa->scratch_size) {
+    g_free (ladspa->scratch);
+    ladspa->scratch = g_new (LADSPA_Data, size);
+    ladspa->scratch_size = size;
+  }
+
+  return ladspa->scratch;
+}
+
 /*
  * The data entry/exit point.
  */
@@ -145,22 +157,32 @@ gboolean
 gst_ladspa_transform (GstLADSPA * ladspa, guint8 * outdata, guint samples,
     guint8 * indata)
 {
-  LADSPA_Data *in, *out;
+  const guint audio_in = ladspa->klass->count.audio.in;
+  const guint audio_out = ladspa->klass->count.audio.out;
+  gboolean copy_in, copy_out;
+  LADSPA_Data *in, *out, *scratch;
 
-  in = g_new0 (LADSPA_Data, samples * ladspa->klass->count.audio.in);
-  out = g_new0 (LADSPA_Data, samples * ladspa->klass->count.audio.out);
+  /* non-interleaved and single channel data is laid out like the ports
+   * expect, so the ports use the buffers directly */
+  copy_in = ladspa->interleaved && audio_in > 1;
+  copy_out = ladspa->interleaved && audio_out > 1;
 
-  gst_ladspa_ladspa_deinterleave_data (ladspa, in, samples, indata);
+  scratch = gst_ladspa_get_scratch (ladspa,
+      samples * ((copy_in ? audio_in : 0) + (copy_out ? audio_out : 0)));
+  in = copy_in ? scratch : (LADSPA_Data *) indata;
+  out = copy_out ? scratch + (copy_in ? samples * audio_in : 0) :
+      (LADSPA_Data *) outdata;
+
+  if (copy_in)
+    gst_ladspa_ladspa_deinterleave_data (ladspa, in, samples, indata);
 
   gst_ladspa_connect_audio_in (ladspa, samples, in);
   gst_ladspa_connect_audio_out (ladspa, samples, out);
 
   gst_ladspa_run (ladspa, samples);
 
-  gst_ladspa_interleave_ladspa_data (ladspa, outdata, samples, out);
-
-  g_free (out);
-  g_free (in);
+  if (copy_out)
+    gst_ladspa_interleave_ladspa_data (ladspa, outdata, samples, out);
 
   return TRUE;
 }
@@ -197,11 +219,143 @@ gst_ladspa_deactivate (GstLADSPA * ladspa)
   return TRUE;
 }
 
+/* the port layout of the cached description has to match the library */
+static gboolean
+gst_ladspa_class_load (GstLADSPAClass * ladspa_class)
+{
+  static GMutex load_lock;
+  LADSPA_Descriptor_Function descriptor_function;
+  const LADSPA_Descriptor *desc;
+  gboolean ret = TRUE;
+
+  g_mutex_lock (&load_lock);
+  if (ladspa_class->plugin)
+    goto done;
+
+  GST_DEBUG ("LADSPA loading %s", ladspa_class->file_name);
+
+  ladspa_class->plugin = g_module_open (ladspa_class->file_name,
+      G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
+  if (!ladspa_class->plugin)
+    goto open_failed;
+
+  if (!g_module_symbol (ladspa_class->plugin, "ladspa_descriptor",
+          (gpointer *) & descriptor_function) ||
+      !(desc = descriptor_function (ladspa_class->element_ix)))
+    goto no_descriptor;
+
+  if (ladspa_class->descriptor &&
+      (desc->UniqueID != ladspa_class->descriptor->UniqueID ||
+          desc->PortCount != ladspa_class->descriptor->PortCount))
+    goto changed;
+
+  ladspa_class->descriptor = desc;
+
+done:
+  g_mutex_unlock (&load_lock);
+  return ret;
+
+  /* ERRORS */
+open_failed:
+  {
+    GST_WARNING ("could not open %s: %s", ladspa_class->file_name,
+        g_module_error ());
+    ret = FALSE;
+    goto done;
+  }
+no_descriptor:
+  {
+    GST_WARNING ("no LADSPA plugin %u in %s", ladspa_class->element_ix,
+        ladspa_class->file_name);
+    ret = FALSE;
+    goto unload;
+  }
+changed:
+  {
+    GST_WARNING ("LADSPA plugin %u in %s changed since it was scanned",
+        ladspa_class->element_ix, ladspa_class->file_name);
+    ret = FALSE;
+    goto unload;
+  }
+unload:
+  {
+    g_module_close (ladspa_class->plugin);
+    ladspa_class->plugin = NULL;
+    goto done;
+  }
+}
+
+/* what the scanner stored about the plugin, enough to set up the class but
+ * without any of the functions */
+static const LADSPA_Descriptor *
+gst_ladspa_descriptor_from_meta (const GstStructure * ladspa_meta)
+{
+  LADSPA_Descriptor *desc;
+  LADSPA_PortDescriptor *descriptors;
+  LADSPA_PortRangeHint *hints;
+  const char **names;
+  const GValue *v_descriptors, *v_hints, *v_names, *v_lower, *v_upper;
+  guint64 unique_id = 0;
+  gint properties = 0;
+  guint i, n;
+
+  v_descriptors = gst_structure_get_value (ladspa_meta, "port-descriptors");
+  v_hints = gst_structure_get_value (ladspa_meta, "port-hints");
+  v_names = gst_structure_get_value (ladspa_meta, "port-names");
+  v_lower = gst_structure_get_value (ladspa_meta, "port-lower-bounds");
+  v_upper = gst_structure_get_value (ladspa_meta, "port-upper-bounds");
+  if (!v_descriptors || !v_hints || !v_names || !v_lower || !v_upper)
+    return NULL;
+
+  n = gst_value_array_get_size (v_descriptors);
+  if (gst_value_array_get_size (v_hints) != n ||
+      gst_value_array_get_size (v_names) != n ||
+      gst_value_array_get_size (v_lower) != n ||
+      gst_value_array_get_size (v_upper) != n)
+    return NULL;
+
+  descriptors = g_new0 (LADSPA_PortDescriptor, n);
+  hints = g_new0 (LADSPA_PortRangeHint, n);
+  names = g_new0 (const char *, n);
+
+  for (i = 0; i < n; i++) {
+    descriptors[i] =
+        g_value_get_int (gst_value_array_get_value (v_descriptors, i));
+    hints[i].HintDescriptor =
+        g_value_get_int (gst_value_array_get_value (v_hints, i));
+    hints[i].LowerBound =
+        g_value_get_float (gst_value_array_get_value (v_lower, i));
+    hints[i].UpperBound =
+        g_value_get_float (gst_value_array_get_value (v_upper, i));
+    names[i] = g_value_get_string (gst_value_array_get_value (v_names, i));
+  }
+
+  gst_structure_get_uint64 (ladspa_meta, "unique-id", &unique_id);
+  gst_structure_get_int (ladspa_meta, "properties", &properties);
+
+  desc = g_new0 (LADSPA_Descriptor, 1);
+  desc->UniqueID = unique_id;
+  desc->Label = gst_structure_get_string (ladspa_meta, "label");
+  desc->Properties = properties;
+  desc->Name = gst_structure_get_string (ladspa_meta, "name");
+  desc->Maker = gst_structure_get_string (ladspa_meta, "maker");
+  desc->Copyright = gst_structure_get_string (ladspa_meta, "copyright");
+  desc->PortCount = n;
+  desc->PortDescriptors = descriptors;
+  desc->PortNames = names;
+  desc->PortRangeHints = hints;
+
+  return desc;
+}
+
 static gboolean
 gst_ladspa_open (GstLADSPA * ladspa, unsigned long rate)
 {
   guint i;
 
+  if (!gst_ladspa_class_load (ladspa->klass))
+    return FALSE;
+
   GST_DEBUG ("LADSPA instantiating plugin at %lu Hz", rate);
 
   if (!(ladspa->handle =
@@ -243,12 +397,16 @@ gst_ladspa_close (GstLADSPA * ladspa)
  * Safe open.
  */
 gboolean
-gst_ladspa_setup (GstLADSPA * ladspa, unsigned long rate)
+gst_ladspa_setup (GstLADSPA * ladspa, const GstAudioInfo * info)
 {
+  unsigned long rate = GST_AUDIO_INFO_RATE (info);
   gboolean ret = TRUE;
 
   GST_DEBUG ("LADSPA setting up plugin");
 
+  ladspa->interleaved =
+      GST_AUDIO_INFO_LAYOUT (info) == GST_AUDIO_LAYOUT_INTERLEAVED;
+
   if (ladspa->handle && ladspa->rate != rate) {
     if (ladspa->activated)
       gst_ladspa_deactivate (ladspa);
@@ -257,7 +415,8 @@ gst_ladspa_setup (GstLADSPA * ladspa, unsigned long rate)
   }
 
   if (!ladspa->handle) {
-    gst_ladspa_open (ladspa, rate);
+    if (!(ret = gst_ladspa_open (ladspa, rate)))
+      return ret;
     if (!(ret = gst_ladspa_activate (ladspa)))
       gst_ladspa_close (ladspa);
   }
@@ -657,23 +816,39 @@ gst_ladspa_element_class_set_metadata (GstLADSPAClass * ladspa_class,
   g_free (longname);
 }
 
+/* non-interleaved data doesn't need to be copied for the ports */
+static GstCaps *
+gst_ladspa_audio_caps_new (guint channels)
+{
+  GstCaps *caps;
+  GValue layouts = G_VALUE_INIT, layout = G_VALUE_INIT;
+
+  caps = gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
+      "channels", G_TYPE_INT, channels,
+      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+
+  g_value_init (&layouts, GST_TYPE_LIST);
+  g_value_init (&layout, G_TYPE_STRING);
+  g_value_set_static_string (&layout, "interleaved");
+  gst_value_list_append_value (&layouts, &layout);
+  g_value_set_static_string (&layout, "non-interleaved");
+  gst_value_list_append_value (&layouts, &layout);
+  g_value_unset (&layout);
+  gst_caps_set_value (caps, "layout", &layouts);
+  g_value_unset (&layouts);
+
+  return caps;
+}
+
 void
 gst_ladspa_filter_type_class_add_pad_templates (GstLADSPAClass *
     ladspa_class, GstAudioFilterClass * audio_class)
 {
   GstCaps *srccaps, *sinkcaps;
 
-  srccaps = gst_caps_new_simple ("audio/x-raw",
-      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
-      "channels", G_TYPE_INT, ladspa_class->count.audio.out,
-      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT,
-      "layout", G_TYPE_STRING, "interleaved", NULL);
-
-  sinkcaps = gst_caps_new_simple ("audio/x-raw",
-      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
-      "channels", G_TYPE_INT, ladspa_class->count.audio.in,
-      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT,
-      "layout", G_TYPE_STRING, "interleaved", NULL);
+  srccaps = gst_ladspa_audio_caps_new (ladspa_class->count.audio.out);
+  sinkcaps = gst_ladspa_audio_caps_new (ladspa_class->count.audio.in);
 
   gst_my_audio_filter_class_add_pad_templates (audio_class, srccaps, sinkcaps);
 
@@ -687,11 +862,7 @@ gst_ladspa_source_type_class_add_pad_template (GstLADSPAClass *
 {
   GstCaps *srccaps;
 
-  srccaps = gst_caps_new_simple ("audio/x-raw",
-      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
-      "channels", G_TYPE_INT, ladspa_class->count.audio.out,
-      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT,
-      "layout", G_TYPE_STRING, "interleaved", NULL);
+  srccaps = gst_ladspa_audio_caps_new (ladspa_class->count.audio.out);
 
   gst_my_base_source_class_add_pad_template (base_class, srccaps);
 
@@ -704,11 +875,7 @@ gst_ladspa_sink_type_class_add_pad_template (GstLADSPAClass * ladspa_class,
 {
   GstCaps *sinkcaps;
 
-  sinkcaps = gst_caps_new_simple ("audio/x-raw",
-      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
-      "channels", G_TYPE_INT, ladspa_class->count.audio.in,
-      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT,
-      "layout", G_TYPE_STRING, "interleaved", NULL);
+  sinkcaps = gst_ladspa_audio_caps_new (ladspa_class->count.audio.in);
 
   gst_my_base_sink_class_add_pad_template (base_class, sinkcaps);
 
@@ -725,6 +892,9 @@ gst_ladspa_init (GstLADSPA * ladspa, GstLADSPAClass * ladspa_class)
   ladspa->handle = NULL;
   ladspa->activated = FALSE;
   ladspa->rate = 0;
+  ladspa->interleaved = TRUE;
+  ladspa->scratch = NULL;
+  ladspa->scratch_size = 0;
 
   ladspa->ports.audio.in = g_new0 (LADSPA_Data *, ladspa_class->count.audio.in);
   ladspa->ports.audio.out =
@@ -750,6 +920,10 @@ gst_ladspa_finalize (GstLADSPA * ladspa)
   ladspa->ports.audio.out = NULL;
   g_free (ladspa->ports.audio.in);
   ladspa->ports.audio.in = NULL;
+
+  g_free (ladspa->scratch);
+  ladspa->scratch = NULL;
+  ladspa->scratch_size = 0;
 }
 
 void
@@ -760,19 +934,21 @@ gst_ladspa_class_init (GstLADSPAClass * ladspa_class, GType type)
   const GValue *value =
       gst_structure_get_value (ladspa_meta_all, g_type_name (type));
   GstStructure *ladspa_meta = g_value_get_boxed (value);
-  const gchar *file_name;
-  LADSPA_Descriptor_Function descriptor_function;
 
   GST_DEBUG ("LADSPA initializing class");
 
-  file_name = gst_structure_get_string (ladspa_meta, "plugin-filename");
-  ladspa_class->plugin =
-      g_module_open (file_name, G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
-  g_module_symbol (ladspa_class->plugin, "ladspa_descriptor",
-      (gpointer *) & descriptor_function);
+  ladspa_class->file_name =
+      g_strdup (gst_structure_get_string (ladspa_meta, "plugin-filename"));
   gst_structure_get_uint (ladspa_meta, "element-ix", &ix);
+  ladspa_class->element_ix = ix;
+
+  /* registering the elements doesn't load any of the libraries, unless the
+   * scanner did not describe the ports */
+  if (!(ladspa_class->descriptor =
+          gst_ladspa_descriptor_from_meta (ladspa_meta)))
+    gst_ladspa_class_load (ladspa_class);
+  g_assert (ladspa_class->descriptor != NULL);
 
-  ladspa_class->descriptor = descriptor_function (ix);
   gst_structure_get_uint (ladspa_meta, "audio-in",
       &ladspa_class->count.audio.in);
   gst_structure_get_uint (ladspa_meta, "audio-out",
@@ -831,8 +1007,11 @@ gst_ladspa_class_finalize (GstLADSPAClass * ladspa_class)
   g_free (ladspa_class->map.audio.in);
   ladspa_class->map.audio.in = NULL;
 
-  g_module_close (ladspa_class->plugin);
+  if (ladspa_class->plugin)
+    g_module_close (ladspa_class->plugin);
   ladspa_class->plugin = NULL;
+  g_free (ladspa_class->file_name);
+  ladspa_class->file_name = NULL;
 }
 
 /*
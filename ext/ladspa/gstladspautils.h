@@ -44,6 +44,11 @@ struct _GstLADSPA
   LADSPA_Handle *handle;
   gboolean activated;
   unsigned long rate;
+  gboolean interleaved;
+
+  /* for the data that has to be (de)interleaved, kept across buffers */
+  LADSPA_Data *scratch;
+  gsize scratch_size;
 
   struct
   {
@@ -65,8 +70,12 @@ struct _GstLADSPAClass
 {
   guint properties;
 
+  /* until an element is set up, the descriptor is only the description the
+   * scanner stored and the library is not loaded */
   GModule *plugin;
   const LADSPA_Descriptor *descriptor;
+  gchar *file_name;
+  guint element_ix;
 
   struct
   {
@@ -104,7 +113,7 @@ gst_ladspa_transform (GstLADSPA * ladspa, guint8 * outdata, guint samples,
     guint8 * indata);
 
 gboolean
-gst_ladspa_setup (GstLADSPA * ladspa, unsigned long rate);
+gst_ladspa_setup (GstLADSPA * ladspa, const GstAudioInfo * info);
 
 gboolean
 gst_ladspa_cleanup (GstLADSPA * ladspa);
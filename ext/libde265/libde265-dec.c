@@ -85,6 +85,8 @@ static gboolean gst_libde265_dec_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state);
 static gboolean gst_libde265_dec_flush (GstVideoDecoder * decoder);
 static GstFlowReturn gst_libde265_dec_finish (GstVideoDecoder * decoder);
+static gboolean gst_libde265_dec_decide_allocation (GstVideoDecoder * decoder,
+    GstQuery * query);
 static GstFlowReturn _gst_libde265_return_image (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame, const struct de265_image *img);
 static GstFlowReturn gst_libde265_dec_handle_frame (GstVideoDecoder * decoder,
@@ -114,6 +116,8 @@ gst_libde265_dec_class_init (GstLibde265DecClass * klass)
   decoder_class->set_format = GST_DEBUG_FUNCPTR (gst_libde265_dec_set_format);
   decoder_class->flush = GST_DEBUG_FUNCPTR (gst_libde265_dec_flush);
   decoder_class->finish = GST_DEBUG_FUNCPTR (gst_libde265_dec_finish);
+  decoder_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_libde265_dec_decide_allocation);
   decoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_libde265_dec_handle_frame);
 
@@ -136,6 +140,8 @@ _gst_libde265_dec_reset_decoder (GstLibde265Dec * dec)
   dec->codec_data_size = 0;
   dec->input_state = NULL;
   dec->output_state = NULL;
+  gst_video_alignment_reset (&dec->alignment);
+  dec->alignment_supported = FALSE;
 }
 
 static void
@@ -245,6 +251,7 @@ gst_libde265_dec_get_buffer (de265_decoder_context * ctx,
   GstFlowReturn ret;
   struct GstLibde265FrameRef *ref;
   GstVideoInfo *info;
+  GstVideoAlignment align;
   int frame_number;
 
   frame_number = (uintptr_t) de265_get_image_user_data (img) - 1;
@@ -264,12 +271,25 @@ gst_libde265_dec_get_buffer (de265_decoder_context * ctx,
   if (width % spec->alignment) {
     width += spec->alignment - (width % spec->alignment);
   }
-  if (width != spec->visible_width || height != spec->visible_height) {
+  if (spec->crop_left || spec->crop_top) {
     /* clipping not supported for now */
     goto fallback;
   }
 
-  ret = _gst_libde265_image_available (base, width, height);
+  /* the pictures are decoded with their padding to the coded size, which
+   * the output buffers need to have too */
+  gst_video_alignment_reset (&align);
+  align.padding_right = width - spec->visible_width;
+  align.padding_bottom = height - spec->visible_height;
+  for (i = 0; i < GST_VIDEO_MAX_PLANES; i++)
+    align.stride_align[i] = spec->alignment - 1;
+  if (memcmp (&align, &dec->alignment, sizeof (align)) != 0) {
+    dec->alignment = align;
+    gst_pad_mark_reconfigure (GST_VIDEO_DECODER_SRC_PAD (dec));
+  }
+
+  ret = _gst_libde265_image_available (base, spec->visible_width,
+      spec->visible_height);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_ERROR_OBJECT (dec, "Failed to notify about available image");
     goto fallback;
@@ -281,6 +301,13 @@ gst_libde265_dec_get_buffer (de265_decoder_context * ctx,
     GST_ERROR_OBJECT (dec, "Failed to allocate output buffer");
     goto fallback;
   }
+  if ((align.padding_right || align.padding_bottom)
+      && !dec->alignment_supported) {
+    GST_DEBUG_OBJECT (dec, "output buffers can't have %ux%u padding",
+        align.padding_right, align.padding_bottom);
+    gst_buffer_replace (&frame->output_buffer, NULL);
+    goto fallback;
+  }
 
   ref = (struct GstLibde265FrameRef *) g_malloc0 (sizeof (*ref));
   g_assert (ref != NULL);
@@ -305,9 +332,11 @@ gst_libde265_dec_get_buffer (de265_decoder_context * ctx,
     goto error;
   }
 
-  if (GST_VIDEO_FRAME_COMP_HEIGHT (&ref->vframe, 0) < height) {
+  if (GST_VIDEO_FRAME_COMP_HEIGHT (&ref->vframe, 0) + align.padding_bottom <
+      height) {
     GST_DEBUG_OBJECT (dec, "plane 0: lines too few (%d/%d)",
-        GST_VIDEO_FRAME_COMP_HEIGHT (&ref->vframe, 0), height);
+        GST_VIDEO_FRAME_COMP_HEIGHT (&ref->vframe, 0) + align.padding_bottom,
+        height);
     goto error;
   }
 
@@ -502,6 +531,65 @@ gst_libde265_dec_finish (GstVideoDecoder * decoder)
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_libde265_dec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
+{
+  GstLibde265Dec *dec = GST_LIBDE265_DEC (decoder);
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  GstVideoInfo info;
+  GstCaps *caps;
+  guint size, min, max;
+
+  if (!GST_VIDEO_DECODER_CLASS (parent_class)->decide_allocation (decoder,
+          query))
+    return FALSE;
+
+  /* The base class ensures that there will always be at least a 0th pool
+   * in the query. */
+  gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL);
+
+  dec->alignment_supported =
+      gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL)
+      && gst_buffer_pool_has_option (pool,
+      GST_BUFFER_POOL_OPTION_VIDEO_ALIGNMENT)
+      && caps && gst_video_info_from_caps (&info, caps);
+
+  if (dec->alignment_supported) {
+    gst_video_info_align (&info, &dec->alignment);
+    size = MAX (size, GST_VIDEO_INFO_SIZE (&info));
+    gst_buffer_pool_config_set_params (config, caps, size, min, max);
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_META);
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_ALIGNMENT);
+    gst_buffer_pool_config_set_video_alignment (config, &dec->alignment);
+
+    /* libde265 wants the planes as aligned as their strides */
+    if (gst_buffer_pool_config_get_allocator (config, &allocator, &params)) {
+      params.align |= dec->alignment.stride_align[0];
+      gst_buffer_pool_config_set_allocator (config, allocator, &params);
+    }
+
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      GST_DEBUG_OBJECT (dec, "pool refused the padded frames");
+      dec->alignment_supported = FALSE;
+    } else {
+      gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+    }
+  } else {
+    gst_structure_free (config);
+  }
+
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 _gst_libde265_image_available (GstVideoDecoder * decoder, int width, int height)
 {
@@ -842,9 +930,6 @@ gst_libde265_dec_handle_frame (GstVideoDecoder * decoder,
 
     case DE265_ERROR_IMAGE_BUFFER_FULL:
       dec->buffer_full = 1;
-      if ((img = de265_peek_next_picture (dec->ctx)) == NULL) {
-        return GST_FLOW_OK;
-      }
       break;
 
     default:
@@ -859,13 +944,21 @@ gst_libde265_dec_handle_frame (GstVideoDecoder * decoder,
         ("%s (code=%d)", de265_get_error_text (ret), ret), (NULL));
   }
 
-  img = de265_get_next_picture (dec->ctx);
-  if (img == NULL) {
-    /* need more data */
-    return GST_FLOW_OK;
+  /* output all the pictures that are ready, so that the worker threads
+   * can move on to the next ones */
+  while ((img = de265_get_next_picture (dec->ctx)) != NULL) {
+    GstFlowReturn result = _gst_libde265_return_image (decoder, frame, img);
+
+    frame = NULL;
+    if (result != GST_FLOW_OK)
+      return result;
   }
 
-  return _gst_libde265_return_image (decoder, frame, img);
+  /* need more data */
+  if (frame != NULL)
+    gst_video_codec_frame_unref (frame);
+
+  return GST_FLOW_OK;
 
 error_input:
   gst_buffer_unmap (frame->input_buffer, &info);
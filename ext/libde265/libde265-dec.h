@@ -55,6 +55,10 @@ typedef struct _GstLibde265Dec
   int codec_data_size;
   GstVideoCodecState *input_state;
   GstVideoCodecState *output_state;
+  /* padding of the coded pictures, decoded into in place when the
+   * output pool supports it */
+  GstVideoAlignment alignment;
+  gboolean alignment_supported;
 } GstLibde265Dec;
 
 typedef struct _GstLibde265DecClass
@@ -251,18 +251,8 @@ gst_lv2_filter_type_class_add_pad_templates (GstLV2FilterClass * klass)
 
   out_channels = klass->lv2.out_group.ports->len;
 
-  /* FIXME Implement deintereleaved audio support */
-  sinkcaps = gst_caps_new_simple ("audio/x-raw",
-      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
-      "channels", G_TYPE_INT, in_channels,
-      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT,
-      "layout", G_TYPE_STRING, "interleaved", NULL);
-
-  srccaps = gst_caps_new_simple ("audio/x-raw",
-      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
-      "channels", G_TYPE_INT, out_channels,
-      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT,
-      "layout", G_TYPE_STRING, "interleaved", NULL);
+  sinkcaps = gst_lv2_audio_caps_new (in_channels);
+  srccaps = gst_lv2_audio_caps_new (out_channels);
 
   pad_template =
       gst_pad_template_new (GST_BASE_TRANSFORM_SINK_NAME, GST_PAD_SINK,
@@ -288,7 +278,7 @@ gst_lv2_filter_setup (GstAudioFilter * gsp, const GstAudioInfo * info)
   GST_DEBUG_OBJECT (self, "instantiating the plugin at %d Hz",
       GST_AUDIO_INFO_RATE (info));
 
-  if (!gst_lv2_setup (&self->lv2, GST_AUDIO_INFO_RATE (info)))
+  if (!gst_lv2_setup (&self->lv2, info))
     goto no_instance;
 
   /* FIXME Handle audio channel positionning while negotiating CAPS */
@@ -381,29 +371,40 @@ gst_lv2_filter_transform_data (GstLV2Filter * self,
   GstLV2Class *lv2_class = &klass->lv2;
   GstLV2Group *lv2_group;
   GstLV2Port *lv2_port;
-  guint j, k, l, nframes, samples, out_samples;
-  gfloat *in = NULL, *out = NULL, *cv = NULL, *mem;
+  guint j, k, l, nframes, samples, n_in, n_out;
+  gboolean copy_in, copy_out;
+  gfloat *in, *out, *cv, *mem;
   gfloat val;
 
   nframes = in_map->size / sizeof (float);
+  n_in = lv2_class->in_group.ports->len;
+  n_out = lv2_class->out_group.ports->len;
+  samples = nframes / n_in;
+
+  /* non-interleaved and single channel data is laid out like the ports
+   * expect, so the ports use the buffers directly */
+  copy_in = self->lv2.interleaved && n_in > 1;
+  copy_out = self->lv2.interleaved && n_out > 1;
+
+  in = gst_lv2_get_scratch (&self->lv2, samples * ((copy_in ? n_in : 0) +
+          (copy_out ? n_out : 0) + lv2_class->num_cv_in));
+  out = in + (copy_in ? n_in * samples : 0);
+  cv = out + (copy_out ? n_out * samples : 0);
+
+  if (copy_in)
+    gst_lv2_filter_deinterleave_data (n_in, in, samples,
+        (gfloat *) in_map->data);
+  else
+    in = (gfloat *) in_map->data;
+
+  if (!copy_out)
+    out = (gfloat *) out_map->data;
 
   /* multi channel inputs */
   lv2_group = &lv2_class->in_group;
-  samples = nframes / lv2_group->ports->len;
   GST_LOG_OBJECT (self, "in : samples=%u, nframes=%u, ports=%d", samples,
-      nframes, lv2_group->ports->len);
-
-  if (lv2_group->ports->len > 1) {
-    in = g_new0 (gfloat, nframes);
-    out = g_new0 (gfloat, samples * lv2_group->ports->len);
-    gst_lv2_filter_deinterleave_data (lv2_group->ports->len, in,
-        samples, (gfloat *) in_map->data);
-  } else {
-    in = (gfloat *) in_map->data;
-    out = (gfloat *) out_map->data;
-  }
-
-  for (j = 0; j < lv2_group->ports->len; ++j) {
+      nframes, n_in);
+  for (j = 0; j < n_in; ++j) {
     lv2_port = &g_array_index (lv2_group->ports, GstLV2Port, j);
     lilv_instance_connect_port (self->lv2.instance, lv2_port->index,
         in + (j * samples));
@@ -411,18 +412,14 @@ gst_lv2_filter_transform_data (GstLV2Filter * self,
 
   /* multi channel outputs */
   lv2_group = &lv2_class->out_group;
-  out_samples = nframes / lv2_group->ports->len;
-
-  GST_LOG_OBJECT (self, "out: samples=%u, nframes=%u, ports=%d", out_samples,
-      nframes, lv2_group->ports->len);
-  for (j = 0; j < lv2_group->ports->len; ++j) {
+  GST_LOG_OBJECT (self, "out: samples=%u, ports=%d", samples, n_out);
+  for (j = 0; j < n_out; ++j) {
     lv2_port = &g_array_index (lv2_group->ports, GstLV2Port, j);
     lilv_instance_connect_port (self->lv2.instance, lv2_port->index,
-        out + (j * out_samples));
+        out + (j * samples));
   }
 
   /* cv ports */
-  cv = g_new (gfloat, samples * lv2_class->num_cv_in);
   for (j = k = 0; j < lv2_class->control_in_ports->len; j++) {
     lv2_port = &g_array_index (lv2_class->control_in_ports, GstLV2Port, j);
     if (lv2_port->type != GST_LV2_PORT_CV)
@@ -439,13 +436,9 @@ gst_lv2_filter_transform_data (GstLV2Filter * self,
 
   lilv_instance_run (self->lv2.instance, samples);
 
-  if (lv2_group->ports->len > 1) {
-    gst_lv2_filter_interleave_data (lv2_group->ports->len,
-        (gfloat *) out_map->data, out_samples, out);
-    g_free (out);
-    g_free (in);
-  }
-  g_free (cv);
+  if (copy_out)
+    gst_lv2_filter_interleave_data (n_out, (gfloat *) out_map->data, samples,
+        out);
 
   return GST_FLOW_OK;
 }
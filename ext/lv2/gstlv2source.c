@@ -178,7 +178,7 @@ gst_lv2_source_set_caps (GstBaseSrc * base, GstCaps * caps)
   gst_base_src_set_blocksize (base,
       GST_AUDIO_INFO_BPF (&info) * lv2->samples_per_buffer);
 
-  if (!gst_lv2_setup (&lv2->lv2, GST_AUDIO_INFO_RATE (&info)))
+  if (!gst_lv2_setup (&lv2->lv2, &info))
     goto no_instance;
 
   return TRUE;
@@ -373,8 +373,9 @@ gst_lv2_source_fill (GstBaseSrc * base, guint64 offset,
   GstElementClass *eclass;
   GstMapInfo map;
   gint samplerate, bpf;
-  guint j, k, l;
-  gfloat *out = NULL, *cv = NULL, *mem;
+  guint j, k, l, n_out;
+  gboolean copy_out;
+  gfloat *out, *cv, *mem;
   gfloat val;
 
   /* example for tagging generated data */
@@ -468,27 +469,31 @@ gst_lv2_source_fill (GstBaseSrc * base, guint64 offset,
   GST_LOG_OBJECT (lv2, "generating %u samples at ts %" GST_TIME_FORMAT,
       samples, GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)));
 
+  /* the planes of non-interleaved data follow each other in the buffer */
+  samples = lv2->generate_samples_per_buffer;
+
   gst_buffer_map (buffer, &map, GST_MAP_WRITE);
 
-  /* multi channel outputs */
+  /* multi channel outputs, non-interleaved and single channel data is
+   * written to the buffer directly */
   lv2_group = &lv2_class->out_group;
-  if (lv2_group->ports->len > 1) {
-    out = g_new0 (gfloat, samples * lv2_group->ports->len);
-    for (j = 0; j < lv2_group->ports->len; ++j) {
-      lv2_port = &g_array_index (lv2_group->ports, GstLV2Port, j);
-      lilv_instance_connect_port (lv2->lv2.instance, lv2_port->index,
-          out + (j * samples));
-      GST_LOG_OBJECT (lv2, "connected port %d/%d", j, lv2_group->ports->len);
-    }
-  } else {
-    lv2_port = &g_array_index (lv2_group->ports, GstLV2Port, 0);
+  n_out = lv2_group->ports->len;
+  copy_out = lv2->lv2.interleaved && n_out > 1;
+
+  out = gst_lv2_get_scratch (&lv2->lv2,
+      samples * ((copy_out ? n_out : 0) + lv2_class->num_cv_in));
+  cv = out + (copy_out ? n_out * samples : 0);
+  if (!copy_out)
+    out = (gfloat *) map.data;
+
+  for (j = 0; j < n_out; ++j) {
+    lv2_port = &g_array_index (lv2_group->ports, GstLV2Port, j);
     lilv_instance_connect_port (lv2->lv2.instance, lv2_port->index,
-        (gfloat *) map.data);
-    GST_LOG_OBJECT (lv2, "connected port 0");
+        out + (j * samples));
+    GST_LOG_OBJECT (lv2, "connected port %d/%d", j, n_out);
   }
 
   /* cv ports */
-  cv = g_new (gfloat, samples * lv2_class->num_cv_in);
   for (j = k = 0; j < lv2_class->control_in_ports->len; j++) {
     lv2_port = &g_array_index (lv2_class->control_in_ports, GstLV2Port, j);
     if (lv2_port->type != GST_LV2_PORT_CV)
@@ -505,13 +510,8 @@ gst_lv2_source_fill (GstBaseSrc * base, guint64 offset,
 
   lilv_instance_run (lv2->lv2.instance, samples);
 
-  if (lv2_group->ports->len > 1) {
-    gst_lv2_source_interleave_data (lv2_group->ports->len,
-        (gfloat *) map.data, samples, out);
-    g_free (out);
-  }
-
-  g_free (cv);
+  if (copy_out)
+    gst_lv2_source_interleave_data (n_out, (gfloat *) map.data, samples, out);
 
   gst_buffer_unmap (buffer, &map);
 
@@ -627,11 +627,7 @@ gst_lv2_source_base_init (gpointer g_class)
   gst_lv2_element_class_set_metadata (&klass->lv2, element_class,
       "Source/Audio/LV2");
 
-  srccaps = gst_caps_new_simple ("audio/x-raw",
-      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
-      "channels", G_TYPE_INT, klass->lv2.out_group.ports->len,
-      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT,
-      "layout", G_TYPE_STRING, "interleaved", NULL);
+  srccaps = gst_lv2_audio_caps_new (klass->lv2.out_group.ports->len);
 
   pad_template =
       gst_pad_template_new (GST_BASE_TRANSFORM_SRC_NAME, GST_PAD_SRC,
@@ -390,6 +390,9 @@ gst_lv2_init (GstLV2 * lv2, GstLV2Class * lv2_class)
 
   lv2->instance = NULL;
   lv2->activated = FALSE;
+  lv2->interleaved = TRUE;
+  lv2->scratch = NULL;
+  lv2->scratch_size = 0;
 
   lv2->ports.control.in = g_new0 (gfloat, lv2_class->control_in_ports->len);
   lv2->ports.control.out = g_new0 (gfloat, lv2_class->control_out_ports->len);
@@ -403,16 +406,60 @@ gst_lv2_finalize (GstLV2 * lv2)
   }
   g_free (lv2->ports.control.in);
   g_free (lv2->ports.control.out);
+  g_free (lv2->scratch);
+}
+
+/* Returns at least @size floats of memory owned by @lv2, only reallocated
+ * when a larger buffer comes along */
+gfloat *
+gst_lv2_get_scratch (GstLV2 * lv2, gsize size)
+{
+  if (size > lv2->scratch_size) {
+    g_free (lv2->scratch);
+    lv2->scratch = g_new (gfloat, size);
+    lv2->scratch_size = size;
+  }
+
+  return lv2->scratch;
+}
+
+/* non-interleaved data doesn't need to be copied for the ports */
+GstCaps *
+gst_lv2_audio_caps_new (guint channels)
+{
+  GstCaps *caps;
+  GValue layouts = G_VALUE_INIT, layout = G_VALUE_INIT;
+
+  caps = gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
+      "channels", G_TYPE_INT, channels,
+      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+
+  g_value_init (&layouts, GST_TYPE_LIST);
+  g_value_init (&layout, G_TYPE_STRING);
+  g_value_set_static_string (&layout, "interleaved");
+  gst_value_list_append_value (&layouts, &layout);
+  g_value_set_static_string (&layout, "non-interleaved");
+  gst_value_list_append_value (&layouts, &layout);
+  g_value_unset (&layout);
+  gst_caps_set_value (caps, "layout", &layouts);
+  g_value_unset (&layouts);
+
+  return caps;
 }
 
 gboolean
-gst_lv2_setup (GstLV2 * lv2, unsigned long rate)
+gst_lv2_setup (GstLV2 * lv2, const GstAudioInfo * info)
 {
   GstLV2Class *lv2_class = lv2->klass;
+  unsigned long rate = GST_AUDIO_INFO_RATE (info);
   GstLV2Port *port;
   GArray *ports;
   gint i;
 
+  lv2->interleaved =
+      GST_AUDIO_INFO_LAYOUT (info) == GST_AUDIO_LAYOUT_INTERLEAVED;
+
   if (lv2->instance)
     lilv_instance_free (lv2->instance);
 
@@ -73,6 +73,11 @@ struct _GstLV2
 
   gboolean activated;
   unsigned long rate;
+  gboolean interleaved;
+
+  /* for (de)interleaved audio and cv ports, kept across buffers */
+  gfloat *scratch;
+  gsize scratch_size;
 
   struct
   {
@@ -113,9 +118,12 @@ gboolean gst_lv2_delete_preset (GstLV2 * lv2, GstObject * obj, const gchar * nam
 void gst_lv2_init (GstLV2 * lv2, GstLV2Class * lv2_class);
 void gst_lv2_finalize (GstLV2 * lv2);
 
-gboolean gst_lv2_setup (GstLV2 * lv2, unsigned long rate);
+gboolean gst_lv2_setup (GstLV2 * lv2, const GstAudioInfo * info);
 gboolean gst_lv2_cleanup (GstLV2 * lv2, GstObject *obj);
 
+gfloat *gst_lv2_get_scratch (GstLV2 * lv2, gsize size);
+GstCaps *gst_lv2_audio_caps_new (guint channels);
+
 void gst_lv2_object_set_property (GstLV2 * lv2, GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 void gst_lv2_object_get_property (GstLV2 * lv2, GObject * object,
@@ -61,6 +61,7 @@
 #endif
 
 #include "gstedgedetect.h"
+#include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/imgproc/imgproc_c.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_edge_detect_debug);
@@ -106,24 +107,14 @@ static void gst_edge_detect_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_edge_detect_transform (GstOpencvVideoFilter * filter,
-    GstBuffer * buf, IplImage * img, GstBuffer * outbuf, IplImage * outimg);
-static gboolean gst_edge_detect_set_caps (GstOpencvVideoFilter * transform,
-    gint in_width, gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels);
+    GstBuffer * buf, cv::Mat & img, GstBuffer * outbuf, cv::Mat & outimg);
 
-/* Clean up */
-static void
-gst_edge_detect_finalize (GObject * obj)
+/* indices of the scratch images */
+enum
 {
-  GstEdgeDetect *filter = GST_EDGE_DETECT (obj);
-
-  if (filter->cvEdge != NULL) {
-    cvReleaseImage (&filter->cvGray);
-    cvReleaseImage (&filter->cvEdge);
-  }
-
-  G_OBJECT_CLASS (gst_edge_detect_parent_class)->finalize (obj);
-}
+  SCRATCH_GRAY,
+  SCRATCH_EDGE
+};
 
 /* initialize the edgedetect's class */
 static void
@@ -136,12 +127,10 @@ gst_edge_detect_class_init (GstEdgeDetectClass * klass)
   gobject_class = (GObjectClass *) klass;
   gstopencvbasefilter_class = (GstOpencvVideoFilterClass *) klass;
 
-  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_edge_detect_finalize);
   gobject_class->set_property = gst_edge_detect_set_property;
   gobject_class->get_property = gst_edge_detect_get_property;
 
-  gstopencvbasefilter_class->cv_trans_func = gst_edge_detect_transform;
-  gstopencvbasefilter_class->cv_set_caps = gst_edge_detect_set_caps;
+  gstopencvbasefilter_class->cv_trans_mat_func = gst_edge_detect_transform;
 
   g_object_class_install_property (gobject_class, PROP_MASK,
       g_param_spec_boolean ("mask", "Mask",
@@ -237,42 +226,25 @@ gst_edge_detect_get_property (GObject * object, guint prop_id,
   }
 }
 
-/* GstElement vmethod implementations */
-
-/* this function handles the link with other elements */
-static gboolean
-gst_edge_detect_set_caps (GstOpencvVideoFilter * transform,
-    gint in_width, gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels)
-{
-  GstEdgeDetect *filter = GST_EDGE_DETECT (transform);
-
-  if (filter->cvEdge != NULL) {
-      cvReleaseImage (&filter->cvGray);
-      cvReleaseImage (&filter->cvEdge);
-  }
-
-  filter->cvGray = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U, 1);
-  filter->cvEdge = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U, 1);
-
-  return TRUE;
-}
-
 static GstFlowReturn
 gst_edge_detect_transform (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img, GstBuffer * outbuf, IplImage * outimg)
+    cv::Mat & img, GstBuffer * outbuf, cv::Mat & outimg)
 {
   GstEdgeDetect *filter = GST_EDGE_DETECT (base);
+  cv::Mat & gray = gst_opencv_video_filter_get_scratch (base, SCRATCH_GRAY,
+      img.cols, img.rows, CV_8UC1);
+  cv::Mat & edge = gst_opencv_video_filter_get_scratch (base, SCRATCH_EDGE,
+      img.cols, img.rows, CV_8UC1);
 
-  cvCvtColor (img, filter->cvGray, CV_RGB2GRAY);
-  cvCanny (filter->cvGray, filter->cvEdge, filter->threshold1,
-      filter->threshold2, filter->aperture);
+  cv::cvtColor (img, gray, CV_RGB2GRAY);
+  cv::Canny (gray, edge, filter->threshold1, filter->threshold2,
+      filter->aperture);
 
-  cvZero (outimg);
   if (filter->mask) {
-    cvCopy (img, outimg, filter->cvEdge);
+    outimg.setTo (cv::Scalar::all (0));
+    img.copyTo (outimg, edge);
   } else {
-    cvCvtColor (filter->cvEdge, outimg, CV_GRAY2RGB);
+    cv::cvtColor (edge, outimg, CV_GRAY2RGB);
   }
 
   return GST_FLOW_OK;
@@ -74,9 +74,6 @@ struct _GstEdgeDetect
   int threshold1;
   int threshold2;
   int aperture;
-
-  IplImage *cvEdge;
-  IplImage *cvGray;
 };
 
 struct _GstEdgeDetectClass
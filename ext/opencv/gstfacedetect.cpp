@@ -101,6 +101,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_face_detect_debug);
 #define DEFAULT_MIN_SIZE_WIDTH 30
 #define DEFAULT_MIN_SIZE_HEIGHT 30
 #define DEFAULT_MIN_STDDEV 0
+#define DEFAULT_DETECTION_WIDTH 0
+#define DEFAULT_DETECTION_INTERVAL 1
+#define DEFAULT_N_THREADS 1
 
 using namespace cv;
 /* Filter signals and args */
@@ -124,9 +127,42 @@ enum
   PROP_MIN_SIZE_WIDTH,
   PROP_MIN_SIZE_HEIGHT,
   PROP_UPDATES,
-  PROP_MIN_STDDEV
+  PROP_MIN_STDDEV,
+  PROP_DETECTION_WIDTH,
+  PROP_DETECTION_INTERVAL,
+  PROP_N_THREADS
 };
 
+/* the face features, each one detected with its own cascade in a part of
+ * the detected faces */
+enum
+{
+  FEATURE_NOSE,
+  FEATURE_MOUTH,
+  FEATURE_EYES,
+  N_FEATURES
+};
+
+/* indices of the scratch images */
+enum
+{
+  SCRATCH_GRAY,
+  SCRATCH_SMALL
+};
+
+/* the detection of one feature in all the faces of a frame, which can run
+ * in parallel with the other features since each one has its own
+ * classifier */
+typedef struct
+{
+  CascadeClassifier *detector;
+  const Mat *gray;
+  const vector < Rect > *faces;
+  guint min_width, min_height;
+  vector < Rect > rois;
+  vector < vector < Rect > > results;
+} GstFaceDetectFeatureTask;
+
 
 /*
  * GstOpencvFaceDetectFlags:
@@ -234,10 +270,11 @@ static gboolean gst_face_detect_set_caps (GstOpencvVideoFilter * transform,
     gint in_width, gint in_height, gint in_depth, gint in_channels,
     gint out_width, gint out_height, gint out_depth, gint out_channels);
 static GstFlowReturn gst_face_detect_transform_ip (GstOpencvVideoFilter * base,
-    GstBuffer * buf, IplImage * img);
+    GstBuffer * buf, Mat & img);
 
 static CascadeClassifier *gst_face_detect_load_profile (GstFaceDetect *
     filter, gchar * profile);
+static void gst_face_detect_feature_func (gpointer data, gpointer user_data);
 
 /* Clean up */
 static void
@@ -245,8 +282,10 @@ gst_face_detect_finalize (GObject * obj)
 {
   GstFaceDetect *filter = GST_FACE_DETECT (obj);
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
+  g_thread_pool_free (filter->pool, FALSE, TRUE);
+  g_mutex_clear (&filter->lock);
+  g_cond_clear (&filter->cond);
+  delete filter->prev_faces;
 
   g_free (filter->face_profile);
   g_free (filter->nose_profile);
@@ -280,7 +319,8 @@ gst_face_detect_class_init (GstFaceDetectClass * klass)
   gobject_class->set_property = gst_face_detect_set_property;
   gobject_class->get_property = gst_face_detect_get_property;
 
-  gstopencvbasefilter_class->cv_trans_ip_func = gst_face_detect_transform_ip;
+  gstopencvbasefilter_class->cv_trans_ip_mat_func =
+      gst_face_detect_transform_ip;
   gstopencvbasefilter_class->cv_set_caps = gst_face_detect_set_caps;
 
   g_object_class_install_property (gobject_class, PROP_DISPLAY,
@@ -347,6 +387,54 @@ gst_face_detect_class_init (GstFaceDetectClass * klass)
           "little changes", 0, 255, DEFAULT_MIN_STDDEV,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /**
+   * GstFaceDetect:detection-width:
+   *
+   * Largest width the faces are searched at. Larger frames are scaled down
+   * for the face cascade, the nose, mouth and eyes are still searched at
+   * full resolution in the detected faces. The minimum sizes refer to the
+   * full resolution frame.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DETECTION_WIDTH,
+      g_param_spec_uint ("detection-width", "Detection width",
+          "Largest width faces are searched at, larger frames are scaled "
+          "down (0 = full resolution)", 0, G_MAXINT, DEFAULT_DETECTION_WIDTH,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  /**
+   * GstFaceDetect:detection-interval:
+   *
+   * Number of frames between two searches for faces in the whole frame. On
+   * the frames in between, the faces are only tracked: each one is searched
+   * for again around its last position, and faces that appear are only
+   * found at the next full search.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DETECTION_INTERVAL,
+      g_param_spec_uint ("detection-interval", "Detection interval",
+          "Number of frames between two searches for faces in the whole "
+          "frame, the faces are tracked in between", 1, G_MAXUINT,
+          DEFAULT_DETECTION_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  /**
+   * GstFaceDetect:n-threads:
+   *
+   * Number of threads the nose, mouth and eyes detections run in. Each
+   * feature is searched in one thread, so more than 3 threads are not
+   * used.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads for the face feature detection "
+          "(0 = number of processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
   gst_element_class_set_static_metadata (element_class,
       "facedetect",
       "Filter/Effect/Video",
@@ -375,6 +463,15 @@ gst_face_detect_init (GstFaceDetect * filter)
   filter->min_size_width = DEFAULT_MIN_SIZE_WIDTH;
   filter->min_size_height = DEFAULT_MIN_SIZE_HEIGHT;
   filter->min_stddev = DEFAULT_MIN_STDDEV;
+  filter->detection_width = DEFAULT_DETECTION_WIDTH;
+  filter->detection_interval = DEFAULT_DETECTION_INTERVAL;
+  filter->n_threads = DEFAULT_N_THREADS;
+  filter->prev_faces = new vector < Rect > ();
+  g_mutex_init (&filter->lock);
+  g_cond_init (&filter->cond);
+  /* the streaming thread detects one of the features itself */
+  filter->pool = g_thread_pool_new (gst_face_detect_feature_func, filter,
+      N_FEATURES - 1, FALSE, NULL);
   filter->cvFaceDetect =
       gst_face_detect_load_profile (filter, filter->face_profile);
   filter->cvNoseDetect =
@@ -452,6 +549,15 @@ gst_face_detect_set_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       filter->updates = g_value_get_enum (value);
       break;
+    case PROP_DETECTION_WIDTH:
+      filter->detection_width = g_value_get_uint (value);
+      break;
+    case PROP_DETECTION_INTERVAL:
+      filter->detection_interval = g_value_get_uint (value);
+      break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -501,6 +607,15 @@ gst_face_detect_get_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       g_value_set_enum (value, filter->updates);
       break;
+    case PROP_DETECTION_WIDTH:
+      g_value_set_uint (value, filter->detection_width);
+      break;
+    case PROP_DETECTION_INTERVAL:
+      g_value_set_uint (value, filter->detection_interval);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -519,11 +634,9 @@ gst_face_detect_set_caps (GstOpencvVideoFilter * transform, gint in_width,
 
   filter = GST_FACE_DETECT (transform);
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
-
-  filter->cvGray = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U,
-      1);
+  /* start over with a full search */
+  filter->prev_faces->clear ();
+  filter->frame_count = 0;
 
   return TRUE;
 }
@@ -552,23 +665,175 @@ gst_face_detect_message_new (GstFaceDetect * filter, GstBuffer * buf)
 static void
 gst_face_detect_run_detector (GstFaceDetect * filter,
     CascadeClassifier * detector, gint min_size_width,
-    gint min_size_height, Rect r, vector < Rect > &faces)
+    gint min_size_height, const Mat & img, Rect r, vector < Rect > &faces)
+{
+  Mat roi (img, r);
+
+  detector->detectMultiScale (roi, faces, filter->scale_factor,
+      filter->min_neighbors, filter->flags, cvSize (min_size_width,
+          min_size_height), cvSize (0, 0));
+}
+
+/* searches for faces in @img, which is the gray frame scaled by @scale.
+ * Every detection_interval frames the whole frame is searched, otherwise
+ * each face of the previous frame is searched for around its position. The
+ * faces are returned at full resolution. */
+static void
+gst_face_detect_find_faces (GstFaceDetect * filter, const Mat & img,
+    gdouble scale, vector < Rect > &faces)
+{
+  gint min_w = MAX (1, cvRound (filter->min_size_width * scale));
+  gint min_h = MAX (1, cvRound (filter->min_size_height * scale));
+  Rect bounds (0, 0, img.cols, img.rows);
+  vector < Rect > found;
+
+  faces.clear ();
+
+  if (filter->frame_count++ % filter->detection_interval == 0) {
+    gst_face_detect_run_detector (filter, filter->cvFaceDetect, min_w, min_h,
+        img, bounds, found);
+    for (size_t i = 0; i < found.size (); i++)
+      faces.push_back (found[i]);
+  } else {
+    for (size_t i = 0; i < filter->prev_faces->size (); i++) {
+      Rect p = (*filter->prev_faces)[i];
+      Rect r;
+      size_t best = 0;
+
+      /* half the size of the face around it, in the scaled image */
+      r.x = cvFloor ((p.x - p.width / 2) * scale);
+      r.y = cvFloor ((p.y - p.height / 2) * scale);
+      r.width = cvCeil (2 * p.width * scale);
+      r.height = cvCeil (2 * p.height * scale);
+      r &= bounds;
+      if (r.width < min_w || r.height < min_h)
+        continue;
+
+      gst_face_detect_run_detector (filter, filter->cvFaceDetect, min_w,
+          min_h, img, r, found);
+      if (found.empty ())
+        continue;
+
+      for (size_t j = 1; j < found.size (); j++)
+        if (found[j].area () > found[best].area ())
+          best = j;
+      faces.push_back (found[best] + r.tl ());
+    }
+  }
+
+  if (scale != 1.0) {
+    for (size_t i = 0; i < faces.size (); i++) {
+      Rect & r = faces[i];
+
+      r = Rect (cvRound (r.x / scale), cvRound (r.y / scale),
+          cvRound (r.width / scale), cvRound (r.height / scale));
+    }
+  }
+
+  *filter->prev_faces = faces;
+}
+
+/* the part of @face a feature is searched in */
+static Rect
+gst_face_detect_feature_roi (guint feature, const Rect & face)
 {
-  double img_stddev = 0;
-  if (filter->min_stddev > 0) {
-    CvScalar mean, stddev;
-    cvAvgSdv (filter->cvGray, &mean, &stddev, NULL);
-    img_stddev = stddev.val[0];
+  switch (feature) {
+    case FEATURE_NOSE:
+      return Rect (face.x + face.width / 4, face.y + face.height / 4,
+          face.width / 2, face.height / 2);
+    case FEATURE_MOUTH:
+      return Rect (face.x, face.y + face.height / 2, face.width,
+          face.height / 2);
+    case FEATURE_EYES:
+    default:
+      return Rect (face.x, face.y, face.width, face.height / 2);
   }
-  if (img_stddev >= filter->min_stddev) {
-    Mat roi (cv::cvarrToMat (filter->cvGray), r);
-    detector->detectMultiScale (roi, faces, filter->scale_factor,
-        filter->min_neighbors, filter->flags, cvSize (min_size_width,
-            min_size_height), cvSize (0, 0));
+}
+
+static void
+gst_face_detect_run_feature_task (GstFaceDetect * filter,
+    GstFaceDetectFeatureTask * task)
+{
+  for (size_t i = 0; i < task->faces->size (); i++) {
+    Rect r = task->rois[i] & Rect (0, 0, task->gray->cols, task->gray->rows);
+
+    if (r.width > 0 && r.height > 0)
+      gst_face_detect_run_detector (filter, task->detector, task->min_width,
+          task->min_height, *task->gray, r, task->results[i]);
+  }
+}
+
+static void
+gst_face_detect_feature_func (gpointer data, gpointer user_data)
+{
+  GstFaceDetect *filter = GST_FACE_DETECT (user_data);
+
+  gst_face_detect_run_feature_task (filter, (GstFaceDetectFeatureTask *) data);
+
+  g_mutex_lock (&filter->lock);
+  if (--filter->pending_tasks == 0)
+    g_cond_signal (&filter->cond);
+  g_mutex_unlock (&filter->lock);
+}
+
+/* detects the nose, mouth and eyes in all the @faces, in up to n-threads
+ * threads */
+static void
+gst_face_detect_find_features (GstFaceDetect * filter, const Mat & gray,
+    const vector < Rect > &faces, GstFaceDetectFeatureTask * tasks)
+{
+  CascadeClassifier *detectors[N_FEATURES] = { filter->cvNoseDetect,
+    filter->cvMouthDetect, filter->cvEyesDetect
+  };
+  GstFaceDetectFeatureTask *run[N_FEATURES];
+  guint n_run = 0, n_threads, i;
+
+  n_threads = filter->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  for (i = 0; i < N_FEATURES; i++) {
+    GstFaceDetectFeatureTask *task = &tasks[i];
+
+    task->detector = detectors[i];
+    task->gray = &gray;
+    task->faces = &faces;
+    task->min_width = filter->min_size_width / 8;
+    task->min_height = filter->min_size_height / 8;
+    task->rois.resize (faces.size ());
+    task->results.resize (faces.size ());
+    for (size_t j = 0; j < faces.size (); j++) {
+      task->rois[j] = gst_face_detect_feature_roi (i, faces[j]);
+      task->results[j].clear ();
+    }
+
+    if (task->detector && !faces.empty ())
+      run[n_run++] = task;
+  }
+
+  if (n_run == 0)
+    return;
+
+  n_threads = MIN (n_threads, n_run);
+  if (n_threads > 1) {
+    g_mutex_lock (&filter->lock);
+    filter->pending_tasks = n_run - 1;
+    g_mutex_unlock (&filter->lock);
+
+    /* the streaming thread handles as many tasks as each pool thread */
+    g_thread_pool_set_max_threads (filter->pool, n_threads - 1, NULL);
+    for (i = 1; i < n_run; i++)
+      g_thread_pool_push (filter->pool, run[i], NULL);
+
+    gst_face_detect_run_feature_task (filter, run[0]);
+
+    g_mutex_lock (&filter->lock);
+    while (filter->pending_tasks > 0)
+      g_cond_wait (&filter->cond, &filter->lock);
+    g_mutex_unlock (&filter->lock);
   } else {
-    GST_LOG_OBJECT (filter,
-        "Calculated stddev %f lesser than min_stddev %d, detection not performed",
-        img_stddev, filter->min_stddev);
+    for (i = 0; i < n_run; i++)
+      gst_face_detect_run_feature_task (filter, run[i]);
   }
 }
 
@@ -577,7 +842,7 @@ gst_face_detect_run_detector (GstFaceDetect * filter,
  */
 static GstFlowReturn
 gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img)
+    Mat & img)
 {
   GstFaceDetect *filter = GST_FACE_DETECT (base);
 
@@ -587,19 +852,43 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     GValue facelist = { 0 };
     GValue facedata = { 0 };
     vector < Rect > faces;
-    vector < Rect > mouth;
-    vector < Rect > nose;
-    vector < Rect > eyes;
+    GstFaceDetectFeatureTask tasks[N_FEATURES];
     gboolean post_msg = FALSE;
+    double img_stddev = 0;
+    Mat & gray = gst_opencv_video_filter_get_scratch (base, SCRATCH_GRAY,
+        img.cols, img.rows, CV_8UC1);
+
+    cvtColor (img, gray, CV_RGB2GRAY);
 
-    Mat mtxOrg (cv::cvarrToMat (img));
+    if (filter->min_stddev > 0) {
+      Scalar mean, stddev;
 
-    cvCvtColor (img, filter->cvGray, CV_RGB2GRAY);
+      meanStdDev (gray, mean, stddev);
+      img_stddev = stddev.val[0];
+    }
+
+    if (img_stddev >= filter->min_stddev) {
+      if (filter->detection_width > 0
+          && (guint) gray.cols > filter->detection_width) {
+        gdouble scale = (gdouble) filter->detection_width / gray.cols;
+        Mat & small = gst_opencv_video_filter_get_scratch (base,
+            SCRATCH_SMALL, filter->detection_width,
+            MAX (1, cvRound (gray.rows * scale)), CV_8UC1);
+
+        resize (gray, small, small.size (), 0, 0, INTER_AREA);
+        gst_face_detect_find_faces (filter, small,
+            (gdouble) small.cols / gray.cols, faces);
+      } else {
+        gst_face_detect_find_faces (filter, gray, 1.0, faces);
+      }
+    } else {
+      GST_LOG_OBJECT (filter,
+          "Calculated stddev %f lesser than min_stddev %d, detection not performed",
+          img_stddev, filter->min_stddev);
+      filter->prev_faces->clear ();
+    }
 
-    gst_face_detect_run_detector (filter, filter->cvFaceDetect,
-        filter->min_size_width, filter->min_size_height,
-        Rect (filter->cvGray->origin, filter->cvGray->origin,
-            filter->cvGray->width, filter->cvGray->height), faces);
+    gst_face_detect_find_features (filter, gray, faces, tasks);
 
     switch (filter->updates) {
       case GST_FACEDETECT_UPDATES_EVERY_FRAME:
@@ -639,51 +928,22 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
 
     for (unsigned int i = 0; i < faces.size (); ++i) {
       Rect r = faces[i];
-      guint mw = filter->min_size_width / 8;
-      guint mh = filter->min_size_height / 8;
-      guint rnx = 0, rny = 0, rnw, rnh;
-      guint rmx = 0, rmy = 0, rmw, rmh;
-      guint rex = 0, rey = 0, rew, reh;
-      guint rhh = r.height / 2;
+      const vector < Rect > &nose = tasks[FEATURE_NOSE].results[i];
+      const vector < Rect > &mouth = tasks[FEATURE_MOUTH].results[i];
+      const vector < Rect > &eyes = tasks[FEATURE_EYES].results[i];
+      /* the features are relative to the clipped search areas */
+      Rect frame (0, 0, img.cols, img.rows);
+      Rect rn = tasks[FEATURE_NOSE].rois[i] & frame;
+      Rect rm = tasks[FEATURE_MOUTH].rois[i] & frame;
+      Rect re = tasks[FEATURE_EYES].rois[i] & frame;
+      guint rnx = rn.x, rny = rn.y;
+      guint rmx = rm.x, rmy = rm.y;
+      guint rex = re.x, rey = re.y;
       gboolean have_nose, have_mouth, have_eyes;
 
-      /* detect face features */
-
-      if (filter->cvNoseDetect) {
-        rnx = r.x + r.width / 4;
-        rny = r.y + r.height / 4;
-        rnw = r.width / 2;
-        rnh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvNoseDetect, mw, mh,
-            Rect (rnx, rny, rnw, rnh), nose);
-        have_nose = !nose.empty ();
-      } else {
-        have_nose = FALSE;
-      }
-
-      if (filter->cvMouthDetect) {
-        rmx = r.x;
-        rmy = r.y + r.height / 2;
-        rmw = r.width;
-        rmh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvMouthDetect, mw,
-            mh, Rect (rmx, rmy, rmw, rmh), mouth);
-        have_mouth = !mouth.empty ();
-      } else {
-        have_mouth = FALSE;
-      }
-
-      if (filter->cvEyesDetect) {
-        rex = r.x;
-        rey = r.y;
-        rew = r.width;
-        reh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvEyesDetect, mw, mh,
-            Rect (rex, rey, rew, reh), eyes);
-        have_eyes = !eyes.empty ();
-      } else {
-        have_eyes = FALSE;
-      }
+      have_nose = !nose.empty ();
+      have_mouth = !mouth.empty ();
+      have_eyes = !eyes.empty ();
 
       GST_LOG_OBJECT (filter,
           "%2d/%2" G_GSIZE_FORMAT
@@ -724,7 +984,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
         center.y = cvRound ((r.y + h));
         axes.width = w;
         axes.height = h * 1.25; /* tweak for face form */
-        ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
+        ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
 
         if (have_nose) {
           Rect sr = nose[0];
@@ -735,7 +995,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
           center.y = cvRound ((rny + sr.y + h));
           axes.width = w;
           axes.height = h * 1.25;       /* tweak for nose form */
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
               0);
         }
         if (have_mouth) {
@@ -747,7 +1007,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
           center.y = cvRound ((rmy + sr.y + h));
           axes.width = w * 1.5; /* tweak for mouth form */
           axes.height = h;
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
               0);
         }
         if (have_eyes) {
@@ -759,7 +1019,7 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
           center.y = cvRound ((rey + sr.y + h));
           axes.width = w * 1.5; /* tweak for eyes form */
           axes.height = h;
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
               0);
         }
       }
@@ -773,7 +1033,6 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
       g_value_unset (&facelist);
       gst_element_post_message (GST_ELEMENT (filter), msg);
     }
-    mtxOrg.release ();
   }
 
   return GST_FLOW_OK;
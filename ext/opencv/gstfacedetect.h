@@ -48,6 +48,7 @@
 #ifndef __GST_FACE_DETECT_H__
 #define __GST_FACE_DETECT_H__
 
+#include <vector>
 #include <gst/gst.h>
 #include <opencv2/core/version.hpp>
 #include <cv.h>
@@ -103,8 +104,19 @@ struct _GstFaceDetect
   gint min_size_height;
   gint min_stddev;
   gint updates;
+  guint detection_width;
+  guint detection_interval;
+  guint n_threads;
+
+  /* the faces found in the previous frame, for tracking them */
+  std::vector<cv::Rect> *prev_faces;
+  guint frame_count;
+
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending_tasks;
 
-  IplImage *cvGray;
   cv::CascadeClassifier *cvFaceDetect;
   cv::CascadeClassifier *cvNoseDetect;
   cv::CascadeClassifier *cvMouthDetect;
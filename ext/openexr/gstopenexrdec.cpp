@@ -29,6 +29,7 @@
 
 #include <ImfRgbaFile.h>
 #include <ImfIO.h>
+#include <ImfThreading.h>
 using namespace Imf;
 using namespace Imath;
 
@@ -85,6 +86,23 @@ MemIStream::clear ()
 GST_DEBUG_CATEGORY_STATIC (gst_openexr_dec_debug);
 #define GST_CAT_DEFAULT gst_openexr_dec_debug
 
+enum
+{
+  PROP_0,
+  PROP_THREADS
+};
+
+#define DEFAULT_THREADS 1
+
+/* lines converted at once per decoding thread, enough to span a few of the
+ * line blocks of the compression methods */
+#define LINES_PER_THREAD 64
+
+static void gst_openexr_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_openexr_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_openexr_dec_start (GstVideoDecoder * decoder);
 static gboolean gst_openexr_dec_stop (GstVideoDecoder * decoder);
 static GstFlowReturn gst_openexr_dec_parse (GstVideoDecoder * decoder,
@@ -116,12 +134,31 @@ G_DEFINE_TYPE (GstOpenEXRDec, gst_openexr_dec, GST_TYPE_VIDEO_DECODER);
 static void
 gst_openexr_dec_class_init (GstOpenEXRDecClass * klass)
 {
+  GObjectClass *gobject_class;
   GstElementClass *element_class;
   GstVideoDecoderClass *video_decoder_class;
 
+  gobject_class = (GObjectClass *) klass;
   element_class = (GstElementClass *) klass;
   video_decoder_class = (GstVideoDecoderClass *) klass;
 
+  gobject_class->set_property = gst_openexr_dec_set_property;
+  gobject_class->get_property = gst_openexr_dec_get_property;
+
+  /**
+   * GstOpenEXRDec:threads:
+   *
+   * Number of threads decoding the lines of an image in parallel, using the
+   * global OpenEXR thread pool. 0 uses one thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_int ("threads", "Threads",
+          "Number of decoding threads (0 = automatic)", 0, 64,
+          DEFAULT_THREADS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
   gst_element_class_add_static_pad_template (element_class, &gst_openexr_dec_src_template);
   gst_element_class_add_static_pad_template (element_class, &gst_openexr_dec_sink_template);
 
@@ -152,6 +189,44 @@ gst_openexr_dec_init (GstOpenEXRDec * self)
   gst_video_decoder_set_use_default_pad_acceptcaps (GST_VIDEO_DECODER_CAST
       (self), TRUE);
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_VIDEO_DECODER_SINK_PAD (self));
+
+  self->threads = DEFAULT_THREADS;
+}
+
+static void
+gst_openexr_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstOpenEXRDec *self = GST_OPENEXR_DEC (object);
+
+  switch (prop_id) {
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->threads = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_openexr_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstOpenEXRDec *self = GST_OPENEXR_DEC (object);
+
+  switch (prop_id) {
+    case PROP_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -333,27 +408,42 @@ gst_openexr_dec_handle_frame (GstVideoDecoder * decoder,
     return GST_FLOW_ERROR;
   }
 
+  GST_OBJECT_LOCK (self);
+  gint threads = self->threads;
+  GST_OBJECT_UNLOCK (self);
+
+  if (threads == 0)
+    threads = g_get_num_processors ();
+
+  /* the decoding threads come from the global pool, only ever grow it as
+   * other users in the process might rely on its size */
+  if (threads > 1 && globalThreadCount () < threads)
+    setGlobalThreadCount (threads);
+
   /* Now read the file and catch any exceptions */
   MemIStream *istr;
   RgbaInputFile *file;
+  gchar *stream_id =
+      gst_pad_get_stream_id (GST_VIDEO_DECODER_SINK_PAD (decoder));
   try {
-    istr =
-        new
-        MemIStream (gst_pad_get_stream_id (GST_VIDEO_DECODER_SINK_PAD
-            (decoder)), map.data, map.size);
+    istr = new MemIStream (stream_id ? stream_id : "", map.data, map.size);
   }
   catch (Iex::BaseExc& e) {
+    g_free (stream_id);
+    gst_buffer_unmap (frame->input_buffer, &map);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
         ("Failed to create input stream"), (NULL));
     return GST_FLOW_ERROR;
   }
+  g_free (stream_id);
   try {
-    file = new RgbaInputFile (*istr);
+    file = new RgbaInputFile (*istr, threads > 1 ? threads : 0);
   }
   catch (Iex::BaseExc& e) {
     delete istr;
+    gst_buffer_unmap (frame->input_buffer, &map);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -397,44 +487,53 @@ gst_openexr_dec_handle_frame (GstVideoDecoder * decoder,
     return GST_FLOW_ERROR;
   }
 
-  /* Decode the file */
+  /* Decode the file a strip of lines at a time, converting each strip into
+   * the output frame while it is still in the cache instead of going through
+   * a copy of the whole image. The half floats can't be read into the
+   * ARGB64 frame directly as OpenEXR does not scale them to integers. */
   Box2i dw = file->dataWindow ();
   int width = dw.max.x - dw.min.x + 1;
   int height = dw.max.y - dw.min.y + 1;
-  Rgba *fb = new Rgba[width * height];
-
-  try {
-    file->setFrameBuffer (fb - dw.min.x - dw.min.y * width, 1, width);
-    file->readPixels (dw.min.y, dw.max.y);
-  } catch (Iex::BaseExc& e) {
-    delete[](fb);
-    delete file;
-    delete istr;
-    gst_buffer_unmap (frame->input_buffer, &map);
-    gst_video_frame_unmap (&vframe);
-
-    GST_ELEMENT_ERROR (self, CORE, FAILED, ("Failed to read pixels"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-
-  /* And convert from ARGB64_F16 to ARGB64 */
-  gint i, j;
+  int strip_height = MIN (height, LINES_PER_THREAD * MAX (threads, 1));
+  Rgba *fb = new Rgba[width * strip_height];
   guint16 *dest = (guint16 *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0);
   guint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0);
-  Rgba *ptr = fb;
-
-  /* TODO: Use displayWindow here and also support output of ARGB_F16
-   * and add a conversion filter element that can change exposure and
-   * other things */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      dest[4 * j + 0] = CLAMP (((float) ptr->a) * 65536, 0, 65535);
-      dest[4 * j + 1] = CLAMP (((float) ptr->r) * 65536, 0, 65535);
-      dest[4 * j + 2] = CLAMP (((float) ptr->g) * 65536, 0, 65535);
-      dest[4 * j + 3] = CLAMP (((float) ptr->b) * 65536, 0, 65535);
-      ptr++;
+  gint i, j, y;
+
+  for (y = dw.min.y; y <= dw.max.y; y += strip_height) {
+    int last = MIN (y + strip_height - 1, dw.max.y);
+
+    try {
+      file->setFrameBuffer (fb - dw.min.x - y * width, 1, width);
+      file->readPixels (y, last);
+    } catch (Iex::BaseExc& e) {
+      delete[](fb);
+      delete file;
+      delete istr;
+      gst_buffer_unmap (frame->input_buffer, &map);
+      gst_video_frame_unmap (&vframe);
+      gst_video_codec_frame_unref (frame);
+
+      GST_ELEMENT_ERROR (self, CORE, FAILED, ("Failed to read pixels"), (NULL));
+      return GST_FLOW_ERROR;
+    }
+
+    /* And convert from ARGB64_F16 to ARGB64 */
+    Rgba *ptr = fb;
+
+    /* TODO: Use displayWindow here and also support output of ARGB_F16
+     * and add a conversion filter element that can change exposure and
+     * other things */
+    for (i = y; i <= last; i++) {
+      for (j = 0; j < width; j++) {
+        dest[4 * j + 0] = CLAMP (((float) ptr->a) * 65536, 0, 65535);
+        dest[4 * j + 1] = CLAMP (((float) ptr->r) * 65536, 0, 65535);
+        dest[4 * j + 2] = CLAMP (((float) ptr->g) * 65536, 0, 65535);
+        dest[4 * j + 3] = CLAMP (((float) ptr->b) * 65536, 0, 65535);
+        ptr++;
+      }
+      dest += dstride / 2;
     }
-    dest += dstride / 2;
   }
 
   delete[](fb);
@@ -49,6 +49,8 @@ struct _GstOpenEXRDec
   /* < private > */
   GstVideoCodecState *input_state;
   GstVideoCodecState *output_state;
+
+  gint threads;
 };
 
 struct _GstOpenEXRDecClass
@@ -110,6 +110,8 @@ gst_openh264enc_slice_mode_get_type (void)
     {GST_OPENH264_SLICE_MODE_N_SLICES, "Fixed number of slices", "n-slices"},
     {GST_OPENH264_SLICE_MODE_AUTO,
         "Number of slices equal to number of threads", "auto"},
+    {GST_OPENH264_SLICE_MODE_SIZE_LIMITED,
+        "Slices limited to max-slice-size bytes", "size-limited"},
     {0, NULL, NULL},
   };
   static gsize id = 0;
@@ -183,6 +185,7 @@ static void gst_openh264enc_set_rate_control (GstOpenh264Enc * openh264enc,
 #define DEFAULT_COMPLEXITY      MEDIUM_COMPLEXITY
 #define DEFAULT_QP_MIN             0
 #define DEFAULT_QP_MAX             51
+#define DEFAULT_LOW_LATENCY        FALSE
 
 enum
 {
@@ -205,6 +208,7 @@ enum
   PROP_COMPLEXITY,
   PROP_QP_MIN,
   PROP_QP_MAX,
+  PROP_LOW_LATENCY,
   N_PROPERTIES
 };
 
@@ -324,7 +328,8 @@ gst_openh264enc_class_init (GstOpenh264EncClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_MAX_SLICE_SIZE,
       g_param_spec_uint ("max-slice-size", "Max slice size",
-          "The maximum size of one slice (in bytes).",
+          "The maximum size of one slice (in bytes, "
+          "needs slice-mode=size-limited)",
           0, G_MAXUINT, DEFAULT_MAX_SLICE_SIZE,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
@@ -365,6 +370,22 @@ gst_openh264enc_class_init (GstOpenh264EncClass * klass)
       g_param_spec_enum ("complexity", "Complexity / quality / speed tradeoff",
           "Complexity", GST_TYPE_OPENH264ENC_COMPLEXITY, DEFAULT_COMPLEXITY,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  /**
+   * GstOpenh264Enc:low-latency:
+   *
+   * Encode each picture as one slice per thread, so that all the threads
+   * work on the same picture instead of the encoder waiting for a full
+   * picture per thread, and only ever reference the previous picture.
+   * Overrides the number of slices of slice-mode=n-slices.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Use one slice per thread and a single reference frame",
+          DEFAULT_LOW_LATENCY,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
@@ -394,6 +415,7 @@ gst_openh264enc_init (GstOpenh264Enc * openh264enc)
   openh264enc->num_slices = DEFAULT_NUM_SLICES;
   openh264enc->encoder = NULL;
   openh264enc->complexity = DEFAULT_COMPLEXITY;
+  openh264enc->low_latency = DEFAULT_LOW_LATENCY;
   openh264enc->bitrate_changed = FALSE;
   openh264enc->max_bitrate_changed = FALSE;
   gst_openh264enc_set_usage_type (openh264enc, CAMERA_VIDEO_REAL_TIME);
@@ -529,6 +551,10 @@ gst_openh264enc_set_property (GObject * object, guint property_id,
       openh264enc->complexity = (ECOMPLEXITY_MODE) g_value_get_enum (value);
       break;
 
+    case PROP_LOW_LATENCY:
+      openh264enc->low_latency = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -616,6 +642,10 @@ gst_openh264enc_get_property (GObject * object, guint property_id,
       g_value_set_enum (value, openh264enc->complexity);
       break;
 
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, openh264enc->low_latency);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -681,8 +711,9 @@ gst_openh264enc_set_format (GstVideoEncoder * encoder,
   gchar *debug_caps;
   guint width, height, fps_n, fps_d;
   SEncParamExt enc_params;
+  GstOpenh264EncSliceMode gst_slice_mode;
   SliceModeEnum slice_mode = SM_SINGLE_SLICE;
-  guint n_slices = 1;
+  guint num_slices, n_slices = 1;
   gint ret;
   GstCaps *outcaps;
   GstVideoCodecState *output_state;
@@ -754,31 +785,59 @@ gst_openh264enc_set_format (GstVideoEncoder * encoder,
   enc_params.sSpatialLayers[0].iSpatialBitrate = enc_params.iTargetBitrate;
   enc_params.sSpatialLayers[0].iMaxSpatialBitrate = enc_params.iMaxBitrate;
 
-  if (openh264enc->slice_mode == GST_OPENH264_SLICE_MODE_N_SLICES) {
-    if (openh264enc->num_slices == 1)
+  if (openh264enc->low_latency) {
+    /* a single reference keeps the encoder from holding on to pictures */
+    enc_params.iNumRefFrame = 1;
+  }
+
+  gst_slice_mode = openh264enc->slice_mode;
+  num_slices = openh264enc->num_slices;
+  if (openh264enc->low_latency &&
+      gst_slice_mode == GST_OPENH264_SLICE_MODE_N_SLICES) {
+    /* one slice per thread, so that all of them encode the same picture */
+    if (openh264enc->multi_thread == 0)
+      gst_slice_mode = GST_OPENH264_SLICE_MODE_AUTO;
+    else
+      num_slices = openh264enc->multi_thread;
+  }
+
+  if (gst_slice_mode == GST_OPENH264_SLICE_MODE_N_SLICES) {
+    if (num_slices == 1)
       slice_mode = SM_SINGLE_SLICE;
     else
       slice_mode = SM_FIXEDSLCNUM_SLICE;
-    n_slices = openh264enc->num_slices;
-  } else if (openh264enc->slice_mode == GST_OPENH264_SLICE_MODE_AUTO) {
+    n_slices = num_slices;
+  } else if (gst_slice_mode == GST_OPENH264_SLICE_MODE_AUTO) {
 #if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
     slice_mode = SM_AUTO_SLICE;
 #else
     slice_mode = SM_FIXEDSLCNUM_SLICE;
     n_slices = 0;
 #endif
+  } else if (gst_slice_mode == GST_OPENH264_SLICE_MODE_SIZE_LIMITED) {
+#if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
+    slice_mode = SM_DYN_SLICE;
+#else
+    slice_mode = SM_SIZELIMITED_SLICE;
+#endif
+    n_slices = 0;
+    enc_params.uiMaxNalSize = openh264enc->max_slice_size;
   } else {
     GST_ERROR_OBJECT (openh264enc, "unexpected slice mode %d",
-        openh264enc->slice_mode);
+        gst_slice_mode);
     slice_mode = SM_SINGLE_SLICE;
   }
 
 #if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
   enc_params.sSpatialLayers[0].sSliceCfg.uiSliceMode = slice_mode;
   enc_params.sSpatialLayers[0].sSliceCfg.sSliceArgument.uiSliceNum = n_slices;
+  enc_params.sSpatialLayers[0].sSliceCfg.sSliceArgument.uiSliceSizeConstraint =
+      openh264enc->max_slice_size;
 #else
   enc_params.sSpatialLayers[0].sSliceArgument.uiSliceMode = slice_mode;
   enc_params.sSpatialLayers[0].sSliceArgument.uiSliceNum = n_slices;
+  enc_params.sSpatialLayers[0].sSliceArgument.uiSliceSizeConstraint =
+      openh264enc->max_slice_size;
 #endif
 
   openh264enc->framerate = (1 + fps_n / fps_d);
@@ -822,6 +881,7 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame)
 {
   GstOpenh264Enc *openh264enc = GST_OPENH264ENC (encoder);
+  SSourcePicture pic;
   SSourcePicture *src_pic = NULL;
   GstVideoFrame video_frame;
   gboolean force_keyframe;
@@ -864,14 +924,9 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   GST_OBJECT_UNLOCK (openh264enc);
 
   if (frame) {
-    src_pic = new SSourcePicture;
-
-    if (src_pic == NULL) {
-      if (frame)
-        gst_video_codec_frame_unref (frame);
-      return GST_FLOW_ERROR;
-    }
-    //fill default src_pic
+    /* the planes are passed to the encoder as mapped, without a copy */
+    memset (&pic, 0, sizeof (SSourcePicture));
+    src_pic = &pic;
     src_pic->iColorFormat = videoFormatI420;
     src_pic->uiTimeStamp = frame->pts / GST_MSECOND;
   }
@@ -894,8 +949,13 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   }
 
   if (frame) {
-    gst_video_frame_map (&video_frame, &openh264enc->input_state->info,
-        frame->input_buffer, GST_MAP_READ);
+    if (!gst_video_frame_map (&video_frame, &openh264enc->input_state->info,
+            frame->input_buffer, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (openh264enc, STREAM, ENCODE,
+          ("Could not map input frame"), (NULL));
+      gst_video_codec_frame_unref (frame);
+      return GST_FLOW_ERROR;
+    }
     src_pic->iPicWidth = GST_VIDEO_FRAME_WIDTH (&video_frame);
     src_pic->iPicHeight = GST_VIDEO_FRAME_HEIGHT (&video_frame);
     src_pic->iStride[0] = GST_VIDEO_FRAME_COMP_STRIDE (&video_frame, 0);
@@ -919,7 +979,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     if (frame) {
       gst_video_frame_unmap (&video_frame);
       gst_video_codec_frame_unref (frame);
-      delete src_pic;
       GST_ELEMENT_ERROR (openh264enc, STREAM, ENCODE,
           ("Could not encode frame"), ("Openh264 returned %d", ret));
       return GST_FLOW_ERROR;
@@ -932,7 +991,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     if (frame) {
       gst_video_frame_unmap (&video_frame);
       gst_video_encoder_finish_frame (encoder, frame);
-      delete src_pic;
     }
 
     return GST_FLOW_OK;
@@ -941,7 +999,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   if (frame) {
     gst_video_frame_unmap (&video_frame);
     gst_video_codec_frame_unref (frame);
-    delete src_pic;
     src_pic = NULL;
     frame = NULL;
   }
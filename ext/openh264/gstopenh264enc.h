@@ -50,6 +50,7 @@ typedef enum _GstOpenh264encDeblockingMode
 typedef enum
 {
   GST_OPENH264_SLICE_MODE_N_SLICES = 1,  /* SM_FIXEDSLCNUM_SLICE */
+  GST_OPENH264_SLICE_MODE_SIZE_LIMITED = 3, /* SM_SIZELIMITED_SLICE */
   GST_OPENH264_SLICE_MODE_AUTO = 5       /* former SM_AUTO_SLICE */
 } GstOpenh264EncSliceMode;
 
@@ -91,6 +92,7 @@ struct _GstOpenh264Enc
   GstOpenh264EncSliceMode slice_mode;
   guint num_slices;
   ECOMPLEXITY_MODE complexity;
+  gboolean low_latency;
   gboolean bitrate_changed;
   gboolean max_bitrate_changed;
 };
@@ -32,6 +32,24 @@
 GST_DEBUG_CATEGORY_STATIC (gst_openjpeg_dec_debug);
 #define GST_CAT_DEFAULT gst_openjpeg_dec_debug
 
+enum
+{
+  PROP_0,
+  PROP_FRAME_THREADS,
+#ifdef HAVE_OPENJPEG_2_2
+  PROP_MAX_THREADS,
+#endif
+};
+
+#define DEFAULT_FRAME_THREADS 1
+#define DEFAULT_MAX_THREADS 0
+
+static void gst_openjpeg_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_finalize (GObject * object);
+
 static gboolean gst_openjpeg_dec_start (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_stop (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
@@ -40,6 +58,11 @@ static GstFlowReturn gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame);
 static gboolean gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder,
     GstQuery * query);
+static gboolean gst_openjpeg_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_openjpeg_dec_drain (GstVideoDecoder * decoder);
+static GstFlowReturn gst_openjpeg_dec_finish_pending (GstOpenJPEGDec * self,
+    guint max_pending, gboolean discard);
+static void gst_openjpeg_dec_decode_func (gpointer data, gpointer user_data);
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define GRAY16 "GRAY16_LE"
@@ -73,12 +96,49 @@ G_DEFINE_TYPE (GstOpenJPEGDec, gst_openjpeg_dec, GST_TYPE_VIDEO_DECODER);
 static void
 gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
 {
+  GObjectClass *gobject_class;
   GstElementClass *element_class;
   GstVideoDecoderClass *video_decoder_class;
 
+  gobject_class = (GObjectClass *) klass;
   element_class = (GstElementClass *) klass;
   video_decoder_class = (GstVideoDecoderClass *) klass;
 
+  gobject_class->set_property = gst_openjpeg_dec_set_property;
+  gobject_class->get_property = gst_openjpeg_dec_get_property;
+  gobject_class->finalize = gst_openjpeg_dec_finalize;
+
+  /**
+   * GstOpenJPEGDec:frame-threads:
+   *
+   * Number of frames decoded in parallel, each on its own thread. Frames
+   * are still output in order, with a latency of one frame less than the
+   * number of threads. 0 uses one thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_THREADS,
+      g_param_spec_uint ("frame-threads", "Frame threads",
+          "Number of frames to decode in parallel (0 = one per processor)",
+          0, G_MAXINT, DEFAULT_FRAME_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+#ifdef HAVE_OPENJPEG_2_2
+  /**
+   * GstOpenJPEGDec:max-threads:
+   *
+   * Number of threads used by OpenJPEG to decode the code-blocks of the
+   * tiles of a single frame. 0 keeps the OpenJPEG default.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_THREADS,
+      g_param_spec_uint ("max-threads", "Maximum threads",
+          "Number of threads used to decode one frame (0 = OpenJPEG default)",
+          0, G_MAXINT, DEFAULT_MAX_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+#endif
+
   gst_element_class_add_static_pad_template (element_class,
       &gst_openjpeg_dec_src_template);
   gst_element_class_add_static_pad_template (element_class,
@@ -97,6 +157,9 @@ gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
   video_decoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_handle_frame);
   video_decoder_class->decide_allocation = gst_openjpeg_dec_decide_allocation;
+  video_decoder_class->flush = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_flush);
+  video_decoder_class->drain = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_drain);
+  video_decoder_class->finish = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_drain);
 
   GST_DEBUG_CATEGORY_INIT (gst_openjpeg_dec_debug, "openjpegdec", 0,
       "OpenJPEG Decoder");
@@ -117,6 +180,66 @@ gst_openjpeg_dec_init (GstOpenJPEGDec * self)
   self->params.cp_limit_decoding = NO_LIMITATION;
 #endif
   self->sampling = GST_JPEG2000_SAMPLING_NONE;
+
+  self->frame_threads = DEFAULT_FRAME_THREADS;
+  self->max_threads = DEFAULT_MAX_THREADS;
+  self->n_frame_threads = 1;
+  g_queue_init (&self->pending);
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+}
+
+static void
+gst_openjpeg_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_THREADS:
+      self->frame_threads = g_value_get_uint (value);
+      break;
+#ifdef HAVE_OPENJPEG_2_2
+    case PROP_MAX_THREADS:
+      self->max_threads = g_value_get_uint (value);
+      break;
+#endif
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_openjpeg_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_THREADS:
+      g_value_set_uint (value, self->frame_threads);
+      break;
+#ifdef HAVE_OPENJPEG_2_2
+    case PROP_MAX_THREADS:
+      g_value_set_uint (value, self->max_threads);
+      break;
+#endif
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_openjpeg_dec_finalize (GObject * object)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static gboolean
@@ -126,6 +249,26 @@ gst_openjpeg_dec_start (GstVideoDecoder * decoder)
 
   GST_DEBUG_OBJECT (self, "Starting");
 
+  self->n_frame_threads = self->frame_threads;
+  if (self->n_frame_threads == 0)
+    self->n_frame_threads = g_get_num_processors ();
+
+  if (self->n_frame_threads > 1) {
+    GError *err = NULL;
+
+    self->pool = g_thread_pool_new (gst_openjpeg_dec_decode_func, self,
+        self->n_frame_threads, FALSE, &err);
+    if (!self->pool) {
+      GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
+          ("Failed to create decoding threads"), ("%s", err->message));
+      g_clear_error (&err);
+      return FALSE;
+    }
+  }
+
+  GST_DEBUG_OBJECT (self, "Decoding %u frames in parallel",
+      self->n_frame_threads);
+
   return TRUE;
 }
 
@@ -136,6 +279,12 @@ gst_openjpeg_dec_stop (GstVideoDecoder * video_decoder)
 
   GST_DEBUG_OBJECT (self, "Stopping");
 
+  gst_openjpeg_dec_finish_pending (self, 0, TRUE);
+  if (self->pool) {
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+    self->pool = NULL;
+  }
+
   if (self->output_state) {
     gst_video_codec_state_unref (self->output_state);
     self->output_state = NULL;
@@ -195,6 +344,13 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     gst_video_codec_state_unref (self->input_state);
   self->input_state = gst_video_codec_state_ref (state);
 
+  if (self->n_frame_threads > 1 && state->info.fps_n > 0) {
+    GstClockTime latency = gst_util_uint64_scale (GST_SECOND,
+        (self->n_frame_threads - 1) * state->info.fps_d, state->info.fps_n);
+
+    gst_video_decoder_set_latency (decoder, latency, latency);
+  }
+
   return TRUE;
 }
 
@@ -943,6 +1099,9 @@ gst_openjpeg_dec_negotiate (GstOpenJPEGDec * self, opj_image_t * image)
       self->output_state->info.finfo->format != format ||
       self->output_state->info.width != width ||
       self->output_state->info.height != height) {
+    /* frames still being decoded need to go out with the previous caps */
+    gst_openjpeg_dec_finish_pending (self, 0, FALSE);
+
     if (self->output_state)
       gst_video_codec_state_unref (self->output_state);
     self->output_state =
@@ -1046,14 +1205,16 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
 }
 #endif
 
-static GstFlowReturn
-gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
-    GstVideoCodecFrame * frame)
+/* One frame being decoded. The codestream header is parsed, the caps
+ * negotiated and the output frame allocated from the streaming thread,
+ * while the actual decoding and the conversion into the output frame is
+ * done by a worker thread when frame threading is enabled */
+typedef struct
 {
-  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint64 deadline;
+  GstVideoCodecFrame *frame;
   GstMapInfo map;
+  gboolean input_mapped;
+
 #ifdef HAVE_OPENJPEG_1
   opj_dinfo_t *dec;
   opj_cio_t *io;
@@ -1063,7 +1224,141 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
   MemStream mstream;
 #endif
   opj_image_t *image;
+
   GstVideoFrame vframe;
+  gboolean output_mapped;
+  void (*fill_frame) (GstVideoFrame * frame, opj_image_t * image);
+
+  /* protected by the decoder lock */
+  gboolean done;
+  gboolean decoded;
+} GstOpenJPEGDecJob;
+
+static void
+gst_openjpeg_dec_job_free (GstOpenJPEGDecJob * job)
+{
+  if (job->output_mapped)
+    gst_video_frame_unmap (&job->vframe);
+
+  if (job->image)
+    opj_image_destroy (job->image);
+#ifdef HAVE_OPENJPEG_1
+  if (job->io)
+    opj_cio_close (job->io);
+  if (job->dec)
+    opj_destroy_decompress (job->dec);
+#else
+  if (job->stream)
+    opj_stream_destroy (job->stream);
+  if (job->dec)
+    opj_destroy_codec (job->dec);
+#endif
+
+  if (job->input_mapped)
+    gst_buffer_unmap (job->frame->input_buffer, &job->map);
+
+  g_slice_free (GstOpenJPEGDecJob, job);
+}
+
+/* called from the worker threads, nothing in here must touch the decoder
+ * state */
+static gboolean
+gst_openjpeg_dec_job_decode (GstOpenJPEGDecJob * job)
+{
+  gint i;
+
+#ifndef HAVE_OPENJPEG_1
+  if (!opj_decode (job->dec, job->stream, job->image))
+    return FALSE;
+
+  opj_end_decompress (job->dec, job->stream);
+#endif
+
+  for (i = 0; i < job->image->numcomps; i++) {
+    if (job->image->comps[i].data == NULL)
+      return FALSE;
+  }
+
+  job->fill_frame (&job->vframe, job->image);
+
+  return TRUE;
+}
+
+static void
+gst_openjpeg_dec_decode_func (gpointer data, gpointer user_data)
+{
+  GstOpenJPEGDecJob *job = data;
+  GstOpenJPEGDec *self = user_data;
+  gboolean decoded;
+
+  decoded = gst_openjpeg_dec_job_decode (job);
+
+  g_mutex_lock (&self->lock);
+  job->decoded = decoded;
+  job->done = TRUE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_finish_job (GstOpenJPEGDec * self, GstOpenJPEGDecJob * job,
+    gboolean discard)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstVideoCodecFrame *frame = job->frame;
+  gboolean decoded = job->decoded;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  gst_openjpeg_dec_job_free (job);
+
+  if (discard) {
+    gst_video_decoder_release_frame (decoder, frame);
+    return GST_FLOW_OK;
+  }
+
+  if (!decoded) {
+    gst_video_decoder_release_frame (decoder, frame);
+    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+        ("Failed to decode OpenJPEG stream"), (NULL), ret);
+    return ret;
+  }
+
+  return gst_video_decoder_finish_frame (decoder, frame);
+}
+
+/* Outputs the oldest pending frames, in decoding order, until at most
+ * @max_pending are left */
+static GstFlowReturn
+gst_openjpeg_dec_finish_pending (GstOpenJPEGDec * self, guint max_pending,
+    gboolean discard)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (g_queue_get_length (&self->pending) > max_pending) {
+    GstOpenJPEGDecJob *job = g_queue_pop_head (&self->pending);
+    GstFlowReturn job_ret;
+
+    g_mutex_lock (&self->lock);
+    while (!job->done)
+      g_cond_wait (&self->cond, &self->lock);
+    g_mutex_unlock (&self->lock);
+
+    job_ret = gst_openjpeg_dec_finish_job (self, job, discard);
+    if (ret == GST_FLOW_OK)
+      ret = job_ret;
+  }
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint64 deadline;
+  GstOpenJPEGDecJob *job;
   opj_dparameters_t params;
 
   GST_DEBUG_OBJECT (self, "Handling frame");
@@ -1076,8 +1371,11 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     return ret;
   }
 
-  dec = opj_create_decompress (self->codec_format);
-  if (!dec)
+  job = g_slice_new0 (GstOpenJPEGDecJob);
+  job->frame = frame;
+
+  job->dec = opj_create_decompress (self->codec_format);
+  if (!job->dec)
     goto initialization_error;
 
 #ifdef HAVE_OPENJPEG_1
@@ -1088,115 +1386,106 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     callbacks.error_handler = gst_openjpeg_dec_opj_error;
     callbacks.warning_handler = gst_openjpeg_dec_opj_warning;
     callbacks.info_handler = gst_openjpeg_dec_opj_info;
-    opj_set_event_mgr ((opj_common_ptr) dec, &callbacks, self);
+    opj_set_event_mgr ((opj_common_ptr) job->dec, &callbacks, self);
   } else {
-    opj_set_event_mgr ((opj_common_ptr) dec, NULL, NULL);
+    opj_set_event_mgr ((opj_common_ptr) job->dec, NULL, NULL);
   }
 #else
   if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
           GST_LEVEL_TRACE)) {
-    opj_set_info_handler (dec, gst_openjpeg_dec_opj_info, self);
-    opj_set_warning_handler (dec, gst_openjpeg_dec_opj_warning, self);
-    opj_set_error_handler (dec, gst_openjpeg_dec_opj_error, self);
+    opj_set_info_handler (job->dec, gst_openjpeg_dec_opj_info, self);
+    opj_set_warning_handler (job->dec, gst_openjpeg_dec_opj_warning, self);
+    opj_set_error_handler (job->dec, gst_openjpeg_dec_opj_error, self);
   } else {
-    opj_set_info_handler (dec, NULL, NULL);
-    opj_set_warning_handler (dec, NULL, NULL);
-    opj_set_error_handler (dec, NULL, NULL);
+    opj_set_info_handler (job->dec, NULL, NULL);
+    opj_set_warning_handler (job->dec, NULL, NULL);
+    opj_set_error_handler (job->dec, NULL, NULL);
   }
 #endif
 
   params = self->params;
   if (self->ncomps)
     params.jpwl_exp_comps = self->ncomps;
-  opj_setup_decoder (dec, &params);
+  opj_setup_decoder (job->dec, &params);
+
+#ifdef HAVE_OPENJPEG_2_2
+  if (self->max_threads > 0 &&
+      !opj_codec_set_threads (job->dec, self->max_threads))
+    GST_WARNING_OBJECT (self, "Failed to use %u threads", self->max_threads);
+#endif
 
-  if (!gst_buffer_map (frame->input_buffer, &map, GST_MAP_READ))
+  if (!gst_buffer_map (frame->input_buffer, &job->map, GST_MAP_READ))
     goto map_read_error;
+  job->input_mapped = TRUE;
 
-  if (self->is_jp2c && map.size < 8)
+  if (self->is_jp2c && job->map.size < 8)
     goto open_error;
 
 #ifdef HAVE_OPENJPEG_1
-  io = opj_cio_open ((opj_common_ptr) dec, map.data + (self->is_jp2c ? 8 : 0),
-      map.size - (self->is_jp2c ? 8 : 0));
-  if (!io)
+  /* OpenJPEG 1 can only decode the whole codestream in one go */
+  job->io = opj_cio_open ((opj_common_ptr) job->dec,
+      job->map.data + (self->is_jp2c ? 8 : 0),
+      job->map.size - (self->is_jp2c ? 8 : 0));
+  if (!job->io)
     goto open_error;
 
-  image = opj_decode (dec, io);
-  if (!image)
+  job->image = opj_decode (job->dec, job->io);
+  if (!job->image)
     goto decode_error;
 #else
-  stream = opj_stream_create (4096, OPJ_TRUE);
-  if (!stream)
+  job->stream = opj_stream_create (4096, OPJ_TRUE);
+  if (!job->stream)
     goto open_error;
 
-  mstream.data = map.data + (self->is_jp2c ? 8 : 0);
-  mstream.offset = 0;
-  mstream.size = map.size - (self->is_jp2c ? 8 : 0);
+  job->mstream.data = job->map.data + (self->is_jp2c ? 8 : 0);
+  job->mstream.offset = 0;
+  job->mstream.size = job->map.size - (self->is_jp2c ? 8 : 0);
 
-  opj_stream_set_read_function (stream, read_fn);
-  opj_stream_set_write_function (stream, write_fn);
-  opj_stream_set_skip_function (stream, skip_fn);
-  opj_stream_set_seek_function (stream, seek_fn);
+  opj_stream_set_read_function (job->stream, read_fn);
+  opj_stream_set_write_function (job->stream, write_fn);
+  opj_stream_set_skip_function (job->stream, skip_fn);
+  opj_stream_set_seek_function (job->stream, seek_fn);
 #ifdef HAVE_OPENJPEG_2_1
-  opj_stream_set_user_data (stream, &mstream, NULL);
+  opj_stream_set_user_data (job->stream, &job->mstream, NULL);
 #else
-  opj_stream_set_user_data (stream, &mstream);
+  opj_stream_set_user_data (job->stream, &job->mstream);
 #endif
-  opj_stream_set_user_data_length (stream, mstream.size);
+  opj_stream_set_user_data_length (job->stream, job->mstream.size);
 
-  image = NULL;
-  if (!opj_read_header (stream, dec, &image))
-    goto decode_error;
-
-  if (!opj_decode (dec, stream, image))
+  if (!opj_read_header (job->stream, job->dec, &job->image))
     goto decode_error;
 #endif
 
-  {
-    gint i;
-
-    for (i = 0; i < image->numcomps; i++) {
-      if (image->comps[i].data == NULL)
-        goto decode_error;
-    }
-  }
-
-  gst_buffer_unmap (frame->input_buffer, &map);
-
-  ret = gst_openjpeg_dec_negotiate (self, image);
+  /* the header is enough to know the output format */
+  ret = gst_openjpeg_dec_negotiate (self, job->image);
   if (ret != GST_FLOW_OK)
     goto negotiate_error;
+  job->fill_frame = self->fill_frame;
 
   ret = gst_video_decoder_allocate_output_frame (decoder, frame);
   if (ret != GST_FLOW_OK)
     goto allocate_error;
 
-  if (!gst_video_frame_map (&vframe, &self->output_state->info,
+  if (!gst_video_frame_map (&job->vframe, &self->output_state->info,
           frame->output_buffer, GST_MAP_WRITE))
     goto map_write_error;
+  job->output_mapped = TRUE;
 
-  self->fill_frame (&vframe, image);
+  g_queue_push_tail (&self->pending, job);
 
-  gst_video_frame_unmap (&vframe);
-
-#ifdef HAVE_OPENJPEG_1
-  opj_cio_close (io);
-  opj_image_destroy (image);
-  opj_destroy_decompress (dec);
-#else
-  opj_end_decompress (dec, stream);
-  opj_stream_destroy (stream);
-  opj_image_destroy (image);
-  opj_destroy_codec (dec);
-#endif
-
-  ret = gst_video_decoder_finish_frame (decoder, frame);
+  if (self->pool) {
+    g_thread_pool_push (self->pool, job, NULL);
+  } else {
+    job->decoded = gst_openjpeg_dec_job_decode (job);
+    job->done = TRUE;
+  }
 
-  return ret;
+  return gst_openjpeg_dec_finish_pending (self, self->n_frame_threads - 1,
+      FALSE);
 
 initialization_error:
   {
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
     GST_ELEMENT_ERROR (self, LIBRARY, INIT,
         ("Failed to initialize OpenJPEG decoder"), (NULL));
@@ -1204,11 +1493,7 @@ initialization_error:
   }
 map_read_error:
   {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_decompress (dec);
-#else
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1217,12 +1502,7 @@ map_read_error:
   }
 open_error:
   {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_decompress (dec);
-#else
-    opj_destroy_codec (dec);
-#endif
-    gst_buffer_unmap (frame->input_buffer, &map);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, LIBRARY, INIT,
@@ -1231,16 +1511,7 @@ open_error:
   }
 decode_error:
   {
-    if (image)
-      opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
-    gst_buffer_unmap (frame->input_buffer, &map);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
@@ -1249,14 +1520,7 @@ decode_error:
   }
 negotiate_error:
   {
-    opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
@@ -1265,14 +1529,7 @@ negotiate_error:
   }
 allocate_error:
   {
-    opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1281,14 +1538,7 @@ allocate_error:
   }
 map_write_error:
   {
-    opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1297,6 +1547,24 @@ map_write_error:
   }
 }
 
+static gboolean
+gst_openjpeg_dec_flush (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  gst_openjpeg_dec_finish_pending (self, 0, TRUE);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_drain (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  return gst_openjpeg_dec_finish_pending (self, 0, FALSE);
+}
+
 static gboolean
 gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 {
@@ -61,6 +61,16 @@ struct _GstOpenJPEGDec
   void (*fill_frame) (GstVideoFrame *frame, opj_image_t * image);
 
   opj_dparameters_t params;
+
+  guint frame_threads;
+  guint max_threads;
+
+  /* frames being decoded, in decoding order */
+  guint n_frame_threads;
+  GThreadPool *pool;
+  GQueue pending;
+  GMutex lock;
+  GCond cond;
 };
 
 struct _GstOpenJPEGDecClass
@@ -31,6 +31,10 @@
  * |[
  * gst-launch-1.0 -v filesrc location=opusdata ! opusparse ! opusdec ! audioconvert ! audioresample ! alsasink
  * ]| Decode and plays an unmuxed Opus file.
+ * |[
+ * gst-launch-1.0 -v udpsrc caps=application/x-rtp,media=audio,encoding-name=OPUS,clock-rate=48000 ! rtpopusdepay ! opusparse packet-duration=60000000 ! rtpopuspay ! udpsink host=127.0.0.1 port=5002
+ * ]| Combines the 20 ms packets received over RTP into 60 ms packets without
+ * decoding and reencoding them.
  *
  */
 
@@ -51,6 +55,17 @@ GST_DEBUG_CATEGORY_STATIC (opusparse_debug);
 
 #define MAX_PAYLOAD_BYTES 1500
 
+/* an Opus packet holds at most 120 ms, i.e. 5760 samples at 48 kHz */
+#define MAX_PACKET_SAMPLES 5760
+
+#define DEFAULT_PACKET_DURATION 0
+
+enum
+{
+  PROP_0,
+  PROP_PACKET_DURATION
+};
+
 static GstStaticPadTemplate opus_parse_src_factory =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -69,22 +84,52 @@ G_DEFINE_TYPE (GstOpusParse, gst_opus_parse, GST_TYPE_BASE_PARSE);
 
 static gboolean gst_opus_parse_start (GstBaseParse * parse);
 static gboolean gst_opus_parse_stop (GstBaseParse * parse);
+static gboolean gst_opus_parse_sink_event (GstBaseParse * parse,
+    GstEvent * event);
 static GstFlowReturn gst_opus_parse_handle_frame (GstBaseParse * base,
     GstBaseParseFrame * frame, gint * skip);
 static GstFlowReturn gst_opus_parse_parse_frame (GstBaseParse * base,
     GstBaseParseFrame * frame);
+static void gst_opus_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_opus_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static void
 gst_opus_parse_class_init (GstOpusParseClass * klass)
 {
+  GObjectClass *gobject_class;
   GstBaseParseClass *bpclass;
   GstElementClass *element_class;
 
+  gobject_class = (GObjectClass *) klass;
   bpclass = (GstBaseParseClass *) klass;
   element_class = (GstElementClass *) klass;
 
+  gobject_class->set_property = gst_opus_parse_set_property;
+  gobject_class->get_property = gst_opus_parse_get_property;
+
+  /**
+   * GstOpusParse:packet-duration:
+   *
+   * Duration of the output packets in nanoseconds. Consecutive packets are
+   * merged, or packets holding several frames are split, to get as close as
+   * possible to this duration without decoding the audio. Packets can only
+   * be combined when they use the same coding mode, bandwidth and frame
+   * size, and multistream packets are always passed through unchanged.
+   * 0 keeps the packets as they are.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PACKET_DURATION,
+      g_param_spec_uint64 ("packet-duration", "Packet duration",
+          "Duration of the output packets in nanoseconds, 0 to keep the "
+          "input packets", 0, 120 * GST_MSECOND, DEFAULT_PACKET_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   bpclass->start = GST_DEBUG_FUNCPTR (gst_opus_parse_start);
   bpclass->stop = GST_DEBUG_FUNCPTR (gst_opus_parse_stop);
+  bpclass->sink_event = GST_DEBUG_FUNCPTR (gst_opus_parse_sink_event);
   bpclass->handle_frame = GST_DEBUG_FUNCPTR (gst_opus_parse_handle_frame);
 
   gst_element_class_add_static_pad_template (element_class,
@@ -105,6 +150,53 @@ gst_opus_parse_init (GstOpusParse * parse)
   parse->header_sent = FALSE;
   parse->got_headers = FALSE;
   parse->pre_skip = 0;
+  parse->n_streams = 1;
+  parse->packet_duration = DEFAULT_PACKET_DURATION;
+  g_queue_init (&parse->pending);
+}
+
+static void
+gst_opus_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstOpusParse *parse = GST_OPUS_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_PACKET_DURATION:
+      GST_OBJECT_LOCK (parse);
+      parse->packet_duration = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_opus_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstOpusParse *parse = GST_OPUS_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_PACKET_DURATION:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_uint64 (value, parse->packet_duration);
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_opus_parse_clear_pending (GstOpusParse * parse)
+{
+  g_queue_foreach (&parse->pending, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&parse->pending);
+  parse->pending_frames = 0;
 }
 
 static gboolean
@@ -116,6 +208,13 @@ gst_opus_parse_start (GstBaseParse * base)
   parse->got_headers = FALSE;
   parse->pre_skip = 0;
   parse->next_ts = 0;
+  parse->n_streams = 1;
+
+  parse->repacketizer = opus_repacketizer_create ();
+  if (!parse->repacketizer) {
+    GST_ERROR_OBJECT (parse, "Failed to create the repacketizer");
+    return FALSE;
+  }
 
   return TRUE;
 }
@@ -129,9 +228,239 @@ gst_opus_parse_stop (GstBaseParse * base)
   parse->got_headers = FALSE;
   parse->pre_skip = 0;
 
+  gst_opus_parse_clear_pending (parse);
+  if (parse->repacketizer) {
+    opus_repacketizer_destroy (parse->repacketizer);
+    parse->repacketizer = NULL;
+  }
+
   return TRUE;
 }
 
+/* Builds one packet out of the first n_frames pending frames. The frames
+ * that are left over are kept as a single pending packet. */
+static GstBuffer *
+gst_opus_parse_take_pending (GstOpusParse * parse, guint n_frames)
+{
+  OpusRepacketizer *rp = parse->repacketizer;
+  GstMapInfo *maps, map;
+  GstBuffer *outbuf = NULL, *rest = NULL;
+  GstClockTime duration;
+  gsize maxlen = 0;
+  guint i, n_buffers;
+  gint total = 0, len;
+
+  n_buffers = g_queue_get_length (&parse->pending);
+  maps = g_new (GstMapInfo, n_buffers);
+
+  /* the repacketizer only references the data of the packets, so they have
+   * to stay mapped until the output packets are written */
+  opus_repacketizer_init (rp);
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = g_queue_peek_nth (&parse->pending, i);
+
+    gst_buffer_map (buf, &maps[i], GST_MAP_READ);
+    maxlen += maps[i].size;
+    if (opus_repacketizer_cat (rp, maps[i].data, maps[i].size) != OPUS_OK) {
+      GST_WARNING_OBJECT (parse, "Could not combine the pending packets");
+      n_buffers = i + 1;
+      goto done;
+    }
+  }
+
+  total = opus_repacketizer_get_nb_frames (rp);
+  n_frames = MIN (n_frames, total);
+
+  /* room for the TOC, the frame count and the frame lengths */
+  maxlen += 2 + 2 * total;
+
+  outbuf = gst_buffer_new_allocate (NULL, maxlen, NULL);
+  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+  len = opus_repacketizer_out_range (rp, 0, n_frames, map.data, maxlen);
+  gst_buffer_unmap (outbuf, &map);
+  if (len <= 0) {
+    GST_WARNING_OBJECT (parse, "Could not write a packet: %d", len);
+    gst_buffer_unref (outbuf);
+    outbuf = NULL;
+    goto done;
+  }
+  gst_buffer_set_size (outbuf, len);
+
+  if (n_frames < total) {
+    rest = gst_buffer_new_allocate (NULL, maxlen, NULL);
+    gst_buffer_map (rest, &map, GST_MAP_WRITE);
+    len = opus_repacketizer_out_range (rp, n_frames, total, map.data, maxlen);
+    gst_buffer_unmap (rest, &map);
+    if (len > 0) {
+      gst_buffer_set_size (rest, len);
+    } else {
+      GST_WARNING_OBJECT (parse, "Could not keep the remaining frames");
+      gst_buffer_unref (rest);
+      rest = NULL;
+    }
+  }
+
+  duration = gst_util_uint64_scale (n_frames * parse->pending_samples_per_frame,
+      GST_SECOND, 48000);
+  GST_BUFFER_TIMESTAMP (outbuf) = parse->pending_ts;
+  GST_BUFFER_DURATION (outbuf) = duration;
+  parse->pending_ts += duration;
+  GST_BUFFER_OFFSET_END (outbuf) =
+      gst_util_uint64_scale (parse->pending_ts, 48000, GST_SECOND);
+  GST_BUFFER_OFFSET (outbuf) = parse->pending_ts;
+
+  GST_LOG_OBJECT (parse, "Built a packet of %u frames, %" GST_TIME_FORMAT,
+      n_frames, GST_TIME_ARGS (duration));
+
+done:
+  for (i = 0; i < n_buffers; i++)
+    gst_buffer_unmap (g_queue_peek_nth (&parse->pending, i), &maps[i]);
+  g_free (maps);
+
+  gst_opus_parse_clear_pending (parse);
+  if (rest) {
+    g_queue_push_tail (&parse->pending, rest);
+    parse->pending_frames = total - n_frames;
+  }
+
+  return outbuf;
+}
+
+static GstFlowReturn
+gst_opus_parse_push_packet (GstOpusParse * parse, GstBuffer * buffer)
+{
+  GstBaseParseFrame *frame;
+  GstFlowReturn ret;
+
+  frame = gst_base_parse_frame_new (buffer, 0, 0);
+  frame->out_buffer = buffer;
+  ret = gst_base_parse_finish_frame (GST_BASE_PARSE (parse), frame, 0);
+  gst_base_parse_frame_free (frame);
+
+  return ret;
+}
+
+/* Pushes all pending frames as one packet, even if it is shorter than
+ * the configured duration */
+static GstFlowReturn
+gst_opus_parse_drain (GstOpusParse * parse)
+{
+  GstBuffer *outbuf;
+
+  if (parse->pending_frames == 0)
+    return GST_FLOW_OK;
+
+  outbuf = gst_opus_parse_take_pending (parse, parse->pending_frames);
+  if (!outbuf)
+    return GST_FLOW_OK;
+
+  return gst_opus_parse_push_packet (parse, outbuf);
+}
+
+static gboolean
+gst_opus_parse_sink_event (GstBaseParse * base, GstEvent * event)
+{
+  GstOpusParse *parse = GST_OPUS_PARSE (base);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      gst_opus_parse_drain (parse);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_opus_parse_clear_pending (parse);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_PARSE_CLASS (gst_opus_parse_parent_class)->sink_event (base,
+      event);
+}
+
+static gboolean
+gst_opus_parse_can_repacketize (GstOpusParse * parse,
+    GstBaseParseFrame * frame)
+{
+  GstClockTime packet_duration;
+
+  GST_OBJECT_LOCK (parse);
+  packet_duration = parse->packet_duration;
+  GST_OBJECT_UNLOCK (parse);
+
+  /* the clipping of the first and last packets can't be moved to other
+   * packets, and multistream packets would have to be split per stream */
+  return packet_duration > 0 && parse->header_sent && parse->n_streams == 1
+      && !(frame->flags & (GST_BASE_PARSE_FRAME_FLAG_DROP |
+          GST_BASE_PARSE_FRAME_FLAG_QUEUE))
+      && !gst_buffer_get_audio_clipping_meta (frame->buffer);
+}
+
+/* Queues the frames of the packet and pushes as many packets of the
+ * configured duration as they fill up */
+static GstFlowReturn
+gst_opus_parse_repacketize_frame (GstOpusParse * parse,
+    GstBaseParseFrame * frame, gsize size)
+{
+  GstBaseParse *base = GST_BASE_PARSE (parse);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime packet_duration;
+  GstMapInfo map;
+  GstBuffer *outbuf;
+  gint n_frames, samples_per_frame;
+  guint target;
+  guint8 toc;
+
+  gst_buffer_map (frame->buffer, &map, GST_MAP_READ);
+  n_frames = opus_packet_get_nb_frames (map.data, map.size);
+  samples_per_frame = opus_packet_get_samples_per_frame (map.data, 48000);
+  toc = map.data[0] & 0xfc;
+  gst_buffer_unmap (frame->buffer, &map);
+
+  if (n_frames <= 0) {
+    ret = gst_opus_parse_drain (parse);
+    if (ret == GST_FLOW_OK)
+      ret = gst_base_parse_finish_frame (base, frame, size);
+    return ret;
+  }
+
+  /* frames can only be combined if they share the TOC configuration, and
+   * a packet can't hold more than 120 ms */
+  if (parse->pending_frames > 0 && (toc != parse->pending_toc
+          || (parse->pending_frames + n_frames) * samples_per_frame >
+          MAX_PACKET_SAMPLES))
+    ret = gst_opus_parse_drain (parse);
+
+  if (parse->pending_frames == 0) {
+    parse->pending_toc = toc;
+    parse->pending_samples_per_frame = samples_per_frame;
+    parse->pending_ts = GST_BUFFER_TIMESTAMP (frame->buffer);
+  }
+  g_queue_push_tail (&parse->pending, gst_buffer_ref (frame->buffer));
+  parse->pending_frames += n_frames;
+
+  GST_OBJECT_LOCK (parse);
+  packet_duration = parse->packet_duration;
+  GST_OBJECT_UNLOCK (parse);
+
+  target = gst_util_uint64_scale (packet_duration, 48000, GST_SECOND) /
+      samples_per_frame;
+  target = CLAMP (target, 1, MAX_PACKET_SAMPLES / samples_per_frame);
+
+  while (ret == GST_FLOW_OK && parse->pending_frames >= target) {
+    outbuf = gst_opus_parse_take_pending (parse, target);
+    if (!outbuf)
+      break;
+    ret = gst_opus_parse_push_packet (parse, outbuf);
+  }
+
+  /* the input packet itself is replaced by the packets pushed above */
+  frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+  if (ret == GST_FLOW_OK)
+    ret = gst_base_parse_finish_frame (base, frame, size);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_opus_parse_handle_frame (GstBaseParse * base,
     GstBaseParseFrame * frame, gint * skip)
@@ -256,8 +585,16 @@ beach:
     frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
     ret = GST_FLOW_OK;
   }
-  if (ret == GST_FLOW_OK)
-    ret = gst_base_parse_finish_frame (base, frame, size);
+  if (ret == GST_FLOW_OK) {
+    if (gst_opus_parse_can_repacketize (parse, frame)) {
+      ret = gst_opus_parse_repacketize_frame (parse, frame, size);
+    } else {
+      /* keep the order of the packets */
+      ret = gst_opus_parse_drain (parse);
+      if (ret == GST_FLOW_OK)
+        ret = gst_base_parse_finish_frame (base, frame, size);
+    }
+  }
 
   return ret;
 }
@@ -397,6 +734,7 @@ gst_opus_parse_parse_frame (GstBaseParse * base, GstBaseParseFrame * frame)
       }
       if (sink_caps)
         gst_caps_unref (sink_caps);
+      parse->n_streams = n_streams;
 
       id_header =
           gst_codec_utils_opus_create_header (sample_rate, n_channels,
@@ -24,6 +24,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
+#include <opus.h>
 
 G_BEGIN_DECLS
 
@@ -49,6 +50,17 @@ struct _GstOpusParse {
   GstClockTime next_ts;
   GstBuffer *id_header;
   GstBuffer *comment_header;
+
+  guint8 n_streams;
+
+  /* repacketization */
+  GstClockTime packet_duration;
+  OpusRepacketizer *repacketizer;
+  GQueue pending;
+  guint pending_frames;
+  gint pending_samples_per_frame;
+  guint8 pending_toc;
+  GstClockTime pending_ts;
 };
 
 struct _GstOpusParseClass {
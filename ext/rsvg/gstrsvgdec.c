@@ -69,6 +69,7 @@ static GstFlowReturn gst_rsvg_dec_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame);
 static GstFlowReturn gst_rsvg_decode_image (GstRsvgDec * rsvg,
     GstBuffer * buffer, GstVideoCodecFrame * frame);
+static void gst_rsvg_decode_init_unpremultiply_table (void);
 
 static void gst_rsvg_dec_finalize (GObject * object);
 
@@ -81,6 +82,8 @@ gst_rsvg_dec_class_init (GstRsvgDecClass * klass)
 
   GST_DEBUG_CATEGORY_INIT (rsvgdec_debug, "rsvgdec", 0, "RSVG decoder");
 
+  gst_rsvg_decode_init_unpremultiply_table ();
+
   gst_element_class_set_static_metadata (element_class,
       "SVG image decoder", "Codec/Decoder/Image",
       "Uses librsvg to decode SVG images",
@@ -114,36 +117,89 @@ gst_rsvg_dec_finalize (GObject * object)
 }
 
 
-#define CAIRO_UNPREMULTIPLY(a,r,g,b) G_STMT_START { \
-  b = (a > 0) ? MIN ((b * 255 + a / 2) / a, 255) : 0; \
-  g = (a > 0) ? MIN ((g * 255 + a / 2) / a, 255) : 0; \
-  r = (a > 0) ? MIN ((r * 255 + a / 2) / a, 255) : 0; \
-} G_STMT_END
+/* unpremultiply_table[a][c] is the colour component c premultiplied with
+ * alpha a, restored to its straight value */
+static guint8 unpremultiply_table[256][256];
+
+static void
+gst_rsvg_decode_init_unpremultiply_table (void)
+{
+  guint a, c;
+
+  for (c = 0; c < 256; c++)
+    unpremultiply_table[0][c] = 0;
+  for (a = 1; a < 256; a++) {
+    for (c = 0; c < 256; c++)
+      unpremultiply_table[a][c] = MIN ((c * 255 + a / 2) / a, 255);
+  }
+}
 
 static void
-gst_rsvg_decode_unpremultiply (guint8 * data, gint width, gint height)
+gst_rsvg_decode_unpremultiply (guint8 * data, gint width, gint height,
+    gint stride)
 {
   gint i, j;
   guint a;
+  const guint8 *table;
+  guint8 *line;
 
   for (i = 0; i < height; i++) {
+    line = data;
     for (j = 0; j < width; j++) {
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
-      a = data[3];
-      data[0] = (a > 0) ? MIN ((data[0] * 255 + a / 2) / a, 255) : 0;
-      data[1] = (a > 0) ? MIN ((data[1] * 255 + a / 2) / a, 255) : 0;
-      data[2] = (a > 0) ? MIN ((data[2] * 255 + a / 2) / a, 255) : 0;
+      a = line[3];
+#else
+      a = line[0];
+#endif
+      /* opaque and fully transparent pixels are the common case of graphics
+       * and don't change, cairo already cleared the latter */
+      if (a != 255 && a != 0) {
+        table = unpremultiply_table[a];
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+        line[0] = table[line[0]];
+        line[1] = table[line[1]];
+        line[2] = table[line[2]];
 #else
-      a = data[0];
-      data[1] = (a > 0) ? MIN ((data[1] * 255 + a / 2) / a, 255) : 0;
-      data[2] = (a > 0) ? MIN ((data[2] * 255 + a / 2) / a, 255) : 0;
-      data[3] = (a > 0) ? MIN ((data[3] * 255 + a / 2) / a, 255) : 0;
+        line[1] = table[line[1]];
+        line[2] = table[line[2]];
+        line[3] = table[line[3]];
 #endif
-      data += 4;
+      }
+      line += 4;
     }
+    data += stride;
   }
 }
 
+/* Returns TRUE if @buffer holds the same SVG as the last rendered one */
+static gboolean
+gst_rsvg_decode_is_last_image (GstRsvgDec * rsvg, GstBuffer * buffer,
+    const GstMapInfo * minfo)
+{
+  GstMapInfo last;
+  gboolean same;
+
+  if (!rsvg->last_input || !rsvg->last_output)
+    return FALSE;
+
+  if (gst_buffer_get_size (rsvg->last_input) != minfo->size)
+    return FALSE;
+
+  if (!gst_buffer_map (rsvg->last_input, &last, GST_MAP_READ))
+    return FALSE;
+  same = memcmp (last.data, minfo->data, minfo->size) == 0;
+  gst_buffer_unmap (rsvg->last_input, &last);
+
+  return same;
+}
+
+static void
+gst_rsvg_decode_clear_last_image (GstRsvgDec * rsvg)
+{
+  gst_buffer_replace (&rsvg->last_input, NULL);
+  gst_buffer_replace (&rsvg->last_output, NULL);
+}
+
 static GstFlowReturn
 gst_rsvg_decode_image (GstRsvgDec * rsvg, GstBuffer * buffer,
     GstVideoCodecFrame * frame)
@@ -160,16 +216,28 @@ gst_rsvg_decode_image (GstRsvgDec * rsvg, GstBuffer * buffer,
   GstVideoFrame vframe;
   GstVideoCodecState *output_state;
 
-  GST_LOG_OBJECT (rsvg, "parsing svg");
-
   if (!gst_buffer_map (buffer, &minfo, GST_MAP_READ)) {
     GST_ERROR_OBJECT (rsvg, "Failed to get SVG image");
     return GST_FLOW_ERROR;
   }
+
+  /* overlays often push the same graphic again and again, the output
+   * buffer is shared and only its metadata gets copied for the new frame */
+  if (gst_rsvg_decode_is_last_image (rsvg, buffer, &minfo)) {
+    GST_LOG_OBJECT (rsvg, "same svg as before, reusing its rendering");
+    gst_buffer_unmap (buffer, &minfo);
+    frame->output_buffer = gst_buffer_ref (rsvg->last_output);
+    return GST_FLOW_OK;
+  }
+  gst_rsvg_decode_clear_last_image (rsvg);
+
+  GST_LOG_OBJECT (rsvg, "parsing svg");
+
   handle = rsvg_handle_new_from_data (minfo.data, minfo.size, &error);
   if (!handle) {
     GST_ERROR_OBJECT (rsvg, "Failed to parse SVG image: %s", error->message);
     g_error_free (error);
+    gst_buffer_unmap (buffer, &minfo);
     return GST_FLOW_ERROR;
   }
 
@@ -193,6 +261,7 @@ gst_rsvg_decode_image (GstRsvgDec * rsvg, GstBuffer * buffer,
   if (ret != GST_FLOW_OK) {
     g_object_unref (handle);
     gst_video_codec_state_unref (output_state);
+    gst_buffer_unmap (buffer, &minfo);
     GST_ERROR_OBJECT (rsvg, "Buffer allocation failed %s",
         gst_flow_get_name (ret));
     return ret;
@@ -208,6 +277,7 @@ gst_rsvg_decode_image (GstRsvgDec * rsvg, GstBuffer * buffer,
     GST_ERROR_OBJECT (rsvg, "Failed to get SVG image");
     g_object_unref (handle);
     gst_video_codec_state_unref (output_state);
+    gst_buffer_unmap (buffer, &minfo);
     return GST_FLOW_ERROR;
   }
   surface =
@@ -243,12 +313,16 @@ gst_rsvg_decode_image (GstRsvgDec * rsvg, GstBuffer * buffer,
 
   /* Now unpremultiply Cairo's ARGB to match GStreamer's */
   gst_rsvg_decode_unpremultiply (GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0),
-      GST_VIDEO_FRAME_WIDTH (&vframe), GST_VIDEO_FRAME_HEIGHT (&vframe));
+      GST_VIDEO_FRAME_WIDTH (&vframe), GST_VIDEO_FRAME_HEIGHT (&vframe),
+      GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0));
 
   gst_video_codec_state_unref (output_state);
   gst_buffer_unmap (buffer, &minfo);
   gst_video_frame_unmap (&vframe);
 
+  rsvg->last_input = gst_buffer_ref (buffer);
+  rsvg->last_output = gst_buffer_ref (frame->output_buffer);
+
   return ret;
 }
 
@@ -363,5 +437,7 @@ gst_rsvg_dec_stop (GstVideoDecoder * decoder)
     rsvg->input_state = NULL;
   }
 
+  gst_rsvg_decode_clear_last_image (rsvg);
+
   return TRUE;
 }
@@ -62,6 +62,11 @@ struct _GstRsvgDec
   gboolean need_newsegment;
 
   GstAdapter *adapter;
+
+  /* the last image and its rendering, reused when the same SVG comes in
+   * again */
+  GstBuffer *last_input;
+  GstBuffer *last_output;
 };
 
 struct _GstRsvgDecClass
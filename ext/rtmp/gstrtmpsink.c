@@ -33,6 +33,13 @@
  * gst-launch-1.0 -v videotestsrc ! ffenc_flv ! flvmux ! rtmpsink location='rtmp://localhost/path/to/stream live=1'
  * ]| Encode a test video stream to FLV video format and stream it via RTMP.
  *
+ * By default the data is written to the server from the streaming thread, so
+ * a stalling server stalls upstream as well. With #GstRTMPSink:max-queue-bytes
+ * set, the data is queued and written by a separate thread instead. When the
+ * queue would grow beyond that size, queued video frames are dropped from the
+ * oldest on, each time along with the frames depending on them up to the next
+ * key frame, while audio is kept. If that doesn't make enough room, the
+ * oldest buffers are dropped.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -49,15 +56,26 @@
 
 #include <stdlib.h>
 
+#ifdef G_OS_WIN32
+#define SHUT_RDWR SD_BOTH
+#else
+#include <sys/socket.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_rtmp_sink_debug);
 #define GST_CAT_DEFAULT gst_rtmp_sink_debug
 
 #define DEFAULT_LOCATION NULL
+#define DEFAULT_MAX_QUEUE_BYTES 0
+
+#define FLV_TAG_TYPE_VIDEO 9
 
 enum
 {
   PROP_0,
-  PROP_LOCATION
+  PROP_LOCATION,
+  PROP_MAX_QUEUE_BYTES,
+  PROP_STATS
 };
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -76,8 +94,11 @@ static void gst_rtmp_sink_finalize (GObject * object);
 static gboolean gst_rtmp_sink_stop (GstBaseSink * sink);
 static gboolean gst_rtmp_sink_start (GstBaseSink * sink);
 static gboolean gst_rtmp_sink_event (GstBaseSink * sink, GstEvent * event);
+static gboolean gst_rtmp_sink_unlock (GstBaseSink * sink);
+static gboolean gst_rtmp_sink_unlock_stop (GstBaseSink * sink);
 static gboolean gst_rtmp_sink_setcaps (GstBaseSink * sink, GstCaps * caps);
 static GstFlowReturn gst_rtmp_sink_render (GstBaseSink * sink, GstBuffer * buf);
+static gpointer gst_rtmp_sink_io_thread (GstRTMPSink * sink);
 
 #define gst_rtmp_sink_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstRTMPSink, gst_rtmp_sink, GST_TYPE_BASE_SINK,
@@ -104,6 +125,34 @@ gst_rtmp_sink_class_init (GstRTMPSinkClass * klass)
       g_param_spec_string ("location", "RTMP Location", "RTMP url",
           DEFAULT_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTMPSink:max-queue-bytes:
+   *
+   * Maximum number of bytes queued for a separate thread to send, or 0 to
+   * send from the streaming thread.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_BYTES,
+      g_param_spec_uint ("max-queue-bytes", "Max queue bytes",
+          "Maximum number of bytes queued for sending before buffers are "
+          "dropped (0 = send synchronously)", 0, G_MAXUINT,
+          DEFAULT_MAX_QUEUE_BYTES,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTMPSink:stats:
+   *
+   * Statistics of the send queue: "queued-bytes", "sent-buffers",
+   * "sent-bytes", "dropped-buffers" and "dropped-bytes".
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "Send queue statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "RTMP output sink",
       "Sink/Network", "Sends FLV content to a server via RTMP",
@@ -116,6 +165,9 @@ gst_rtmp_sink_class_init (GstRTMPSinkClass * klass)
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_rtmp_sink_render);
   gstbasesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_rtmp_sink_setcaps);
   gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_rtmp_sink_event);
+  gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_rtmp_sink_unlock);
+  gstbasesink_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_rtmp_sink_unlock_stop);
 
   GST_DEBUG_CATEGORY_INIT (gst_rtmp_sink_debug, "rtmpsink", 0,
       "RTMP server element");
@@ -134,6 +186,11 @@ gst_rtmp_sink_init (GstRTMPSink * sink)
     GST_ERROR_OBJECT (sink, "WSAStartup failed: 0x%08x", WSAGetLastError ());
   }
 #endif
+
+  sink->max_queue_bytes = DEFAULT_MAX_QUEUE_BYTES;
+  g_mutex_init (&sink->lock);
+  g_cond_init (&sink->cond);
+  g_queue_init (&sink->queue);
 }
 
 static void
@@ -145,6 +202,8 @@ gst_rtmp_sink_finalize (GObject * object)
   WSACleanup ();
 #endif
   g_free (sink->uri);
+  g_mutex_clear (&sink->lock);
+  g_cond_clear (&sink->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -184,6 +243,20 @@ gst_rtmp_sink_start (GstBaseSink * basesink)
   sink->first = TRUE;
   sink->have_write_error = FALSE;
 
+  sink->queued_bytes = 0;
+  sink->flushing = FALSE;
+  sink->drop_delta = FALSE;
+  sink->sending = FALSE;
+  sink->io_ret = GST_FLOW_OK;
+  sink->sent_buffers = sink->sent_bytes = 0;
+  sink->dropped_buffers = sink->dropped_bytes = 0;
+
+  if (sink->max_queue_bytes > 0) {
+    sink->running = TRUE;
+    sink->thread = g_thread_new ("rtmpsink",
+        (GThreadFunc) gst_rtmp_sink_io_thread, sink);
+  }
+
   return TRUE;
 
 error:
@@ -201,6 +274,23 @@ gst_rtmp_sink_stop (GstBaseSink * basesink)
 {
   GstRTMPSink *sink = GST_RTMP_SINK (basesink);
 
+  if (sink->thread) {
+    g_mutex_lock (&sink->lock);
+    sink->running = FALSE;
+    /* unblock a write to a stalled server */
+    if (sink->rtmp && RTMP_IsConnected (sink->rtmp))
+      shutdown (RTMP_Socket (sink->rtmp), SHUT_RDWR);
+    g_cond_broadcast (&sink->cond);
+    g_mutex_unlock (&sink->lock);
+
+    g_thread_join (sink->thread);
+    sink->thread = NULL;
+
+    g_queue_foreach (&sink->queue, (GFunc) gst_buffer_unref, NULL);
+    g_queue_clear (&sink->queue);
+    sink->queued_bytes = 0;
+  }
+
   if (sink->header) {
     gst_buffer_unref (sink->header);
     sink->header = NULL;
@@ -218,52 +308,65 @@ gst_rtmp_sink_stop (GstBaseSink * basesink)
   return TRUE;
 }
 
+/* Connects on the first buffer and writes it, either from the streaming
+ * thread or from the I/O thread. In the latter case, the RTMP context is
+ * shared with stop() and the header with setcaps(), so they are only
+ * accessed with the lock. */
 static GstFlowReturn
-gst_rtmp_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+gst_rtmp_sink_send (GstRTMPSink * sink, GstBuffer * buf)
 {
-  GstRTMPSink *sink = GST_RTMP_SINK (bsink);
   gboolean need_unref = FALSE;
   GstMapInfo map = GST_MAP_INFO_INIT;
-
-  if (sink->rtmp == NULL) {
+  GstBuffer *header = NULL;
+  gboolean first, have_write_error;
+  RTMP *rtmp;
+
+  g_mutex_lock (&sink->lock);
+  rtmp = sink->rtmp;
+  first = sink->first;
+  have_write_error = sink->have_write_error;
+  if (rtmp && first && sink->header)
+    header = gst_buffer_ref (sink->header);
+  g_mutex_unlock (&sink->lock);
+
+  if (rtmp == NULL) {
     /* Do not crash */
     GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL), ("Failed to write data"));
     return GST_FLOW_ERROR;
   }
 
-  /* Ignore buffers that are in the stream headers (caps) */
-  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER)) {
-    return GST_FLOW_OK;
-  }
-
-  if (sink->first) {
+  if (first) {
     /* open the connection */
-    if (!RTMP_IsConnected (sink->rtmp)) {
-      if (!RTMP_Connect (sink->rtmp, NULL)
-          || !RTMP_ConnectStream (sink->rtmp, 0)) {
+    if (!RTMP_IsConnected (rtmp)) {
+      if (!RTMP_Connect (rtmp, NULL) || !RTMP_ConnectStream (rtmp, 0)) {
         GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
             ("Could not connect to RTMP stream \"%s\" for writing", sink->uri));
+        g_mutex_lock (&sink->lock);
         RTMP_Free (sink->rtmp);
         sink->rtmp = NULL;
         g_free (sink->rtmp_uri);
         sink->rtmp_uri = NULL;
         sink->have_write_error = TRUE;
+        g_mutex_unlock (&sink->lock);
+        if (header)
+          gst_buffer_unref (header);
         return GST_FLOW_ERROR;
       }
       GST_DEBUG_OBJECT (sink, "Opened connection to %s", sink->rtmp_uri);
     }
 
     /* Prepend the header from the caps to the first non header buffer */
-    if (sink->header) {
-      buf = gst_buffer_append (gst_buffer_ref (sink->header),
-          gst_buffer_ref (buf));
+    if (header) {
+      buf = gst_buffer_append (header, gst_buffer_ref (buf));
       need_unref = TRUE;
     }
 
+    g_mutex_lock (&sink->lock);
     sink->first = FALSE;
+    g_mutex_unlock (&sink->lock);
   }
 
-  if (sink->have_write_error)
+  if (have_write_error)
     goto write_failed;
 
   GST_LOG_OBJECT (sink, "Sending %" G_GSIZE_FORMAT " bytes to RTMP server",
@@ -271,7 +374,7 @@ gst_rtmp_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 
   gst_buffer_map (buf, &map, GST_MAP_READ);
 
-  if (RTMP_Write (sink->rtmp, (char *) map.data, map.size) <= 0)
+  if (RTMP_Write (rtmp, (char *) map.data, map.size) <= 0)
     goto write_failed;
 
   gst_buffer_unmap (buf, &map);
@@ -287,11 +390,241 @@ write_failed:
     gst_buffer_unmap (buf, &map);
     if (need_unref)
       gst_buffer_unref (buf);
+    g_mutex_lock (&sink->lock);
     sink->have_write_error = TRUE;
+    g_mutex_unlock (&sink->lock);
     return GST_FLOW_ERROR;
   }
 }
 
+static gpointer
+gst_rtmp_sink_io_thread (GstRTMPSink * sink)
+{
+  GstFlowReturn ret;
+  GstBuffer *buf;
+  gsize size;
+
+  g_mutex_lock (&sink->lock);
+  while (sink->running) {
+    buf = g_queue_pop_head (&sink->queue);
+    if (!buf) {
+      g_cond_wait (&sink->cond, &sink->lock);
+      continue;
+    }
+
+    size = gst_buffer_get_size (buf);
+    sink->queued_bytes -= size;
+    sink->sending = TRUE;
+    g_cond_broadcast (&sink->cond);
+    g_mutex_unlock (&sink->lock);
+
+    ret = gst_rtmp_sink_send (sink, buf);
+    gst_buffer_unref (buf);
+
+    g_mutex_lock (&sink->lock);
+    sink->sending = FALSE;
+    g_cond_broadcast (&sink->cond);
+    if (ret != GST_FLOW_OK) {
+      sink->io_ret = ret;
+      g_cond_broadcast (&sink->cond);
+      break;
+    }
+    sink->sent_buffers++;
+    sink->sent_bytes += size;
+  }
+  g_mutex_unlock (&sink->lock);
+
+  return NULL;
+}
+
+static gboolean
+gst_rtmp_sink_is_video (GstBuffer * buf)
+{
+  guint8 tag_type;
+
+  return gst_buffer_extract (buf, 0, &tag_type, 1) == 1 &&
+      (tag_type & 0x1f) == FLV_TAG_TYPE_VIDEO;
+}
+
+static gboolean
+gst_rtmp_sink_is_video_key_frame (GstBuffer * buf)
+{
+  return !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT) &&
+      gst_rtmp_sink_is_video (buf);
+}
+
+/* flvmux also marks audio as delta units when there is video, so only
+ * video frames are checked for the frames they depend on */
+static gboolean
+gst_rtmp_sink_is_video_delta (GstBuffer * buf)
+{
+  return GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT) &&
+      gst_rtmp_sink_is_video (buf);
+}
+
+static void
+gst_rtmp_sink_drop (GstRTMPSink * sink, GstBuffer * buf)
+{
+  sink->dropped_buffers++;
+  sink->dropped_bytes += gst_buffer_get_size (buf);
+  gst_buffer_unref (buf);
+}
+
+static gboolean
+gst_rtmp_sink_has_room (GstRTMPSink * sink, gsize size)
+{
+  return sink->queued_bytes + size <= sink->max_queue_bytes;
+}
+
+/* Called with the lock, makes room for @size more bytes in the queue */
+static void
+gst_rtmp_sink_make_room (GstRTMPSink * sink, gsize size)
+{
+  GList *l, *next;
+  GstBuffer *buf;
+  guint64 dropped = sink->dropped_buffers;
+  gboolean dropping = FALSE, dropped_video = FALSE;
+
+  if (gst_rtmp_sink_has_room (sink, size))
+    return;
+
+  /* Drop video frames from the oldest on, each time up to the next key
+   * frame, as the frames in between can't be decoded anymore. Audio and
+   * key frames are kept. */
+  for (l = sink->queue.head; l; l = next) {
+    next = l->next;
+    buf = l->data;
+
+    if (!gst_rtmp_sink_is_video (buf))
+      continue;
+
+    if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+      dropping = FALSE;
+      continue;
+    }
+
+    if (!dropping) {
+      if (gst_rtmp_sink_has_room (sink, size))
+        break;
+      dropping = TRUE;
+    }
+
+    sink->queued_bytes -= gst_buffer_get_size (buf);
+    g_queue_delete_link (&sink->queue, l);
+    gst_rtmp_sink_drop (sink, buf);
+  }
+  /* The frames following the last ones dropped have to go as well */
+  if (dropping)
+    sink->drop_delta = TRUE;
+
+  while (!gst_rtmp_sink_has_room (sink, size) &&
+      (buf = g_queue_pop_head (&sink->queue))) {
+    if (gst_rtmp_sink_is_video (buf))
+      dropped_video = TRUE;
+    sink->queued_bytes -= gst_buffer_get_size (buf);
+    gst_rtmp_sink_drop (sink, buf);
+  }
+
+  /* Without a key frame left, the next video frames can't be decoded */
+  if (dropped_video && !sink->drop_delta) {
+    sink->drop_delta = TRUE;
+    for (l = sink->queue.head; l; l = l->next) {
+      if (gst_rtmp_sink_is_video_key_frame (l->data)) {
+        sink->drop_delta = FALSE;
+        break;
+      }
+    }
+  }
+
+  GST_WARNING_OBJECT (sink, "send queue full, dropped %" G_GUINT64_FORMAT
+      " buffers", sink->dropped_buffers - dropped);
+}
+
+static GstFlowReturn
+gst_rtmp_sink_queue (GstRTMPSink * sink, GstBuffer * buf)
+{
+  GstFlowReturn ret;
+  gsize size = gst_buffer_get_size (buf);
+  gboolean video_delta = gst_rtmp_sink_is_video_delta (buf);
+
+  g_mutex_lock (&sink->lock);
+  ret = sink->io_ret;
+  if (ret != GST_FLOW_OK)
+    goto done;
+
+  if (sink->drop_delta && gst_rtmp_sink_is_video_key_frame (buf))
+    sink->drop_delta = FALSE;
+
+  if (!sink->drop_delta || !video_delta)
+    gst_rtmp_sink_make_room (sink, size);
+
+  if (sink->drop_delta && video_delta) {
+    gst_rtmp_sink_drop (sink, gst_buffer_ref (buf));
+    goto done;
+  }
+
+  g_queue_push_tail (&sink->queue, gst_buffer_ref (buf));
+  sink->queued_bytes += size;
+  g_cond_broadcast (&sink->cond);
+
+done:
+  g_mutex_unlock (&sink->lock);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_rtmp_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (bsink);
+
+  /* Ignore buffers that are in the stream headers (caps) */
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER)) {
+    return GST_FLOW_OK;
+  }
+
+  if (sink->thread)
+    return gst_rtmp_sink_queue (sink, buf);
+
+  return gst_rtmp_sink_send (sink, buf);
+}
+
+/* Waits for the queue and the buffer being written to be sent, for EOS */
+static void
+gst_rtmp_sink_drain (GstRTMPSink * sink)
+{
+  g_mutex_lock (&sink->lock);
+  while (sink->running && !sink->flushing && sink->io_ret == GST_FLOW_OK &&
+      (!g_queue_is_empty (&sink->queue) || sink->sending))
+    g_cond_wait (&sink->cond, &sink->lock);
+  g_mutex_unlock (&sink->lock);
+}
+
+static gboolean
+gst_rtmp_sink_unlock (GstBaseSink * basesink)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (basesink);
+
+  g_mutex_lock (&sink->lock);
+  sink->flushing = TRUE;
+  g_cond_broadcast (&sink->cond);
+  g_mutex_unlock (&sink->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtmp_sink_unlock_stop (GstBaseSink * basesink)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (basesink);
+
+  g_mutex_lock (&sink->lock);
+  sink->flushing = FALSE;
+  g_mutex_unlock (&sink->lock);
+
+  return TRUE;
+}
+
 /*
  * URI interface support.
  */
@@ -386,6 +719,9 @@ gst_rtmp_sink_set_property (GObject * object, guint prop_id,
       gst_rtmp_sink_uri_set_uri (GST_URI_HANDLER (sink),
           g_value_get_string (value), NULL);
       break;
+    case PROP_MAX_QUEUE_BYTES:
+      sink->max_queue_bytes = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -401,15 +737,11 @@ gst_rtmp_sink_setcaps (GstBaseSink * sink, GstCaps * caps)
   GArray *buffers;
   gint i;
 
-  GST_DEBUG_OBJECT (sink, "caps set to %" GST_PTR_FORMAT, caps);
+  GstBuffer *header, *old_header;
 
-  /* Clear our current header buffer */
-  if (rtmpsink->header) {
-    gst_buffer_unref (rtmpsink->header);
-    rtmpsink->header = NULL;
-  }
+  GST_DEBUG_OBJECT (sink, "caps set to %" GST_PTR_FORMAT, caps);
 
-  rtmpsink->header = gst_buffer_new ();
+  header = gst_buffer_new ();
 
   s = gst_caps_get_structure (caps, 0);
 
@@ -426,11 +758,20 @@ gst_rtmp_sink_setcaps (GstBaseSink * sink, GstCaps * caps)
 
     gst_buffer_ref (buf);
 
-    rtmpsink->header = gst_buffer_append (rtmpsink->header, buf);
+    header = gst_buffer_append (header, buf);
   }
 
   GST_DEBUG_OBJECT (rtmpsink, "have %" G_GSIZE_FORMAT " bytes of header data",
-      gst_buffer_get_size (rtmpsink->header));
+      gst_buffer_get_size (header));
+
+  /* The I/O thread might be sending the first buffer */
+  g_mutex_lock (&rtmpsink->lock);
+  old_header = rtmpsink->header;
+  rtmpsink->header = header;
+  g_mutex_unlock (&rtmpsink->lock);
+
+  if (old_header)
+    gst_buffer_unref (old_header);
 
   return TRUE;
 }
@@ -442,7 +783,21 @@ gst_rtmp_sink_event (GstBaseSink * sink, GstEvent * event)
 
   switch (event->type) {
     case GST_EVENT_FLUSH_STOP:
+      g_mutex_lock (&rtmpsink->lock);
       rtmpsink->have_write_error = FALSE;
+      g_mutex_unlock (&rtmpsink->lock);
+      if (rtmpsink->thread) {
+        g_mutex_lock (&rtmpsink->lock);
+        g_queue_foreach (&rtmpsink->queue, (GFunc) gst_buffer_unref, NULL);
+        g_queue_clear (&rtmpsink->queue);
+        rtmpsink->queued_bytes = 0;
+        rtmpsink->drop_delta = FALSE;
+        g_mutex_unlock (&rtmpsink->lock);
+      }
+      break;
+    case GST_EVENT_EOS:
+      if (rtmpsink->thread)
+        gst_rtmp_sink_drain (rtmpsink);
       break;
     default:
       break;
@@ -461,6 +816,19 @@ gst_rtmp_sink_get_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       g_value_set_string (value, sink->uri);
       break;
+    case PROP_MAX_QUEUE_BYTES:
+      g_value_set_uint (value, sink->max_queue_bytes);
+      break;
+    case PROP_STATS:
+      g_mutex_lock (&sink->lock);
+      g_value_take_boxed (value, gst_structure_new ("application/x-rtmp-stats",
+              "queued-bytes", G_TYPE_UINT64, (guint64) sink->queued_bytes,
+              "sent-buffers", G_TYPE_UINT64, sink->sent_buffers,
+              "sent-bytes", G_TYPE_UINT64, sink->sent_bytes,
+              "dropped-buffers", G_TYPE_UINT64, sink->dropped_buffers,
+              "dropped-bytes", G_TYPE_UINT64, sink->dropped_bytes, NULL));
+      g_mutex_unlock (&sink->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
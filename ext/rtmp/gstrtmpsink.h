@@ -53,9 +53,28 @@ struct _GstRTMPSink {
   RTMP *rtmp;
   gchar *rtmp_uri; /* copy of url for librtmp */
 
+  /* shared with the I/O thread, protected by the lock when it runs */
   GstBuffer *header;
   gboolean first;
   gboolean have_write_error;
+
+  guint max_queue_bytes;
+
+  /* send queue of the I/O thread, all protected by the lock */
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  GQueue queue;
+  gsize queued_bytes;
+  gboolean running;
+  gboolean flushing;
+  /* a buffer was taken from the queue and is being written */
+  gboolean sending;
+  gboolean drop_delta;
+  GstFlowReturn io_ret;
+
+  guint64 sent_buffers, sent_bytes;
+  guint64 dropped_buffers, dropped_bytes;
 };
 
 struct _GstRTMPSinkClass {
@@ -659,6 +659,11 @@ gst_mss_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
 
   interval = 2 * (interval / GST_USECOND);
 
+  /* When the fragments announce the next ones the timeline is extended
+   * from them, and the manifest is only needed once they are all used up */
+  interval *= 1 +
+      gst_mss_manifest_get_look_ahead_fragments_count (mssdemux->manifest);
+
   return interval;
 }
 
@@ -1308,6 +1308,92 @@ gst_mss_manifest_is_live (GstMssManifest * manifest)
   return manifest->is_live;
 }
 
+gint
+gst_mss_manifest_get_look_ahead_fragments_count (GstMssManifest * manifest)
+{
+  return manifest->is_live ? manifest->look_ahead_fragment_count : 0;
+}
+
+static inline guint64
+gst_mss_stream_fragment_end (GstMssStreamFragment * fragment)
+{
+  return fragment->time + fragment->duration * fragment->repetitions;
+}
+
+/* Appends @fragment after the link @tail of the fragments list and updates
+ * @tail. Fragments continuing the last run are merged into it. */
+static void
+gst_mss_stream_append_fragment (GList ** tail, GstMssStreamFragment * fragment)
+{
+  GstMssStreamFragment *last = (*tail)->data;
+
+  if (last->duration == fragment->duration
+      && gst_mss_stream_fragment_end (last) == fragment->time) {
+    last->repetitions += fragment->repetitions;
+    g_free (fragment);
+    return;
+  }
+
+  /* appending after the last link doesn't walk the list */
+  g_list_append (*tail, fragment);
+  *tail = (*tail)->next;
+}
+
+/* Adds the fragments of a reloaded manifest that come after the ones
+ * already known and drops the known ones that left the DVR window, so the
+ * current fragment stays valid */
+static void
+gst_mss_stream_merge_fragments (GstMssStream * stream, GList * fragments)
+{
+  GstMssStreamFragment *first = fragments->data;
+  GList *tail, *iter;
+  guint64 end;
+  guint added = 0, removed = 0;
+
+  tail = g_list_last (stream->fragments);
+  end = gst_mss_stream_fragment_end (tail->data);
+
+  for (iter = fragments; iter; iter = iter->next) {
+    GstMssStreamFragment *fragment = iter->data;
+
+    if (fragment->time < end) {
+      guint64 skip;
+
+      if (fragment->duration == 0) {
+        g_free (fragment);
+        continue;
+      }
+
+      /* only keep the repetitions after the known fragments */
+      skip = (end - fragment->time + fragment->duration - 1) /
+          fragment->duration;
+      if (skip >= fragment->repetitions) {
+        g_free (fragment);
+        continue;
+      }
+      fragment->time += skip * fragment->duration;
+      fragment->repetitions -= skip;
+    }
+
+    end = gst_mss_stream_fragment_end (fragment);
+    gst_mss_stream_append_fragment (&tail, fragment);
+    added++;
+  }
+  g_list_free (fragments);
+
+  while (stream->fragments != stream->current_fragment
+      && stream->fragments->next
+      && gst_mss_stream_fragment_end (stream->fragments->data) <=
+      first->time) {
+    g_free (stream->fragments->data);
+    stream->fragments =
+        g_list_delete_link (stream->fragments, stream->fragments);
+    removed++;
+  }
+
+  GST_DEBUG ("Merged fragments: %u added, %u removed", added, removed);
+}
+
 static void
 gst_mss_stream_reload_fragments (GstMssStream * stream, xmlNodePtr streamIndex)
 {
@@ -1330,15 +1416,22 @@ gst_mss_stream_reload_fragments (GstMssStream * stream, xmlNodePtr streamIndex)
     }
   }
 
-  /* store the new fragments list */
-  if (builder.fragments) {
-    g_list_free_full (stream->fragments, g_free);
-    stream->fragments = g_list_reverse (builder.fragments);
-    stream->current_fragment = stream->fragments;
-    /* TODO Verify how repositioning here works for reverse
-     * playback - it might start from the wrong fragment */
-    gst_mss_stream_seek (stream, TRUE, 0, current_gst_time, NULL);
+  if (!builder.fragments)
+    return;
+
+  /* with a current fragment, keep the list and just extend it */
+  if (stream->current_fragment) {
+    gst_mss_stream_merge_fragments (stream, g_list_reverse (builder.fragments));
+    return;
   }
+
+  /* store the new fragments list */
+  g_list_free_full (stream->fragments, g_free);
+  stream->fragments = g_list_reverse (builder.fragments);
+  stream->current_fragment = stream->fragments;
+  /* TODO Verify how repositioning here works for reverse
+   * playback - it might start from the wrong fragment */
+  gst_mss_stream_seek (stream, TRUE, 0, current_gst_time, NULL);
 }
 
 static void
@@ -1602,6 +1695,7 @@ gst_mss_stream_parse_fragment (GstMssStream * stream, GstBuffer * buffer)
 {
   GstMssStreamFragment *current_fragment = NULL;
   const gchar *stream_type_name;
+  GList *tail;
   guint8 index;
 
   if (!stream->has_live_fragments)
@@ -1610,29 +1704,31 @@ gst_mss_stream_parse_fragment (GstMssStream * stream, GstBuffer * buffer)
   if (!gst_mss_fragment_parser_add_buffer (&stream->fragment_parser, buffer))
     return;
 
+  /* the fragment tells its exact timing, but runs of repeated fragments
+   * share theirs so they are left alone */
   current_fragment = stream->current_fragment->data;
-  current_fragment->time = stream->fragment_parser.tfxd.time;
-  current_fragment->duration = stream->fragment_parser.tfxd.duration;
+  if (current_fragment->repetitions == 1) {
+    current_fragment->time = stream->fragment_parser.tfxd.time;
+    current_fragment->duration = stream->fragment_parser.tfxd.duration;
+  }
 
   stream_type_name =
       gst_mss_stream_type_name (gst_mss_stream_get_type (stream));
 
+  tail = g_list_last (stream->fragments);
+  if (tail == NULL)
+    return;
+
   for (index = 0; index < stream->fragment_parser.tfrf.entries_count; index++) {
-    GList *l = g_list_last (stream->fragments);
-    GstMssStreamFragment *last;
+    GstMssStreamFragment *last = (GstMssStreamFragment *) tail->data;
     GstMssStreamFragment *fragment;
     guint64 parsed_time = stream->fragment_parser.tfrf.entries[index].time;
     guint64 parsed_duration =
         stream->fragment_parser.tfrf.entries[index].duration;
 
-    if (l == NULL)
-      break;
-
-    last = (GstMssStreamFragment *) l->data;
-
     /* only add the fragment to the list if it's outside the time in the
-     * current list */
-    if (last->time >= stream->fragment_parser.tfrf.entries[index].time)
+     * current list, including all repetitions of the last run */
+    if (gst_mss_stream_fragment_end (last) > parsed_time)
       continue;
 
     fragment = g_new (GstMssStreamFragment, 1);
@@ -1641,10 +1737,10 @@ gst_mss_stream_parse_fragment (GstMssStream * stream, GstBuffer * buffer)
     fragment->time = parsed_time;
     fragment->duration = parsed_duration;
 
-    stream->fragments = g_list_append (stream->fragments, fragment);
     GST_LOG ("Adding fragment number: %u to %s stream, time: %"
         G_GUINT64_FORMAT ", duration: %" G_GUINT64_FORMAT ", repetitions: %u",
         fragment->number, stream_type_name, fragment->time,
         fragment->duration, fragment->repetitions);
+    gst_mss_stream_append_fragment (&tail, fragment);
   }
 }
@@ -210,6 +210,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -373,6 +377,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -396,6 +402,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -501,15 +509,29 @@ gst_srtp_dec_remove_stream (GstSrtpDec * filter, guint ssrc)
   stream = g_hash_table_lookup (filter->streams, GUINT_TO_POINTER (ssrc));
 
   if (stream) {
+    if (filter->last_stream == stream)
+      filter->last_stream = NULL;
     srtp_remove_stream (filter->session, ssrc);
     g_hash_table_remove (filter->streams, GUINT_TO_POINTER (ssrc));
   }
 }
 
+/* Packets mostly come in runs of the same SSRC, so the last stream found is
+ * checked before the hash table. The lock is needed anyway for the session,
+ * which libsrtp doesn't allow to use from several threads at once */
 static GstSrtpDecSsrcStream *
 find_stream_by_ssrc (GstSrtpDec * filter, guint32 ssrc)
 {
-  return g_hash_table_lookup (filter->streams, GUINT_TO_POINTER (ssrc));
+  GstSrtpDecSsrcStream *stream = filter->last_stream;
+
+  if (stream && stream->ssrc == ssrc)
+    return stream;
+
+  stream = g_hash_table_lookup (filter->streams, GUINT_TO_POINTER (ssrc));
+  if (stream)
+    filter->last_stream = stream;
+
+  return stream;
 }
 
 
@@ -780,6 +802,7 @@ gst_srtp_dec_clear_streams (GstSrtpDec * filter)
   if (!filter->first_session)
     srtp_dealloc (filter->session);
 
+  filter->last_stream = NULL;
   if (filter->streams)
     nb = g_hash_table_foreach_remove (filter->streams, remove_yes, NULL);
 
@@ -1130,12 +1153,15 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 }
 
 /*
- * This function should be called while holding the filter lock
+ * This function should be called while holding the filter lock. The packet
+ * is decoded in place, @buf is replaced by a copy first if it is not
+ * writable. The lock is only released to handle errors.
  */
 static gboolean
-gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
-    gboolean is_rtcp, guint32 ssrc)
+gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad,
+    GstBuffer ** bufptr, gboolean is_rtcp, guint32 ssrc)
 {
+  GstBuffer *buf = *bufptr;
   GstMapInfo map;
   err_status_t err;
   gint size;
@@ -1145,7 +1171,7 @@ gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
       ssrc);
 
   /* Change buffer to remove protection */
-  buf = gst_buffer_make_writable (buf);
+  buf = *bufptr = gst_buffer_make_writable (buf);
 
   gst_buffer_map (buf, &map, GST_MAP_READWRITE);
   size = map.size;
@@ -1184,9 +1210,9 @@ unprotect:
     err = srtp_unprotect (filter->session, map.data, &size);
   }
 
-  GST_OBJECT_UNLOCK (filter);
-
   if (err != err_status_ok) {
+    GST_OBJECT_UNLOCK (filter);
+
     GST_WARNING_OBJECT (pad,
         "Unable to unprotect buffer (unprotect failed code %d)", err);
 
@@ -1206,6 +1232,7 @@ unprotect:
                 "dropping");
           }
         } else {
+          GST_OBJECT_UNLOCK (filter);
           GST_WARNING_OBJECT (filter, "Could not find matching stream, "
               "dropping");
         }
@@ -1231,10 +1258,29 @@ unprotect:
 
   gst_buffer_set_size (buf, size);
 
-  GST_OBJECT_LOCK (filter);
   return TRUE;
 }
 
+static GstPad *
+gst_srtp_dec_get_src_pad (GstSrtpDec * filter, gboolean is_rtcp)
+{
+  GstPad *otherpad;
+
+  if (is_rtcp) {
+    otherpad = filter->rtcp_srcpad;
+    if (!filter->rtcp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
+          filter->rtp_srcpad, TRUE);
+  } else {
+    otherpad = filter->rtp_srcpad;
+    if (!filter->rtp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
+          filter->rtcp_srcpad, FALSE);
+  }
+
+  return otherpad;
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     gboolean is_rtcp)
@@ -1260,7 +1306,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     goto push_out;
   }
 
-  if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
+  if (!gst_srtp_dec_decode_buffer (filter, pad, &buf, is_rtcp, ssrc)) {
     GST_OBJECT_UNLOCK (filter);
     goto drop_buffer;
   }
@@ -1273,17 +1319,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 push_out:
   /* Push buffer to source pad */
-  if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
-    if (!filter->rtcp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
-          filter->rtp_srcpad, TRUE);
-  } else {
-    otherpad = filter->rtp_srcpad;
-    if (!filter->rtp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
-          filter->rtcp_srcpad, FALSE);
-  }
+  otherpad = gst_srtp_dec_get_src_pad (filter, is_rtcp);
   ret = gst_pad_push (otherpad, buf);
 
   return ret;
@@ -1296,6 +1332,98 @@ drop_buffer:
   return ret;
 }
 
+typedef struct
+{
+  GstSrtpDec *filter;
+  GstPad *pad;
+  gboolean is_rtcp;
+  /* RTCP packets received on the RTP pad or the other way around */
+  GstBufferList *other_list;
+  /* streams that reached the soft limit */
+  GArray *soft_limit_ssrcs;
+} DecodeBufferItData;
+
+/* Called with the filter lock held, for a writable list */
+static gboolean
+decode_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
+{
+  DecodeBufferItData *data = user_data;
+  GstSrtpDec *filter = data->filter;
+  GstSrtpDecSsrcStream *stream;
+  gboolean is_rtcp = data->is_rtcp;
+  guint32 ssrc = 0;
+
+  if (!(stream = validate_buffer (filter, *buffer, &ssrc, &is_rtcp))) {
+    GST_WARNING_OBJECT (filter, "Invalid buffer, dropping");
+    goto drop_buffer;
+  }
+
+  if (STREAM_HAS_CRYPTO (stream)) {
+    if (!gst_srtp_dec_decode_buffer (filter, data->pad, buffer, is_rtcp, ssrc))
+      goto drop_buffer;
+
+    if (gst_srtp_get_soft_limit_reached ())
+      g_array_append_val (data->soft_limit_ssrcs, ssrc);
+  }
+
+  if (is_rtcp != data->is_rtcp) {
+    if (!data->other_list)
+      data->other_list = gst_buffer_list_new ();
+    gst_buffer_list_add (data->other_list, *buffer);
+    *buffer = NULL;
+  }
+
+  return TRUE;
+
+drop_buffer:
+  gst_buffer_unref (*buffer);
+  *buffer = NULL;
+
+  return TRUE;
+}
+
+/* Decodes the whole list in place with a single acquisition of the filter
+ * lock, unless a key needs to be requested */
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  DecodeBufferItData data;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
+
+  buf_list = gst_buffer_list_make_writable (buf_list);
+
+  data.filter = filter;
+  data.pad = pad;
+  data.is_rtcp = is_rtcp;
+  data.other_list = NULL;
+  data.soft_limit_ssrcs = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  GST_OBJECT_LOCK (filter);
+  gst_buffer_list_foreach (buf_list, decode_buffer_it, &data);
+  GST_OBJECT_UNLOCK (filter);
+
+  /* If all is well, we may have reached soft limit */
+  for (i = 0; i < data.soft_limit_ssrcs->len; i++)
+    request_key_with_signal (filter, g_array_index (data.soft_limit_ssrcs,
+            guint32, i), SIGNAL_SOFT_LIMIT);
+  g_array_free (data.soft_limit_ssrcs, TRUE);
+
+  if (data.other_list)
+    gst_pad_push_list (gst_srtp_dec_get_src_pad (filter, !is_rtcp),
+        data.other_list);
+
+  if (gst_buffer_list_length (buf_list) > 0)
+    ret = gst_pad_push_list (gst_srtp_dec_get_src_pad (filter, is_rtcp),
+        buf_list);
+  else
+    gst_buffer_list_unref (buf_list);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain_rtp (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1308,6 +1436,20 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
@@ -80,6 +80,7 @@ struct _GstSrtpDec
   srtp_t session;
   gboolean first_session;
   GHashTable *streams;
+  GstSrtpDecSsrcStream *last_stream;
 
   gboolean rtp_has_segment;
   gboolean rtcp_has_segment;
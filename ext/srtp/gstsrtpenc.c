@@ -137,6 +137,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_srtp_enc_debug);
 #define DEFAULT_REPLAY_WINDOW_SIZE 128
 #define DEFAULT_ALLOW_REPEAT_TX FALSE
 
+/* Size of the buffers of the output pool, enough for a protected packet
+ * that fits in an Ethernet MTU. Bigger packets get their own allocation */
+#define POOL_BUFFER_SIZE (1500 + SRTP_MAX_TRAILER_LEN + 10)
+
 #define HAS_CRYPTO(filter) (filter->rtp_cipher != GST_SRTP_CIPHER_NULL || \
       filter->rtcp_cipher != GST_SRTP_CIPHER_NULL ||                      \
       filter->rtp_auth != GST_SRTP_AUTH_NULL ||                           \
@@ -168,8 +172,9 @@ typedef struct ProcessBufferItData
 {
   GstSrtpEnc *filter;
   GstPad *pad;
-  GstBufferList *out_list;
   gboolean is_rtcp;
+  err_status_t err;
+  gboolean soft_limit_reached;
 } ProcessBufferItData;
 
 /* the capabilities of the inputs and outputs.
@@ -602,6 +607,12 @@ gst_srtp_enc_dispose (GObject * object)
     gst_buffer_unref (filter->key);
   filter->key = NULL;
 
+  if (filter->pool) {
+    gst_buffer_pool_set_active (filter->pool, FALSE);
+    gst_object_unref (filter->pool);
+  }
+  filter->pool = NULL;
+
   G_OBJECT_CLASS (gst_srtp_enc_parent_class)->dispose (object);
 }
 
@@ -1016,64 +1027,141 @@ gst_srtp_enc_check_set_caps (GstSrtpEnc * filter, GstPad * pad,
   return GST_FLOW_OK;
 }
 
+/* Whether @buf can be protected in place: it's not shared with anyone and
+ * its memory has room for @size bytes */
+static gboolean
+gst_srtp_enc_has_tailroom (GstBuffer * buf, gsize size)
+{
+  GstMemory *mem;
+
+  if (!gst_buffer_is_writable (buf) || gst_buffer_n_memory (buf) != 1)
+    return FALSE;
+
+  mem = gst_buffer_peek_memory (buf, 0);
+  if (GST_MEMORY_IS_READONLY (mem) ||
+      !gst_mini_object_is_writable (GST_MINI_OBJECT_CAST (mem)))
+    return FALSE;
+
+  return mem->maxsize - mem->offset >= size;
+}
+
+/* Must be called with the filter lock held */
+static GstBuffer *
+gst_srtp_enc_alloc_buffer (GstSrtpEnc * filter, gsize size)
+{
+  GstBuffer *buf = NULL;
+
+  if (size > POOL_BUFFER_SIZE)
+    return gst_buffer_new_allocate (NULL, size, NULL);
+
+  if (!filter->pool) {
+    GstStructure *config;
+
+    filter->pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (filter->pool);
+    gst_buffer_pool_config_set_params (config, NULL, POOL_BUFFER_SIZE, 0, 0);
+    if (!gst_buffer_pool_set_config (filter->pool, config) ||
+        !gst_buffer_pool_set_active (filter->pool, TRUE)) {
+      GST_WARNING_OBJECT (filter, "Failed to set up the output pool");
+      gst_object_unref (filter->pool);
+      filter->pool = NULL;
+      return gst_buffer_new_allocate (NULL, size, NULL);
+    }
+  }
+
+  if (gst_buffer_pool_acquire_buffer (filter->pool, &buf, NULL) != GST_FLOW_OK)
+    buf = gst_buffer_new_allocate (NULL, size, NULL);
+
+  return buf;
+}
+
+/* Protects @buf and returns the protected buffer, or %NULL with the error
+ * in @err. The packet is protected in place if @buf is writable and has
+ * room for the trailer, else it is copied into a buffer from the output
+ * pool. Takes ownership of @buf.
+ *
+ * This function should be called while holding the filter lock. Errors
+ * need to be posted by the caller, once the lock is released.
+ */
 static GstBuffer *
 gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
-    GstBuffer * buf, gboolean is_rtcp)
+    GstBuffer * buf, gboolean is_rtcp, err_status_t * err)
 {
   gint size_max, size;
   GstBuffer *bufout = NULL;
   GstMapInfo mapout;
-  err_status_t err;
 
-  /* Create a bigger buffer to add protection */
   size = gst_buffer_get_size (buf);
   size_max = size + SRTP_MAX_TRAILER_LEN + 10;
-  bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
-
-  gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
 
-  gst_buffer_extract (buf, 0, mapout.data, size);
-
-  GST_OBJECT_LOCK (filter);
+  if (gst_srtp_enc_has_tailroom (buf, size_max)) {
+    /* Make the trailer part of the buffer so that it is mapped too */
+    bufout = buf;
+    buf = NULL;
+    gst_buffer_set_size (bufout, size_max);
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  } else {
+    bufout = gst_srtp_enc_alloc_buffer (filter, size_max);
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+    gst_buffer_extract (buf, 0, mapout.data, size);
+  }
 
   gst_srtp_init_event_reporter ();
 
   if (is_rtcp)
-    err = srtp_protect_rtcp (filter->session, mapout.data, &size);
+    *err = srtp_protect_rtcp (filter->session, mapout.data, &size);
   else
-    err = srtp_protect (filter->session, mapout.data, &size);
-
-  GST_OBJECT_UNLOCK (filter);
+    *err = srtp_protect (filter->session, mapout.data, &size);
 
   gst_buffer_unmap (bufout, &mapout);
 
-  if (err == err_status_ok) {
+  if (*err == err_status_ok) {
     /* Buffer protected */
     gst_buffer_set_size (bufout, size);
-    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+    if (buf)
+      gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
 
     GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d",
         is_rtcp ? "RTCP" : "RTP", size);
+  } else {
+    gst_buffer_unref (bufout);
+    bufout = NULL;
+  }
 
-  } else if (err == err_status_key_expired) {
+  if (buf)
+    gst_buffer_unref (buf);
 
+  return bufout;
+}
+
+static void
+gst_srtp_enc_post_error (GstSrtpEnc * filter, err_status_t err)
+{
+  if (err == err_status_key_expired) {
     GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
         ("Key usage limit has been reached"),
         ("Unable to protect buffer (hard key usage limit reached)"));
-    goto fail;
-
   } else {
     /* srtp_protect failed */
     GST_ELEMENT_ERROR (filter, LIBRARY, FAILED, (NULL),
         ("Unable to protect buffer (protect failed) code %d", err));
-    goto fail;
   }
+}
 
-  return bufout;
+static void
+gst_srtp_enc_check_soft_limit (GstSrtpEnc * filter, gboolean reached)
+{
+  GST_OBJECT_LOCK (filter);
 
-fail:
-  gst_buffer_unref (bufout);
-  return NULL;
+  if (reached) {
+    GST_OBJECT_UNLOCK (filter);
+    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
+    GST_OBJECT_LOCK (filter);
+    if (filter->random_key && !filter->key_changed)
+      gst_srtp_enc_replace_random_key (filter);
+  }
+
+  GST_OBJECT_UNLOCK (filter);
 }
 
 static GstFlowReturn
@@ -1084,73 +1172,64 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
   GstBuffer *bufout = NULL;
+  err_status_t err;
 
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK) {
-    goto out;
+    gst_buffer_unref (buf);
+    return ret;
   }
 
+  otherpad = get_rtp_other_pad (pad);
+
   GST_OBJECT_LOCK (filter);
 
   if (!HAS_CRYPTO (filter)) {
     GST_OBJECT_UNLOCK (filter);
-    otherpad = get_rtp_other_pad (pad);
     return gst_pad_push (otherpad, buf);
   }
 
-  GST_OBJECT_UNLOCK (filter);
+  bufout = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp, &err);
 
-  if ((bufout = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp))) {
-    /* Push buffer to source pad */
-    otherpad = get_rtp_other_pad (pad);
-    ret = gst_pad_push (otherpad, bufout);
-    bufout = NULL;
+  GST_OBJECT_UNLOCK (filter);
 
-    if (ret != GST_FLOW_OK)
-      goto out;
-  } else {
-    goto fail;
+  if (!bufout) {
+    gst_srtp_enc_post_error (filter, err);
+    return GST_FLOW_ERROR;
   }
 
-  GST_OBJECT_LOCK (filter);
-
-  if (gst_srtp_get_soft_limit_reached ()) {
-    GST_OBJECT_UNLOCK (filter);
-    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
-    GST_OBJECT_LOCK (filter);
-    if (filter->random_key && !filter->key_changed)
-      gst_srtp_enc_replace_random_key (filter);
-  }
-
-  GST_OBJECT_UNLOCK (filter);
-
-out:
+  /* Push buffer to source pad */
+  ret = gst_pad_push (otherpad, bufout);
+  if (ret != GST_FLOW_OK)
+    return ret;
 
-  gst_buffer_unref (buf);
+  gst_srtp_enc_check_soft_limit (filter, gst_srtp_get_soft_limit_reached ());
 
   return ret;
-
-fail:
-  ret = GST_FLOW_ERROR;
-  goto out;
 }
 
+/* Called with the filter lock held, for a writable list */
 static gboolean
 process_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
 {
   ProcessBufferItData *data = user_data;
-  GstBuffer *bufout;
+  err_status_t err;
+
+  *buffer = gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
+      data->is_rtcp, &err);
 
-  if ((bufout =
-          gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
-              data->is_rtcp))) {
-    gst_buffer_list_add (data->out_list, bufout);
+  if (*buffer) {
+    data->soft_limit_reached |= gst_srtp_get_soft_limit_reached ();
   } else {
     GST_WARNING_OBJECT (data->filter, "Error encoding buffer, dropping");
+    if (data->err == err_status_ok)
+      data->err = err;
   }
 
   return TRUE;
 }
 
+/* The whole list is protected with a single acquisition of the filter
+ * lock, and in the list itself */
 static GstFlowReturn
 gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
     GstBufferList * buf_list, gboolean is_rtcp)
@@ -1158,7 +1237,6 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
-  GstBufferList *out_list = NULL;
   ProcessBufferItData process_data;
 
   GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
@@ -1170,52 +1248,44 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK)
     goto out;
 
+  otherpad = get_rtp_other_pad (pad);
+
   GST_OBJECT_LOCK (filter);
 
   if (!HAS_CRYPTO (filter)) {
     GST_OBJECT_UNLOCK (filter);
-    otherpad = get_rtp_other_pad (pad);
     return gst_pad_push_list (otherpad, buf_list);
   }
 
-  GST_OBJECT_UNLOCK (filter);
-
-  out_list = gst_buffer_list_new ();
+  buf_list = gst_buffer_list_make_writable (buf_list);
 
   process_data.filter = filter;
   process_data.pad = pad;
   process_data.is_rtcp = is_rtcp;
-  process_data.out_list = out_list;
+  process_data.err = err_status_ok;
+  process_data.soft_limit_reached = FALSE;
 
   gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data);
 
-  if (!gst_buffer_list_length (out_list)) {
-    gst_buffer_list_unref (out_list);
-    ret = GST_FLOW_OK;
+  GST_OBJECT_UNLOCK (filter);
+
+  if (process_data.err != err_status_ok)
+    gst_srtp_enc_post_error (filter, process_data.err);
+
+  if (!gst_buffer_list_length (buf_list))
     goto out;
-  }
 
   /* Push buffer to source pad */
-  otherpad = get_rtp_other_pad (pad);
   GST_LOG_OBJECT (pad, "Pushing buffer chain of %d",
       gst_buffer_list_length (buf_list));
-  ret = gst_pad_push_list (otherpad, out_list);
+  ret = gst_pad_push_list (otherpad, buf_list);
 
-  if (ret != GST_FLOW_OK) {
-    goto out;
-  }
+  if (ret != GST_FLOW_OK)
+    return ret;
 
-  GST_OBJECT_LOCK (filter);
+  gst_srtp_enc_check_soft_limit (filter, process_data.soft_limit_reached);
 
-  if (gst_srtp_get_soft_limit_reached ()) {
-    GST_OBJECT_UNLOCK (filter);
-    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
-    GST_OBJECT_LOCK (filter);
-    if (filter->random_key && !filter->key_changed)
-      gst_srtp_enc_replace_random_key (filter);
-  }
-
-  GST_OBJECT_UNLOCK (filter);
+  return ret;
 
 out:
 
@@ -1303,6 +1373,13 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_srtp_enc_reset (filter);
+      GST_OBJECT_LOCK (filter);
+      if (filter->pool) {
+        gst_buffer_pool_set_active (filter->pool, FALSE);
+        gst_object_unref (filter->pool);
+      }
+      filter->pool = NULL;
+      GST_OBJECT_UNLOCK (filter);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -84,6 +84,9 @@ struct _GstSrtpEnc
 
   guint replay_window_size;
   gboolean allow_repeat_tx;
+
+  /* output buffers for packets that can't be protected in place */
+  GstBufferPool *pool;
 };
 
 struct _GstSrtpEncClass
@@ -179,6 +179,7 @@ static gboolean gst_teletextdec_extract_data_units (GstTeletextDec *
 static void gst_teletextdec_zvbi_init (GstTeletextDec * teletext);
 static void gst_teletextdec_zvbi_clear (GstTeletextDec * teletext);
 static void gst_teletextdec_reset_frame (GstTeletextDec * teletext);
+static void gst_teletextdec_clear_cache (GstTeletextDec * teletext);
 
 /* initialize the gstteletext's class */
 static void
@@ -209,7 +210,8 @@ gst_teletextdec_class_init (GstTeletextDecClass * klass)
   g_object_class_install_property (gobject_class, PROP_SUBTITLES_MODE,
       g_param_spec_boolean ("subtitles-mode", "Enable subtitles mode",
           "Enables subtitles mode for text output stripping the blank lines and "
-          "the teletext state lines", FALSE,
+          "the teletext state lines, and for RGBA output only rendering the "
+          "lines with text on a transparent background", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_SUBS_TEMPLATE,
@@ -278,6 +280,10 @@ gst_teletextdec_init (GstTeletextDec * teletext)
 
   teletext->export_func = NULL;
   teletext->buf_pool = NULL;
+
+  teletext->last_text = NULL;
+  teletext->last_text_size = 0;
+  teletext->last_buffer = NULL;
 }
 
 static void
@@ -288,6 +294,8 @@ gst_teletextdec_finalize (GObject * object)
   g_mutex_clear (&teletext->queue_lock);
 
   g_free (teletext->frame);
+  gst_teletextdec_clear_cache (teletext);
+  g_free (teletext->last_text);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -333,6 +341,7 @@ gst_teletextdec_zvbi_clear (GstTeletextDec * teletext)
     g_queue_free (teletext->queue);
     teletext->queue = NULL;
   }
+  gst_teletextdec_clear_cache (teletext);
   g_mutex_unlock (&teletext->queue_lock);
 
   teletext->in_timestamp = GST_CLOCK_TIME_NONE;
@@ -356,13 +365,24 @@ gst_teletextdec_set_property (GObject * object, guint prop_id,
       teletext->subno = g_value_get_int (value);
       break;
     case PROP_SUBTITLES_MODE:
+      g_mutex_lock (&teletext->queue_lock);
       teletext->subtitles_mode = g_value_get_boolean (value);
+      gst_teletextdec_clear_cache (teletext);
+      g_mutex_unlock (&teletext->queue_lock);
       break;
     case PROP_SUBS_TEMPLATE:
+      g_mutex_lock (&teletext->queue_lock);
+      g_free (teletext->subtitles_template);
       teletext->subtitles_template = g_value_dup_string (value);
+      gst_teletextdec_clear_cache (teletext);
+      g_mutex_unlock (&teletext->queue_lock);
       break;
     case PROP_FONT_DESCRIPTION:
+      g_mutex_lock (&teletext->queue_lock);
+      g_free (teletext->font_description);
       teletext->font_description = g_value_dup_string (value);
+      gst_teletextdec_clear_cache (teletext);
+      g_mutex_unlock (&teletext->queue_lock);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -698,6 +718,9 @@ gst_teletextdec_negotiate_caps (GstTeletextDec * teletext, guint width,
     goto beach;
   }
 
+  /* the last buffer has the old format */
+  gst_teletextdec_clear_cache (teletext);
+
   /* try to get a bufferpool from the peer pad in case of RGBA output. */
   if (gst_teletextdec_export_rgba_page == teletext->export_func) {
     gst_teletextdec_try_get_buffer_pool (teletext, peercaps,
@@ -750,6 +773,62 @@ error:
   }
 }
 
+/* The rows of a page that end up in the output */
+static void
+gst_teletextdec_get_exported_rows (GstTeletextDec * teletext, vbi_page * page,
+    guint * start, guint * stop)
+{
+  *start = teletext->subtitles_mode ? 1 : 0;
+  *stop = teletext->subtitles_mode ? page->rows - 2 : page->rows - 1;
+}
+
+static void
+gst_teletextdec_clear_cache (GstTeletextDec * teletext)
+{
+  gst_buffer_replace (&teletext->last_buffer, NULL);
+  teletext->last_text_size = 0;
+}
+
+/* Whether the page exports to the same buffer as the last page. Only the
+ * exported rows are compared, so that the clock in the header row does not
+ * cause a new export every second in subtitles mode. */
+static gboolean
+gst_teletextdec_page_is_cached (GstTeletextDec * teletext, vbi_page * page)
+{
+  guint start, stop;
+  gsize size;
+
+  if (teletext->last_buffer == NULL)
+    return FALSE;
+
+  gst_teletextdec_get_exported_rows (teletext, page, &start, &stop);
+  size = (stop - start + 1) * page->columns * sizeof (vbi_char);
+
+  return size == teletext->last_text_size &&
+      memcmp (teletext->last_text, page->text + start * page->columns,
+      size) == 0 &&
+      memcmp (teletext->last_color_map, page->color_map,
+      sizeof (teletext->last_color_map)) == 0;
+}
+
+static void
+gst_teletextdec_cache_page (GstTeletextDec * teletext, vbi_page * page,
+    GstBuffer * buf)
+{
+  guint start, stop;
+  gsize size;
+
+  gst_teletextdec_get_exported_rows (teletext, page, &start, &stop);
+  size = (stop - start + 1) * page->columns * sizeof (vbi_char);
+
+  teletext->last_text = g_realloc (teletext->last_text, size);
+  memcpy (teletext->last_text, page->text + start * page->columns, size);
+  teletext->last_text_size = size;
+  memcpy (teletext->last_color_map, page->color_map,
+      sizeof (teletext->last_color_map));
+  gst_buffer_replace (&teletext->last_buffer, buf);
+}
+
 static GstFlowReturn
 gst_teletextdec_push_page (GstTeletextDec * teletext)
 {
@@ -792,7 +871,20 @@ gst_teletextdec_push_page (GstTeletextDec * teletext)
     }
   }
 
-  teletext->export_func (teletext, &page, &buf);
+  if (gst_teletextdec_page_is_cached (teletext, &page)) {
+    GST_LOG_OBJECT (teletext, "Page did not change, reusing the last buffer");
+    /* only the metadata is copied, the memory is shared */
+    buf = gst_buffer_copy (teletext->last_buffer);
+  } else {
+    /* release the last buffer first, it may be one of the pool's */
+    gst_teletextdec_clear_cache (teletext);
+    ret = teletext->export_func (teletext, &page, &buf);
+    if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+      vbi_unref_page (&page);
+      goto push_failed;
+    }
+    gst_teletextdec_cache_page (teletext, &page, buf);
+  }
   vbi_unref_page (&page);
 
   GST_BUFFER_TIMESTAMP (buf) = teletext->in_timestamp;
@@ -915,7 +1007,30 @@ gst_teletextdec_export_rgba_page (GstTeletextDec * teletext, vbi_page * page,
     return GST_FLOW_ERROR;
   }
 
-  vbi_draw_vt_page (page, VBI_PIXFMT_RGBA32_LE, buf_map.data, FALSE, TRUE);
+  if (teletext->subtitles_mode) {
+    const gint stride = teletext->width * sizeof (vbi_rgba);
+    vbi_char *acp;
+    gint row, column;
+
+    /* only the rows with text are rendered, the rest of the page, including
+     * the header and the last row, stays transparent */
+    memset (buf_map.data, 0, buf_map.size);
+    for (row = 1; row < page->rows - 1; row++) {
+      acp = page->text + row * page->columns;
+      for (column = 0; column < page->columns; column++) {
+        if (acp[column].unicode != 0x20)
+          break;
+      }
+      if (column == page->columns)
+        continue;
+
+      vbi_draw_vt_page_region (page, VBI_PIXFMT_RGBA32_LE,
+          buf_map.data + ROWS_TO_HEIGHT (row) * stride, stride, 0, row,
+          page->columns, 1, FALSE, TRUE);
+    }
+  } else {
+    vbi_draw_vt_page (page, VBI_PIXFMT_RGBA32_LE, buf_map.data, FALSE, TRUE);
+  }
   gst_buffer_unmap (lbuf, &buf_map);
   *buf = lbuf;
 
@@ -80,6 +80,13 @@ struct _GstTeletextDec
 
   /* buffer pool received from the peer pad - used in RGBA output only. */
   GstBufferPool *buf_pool;
+
+  /* the exported rows of the last page and the buffer they were exported
+   * to, pushed again with new timestamps while the page does not change. */
+  vbi_char *last_text;
+  gsize last_text_size;
+  vbi_rgba last_color_map[40];
+  GstBuffer *last_buffer;
 };
 
 struct _GstTeletextFrame
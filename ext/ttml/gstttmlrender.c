@@ -284,6 +284,11 @@ gst_ttml_render_finalize (GObject * object)
     render->compositions = NULL;
   }
 
+  if (render->region_cache) {
+    g_hash_table_unref (render->region_cache);
+    render->region_cache = NULL;
+  }
+
   if (render->text_buffer) {
     gst_buffer_unref (render->text_buffer);
     render->text_buffer = NULL;
@@ -511,6 +516,11 @@ gst_ttml_render_setcaps (GstTtmlRender * render, GstCaps * caps)
   ret = gst_ttml_render_negotiate (render, caps);
 
   GST_TTML_RENDER_LOCK (render);
+  /* the cached regions were rendered for the previous frame size */
+  if (render->region_cache) {
+    g_hash_table_unref (render->region_cache);
+    render->region_cache = NULL;
+  }
   g_mutex_lock (GST_TTML_RENDER_GET_CLASS (render)->pango_lock);
   if (!gst_ttml_render_can_handle_caps (caps)) {
     GST_DEBUG_OBJECT (render, "unsupported caps %" GST_PTR_FORMAT, caps);
@@ -2752,6 +2762,67 @@ gst_ttml_render_render_text_region (GstTtmlRender * render,
 }
 
 
+/* Appends everything in @style_set that affects rendering to @key. */
+static void
+gst_ttml_render_append_style_key (GString * key,
+    const GstSubtitleStyleSet * style_set)
+{
+  g_string_append_printf (key, "%d|%s|%.17g|%.17g|%d|%08x|%08x|%d|%d|%d|%d|"
+      "%d|%d|%.17g|%.17g|%.17g|%.17g|%.17g|%d|%.17g|%.17g|%.17g|%.17g|%d|%d|"
+      "%d|", style_set->text_direction, style_set->font_family,
+      style_set->font_size, style_set->line_height, style_set->text_align,
+      GST_READ_UINT32_BE (&style_set->color),
+      GST_READ_UINT32_BE (&style_set->background_color),
+      style_set->font_style, style_set->font_weight,
+      style_set->text_decoration, style_set->unicode_bidi,
+      style_set->wrap_option, style_set->multi_row_align,
+      style_set->line_padding, style_set->origin_x, style_set->origin_y,
+      style_set->extent_w, style_set->extent_h, style_set->display_align,
+      style_set->padding_start, style_set->padding_end,
+      style_set->padding_before, style_set->padding_after,
+      style_set->writing_mode, style_set->show_background,
+      style_set->overflow);
+}
+
+
+/* Returns a string that identifies the rendering of @region: two regions
+ * with the same key give the same overlay for a given frame size. Caller
+ * needs to free returned string after use. */
+static gchar *
+gst_ttml_render_get_region_key (GstSubtitleRegion * region,
+    GstBuffer * text_buf)
+{
+  GString *key = g_string_new (NULL);
+  guint i, j;
+
+  gst_ttml_render_append_style_key (key, region->style_set);
+
+  for (i = 0; i < gst_subtitle_region_get_block_count (region); ++i) {
+    const GstSubtitleBlock *block = gst_subtitle_region_get_block (region, i);
+
+    g_string_append_c (key, '{');
+    gst_ttml_render_append_style_key (key, block->style_set);
+
+    for (j = 0; j < gst_subtitle_block_get_element_count (block); ++j) {
+      GstSubtitleElement *element = gst_subtitle_block_get_element (block, j);
+      gchar *text;
+
+      g_string_append_c (key, '[');
+      gst_ttml_render_append_style_key (key, element->style_set);
+      text = gst_ttml_render_get_text_from_buffer (text_buf,
+          element->text_index);
+      g_string_append_printf (key, "%d|%" G_GSIZE_FORMAT ":%s]",
+          element->suppress_whitespace, text ? strlen (text) : 0,
+          text ? text : "");
+      g_free (text);
+    }
+    g_string_append_c (key, '}');
+  }
+
+  return g_string_free (key, FALSE);
+}
+
+
 static GstFlowReturn
 gst_ttml_render_video_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
@@ -2894,6 +2965,7 @@ wait_for_text_buf:
       if (render->need_render) {
         GstSubtitleRegion *region = NULL;
         GstSubtitleMeta *subtitle_meta = NULL;
+        GHashTable *region_cache;
         guint i;
 
         if (render->compositions) {
@@ -2906,16 +2978,43 @@ wait_for_text_buf:
         if (!subtitle_meta) {
           GST_CAT_WARNING (ttmlrender_debug, "Failed to get subtitle meta.");
         } else {
+          /* Regions that are still displayed unchanged are taken from the
+           * previous rendering, so that only the changed regions are laid
+           * out and rendered again and downstream gets the same overlay
+           * rectangles for the others. */
+          region_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+              g_free, (GDestroyNotify) gst_video_overlay_composition_unref);
+
           for (i = 0; i < subtitle_meta->regions->len; ++i) {
-            GstVideoOverlayComposition *composition;
+            GstVideoOverlayComposition *composition = NULL;
+            gchar *key;
+
             region = g_ptr_array_index (subtitle_meta->regions, i);
-            composition = gst_ttml_render_render_text_region (render, region,
-                render->text_buffer);
+            key = gst_ttml_render_get_region_key (region, render->text_buffer);
+            if (render->region_cache)
+              composition = g_hash_table_lookup (render->region_cache, key);
+
+            if (composition) {
+              GST_CAT_LOG (ttmlrender_debug, "reusing rendered region %u", i);
+              gst_video_overlay_composition_ref (composition);
+            } else {
+              composition = gst_ttml_render_render_text_region (render,
+                  region, render->text_buffer);
+            }
+
             if (composition) {
               render->compositions = g_list_append (render->compositions,
                   composition);
+              g_hash_table_insert (region_cache, key,
+                  gst_video_overlay_composition_ref (composition));
+            } else {
+              g_free (key);
             }
           }
+
+          if (render->region_cache)
+            g_hash_table_unref (render->region_cache);
+          render->region_cache = region_cache;
         }
         render->need_render = FALSE;
       }
@@ -93,6 +93,9 @@ struct _GstTtmlRender {
 
     PangoLayout             *layout;
     GList * compositions;
+
+    /* region key -> GstVideoOverlayComposition of the last rendering */
+    GHashTable              *region_cache;
 };
 
 struct _GstTtmlRenderClass {
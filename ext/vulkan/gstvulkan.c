@@ -31,6 +31,9 @@
 
 #include "vksink.h"
 #include "vkupload.h"
+#if GST_VULKAN_HAVE_COMPUTE_SHADERS
+#include "vkcolorconvert.h"
+#endif
 
 #if GST_VULKAN_HAVE_WINDOW_X11
 #include <X11/Xlib.h>
@@ -58,6 +61,12 @@ plugin_init (GstPlugin * plugin)
           GST_RANK_NONE, GST_TYPE_VULKAN_UPLOAD)) {
     return FALSE;
   }
+#if GST_VULKAN_HAVE_COMPUTE_SHADERS
+  if (!gst_element_register (plugin, "vulkancolorconvert",
+          GST_RANK_NONE, GST_TYPE_VULKAN_COLOR_CONVERT)) {
+    return FALSE;
+  }
+#endif
 
   return TRUE;
 }
@@ -61,6 +61,7 @@ typedef struct _GstVulkanMemoryAllocatorClass GstVulkanMemoryAllocatorClass;
 typedef struct _GstVulkanBufferMemory GstVulkanBufferMemory;
 typedef struct _GstVulkanBufferMemoryAllocator GstVulkanBufferMemoryAllocator;
 typedef struct _GstVulkanBufferMemoryAllocatorClass GstVulkanBufferMemoryAllocatorClass;
+typedef struct _GstVulkanStagingRing GstVulkanStagingRing;
 
 typedef struct _GstVulkanImageMemory GstVulkanImageMemory;
 typedef struct _GstVulkanImageMemoryAllocator GstVulkanImageMemoryAllocator;
@@ -152,13 +152,9 @@ _vk_buffer_mem_new_alloc (GstAllocator * allocator, GstMemory * parent,
   if (gst_vulkan_error_to_g_error (err, &error, "vkBindBufferMemory") < 0)
     goto vk_error;
 
+  /* buffer views are only valid for texel buffers */
   if (usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)) {
+          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)) {
     VkBufferViewCreateInfo view_info;
 
     _create_view_from_args (&view_info, mem->buffer, format, 0,
@@ -209,13 +205,9 @@ _vk_buffer_mem_new_wrapped (GstAllocator * allocator, GstMemory * parent,
 
   /* XXX: we don't actually if the buffer has a vkDeviceMemory bound so
    * this may fail */
+  /* buffer views are only valid for texel buffers */
   if (usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)) {
+          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)) {
     VkBufferViewCreateInfo view_info;
 
     _create_view_from_args (&view_info, mem->buffer, format, 0,
@@ -432,3 +424,195 @@ gst_is_vulkan_buffer_memory (GstMemory * mem)
       g_type_is_a (G_OBJECT_TYPE (mem->allocator),
       GST_TYPE_VULKAN_BUFFER_MEMORY_ALLOCATOR);
 }
+
+typedef struct
+{
+  GstVulkanFence *fence;
+  guint64 head;
+} GstVulkanStagingRegion;
+
+/**
+ * gst_vulkan_staging_ring_new:
+ * @device: a #GstVulkanDevice
+ * @size: the size in bytes of the ring
+ * @error: a #GError
+ *
+ * Allocates a host visible buffer of @size bytes, mapped for its whole
+ * lifetime, that is handed out in chunks for transfers to the GPU. A chunk
+ * is reused once the fence of the submission that read it has signaled, so
+ * that uploads never wait for the GPU unless the ring is full.
+ *
+ * Returns: (transfer full): a new #GstVulkanStagingRing or %NULL
+ */
+GstVulkanStagingRing *
+gst_vulkan_staging_ring_new (GstVulkanDevice * device, gsize size,
+    GError ** error)
+{
+  GstVulkanStagingRing *ring;
+  GstMemory *mem;
+
+  g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  gst_vulkan_buffer_memory_init_once ();
+
+  mem = gst_vulkan_buffer_memory_alloc (device, VK_FORMAT_R8_UNORM, size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  if (!mem) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_OUT_OF_DEVICE_MEMORY,
+        "Failed to allocate the staging ring");
+    return NULL;
+  }
+
+  ring = g_new0 (GstVulkanStagingRing, 1);
+  ring->device = gst_object_ref (device);
+  ring->mem = (GstVulkanBufferMemory *) mem;
+  ring->size = size;
+  g_queue_init (&ring->in_flight);
+
+  if (!gst_memory_map (mem, &ring->map_info, GST_MAP_WRITE)) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_MEMORY_MAP_FAILED,
+        "Failed to map the staging ring");
+    gst_vulkan_staging_ring_free (ring);
+    return NULL;
+  }
+
+  GST_CAT_DEBUG (GST_CAT_VULKAN_BUFFER_MEMORY, "new staging ring %p of %"
+      G_GSIZE_FORMAT " bytes", ring, size);
+
+  return ring;
+}
+
+static gboolean
+_staging_ring_release (GstVulkanStagingRing * ring, gboolean wait)
+{
+  GstVulkanStagingRegion *region = g_queue_peek_head (&ring->in_flight);
+
+  if (!region)
+    return FALSE;
+
+  if (!gst_vulkan_fence_is_signaled (region->fence)) {
+    VkFence fence = GST_VULKAN_FENCE_FENCE (region->fence);
+
+    if (!wait)
+      return FALSE;
+    vkWaitForFences (ring->device->device, 1, &fence, TRUE, G_MAXUINT64);
+  }
+
+  g_queue_pop_head (&ring->in_flight);
+  ring->tail = region->head;
+  gst_vulkan_fence_unref (region->fence);
+  g_free (region);
+
+  return TRUE;
+}
+
+/**
+ * gst_vulkan_staging_ring_free:
+ * @ring: a #GstVulkanStagingRing
+ *
+ * Waits for the pending transfers from @ring to complete and frees it.
+ */
+void
+gst_vulkan_staging_ring_free (GstVulkanStagingRing * ring)
+{
+  g_return_if_fail (ring != NULL);
+
+  while (_staging_ring_release (ring, TRUE));
+
+  if (ring->map_info.memory)
+    gst_memory_unmap ((GstMemory *) ring->mem, &ring->map_info);
+  gst_memory_unref ((GstMemory *) ring->mem);
+  gst_object_unref (ring->device);
+  g_free (ring);
+}
+
+/**
+ * gst_vulkan_staging_ring_alloc:
+ * @ring: a #GstVulkanStagingRing
+ * @size: the number of bytes needed
+ * @align: the required alignment of the offset, a power of 2
+ * @offset: (out): the offset of the chunk in the buffer of @ring
+ * @data: (out): the CPU address of the chunk
+ * @error: a #GError
+ *
+ * Reserves @size bytes in @ring, waiting for previous transfers when it is
+ * full. The chunk belongs to the next call to
+ * gst_vulkan_staging_ring_submit().
+ *
+ * Returns: whether a chunk could be reserved
+ */
+gboolean
+gst_vulkan_staging_ring_alloc (GstVulkanStagingRing * ring, gsize size,
+    gsize align, gsize * offset, guint8 ** data, GError ** error)
+{
+  gsize pos, start, needed;
+
+  g_return_val_if_fail (ring != NULL, FALSE);
+  g_return_val_if_fail (align > 0 && (align & (align - 1)) == 0, FALSE);
+
+  pos = ring->head % ring->size;
+  start = (pos + align - 1) & ~(align - 1);
+  if (start + size > ring->size) {
+    /* never split a chunk, skip the end of the buffer instead */
+    start = 0;
+    needed = ring->size - pos + size;
+  } else {
+    needed = start - pos + size;
+  }
+
+  if (needed > ring->size) {
+    g_set_error (error, GST_VULKAN_ERROR, VK_ERROR_OUT_OF_DEVICE_MEMORY,
+        "%" G_GSIZE_FORMAT " bytes do not fit in the staging ring", size);
+    return FALSE;
+  }
+
+  /* reclaim the chunks the GPU is done with, and only wait for it if that
+   * is not enough */
+  while (_staging_ring_release (ring, FALSE));
+  while (ring->size - (ring->head - ring->tail) < needed) {
+    GST_CAT_LOG (GST_CAT_VULKAN_BUFFER_MEMORY, "staging ring %p is full, "
+        "waiting", ring);
+    if (!_staging_ring_release (ring, TRUE)) {
+      g_set_error_literal (error, GST_VULKAN_ERROR,
+          VK_ERROR_OUT_OF_DEVICE_MEMORY,
+          "The staging ring is full of unsubmitted chunks");
+      return FALSE;
+    }
+  }
+
+  ring->head += needed;
+  *offset = start;
+  *data = ring->map_info.data + start;
+
+  return TRUE;
+}
+
+/**
+ * gst_vulkan_staging_ring_submit:
+ * @ring: a #GstVulkanStagingRing
+ * @fence: the #GstVulkanFence of the submission reading the chunks
+ *
+ * Associates the chunks reserved since the last call with @fence: they are
+ * reused once @fence is signaled.
+ */
+void
+gst_vulkan_staging_ring_submit (GstVulkanStagingRing * ring,
+    GstVulkanFence * fence)
+{
+  GstVulkanStagingRegion *region;
+
+  g_return_if_fail (ring != NULL);
+  g_return_if_fail (fence != NULL);
+
+  region = g_queue_peek_tail (&ring->in_flight);
+  if (ring->head == (region ? region->head : ring->tail))
+    return;
+
+  region = g_new0 (GstVulkanStagingRegion, 1);
+  region->fence = gst_vulkan_fence_ref (fence);
+  region->head = ring->head;
+  g_queue_push_tail (&ring->in_flight, region);
+}
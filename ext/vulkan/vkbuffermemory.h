@@ -97,6 +97,38 @@ GstMemory *     gst_vulkan_buffer_memory_wrapped         (GstVulkanDevice * devi
                                                          gpointer user_data,
                                                          GDestroyNotify notify);
 
+/**
+ * GstVulkanStagingRing:
+ *
+ * A ring of host visible memory for asynchronous transfers to the GPU
+ */
+struct _GstVulkanStagingRing
+{
+  GstVulkanDevice *device;
+  GstVulkanBufferMemory *mem;
+  gsize size;
+
+  /*< private >*/
+  GstMapInfo map_info;
+  /* bytes ever reserved and released, the positions are modulo size */
+  guint64 head;
+  guint64 tail;
+  GQueue in_flight;
+};
+
+GstVulkanStagingRing * gst_vulkan_staging_ring_new      (GstVulkanDevice * device,
+                                                         gsize size,
+                                                         GError ** error);
+void            gst_vulkan_staging_ring_free             (GstVulkanStagingRing * ring);
+gboolean        gst_vulkan_staging_ring_alloc            (GstVulkanStagingRing * ring,
+                                                         gsize size,
+                                                         gsize align,
+                                                         gsize * offset,
+                                                         guint8 ** data,
+                                                         GError ** error);
+void            gst_vulkan_staging_ring_submit           (GstVulkanStagingRing * ring,
+                                                         GstVulkanFence * fence);
+
 G_END_DECLS
 
 #endif /* _VK_BUFFER_MEMORY_H_ */
@@ -24,6 +24,8 @@
 
 #include "vkbufferpool.h"
 
+#include <gst/gstbufferpoolstats-private.h>
+
 /**
  * SECTION:vkbufferpool
  * @title: GstVulkanBufferPool
@@ -45,6 +47,8 @@ struct _GstVulkanBufferPoolPrivate
   GstVideoInfo v_info;
   gboolean add_videometa;
   gsize alloc_sizes[GST_VIDEO_MAX_PLANES];
+
+  GstBufferPoolStats stats;
 };
 
 static void gst_vulkan_buffer_pool_finalize (GObject * object);
@@ -168,7 +172,8 @@ gst_vulkan_buffer_pool_alloc (GstBufferPool * pool, GstBuffer ** buffer,
 
     mem = gst_vulkan_buffer_memory_alloc (vk_pool->device,
         vk_format, priv->alloc_sizes[i],
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
     if (!mem) {
       gst_buffer_unref (buf);
@@ -178,6 +183,8 @@ gst_vulkan_buffer_pool_alloc (GstBufferPool * pool, GstBuffer ** buffer,
     gst_buffer_append_memory (buf, mem);
   }
 
+  gst_buffer_pool_stats_allocated (&priv->stats);
+
   *buffer = buf;
 
   return GST_FLOW_OK;
@@ -195,6 +202,36 @@ mem_create_failed:
   }
 }
 
+static GstFlowReturn
+gst_vulkan_buffer_pool_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstVulkanBufferPoolPrivate *priv = GST_VULKAN_BUFFER_POOL_CAST (pool)->priv;
+
+  return gst_buffer_pool_stats_acquire_buffer (&priv->stats,
+      GST_BUFFER_POOL_CLASS (parent_class), pool, buffer, params);
+}
+
+static void
+gst_vulkan_buffer_pool_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstVulkanBufferPoolPrivate *priv = GST_VULKAN_BUFFER_POOL_CAST (pool)->priv;
+
+  gst_buffer_pool_stats_released (&priv->stats);
+
+  GST_BUFFER_POOL_CLASS (parent_class)->release_buffer (pool, buffer);
+}
+
+static gboolean
+gst_vulkan_buffer_pool_stop (GstBufferPool * pool)
+{
+  GstVulkanBufferPoolPrivate *priv = GST_VULKAN_BUFFER_POOL_CAST (pool)->priv;
+
+  gst_buffer_pool_stats_log (&priv->stats, pool);
+
+  return GST_BUFFER_POOL_CLASS (parent_class)->stop (pool);
+}
+
 /**
  * gst_vulkan_buffer_pool_new:
  * @context: the #GstGLContext to use
@@ -229,12 +266,16 @@ gst_vulkan_buffer_pool_class_init (GstVulkanBufferPoolClass * klass)
   gstbufferpool_class->get_options = gst_vulkan_buffer_pool_get_options;
   gstbufferpool_class->set_config = gst_vulkan_buffer_pool_set_config;
   gstbufferpool_class->alloc_buffer = gst_vulkan_buffer_pool_alloc;
+  gstbufferpool_class->acquire_buffer = gst_vulkan_buffer_pool_acquire_buffer;
+  gstbufferpool_class->release_buffer = gst_vulkan_buffer_pool_release_buffer;
+  gstbufferpool_class->stop = gst_vulkan_buffer_pool_stop;
 }
 
 static void
 gst_vulkan_buffer_pool_init (GstVulkanBufferPool * pool)
 {
   pool->priv = GST_VULKAN_BUFFER_POOL_GET_PRIVATE (pool);
+  gst_buffer_pool_stats_init (&pool->priv->stats);
 }
 
 static void
@@ -248,6 +289,8 @@ gst_vulkan_buffer_pool_finalize (GObject * object)
   if (priv->caps)
     gst_caps_unref (priv->caps);
 
+  gst_buffer_pool_stats_clear (&priv->stats);
+
   G_OBJECT_CLASS (gst_vulkan_buffer_pool_parent_class)->finalize (object);
 
   /* only release the context once all our memory have been deleted */
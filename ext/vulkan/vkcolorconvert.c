@@ -0,0 +1,1033 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vulkancolorconvert
+ * @title: vulkancolorconvert
+ *
+ * vulkancolorconvert converts and scales video frames to RGBA or BGRA with
+ * a Vulkan compute shader. Frames in system memory are copied into a
+ * staging ring and converted without waiting for the GPU.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 videotestsrc ! video/x-raw,format=I420 ! vulkancolorconvert ! video/x-raw,width=1920,height=1080 ! vulkansink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "vkcolorconvert.h"
+
+GST_DEBUG_CATEGORY (gst_debug_vulkan_color_convert);
+#define GST_CAT_DEFAULT gst_debug_vulkan_color_convert
+
+/* SPIR-V of shaders/colorconvert.comp, generated by glslc */
+static const guint32 colorconvert_comp[] =
+#include "colorconvert.comp.h"
+    ;
+
+/* keep in sync with shaders/colorconvert.comp */
+enum
+{
+  SHADER_FORMAT_RGBA,
+  SHADER_FORMAT_BGRA,
+  SHADER_FORMAT_I420,
+  SHADER_FORMAT_NV12,
+};
+
+struct ColorConvertParams
+{
+  gint32 size[4];
+  gint32 format[4];
+  gint32 strides[4];
+  gfloat yuv_range[4];
+  gfloat coeffs[4];
+};
+
+#define N_BINDINGS 4
+#define LOCAL_SIZE 16
+/* the number of frames converted by the GPU before waiting for it */
+#define MAX_IN_FLIGHT 8
+#define STAGING_RING_FRAMES 3
+
+typedef struct
+{
+  GstVulkanColorConvert *conv;
+  VkDescriptorSet set;
+  GstBuffer *inbuf;
+} FrameResources;
+
+static GstStaticPadTemplate gst_vulkan_color_convert_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER,
+            "{ RGBA, BGRA, I420, NV12 }") "; "
+        GST_VIDEO_CAPS_MAKE ("{ RGBA, BGRA, I420, NV12 }")));
+
+static GstStaticPadTemplate gst_vulkan_color_convert_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER, "{ RGBA, BGRA }")));
+
+static void gst_vulkan_color_convert_finalize (GObject * object);
+
+static gboolean gst_vulkan_color_convert_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query);
+static void gst_vulkan_color_convert_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_vulkan_color_convert_change_state (GstElement *
+    element, GstStateChange transition);
+
+static gboolean gst_vulkan_color_convert_stop (GstBaseTransform * bt);
+static GstCaps *gst_vulkan_color_convert_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static GstCaps *gst_vulkan_color_convert_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps);
+static gboolean gst_vulkan_color_convert_set_caps (GstBaseTransform * bt,
+    GstCaps * in_caps, GstCaps * out_caps);
+static gboolean gst_vulkan_color_convert_propose_allocation (GstBaseTransform *
+    bt, GstQuery * decide_query, GstQuery * query);
+static gboolean gst_vulkan_color_convert_decide_allocation (GstBaseTransform *
+    bt, GstQuery * query);
+static GstFlowReturn gst_vulkan_color_convert_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+
+#define gst_vulkan_color_convert_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVulkanColorConvert, gst_vulkan_color_convert,
+    GST_TYPE_BASE_TRANSFORM,
+    GST_DEBUG_CATEGORY_INIT (gst_debug_vulkan_color_convert,
+        "vulkancolorconvert", 0, "Vulkan Color Convert"));
+
+static void
+gst_vulkan_color_convert_class_init (GstVulkanColorConvertClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseTransformClass *gstbasetransform_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstelement_class = (GstElementClass *) klass;
+  gstbasetransform_class = (GstBaseTransformClass *) klass;
+
+  gst_element_class_set_metadata (gstelement_class, "Vulkan Color Convert",
+      "Filter/Converter/Video/Scaler", "Converts and scales video with Vulkan",
+      "Matthew Waters <matthew@centricular.com>");
+
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_color_convert_sink_template);
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_color_convert_src_template);
+
+  gobject_class->finalize = gst_vulkan_color_convert_finalize;
+
+  gstelement_class->change_state = gst_vulkan_color_convert_change_state;
+  gstelement_class->set_context = gst_vulkan_color_convert_set_context;
+  gstbasetransform_class->query =
+      GST_DEBUG_FUNCPTR (gst_vulkan_color_convert_query);
+  gstbasetransform_class->stop = gst_vulkan_color_convert_stop;
+  gstbasetransform_class->transform_caps =
+      gst_vulkan_color_convert_transform_caps;
+  gstbasetransform_class->fixate_caps = gst_vulkan_color_convert_fixate_caps;
+  gstbasetransform_class->set_caps = gst_vulkan_color_convert_set_caps;
+  gstbasetransform_class->propose_allocation =
+      gst_vulkan_color_convert_propose_allocation;
+  gstbasetransform_class->decide_allocation =
+      gst_vulkan_color_convert_decide_allocation;
+  gstbasetransform_class->transform = gst_vulkan_color_convert_transform;
+
+  gstbasetransform_class->passthrough_on_same_caps = TRUE;
+}
+
+static void
+gst_vulkan_color_convert_init (GstVulkanColorConvert * conv)
+{
+}
+
+static void
+gst_vulkan_color_convert_finalize (GObject * object)
+{
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+gst_vulkan_color_convert_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (bt);
+  gboolean res = FALSE;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:{
+      res = gst_vulkan_handle_context_query (GST_ELEMENT (conv), query,
+          &conv->display, &conv->instance, &conv->device);
+
+      if (res)
+        return res;
+      break;
+    }
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->query (bt, direction, query);
+}
+
+static void
+gst_vulkan_color_convert_set_context (GstElement * element,
+    GstContext * context)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (element);
+
+  gst_vulkan_handle_set_context (element, context, &conv->display,
+      &conv->instance);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static gboolean
+_choose_queue (GstVulkanDevice * device, GstVulkanQueue * queue,
+    GstVulkanQueue ** ret)
+{
+  guint flags = device->queue_family_props[queue->family].queueFlags;
+
+  if ((flags & VK_QUEUE_COMPUTE_BIT) != 0) {
+    *ret = gst_object_ref (queue);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstStateChangeReturn
+gst_vulkan_color_convert_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (element);
+  GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+
+  GST_DEBUG ("changing state: %s => %s",
+      gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (transition)),
+      gst_element_state_get_name (GST_STATE_TRANSITION_NEXT (transition)));
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_vulkan_ensure_element_data (element, &conv->display,
+              &conv->instance)) {
+        GST_ELEMENT_ERROR (conv, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan instance/display"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      if (!gst_vulkan_device_run_context_query (GST_ELEMENT (conv),
+              &conv->device)) {
+        GST_ELEMENT_ERROR (conv, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan device"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      gst_vulkan_device_foreach_queue (conv->device,
+          (GstVulkanDeviceForEachQueueFunc) _choose_queue, &conv->queue);
+      if (!conv->queue) {
+        GST_ELEMENT_ERROR (conv, RESOURCE, NOT_FOUND,
+            ("Failed to find a vulkan queue supporting compute"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      if (conv->queue)
+        gst_object_unref (conv->queue);
+      conv->queue = NULL;
+      if (conv->display)
+        gst_object_unref (conv->display);
+      conv->display = NULL;
+      if (conv->device)
+        gst_object_unref (conv->device);
+      conv->device = NULL;
+      if (conv->instance)
+        gst_object_unref (conv->instance);
+      conv->instance = NULL;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+_free_frame_resources (GstVulkanDevice * device, FrameResources * res)
+{
+  vkFreeDescriptorSets (device->device, res->conv->descriptor_pool, 1,
+      &res->set);
+  gst_buffer_unref (res->inbuf);
+  res->conv->n_in_flight--;
+
+  g_free (res);
+}
+
+static gboolean
+gst_vulkan_color_convert_stop (GstBaseTransform * bt)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (bt);
+
+  if (conv->trash_list && !gst_vulkan_trash_list_wait (conv->trash_list, -1))
+    GST_WARNING_OBJECT (conv, "Failed to wait for all fences to complete "
+        "before shutting down");
+  conv->trash_list = NULL;
+
+  if (conv->staging)
+    gst_vulkan_staging_ring_free (conv->staging);
+  conv->staging = NULL;
+
+  if (conv->pipeline)
+    vkDestroyPipeline (conv->device->device, conv->pipeline, NULL);
+  conv->pipeline = VK_NULL_HANDLE;
+
+  if (conv->pipeline_layout)
+    vkDestroyPipelineLayout (conv->device->device, conv->pipeline_layout,
+        NULL);
+  conv->pipeline_layout = VK_NULL_HANDLE;
+
+  if (conv->descriptor_pool)
+    vkDestroyDescriptorPool (conv->device->device, conv->descriptor_pool,
+        NULL);
+  conv->descriptor_pool = VK_NULL_HANDLE;
+
+  if (conv->descriptor_set_layout)
+    vkDestroyDescriptorSetLayout (conv->device->device,
+        conv->descriptor_set_layout, NULL);
+  conv->descriptor_set_layout = VK_NULL_HANDLE;
+
+  if (conv->shader)
+    vkDestroyShaderModule (conv->device->device, conv->shader, NULL);
+  conv->shader = VK_NULL_HANDLE;
+
+  return TRUE;
+}
+
+/* the pipeline doesn't depend on the formats, which are push constants, so
+ * it is only created once and the compiled shader is kept in the pipeline
+ * cache of the device across runs */
+static gboolean
+_create_pipeline (GstVulkanColorConvert * conv, GError ** error)
+{
+  VkDevice device = conv->device->device;
+  VkResult err;
+
+  if (conv->pipeline)
+    return TRUE;
+
+  {
+    VkShaderModuleCreateInfo info = { 0, };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof (colorconvert_comp);
+    info.pCode = colorconvert_comp;
+
+    err = vkCreateShaderModule (device, &info, NULL, &conv->shader);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreateShaderModule") < 0)
+      return FALSE;
+  }
+
+  {
+    VkDescriptorSetLayoutBinding bindings[N_BINDINGS];
+    VkDescriptorSetLayoutCreateInfo info = { 0, };
+    guint i;
+
+    for (i = 0; i < N_BINDINGS; i++) {
+      bindings[i].binding = i;
+      bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[i].descriptorCount = 1;
+      bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+      bindings[i].pImmutableSamplers = NULL;
+    }
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.bindingCount = N_BINDINGS;
+    info.pBindings = bindings;
+
+    err = vkCreateDescriptorSetLayout (device, &info, NULL,
+        &conv->descriptor_set_layout);
+    if (gst_vulkan_error_to_g_error (err, error,
+            "vkCreateDescriptorSetLayout") < 0)
+      return FALSE;
+  }
+
+  {
+    VkDescriptorPoolSize pool_size = { 0, };
+    VkDescriptorPoolCreateInfo info = { 0, };
+
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = N_BINDINGS * MAX_IN_FLIGHT;
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    info.maxSets = MAX_IN_FLIGHT;
+    info.poolSizeCount = 1;
+    info.pPoolSizes = &pool_size;
+
+    err = vkCreateDescriptorPool (device, &info, NULL, &conv->descriptor_pool);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreateDescriptorPool") < 0)
+      return FALSE;
+  }
+
+  {
+    VkPushConstantRange push_range = { 0, };
+    VkPipelineLayoutCreateInfo info = { 0, };
+
+    push_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_range.offset = 0;
+    push_range.size = sizeof (struct ColorConvertParams);
+
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.setLayoutCount = 1;
+    info.pSetLayouts = &conv->descriptor_set_layout;
+    info.pushConstantRangeCount = 1;
+    info.pPushConstantRanges = &push_range;
+
+    err = vkCreatePipelineLayout (device, &info, NULL, &conv->pipeline_layout);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreatePipelineLayout") < 0)
+      return FALSE;
+  }
+
+  {
+    VkComputePipelineCreateInfo info = { 0, };
+    VkPipelineCache cache;
+
+    cache = gst_vulkan_device_get_pipeline_cache (conv->device, NULL);
+
+    info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    info.stage.pNext = NULL;
+    info.stage.flags = 0;
+    info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    info.stage.module = conv->shader;
+    info.stage.pName = "main";
+    info.stage.pSpecializationInfo = NULL;
+    info.layout = conv->pipeline_layout;
+    info.basePipelineHandle = VK_NULL_HANDLE;
+    info.basePipelineIndex = -1;
+
+    err = vkCreateComputePipelines (device, cache, 1, &info, NULL,
+        &conv->pipeline);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreateComputePipelines") < 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gsize
+_storage_buffer_alignment (GstVulkanColorConvert * conv)
+{
+  return MAX (4,
+      conv->device->gpu_props.limits.minStorageBufferOffsetAlignment);
+}
+
+/* room for a few frames, each plane aligned for the storage buffer
+ * descriptors */
+static gsize
+_staging_ring_size (GstVulkanColorConvert * conv)
+{
+  gsize frame_size = GST_VIDEO_INFO_SIZE (&conv->in_info) +
+      GST_VIDEO_MAX_PLANES * _storage_buffer_alignment (conv);
+
+  return frame_size * STAGING_RING_FRAMES;
+}
+
+static GstCaps *
+_caps_remove_format_and_size (GstCaps * caps, const gchar * feature_name)
+{
+  GstCaps *ret;
+  guint i, n;
+
+  ret = gst_caps_new_empty ();
+
+  n = gst_caps_get_size (caps);
+  for (i = 0; i < n; i++) {
+    GstStructure *s = gst_caps_get_structure (caps, i);
+    GstCapsFeatures *f = gst_caps_get_features (caps, i);
+
+    /* skip if this is already included */
+    if (i > 0 && gst_caps_is_subset_structure_full (ret, s, f))
+      continue;
+
+    s = gst_structure_copy (s);
+    gst_structure_remove_fields (s, "format", "colorimetry", "chroma-site",
+        NULL);
+    gst_structure_set (s, "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+        "height", GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+    if (gst_structure_has_field (s, "pixel-aspect-ratio"))
+      gst_structure_set (s, "pixel-aspect-ratio", GST_TYPE_FRACTION_RANGE, 1,
+          G_MAXINT, G_MAXINT, 1, NULL);
+
+    gst_caps_append_structure_full (ret, s,
+        gst_caps_features_from_string (feature_name));
+  }
+
+  return ret;
+}
+
+static GstCaps *
+gst_vulkan_color_convert_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  GstCaps *result, *tmp, *templ;
+
+  if (direction == GST_PAD_SINK) {
+    tmp = _caps_remove_format_and_size (caps,
+        GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER);
+    templ = gst_static_pad_template_get_caps
+        (&gst_vulkan_color_convert_src_template);
+  } else {
+    tmp = _caps_remove_format_and_size (caps,
+        GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER);
+    tmp = gst_caps_merge (tmp, _caps_remove_format_and_size (caps,
+            GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY));
+    templ = gst_static_pad_template_get_caps
+        (&gst_vulkan_color_convert_sink_template);
+  }
+
+  result = gst_caps_intersect_full (tmp, templ, GST_CAPS_INTERSECT_FIRST);
+  gst_caps_unref (templ);
+  gst_caps_unref (tmp);
+
+  if (filter) {
+    tmp = gst_caps_intersect_full (filter, result, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (result);
+    result = tmp;
+  }
+
+  GST_DEBUG_OBJECT (bt, "transformed %" GST_PTR_FORMAT " into %"
+      GST_PTR_FORMAT, caps, result);
+
+  return result;
+}
+
+static GstCaps *
+gst_vulkan_color_convert_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  const GValue *par;
+  gint width, height;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  /* only scale when something downstream asks for it */
+  if (gst_structure_get_int (ins, "width", &width))
+    gst_structure_fixate_field_nearest_int (outs, "width", width);
+  if (gst_structure_get_int (ins, "height", &height))
+    gst_structure_fixate_field_nearest_int (outs, "height", height);
+  if ((par = gst_structure_get_value (ins, "pixel-aspect-ratio"))
+      && gst_structure_has_field (outs, "pixel-aspect-ratio"))
+    gst_structure_fixate_field_nearest_fraction (outs, "pixel-aspect-ratio",
+        gst_value_get_fraction_numerator (par),
+        gst_value_get_fraction_denominator (par));
+  if (direction == GST_PAD_SINK)
+    gst_structure_fixate_field_string (outs, "format", "RGBA");
+
+  return gst_caps_fixate (othercaps);
+}
+
+static gboolean
+gst_vulkan_color_convert_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
+    GstCaps * out_caps)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (bt);
+  GError *error = NULL;
+
+  if (!gst_video_info_from_caps (&conv->in_info, in_caps))
+    return FALSE;
+  if (!gst_video_info_from_caps (&conv->out_info, out_caps))
+    return FALSE;
+
+  if (!_create_pipeline (conv, &error)) {
+    GST_ELEMENT_ERROR (conv, RESOURCE, NOT_FOUND,
+        ("Failed to create the compute pipeline"), ("%s", error->message));
+    g_clear_error (&error);
+    return FALSE;
+  }
+
+  /* the staging ring is only created on the first frame in system memory */
+  if (conv->staging && conv->staging->size < _staging_ring_size (conv)) {
+    gst_vulkan_staging_ring_free (conv->staging);
+    conv->staging = NULL;
+  }
+
+  GST_DEBUG_OBJECT (bt, "set caps in: %" GST_PTR_FORMAT " out: %"
+      GST_PTR_FORMAT, in_caps, out_caps);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vulkan_color_convert_propose_allocation (GstBaseTransform * bt,
+    GstQuery * decide_query, GstQuery * query)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (bt);
+  GstCapsFeatures *features;
+  gboolean need_pool;
+  GstCaps *caps;
+
+  /* passthrough, we're done */
+  if (decide_query == NULL)
+    return TRUE;
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (caps == NULL)
+    return FALSE;
+
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  features = gst_caps_get_features (caps, 0);
+  if (need_pool && conv->device && gst_caps_features_contains (features,
+          GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER)) {
+    GstBufferPool *pool;
+    GstStructure *config;
+    GstVideoInfo info;
+
+    if (!gst_video_info_from_caps (&info, caps))
+      return FALSE;
+
+    pool = gst_vulkan_buffer_pool_new (conv->device);
+
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, info.size, 0, 0);
+
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      g_object_unref (pool);
+      return FALSE;
+    }
+
+    gst_query_add_allocation_pool (query, pool, info.size, 1, 0);
+    g_object_unref (pool);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_vulkan_color_convert_decide_allocation (GstBaseTransform * bt,
+    GstQuery * query)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (bt);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstCaps *caps;
+  guint min, max, size;
+  gboolean update_pool;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+  if (!caps)
+    return FALSE;
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+    update_pool = TRUE;
+  } else {
+    GstVideoInfo vinfo;
+
+    gst_video_info_init (&vinfo);
+    gst_video_info_from_caps (&vinfo, caps);
+    size = vinfo.size;
+    min = max = 0;
+    update_pool = FALSE;
+  }
+
+  /* the output is written by the shader, only vulkan buffers will do */
+  if (!pool || !GST_IS_VULKAN_BUFFER_POOL (pool)) {
+    if (pool)
+      gst_object_unref (pool);
+    pool = gst_vulkan_buffer_pool_new (conv->device);
+  }
+
+  config = gst_buffer_pool_get_config (pool);
+
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  gst_buffer_pool_set_config (pool, config);
+
+  if (update_pool)
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static void
+_fill_params (GstVulkanColorConvert * conv, struct ColorConvertParams *params,
+    const gint * in_strides)
+{
+  GstVideoInfo *in_info = &conv->in_info;
+  GstVideoInfo *out_info = &conv->out_info;
+  guint i;
+
+  params->size[0] = GST_VIDEO_INFO_WIDTH (in_info);
+  params->size[1] = GST_VIDEO_INFO_HEIGHT (in_info);
+  params->size[2] = GST_VIDEO_INFO_WIDTH (out_info);
+  params->size[3] = GST_VIDEO_INFO_HEIGHT (out_info);
+
+  switch (GST_VIDEO_INFO_FORMAT (in_info)) {
+    case GST_VIDEO_FORMAT_BGRA:
+      params->format[0] = SHADER_FORMAT_BGRA;
+      break;
+    case GST_VIDEO_FORMAT_I420:
+      params->format[0] = SHADER_FORMAT_I420;
+      break;
+    case GST_VIDEO_FORMAT_NV12:
+      params->format[0] = SHADER_FORMAT_NV12;
+      break;
+    default:
+      params->format[0] = SHADER_FORMAT_RGBA;
+      break;
+  }
+  params->format[1] =
+      GST_VIDEO_INFO_FORMAT (out_info) == GST_VIDEO_FORMAT_BGRA;
+  params->format[2] = GST_VIDEO_INFO_PLANE_STRIDE (out_info, 0);
+  params->format[3] = 0;
+
+  for (i = 0; i < 4; i++)
+    params->strides[i] = i < GST_VIDEO_INFO_N_PLANES (in_info) ?
+        in_strides[i] : 0;
+
+  if (GST_VIDEO_INFO_IS_YUV (in_info)) {
+    gdouble Kr = 0.299, Kb = 0.114, Kg;
+
+    gst_video_color_matrix_get_Kr_Kb (in_info->colorimetry.matrix, &Kr, &Kb);
+    Kg = 1.0 - Kr - Kb;
+
+    if (in_info->colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255) {
+      params->yuv_range[0] = 0.0;
+      params->yuv_range[2] = 1.0;
+      params->yuv_range[3] = 1.0;
+    } else {
+      params->yuv_range[0] = 16.0 / 255.0;
+      params->yuv_range[2] = 255.0 / 219.0;
+      params->yuv_range[3] = 255.0 / 224.0;
+    }
+    params->yuv_range[1] = 128.0 / 255.0;
+
+    params->coeffs[0] = 2.0 * (1.0 - Kr);
+    params->coeffs[1] = -2.0 * Kb * (1.0 - Kb) / Kg;
+    params->coeffs[2] = -2.0 * Kr * (1.0 - Kr) / Kg;
+    params->coeffs[3] = 2.0 * (1.0 - Kb);
+  } else {
+    memset (params->yuv_range, 0, sizeof (params->yuv_range));
+    memset (params->coeffs, 0, sizeof (params->coeffs));
+  }
+}
+
+/* copies the planes of @inbuf into the staging ring */
+static gboolean
+_stage_frame (GstVulkanColorConvert * conv, GstBuffer * inbuf,
+    VkDescriptorBufferInfo * buffers, gint * strides, GError ** error)
+{
+  GstVideoFrame frame;
+  guint i;
+
+  if (!conv->staging) {
+    conv->staging = gst_vulkan_staging_ring_new (conv->device,
+        _staging_ring_size (conv), error);
+    if (!conv->staging)
+      return FALSE;
+  }
+
+  if (!gst_video_frame_map (&frame, &conv->in_info, inbuf, GST_MAP_READ)) {
+    g_set_error_literal (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Failed to map the input frame");
+    return FALSE;
+  }
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&frame); i++) {
+    gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, i);
+    guint height = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, i);
+    const guint8 *src = GST_VIDEO_FRAME_PLANE_DATA (&frame, i);
+    gsize offset;
+    guint8 *dest;
+
+    if (!gst_vulkan_staging_ring_alloc (conv->staging, stride * height,
+            _storage_buffer_alignment (conv), &offset, &dest, error)) {
+      gst_video_frame_unmap (&frame);
+      return FALSE;
+    }
+
+    memcpy (dest, src, stride * height);
+
+    buffers[i].buffer = conv->staging->mem->buffer;
+    buffers[i].offset = offset;
+    buffers[i].range = stride * height;
+    strides[i] = stride;
+  }
+
+  gst_video_frame_unmap (&frame);
+
+  return TRUE;
+}
+
+static gboolean
+_bind_buffer (GstBuffer * buffer, guint n_planes,
+    VkDescriptorBufferInfo * buffers)
+{
+  guint i;
+
+  if (gst_buffer_n_memory (buffer) < n_planes)
+    return FALSE;
+
+  for (i = 0; i < n_planes; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+
+    if (!gst_is_vulkan_buffer_memory (mem))
+      return FALSE;
+
+    buffers[i].buffer = ((GstVulkanBufferMemory *) mem)->buffer;
+    buffers[i].offset = 0;
+    buffers[i].range = VK_WHOLE_SIZE;
+  }
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_vulkan_color_convert_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (bt);
+  VkDescriptorBufferInfo buffers[N_BINDINGS] = { {0,}, };
+  struct ColorConvertParams params;
+  gint strides[GST_VIDEO_MAX_PLANES] = { 0, };
+  VkCommandBuffer cmd = VK_NULL_HANDLE;
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  GstVulkanFence *fence = NULL;
+  FrameResources *res;
+  GError *error = NULL;
+  guint n_planes, i;
+  VkResult err;
+
+  conv->trash_list = gst_vulkan_trash_list_gc (conv->trash_list);
+
+  /* bound the number of descriptor sets and buffers held by the GPU, the
+   * oldest submission is last in the list */
+  while (conv->n_in_flight >= MAX_IN_FLIGHT) {
+    GstVulkanTrash *oldest = g_list_last (conv->trash_list)->data;
+    VkFence fences[1] = { GST_VULKAN_FENCE_FENCE (oldest->fence) };
+
+    err = vkWaitForFences (conv->device->device, 1, fences, TRUE, G_MAXUINT64);
+    if (gst_vulkan_error_to_g_error (err, &error, "vkWaitForFences") < 0)
+      goto error;
+    conv->trash_list = gst_vulkan_trash_list_gc (conv->trash_list);
+  }
+
+  n_planes = GST_VIDEO_INFO_N_PLANES (&conv->in_info);
+  if (_bind_buffer (inbuf, n_planes, buffers)) {
+    GstVideoMeta *meta = gst_buffer_get_video_meta (inbuf);
+
+    for (i = 0; i < n_planes; i++)
+      strides[i] = meta ? meta->stride[i] :
+          GST_VIDEO_INFO_PLANE_STRIDE (&conv->in_info, i);
+  } else if (!_stage_frame (conv, inbuf, buffers, strides, &error)) {
+    goto error;
+  }
+  /* unused input bindings still need a valid buffer */
+  for (i = n_planes; i < N_BINDINGS - 1; i++)
+    buffers[i] = buffers[0];
+
+  if (!_bind_buffer (outbuf, 1, &buffers[N_BINDINGS - 1])) {
+    g_set_error_literal (&error, GST_RESOURCE_ERROR,
+        GST_RESOURCE_ERROR_WRITE, "The output buffer is not a vulkan buffer");
+    goto error;
+  }
+
+  _fill_params (conv, &params, strides);
+
+  {
+    VkDescriptorSetAllocateInfo info = { 0, };
+    VkWriteDescriptorSet writes[N_BINDINGS];
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.descriptorPool = conv->descriptor_pool;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &conv->descriptor_set_layout;
+
+    err = vkAllocateDescriptorSets (conv->device->device, &info, &set);
+    if (gst_vulkan_error_to_g_error (err, &error,
+            "vkAllocateDescriptorSets") < 0)
+      goto error;
+
+    for (i = 0; i < N_BINDINGS; i++) {
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].pNext = NULL;
+      writes[i].dstSet = set;
+      writes[i].dstBinding = i;
+      writes[i].dstArrayElement = 0;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[i].pImageInfo = NULL;
+      writes[i].pBufferInfo = &buffers[i];
+      writes[i].pTexelBufferView = NULL;
+    }
+
+    vkUpdateDescriptorSets (conv->device->device, N_BINDINGS, writes, 0, NULL);
+  }
+
+  {
+    VkCommandBufferAllocateInfo cmd_info = { 0, };
+    VkCommandBufferBeginInfo begin_info = { 0, };
+
+    cmd_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmd_info.pNext = NULL;
+    cmd_info.commandPool = conv->device->cmd_pool;
+    cmd_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmd_info.commandBufferCount = 1;
+
+    err = vkAllocateCommandBuffers (conv->device->device, &cmd_info, &cmd);
+    if (gst_vulkan_error_to_g_error (err, &error,
+            "vkAllocateCommandBuffers") < 0)
+      goto error;
+
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.pNext = NULL;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    begin_info.pInheritanceInfo = NULL;
+
+    err = vkBeginCommandBuffer (cmd, &begin_info);
+    if (gst_vulkan_error_to_g_error (err, &error, "vkBeginCommandBuffer") < 0)
+      goto error;
+  }
+
+  {
+    VkMemoryBarrier barrier = { 0, };
+
+    vkCmdBindPipeline (cmd, VK_PIPELINE_BIND_POINT_COMPUTE, conv->pipeline);
+    vkCmdBindDescriptorSets (cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+        conv->pipeline_layout, 0, 1, &set, 0, NULL);
+    vkCmdPushConstants (cmd, conv->pipeline_layout,
+        VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (params), &params);
+    vkCmdDispatch (cmd,
+        (GST_VIDEO_INFO_WIDTH (&conv->out_info) + LOCAL_SIZE - 1) / LOCAL_SIZE,
+        (GST_VIDEO_INFO_HEIGHT (&conv->out_info) + LOCAL_SIZE - 1) / LOCAL_SIZE,
+        1);
+
+    /* make the output visible to whatever reads it next */
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+    vkCmdPipelineBarrier (cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+  }
+
+  err = vkEndCommandBuffer (cmd);
+  if (gst_vulkan_error_to_g_error (err, &error, "vkEndCommandBuffer") < 0)
+    goto error;
+
+  fence = gst_vulkan_fence_new (conv->device, 0, &error);
+  if (!fence)
+    goto error;
+
+  {
+    VkSubmitInfo submit_info = { 0, };
+
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = NULL;
+    submit_info.waitSemaphoreCount = 0;
+    submit_info.pWaitSemaphores = NULL;
+    submit_info.pWaitDstStageMask = NULL;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &cmd;
+    submit_info.signalSemaphoreCount = 0;
+    submit_info.pSignalSemaphores = NULL;
+
+    /* the queue may be used by other elements from other threads */
+    GST_OBJECT_LOCK (conv->device);
+    err = vkQueueSubmit (conv->queue->queue, 1, &submit_info,
+        GST_VULKAN_FENCE_FENCE (fence));
+    GST_OBJECT_UNLOCK (conv->device);
+    if (gst_vulkan_error_to_g_error (err, &error, "vkQueueSubmit") < 0)
+      goto error;
+  }
+
+  if (conv->staging)
+    gst_vulkan_staging_ring_submit (conv->staging, fence);
+
+  /* the input buffer and the descriptor set are released once the GPU is
+   * done with them, without blocking the streaming thread */
+  res = g_new0 (FrameResources, 1);
+  res->conv = conv;
+  res->set = set;
+  res->inbuf = gst_buffer_ref (inbuf);
+  conv->n_in_flight++;
+
+  conv->trash_list = g_list_prepend (conv->trash_list,
+      gst_vulkan_trash_new_free_command_buffer (gst_vulkan_fence_ref (fence),
+          cmd));
+  conv->trash_list = g_list_prepend (conv->trash_list,
+      gst_vulkan_trash_new (fence, (GstVulkanTrashNotify) _free_frame_resources,
+          res));
+
+  return GST_FLOW_OK;
+
+error:
+  if (fence)
+    gst_vulkan_fence_unref (fence);
+  if (cmd)
+    vkFreeCommandBuffers (conv->device->device, conv->device->cmd_pool, 1,
+        &cmd);
+  if (set)
+    vkFreeDescriptorSets (conv->device->device, conv->descriptor_pool, 1, &set);
+  GST_ELEMENT_ERROR (conv, RESOURCE, FAILED, ("%s", error->message), (NULL));
+  g_clear_error (&error);
+  return GST_FLOW_ERROR;
+}
@@ -53,6 +53,8 @@ static void gst_vulkan_device_finalize (GObject * object);
 struct _GstVulkanDevicePrivate
 {
   gboolean opened;
+
+  VkPipelineCache pipeline_cache;
 };
 
 GstVulkanDevice *
@@ -86,11 +88,71 @@ gst_vulkan_device_class_init (GstVulkanDeviceClass * device_class)
   gobject_class->finalize = gst_vulkan_device_finalize;
 }
 
+static gchar *
+_pipeline_cache_filename (GstVulkanDevice * device)
+{
+  gchar *basename, *filename;
+
+  basename = g_strdup_printf ("pipeline-cache-%08x-%08x.bin",
+      device->gpu_props.vendorID, device->gpu_props.deviceID);
+  filename = g_build_filename (g_get_user_cache_dir (),
+      "gstreamer-" GST_API_VERSION, "vulkan", basename, NULL);
+  g_free (basename);
+
+  return filename;
+}
+
+static void
+_save_pipeline_cache (GstVulkanDevice * device)
+{
+  gchar *filename, *dirname;
+  GError *error = NULL;
+  gsize size = 0;
+  gpointer data;
+  VkResult err;
+
+  err = vkGetPipelineCacheData (device->device, device->priv->pipeline_cache,
+      &size, NULL);
+  if (err != VK_SUCCESS || size == 0)
+    return;
+
+  data = g_malloc (size);
+  err = vkGetPipelineCacheData (device->device, device->priv->pipeline_cache,
+      &size, data);
+  if (err != VK_SUCCESS) {
+    g_free (data);
+    return;
+  }
+
+  filename = _pipeline_cache_filename (device);
+  dirname = g_path_get_dirname (filename);
+  g_mkdir_with_parents (dirname, 0755);
+  if (!g_file_set_contents (filename, data, size, &error)) {
+    GST_WARNING_OBJECT (device, "Failed to save the pipeline cache: %s",
+        error->message);
+    g_clear_error (&error);
+  } else {
+    GST_DEBUG_OBJECT (device, "saved %" G_GSIZE_FORMAT " bytes of pipeline "
+        "cache to %s", size, filename);
+  }
+
+  g_free (dirname);
+  g_free (filename);
+  g_free (data);
+}
+
 static void
 gst_vulkan_device_finalize (GObject * object)
 {
   GstVulkanDevice *device = GST_VULKAN_DEVICE (object);
 
+  if (device->priv->pipeline_cache) {
+    _save_pipeline_cache (device);
+    vkDestroyPipelineCache (device->device, device->priv->pipeline_cache,
+        NULL);
+  }
+  device->priv->pipeline_cache = VK_NULL_HANDLE;
+
   g_free (device->queue_family_props);
   device->queue_family_props = NULL;
 
@@ -417,6 +479,59 @@ gst_vulkan_device_get_physical_device (GstVulkanDevice * device)
   return device->instance->physical_devices[device->device_index];
 }
 
+/**
+ * gst_vulkan_device_get_pipeline_cache:
+ * @device: a #GstVulkanDevice
+ * @error: a #GError
+ *
+ * Returns the pipeline cache shared by all the pipelines created on @device.
+ * Its contents are saved to the user cache directory when @device is
+ * destroyed and loaded back the next time, avoiding the compilation of the
+ * shaders on every run.
+ *
+ * Returns: the #VkPipelineCache of @device, or %VK_NULL_HANDLE
+ */
+VkPipelineCache
+gst_vulkan_device_get_pipeline_cache (GstVulkanDevice * device,
+    GError ** error)
+{
+  VkPipelineCacheCreateInfo cache_info = { 0, };
+  gchar *filename, *contents = NULL;
+  gsize size = 0;
+  VkResult err;
+
+  g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), VK_NULL_HANDLE);
+  g_return_val_if_fail (device->device != NULL, VK_NULL_HANDLE);
+
+  GST_OBJECT_LOCK (device);
+  if (device->priv->pipeline_cache)
+    goto done;
+
+  /* the driver discards the data if it was created for another one */
+  filename = _pipeline_cache_filename (device);
+  if (g_file_get_contents (filename, &contents, &size, NULL))
+    GST_DEBUG_OBJECT (device, "loading %" G_GSIZE_FORMAT " bytes of pipeline "
+        "cache from %s", size, filename);
+  g_free (filename);
+
+  cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cache_info.pNext = NULL;
+  cache_info.flags = 0;
+  cache_info.initialDataSize = size;
+  cache_info.pInitialData = contents;
+
+  err = vkCreatePipelineCache (device->device, &cache_info, NULL,
+      &device->priv->pipeline_cache);
+  g_free (contents);
+  if (gst_vulkan_error_to_g_error (err, error, "vkCreatePipelineCache") < 0)
+    device->priv->pipeline_cache = VK_NULL_HANDLE;
+
+done:
+  GST_OBJECT_UNLOCK (device);
+
+  return device->priv->pipeline_cache;
+}
+
 gboolean
 gst_vulkan_device_create_cmd_buffer (GstVulkanDevice * device,
     VkCommandBuffer * cmd, GError ** error)
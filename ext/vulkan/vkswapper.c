@@ -556,9 +556,11 @@ _swapper_set_image_layout (GstVulkanSwapper * swapper,
     submit_info.signalSemaphoreCount = 0;
     submit_info.pSignalSemaphores = NULL;
 
+    GST_OBJECT_LOCK (swapper->device);
     err =
         vkQueueSubmit (swapper->queue->queue, 1, &submit_info,
         GST_VULKAN_FENCE_FENCE (fence));
+    GST_OBJECT_UNLOCK (swapper->device);
     if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
       goto error;
   }
@@ -958,9 +960,11 @@ reacquire:
     if (!fence)
       goto error;
 
+    GST_OBJECT_LOCK (swapper->device);
     err =
         vkQueueSubmit (swapper->queue->queue, 1, &submit_info,
         GST_VULKAN_FENCE_FENCE (fence));
+    GST_OBJECT_UNLOCK (swapper->device);
     if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
       goto error;
 
@@ -983,7 +987,9 @@ reacquire:
   present.pImageIndices = &swap_idx;
   present.pResults = &present_err;
 
+  GST_OBJECT_LOCK (swapper->device);
   err = swapper->QueuePresentKHR (swapper->queue->queue, &present);
+  GST_OBJECT_UNLOCK (swapper->device);
   if (gst_vulkan_error_to_g_error (err, error, "vkQueuePresentKHR") < 0)
     goto error;
 
@@ -1006,9 +1012,11 @@ reacquire:
     if (!fence)
       goto error;
 
+    GST_OBJECT_LOCK (swapper->device);
     err =
         vkQueueSubmit (swapper->queue->queue, 1, &submit_info,
         GST_VULKAN_FENCE_FENCE (fence));
+    GST_OBJECT_UNLOCK (swapper->device);
     if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
       goto error;
 
@@ -50,6 +50,8 @@
 #include <gst/wayland/wayland.h>
 #include <gst/video/videooverlay.h>
 
+#include <time.h>
+
 /* signals */
 enum
 {
@@ -170,6 +172,10 @@ gst_wayland_sink_init (GstWaylandSink * sink)
 {
   g_mutex_init (&sink->display_lock);
   g_mutex_init (&sink->render_lock);
+
+  sink->refresh = GST_CLOCK_TIME_NONE;
+  sink->display_latency = GST_CLOCK_TIME_NONE;
+  sink->render_delay = 0;
 }
 
 static void
@@ -565,6 +571,101 @@ static const struct wl_callback_listener frame_callback_listener = {
   frame_redraw_callback
 };
 
+typedef struct
+{
+  GstWaylandSink *sink;
+  GstClockTime commit_time;
+} PresentationFeedbackData;
+
+static GstClockTime
+presentation_clock_now (GstWlDisplay * display)
+{
+  struct timespec ts;
+
+  if (clock_gettime (display->presentation_clock_id, &ts) < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+static void
+presentation_sync_output (void *data,
+    struct wp_presentation_feedback *feedback, struct wl_output *output)
+{
+}
+
+/* Called from the display thread when the compositor has shown a frame.
+ * The time between the commit and the presentation is the latency of the
+ * display, which we compensate with the render delay of the base class so
+ * that frames get on screen at their running time instead of one or more
+ * refresh cycles later. */
+static void
+presentation_presented (void *data, struct wp_presentation_feedback *feedback,
+    uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec, uint32_t refresh,
+    uint32_t seq_hi, uint32_t seq_lo, uint32_t flags)
+{
+  PresentationFeedbackData *fb = data;
+  GstWaylandSink *sink = fb->sink;
+  GstClockTime presented, latency, render_delay, refresh_time;
+  gboolean update = FALSE;
+
+  presented = (((guint64) tv_sec_hi << 32) | tv_sec_lo) * GST_SECOND + tv_nsec;
+
+  g_mutex_lock (&sink->render_lock);
+  if (refresh != 0)
+    sink->refresh = refresh;
+
+  if (GST_CLOCK_TIME_IS_VALID (fb->commit_time) && presented > fb->commit_time) {
+    latency = presented - fb->commit_time;
+    if (GST_CLOCK_TIME_IS_VALID (sink->display_latency))
+      sink->display_latency = (7 * sink->display_latency + latency) / 8;
+    else
+      sink->display_latency = latency;
+
+    /* leave the render delay alone once the application changed it */
+    render_delay = gst_base_sink_get_render_delay (GST_BASE_SINK (sink));
+    if (render_delay == sink->render_delay &&
+        ABS (GST_CLOCK_DIFF (render_delay, sink->display_latency)) >
+        GST_MSECOND) {
+      sink->render_delay = sink->display_latency;
+      update = TRUE;
+    }
+  }
+  render_delay = sink->render_delay;
+  refresh_time = sink->refresh;
+  g_mutex_unlock (&sink->render_lock);
+
+  GST_LOG_OBJECT (sink, "frame %" G_GUINT64_FORMAT " presented, refresh %u "
+      "ns, flags 0x%x", ((guint64) seq_hi << 32) | seq_lo, refresh, flags);
+
+  if (update) {
+    GST_DEBUG_OBJECT (sink, "display latency now %" GST_TIME_FORMAT
+        ", refresh period %" GST_TIME_FORMAT, GST_TIME_ARGS (render_delay),
+        GST_TIME_ARGS (refresh_time));
+    gst_base_sink_set_render_delay (GST_BASE_SINK (sink), render_delay);
+    gst_element_post_message (GST_ELEMENT (sink),
+        gst_message_new_latency (GST_OBJECT (sink)));
+  }
+
+  wp_presentation_feedback_destroy (feedback);
+  g_slice_free (PresentationFeedbackData, fb);
+}
+
+static void
+presentation_discarded (void *data, struct wp_presentation_feedback *feedback)
+{
+  GST_LOG ("frame discarded");
+
+  wp_presentation_feedback_destroy (feedback);
+  g_slice_free (PresentationFeedbackData, data);
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+  presentation_sync_output,
+  presentation_presented,
+  presentation_discarded
+};
+
 /* must be called with the render lock */
 static void
 render_last_buffer (GstWaylandSink * sink)
@@ -581,6 +682,16 @@ render_last_buffer (GstWaylandSink * sink)
   callback = wl_surface_frame (surface);
   wl_callback_add_listener (callback, &frame_callback_listener, sink);
 
+  if (sink->display->presentation) {
+    PresentationFeedbackData *fb = g_slice_new (PresentationFeedbackData);
+    struct wp_presentation_feedback *feedback;
+
+    fb->sink = sink;
+    fb->commit_time = presentation_clock_now (sink->display);
+    feedback = wp_presentation_feedback (sink->display->presentation, surface);
+    wp_presentation_feedback_add_listener (feedback, &feedback_listener, fb);
+  }
+
   if (G_UNLIKELY (sink->video_info_changed)) {
     info = &sink->video_info;
     sink->video_info_changed = FALSE;
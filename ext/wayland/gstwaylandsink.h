@@ -66,6 +66,11 @@ struct _GstWaylandSink
   gboolean redraw_pending;
   GMutex render_lock;
   GstBuffer *last_buffer;
+
+  /* learnt from presentation feedback, protected by the render lock */
+  GstClockTime refresh;
+  GstClockTime display_latency;
+  GstClockTime render_delay;    /* the render delay we set last */
 };
 
 struct _GstWaylandSinkClass
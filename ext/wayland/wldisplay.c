@@ -87,6 +87,9 @@ gst_wl_display_finalize (GObject * gobject)
   if (self->dmabuf)
     zwp_linux_dmabuf_v1_destroy (self->dmabuf);
 
+  if (self->presentation)
+    wp_presentation_destroy (self->presentation);
+
   if (self->shell)
     wl_shell_destroy (self->shell);
 
@@ -163,6 +166,19 @@ dmabuf_format (void *data, struct zwp_linux_dmabuf_v1 *zwp_linux_dmabuf,
     g_array_append_val (self->dmabuf_formats, format);
 }
 
+static void
+presentation_clock_id (void *data, struct wp_presentation *presentation,
+    uint32_t clk_id)
+{
+  GstWlDisplay *self = data;
+
+  self->presentation_clock_id = clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+  presentation_clock_id,
+};
+
 static const struct zwp_linux_dmabuf_v1_listener dmabuf_listener = {
   dmabuf_format,
 };
@@ -232,9 +248,21 @@ registry_handle_global (void *data, struct wl_registry *registry,
     self->viewporter =
         wl_registry_bind (registry, id, &wp_viewporter_interface, 1);
   } else if (g_strcmp0 (interface, "zwp_linux_dmabuf_v1") == 0) {
-    self->dmabuf =
-        wl_registry_bind (registry, id, &zwp_linux_dmabuf_v1_interface, 1);
+    guint dmabuf_version = 1;
+
+    /* version 2 adds create_immed, version 3 replaces the format events
+     * with modifier events that we don't handle */
+#ifdef ZWP_LINUX_BUFFER_PARAMS_V1_CREATE_IMMED_SINCE_VERSION
+    dmabuf_version = MIN (version, 2);
+#endif
+    self->dmabuf = wl_registry_bind (registry, id,
+        &zwp_linux_dmabuf_v1_interface, dmabuf_version);
     zwp_linux_dmabuf_v1_add_listener (self->dmabuf, &dmabuf_listener, self);
+  } else if (g_strcmp0 (interface, "wp_presentation") == 0) {
+    self->presentation =
+        wl_registry_bind (registry, id, &wp_presentation_interface, 1);
+    wp_presentation_add_listener (self->presentation, &presentation_listener,
+        self);
   }
 }
 
@@ -26,6 +26,7 @@
 #include <wayland-client.h>
 #include "viewporter-client-protocol.h"
 #include "linux-dmabuf-unstable-v1-client-protocol.h"
+#include "presentation-time-client-protocol.h"
 
 G_BEGIN_DECLS
 
@@ -55,6 +56,8 @@ struct _GstWlDisplay
   struct wl_shm *shm;
   struct wp_viewporter *viewporter;
   struct zwp_linux_dmabuf_v1 *dmabuf;
+  struct wp_presentation *presentation;
+  guint32 presentation_clock_id;
   GArray *shm_formats;
   GArray *dmabuf_formats;
 
@@ -131,6 +131,19 @@ gst_wl_linux_dmabuf_construct_wl_buffer (GstBuffer * buf,
     }
   }
 
+#ifdef ZWP_LINUX_BUFFER_PARAMS_V1_CREATE_IMMED_SINCE_VERSION
+  /* Create the buffer without waiting for a round-trip to the compositor.
+   * If it can't import the buffer after all, it sends a failed event and the
+   * buffer just never shows up on screen. */
+  if (wl_proxy_get_version ((struct wl_proxy *) params) >=
+      ZWP_LINUX_BUFFER_PARAMS_V1_CREATE_IMMED_SINCE_VERSION) {
+    data.wbuf = zwp_linux_buffer_params_v1_create_immed (params, width, height,
+        format, flags);
+    zwp_linux_buffer_params_v1_destroy (params);
+    goto out;
+  }
+#endif
+
   /* Request buffer creation */
   zwp_linux_buffer_params_v1_add_listener (params, &params_listener, &data);
   zwp_linux_buffer_params_v1_create (params, width, height, format, flags);
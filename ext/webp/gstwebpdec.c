@@ -425,7 +425,11 @@ gst_webp_dec_handle_frame (GstVideoDecoder * decoder,
   GstFlowReturn ret = GST_FLOW_OK;
   GstVideoFrame vframe;
 
-  gst_buffer_map (frame->input_buffer, &map_info, GST_MAP_READ);
+  if (!gst_buffer_map (frame->input_buffer, &map_info, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (decoder, "Failed to map input buffer");
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
 
   ret = gst_webp_dec_update_src_caps (webpdec, &map_info);
   if (ret != GST_FLOW_OK) {
@@ -444,8 +448,10 @@ gst_webp_dec_handle_frame (GstVideoDecoder * decoder,
     goto done;
   }
 
+  /* libwebp decodes straight into the downstream buffer, which is only ever
+   * written to */
   if (!gst_video_frame_map (&vframe, &webpdec->output_state->info,
-          frame->output_buffer, GST_MAP_READWRITE)) {
+          frame->output_buffer, GST_MAP_WRITE)) {
     GST_ERROR_OBJECT (decoder, "Failed to map output videoframe");
     ret = GST_FLOW_ERROR;
     gst_buffer_unmap (frame->input_buffer, &map_info);
@@ -459,10 +465,12 @@ gst_webp_dec_handle_frame (GstVideoDecoder * decoder,
   webpdec->config.options.no_fancy_upsampling = webpdec->no_fancy_upsampling;
   webpdec->config.options.use_threads = webpdec->use_threads;
   webpdec->config.output.colorspace = webpdec->colorspace;
-  webpdec->config.output.u.RGBA.rgba = (uint8_t *) vframe.map[0].data;
+  webpdec->config.output.u.RGBA.rgba =
+      (uint8_t *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0);
   webpdec->config.output.u.RGBA.stride =
       GST_VIDEO_FRAME_COMP_STRIDE (&vframe, 0);
-  webpdec->config.output.u.RGBA.size = GST_VIDEO_FRAME_SIZE (&vframe);
+  webpdec->config.output.u.RGBA.size =
+      vframe.map[0].size - GST_VIDEO_FRAME_PLANE_OFFSET (&vframe, 0);
   webpdec->config.output.is_external_memory = 1;
 
   if (WebPDecode (map_info.data, map_info.size,
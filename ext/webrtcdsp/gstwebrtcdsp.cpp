@@ -315,8 +315,9 @@ webrtc_error_to_string (gint err)
   return str;
 }
 
+/* Takes as many complete 10ms periods as available from the adapter */
 static GstBuffer *
-gst_webrtc_dsp_take_buffer (GstWebrtcDsp * self)
+gst_webrtc_dsp_take_buffer (GstWebrtcDsp * self, guint n_periods)
 {
   GstBuffer *buffer;
   GstClockTime timestamp;
@@ -326,10 +327,11 @@ gst_webrtc_dsp_take_buffer (GstWebrtcDsp * self)
   timestamp += gst_util_uint64_scale_int (distance / self->info.bpf,
       GST_SECOND, self->info.rate);
 
-  buffer = gst_adapter_take_buffer (self->adapter, self->period_size);
+  buffer = gst_adapter_take_buffer (self->adapter,
+      n_periods * self->period_size);
 
   GST_BUFFER_PTS (buffer) = timestamp;
-  GST_BUFFER_DURATION (buffer) = 10 * GST_MSECOND;
+  GST_BUFFER_DURATION (buffer) = n_periods * 10 * GST_MSECOND;
 
   if (gst_adapter_pts_at_discont (self->adapter) == timestamp && distance == 0) {
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
@@ -414,11 +416,11 @@ gst_webrtc_vad_post_message (GstWebrtcDsp *self, GstClockTime timestamp,
       gst_message_new_element (GST_OBJECT (self), s));
 }
 
-static GstFlowReturn
-gst_webrtc_dsp_process_stream (GstWebrtcDsp * self,
-    GstBuffer * buffer)
+/* Filters one 10ms period in place, @data points into the mapped buffer */
+static void
+gst_webrtc_dsp_process_stream (GstWebrtcDsp * self, guint8 * data,
+    GstClockTime timestamp)
 {
-  GstMapInfo info;
   webrtc::AudioProcessing * apm = self->apm;
   webrtc::AudioFrame frame;
   gint err;
@@ -427,12 +429,7 @@ gst_webrtc_dsp_process_stream (GstWebrtcDsp * self,
   frame.sample_rate_hz_ = self->info.rate;
   frame.samples_per_channel_ = self->period_size / self->info.bpf;
 
-  if (!gst_buffer_map (buffer, &info, (GstMapFlags) GST_MAP_READWRITE)) {
-    gst_buffer_unref (buffer);
-    return GST_FLOW_ERROR;
-  }
-
-  memcpy (frame.data_, info.data, self->period_size);
+  memcpy (frame.data_, data, self->period_size);
 
   if ((err = apm->ProcessStream (&frame)) < 0) {
     GST_WARNING_OBJECT (self, "Failed to filter the audio: %s.",
@@ -442,16 +439,12 @@ gst_webrtc_dsp_process_stream (GstWebrtcDsp * self,
       gboolean stream_has_voice = apm->voice_detection ()->stream_has_voice ();
 
       if (stream_has_voice != self->stream_has_voice)
-        gst_webrtc_vad_post_message (self, GST_BUFFER_PTS (buffer), stream_has_voice);
+        gst_webrtc_vad_post_message (self, timestamp, stream_has_voice);
 
       self->stream_has_voice = stream_has_voice;
     }
-    memcpy (info.data, frame.data_, self->period_size);
+    memcpy (data, frame.data_, self->period_size);
   }
-
-  gst_buffer_unmap (buffer, &info);
-
-  return GST_FLOW_OK;
 }
 
 static GstFlowReturn
@@ -479,18 +472,41 @@ static GstFlowReturn
 gst_webrtc_dsp_generate_output (GstBaseTransform * btrans, GstBuffer ** outbuf)
 {
   GstWebrtcDsp *self = GST_WEBRTC_DSP (btrans);
-  GstFlowReturn ret;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime timestamp;
+  GstMapInfo info;
+  guint n_periods, i;
 
-  if (gst_adapter_available (self->adapter) < self->period_size) {
+  n_periods = gst_adapter_available (self->adapter) / self->period_size;
+  if (n_periods == 0) {
     *outbuf = NULL;
     return GST_FLOW_OK;
   }
 
-  *outbuf = gst_webrtc_dsp_take_buffer (self);
-  ret = gst_webrtc_dsp_analyze_reverse_stream (self, GST_BUFFER_PTS (*outbuf));
+  /* The library works on 10ms periods, but all the periods that are
+   * available are filtered in place in one output buffer, so that large
+   * input buffers don't get split into many small ones */
+  *outbuf = gst_webrtc_dsp_take_buffer (self, n_periods);
+
+  if (!gst_buffer_map (*outbuf, &info, (GstMapFlags) GST_MAP_READWRITE))
+    return GST_FLOW_ERROR;
+
+  timestamp = GST_BUFFER_PTS (*outbuf);
+  for (i = 0; i < n_periods; i++) {
+    GstClockTime period_time = timestamp;
+
+    if (GST_CLOCK_TIME_IS_VALID (timestamp))
+      period_time += i * 10 * GST_MSECOND;
+
+    ret = gst_webrtc_dsp_analyze_reverse_stream (self, period_time);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    gst_webrtc_dsp_process_stream (self, info.data + i * self->period_size,
+        period_time);
+  }
 
-  if (ret == GST_FLOW_OK)
-    ret = gst_webrtc_dsp_process_stream (self, *outbuf);
+  gst_buffer_unmap (*outbuf, &info);
 
   return ret;
 }
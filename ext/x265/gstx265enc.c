@@ -53,7 +53,11 @@ enum
   PROP_OPTION_STRING,
   PROP_X265_LOG_LEVEL,
   PROP_SPEED_PRESET,
-  PROP_TUNE
+  PROP_TUNE,
+  PROP_FRAME_THREADS,
+  PROP_POOL_THREADS,
+  PROP_NUMA_NODE,
+  PROP_WPP
 };
 
 #define PROP_BITRATE_DEFAULT            (2 * 1024)
@@ -62,6 +66,10 @@ enum
 #define PROP_LOG_LEVEL_DEFAULT           -1     // None
 #define PROP_SPEED_PRESET_DEFAULT        6      // Medium
 #define PROP_TUNE_DEFAULT                2      // SSIM
+#define PROP_FRAME_THREADS_DEFAULT       0      // Auto
+#define PROP_POOL_THREADS_DEFAULT        0      // Auto
+#define PROP_NUMA_NODE_DEFAULT           -1     // All nodes
+#define PROP_WPP_DEFAULT                 TRUE
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define FORMATS "I420, Y444, I420_10LE, Y444_10LE"
@@ -396,6 +404,61 @@ gst_x265_enc_class_init (GstX265EncClass * klass)
           "Preset name for tuning options", GST_X265_ENC_TUNE_TYPE,
           PROP_TUNE_DEFAULT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstX265Enc:frame-threads:
+   *
+   * Number of frames encoded concurrently.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_THREADS,
+      g_param_spec_uint ("frame-threads", "Frame threads",
+          "Number of concurrently encoded frames (0 = auto)", 0, 16,
+          PROP_FRAME_THREADS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstX265Enc:pool-threads:
+   *
+   * Number of worker threads of the thread pool, shared by the frame,
+   * wavefront and lookahead jobs.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_POOL_THREADS,
+      g_param_spec_uint ("pool-threads", "Pool threads",
+          "Number of worker threads in the thread pool (0 = one per core)",
+          0, 256, PROP_POOL_THREADS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstX265Enc:numa-node:
+   *
+   * NUMA node to run the thread pool on, so that the pictures and the
+   * analysis data are allocated on the memory of that node only. Ignored
+   * when x265 was built without NUMA support.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_NUMA_NODE,
+      g_param_spec_int ("numa-node", "NUMA node",
+          "NUMA node to create the thread pool on (-1 = all nodes)",
+          -1, 63, PROP_NUMA_NODE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstX265Enc:wpp:
+   *
+   * Encode the rows of a frame in parallel with wavefront parallel
+   * processing.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_WPP,
+      g_param_spec_boolean ("wpp", "WPP",
+          "Wavefront parallel processing", PROP_WPP_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (element_class,
       "x265enc", "Codec/Encoder/Video", "H265 Encoder",
       "Thijs Vermeir <thijs.vermeir@barco.com>");
@@ -422,6 +485,10 @@ gst_x265_enc_init (GstX265Enc * encoder)
   encoder->log_level = PROP_LOG_LEVEL_DEFAULT;
   encoder->speed_preset = PROP_SPEED_PRESET_DEFAULT;
   encoder->tune = PROP_TUNE_DEFAULT;
+  encoder->frame_threads = PROP_FRAME_THREADS_DEFAULT;
+  encoder->pool_threads = PROP_POOL_THREADS_DEFAULT;
+  encoder->numa_node = PROP_NUMA_NODE_DEFAULT;
+  encoder->wpp = PROP_WPP_DEFAULT;
 }
 
 typedef struct
@@ -614,6 +681,31 @@ gst_x265_enc_parse_options (GstX265Enc * encoder, const gchar * str)
   return !ret;
 }
 
+/* builds the value of the x265 "pools" option: one entry per NUMA node,
+ * "-" for no threads and "+" for one thread per core */
+static gchar *
+gst_x265_enc_get_pools (GstX265Enc * encoder)
+{
+  GString *pools;
+  gint i;
+
+  if (encoder->numa_node < 0) {
+    if (encoder->pool_threads == 0)
+      return NULL;
+    return g_strdup_printf ("%u", encoder->pool_threads);
+  }
+
+  pools = g_string_new (NULL);
+  for (i = 0; i < encoder->numa_node; i++)
+    g_string_append (pools, "-,");
+  if (encoder->pool_threads)
+    g_string_append_printf (pools, "%u", encoder->pool_threads);
+  else
+    g_string_append_c (pools, '+');
+
+  return g_string_free (pools, FALSE);
+}
+
 /*
  * gst_x265_enc_init_encoder
  * @encoder:  Encoder which should be initialized.
@@ -625,6 +717,7 @@ static gboolean
 gst_x265_enc_init_encoder (GstX265Enc * encoder)
 {
   GstVideoInfo *info;
+  gchar *pools;
 
   if (!encoder->input_state) {
     GST_DEBUG_OBJECT (encoder, "Have no input state yet");
@@ -673,6 +766,21 @@ gst_x265_enc_init_encoder (GstX265Enc * encoder)
     encoder->x265param.rc.rateControlMode = X265_RC_ABR;
   }
 
+  /* threading */
+  encoder->x265param.frameNumThreads = encoder->frame_threads;
+  encoder->x265param.bEnableWavefront = encoder->wpp;
+  pools = gst_x265_enc_get_pools (encoder);
+  if (pools) {
+    GST_DEBUG_OBJECT (encoder, "Using thread pools %s", pools);
+    if (x265_param_parse (&encoder->x265param, "pools", pools) < 0) {
+      GST_ERROR_OBJECT (encoder, "Invalid thread pools %s", pools);
+      g_free (pools);
+      GST_OBJECT_UNLOCK (encoder);
+      return FALSE;
+    }
+    g_free (pools);
+  }
+
   /* apply option-string property */
   if (encoder->option_string_prop && encoder->option_string_prop->len) {
     GST_DEBUG_OBJECT (encoder, "Applying option-string: %s",
@@ -1197,6 +1305,18 @@ gst_x265_enc_set_property (GObject * object, guint prop_id,
     case PROP_TUNE:
       encoder->tune = g_value_get_enum (value);
       break;
+    case PROP_FRAME_THREADS:
+      encoder->frame_threads = g_value_get_uint (value);
+      break;
+    case PROP_POOL_THREADS:
+      encoder->pool_threads = g_value_get_uint (value);
+      break;
+    case PROP_NUMA_NODE:
+      encoder->numa_node = g_value_get_int (value);
+      break;
+    case PROP_WPP:
+      encoder->wpp = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1241,6 +1361,18 @@ gst_x265_enc_get_property (GObject * object, guint prop_id,
     case PROP_TUNE:
       g_value_set_enum (value, encoder->tune);
       break;
+    case PROP_FRAME_THREADS:
+      g_value_set_uint (value, encoder->frame_threads);
+      break;
+    case PROP_POOL_THREADS:
+      g_value_set_uint (value, encoder->pool_threads);
+      break;
+    case PROP_NUMA_NODE:
+      g_value_set_int (value, encoder->numa_node);
+      break;
+    case PROP_WPP:
+      g_value_set_boolean (value, encoder->wpp);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
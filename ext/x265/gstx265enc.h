@@ -61,6 +61,10 @@ struct _GstX265Enc
   gint log_level;
   gint tune;
   gint speed_preset;
+  guint frame_threads;
+  guint pool_threads;
+  gint numa_node;
+  gboolean wpp;
   GString *option_string_prop;  /* option-string property */
   /*GString *option_string; *//* used by set prop */
 
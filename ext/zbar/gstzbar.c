@@ -36,6 +36,14 @@
  * * GstSample `frame`: the frame in which the barcode message was detected, if
  *   the .#GstZBar:attach-frame property was set to %TRUE (Since 1.6)
  *
+ * On high resolution streams the scanning work can be reduced by only
+ * scanning the regions of interest attached to the frames upstream, with
+ * the .#GstZBar:use-roi property, and by scanning a subsampled image with the
+ * .#GstZBar:downscale property. With the .#GstZBar:async property set, frames
+ * are scanned on a separate thread and frames arriving while the scanner is
+ * still busy are not scanned, so that the stream is never held up
+ * (Since 1.14).
+ *
  * ## Example launch lines
  * |[
  * gst-launch-1.0 -m v4l2src ! videoconvert ! zbar ! videoconvert ! xvimagesink
@@ -73,12 +81,37 @@ enum
   PROP_0,
   PROP_MESSAGE,
   PROP_ATTACH_FRAME,
-  PROP_CACHE
+  PROP_CACHE,
+  PROP_DOWNSCALE,
+  PROP_USE_ROI,
+  PROP_ASYNC
 };
 
 #define DEFAULT_CACHE    FALSE
 #define DEFAULT_MESSAGE  TRUE
 #define DEFAULT_ATTACH_FRAME FALSE
+#define DEFAULT_DOWNSCALE 1
+#define DEFAULT_USE_ROI FALSE
+#define DEFAULT_ASYNC FALSE
+
+/* A Y800 image to scan, either pointing into the frame or a packed copy of
+ * a part of it */
+typedef struct
+{
+  guint8 *data;
+  gint width, height;
+  gboolean copied;
+} GstZBarRegion;
+
+/* The regions of one frame, with what the messages need from it */
+typedef struct
+{
+  GArray *regions;
+  GstClockTime timestamp;
+  /* only set with attach-frame */
+  GstBuffer *buffer;
+  GstVideoInfo info;
+} GstZBarJob;
 
 #define ZBAR_YUV_CAPS \
     "{ Y800, I420, YV12, NV12, NV21, Y41B, Y42B, YUV9, YVU9 }"
@@ -154,6 +187,48 @@ gst_zbar_class_init (GstZBarClass * g_class)
           G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
           G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstZBar:downscale:
+   *
+   * Scan an image subsampled by this factor in both directions. Barcodes
+   * that are large enough in the frame are still detected at a fraction of
+   * the cost.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DOWNSCALE,
+      g_param_spec_uint ("downscale", "Downscale",
+          "Subsampling factor of the scanned image", 1, 8, DEFAULT_DOWNSCALE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstZBar:use-roi:
+   *
+   * Only scan the regions described by the #GstVideoRegionOfInterestMeta of
+   * the frames. Frames without such meta are scanned completely.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_ROI,
+      g_param_spec_boolean ("use-roi", "Use ROI",
+          "Only scan the regions of interest attached to the frames",
+          DEFAULT_USE_ROI, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstZBar:async:
+   *
+   * Scan on a separate thread instead of the streaming thread. Frames that
+   * arrive while a frame is still waiting to be scanned are not scanned.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC,
+      g_param_spec_boolean ("async", "Asynchronous",
+          "Scan on a separate thread, skipping frames while it is busy",
+          DEFAULT_ASYNC,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Barcode detector",
       "Filter/Analyzer/Video",
       "Detect bar codes in the video streams",
@@ -178,8 +253,14 @@ gst_zbar_init (GstZBar * zbar)
   zbar->cache = DEFAULT_CACHE;
   zbar->message = DEFAULT_MESSAGE;
   zbar->attach_frame = DEFAULT_ATTACH_FRAME;
+  zbar->downscale = DEFAULT_DOWNSCALE;
+  zbar->use_roi = DEFAULT_USE_ROI;
+  zbar->async = DEFAULT_ASYNC;
 
   zbar->scanner = zbar_image_scanner_create ();
+
+  g_mutex_init (&zbar->lock);
+  g_cond_init (&zbar->cond);
 }
 
 static void
@@ -189,6 +270,9 @@ gst_zbar_finalize (GObject * object)
 
   zbar_image_scanner_destroy (zbar->scanner);
 
+  g_mutex_clear (&zbar->lock);
+  g_cond_clear (&zbar->cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -211,6 +295,15 @@ gst_zbar_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_ATTACH_FRAME:
       zbar->attach_frame = g_value_get_boolean (value);
       break;
+    case PROP_DOWNSCALE:
+      zbar->downscale = g_value_get_uint (value);
+      break;
+    case PROP_USE_ROI:
+      zbar->use_roi = g_value_get_boolean (value);
+      break;
+    case PROP_ASYNC:
+      zbar->async = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -236,33 +329,52 @@ gst_zbar_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_ATTACH_FRAME:
       g_value_set_boolean (value, zbar->attach_frame);
       break;
+    case PROP_DOWNSCALE:
+      g_value_set_uint (value, zbar->downscale);
+      break;
+    case PROP_USE_ROI:
+      g_value_set_boolean (value, zbar->use_roi);
+      break;
+    case PROP_ASYNC:
+      g_value_set_boolean (value, zbar->async);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
-static GstFlowReturn
-gst_zbar_transform_frame_ip (GstVideoFilter * vfilter, GstVideoFrame * frame)
+static void
+gst_zbar_job_free (GstZBarJob * job)
+{
+  guint i;
+
+  for (i = 0; i < job->regions->len; i++) {
+    GstZBarRegion *region = &g_array_index (job->regions, GstZBarRegion, i);
+
+    if (region->copied)
+      g_free (region->data);
+  }
+  g_array_free (job->regions, TRUE);
+  if (job->buffer)
+    gst_buffer_unref (job->buffer);
+  g_slice_free (GstZBarJob, job);
+}
+
+static void
+gst_zbar_scan_region (GstZBar * zbar, GstZBarJob * job,
+    GstZBarRegion * region)
 {
-  GstZBar *zbar = GST_ZBAR (vfilter);
-  gpointer data;
-  gint stride, height;
   zbar_image_t *image;
   const zbar_symbol_t *symbol;
   int n;
 
   image = zbar_image_create ();
 
-  /* all formats we support start with an 8-bit Y plane. zbar doesn't need
-   * to know about the chroma plane(s) */
-  data = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
-  stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
-
   zbar_image_set_format (image, GST_MAKE_FOURCC ('Y', '8', '0', '0'));
-  zbar_image_set_size (image, stride, height);
-  zbar_image_set_data (image, (gpointer) data, stride * height, NULL);
+  zbar_image_set_size (image, region->width, region->height);
+  zbar_image_set_data (image, region->data, region->width * region->height,
+      NULL);
 
   /* scan the image for barcodes */
   n = zbar_scan_image (zbar->scanner, image);
@@ -293,14 +405,14 @@ gst_zbar_transform_frame_ip (GstVideoFilter * vfilter, GstVideoFrame * frame)
       GstCaps *sample_caps;
 
       s = gst_structure_new ("barcode",
-          "timestamp", G_TYPE_UINT64, GST_BUFFER_TIMESTAMP (frame->buffer),
+          "timestamp", G_TYPE_UINT64, job->timestamp,
           "type", G_TYPE_STRING, zbar_get_symbol_name (typ),
           "symbol", G_TYPE_STRING, data, "quality", G_TYPE_INT, quality, NULL);
 
-      if (zbar->attach_frame) {
+      if (job->buffer) {
         /* create a sample from image */
-        sample_caps = gst_video_info_to_caps (&frame->info);
-        sample = gst_sample_new (frame->buffer, sample_caps, NULL, NULL);
+        sample_caps = gst_video_info_to_caps (&job->info);
+        sample = gst_sample_new (job->buffer, sample_caps, NULL, NULL);
         gst_caps_unref (sample_caps);
         gst_structure_set (s, "frame", GST_TYPE_SAMPLE, sample, NULL);
         gst_sample_unref (sample);
@@ -318,6 +430,186 @@ out:
   /* clean up */
   zbar_image_scanner_recycle_image (zbar->scanner, image);
   zbar_image_destroy (image);
+}
+
+static void
+gst_zbar_scan_job (GstZBar * zbar, GstZBarJob * job)
+{
+  guint i;
+
+  for (i = 0; i < job->regions->len; i++)
+    gst_zbar_scan_region (zbar, job,
+        &g_array_index (job->regions, GstZBarRegion, i));
+}
+
+static gpointer
+gst_zbar_worker (GstZBar * zbar)
+{
+  GstZBarJob *job;
+
+  g_mutex_lock (&zbar->lock);
+  while (TRUE) {
+    while (!zbar->pending_job && !zbar->worker_stopping)
+      g_cond_wait (&zbar->cond, &zbar->lock);
+    if (zbar->worker_stopping)
+      break;
+
+    /* the job stays pending while it is scanned so that new frames are
+     * skipped until the scanner is free again */
+    job = zbar->pending_job;
+    g_mutex_unlock (&zbar->lock);
+
+    gst_zbar_scan_job (zbar, job);
+
+    g_mutex_lock (&zbar->lock);
+    zbar->pending_job = NULL;
+    gst_zbar_job_free (job);
+  }
+  g_mutex_unlock (&zbar->lock);
+
+  return NULL;
+}
+
+static void
+gst_zbar_stop_worker (GstZBar * zbar)
+{
+  if (!zbar->worker)
+    return;
+
+  g_mutex_lock (&zbar->lock);
+  zbar->worker_stopping = TRUE;
+  g_cond_signal (&zbar->cond);
+  g_mutex_unlock (&zbar->lock);
+
+  g_thread_join (zbar->worker);
+  zbar->worker = NULL;
+  zbar->worker_stopping = FALSE;
+
+  if (zbar->pending_job) {
+    gst_zbar_job_free (zbar->pending_job);
+    zbar->pending_job = NULL;
+  }
+}
+
+/* Adds the part of the Y plane at @x, @y of size @width x @height to @job,
+ * subsampled with the downscale factor. The full frame is scanned in place
+ * when it doesn't need to outlive the frame. */
+static void
+gst_zbar_add_region (GstZBar * zbar, GstZBarJob * job, GstVideoFrame * frame,
+    gint x, gint y, gint width, gint height)
+{
+  GstZBarRegion region;
+  guint8 *src, *dst;
+  gint stride, step, i, j;
+
+  src = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  step = zbar->downscale;
+
+  if (step == 1 && !zbar->async && x == 0 && y == 0 &&
+      width == GST_VIDEO_FRAME_WIDTH (frame) &&
+      height == GST_VIDEO_FRAME_HEIGHT (frame)) {
+    /* zbar doesn't take a stride, the padding is scanned along */
+    region.data = src;
+    region.width = stride;
+    region.height = height;
+    region.copied = FALSE;
+    g_array_append_val (job->regions, region);
+    return;
+  }
+
+  region.width = width / step;
+  region.height = height / step;
+  if (region.width == 0 || region.height == 0)
+    return;
+
+  region.data = g_malloc (region.width * region.height);
+  region.copied = TRUE;
+
+  src += y * stride + x;
+  dst = region.data;
+  for (i = 0; i < region.height; i++) {
+    if (step == 1) {
+      memcpy (dst, src, region.width);
+    } else {
+      for (j = 0; j < region.width; j++)
+        dst[j] = src[j * step];
+    }
+    src += stride * step;
+    dst += region.width;
+  }
+
+  g_array_append_val (job->regions, region);
+}
+
+static GstFlowReturn
+gst_zbar_transform_frame_ip (GstVideoFilter * vfilter, GstVideoFrame * frame)
+{
+  GstZBar *zbar = GST_ZBAR (vfilter);
+  GstZBarJob *job;
+  gint width, height;
+  gboolean have_roi = FALSE;
+
+  if (zbar->async) {
+    gboolean busy;
+
+    g_mutex_lock (&zbar->lock);
+    busy = zbar->pending_job != NULL;
+    g_mutex_unlock (&zbar->lock);
+
+    if (busy) {
+      GST_LOG_OBJECT (zbar, "scanner busy, not scanning frame %"
+          GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (frame->buffer)));
+      return GST_FLOW_OK;
+    }
+  }
+
+  job = g_slice_new0 (GstZBarJob);
+  job->regions = g_array_new (FALSE, FALSE, sizeof (GstZBarRegion));
+  job->timestamp = GST_BUFFER_TIMESTAMP (frame->buffer);
+  if (zbar->message && zbar->attach_frame) {
+    job->buffer = gst_buffer_ref (frame->buffer);
+    job->info = frame->info;
+  }
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  height = GST_VIDEO_FRAME_HEIGHT (frame);
+
+  /* all formats we support start with an 8-bit Y plane. zbar doesn't need
+   * to know about the chroma plane(s) */
+  if (zbar->use_roi) {
+    GstVideoRegionOfInterestMeta *roi;
+    gpointer state = NULL;
+
+    while ((roi = (GstVideoRegionOfInterestMeta *)
+            gst_buffer_iterate_meta_filtered (frame->buffer, &state,
+                GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))) {
+      gint x = MIN (roi->x, width);
+      gint y = MIN (roi->y, height);
+
+      gst_zbar_add_region (zbar, job, frame, x, y, MIN (roi->w, width - x),
+          MIN (roi->h, height - y));
+      have_roi = TRUE;
+    }
+  }
+
+  if (!have_roi)
+    gst_zbar_add_region (zbar, job, frame, 0, 0, width, height);
+
+  if (!zbar->async) {
+    gst_zbar_scan_job (zbar, job);
+    gst_zbar_job_free (job);
+    return GST_FLOW_OK;
+  }
+
+  g_mutex_lock (&zbar->lock);
+  if (!zbar->worker) {
+    zbar->worker = g_thread_new ("zbar-scanner",
+        (GThreadFunc) gst_zbar_worker, zbar);
+  }
+  zbar->pending_job = job;
+  g_cond_signal (&zbar->cond);
+  g_mutex_unlock (&zbar->lock);
 
   return GST_FLOW_OK;
 }
@@ -338,6 +630,8 @@ gst_zbar_stop (GstBaseTransform * base)
 {
   GstZBar *zbar = GST_ZBAR (base);
 
+  gst_zbar_stop_worker (zbar);
+
   /* stop the cache if enabled (e.g. for filtering dupes) */
   zbar_image_scanner_enable_cache (zbar->scanner, zbar->cache);
 
@@ -55,9 +55,19 @@ struct _GstZBar
   gboolean message;
   gboolean attach_frame;
   gboolean cache;
+  guint downscale;
+  gboolean use_roi;
+  gboolean async;
 
   /* internals */
   zbar_image_scanner_t *scanner;
+
+  /* scanning worker of the async mode, the scanner is only used by it */
+  GThread *worker;
+  GMutex lock;
+  GCond cond;
+  gpointer pending_job;
+  gboolean worker_stopping;
 };
 
 struct _GstZBarClass
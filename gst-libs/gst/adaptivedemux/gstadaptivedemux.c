@@ -122,6 +122,7 @@ that the demux object and its streams are not changed by anybody else.
 #include "gstadaptivedemux.h"
 #include "gst/gst-i18n-plugin.h"
 #include <gst/base/gstadapter.h>
+#include <gst/uridownloader/gstfragmentcache.h>
 
 GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define GST_CAT_DEFAULT adaptivedemux_debug
@@ -134,9 +135,23 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
+#define DEFAULT_PREFETCH_DEPTH 0
+#define DEFAULT_ABR_ALGORITHM GST_ADAPTIVE_DEMUX_ABR_MOVING_AVERAGE
+#define DEFAULT_FRAGMENT_CACHE_SIZE 0
+#define DEFAULT_MAX_RANGE_GAP -1
+#define MAX_PREFETCH_DEPTH 16
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
 
+/* Weight of the previous estimate in the fast and slow bitrate averages,
+ * giving a half-life of one and four fragments */
+#define ABR_EWMA_FAST_ALPHA 0.5
+#define ABR_EWMA_SLOW_ALPHA 0.84
+/* Buffered durations between which buffer-based selection goes from half
+ * the estimated bitrate to all of it */
+#define ABR_BUFFER_LEVEL_LOW (5 * GST_SECOND)
+#define ABR_BUFFER_LEVEL_HIGH (20 * GST_SECOND)
+
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
     GST_TRACE("Locking from thread %p", g_thread_self()); \
@@ -162,9 +177,47 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_DEPTH,
+  PROP_ABR_ALGORITHM,
+  PROP_FRAGMENT_CACHE_SIZE,
+  PROP_MAX_RANGE_GAP,
   PROP_LAST
 };
 
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_ABR_MOVING_AVERAGE,
+  GST_ADAPTIVE_DEMUX_ABR_EWMA,
+  GST_ADAPTIVE_DEMUX_ABR_BUFFER_BASED
+} GstAdaptiveDemuxAbrAlgorithm;
+
+#define GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM \
+    (gst_adaptive_demux_abr_algorithm_get_type ())
+static GType
+gst_adaptive_demux_abr_algorithm_get_type (void)
+{
+  static GType abr_algorithm_type = 0;
+  static const GEnumValue abr_algorithms[] = {
+    {GST_ADAPTIVE_DEMUX_ABR_MOVING_AVERAGE,
+        "Lowest of the last fragment and the last fragments average bitrate",
+        "moving-average"},
+    {GST_ADAPTIVE_DEMUX_ABR_EWMA,
+        "Lowest of a fast and a slow exponentially weighted average bitrate",
+        "ewma"},
+    {GST_ADAPTIVE_DEMUX_ABR_BUFFER_BASED,
+          "Weighted average bitrate, used more fully as the buffered "
+          "duration grows", "buffer-based"},
+    {0, NULL, NULL}
+  };
+
+  if (!abr_algorithm_type) {
+    abr_algorithm_type =
+        g_enum_register_static ("GstAdaptiveDemuxAbrAlgorithm",
+        abr_algorithms);
+  }
+  return abr_algorithm_type;
+}
+
 /* Internal, so not using GST_FLOW_CUSTOM_SUCCESS_N */
 #define GST_ADAPTIVE_DEMUX_FLOW_SWITCH (GST_FLOW_CUSTOM_SUCCESS_2 + 1)
 
@@ -210,6 +263,29 @@ struct _GstAdaptiveDemuxPrivate
    * without needing to stop tasks when they just want to
    * update the segment boundaries */
   GMutex segment_lock;
+
+  /* number of fragments requested ahead of the current one, protected by
+   * manifest_lock */
+  guint prefetch_depth;
+  /* runs the prefetch requests, reusing connections between them. MT safe */
+  GstUriDownloader *prefetch_downloader;
+
+  /* protected by manifest_lock */
+  GstAdaptiveDemuxAbrAlgorithm abr_algorithm;
+
+  /* requested size of the shared fragment cache, 0 if this element does not
+   * use it. Protected by manifest_lock */
+  guint64 fragment_cache_size;
+
+  /* largest number of bytes between the header and the index ranges of a
+   * file for them to be fetched together, -1 to never do it. Protected by
+   * manifest_lock */
+  gint max_range_gap;
+
+  /* whether the start of the next period was requested into the fragment
+   * cache, and the ids of those requests. Protected by manifest_lock */
+  gboolean next_period_prefetched;
+  GArray *next_period_requests;
 };
 
 typedef struct _GstAdaptiveDemuxTimer
@@ -221,6 +297,23 @@ typedef struct _GstAdaptiveDemuxTimer
   gboolean fired;
 } GstAdaptiveDemuxTimer;
 
+/* A fragment requested ahead of the one currently being downloaded. It is
+ * shared between the stream's prefetch queue and the thread doing the
+ * request */
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  volatile gint ref_count;
+  GMutex lock;
+  GCond cond;
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+  GstUriDownloader *downloader;
+  guint request_id;
+  GstFragment *download;        /* protected by lock */
+  gboolean done;                /* protected by lock */
+} GstAdaptiveDemuxPrefetch;
+
 static GstBinClass *parent_class = NULL;
 static void gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass);
 static void gst_adaptive_demux_init (GstAdaptiveDemux * dec,
@@ -307,6 +400,16 @@ static gboolean gst_adaptive_demux_clock_callback (GstClock * clock,
 static gboolean
 gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
     * demux);
+static void gst_adaptive_demux_prefetch_done (GstUriDownloader * downloader,
+    GstFragment * download, const GError * err,
+    GstAdaptiveDemuxPrefetch * prefetch);
+static void gst_adaptive_demux_prefetch_next_period (GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_cancel_next_period_prefetch (GstAdaptiveDemux *
+    demux);
+static void gst_adaptive_demux_stream_cancel_prefetch (GstAdaptiveDemuxStream *
+    stream);
+static void gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream *
+    stream);
 
 /* we can't use G_DEFINE_ABSTRACT_TYPE because we need the klass in the _init
  * method to get to the padtemplates */
@@ -354,6 +457,24 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_DEPTH:
+      demux->priv->prefetch_depth = g_value_get_uint (value);
+      break;
+    case PROP_ABR_ALGORITHM:
+      demux->priv->abr_algorithm = g_value_get_enum (value);
+      break;
+    case PROP_FRAGMENT_CACHE_SIZE:
+      if (demux->priv->fragment_cache_size > 0)
+        gst_fragment_cache_remove_user (demux->priv->fragment_cache_size);
+      demux->priv->fragment_cache_size = g_value_get_uint64 (value);
+      if (demux->priv->fragment_cache_size > 0)
+        gst_fragment_cache_add_user (demux->priv->fragment_cache_size);
+      gst_uri_downloader_set_use_cache (demux->priv->prefetch_downloader,
+          demux->priv->fragment_cache_size > 0);
+      break;
+    case PROP_MAX_RANGE_GAP:
+      demux->priv->max_range_gap = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -378,6 +499,18 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_DEPTH:
+      g_value_set_uint (value, demux->priv->prefetch_depth);
+      break;
+    case PROP_ABR_ALGORITHM:
+      g_value_set_enum (value, demux->priv->abr_algorithm);
+      break;
+    case PROP_FRAGMENT_CACHE_SIZE:
+      g_value_set_uint64 (value, demux->priv->fragment_cache_size);
+      break;
+    case PROP_MAX_RANGE_GAP:
+      g_value_set_int (value, demux->priv->max_range_gap);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -421,6 +554,76 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-depth:
+   *
+   * Number of upcoming fragments of each stream that are requested in
+   * parallel with the current one, so that a slow request start does not
+   * stall the stream. This also bounds how many downloaded fragments are
+   * held per stream. Only used if the subclass can report upcoming fragments.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_DEPTH,
+      g_param_spec_uint ("prefetch-depth", "Prefetch depth",
+          "Number of upcoming fragments to request in advance for each stream"
+          " (0 = disabled)", 0, MAX_PREFETCH_DEPTH, DEFAULT_PREFETCH_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-algorithm:
+   *
+   * How the bandwidth available for the next fragment is estimated from the
+   * download bitrate of the previous ones. "ewma" smooths out short-term
+   * spikes so that switches happen less often, "buffer-based" additionally
+   * stays conservative while little data is buffered and makes use of the
+   * whole estimate once enough is. The result is scaled by
+   * #GstAdaptiveDemux:bitrate-limit in all cases.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_ALGORITHM,
+      g_param_spec_enum ("abr-algorithm", "ABR algorithm",
+          "Algorithm used to estimate the available bandwidth",
+          GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM, DEFAULT_ABR_ALGORITHM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:fragment-cache-size:
+   *
+   * Size in bytes of a fragment cache shared by all the adaptive demuxers of
+   * the process that enable it, so that several of them playing the same
+   * presentation download each fragment only once. Least recently used
+   * fragments are dropped when it is full, initialization segments and
+   * indexes are kept over other fragments as long as they take at most a
+   * quarter of it. The cache is as large as the largest size requested by
+   * the demuxers using it, and is cleared once none of them is left.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAGMENT_CACHE_SIZE,
+      g_param_spec_uint64 ("fragment-cache-size", "Fragment cache size",
+          "Size in bytes of the fragment cache shared between demuxers"
+          " (0 = disabled)", 0, G_MAXUINT64, DEFAULT_FRAGMENT_CACHE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:max-range-gap:
+   *
+   * When the header and the index of a stream are byte ranges of the same
+   * file that are at most this many bytes apart, as is usual for the
+   * on-demand profile of DASH, they are fetched with a single request
+   * instead of one each, saving a round trip on every representation
+   * switch. The bytes in between are downloaded and dropped.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_RANGE_GAP,
+      g_param_spec_int ("max-range-gap", "Max range gap",
+          "Largest gap in bytes between the header and index ranges of a file"
+          " to fetch them with one request (-1 = disabled)", -1, G_MAXINT,
+          DEFAULT_MAX_RANGE_GAP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -447,6 +650,9 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   demux->priv->input_adapter = gst_adapter_new ();
   demux->downloader = gst_uri_downloader_new ();
   gst_uri_downloader_set_parent (demux->downloader, GST_ELEMENT_CAST (demux));
+  demux->priv->prefetch_downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_parent (demux->priv->prefetch_downloader,
+      GST_ELEMENT_CAST (demux));
   demux->stream_struct_size = sizeof (GstAdaptiveDemuxStream);
   demux->priv->segment_seqnum = gst_util_seqnum_next ();
   demux->have_group_id = FALSE;
@@ -513,6 +719,12 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_depth = DEFAULT_PREFETCH_DEPTH;
+  demux->priv->abr_algorithm = DEFAULT_ABR_ALGORITHM;
+  demux->priv->fragment_cache_size = DEFAULT_FRAGMENT_CACHE_SIZE;
+  demux->priv->max_range_gap = DEFAULT_MAX_RANGE_GAP;
+  demux->priv->next_period_requests = g_array_new (FALSE, FALSE,
+      sizeof (guint));
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -527,6 +739,10 @@ gst_adaptive_demux_finalize (GObject * object)
 
   g_object_unref (priv->input_adapter);
   g_object_unref (demux->downloader);
+  g_object_unref (priv->prefetch_downloader);
+  g_array_free (priv->next_period_requests, TRUE);
+  if (priv->fragment_cache_size > 0)
+    gst_fragment_cache_remove_user (priv->fragment_cache_size);
 
   g_mutex_clear (&priv->updates_timed_lock);
   g_cond_clear (&priv->updates_timed_cond);
@@ -778,6 +994,8 @@ gst_adaptive_demux_reset (GstAdaptiveDemux * demux)
   if (klass->reset)
     klass->reset (demux);
 
+  gst_adaptive_demux_cancel_next_period_prefetch (demux);
+
   eos = gst_event_new_eos ();
   for (iter = demux->streams; iter; iter = g_list_next (iter)) {
     GstAdaptiveDemuxStream *stream = iter->data;
@@ -1042,6 +1260,11 @@ gst_adaptive_demux_prepare_streams (GstAdaptiveDemux * demux,
   demux->prepared_streams = demux->next_streams;
   demux->next_streams = NULL;
 
+  /* the requests for the start of this period are done or still needed,
+   * the next period has not been asked for yet */
+  demux->priv->next_period_prefetched = FALSE;
+  g_array_set_size (demux->priv->next_period_requests, 0);
+
   if (!demux->running) {
     GST_DEBUG_OBJECT (demux, "Not exposing pads due to shutdown");
     return TRUE;
@@ -1387,7 +1610,9 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
     stream->download_task = NULL;
   }
 
+  gst_adaptive_demux_stream_clear_prefetch (stream);
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
+  gst_buffer_replace (&stream->cache_data, NULL);
 
   if (stream->pending_segment) {
     gst_event_unref (stream->pending_segment);
@@ -2073,6 +2298,9 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
     gst_task_stop (stream->download_task);
     g_cond_signal (&stream->fragment_download_cond);
     g_mutex_unlock (&stream->fragment_download_lock);
+
+    /* wakes up the task if it is waiting for a prefetched fragment */
+    gst_adaptive_demux_stream_cancel_prefetch (stream);
   }
 
   GST_MANIFEST_UNLOCK (demux);
@@ -2121,6 +2349,7 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
     stream->download_error_count = 0;
     stream->need_header = TRUE;
     stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
+    gst_adaptive_demux_stream_clear_prefetch (stream);
   }
 }
 
@@ -2190,12 +2419,62 @@ _update_average_bitrate (GstAdaptiveDemux * demux,
   return stream->moving_bitrate / stream->moving_index;
 }
 
+static guint64
+_update_ewma_bitrate (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, guint64 new_bitrate)
+{
+  if (stream->ewma_slow_bitrate == 0) {
+    stream->ewma_fast_bitrate = stream->ewma_slow_bitrate = new_bitrate;
+  } else {
+    stream->ewma_fast_bitrate = ABR_EWMA_FAST_ALPHA * stream->ewma_fast_bitrate
+        + (1 - ABR_EWMA_FAST_ALPHA) * new_bitrate;
+    stream->ewma_slow_bitrate = ABR_EWMA_SLOW_ALPHA * stream->ewma_slow_bitrate
+        + (1 - ABR_EWMA_SLOW_ALPHA) * new_bitrate;
+  }
+
+  /* drops are followed quickly, raises only once they last */
+  return MIN (stream->ewma_fast_bitrate, stream->ewma_slow_bitrate);
+}
+
+/* must be called with manifest_lock taken.
+ *
+ * Returns how far the stream position is ahead of the pipeline running time,
+ * or 0 if this is not known.
+ */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstClockTime position, now;
+  GstClock *clock;
+
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  position = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
+
+  if (!GST_CLOCK_TIME_IS_VALID (position)
+      || GST_STATE (demux) != GST_STATE_PLAYING)
+    return 0;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (demux));
+  if (clock == NULL)
+    return 0;
+
+  now = gst_clock_get_time (clock) -
+      gst_element_get_base_time (GST_ELEMENT_CAST (demux));
+  gst_object_unref (clock);
+
+  return position > now ? position - now : 0;
+}
+
 /* must be called with manifest_lock taken */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream)
 {
   guint64 average_bitrate;
+  guint64 ewma_bitrate;
   guint64 fragment_bitrate;
 
   if (demux->connection_speed) {
@@ -2208,21 +2487,53 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   GST_DEBUG_OBJECT (demux, "Download bitrate is : %" G_GUINT64_FORMAT " bps",
       fragment_bitrate);
 
+  /* keep all estimates up to date so that the algorithm can be changed at
+   * any time */
   average_bitrate = _update_average_bitrate (demux, stream, fragment_bitrate);
+  ewma_bitrate = _update_ewma_bitrate (demux, stream, fragment_bitrate);
 
   GST_INFO_OBJECT (stream, "last fragment bitrate was %" G_GUINT64_FORMAT,
       fragment_bitrate);
   GST_INFO_OBJECT (stream,
       "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
       NUM_LOOKBACK_FRAGMENTS, average_bitrate);
+  GST_INFO_OBJECT (stream, "Weighted average bitrate is %" G_GUINT64_FORMAT,
+      ewma_bitrate);
 
-  /* Conservative approach, make sure we don't upgrade too fast */
-  stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  if (demux->priv->abr_algorithm == GST_ADAPTIVE_DEMUX_ABR_MOVING_AVERAGE) {
+    /* Conservative approach, make sure we don't upgrade too fast */
+    stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  } else {
+    stream->current_download_rate = ewma_bitrate;
+  }
 
   stream->current_download_rate *= demux->bitrate_limit;
   GST_DEBUG_OBJECT (demux, "Bitrate after bitrate limit (%0.2f): %"
       G_GUINT64_FORMAT, demux->bitrate_limit, stream->current_download_rate);
 
+  if (demux->priv->abr_algorithm == GST_ADAPTIVE_DEMUX_ABR_BUFFER_BASED
+      && demux->bitrate_limit > 0) {
+    GstClockTime level;
+    gdouble factor;
+
+    /* go from half the limited bitrate with an almost empty buffer to the
+     * whole estimate with a full one */
+    level = gst_adaptive_demux_stream_get_buffer_level (demux, stream);
+    if (level <= ABR_BUFFER_LEVEL_LOW)
+      factor = 0.5;
+    else if (level >= ABR_BUFFER_LEVEL_HIGH)
+      factor = 1 / demux->bitrate_limit;
+    else
+      factor = 0.5 + (1 / demux->bitrate_limit - 0.5) *
+          (level - ABR_BUFFER_LEVEL_LOW) /
+          (ABR_BUFFER_LEVEL_HIGH - ABR_BUFFER_LEVEL_LOW);
+
+    stream->current_download_rate *= factor;
+    GST_DEBUG_OBJECT (demux, "Bitrate for buffer level %" GST_TIME_FORMAT
+        ": %" G_GUINT64_FORMAT, GST_TIME_ARGS (level),
+        stream->current_download_rate);
+  }
+
 #if 0
   /* Debugging code, modulate the bitrate every few fragments */
   {
@@ -2703,6 +3014,21 @@ _src_event (GstPad * pad, GstObject * parent, GstEvent * event)
   GstAdaptiveDemux *demux = stream->demux;
 
   switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CUSTOM_DOWNSTREAM_STICKY:{
+      const GstStructure *s = gst_event_get_structure (event);
+      gboolean reused;
+
+      /* sources that know whether the request went over an existing
+       * connection say so in their http-headers event */
+      if (gst_structure_has_name (s, "http-headers")
+          && gst_structure_get_boolean (s, "connection-reused", &reused)) {
+        GST_MANIFEST_LOCK (demux);
+        GST_LOG_OBJECT (pad, "Connection reused: %d", reused);
+        stream->last_connection_reused = reused;
+        GST_MANIFEST_UNLOCK (demux);
+      }
+      break;
+    }
     case GST_EVENT_EOS:{
       GST_DEBUG_OBJECT (pad, "Saw EOS on src pad");
       GST_MANIFEST_LOCK (demux);
@@ -2766,6 +3092,20 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
     GST_LOG_OBJECT (pad,
         "Received buffer, size %" G_GSIZE_FORMAT " total %" G_GUINT64_FORMAT,
         gst_buffer_get_size (buf), stream->fragment_bytes_downloaded);
+    if (stream->cache_download) {
+      /* a shallow copy, the buffer metadata is changed downstream */
+      if (stream->fragment_bytes_downloaded >
+          gst_fragment_cache_get_max_size ()) {
+        GST_LOG_OBJECT (pad, "Download too large for the fragment cache");
+        stream->cache_download = FALSE;
+        gst_buffer_replace (&stream->cache_data, NULL);
+      } else if (stream->cache_data) {
+        stream->cache_data =
+            gst_buffer_append (stream->cache_data, gst_buffer_copy (buf));
+      } else {
+        stream->cache_data = gst_buffer_copy (buf);
+      }
+    }
   } else if (GST_PAD_PROBE_INFO_TYPE (info) &
       GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
     GstEvent *ev = GST_PAD_PROBE_INFO_EVENT (info);
@@ -2774,6 +3114,7 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
     switch (GST_EVENT_TYPE (ev)) {
       case GST_EVENT_SEGMENT:
         stream->fragment_bytes_downloaded = 0;
+        gst_buffer_replace (&stream->cache_data, NULL);
         break;
       case GST_EVENT_EOS:
       {
@@ -2859,6 +3200,47 @@ gst_adaptive_demux_stream_wait_manifest_update (GstAdaptiveDemux * demux,
   return ret;
 }
 
+/* Sets up the request properties of an HTTP source. keep-alive makes the
+ * source keep its connection open when it is re-used for the next fragment.
+ * The fragments the streams are waiting for get a larger share of a
+ * multiplexed connection than the prefetched ones, which use the default
+ * HTTP/2 weight of 16 */
+static void
+gst_adaptive_demux_configure_uri_handler (GstElement * uri_handler,
+    const gchar * referer, gboolean refresh, gboolean allow_cache)
+{
+  GObjectClass *gobject_class = G_OBJECT_GET_CLASS (uri_handler);
+
+  if (g_object_class_find_property (gobject_class, "compress"))
+    g_object_set (uri_handler, "compress", FALSE, NULL);
+  if (g_object_class_find_property (gobject_class, "keep-alive"))
+    g_object_set (uri_handler, "keep-alive", TRUE, NULL);
+  if (g_object_class_find_property (gobject_class, "stream-weight"))
+    g_object_set (uri_handler, "stream-weight", 32, NULL);
+  if (g_object_class_find_property (gobject_class, "extra-headers")) {
+    if (referer || refresh || !allow_cache) {
+      GstStructure *extra_headers = gst_structure_new_empty ("headers");
+
+      if (referer)
+        gst_structure_set (extra_headers, "Referer", G_TYPE_STRING, referer,
+            NULL);
+
+      if (!allow_cache)
+        gst_structure_set (extra_headers, "Cache-Control", G_TYPE_STRING,
+            "no-cache", NULL);
+      else if (refresh)
+        gst_structure_set (extra_headers, "Cache-Control", G_TYPE_STRING,
+            "max-age=0", NULL);
+
+      g_object_set (uri_handler, "extra-headers", extra_headers, NULL);
+
+      gst_structure_free (extra_headers);
+    } else {
+      g_object_set (uri_handler, "extra-headers", NULL, NULL);
+    }
+  }
+}
+
 /* must be called with manifest_lock taken */
 static gboolean
 gst_adaptive_demux_stream_update_source (GstAdaptiveDemuxStream * stream,
@@ -2897,6 +3279,9 @@ gst_adaptive_demux_stream_update_source (GstAdaptiveDemuxStream * stream,
       GError *err = NULL;
 
       GST_DEBUG_OBJECT (demux, "Re-using old source element");
+      /* the source keeps its connection open, only the request changes */
+      gst_adaptive_demux_configure_uri_handler (stream->uri_handler, referer,
+          refresh, allow_cache);
       if (!gst_uri_handler_set_uri (GST_URI_HANDLER (stream->uri_handler), uri,
               &err)) {
         GstElement *src = stream->src;
@@ -2926,7 +3311,6 @@ gst_adaptive_demux_stream_update_source (GstAdaptiveDemuxStream * stream,
     GstElement *uri_handler;
     GstElement *queue;
     GstPadLinkReturn pad_link_ret;
-    GObjectClass *gobject_class;
     gchar *internal_name, *bin_name;
 
     /* Our src consists of a bin containing uri_handler -> queue . The
@@ -2950,34 +3334,8 @@ gst_adaptive_demux_stream_update_source (GstAdaptiveDemuxStream * stream,
       return FALSE;
     }
 
-    gobject_class = G_OBJECT_GET_CLASS (uri_handler);
-
-    if (g_object_class_find_property (gobject_class, "compress"))
-      g_object_set (uri_handler, "compress", FALSE, NULL);
-    if (g_object_class_find_property (gobject_class, "keep-alive"))
-      g_object_set (uri_handler, "keep-alive", TRUE, NULL);
-    if (g_object_class_find_property (gobject_class, "extra-headers")) {
-      if (referer || refresh || !allow_cache) {
-        GstStructure *extra_headers = gst_structure_new_empty ("headers");
-
-        if (referer)
-          gst_structure_set (extra_headers, "Referer", G_TYPE_STRING, referer,
-              NULL);
-
-        if (!allow_cache)
-          gst_structure_set (extra_headers, "Cache-Control", G_TYPE_STRING,
-              "no-cache", NULL);
-        else if (refresh)
-          gst_structure_set (extra_headers, "Cache-Control", G_TYPE_STRING,
-              "max-age=0", NULL);
-
-        g_object_set (uri_handler, "extra-headers", extra_headers, NULL);
-
-        gst_structure_free (extra_headers);
-      } else {
-        g_object_set (uri_handler, "extra-headers", NULL, NULL);
-      }
-    }
+    gst_adaptive_demux_configure_uri_handler (uri_handler, referer, refresh,
+        allow_cache);
 
     /* Source bin creation */
     bin_name = g_strdup_printf ("srcbin-%s", GST_PAD_NAME (stream->pad));
@@ -3138,6 +3496,7 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
     if (G_LIKELY (stream->last_ret == GST_FLOW_OK)) {
       stream->download_start_time =
           GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+      stream->last_connection_reused = FALSE;
 
       /* src element is in state READY. Before we start it, we reset
        * download_finished
@@ -3244,6 +3603,555 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
   return ret;
 }
 
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_new (GstAdaptiveDemux * demux, gchar * uri,
+    gint64 range_start, gint64 range_end)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  prefetch = g_slice_new0 (GstAdaptiveDemuxPrefetch);
+  prefetch->ref_count = 1;
+  g_mutex_init (&prefetch->lock);
+  g_cond_init (&prefetch->cond);
+  prefetch->uri = uri;
+  prefetch->range_start = range_start;
+  prefetch->range_end = range_end;
+  prefetch->downloader = gst_object_ref (demux->priv->prefetch_downloader);
+  return prefetch;
+}
+
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_ref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_return_val_if_fail (prefetch != NULL, NULL);
+  g_atomic_int_inc (&prefetch->ref_count);
+  return prefetch;
+}
+
+static void
+gst_adaptive_demux_prefetch_unref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_return_if_fail (prefetch != NULL);
+  if (g_atomic_int_dec_and_test (&prefetch->ref_count)) {
+    if (prefetch->download)
+      g_object_unref (prefetch->download);
+    g_object_unref (prefetch->downloader);
+    g_free (prefetch->uri);
+    g_mutex_clear (&prefetch->lock);
+    g_cond_clear (&prefetch->cond);
+    g_slice_free (GstAdaptiveDemuxPrefetch, prefetch);
+  }
+}
+
+/* called from the thread of the request */
+static void
+gst_adaptive_demux_prefetch_done (GstUriDownloader * downloader,
+    GstFragment * download, const GError * err,
+    GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (download == NULL)
+    GST_DEBUG ("Prefetch of %s failed: %s", prefetch->uri,
+        err ? err->message : "error");
+
+  g_mutex_lock (&prefetch->lock);
+  prefetch->download = download;
+  prefetch->done = TRUE;
+  g_cond_signal (&prefetch->cond);
+  g_mutex_unlock (&prefetch->lock);
+}
+
+static void
+gst_adaptive_demux_prefetch_start (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GST_DEBUG ("Prefetching %s range %" G_GINT64_FORMAT " - %" G_GINT64_FORMAT,
+      prefetch->uri, prefetch->range_start, prefetch->range_end);
+
+  prefetch->request_id =
+      gst_uri_downloader_fetch_uri_async (prefetch->downloader, prefetch->uri,
+      NULL, FALSE, FALSE, TRUE, prefetch->range_start, prefetch->range_end,
+      (GstUriDownloaderCallback) gst_adaptive_demux_prefetch_done,
+      gst_adaptive_demux_prefetch_ref (prefetch),
+      (GDestroyNotify) gst_adaptive_demux_prefetch_unref);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_cancel_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GList *iter;
+
+  for (iter = stream->prefetch.head; iter; iter = g_list_next (iter)) {
+    GstAdaptiveDemuxPrefetch *prefetch = iter->data;
+
+    gst_uri_downloader_cancel_request (prefetch->downloader,
+        prefetch->request_id);
+  }
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  while ((prefetch = g_queue_pop_head (&stream->prefetch))) {
+    gst_uri_downloader_cancel_request (prefetch->downloader,
+        prefetch->request_id);
+    gst_adaptive_demux_prefetch_unref (prefetch);
+  }
+}
+
+/* must be called with manifest_lock taken.
+ *
+ * Makes sure that up to prefetch-depth fragments following the current one
+ * are requested, in order, and drops the requests that are not upcoming
+ * anymore (e.g. after a bitrate switch). A request for the current fragment
+ * is kept at the head of the queue.
+ */
+static void
+gst_adaptive_demux_stream_update_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxPrefetch *prefetch;
+  GQueue old = stream->prefetch;
+  guint depth = demux->priv->prefetch_depth;
+  guint i;
+
+  if (klass->stream_peek_fragment == NULL)
+    depth = 0;
+
+  g_queue_init (&stream->prefetch);
+
+  for (i = 0; i <= depth; i++) {
+    gchar *uri;
+    gint64 range_start, range_end;
+    GList *link;
+
+    if (i == 0) {
+      uri = g_strdup (stream->fragment.uri);
+      range_start = stream->fragment.range_start;
+      range_end = stream->fragment.range_end;
+    } else if (!klass->stream_peek_fragment (stream, i, &uri, &range_start,
+            &range_end)) {
+      break;
+    }
+
+    for (link = old.head; link; link = g_list_next (link)) {
+      prefetch = link->data;
+      if (prefetch->range_start == range_start
+          && prefetch->range_end == range_end
+          && g_strcmp0 (prefetch->uri, uri) == 0)
+        break;
+    }
+
+    if (link) {
+      g_queue_unlink (&old, link);
+      g_queue_push_tail_link (&stream->prefetch, link);
+      g_free (uri);
+    } else if (i > 0) {
+      GST_DEBUG_OBJECT (stream->pad, "Requesting fragment +%u: %s", i, uri);
+      prefetch =
+          gst_adaptive_demux_prefetch_new (demux, uri, range_start, range_end);
+      g_queue_push_tail (&stream->prefetch, prefetch);
+      gst_adaptive_demux_prefetch_start (prefetch);
+    } else {
+      g_free (uri);
+    }
+  }
+
+  while ((prefetch = g_queue_pop_head (&old))) {
+    GST_DEBUG_OBJECT (stream->pad, "Dropping prefetched fragment %s",
+        prefetch->uri);
+    gst_uri_downloader_cancel_request (prefetch->downloader,
+        prefetch->request_id);
+    gst_adaptive_demux_prefetch_unref (prefetch);
+  }
+}
+
+/* called from the thread of the request, the data is in the fragment cache
+ * now */
+static void
+gst_adaptive_demux_next_period_fetched (GstUriDownloader * downloader,
+    GstFragment * download, const GError * err, gpointer user_data)
+{
+  if (download == NULL) {
+    GST_DEBUG ("Prefetch for the next period failed: %s",
+        err ? err->message : "error");
+    return;
+  }
+
+  GST_DEBUG ("Prefetched %s for the next period", download->uri);
+  g_object_unref (download);
+}
+
+/* must be called with manifest_lock taken.
+ *
+ * Requests what the streams of the next period start with into the fragment
+ * cache, once per period, so that the switch to it does not wait for those
+ * downloads.
+ */
+static void
+gst_adaptive_demux_prefetch_next_period (GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GList *fragments, *iter;
+
+  if (demux->priv->next_period_prefetched || klass->peek_next_period == NULL
+      || demux->priv->fragment_cache_size == 0 || demux->segment.rate < 0)
+    return;
+
+  if (!gst_adaptive_demux_has_next_period (demux))
+    return;
+
+  demux->priv->next_period_prefetched = TRUE;
+
+  fragments = klass->peek_next_period (demux);
+  for (iter = fragments; iter; iter = g_list_next (iter)) {
+    GstFragment *fragment = iter->data;
+    guint request_id;
+
+    GST_DEBUG_OBJECT (demux, "Requesting %s %" G_GINT64_FORMAT "-%"
+        G_GINT64_FORMAT " for the next period", fragment->uri,
+        fragment->range_start, fragment->range_end);
+
+    request_id =
+        gst_uri_downloader_fetch_uri_async (demux->priv->prefetch_downloader,
+        fragment->uri, NULL, FALSE, FALSE, TRUE, fragment->range_start,
+        fragment->range_end, gst_adaptive_demux_next_period_fetched, NULL,
+        NULL);
+    g_array_append_val (demux->priv->next_period_requests, request_id);
+  }
+  g_list_free_full (fragments, g_object_unref);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_cancel_next_period_prefetch (GstAdaptiveDemux * demux)
+{
+  guint i;
+
+  for (i = 0; i < demux->priv->next_period_requests->len; i++)
+    gst_uri_downloader_cancel_request (demux->priv->prefetch_downloader,
+        g_array_index (demux->priv->next_period_requests, guint, i));
+  g_array_set_size (demux->priv->next_period_requests, 0);
+  demux->priv->next_period_prefetched = FALSE;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Pushes data that was not downloaded by the stream's source the same way
+ * the source would have, and finishes the download.
+ */
+static GstFlowReturn
+gst_adaptive_demux_stream_push_download (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
+{
+  GstFlowReturn flow;
+  gboolean finished;
+  gsize size;
+
+  /* the data might be shared with the fragment cache, and its metadata is
+   * changed downstream */
+  buffer = gst_buffer_make_writable (buffer);
+  size = gst_buffer_get_size (buffer);
+  stream->fragment_bytes_downloaded = size;
+
+  /* there is no uri_handler to query the fragment size from */
+  if (!stream->downloading_header && !stream->downloading_index
+      && stream->fragment.bitrate == 0 && stream->fragment.duration != 0)
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+
+  GST_DEBUG_OBJECT (stream->pad, "Pushing downloaded %s, %" G_GSIZE_FORMAT
+      " bytes", uritype (stream), size);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  GST_MANIFEST_UNLOCK (demux);
+  flow = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  finished = stream->download_finished;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* this is where the source would send EOS */
+  if (!finished) {
+    if (flow == GST_FLOW_OK)
+      gst_adaptive_demux_eos_handling (stream);
+    else
+      gst_adaptive_demux_stream_fragment_download_finish (stream, flow, NULL);
+  }
+
+  return stream->last_ret;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Pushes the current fragment from its prefetched download, the same way
+ * the source would have. Returns FALSE if there is none and the fragment has
+ * to be downloaded normally.
+ */
+static gboolean
+gst_adaptive_demux_stream_push_prefetched (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstFlowReturn * ret)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+  GstFragment *download = NULL;
+  GstBuffer *buffer = NULL;
+
+  prefetch = g_queue_peek_head (&stream->prefetch);
+  if (prefetch == NULL || stream->internal_pad == NULL
+      || prefetch->range_start != stream->fragment.range_start
+      || prefetch->range_end != stream->fragment.range_end
+      || g_strcmp0 (prefetch->uri, stream->fragment.uri) != 0)
+    return FALSE;
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+  stream->last_connection_reused = FALSE;
+
+  /* the request stays queued while waiting, so that stop_tasks() can
+   * cancel it */
+  GST_MANIFEST_UNLOCK (demux);
+  g_mutex_lock (&prefetch->lock);
+  while (!prefetch->done)
+    g_cond_wait (&prefetch->cond, &prefetch->lock);
+  if (prefetch->download)
+    download = g_object_ref (prefetch->download);
+  g_mutex_unlock (&prefetch->lock);
+  GST_MANIFEST_LOCK (demux);
+
+  g_queue_pop_head (&stream->prefetch);
+  gst_adaptive_demux_prefetch_unref (prefetch);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    if (download)
+      g_object_unref (download);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    return TRUE;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  if (download) {
+    buffer = gst_fragment_get_buffer (download);
+    stream->last_download_time =
+        download->download_stop_time - download->download_start_time;
+    g_object_unref (download);
+  }
+  if (buffer == NULL) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch failed, requesting %s again",
+        stream->fragment.uri);
+    return FALSE;
+  }
+
+  /* the statistics _uri_handler_probe() would have gathered, except for the
+   * request latency which is not known here. A download time of 0 means
+   * that the fragment came from the fragment cache, which says nothing
+   * about the bandwidth */
+  if (stream->last_download_time > 0)
+    stream->last_bitrate =
+        gst_util_uint64_scale (gst_buffer_get_size (buffer), 8 * GST_SECOND,
+        stream->last_download_time);
+
+  *ret = gst_adaptive_demux_stream_push_download (demux, stream, buffer);
+  return TRUE;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Like gst_adaptive_demux_stream_download_uri(), but serves the request from
+ * the fragment cache if possible and otherwise adds the downloaded data to
+ * it. Headers and indexes are pinned in the cache.
+ */
+static GstFlowReturn
+gst_adaptive_demux_stream_download_cached_uri (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, const gchar * uri, gint64 start,
+    gint64 end, guint * http_status)
+{
+  GstBuffer *buffer = NULL;
+  GstFlowReturn ret;
+
+  if (demux->priv->fragment_cache_size == 0)
+    return gst_adaptive_demux_stream_download_uri (demux, stream, uri, start,
+        end, http_status);
+
+  /* the source bin is only created with the first download */
+  if (stream->internal_pad != NULL)
+    buffer = gst_fragment_cache_lookup (uri, start, end);
+  if (buffer) {
+    GST_DEBUG_OBJECT (stream->pad, "Got %s %s from the fragment cache",
+        uritype (stream), uri);
+    if (http_status)
+      *http_status = 200;
+    stream->download_start_time =
+        GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+    stream->last_connection_reused = FALSE;
+    stream->last_download_time = 0;
+    /* keep last_bitrate, this download says nothing about the bandwidth */
+    return gst_adaptive_demux_stream_push_download (demux, stream, buffer);
+  }
+
+  stream->cache_download = TRUE;
+  ret = gst_adaptive_demux_stream_download_uri (demux, stream, uri, start,
+      end, http_status);
+  if (ret == GST_FLOW_OK && stream->cache_download && stream->cache_data)
+    gst_fragment_cache_insert (uri, start, end, stream->cache_data,
+        stream->downloading_header || stream->downloading_index);
+  stream->cache_download = FALSE;
+  gst_buffer_replace (&stream->cache_data, NULL);
+
+  return ret;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Fetches the header and the index with one request if they are close
+ * enough ranges of the same file, and pushes them one after the other as if
+ * they had been downloaded separately. Returns FALSE if they have to be
+ * downloaded separately.
+ */
+static gboolean
+gst_adaptive_demux_stream_download_header_and_index (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstFlowReturn * ret)
+{
+  GstAdaptiveDemuxStreamFragment *fragment = &stream->fragment;
+  GstAdaptiveDemuxPrefetch *prefetch;
+  GstFragment *download = NULL;
+  GstBuffer *buffer = NULL, *header, *index;
+  gint64 gap;
+  gsize header_size, index_size;
+
+  /* the data is pushed through the source's pad, which only exists after
+   * the first download */
+  if (demux->priv->max_range_gap < 0 || stream->internal_pad == NULL
+      || fragment->header_uri == NULL || fragment->index_uri == NULL
+      || g_strcmp0 (fragment->header_uri, fragment->index_uri) != 0
+      || fragment->header_range_start < 0 || fragment->header_range_end < 0
+      || fragment->index_range_end < 0)
+    return FALSE;
+
+  gap = fragment->index_range_start - fragment->header_range_end - 1;
+  if (gap < 0 || gap > demux->priv->max_range_gap)
+    return FALSE;
+
+  if (demux->priv->fragment_cache_size > 0) {
+    buffer = gst_fragment_cache_lookup (fragment->header_uri,
+        fragment->header_range_start, fragment->header_range_end);
+    if (buffer) {
+      gst_buffer_unref (buffer);
+      return FALSE;
+    }
+  }
+
+  GST_DEBUG_OBJECT (stream->pad, "Fetching header and index %s %"
+      G_GINT64_FORMAT "-%" G_GINT64_FORMAT, fragment->header_uri,
+      fragment->header_range_start, fragment->index_range_end);
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+  stream->last_connection_reused = FALSE;
+
+  /* queued with the prefetches so that stop_tasks() can cancel it */
+  prefetch = gst_adaptive_demux_prefetch_new (demux,
+      g_strdup (fragment->header_uri), fragment->header_range_start,
+      fragment->index_range_end);
+  g_queue_push_head (&stream->prefetch,
+      gst_adaptive_demux_prefetch_ref (prefetch));
+  gst_adaptive_demux_prefetch_start (prefetch);
+
+  GST_MANIFEST_UNLOCK (demux);
+  g_mutex_lock (&prefetch->lock);
+  while (!prefetch->done)
+    g_cond_wait (&prefetch->cond, &prefetch->lock);
+  if (prefetch->download)
+    download = g_object_ref (prefetch->download);
+  g_mutex_unlock (&prefetch->lock);
+  GST_MANIFEST_LOCK (demux);
+
+  if (g_queue_remove (&stream->prefetch, prefetch))
+    gst_adaptive_demux_prefetch_unref (prefetch);
+  gst_adaptive_demux_prefetch_unref (prefetch);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    if (download)
+      g_object_unref (download);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    return TRUE;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  header_size = fragment->header_range_end - fragment->header_range_start + 1;
+  index_size = fragment->index_range_end - fragment->index_range_start + 1;
+
+  if (download) {
+    buffer = gst_fragment_get_buffer (download);
+    stream->last_download_time =
+        download->download_stop_time - download->download_start_time;
+    g_object_unref (download);
+  }
+  if (buffer == NULL
+      || gst_buffer_get_size (buffer) < header_size + gap + index_size) {
+    GST_DEBUG_OBJECT (stream->pad, "Could not fetch header and index"
+        " together, requesting them separately");
+    if (buffer)
+      gst_buffer_unref (buffer);
+    return FALSE;
+  }
+
+  if (stream->last_download_time > 0)
+    stream->last_bitrate =
+        gst_util_uint64_scale (gst_buffer_get_size (buffer), 8 * GST_SECOND,
+        stream->last_download_time);
+
+  /* both share the memory of the download */
+  header = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, 0,
+      header_size);
+  index = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY,
+      header_size + gap, index_size);
+  gst_buffer_unref (buffer);
+
+  /* like the source would have, to let the subclass know where in the
+   * file the data is */
+  GST_BUFFER_OFFSET (header) = fragment->header_range_start;
+  GST_BUFFER_OFFSET_END (header) = fragment->header_range_end + 1;
+  GST_BUFFER_OFFSET (index) = fragment->index_range_start;
+  GST_BUFFER_OFFSET_END (index) = fragment->index_range_end + 1;
+
+  if (demux->priv->fragment_cache_size > 0) {
+    gst_fragment_cache_insert (fragment->header_uri,
+        fragment->header_range_start, fragment->header_range_end, header, TRUE);
+    gst_fragment_cache_insert (fragment->index_uri,
+        fragment->index_range_start, fragment->index_range_end, index, TRUE);
+  }
+
+  stream->downloading_header = TRUE;
+  *ret = gst_adaptive_demux_stream_push_download (demux, stream, header);
+  stream->downloading_header = FALSE;
+
+  if (*ret == GST_FLOW_OK) {
+    stream->downloading_index = TRUE;
+    *ret = gst_adaptive_demux_stream_push_download (demux, stream, index);
+    stream->downloading_index = FALSE;
+  } else {
+    gst_buffer_unref (index);
+  }
+
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3254,13 +4162,17 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   GstAdaptiveDemux *demux = stream->demux;
   GstFlowReturn ret = GST_FLOW_OK;
 
+  if (gst_adaptive_demux_stream_download_header_and_index (demux, stream,
+          &ret))
+    return ret;
+
   if (stream->fragment.header_uri != NULL) {
     GST_DEBUG_OBJECT (demux, "Fetching header %s %" G_GINT64_FORMAT "-%"
         G_GINT64_FORMAT, stream->fragment.header_uri,
         stream->fragment.header_range_start, stream->fragment.header_range_end);
 
     stream->downloading_header = TRUE;
-    ret = gst_adaptive_demux_stream_download_uri (demux, stream,
+    ret = gst_adaptive_demux_stream_download_cached_uri (demux, stream,
         stream->fragment.header_uri, stream->fragment.header_range_start,
         stream->fragment.header_range_end, NULL);
     stream->downloading_header = FALSE;
@@ -3275,7 +4187,7 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
           stream->fragment.index_uri,
           stream->fragment.index_range_start, stream->fragment.index_range_end);
       stream->downloading_index = TRUE;
-      ret = gst_adaptive_demux_stream_download_uri (demux, stream,
+      ret = gst_adaptive_demux_stream_download_cached_uri (demux, stream,
           stream->fragment.index_uri, stream->fragment.index_range_start,
           stream->fragment.index_range_end, NULL);
       stream->downloading_index = FALSE;
@@ -3322,6 +4234,11 @@ gst_adaptive_demux_stream_download_fragment (GstAdaptiveDemuxStream * stream)
     stream->need_header = FALSE;
   }
 
+  /* the streams of the next period are created when all of this period's
+   * are done, start fetching what they will need with the last fragment */
+  if (!gst_adaptive_demux_stream_has_next_fragment (demux, stream))
+    gst_adaptive_demux_prefetch_next_period (demux);
+
 again:
   ret = GST_FLOW_OK;
   url = stream->fragment.uri;
@@ -3403,9 +4320,12 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
+    gst_adaptive_demux_stream_update_prefetch (demux, stream);
+    if (!gst_adaptive_demux_stream_push_prefetched (demux, stream, &ret))
+      ret =
+          gst_adaptive_demux_stream_download_cached_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
     GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
         stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
   }
@@ -4144,7 +5064,9 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
               "fragment-stop-time", GST_TYPE_CLOCK_TIME,
               gst_util_get_timestamp (), "fragment-size", G_TYPE_UINT64,
               stream->download_total_bytes, "fragment-download-time",
-              GST_TYPE_CLOCK_TIME, stream->last_download_time, NULL)));
+              GST_TYPE_CLOCK_TIME, stream->last_download_time,
+              "connection-reused", G_TYPE_BOOLEAN,
+              stream->last_connection_reused, NULL)));
 
   /* Don't update to the end of the segment if in reverse playback */
   GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
@@ -176,12 +176,20 @@ struct _GstAdaptiveDemuxStream
    * of previous fragment (pre-queue2) */
   GstClockTime last_latency;
   GstClockTime last_download_time;
+  /* TRUE if the source reported that the previous fragment was fetched over
+   * an already open connection */
+  gboolean last_connection_reused;
 
   /* Average for the last fragments */
   guint64 moving_bitrate;
   guint moving_index;
   guint64 *fragment_bitrates;
 
+  /* Exponentially weighted averages of the fragments bitrate, reacting
+   * quickly and slowly to changes */
+  gdouble ewma_fast_bitrate;
+  gdouble ewma_slow_bitrate;
+
   /* QoS data */
   GstClockTime qos_earliest_time;
 
@@ -193,6 +201,15 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* fragments requested ahead of the current one, protected by
+   * manifest_lock */
+  GQueue prefetch;
+
+  /* data of the current download, gathered (pre-queue2) when it is to be
+   * added to the fragment cache */
+  gboolean cache_download;
+  GstBuffer *cache_data;
 };
 
 /**
@@ -480,6 +497,39 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @offset: position of the fragment relative to the current one
+   * @uri: (out) (transfer full): location for the fragment URI
+   * @range_start: (out): location for the start of the byte range
+   * @range_end: (out): location for the (inclusive) end of the byte range,
+   *     or -1
+   *
+   * Optional. Gets the location of the fragment @offset fragments after the
+   * current one in the playback direction, without changing the current
+   * position. Used to request upcoming fragments in advance when the
+   * prefetch-depth property is set.
+   *
+   * Return: %TRUE if the fragment is known
+   */
+  gboolean (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream, guint offset, gchar ** uri, gint64 * range_start, gint64 * range_end);
+
+  /**
+   * peek_next_period:
+   * @demux: #GstAdaptiveDemux
+   *
+   * Optional. Gets the locations of the headers, indexes and first fragments
+   * the streams of the next period will start with, without changing the
+   * current period. Used to fetch them into the fragment cache while the
+   * current period is still playing, when the fragment-cache-size property
+   * is set.
+   *
+   * Return: (transfer full) (element-type GstFragment): a list of
+   *     #GstFragment with their uri, range_start and range_end set
+   */
+  GList *  (*peek_next_period) (GstAdaptiveDemux * demux);
 };
 
 GST_EXPORT
@@ -22,6 +22,7 @@
 #ifndef __GST_ALLOCATORS_BAD_H__
 #define __GST_ALLOCATORS_BAD_H__
 
+#include <gst/allocators/gstcmaallocator.h>
 #include <gst/allocators/gstphysmemory.h>
 
 #endif /* __GST_ALLOCATORS_BAD_H__ */
@@ -0,0 +1,269 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstcmaallocator
+ * @title: GstCmaAllocator
+ * @short_description: Physically contiguous dmabuf memory
+ *
+ * #GstCmaAllocator allocates memory from a Linux dma-heap, usually the CMA
+ * heap, and wraps it as #GstDmaBufMemory. Camera, scaler and encoder
+ * elements can share such memory without copies, either by importing its
+ * file descriptor or by its physical address with
+ * gst_phys_memory_get_phys_addr().
+ *
+ * A buffer pool of contiguous buffers is created by setting the allocator
+ * on the pool configuration with gst_buffer_pool_config_set_allocator().
+ *
+ * The physical address is looked up in /proc/self/pagemap, which only
+ * reports it to processes with %CAP_SYS_ADMIN. Otherwise
+ * gst_phys_memory_get_phys_addr() returns 0, and the memory has to be
+ * shared by its file descriptor.
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcmaallocator.h"
+#include "gstphysmemory.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#ifdef HAVE_LINUX_DMA_HEAP_H
+#include <linux/dma-heap.h>
+#else
+#include <linux/types.h>
+
+/* From the kernel's include/uapi/linux/dma-heap.h */
+struct dma_heap_allocation_data
+{
+  __u64 len;
+  __u32 fd;
+  __u32 fd_flags;
+  __u64 heap_flags;
+};
+
+#define DMA_HEAP_IOC_MAGIC 'H'
+#define DMA_HEAP_IOCTL_ALLOC _IOWR(DMA_HEAP_IOC_MAGIC, 0x0, \
+    struct dma_heap_allocation_data)
+#endif
+#endif
+
+GST_DEBUG_CATEGORY_STATIC (cmaallocator_debug);
+#define GST_CAT_DEFAULT cmaallocator_debug
+
+static void gst_cma_allocator_phys_iface_init (gpointer g_iface,
+    gpointer iface_data);
+
+#define gst_cma_allocator_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstCmaAllocator, gst_cma_allocator,
+    GST_TYPE_DMABUF_ALLOCATOR,
+    G_IMPLEMENT_INTERFACE (GST_TYPE_PHYS_MEMORY_ALLOCATOR,
+        gst_cma_allocator_phys_iface_init);
+    GST_DEBUG_CATEGORY_INIT (cmaallocator_debug, "cmaallocator", 0,
+        "CMA allocator"));
+
+static GQuark phys_addr_quark;
+
+static GstMemory *
+gst_cma_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+#ifdef __linux__
+  GstCmaAllocator *self = GST_CMA_ALLOCATOR (allocator);
+  struct dma_heap_allocation_data data = { 0, };
+  GstMemory *mem;
+  gsize maxsize;
+
+  maxsize = size + params->prefix + params->padding;
+
+  data.len = maxsize;
+  data.fd_flags = O_RDWR | O_CLOEXEC;
+
+  if (ioctl (self->heap_fd, DMA_HEAP_IOCTL_ALLOC, &data) < 0) {
+    GST_WARNING_OBJECT (self, "Failed to allocate %" G_GSIZE_FORMAT
+        " bytes: %s", maxsize, g_strerror (errno));
+    return NULL;
+  }
+
+  mem = gst_fd_allocator_alloc (allocator, data.fd, maxsize,
+      GST_FD_MEMORY_FLAG_NONE);
+  if (!mem) {
+    close (data.fd);
+    return NULL;
+  }
+
+  gst_memory_resize (mem, params->prefix, size);
+
+  GST_LOG_OBJECT (self, "allocated %" G_GSIZE_FORMAT " bytes as fd %d",
+      maxsize, data.fd);
+
+  return mem;
+#else
+  return NULL;
+#endif
+}
+
+/* The memory of the CMA heap is contiguous, so the physical address of the
+ * first page is the one of the whole memory. It is cached on the memory as
+ * the lookup maps it. When pagemap doesn't give the address, which is the
+ * case for all memories without the permission to see it, the lookup is
+ * not tried again. */
+static guintptr
+gst_cma_allocator_get_phys_addr (GstPhysMemoryAllocator * allocator,
+    GstMemory * mem)
+{
+#ifdef __linux__
+  GstCmaAllocator *self = GST_CMA_ALLOCATOR (allocator);
+  GstMemory *parent = mem->parent ? mem->parent : mem;
+  gpointer cached;
+  guintptr addr = 0;
+  GstMapInfo map;
+  guint64 entry;
+  glong page_size;
+
+  cached = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (parent),
+      phys_addr_quark);
+  if (cached)
+    return GPOINTER_TO_SIZE (cached) + mem->offset;
+
+  if (self->pagemap_fd < 0 || g_atomic_int_get (&self->phys_addr_unavailable))
+    return 0;
+
+  if (!gst_memory_map (parent, &map, GST_MAP_READ))
+    return 0;
+
+  /* dma-heap mappings are populated on the first access, and pagemap
+   * doesn't report pages that are not present */
+  (void) *(volatile guint8 *) map.data;
+
+  page_size = sysconf (_SC_PAGESIZE);
+  if (pread (self->pagemap_fd, &entry, sizeof (entry),
+          ((guintptr) map.data / page_size) * sizeof (entry)) == sizeof (entry)
+      && (entry & (G_GUINT64_CONSTANT (1) << 63))) {
+    /* present page, bits 0-54 are the page frame number, which reads as 0
+     * without the permission to see it */
+    addr = (entry & ((G_GUINT64_CONSTANT (1) << 55) - 1)) * page_size;
+  }
+
+  gst_memory_unmap (parent, &map);
+
+  if (addr == 0) {
+    GST_INFO_OBJECT (self, "physical address of fd %d not available, not "
+        "looking up any other", gst_dmabuf_memory_get_fd (parent));
+    g_atomic_int_set (&self->phys_addr_unavailable, TRUE);
+    return 0;
+  }
+
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (parent), phys_addr_quark,
+      GSIZE_TO_POINTER (addr), NULL);
+
+  return addr + mem->offset;
+#else
+  return 0;
+#endif
+}
+
+static void
+gst_cma_allocator_finalize (GObject * object)
+{
+#ifdef __linux__
+  GstCmaAllocator *self = GST_CMA_ALLOCATOR (object);
+
+  if (self->heap_fd >= 0)
+    close (self->heap_fd);
+  if (self->pagemap_fd >= 0)
+    close (self->pagemap_fd);
+#endif
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_cma_allocator_phys_iface_init (gpointer g_iface, gpointer iface_data)
+{
+  GstPhysMemoryAllocatorInterface *iface = g_iface;
+
+  iface->get_phys_addr = gst_cma_allocator_get_phys_addr;
+}
+
+static void
+gst_cma_allocator_class_init (GstCmaAllocatorClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstAllocatorClass *allocator_class = GST_ALLOCATOR_CLASS (klass);
+
+  gobject_class->finalize = gst_cma_allocator_finalize;
+  allocator_class->alloc = gst_cma_allocator_alloc;
+
+  phys_addr_quark = g_quark_from_static_string ("GstCmaAllocatorPhysAddr");
+}
+
+static void
+gst_cma_allocator_init (GstCmaAllocator * self)
+{
+  self->heap_fd = -1;
+  self->pagemap_fd = -1;
+}
+
+/**
+ * gst_cma_allocator_new:
+ * @heap: (allow-none): path of the dma-heap device to allocate from, or
+ *   %NULL for %GST_CMA_ALLOCATOR_DEFAULT_HEAP
+ *
+ * Creates an allocator of physically contiguous dmabuf memory.
+ *
+ * Returns: (transfer full) (nullable): a new #GstCmaAllocator, or %NULL if
+ *   the heap could not be opened
+ *
+ * Since: 1.14
+ */
+GstAllocator *
+gst_cma_allocator_new (const gchar * heap)
+{
+#ifdef __linux__
+  GstCmaAllocator *self;
+
+  if (!heap)
+    heap = GST_CMA_ALLOCATOR_DEFAULT_HEAP;
+
+  self = g_object_new (GST_TYPE_CMA_ALLOCATOR, NULL);
+  gst_object_ref_sink (self);
+
+  self->heap_fd = open (heap, O_RDWR | O_CLOEXEC);
+  if (self->heap_fd < 0) {
+    GST_WARNING_OBJECT (self, "Failed to open %s: %s", heap,
+        g_strerror (errno));
+    gst_object_unref (self);
+    return NULL;
+  }
+
+  self->pagemap_fd = open ("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+
+  return GST_ALLOCATOR_CAST (self);
+#else
+  return NULL;
+#endif
+}
@@ -0,0 +1,86 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CMA_ALLOCATOR_H__
+#define __GST_CMA_ALLOCATOR_H__
+
+#include <gst/gst.h>
+#include <gst/allocators/allocators.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstCmaAllocator GstCmaAllocator;
+typedef struct _GstCmaAllocatorClass GstCmaAllocatorClass;
+
+#define GST_TYPE_CMA_ALLOCATOR                  (gst_cma_allocator_get_type())
+#define GST_IS_CMA_ALLOCATOR(obj)               (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_CMA_ALLOCATOR))
+#define GST_IS_CMA_ALLOCATOR_CLASS(klass)       (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_CMA_ALLOCATOR))
+#define GST_CMA_ALLOCATOR_GET_CLASS(obj)        (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_CMA_ALLOCATOR, GstCmaAllocatorClass))
+#define GST_CMA_ALLOCATOR(obj)                  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_CMA_ALLOCATOR, GstCmaAllocator))
+#define GST_CMA_ALLOCATOR_CLASS(klass)          (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_CMA_ALLOCATOR, GstCmaAllocatorClass))
+#define GST_CMA_ALLOCATOR_CAST(obj)             ((GstCmaAllocator *)(obj))
+
+/**
+ * GST_CMA_ALLOCATOR_DEFAULT_HEAP:
+ *
+ * The dma-heap device used by gst_cma_allocator_new() when no heap is given.
+ *
+ * Since: 1.14
+ */
+#define GST_CMA_ALLOCATOR_DEFAULT_HEAP "/dev/dma_heap/linux,cma"
+
+/**
+ * GstCmaAllocator:
+ *
+ * Allocator of physically contiguous memory from a Linux dma-heap. The
+ * memories are #GstDmaBufMemory and can be shared with other devices and
+ * processes through their file descriptor. The allocator implements
+ * #GstPhysMemoryAllocator.
+ *
+ * Since: 1.14
+ */
+struct _GstCmaAllocator
+{
+  GstDmaBufAllocator parent;
+
+  /*< private >*/
+  gint heap_fd;
+  gint pagemap_fd;
+  /* set once pagemap turned out not to give physical addresses */
+  gint phys_addr_unavailable;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+struct _GstCmaAllocatorClass
+{
+  GstDmaBufAllocatorClass parent_class;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_EXPORT
+GType          gst_cma_allocator_get_type (void);
+
+GST_EXPORT
+GstAllocator * gst_cma_allocator_new      (const gchar * heap);
+
+G_END_DECLS
+
+#endif /* __GST_CMA_ALLOCATOR_H__ */
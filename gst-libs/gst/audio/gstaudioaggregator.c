@@ -158,6 +158,10 @@ struct _GstAudioAggregatorPrivate
   /* Readable with object lock, writable with both aag lock and object lock */
 
   gint64 offset;                /* Sample offset starting from 0 at segment.start */
+
+  /* Inputs collected for aggregate_all_buffers(), only used from the
+   * aggregate function */
+  GArray *inputs;
 };
 
 #define GST_AUDIO_AGGREGATOR_LOCK(self)   g_mutex_lock (&(self)->priv->mutex);
@@ -294,6 +298,9 @@ gst_audio_aggregator_init (GstAudioAggregator * aagg)
   aagg->priv->alignment_threshold = DEFAULT_ALIGNMENT_THRESHOLD;
   aagg->priv->discont_wait = DEFAULT_DISCONT_WAIT;
 
+  aagg->priv->inputs = g_array_new (FALSE, FALSE,
+      sizeof (GstAudioAggregatorInput));
+
   aagg->current_caps = NULL;
   gst_audio_info_init (&aagg->info);
 
@@ -308,6 +315,11 @@ gst_audio_aggregator_dispose (GObject * object)
 
   gst_caps_replace (&aagg->current_caps, NULL);
 
+  if (aagg->priv->inputs) {
+    g_array_free (aagg->priv->inputs, TRUE);
+    aagg->priv->inputs = NULL;
+  }
+
   g_mutex_clear (&aagg->priv->mutex);
 
   G_OBJECT_CLASS (gst_audio_aggregator_parent_class)->dispose (object);
@@ -966,18 +978,15 @@ done:
   return TRUE;
 }
 
-/* Called with pad object lock held */
-
-static gboolean
-gst_audio_aggregator_mix_buffer (GstAudioAggregator * aagg,
-    GstAudioAggregatorPad * pad, GstBuffer * inbuf, GstBuffer * outbuf)
+/* Called with pad object lock held. Returns the number of frames of the
+ * pad's current buffer that overlap the current output buffer and stores
+ * the offset of the first one in the output buffer in @out_start */
+static guint
+gst_audio_aggregator_pad_get_overlap (GstAudioAggregator * aagg,
+    GstAudioAggregatorPad * pad, guint * out_start)
 {
   guint overlap;
-  guint out_start;
-  gboolean filled;
   guint blocksize;
-  guint in_offset;
-  gboolean pad_changed = FALSE;
 
   blocksize = gst_util_uint64_scale (aagg->priv->output_buffer_duration,
       GST_AUDIO_INFO_RATE (&aagg->info), GST_SECOND);
@@ -985,24 +994,75 @@ gst_audio_aggregator_mix_buffer (GstAudioAggregator * aagg,
 
   /* Overlap => mix */
   if (aagg->priv->offset < pad->priv->output_offset)
-    out_start = pad->priv->output_offset - aagg->priv->offset;
+    *out_start = pad->priv->output_offset - aagg->priv->offset;
   else
-    out_start = 0;
+    *out_start = 0;
 
   overlap = pad->priv->size - pad->priv->position;
-  if (overlap > blocksize - out_start)
-    overlap = blocksize - out_start;
+  if (overlap > blocksize - *out_start)
+    overlap = blocksize - *out_start;
+
+  return overlap;
+}
+
+/* Called with pad object lock held. Skips a gap buffer, returns TRUE if
+ * @inbuf was one */
+static gboolean
+gst_audio_aggregator_pad_skip_gap (GstAudioAggregatorPad * pad,
+    GstBuffer * inbuf)
+{
+  if (!GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP))
+    return FALSE;
+
+  /* skip gap buffer */
+  GST_LOG_OBJECT (pad, "skipping GAP buffer");
+  pad->priv->output_offset += pad->priv->size - pad->priv->position;
+  pad->priv->position = pad->priv->size;
+
+  gst_buffer_replace (&pad->priv->buffer, NULL);
+  return TRUE;
+}
+
+/* Called with pad object lock held. Advances the pad after @overlap frames
+ * of @inbuf were mixed. Returns FALSE if the pad is done with its buffer */
+static gboolean
+gst_audio_aggregator_pad_advance (GstAudioAggregatorPad * pad,
+    GstBuffer * inbuf, guint overlap)
+{
+  /* The pad was flushed while we were mixing */
+  if (inbuf != pad->priv->buffer)
+    return FALSE;
 
-  if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP)) {
-    /* skip gap buffer */
-    GST_LOG_OBJECT (pad, "skipping GAP buffer");
-    pad->priv->output_offset += pad->priv->size - pad->priv->position;
-    pad->priv->position = pad->priv->size;
+  pad->priv->position += overlap;
+  pad->priv->output_offset += overlap;
 
+  if (pad->priv->position == pad->priv->size) {
+    /* Buffer done, drop it */
     gst_buffer_replace (&pad->priv->buffer, NULL);
+    GST_LOG_OBJECT (pad, "Finished mixing buffer, waiting for next");
     return FALSE;
   }
 
+  return TRUE;
+}
+
+/* Called with pad object lock held */
+
+static gboolean
+gst_audio_aggregator_mix_buffer (GstAudioAggregator * aagg,
+    GstAudioAggregatorPad * pad, GstBuffer * inbuf, GstBuffer * outbuf)
+{
+  guint overlap;
+  guint out_start;
+  gboolean filled;
+  guint in_offset;
+  gboolean ret;
+
+  overlap = gst_audio_aggregator_pad_get_overlap (aagg, pad, &out_start);
+
+  if (gst_audio_aggregator_pad_skip_gap (pad, inbuf))
+    return FALSE;
+
   gst_buffer_ref (inbuf);
   in_offset = pad->priv->position;
   GST_OBJECT_UNLOCK (pad);
@@ -1014,28 +1074,80 @@ gst_audio_aggregator_mix_buffer (GstAudioAggregator * aagg,
   GST_OBJECT_LOCK (aagg);
   GST_OBJECT_LOCK (pad);
 
-  pad_changed = (inbuf != pad->priv->buffer);
-  gst_buffer_unref (inbuf);
-
   if (filled)
     GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
 
-  if (pad_changed)
-    return FALSE;
+  ret = gst_audio_aggregator_pad_advance (pad, inbuf, overlap);
+  gst_buffer_unref (inbuf);
 
-  pad->priv->position += overlap;
-  pad->priv->output_offset += overlap;
+  return ret;
+}
 
-  if (pad->priv->position == pad->priv->size) {
-    /* Buffer done, drop it */
-    gst_buffer_replace (&pad->priv->buffer, NULL);
-    GST_LOG_OBJECT (pad, "Finished mixing buffer, waiting for next");
+/* Called with pad object lock held. Like gst_audio_aggregator_mix_buffer()
+ * but only queues the input, gst_audio_aggregator_mix_inputs() mixes all
+ * queued inputs at once. Stores the output offset the pad will be at once
+ * its input is mixed in @end_offset */
+
+static gboolean
+gst_audio_aggregator_queue_input (GstAudioAggregator * aagg,
+    GstAudioAggregatorPad * pad, GstBuffer * inbuf, guint64 * end_offset)
+{
+  GstAudioAggregatorInput input;
+
+  input.num_frames = gst_audio_aggregator_pad_get_overlap (aagg, pad,
+      &input.out_offset);
+
+  if (gst_audio_aggregator_pad_skip_gap (pad, inbuf)) {
+    *end_offset = pad->priv->output_offset;
     return FALSE;
   }
 
+  input.pad = gst_object_ref (pad);
+  input.buffer = gst_buffer_ref (inbuf);
+  input.in_offset = pad->priv->position;
+  g_array_append_val (aagg->priv->inputs, input);
+
+  *end_offset = pad->priv->output_offset + input.num_frames;
+
   return TRUE;
 }
 
+/* Called with the object lock held */
+
+static void
+gst_audio_aggregator_mix_inputs (GstAudioAggregator * aagg, GstBuffer * outbuf)
+{
+  GArray *inputs = aagg->priv->inputs;
+  gboolean filled;
+  guint i;
+
+  GST_OBJECT_UNLOCK (aagg);
+  filled = GST_AUDIO_AGGREGATOR_GET_CLASS (aagg)->aggregate_all_buffers (aagg,
+      (GstAudioAggregatorInput *) inputs->data, inputs->len, outbuf);
+  GST_OBJECT_LOCK (aagg);
+
+  if (filled)
+    GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
+
+  for (i = 0; i < inputs->len; i++) {
+    GstAudioAggregatorInput *input =
+        &g_array_index (inputs, GstAudioAggregatorInput, i);
+    gboolean drop_buf;
+
+    GST_OBJECT_LOCK (input->pad);
+    drop_buf = !gst_audio_aggregator_pad_advance (input->pad, input->buffer,
+        input->num_frames);
+    GST_OBJECT_UNLOCK (input->pad);
+
+    if (drop_buf)
+      gst_aggregator_pad_drop_buffer (GST_AGGREGATOR_PAD (input->pad));
+
+    gst_buffer_unref (input->buffer);
+    gst_object_unref (input->pad);
+  }
+  g_array_set_size (inputs, 0);
+}
+
 static GstBuffer *
 gst_audio_aggregator_create_output_buffer (GstAudioAggregator * aagg,
     guint num_frames)
@@ -1060,6 +1172,28 @@ gst_audio_aggregator_create_output_buffer (GstAudioAggregator * aagg,
   return outbuf;
 }
 
+/* Non-interleaved output buffers have their planes laid out for a full
+ * buffer. Moves them next to each other, for the first @num_frames samples
+ * of each plane to be all the buffer contains once it is shortened. */
+static void
+gst_audio_aggregator_pack_planes (GstAudioAggregator * aagg,
+    GstBuffer * outbuf, guint num_frames)
+{
+  GstMapInfo outmap;
+  gint channels = GST_AUDIO_INFO_CHANNELS (&aagg->info);
+  gsize sample_size = GST_AUDIO_INFO_BPF (&aagg->info) / channels;
+  gsize plane_size, packed_size;
+  gint c;
+
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
+  plane_size = outmap.size / channels;
+  packed_size = num_frames * sample_size;
+  for (c = 1; c < channels; c++)
+    memmove (outmap.data + c * packed_size, outmap.data + c * plane_size,
+        packed_size);
+  gst_buffer_unmap (outbuf, &outmap);
+}
+
 static gboolean
 sync_pad_values (GstAudioAggregator * aagg, GstAudioAggregatorPad * pad)
 {
@@ -1125,10 +1259,12 @@ gst_audio_aggregator_aggregate (GstAggregator * agg, gboolean timeout)
   gboolean dropped = FALSE;
   gboolean is_eos = TRUE;
   gboolean is_done = TRUE;
+  gboolean mix_all;
   guint blocksize;
 
   element = GST_ELEMENT (agg);
   aagg = GST_AUDIO_AGGREGATOR (agg);
+  mix_all = GST_AUDIO_AGGREGATOR_GET_CLASS (aagg)->aggregate_all_buffers != NULL;
 
   /* Sync pad properties to the stream time */
   gst_aggregator_iterate_sinkpads (agg,
@@ -1293,13 +1429,22 @@ gst_audio_aggregator_aggregate (GstAggregator * agg, gboolean timeout)
     if (pad->priv->output_offset >= aagg->priv->offset
         && pad->priv->output_offset <
         aagg->priv->offset + blocksize && pad->priv->buffer) {
-      GST_LOG_OBJECT (aggpad, "Mixing buffer for current offset");
-      drop_buf = !gst_audio_aggregator_mix_buffer (aagg, pad, pad->priv->buffer,
-          outbuf);
-      if (pad->priv->output_offset >= next_offset) {
+      guint64 end_offset;
+
+      if (mix_all) {
+        GST_LOG_OBJECT (aggpad, "Queueing buffer for current offset");
+        drop_buf = !gst_audio_aggregator_queue_input (aagg, pad,
+            pad->priv->buffer, &end_offset);
+      } else {
+        GST_LOG_OBJECT (aggpad, "Mixing buffer for current offset");
+        drop_buf = !gst_audio_aggregator_mix_buffer (aagg, pad,
+            pad->priv->buffer, outbuf);
+        end_offset = pad->priv->output_offset;
+      }
+      if (end_offset >= next_offset) {
         GST_LOG_OBJECT (pad,
             "Pad is at or after current offset: %" G_GUINT64_FORMAT " >= %"
-            G_GINT64_FORMAT, pad->priv->output_offset, next_offset);
+            G_GINT64_FORMAT, end_offset, next_offset);
       } else {
         is_done = FALSE;
       }
@@ -1310,6 +1455,10 @@ gst_audio_aggregator_aggregate (GstAggregator * agg, gboolean timeout)
       gst_aggregator_pad_drop_buffer (aggpad);
 
   }
+
+  if (aagg->priv->inputs->len > 0)
+    gst_audio_aggregator_mix_inputs (aagg, outbuf);
+
   GST_OBJECT_UNLOCK (agg);
 
   if (dropped) {
@@ -1356,8 +1505,14 @@ gst_audio_aggregator_aggregate (GstAggregator * agg, gboolean timeout)
           agg->segment.start + gst_util_uint64_scale (next_offset, GST_SECOND,
           rate);
 
-      if (next_offset > aagg->priv->offset)
-        gst_buffer_resize (outbuf, 0, (next_offset - aagg->priv->offset) * bpf);
+      if (next_offset > aagg->priv->offset) {
+        guint n_samples = next_offset - aagg->priv->offset;
+
+        if (GST_AUDIO_INFO_LAYOUT (&aagg->info) ==
+            GST_AUDIO_LAYOUT_NON_INTERLEAVED)
+          gst_audio_aggregator_pack_planes (aagg, outbuf, n_samples);
+        gst_buffer_resize (outbuf, 0, n_samples * bpf);
+      }
     }
   }
 
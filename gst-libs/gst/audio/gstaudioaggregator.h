@@ -130,6 +130,27 @@ struct _GstAudioAggregator
   gpointer                 _gst_reserved[GST_PADDING];
 };
 
+/**
+ * GstAudioAggregatorInput:
+ * @pad: The pad the input comes from
+ * @buffer: The input buffer
+ * @in_offset: Offset in frames of the first frame to aggregate in @buffer
+ * @out_offset: Offset in frames in the output buffer to aggregate to
+ * @num_frames: Number of frames to aggregate
+ *
+ * The part of one pad's input that overlaps the current output buffer,
+ * as passed to aggregate_all_buffers().
+ *
+ * Since: 1.14
+ */
+typedef struct {
+  GstAudioAggregatorPad *pad;
+  GstBuffer             *buffer;
+  guint                  in_offset;
+  guint                  out_offset;
+  guint                  num_frames;
+} GstAudioAggregatorInput;
+
 /**
  * GstAudioAggregatorClass:
  * @create_output_buffer: Create a new output buffer contains num_frames frames.
@@ -137,6 +158,9 @@ struct _GstAudioAggregator
  *  buffer.  The in_offset and out_offset are in "frames", which is
  *  the size of a sample times the number of channels. Returns TRUE if
  *  any non-silence was added to the buffer
+ * @aggregate_all_buffers: Aggregates the inputs of all pads to the output
+ *  buffer at once. If set, it is used instead of @aggregate_one_buffer.
+ *  Returns TRUE if any non-silence was added to the buffer. Since: 1.14
  */
 struct _GstAudioAggregatorClass {
   GstAggregatorClass   parent_class;
@@ -146,6 +170,8 @@ struct _GstAudioAggregatorClass {
   gboolean (* aggregate_one_buffer) (GstAudioAggregator * aagg,
       GstAudioAggregatorPad * pad, GstBuffer * inbuf, guint in_offset,
       GstBuffer * outbuf, guint out_offset, guint num_frames);
+  gboolean (* aggregate_all_buffers) (GstAudioAggregator * aagg,
+      GstAudioAggregatorInput * inputs, guint n_inputs, GstBuffer * outbuf);
 
   /*< private >*/
   gpointer          _gst_reserved[GST_PADDING];
@@ -246,6 +246,12 @@ gst_nonstream_audio_decoder_set_initial_state (GstNonstreamAudioDecoder * dec);
 static void gst_nonstream_audio_decoder_cleanup_state (GstNonstreamAudioDecoder
     * dec);
 
+static void
+gst_nonstream_audio_decoder_clear_output_pool (GstNonstreamAudioDecoder * dec);
+static void
+gst_nonstream_audio_decoder_create_output_pool (GstNonstreamAudioDecoder * dec,
+    gsize size);
+
 static gboolean gst_nonstream_audio_decoder_negotiate (GstNonstreamAudioDecoder
     * dec);
 
@@ -1165,6 +1171,8 @@ gst_nonstream_audio_decoder_set_initial_state (GstNonstreamAudioDecoder * dec)
   dec->toc = NULL;
 
   dec->allocator = NULL;
+  dec->output_pool = NULL;
+  dec->output_pool_buffer_size = 0;
 }
 
 
@@ -1178,6 +1186,8 @@ gst_nonstream_audio_decoder_cleanup_state (GstNonstreamAudioDecoder * dec)
     dec->allocator = NULL;
   }
 
+  gst_nonstream_audio_decoder_clear_output_pool (dec);
+
   if (dec->toc != NULL) {
     gst_toc_unref (dec->toc);
     dec->toc = NULL;
@@ -1187,6 +1197,46 @@ gst_nonstream_audio_decoder_cleanup_state (GstNonstreamAudioDecoder * dec)
 }
 
 
+static void
+gst_nonstream_audio_decoder_clear_output_pool (GstNonstreamAudioDecoder * dec)
+{
+  if (dec->output_pool != NULL) {
+    gst_buffer_pool_set_active (dec->output_pool, FALSE);
+    gst_object_unref (dec->output_pool);
+    dec->output_pool = NULL;
+  }
+  dec->output_pool_buffer_size = 0;
+}
+
+
+static void
+gst_nonstream_audio_decoder_create_output_pool (GstNonstreamAudioDecoder * dec,
+    gsize size)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+  gst_buffer_pool_config_set_allocator (config, dec->allocator,
+      &(dec->allocation_params));
+
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (dec, "could not set up output buffer pool");
+    gst_object_unref (pool);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (dec, "created output buffer pool for buffers of %"
+      G_GSIZE_FORMAT " bytes", size);
+
+  dec->output_pool = pool;
+  dec->output_pool_buffer_size = size;
+}
+
+
 static gboolean
 gst_nonstream_audio_decoder_negotiate (GstNonstreamAudioDecoder * dec)
 {
@@ -1269,6 +1319,9 @@ gst_nonstream_audio_decoder_negotiate_default (GstNonstreamAudioDecoder * dec)
   dec->allocator = allocator;
   dec->allocation_params = allocation_params;
 
+  /* the pool's buffers came from the old allocator */
+  gst_nonstream_audio_decoder_clear_output_pool (dec);
+
 done:
   if (query != NULL)
     gst_query_unref (query);
@@ -2484,6 +2537,10 @@ gst_nonstream_audio_decoder_get_downstream_info (GstNonstreamAudioDecoder * dec,
  * @size: Size of the output buffer, in bytes
  *
  * Allocates an output buffer with the internally configured buffer pool.
+ * Buffers of the same size are recycled once downstream releases them, so
+ * subclasses should ask for the same @size on each @decode call where they
+ * can, and shrink the buffer with gst_buffer_set_size() if less was
+ * decoded.
  *
  * This function may only be called from within @load_from_buffer,
  * @load_from_custom, and @decode.
@@ -2508,6 +2565,24 @@ gst_nonstream_audio_decoder_allocate_output_buffer (GstNonstreamAudioDecoder *
     }
   }
 
+  /* decode() asks for buffers of the same size over and over, recycle
+   * them through a pool instead of allocating each one */
+  if (G_UNLIKELY (dec->output_pool == NULL
+          || dec->output_pool_buffer_size != size)) {
+    gst_nonstream_audio_decoder_clear_output_pool (dec);
+    gst_nonstream_audio_decoder_create_output_pool (dec, size);
+  }
+
+  if (G_LIKELY (dec->output_pool != NULL)) {
+    GstBuffer *buffer;
+
+    if (gst_buffer_pool_acquire_buffer (dec->output_pool, &buffer,
+            NULL) == GST_FLOW_OK)
+      return buffer;
+
+    GST_WARNING_OBJECT (dec, "could not acquire buffer from output pool");
+  }
+
   return gst_buffer_new_allocate (dec->allocator, size,
       &(dec->allocation_params));
 }
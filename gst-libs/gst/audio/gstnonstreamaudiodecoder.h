@@ -169,6 +169,9 @@ struct _GstNonstreamAudioDecoder
   /* allocation */
   GstAllocator *allocator;
   GstAllocationParams allocation_params;
+  /* output buffers of the size decode() last asked for are recycled */
+  GstBufferPool *output_pool;
+  gsize output_pool_buffer_size;
 
   /* thread safety */
   GMutex mutex;
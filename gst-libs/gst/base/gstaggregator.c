@@ -213,7 +213,12 @@ struct _GstAggregatorPadPrivate
 
   GQueue buffers;
   GstBuffer *clipped_buffer;
-  guint num_buffers;
+
+  /* The following are also written with the PAD_LOCK held, but updated
+   * atomically so that the srcpad task can check whether the pad is ready
+   * without taking the PAD_LOCK of every pad on each wakeup */
+  gint num_buffers;
+  gint num_queued;              /* items in buffers + clipped_buffer */
   GstClockTime head_position;
   GstClockTime tail_position;
   GstClockTime head_time;
@@ -221,9 +226,14 @@ struct _GstAggregatorPadPrivate
   GstClockTime time_level;
   GstSegment head_segment;      /* segment before the queue */
 
+  /* statistics, protected by the PAD_LOCK */
+  guint64 queued_bytes;
+  guint64 late_buffers;
+  guint64 dropped_buffers;
+
   gboolean negotiated;
 
-  gboolean eos;
+  gboolean eos;                 /* also accessed atomically */
 
   GMutex lock;
   GCond event_cond;
@@ -238,7 +248,7 @@ static void
 gst_aggregator_pad_reset_unlocked (GstAggregatorPad * aggpad)
 {
   aggpad->priv->pending_eos = FALSE;
-  aggpad->priv->eos = FALSE;
+  g_atomic_int_set (&aggpad->priv->eos, FALSE);
   aggpad->priv->flow_return = GST_FLOW_OK;
   GST_OBJECT_LOCK (aggpad);
   gst_segment_init (&aggpad->segment, GST_FORMAT_UNDEFINED);
@@ -252,6 +262,39 @@ gst_aggregator_pad_reset_unlocked (GstAggregatorPad * aggpad)
   aggpad->priv->first_buffer = TRUE;
 }
 
+/* Must be called with PAD_LOCK held */
+static void
+gst_aggregator_pad_queue_push_unlocked (GstAggregatorPad * aggpad,
+    gpointer item, gboolean head)
+{
+  if (head)
+    g_queue_push_head (&aggpad->priv->buffers, item);
+  else
+    g_queue_push_tail (&aggpad->priv->buffers, item);
+  g_atomic_int_inc (&aggpad->priv->num_queued);
+}
+
+/* Must be called with PAD_LOCK held */
+static gpointer
+gst_aggregator_pad_queue_pop_tail_unlocked (GstAggregatorPad * aggpad)
+{
+  gpointer item = g_queue_pop_tail (&aggpad->priv->buffers);
+
+  if (item)
+    g_atomic_int_add (&aggpad->priv->num_queued, -1);
+
+  return item;
+}
+
+/* Must be called with PAD_LOCK held */
+static void
+gst_aggregator_pad_queue_update_unlocked (GstAggregatorPad * aggpad)
+{
+  g_atomic_int_set (&aggpad->priv->num_queued,
+      g_queue_get_length (&aggpad->priv->buffers) +
+      (aggpad->priv->clipped_buffer ? 1 : 0));
+}
+
 static gboolean
 gst_aggregator_pad_flush (GstAggregatorPad * aggpad, GstAggregator * agg)
 {
@@ -316,8 +359,17 @@ struct _GstAggregatorPrivate
   GstBufferPool *pool;
   GstAllocationParams allocation_params;
 
+  /* statistics, protected by the object lock */
+  guint64 aggregates;
+  guint64 timeout_aggregates;
+  GstClockTime aggregate_time;
+  GstClockTime max_aggregate_time;
+  gint64 last_stats_message;    /* monotonic time, in microseconds */
+
   /* properties */
   gint64 latency;               /* protected by both src_lock and all pad locks */
+  gboolean coalesce_wakeups;    /* protected by object lock */
+  GstClockTime stats_interval;  /* protected by object lock */
 };
 
 typedef struct
@@ -333,6 +385,8 @@ typedef struct
 #define DEFAULT_LATENCY              0
 #define DEFAULT_START_TIME_SELECTION GST_AGGREGATOR_START_TIME_SELECTION_ZERO
 #define DEFAULT_START_TIME           (-1)
+#define DEFAULT_COALESCE_WAKEUPS     FALSE
+#define DEFAULT_STATS_INTERVAL       0
 
 enum
 {
@@ -340,6 +394,9 @@ enum
   PROP_LATENCY,
   PROP_START_TIME_SELECTION,
   PROP_START_TIME,
+  PROP_COALESCE_WAKEUPS,
+  PROP_STATS,
+  PROP_STATS_INTERVAL,
   PROP_LAST
 };
 
@@ -427,11 +484,12 @@ no_iter:
   return result;
 }
 
+/* Can be called without the PAD_LOCK, but the result is only stable with
+ * the PAD_LOCK held */
 static gboolean
 gst_aggregator_pad_queue_is_empty (GstAggregatorPad * pad)
 {
-  return (g_queue_peek_tail (&pad->priv->buffers) == NULL &&
-      pad->priv->clipped_buffer == NULL);
+  return g_atomic_int_get (&pad->priv->num_queued) == 0;
 }
 
 static gboolean
@@ -450,22 +508,21 @@ gst_aggregator_check_pads_ready (GstAggregator * self)
   if (sinkpads == NULL)
     goto no_sinkpads;
 
+  /* The pad state is only read atomically here instead of taking every
+   * PAD_LOCK. Anything queuing data does so with the SRC_LOCK held, which
+   * we hold too, so no change can be missed. */
   for (l = sinkpads; l != NULL; l = l->next) {
     pad = l->data;
 
-    PAD_LOCK (pad);
-
-    if (pad->priv->num_buffers == 0) {
+    if (g_atomic_int_get (&pad->priv->num_buffers) == 0) {
       if (!gst_aggregator_pad_queue_is_empty (pad))
         have_event = TRUE;
-      if (!pad->priv->eos) {
+      if (!g_atomic_int_get (&pad->priv->eos)) {
         have_buffer = FALSE;
 
         /* If not live we need data on all pads, so leave the loop */
-        if (!self->priv->peer_latency_live) {
-          PAD_UNLOCK (pad);
+        if (!self->priv->peer_latency_live)
           goto pad_not_ready;
-        }
       }
     } else if (self->priv->peer_latency_live) {
       /* In live mode, having a single pad with buffers is enough to
@@ -474,8 +531,6 @@ gst_aggregator_check_pads_ready (GstAggregator * self)
        */
       self->priv->first_buffer = FALSE;
     }
-
-    PAD_UNLOCK (pad);
   }
 
   if (!have_buffer && !have_event)
@@ -506,6 +561,24 @@ pad_not_ready:
   }
 }
 
+/* Must be called with the object lock held. Whether the aggregate task
+ * would find all pads ready, see gst_aggregator_check_pads_ready(). */
+static gboolean
+gst_aggregator_all_pads_have_data_locked (GstAggregator * self)
+{
+  GList *l;
+
+  for (l = GST_ELEMENT_CAST (self)->sinkpads; l != NULL; l = l->next) {
+    GstAggregatorPad *pad = l->data;
+
+    if (g_atomic_int_get (&pad->priv->num_buffers) == 0 &&
+        !g_atomic_int_get (&pad->priv->eos))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static void
 gst_aggregator_reset_flow_values (GstAggregator * self)
 {
@@ -763,7 +836,7 @@ check_events (GstAggregator * self, GstAggregatorPad * pad, gpointer user_data)
     PAD_LOCK (pad);
     if (pad->priv->num_buffers == 0 && pad->priv->pending_eos) {
       pad->priv->pending_eos = FALSE;
-      pad->priv->eos = TRUE;
+      g_atomic_int_set (&pad->priv->eos, TRUE);
     }
     if (pad->priv->clipped_buffer == NULL &&
         !GST_IS_BUFFER (g_queue_peek_tail (&pad->priv->buffers))) {
@@ -790,7 +863,7 @@ check_events (GstAggregator * self, GstAggregatorPad * pad, gpointer user_data)
         if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS)
           pad->priv->negotiated = ret;
         if (g_queue_peek_tail (&pad->priv->buffers) == event)
-          gst_event_unref (g_queue_pop_tail (&pad->priv->buffers));
+          gst_event_unref (gst_aggregator_pad_queue_pop_tail_unlocked (pad));
         gst_event_unref (event);
       }
 
@@ -805,7 +878,7 @@ check_events (GstAggregator * self, GstAggregatorPad * pad, gpointer user_data)
           s = gst_query_writable_structure (query);
           gst_structure_set (s, "gst-aggregator-retval", G_TYPE_BOOLEAN, ret,
               NULL);
-          g_queue_pop_tail (&pad->priv->buffers);
+          gst_aggregator_pad_queue_pop_tail_unlocked (pad);
         }
       }
 
@@ -846,8 +919,10 @@ gst_aggregator_pad_set_flushing (GstAggregatorPad * aggpad,
     }
     item = next;
   }
-  aggpad->priv->num_buffers = 0;
+  g_atomic_int_set (&aggpad->priv->num_buffers, 0);
   gst_buffer_replace (&aggpad->priv->clipped_buffer, NULL);
+  gst_aggregator_pad_queue_update_unlocked (aggpad);
+  aggpad->priv->queued_bytes = 0;
 
   PAD_BROADCAST_EVENT (aggpad);
   PAD_UNLOCK (aggpad);
@@ -1079,6 +1154,95 @@ done:
   return ret;
 }
 
+static gboolean
+append_pad_stats (GstAggregator * self, GstAggregatorPad * aggpad,
+    GValue * pad_stats)
+{
+  GValue value = G_VALUE_INIT;
+  GstStructure *s;
+
+  PAD_LOCK (aggpad);
+  s = gst_structure_new ("application/x-aggregator-pad-stats",
+      "pad-name", G_TYPE_STRING, GST_PAD_NAME (aggpad),
+      "queued-buffers", G_TYPE_UINT,
+      (guint) g_atomic_int_get (&aggpad->priv->num_buffers),
+      "queued-bytes", G_TYPE_UINT64, aggpad->priv->queued_bytes,
+      "queued-time", G_TYPE_UINT64, aggpad->priv->time_level,
+      "late-buffers", G_TYPE_UINT64, aggpad->priv->late_buffers,
+      "dropped-buffers", G_TYPE_UINT64, aggpad->priv->dropped_buffers, NULL);
+  PAD_UNLOCK (aggpad);
+
+  g_value_init (&value, GST_TYPE_STRUCTURE);
+  g_value_take_boxed (&value, s);
+  gst_value_array_append_and_take_value (pad_stats, &value);
+
+  return TRUE;
+}
+
+static GstStructure *
+gst_aggregator_create_stats (GstAggregator * self)
+{
+  GValue pad_stats = G_VALUE_INIT;
+  GstStructure *s;
+  GList *l;
+
+  g_value_init (&pad_stats, GST_TYPE_ARRAY);
+
+  GST_OBJECT_LOCK (self);
+  s = gst_structure_new ("application/x-aggregator-stats",
+      "aggregates", G_TYPE_UINT64, self->priv->aggregates,
+      "timeout-aggregates", G_TYPE_UINT64, self->priv->timeout_aggregates,
+      "aggregate-time", G_TYPE_UINT64, self->priv->aggregate_time,
+      "max-aggregate-time", G_TYPE_UINT64, self->priv->max_aggregate_time,
+      "latency", G_TYPE_UINT64, self->priv->latency, NULL);
+
+  for (l = GST_ELEMENT (self)->sinkpads; l; l = l->next)
+    append_pad_stats (self, GST_AGGREGATOR_PAD (l->data), &pad_stats);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_structure_take_value (s, "pad-stats", &pad_stats);
+
+  return s;
+}
+
+/* Accounts for one call to aggregate() that took @elapsed microseconds and
+ * posts the statistics on the bus when #GstAggregator:stats-interval has
+ * passed since the last time */
+static void
+gst_aggregator_update_stats (GstAggregator * self, gboolean timeout,
+    gint64 elapsed)
+{
+  GstClockTime interval;
+  gint64 now;
+  gboolean post = FALSE;
+
+  GST_OBJECT_LOCK (self);
+  self->priv->aggregates++;
+  if (timeout)
+    self->priv->timeout_aggregates++;
+  self->priv->aggregate_time += elapsed * GST_USECOND;
+  self->priv->max_aggregate_time = MAX (self->priv->max_aggregate_time,
+      elapsed * GST_USECOND);
+
+  interval = self->priv->stats_interval;
+  if (interval > 0) {
+    now = g_get_monotonic_time ();
+    if (self->priv->last_stats_message == 0) {
+      self->priv->last_stats_message = now;
+    } else if ((now - self->priv->last_stats_message) * GST_USECOND >=
+        interval) {
+      self->priv->last_stats_message = now;
+      post = TRUE;
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (post)
+    gst_element_post_message (GST_ELEMENT_CAST (self),
+        gst_message_new_element (GST_OBJECT_CAST (self),
+            gst_aggregator_create_stats (self)));
+}
+
 static void
 gst_aggregator_aggregate_func (GstAggregator * self)
 {
@@ -1112,8 +1276,13 @@ gst_aggregator_aggregate_func (GstAggregator * self)
     }
 
     if (timeout || flow_return >= GST_FLOW_OK) {
+      gint64 start;
+
       GST_TRACE_OBJECT (self, "Actually aggregating!");
+      start = g_get_monotonic_time ();
       flow_return = klass->aggregate (self, timeout);
+      gst_aggregator_update_stats (self, timeout,
+          g_get_monotonic_time () - start);
     }
 
     if (flow_return == GST_AGGREGATOR_FLOW_NEED_DATA)
@@ -1169,6 +1338,14 @@ gst_aggregator_start (GstAggregator * self)
   self->priv->send_eos = TRUE;
   self->priv->srccaps = NULL;
 
+  GST_OBJECT_LOCK (self);
+  self->priv->aggregates = 0;
+  self->priv->timeout_aggregates = 0;
+  self->priv->aggregate_time = 0;
+  self->priv->max_aggregate_time = 0;
+  self->priv->last_stats_message = 0;
+  GST_OBJECT_UNLOCK (self);
+
   gst_aggregator_set_allocation (self, NULL, NULL, NULL, NULL);
 
   klass = GST_AGGREGATOR_GET_CLASS (self);
@@ -1408,7 +1585,7 @@ gst_aggregator_default_sink_event (GstAggregator * self,
       SRC_LOCK (self);
       PAD_LOCK (aggpad);
       if (aggpad->priv->num_buffers == 0) {
-        aggpad->priv->eos = TRUE;
+        g_atomic_int_set (&aggpad->priv->eos, TRUE);
       } else {
         aggpad->priv->pending_eos = TRUE;
       }
@@ -1475,8 +1652,10 @@ gst_aggregator_default_sink_event (GstAggregator * self,
       GST_BUFFER_FLAG_SET (gapbuf, GST_BUFFER_FLAG_DROPPABLE);
 
       /* Remove GAP event so we can replace it with the buffer */
+      PAD_LOCK (aggpad);
       if (g_queue_peek_tail (&aggpad->priv->buffers) == event)
-        gst_event_unref (g_queue_pop_tail (&aggpad->priv->buffers));
+        gst_event_unref (gst_aggregator_pad_queue_pop_tail_unlocked (aggpad));
+      PAD_UNLOCK (aggpad);
 
       if (gst_aggregator_pad_chain_internal (self, aggpad, gapbuf, FALSE) !=
           GST_FLOW_OK) {
@@ -2272,6 +2451,16 @@ gst_aggregator_set_property (GObject * object, guint prop_id,
     case PROP_START_TIME:
       agg->priv->start_time = g_value_get_uint64 (value);
       break;
+    case PROP_COALESCE_WAKEUPS:
+      GST_OBJECT_LOCK (agg);
+      agg->priv->coalesce_wakeups = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (agg);
+      break;
+    case PROP_STATS_INTERVAL:
+      GST_OBJECT_LOCK (agg);
+      agg->priv->stats_interval = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (agg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2294,6 +2483,19 @@ gst_aggregator_get_property (GObject * object, guint prop_id,
     case PROP_START_TIME:
       g_value_set_uint64 (value, agg->priv->start_time);
       break;
+    case PROP_COALESCE_WAKEUPS:
+      GST_OBJECT_LOCK (agg);
+      g_value_set_boolean (value, agg->priv->coalesce_wakeups);
+      GST_OBJECT_UNLOCK (agg);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_aggregator_create_stats (agg));
+      break;
+    case PROP_STATS_INTERVAL:
+      GST_OBJECT_LOCK (agg);
+      g_value_set_uint64 (value, agg->priv->stats_interval);
+      GST_OBJECT_UNLOCK (agg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2359,6 +2561,62 @@ gst_aggregator_class_init (GstAggregatorClass * klass)
           G_MAXUINT64,
           DEFAULT_START_TIME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAggregator:coalesce-wakeups:
+   *
+   * Only wake up the aggregating thread for new buffers once all pads
+   * have data, instead of once for every buffer arriving on any pad.
+   * Events, EOS and the latency deadline in live mode still wake it up.
+   * This cuts down context switches with many pads.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_COALESCE_WAKEUPS,
+      g_param_spec_boolean ("coalesce-wakeups", "Coalesce Wakeups",
+          "Only wake up the aggregating thread once all pads have data",
+          DEFAULT_COALESCE_WAKEUPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAggregator:stats:
+   *
+   * Statistics about the aggregation, in a structure named
+   * "application/x-aggregator-stats" with the following fields:
+   *
+   *  - "aggregates" (guint64): number of calls to aggregate()
+   *  - "timeout-aggregates" (guint64): how many of them were caused by the
+   *    latency deadline passing in live mode
+   *  - "aggregate-time" and "max-aggregate-time" (guint64): the total and
+   *    the longest time spent in aggregate(), in nanoseconds
+   *  - "latency" (guint64): the configured #GstAggregator:latency
+   *  - "pad-stats" (GstValueArray of GstStructure): one
+   *    "application/x-aggregator-pad-stats" structure per sink pad with
+   *    "pad-name", "queued-buffers", "queued-bytes", "queued-time" (in
+   *    nanoseconds), "late-buffers" (buffers ending before the position
+   *    that was already output) and "dropped-buffers" (buffers dropped
+   *    when clipping)
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Statistics about the aggregation and its sink pads",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAggregator:stats-interval:
+   *
+   * When not 0, #GstAggregator:stats is posted on the bus as an element
+   * message at most every stats-interval nanoseconds while aggregating.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint64 ("stats-interval", "Statistics Interval",
+          "Interval between statistics messages on the bus, "
+          "in nanoseconds (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_STATS_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_REGISTER_FUNCPTR (gst_aggregator_stop_pad);
 }
 
@@ -2403,6 +2661,8 @@ gst_aggregator_init (GstAggregator * self, GstAggregatorClass * klass)
   self->priv->latency = DEFAULT_LATENCY;
   self->priv->start_time_selection = DEFAULT_START_TIME_SELECTION;
   self->priv->start_time = DEFAULT_START_TIME;
+  self->priv->coalesce_wakeups = DEFAULT_COALESCE_WAKEUPS;
+  self->priv->stats_interval = DEFAULT_STATS_INTERVAL;
 
   g_mutex_init (&self->priv->src_lock);
   g_cond_init (&self->priv->src_cond);
@@ -2487,6 +2747,34 @@ apply_buffer (GstAggregatorPad * aggpad, GstBuffer * buffer, gboolean head)
   update_time_level (aggpad, head);
 }
 
+/* A buffer is late when it ends before the position the aggregator already
+ * produced output for, e.g. because it timed out waiting for it in live
+ * mode. Must be called with the object lock and the PAD_LOCK held */
+static gboolean
+gst_aggregator_pad_buffer_is_late (GstAggregator * self,
+    GstAggregatorPad * aggpad, GstBuffer * buffer)
+{
+  GstClockTime end, output_time;
+
+  if (aggpad->priv->head_segment.format != GST_FORMAT_TIME ||
+      self->segment.format != GST_FORMAT_TIME ||
+      !GST_CLOCK_TIME_IS_VALID (self->segment.position) ||
+      !GST_BUFFER_PTS_IS_VALID (buffer))
+    return FALSE;
+
+  end = GST_BUFFER_PTS (buffer);
+  if (GST_BUFFER_DURATION_IS_VALID (buffer))
+    end += GST_BUFFER_DURATION (buffer);
+
+  end = gst_segment_to_running_time (&aggpad->priv->head_segment,
+      GST_FORMAT_TIME, end);
+  output_time = gst_segment_to_running_time (&self->segment,
+      GST_FORMAT_TIME, self->segment.position);
+
+  return GST_CLOCK_TIME_IS_VALID (end) && GST_CLOCK_TIME_IS_VALID (output_time)
+      && end < output_time;
+}
+
 static GstFlowReturn
 gst_aggregator_pad_chain_internal (GstAggregator * self,
     GstAggregatorPad * aggpad, GstBuffer * buffer, gboolean head)
@@ -2522,14 +2810,21 @@ gst_aggregator_pad_chain_internal (GstAggregator * self,
 
     if (gst_aggregator_pad_has_space (self, aggpad)
         && aggpad->priv->flow_return == GST_FLOW_OK) {
-      if (head)
-        g_queue_push_head (&aggpad->priv->buffers, buffer);
-      else
-        g_queue_push_tail (&aggpad->priv->buffers, buffer);
+      if (gst_aggregator_pad_buffer_is_late (self, aggpad, buffer))
+        aggpad->priv->late_buffers++;
+      aggpad->priv->queued_bytes += gst_buffer_get_size (buffer);
+      gst_aggregator_pad_queue_push_unlocked (aggpad, buffer, head);
       apply_buffer (aggpad, buffer, head);
-      aggpad->priv->num_buffers++;
+      g_atomic_int_inc (&aggpad->priv->num_buffers);
       buffer = NULL;
-      SRC_BROADCAST (self);
+
+      /* When coalescing, only wake up the aggregate task once all pads have
+       * data. Until then it has nothing to do but wait for the next buffer
+       * or, in live mode, for the latency deadline. Until the first buffer
+       * the task also needs to see every buffer to pick a start time. */
+      if (!self->priv->coalesce_wakeups || self->priv->first_buffer ||
+          gst_aggregator_all_pads_have_data_locked (self))
+        SRC_BROADCAST (self);
       break;
     }
 
@@ -2650,7 +2945,7 @@ gst_aggregator_pad_query_func (GstPad * pad, GstObject * parent,
       goto flushing;
     }
 
-    g_queue_push_head (&aggpad->priv->buffers, query);
+    gst_aggregator_pad_queue_push_unlocked (aggpad, query, TRUE);
     SRC_BROADCAST (self);
     SRC_UNLOCK (self);
 
@@ -2663,8 +2958,8 @@ gst_aggregator_pad_query_func (GstPad * pad, GstObject * parent,
     s = gst_query_writable_structure (query);
     if (gst_structure_get_boolean (s, "gst-aggregator-retval", &ret))
       gst_structure_remove_field (s, "gst-aggregator-retval");
-    else
-      g_queue_remove (&aggpad->priv->buffers, query);
+    else if (g_queue_remove (&aggpad->priv->buffers, query))
+      g_atomic_int_add (&aggpad->priv->num_queued, -1);
 
     if (aggpad->priv->flow_return != GST_FLOW_OK)
       goto flushing;
@@ -2715,7 +3010,7 @@ gst_aggregator_pad_event_func (GstPad * pad, GstObject * parent,
     if (GST_EVENT_TYPE (event) != GST_EVENT_FLUSH_STOP) {
       GST_DEBUG_OBJECT (aggpad, "Store event in queue: %" GST_PTR_FORMAT,
           event);
-      g_queue_push_head (&aggpad->priv->buffers, event);
+      gst_aggregator_pad_queue_push_unlocked (aggpad, event, TRUE);
       event = NULL;
       SRC_BROADCAST (self);
     }
@@ -2842,11 +3137,11 @@ gst_aggregator_pad_init (GstAggregatorPad * pad)
 static void
 gst_aggregator_pad_buffer_consumed (GstAggregatorPad * pad)
 {
-  pad->priv->num_buffers--;
+  g_atomic_int_add (&pad->priv->num_buffers, -1);
   GST_TRACE_OBJECT (pad, "Consuming buffer");
   if (gst_aggregator_pad_queue_is_empty (pad) && pad->priv->pending_eos) {
     pad->priv->pending_eos = FALSE;
-    pad->priv->eos = TRUE;
+    g_atomic_int_set (&pad->priv->eos, TRUE);
   }
   PAD_BROADCAST_EVENT (pad);
 }
@@ -2862,7 +3157,11 @@ gst_aggregator_pad_clip_buffer_unlocked (GstAggregatorPad * pad)
   while (pad->priv->clipped_buffer == NULL &&
       GST_IS_BUFFER (g_queue_peek_tail (&pad->priv->buffers))) {
     buffer = g_queue_pop_tail (&pad->priv->buffers);
+    pad->priv->queued_bytes -= MIN (pad->priv->queued_bytes,
+        gst_buffer_get_size (buffer));
 
+    /* Moving the buffer to clipped_buffer below keeps num_queued as is, only
+     * account for it if it gets dropped */
     apply_buffer (pad, buffer, FALSE);
 
     /* We only take the parent here so that it's not taken if the buffer is
@@ -2871,6 +3170,7 @@ gst_aggregator_pad_clip_buffer_unlocked (GstAggregatorPad * pad)
     if (self == NULL) {
       self = GST_AGGREGATOR (gst_pad_get_parent_element (GST_PAD (pad)));
       if (self == NULL) {
+        g_atomic_int_add (&pad->priv->num_queued, -1);
         gst_buffer_unref (buffer);
         return;
       }
@@ -2884,7 +3184,9 @@ gst_aggregator_pad_clip_buffer_unlocked (GstAggregatorPad * pad)
       buffer = aggclass->clip (self, pad, buffer);
 
       if (buffer == NULL) {
+        g_atomic_int_add (&pad->priv->num_queued, -1);
         gst_aggregator_pad_buffer_consumed (pad);
+        pad->priv->dropped_buffers++;
         GST_TRACE_OBJECT (pad, "Clipping consumed the buffer");
       }
     }
@@ -2918,6 +3220,7 @@ gst_aggregator_pad_steal_buffer (GstAggregatorPad * pad)
   pad->priv->clipped_buffer = NULL;
 
   if (buffer) {
+    g_atomic_int_add (&pad->priv->num_queued, -1);
     gst_aggregator_pad_buffer_consumed (pad);
     GST_DEBUG_OBJECT (pad, "Consumed: %" GST_PTR_FORMAT, buffer);
   }
@@ -2981,9 +3284,7 @@ gst_aggregator_pad_is_eos (GstAggregatorPad * pad)
 {
   gboolean is_eos;
 
-  PAD_LOCK (pad);
-  is_eos = pad->priv->eos;
-  PAD_UNLOCK (pad);
+  is_eos = g_atomic_int_get (&pad->priv->eos);
 
   return is_eos;
 }
@@ -684,12 +684,8 @@ failed:
 static inline gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  return scan_for_start_code_prefix (data, size);
 }
 
 static inline gint
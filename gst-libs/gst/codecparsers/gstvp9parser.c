@@ -664,6 +664,80 @@ gst_vp9_parser_free (GstVp9Parser * parser)
   }
 }
 
+/**
+ * gst_vp9_parser_parse_superframe_info:
+ * @parser: The #GstVp9Parser
+ * @superframe_info: The #GstVp9SuperframeInfo to fill
+ * @data: The data to parse
+ * @size: The size of the @data to parse
+ *
+ * Parses the superframe index that may end the chunk of VP9 data in @data
+ * and fills in @superframe_info with the sizes of the frames it contains.
+ * Data without a superframe index is reported as a single frame of @size
+ * bytes.
+ *
+ * Returns: a #GstVp9ParserResult
+ *
+ * Since: 1.14
+ */
+GstVp9ParserResult
+gst_vp9_parser_parse_superframe_info (GstVp9Parser * parser,
+    GstVp9SuperframeInfo * superframe_info, const guint8 * data, gsize size)
+{
+  guint8 marker;
+  guint32 frames, mag, index_size, total = 0;
+  const guint8 *p;
+  guint i, j;
+
+  g_return_val_if_fail (superframe_info != NULL, GST_VP9_PARSER_ERROR);
+  g_return_val_if_fail (data != NULL || size == 0, GST_VP9_PARSER_ERROR);
+
+  memset (superframe_info, 0, sizeof (*superframe_info));
+
+  if (size == 0)
+    return GST_VP9_PARSER_BROKEN_DATA;
+
+  marker = data[size - 1];
+  if ((marker & 0xe0) != 0xc0)
+    goto single_frame;
+
+  frames = (marker & 0x7) + 1;
+  mag = ((marker >> 3) & 0x3) + 1;
+  index_size = 2 + mag * frames;
+
+  /* the index starts and ends with the same marker byte */
+  if (size < index_size || data[size - index_size] != marker)
+    goto single_frame;
+
+  p = data + size - index_size + 1;
+  for (i = 0; i < frames; i++) {
+    guint32 frame_size = 0;
+
+    for (j = 0; j < mag; j++)
+      frame_size |= ((guint32) *p++) << (j * 8);
+
+    if (frame_size == 0 || total + frame_size > size - index_size) {
+      GST_ERROR ("Superframe index refers to data past the frames");
+      return GST_VP9_PARSER_BROKEN_DATA;
+    }
+
+    superframe_info->frame_sizes[i] = frame_size;
+    total += frame_size;
+  }
+
+  superframe_info->bytes_per_framesize = mag;
+  superframe_info->frames_in_superframe = frames;
+  superframe_info->superframe_index_size = index_size;
+
+  return GST_VP9_PARSER_OK;
+
+single_frame:
+  superframe_info->frames_in_superframe = 1;
+  superframe_info->frame_sizes[0] = size;
+
+  return GST_VP9_PARSER_OK;
+}
+
 /**
  * gst_vp9_parser_parse_frame_header:
  * @parser: The #GstVp9Parser
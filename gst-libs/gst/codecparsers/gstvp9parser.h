@@ -60,6 +60,8 @@ G_BEGIN_DECLS
 
 #define GST_VP9_PREDICTION_PROBS   3
 
+#define GST_VP9_MAX_FRAMES_IN_SUPERFRAME 8
+
 typedef struct _GstVp9Parser               GstVp9Parser;
 typedef struct _GstVp9FrameHdr             GstVp9FrameHdr;
 typedef struct _GstVp9LoopFilter           GstVp9LoopFilter;
@@ -67,6 +69,7 @@ typedef struct _GstVp9QuantIndices         GstVp9QuantIndices;
 typedef struct _GstVp9Segmentation         GstVp9Segmentation;
 typedef struct _GstVp9SegmentationInfo     GstVp9SegmentationInfo;
 typedef struct _GstVp9SegmentationInfoData GstVp9SegmentationInfoData;
+typedef struct _GstVp9SuperframeInfo       GstVp9SuperframeInfo;
 
 /**
  * GstVp9ParseResult:
@@ -450,6 +453,30 @@ struct _GstVp9Segmentation
   guint8 reference_skip;
 };
 
+/**
+ * GstVp9SuperframeInfo:
+ * @bytes_per_framesize: number of bytes used for each frame size in the
+ *   superframe index, 0 if the data is not a superframe
+ * @frames_in_superframe: number of frames in the data, 1 if it is not a
+ *   superframe
+ * @frame_sizes: size of each of the frames, which follow each other from
+ *   the start of the data
+ * @superframe_index_size: size of the superframe index at the end of the
+ *   data, 0 if the data is not a superframe
+ *
+ * Layout of a chunk of VP9 data that may combine several frames into a
+ * superframe.
+ *
+ * Since: 1.14
+ */
+struct _GstVp9SuperframeInfo
+{
+  guint32 bytes_per_framesize;
+  guint32 frames_in_superframe;
+  guint32 frame_sizes[GST_VP9_MAX_FRAMES_IN_SUPERFRAME];
+  guint32 superframe_index_size;
+};
+
 /**
  * GstVp9Parser:
  * @priv: GstVp9ParserPrivate struct to keep track of state variables
@@ -488,6 +515,9 @@ GstVp9Parser *     gst_vp9_parser_new (void);
 GST_EXPORT
 GstVp9ParserResult gst_vp9_parser_parse_frame_header (GstVp9Parser* parser, GstVp9FrameHdr * frame_hdr, const guint8 * data, gsize size);
 
+GST_EXPORT
+GstVp9ParserResult gst_vp9_parser_parse_superframe_info (GstVp9Parser * parser, GstVp9SuperframeInfo * superframe_info, const guint8 * data, gsize size);
+
 GST_EXPORT
 void               gst_vp9_parser_free (GstVp9Parser * parser);
 
@@ -36,6 +36,7 @@
 #endif
 
 #include "nalutils.h"
+#include "parserutils.h"
 
 /* Compute Ceil(Log2(v)) */
 /* Derived from branchless code for integer log2(v) from:
@@ -69,14 +70,44 @@ nal_reader_init (NalReader * nr, const guint8 * data, guint size)
   nr->data = data;
   nr->size = size;
   nr->n_epb = 0;
+  nr->next_epb = 0;
+  nr->at_epb = FALSE;
 
   nr->byte = 0;
   nr->bits_in_cache = 0;
-  /* fill with something other than 0 to detect emulation prevention bytes */
   nr->first_byte = 0xff;
   nr->cache = 0xff;
 }
 
+/* How many bytes to search for the next emulation prevention byte at once.
+ * Parsing headers usually only reads a few bytes of a NAL, so don't search
+ * the whole NAL upfront */
+#define NAL_READER_EPB_SEARCH_SIZE 128
+
+/* Finds the next emulation_prevention_three_byte, a 0x03 following two 0x00
+ * bytes in the NAL data, in the bytes starting at the current position. As
+ * the 0x00 bytes can't be part of a previous 0x000003 sequence, looking at
+ * the two bytes in front of each 0x03 is enough. */
+static void
+nal_reader_find_next_epb (NalReader * nr)
+{
+  const guint8 *p = nr->data + nr->byte;
+  const guint8 *end = nr->data + MIN (nr->size,
+      nr->byte + NAL_READER_EPB_SEARCH_SIZE);
+
+  while (p < end && (p = memchr (p, 0x03, end - p))) {
+    if (p - nr->data >= 2 && p[-1] == 0x00 && p[-2] == 0x00) {
+      nr->next_epb = p - nr->data;
+      nr->at_epb = TRUE;
+      return;
+    }
+    p++;
+  }
+
+  nr->next_epb = end - nr->data;
+  nr->at_epb = FALSE;
+}
+
 gboolean
 nal_reader_read (NalReader * nr, guint nbits)
 {
@@ -88,23 +119,24 @@ nal_reader_read (NalReader * nr, guint nbits)
 
   while (nr->bits_in_cache < nbits) {
     guint8 byte;
-    gboolean check_three_byte;
 
-    check_three_byte = TRUE;
-  next_byte:
+    /* Only one comparison per byte, the emulation prevention bytes in the
+     * next NAL_READER_EPB_SEARCH_SIZE bytes are searched for at once */
+    while (G_UNLIKELY (nr->byte == nr->next_epb)) {
+      if (nr->at_epb) {
+        nr->byte++;
+        nr->n_epb++;
+      }
+      if (G_UNLIKELY (nr->byte >= nr->size))
+        return FALSE;
+      nal_reader_find_next_epb (nr);
+    }
+
     if (G_UNLIKELY (nr->byte >= nr->size))
       return FALSE;
 
     byte = nr->data[nr->byte++];
 
-    /* check if the byte is a emulation_prevention_three_byte */
-    if (check_three_byte && byte == 0x03 && nr->first_byte == 0x00 &&
-        ((nr->cache & 0xff) == 0)) {
-      /* next byte goes unconditionally to the cache, even if it's 0x03 */
-      check_three_byte = FALSE;
-      nr->n_epb++;
-      goto next_byte;
-    }
     nr->cache = (nr->cache << 8) | nr->first_byte;
     nr->first_byte = byte;
     nr->bits_in_cache += 8;
@@ -300,10 +332,6 @@ nal_reader_has_more_data (NalReader * nr)
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  return scan_for_start_code_prefix (data, size);
 }
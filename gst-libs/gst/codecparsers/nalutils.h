@@ -47,6 +47,10 @@ typedef struct
   guint size;
 
   guint n_epb;                  /* Number of emulation prevention bytes */
+  guint next_epb;               /* Position of the next emulation prevention
+                                 * byte, or of the end of the range searched
+                                 * for them if !at_epb */
+  gboolean at_epb;
   guint byte;                   /* Byte position */
   guint bits_in_cache;          /* bitpos in the cache of next bit */
   guint8 first_byte;
@@ -21,6 +21,8 @@
 
 #include "parserutils.h"
 
+#include <string.h>
+
 gboolean
 decode_vlc (GstBitReader * br, guint * res, const VLCTable * table,
     guint length)
@@ -55,3 +57,36 @@ failed:
     return FALSE;
   }
 }
+
+/* Returns the offset of the first 0x000001 start code prefix in @data that
+ * is followed by at least one more byte, or -1. This is the same as
+ * gst_byte_reader_masked_scan_uint32 (br, 0xffffff00, 0x00000100, 0, size)
+ * but it lets memchr(), which the C library implements with the widest
+ * vector instructions the CPU supports, skip over the long runs of bytes
+ * that cannot end a start code. Everything but the 0x01 byte is checked
+ * backwards from there. */
+gint
+scan_for_start_code_prefix (const guint8 * data, guint size)
+{
+  const guint8 *p, *end;
+
+  if (size < 4)
+    return -1;
+
+  /* The 0x01 is at least at offset 2 and at most at offset size - 2 */
+  p = data + 2;
+  end = data + size - 1;
+
+  while (p < end) {
+    p = memchr (p, 0x01, end - p);
+    if (p == NULL)
+      return -1;
+
+    if (p[-1] == 0x00 && p[-2] == 0x00)
+      return p - 2 - data;
+
+    p++;
+  }
+
+  return -1;
+}
@@ -57,6 +57,18 @@
 #ifndef DRM_FORMAT_GR88
 #define DRM_FORMAT_GR88 fourcc_code('G', 'R', '8', '8')
 #endif
+
+#ifndef DRM_FORMAT_P010
+#define DRM_FORMAT_P010 fourcc_code('P', '0', '1', '0')
+#endif
+
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR 0ULL
+#endif
+
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
+#endif
 #endif
 
 #ifndef EGL_LINUX_DMA_BUF_EXT
@@ -79,6 +91,82 @@
 #define EGL_DMA_BUF_PLANE0_PITCH_EXT 0x3274
 #endif
 
+#ifndef EGL_DMA_BUF_PLANE1_FD_EXT
+#define EGL_DMA_BUF_PLANE1_FD_EXT 0x3275
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE1_OFFSET_EXT
+#define EGL_DMA_BUF_PLANE1_OFFSET_EXT 0x3276
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE1_PITCH_EXT
+#define EGL_DMA_BUF_PLANE1_PITCH_EXT 0x3277
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE2_FD_EXT
+#define EGL_DMA_BUF_PLANE2_FD_EXT 0x3278
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE2_OFFSET_EXT
+#define EGL_DMA_BUF_PLANE2_OFFSET_EXT 0x3279
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE2_PITCH_EXT
+#define EGL_DMA_BUF_PLANE2_PITCH_EXT 0x327A
+#endif
+
+#ifndef EGL_YUV_COLOR_SPACE_HINT_EXT
+#define EGL_YUV_COLOR_SPACE_HINT_EXT 0x327B
+#endif
+
+#ifndef EGL_SAMPLE_RANGE_HINT_EXT
+#define EGL_SAMPLE_RANGE_HINT_EXT 0x327C
+#endif
+
+#ifndef EGL_ITU_REC601_EXT
+#define EGL_ITU_REC601_EXT 0x327F
+#endif
+
+#ifndef EGL_ITU_REC709_EXT
+#define EGL_ITU_REC709_EXT 0x3280
+#endif
+
+#ifndef EGL_ITU_REC2020_EXT
+#define EGL_ITU_REC2020_EXT 0x3281
+#endif
+
+#ifndef EGL_YUV_FULL_RANGE_EXT
+#define EGL_YUV_FULL_RANGE_EXT 0x3282
+#endif
+
+#ifndef EGL_YUV_NARROW_RANGE_EXT
+#define EGL_YUV_NARROW_RANGE_EXT 0x3283
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT
+#define EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT 0x3443
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT
+#define EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT 0x3444
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT
+#define EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT 0x3445
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT
+#define EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT 0x3446
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT
+#define EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT 0x3447
+#endif
+
+#ifndef EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT
+#define EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT 0x3448
+#endif
+
 GST_DEFINE_MINI_OBJECT_TYPE (GstEGLImage, gst_egl_image);
 
 #ifndef GST_DISABLE_GST_DEBUG
@@ -462,4 +550,244 @@ gst_egl_image_from_dmabuf (GstGLContext * context,
   return gst_egl_image_new_wrapped (context, img, format, NULL,
       (GstEGLImageDestroyNotify) _destroy_egl_image);
 }
+
+/* the DRM format describing all the planes of @info at once, for the import
+ * of a whole frame as a single external image */
+static int
+_drm_direct_fourcc_from_info (GstVideoInfo * info)
+{
+  switch (GST_VIDEO_INFO_FORMAT (info)) {
+    case GST_VIDEO_FORMAT_NV12:
+      return DRM_FORMAT_NV12;
+    case GST_VIDEO_FORMAT_NV21:
+      return DRM_FORMAT_NV21;
+    case GST_VIDEO_FORMAT_I420:
+      return DRM_FORMAT_YUV420;
+    case GST_VIDEO_FORMAT_YV12:
+      return DRM_FORMAT_YVU420;
+    case GST_VIDEO_FORMAT_P010_10LE:
+      return DRM_FORMAT_P010;
+    default:
+      return -1;
+  }
+}
+
+/**
+ * gst_egl_image_from_dmabuf_direct:
+ * @context: a #GstGLContext (must be an EGL context)
+ * @fd: the DMA-Buf file descriptor of each plane
+ * @offset: the byte-offset of each plane in its DMA-Buf
+ * @in_info: the #GstVideoInfo in the DMA-Buf's
+ * @modifier: the DRM format modifier of the DMA-Buf's, or
+ *     DRM_FORMAT_MOD_INVALID if unknown
+ *
+ * Creates a single #GstEGLImage for all the planes of a multi-planar YUV
+ * frame. The resulting image can only be bound to the external-oes texture
+ * target and is sampled as RGBA, the conversion being done by the driver.
+ *
+ * A @modifier other than DRM_FORMAT_MOD_INVALID or DRM_FORMAT_MOD_LINEAR
+ * requires the EGL_EXT_image_dma_buf_import_modifiers extension.
+ *
+ * Returns: a #GstEGLImage wrapping all the planes or %NULL on failure
+ *
+ * Since: 1.14
+ */
+GstEGLImage *
+gst_egl_image_from_dmabuf_direct (GstGLContext * context, gint * fd,
+    gsize * offset, GstVideoInfo * in_info, guint64 modifier)
+{
+  static const EGLint plane_attribs[3][5] = {
+    {EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
+        EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT,
+        EGL_DMA_BUF_PLANE1_PITCH_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
+        EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT,
+        EGL_DMA_BUF_PLANE2_PITCH_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
+        EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT},
+  };
+  guintptr attribs[41];
+  gboolean with_modifiers;
+  EGLImageKHR img;
+  guint n_planes;
+  gint atti = 0;
+  gint fourcc;
+  gint i;
+
+  fourcc = _drm_direct_fourcc_from_info (in_info);
+  if (fourcc == -1) {
+    GST_DEBUG ("%s can not be imported as a single image",
+        gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (in_info)));
+    return NULL;
+  }
+
+  with_modifiers = gst_gl_context_check_feature (context,
+      "EGL_EXT_image_dma_buf_import_modifiers");
+  if (modifier == DRM_FORMAT_MOD_INVALID) {
+    with_modifiers = FALSE;
+  } else if (!with_modifiers && modifier != DRM_FORMAT_MOD_LINEAR) {
+    GST_DEBUG ("modifier 0x%" G_GINT64_MODIFIER "x is not supported without "
+        "EGL_EXT_image_dma_buf_import_modifiers", modifier);
+    return NULL;
+  }
+
+  n_planes = GST_VIDEO_INFO_N_PLANES (in_info);
+
+  GST_DEBUG ("fourcc %.4s (%d) with %u planes (%dx%d) modifier 0x%"
+      G_GINT64_MODIFIER "x", (char *) &fourcc, fourcc, n_planes,
+      GST_VIDEO_INFO_WIDTH (in_info), GST_VIDEO_INFO_HEIGHT (in_info),
+      modifier);
+
+  attribs[atti++] = EGL_WIDTH;
+  attribs[atti++] = GST_VIDEO_INFO_WIDTH (in_info);
+  attribs[atti++] = EGL_HEIGHT;
+  attribs[atti++] = GST_VIDEO_INFO_HEIGHT (in_info);
+  attribs[atti++] = EGL_LINUX_DRM_FOURCC_EXT;
+  attribs[atti++] = fourcc;
+
+  for (i = 0; i < n_planes; i++) {
+    attribs[atti++] = plane_attribs[i][0];
+    attribs[atti++] = fd[i];
+    attribs[atti++] = plane_attribs[i][1];
+    attribs[atti++] = offset[i];
+    attribs[atti++] = plane_attribs[i][2];
+    attribs[atti++] = GST_VIDEO_INFO_PLANE_STRIDE (in_info, i);
+    if (with_modifiers) {
+      attribs[atti++] = plane_attribs[i][3];
+      attribs[atti++] = modifier & 0xffffffff;
+      attribs[atti++] = plane_attribs[i][4];
+      attribs[atti++] = (modifier >> 32) & 0xffffffff;
+    }
+  }
+
+  attribs[atti++] = EGL_YUV_COLOR_SPACE_HINT_EXT;
+  switch (in_info->colorimetry.matrix) {
+    case GST_VIDEO_COLOR_MATRIX_BT709:
+      attribs[atti++] = EGL_ITU_REC709_EXT;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_BT2020:
+      attribs[atti++] = EGL_ITU_REC2020_EXT;
+      break;
+    default:
+      attribs[atti++] = EGL_ITU_REC601_EXT;
+      break;
+  }
+
+  attribs[atti++] = EGL_SAMPLE_RANGE_HINT_EXT;
+  if (in_info->colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255)
+    attribs[atti++] = EGL_YUV_FULL_RANGE_EXT;
+  else
+    attribs[atti++] = EGL_YUV_NARROW_RANGE_EXT;
+
+  attribs[atti] = EGL_NONE;
+
+  for (i = 0; i < atti; i++)
+    GST_LOG ("attr %i: %" G_GINTPTR_FORMAT, i, attribs[i]);
+
+  g_assert (atti < G_N_ELEMENTS (attribs));
+
+  img = _gst_egl_image_create (context, EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+  if (!img) {
+    GST_WARNING ("eglCreateImage failed: %s",
+        gst_egl_get_error_string (eglGetError ()));
+    return NULL;
+  }
+
+  return gst_egl_image_new_wrapped (context, img, GST_GL_RGBA, NULL,
+      (GstEGLImageDestroyNotify) _destroy_egl_image);
+}
+
+/**
+ * gst_egl_image_export_dmabuf:
+ * @image: a #GstEGLImage
+ * @fd: (out): the DMA-Buf file descriptor
+ * @stride: (out): the stride of the data in @fd
+ * @offset: (out): the byte-offset of the data in @fd
+ * @modifier: (out) (allow-none): the DRM format modifier of the data
+ *
+ * Exports @image as a DMA-Buf using the EGL_MESA_image_dma_buf_export
+ * extension. Only single plane images can be exported. The caller owns the
+ * returned @fd and must close it.
+ *
+ * Must be called in @image's context thread.
+ *
+ * Returns: whether @image could be exported
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_egl_image_export_dmabuf (GstEGLImage * image, gint * fd, gint * stride,
+    gsize * offset, guint64 * modifier)
+{
+  EGLBoolean (*gst_eglExportDMABUFImageQueryMESA) (EGLDisplay dpy,
+      EGLImageKHR image, int *fourcc, int *num_planes, guint64 * modifiers);
+  EGLBoolean (*gst_eglExportDMABUFImageMESA) (EGLDisplay dpy,
+      EGLImageKHR image, int *fds, EGLint * strides, EGLint * offsets);
+  GstGLDisplayEGL *display_egl;
+  EGLDisplay egl_display;
+  GstGLContext *context;
+  int fourcc, num_planes;
+  guint64 egl_modifier = DRM_FORMAT_MOD_INVALID;
+  int egl_fd;
+  EGLint egl_stride, egl_offset;
+
+  g_return_val_if_fail (GST_IS_EGL_IMAGE (image), FALSE);
+  g_return_val_if_fail (fd != NULL, FALSE);
+  g_return_val_if_fail (stride != NULL, FALSE);
+  g_return_val_if_fail (offset != NULL, FALSE);
+
+  context = GST_GL_CONTEXT (image->context);
+
+  if (!gst_gl_context_check_feature (context, "EGL_MESA_image_dma_buf_export"))
+    return FALSE;
+
+  gst_eglExportDMABUFImageQueryMESA = gst_gl_context_get_proc_address (context,
+      "eglExportDMABUFImageQueryMESA");
+  gst_eglExportDMABUFImageMESA = gst_gl_context_get_proc_address (context,
+      "eglExportDMABUFImageMESA");
+  if (!gst_eglExportDMABUFImageQueryMESA || !gst_eglExportDMABUFImageMESA)
+    return FALSE;
+
+  display_egl = gst_gl_display_egl_from_gl_display (context->display);
+  if (!display_egl) {
+    GST_WARNING_OBJECT (context, "Failed to retrieve GstGLDisplayEGL from %"
+        GST_PTR_FORMAT, context->display);
+    return FALSE;
+  }
+  egl_display =
+      (EGLDisplay) gst_gl_display_get_handle (GST_GL_DISPLAY (display_egl));
+  gst_object_unref (display_egl);
+
+  if (!gst_eglExportDMABUFImageQueryMESA (egl_display, image->image, &fourcc,
+          &num_planes, &egl_modifier)) {
+    GST_WARNING ("eglExportDMABUFImageQueryMESA failed: %s",
+        gst_egl_get_error_string (eglGetError ()));
+    return FALSE;
+  }
+
+  if (num_planes != 1) {
+    GST_DEBUG ("can not export images with %i planes", num_planes);
+    return FALSE;
+  }
+
+  if (!gst_eglExportDMABUFImageMESA (egl_display, image->image, &egl_fd,
+          &egl_stride, &egl_offset)) {
+    GST_WARNING ("eglExportDMABUFImageMESA failed: %s",
+        gst_egl_get_error_string (eglGetError ()));
+    return FALSE;
+  }
+
+  GST_DEBUG ("exported fourcc %.4s as fd %i stride %i offset %i modifier 0x%"
+      G_GINT64_MODIFIER "x", (char *) &fourcc, egl_fd, egl_stride, egl_offset,
+      egl_modifier);
+
+  *fd = egl_fd;
+  *stride = egl_stride;
+  *offset = egl_offset;
+  if (modifier)
+    *modifier = egl_modifier;
+
+  return TRUE;
+}
 #endif /* GST_GL_HAVE_DMABUF */
@@ -86,6 +86,16 @@ GstEGLImage *           gst_egl_image_from_dmabuf               (GstGLContext *
                                                                  GstVideoInfo * in_info,
                                                                  gint plane,
                                                                  gsize offset);
+GstEGLImage *           gst_egl_image_from_dmabuf_direct        (GstGLContext * context,
+                                                                 gint * fd,
+                                                                 gsize * offset,
+                                                                 GstVideoInfo * in_info,
+                                                                 guint64 modifier);
+gboolean                gst_egl_image_export_dmabuf             (GstEGLImage * image,
+                                                                 gint * fd,
+                                                                 gint * stride,
+                                                                 gsize * offset,
+                                                                 guint64 * modifier);
 #endif
 
 /**
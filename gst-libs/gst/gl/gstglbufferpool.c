@@ -26,6 +26,8 @@
 #include "gstglbufferpool.h"
 #include "gstglutils.h"
 
+#include <gst/gstbufferpoolstats-private.h>
+
 /**
  * SECTION:gstglbufferpool
  * @title: GstGLBufferPool
@@ -50,6 +52,8 @@ struct _GstGLBufferPoolPrivate
   GstCaps *caps;
   gboolean add_videometa;
   gboolean add_glsyncmeta;
+
+  GstBufferPoolStats stats;
 };
 
 static void gst_gl_buffer_pool_finalize (GObject * object);
@@ -260,6 +264,36 @@ gst_gl_buffer_pool_start (GstBufferPool * pool)
   return GST_BUFFER_POOL_CLASS (parent_class)->start (pool);
 }
 
+static GstFlowReturn
+gst_gl_buffer_pool_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstGLBufferPoolPrivate *priv = GST_GL_BUFFER_POOL_CAST (pool)->priv;
+
+  return gst_buffer_pool_stats_acquire_buffer (&priv->stats,
+      GST_BUFFER_POOL_CLASS (parent_class), pool, buffer, params);
+}
+
+static void
+gst_gl_buffer_pool_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstGLBufferPoolPrivate *priv = GST_GL_BUFFER_POOL_CAST (pool)->priv;
+
+  gst_buffer_pool_stats_released (&priv->stats);
+
+  GST_BUFFER_POOL_CLASS (parent_class)->release_buffer (pool, buffer);
+}
+
+static gboolean
+gst_gl_buffer_pool_stop (GstBufferPool * pool)
+{
+  GstGLBufferPoolPrivate *priv = GST_GL_BUFFER_POOL_CAST (pool)->priv;
+
+  gst_buffer_pool_stats_log (&priv->stats, pool);
+
+  return GST_BUFFER_POOL_CLASS (parent_class)->stop (pool);
+}
+
 /* This function handles GstBuffer creation */
 static GstFlowReturn
 gst_gl_buffer_pool_alloc (GstBufferPool * pool, GstBuffer ** buffer,
@@ -281,6 +315,8 @@ gst_gl_buffer_pool_alloc (GstBufferPool * pool, GstBuffer ** buffer,
   if (priv->add_glsyncmeta)
     gst_buffer_add_gl_sync_meta (glpool->context, buf);
 
+  gst_buffer_pool_stats_allocated (&priv->stats);
+
   *buffer = buf;
 
   return GST_FLOW_OK;
@@ -333,6 +369,9 @@ gst_gl_buffer_pool_class_init (GstGLBufferPoolClass * klass)
   gstbufferpool_class->set_config = gst_gl_buffer_pool_set_config;
   gstbufferpool_class->alloc_buffer = gst_gl_buffer_pool_alloc;
   gstbufferpool_class->start = gst_gl_buffer_pool_start;
+  gstbufferpool_class->stop = gst_gl_buffer_pool_stop;
+  gstbufferpool_class->acquire_buffer = gst_gl_buffer_pool_acquire_buffer;
+  gstbufferpool_class->release_buffer = gst_gl_buffer_pool_release_buffer;
 }
 
 static void
@@ -347,6 +386,7 @@ gst_gl_buffer_pool_init (GstGLBufferPool * pool)
   priv->caps = NULL;
   priv->add_videometa = TRUE;
   priv->add_glsyncmeta = FALSE;
+  gst_buffer_pool_stats_init (&priv->stats);
 }
 
 static void
@@ -360,6 +400,8 @@ gst_gl_buffer_pool_finalize (GObject * object)
   if (priv->caps)
     gst_caps_unref (priv->caps);
 
+  gst_buffer_pool_stats_clear (&priv->stats);
+
   G_OBJECT_CLASS (gst_gl_buffer_pool_parent_class)->finalize (object);
 
   /* only release the context once all our memory have been deleted */
@@ -28,6 +28,7 @@
 #include "gl.h"
 #include "gstglcolorconvert.h"
 #include "gstglsl_private.h"
+#include "gstglresourcepool_private.h"
 
 /**
  * SECTION:gstglcolorconvert
@@ -433,6 +434,10 @@ struct _GstGLColorConvertPrivate
 
   GstBufferPool *pool;
   gboolean pool_started;
+
+  /* framebuffers and intermediate textures shared with the other users of
+   * the context */
+  GstGLResourcePool *resource_pool;
 };
 
 GST_DEBUG_CATEGORY_STATIC (gst_gl_color_convert_debug);
@@ -482,6 +487,7 @@ gst_gl_color_convert_new (GstGLContext * context)
   gst_object_ref_sink (convert);
 
   convert->context = gst_object_ref (context);
+  convert->priv->resource_pool = gst_gl_resource_pool_get (context);
 
   gst_video_info_set_format (&convert->in_info, GST_VIDEO_FORMAT_ENCODED, 0, 0);
   gst_video_info_set_format (&convert->out_info, GST_VIDEO_FORMAT_ENCODED, 0,
@@ -502,6 +508,11 @@ gst_gl_color_convert_finalize (GObject * object)
 
   gst_gl_color_convert_reset (convert);
 
+  if (convert->priv->resource_pool) {
+    gst_gl_resource_pool_unref (convert->priv->resource_pool);
+    convert->priv->resource_pool = NULL;
+  }
+
   if (convert->context) {
     gst_object_unref (convert->context);
     convert->context = NULL;
@@ -546,6 +557,10 @@ gst_gl_color_convert_reset_shader (GstGLColorConvert * convert)
     convert->priv->convert_info.frag_body = NULL;
   }
   if (convert->shader) {
+    if (g_object_get_qdata (G_OBJECT (convert->shader),
+            _shader_user_quark) == convert)
+      g_object_set_qdata (G_OBJECT (convert->shader), _shader_user_quark,
+          NULL);
     gst_object_unref (convert->shader);
     convert->shader = NULL;
   }
@@ -559,13 +574,15 @@ gst_gl_color_convert_reset (GstGLColorConvert * convert)
   guint i;
 
   if (convert->fbo) {
-    gst_object_unref (convert->fbo);
+    gst_gl_resource_pool_release_framebuffer (convert->priv->resource_pool,
+        convert->fbo);
     convert->fbo = NULL;
   }
 
   for (i = 0; i < convert->priv->convert_info.out_n_textures; i++) {
     if (convert->priv->out_tex[i])
-      gst_memory_unref ((GstMemory *) convert->priv->out_tex[i]);
+      gst_gl_resource_pool_release_texture (convert->priv->resource_pool,
+          convert->priv->out_tex[i]);
     convert->priv->out_tex[i] = NULL;
   }
 
@@ -1780,6 +1797,94 @@ _unbind_buffer (GstGLColorConvert * convert)
   gl->DisableVertexAttribArray (convert->priv->attr_texture);
 }
 
+/* Linked programs, shared between all the converters of a GL context that
+ * end up with the same shader sources. The cache only holds weak references
+ * so that it does not keep the context alive through the shaders. */
+typedef struct
+{
+  GMutex lock;
+  GHashTable *shaders;          /* sources -> GWeakRef to a GstGLShader */
+} ShaderCache;
+
+static GQuark _shader_cache_quark;
+static GQuark _shader_user_quark;
+
+static void
+_weak_ref_free (GWeakRef * ref)
+{
+  g_weak_ref_clear (ref);
+  g_free (ref);
+}
+
+static void
+_shader_cache_free (ShaderCache * cache)
+{
+  g_hash_table_unref (cache->shaders);
+  g_mutex_clear (&cache->lock);
+  g_free (cache);
+}
+
+static ShaderCache *
+_shader_cache_get (GstGLContext * context)
+{
+  static GMutex create_lock;
+  ShaderCache *cache;
+
+  g_mutex_lock (&create_lock);
+  if (!_shader_cache_quark) {
+    _shader_cache_quark =
+        g_quark_from_static_string ("GstGLColorConvertShaderCache");
+    _shader_user_quark =
+        g_quark_from_static_string ("GstGLColorConvertShaderUser");
+  }
+
+  cache = g_object_get_qdata (G_OBJECT (context), _shader_cache_quark);
+  if (!cache) {
+    cache = g_new0 (ShaderCache, 1);
+    g_mutex_init (&cache->lock);
+    cache->shaders = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) _weak_ref_free);
+    g_object_set_qdata_full (G_OBJECT (context), _shader_cache_quark, cache,
+        (GDestroyNotify) _shader_cache_free);
+  }
+  g_mutex_unlock (&create_lock);
+
+  return cache;
+}
+
+static GstGLShader *
+_shader_cache_lookup (GstGLContext * context, const gchar * sources)
+{
+  ShaderCache *cache = _shader_cache_get (context);
+  GstGLShader *shader = NULL;
+  GWeakRef *ref;
+
+  g_mutex_lock (&cache->lock);
+  ref = g_hash_table_lookup (cache->shaders, sources);
+  if (ref) {
+    shader = g_weak_ref_get (ref);
+    if (!shader)
+      g_hash_table_remove (cache->shaders, sources);
+  }
+  g_mutex_unlock (&cache->lock);
+
+  return shader;
+}
+
+static void
+_shader_cache_insert (GstGLContext * context, const gchar * sources,
+    GstGLShader * shader)
+{
+  ShaderCache *cache = _shader_cache_get (context);
+  GWeakRef *ref = g_new0 (GWeakRef, 1);
+
+  g_weak_ref_init (ref, shader);
+
+  g_mutex_lock (&cache->lock);
+  g_hash_table_insert (cache->shaders, g_strdup (sources), ref);
+  g_mutex_unlock (&cache->lock);
+}
+
 static GstGLShader *
 _create_shader (GstGLColorConvert * convert)
 {
@@ -1789,14 +1894,13 @@ _create_shader (GstGLColorConvert * convert)
   GstGLSLStage *stage;
   GstGLSLVersion version;
   GstGLSLProfile profile;
-  gchar *version_str, *tmp, *tmp1;
+  gchar *version_str, *vert_prog, *tmp, *tmp1, *sources;
+  gboolean bind_frag_data = FALSE;
   const gchar *strings[2];
   GError *error = NULL;
   int i;
 
-  ret = gst_gl_shader_new (convert->context);
-
-  tmp =
+  vert_prog =
       _gst_glsl_mangle_shader (text_vertex_shader, GL_VERTEX_SHADER,
       info->templ->target, convert->priv->from_texture_target, convert->context,
       &version, &profile);
@@ -1805,28 +1909,6 @@ _create_shader (GstGLColorConvert * convert)
   version_str = g_strdup_printf ("#version %s\n", tmp1);
   g_free (tmp1);
 
-  strings[0] = version_str;
-  strings[1] = tmp;
-  if (!(stage = gst_glsl_stage_new_with_strings (convert->context,
-              GL_VERTEX_SHADER, version, profile, 2, strings))) {
-    GST_ERROR_OBJECT (convert, "Failed to create vertex stage");
-    g_free (version_str);
-    g_free (tmp);
-    gst_object_unref (ret);
-    return NULL;
-  }
-  g_free (tmp);
-
-  if (!gst_gl_shader_compile_attach_stage (ret, stage, &error)) {
-    GST_ERROR_OBJECT (convert, "Failed to compile vertex shader %s",
-        error->message);
-    g_clear_error (&error);
-    g_free (version_str);
-    gst_object_unref (stage);
-    gst_object_unref (ret);
-    return NULL;
-  }
-
   if (info->templ->extensions)
     g_string_append (str, info->templ->extensions);
 
@@ -1858,16 +1940,12 @@ _create_shader (GstGLColorConvert * convert)
     if (info->out_n_textures > 1) {
       gint i;
 
-      for (i = 0; i < info->out_n_textures; i++) {
-        gchar *var_name = g_strdup_printf ("fragColor_%d", i);
-        g_string_append_printf (str, "out vec4 %s;\n", var_name);
-        gst_gl_shader_bind_frag_data_location (ret, i, var_name);
-        g_free (var_name);
-      }
+      for (i = 0; i < info->out_n_textures; i++)
+        g_string_append_printf (str, "out vec4 fragColor_%d;\n", i);
     } else {
       g_string_append (str, "out vec4 fragColor;\n");
-      gst_gl_shader_bind_frag_data_location (ret, 0, "fragColor");
     }
+    bind_frag_data = TRUE;
   }
 
   for (i = 0; i < MAX_FUNCTIONS; i++) {
@@ -1910,38 +1988,128 @@ _create_shader (GstGLColorConvert * convert)
       &version, &profile);
   g_free (tmp);
 
+  sources = g_strconcat (version_str, vert_prog, "\n", version_str,
+      info->frag_prog, NULL);
+  if ((ret = _shader_cache_lookup (convert->context, sources))) {
+    GST_DEBUG_OBJECT (convert, "Reusing already linked shader %" GST_PTR_FORMAT,
+        ret);
+    goto done;
+  }
+
+  ret = gst_gl_shader_new (convert->context);
+
+  strings[0] = version_str;
+  strings[1] = vert_prog;
+  if (!(stage = gst_glsl_stage_new_with_strings (convert->context,
+              GL_VERTEX_SHADER, version, profile, 2, strings))) {
+    GST_ERROR_OBJECT (convert, "Failed to create vertex stage");
+    goto error;
+  }
+
+  if (!gst_gl_shader_compile_attach_stage (ret, stage, &error)) {
+    GST_ERROR_OBJECT (convert, "Failed to compile vertex shader %s",
+        error->message);
+    g_clear_error (&error);
+    gst_object_unref (stage);
+    goto error;
+  }
+
   strings[1] = info->frag_prog;
   if (!(stage = gst_glsl_stage_new_with_strings (convert->context,
               GL_FRAGMENT_SHADER, version, profile, 2, strings))) {
     GST_ERROR_OBJECT (convert, "Failed to create fragment stage");
-    g_free (info->frag_prog);
-    info->frag_prog = NULL;
-    g_free (version_str);
-    gst_object_unref (ret);
-    return NULL;
+    goto error;
   }
-  g_free (version_str);
   if (!gst_gl_shader_compile_attach_stage (ret, stage, &error)) {
     GST_ERROR_OBJECT (convert, "Failed to compile fragment shader %s",
         error->message);
     g_clear_error (&error);
-    g_free (info->frag_prog);
-    info->frag_prog = NULL;
     gst_object_unref (stage);
-    gst_object_unref (ret);
-    return NULL;
+    goto error;
+  }
+
+  if (bind_frag_data) {
+    if (info->out_n_textures > 1) {
+      for (i = 0; i < info->out_n_textures; i++) {
+        gchar *var_name = g_strdup_printf ("fragColor_%d", i);
+        gst_gl_shader_bind_frag_data_location (ret, i, var_name);
+        g_free (var_name);
+      }
+    } else {
+      gst_gl_shader_bind_frag_data_location (ret, 0, "fragColor");
+    }
   }
 
   if (!gst_gl_shader_link (ret, &error)) {
     GST_ERROR_OBJECT (convert, "Failed to link shader %s", error->message);
     g_clear_error (&error);
-    g_free (info->frag_prog);
-    info->frag_prog = NULL;
-    gst_object_unref (ret);
-    return NULL;
+    goto error;
   }
 
+  _shader_cache_insert (convert->context, sources, ret);
+
+done:
+  g_free (sources);
+  g_free (version_str);
+  g_free (vert_prog);
+
   return ret;
+
+error:
+  g_free (info->frag_prog);
+  info->frag_prog = NULL;
+  gst_object_unref (ret);
+  ret = NULL;
+  goto done;
+}
+
+/* the uniforms only depend on the conversion, but have to be set again when
+ * the program was last used by another converter sharing it */
+static void
+_set_uniforms (GstGLColorConvert * convert)
+{
+  struct ConvertInfo *info = &convert->priv->convert_info;
+  gint i;
+
+  if (info->cms_offset && info->cms_coeff1
+      && info->cms_coeff2 && info->cms_coeff3) {
+    gst_gl_shader_set_uniform_3fv (convert->shader, "offset", 1,
+        info->cms_offset);
+    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff1", 1,
+        info->cms_coeff1);
+    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff2", 1,
+        info->cms_coeff2);
+    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff3", 1,
+        info->cms_coeff3);
+  }
+
+  for (i = info->in_n_textures; i >= 0; i--) {
+    if (info->shader_tex_names[i])
+      gst_gl_shader_set_uniform_1i (convert->shader, info->shader_tex_names[i],
+          i);
+  }
+
+  gst_gl_shader_set_uniform_1f (convert->shader, "width",
+      GST_VIDEO_INFO_WIDTH (&convert->in_info));
+  gst_gl_shader_set_uniform_1f (convert->shader, "height",
+      GST_VIDEO_INFO_HEIGHT (&convert->in_info));
+
+  if (convert->priv->from_texture_target == GST_GL_TEXTURE_TARGET_RECTANGLE) {
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x", 1.);
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y", 1.);
+  } else {
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x",
+        1. / (gfloat) GST_VIDEO_INFO_WIDTH (&convert->in_info));
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y",
+        1. / (gfloat) GST_VIDEO_INFO_HEIGHT (&convert->in_info));
+  }
+
+  if (info->chroma_sampling[0] > 0.0f && info->chroma_sampling[1] > 0.0f) {
+    gst_gl_shader_set_uniform_2fv (convert->shader, "chroma_sampling", 1,
+        info->chroma_sampling);
+  }
+
+  g_object_set_qdata (G_OBJECT (convert->shader), _shader_user_quark, convert);
 }
 
 /* Called in the gl thread */
@@ -1950,7 +2118,6 @@ _init_convert (GstGLColorConvert * convert)
 {
   GstGLFuncs *gl;
   struct ConvertInfo *info = &convert->priv->convert_info;
-  gint i;
 
   gl = convert->context->gl_vtable;
 
@@ -2024,44 +2191,7 @@ _init_convert (GstGLColorConvert * convert)
       gst_gl_shader_get_attribute_location (convert->shader, "a_texcoord");
 
   gst_gl_shader_use (convert->shader);
-
-  if (info->cms_offset && info->cms_coeff1
-      && info->cms_coeff2 && info->cms_coeff3) {
-    gst_gl_shader_set_uniform_3fv (convert->shader, "offset", 1,
-        info->cms_offset);
-    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff1", 1,
-        info->cms_coeff1);
-    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff2", 1,
-        info->cms_coeff2);
-    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff3", 1,
-        info->cms_coeff3);
-  }
-
-  for (i = info->in_n_textures; i >= 0; i--) {
-    if (info->shader_tex_names[i])
-      gst_gl_shader_set_uniform_1i (convert->shader, info->shader_tex_names[i],
-          i);
-  }
-
-  gst_gl_shader_set_uniform_1f (convert->shader, "width",
-      GST_VIDEO_INFO_WIDTH (&convert->in_info));
-  gst_gl_shader_set_uniform_1f (convert->shader, "height",
-      GST_VIDEO_INFO_HEIGHT (&convert->in_info));
-
-  if (convert->priv->from_texture_target == GST_GL_TEXTURE_TARGET_RECTANGLE) {
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x", 1.);
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y", 1.);
-  } else {
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x",
-        1. / (gfloat) GST_VIDEO_INFO_WIDTH (&convert->in_info));
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y",
-        1. / (gfloat) GST_VIDEO_INFO_HEIGHT (&convert->in_info));
-  }
-
-  if (info->chroma_sampling[0] > 0.0f && info->chroma_sampling[1] > 0.0f) {
-    gst_gl_shader_set_uniform_2fv (convert->shader, "chroma_sampling", 1,
-        info->chroma_sampling);
-  }
+  _set_uniforms (convert);
 
   gst_gl_context_clear_shader (convert->context);
 
@@ -2129,8 +2259,8 @@ _init_convert_fbo (GstGLColorConvert * convert)
   out_height = GST_VIDEO_INFO_HEIGHT (&convert->out_info);
 
   convert->fbo =
-      gst_gl_framebuffer_new_with_default_depth (convert->context, out_width,
-      out_height);
+      gst_gl_resource_pool_acquire_framebuffer (convert->priv->resource_pool,
+      out_width, out_height);
 
   return convert->fbo != NULL;
 }
@@ -2192,25 +2322,14 @@ _do_convert_one_view (GstGLContext * context, GstGLColorConvert * convert,
       /* renderering to a framebuffer only renders the intersection of all
        * the attachments i.e. the smallest attachment size */
       if (!convert->priv->out_tex[j]) {
-        GstGLVideoAllocationParams *params;
-        GstGLBaseMemoryAllocator *base_mem_allocator;
-        GstAllocator *allocator;
         GstVideoInfo temp_info;
 
         gst_video_info_set_format (&temp_info, GST_VIDEO_FORMAT_RGBA, out_width,
             out_height);
 
-        allocator = gst_allocator_find (GST_GL_MEMORY_ALLOCATOR_NAME);
-        base_mem_allocator = GST_GL_BASE_MEMORY_ALLOCATOR (allocator);
-        params = gst_gl_video_allocation_params_new (context, NULL, &temp_info,
-            0, NULL, convert->priv->to_texture_target, GST_GL_RGBA);
-
         convert->priv->out_tex[j] =
-            (GstGLMemory *) gst_gl_base_memory_alloc (base_mem_allocator,
-            (GstGLAllocationParams *) params);
-
-        gst_gl_allocation_params_free ((GstGLAllocationParams *) params);
-        gst_object_unref (allocator);
+            gst_gl_resource_pool_acquire_texture (convert->priv->resource_pool,
+            &temp_info, 0, convert->priv->to_texture_target, GST_GL_RGBA);
       }
     } else {
       convert->priv->out_tex[j] = out_tex;
@@ -2475,6 +2594,9 @@ _do_convert_draw (GstGLContext * context, GstGLColorConvert * convert)
   gl->Viewport (0, 0, out_width, out_height);
 
   gst_gl_shader_use (convert->shader);
+  if (g_object_get_qdata (G_OBJECT (convert->shader),
+          _shader_user_quark) != convert)
+    _set_uniforms (convert);
 
   if (gl->BindVertexArray)
     gl->BindVertexArray (convert->priv->vao);
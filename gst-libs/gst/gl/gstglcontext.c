@@ -1582,6 +1582,57 @@ gst_gl_context_thread_add (GstGLContext * context,
   gst_object_unref (window);
 }
 
+typedef struct
+{
+  guint n_funcs;
+  GstGLContextThreadFunc *funcs;
+  gpointer *data;
+} RunBatchData;
+
+static void
+_gst_gl_context_thread_run_batch (GstGLContext * context, RunBatchData * batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->n_funcs; i++)
+    batch->funcs[i] (context, batch->data[i]);
+}
+
+/**
+ * gst_gl_context_thread_add_batch:
+ * @context: a #GstGLContext
+ * @n_funcs: the number of functions in @funcs
+ * @funcs: (array length=n_funcs) (scope call): the functions to execute
+ * @data: (array length=n_funcs): the user data to call each of @funcs with
+ *
+ * Execute each of @funcs in order in the OpenGL thread of @context, with
+ * the matching entry of @data. Unlike calling gst_gl_context_thread_add()
+ * for each of them, this only waits for the OpenGL thread once.
+ *
+ * MT-safe
+ *
+ * Since: 1.14
+ */
+void
+gst_gl_context_thread_add_batch (GstGLContext * context, guint n_funcs,
+    GstGLContextThreadFunc * funcs, gpointer * data)
+{
+  RunBatchData batch;
+
+  g_return_if_fail (GST_IS_GL_CONTEXT (context));
+  g_return_if_fail (n_funcs == 0 || (funcs != NULL && data != NULL));
+
+  if (n_funcs == 0)
+    return;
+
+  batch.n_funcs = n_funcs;
+  batch.funcs = funcs;
+  batch.data = data;
+
+  gst_gl_context_thread_add (context,
+      (GstGLContextThreadFunc) _gst_gl_context_thread_run_batch, &batch);
+}
+
 /**
  * gst_gl_context_get_gl_version:
  * @context: a #GstGLContext
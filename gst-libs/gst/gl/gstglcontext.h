@@ -215,6 +215,9 @@ gboolean gst_gl_context_fill_info (GstGLContext * context, GError ** error);
 GST_EXPORT
 void gst_gl_context_thread_add (GstGLContext * context,
     GstGLContextThreadFunc func, gpointer data);
+GST_EXPORT
+void gst_gl_context_thread_add_batch (GstGLContext * context, guint n_funcs,
+    GstGLContextThreadFunc * funcs, gpointer * data);
 
 GST_DEBUG_CATEGORY_EXTERN (gst_gl_context_debug);
 
@@ -44,6 +44,7 @@
 
 #include "gl.h"
 #include "gstglframebuffer.h"
+#include "gstglresourcepool_private.h"
 
 #ifndef GL_FRAMEBUFFER_UNDEFINED
 #define GL_FRAMEBUFFER_UNDEFINED          0x8219
@@ -483,6 +484,43 @@ gst_gl_framebuffer_attach (GstGLFramebuffer * fb, guint attachment_point,
   _update_effective_dimensions (fb);
 }
 
+/* drops all the color attachments of @fb, keeping its depth and stencil
+ * buffers. Must be called from the GL thread */
+void
+gst_gl_framebuffer_detach_color_attachments (GstGLFramebuffer * fb)
+{
+  const GstGLFuncs *gl;
+  gboolean bound = FALSE;
+  int i;
+
+  g_return_if_fail (GST_IS_GL_FRAMEBUFFER (fb));
+  g_return_if_fail (gst_gl_context_get_current () == fb->context);
+
+  gl = fb->context->gl_vtable;
+
+  for (i = fb->attachments->len - 1; i >= 0; i--) {
+    struct fbo_attachment *attach;
+
+    attach = &g_array_index (fb->attachments, struct fbo_attachment, i);
+
+    if (!gst_is_gl_memory (GST_MEMORY_CAST (attach->mem)))
+      continue;
+
+    if (!bound) {
+      gst_gl_framebuffer_bind (fb);
+      bound = TRUE;
+    }
+    gl->FramebufferTexture2D (GL_FRAMEBUFFER, attach->attachment_point,
+        GL_TEXTURE_2D, 0, 0);
+    g_array_remove_index_fast (fb->attachments, i);
+  }
+
+  if (bound) {
+    gst_gl_context_clear_framebuffer (fb->context);
+    _update_effective_dimensions (fb);
+  }
+}
+
 /**
  * gst_gl_framebuffer_get_effective_dimensions:
  * @fb: a #GstGLFramebuffer
@@ -82,10 +82,20 @@ struct _GstGLCompositionOverlay
   GLint texcoord_attrib;
 
   GLfloat positions[16];
+  /* what the positions were computed from */
+  gint render_x, render_y;
+  guint render_width, render_height;
+  guint video_width, video_height;
 
   GLuint texture_id;
   GstGLMemory *gl_memory;
   GstVideoOverlayRectangle *rectangle;
+
+  /* what the texture was uploaded from, to find it again when the same
+   * pixels come in another rectangle of another composition */
+  guint seqnum;
+  GstBuffer *pixels;
+  gfloat global_alpha;
 };
 
 struct _GstGLCompositionOverlayClass
@@ -174,8 +184,8 @@ gst_gl_composition_overlay_free_vertex_buffer (GstGLContext * context,
   }
 
   if (overlay->texcoord_buffer) {
-    gl->DeleteBuffers (1, &overlay->position_buffer);
-    overlay->position_buffer = 0;
+    gl->DeleteBuffers (1, &overlay->texcoord_buffer);
+    overlay->texcoord_buffer = 0;
   }
 
   if (overlay->index_buffer) {
@@ -184,6 +194,20 @@ gst_gl_composition_overlay_free_vertex_buffer (GstGLContext * context,
   }
 }
 
+static void
+gst_gl_composition_overlay_update_vertex_buffer (GstGLContext * context,
+    gpointer overlay_pointer)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  GstGLCompositionOverlay *overlay =
+      (GstGLCompositionOverlay *) overlay_pointer;
+
+  gl->BindBuffer (GL_ARRAY_BUFFER, overlay->position_buffer);
+  gl->BufferSubData (GL_ARRAY_BUFFER, 0, 4 * 4 * sizeof (GLfloat),
+      overlay->positions);
+  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
 static void
 gst_gl_composition_overlay_bind_vertex_buffer (GstGLCompositionOverlay *
     overlay)
@@ -213,6 +237,12 @@ gst_gl_composition_overlay_finalize (GObject * object)
   if (overlay->gl_memory)
     gst_memory_unref ((GstMemory *) overlay->gl_memory);
 
+  if (overlay->pixels)
+    gst_buffer_unref (overlay->pixels);
+
+  if (overlay->rectangle)
+    gst_video_overlay_rectangle_unref (overlay->rectangle);
+
   if (overlay->context) {
     gst_gl_context_thread_add (overlay->context,
         gst_gl_composition_overlay_free_vertex_buffer, overlay);
@@ -253,6 +283,21 @@ gst_gl_composition_overlay_add_transformation (GstGLCompositionOverlay *
   width = meta->width;
   height = meta->height;
 
+  /* the vertex buffer only changes when the overlay moves or the video size
+   * changes, not with every frame */
+  if (overlay->position_buffer && comp_x == overlay->render_x
+      && comp_y == overlay->render_y && comp_width == overlay->render_width
+      && comp_height == overlay->render_height && width == overlay->video_width
+      && height == overlay->video_height)
+    return;
+
+  overlay->render_x = comp_x;
+  overlay->render_y = comp_y;
+  overlay->render_width = comp_width;
+  overlay->render_height = comp_height;
+  overlay->video_width = width;
+  overlay->video_height = height;
+
   /* calculate relative position */
   rel_x = (float) comp_x / (float) width;
   rel_y = (float) comp_y / (float) height;
@@ -284,17 +329,42 @@ gst_gl_composition_overlay_add_transformation (GstGLCompositionOverlay *
   overlay->positions[14] = 0.0;
   overlay->positions[15] = 1.0;
 
-  gst_gl_context_thread_add (overlay->context,
-      gst_gl_composition_overlay_free_vertex_buffer, overlay);
-
-  gst_gl_context_thread_add (overlay->context,
-      gst_gl_composition_overlay_init_vertex_buffer, overlay);
+  if (overlay->position_buffer)
+    gst_gl_context_thread_add (overlay->context,
+        gst_gl_composition_overlay_update_vertex_buffer, overlay);
+  else
+    gst_gl_context_thread_add (overlay->context,
+        gst_gl_composition_overlay_init_vertex_buffer, overlay);
 
   GST_DEBUG
       ("overlay position: (%d,%d) size: %dx%d video size: %dx%d",
       comp_x, comp_y, comp_width, comp_height, meta->width, meta->height);
 }
 
+/* The pixels identifying the texture of @rectangle. Copies of a rectangle,
+ * as made when a composition is copied to add or change other rectangles,
+ * share the pixel buffer of the original. */
+static GstBuffer *
+_get_rectangle_pixels (GstVideoOverlayRectangle * rectangle)
+{
+  return gst_video_overlay_rectangle_get_pixels_unscaled_raw (rectangle,
+      gst_video_overlay_rectangle_get_flags (rectangle));
+}
+
+static void
+gst_gl_composition_overlay_set_rectangle (GstGLCompositionOverlay * overlay,
+    GstVideoOverlayRectangle * rectangle)
+{
+  if (overlay->rectangle == rectangle)
+    return;
+
+  gst_video_overlay_rectangle_ref (rectangle);
+  if (overlay->rectangle)
+    gst_video_overlay_rectangle_unref (overlay->rectangle);
+  overlay->rectangle = rectangle;
+  overlay->seqnum = gst_video_overlay_rectangle_get_seqnum (rectangle);
+}
+
 /* helper object API functions */
 
 static GstGLCompositionOverlay *
@@ -307,7 +377,10 @@ gst_gl_composition_overlay_new (GstGLContext * context,
 
   overlay->gl_memory = NULL;
   overlay->texture_id = -1;
-  overlay->rectangle = rectangle;
+  gst_gl_composition_overlay_set_rectangle (overlay, rectangle);
+  overlay->pixels = gst_buffer_ref (_get_rectangle_pixels (rectangle));
+  overlay->global_alpha =
+      gst_video_overlay_rectangle_get_global_alpha (rectangle);
   overlay->context = gst_object_ref (context);
   overlay->vao = 0;
   overlay->position_attrib = position_attrib;
@@ -359,8 +432,6 @@ gst_gl_composition_overlay_upload (GstGLCompositionOverlay * overlay,
         GST_ALLOCATOR (gst_gl_memory_allocator_get_default (overlay->context));
     mem_allocator = GST_GL_BASE_MEMORY_ALLOCATOR (allocator);
 
-    gst_gl_composition_overlay_add_transformation (overlay, buf);
-
     params = gst_gl_video_allocation_params_new_wrapped_data (overlay->context,
         NULL, &comp_frame->info, 0, NULL, GST_GL_TEXTURE_TARGET_2D,
         GST_GL_RGBA, comp_frame->data[0], comp_frame,
@@ -426,10 +497,8 @@ G_DEFINE_TYPE_WITH_CODE (GstGLOverlayCompositor, gst_gl_overlay_compositor,
     GST_TYPE_OBJECT, DEBUG_INIT);
 
 static void gst_gl_overlay_compositor_finalize (GObject * object);
-static gboolean _is_rectangle_in_overlays (GList * overlays,
+static GstGLCompositionOverlay *_find_overlay (GList * overlays,
     GstVideoOverlayRectangle * rectangle);
-static gboolean _is_overlay_in_rectangles (GstVideoOverlayComposition *
-    composition, GstGLCompositionOverlay * overlay);
 
 static void
 gst_gl_overlay_compositor_class_init (GstGLOverlayCompositorClass * klass)
@@ -506,33 +575,33 @@ gst_gl_overlay_compositor_finalize (GObject * object)
   G_OBJECT_CLASS (gst_gl_overlay_compositor_parent_class)->finalize (object);
 }
 
-static gboolean
-_is_rectangle_in_overlays (GList * overlays,
-    GstVideoOverlayRectangle * rectangle)
+/* Finds an uploaded overlay in @overlays that can show @rectangle: the one made for @rectangle itself, or else one that
+ * was uploaded from the same pixels with the same global alpha. */
+static GstGLCompositionOverlay *
+_find_overlay (GList * overlays, GstVideoOverlayRectangle * rectangle)
 {
+  GstBuffer *pixels;
+  gfloat global_alpha;
   GList *l;
 
   for (l = overlays; l != NULL; l = l->next) {
     GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
-    if (overlay->rectangle == rectangle)
-      return TRUE;
+
+    if (overlay->rectangle == rectangle && overlay->seqnum == gst_video_overlay_rectangle_get_seqnum (rectangle))
+      return overlay;
   }
-  return FALSE;
-}
 
-static gboolean
-_is_overlay_in_rectangles (GstVideoOverlayComposition * composition,
-    GstGLCompositionOverlay * overlay)
-{
-  guint i;
+  pixels = _get_rectangle_pixels (rectangle);
+  global_alpha = gst_video_overlay_rectangle_get_global_alpha (rectangle);
+
+  for (l = overlays; l != NULL; l = l->next) {
+    GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
 
-  for (i = 0; i < gst_video_overlay_composition_n_rectangles (composition); i++) {
-    GstVideoOverlayRectangle *rectangle =
-        gst_video_overlay_composition_get_rectangle (composition, i);
-    if (overlay->rectangle == rectangle)
-      return TRUE;
+    if (overlay->pixels == pixels && overlay->global_alpha == global_alpha)
+      return overlay;
   }
-  return FALSE;
+
+  return NULL;
 }
 
 
@@ -561,40 +630,41 @@ gst_gl_overlay_compositor_upload_overlays (GstGLOverlayCompositor * compositor,
   if (composition_meta) {
     GstVideoOverlayComposition *composition = NULL;
     guint num_overlays, i;
-    GList *l = compositor->overlays;
+    GList *old_overlays = compositor->overlays;
 
     GST_DEBUG ("GstVideoOverlayCompositionMeta found.");
 
     composition = composition_meta->overlay;
     num_overlays = gst_video_overlay_composition_n_rectangles (composition);
 
-    /* add new overlays to list */
+    /* reuse the textures of what is still shown, only upload new pixels.
+     * The list is rebuilt in the order of the composition, which is the
+     * order the overlays are drawn in. */
+    compositor->overlays = NULL;
     for (i = 0; i < num_overlays; i++) {
       GstVideoOverlayRectangle *rectangle =
           gst_video_overlay_composition_get_rectangle (composition, i);
-
-      if (!_is_rectangle_in_overlays (compositor->overlays, rectangle)) {
-        GstGLCompositionOverlay *overlay =
-            gst_gl_composition_overlay_new (compositor->context, rectangle,
-            compositor->position_attrib, compositor->texcoord_attrib);
+      GstGLCompositionOverlay *overlay;
+
+      overlay = _find_overlay (old_overlays, rectangle);
+      if (overlay) {
+        old_overlays = g_list_remove (old_overlays, overlay);
+        gst_gl_composition_overlay_set_rectangle (overlay, rectangle);
+      } else {
+        overlay = gst_gl_composition_overlay_new (compositor->context,
+            rectangle, compositor->position_attrib,
+            compositor->texcoord_attrib);
         gst_object_ref_sink (overlay);
 
         gst_gl_composition_overlay_upload (overlay, buf);
-
-        compositor->overlays = g_list_append (compositor->overlays, overlay);
       }
-    }
 
-    /* remove old overlays from list */
-    while (l != NULL) {
-      GList *next = l->next;
-      GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
-      if (!_is_overlay_in_rectangles (composition, overlay)) {
-        compositor->overlays = g_list_delete_link (compositor->overlays, l);
-        gst_object_unref (overlay);
-      }
-      l = next;
+      compositor->overlays = g_list_append (compositor->overlays, overlay);
+      gst_gl_composition_overlay_add_transformation (overlay, buf);
     }
+
+    /* what is left is not shown anymore */
+    g_list_free_full (old_overlays, gst_object_unref);
   } else {
     gst_gl_overlay_compositor_free_overlays (compositor);
   }
@@ -0,0 +1,286 @@
+/*
+ * GStreamer
+ * Copyright (C) 2017 Matthew Waters <matthew@centricular.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Idle framebuffers and intermediate textures, shared between the
+ * converters of a GL context so that renegotiating or resetting one of them
+ * does not have to go back to the driver for new objects.
+ *
+ * Every user holds a reference on the pool while the context only points to
+ * it from its qdata without one: the pooled objects reference the context, so
+ * the pool has to go away together with its last user rather than with the
+ * context. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstglresourcepool_private.h"
+
+#define MAX_IDLE_FRAMEBUFFERS 8
+#define MAX_IDLE_TEXTURES 16
+
+GST_DEBUG_CATEGORY_STATIC (gst_gl_resource_pool_debug);
+#define GST_CAT_DEFAULT gst_gl_resource_pool_debug
+
+struct _GstGLResourcePool
+{
+  /* protected by pool_lock */
+  gint refcount;
+  GstGLContext *context;
+
+  GMutex lock;
+  GQueue framebuffers;          /* most recently released first */
+  GQueue textures;              /* most recently released first */
+};
+
+static GMutex pool_lock;
+static GQuark pool_quark;
+
+/*
+ * gst_gl_resource_pool_get:
+ * @context: a #GstGLContext
+ *
+ * Returns: (transfer full): the pool shared by all the users of @context
+ */
+GstGLResourcePool *
+gst_gl_resource_pool_get (GstGLContext * context)
+{
+  GstGLResourcePool *pool;
+
+  g_return_val_if_fail (GST_IS_GL_CONTEXT (context), NULL);
+
+  g_mutex_lock (&pool_lock);
+  if (!pool_quark) {
+    pool_quark = g_quark_from_static_string ("GstGLResourcePool");
+    GST_DEBUG_CATEGORY_INIT (gst_gl_resource_pool_debug, "glresourcepool", 0,
+        "OpenGL resource pool");
+  }
+
+  pool = g_object_get_qdata (G_OBJECT (context), pool_quark);
+  if (pool) {
+    pool->refcount++;
+  } else {
+    pool = g_new0 (GstGLResourcePool, 1);
+    pool->refcount = 1;
+    pool->context = context;
+    g_mutex_init (&pool->lock);
+    g_queue_init (&pool->framebuffers);
+    g_queue_init (&pool->textures);
+    g_object_set_qdata (G_OBJECT (context), pool_quark, pool);
+    GST_DEBUG_OBJECT (context, "created resource pool %p", pool);
+  }
+  g_mutex_unlock (&pool_lock);
+
+  return pool;
+}
+
+/*
+ * gst_gl_resource_pool_unref:
+ * @pool: a #GstGLResourcePool
+ *
+ * Drops a reference on @pool, freeing all the idle resources with the last
+ * one.
+ */
+void
+gst_gl_resource_pool_unref (GstGLResourcePool * pool)
+{
+  g_return_if_fail (pool != NULL);
+
+  g_mutex_lock (&pool_lock);
+  if (--pool->refcount > 0) {
+    g_mutex_unlock (&pool_lock);
+    return;
+  }
+  g_object_set_qdata (G_OBJECT (pool->context), pool_quark, NULL);
+  g_mutex_unlock (&pool_lock);
+
+  GST_DEBUG_OBJECT (pool->context, "freeing resource pool %p with %u "
+      "framebuffers and %u textures", pool, pool->framebuffers.length,
+      pool->textures.length);
+
+  g_queue_clear_full (&pool->framebuffers, (GDestroyNotify) gst_object_unref);
+  g_queue_clear_full (&pool->textures, (GDestroyNotify) gst_memory_unref);
+  g_mutex_clear (&pool->lock);
+  g_free (pool);
+}
+
+/*
+ * gst_gl_resource_pool_acquire_framebuffer:
+ * @pool: a #GstGLResourcePool
+ * @width: width of the depth buffer
+ * @height: height of the depth buffer
+ *
+ * Must be called from the GL thread.
+ *
+ * Returns: (transfer full) (nullable): a framebuffer with a depth buffer of
+ * @width and @height and no color attachments
+ */
+GstGLFramebuffer *
+gst_gl_resource_pool_acquire_framebuffer (GstGLResourcePool * pool,
+    guint width, guint height)
+{
+  GstGLFramebuffer *fb = NULL;
+  GList *l;
+
+  g_return_val_if_fail (pool != NULL, NULL);
+
+  g_mutex_lock (&pool->lock);
+  for (l = pool->framebuffers.head; l; l = l->next) {
+    guint fb_width, fb_height;
+
+    gst_gl_framebuffer_get_effective_dimensions (l->data, &fb_width,
+        &fb_height);
+    if (fb_width == width && fb_height == height) {
+      fb = l->data;
+      g_queue_delete_link (&pool->framebuffers, l);
+      break;
+    }
+  }
+  g_mutex_unlock (&pool->lock);
+
+  if (fb) {
+    GST_TRACE_OBJECT (pool->context, "reusing framebuffer %" GST_PTR_FORMAT
+        " of %ux%u", fb, width, height);
+    return fb;
+  }
+
+  return gst_gl_framebuffer_new_with_default_depth (pool->context, width,
+      height);
+}
+
+static void
+_detach_color_attachments_gl (GstGLContext * context, GstGLFramebuffer * fb)
+{
+  gst_gl_framebuffer_detach_color_attachments (fb);
+}
+
+/*
+ * gst_gl_resource_pool_release_framebuffer:
+ * @pool: a #GstGLResourcePool
+ * @fb: (transfer full): a #GstGLFramebuffer from
+ *     gst_gl_resource_pool_acquire_framebuffer()
+ *
+ * Gives back @fb to @pool. The color attachments are dropped so that the
+ * pool does not keep the textures they refer to alive.
+ */
+void
+gst_gl_resource_pool_release_framebuffer (GstGLResourcePool * pool,
+    GstGLFramebuffer * fb)
+{
+  g_return_if_fail (pool != NULL);
+  g_return_if_fail (GST_IS_GL_FRAMEBUFFER (fb));
+  g_return_if_fail (fb->context == pool->context);
+
+  gst_gl_context_thread_add (pool->context,
+      (GstGLContextThreadFunc) _detach_color_attachments_gl, fb);
+
+  g_mutex_lock (&pool->lock);
+  g_queue_push_head (&pool->framebuffers, fb);
+  while (pool->framebuffers.length > MAX_IDLE_FRAMEBUFFERS)
+    gst_object_unref (g_queue_pop_tail (&pool->framebuffers));
+  g_mutex_unlock (&pool->lock);
+}
+
+/*
+ * gst_gl_resource_pool_acquire_texture:
+ * @pool: a #GstGLResourcePool
+ * @v_info: the #GstVideoInfo of the texture
+ * @plane: the plane of @v_info the texture is for
+ * @target: the #GstGLTextureTarget of the texture
+ * @tex_format: the #GstGLFormat of the texture
+ *
+ * Must be called from the GL thread.
+ *
+ * Returns: (transfer full) (nullable): a texture with the requested
+ * dimensions and format. Its contents are undefined.
+ */
+GstGLMemory *
+gst_gl_resource_pool_acquire_texture (GstGLResourcePool * pool,
+    GstVideoInfo * v_info, guint plane, GstGLTextureTarget target,
+    GstGLFormat tex_format)
+{
+  GstGLVideoAllocationParams *params;
+  GstGLBaseMemoryAllocator *base_mem_allocator;
+  GstAllocator *allocator;
+  GstGLMemory *mem = NULL;
+  gint width, height;
+  GList *l;
+
+  g_return_val_if_fail (pool != NULL, NULL);
+  g_return_val_if_fail (v_info != NULL, NULL);
+
+  width = GST_VIDEO_INFO_COMP_WIDTH (v_info, plane);
+  height = GST_VIDEO_INFO_COMP_HEIGHT (v_info, plane);
+
+  g_mutex_lock (&pool->lock);
+  for (l = pool->textures.head; l; l = l->next) {
+    GstGLMemory *tex = l->data;
+
+    if (tex->tex_target == target && tex->tex_format == tex_format
+        && gst_gl_memory_get_texture_width (tex) == width
+        && gst_gl_memory_get_texture_height (tex) == height) {
+      mem = tex;
+      g_queue_delete_link (&pool->textures, l);
+      break;
+    }
+  }
+  g_mutex_unlock (&pool->lock);
+
+  if (mem) {
+    GST_TRACE_OBJECT (pool->context, "reusing texture %u of %ix%i",
+        mem->tex_id, width, height);
+    return mem;
+  }
+
+  allocator = gst_allocator_find (GST_GL_MEMORY_ALLOCATOR_NAME);
+  base_mem_allocator = GST_GL_BASE_MEMORY_ALLOCATOR (allocator);
+  params = gst_gl_video_allocation_params_new (pool->context, NULL, v_info,
+      plane, NULL, target, tex_format);
+
+  mem = (GstGLMemory *) gst_gl_base_memory_alloc (base_mem_allocator,
+      (GstGLAllocationParams *) params);
+
+  gst_gl_allocation_params_free ((GstGLAllocationParams *) params);
+  gst_object_unref (allocator);
+
+  return mem;
+}
+
+/*
+ * gst_gl_resource_pool_release_texture:
+ * @pool: a #GstGLResourcePool
+ * @mem: (transfer full): a #GstGLMemory from
+ *     gst_gl_resource_pool_acquire_texture()
+ *
+ * Gives back @mem to @pool.
+ */
+void
+gst_gl_resource_pool_release_texture (GstGLResourcePool * pool,
+    GstGLMemory * mem)
+{
+  g_return_if_fail (pool != NULL);
+  g_return_if_fail (gst_is_gl_memory ((GstMemory *) mem));
+
+  g_mutex_lock (&pool->lock);
+  g_queue_push_head (&pool->textures, mem);
+  while (pool->textures.length > MAX_IDLE_TEXTURES)
+    gst_memory_unref (g_queue_pop_tail (&pool->textures));
+  g_mutex_unlock (&pool->lock);
+}
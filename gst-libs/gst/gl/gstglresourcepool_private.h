@@ -0,0 +1,52 @@
+/*
+ * GStreamer
+ * Copyright (C) 2017 Matthew Waters <matthew@centricular.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_GL_RESOURCE_POOL_PRIVATE_H__
+#define __GST_GL_RESOURCE_POOL_PRIVATE_H__
+
+#include <gst/gl/gl.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstGLResourcePool GstGLResourcePool;
+
+G_GNUC_INTERNAL GstGLResourcePool * gst_gl_resource_pool_get                (GstGLContext * context);
+G_GNUC_INTERNAL void                gst_gl_resource_pool_unref              (GstGLResourcePool * pool);
+
+G_GNUC_INTERNAL GstGLFramebuffer *  gst_gl_resource_pool_acquire_framebuffer (GstGLResourcePool * pool,
+                                                                             guint width,
+                                                                             guint height);
+G_GNUC_INTERNAL void                gst_gl_resource_pool_release_framebuffer (GstGLResourcePool * pool,
+                                                                             GstGLFramebuffer * fb);
+
+G_GNUC_INTERNAL GstGLMemory *       gst_gl_resource_pool_acquire_texture    (GstGLResourcePool * pool,
+                                                                             GstVideoInfo * v_info,
+                                                                             guint plane,
+                                                                             GstGLTextureTarget target,
+                                                                             GstGLFormat tex_format);
+G_GNUC_INTERNAL void                gst_gl_resource_pool_release_texture    (GstGLResourcePool * pool,
+                                                                             GstGLMemory * mem);
+
+/* implemented in gstglframebuffer.c */
+G_GNUC_INTERNAL void                gst_gl_framebuffer_detach_color_attachments (GstGLFramebuffer * fb);
+
+G_END_DECLS
+
+#endif /* __GST_GL_RESOURCE_POOL_PRIVATE_H__ */
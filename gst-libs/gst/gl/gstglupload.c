@@ -24,6 +24,7 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include "gl.h"
 #include "gstglupload.h"
@@ -35,6 +36,7 @@
 
 #if GST_GL_HAVE_DMABUF
 #include <gst/allocators/gstdmabuf.h>
+#include <sys/stat.h>
 #endif
 
 #if GST_GL_HAVE_VIV_DIRECTVIV
@@ -480,13 +482,55 @@ static const UploadMethod _gl_memory_upload = {
 };
 
 #if GST_GL_HAVE_DMABUF
+/* EGLImages imported from dmabufs, keyed on what identifies the underlying
+ * buffer rather than on the GstMemory wrapping it, so that pools which wrap
+ * their fds in new memories for every frame still hit the cache. The images
+ * keep their dmabuf alive, so an inode can not be reused for another buffer
+ * while it is in the cache. */
+#define DMABUF_CACHE_SIZE 32
+
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR 0ULL
+#endif
+
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
+#endif
+
+typedef struct
+{
+  guint64 dev[GST_VIDEO_MAX_PLANES];
+  guint64 ino[GST_VIDEO_MAX_PLANES];
+  guint64 offset[GST_VIDEO_MAX_PLANES];
+  gint stride[GST_VIDEO_MAX_PLANES];
+  guint64 modifier;
+  GstVideoFormat format;
+  gint width;
+  gint height;
+  /* the plane imported, -1 for all of them in a single image */
+  gint plane;
+} DmabufCacheKey;
+
+typedef struct
+{
+  DmabufCacheKey key;
+  GstEGLImage *image;
+  GList link;
+} DmabufCacheEntry;
+
 struct DmabufUpload
 {
   GstGLUpload *upload;
+  /* import all the planes into a single external-oes image */
+  gboolean direct;
 
   GstEGLImage *eglimage[GST_VIDEO_MAX_PLANES];
   GstBuffer *outbuf;
   GstGLVideoAllocationParams *params;
+
+  GstCaps *cache_caps;
+  GHashTable *cache;            /* DmabufCacheKey -> DmabufCacheEntry */
+  GQueue cache_lru;             /* most recently used first */
 };
 
 static GstStaticCaps _dma_buf_upload_caps =
@@ -495,14 +539,129 @@ static GstStaticCaps _dma_buf_upload_caps =
         GST_GL_MEMORY_VIDEO_FORMATS_STR) ";"
     GST_VIDEO_CAPS_MAKE (GST_GL_MEMORY_VIDEO_FORMATS_STR));
 
+#define GST_GL_DIRECT_DMABUF_FORMATS "{ NV12, NV21, I420, YV12, P010_10LE }"
+
+static GstStaticCaps _direct_dma_buf_upload_caps =
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+    (GST_CAPS_FEATURE_MEMORY_DMABUF, GST_GL_DIRECT_DMABUF_FORMATS));
+
+static guint
+_dmabuf_cache_key_hash (const DmabufCacheKey * key)
+{
+  const guint8 *data = (const guint8 *) key;
+  guint hash = 2166136261u;
+  gsize i;
+
+  /* FNV-1a, the keys are zero-filled so the padding does not matter */
+  for (i = 0; i < sizeof (DmabufCacheKey); i++)
+    hash = (hash ^ data[i]) * 16777619u;
+
+  return hash;
+}
+
+static gboolean
+_dmabuf_cache_key_equal (const DmabufCacheKey * a, const DmabufCacheKey * b)
+{
+  return memcmp (a, b, sizeof (DmabufCacheKey)) == 0;
+}
+
+static void
+_dmabuf_cache_entry_free (DmabufCacheEntry * entry)
+{
+  gst_egl_image_unref (entry->image);
+  g_slice_free (DmabufCacheEntry, entry);
+}
+
+static void
+_dmabuf_cache_clear (struct DmabufUpload *dmabuf)
+{
+  g_queue_init (&dmabuf->cache_lru);
+  g_hash_table_remove_all (dmabuf->cache);
+}
+
+static gboolean
+_dmabuf_cache_key_fill_plane (DmabufCacheKey * key, guint i, gint fd,
+    gsize offset, gint stride)
+{
+  struct stat st;
+
+  if (fstat (fd, &st) != 0)
+    return FALSE;
+
+  key->dev[i] = st.st_dev;
+  key->ino[i] = st.st_ino;
+  key->offset[i] = offset;
+  key->stride[i] = stride;
+
+  return TRUE;
+}
+
+static GstEGLImage *
+_dmabuf_cache_lookup (struct DmabufUpload *dmabuf, const DmabufCacheKey * key)
+{
+  DmabufCacheEntry *entry;
+
+  entry = g_hash_table_lookup (dmabuf->cache, key);
+  if (!entry)
+    return NULL;
+
+  g_queue_unlink (&dmabuf->cache_lru, &entry->link);
+  g_queue_push_head_link (&dmabuf->cache_lru, &entry->link);
+
+  return entry->image;
+}
+
+static void
+_dmabuf_cache_insert (struct DmabufUpload *dmabuf, const DmabufCacheKey * key,
+    GstEGLImage * image)
+{
+  DmabufCacheEntry *entry;
+
+  while (dmabuf->cache_lru.length >= DMABUF_CACHE_SIZE) {
+    entry = dmabuf->cache_lru.tail->data;
+    g_queue_unlink (&dmabuf->cache_lru, &entry->link);
+    g_hash_table_remove (dmabuf->cache, &entry->key);
+  }
+
+  entry = g_slice_new0 (DmabufCacheEntry);
+  memcpy (&entry->key, key, sizeof (DmabufCacheKey));
+  entry->image = gst_egl_image_ref (image);
+  entry->link.data = entry;
+  g_hash_table_insert (dmabuf->cache, &entry->key, entry);
+  g_queue_push_head_link (&dmabuf->cache_lru, &entry->link);
+}
+
 static gpointer
 _dma_buf_upload_new (GstGLUpload * upload)
 {
   struct DmabufUpload *dmabuf = g_new0 (struct DmabufUpload, 1);
   dmabuf->upload = upload;
+  dmabuf->cache = g_hash_table_new_full ((GHashFunc) _dmabuf_cache_key_hash,
+      (GEqualFunc) _dmabuf_cache_key_equal, NULL,
+      (GDestroyNotify) _dmabuf_cache_entry_free);
+  g_queue_init (&dmabuf->cache_lru);
+  return dmabuf;
+}
+
+static gpointer
+_direct_dma_buf_upload_new (GstGLUpload * upload)
+{
+  struct DmabufUpload *dmabuf = _dma_buf_upload_new (upload);
+  dmabuf->direct = TRUE;
   return dmabuf;
 }
 
+static guint64
+_structure_get_modifier (const GstStructure * s)
+{
+  guint64 modifier;
+
+  if (!gst_structure_get_uint64 (s, "drm-modifier", &modifier))
+    return DRM_FORMAT_MOD_INVALID;
+
+  return modifier;
+}
+
 static GstCaps *
 _dma_buf_upload_transform_caps (gpointer impl, GstGLContext * context,
     GstPadDirection direction, GstCaps * caps)
@@ -514,11 +673,26 @@ _dma_buf_upload_transform_caps (gpointer impl, GstGLContext * context,
 
   if (direction == GST_PAD_SINK) {
     GstCaps *tmp;
+    gint i, n;
 
     ret =
         _set_caps_features_with_passthrough (caps,
         GST_CAPS_FEATURE_MEMORY_GL_MEMORY, passthrough);
 
+    /* tiled layouts can only be imported with all their planes at once
+     * through the direct upload */
+    n = gst_caps_get_size (ret);
+    for (i = n - 1; i >= 0; i--) {
+      GstStructure *s = gst_caps_get_structure (ret, i);
+      guint64 modifier = _structure_get_modifier (s);
+
+      if (modifier != DRM_FORMAT_MOD_INVALID
+          && modifier != DRM_FORMAT_MOD_LINEAR)
+        gst_caps_remove_structure (ret, i);
+      else
+        gst_structure_remove_field (s, "drm-modifier");
+    }
+
     tmp = _caps_intersect_texture_target (ret, 1 << GST_GL_TEXTURE_TARGET_2D);
     gst_caps_unref (ret);
     ret = tmp;
@@ -542,17 +716,96 @@ _dma_buf_upload_transform_caps (gpointer impl, GstGLContext * context,
   return ret;
 }
 
+/* keeps the parts of @caps in the formats the direct upload can import */
+static GstCaps *
+_direct_dma_buf_filter_formats (GstCaps * caps)
+{
+  GstCaps *templ = gst_static_caps_get (&_direct_dma_buf_upload_caps);
+  GstStructure *templ_s = gst_caps_get_structure (templ, 0);
+  GstCaps *ret = gst_caps_new_empty ();
+  gint i, n;
+
+  n = gst_caps_get_size (caps);
+  for (i = 0; i < n; i++) {
+    GstStructure *s;
+
+    s = gst_structure_intersect (gst_caps_get_structure (caps, i), templ_s);
+    if (s)
+      gst_caps_append_structure_full (ret, s,
+          gst_caps_features_copy (gst_caps_get_features (caps, i)));
+  }
+
+  gst_caps_unref (templ);
+
+  return ret;
+}
+
+static GstCaps *
+_direct_dma_buf_upload_transform_caps (gpointer impl, GstGLContext * context,
+    GstPadDirection direction, GstCaps * caps)
+{
+  GstCapsFeatures *passthrough =
+      gst_caps_features_from_string
+      (GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION);
+  GstCaps *ret, *tmp;
+  gint i, n;
+
+  if (direction == GST_PAD_SINK) {
+    tmp = _direct_dma_buf_filter_formats (caps);
+    ret = _set_caps_features_with_passthrough (tmp,
+        GST_CAPS_FEATURE_MEMORY_GL_MEMORY, passthrough);
+    gst_caps_unref (tmp);
+
+    /* the driver samples the image as RGBA */
+    n = gst_caps_get_size (ret);
+    for (i = 0; i < n; i++) {
+      GstStructure *s = gst_caps_get_structure (ret, i);
+
+      gst_structure_remove_fields (s, "drm-modifier", "chroma-site",
+          "colorimetry", NULL);
+      gst_structure_set (s, "format", G_TYPE_STRING, "RGBA", NULL);
+    }
+
+    tmp = _caps_intersect_texture_target (ret,
+        1 << GST_GL_TEXTURE_TARGET_EXTERNAL_OES);
+    gst_caps_unref (ret);
+    ret = tmp;
+  } else {
+    tmp = _set_caps_features_with_passthrough (caps,
+        GST_CAPS_FEATURE_MEMORY_DMABUF, passthrough);
+
+    n = gst_caps_get_size (tmp);
+    for (i = 0; i < n; i++) {
+      GstStructure *s = gst_caps_get_structure (tmp, i);
+
+      gst_structure_remove_fields (s, "texture-target", "format", NULL);
+    }
+
+    ret = _direct_dma_buf_filter_formats (tmp);
+    gst_caps_unref (tmp);
+  }
+
+  gst_caps_features_free (passthrough);
+
+  return ret;
+}
+
 static GQuark
 _eglimage_quark (gint plane)
 {
-  static GQuark quark[4] = { 0 };
+  static GQuark quark[5] = { 0 };
   static const gchar *quark_str[] = {
     "GstGLDMABufEGLImage0",
     "GstGLDMABufEGLImage1",
     "GstGLDMABufEGLImage2",
     "GstGLDMABufEGLImage3",
+    "GstGLDMABufEGLImageDirect",
   };
 
+  /* -1 for the images of the direct upload */
+  if (plane < 0)
+    plane = 4;
+
   if (!quark[plane])
     quark[plane] = g_quark_from_static_string (quark_str[plane]);
 
@@ -585,6 +838,10 @@ _dma_buf_upload_accept (gpointer impl, GstBuffer * buffer, GstCaps * in_caps,
   guint mems_idx[GST_VIDEO_MAX_PLANES];
   gsize mems_skip[GST_VIDEO_MAX_PLANES];
   GstMemory *mems[GST_VIDEO_MAX_PLANES];
+  gint fds[GST_VIDEO_MAX_PLANES];
+  gsize offsets[GST_VIDEO_MAX_PLANES];
+  DmabufCacheKey key;
+  guint64 modifier;
   guint i;
 
   n_mem = gst_buffer_n_memory (buffer);
@@ -607,6 +864,33 @@ _dma_buf_upload_accept (gpointer impl, GstBuffer * buffer, GstCaps * in_caps,
   if (n_mem > n_planes)
     return FALSE;
 
+  modifier = _structure_get_modifier (gst_caps_get_structure (in_caps, 0));
+
+  if (dmabuf->direct) {
+    const gchar *target_str;
+    GstCaps *direct_caps;
+
+    direct_caps = _direct_dma_buf_filter_formats (in_caps);
+    if (gst_caps_is_empty (direct_caps)) {
+      gst_caps_unref (direct_caps);
+      return FALSE;
+    }
+    gst_caps_unref (direct_caps);
+
+    target_str = gst_structure_get_string (gst_caps_get_structure (out_caps,
+            0), "texture-target");
+    if (g_strcmp0 (target_str, GST_GL_TEXTURE_TARGET_EXTERNAL_OES_STR) != 0)
+      return FALSE;
+
+    if (!gst_gl_context_check_feature (dmabuf->upload->context,
+            "GL_OES_EGL_image_external"))
+      return FALSE;
+  } else if (modifier != DRM_FORMAT_MOD_INVALID
+      && modifier != DRM_FORMAT_MOD_LINEAR) {
+    /* the planes of tiled layouts can not be imported separately */
+    return FALSE;
+  }
+
   /* Update video info based on video meta */
   if (meta) {
     in_info->width = meta->width;
@@ -618,12 +902,32 @@ _dma_buf_upload_accept (gpointer impl, GstBuffer * buffer, GstCaps * in_caps,
     }
   }
 
+  if (!dmabuf->cache_caps || !gst_caps_is_equal (dmabuf->cache_caps, in_caps)) {
+    _dmabuf_cache_clear (dmabuf);
+    gst_caps_replace (&dmabuf->cache_caps, in_caps);
+  }
+
   if (dmabuf->params)
     gst_gl_allocation_params_free ((GstGLAllocationParams *) dmabuf->params);
-  if (!(dmabuf->params =
-          gst_gl_video_allocation_params_new_wrapped_gl_handle (dmabuf->
-              upload->context, NULL, &dmabuf->upload->priv->in_info, -1, NULL,
-              GST_GL_TEXTURE_TARGET_2D, 0, NULL, NULL, NULL)))
+  dmabuf->params = NULL;
+
+  if (dmabuf->direct) {
+    GstVideoInfo out_info;
+
+    gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_RGBA,
+        GST_VIDEO_INFO_WIDTH (in_info), GST_VIDEO_INFO_HEIGHT (in_info));
+
+    dmabuf->params =
+        gst_gl_video_allocation_params_new_wrapped_gl_handle (dmabuf->
+        upload->context, NULL, &out_info, -1, NULL,
+        GST_GL_TEXTURE_TARGET_EXTERNAL_OES, 0, NULL, NULL, NULL);
+  } else {
+    dmabuf->params =
+        gst_gl_video_allocation_params_new_wrapped_gl_handle (dmabuf->
+        upload->context, NULL, &dmabuf->upload->priv->in_info, -1, NULL,
+        GST_GL_TEXTURE_TARGET_2D, 0, NULL, NULL, NULL);
+  }
+  if (!dmabuf->params)
     return FALSE;
 
   /* Find and validate all memories */
@@ -646,24 +950,81 @@ _dma_buf_upload_accept (gpointer impl, GstBuffer * buffer, GstCaps * in_caps,
     /* And all memory found must be dmabuf */
     if (!gst_is_dmabuf_memory (mems[i]))
       return FALSE;
+
+    fds[i] = gst_dmabuf_memory_get_fd (mems[i]);
+    offsets[i] = mems[i]->offset + mems_skip[i];
+  }
+
+  memset (&key, 0, sizeof (key));
+  key.modifier = modifier;
+  key.format = GST_VIDEO_INFO_FORMAT (in_info);
+  key.width = GST_VIDEO_INFO_WIDTH (in_info);
+  key.height = GST_VIDEO_INFO_HEIGHT (in_info);
+
+  if (dmabuf->direct) {
+    dmabuf->eglimage[0] = _get_cached_eglimage (mems[0], -1);
+    if (dmabuf->eglimage[0])
+      return TRUE;
+
+    key.plane = -1;
+    for (i = 0; i < n_planes; i++) {
+      if (!_dmabuf_cache_key_fill_plane (&key, i, fds[i], offsets[i],
+              GST_VIDEO_INFO_PLANE_STRIDE (in_info, i)))
+        return FALSE;
+    }
+
+    dmabuf->eglimage[0] = _dmabuf_cache_lookup (dmabuf, &key);
+    if (!dmabuf->eglimage[0]) {
+      dmabuf->eglimage[0] =
+          gst_egl_image_from_dmabuf_direct (dmabuf->upload->context, fds,
+          offsets, in_info, modifier);
+      if (!dmabuf->eglimage[0])
+        return FALSE;
+
+      _dmabuf_cache_insert (dmabuf, &key, dmabuf->eglimage[0]);
+    } else {
+      gst_egl_image_ref (dmabuf->eglimage[0]);
+    }
+
+    /* the memory holds the reference kept for the next frames */
+    _set_cached_eglimage (mems[0], dmabuf->eglimage[0], -1);
+
+    return TRUE;
   }
 
   /* Now create an EGLImage for each dmabufs */
   for (i = 0; i < n_planes; i++) {
-    /* check if one is cached */
+    DmabufCacheKey plane_key;
+
+    /* copied with memcpy to keep the padding zero-filled for the hash */
+    memcpy (&plane_key, &key, sizeof (key));
+
+    /* check if one is cached on the memory */
     dmabuf->eglimage[i] = _get_cached_eglimage (mems[i], i);
     if (dmabuf->eglimage[i])
       continue;
 
-    /* otherwise create one and cache it */
-    dmabuf->eglimage[i] =
-        gst_egl_image_from_dmabuf (dmabuf->upload->context,
-        gst_dmabuf_memory_get_fd (mems[i]), in_info, i,
-        mems[i]->offset + mems_skip[i]);
-
-    if (!dmabuf->eglimage[i])
+    /* or for the same buffer wrapped in another memory */
+    plane_key.plane = i;
+    if (!_dmabuf_cache_key_fill_plane (&plane_key, 0, fds[i], offsets[i],
+            GST_VIDEO_INFO_PLANE_STRIDE (in_info, i)))
       return FALSE;
 
+    dmabuf->eglimage[i] = _dmabuf_cache_lookup (dmabuf, &plane_key);
+    if (dmabuf->eglimage[i]) {
+      gst_egl_image_ref (dmabuf->eglimage[i]);
+    } else {
+      /* otherwise create one and cache it */
+      dmabuf->eglimage[i] =
+          gst_egl_image_from_dmabuf (dmabuf->upload->context, fds[i], in_info,
+          i, offsets[i]);
+
+      if (!dmabuf->eglimage[i])
+        return FALSE;
+
+      _dmabuf_cache_insert (dmabuf, &plane_key, dmabuf->eglimage[i]);
+    }
+
     _set_cached_eglimage (mems[i], dmabuf->eglimage[i], i);
   }
 
@@ -721,6 +1082,10 @@ _dma_buf_upload_free (gpointer impl)
   if (dmabuf->params)
     gst_gl_allocation_params_free ((GstGLAllocationParams *) dmabuf->params);
 
+  _dmabuf_cache_clear (dmabuf);
+  g_hash_table_unref (dmabuf->cache);
+  gst_caps_replace (&dmabuf->cache_caps, NULL);
+
   g_free (impl);
 }
 
@@ -736,6 +1101,20 @@ static const UploadMethod _dma_buf_upload = {
   &_dma_buf_upload_free
 };
 
+/* imports multi-planar YUV dmabufs, possibly tiled, as a single RGBA
+ * external-oes texture and leaves the conversion to the driver */
+static const UploadMethod _direct_dma_buf_upload = {
+  "DirectDmabuf",
+  0,
+  &_direct_dma_buf_upload_caps,
+  &_direct_dma_buf_upload_new,
+  &_direct_dma_buf_upload_transform_caps,
+  &_dma_buf_upload_accept,
+  &_dma_buf_upload_propose_allocation,
+  &_dma_buf_upload_perform,
+  &_dma_buf_upload_free
+};
+
 #endif /* GST_GL_HAVE_DMABUF */
 
 struct GLUploadMeta
@@ -984,17 +1363,54 @@ static const UploadMethod _upload_meta_upload = {
   &_upload_meta_upload_free
 };
 
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+
+/* number of persistently mapped PBOs the raw frames are copied into */
+#define RAW_UPLOAD_N_PBOS 3
+
 struct RawUploadFrame
 {
   gint ref_count;
   GstVideoFrame frame;
 };
 
+struct RawUploadPBO
+{
+  guint id;
+  gpointer data;
+  gsize size;
+  GLsync fence;                 /* signalled when the GPU is done reading */
+};
+
 struct RawUpload
 {
   GstGLUpload *upload;
   struct RawUploadFrame *in_frame;
   GstGLVideoAllocationParams *params;
+
+  /* persistently mapped upload ring */
+  GstGLContext *pbo_context;
+  struct RawUploadPBO pbos[RAW_UPLOAD_N_PBOS];
+  guint next_pbo;
+  GstBuffer *pbo_outbuf;
+  gboolean pbo_result;
 };
 
 static struct RawUploadFrame *
@@ -1130,6 +1546,183 @@ _raw_data_upload_propose_allocation (gpointer impl, GstQuery * decide_query,
   gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, 0);
 }
 
+#define CONTEXT_SUPPORTS_PERSISTENT_PBO(context) \
+    ((context)->gl_vtable->BufferStorage \
+        && (context)->gl_vtable->MapBufferRange \
+        && (context)->gl_vtable->FenceSync \
+        && (context)->gl_vtable->ClientWaitSync \
+        && (gst_gl_context_check_gl_version (context, \
+                GST_GL_API_OPENGL | GST_GL_API_OPENGL3, 2, 1) \
+            || gst_gl_context_check_gl_version (context, GST_GL_API_GLES2, 3, 0)))
+
+static void
+_raw_upload_pbo_clear (GstGLContext * context, struct RawUploadPBO *pbo)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  if (pbo->fence) {
+    gl->DeleteSync (pbo->fence);
+    pbo->fence = NULL;
+  }
+  if (pbo->id) {
+    if (pbo->data) {
+      gl->BindBuffer (GL_PIXEL_UNPACK_BUFFER, pbo->id);
+      gl->UnmapBuffer (GL_PIXEL_UNPACK_BUFFER);
+      gl->BindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    gl->DeleteBuffers (1, &pbo->id);
+  }
+  pbo->id = 0;
+  pbo->data = NULL;
+  pbo->size = 0;
+}
+
+static void
+_raw_upload_pbos_free_gl (GstGLContext * context, struct RawUpload *raw)
+{
+  gint i;
+
+  for (i = 0; i < RAW_UPLOAD_N_PBOS; i++)
+    _raw_upload_pbo_clear (context, &raw->pbos[i]);
+}
+
+/* copies the input frame into the next PBO of the ring and uploads the
+ * textures of raw->pbo_outbuf from it. The copy only waits for the upload
+ * done from the same PBO RAW_UPLOAD_N_PBOS frames ago. */
+static void
+_raw_upload_persistent_gl (GstGLContext * context, struct RawUpload *raw)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  GstVideoInfo *in_info = &raw->upload->priv->in_info;
+  struct RawUploadPBO *pbo = &raw->pbos[raw->next_pbo];
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+      GL_MAP_COHERENT_BIT;
+  guint i, n_mem;
+
+  raw->pbo_result = FALSE;
+
+  if (pbo->fence) {
+    if (gl->ClientWaitSync (pbo->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+            GST_SECOND) == GL_TIMEOUT_EXPIRED)
+      GST_WARNING_OBJECT (raw->upload, "Timed out waiting for upload PBO %u",
+          pbo->id);
+    gl->DeleteSync (pbo->fence);
+    pbo->fence = NULL;
+  }
+
+  if (pbo->size < GST_VIDEO_INFO_SIZE (in_info)) {
+    _raw_upload_pbo_clear (context, pbo);
+
+    gl->GenBuffers (1, &pbo->id);
+    gl->BindBuffer (GL_PIXEL_UNPACK_BUFFER, pbo->id);
+    gl->BufferStorage (GL_PIXEL_UNPACK_BUFFER, GST_VIDEO_INFO_SIZE (in_info),
+        NULL, flags);
+    pbo->data = gl->MapBufferRange (GL_PIXEL_UNPACK_BUFFER, 0,
+        GST_VIDEO_INFO_SIZE (in_info), flags);
+    if (!pbo->data) {
+      GST_WARNING_OBJECT (raw->upload, "Failed to persistently map PBO %u",
+          pbo->id);
+      gl->BindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+      _raw_upload_pbo_clear (context, pbo);
+      return;
+    }
+    pbo->size = GST_VIDEO_INFO_SIZE (in_info);
+    GST_DEBUG_OBJECT (raw->upload, "Created persistently mapped PBO %u of %"
+        G_GSIZE_FORMAT " bytes", pbo->id, pbo->size);
+  } else {
+    gl->BindBuffer (GL_PIXEL_UNPACK_BUFFER, pbo->id);
+  }
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (in_info); i++)
+    memcpy ((guint8 *) pbo->data + GST_VIDEO_INFO_PLANE_OFFSET (in_info, i),
+        raw->in_frame->frame.data[i],
+        gst_gl_get_plane_data_size (in_info, NULL, i));
+
+  n_mem = gst_buffer_n_memory (raw->pbo_outbuf);
+  for (i = 0; i < n_mem; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (raw->pbo_outbuf, i);
+    GstMapInfo map_info;
+
+    if (!gst_memory_map (mem, &map_info, GST_MAP_WRITE | GST_MAP_GL)) {
+      GST_ERROR_OBJECT (raw->upload, "Failed to map texture for writing");
+      gl->BindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+      return;
+    }
+
+    /* the plane data lives at its offset in the bound unpack buffer */
+    GST_MINI_OBJECT_FLAG_SET (mem, GST_GL_BASE_MEMORY_TRANSFER_NEED_UPLOAD);
+    gst_gl_memory_texsubimage ((GstGLMemory *) mem,
+        (gpointer) GST_VIDEO_INFO_PLANE_OFFSET (in_info, i));
+    GST_MINI_OBJECT_FLAG_UNSET (mem, GST_GL_BASE_MEMORY_TRANSFER_NEED_UPLOAD);
+
+    gst_memory_unmap (mem, &map_info);
+  }
+  gl->BindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+
+  pbo->fence = gl->FenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  raw->next_pbo = (raw->next_pbo + 1) % RAW_UPLOAD_N_PBOS;
+  raw->pbo_result = TRUE;
+}
+
+static gboolean
+_raw_data_upload_perform_persistent (struct RawUpload *raw,
+    GstBuffer ** outbuf)
+{
+  GstGLContext *context = raw->upload->context;
+  GstGLBaseMemoryAllocator *allocator;
+  GstVideoInfo *in_info = &raw->upload->priv->in_info;
+  guint i, n_mem = GST_VIDEO_INFO_N_PLANES (in_info);
+
+  if (raw->pbo_context != context) {
+    if (raw->pbo_context) {
+      gst_gl_context_thread_add (raw->pbo_context,
+          (GstGLContextThreadFunc) _raw_upload_pbos_free_gl, raw);
+      gst_object_unref (raw->pbo_context);
+    }
+    raw->pbo_context = gst_object_ref (context);
+    raw->next_pbo = 0;
+  }
+
+  allocator =
+      GST_GL_BASE_MEMORY_ALLOCATOR (gst_gl_memory_allocator_get_default
+      (context));
+
+  *outbuf = gst_buffer_new ();
+  for (i = 0; i < n_mem; i++) {
+    GstGLVideoAllocationParams *params;
+    GstGLBaseMemory *tex;
+
+    params = gst_gl_video_allocation_params_new (context, NULL, in_info, i,
+        NULL, GST_GL_TEXTURE_TARGET_2D,
+        gst_gl_format_from_video_info (context, in_info, i));
+    tex = gst_gl_base_memory_alloc (allocator,
+        (GstGLAllocationParams *) params);
+    gst_gl_allocation_params_free ((GstGLAllocationParams *) params);
+    if (!tex)
+      goto error;
+
+    gst_buffer_append_memory (*outbuf, (GstMemory *) tex);
+  }
+  gst_object_unref (allocator);
+  allocator = NULL;
+
+  raw->pbo_outbuf = *outbuf;
+  gst_gl_context_thread_add (context,
+      (GstGLContextThreadFunc) _raw_upload_persistent_gl, raw);
+  raw->pbo_outbuf = NULL;
+  if (!raw->pbo_result)
+    goto error;
+
+  return TRUE;
+
+error:
+  if (allocator)
+    gst_object_unref (allocator);
+  gst_buffer_unref (*outbuf);
+  *outbuf = NULL;
+  return FALSE;
+}
+
 static GstGLUploadReturn
 _raw_data_upload_perform (gpointer impl, GstBuffer * buffer,
     GstBuffer ** outbuf)
@@ -1144,6 +1737,20 @@ _raw_data_upload_perform (gpointer impl, GstBuffer * buffer,
       GST_GL_BASE_MEMORY_ALLOCATOR (gst_gl_memory_allocator_get_default
       (raw->upload->context));
 
+  /* copy into GPU visible memory right away when possible, so that the
+   * upload does not have to wait for the GPU to be done with the previous
+   * frame */
+  if (CONTEXT_SUPPORTS_PERSISTENT_PBO (raw->upload->context)) {
+    if (_raw_data_upload_perform_persistent (raw, outbuf)) {
+      gst_object_unref (allocator);
+      _raw_upload_frame_unref (raw->in_frame);
+      raw->in_frame = NULL;
+      return GST_GL_UPLOAD_DONE;
+    }
+    GST_DEBUG_OBJECT (raw->upload, "Persistent PBO upload failed, wrapping "
+        "the raw data instead");
+  }
+
   /* FIXME Use a buffer pool to cache the generated textures */
   /* FIXME: multiview support with separated left/right frames? */
   *outbuf = gst_buffer_new ();
@@ -1183,6 +1790,12 @@ _raw_data_upload_free (gpointer impl)
   if (raw->params)
     gst_gl_allocation_params_free ((GstGLAllocationParams *) raw->params);
 
+  if (raw->pbo_context) {
+    gst_gl_context_thread_add (raw->pbo_context,
+        (GstGLContextThreadFunc) _raw_upload_pbos_free_gl, raw);
+    gst_object_unref (raw->pbo_context);
+  }
+
   g_free (raw);
 }
 
@@ -1522,7 +2135,7 @@ static const UploadMethod _directviv_upload = {
 
 static const UploadMethod *upload_methods[] = { &_gl_memory_upload,
 #if GST_GL_HAVE_DMABUF
-  &_dma_buf_upload,
+  &_dma_buf_upload, &_direct_dma_buf_upload,
 #endif
 #if GST_GL_HAVE_VIV_DIRECTVIV
   &_directviv_upload,
@@ -1778,34 +2391,16 @@ _upload_find_method (GstGLUpload * upload)
   return TRUE;
 }
 
-/**
- * gst_gl_upload_perform_with_buffer:
- * @upload: a #GstGLUpload
- * @buffer: input #GstBuffer
- * @outbuf_ptr: resulting #GstBuffer
- *
- * Uploads @buffer using the transformation specified by
- * gst_gl_upload_set_caps() creating a new #GstBuffer in @outbuf_ptr.
- *
- * Returns: whether the upload was successful
- */
-GstGLUploadReturn
-gst_gl_upload_perform_with_buffer (GstGLUpload * upload, GstBuffer * buffer,
-    GstBuffer ** outbuf_ptr)
+static GstGLUploadReturn
+_gst_gl_upload_perform_with_buffer_unlocked (GstGLUpload * upload,
+    GstBuffer * buffer, GstBuffer ** outbuf_ptr)
 {
   GstGLUploadReturn ret = GST_GL_UPLOAD_ERROR;
   GstBuffer *outbuf;
 
-  g_return_val_if_fail (GST_IS_GL_UPLOAD (upload), FALSE);
-  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
-  g_return_val_if_fail (outbuf_ptr != NULL, FALSE);
-
-  GST_OBJECT_LOCK (upload);
-
 #define NEXT_METHOD \
 do { \
   if (!_upload_find_method (upload)) { \
-    GST_OBJECT_UNLOCK (upload); \
     return FALSE; \
   } \
   goto restart; \
@@ -1847,9 +2442,61 @@ restart:
         GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
   *outbuf_ptr = outbuf;
 
-  GST_OBJECT_UNLOCK (upload);
-
   return ret;
 
 #undef NEXT_METHOD
 }
+
+struct PerformWithBuffer
+{
+  GstGLUpload *upload;
+  GstBuffer *buffer;
+  GstBuffer **outbuf_ptr;
+  GstGLUploadReturn ret;
+};
+
+static void
+_perform_with_buffer_gl (GstGLContext * context, struct PerformWithBuffer *data)
+{
+  data->ret = _gst_gl_upload_perform_with_buffer_unlocked (data->upload,
+      data->buffer, data->outbuf_ptr);
+}
+
+/**
+ * gst_gl_upload_perform_with_buffer:
+ * @upload: a #GstGLUpload
+ * @buffer: input #GstBuffer
+ * @outbuf_ptr: resulting #GstBuffer
+ *
+ * Uploads @buffer using the transformation specified by
+ * gst_gl_upload_set_caps() creating a new #GstBuffer in @outbuf_ptr.
+ *
+ * Returns: whether the upload was successful
+ */
+GstGLUploadReturn
+gst_gl_upload_perform_with_buffer (GstGLUpload * upload, GstBuffer * buffer,
+    GstBuffer ** outbuf_ptr)
+{
+  struct PerformWithBuffer data;
+
+  g_return_val_if_fail (GST_IS_GL_UPLOAD (upload), FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (outbuf_ptr != NULL, FALSE);
+
+  data.upload = upload;
+  data.buffer = buffer;
+  data.outbuf_ptr = outbuf_ptr;
+  data.ret = GST_GL_UPLOAD_ERROR;
+
+  GST_OBJECT_LOCK (upload);
+  /* the upload methods make several calls into the GL thread, run them all
+   * from there so that it is only waited for once */
+  if (upload->context)
+    gst_gl_context_thread_add (upload->context,
+        (GstGLContextThreadFunc) _perform_with_buffer_gl, &data);
+  else
+    _perform_with_buffer_gl (NULL, &data);
+  GST_OBJECT_UNLOCK (upload);
+
+  return data.ret;
+}
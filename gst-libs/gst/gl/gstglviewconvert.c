@@ -36,6 +36,7 @@
 #include "gstglviewconvert.h"
 #include "gstglsl_private.h"
 #include "gstglutils_private.h"
+#include "gstglresourcepool_private.h"
 #include <gst/video/gstvideoaffinetransformationmeta.h>
 
 #define USING_OPENGL(context) (gst_gl_context_check_gl_version (context, GST_GL_API_OPENGL, 1, 0))
@@ -91,6 +92,9 @@ struct _GstGLViewConvertPrivate
   GLuint vbo_indices;
   GLuint attr_position;
   GLuint attr_texture;
+
+  /* framebuffers shared with the other users of the context */
+  GstGLResourcePool *resource_pool;
 };
 
 #define GST_GL_VIEW_CONVERT_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
@@ -325,6 +329,11 @@ gst_gl_view_convert_finalize (GObject * object)
   gst_buffer_replace (&viewconvert->priv->primary_out, NULL);
   gst_buffer_replace (&viewconvert->priv->auxilliary_out, NULL);
 
+  if (viewconvert->priv->resource_pool) {
+    gst_gl_resource_pool_unref (viewconvert->priv->resource_pool);
+    viewconvert->priv->resource_pool = NULL;
+  }
+
   if (viewconvert->context) {
     gst_object_unref (viewconvert->context);
     viewconvert->context = NULL;
@@ -367,8 +376,15 @@ gst_gl_view_convert_set_context (GstGLViewConvert * viewconvert,
   g_return_if_fail (GST_IS_GL_VIEW_CONVERT (viewconvert));
 
   if (gst_object_replace ((GstObject **) & viewconvert->context,
-          GST_OBJECT (context)))
+          GST_OBJECT (context))) {
     gst_gl_view_convert_reset (viewconvert);
+
+    /* the pooled framebuffers belong to the previous context */
+    if (viewconvert->priv->resource_pool) {
+      gst_gl_resource_pool_unref (viewconvert->priv->resource_pool);
+      viewconvert->priv->resource_pool = NULL;
+    }
+  }
 }
 
 static gboolean
@@ -1368,7 +1384,8 @@ gst_gl_view_convert_reset (GstGLViewConvert * viewconvert)
   viewconvert->shader = NULL;
 
   if (viewconvert->fbo)
-    gst_object_unref (viewconvert->fbo);
+    gst_gl_resource_pool_release_framebuffer (viewconvert->priv->resource_pool,
+        viewconvert->fbo);
   viewconvert->fbo = NULL;
 
   viewconvert->initted = FALSE;
@@ -1467,8 +1484,12 @@ _init_view_convert_fbo (GstGLViewConvert * viewconvert)
   out_width = GST_VIDEO_INFO_WIDTH (&viewconvert->out_info);
   out_height = GST_VIDEO_INFO_HEIGHT (&viewconvert->out_info);
 
+  if (!viewconvert->priv->resource_pool)
+    viewconvert->priv->resource_pool =
+        gst_gl_resource_pool_get (viewconvert->context);
+
   viewconvert->fbo =
-      gst_gl_framebuffer_new_with_default_depth (viewconvert->context,
+      gst_gl_resource_pool_acquire_framebuffer (viewconvert->priv->resource_pool,
       out_width, out_height);
 
   return viewconvert->fbo != NULL;
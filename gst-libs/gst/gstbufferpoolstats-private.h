@@ -0,0 +1,194 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_BUFFER_POOL_STATS_PRIVATE_H__
+#define __GST_BUFFER_POOL_STATS_PRIVATE_H__
+
+#include <string.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Allocation statistics shared by the buffer pools of the libraries and
+ * plugins. A pool embeds a GstBufferPoolStats, chains its acquire_buffer
+ * through gst_buffer_pool_stats_acquire_buffer(), reports its allocations and
+ * releases, and calls gst_buffer_pool_stats_log() when it stops.
+ *
+ * The statistics are logged as a "buffer-pool-stats" tracer record, enabled
+ * with GST_TRACERS and GST_DEBUG=GST_TRACER:7, so that the records of all
+ * the pools of a pipeline can be aggregated the same way as the ones of the
+ * core tracers. They are also logged in the GST_PERFORMANCE category. */
+typedef struct
+{
+  GMutex lock;
+
+  guint n_allocated;
+  guint n_acquired;
+  guint n_outstanding;
+  guint max_outstanding;
+  /* time acquire was blocked on an exhausted pool */
+  GstClockTime wait_time;
+} GstBufferPoolStats;
+
+static inline void
+gst_buffer_pool_stats_init (GstBufferPoolStats * stats)
+{
+  memset (stats, 0, sizeof (GstBufferPoolStats));
+  g_mutex_init (&stats->lock);
+}
+
+static inline void
+gst_buffer_pool_stats_clear (GstBufferPoolStats * stats)
+{
+  g_mutex_clear (&stats->lock);
+}
+
+/* to be called by alloc_buffer for every new buffer */
+static inline void
+gst_buffer_pool_stats_allocated (GstBufferPoolStats * stats)
+{
+  g_mutex_lock (&stats->lock);
+  stats->n_allocated++;
+  g_mutex_unlock (&stats->lock);
+}
+
+/* to be called by release_buffer */
+static inline void
+gst_buffer_pool_stats_released (GstBufferPoolStats * stats)
+{
+  g_mutex_lock (&stats->lock);
+  if (stats->n_outstanding > 0)
+    stats->n_outstanding--;
+  g_mutex_unlock (&stats->lock);
+}
+
+/* Acquires a buffer through @parent_class. The pool is first tried without
+ * waiting, only the wait for a buffer to be released, when that fails
+ * because the pool is exhausted, counts as wait time. */
+static inline GstFlowReturn
+gst_buffer_pool_stats_acquire_buffer (GstBufferPoolStats * stats,
+    GstBufferPoolClass * parent_class, GstBufferPool * pool,
+    GstBuffer ** buffer, GstBufferPoolAcquireParams * params)
+{
+  GstBufferPoolAcquireParams dontwait = { 0, };
+  GstClockTime wait_time = 0;
+  GstFlowReturn ret;
+
+  if (params)
+    dontwait = *params;
+  dontwait.flags |= GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+
+  ret = parent_class->acquire_buffer (pool, buffer, &dontwait);
+  if (ret == GST_FLOW_EOS &&
+      !(params && (params->flags & GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT))) {
+    GstClockTime start = gst_util_get_timestamp ();
+
+    ret = parent_class->acquire_buffer (pool, buffer, params);
+    wait_time = gst_util_get_timestamp () - start;
+  }
+
+  if (ret == GST_FLOW_OK) {
+    g_mutex_lock (&stats->lock);
+    stats->n_acquired++;
+    stats->n_outstanding++;
+    stats->max_outstanding = MAX (stats->max_outstanding, stats->n_outstanding);
+    stats->wait_time += wait_time;
+    g_mutex_unlock (&stats->lock);
+  }
+
+  return ret;
+}
+
+static inline GstStructure *
+gst_buffer_pool_stats_new_field (GType type, const gchar * description)
+{
+  return gst_structure_new ("value",
+      "type", G_TYPE_GTYPE, type,
+      "description", G_TYPE_STRING, description,
+      "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+      NULL);
+}
+
+static inline GstTracerRecord *
+gst_buffer_pool_stats_get_record (void)
+{
+  static GstTracerRecord *record = NULL;
+
+  if (g_once_init_enter (&record)) {
+    GstTracerRecord *r;
+
+    r = gst_tracer_record_new ("buffer-pool-stats.class",
+        "pool", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+            "type", G_TYPE_GTYPE, G_TYPE_STRING,
+            "description", G_TYPE_STRING, "name of the buffer pool", NULL),
+        "allocated", GST_TYPE_STRUCTURE,
+        gst_buffer_pool_stats_new_field (G_TYPE_UINT,
+            "number of buffers allocated"),
+        "acquired", GST_TYPE_STRUCTURE,
+        gst_buffer_pool_stats_new_field (G_TYPE_UINT,
+            "number of buffers acquired"),
+        "reuse-rate", GST_TYPE_STRUCTURE,
+        gst_buffer_pool_stats_new_field (G_TYPE_DOUBLE,
+            "ratio of the acquired buffers that were not allocated"),
+        "high-water", GST_TYPE_STRUCTURE,
+        gst_buffer_pool_stats_new_field (G_TYPE_UINT,
+            "largest number of buffers acquired at once"),
+        "wait-time", GST_TYPE_STRUCTURE,
+        gst_buffer_pool_stats_new_field (G_TYPE_UINT64,
+            "time spent waiting on the exhausted pool"), NULL);
+    GST_OBJECT_FLAG_SET (r, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+    g_once_init_leave (&record, r);
+  }
+
+  return record;
+}
+
+/* Logs the statistics of @pool and resets them, to be called when the pool
+ * stops */
+static inline void
+gst_buffer_pool_stats_log (GstBufferPoolStats * stats, GstBufferPool * pool)
+{
+  guint n_allocated, n_acquired, max_outstanding;
+  GstClockTime wait_time;
+  gdouble reuse_rate;
+
+  g_mutex_lock (&stats->lock);
+  n_allocated = stats->n_allocated;
+  n_acquired = stats->n_acquired;
+  max_outstanding = stats->max_outstanding;
+  wait_time = stats->wait_time;
+  stats->n_allocated = stats->n_acquired = stats->max_outstanding = 0;
+  stats->wait_time = 0;
+  g_mutex_unlock (&stats->lock);
+
+  reuse_rate = n_acquired == 0 ? 0.0 :
+      1.0 - MIN (n_allocated, n_acquired) / (gdouble) n_acquired;
+
+  GST_CAT_INFO_OBJECT (GST_CAT_PERFORMANCE, pool, "allocated %u, acquired %u, "
+      "reuse-rate %f, high-water %u, wait-time %" GST_TIME_FORMAT,
+      n_allocated, n_acquired, reuse_rate, max_outstanding,
+      GST_TIME_ARGS (wait_time));
+
+  gst_tracer_record_log (gst_buffer_pool_stats_get_record (),
+      GST_OBJECT_NAME (pool), n_allocated, n_acquired, reuse_rate,
+      max_outstanding, wait_time);
+}
+
+G_END_DECLS
+
+#endif /* __GST_BUFFER_POOL_STATS_PRIVATE_H__ */
@@ -37,6 +37,13 @@
  * returns or it could be called later from another thread. The signature of
  * this callback GstInsertBinCallback().
  *
+ * With #GstInsertBin:prepare-elements, added elements are brought up to
+ * their final state and their caps are checked before the data flow is
+ * blocked, so that the stream is only held for the time it takes to relink
+ * the pads. With #GstInsertBin:swap-on-keyframe, the change is delayed until
+ * the next buffer that does not depend on previous ones, so that decoders
+ * downstream never see a stream that starts with a delta unit.
+ *
  * Since: 1.2
  */
 
@@ -75,9 +82,14 @@ enum
 
 static guint signals[LAST_SIGNAL];
 
+#define DEFAULT_PREPARE_ELEMENTS FALSE
+#define DEFAULT_SWAP_ON_KEYFRAME FALSE
+
 enum
 {
   PROP_0,
+  PROP_PREPARE_ELEMENTS,
+  PROP_SWAP_ON_KEYFRAME
 };
 
 struct _GstInsertBinPrivate
@@ -86,6 +98,10 @@ struct _GstInsertBinPrivate
   GstPad *sinkpad;
 
   GQueue change_queue;
+
+  /* protected by the object lock */
+  gboolean prepare_elements;
+  gboolean swap_on_keyframe;
 };
 
 typedef enum
@@ -114,11 +130,17 @@ struct ChangeData
 };
 
 static void gst_insert_bin_dispose (GObject * object);
+static void gst_insert_bin_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_insert_bin_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 
 static void gst_insert_bin_do_change (GstInsertBin * self, GstPad * pad);
 static GstPadProbeReturn pad_blocked_cb (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data);
+static GstPadProbeReturn keyframe_blocked_cb (GstPad * pad,
+    GstPadProbeInfo * info, gpointer user_data);
 
 G_DEFINE_TYPE (GstInsertBin, gst_insert_bin, GST_TYPE_BIN);
 
@@ -141,6 +163,40 @@ gst_insert_bin_class_init (GstInsertBinClass * klass)
       "Olivier Crete <olivier.crete@collabora.com>");
 
   gobject_class->dispose = gst_insert_bin_dispose;
+  gobject_class->set_property = gst_insert_bin_set_property;
+  gobject_class->get_property = gst_insert_bin_get_property;
+
+  /**
+   * GstInsertBin:prepare-elements:
+   *
+   * Bring added elements to the state of the bin (at most PAUSED) and check
+   * that they accept the current caps at the insertion point before
+   * blocking the stream. Elements that fail either step are rejected
+   * without ever interrupting the data flow.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PREPARE_ELEMENTS,
+      g_param_spec_boolean ("prepare-elements", "Prepare elements",
+          "Prepare added elements before blocking the stream",
+          DEFAULT_PREPARE_ELEMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInsertBin:swap-on-keyframe:
+   *
+   * Only perform changes in front of a buffer without the
+   * %GST_BUFFER_FLAG_DELTA_UNIT flag, instead of as soon as the pad is idle.
+   * This only applies to changes that block a source pad, and pending changes
+   * wait as long as no such buffer arrives.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_SWAP_ON_KEYFRAME,
+      g_param_spec_boolean ("swap-on-keyframe", "Swap on keyframe",
+          "Delay changes until the next keyframe",
+          DEFAULT_SWAP_ON_KEYFRAME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   /**
    * GstInsertBin::prepend:
@@ -262,6 +318,11 @@ static void
 gst_insert_bin_change_data_complete (GstInsertBin * self,
     struct ChangeData *data, gboolean success)
 {
+  /* undo gst_insert_bin_prepare_element() for elements that were not added */
+  if (!success && data->action == GST_INSERT_BIN_ACTION_ADD &&
+      GST_OBJECT_PARENT (data->element) == NULL)
+    gst_element_set_state (data->element, GST_STATE_NULL);
+
   if (data->callback)
     data->callback (self, data->element, success, data->user_data);
 
@@ -277,6 +338,8 @@ gst_insert_bin_init (GstInsertBin * self)
       GstInsertBinPrivate);
 
   g_queue_init (&self->priv->change_queue);
+  self->priv->prepare_elements = DEFAULT_PREPARE_ELEMENTS;
+  self->priv->swap_on_keyframe = DEFAULT_SWAP_ON_KEYFRAME;
 
   self->priv->sinkpad = gst_ghost_pad_new_no_target_from_template ("sink",
       gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (self),
@@ -306,6 +369,52 @@ gst_insert_bin_dispose (GObject * object)
   G_OBJECT_CLASS (gst_insert_bin_parent_class)->dispose (object);
 }
 
+static void
+gst_insert_bin_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstInsertBin *self = GST_INSERT_BIN (object);
+
+  switch (prop_id) {
+    case PROP_PREPARE_ELEMENTS:
+      GST_OBJECT_LOCK (self);
+      self->priv->prepare_elements = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SWAP_ON_KEYFRAME:
+      GST_OBJECT_LOCK (self);
+      self->priv->swap_on_keyframe = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_insert_bin_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstInsertBin *self = GST_INSERT_BIN (object);
+
+  switch (prop_id) {
+    case PROP_PREPARE_ELEMENTS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->priv->prepare_elements);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SWAP_ON_KEYFRAME:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->priv->swap_on_keyframe);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 validate_element (GstInsertBin * self, GstElement * element)
 {
@@ -451,6 +560,15 @@ again:
     }
   }
 
+  if (GST_PAD_IS_SRC (pad) && self->priv->swap_on_keyframe) {
+    GST_OBJECT_UNLOCK (self);
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BLOCK |
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        keyframe_blocked_cb, self, NULL);
+    gst_object_unref (pad);
+    return;
+  }
+
   if (GST_PAD_IS_SRC (pad))
     probetype = GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM;
   else
@@ -791,6 +909,77 @@ pad_blocked_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
   return GST_PAD_PROBE_REMOVE;
 }
 
+static GstPadProbeReturn
+keyframe_blocked_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstInsertBin *self = GST_INSERT_BIN (user_data);
+  GstBuffer *buffer;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    buffer = gst_buffer_list_get (GST_PAD_PROBE_INFO_BUFFER_LIST (info), 0);
+  else
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (buffer && GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    return GST_PAD_PROBE_PASS;
+
+  GST_DEBUG_OBJECT (self, "Changing before keyframe %" GST_PTR_FORMAT, buffer);
+  gst_insert_bin_do_change (self, pad);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Called without the object lock. Brings @element to the state it will have
+ * once added, at most PAUSED, and checks that it accepts the caps currently
+ * flowing where it is going to be inserted, so that only the relinking
+ * remains to be done while the stream is blocked. */
+static gboolean
+gst_insert_bin_prepare_element (GstInsertBin * self, GstElement * element,
+    GstElement * sibling, GstInsertBinDirection direction)
+{
+  GstState state;
+  GstPad *pad, *sinkpad;
+  GstCaps *caps = NULL;
+  gboolean ret = TRUE;
+
+  GST_OBJECT_LOCK (self);
+  state = GST_STATE_TARGET (self);
+  GST_OBJECT_UNLOCK (self);
+
+  state = MIN (state, GST_STATE_PAUSED);
+  if (state > GST_STATE_NULL &&
+      gst_element_set_state (element, state) == GST_STATE_CHANGE_FAILURE) {
+    GST_WARNING_OBJECT (self, "Can not prepare %" GST_PTR_FORMAT, element);
+    return FALSE;
+  }
+
+  if (sibling)
+    pad = get_single_pad (sibling, direction == DIRECTION_BEFORE ?
+        GST_PAD_SINK : GST_PAD_SRC);
+  else
+    pad = gst_object_ref (direction == DIRECTION_BEFORE ?
+        self->priv->srcpad : self->priv->sinkpad);
+
+  if (pad) {
+    caps = gst_pad_get_current_caps (pad);
+    gst_object_unref (pad);
+  }
+
+  if (caps) {
+    sinkpad = get_single_pad (element, GST_PAD_SINK);
+    if (sinkpad) {
+      ret = gst_pad_query_accept_caps (sinkpad, caps);
+      gst_object_unref (sinkpad);
+    }
+    if (!ret)
+      GST_WARNING_OBJECT (self, "%" GST_PTR_FORMAT " does not accept %"
+          GST_PTR_FORMAT, element, caps);
+    gst_caps_unref (caps);
+  }
+
+  return ret;
+}
+
 static void
 gst_insert_bin_add_operation (GstInsertBin * self,
     GstElement * element, GstInsertBinAction action, GstElement * sibling,
@@ -824,6 +1013,8 @@ gst_insert_bin_add (GstInsertBin * self, GstElement * element,
     GstElement * sibling, GstInsertBinDirection direction,
     GstInsertBinCallback callback, gpointer user_data)
 {
+  gboolean prepare;
+
   gst_object_ref_sink (element);
 
   if (!validate_element (self, element))
@@ -840,6 +1031,15 @@ gst_insert_bin_add (GstInsertBin * self, GstElement * element,
       goto reject;
   }
 
+  GST_OBJECT_LOCK (self);
+  prepare = self->priv->prepare_elements;
+  GST_OBJECT_UNLOCK (self);
+
+  if (prepare && !gst_insert_bin_prepare_element (self, element, sibling,
+          direction)) {
+    gst_element_set_state (element, GST_STATE_NULL);
+    goto reject;
+  }
 
   gst_insert_bin_add_operation (self, element, GST_INSERT_BIN_ACTION_ADD,
       sibling, direction, callback, user_data);
@@ -50,6 +50,7 @@
 #include "gstopencvvideofilter.h"
 #include "gstopencvutils.h"
 
+#include <opencv2/core/core.hpp>
 #include <opencv2/core/core_c.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_opencv_video_filter_debug);
@@ -64,9 +65,14 @@ enum
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_ASYNC_ANALYSIS,
+  PROP_ANALYSIS_INTERVAL
 };
 
+#define DEFAULT_ASYNC_ANALYSIS FALSE
+#define DEFAULT_ANALYSIS_INTERVAL 0
+
 #define parent_class gst_opencv_video_filter_parent_class
 G_DEFINE_ABSTRACT_TYPE (GstOpencvVideoFilter, gst_opencv_video_filter,
     GST_TYPE_VIDEO_FILTER);
@@ -84,6 +90,10 @@ static GstFlowReturn gst_opencv_video_filter_transform_frame_ip (GstVideoFilter
 static gboolean gst_opencv_video_filter_set_info (GstVideoFilter * trans,
     GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
     GstVideoInfo * out_info);
+static gboolean gst_opencv_video_filter_stop (GstBaseTransform * trans);
+
+static void gst_opencv_video_filter_analyse (gpointer data,
+    gpointer user_data);
 
 /* Clean up */
 static void
@@ -91,10 +101,11 @@ gst_opencv_video_filter_finalize (GObject * obj)
 {
   GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (obj);
 
-  if (transform->cvImage)
-    cvReleaseImage (&transform->cvImage);
-  if (transform->out_cvImage)
-    cvReleaseImage (&transform->out_cvImage);
+  g_thread_pool_free (transform->async_pool, FALSE, TRUE);
+  g_ptr_array_unref (transform->scratch);
+  gst_buffer_replace (&transform->async_result, NULL);
+  g_mutex_clear (&transform->async_lock);
+  g_cond_clear (&transform->async_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -103,9 +114,11 @@ static void
 gst_opencv_video_filter_class_init (GstOpencvVideoFilterClass * klass)
 {
   GObjectClass *gobject_class;
+  GstBaseTransformClass *trans_class;
   GstVideoFilterClass *vfilter_class;
 
   gobject_class = (GObjectClass *) klass;
+  trans_class = (GstBaseTransformClass *) klass;
   vfilter_class = (GstVideoFilterClass *) klass;
 
   GST_DEBUG_CATEGORY_INIT (gst_opencv_video_filter_debug,
@@ -119,11 +132,183 @@ gst_opencv_video_filter_class_init (GstOpencvVideoFilterClass * klass)
   vfilter_class->transform_frame = gst_opencv_video_filter_transform_frame;
   vfilter_class->transform_frame_ip = gst_opencv_video_filter_transform_frame_ip;
   vfilter_class->set_info = gst_opencv_video_filter_set_info;
+  trans_class->stop = gst_opencv_video_filter_stop;
+
+  /**
+   * GstOpencvVideoFilter:async-analysis:
+   *
+   * Pass the frames through untouched and run the analysis on copies of
+   * them in a worker thread. Frames arriving while the worker is busy are
+   * not analysed. The region of interest metas of the last analysed frame
+   * are attached to the following frames; anything drawn on the frames by
+   * the analysis is lost.
+   *
+   * Only applies to filters working in place.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_ANALYSIS,
+      g_param_spec_boolean ("async-analysis", "Asynchronous analysis",
+          "Analyse copies of the frames in a worker thread, skipping frames "
+          "while it is busy", DEFAULT_ASYNC_ANALYSIS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  /**
+   * GstOpencvVideoFilter:analysis-interval:
+   *
+   * Minimum time between the timestamps of two frames analysed
+   * asynchronously.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ANALYSIS_INTERVAL,
+      g_param_spec_uint64 ("analysis-interval", "Analysis interval",
+          "Minimum time between two asynchronously analysed frames "
+          "(0 = as often as possible)", 0, G_MAXUINT64,
+          DEFAULT_ANALYSIS_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+}
+
+static void
+gst_opencv_video_filter_free_scratch (gpointer data)
+{
+  delete (cv::Mat *) data;
 }
 
 static void
 gst_opencv_video_filter_init (GstOpencvVideoFilter * transform)
 {
+  transform->scratch =
+      g_ptr_array_new_with_free_func (gst_opencv_video_filter_free_scratch);
+  transform->async_analysis = DEFAULT_ASYNC_ANALYSIS;
+  transform->analysis_interval = DEFAULT_ANALYSIS_INTERVAL;
+  transform->async_last_pts = GST_CLOCK_TIME_NONE;
+  g_mutex_init (&transform->async_lock);
+  g_cond_init (&transform->async_cond);
+  /* a single worker, frames are skipped rather than queued */
+  transform->async_pool = g_thread_pool_new (gst_opencv_video_filter_analyse,
+      transform, 1, FALSE, NULL);
+}
+
+/* a header over the first plane of @frame, nothing is copied or allocated */
+static inline cv::Mat
+gst_opencv_video_filter_wrap_frame (GstVideoFrame * frame, int cv_type)
+{
+  return cv::Mat (GST_VIDEO_FRAME_HEIGHT (frame), GST_VIDEO_FRAME_WIDTH (frame),
+      cv_type, GST_VIDEO_FRAME_PLANE_DATA (frame, 0),
+      GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0));
+}
+
+static GstFlowReturn
+gst_opencv_video_filter_call_ip (GstOpencvVideoFilter * transform,
+    GstOpencvVideoFilterClass * fclass, GstBuffer * buffer, cv::Mat & img)
+{
+  IplImage iplimg;
+
+  if (fclass->cv_trans_ip_mat_func)
+    return fclass->cv_trans_ip_mat_func (transform, buffer, img);
+
+  /* IplImage headers for the filters not ported to cv::Mat yet */
+  iplimg = img;
+  return fclass->cv_trans_ip_func (transform, buffer, &iplimg);
+}
+
+/* must be called with the async lock */
+static void
+gst_opencv_video_filter_wait_analysis (GstOpencvVideoFilter * transform)
+{
+  while (transform->async_busy)
+    g_cond_wait (&transform->async_cond, &transform->async_lock);
+}
+
+static void
+gst_opencv_video_filter_analyse (gpointer data, gpointer user_data)
+{
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (user_data);
+  GstOpencvVideoFilterClass *fclass =
+      GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
+  GstBuffer *buffer = GST_BUFFER (data);
+  GstVideoFrame frame;
+
+  if (gst_video_frame_map (&frame, &transform->async_info, buffer,
+          GST_MAP_READWRITE)) {
+    cv::Mat img = gst_opencv_video_filter_wrap_frame (&frame,
+        transform->in_cv_type);
+
+    if (gst_opencv_video_filter_call_ip (transform, fclass, buffer,
+            img) != GST_FLOW_OK)
+      GST_WARNING_OBJECT (transform, "asynchronous analysis failed");
+
+    gst_video_frame_unmap (&frame);
+  } else {
+    GST_WARNING_OBJECT (transform, "failed to map frame for analysis");
+  }
+
+  g_mutex_lock (&transform->async_lock);
+  gst_buffer_replace (&transform->async_result, buffer);
+  transform->async_busy = FALSE;
+  g_cond_signal (&transform->async_cond);
+  g_mutex_unlock (&transform->async_lock);
+
+  gst_buffer_unref (buffer);
+}
+
+/* hands a copy of @frame to the worker if it is idle and the interval has
+ * passed, and attaches the results of the last analysis to @frame */
+static GstFlowReturn
+gst_opencv_video_filter_transform_frame_async (GstOpencvVideoFilter *
+    transform, GstVideoFrame * frame)
+{
+  GstClockTime pts = GST_BUFFER_PTS (frame->buffer);
+  GstBuffer *result = NULL;
+
+  g_mutex_lock (&transform->async_lock);
+  if (!transform->async_busy && (!GST_CLOCK_TIME_IS_VALID (pts)
+          || !GST_CLOCK_TIME_IS_VALID (transform->async_last_pts)
+          || pts < transform->async_last_pts
+          || pts - transform->async_last_pts >=
+          transform->analysis_interval)) {
+    GstVideoFrame copy;
+    GstBuffer *buffer;
+
+    /* a copy without the metas of the frame, so that the ones found by
+     * the analysis can be told apart */
+    buffer = gst_buffer_new_allocate (NULL, transform->async_info.size, NULL);
+    gst_buffer_copy_into (buffer, frame->buffer, (GstBufferCopyFlags)
+        (GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS), 0, -1);
+
+    if (gst_video_frame_map (&copy, &transform->async_info, buffer,
+            GST_MAP_WRITE)) {
+      gst_video_frame_copy (&copy, frame);
+      gst_video_frame_unmap (&copy);
+
+      transform->async_busy = TRUE;
+      transform->async_last_pts = pts;
+      g_thread_pool_push (transform->async_pool, buffer, NULL);
+    } else {
+      GST_WARNING_OBJECT (transform, "failed to map frame copy");
+      gst_buffer_unref (buffer);
+    }
+  }
+  if (transform->async_result)
+    result = gst_buffer_ref (transform->async_result);
+  g_mutex_unlock (&transform->async_lock);
+
+  if (result) {
+    gpointer state = NULL;
+    GstMeta *meta;
+
+    while ((meta = gst_buffer_iterate_meta_filtered (result, &state,
+                GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))) {
+      GstVideoRegionOfInterestMeta *roi = (GstVideoRegionOfInterestMeta *) meta;
+
+      gst_buffer_add_video_region_of_interest_meta_id (frame->buffer,
+          roi->roi_type, roi->x, roi->y, roi->w, roi->h);
+    }
+    gst_buffer_unref (result);
+  }
+
+  return GST_FLOW_OK;
 }
 
 static GstFlowReturn
@@ -132,27 +317,27 @@ gst_opencv_video_filter_transform_frame (GstVideoFilter *trans,
 {
   GstOpencvVideoFilter *transform;
   GstOpencvVideoFilterClass *fclass;
-  GstFlowReturn ret;
+  IplImage iplimg, out_iplimg;
 
   transform = GST_OPENCV_VIDEO_FILTER (trans);
   fclass = GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
 
-  g_return_val_if_fail (fclass->cv_trans_func != NULL, GST_FLOW_ERROR);
-  g_return_val_if_fail (transform->cvImage != NULL, GST_FLOW_ERROR);
-  g_return_val_if_fail (transform->out_cvImage != NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (fclass->cv_trans_mat_func != NULL
+      || fclass->cv_trans_func != NULL, GST_FLOW_ERROR);
 
-  transform->cvImage->imageData = (char *) inframe->data[0];
-  transform->cvImage->imageSize = inframe->info.size;
-  transform->cvImage->widthStep = inframe->info.stride[0];
+  cv::Mat img = gst_opencv_video_filter_wrap_frame (inframe,
+      transform->in_cv_type);
+  cv::Mat outimg = gst_opencv_video_filter_wrap_frame (outframe,
+      transform->out_cv_type);
 
-  transform->out_cvImage->imageData = (char *) outframe->data[0];
-  transform->out_cvImage->imageSize = outframe->info.size;
-  transform->out_cvImage->widthStep = outframe->info.stride[0];
+  if (fclass->cv_trans_mat_func)
+    return fclass->cv_trans_mat_func (transform, inframe->buffer, img,
+        outframe->buffer, outimg);
 
-  ret = fclass->cv_trans_func (transform, inframe->buffer, transform->cvImage,
-      outframe->buffer, transform->out_cvImage);
-
-  return ret;
+  iplimg = img;
+  out_iplimg = outimg;
+  return fclass->cv_trans_func (transform, inframe->buffer, &iplimg,
+      outframe->buffer, &out_iplimg);
 }
 
 static GstFlowReturn
@@ -161,21 +346,21 @@ gst_opencv_video_filter_transform_frame_ip (GstVideoFilter * trans,
 {
   GstOpencvVideoFilter *transform;
   GstOpencvVideoFilterClass *fclass;
-  GstFlowReturn ret;
 
   transform = GST_OPENCV_VIDEO_FILTER (trans);
   fclass = GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
 
-  g_return_val_if_fail (fclass->cv_trans_ip_func != NULL, GST_FLOW_ERROR);
-  g_return_val_if_fail (transform->cvImage != NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (fclass->cv_trans_ip_mat_func != NULL
+      || fclass->cv_trans_ip_func != NULL, GST_FLOW_ERROR);
 
-  transform->cvImage->imageData = (char *) frame->data[0];
-  transform->cvImage->imageSize = frame->info.size;
-  transform->cvImage->widthStep = frame->info.stride[0];
+  if (transform->async_analysis)
+    return gst_opencv_video_filter_transform_frame_async (transform, frame);
 
-  ret = fclass->cv_trans_ip_func (transform, frame->buffer, transform->cvImage);
+  cv::Mat img = gst_opencv_video_filter_wrap_frame (frame,
+      transform->in_cv_type);
 
-  return ret;
+  return gst_opencv_video_filter_call_ip (transform, fclass, frame->buffer,
+      img);
 }
 
 static gboolean
@@ -189,11 +374,14 @@ gst_opencv_video_filter_set_info (GstVideoFilter * trans, GstCaps * incaps,
   gint in_depth, in_channels;
   gint out_width, out_height;
   gint out_depth, out_channels;
+  int in_cv_type, out_cv_type;
   GError *in_err = NULL;
   GError *out_err = NULL;
 
   if (!gst_opencv_iplimage_params_from_video_info (in_info, &in_width,
-          &in_height, &in_depth, &in_channels, &in_err)) {
+          &in_height, &in_depth, &in_channels, &in_err) ||
+      !gst_opencv_cv_image_type_from_video_format (GST_VIDEO_INFO_FORMAT
+          (in_info), &in_cv_type, &in_err)) {
     GST_WARNING_OBJECT (transform, "Failed to parse input caps: %s",
         in_err->message);
     g_error_free (in_err);
@@ -201,42 +389,66 @@ gst_opencv_video_filter_set_info (GstVideoFilter * trans, GstCaps * incaps,
   }
 
   if (!gst_opencv_iplimage_params_from_video_info (out_info, &out_width,
-          &out_height, &out_depth, &out_channels, &out_err)) {
+          &out_height, &out_depth, &out_channels, &out_err) ||
+      !gst_opencv_cv_image_type_from_video_format (GST_VIDEO_INFO_FORMAT
+          (out_info), &out_cv_type, &out_err)) {
     GST_WARNING_OBJECT (transform, "Failed to parse output caps: %s",
         out_err->message);
     g_error_free (out_err);
     return FALSE;
   }
 
+  /* the subclass state used by the analysis is about to change */
+  g_mutex_lock (&transform->async_lock);
+  gst_opencv_video_filter_wait_analysis (transform);
+  gst_buffer_replace (&transform->async_result, NULL);
+  transform->async_last_pts = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&transform->async_lock);
+
   if (klass->cv_set_caps) {
     if (!klass->cv_set_caps (transform, in_width, in_height, in_depth,
             in_channels, out_width, out_height, out_depth, out_channels))
       return FALSE;
   }
 
-  if (transform->cvImage) {
-    cvReleaseImage (&transform->cvImage);
-  }
-  if (transform->out_cvImage) {
-    cvReleaseImage (&transform->out_cvImage);
-  }
-
-  transform->cvImage =
-      cvCreateImageHeader (cvSize (in_width, in_height), in_depth, in_channels);
-  transform->out_cvImage =
-      cvCreateImageHeader (cvSize (out_width, out_height), out_depth,
-      out_channels);
+  transform->in_cv_type = in_cv_type;
+  transform->out_cv_type = out_cv_type;
+  transform->async_info = *in_info;
 
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (transform),
       transform->in_place);
   return TRUE;
 }
 
+static gboolean
+gst_opencv_video_filter_stop (GstBaseTransform * trans)
+{
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (trans);
+
+  g_mutex_lock (&transform->async_lock);
+  gst_opencv_video_filter_wait_analysis (transform);
+  gst_buffer_replace (&transform->async_result, NULL);
+  transform->async_last_pts = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&transform->async_lock);
+
+  g_ptr_array_set_size (transform->scratch, 0);
+
+  return TRUE;
+}
+
 static void
 gst_opencv_video_filter_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (object);
+
   switch (prop_id) {
+    case PROP_ASYNC_ANALYSIS:
+      transform->async_analysis = g_value_get_boolean (value);
+      break;
+    case PROP_ANALYSIS_INTERVAL:
+      transform->analysis_interval = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -247,7 +459,15 @@ static void
 gst_opencv_video_filter_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (object);
+
   switch (prop_id) {
+    case PROP_ASYNC_ANALYSIS:
+      g_value_set_boolean (value, transform->async_analysis);
+      break;
+    case PROP_ANALYSIS_INTERVAL:
+      g_value_set_uint64 (value, transform->analysis_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -261,3 +481,37 @@ gst_opencv_video_filter_set_in_place (GstOpencvVideoFilter * transform,
   transform->in_place = ip;
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (transform), ip);
 }
+
+/**
+ * gst_opencv_video_filter_get_scratch:
+ * @transform: a #GstOpencvVideoFilter
+ * @index: the index of the image, chosen by the subclass
+ * @width: the width of the image
+ * @height: the height of the image
+ * @cv_type: the OpenCV type of the image, for example CV_8UC1
+ *
+ * Returns an image for intermediate results, such as a grayscale or
+ * downscaled copy of the frame. The image with a given @index is kept from
+ * frame to frame and only reallocated when its size or type changes, so
+ * no memory is allocated per frame. Its content is undefined.
+ *
+ * The images are released when @transform is stopped.
+ *
+ * Returns: the image, owned by @transform
+ *
+ * Since: 1.14
+ */
+cv::Mat &
+gst_opencv_video_filter_get_scratch (GstOpencvVideoFilter * transform,
+    guint index, gint width, gint height, int cv_type)
+{
+  cv::Mat *mat;
+
+  while (transform->scratch->len <= index)
+    g_ptr_array_add (transform->scratch, new cv::Mat ());
+
+  mat = (cv::Mat *) g_ptr_array_index (transform->scratch, index);
+  mat->create (height, width, cv_type);
+
+  return *mat;
+}
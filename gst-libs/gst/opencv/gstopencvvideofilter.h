@@ -47,10 +47,14 @@
 #include <gst/gst.h>
 #include <gst/video/gstvideofilter.h>
 
-G_BEGIN_DECLS
-
-/* forward declare opencv type to avoid exposing them in this API */
+/* forward declare opencv types to avoid exposing them in this API */
 typedef struct _IplImage IplImage;
+namespace cv
+{
+  class Mat;
+}
+
+G_BEGIN_DECLS
 
 /* #defines don't like whitespacey bits */
 #define GST_TYPE_OPENCV_VIDEO_FILTER \
@@ -76,6 +80,12 @@ typedef GstFlowReturn (*GstOpencvVideoFilterTransformFunc)
     (GstOpencvVideoFilter * transform, GstBuffer * buffer, IplImage * img,
     GstBuffer * outbuf, IplImage * outimg);
 
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformIPMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::Mat & img);
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::Mat & img,
+    GstBuffer * outbuf, cv::Mat & outimg);
+
 typedef gboolean (*GstOpencvVideoFilterSetCaps)
     (GstOpencvVideoFilter * transform, gint in_width, gint in_height,
     gint in_depth, gint in_channels, gint out_width, gint out_height,
@@ -87,8 +97,27 @@ struct _GstOpencvVideoFilter
 
   gboolean in_place;
 
-  IplImage *cvImage;
-  IplImage *out_cvImage;
+  /*< private >*/
+  /* the frames are wrapped in cv::Mat headers over the mapped planes */
+  int in_cv_type;
+  int out_cv_type;
+
+  /* intermediate images reused from frame to frame, see
+   * gst_opencv_video_filter_get_scratch() */
+  GPtrArray *scratch;
+
+  /* asynchronous analysis, running cv_trans_ip_func on copies of the
+   * frames in a worker thread */
+  gboolean async_analysis;
+  GstClockTime analysis_interval;
+
+  GThreadPool *async_pool;
+  GMutex async_lock;
+  GCond async_cond;
+  gboolean async_busy;
+  GstVideoInfo async_info;
+  GstBuffer *async_result;
+  GstClockTime async_last_pts;
 };
 
 struct _GstOpencvVideoFilterClass
@@ -99,6 +128,10 @@ struct _GstOpencvVideoFilterClass
   GstOpencvVideoFilterTransformIPFunc cv_trans_ip_func;
 
   GstOpencvVideoFilterSetCaps cv_set_caps;
+
+  /* used instead of cv_trans_func and cv_trans_ip_func when set */
+  GstOpencvVideoFilterTransformMatFunc cv_trans_mat_func;
+  GstOpencvVideoFilterTransformIPMatFunc cv_trans_ip_mat_func;
 };
 
 GST_EXPORT
@@ -108,6 +141,11 @@ GST_EXPORT
 void gst_opencv_video_filter_set_in_place (GstOpencvVideoFilter * transform,
                                            gboolean ip);
 
+GST_EXPORT
+cv::Mat & gst_opencv_video_filter_get_scratch (GstOpencvVideoFilter * transform,
+                                               guint index, gint width,
+                                               gint height, int cv_type);
+
 G_END_DECLS
 
 #endif /* __GST_OPENCV_VIDEO_FILTER_H__ */
@@ -134,6 +134,7 @@ enum
   SIGNAL_VOLUME_CHANGED,
   SIGNAL_MUTE_CHANGED,
   SIGNAL_SEEK_DONE,
+  SIGNAL_STARTUP_DONE,
   SIGNAL_LAST
 };
 
@@ -186,6 +187,15 @@ struct _GstPlayer
   GstClockTime last_seek_time;  /* Only set from main context */
   GSource *seek_source;
   GstClockTime seek_position;
+  /* Latest values not yet picked up by the dispatched position-updated and
+   * buffering signals, so that only one of each is pending at a time */
+  GstClockTime pending_position;
+  gboolean position_update_pending;
+  gint pending_buffering;
+  gboolean buffering_update_pending;
+  /* Startup timing, only set from main context */
+  GstClockTime startup_start;
+  GstClockTime startup_preroll;
   /* If TRUE, all signals are inhibited except the
    * state-changed:GST_PLAYER_STATE_STOPPED/PAUSED. This ensures that no signal
    * is emitted after gst_player_stop/pause() has been called by the user. */
@@ -292,6 +302,8 @@ gst_player_init (GstPlayer * self)
   self->seek_pending = FALSE;
   self->seek_position = GST_CLOCK_TIME_NONE;
   self->last_seek_time = GST_CLOCK_TIME_NONE;
+  self->startup_start = GST_CLOCK_TIME_NONE;
+  self->startup_preroll = GST_CLOCK_TIME_NONE;
   self->inhibit_sigs = FALSE;
 
   GST_TRACE_OBJECT (self, "Initialized");
@@ -477,6 +489,23 @@ gst_player_class_init (GstPlayerClass * klass)
       G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
       NULL, NULL, G_TYPE_NONE, 1, GST_TYPE_CLOCK_TIME);
 
+  /**
+   * GstPlayer::startup-done:
+   * @player: the #GstPlayer
+   * @preroll_time: time from gst_player_play() until the first frame was
+   *  pre-rolled, or %GST_CLOCK_TIME_NONE for live pipelines
+   * @playing_time: time from gst_player_play() until playback started
+   *
+   * Emitted once per URI when playback starts for the first time, to measure
+   * how long the startup took.
+   *
+   * Since: 1.14
+   */
+  signals[SIGNAL_STARTUP_DONE] =
+      g_signal_new ("startup-done", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, GST_TYPE_CLOCK_TIME, GST_TYPE_CLOCK_TIME);
+
   config_quark_initialize ();
 }
 
@@ -901,20 +930,25 @@ change_state (GstPlayer * self, GstPlayerState state)
 typedef struct
 {
   GstPlayer *player;
-  GstClockTime position;
 } PositionUpdatedSignalData;
 
 static void
 position_updated_dispatch (gpointer user_data)
 {
   PositionUpdatedSignalData *data = user_data;
+  GstClockTime position;
+
+  g_mutex_lock (&data->player->lock);
+  position = data->player->pending_position;
+  data->player->position_update_pending = FALSE;
+  g_mutex_unlock (&data->player->lock);
 
   if (data->player->inhibit_sigs)
     return;
 
   if (data->player->target_state >= GST_STATE_PAUSED) {
     g_signal_emit (data->player, signals[SIGNAL_POSITION_UPDATED], 0,
-        data->position);
+        position);
     g_object_notify_by_pspec (G_OBJECT (data->player),
         param_specs[PROP_POSITION]);
   }
@@ -941,13 +975,24 @@ tick_cb (gpointer user_data)
 
     if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
             signals[SIGNAL_POSITION_UPDATED], 0, NULL, NULL, NULL) != 0) {
-      PositionUpdatedSignalData *data = g_new (PositionUpdatedSignalData, 1);
+      gboolean dispatch;
+
+      /* if the application did not get the previous update yet, it will get
+       * this position instead */
+      g_mutex_lock (&self->lock);
+      self->pending_position = position;
+      dispatch = !self->position_update_pending;
+      self->position_update_pending = TRUE;
+      g_mutex_unlock (&self->lock);
 
-      data->player = g_object_ref (self);
-      data->position = position;
-      gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
-          position_updated_dispatch, data,
-          (GDestroyNotify) position_updated_signal_data_free);
+      if (dispatch) {
+        PositionUpdatedSignalData *data = g_new (PositionUpdatedSignalData, 1);
+
+        data->player = g_object_ref (self);
+        gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+            position_updated_dispatch, data,
+            (GDestroyNotify) position_updated_signal_data_free);
+      }
     }
   }
 
@@ -1095,6 +1140,9 @@ emit_error (GstPlayer * self, GError * err)
   self->seek_position = GST_CLOCK_TIME_NONE;
   self->last_seek_time = GST_CLOCK_TIME_NONE;
   g_mutex_unlock (&self->lock);
+
+  self->startup_start = GST_CLOCK_TIME_NONE;
+  self->startup_preroll = GST_CLOCK_TIME_NONE;
 }
 
 static void
@@ -1268,19 +1316,24 @@ eos_cb (G_GNUC_UNUSED GstBus * bus, G_GNUC_UNUSED GstMessage * msg,
 typedef struct
 {
   GstPlayer *player;
-  gint percent;
 } BufferingSignalData;
 
 static void
 buffering_dispatch (gpointer user_data)
 {
   BufferingSignalData *data = user_data;
+  gint percent;
+
+  g_mutex_lock (&data->player->lock);
+  percent = data->player->pending_buffering;
+  data->player->buffering_update_pending = FALSE;
+  g_mutex_unlock (&data->player->lock);
 
   if (data->player->inhibit_sigs)
     return;
 
   if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0, data->percent);
+    g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0, percent);
   }
 }
 
@@ -1323,16 +1376,27 @@ buffering_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg, gpointer user_data)
   if (self->buffering != percent) {
     if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
             signals[SIGNAL_BUFFERING], 0, NULL, NULL, NULL) != 0) {
-      BufferingSignalData *data = g_new (BufferingSignalData, 1);
+      gboolean dispatch;
+
+      /* buffering messages can arrive faster than the application handles
+       * them, only the latest percentage matters */
+      g_mutex_lock (&self->lock);
+      self->pending_buffering = percent;
+      dispatch = !self->buffering_update_pending;
+      self->buffering_update_pending = TRUE;
+      g_mutex_unlock (&self->lock);
+
+      if (dispatch) {
+        BufferingSignalData *data = g_new (BufferingSignalData, 1);
 
-      data->player = g_object_ref (self);
-      data->percent = percent;
-      gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
-          buffering_dispatch, data,
-          (GDestroyNotify) buffering_signal_data_free);
+        data->player = g_object_ref (self);
+        gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+            buffering_dispatch, data,
+            (GDestroyNotify) buffering_signal_data_free);
+      }
     }
 
-    self->buffering = percent;
+    g_atomic_int_set (&self->buffering, percent);
   }
 
 
@@ -1558,6 +1622,61 @@ emit_seek_done (GstPlayer * self)
   }
 }
 
+typedef struct
+{
+  GstPlayer *player;
+  GstClockTime preroll_time;
+  GstClockTime playing_time;
+} StartupDoneSignalData;
+
+static void
+startup_done_dispatch (gpointer user_data)
+{
+  StartupDoneSignalData *data = user_data;
+
+  if (data->player->inhibit_sigs)
+    return;
+
+  g_signal_emit (data->player, signals[SIGNAL_STARTUP_DONE], 0,
+      data->preroll_time, data->playing_time);
+}
+
+static void
+startup_done_signal_data_free (StartupDoneSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+emit_startup_done (GstPlayer * self)
+{
+  GstClockTime playing_time;
+
+  if (!GST_CLOCK_TIME_IS_VALID (self->startup_start))
+    return;
+
+  playing_time = gst_util_get_timestamp () - self->startup_start;
+  GST_DEBUG_OBJECT (self, "Startup took %" GST_TIME_FORMAT " (pre-rolled "
+      "after %" GST_TIME_FORMAT ")", GST_TIME_ARGS (playing_time),
+      GST_TIME_ARGS (self->startup_preroll));
+
+  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_STARTUP_DONE], 0, NULL, NULL, NULL) != 0) {
+    StartupDoneSignalData *data = g_new (StartupDoneSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->preroll_time = self->startup_preroll;
+    data->playing_time = playing_time;
+    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+        startup_done_dispatch, data,
+        (GDestroyNotify) startup_done_signal_data_free);
+  }
+
+  self->startup_start = GST_CLOCK_TIME_NONE;
+  self->startup_preroll = GST_CLOCK_TIME_NONE;
+}
+
 static void
 state_changed_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg,
     gpointer user_data)
@@ -1591,6 +1710,9 @@ state_changed_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg,
 
       GST_DEBUG_OBJECT (self, "Initial PAUSED - pre-rolled");
 
+      if (GST_CLOCK_TIME_IS_VALID (self->startup_start))
+        self->startup_preroll = gst_util_get_timestamp () - self->startup_start;
+
       g_mutex_lock (&self->lock);
       if (self->media_info)
         g_object_unref (self->media_info);
@@ -1677,6 +1799,8 @@ state_changed_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg,
         add_tick_source (self);
         change_state (self, GST_PLAYER_STATE_PLAYING);
       }
+
+      emit_startup_done (self);
     } else if (new_state == GST_STATE_READY && old_state > GST_STATE_READY) {
       change_state (self, GST_PLAYER_STATE_STOPPED);
     } else {
@@ -3062,8 +3186,11 @@ gst_player_play_internal (gpointer user_data)
   remove_ready_timeout_source (self);
   self->target_state = GST_STATE_PLAYING;
 
-  if (self->current_state < GST_STATE_PAUSED)
+  if (self->current_state < GST_STATE_PAUSED) {
+    if (!GST_CLOCK_TIME_IS_VALID (self->startup_start))
+      self->startup_start = gst_util_get_timestamp ();
     change_state (self, GST_PLAYER_STATE_BUFFERING);
+  }
 
   if (self->current_state >= GST_STATE_PAUSED && !self->is_eos
       && self->buffering >= 100 && !(self->seek_position != GST_CLOCK_TIME_NONE
@@ -3218,6 +3345,8 @@ gst_player_stop_internal (GstPlayer * self, gboolean transient)
       GST_PLAYER_STATE_STOPPED);
   self->buffering = 100;
   self->cached_duration = GST_CLOCK_TIME_NONE;
+  self->startup_start = GST_CLOCK_TIME_NONE;
+  self->startup_preroll = GST_CLOCK_TIME_NONE;
   g_mutex_lock (&self->lock);
   if (self->media_info) {
     g_object_unref (self->media_info);
@@ -3554,6 +3683,26 @@ gst_player_get_position (GstPlayer * self)
   return val;
 }
 
+/**
+ * gst_player_get_buffering_percent:
+ * @player: #GstPlayer instance
+ *
+ * Retrieves the latest buffering level without waiting for the
+ * #GstPlayer::buffering signal. This is cheap enough to be polled from a user
+ * interface at a fixed rate.
+ *
+ * Returns: the buffering percentage, 100 if the player is not buffering
+ *
+ * Since: 1.14
+ */
+gint
+gst_player_get_buffering_percent (GstPlayer * self)
+{
+  g_return_val_if_fail (GST_IS_PLAYER (self), 100);
+
+  return g_atomic_int_get (&self->buffering);
+}
+
 /**
  * gst_player_get_duration:
  * @player: #GstPlayer instance
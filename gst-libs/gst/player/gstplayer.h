@@ -150,6 +150,9 @@ GstClockTime gst_player_get_position                  (GstPlayer    * player);
 GST_EXPORT
 GstClockTime gst_player_get_duration                  (GstPlayer    * player);
 
+GST_EXPORT
+gint         gst_player_get_buffering_percent         (GstPlayer    * player);
+
 GST_EXPORT
 gdouble      gst_player_get_volume                    (GstPlayer    * player);
 
@@ -0,0 +1,336 @@
+/* GStreamer
+ *
+ * gstfragmentcache.c:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A process-wide cache of downloaded fragments, keyed on their URI and byte
+ * range, so that several demuxers playing the same presentation only fetch
+ * each fragment once. Entries are evicted least recently used first when the
+ * size limit is reached. Pinned ones (e.g. initialization segments) are only
+ * evicted when nothing else is left, and can't take more than a quarter of
+ * the cache. The cache is as large as the largest size requested by its
+ * users, and is cleared when the last of them goes away. */
+
+#include <glib.h>
+#include "gstfragmentcache.h"
+#include "gsturidownloader.h"
+#include "gsturidownloader_debug.h"
+
+#define GST_CAT_DEFAULT uridownloader_debug
+
+typedef struct _GstFragmentCacheEntry
+{
+  gchar *key;
+  GstBuffer *buffer;
+  gsize size;
+  gboolean pinned;
+  GList link;                   /* in the LRU queue, most recent first */
+} GstFragmentCacheEntry;
+
+static GMutex cache_lock;
+static GHashTable *cache_entries;       /* key -> GstFragmentCacheEntry */
+static GQueue cache_lru = G_QUEUE_INIT;
+static guint64 cache_size;
+static guint64 cache_pinned_size;
+static guint64 cache_max_size;
+/* the max sizes requested by the users of the cache */
+static GArray *cache_users;
+
+#define PINNED_MAX_SIZE(max_size) ((max_size) / 4)
+
+static gchar *
+gst_fragment_cache_make_key (const gchar * uri, gint64 range_start,
+    gint64 range_end)
+{
+  return g_strdup_printf ("%" G_GINT64_FORMAT "-%" G_GINT64_FORMAT " %s",
+      range_start, range_end, uri);
+}
+
+static void
+gst_fragment_cache_entry_free (GstFragmentCacheEntry * entry)
+{
+  gst_buffer_unref (entry->buffer);
+  g_free (entry->key);
+  g_slice_free (GstFragmentCacheEntry, entry);
+}
+
+/* must be called with cache_lock taken */
+static void
+gst_fragment_cache_remove_entry (GstFragmentCacheEntry * entry)
+{
+  g_queue_unlink (&cache_lru, &entry->link);
+  cache_size -= entry->size;
+  if (entry->pinned)
+    cache_pinned_size -= entry->size;
+  /* frees the entry */
+  g_hash_table_remove (cache_entries, entry->key);
+}
+
+/* must be called with cache_lock taken.
+ * Evicts entries least recently used first until @size more bytes fit in
+ * @max_size bytes. With @pinned_only, only the pinned entries are counted
+ * and evicted, with @keep_pinned only the unpinned ones are evicted. */
+static void
+gst_fragment_cache_evict (guint64 size, guint64 max_size,
+    gboolean pinned_only, gboolean keep_pinned)
+{
+  GList *iter, *prev;
+
+  for (iter = cache_lru.tail; iter; iter = prev) {
+    GstFragmentCacheEntry *entry = iter->data;
+
+    if ((pinned_only ? cache_pinned_size : cache_size) + size <= max_size)
+      break;
+
+    prev = iter->prev;
+    if ((pinned_only && !entry->pinned) || (keep_pinned && entry->pinned))
+      continue;
+
+    GST_LOG ("Evicting %s from the fragment cache", entry->key);
+    gst_fragment_cache_remove_entry (entry);
+  }
+}
+
+/* must be called with cache_lock taken.
+ * Makes @size more bytes fit in the cache, and in the part for pinned
+ * entries if @pinned is set */
+static gboolean
+gst_fragment_cache_make_room (guint64 size, gboolean pinned)
+{
+  if (size > cache_max_size)
+    return FALSE;
+
+  if (pinned) {
+    if (size > PINNED_MAX_SIZE (cache_max_size))
+      return FALSE;
+    gst_fragment_cache_evict (size, PINNED_MAX_SIZE (cache_max_size), TRUE,
+        FALSE);
+  }
+
+  /* pinned entries only go once all the others are gone */
+  gst_fragment_cache_evict (size, cache_max_size, FALSE, TRUE);
+  gst_fragment_cache_evict (size, cache_max_size, FALSE, FALSE);
+
+  return cache_size + size <= cache_max_size;
+}
+
+/* must be called with cache_lock taken.
+ * Sets the size of the cache to the largest one requested by its users,
+ * evicting entries as needed */
+static void
+gst_fragment_cache_update_max_size (void)
+{
+  guint64 max_size = 0;
+  guint i;
+
+  for (i = 0; i < cache_users->len; i++)
+    max_size = MAX (max_size, g_array_index (cache_users, guint64, i));
+
+  if (max_size == cache_max_size)
+    return;
+
+  GST_DEBUG ("Fragment cache size set to %" G_GUINT64_FORMAT " bytes",
+      max_size);
+  cache_max_size = max_size;
+
+  /* with no users left, this clears the cache */
+  gst_fragment_cache_evict (0, PINNED_MAX_SIZE (cache_max_size), TRUE, FALSE);
+  gst_fragment_cache_evict (0, cache_max_size, FALSE, TRUE);
+  gst_fragment_cache_evict (0, cache_max_size, FALSE, FALSE);
+}
+
+/**
+ * gst_fragment_cache_add_user:
+ * @max_size: the size in bytes the cache should be able to hold
+ *
+ * Registers a user of the fragment cache, which needs it to hold at least
+ * @max_size bytes. The cache is shared by the whole process, so its size is
+ * the largest one requested by any of its users. Every call must be
+ * matched by a call to gst_fragment_cache_remove_user() with the same
+ * @max_size.
+ */
+void
+gst_fragment_cache_add_user (guint64 max_size)
+{
+  g_return_if_fail (max_size > 0);
+
+  /* makes sure the debug category is registered */
+  g_type_ensure (GST_TYPE_URI_DOWNLOADER);
+
+  g_mutex_lock (&cache_lock);
+  if (cache_entries == NULL) {
+    cache_entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+        (GDestroyNotify) gst_fragment_cache_entry_free);
+    cache_users = g_array_new (FALSE, FALSE, sizeof (guint64));
+  }
+  g_array_append_val (cache_users, max_size);
+  gst_fragment_cache_update_max_size ();
+  g_mutex_unlock (&cache_lock);
+}
+
+/**
+ * gst_fragment_cache_remove_user:
+ * @max_size: the size passed to gst_fragment_cache_add_user()
+ *
+ * Unregisters a user of the fragment cache. The cache shrinks to the size
+ * needed by the remaining users, and is cleared if there are none left.
+ */
+void
+gst_fragment_cache_remove_user (guint64 max_size)
+{
+  guint i;
+
+  g_mutex_lock (&cache_lock);
+  for (i = 0; cache_users && i < cache_users->len; i++) {
+    if (g_array_index (cache_users, guint64, i) == max_size) {
+      g_array_remove_index_fast (cache_users, i);
+      gst_fragment_cache_update_max_size ();
+      g_mutex_unlock (&cache_lock);
+      return;
+    }
+  }
+  g_mutex_unlock (&cache_lock);
+
+  g_critical ("No fragment cache user with a size of %" G_GUINT64_FORMAT,
+      max_size);
+}
+
+/**
+ * gst_fragment_cache_get_max_size:
+ *
+ * Returns: the size in bytes the fragment cache can hold, 0 if it is not
+ * enabled.
+ */
+guint64
+gst_fragment_cache_get_max_size (void)
+{
+  guint64 max_size;
+
+  g_mutex_lock (&cache_lock);
+  max_size = cache_max_size;
+  g_mutex_unlock (&cache_lock);
+
+  return max_size;
+}
+
+/**
+ * gst_fragment_cache_lookup:
+ * @uri: the uri
+ * @range_start: the starting byte index
+ * @range_end: the final byte index, -1 for unspecified
+ *
+ * Returns: (transfer full) (nullable): the data previously stored for this
+ * @uri and range, or %NULL if it is not in the cache. The buffer is shared
+ * with the cache and must not be modified.
+ */
+GstBuffer *
+gst_fragment_cache_lookup (const gchar * uri, gint64 range_start,
+    gint64 range_end)
+{
+  GstFragmentCacheEntry *entry = NULL;
+  GstBuffer *buffer = NULL;
+  gchar *key;
+
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  g_mutex_lock (&cache_lock);
+  if (cache_entries != NULL) {
+    key = gst_fragment_cache_make_key (uri, range_start, range_end);
+    entry = g_hash_table_lookup (cache_entries, key);
+    g_free (key);
+  }
+
+  if (entry) {
+    g_queue_unlink (&cache_lru, &entry->link);
+    g_queue_push_head_link (&cache_lru, &entry->link);
+    buffer = gst_buffer_ref (entry->buffer);
+    GST_LOG ("Fragment cache hit for %s", entry->key);
+  }
+  g_mutex_unlock (&cache_lock);
+
+  return buffer;
+}
+
+/**
+ * gst_fragment_cache_insert:
+ * @uri: the uri
+ * @range_start: the starting byte index
+ * @range_end: the final byte index, -1 for unspecified
+ * @buffer: the downloaded data
+ * @pinned: whether the entry should be kept over unpinned ones
+ *
+ * Stores the data downloaded for @uri and range in the cache, evicting the
+ * least recently used entries if needed. Pinned entries are only evicted
+ * when there are no other entries left, or to keep them within a quarter
+ * of the cache. Does nothing if the cache is not enabled or the data does
+ * not fit in it.
+ */
+void
+gst_fragment_cache_insert (const gchar * uri, gint64 range_start,
+    gint64 range_end, GstBuffer * buffer, gboolean pinned)
+{
+  GstFragmentCacheEntry *entry;
+  gchar *key;
+  gsize size;
+
+  g_return_if_fail (uri != NULL);
+  g_return_if_fail (GST_IS_BUFFER (buffer));
+
+  size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&cache_lock);
+  if (cache_entries == NULL || cache_max_size == 0)
+    goto done;
+
+  key = gst_fragment_cache_make_key (uri, range_start, range_end);
+  entry = g_hash_table_lookup (cache_entries, key);
+  if (entry) {
+    /* keep the pinning of the previous entry */
+    pinned |= entry->pinned;
+    gst_fragment_cache_remove_entry (entry);
+  }
+
+  /* without room among the pinned entries, cache it like any other */
+  if (pinned && !gst_fragment_cache_make_room (size, TRUE))
+    pinned = FALSE;
+
+  if (!pinned && !gst_fragment_cache_make_room (size, FALSE)) {
+    GST_DEBUG ("No room for %" G_GSIZE_FORMAT " bytes of %s in the fragment"
+        " cache", size, key);
+    g_free (key);
+    goto done;
+  }
+
+  entry = g_slice_new0 (GstFragmentCacheEntry);
+  entry->key = key;
+  entry->buffer = gst_buffer_ref (buffer);
+  entry->size = size;
+  entry->pinned = pinned;
+  entry->link.data = entry;
+  g_hash_table_insert (cache_entries, entry->key, entry);
+  g_queue_push_head_link (&cache_lru, &entry->link);
+  cache_size += size;
+  if (pinned)
+    cache_pinned_size += size;
+
+  GST_LOG ("Cached %" G_GSIZE_FORMAT " bytes of %s%s, %" G_GUINT64_FORMAT
+      " bytes in use", size, key, pinned ? " (pinned)" : "", cache_size);
+
+done:
+  g_mutex_unlock (&cache_lock);
+}
@@ -0,0 +1,44 @@
+/* GStreamer
+ *
+ * gstfragmentcache.h:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_FRAGMENT_CACHE_H__
+#define __GST_FRAGMENT_CACHE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+GST_EXPORT
+void gst_fragment_cache_add_user (guint64 max_size);
+
+GST_EXPORT
+void gst_fragment_cache_remove_user (guint64 max_size);
+
+GST_EXPORT
+guint64 gst_fragment_cache_get_max_size (void);
+
+GST_EXPORT
+GstBuffer * gst_fragment_cache_lookup (const gchar * uri, gint64 range_start, gint64 range_end);
+
+GST_EXPORT
+void gst_fragment_cache_insert (const gchar * uri, gint64 range_start, gint64 range_end, GstBuffer * buffer, gboolean pinned);
+
+G_END_DECLS
+#endif /* __GST_FRAGMENT_CACHE_H__ */
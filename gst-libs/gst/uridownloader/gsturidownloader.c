@@ -21,6 +21,7 @@
 
 #include <glib.h>
 #include "gstfragment.h"
+#include "gstfragmentcache.h"
 #include "gsturidownloader.h"
 #include "gsturidownloader_debug.h"
 
@@ -31,6 +32,10 @@ GST_DEBUG_CATEGORY (uridownloader_debug);
    (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
     GST_TYPE_URI_DOWNLOADER, GstUriDownloaderPrivate))
 
+/* number of idle downloaders, and so source elements, kept around per host
+ * for asynchronous requests */
+#define MAX_IDLE_WORKERS_PER_HOST 2
+
 struct _GstUriDownloaderPrivate
 {
   /* Fragments fetcher */
@@ -48,8 +53,40 @@ struct _GstUriDownloaderPrivate
 
   GCond cond;
   gboolean cancelled;
+
+  /* look fragments up in and add them to the shared fragment cache */
+  gboolean use_cache;
+
+  /* asynchronous requests */
+  GMutex async_lock;
+  GList *requests;              /* protected by async_lock */
+  GHashTable *idle_workers;     /* host -> GQueue of GstUriDownloader,
+                                 * protected by async_lock */
+  guint next_request_id;        /* protected by async_lock */
 };
 
+typedef struct _GstUriDownloaderRequest
+{
+  GstUriDownloader *downloader;
+  guint id;
+
+  gchar *uri;
+  gchar *referer;
+  gboolean compress;
+  gboolean refresh;
+  gboolean allow_cache;
+  gint64 range_start;
+  gint64 range_end;
+
+  GstUriDownloaderCallback callback;
+  gpointer user_data;
+  GDestroyNotify notify;
+
+  /* protected by the downloader's async_lock */
+  GstUriDownloader *worker;
+  gboolean cancelled;
+} GstUriDownloaderRequest;
+
 static void gst_uri_downloader_finalize (GObject * object);
 static void gst_uri_downloader_dispose (GObject * object);
 
@@ -63,6 +100,9 @@ static GstBusSyncReply gst_uri_downloader_bus_handler (GstBus * bus,
 static gboolean gst_uri_downloader_ensure_src (GstUriDownloader * downloader,
     const gchar * uri);
 static void gst_uri_downloader_destroy_src (GstUriDownloader * downloader);
+static void gst_uri_downloader_free_workers (GQueue * workers);
+static void gst_uri_downloader_request_cancel (GstUriDownloaderRequest *
+    request);
 
 static GstStaticPadTemplate sinkpadtemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -111,6 +151,11 @@ gst_uri_downloader_init (GstUriDownloader * downloader)
 
   g_mutex_init (&downloader->priv->download_lock);
   g_cond_init (&downloader->priv->cond);
+
+  g_mutex_init (&downloader->priv->async_lock);
+  downloader->priv->idle_workers =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_uri_downloader_free_workers);
 }
 
 static void
@@ -137,6 +182,9 @@ gst_uri_downloader_dispose (GObject * object)
 
   g_weak_ref_clear (&downloader->priv->parent);
 
+  /* requests keep a reference, so none is in progress at this point */
+  g_hash_table_remove_all (downloader->priv->idle_workers);
+
   G_OBJECT_CLASS (gst_uri_downloader_parent_class)->dispose (object);
 }
 
@@ -147,6 +195,8 @@ gst_uri_downloader_finalize (GObject * object)
 
   g_mutex_clear (&downloader->priv->download_lock);
   g_cond_clear (&downloader->priv->cond);
+  g_mutex_clear (&downloader->priv->async_lock);
+  g_hash_table_unref (downloader->priv->idle_workers);
 
   G_OBJECT_CLASS (gst_uri_downloader_parent_class)->finalize (object);
 }
@@ -178,6 +228,26 @@ gst_uri_downloader_set_parent (GstUriDownloader * downloader,
   g_weak_ref_set (&downloader->priv->parent, parent);
 }
 
+/**
+ * gst_uri_downloader_set_use_cache:
+ * @downloader: the #GstUriDownloader
+ * @use_cache: whether to use the fragment cache
+ *
+ * Makes gst_uri_downloader_fetch_uri_with_range() serve requests from the
+ * process-wide fragment cache when possible, and store what it downloads
+ * in it. Requests with @refresh set or @allow_cache unset always go to the
+ * network. The cache has to be enabled with
+ * gst_fragment_cache_add_user() for this to have any effect.
+ */
+void
+gst_uri_downloader_set_use_cache (GstUriDownloader * downloader,
+    gboolean use_cache)
+{
+  GST_OBJECT_LOCK (downloader);
+  downloader->priv->use_cache = use_cache;
+  GST_OBJECT_UNLOCK (downloader);
+}
+
 static gboolean
 gst_uri_downloader_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event)
@@ -380,6 +450,11 @@ gst_uri_downloader_cancel (GstUriDownloader * downloader)
           "Trying to cancel a download that was alredy cancelled");
   }
   GST_OBJECT_UNLOCK (downloader);
+
+  g_mutex_lock (&downloader->priv->async_lock);
+  g_list_foreach (downloader->priv->requests,
+      (GFunc) gst_uri_downloader_request_cancel, NULL);
+  g_mutex_unlock (&downloader->priv->async_lock);
 }
 
 static gboolean
@@ -560,6 +635,7 @@ gst_uri_downloader_fetch_uri_with_range (GstUriDownloader *
 {
   GstStateChangeReturn ret;
   GstFragment *download = NULL;
+  gboolean cache = FALSE;
 
   GST_DEBUG_OBJECT (downloader, "Fetching URI %s", uri);
 
@@ -573,6 +649,28 @@ gst_uri_downloader_fetch_uri_with_range (GstUriDownloader *
     goto quit;
   }
 
+  /* HEAD requests have no data to cache */
+  if (downloader->priv->use_cache && !refresh && allow_cache
+      && (range_start >= 0 || range_end >= 0)) {
+    GstBuffer *buffer = gst_fragment_cache_lookup (uri, range_start,
+        range_end);
+
+    if (buffer) {
+      GST_DEBUG_OBJECT (downloader, "Got URI %s from the fragment cache", uri);
+      download = gst_fragment_new ();
+      download->uri = g_strdup (uri);
+      download->range_start = range_start;
+      download->range_end = range_end;
+      gst_fragment_add_buffer (download, buffer);
+      download->completed = TRUE;
+      download->download_stop_time = download->download_start_time;
+      GST_OBJECT_UNLOCK (downloader);
+      g_mutex_unlock (&downloader->priv->download_lock);
+      return download;
+    }
+    cache = TRUE;
+  }
+
   if (!gst_uri_downloader_set_uri (downloader, uri, referer, compress, refresh,
           allow_cache)) {
     GST_WARNING_OBJECT (downloader, "Failed to set URI");
@@ -655,9 +753,17 @@ gst_uri_downloader_fetch_uri_with_range (GstUriDownloader *
     }
   }
 
-  if (download != NULL)
+  if (download != NULL) {
     GST_INFO_OBJECT (downloader, "URI fetched successfully");
-  else
+    if (cache) {
+      GstBuffer *buffer = gst_fragment_get_buffer (download);
+
+      if (buffer) {
+        gst_fragment_cache_insert (uri, range_start, range_end, buffer, FALSE);
+        gst_buffer_unref (buffer);
+      }
+    }
+  } else
     GST_INFO_OBJECT (downloader, "Error fetching URI");
 
 quit:
@@ -721,3 +827,238 @@ quit:
     return download;
   }
 }
+
+static void
+gst_uri_downloader_free_workers (GQueue * workers)
+{
+  g_queue_free_full (workers, (GDestroyNotify) gst_object_unref);
+}
+
+/* requests to the same scheme, host and port can share a source element,
+ * and so its connection */
+static gchar *
+gst_uri_downloader_get_host (const gchar * uri)
+{
+  GstUri *gsturi;
+  gchar *host;
+
+  gsturi = gst_uri_from_string (uri);
+  if (gsturi == NULL)
+    return g_strdup ("");
+
+  host = g_strdup_printf ("%s://%s:%u", GST_STR_NULL (gst_uri_get_scheme
+          (gsturi)), GST_STR_NULL (gst_uri_get_host (gsturi)),
+      gst_uri_get_port (gsturi));
+  gst_uri_unref (gsturi);
+
+  return host;
+}
+
+/* must be called with the downloader's async_lock taken */
+static void
+gst_uri_downloader_request_cancel (GstUriDownloaderRequest * request)
+{
+  GST_DEBUG_OBJECT (request->downloader, "Cancelling request %u for %s",
+      request->id, request->uri);
+
+  request->cancelled = TRUE;
+  if (request->worker)
+    gst_uri_downloader_cancel (request->worker);
+}
+
+static void
+gst_uri_downloader_request_free (GstUriDownloaderRequest * request)
+{
+  if (request->notify)
+    request->notify (request->user_data);
+  gst_object_unref (request->downloader);
+  g_free (request->uri);
+  g_free (request->referer);
+  g_slice_free (GstUriDownloaderRequest, request);
+}
+
+/* runs in a thread of the request pool, takes an idle downloader for the
+ * host of the request, or creates one, and does a blocking fetch with it */
+static void
+gst_uri_downloader_request_func (GstUriDownloaderRequest * request,
+    gpointer user_data)
+{
+  GstUriDownloader *downloader = request->downloader;
+  GstUriDownloaderPrivate *priv = downloader->priv;
+  GstUriDownloader *worker = NULL;
+  GstFragment *download = NULL;
+  GError *err = NULL;
+  GQueue *workers;
+  gboolean use_cache;
+  gchar *host;
+
+  host = gst_uri_downloader_get_host (request->uri);
+
+  GST_OBJECT_LOCK (downloader);
+  use_cache = priv->use_cache;
+  GST_OBJECT_UNLOCK (downloader);
+
+  g_mutex_lock (&priv->async_lock);
+  if (!request->cancelled) {
+    workers = g_hash_table_lookup (priv->idle_workers, host);
+    if (workers)
+      worker = g_queue_pop_head (workers);
+    if (worker == NULL) {
+      GstElement *parent = g_weak_ref_get (&priv->parent);
+
+      GST_DEBUG_OBJECT (downloader, "Creating a downloader for %s", host);
+      worker = gst_uri_downloader_new ();
+      gst_uri_downloader_set_parent (worker, parent);
+      if (parent)
+        gst_object_unref (parent);
+    }
+    request->worker = worker;
+  }
+  g_mutex_unlock (&priv->async_lock);
+
+  if (worker) {
+    gst_uri_downloader_set_use_cache (worker, use_cache);
+    download = gst_uri_downloader_fetch_uri_with_range (worker, request->uri,
+        request->referer, request->compress, request->refresh,
+        request->allow_cache, request->range_start, request->range_end, &err);
+  }
+
+  g_mutex_lock (&priv->async_lock);
+  request->worker = NULL;
+  priv->requests = g_list_remove (priv->requests, request);
+  if (worker) {
+    /* the downloader might have been cancelled after the fetch returned */
+    gst_uri_downloader_reset (worker);
+
+    workers = g_hash_table_lookup (priv->idle_workers, host);
+    if (workers == NULL) {
+      workers = g_queue_new ();
+      g_hash_table_insert (priv->idle_workers, g_strdup (host), workers);
+    }
+    if (g_queue_get_length (workers) < MAX_IDLE_WORKERS_PER_HOST)
+      g_queue_push_head (workers, worker);
+    else
+      gst_object_unref (worker);
+  }
+  if (request->cancelled) {
+    if (download) {
+      g_object_unref (download);
+      download = NULL;
+    }
+    g_clear_error (&err);
+    g_set_error (&err, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Download of '%s' was cancelled", request->uri);
+  }
+  g_mutex_unlock (&priv->async_lock);
+
+  GST_DEBUG_OBJECT (downloader, "Request %u for %s finished: %s", request->id,
+      request->uri, err ? err->message : "ok");
+
+  request->callback (downloader, download, err, request->user_data);
+
+  g_clear_error (&err);
+  g_free (host);
+  gst_uri_downloader_request_free (request);
+}
+
+static gpointer
+gst_uri_downloader_create_request_pool (gpointer data)
+{
+  return g_thread_pool_new ((GFunc) gst_uri_downloader_request_func, NULL, -1,
+      FALSE, NULL);
+}
+
+/**
+ * gst_uri_downloader_fetch_uri_async:
+ * @downloader: the #GstUriDownloader
+ * @uri: the uri
+ * @range_start: the starting byte index
+ * @range_end: the final byte index, use -1 for unspecified
+ * @callback: called from another thread when the request is done
+ * @user_data: data passed to @callback
+ * @notify: called to free @user_data after @callback
+ *
+ * Like gst_uri_downloader_fetch_uri_with_range(), but returns immediately
+ * and runs the request in a thread of its own. Requests can run in parallel
+ * with each other and with the blocking ones. Their source elements, and so
+ * their connections, are reused for later requests to the same host.
+ *
+ * @callback is always called exactly once, with the downloaded #GstFragment
+ * (transfer full) or with %NULL and an error if the request failed or was
+ * cancelled.
+ *
+ * Returns: an identifier for gst_uri_downloader_cancel_request()
+ */
+guint
+gst_uri_downloader_fetch_uri_async (GstUriDownloader * downloader,
+    const gchar * uri, const gchar * referer, gboolean compress,
+    gboolean refresh, gboolean allow_cache, gint64 range_start,
+    gint64 range_end, GstUriDownloaderCallback callback, gpointer user_data,
+    GDestroyNotify notify)
+{
+  static GOnce request_pool_once = G_ONCE_INIT;
+  GstUriDownloaderRequest *request;
+  GThreadPool *pool;
+  guint id;
+
+  g_return_val_if_fail (GST_IS_URI_DOWNLOADER (downloader), 0);
+  g_return_val_if_fail (uri != NULL, 0);
+  g_return_val_if_fail (callback != NULL, 0);
+
+  pool = g_once (&request_pool_once, gst_uri_downloader_create_request_pool,
+      NULL);
+
+  request = g_slice_new0 (GstUriDownloaderRequest);
+  request->downloader = gst_object_ref (downloader);
+  request->uri = g_strdup (uri);
+  request->referer = g_strdup (referer);
+  request->compress = compress;
+  request->refresh = refresh;
+  request->allow_cache = allow_cache;
+  request->range_start = range_start;
+  request->range_end = range_end;
+  request->callback = callback;
+  request->user_data = user_data;
+  request->notify = notify;
+
+  g_mutex_lock (&downloader->priv->async_lock);
+  if (++downloader->priv->next_request_id == 0)
+    downloader->priv->next_request_id = 1;
+  id = request->id = downloader->priv->next_request_id;
+  downloader->priv->requests =
+      g_list_prepend (downloader->priv->requests, request);
+  g_mutex_unlock (&downloader->priv->async_lock);
+
+  GST_DEBUG_OBJECT (downloader, "Request %u for %s", id, uri);
+  g_thread_pool_push (pool, request, NULL);
+
+  return id;
+}
+
+/**
+ * gst_uri_downloader_cancel_request:
+ * @downloader: the #GstUriDownloader
+ * @request_id: a request identifier
+ *
+ * Aborts a request started with gst_uri_downloader_fetch_uri_async(), if it
+ * is not finished yet. gst_uri_downloader_cancel() cancels all of them.
+ */
+void
+gst_uri_downloader_cancel_request (GstUriDownloader * downloader,
+    guint request_id)
+{
+  GList *iter;
+
+  g_return_if_fail (GST_IS_URI_DOWNLOADER (downloader));
+
+  g_mutex_lock (&downloader->priv->async_lock);
+  for (iter = downloader->priv->requests; iter; iter = g_list_next (iter)) {
+    GstUriDownloaderRequest *request = iter->data;
+
+    if (request->id == request_id) {
+      gst_uri_downloader_request_cancel (request);
+      break;
+    }
+  }
+  g_mutex_unlock (&downloader->priv->async_lock);
+}
@@ -50,6 +50,16 @@ struct _GstUriDownloader
   GstUriDownloaderPrivate *priv;
 };
 
+/**
+ * GstUriDownloaderCallback:
+ * @downloader: the #GstUriDownloader
+ * @download: (transfer full) (nullable): the downloaded #GstFragment, or
+ *     %NULL if the request failed
+ * @err: (nullable): the reason of the failure
+ * @user_data: the data passed to gst_uri_downloader_fetch_uri_async()
+ */
+typedef void (*GstUriDownloaderCallback) (GstUriDownloader * downloader, GstFragment * download, const GError * err, gpointer user_data);
+
 struct _GstUriDownloaderClass
 {
   GstObjectClass parent_class;
@@ -67,12 +77,21 @@ GstUriDownloader * gst_uri_downloader_new (void);
 GST_EXPORT
 void gst_uri_downloader_set_parent (GstUriDownloader * downloader, GstElement * parent);
 
+GST_EXPORT
+void gst_uri_downloader_set_use_cache (GstUriDownloader * downloader, gboolean use_cache);
+
 GST_EXPORT
 GstFragment * gst_uri_downloader_fetch_uri (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, GError ** err);
 
 GST_EXPORT
 GstFragment * gst_uri_downloader_fetch_uri_with_range (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, gint64 range_start, gint64 range_end, GError ** err);
 
+GST_EXPORT
+guint gst_uri_downloader_fetch_uri_async (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, gint64 range_start, gint64 range_end, GstUriDownloaderCallback callback, gpointer user_data, GDestroyNotify notify);
+
+GST_EXPORT
+void gst_uri_downloader_cancel_request (GstUriDownloader * downloader, guint request_id);
+
 GST_EXPORT
 void gst_uri_downloader_reset (GstUriDownloader *downloader);
 
@@ -431,6 +431,17 @@ struct _GstVideoAggregatorPrivate
   GstCaps *current_caps;
 
   gboolean live;
+
+  /* prepare-threads property, protected by the object lock */
+  guint prepare_threads;
+  /* Worker pool running prepare_frame on all pads in parallel, only
+   * accessed from the aggregate function */
+  GThreadPool *prepare_pool;
+
+  /* Protects prepare_pending and signals prepare_cond when it drops to 0 */
+  GMutex prepare_lock;
+  GCond prepare_cond;
+  guint prepare_pending;
 };
 
 /* Can't use the G_DEFINE_TYPE macros because we need the
@@ -1269,6 +1280,18 @@ sync_pad_values (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad)
   return TRUE;
 }
 
+static gboolean
+prepare_frames_start (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad)
+{
+  GstVideoAggregatorPadClass *vaggpad_class =
+      GST_VIDEO_AGGREGATOR_PAD_GET_CLASS (pad);
+
+  if (pad->buffer != NULL && vaggpad_class->prepare_frame_start)
+    vaggpad_class->prepare_frame_start (pad, vagg);
+
+  return TRUE;
+}
+
 static gboolean
 prepare_frames (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad)
 {
@@ -1281,6 +1304,114 @@ prepare_frames (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad)
   return vaggpad_class->prepare_frame (pad, vagg);
 }
 
+static void
+prepare_frames_worker (GstVideoAggregatorPad * pad, GstVideoAggregator * vagg)
+{
+  GstVideoAggregatorPrivate *priv = vagg->priv;
+
+  if (!prepare_frames (vagg, pad))
+    GST_WARNING_OBJECT (pad, "Failed to prepare frame");
+
+  gst_object_unref (pad);
+
+  g_mutex_lock (&priv->prepare_lock);
+  if (--priv->prepare_pending == 0)
+    g_cond_signal (&priv->prepare_cond);
+  g_mutex_unlock (&priv->prepare_lock);
+}
+
+/* Makes sure the worker pool matches the prepare-threads property. Only
+ * called from the aggregate function, so nothing else can be using the
+ * pool while it is replaced here. */
+static GThreadPool *
+gst_video_aggregator_ensure_prepare_pool (GstVideoAggregator * vagg)
+{
+  GstVideoAggregatorPrivate *priv = vagg->priv;
+  guint n_threads;
+
+  GST_OBJECT_LOCK (vagg);
+  n_threads = priv->prepare_threads;
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  if (n_threads <= 1) {
+    if (priv->prepare_pool) {
+      g_thread_pool_free (priv->prepare_pool, FALSE, TRUE);
+      priv->prepare_pool = NULL;
+    }
+    return NULL;
+  }
+
+  if (priv->prepare_pool == NULL) {
+    GError *err = NULL;
+
+    GST_DEBUG_OBJECT (vagg, "Preparing frames with %u threads", n_threads);
+    priv->prepare_pool =
+        g_thread_pool_new ((GFunc) prepare_frames_worker, vagg, n_threads,
+        FALSE, &err);
+    if (priv->prepare_pool == NULL) {
+      GST_WARNING_OBJECT (vagg, "Could not create worker pool: %s",
+          err->message);
+      g_clear_error (&err);
+    }
+  } else if (g_thread_pool_get_max_threads (priv->prepare_pool) !=
+      (gint) n_threads) {
+    g_thread_pool_set_max_threads (priv->prepare_pool, n_threads, NULL);
+  }
+
+  return priv->prepare_pool;
+}
+
+/* Runs prepare_frame for all pads that have a buffer on the worker pool and
+ * waits for all of them to finish. Returns FALSE if no pool is configured,
+ * in which case the caller has to prepare the frames itself. */
+static gboolean
+gst_video_aggregator_prepare_frames_parallel (GstVideoAggregator * vagg)
+{
+  GstVideoAggregatorPrivate *priv = vagg->priv;
+  GList *pads = NULL, *l;
+  GThreadPool *pool;
+
+  pool = gst_video_aggregator_ensure_prepare_pool (vagg);
+  if (pool == NULL)
+    return FALSE;
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+
+    if (pad->buffer != NULL)
+      pads = g_list_prepend (pads, gst_object_ref (pad));
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  /* Nothing to gain from handing a single pad to another thread */
+  if (pads == NULL || pads->next == NULL) {
+    for (l = pads; l; l = l->next)
+      prepare_frames (vagg, l->data);
+    g_list_free_full (pads, gst_object_unref);
+    return TRUE;
+  }
+
+  g_mutex_lock (&priv->prepare_lock);
+  priv->prepare_pending = g_list_length (pads);
+  g_mutex_unlock (&priv->prepare_lock);
+
+  /* The pool owns the pad references from here on */
+  for (l = pads; l; l = l->next)
+    g_thread_pool_push (pool, l->data, NULL);
+  g_list_free (pads);
+
+  g_mutex_lock (&priv->prepare_lock);
+  while (priv->prepare_pending > 0)
+    g_cond_wait (&priv->prepare_cond, &priv->prepare_lock);
+  g_mutex_unlock (&priv->prepare_lock);
+
+  return TRUE;
+}
+
 static gboolean
 clean_pad (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad)
 {
@@ -1323,9 +1454,15 @@ gst_video_aggregator_do_aggregate (GstVideoAggregator * vagg,
   gst_aggregator_iterate_sinkpads (GST_AGGREGATOR (vagg),
       (GstAggregatorPadForeachFunc) sync_pad_values, NULL);
 
-  /* Convert all the frames the subclass has before aggregating */
+  /* Everything depending on several pads is done before the frames are
+   * possibly prepared in parallel */
   gst_aggregator_iterate_sinkpads (GST_AGGREGATOR (vagg),
-      (GstAggregatorPadForeachFunc) prepare_frames, NULL);
+      (GstAggregatorPadForeachFunc) prepare_frames_start, NULL);
+
+  /* Convert all the frames the subclass has before aggregating */
+  if (!gst_video_aggregator_prepare_frames_parallel (vagg))
+    gst_aggregator_iterate_sinkpads (GST_AGGREGATOR (vagg),
+        (GstAggregatorPadForeachFunc) prepare_frames, NULL);
 
   ret = vagg_klass->aggregate_frames (vagg, *outbuf);
 
@@ -2105,13 +2242,26 @@ gst_video_aggregator_sink_query (GstAggregator * agg, GstAggregatorPad * bpad,
   return ret;
 }
 
+#define DEFAULT_PREPARE_THREADS 1
+enum
+{
+  PROP_0,
+  PROP_PREPARE_THREADS,
+};
+
 /* GObject vmethods */
 static void
 gst_video_aggregator_finalize (GObject * o)
 {
   GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (o);
 
+  if (vagg->priv->prepare_pool)
+    g_thread_pool_free (vagg->priv->prepare_pool, FALSE, TRUE);
+  vagg->priv->prepare_pool = NULL;
+
   g_mutex_clear (&vagg->priv->lock);
+  g_mutex_clear (&vagg->priv->prepare_lock);
+  g_cond_clear (&vagg->priv->prepare_cond);
 
   G_OBJECT_CLASS (gst_video_aggregator_parent_class)->finalize (o);
 }
@@ -2130,7 +2280,14 @@ static void
 gst_video_aggregator_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
 {
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (object);
+
   switch (prop_id) {
+    case PROP_PREPARE_THREADS:
+      GST_OBJECT_LOCK (vagg);
+      g_value_set_uint (value, vagg->priv->prepare_threads);
+      GST_OBJECT_UNLOCK (vagg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2141,7 +2298,14 @@ static void
 gst_video_aggregator_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec)
 {
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (object);
+
   switch (prop_id) {
+    case PROP_PREPARE_THREADS:
+      GST_OBJECT_LOCK (vagg);
+      vagg->priv->prepare_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (vagg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2169,6 +2333,22 @@ gst_video_aggregator_class_init (GstVideoAggregatorClass * klass)
   gobject_class->get_property = gst_video_aggregator_get_property;
   gobject_class->set_property = gst_video_aggregator_set_property;
 
+  /**
+   * GstVideoAggregator:prepare-threads:
+   *
+   * Number of threads used to prepare (map and convert) the input frames
+   * of all pads in parallel before aggregating them. 1 prepares the frames
+   * one after another from the aggregator thread, 0 uses one thread per CPU.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PREPARE_THREADS,
+      g_param_spec_uint ("prepare-threads", "Prepare Threads",
+          "Number of threads used to prepare input frames "
+          "(0 = number of processors, 1 = no parallel preparation)",
+          0, G_MAXINT, DEFAULT_PREPARE_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_video_aggregator_request_new_pad);
   gstelement_class->release_pad =
@@ -2283,6 +2463,10 @@ gst_video_aggregator_init (GstVideoAggregator * vagg,
   vagg->priv->current_caps = NULL;
 
   g_mutex_init (&vagg->priv->lock);
+  g_mutex_init (&vagg->priv->prepare_lock);
+  g_cond_init (&vagg->priv->prepare_cond);
+  vagg->priv->prepare_threads = DEFAULT_PREPARE_THREADS;
+  vagg->priv->prepare_pool = NULL;
 
   /* initialize variables */
   g_mutex_lock (&sink_caps_mutex);
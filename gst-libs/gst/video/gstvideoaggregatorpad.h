@@ -81,6 +81,11 @@ struct _GstVideoAggregatorPad
  * @prepare_frame: Prepare the frame from the pad buffer (if any)
  *                 and sets it to @aggregated_frame
  * @clean_frame:   clean the frame previously prepared in prepare_frame
+ * @prepare_frame_start: Called for all pads with a buffer, one after the
+ *                 other from the aggregator thread, before any frame is
+ *                 prepared. As prepare_frame can run for several pads in
+ *                 parallel, anything looking at other pads has to be done
+ *                 here. Since: 1.14
  */
 struct _GstVideoAggregatorPadClass
 {
@@ -96,7 +101,10 @@ struct _GstVideoAggregatorPadClass
   void               (*clean_frame)           (GstVideoAggregatorPad * pad,
                                                GstVideoAggregator    * videoaggregator);
 
-  gpointer          _gst_reserved[GST_PADDING_LARGE];
+  void               (*prepare_frame_start)   (GstVideoAggregatorPad * pad,
+                                               GstVideoAggregator    * videoaggregator);
+
+  gpointer          _gst_reserved[GST_PADDING_LARGE - 1];
 };
 
 GST_EXPORT
@@ -0,0 +1,257 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstvideolumameta
+ * @title: GstVideoLumaMeta
+ * @short_description: Decimated luma of a video frame
+ *
+ * A #GstVideoLumaMeta holds the luma of a frame at a reduced resolution,
+ * for analysis elements whose metrics do not need every pixel. The first
+ * element computing it attaches it to the buffer and the following ones
+ * reuse it.
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstvideolumameta.h"
+
+static gboolean
+gst_video_luma_meta_init (GstVideoLumaMeta * meta, gpointer params,
+    GstBuffer * buffer)
+{
+  meta->shift = 0;
+  meta->width = meta->height = meta->stride = 0;
+  meta->data = NULL;
+
+  return TRUE;
+}
+
+static void
+gst_video_luma_meta_free (GstVideoLumaMeta * meta, GstBuffer * buffer)
+{
+  g_free (meta->data);
+}
+
+static gboolean
+gst_video_luma_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstVideoLumaMeta *smeta, *dmeta;
+
+  smeta = (GstVideoLumaMeta *) meta;
+
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    if (!copy->region) {
+      /* only copy if the complete data is copied as well */
+      dmeta = (GstVideoLumaMeta *) gst_buffer_add_meta (dest,
+          GST_VIDEO_LUMA_META_INFO, NULL);
+      if (!dmeta)
+        return FALSE;
+
+      dmeta->shift = smeta->shift;
+      dmeta->width = smeta->width;
+      dmeta->height = smeta->height;
+      dmeta->stride = smeta->stride;
+      dmeta->data = g_memdup (smeta->data, smeta->stride * smeta->height);
+    }
+  } else {
+    /* return FALSE, if transform type is not supported */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GType
+gst_video_luma_meta_api_get_type (void)
+{
+  static volatile GType type;
+  /* the luma changes with the size and the colorspace of the frame */
+  static const gchar *tags[] = { GST_META_TAG_VIDEO_STR,
+    GST_META_TAG_VIDEO_SIZE_STR, GST_META_TAG_VIDEO_COLORSPACE_STR, NULL
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstVideoLumaMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_video_luma_meta_get_info (void)
+{
+  static const GstMetaInfo *video_luma_meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & video_luma_meta_info)) {
+    const GstMetaInfo *meta = gst_meta_register (GST_VIDEO_LUMA_META_API_TYPE,
+        "GstVideoLumaMeta", sizeof (GstVideoLumaMeta),
+        (GstMetaInitFunction) gst_video_luma_meta_init,
+        (GstMetaFreeFunction) gst_video_luma_meta_free,
+        (GstMetaTransformFunction) gst_video_luma_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & video_luma_meta_info,
+        (GstMetaInfo *) meta);
+  }
+
+  return video_luma_meta_info;
+}
+
+/**
+ * gst_buffer_get_video_luma_meta:
+ * @buffer: a #GstBuffer
+ * @shift: the decimation factor, as a power of two
+ *
+ * Finds the #GstVideoLumaMeta of @buffer decimated by (1 << @shift).
+ *
+ * Returns: (transfer none) (nullable): the #GstVideoLumaMeta or %NULL
+ *
+ * Since: 1.14
+ */
+GstVideoLumaMeta *
+gst_buffer_get_video_luma_meta (GstBuffer * buffer, guint shift)
+{
+  gpointer state = NULL;
+  GstMeta *meta;
+
+  while ((meta = gst_buffer_iterate_meta_filtered (buffer, &state,
+              GST_VIDEO_LUMA_META_API_TYPE))) {
+    GstVideoLumaMeta *lmeta = (GstVideoLumaMeta *) meta;
+
+    if (lmeta->shift == shift)
+      return lmeta;
+  }
+
+  return NULL;
+}
+
+/* box filter over squares of (1 << shift) samples, the samples of the
+ * frame right and below the last complete square are ignored */
+static void
+decimate_luma (const GstVideoFrame * frame, GstVideoLumaMeta * meta)
+{
+  const guint8 *src = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  const gint src_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  const gint pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
+  const guint shift = meta->shift;
+  const gint n = 1 << shift;
+  guint32 *acc;
+  gint x, y, j, k;
+
+  acc = g_new (guint32, meta->width);
+
+  for (y = 0; y < meta->height; y++) {
+    guint8 *dest = meta->data + y * meta->stride;
+
+    memset (acc, 0, meta->width * sizeof (guint32));
+    for (j = 0; j < n; j++) {
+      const guint8 *s = src + (y * n + j) * src_stride;
+
+      if (pstride == 1) {
+        for (x = 0; x < meta->width; x++) {
+          for (k = 0; k < n; k++)
+            acc[x] += s[x * n + k];
+        }
+      } else {
+        for (x = 0; x < meta->width; x++) {
+          for (k = 0; k < n; k++)
+            acc[x] += s[(x * n + k) * pstride];
+        }
+      }
+    }
+
+    for (x = 0; x < meta->width; x++)
+      dest[x] = (acc[x] + ((n * n) >> 1)) >> (2 * shift);
+  }
+
+  g_free (acc);
+}
+
+/**
+ * gst_buffer_add_video_luma_meta:
+ * @buffer: a writable #GstBuffer
+ * @frame: @buffer mapped as a video frame with 8 bits luma
+ * @shift: the decimation factor, as a power of two
+ *
+ * Computes the luma of @frame decimated by (1 << @shift) in both directions
+ * and attaches it to @buffer.
+ *
+ * Returns: (transfer none): the new #GstVideoLumaMeta
+ *
+ * Since: 1.14
+ */
+GstVideoLumaMeta *
+gst_buffer_add_video_luma_meta (GstBuffer * buffer,
+    const GstVideoFrame * frame, guint shift)
+{
+  GstVideoLumaMeta *meta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (frame != NULL, NULL);
+  g_return_val_if_fail (GST_VIDEO_FORMAT_INFO_IS_YUV (frame->info.finfo) ||
+      GST_VIDEO_FORMAT_INFO_IS_GRAY (frame->info.finfo), NULL);
+  g_return_val_if_fail (GST_VIDEO_FRAME_COMP_DEPTH (frame, 0) == 8, NULL);
+  g_return_val_if_fail (shift < 16, NULL);
+
+  meta = (GstVideoLumaMeta *) gst_buffer_add_meta (buffer,
+      GST_VIDEO_LUMA_META_INFO, NULL);
+  if (!meta)
+    return NULL;
+
+  meta->shift = shift;
+  meta->width = GST_VIDEO_FRAME_COMP_WIDTH (frame, 0) >> shift;
+  meta->height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 0) >> shift;
+  meta->stride = GST_ROUND_UP_4 (meta->width);
+  meta->data = g_malloc (meta->stride * meta->height);
+
+  decimate_luma (frame, meta);
+
+  return meta;
+}
+
+/**
+ * gst_video_luma_meta_shift_for_width:
+ * @width: the width of the frame
+ * @max_width: the maximum width to analyse, 0 for the full width
+ *
+ * Returns: the smallest decimation factor, as a power of two, for which
+ *   the width of the luma is at most @max_width
+ *
+ * Since: 1.14
+ */
+guint
+gst_video_luma_meta_shift_for_width (gint width, guint max_width)
+{
+  guint shift = 0;
+
+  if (max_width == 0)
+    return 0;
+
+  while ((width >> shift) > max_width && shift < 15)
+    shift++;
+
+  return shift;
+}
@@ -0,0 +1,83 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_LUMA_META_H__
+#define __GST_VIDEO_LUMA_META_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The Video library from gst-plugins-bad is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstVideoLumaMeta GstVideoLumaMeta;
+
+GST_EXPORT
+GType gst_video_luma_meta_api_get_type (void);
+#define GST_VIDEO_LUMA_META_API_TYPE  (gst_video_luma_meta_api_get_type())
+#define GST_VIDEO_LUMA_META_INFO  (gst_video_luma_meta_get_info())
+GST_EXPORT
+const GstMetaInfo * gst_video_luma_meta_get_info (void);
+
+/**
+ * GstVideoLumaMeta:
+ * @meta: parent #GstMeta
+ * @shift: the decimation factor, as a power of two
+ * @width: the width of @data
+ * @height: the height of @data
+ * @stride: the stride of @data
+ * @data: the luma of the frame, each sample being the average of a square
+ *   of (1 << @shift) by (1 << @shift) samples of the frame
+ *
+ * Extra buffer metadata holding a decimated copy of the luma of a video
+ * frame.
+ *
+ * Analysis elements that do not need the full resolution can compute it
+ * once and share it through the buffer.
+ *
+ * Since: 1.14
+ */
+struct _GstVideoLumaMeta {
+  GstMeta meta;
+
+  guint shift;
+  gint width;
+  gint height;
+  gint stride;
+  guint8 *data;
+};
+
+GST_EXPORT
+GstVideoLumaMeta * gst_buffer_get_video_luma_meta (GstBuffer * buffer,
+                                                   guint shift);
+
+GST_EXPORT
+GstVideoLumaMeta * gst_buffer_add_video_luma_meta (GstBuffer * buffer,
+                                                   const GstVideoFrame * frame,
+                                                   guint shift);
+
+GST_EXPORT
+guint gst_video_luma_meta_shift_for_width (gint width, guint max_width);
+
+G_END_DECLS
+
+#endif /* __GST_VIDEO_LUMA_META_H__ */
@@ -198,6 +198,15 @@ gst_asf_mux_reset (GstAsfMux * asfmux)
   asfmux->payloads = NULL;
   asfmux->payload_data_size = 0;
 
+  if (asfmux->packets) {
+    gst_buffer_list_unref (asfmux->packets);
+    asfmux->packets = NULL;
+  }
+  if (asfmux->padding) {
+    gst_memory_unref (asfmux->padding);
+    asfmux->padding = NULL;
+  }
+
   asfmux->file_id.v1 = 0;
   asfmux->file_id.v2 = 0;
   asfmux->file_id.v3 = 0;
@@ -1430,22 +1439,54 @@ gst_asf_mux_add_simple_index_entry (GstAsfMux * asfmux,
  * @asfmux:
  * @buf: The asf data packet
  *
- * Pushes an asf data packet downstream. The total number
- * of packets and bytes of the stream are incremented.
- *
- * Returns: the result of pushing the buffer downstream
+ * Queues an asf data packet to be pushed downstream by
+ * #gst_asf_mux_push_packets. The total number of packets
+ * of the stream is incremented.
  */
-static GstFlowReturn
+static void
 gst_asf_mux_send_packet (GstAsfMux * asfmux, GstBuffer * buf, gsize bufsize)
 {
   g_assert (bufsize == asfmux->packet_size);
   asfmux->total_data_packets++;
   GST_LOG_OBJECT (asfmux,
-      "Pushing a packet of size %" G_GSIZE_FORMAT " and timestamp %"
+      "Queueing a packet of size %" G_GSIZE_FORMAT " and timestamp %"
       G_GUINT64_FORMAT, bufsize, GST_BUFFER_TIMESTAMP (buf));
   GST_LOG_OBJECT (asfmux, "Total data packets: %" G_GUINT64_FORMAT,
       asfmux->total_data_packets);
-  return gst_asf_mux_push_buffer (asfmux, buf, bufsize);
+
+  if (asfmux->packets == NULL)
+    asfmux->packets = gst_buffer_list_new ();
+  gst_buffer_list_add (asfmux->packets, buf);
+}
+
+/**
+ * gst_asf_mux_push_packets:
+ * @asfmux:
+ *
+ * Pushes the queued asf data packets downstream in a single
+ * buffer list and adds their size to the total file size.
+ *
+ * Returns: the result of pushing the packets downstream
+ */
+static GstFlowReturn
+gst_asf_mux_push_packets (GstAsfMux * asfmux)
+{
+  GstFlowReturn ret;
+  GstBufferList *packets = asfmux->packets;
+  guint n_packets;
+
+  if (packets == NULL)
+    return GST_FLOW_OK;
+
+  asfmux->packets = NULL;
+  n_packets = gst_buffer_list_length (packets);
+  GST_LOG_OBJECT (asfmux, "Pushing %u packets", n_packets);
+
+  ret = gst_pad_push_list (asfmux->srcpad, packets);
+  if (ret == GST_FLOW_OK)
+    asfmux->file_size += (guint64) n_packets * asfmux->packet_size;
+
+  return ret;
 }
 
 /**
@@ -1453,11 +1494,13 @@ gst_asf_mux_send_packet (GstAsfMux * asfmux, GstBuffer * buf, gsize bufsize)
  * @asfmux: #GstAsfMux to flush the payloads from
  *
  * Fills an asf packet with asfmux queued payloads and
- * pushes it downstream.
+ * queues it to be pushed downstream.
  *
- * Returns: The result of pushing the packet
+ * The packet is made of a memory holding the headers, which is
+ * shared in between the payloads data, and of the memories of
+ * the payloads themselves, so the media data is not copied.
  */
-static GstFlowReturn
+static void
 gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
 {
   GstBuffer *buf;
@@ -1473,18 +1516,24 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
   AsfPayload *payload;
   guint32 payload_size;
   guint offset;
+  GstMemory *headers;
   GstMapInfo map;
+  GstBuffer *payloads_data[MAX_PAYLOADS_IN_A_PACKET + 1];
+  gsize headers_end[MAX_PAYLOADS_IN_A_PACKET + 1];
+  gsize headers_size, headers_start;
 
   if (asfmux->payloads == NULL)
-    return GST_FLOW_OK;         /* nothing to send is ok */
+    return;                     /* nothing to send is ok */
 
   GST_LOG_OBJECT (asfmux, "Flushing payloads");
 
-  buf = gst_buffer_new_and_alloc (asfmux->packet_size);
-  gst_buffer_map (buf, &map, GST_MAP_WRITE);
-  memset (map.data, 0, asfmux->packet_size);
-
   /* 1 for the multiple payload flags */
+  headers_size = asfmux->payload_parsing_info_size + 1 +
+      (MAX_PAYLOADS_IN_A_PACKET + 1) * ASF_MULTIPLE_PAYLOAD_HEADER_SIZE;
+  headers = gst_allocator_alloc (NULL, headers_size, NULL);
+  gst_memory_map (headers, &map, GST_MAP_WRITE);
+  memset (map.data, 0, headers_size);
+
   data = map.data + asfmux->payload_parsing_info_size + 1;
   size_left = asfmux->packet_size - asfmux->payload_parsing_info_size - 1;
 
@@ -1539,6 +1588,9 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
         GST_TIME_ARGS (GST_BUFFER_DURATION (payload->data)));
 
     gst_asf_put_payload (data, payload);
+    payloads_data[payloads_count] = gst_buffer_ref (payload->data);
+    headers_end[payloads_count] =
+        data + ASF_MULTIPLE_PAYLOAD_HEADER_SIZE - map.data;
     if (!payload->has_packet_info) {
       payload->has_packet_info = TRUE;
       payload->packet_number = asfmux->total_data_packets;
@@ -1557,7 +1609,7 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
     }
 
     /* update our variables */
-    data += payload_size;
+    data += ASF_MULTIPLE_PAYLOAD_HEADER_SIZE;
     size_left -= payload_size;
     payloads_count++;
     walk = g_slist_next (walk);
@@ -1591,7 +1643,11 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
       send_ts = GST_BUFFER_TIMESTAMP (payload->data);
     }
 
-    bytes_writen = gst_asf_put_subpayload (data, payload, size_left);
+    bytes_writen = gst_asf_put_subpayload (data, payload, size_left,
+        &payloads_data[payloads_count]);
+    headers_end[payloads_count] =
+        data + ASF_MULTIPLE_PAYLOAD_HEADER_SIZE - map.data;
+    data += ASF_MULTIPLE_PAYLOAD_HEADER_SIZE;
     if (!payload->has_packet_info) {
       payload->has_packet_info = TRUE;
       payload->packet_number = asfmux->total_data_packets;
@@ -1606,7 +1662,8 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
 
   /* fill payload parsing info */
   data = map.data;
-  size = map.size;
+  size = asfmux->packet_size;
+  buf = gst_buffer_new ();
 
   /* flags */
   GST_WRITE_UINT8 (data, (0x0 << 7) |   /* no error correction */
@@ -1646,10 +1703,8 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
   }
 
   /* packet send time */
-  if (GST_CLOCK_TIME_IS_VALID (send_ts)) {
+  if (GST_CLOCK_TIME_IS_VALID (send_ts))
     GST_WRITE_UINT32_LE (data + offset, (send_ts / GST_MSECOND));
-    GST_BUFFER_TIMESTAMP (buf) = send_ts;
-  }
   offset += 4;
 
   /* packet duration */
@@ -1658,17 +1713,43 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
 
   /* multiple payloads flags */
   GST_WRITE_UINT8 (data + offset, 0x2 << 6 | payloads_count);
-  gst_buffer_unmap (buf, &map);
+  gst_memory_unmap (headers, &map);
 
+  /* put the payloads data after their headers */
+  headers_start = 0;
+  for (i = 0; i < payloads_count; i++) {
+    gst_buffer_append_memory (buf, gst_memory_share (headers, headers_start,
+            headers_end[i] - headers_start));
+    buf = gst_buffer_append (buf, payloads_data[i]);
+    headers_start = headers_end[i];
+  }
   if (payloads_count == 0) {
     GST_WARNING_OBJECT (asfmux, "Sending packet without any payload");
+    gst_buffer_append_memory (buf, gst_memory_share (headers, 0,
+            asfmux->payload_parsing_info_size + 1));
   }
+  gst_memory_unref (headers);
+
+  if (size_left > 0) {
+    if (asfmux->padding == NULL) {
+      asfmux->padding = gst_allocator_alloc (NULL, asfmux->packet_size, NULL);
+      gst_memory_map (asfmux->padding, &map, GST_MAP_WRITE);
+      memset (map.data, 0, map.size);
+      gst_memory_unmap (asfmux->padding, &map);
+    }
+    gst_buffer_append_memory (buf, gst_memory_share (asfmux->padding, 0,
+            size_left));
+  }
+  g_assert (gst_buffer_get_size (buf) == size);
+
+  if (GST_CLOCK_TIME_IS_VALID (send_ts))
+    GST_BUFFER_TIMESTAMP (buf) = send_ts;
   asfmux->data_object_size += size;
 
   if (!has_keyframe)
     GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
 
-  return gst_asf_mux_send_packet (asfmux, buf, size);
+  gst_asf_mux_send_packet (asfmux, buf, size);
 }
 
 /**
@@ -1942,12 +2023,10 @@ gst_asf_mux_process_buffer (GstAsfMux * asfmux, GstAsfPad * pad,
 
   while (asfmux->payload_data_size + asfmux->payload_parsing_info_size >=
       asfmux->packet_size) {
-    GstFlowReturn ret = gst_asf_mux_flush_payloads (asfmux);
-    if (ret != GST_FLOW_OK)
-      return ret;
+    gst_asf_mux_flush_payloads (asfmux);
   }
 
-  return GST_FLOW_OK;
+  return gst_asf_mux_push_packets (asfmux);
 }
 
 static GstFlowReturn
@@ -2025,12 +2104,11 @@ gst_asf_mux_collected (GstCollectPads * collect, gpointer data)
     ret = gst_asf_mux_process_buffer (asfmux, best_pad, buf);
   } else {
     /* no data, let's finish it up */
-    while (asfmux->payloads) {
-      ret = gst_asf_mux_flush_payloads (asfmux);
-      if (ret != GST_FLOW_OK) {
-        return ret;
-      }
-    }
+    while (asfmux->payloads)
+      gst_asf_mux_flush_payloads (asfmux);
+    ret = gst_asf_mux_push_packets (asfmux);
+    if (ret != GST_FLOW_OK)
+      return ret;
     g_assert (asfmux->payloads == NULL);
     g_assert (asfmux->payload_data_size == 0);
     /* in not on 'streamable' mode we need to push indexes
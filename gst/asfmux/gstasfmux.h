@@ -123,6 +123,10 @@ struct _GstAsfMux
   guint32 payload_parsing_info_size;
   GSList *payloads;
 
+  /* packets not pushed yet, and zeroes to pad them with */
+  GstBufferList *packets;
+  GstMemory *padding;
+
   Guid file_id;
 
   /* properties */
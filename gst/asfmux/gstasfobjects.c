@@ -323,10 +323,11 @@ gst_asf_put_guid (guint8 * buf, Guid guid)
 
 /**
  * gst_asf_put_payload:
- * @buf: memory to write the payload to
+ * @buf: memory to write the payload header to
  * @payload: #AsfPayload to be writen
  *
- * Writes the asf payload to the buffer. The #AsfPayload
+ * Writes the header of the asf payload to the buffer, its data
+ * is expected to follow it in the packet. The #AsfPayload
  * packet count is incremented.
  */
 void
@@ -339,22 +340,22 @@ gst_asf_put_payload (guint8 * buf, AsfPayload * payload)
   GST_WRITE_UINT32_LE (buf + 7, payload->media_object_size);
   GST_WRITE_UINT32_LE (buf + 11, payload->presentation_time);
   GST_WRITE_UINT16_LE (buf + 15, (guint16) gst_buffer_get_size (payload->data));
-  gst_buffer_extract (payload->data, 0, buf + 17,
-      gst_buffer_get_size (payload->data));
 
   payload->packet_count++;
 }
 
 /**
  * gst_asf_put_subpayload:
- * @buf: buffer to write the payload to
+ * @buf: buffer to write the payload header to
  * @payload: the payload to be writen
  * @size: maximum size in bytes to write
+ * @data: (out): location for the part of the payload data to put
+ *     after the header
  *
- * Serializes part of a payload to a buffer.
+ * Serializes the header of part of a payload to a buffer.
  * The maximum size is checked against the payload length,
- * the minimum of this size and the payload length is writen
- * to the buffer and the writen size is returned.
+ * the minimum of this size and the payload length is the size
+ * of the part, which is returned in @data without copying it.
  *
  * It also updates the values of the payload to match the remaining
  * data.
@@ -363,7 +364,8 @@ gst_asf_put_payload (guint8 * buf, AsfPayload * payload)
  * Returns: The writen size in bytes.
  */
 guint16
-gst_asf_put_subpayload (guint8 * buf, AsfPayload * payload, guint16 size)
+gst_asf_put_subpayload (guint8 * buf, AsfPayload * payload, guint16 size,
+    GstBuffer ** data)
 {
   guint16 payload_size;
   GstBuffer *newbuf;
@@ -380,7 +382,8 @@ gst_asf_put_subpayload (guint8 * buf, AsfPayload * payload, guint16 size)
   payload_size = size < gst_buffer_get_size (payload->data) ?
       size : gst_buffer_get_size (payload->data);
   GST_WRITE_UINT16_LE (buf + 15, payload_size);
-  gst_buffer_extract (payload->data, 0, buf + 17, payload_size);
+  *data = gst_buffer_copy_region (payload->data, GST_BUFFER_COPY_MEMORY, 0,
+      payload_size);
 
   /* updates the payload to the remaining data */
   payload->offset_in_media_obj += payload_size;
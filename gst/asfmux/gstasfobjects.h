@@ -106,7 +106,7 @@ void gst_asf_put_time (guint8 * buf, guint64 time);
 void gst_asf_put_guid (guint8 * buf, Guid guid);
 void gst_asf_put_payload (guint8 * buf, AsfPayload * payload);
 guint16 gst_asf_put_subpayload (guint8 * buf, AsfPayload * payload,
-    guint16 size);
+    guint16 size, GstBuffer ** data);
 
 gboolean gst_asf_parse_packet (GstBuffer * buffer, GstAsfPacketInfo * packet,
     gboolean trust_delta_flag, guint packet_size);
@@ -319,7 +319,11 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
     GstClockTime resync_time_diff;
 
     size = MIN (size, avail);
-    buffer = gst_adapter_take_buffer (self->adapter, size);
+    /* Output buffers spanning several input buffers get the memories of
+     * each of them instead of a merged copy. Only the metadata is ever
+     * copied, when the input buffer is still referenced elsewhere */
+    buffer = gst_adapter_take_buffer_fast (self->adapter, size);
+    buffer = gst_buffer_make_writable (buffer);
 
     resync_time_diff =
         gst_util_uint64_scale (self->current_offset, GST_SECOND, rate);
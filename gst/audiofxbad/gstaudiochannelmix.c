@@ -25,6 +25,10 @@
  * equal left/right channels on an input stream that has audio in only
  * one channel.
  *
+ * Unity gains make the element pass the audio through untouched, and
+ * swapping the channels or mixing them down to the same signal on both
+ * sides are handled without any arithmetic on the second channel.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v audiotestsrc ! audiochannelmix ! autoaudiosink
@@ -68,20 +72,22 @@ enum
 
 /* pad templates */
 
+#define AUDIO_CHANNEL_MIX_CAPS \
+    "audio/x-raw,format={ " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (S32) ", " \
+    GST_AUDIO_NE (F32) " },rate=[1,max],channels=2,layout=interleaved"
+
 static GstStaticPadTemplate gst_audio_channel_mix_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw,format=S16LE,rate=[1,max],"
-        "channels=2,layout=interleaved")
+    GST_STATIC_CAPS (AUDIO_CHANNEL_MIX_CAPS)
     );
 
 static GstStaticPadTemplate gst_audio_channel_mix_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw,format=S16LE,rate=[1,max],"
-        "channels=2,layout=interleaved")
+    GST_STATIC_CAPS (AUDIO_CHANNEL_MIX_CAPS)
     );
 
 
@@ -149,6 +155,33 @@ gst_audio_channel_mix_init (GstAudioChannelMix * audiochannelmix)
   audiochannelmix->left_to_right = 0.0;
   audiochannelmix->right_to_left = 0.0;
   audiochannelmix->right_to_right = 1.0;
+  audiochannelmix->mode = GST_AUDIO_CHANNEL_MIX_MODE_UNITY;
+
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (audiochannelmix),
+      TRUE);
+}
+
+static void
+gst_audio_channel_mix_update_mode (GstAudioChannelMix * audiochannelmix)
+{
+  double ll = audiochannelmix->left_to_left;
+  double lr = audiochannelmix->left_to_right;
+  double rl = audiochannelmix->right_to_left;
+  double rr = audiochannelmix->right_to_right;
+  GstAudioChannelMixMode mode;
+
+  if (ll == 1.0 && lr == 0.0 && rl == 0.0 && rr == 1.0)
+    mode = GST_AUDIO_CHANNEL_MIX_MODE_UNITY;
+  else if (ll == 0.0 && lr == 1.0 && rl == 1.0 && rr == 0.0)
+    mode = GST_AUDIO_CHANNEL_MIX_MODE_SWAP;
+  else if (ll == lr && rl == rr)
+    mode = GST_AUDIO_CHANNEL_MIX_MODE_DOWNMIX;
+  else
+    mode = GST_AUDIO_CHANNEL_MIX_MODE_MATRIX;
+
+  audiochannelmix->mode = mode;
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (audiochannelmix),
+      mode == GST_AUDIO_CHANNEL_MIX_MODE_UNITY);
 }
 
 void
@@ -174,8 +207,10 @@ gst_audio_channel_mix_set_property (GObject * object, guint property_id,
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
-      break;
+      return;
   }
+
+  gst_audio_channel_mix_update_mode (audiochannelmix);
 }
 
 void
@@ -217,31 +252,141 @@ gst_audio_channel_mix_setup (GstAudioFilter * filter, const GstAudioInfo * info)
   return TRUE;
 }
 
+/* The loops below have no dependencies between the frames and no branches
+ * besides the clamping, so that the compiler can vectorize them. S16 is
+ * mixed in single precision, which is exact enough for 16 bit samples. */
+
+static void
+mix_s16 (GstAudioChannelMix * audiochannelmix, gint16 * data, gint n)
+{
+  gfloat ll = audiochannelmix->left_to_left;
+  gfloat lr = audiochannelmix->left_to_right;
+  gfloat rl = audiochannelmix->right_to_left;
+  gfloat rr = audiochannelmix->right_to_right;
+  gfloat l, r;
+  gint i;
+
+  if (audiochannelmix->mode == GST_AUDIO_CHANNEL_MIX_MODE_DOWNMIX) {
+    for (i = 0; i < n; i++) {
+      l = CLAMP (ll * data[2 * i + 0] + rl * data[2 * i + 1], -32768.0f,
+          32767.0f);
+      data[2 * i + 0] = data[2 * i + 1] = lrintf (l);
+    }
+  } else {
+    for (i = 0; i < n; i++) {
+      l = CLAMP (ll * data[2 * i + 0] + rl * data[2 * i + 1], -32768.0f,
+          32767.0f);
+      r = CLAMP (lr * data[2 * i + 0] + rr * data[2 * i + 1], -32768.0f,
+          32767.0f);
+      data[2 * i + 0] = lrintf (l);
+      data[2 * i + 1] = lrintf (r);
+    }
+  }
+}
+
+static void
+mix_s32 (GstAudioChannelMix * audiochannelmix, gint32 * data, gint n)
+{
+  double ll = audiochannelmix->left_to_left;
+  double lr = audiochannelmix->left_to_right;
+  double rl = audiochannelmix->right_to_left;
+  double rr = audiochannelmix->right_to_right;
+  double l, r;
+  gint i;
+
+  if (audiochannelmix->mode == GST_AUDIO_CHANNEL_MIX_MODE_DOWNMIX) {
+    for (i = 0; i < n; i++) {
+      l = CLAMP (ll * data[2 * i + 0] + rl * data[2 * i + 1],
+          (double) G_MININT32, (double) G_MAXINT32);
+      data[2 * i + 0] = data[2 * i + 1] = lrint (l);
+    }
+  } else {
+    for (i = 0; i < n; i++) {
+      l = CLAMP (ll * data[2 * i + 0] + rl * data[2 * i + 1],
+          (double) G_MININT32, (double) G_MAXINT32);
+      r = CLAMP (lr * data[2 * i + 0] + rr * data[2 * i + 1],
+          (double) G_MININT32, (double) G_MAXINT32);
+      data[2 * i + 0] = lrint (l);
+      data[2 * i + 1] = lrint (r);
+    }
+  }
+}
+
+static void
+mix_f32 (GstAudioChannelMix * audiochannelmix, gfloat * data, gint n)
+{
+  gfloat ll = audiochannelmix->left_to_left;
+  gfloat lr = audiochannelmix->left_to_right;
+  gfloat rl = audiochannelmix->right_to_left;
+  gfloat rr = audiochannelmix->right_to_right;
+  gfloat l, r;
+  gint i;
+
+  if (audiochannelmix->mode == GST_AUDIO_CHANNEL_MIX_MODE_DOWNMIX) {
+    for (i = 0; i < n; i++) {
+      l = ll * data[2 * i + 0] + rl * data[2 * i + 1];
+      data[2 * i + 0] = data[2 * i + 1] = l;
+    }
+  } else {
+    for (i = 0; i < n; i++) {
+      l = ll * data[2 * i + 0] + rl * data[2 * i + 1];
+      r = lr * data[2 * i + 0] + rr * data[2 * i + 1];
+      data[2 * i + 0] = l;
+      data[2 * i + 1] = r;
+    }
+  }
+}
+
+#define SWAP_CHANNELS(type, data, n) G_STMT_START {   \
+  type *_d = (type *) (data);                          \
+  type _t;                                             \
+  gint _i;                                             \
+  for (_i = 0; _i < (n); _i++) {                       \
+    _t = _d[2 * _i + 0];                               \
+    _d[2 * _i + 0] = _d[2 * _i + 1];                   \
+    _d[2 * _i + 1] = _t;                               \
+  }                                                    \
+} G_STMT_END
+
 static GstFlowReturn
 gst_audio_channel_mix_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 {
   GstAudioChannelMix *audiochannelmix = GST_AUDIO_CHANNEL_MIX (trans);
+  GstAudioInfo *info = GST_AUDIO_FILTER_INFO (audiochannelmix);
   int n;
   GstMapInfo map;
-  int i;
-  double ll = audiochannelmix->left_to_left;
-  double lr = audiochannelmix->left_to_right;
-  double rl = audiochannelmix->right_to_left;
-  double rr = audiochannelmix->right_to_right;
-  int l, r;
-  gint16 *data;
 
-  GST_DEBUG_OBJECT (audiochannelmix, "transform_ip");
+  GST_LOG_OBJECT (audiochannelmix, "transform_ip");
+
+  if (audiochannelmix->mode == GST_AUDIO_CHANNEL_MIX_MODE_UNITY)
+    return GST_FLOW_OK;
 
   gst_buffer_map (buf, &map, GST_MAP_WRITE | GST_MAP_READ);
 
-  n = gst_buffer_get_size (buf) >> 2;
-  data = (gint16 *) map.data;
-  for (i = 0; i < n; i++) {
-    l = data[2 * i + 0];
-    r = data[2 * i + 1];
-    data[2 * i + 0] = CLAMP (rint (ll * l + rl * r), -32768, 32767);
-    data[2 * i + 1] = CLAMP (rint (lr * l + rr * r), -32768, 32767);
+  n = map.size / GST_AUDIO_INFO_BPF (info);
+
+  switch (GST_AUDIO_INFO_FORMAT (info)) {
+    case GST_AUDIO_FORMAT_S16:
+      if (audiochannelmix->mode == GST_AUDIO_CHANNEL_MIX_MODE_SWAP)
+        SWAP_CHANNELS (gint16, map.data, n);
+      else
+        mix_s16 (audiochannelmix, (gint16 *) map.data, n);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      if (audiochannelmix->mode == GST_AUDIO_CHANNEL_MIX_MODE_SWAP)
+        SWAP_CHANNELS (gint32, map.data, n);
+      else
+        mix_s32 (audiochannelmix, (gint32 *) map.data, n);
+      break;
+    case GST_AUDIO_FORMAT_F32:
+      if (audiochannelmix->mode == GST_AUDIO_CHANNEL_MIX_MODE_SWAP)
+        SWAP_CHANNELS (gfloat, map.data, n);
+      else
+        mix_f32 (audiochannelmix, (gfloat *) map.data, n);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
   }
 
   gst_buffer_unmap (buf, &map);
@@ -33,6 +33,14 @@ G_BEGIN_DECLS
 typedef struct _GstAudioChannelMix GstAudioChannelMix;
 typedef struct _GstAudioChannelMixClass GstAudioChannelMixClass;
 
+typedef enum
+{
+  GST_AUDIO_CHANNEL_MIX_MODE_UNITY,
+  GST_AUDIO_CHANNEL_MIX_MODE_SWAP,
+  GST_AUDIO_CHANNEL_MIX_MODE_DOWNMIX,
+  GST_AUDIO_CHANNEL_MIX_MODE_MATRIX
+} GstAudioChannelMixMode;
+
 struct _GstAudioChannelMix
 {
   GstAudioFilter base_audiochannelmix;
@@ -41,6 +49,9 @@ struct _GstAudioChannelMix
   double left_to_right;
   double right_to_left;
   double right_to_right;
+
+  /* which of the kernels the gains allow */
+  GstAudioChannelMixMode mode;
 };
 
 struct _GstAudioChannelMixClass
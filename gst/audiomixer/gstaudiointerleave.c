@@ -131,7 +131,7 @@ GST_STATIC_PAD_TEMPLATE ("src",
         "rate = (int) [ 1, MAX ], "
         "channels = (int) [ 1, MAX ], "
         "format = (string) " GST_AUDIO_FORMATS_ALL ", "
-        "layout = (string) interleaved")
+        "layout = (string) {interleaved, non-interleaved}")
     );
 
 static void gst_audio_interleave_child_proxy_init (gpointer g_iface,
@@ -526,6 +526,11 @@ gst_audio_interleave_update_src_caps (GstAggregator * agg, GstCaps * caps,
       G_TYPE_STRING, "interleaved", "channel-mask", GST_TYPE_BITMASK,
       gst_audio_interleave_get_channel_mask (self), NULL);
 
+  /* only output planar audio if downstream wants nothing else, each channel
+   * is then copied in one block instead of sample by sample */
+  if (!gst_caps_can_intersect (caps, *ret))
+    gst_structure_set (s, "layout", G_TYPE_STRING, "non-interleaved", NULL);
+
   GST_OBJECT_UNLOCK (self);
 
   return GST_FLOW_OK;
@@ -541,6 +546,8 @@ gst_audio_interleave_negotiated_src_caps (GstAggregator * agg, GstCaps * caps)
     return FALSE;
 
   gst_audio_interleave_set_process_function (self, &aagg->info);
+  self->non_interleaved =
+      GST_AUDIO_INFO_LAYOUT (&aagg->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED;
 
   return TRUE;
 }
@@ -843,12 +850,17 @@ gst_audio_interleave_aggregate_one_buffer (GstAudioAggregator * aagg,
     channel = self->default_channels_ordering_map[pad->channel];
   }
 
-  outdata = outmap.data + (out_offset * out_bpf) + (out_width * channel);
-
+  if (self->non_interleaved) {
+    gsize plane_size = (outmap.size / out_bpf) * out_width;
 
-  self->func (outdata, inmap.data + (in_offset * in_bpf), out_channels,
-      num_frames);
+    outdata = outmap.data + (plane_size * channel) + (out_offset * out_width);
+    memcpy (outdata, inmap.data + (in_offset * in_bpf), num_frames * in_bpf);
+  } else {
+    outdata = outmap.data + (out_offset * out_bpf) + (out_width * channel);
 
+    self->func (outdata, inmap.data + (in_offset * in_bpf), out_channels,
+        num_frames);
+  }
 
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
@@ -67,6 +67,8 @@ struct _GstAudioInterleave {
   gint default_channels_ordering_map[64];
 
   GstInterleaveFunc func;
+  /* output channels are planes instead of interleaved samples */
+  gboolean non_interleaved;
 };
 
 struct _GstAudioInterleaveClass {
@@ -217,6 +217,9 @@ static gboolean
 gst_audiomixer_aggregate_one_buffer (GstAudioAggregator * aagg,
     GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
     GstBuffer * outbuf, guint out_offset, guint num_samples);
+static gboolean
+gst_audiomixer_aggregate_all_buffers (GstAudioAggregator * aagg,
+    GstAudioAggregatorInput * inputs, guint n_inputs, GstBuffer * outbuf);
 
 
 /* we can only accept caps that we and downstream can handle.
@@ -521,6 +524,7 @@ gst_audiomixer_class_init (GstAudioMixerClass * klass)
       GST_DEBUG_FUNCPTR (gst_audiomixer_update_src_caps);
 
   aagg_class->aggregate_one_buffer = gst_audiomixer_aggregate_one_buffer;
+  aagg_class->aggregate_all_buffers = gst_audiomixer_aggregate_all_buffers;
 }
 
 static void
@@ -762,6 +766,144 @@ gst_audiomixer_aggregate_one_buffer (GstAudioAggregator * aagg,
   return TRUE;
 }
 
+/* Mixes two inputs covering the same part of the output buffer in a single
+ * pass over it */
+static gboolean
+gst_audiomixer_aggregate_two_buffers (GstAudioAggregator * aagg,
+    GstAudioAggregatorInput * input1, GstAudioAggregatorInput * input2,
+    GstBuffer * outbuf)
+{
+  GstAudioMixerPad *pad1 = GST_AUDIO_MIXER_PAD (input1->pad);
+  GstAudioMixerPad *pad2 = GST_AUDIO_MIXER_PAD (input2->pad);
+  gboolean silent1, silent2;
+  gdouble volume1, volume2;
+  gint volume1_i16, volume2_i16;
+  gint volume1_i32, volume2_i32;
+  GstMapInfo inmap1, inmap2;
+  GstMapInfo outmap;
+  gpointer out, in1, in2;
+  guint num_samples;
+  gint bpf;
+
+  GST_OBJECT_LOCK (aagg);
+  GST_OBJECT_LOCK (pad1);
+  silent1 = pad1->mute || pad1->volume < G_MINDOUBLE;
+  volume1 = pad1->volume;
+  volume1_i16 = pad1->volume_i16;
+  volume1_i32 = pad1->volume_i32;
+  GST_OBJECT_UNLOCK (pad1);
+  GST_OBJECT_LOCK (pad2);
+  silent2 = pad2->mute || pad2->volume < G_MINDOUBLE;
+  volume2 = pad2->volume;
+  volume2_i16 = pad2->volume_i16;
+  volume2_i32 = pad2->volume_i32;
+  GST_OBJECT_UNLOCK (pad2);
+
+  if (silent1 || silent2) {
+    GST_OBJECT_UNLOCK (aagg);
+
+    if (!silent1)
+      return gst_audiomixer_aggregate_one_buffer (aagg, input1->pad,
+          input1->buffer, input1->in_offset, outbuf, input1->out_offset,
+          input1->num_frames);
+    if (!silent2)
+      return gst_audiomixer_aggregate_one_buffer (aagg, input2->pad,
+          input2->buffer, input2->in_offset, outbuf, input2->out_offset,
+          input2->num_frames);
+
+    GST_DEBUG_OBJECT (aagg, "Skipping two muted pads");
+    return FALSE;
+  }
+
+  bpf = GST_AUDIO_INFO_BPF (&aagg->info);
+  num_samples = input1->num_frames * aagg->info.channels;
+
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
+  gst_buffer_map (input1->buffer, &inmap1, GST_MAP_READ);
+  gst_buffer_map (input2->buffer, &inmap2, GST_MAP_READ);
+  GST_LOG_OBJECT (aagg, "mixing %u bytes at offset %u from pads %s and %s",
+      input1->num_frames * bpf, input1->out_offset * bpf,
+      GST_PAD_NAME (pad1), GST_PAD_NAME (pad2));
+
+  out = outmap.data + input1->out_offset * bpf;
+  in1 = inmap1.data + input1->in_offset * bpf;
+  in2 = inmap2.data + input2->in_offset * bpf;
+
+  switch (aagg->info.finfo->format) {
+    case GST_AUDIO_FORMAT_S16:
+      audiomixer_orc_add2_volume_s16 (out, in1, in2, volume1_i16,
+          volume2_i16, num_samples);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      audiomixer_orc_add2_volume_s32 (out, in1, in2, volume1_i32,
+          volume2_i32, num_samples);
+      break;
+    case GST_AUDIO_FORMAT_F32:
+      audiomixer_orc_add2_volume_f32 (out, in1, in2, volume1, volume2,
+          num_samples);
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      audiomixer_orc_add2_volume_f64 (out, in1, in2, volume1, volume2,
+          num_samples);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+
+  gst_buffer_unmap (input2->buffer, &inmap2);
+  gst_buffer_unmap (input1->buffer, &inmap1);
+  gst_buffer_unmap (outbuf, &outmap);
+
+  GST_OBJECT_UNLOCK (aagg);
+
+  return TRUE;
+}
+
+static gboolean
+gst_audiomixer_aggregate_all_buffers (GstAudioAggregator * aagg,
+    GstAudioAggregatorInput * inputs, guint n_inputs, GstBuffer * outbuf)
+{
+  gboolean filled = FALSE;
+  gboolean can_fuse;
+  guint i;
+
+  GST_OBJECT_LOCK (aagg);
+  switch (GST_AUDIO_INFO_FORMAT (&aagg->info)) {
+    case GST_AUDIO_FORMAT_S16:
+    case GST_AUDIO_FORMAT_S32:
+    case GST_AUDIO_FORMAT_F32:
+    case GST_AUDIO_FORMAT_F64:
+      can_fuse = TRUE;
+      break;
+    default:
+      can_fuse = FALSE;
+      break;
+  }
+  GST_OBJECT_UNLOCK (aagg);
+
+  /* Mix the inputs two at a time where they cover the same part of the
+   * output, so the output is only read and written once per pair. The
+   * intermediate clipping is the same as when mixing one by one. */
+  for (i = 0; i < n_inputs; i++) {
+    GstAudioAggregatorInput *input = &inputs[i];
+    GstAudioAggregatorInput *next = i + 1 < n_inputs ? &inputs[i + 1] : NULL;
+
+    if (can_fuse && next && input->out_offset == next->out_offset &&
+        input->num_frames == next->num_frames) {
+      filled |= gst_audiomixer_aggregate_two_buffers (aagg, input, next,
+          outbuf);
+      i++;
+    } else {
+      filled |= gst_audiomixer_aggregate_one_buffer (aagg, input->pad,
+          input->buffer, input->in_offset, outbuf, input->out_offset,
+          input->num_frames);
+    }
+  }
+
+  return filled;
+}
+
 
 /* GstChildProxy implementation */
 static GObject *
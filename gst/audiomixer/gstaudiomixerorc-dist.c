@@ -128,6 +128,18 @@ void audiomixer_orc_add_volume_f32 (float *ORC_RESTRICT d1,
     const float *ORC_RESTRICT s1, float p1, int n);
 void audiomixer_orc_add_volume_f64 (double *ORC_RESTRICT d1,
     const double *ORC_RESTRICT s1, double p1, int n);
+void audiomixer_orc_add2_volume_s16 (gint16 * ORC_RESTRICT d1,
+    const gint16 * ORC_RESTRICT s1, const gint16 * ORC_RESTRICT s2,
+    int p1, int p2, int n);
+void audiomixer_orc_add2_volume_s32 (gint32 * ORC_RESTRICT d1,
+    const gint32 * ORC_RESTRICT s1, const gint32 * ORC_RESTRICT s2,
+    int p1, int p2, int n);
+void audiomixer_orc_add2_volume_f32 (float *ORC_RESTRICT d1,
+    const float *ORC_RESTRICT s1, const float *ORC_RESTRICT s2,
+    float p1, float p2, int n);
+void audiomixer_orc_add2_volume_f64 (double *ORC_RESTRICT d1,
+    const double *ORC_RESTRICT s1, const double *ORC_RESTRICT s2,
+    double p1, double p2, int n);
 
 
 /* begin Orc C target preamble */
@@ -2603,3 +2615,911 @@ audiomixer_orc_add_volume_f64 (double *ORC_RESTRICT d1,
   func (ex);
 }
 #endif
+
+
+/* audiomixer_orc_add2_volume_s16 */
+#ifdef DISABLE_ORC
+void
+audiomixer_orc_add2_volume_s16 (gint16 * ORC_RESTRICT d1,
+    const gint16 * ORC_RESTRICT s1, const gint16 * ORC_RESTRICT s2,
+    int p1, int p2, int n)
+{
+  int i;
+  orc_union16 *ORC_RESTRICT ptr0;
+  const orc_union16 *ORC_RESTRICT ptr4;
+  const orc_union16 *ORC_RESTRICT ptr5;
+  orc_union16 var35;
+  orc_union16 var36;
+  orc_union16 var37;
+  orc_union16 var38;
+  orc_union16 var39;
+  orc_union16 var40;
+  orc_union32 var41;
+  orc_union32 var42;
+  orc_union16 var43;
+  orc_union16 var44;
+  orc_union32 var45;
+  orc_union32 var46;
+  orc_union16 var47;
+
+  ptr0 = (orc_union16 *) d1;
+  ptr4 = (orc_union16 *) s1;
+  ptr5 = (orc_union16 *) s2;
+
+  /* 1: loadpw */
+  var36.i = p1;
+  /* 9: loadpw */
+  var39.i = p2;
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadw */
+    var35 = ptr4[i];
+    /* 2: mulswl */
+    var41.i = var35.i * var36.i;
+    /* 3: shrsl */
+    var42.i = var41.i >> 11;
+    /* 4: convssslw */
+    var43.i = ORC_CLAMP_SW (var42.i);
+    /* 5: loadw */
+    var37 = ptr0[i];
+    /* 6: addssw */
+    var44.i = ORC_CLAMP_SW (var37.i + var43.i);
+    /* 7: loadw */
+    var38 = ptr5[i];
+    /* 8: mulswl */
+    var45.i = var38.i * var39.i;
+    /* 10: shrsl */
+    var46.i = var45.i >> 11;
+    /* 11: convssslw */
+    var47.i = ORC_CLAMP_SW (var46.i);
+    /* 12: addssw */
+    var40.i = ORC_CLAMP_SW (var44.i + var47.i);
+    /* 13: storew */
+    ptr0[i] = var40;
+  }
+
+}
+
+#else
+static void
+_backup_audiomixer_orc_add2_volume_s16 (OrcExecutor * ORC_RESTRICT ex)
+{
+  int i;
+  int n = ex->n;
+  orc_union16 *ORC_RESTRICT ptr0;
+  const orc_union16 *ORC_RESTRICT ptr4;
+  const orc_union16 *ORC_RESTRICT ptr5;
+  orc_union16 var35;
+  orc_union16 var36;
+  orc_union16 var37;
+  orc_union16 var38;
+  orc_union16 var39;
+  orc_union16 var40;
+  orc_union32 var41;
+  orc_union32 var42;
+  orc_union16 var43;
+  orc_union16 var44;
+  orc_union32 var45;
+  orc_union32 var46;
+  orc_union16 var47;
+
+  ptr0 = (orc_union16 *) ex->arrays[0];
+  ptr4 = (orc_union16 *) ex->arrays[4];
+  ptr5 = (orc_union16 *) ex->arrays[5];
+
+  /* 1: loadpw */
+  var36.i = ex->params[24];
+  /* 9: loadpw */
+  var39.i = ex->params[25];
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadw */
+    var35 = ptr4[i];
+    /* 2: mulswl */
+    var41.i = var35.i * var36.i;
+    /* 3: shrsl */
+    var42.i = var41.i >> 11;
+    /* 4: convssslw */
+    var43.i = ORC_CLAMP_SW (var42.i);
+    /* 5: loadw */
+    var37 = ptr0[i];
+    /* 6: addssw */
+    var44.i = ORC_CLAMP_SW (var37.i + var43.i);
+    /* 7: loadw */
+    var38 = ptr5[i];
+    /* 8: mulswl */
+    var45.i = var38.i * var39.i;
+    /* 10: shrsl */
+    var46.i = var45.i >> 11;
+    /* 11: convssslw */
+    var47.i = ORC_CLAMP_SW (var46.i);
+    /* 12: addssw */
+    var40.i = ORC_CLAMP_SW (var44.i + var47.i);
+    /* 13: storew */
+    ptr0[i] = var40;
+  }
+
+}
+
+void
+audiomixer_orc_add2_volume_s16 (gint16 * ORC_RESTRICT d1,
+    const gint16 * ORC_RESTRICT s1, const gint16 * ORC_RESTRICT s2,
+    int p1, int p2, int n)
+{
+  OrcExecutor _ex, *ex = &_ex;
+  static volatile int p_inited = 0;
+  static OrcCode *c = 0;
+  void (*func) (OrcExecutor *);
+
+  if (!p_inited) {
+    orc_once_mutex_lock ();
+    if (!p_inited) {
+      OrcProgram *p;
+
+#if 1
+      static const orc_uint8 bc[] = {
+        1, 9, 30, 97, 117, 100, 105, 111, 109, 105, 120, 101, 114, 95, 111, 114,
+        99, 95, 97, 100, 100, 50, 95, 118, 111, 108, 117, 109, 101, 95, 115, 49,
+        54, 11, 2, 2, 12, 2, 2, 12, 2, 2, 14, 4, 11, 0, 0, 0,
+        16, 2, 16, 2, 20, 4, 20, 2, 20, 2, 176, 32, 4, 24, 125, 32,
+        32, 16, 165, 33, 32, 71, 33, 0, 33, 176, 32, 5, 25, 125, 32, 32,
+        16, 165, 34, 32, 71, 0, 33, 34, 2, 0,
+      };
+      p = orc_program_new_from_static_bytecode (bc);
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_s16);
+#else
+      p = orc_program_new ();
+      orc_program_set_name (p, "audiomixer_orc_add2_volume_s16");
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_s16);
+      orc_program_add_destination (p, 2, "d1");
+      orc_program_add_source (p, 2, "s1");
+      orc_program_add_source (p, 2, "s2");
+      orc_program_add_constant (p, 4, 0x0000000b, "c1");
+      orc_program_add_parameter (p, 2, "p1");
+      orc_program_add_parameter (p, 2, "p2");
+      orc_program_add_temporary (p, 4, "t1");
+      orc_program_add_temporary (p, 2, "t2");
+      orc_program_add_temporary (p, 2, "t3");
+
+      orc_program_append_2 (p, "mulswl", 0, ORC_VAR_T1, ORC_VAR_S1, ORC_VAR_P1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "shrsl", 0, ORC_VAR_T1, ORC_VAR_T1, ORC_VAR_C1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "convssslw", 0, ORC_VAR_T2, ORC_VAR_T1,
+          ORC_VAR_D1, ORC_VAR_D1);
+      orc_program_append_2 (p, "addssw", 0, ORC_VAR_T2, ORC_VAR_D1, ORC_VAR_T2,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "mulswl", 0, ORC_VAR_T1, ORC_VAR_S2, ORC_VAR_P2,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "shrsl", 0, ORC_VAR_T1, ORC_VAR_T1, ORC_VAR_C1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "convssslw", 0, ORC_VAR_T3, ORC_VAR_T1,
+          ORC_VAR_D1, ORC_VAR_D1);
+      orc_program_append_2 (p, "addssw", 0, ORC_VAR_D1, ORC_VAR_T2, ORC_VAR_T3,
+          ORC_VAR_D1);
+#endif
+
+      orc_program_compile (p);
+      c = orc_program_take_code (p);
+      orc_program_free (p);
+    }
+    p_inited = TRUE;
+    orc_once_mutex_unlock ();
+  }
+  ex->arrays[ORC_VAR_A2] = c;
+  ex->program = 0;
+
+  ex->n = n;
+  ex->arrays[ORC_VAR_D1] = d1;
+  ex->arrays[ORC_VAR_S1] = (void *) s1;
+  ex->arrays[ORC_VAR_S2] = (void *) s2;
+  ex->params[ORC_VAR_P1] = p1;
+  ex->params[ORC_VAR_P2] = p2;
+
+  func = c->exec;
+  func (ex);
+}
+#endif
+
+
+/* audiomixer_orc_add2_volume_s32 */
+#ifdef DISABLE_ORC
+void
+audiomixer_orc_add2_volume_s32 (gint32 * ORC_RESTRICT d1,
+    const gint32 * ORC_RESTRICT s1, const gint32 * ORC_RESTRICT s2,
+    int p1, int p2, int n)
+{
+  int i;
+  orc_union32 *ORC_RESTRICT ptr0;
+  const orc_union32 *ORC_RESTRICT ptr4;
+  const orc_union32 *ORC_RESTRICT ptr5;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+  orc_union32 var38;
+  orc_union32 var39;
+  orc_union32 var40;
+  orc_union64 var41;
+  orc_union64 var42;
+  orc_union32 var43;
+  orc_union32 var44;
+  orc_union64 var45;
+  orc_union64 var46;
+  orc_union32 var47;
+
+  ptr0 = (orc_union32 *) d1;
+  ptr4 = (orc_union32 *) s1;
+  ptr5 = (orc_union32 *) s2;
+
+  /* 1: loadpl */
+  var36.i = p1;
+  /* 9: loadpl */
+  var39.i = p2;
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadl */
+    var35 = ptr4[i];
+    /* 2: mulslq */
+    var41.i = ((orc_int64) var35.i) * ((orc_int64) var36.i);
+    /* 3: shrsq */
+    var42.i = var41.i >> 27;
+    /* 4: convsssql */
+    var43.i = ORC_CLAMP_SL (var42.i);
+    /* 5: loadl */
+    var37 = ptr0[i];
+    /* 6: addssl */
+    var44.i = ORC_CLAMP_SL ((orc_int64) var37.i + (orc_int64) var43.i);
+    /* 7: loadl */
+    var38 = ptr5[i];
+    /* 8: mulslq */
+    var45.i = ((orc_int64) var38.i) * ((orc_int64) var39.i);
+    /* 10: shrsq */
+    var46.i = var45.i >> 27;
+    /* 11: convsssql */
+    var47.i = ORC_CLAMP_SL (var46.i);
+    /* 12: addssl */
+    var40.i = ORC_CLAMP_SL ((orc_int64) var44.i + (orc_int64) var47.i);
+    /* 13: storel */
+    ptr0[i] = var40;
+  }
+
+}
+
+#else
+static void
+_backup_audiomixer_orc_add2_volume_s32 (OrcExecutor * ORC_RESTRICT ex)
+{
+  int i;
+  int n = ex->n;
+  orc_union32 *ORC_RESTRICT ptr0;
+  const orc_union32 *ORC_RESTRICT ptr4;
+  const orc_union32 *ORC_RESTRICT ptr5;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+  orc_union32 var38;
+  orc_union32 var39;
+  orc_union32 var40;
+  orc_union64 var41;
+  orc_union64 var42;
+  orc_union32 var43;
+  orc_union32 var44;
+  orc_union64 var45;
+  orc_union64 var46;
+  orc_union32 var47;
+
+  ptr0 = (orc_union32 *) ex->arrays[0];
+  ptr4 = (orc_union32 *) ex->arrays[4];
+  ptr5 = (orc_union32 *) ex->arrays[5];
+
+  /* 1: loadpl */
+  var36.i = ex->params[24];
+  /* 9: loadpl */
+  var39.i = ex->params[25];
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadl */
+    var35 = ptr4[i];
+    /* 2: mulslq */
+    var41.i = ((orc_int64) var35.i) * ((orc_int64) var36.i);
+    /* 3: shrsq */
+    var42.i = var41.i >> 27;
+    /* 4: convsssql */
+    var43.i = ORC_CLAMP_SL (var42.i);
+    /* 5: loadl */
+    var37 = ptr0[i];
+    /* 6: addssl */
+    var44.i = ORC_CLAMP_SL ((orc_int64) var37.i + (orc_int64) var43.i);
+    /* 7: loadl */
+    var38 = ptr5[i];
+    /* 8: mulslq */
+    var45.i = ((orc_int64) var38.i) * ((orc_int64) var39.i);
+    /* 10: shrsq */
+    var46.i = var45.i >> 27;
+    /* 11: convsssql */
+    var47.i = ORC_CLAMP_SL (var46.i);
+    /* 12: addssl */
+    var40.i = ORC_CLAMP_SL ((orc_int64) var44.i + (orc_int64) var47.i);
+    /* 13: storel */
+    ptr0[i] = var40;
+  }
+
+}
+
+void
+audiomixer_orc_add2_volume_s32 (gint32 * ORC_RESTRICT d1,
+    const gint32 * ORC_RESTRICT s1, const gint32 * ORC_RESTRICT s2,
+    int p1, int p2, int n)
+{
+  OrcExecutor _ex, *ex = &_ex;
+  static volatile int p_inited = 0;
+  static OrcCode *c = 0;
+  void (*func) (OrcExecutor *);
+
+  if (!p_inited) {
+    orc_once_mutex_lock ();
+    if (!p_inited) {
+      OrcProgram *p;
+
+#if 1
+      static const orc_uint8 bc[] = {
+        1, 9, 30, 97, 117, 100, 105, 111, 109, 105, 120, 101, 114, 95, 111, 114,
+        99, 95, 97, 100, 100, 50, 95, 118, 111, 108, 117, 109, 101, 95, 115, 51,
+        50, 11, 4, 4, 12, 4, 4, 12, 4, 4, 15, 8, 27, 0, 0, 0,
+        0, 0, 0, 0, 16, 4, 16, 4, 20, 8, 20, 4, 20, 4, 178, 32,
+        4, 24, 147, 32, 32, 16, 170, 33, 32, 104, 33, 0, 33, 178, 32, 5,
+        25, 147, 32, 32, 16, 170, 34, 32, 104, 0, 33, 34, 2, 0,
+      };
+      p = orc_program_new_from_static_bytecode (bc);
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_s32);
+#else
+      p = orc_program_new ();
+      orc_program_set_name (p, "audiomixer_orc_add2_volume_s32");
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_s32);
+      orc_program_add_destination (p, 4, "d1");
+      orc_program_add_source (p, 4, "s1");
+      orc_program_add_source (p, 4, "s2");
+      orc_program_add_constant_int64 (p, 8, 0x000000000000001bULL, "c1");
+      orc_program_add_parameter (p, 4, "p1");
+      orc_program_add_parameter (p, 4, "p2");
+      orc_program_add_temporary (p, 8, "t1");
+      orc_program_add_temporary (p, 4, "t2");
+      orc_program_add_temporary (p, 4, "t3");
+
+      orc_program_append_2 (p, "mulslq", 0, ORC_VAR_T1, ORC_VAR_S1, ORC_VAR_P1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "shrsq", 0, ORC_VAR_T1, ORC_VAR_T1, ORC_VAR_C1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "convsssql", 0, ORC_VAR_T2, ORC_VAR_T1,
+          ORC_VAR_D1, ORC_VAR_D1);
+      orc_program_append_2 (p, "addssl", 0, ORC_VAR_T2, ORC_VAR_D1, ORC_VAR_T2,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "mulslq", 0, ORC_VAR_T1, ORC_VAR_S2, ORC_VAR_P2,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "shrsq", 0, ORC_VAR_T1, ORC_VAR_T1, ORC_VAR_C1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "convsssql", 0, ORC_VAR_T3, ORC_VAR_T1,
+          ORC_VAR_D1, ORC_VAR_D1);
+      orc_program_append_2 (p, "addssl", 0, ORC_VAR_D1, ORC_VAR_T2, ORC_VAR_T3,
+          ORC_VAR_D1);
+#endif
+
+      orc_program_compile (p);
+      c = orc_program_take_code (p);
+      orc_program_free (p);
+    }
+    p_inited = TRUE;
+    orc_once_mutex_unlock ();
+  }
+  ex->arrays[ORC_VAR_A2] = c;
+  ex->program = 0;
+
+  ex->n = n;
+  ex->arrays[ORC_VAR_D1] = d1;
+  ex->arrays[ORC_VAR_S1] = (void *) s1;
+  ex->arrays[ORC_VAR_S2] = (void *) s2;
+  ex->params[ORC_VAR_P1] = p1;
+  ex->params[ORC_VAR_P2] = p2;
+
+  func = c->exec;
+  func (ex);
+}
+#endif
+
+
+/* audiomixer_orc_add2_volume_f32 */
+#ifdef DISABLE_ORC
+void
+audiomixer_orc_add2_volume_f32 (float *ORC_RESTRICT d1,
+    const float *ORC_RESTRICT s1, const float *ORC_RESTRICT s2,
+    float p1, float p2, int n)
+{
+  int i;
+  orc_union32 *ORC_RESTRICT ptr0;
+  const orc_union32 *ORC_RESTRICT ptr4;
+  const orc_union32 *ORC_RESTRICT ptr5;
+  orc_union32 var33;
+  orc_union32 var34;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+  orc_union32 var38;
+  orc_union32 var39;
+  orc_union32 var40;
+  orc_union32 var41;
+
+  ptr0 = (orc_union32 *) d1;
+  ptr4 = (orc_union32 *) s1;
+  ptr5 = (orc_union32 *) s2;
+
+  /* 1: loadpl */
+  var34.f = p1;
+  /* 5: loadpl */
+  var37.f = p2;
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadl */
+    var33 = ptr4[i];
+    /* 2: mulf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var33.i);
+      _src2.i = ORC_DENORMAL (var34.i);
+      _dest1.f = _src1.f * _src2.f;
+      var39.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 3: loadl */
+    var35 = ptr0[i];
+    /* 4: addf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var35.i);
+      _src2.i = ORC_DENORMAL (var39.i);
+      _dest1.f = _src1.f + _src2.f;
+      var40.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 6: loadl */
+    var36 = ptr5[i];
+    /* 7: mulf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var36.i);
+      _src2.i = ORC_DENORMAL (var37.i);
+      _dest1.f = _src1.f * _src2.f;
+      var41.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 8: addf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var40.i);
+      _src2.i = ORC_DENORMAL (var41.i);
+      _dest1.f = _src1.f + _src2.f;
+      var38.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 9: storel */
+    ptr0[i] = var38;
+  }
+
+}
+
+#else
+static void
+_backup_audiomixer_orc_add2_volume_f32 (OrcExecutor * ORC_RESTRICT ex)
+{
+  int i;
+  int n = ex->n;
+  orc_union32 *ORC_RESTRICT ptr0;
+  const orc_union32 *ORC_RESTRICT ptr4;
+  const orc_union32 *ORC_RESTRICT ptr5;
+  orc_union32 var33;
+  orc_union32 var34;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+  orc_union32 var38;
+  orc_union32 var39;
+  orc_union32 var40;
+  orc_union32 var41;
+
+  ptr0 = (orc_union32 *) ex->arrays[0];
+  ptr4 = (orc_union32 *) ex->arrays[4];
+  ptr5 = (orc_union32 *) ex->arrays[5];
+
+  /* 1: loadpl */
+  var34.i = ex->params[24];
+  /* 5: loadpl */
+  var37.i = ex->params[25];
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadl */
+    var33 = ptr4[i];
+    /* 2: mulf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var33.i);
+      _src2.i = ORC_DENORMAL (var34.i);
+      _dest1.f = _src1.f * _src2.f;
+      var39.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 3: loadl */
+    var35 = ptr0[i];
+    /* 4: addf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var35.i);
+      _src2.i = ORC_DENORMAL (var39.i);
+      _dest1.f = _src1.f + _src2.f;
+      var40.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 6: loadl */
+    var36 = ptr5[i];
+    /* 7: mulf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var36.i);
+      _src2.i = ORC_DENORMAL (var37.i);
+      _dest1.f = _src1.f * _src2.f;
+      var41.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 8: addf */
+    {
+      orc_union32 _src1;
+      orc_union32 _src2;
+      orc_union32 _dest1;
+      _src1.i = ORC_DENORMAL (var40.i);
+      _src2.i = ORC_DENORMAL (var41.i);
+      _dest1.f = _src1.f + _src2.f;
+      var38.i = ORC_DENORMAL (_dest1.i);
+    }
+    /* 9: storel */
+    ptr0[i] = var38;
+  }
+
+}
+
+void
+audiomixer_orc_add2_volume_f32 (float *ORC_RESTRICT d1,
+    const float *ORC_RESTRICT s1, const float *ORC_RESTRICT s2,
+    float p1, float p2, int n)
+{
+  OrcExecutor _ex, *ex = &_ex;
+  static volatile int p_inited = 0;
+  static OrcCode *c = 0;
+  void (*func) (OrcExecutor *);
+
+  if (!p_inited) {
+    orc_once_mutex_lock ();
+    if (!p_inited) {
+      OrcProgram *p;
+
+#if 1
+      static const orc_uint8 bc[] = {
+        1, 9, 30, 97, 117, 100, 105, 111, 109, 105, 120, 101, 114, 95, 111, 114,
+        99, 95, 97, 100, 100, 50, 95, 118, 111, 108, 117, 109, 101, 95, 102, 51,
+        50, 11, 4, 4, 12, 4, 4, 12, 4, 4, 17, 4, 17, 4, 20, 4,
+        20, 4, 202, 32, 4, 24, 200, 33, 0, 32, 202, 32, 5, 25, 200, 0,
+        33, 32, 2, 0,
+      };
+      p = orc_program_new_from_static_bytecode (bc);
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_f32);
+#else
+      p = orc_program_new ();
+      orc_program_set_name (p, "audiomixer_orc_add2_volume_f32");
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_f32);
+      orc_program_add_destination (p, 4, "d1");
+      orc_program_add_source (p, 4, "s1");
+      orc_program_add_source (p, 4, "s2");
+      orc_program_add_parameter_float (p, 4, "p1");
+      orc_program_add_parameter_float (p, 4, "p2");
+      orc_program_add_temporary (p, 4, "t1");
+      orc_program_add_temporary (p, 4, "t2");
+
+      orc_program_append_2 (p, "mulf", 0, ORC_VAR_T1, ORC_VAR_S1, ORC_VAR_P1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "addf", 0, ORC_VAR_T2, ORC_VAR_D1, ORC_VAR_T1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "mulf", 0, ORC_VAR_T1, ORC_VAR_S2, ORC_VAR_P2,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "addf", 0, ORC_VAR_D1, ORC_VAR_T2, ORC_VAR_T1,
+          ORC_VAR_D1);
+#endif
+
+      orc_program_compile (p);
+      c = orc_program_take_code (p);
+      orc_program_free (p);
+    }
+    p_inited = TRUE;
+    orc_once_mutex_unlock ();
+  }
+  ex->arrays[ORC_VAR_A2] = c;
+  ex->program = 0;
+
+  ex->n = n;
+  ex->arrays[ORC_VAR_D1] = d1;
+  ex->arrays[ORC_VAR_S1] = (void *) s1;
+  ex->arrays[ORC_VAR_S2] = (void *) s2;
+  {
+    orc_union32 tmp;
+    tmp.f = p1;
+    ex->params[ORC_VAR_P1] = tmp.i;
+  }
+  {
+    orc_union32 tmp;
+    tmp.f = p2;
+    ex->params[ORC_VAR_P2] = tmp.i;
+  }
+
+  func = c->exec;
+  func (ex);
+}
+#endif
+
+
+/* audiomixer_orc_add2_volume_f64 */
+#ifdef DISABLE_ORC
+void
+audiomixer_orc_add2_volume_f64 (double *ORC_RESTRICT d1,
+    const double *ORC_RESTRICT s1, const double *ORC_RESTRICT s2,
+    double p1, double p2, int n)
+{
+  int i;
+  orc_union64 *ORC_RESTRICT ptr0;
+  const orc_union64 *ORC_RESTRICT ptr4;
+  const orc_union64 *ORC_RESTRICT ptr5;
+  orc_union64 var33;
+  orc_union64 var34;
+  orc_union64 var35;
+  orc_union64 var36;
+  orc_union64 var37;
+  orc_union64 var38;
+  orc_union64 var39;
+  orc_union64 var40;
+  orc_union64 var41;
+
+  ptr0 = (orc_union64 *) d1;
+  ptr4 = (orc_union64 *) s1;
+  ptr5 = (orc_union64 *) s2;
+
+  /* 1: loadpq */
+  var34.f = p1;
+  /* 5: loadpq */
+  var37.f = p2;
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadq */
+    var33 = ptr4[i];
+    /* 2: muld */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var33.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var34.i);
+      _dest1.f = _src1.f * _src2.f;
+      var39.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 3: loadq */
+    var35 = ptr0[i];
+    /* 4: addd */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var35.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var39.i);
+      _dest1.f = _src1.f + _src2.f;
+      var40.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 6: loadq */
+    var36 = ptr5[i];
+    /* 7: muld */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var36.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var37.i);
+      _dest1.f = _src1.f * _src2.f;
+      var41.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 8: addd */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var40.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var41.i);
+      _dest1.f = _src1.f + _src2.f;
+      var38.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 9: storeq */
+    ptr0[i] = var38;
+  }
+
+}
+
+#else
+static void
+_backup_audiomixer_orc_add2_volume_f64 (OrcExecutor * ORC_RESTRICT ex)
+{
+  int i;
+  int n = ex->n;
+  orc_union64 *ORC_RESTRICT ptr0;
+  const orc_union64 *ORC_RESTRICT ptr4;
+  const orc_union64 *ORC_RESTRICT ptr5;
+  orc_union64 var33;
+  orc_union64 var34;
+  orc_union64 var35;
+  orc_union64 var36;
+  orc_union64 var37;
+  orc_union64 var38;
+  orc_union64 var39;
+  orc_union64 var40;
+  orc_union64 var41;
+
+  ptr0 = (orc_union64 *) ex->arrays[0];
+  ptr4 = (orc_union64 *) ex->arrays[4];
+  ptr5 = (orc_union64 *) ex->arrays[5];
+
+  /* 1: loadpq */
+  var34.i =
+      (ex->params[24] & 0xffffffff) | ((orc_uint64) (ex->params[24 +
+              (ORC_VAR_T1 - ORC_VAR_P1)]) << 32);
+  /* 5: loadpq */
+  var37.i =
+      (ex->params[25] & 0xffffffff) | ((orc_uint64) (ex->params[25 +
+              (ORC_VAR_T1 - ORC_VAR_P1)]) << 32);
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadq */
+    var33 = ptr4[i];
+    /* 2: muld */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var33.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var34.i);
+      _dest1.f = _src1.f * _src2.f;
+      var39.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 3: loadq */
+    var35 = ptr0[i];
+    /* 4: addd */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var35.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var39.i);
+      _dest1.f = _src1.f + _src2.f;
+      var40.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 6: loadq */
+    var36 = ptr5[i];
+    /* 7: muld */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var36.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var37.i);
+      _dest1.f = _src1.f * _src2.f;
+      var41.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 8: addd */
+    {
+      orc_union64 _src1;
+      orc_union64 _src2;
+      orc_union64 _dest1;
+      _src1.i = ORC_DENORMAL_DOUBLE (var40.i);
+      _src2.i = ORC_DENORMAL_DOUBLE (var41.i);
+      _dest1.f = _src1.f + _src2.f;
+      var38.i = ORC_DENORMAL_DOUBLE (_dest1.i);
+    }
+    /* 9: storeq */
+    ptr0[i] = var38;
+  }
+
+}
+
+void
+audiomixer_orc_add2_volume_f64 (double *ORC_RESTRICT d1,
+    const double *ORC_RESTRICT s1, const double *ORC_RESTRICT s2,
+    double p1, double p2, int n)
+{
+  OrcExecutor _ex, *ex = &_ex;
+  static volatile int p_inited = 0;
+  static OrcCode *c = 0;
+  void (*func) (OrcExecutor *);
+
+  if (!p_inited) {
+    orc_once_mutex_lock ();
+    if (!p_inited) {
+      OrcProgram *p;
+
+#if 1
+      static const orc_uint8 bc[] = {
+        1, 9, 30, 97, 117, 100, 105, 111, 109, 105, 120, 101, 114, 95, 111, 114,
+        99, 95, 97, 100, 100, 50, 95, 118, 111, 108, 117, 109, 101, 95, 102, 54,
+        52, 11, 8, 8, 12, 8, 8, 12, 8, 8, 18, 8, 18, 8, 20, 8,
+        20, 8, 214, 32, 4, 24, 212, 33, 0, 32, 214, 32, 5, 25, 212, 0,
+        33, 32, 2, 0,
+      };
+      p = orc_program_new_from_static_bytecode (bc);
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_f64);
+#else
+      p = orc_program_new ();
+      orc_program_set_name (p, "audiomixer_orc_add2_volume_f64");
+      orc_program_set_backup_function (p,
+          _backup_audiomixer_orc_add2_volume_f64);
+      orc_program_add_destination (p, 8, "d1");
+      orc_program_add_source (p, 8, "s1");
+      orc_program_add_source (p, 8, "s2");
+      orc_program_add_parameter_double (p, 8, "p1");
+      orc_program_add_parameter_double (p, 8, "p2");
+      orc_program_add_temporary (p, 8, "t1");
+      orc_program_add_temporary (p, 8, "t2");
+
+      orc_program_append_2 (p, "muld", 0, ORC_VAR_T1, ORC_VAR_S1, ORC_VAR_P1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "addd", 0, ORC_VAR_T2, ORC_VAR_D1, ORC_VAR_T1,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "muld", 0, ORC_VAR_T1, ORC_VAR_S2, ORC_VAR_P2,
+          ORC_VAR_D1);
+      orc_program_append_2 (p, "addd", 0, ORC_VAR_D1, ORC_VAR_T2, ORC_VAR_T1,
+          ORC_VAR_D1);
+#endif
+
+      orc_program_compile (p);
+      c = orc_program_take_code (p);
+      orc_program_free (p);
+    }
+    p_inited = TRUE;
+    orc_once_mutex_unlock ();
+  }
+  ex->arrays[ORC_VAR_A2] = c;
+  ex->program = 0;
+
+  ex->n = n;
+  ex->arrays[ORC_VAR_D1] = d1;
+  ex->arrays[ORC_VAR_S1] = (void *) s1;
+  ex->arrays[ORC_VAR_S2] = (void *) s2;
+  {
+    orc_union64 tmp;
+    tmp.f = p1;
+    ex->params[ORC_VAR_P1] = ((orc_uint64) tmp.i) & 0xffffffff;
+    ex->params[ORC_VAR_T1] = ((orc_uint64) tmp.i) >> 32;
+  }
+  {
+    orc_union64 tmp;
+    tmp.f = p2;
+    ex->params[ORC_VAR_P2] = ((orc_uint64) tmp.i) & 0xffffffff;
+    ex->params[ORC_VAR_T2] = ((orc_uint64) tmp.i) >> 32;
+  }
+
+  func = c->exec;
+  func (ex);
+}
+#endif
@@ -97,6 +97,10 @@ void audiomixer_orc_add_volume_u32 (guint32 * ORC_RESTRICT d1, const guint32 * O
 void audiomixer_orc_add_volume_s32 (gint32 * ORC_RESTRICT d1, const gint32 * ORC_RESTRICT s1, int p1, int n);
 void audiomixer_orc_add_volume_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, float p1, int n);
 void audiomixer_orc_add_volume_f64 (double * ORC_RESTRICT d1, const double * ORC_RESTRICT s1, double p1, int n);
+void audiomixer_orc_add2_volume_s16 (gint16 * ORC_RESTRICT d1, const gint16 * ORC_RESTRICT s1, const gint16 * ORC_RESTRICT s2, int p1, int p2, int n);
+void audiomixer_orc_add2_volume_s32 (gint32 * ORC_RESTRICT d1, const gint32 * ORC_RESTRICT s1, const gint32 * ORC_RESTRICT s2, int p1, int p2, int n);
+void audiomixer_orc_add2_volume_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, const float * ORC_RESTRICT s2, float p1, float p2, int n);
+void audiomixer_orc_add2_volume_f64 (double * ORC_RESTRICT d1, const double * ORC_RESTRICT s1, const double * ORC_RESTRICT s2, double p1, double p2, int n);
 
 #ifdef __cplusplus
 }
@@ -228,6 +228,25 @@ gst_audio_mix_matrix_init (GstAudioMixMatrix * self)
   self->s16_conv_matrix = NULL;
   self->s32_conv_matrix = NULL;
   self->mode = GST_AUDIO_MIX_MATRIX_MODE_MANUAL;
+  self->routing = GST_AUDIO_MIX_MATRIX_ROUTING_DENSE;
+  self->gather_map = NULL;
+  self->sparse_offsets = NULL;
+  self->sparse_inputs = NULL;
+  self->transposed_matrix = NULL;
+}
+
+static void
+gst_audio_mix_matrix_clear_routing (GstAudioMixMatrix * self)
+{
+  g_free (self->gather_map);
+  self->gather_map = NULL;
+  g_free (self->sparse_offsets);
+  self->sparse_offsets = NULL;
+  g_free (self->sparse_inputs);
+  self->sparse_inputs = NULL;
+  g_free (self->transposed_matrix);
+  self->transposed_matrix = NULL;
+  self->routing = GST_AUDIO_MIX_MATRIX_ROUTING_DENSE;
 }
 
 static void
@@ -240,9 +259,93 @@ gst_audio_mix_matrix_dispose (GObject * object)
     self->matrix = NULL;
   }
 
+  gst_audio_mix_matrix_clear_routing (self);
+
   G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
 }
 
+/* Looks at the shape of the matrix to pick the cheapest way to apply it:
+ * a plain copy for the identity, a gather of one input channel per output
+ * channel for permutations and channel selections, and only multiplying
+ * with the non-zero coefficients if most of them are zero. */
+static void
+gst_audio_mix_matrix_update_routing (GstAudioMixMatrix * self)
+{
+  guint in_channels = self->in_channels;
+  guint out_channels = self->out_channels;
+  gboolean identity, gather;
+  guint in, out, n_nonzero;
+
+  gst_audio_mix_matrix_clear_routing (self);
+
+  if (self->matrix == NULL || in_channels == 0 || out_channels == 0)
+    return;
+
+  identity = (in_channels == out_channels);
+  gather = TRUE;
+  n_nonzero = 0;
+  self->gather_map = g_new (gint, out_channels);
+  for (out = 0; out < out_channels; out++) {
+    guint n_row_nonzero = 0;
+
+    self->gather_map[out] = -1;
+    for (in = 0; in < in_channels; in++) {
+      gdouble coefficient = self->matrix[out * in_channels + in];
+
+      if (coefficient != (out == in))
+        identity = FALSE;
+
+      if (coefficient == 0)
+        continue;
+
+      n_row_nonzero++;
+      if (coefficient == 1)
+        self->gather_map[out] = in;
+      else
+        gather = FALSE;
+    }
+    if (n_row_nonzero > 1)
+      gather = FALSE;
+    n_nonzero += n_row_nonzero;
+  }
+
+  if (identity) {
+    self->routing = GST_AUDIO_MIX_MATRIX_ROUTING_COPY;
+  } else if (gather) {
+    self->routing = GST_AUDIO_MIX_MATRIX_ROUTING_GATHER;
+  } else if (n_nonzero <= in_channels * out_channels / 2) {
+    guint n = 0;
+
+    self->routing = GST_AUDIO_MIX_MATRIX_ROUTING_SPARSE;
+    self->sparse_offsets = g_new (guint, out_channels + 1);
+    self->sparse_inputs = g_new (guint, MAX (n_nonzero, 1));
+    for (out = 0; out < out_channels; out++) {
+      self->sparse_offsets[out] = n;
+      for (in = 0; in < in_channels; in++) {
+        if (self->matrix[out * in_channels + in] != 0)
+          self->sparse_inputs[n++] = in;
+      }
+    }
+    self->sparse_offsets[out_channels] = n;
+  } else {
+    self->transposed_matrix = g_new (gdouble, in_channels * out_channels);
+    for (out = 0; out < out_channels; out++) {
+      for (in = 0; in < in_channels; in++) {
+        self->transposed_matrix[in * out_channels + out] =
+            self->matrix[out * in_channels + in];
+      }
+    }
+  }
+
+  if (self->routing != GST_AUDIO_MIX_MATRIX_ROUTING_GATHER) {
+    g_free (self->gather_map);
+    self->gather_map = NULL;
+  }
+
+  GST_DEBUG_OBJECT (self, "Using routing %d for %u nonzero coefficients",
+      self->routing, n_nonzero);
+}
+
 static void
 gst_audio_mix_matrix_convert_s16_matrix (GstAudioMixMatrix * self)
 {
@@ -289,6 +392,7 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_IN_CHANNELS:
       self->in_channels = g_value_get_uint (value);
+      gst_audio_mix_matrix_clear_routing (self);
       if (self->matrix) {
         gst_audio_mix_matrix_convert_s16_matrix (self);
         gst_audio_mix_matrix_convert_s32_matrix (self);
@@ -296,6 +400,7 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
       break;
     case PROP_OUT_CHANNELS:
       self->out_channels = g_value_get_uint (value);
+      gst_audio_mix_matrix_clear_routing (self);
       if (self->matrix) {
         gst_audio_mix_matrix_convert_s16_matrix (self);
         gst_audio_mix_matrix_convert_s32_matrix (self);
@@ -307,6 +412,7 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
       if (self->matrix)
         g_free (self->matrix);
       self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
+      gst_audio_mix_matrix_clear_routing (self);
 
       g_return_if_fail (gst_value_array_get_size (value) == self->out_channels);
       for (out = 0; out < self->out_channels; out++) {
@@ -324,6 +430,7 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
       }
       gst_audio_mix_matrix_convert_s16_matrix (self);
       gst_audio_mix_matrix_convert_s32_matrix (self);
+      gst_audio_mix_matrix_update_routing (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -410,6 +517,153 @@ gst_audio_mix_matrix_change_state (GstElement * element,
 }
 
 
+#define GATHER_SAMPLES(type) G_STMT_START {                              \
+  const type *inarray = (const type *) inmap->data;                     \
+  type *outarray = (type *) outmap->data;                               \
+  guint n_samples = outmap->size / (sizeof (type) * outchannels);       \
+                                                                        \
+  for (sample = 0; sample < n_samples; sample++) {                      \
+    for (out = 0; out < outchannels; out++) {                           \
+      gint in = gather_map[out];                                        \
+                                                                        \
+      outarray[sample * outchannels + out] =                            \
+          in < 0 ? 0 : inarray[sample * inchannels + in];               \
+    }                                                                   \
+  }                                                                     \
+} G_STMT_END
+
+/* Each output channel is a copy of one input channel or silence. Copies
+ * samples as integers of the same size as zero is all zero bits for all
+ * supported formats. */
+static gboolean
+gst_audio_mix_matrix_transform_gather (GstAudioMixMatrix * self,
+    GstMapInfo * inmap, GstMapInfo * outmap)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  const gint *gather_map = self->gather_map;
+  guint sample, out;
+
+  switch (self->format) {
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:
+      GATHER_SAMPLES (guint16);
+      break;
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:
+      GATHER_SAMPLES (guint32);
+      break;
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:
+      GATHER_SAMPLES (guint64);
+      break;
+    default:
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+#undef GATHER_SAMPLES
+
+/* Same as the dense case, but skipping all zero coefficients */
+static gboolean
+gst_audio_mix_matrix_transform_sparse (GstAudioMixMatrix * self,
+    GstMapInfo * inmap, GstMapInfo * outmap)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  const guint *offsets = self->sparse_offsets;
+  const guint *inputs = self->sparse_inputs;
+  gdouble *matrix = self->matrix;
+  guint sample, out, i;
+
+  switch (self->format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:{
+      const gfloat *inarray = (gfloat *) inmap->data;
+      gfloat *outarray = (gfloat *) outmap->data;
+      guint n_samples = outmap->size / (sizeof (gfloat) * outchannels);
+
+      for (sample = 0; sample < n_samples; sample++) {
+        for (out = 0; out < outchannels; out++) {
+          gfloat outval = 0;
+          for (i = offsets[out]; i < offsets[out + 1]; i++) {
+            outval += inarray[sample * inchannels + inputs[i]] *
+                matrix[out * inchannels + inputs[i]];
+          }
+          outarray[sample * outchannels + out] = outval;
+        }
+      }
+      break;
+    }
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:{
+      const gdouble *inarray = (gdouble *) inmap->data;
+      gdouble *outarray = (gdouble *) outmap->data;
+      guint n_samples = outmap->size / (sizeof (gdouble) * outchannels);
+
+      for (sample = 0; sample < n_samples; sample++) {
+        for (out = 0; out < outchannels; out++) {
+          gdouble outval = 0;
+          for (i = offsets[out]; i < offsets[out + 1]; i++) {
+            outval += inarray[sample * inchannels + inputs[i]] *
+                matrix[out * inchannels + inputs[i]];
+          }
+          outarray[sample * outchannels + out] = outval;
+        }
+      }
+      break;
+    }
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:{
+      const gint16 *inarray = (gint16 *) inmap->data;
+      gint16 *outarray = (gint16 *) outmap->data;
+      guint n_samples = outmap->size / (sizeof (gint16) * outchannels);
+      guint n = self->shift_bytes;
+      gint32 *conv_matrix = self->s16_conv_matrix;
+
+      for (sample = 0; sample < n_samples; sample++) {
+        for (out = 0; out < outchannels; out++) {
+          gint32 outval = 0;
+          for (i = offsets[out]; i < offsets[out + 1]; i++) {
+            outval += (gint32) (inarray[sample * inchannels + inputs[i]] *
+                conv_matrix[out * inchannels + inputs[i]]);
+          }
+          outarray[sample * outchannels + out] = (gint16) (outval >> n);
+        }
+      }
+      break;
+    }
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:{
+      const gint32 *inarray = (gint32 *) inmap->data;
+      gint32 *outarray = (gint32 *) outmap->data;
+      guint n_samples = outmap->size / (sizeof (gint32) * outchannels);
+      guint n = self->shift_bytes;
+      gint64 *conv_matrix = self->s32_conv_matrix;
+
+      for (sample = 0; sample < n_samples; sample++) {
+        for (out = 0; out < outchannels; out++) {
+          gint64 outval = 0;
+          for (i = offsets[out]; i < offsets[out + 1]; i++) {
+            outval += (gint64) (inarray[sample * inchannels + inputs[i]] *
+                conv_matrix[out * inchannels + inputs[i]]);
+          }
+          outarray[sample * outchannels + out] = (gint32) (outval >> n);
+        }
+      }
+      break;
+    }
+    default:
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     GstBuffer * inbuf, GstBuffer * outbuf)
@@ -429,6 +683,22 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     return GST_FLOW_ERROR;
   }
 
+  switch (self->routing) {
+    case GST_AUDIO_MIX_MATRIX_ROUTING_COPY:
+      memcpy (outmap.data, inmap.data, outmap.size);
+      goto done;
+    case GST_AUDIO_MIX_MATRIX_ROUTING_GATHER:
+      if (gst_audio_mix_matrix_transform_gather (self, &inmap, &outmap))
+        goto done;
+      break;
+    case GST_AUDIO_MIX_MATRIX_ROUTING_SPARSE:
+      if (gst_audio_mix_matrix_transform_sparse (self, &inmap, &outmap))
+        goto done;
+      break;
+    default:
+      break;
+  }
+
   switch (self->format) {
     case GST_AUDIO_FORMAT_F32LE:
     case GST_AUDIO_FORMAT_F32BE:{
@@ -439,6 +709,26 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
       inarray = (gfloat *) inmap.data;
       outarray = (gfloat *) outmap.data;
 
+      if (self->transposed_matrix) {
+        /* Accumulate all outputs per input so the inner loop has no
+         * dependency between iterations and can be vectorized. The
+         * summation order per output is the same as below. */
+        for (sample = 0; sample < n_samples; sample++) {
+          gfloat *outval = outarray + sample * outchannels;
+
+          for (out = 0; out < outchannels; out++)
+            outval[out] = 0;
+          for (in = 0; in < inchannels; in++) {
+            gfloat inval = inarray[sample * inchannels + in];
+            const gdouble *row = self->transposed_matrix + in * outchannels;
+
+            for (out = 0; out < outchannels; out++)
+              outval[out] += inval * row[out];
+          }
+        }
+        break;
+      }
+
       for (sample = 0; sample < n_samples; sample++) {
         for (out = 0; out < outchannels; out++) {
           gfloat outval = 0;
@@ -461,6 +751,23 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
       inarray = (gdouble *) inmap.data;
       outarray = (gdouble *) outmap.data;
 
+      if (self->transposed_matrix) {
+        for (sample = 0; sample < n_samples; sample++) {
+          gdouble *outval = outarray + sample * outchannels;
+
+          for (out = 0; out < outchannels; out++)
+            outval[out] = 0;
+          for (in = 0; in < inchannels; in++) {
+            gdouble inval = inarray[sample * inchannels + in];
+            const gdouble *row = self->transposed_matrix + in * outchannels;
+
+            for (out = 0; out < outchannels; out++)
+              outval[out] += inval * row[out];
+          }
+        }
+        break;
+      }
+
       for (sample = 0; sample < n_samples; sample++) {
         for (out = 0; out < outchannels; out++) {
           gdouble outval = 0;
@@ -527,6 +834,7 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
 
   }
 
+done:
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
   return GST_FLOW_OK;
@@ -567,6 +875,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     self->in_channels = info.channels;
     self->out_channels = out_info.channels;
 
+    g_free (self->matrix);
     self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
 
     for (out = 0; out < self->out_channels; out++) {
@@ -596,6 +905,9 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     default:
       break;
   }
+
+  gst_audio_mix_matrix_update_routing (self);
+
   return TRUE;
 }
 
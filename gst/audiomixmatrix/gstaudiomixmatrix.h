@@ -43,6 +43,15 @@ typedef enum _GstAudioMixMatrixMode
   GST_AUDIO_MIX_MATRIX_MODE_FIRST_CHANNELS = 1
 } GstAudioMixMatrixMode;
 
+/* How the matrix is applied, see gst_audio_mix_matrix_update_routing() */
+typedef enum _GstAudioMixMatrixRouting
+{
+  GST_AUDIO_MIX_MATRIX_ROUTING_DENSE = 0,
+  GST_AUDIO_MIX_MATRIX_ROUTING_COPY,
+  GST_AUDIO_MIX_MATRIX_ROUTING_GATHER,
+  GST_AUDIO_MIX_MATRIX_ROUTING_SPARSE
+} GstAudioMixMatrixRouting;
+
 /**
  * GstAudioMixMatrix:
  *
@@ -62,6 +71,16 @@ struct _GstAudioMixMatrix
   gint64 *s32_conv_matrix;
   gint shift_bytes;
 
+  GstAudioMixMatrixRouting routing;
+  /* input channel for each output channel, or -1 for silence */
+  gint *gather_map;
+  /* non-zero coefficients of output channel n are the input channels
+   * sparse_inputs[sparse_offsets[n]] to sparse_inputs[sparse_offsets[n+1]-1] */
+  guint *sparse_offsets;
+  guint *sparse_inputs;
+  /* matrix with one row per input channel */
+  gdouble *transposed_matrix;
+
   GstAudioFormat format;
 };
 
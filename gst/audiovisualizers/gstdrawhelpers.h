@@ -20,6 +20,19 @@
  */
  
 /* FIXME: add versions that don't ignore alpha */
+
+/* saturating add of all four channels at once, without branches */
+static inline void
+add_pixel (guint32 * _p, guint32 _c)
+{
+  guint32 _s, _o;
+
+  /* sum without carries between the channels, then its overflows */
+  _s = ((*_p & 0x7f7f7f7f) + (_c & 0x7f7f7f7f)) ^ ((*_p ^ _c) & 0x80808080);
+  _o = (*_p & _c) | ((*_p | _c) & ~_s);
+  _o = (_o >> 7) & 0x01010101;
+  *_p = _s | (_o * 0xff);
+}
  
 #define draw_dot(_vd, _x, _y, _st, _c) G_STMT_START {                          \
   _vd[(_y * _st) + _x] = _c;                                                   \
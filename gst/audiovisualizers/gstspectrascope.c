@@ -37,8 +37,10 @@
 #include "config.h"
 #endif
 #include <stdlib.h>
+#include <string.h>
 
 #include "gstspectrascope.h"
+#include "gstdrawhelpers.h"
 
 #if G_BYTE_ORDER == G_BIG_ENDIAN
 #define RGB_ORDER "xRGB"
@@ -118,6 +120,10 @@ gst_spectra_scope_finalize (GObject * object)
     g_free (scope->freq_data);
     scope->freq_data = NULL;
   }
+  if (scope->mono_adata) {
+    g_free (scope->mono_adata);
+    scope->mono_adata = NULL;
+  }
 
   G_OBJECT_CLASS (gst_spectra_scope_parent_class)->finalize (object);
 }
@@ -128,48 +134,32 @@ gst_spectra_scope_setup (GstAudioVisualizer * bscope)
   GstSpectraScope *scope = GST_SPECTRA_SCOPE (bscope);
   guint num_freq = GST_VIDEO_INFO_WIDTH (&bscope->vinfo) + 1;
 
+  /* we'd need this amount of samples per render() call */
+  bscope->req_spf = num_freq * 2 - 2;
+
+  /* keep the fft and its buffers over renegotiations of the same width */
+  if (scope->fft_ctx && scope->num_freq == num_freq)
+    return TRUE;
+
   if (scope->fft_ctx)
     gst_fft_s16_free (scope->fft_ctx);
   g_free (scope->freq_data);
+  g_free (scope->mono_adata);
 
-  /* we'd need this amount of samples per render() call */
-  bscope->req_spf = num_freq * 2 - 2;
+  scope->num_freq = num_freq;
   scope->fft_ctx = gst_fft_s16_new (bscope->req_spf, FALSE);
   scope->freq_data = g_new (GstFFTS16Complex, num_freq);
+  scope->mono_adata = g_new (gint16, bscope->req_spf);
 
   return TRUE;
 }
 
-static inline void
-add_pixel (guint32 * _p, guint32 _c)
-{
-  guint8 *p = (guint8 *) _p;
-  guint8 *c = (guint8 *) & _c;
-
-  if (p[0] < 255 - c[0])
-    p[0] += c[0];
-  else
-    p[0] = 255;
-  if (p[1] < 255 - c[1])
-    p[1] += c[1];
-  else
-    p[1] = 255;
-  if (p[2] < 255 - c[2])
-    p[2] += c[2];
-  else
-    p[2] = 255;
-  if (p[3] < 255 - c[3])
-    p[3] += c[3];
-  else
-    p[3] = 255;
-}
-
 static gboolean
 gst_spectra_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
     GstVideoFrame * video)
 {
   GstSpectraScope *scope = GST_SPECTRA_SCOPE (bscope);
-  gint16 *mono_adata;
+  gint16 *mono_adata = scope->mono_adata;
   GstFFTS16Complex *fdata = scope->freq_data;
   guint x, y, off, l;
   guint w = GST_VIDEO_INFO_WIDTH (&bscope->vinfo);
@@ -184,27 +174,29 @@ gst_spectra_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
 
   channels = GST_AUDIO_INFO_CHANNELS (&bscope->ainfo);
 
-  mono_adata = (gint16 *) g_memdup (amap.data, amap.size);
-
   if (channels > 1) {
+    gint16 *adata = (gint16 *) amap.data;
     guint ch = channels;
-    guint num_samples = amap.size / (ch * sizeof (gint16));
+    guint num_samples = MIN (amap.size / (ch * sizeof (gint16)),
+        bscope->req_spf);
     guint i, c, v, s = 0;
 
     /* deinterleave and mixdown adata */
     for (i = 0; i < num_samples; i++) {
       v = 0;
       for (c = 0; c < ch; c++) {
-        v += mono_adata[s++];
+        v += adata[s++];
       }
       mono_adata[i] = v / ch;
     }
+  } else {
+    memcpy (mono_adata, amap.data, MIN (amap.size,
+            bscope->req_spf * sizeof (gint16)));
   }
 
   /* run fft */
   gst_fft_s16_window (scope->fft_ctx, mono_adata, GST_FFT_WINDOW_HAMMING);
   gst_fft_s16_fft (scope->fft_ctx, mono_adata, fdata);
-  g_free (mono_adata);
 
   /* draw lines */
   for (x = 0; x < w; x++) {
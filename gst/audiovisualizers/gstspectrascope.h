@@ -40,6 +40,8 @@ struct _GstSpectraScope
 
   GstFFTS16 *fft_ctx;
   GstFFTS16Complex *freq_data;
+  gint16 *mono_adata;
+  guint num_freq;
 };
 
 struct _GstSpectraScopeClass
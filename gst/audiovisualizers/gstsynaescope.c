@@ -37,6 +37,7 @@
 #endif
 
 #include "gstsynaescope.h"
+#include "gstdrawhelpers.h"
 
 #if G_BYTE_ORDER == G_BIG_ENDIAN
 #define RGB_ORDER "xRGB"
@@ -157,6 +158,15 @@ gst_synae_scope_setup (GstAudioVisualizer * bscope)
   GstSynaeScope *scope = GST_SYNAE_SCOPE (bscope);
   guint num_freq = GST_VIDEO_INFO_HEIGHT (&bscope->vinfo) + 1;
 
+  /* FIXME: we could have horizontal or vertical layout */
+
+  /* we'd need this amount of samples per render() call */
+  bscope->req_spf = num_freq * 2 - 2;
+
+  /* keep the fft and its buffers over renegotiations of the same height */
+  if (scope->fft_ctx && scope->num_freq == num_freq)
+    return TRUE;
+
   if (scope->fft_ctx)
     gst_fft_s16_free (scope->fft_ctx);
   g_free (scope->freq_data_l);
@@ -164,10 +174,7 @@ gst_synae_scope_setup (GstAudioVisualizer * bscope)
   g_free (scope->adata_l);
   g_free (scope->adata_r);
 
-  /* FIXME: we could have horizontal or vertical layout */
-
-  /* we'd need this amount of samples per render() call */
-  bscope->req_spf = num_freq * 2 - 2;
+  scope->num_freq = num_freq;
   scope->fft_ctx = gst_fft_s16_new (bscope->req_spf, FALSE);
   scope->freq_data_l = g_new (GstFFTS16Complex, num_freq);
   scope->freq_data_r = g_new (GstFFTS16Complex, num_freq);
@@ -178,30 +185,6 @@ gst_synae_scope_setup (GstAudioVisualizer * bscope)
   return TRUE;
 }
 
-static inline void
-add_pixel (guint32 * _p, guint32 _c)
-{
-  guint8 *p = (guint8 *) _p;
-  guint8 *c = (guint8 *) & _c;
-
-  if (p[0] < 255 - c[0])
-    p[0] += c[0];
-  else
-    p[0] = 255;
-  if (p[1] < 255 - c[1])
-    p[1] += c[1];
-  else
-    p[1] = 255;
-  if (p[2] < 255 - c[2])
-    p[2] += c[2];
-  else
-    p[2] = 255;
-  if (p[3] < 255 - c[3])
-    p[3] += c[3];
-  else
-    p[3] = 255;
-}
-
 static gboolean
 gst_synae_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
     GstVideoFrame * video)
@@ -41,6 +41,7 @@ struct _GstSynaeScope
   GstFFTS16 *fft_ctx;
   GstFFTS16Complex *freq_data_l, *freq_data_r;
   gint16 *adata_l, *adata_r;
+  guint num_freq;
 
   guint32 colors[256];
   guint shade[256];
@@ -140,6 +140,16 @@ static GstElement
 static gboolean gst_auto_convert_activate_element (GstAutoConvert * autoconvert,
     GstElement * element, GstCaps * caps);
 
+/* number of caps combinations for which the selected factory is remembered */
+#define CAPS_CACHE_SIZE 8
+
+typedef struct
+{
+  GstCaps *sink_caps;
+  GstCaps *src_caps;
+  GstElementFactory *factory;
+} CapsCacheEntry;
+
 static GQuark internal_srcpad_quark = 0;
 static GQuark internal_sinkpad_quark = 0;
 static GQuark parent_quark = 0;
@@ -211,11 +221,25 @@ gst_auto_convert_init (GstAutoConvert * autoconvert)
   gst_element_add_pad (GST_ELEMENT (autoconvert), autoconvert->srcpad);
 }
 
+static void
+caps_cache_entry_free (CapsCacheEntry * entry)
+{
+  gst_caps_unref (entry->sink_caps);
+  if (entry->src_caps)
+    gst_caps_unref (entry->src_caps);
+  gst_object_unref (entry->factory);
+  g_slice_free (CapsCacheEntry, entry);
+}
+
 static void
 gst_auto_convert_dispose (GObject * object)
 {
   GstAutoConvert *autoconvert = GST_AUTO_CONVERT (object);
 
+  g_list_free_full (autoconvert->caps_cache,
+      (GDestroyNotify) caps_cache_entry_free);
+  autoconvert->caps_cache = NULL;
+
   g_clear_object (&autoconvert->current_subelement);
   g_clear_object (&autoconvert->current_internal_sinkpad);
   g_clear_object (&autoconvert->current_internal_srcpad);
@@ -623,6 +647,81 @@ factory_can_intersect (GstAutoConvert * autoconvert,
   return ret;
 }
 
+static gboolean
+caps_equal_or_null (GstCaps * caps1, GstCaps * caps2)
+{
+  if (caps1 == NULL || caps2 == NULL)
+    return caps1 == caps2;
+
+  return gst_caps_is_equal (caps1, caps2);
+}
+
+/* Returns the factory that was selected the last time these caps were
+ * negotiated, if any, and moves the entry to the front so that the least
+ * recently used one gets evicted */
+static GstElementFactory *
+gst_auto_convert_lookup_caps_cache (GstAutoConvert * autoconvert,
+    GstCaps * sink_caps, GstCaps * src_caps)
+{
+  GstElementFactory *factory = NULL;
+  GList *item;
+
+  GST_OBJECT_LOCK (autoconvert);
+  for (item = autoconvert->caps_cache; item; item = item->next) {
+    CapsCacheEntry *entry = item->data;
+
+    if (gst_caps_is_equal (entry->sink_caps, sink_caps) &&
+        caps_equal_or_null (entry->src_caps, src_caps)) {
+      factory = gst_object_ref (entry->factory);
+      autoconvert->caps_cache =
+          g_list_remove_link (autoconvert->caps_cache, item);
+      autoconvert->caps_cache = g_list_concat (item, autoconvert->caps_cache);
+      break;
+    }
+  }
+  GST_OBJECT_UNLOCK (autoconvert);
+
+  return factory;
+}
+
+/* Remembers @factory for these caps, or forgets them if @factory is NULL */
+static void
+gst_auto_convert_update_caps_cache (GstAutoConvert * autoconvert,
+    GstCaps * sink_caps, GstCaps * src_caps, GstElementFactory * factory)
+{
+  CapsCacheEntry *entry;
+  GList *item, *last;
+
+  GST_OBJECT_LOCK (autoconvert);
+  for (item = autoconvert->caps_cache; item; item = item->next) {
+    entry = item->data;
+
+    if (gst_caps_is_equal (entry->sink_caps, sink_caps) &&
+        caps_equal_or_null (entry->src_caps, src_caps)) {
+      autoconvert->caps_cache =
+          g_list_delete_link (autoconvert->caps_cache, item);
+      caps_cache_entry_free (entry);
+      break;
+    }
+  }
+
+  if (factory) {
+    entry = g_slice_new (CapsCacheEntry);
+    entry->sink_caps = gst_caps_ref (sink_caps);
+    entry->src_caps = src_caps ? gst_caps_ref (src_caps) : NULL;
+    entry->factory = gst_object_ref (factory);
+    autoconvert->caps_cache = g_list_prepend (autoconvert->caps_cache, entry);
+
+    if (g_list_length (autoconvert->caps_cache) > CAPS_CACHE_SIZE) {
+      last = g_list_last (autoconvert->caps_cache);
+      caps_cache_entry_free (last->data);
+      autoconvert->caps_cache =
+          g_list_delete_link (autoconvert->caps_cache, last);
+    }
+  }
+  GST_OBJECT_UNLOCK (autoconvert);
+}
+
 static gboolean
 sticky_event_push (GstPad * pad, GstEvent ** event, gpointer user_data)
 {
@@ -714,6 +813,7 @@ gst_auto_convert_sink_setcaps (GstAutoConvert * autoconvert, GstCaps * caps)
   GstCaps *other_caps = NULL;
   GList *factories;
   GstCaps *current_caps;
+  GstElementFactory *cached;
 
   g_return_val_if_fail (autoconvert != NULL, FALSE);
 
@@ -749,6 +849,29 @@ gst_auto_convert_sink_setcaps (GstAutoConvert * autoconvert, GstCaps * caps)
 
   other_caps = gst_pad_peer_query_caps (autoconvert->srcpad, NULL);
 
+  /* Renegotiating to caps that were seen before, try the factory that was
+   * selected then without going through all of them again. The element
+   * itself is normally still in the bin. */
+  cached = gst_auto_convert_lookup_caps_cache (autoconvert, caps, other_caps);
+  if (cached) {
+    GstElement *element;
+
+    element = gst_auto_convert_get_or_make_element_from_factory (autoconvert,
+        cached);
+    if (element) {
+      if (gst_auto_convert_activate_element (autoconvert, element, caps)) {
+        GST_DEBUG_OBJECT (autoconvert, "Reused factory %s for %"
+            GST_PTR_FORMAT, GST_OBJECT_NAME (cached), caps);
+        gst_object_unref (cached);
+        goto get_out;
+      }
+      gst_object_unref (element);
+    }
+
+    gst_auto_convert_update_caps_cache (autoconvert, caps, other_caps, NULL);
+    gst_object_unref (cached);
+  }
+
   factories = g_atomic_pointer_get (&autoconvert->factories);
 
   if (!factories)
@@ -786,10 +909,13 @@ gst_auto_convert_sink_setcaps (GstAutoConvert * autoconvert, GstCaps * caps)
       continue;
 
     /* And make it the current child */
-    if (gst_auto_convert_activate_element (autoconvert, element, caps))
+    if (gst_auto_convert_activate_element (autoconvert, element, caps)) {
+      gst_auto_convert_update_caps_cache (autoconvert, caps, other_caps,
+          factory);
       break;
-    else
+    } else {
       gst_object_unref (element);
+    }
   }
 
 get_out:
@@ -895,7 +1021,7 @@ gst_auto_convert_load_factories (GstAutoConvert * autoconvert)
 
   g_assert (all_factories);
 
-  if (g_atomic_pointer_compare_and_exchange (&autoconvert->factories, NULL,
+  if (!g_atomic_pointer_compare_and_exchange (&autoconvert->factories, NULL,
           all_factories)) {
     gst_plugin_feature_list_free (all_factories);
   }
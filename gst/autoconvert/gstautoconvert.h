@@ -53,6 +53,11 @@ struct _GstAutoConvert
   GstElement *current_subelement;
   GstPad *current_internal_srcpad;
   GstPad *current_internal_sinkpad;
+
+  /* Factories that were selected for previous caps, most recent first
+   * Protected by the object lock
+   */
+  GList *caps_cache;
 };
 
 struct _GstAutoConvertClass
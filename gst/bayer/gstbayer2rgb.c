@@ -99,6 +99,12 @@ enum
   GST_BAYER_2_RGB_FORMAT_RGGB
 };
 
+typedef enum
+{
+  GST_BAYER2RGB_METHOD_BILINEAR,
+  GST_BAYER2RGB_METHOD_EDGE_AWARE
+} GstBayer2RGBMethod;
+
 
 #define GST_TYPE_BAYER2RGB            (gst_bayer2rgb_get_type())
 #define GST_BAYER2RGB(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BAYER2RGB,GstBayer2RGB))
@@ -122,7 +128,29 @@ struct _GstBayer2RGB
   int r_off;                    /* offset for red */
   int g_off;                    /* offset for green */
   int b_off;                    /* offset for blue */
+  int a_off;                    /* offset for the padding */
   int format;
+  int bits;                     /* bits per sample */
+  gboolean big_endian;          /* for more than 8 bits per sample */
+
+  GstBayer2RGBMethod method;
+  guint n_threads;
+
+  GThreadPool *pool;
+  guint n_bands;
+  GMutex lock;
+  GCond cond;
+  guint pending_bands;
+
+  /* line buffers of all the bands */
+  guint8 *tmp;
+  gsize tmp_size;
+
+  /* the frame being converted */
+  guint8 *dest;
+  gint dest_stride;
+  const guint8 *src;
+  gint src_stride;
 };
 
 struct _GstBayer2RGBClass
@@ -133,14 +161,41 @@ struct _GstBayer2RGBClass
 #define	SRC_CAPS                                 \
   GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR }")
 
-#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb}," \
+#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb," \
+  "bggr10le,grbg10le,gbrg10le,rggb10le,bggr10be,grbg10be,gbrg10be,rggb10be," \
+  "bggr12le,grbg12le,gbrg12le,rggb12le,bggr12be,grbg12be,gbrg12be,rggb12be," \
+  "bggr16le,grbg16le,gbrg16le,rggb16le,bggr16be,grbg16be,gbrg16be,rggb16be}," \
   "width=(int)[1,MAX],height=(int)[1,MAX],framerate=(fraction)[0/1,MAX]"
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_METHOD GST_BAYER2RGB_METHOD_BILINEAR
+#define DEFAULT_N_THREADS 1
+
+#define GST_TYPE_BAYER2RGB_METHOD (gst_bayer2rgb_method_get_type ())
+static GType
+gst_bayer2rgb_method_get_type (void)
+{
+  static GType method_type = 0;
+  static const GEnumValue methods[] = {
+    {GST_BAYER2RGB_METHOD_BILINEAR, "Bilinear interpolation", "bilinear"},
+    {GST_BAYER2RGB_METHOD_EDGE_AWARE,
+        "Edge directed green with gradient corrected red and blue",
+        "edge-aware"},
+    {0, NULL, NULL},
+  };
+
+  if (!method_type) {
+    method_type = g_enum_register_static ("GstBayer2RGBMethod", methods);
+  }
+  return method_type;
+}
+
 GType gst_bayer2rgb_get_type (void);
 
 #define gst_bayer2rgb_parent_class parent_class
@@ -160,6 +215,9 @@ static GstCaps *gst_bayer2rgb_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean gst_bayer2rgb_get_unit_size (GstBaseTransform * base,
     GstCaps * caps, gsize * size);
+static gboolean gst_bayer2rgb_start (GstBaseTransform * base);
+static gboolean gst_bayer2rgb_stop (GstBaseTransform * base);
+static void gst_bayer2rgb_finalize (GObject * object);
 
 
 static void
@@ -173,6 +231,36 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 
   gobject_class->set_property = gst_bayer2rgb_set_property;
   gobject_class->get_property = gst_bayer2rgb_get_property;
+  gobject_class->finalize = gst_bayer2rgb_finalize;
+
+  /**
+   * GstBayer2RGB:method:
+   *
+   * The demosaicing algorithm. The edge aware one interpolates green along
+   * the direction of the smallest gradient and corrects red and blue with
+   * the gradients of the other colors, which avoids most of the zipper
+   * artifacts and false colors of the bilinear one, at a higher cost.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "Demosaicing algorithm",
+          GST_TYPE_BAYER2RGB_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBayer2RGB:n-threads:
+   *
+   * Number of threads the frames are converted in, each one handling a
+   * stripe of rows.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads to convert the frames in "
+          "(0 = number of processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Bayer to RGB decoder for cameras", "Filter/Converter/Video",
@@ -194,6 +282,10 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_transform);
+  GST_BASE_TRANSFORM_CLASS (klass)->start =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_start);
+  GST_BASE_TRANSFORM_CLASS (klass)->stop =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_stop);
 
   GST_DEBUG_CATEGORY_INIT (gst_bayer2rgb_debug, "bayer2rgb", 0,
       "bayer2rgb element");
@@ -202,17 +294,40 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 static void
 gst_bayer2rgb_init (GstBayer2RGB * filter)
 {
+  filter->method = DEFAULT_METHOD;
+  filter->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&filter->lock);
+  g_cond_init (&filter->cond);
+
   gst_bayer2rgb_reset (filter);
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
 }
 
-/* No properties are implemented, so only a warning is produced */
+static void
+gst_bayer2rgb_finalize (GObject * object)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
+
+  g_free (filter->tmp);
+  g_mutex_clear (&filter->lock);
+  g_cond_clear (&filter->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      filter->method = g_value_get_enum (value);
+      break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -223,14 +338,68 @@ static void
 gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, filter->method);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* parses a bayer format such as "rggb" or "grbg12le" */
+static gboolean
+gst_bayer2rgb_parse_format (const gchar * format, gint * pattern,
+    gint * bits, gboolean * big_endian)
+{
+  static const gchar patterns[][5] = { "bggr", "gbrg", "grbg", "rggb" };
+  guint i;
+
+  if (format == NULL || strlen (format) < 4)
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (patterns); i++) {
+    if (strncmp (format, patterns[i], 4) == 0)
+      break;
+  }
+  if (i == G_N_ELEMENTS (patterns))
+    return FALSE;
+  /* same order as the GST_BAYER_2_RGB_FORMAT_* values */
+  *pattern = i;
+
+  format += 4;
+  if (*format == '\0') {
+    *bits = 8;
+    *big_endian = FALSE;
+    return TRUE;
+  }
+
+  if (g_str_equal (format, "10le") || g_str_equal (format, "10be"))
+    *bits = 10;
+  else if (g_str_equal (format, "12le") || g_str_equal (format, "12be"))
+    *bits = 12;
+  else if (g_str_equal (format, "16le") || g_str_equal (format, "16be"))
+    *bits = 16;
+  else
+    return FALSE;
+  *big_endian = format[2] == 'b';
+
+  return TRUE;
+}
+
+/* the samples of more than 8 bits are stored in 16 bits */
+static gint
+gst_bayer2rgb_get_stride (gint width, gint bits)
+{
+  return GST_ROUND_UP_4 (bits > 8 ? width * 2 : width);
+}
+
 static gboolean
 gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
     GstCaps * outcaps)
@@ -249,23 +418,18 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   gst_structure_get_int (structure, "height", &bayer2rgb->height);
 
   format = gst_structure_get_string (structure, "format");
-  if (g_str_equal (format, "bggr")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_BGGR;
-  } else if (g_str_equal (format, "gbrg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GBRG;
-  } else if (g_str_equal (format, "grbg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GRBG;
-  } else if (g_str_equal (format, "rggb")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_RGGB;
-  } else {
+  if (!gst_bayer2rgb_parse_format (format, &bayer2rgb->format,
+          &bayer2rgb->bits, &bayer2rgb->big_endian))
     return FALSE;
-  }
 
   /* To cater for different RGB formats, we need to set params for later */
   gst_video_info_from_caps (&info, outcaps);
   bayer2rgb->r_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 0);
   bayer2rgb->g_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 1);
   bayer2rgb->b_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 2);
+  /* the four offsets are 0, 1, 2 and 3 */
+  bayer2rgb->a_off = 6 - bayer2rgb->r_off - bayer2rgb->g_off -
+      bayer2rgb->b_off;
 
   bayer2rgb->info = info;
 
@@ -280,6 +444,9 @@ gst_bayer2rgb_reset (GstBayer2RGB * filter)
   filter->r_off = 0;
   filter->g_off = 0;
   filter->b_off = 0;
+  filter->a_off = 0;
+  filter->bits = 8;
+  filter->big_endian = FALSE;
   gst_video_info_init (&filter->info);
 }
 
@@ -334,7 +501,12 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
     name = gst_structure_get_name (structure);
     /* Our name must be either video/x-bayer video/x-raw */
     if (strcmp (name, "video/x-raw")) {
-      *size = GST_ROUND_UP_4 (width) * height;
+      gint pattern, bits = 8;
+      gboolean big_endian;
+
+      gst_bayer2rgb_parse_format (gst_structure_get_string (structure,
+              "format"), &pattern, &bits, &big_endian);
+      *size = gst_bayer2rgb_get_stride (width, bits) * height;
       return TRUE;
     } else {
       /* For output, calculate according to format (always 32 bits) */
@@ -381,14 +553,43 @@ typedef void (*process_func) (guint8 * d0, const guint8 * s0, const guint8 * s1,
     const guint8 * s2, const guint8 * s3, const guint8 * s4, const guint8 * s5,
     int n);
 
+/* returns row @y of the input as 8 bit samples, converting it into @line
+ * if it has more bits */
+static const guint8 *
+gst_bayer2rgb_get_line (GstBayer2RGB * bayer2rgb, guint8 * line, int y)
+{
+  const guint8 *src = bayer2rgb->src + y * bayer2rgb->src_stride;
+  int shift = bayer2rgb->bits - 8;
+  int i;
+
+  if (bayer2rgb->bits == 8)
+    return src;
+
+  if (bayer2rgb->big_endian) {
+    for (i = 0; i < bayer2rgb->width; i++)
+      line[i] = MIN (GST_READ_UINT16_BE (src + 2 * i) >> shift, 255);
+  } else {
+    for (i = 0; i < bayer2rgb->width; i++)
+      line[i] = MIN (GST_READ_UINT16_LE (src + 2 * i) >> shift, 255);
+  }
+
+  return line;
+}
+
+/* size of the line buffers of one band */
+#define BAND_TMP_SIZE(w) (9 * GST_ROUND_UP_8 (w))
+
 static void
-gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
-    int dest_stride, uint8_t * src, int src_stride)
+gst_bayer2rgb_process_bilinear (GstBayer2RGB * bayer2rgb, guint8 * tmp,
+    int y0, int y1)
 {
   int j;
-  guint8 *tmp;
+  guint8 *line;
   process_func merge[2] = { NULL, NULL };
   int r_off, g_off, b_off;
+  int width = bayer2rgb->width;
+  guint8 *dest = bayer2rgb->dest;
+  int dest_stride = bayer2rgb->dest_stride;
 
   /* We exploit some symmetry in the functions here.  The base functions
    * are all named for the BGGR arrangement.  For RGGB, we swap the
@@ -423,32 +624,276 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     merge[1] = tmp;
   }
 
-  tmp = g_malloc (2 * 4 * bayer2rgb->width);
-#define LINE(x) (tmp + ((x)&7) * bayer2rgb->width)
-
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (3 * 2 + 0), LINE (3 * 2 + 1),
-      src + 1 * src_stride, bayer2rgb->width);
-  j = 0;
+  /* the upsampled lines of 4 rows, in a ring, and one line for the
+   * conversion of samples of more than 8 bits */
+#define LINE(x) (tmp + ((x)&7) * GST_ROUND_UP_8 (width))
+  line = tmp + 8 * GST_ROUND_UP_8 (width);
+
+  /* the row before the band, the second one for the first band */
+  j = y0 > 0 ? y0 - 1 : MIN (1, bayer2rgb->height - 1);
+  gst_bayer2rgb_split_and_upsample_horiz (LINE ((y0 - 1) * 2 + 0),
+      LINE ((y0 - 1) * 2 + 1), gst_bayer2rgb_get_line (bayer2rgb, line, j),
+      width);
+  j = y0;
   gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
-      src + j * src_stride, bayer2rgb->width);
+      gst_bayer2rgb_get_line (bayer2rgb, line, j), width);
 
-  for (j = 0; j < bayer2rgb->height; j++) {
+  for (j = y0; j < y1; j++) {
     if (j < bayer2rgb->height - 1) {
       gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
-          LINE ((j + 1) * 2 + 1), src + (j + 1) * src_stride, bayer2rgb->width);
+          LINE ((j + 1) * 2 + 1), gst_bayer2rgb_get_line (bayer2rgb, line,
+              j + 1), width);
     }
 
     merge[j & 1] (dest + j * dest_stride,
         LINE (j * 2 - 2), LINE (j * 2 - 1),
         LINE (j * 2 + 0), LINE (j * 2 + 1),
-        LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
+        LINE (j * 2 + 2), LINE (j * 2 + 3), width >> 1);
   }
+#undef LINE
+}
+
+/* the colors of the pixels of the 2x2 patterns, in the order of the
+ * GST_BAYER_2_RGB_FORMAT_* values */
+enum
+{
+  COLOR_R,
+  COLOR_G,
+  COLOR_B
+};
+
+static const guint8 cfa_colors[4][4] = {
+  {COLOR_B, COLOR_G, COLOR_G, COLOR_R},   /* bggr */
+  {COLOR_G, COLOR_B, COLOR_R, COLOR_G},   /* gbrg */
+  {COLOR_G, COLOR_R, COLOR_B, COLOR_G},   /* grbg */
+  {COLOR_R, COLOR_G, COLOR_G, COLOR_B},   /* rggb */
+};
 
-  g_free (tmp);
+/* mirrors @i around the edges, keeping its parity */
+static inline int
+gst_bayer2rgb_reflect (int i, int n)
+{
+  if (i < 0)
+    i = -i;
+  if (i >= n)
+    i = 2 * (n - 1) - i;
+  return CLAMP (i, 0, n - 1);
 }
 
+static inline int
+gst_bayer2rgb_load (const guint8 * row, int x, int bytes, gboolean big_endian)
+{
+  if (bytes == 1)
+    return row[x];
+  if (big_endian)
+    return GST_READ_UINT16_BE (row + 2 * x);
+  return GST_READ_UINT16_LE (row + 2 * x);
+}
 
+/* Converts the rows from @y0 to @y1. Green is interpolated at the red and
+ * blue pixels along the direction of the smallest gradient, with a second
+ * order correction from the center color (Hamilton-Adams). Red and blue
+ * are interpolated with the gradient corrected kernels of Malvar, He and
+ * Cutler. @bytes and @big_endian are constants in the callers so that an
+ * inlined copy is made for each sample layout. */
+static inline void
+gst_bayer2rgb_process_edge_aware_rows (GstBayer2RGB * bayer2rgb, int y0,
+    int y1, int bytes, gboolean big_endian)
+{
+  const guint8 *colors = cfa_colors[bayer2rgb->format];
+  int width = bayer2rgb->width, height = bayer2rgb->height;
+  int max = (1 << bayer2rgb->bits) - 1;
+  int shift = bayer2rgb->bits - 8;
+  int x, y, k;
+
+#define P(dy, dx) gst_bayer2rgb_load (rows[(dy) + 2], cols[(dx) + 2], bytes, \
+    big_endian)
+
+  for (y = y0; y < y1; y++) {
+    const guint8 *rows[5];
+    guint8 *d = bayer2rgb->dest + y * bayer2rgb->dest_stride;
+
+    for (k = 0; k < 5; k++)
+      rows[k] = bayer2rgb->src +
+          gst_bayer2rgb_reflect (y + k - 2, height) * bayer2rgb->src_stride;
+
+    for (x = 0; x < width; x++, d += 4) {
+      int cols[5];
+      int c = colors[((y & 1) << 1) | (x & 1)];
+      int center, r, g, b;
+
+      for (k = 0; k < 5; k++)
+        cols[k] = gst_bayer2rgb_reflect (x + k - 2, width);
+
+      center = P (0, 0);
+
+      if (c == COLOR_G) {
+        /* red or blue horizontally, the other one vertically */
+        int diag = P (-1, -1) + P (-1, 1) + P (1, -1) + P (1, 1);
+        int h = (10 * center + 8 * (P (0, -1) + P (0, 1)) -
+            2 * (P (0, -2) + P (0, 2) + diag) + P (-2, 0) + P (2, 0)) / 16;
+        int v = (10 * center + 8 * (P (-1, 0) + P (1, 0)) -
+            2 * (P (-2, 0) + P (2, 0) + diag) + P (0, -2) + P (0, 2)) / 16;
+
+        g = center;
+        if (colors[((y & 1) << 1) | ((x + 1) & 1)] == COLOR_R) {
+          r = h;
+          b = v;
+        } else {
+          r = v;
+          b = h;
+        }
+      } else {
+        int lap_h = 2 * center - P (0, -2) - P (0, 2);
+        int lap_v = 2 * center - P (-2, 0) - P (2, 0);
+        int grad_h = ABS (P (0, -1) - P (0, 1)) + ABS (lap_h);
+        int grad_v = ABS (P (-1, 0) - P (1, 0)) + ABS (lap_v);
+        int gh = (2 * (P (0, -1) + P (0, 1)) + lap_h) / 4;
+        int gv = (2 * (P (-1, 0) + P (1, 0)) + lap_v) / 4;
+        int other;
+
+        if (grad_h < grad_v)
+          g = gh;
+        else if (grad_v < grad_h)
+          g = gv;
+        else
+          g = (gh + gv) / 2;
+
+        /* the other color is on the diagonals */
+        other = (12 * center + 4 * (P (-1, -1) + P (-1, 1) + P (1, -1) +
+                P (1, 1)) - 3 * (P (0, -2) + P (0, 2) + P (-2, 0) +
+                P (2, 0))) / 16;
+
+        if (c == COLOR_R) {
+          r = center;
+          b = other;
+        } else {
+          r = other;
+          b = center;
+        }
+      }
+
+      d[bayer2rgb->r_off] = CLAMP (r, 0, max) >> shift;
+      d[bayer2rgb->g_off] = CLAMP (g, 0, max) >> shift;
+      d[bayer2rgb->b_off] = CLAMP (b, 0, max) >> shift;
+      d[bayer2rgb->a_off] = 255;
+    }
+  }
+#undef P
+}
 
+static void
+gst_bayer2rgb_process_edge_aware (GstBayer2RGB * bayer2rgb, int y0, int y1)
+{
+  if (bayer2rgb->bits == 8)
+    gst_bayer2rgb_process_edge_aware_rows (bayer2rgb, y0, y1, 1, FALSE);
+  else if (bayer2rgb->big_endian)
+    gst_bayer2rgb_process_edge_aware_rows (bayer2rgb, y0, y1, 2, TRUE);
+  else
+    gst_bayer2rgb_process_edge_aware_rows (bayer2rgb, y0, y1, 2, FALSE);
+}
+
+static void
+gst_bayer2rgb_process_band (GstBayer2RGB * bayer2rgb, guint band)
+{
+  int y0 = (guint64) bayer2rgb->height * band / bayer2rgb->n_bands;
+  int y1 = (guint64) bayer2rgb->height * (band + 1) / bayer2rgb->n_bands;
+
+  if (y0 == y1)
+    return;
+
+  if (bayer2rgb->method == GST_BAYER2RGB_METHOD_EDGE_AWARE)
+    gst_bayer2rgb_process_edge_aware (bayer2rgb, y0, y1);
+  else
+    gst_bayer2rgb_process_bilinear (bayer2rgb,
+        bayer2rgb->tmp + band * BAND_TMP_SIZE (bayer2rgb->width), y0, y1);
+}
+
+static void
+gst_bayer2rgb_band_func (gpointer data, gpointer user_data)
+{
+  GstBayer2RGB *bayer2rgb = GST_BAYER2RGB (user_data);
+
+  gst_bayer2rgb_process_band (bayer2rgb, GPOINTER_TO_UINT (data) - 1);
+
+  g_mutex_lock (&bayer2rgb->lock);
+  if (--bayer2rgb->pending_bands == 0)
+    g_cond_signal (&bayer2rgb->cond);
+  g_mutex_unlock (&bayer2rgb->lock);
+}
+
+static void
+gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
+    int dest_stride, const uint8_t * src, int src_stride)
+{
+  guint n_bands, i;
+  gsize tmp_size;
+
+  n_bands = bayer2rgb->n_threads;
+  if (n_bands == 0)
+    n_bands = g_get_num_processors ();
+  n_bands = CLAMP (n_bands, 1, MAX (1, bayer2rgb->height / 16));
+  if (bayer2rgb->pool == NULL)
+    n_bands = 1;
+
+  /* only reallocated when the size or the number of bands grows */
+  tmp_size = n_bands * BAND_TMP_SIZE (bayer2rgb->width);
+  if (tmp_size > bayer2rgb->tmp_size) {
+    g_free (bayer2rgb->tmp);
+    bayer2rgb->tmp = g_malloc (tmp_size);
+    bayer2rgb->tmp_size = tmp_size;
+  }
+
+  bayer2rgb->dest = dest;
+  bayer2rgb->dest_stride = dest_stride;
+  bayer2rgb->src = src;
+  bayer2rgb->src_stride = src_stride;
+  bayer2rgb->n_bands = n_bands;
+
+  if (n_bands > 1) {
+    bayer2rgb->pending_bands = n_bands - 1;
+    g_thread_pool_set_max_threads (bayer2rgb->pool, n_bands - 1, NULL);
+    for (i = 1; i < n_bands; i++)
+      g_thread_pool_push (bayer2rgb->pool, GUINT_TO_POINTER (i + 1), NULL);
+  }
+
+  gst_bayer2rgb_process_band (bayer2rgb, 0);
+
+  if (n_bands > 1) {
+    g_mutex_lock (&bayer2rgb->lock);
+    while (bayer2rgb->pending_bands > 0)
+      g_cond_wait (&bayer2rgb->cond, &bayer2rgb->lock);
+    g_mutex_unlock (&bayer2rgb->lock);
+  }
+}
+
+static gboolean
+gst_bayer2rgb_start (GstBaseTransform * base)
+{
+  GstBayer2RGB *bayer2rgb = GST_BAYER2RGB (base);
+
+  bayer2rgb->pool = g_thread_pool_new (gst_bayer2rgb_band_func, bayer2rgb, 1,
+      FALSE, NULL);
+
+  return bayer2rgb->pool != NULL;
+}
+
+static gboolean
+gst_bayer2rgb_stop (GstBaseTransform * base)
+{
+  GstBayer2RGB *bayer2rgb = GST_BAYER2RGB (base);
+
+  if (bayer2rgb->pool) {
+    g_thread_pool_free (bayer2rgb->pool, FALSE, TRUE);
+    bayer2rgb->pool = NULL;
+  }
+
+  g_free (bayer2rgb->tmp);
+  bayer2rgb->tmp = NULL;
+  bayer2rgb->tmp_size = 0;
+
+  return TRUE;
+}
 
 static GstFlowReturn
 gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
@@ -471,7 +916,7 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
 
   output = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
   gst_bayer2rgb_process (filter, output, frame.info.stride[0],
-      map.data, GST_ROUND_UP_4 (filter->width));
+      map.data, gst_bayer2rgb_get_stride (filter->width, filter->bits));
 
   gst_video_frame_unmap (&frame);
   gst_buffer_unmap (inbuf, &map);
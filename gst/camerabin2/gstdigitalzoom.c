@@ -34,6 +34,10 @@
  *
  * Exposes the 'zoom' property as a float to allow setting the amount
  * of zoom desired. Zooming is done in the center.
+ *
+ * When all the elements downstream support #GstVideoCropMeta, the buffers
+ * pass through unmodified and the zoomed area is only attached to them as
+ * crop meta, leaving the cropping and scaling to them.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -106,6 +110,18 @@ gst_digital_zoom_update_crop (GstDigitalZoom * self, GstCaps * caps)
       left &= 0xFFFE;
     }
 
+    GST_OBJECT_LOCK (self);
+    if (zoom != 1.0 && self->use_crop_meta) {
+      self->crop_rect.x = left;
+      self->crop_rect.y = top;
+      self->crop_rect.w = width - left - right;
+      self->crop_rect.h = height - top - bottom;
+      left = right = top = bottom = 0;
+    } else {
+      self->crop_rect.w = self->crop_rect.h = 0;
+    }
+    GST_OBJECT_UNLOCK (self);
+
     GST_INFO_OBJECT (self,
         "sw cropping: left:%d, right:%d, top:%d, bottom:%d", left, right, top,
         bottom);
@@ -115,6 +131,69 @@ gst_digital_zoom_update_crop (GstDigitalZoom * self, GstCaps * caps)
   }
 }
 
+/* Asks downstream whether it handles crop meta, which a tee only answers
+ * positively when all its branches do. */
+static void
+gst_digital_zoom_check_crop_meta (GstDigitalZoom * self)
+{
+  GstQuery *query;
+  GstCaps *caps;
+  gboolean use_crop_meta = FALSE;
+
+  caps = gst_pad_get_current_caps (self->sinkpad);
+  if (caps) {
+    query = gst_query_new_allocation (caps, FALSE);
+    if (gst_pad_peer_query (self->srcpad, query))
+      use_crop_meta = gst_query_find_allocation_meta (query,
+          GST_VIDEO_CROP_META_API_TYPE, NULL);
+    gst_query_unref (query);
+    gst_caps_unref (caps);
+  }
+
+  if (use_crop_meta != self->use_crop_meta) {
+    GST_DEBUG_OBJECT (self, "%s crop meta", use_crop_meta ? "using" :
+        "not using");
+    self->use_crop_meta = use_crop_meta;
+    gst_digital_zoom_update_zoom (self);
+  }
+}
+
+static GstPadProbeReturn
+gst_digital_zoom_sink_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstDigitalZoom *self = GST_DIGITAL_ZOOM_CAST (user_data);
+  GstBuffer *buffer;
+  GstVideoCropMeta *meta;
+  GstVideoRectangle rect;
+
+  /* decided here, before the buffer reaches videocrop, as the outputs the
+   * camera source switches between differ in what they support */
+  if (self->check_crop_meta) {
+    self->check_crop_meta = FALSE;
+    gst_digital_zoom_check_crop_meta (self);
+  }
+
+  GST_OBJECT_LOCK (self);
+  rect = self->crop_rect;
+  GST_OBJECT_UNLOCK (self);
+
+  if (rect.w == 0 || rect.h == 0)
+    return GST_PAD_PROBE_OK;
+
+  buffer = gst_buffer_make_writable (GST_PAD_PROBE_INFO_BUFFER (info));
+  meta = gst_buffer_get_video_crop_meta (buffer);
+  if (!meta)
+    meta = gst_buffer_add_video_crop_meta (buffer);
+  meta->x = rect.x;
+  meta->y = rect.y;
+  meta->width = rect.w;
+  meta->height = rect.h;
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  return GST_PAD_PROBE_OK;
+}
+
 static void
 gst_digital_zoom_update_zoom (GstDigitalZoom * self)
 {
@@ -199,6 +278,18 @@ gst_digital_zoom_src_query (GstPad * sink, GstObject * parent, GstQuery * query)
   }
 }
 
+static gboolean
+gst_digital_zoom_src_event (GstPad * src, GstObject * parent, GstEvent * event)
+{
+  GstDigitalZoom *self = GST_DIGITAL_ZOOM_CAST (parent);
+
+  /* sent when the source pad is linked to another output */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_RECONFIGURE)
+    self->check_crop_meta = TRUE;
+
+  return gst_pad_event_default (src, parent, event);
+}
+
 static gboolean
 gst_digital_zoom_sink_event (GstPad * sink, GstObject * parent,
     GstEvent * event)
@@ -221,6 +312,7 @@ gst_digital_zoom_sink_event (GstPad * sink, GstObject * parent,
   ret = gst_pad_event_default (sink, parent, event);
 
   if (is_caps) {
+    self->check_crop_meta = TRUE;
     if (!ret) {
       gst_digital_zoom_update_crop (self, old_caps);
       g_object_set (self->capsfilter, "caps", old_caps, NULL);
@@ -268,6 +360,11 @@ gst_digital_zoom_init (GstDigitalZoom * self)
 
   gst_pad_set_query_function (self->srcpad,
       GST_DEBUG_FUNCPTR (gst_digital_zoom_src_query));
+  gst_pad_set_event_function (self->srcpad,
+      GST_DEBUG_FUNCPTR (gst_digital_zoom_src_event));
+
+  gst_pad_add_probe (self->sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+      gst_digital_zoom_sink_probe, self, NULL);
 
   self->zoom = 1;
 }
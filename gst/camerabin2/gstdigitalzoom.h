@@ -23,6 +23,7 @@
 #define __GST_DIGITAL_ZOOM_H__
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
@@ -62,6 +63,12 @@ struct _GstDigitalZoom
   GstPad *capsfilter_sinkpad;
 
   gfloat zoom;
+
+  /* when everything downstream handles GstVideoCropMeta, the zoomed area is
+   * only described in the buffers instead of being cropped and scaled */
+  gboolean use_crop_meta;
+  gboolean check_crop_meta;
+  GstVideoRectangle crop_rect;
 };
 
 
@@ -53,7 +53,9 @@ enum
 G_DEFINE_TYPE (GstColorEffects, gst_color_effects, GST_TYPE_VIDEO_FILTER);
 
 #define CAPS_STR GST_VIDEO_CAPS_MAKE ("{ " \
-    "ARGB, BGRA, ABGR, RGBA, xRGB, BGRx, xBGR, RGBx, RGB, BGR, AYUV }")
+    "ARGB, BGRA, ABGR, RGBA, xRGB, BGRx, xBGR, RGBx, RGB, BGR, AYUV, " \
+    "I420, YV12, Y42B, Y444, NV12, NV21, YUY2, UYVY, YVYU, " \
+    "I420_10LE, I420_10BE, I422_10LE, I422_10BE, Y444_10LE, Y444_10BE }")
 
 static GstStaticPadTemplate gst_color_effects_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -432,6 +434,134 @@ gst_color_effects_transform_ayuv (GstColorEffects * filter,
   }
 }
 
+/* samples deeper than 8 bits are read as 8 bits for the lookup and scaled
+ * back when written */
+static inline gint
+gst_color_effects_load (const guint8 * p, gint depth, gboolean big_endian)
+{
+  if (depth == 8)
+    return *p;
+
+  return (big_endian ? GST_READ_UINT16_BE (p) : GST_READ_UINT16_LE (p)) >>
+      (depth - 8);
+}
+
+static inline void
+gst_color_effects_store (guint8 * p, gint v, gint depth, gboolean big_endian)
+{
+  if (depth == 8) {
+    *p = v;
+  } else {
+    guint16 s = (v << (depth - 8)) | (v >> (16 - depth));
+
+    if (big_endian)
+      GST_WRITE_UINT16_BE (p, s);
+    else
+      GST_WRITE_UINT16_LE (p, s);
+  }
+}
+
+/* maps one pixel through the RGB table of the presets that work on each
+ * color component */
+static inline void
+gst_color_effects_map_yuv (GstColorEffects * filter, gint * y, gint * u,
+    gint * v)
+{
+  gint r, g, b;
+
+  r = APPLY_MATRIX (cog_ycbcr_to_rgb_matrix_8bit_sdtv, 0, *y, *u, *v);
+  g = APPLY_MATRIX (cog_ycbcr_to_rgb_matrix_8bit_sdtv, 1, *y, *u, *v);
+  b = APPLY_MATRIX (cog_ycbcr_to_rgb_matrix_8bit_sdtv, 2, *y, *u, *v);
+
+  r = filter->table[CLAMP (r, 0, 255) * 3];
+  g = filter->table[CLAMP (g, 0, 255) * 3 + 1];
+  b = filter->table[CLAMP (b, 0, 255) * 3 + 2];
+
+  *y = CLAMP (APPLY_MATRIX (cog_rgb_to_ycbcr_matrix_8bit_sdtv, 0, r, g, b),
+      0, 255);
+  *u = CLAMP (APPLY_MATRIX (cog_rgb_to_ycbcr_matrix_8bit_sdtv, 1, r, g, b),
+      0, 255);
+  *v = CLAMP (APPLY_MATRIX (cog_rgb_to_ycbcr_matrix_8bit_sdtv, 2, r, g, b),
+      0, 255);
+}
+
+/* works in place on the planes of any planar, semi-planar or packed 4:2:2
+ * YUV format. Every chroma sample is processed together with the luma
+ * samples it covers: those are mapped one by one and the chroma is set to
+ * the average of their mapped chroma, so no RGB frame is ever built */
+static void
+gst_color_effects_transform_yuv (GstColorEffects * filter,
+    GstVideoFrame * frame)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  gint depth = GST_VIDEO_FORMAT_INFO_DEPTH (finfo, 0);
+  gboolean big_endian = !GST_VIDEO_FORMAT_INFO_IS_LE (finfo);
+  gint w_sub = GST_VIDEO_FORMAT_INFO_W_SUB (finfo, 1);
+  gint h_sub = GST_VIDEO_FORMAT_INFO_H_SUB (finfo, 1);
+  gint width, height, chroma_width, chroma_height;
+  guint8 *ydata, *udata, *vdata;
+  gint y_stride, u_stride, v_stride;
+  gint y_pstride, u_pstride, v_pstride;
+  gint i, j, x, y;
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  height = GST_VIDEO_FRAME_HEIGHT (frame);
+  chroma_width = GST_VIDEO_FRAME_COMP_WIDTH (frame, 1);
+  chroma_height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 1);
+
+  ydata = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  udata = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+  vdata = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
+  y_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  u_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
+  v_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+  y_pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
+  u_pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 1);
+  v_pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 2);
+
+  for (i = 0; i < chroma_height; i++) {
+    gint y0 = i << h_sub;
+    gint y1 = MIN (y0 + (1 << h_sub), height);
+
+    for (j = 0; j < chroma_width; j++) {
+      gint x0 = j << w_sub;
+      gint x1 = MIN (x0 + (1 << w_sub), width);
+      guint8 *up = udata + i * u_stride + j * u_pstride;
+      guint8 *vp = vdata + i * v_stride + j * v_pstride;
+      gint u = gst_color_effects_load (up, depth, big_endian);
+      gint v = gst_color_effects_load (vp, depth, big_endian);
+      gint u_sum = 0, v_sum = 0, n = 0;
+
+      for (y = y0; y < y1; y++) {
+        guint8 *yp = ydata + y * y_stride + x0 * y_pstride;
+
+        for (x = x0; x < x1; x++) {
+          gint l = gst_color_effects_load (yp, depth, big_endian);
+          gint nu, nv;
+
+          if (filter->map_luma) {
+            nu = filter->lut_u[l];
+            nv = filter->lut_v[l];
+            l = filter->lut_y[l];
+          } else {
+            nu = u;
+            nv = v;
+            gst_color_effects_map_yuv (filter, &l, &nu, &nv);
+          }
+          gst_color_effects_store (yp, l, depth, big_endian);
+          u_sum += nu;
+          v_sum += nv;
+          n++;
+          yp += y_pstride;
+        }
+      }
+
+      gst_color_effects_store (up, (u_sum + n / 2) / n, depth, big_endian);
+      gst_color_effects_store (vp, (v_sum + n / 2) / n, depth, big_endian);
+    }
+  }
+}
+
 static gboolean
 gst_color_effects_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
@@ -453,6 +583,23 @@ gst_color_effects_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     case GST_VIDEO_FORMAT_AYUV:
       filter->process = gst_color_effects_transform_ayuv;
       break;
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_YV12:
+    case GST_VIDEO_FORMAT_Y42B:
+    case GST_VIDEO_FORMAT_Y444:
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_NV21:
+    case GST_VIDEO_FORMAT_YUY2:
+    case GST_VIDEO_FORMAT_UYVY:
+    case GST_VIDEO_FORMAT_YVYU:
+    case GST_VIDEO_FORMAT_I420_10LE:
+    case GST_VIDEO_FORMAT_I420_10BE:
+    case GST_VIDEO_FORMAT_I422_10LE:
+    case GST_VIDEO_FORMAT_I422_10BE:
+    case GST_VIDEO_FORMAT_Y444_10LE:
+    case GST_VIDEO_FORMAT_Y444_10BE:
+      filter->process = gst_color_effects_transform_yuv;
+      break;
     case GST_VIDEO_FORMAT_ARGB:
     case GST_VIDEO_FORMAT_ABGR:
     case GST_VIDEO_FORMAT_RGBA:
@@ -498,6 +645,31 @@ not_negotiated:
   return GST_FLOW_NOT_NEGOTIATED;
 }
 
+/* the presets mapping luma only give the same YUV result for a given luma
+ * value, precompute it for the YUV formats */
+static void
+gst_color_effects_update_luts (GstColorEffects * filter)
+{
+  gint i, r, g, b, y, u, v;
+
+  if (filter->table == NULL || !filter->map_luma)
+    return;
+
+  for (i = 0; i < 256; i++) {
+    r = filter->table[i * 3];
+    g = filter->table[i * 3 + 1];
+    b = filter->table[i * 3 + 2];
+
+    y = APPLY_MATRIX (cog_rgb_to_ycbcr_matrix_8bit_sdtv, 0, r, g, b);
+    u = APPLY_MATRIX (cog_rgb_to_ycbcr_matrix_8bit_sdtv, 1, r, g, b);
+    v = APPLY_MATRIX (cog_rgb_to_ycbcr_matrix_8bit_sdtv, 2, r, g, b);
+
+    filter->lut_y[i] = CLAMP (y, 0, 255);
+    filter->lut_u[i] = CLAMP (u, 0, 255);
+    filter->lut_v[i] = CLAMP (v, 0, 255);
+  }
+}
+
 static void
 gst_color_effects_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -537,6 +709,7 @@ gst_color_effects_set_property (GObject * object, guint prop_id,
           g_assert_not_reached ();
 
       }
+      gst_color_effects_update_luts (filter);
       GST_OBJECT_UNLOCK (filter);
       break;
     default:
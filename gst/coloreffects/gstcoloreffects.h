@@ -73,6 +73,11 @@ struct _GstColorEffects
   const guint8 *table;
   gboolean map_luma;
 
+  /* table[luma] converted to YUV, for the presets mapping luma */
+  guint8 lut_y[256];
+  guint8 lut_u[256];
+  guint8 lut_v[256];
+
   /* video format */
   GstVideoFormat format;
   gint width;
@@ -125,6 +125,7 @@ static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink_%u",
 #define DEFAULT_PAD_WIDTH  0
 #define DEFAULT_PAD_HEIGHT 0
 #define DEFAULT_PAD_ALPHA  1.0
+#define DEFAULT_PAD_CONVERTER_THREADS 1
 enum
 {
   PROP_PAD_0,
@@ -132,9 +133,18 @@ enum
   PROP_PAD_YPOS,
   PROP_PAD_WIDTH,
   PROP_PAD_HEIGHT,
-  PROP_PAD_ALPHA
+  PROP_PAD_ALPHA,
+  PROP_PAD_CONVERTER_THREADS
 };
 
+typedef struct
+{
+  GstVideoInfo in_info;
+  GstVideoInfo out_info;
+  guint n_threads;
+  GstVideoConverter *convert;
+} CompositorConverter;
+
 G_DEFINE_TYPE (GstCompositorPad, gst_compositor_pad,
     GST_TYPE_VIDEO_AGGREGATOR_PAD);
 
@@ -160,6 +170,9 @@ gst_compositor_pad_get_property (GObject * object, guint prop_id,
     case PROP_PAD_ALPHA:
       g_value_set_double (value, pad->alpha);
       break;
+    case PROP_PAD_CONVERTER_THREADS:
+      g_value_set_uint (value, pad->converter_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -188,6 +201,9 @@ gst_compositor_pad_set_property (GObject * object, guint prop_id,
     case PROP_PAD_ALPHA:
       pad->alpha = g_value_get_double (value);
       break;
+    case PROP_PAD_CONVERTER_THREADS:
+      pad->converter_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -242,6 +258,101 @@ _mixer_pad_get_output_size (GstCompositor * comp,
   *height = pad_height;
 }
 
+static void
+compositor_converter_free (CompositorConverter * converter)
+{
+  gst_video_converter_free (converter->convert);
+  g_slice_free (CompositorConverter, converter);
+}
+
+/* Returns a converter from @in_info to @out_info, reusing the one made for
+ * the same conversion before if it is still cached. Pads switching between a
+ * few resolutions, as adaptive streams do, then don't build a new converter
+ * and its tables on every switch. The converter stays owned by the cache. */
+static GstVideoConverter *
+gst_compositor_pad_get_converter (GstCompositorPad * cpad,
+    GstVideoInfo * in_info, GstVideoInfo * out_info)
+{
+  CompositorConverter *converter;
+  GstVideoConverter *convert;
+  guint n_threads = cpad->converter_threads;
+  GList *l;
+
+  for (l = cpad->converters; l; l = l->next) {
+    converter = l->data;
+
+    if (converter->n_threads == n_threads &&
+        gst_video_info_is_equal (&converter->in_info, in_info) &&
+        gst_video_info_is_equal (&converter->out_info, out_info)) {
+      GST_DEBUG_OBJECT (cpad, "Reusing cached converter");
+      cpad->converters = g_list_remove_link (cpad->converters, l);
+      cpad->converters = g_list_concat (l, cpad->converters);
+      return converter->convert;
+    }
+  }
+
+  convert = gst_video_converter_new (in_info, out_info,
+      gst_structure_new ("GstVideoConverter",
+          GST_VIDEO_CONVERTER_OPT_THREADS, G_TYPE_UINT, n_threads, NULL));
+  if (!convert)
+    return NULL;
+
+  converter = g_slice_new (CompositorConverter);
+  converter->in_info = *in_info;
+  converter->out_info = *out_info;
+  converter->n_threads = n_threads;
+  converter->convert = convert;
+  cpad->converters = g_list_prepend (cpad->converters, converter);
+
+  if (g_list_length (cpad->converters) > COMPOSITOR_MAX_CACHED_CONVERTERS) {
+    l = g_list_last (cpad->converters);
+    compositor_converter_free (l->data);
+    cpad->converters = g_list_delete_link (cpad->converters, l);
+  }
+
+  return convert;
+}
+
+/* Takes a buffer of @size bytes for a converted frame from the pad's pool,
+ * which is only recreated when the size changes */
+static GstBuffer *
+gst_compositor_pad_acquire_converted_buffer (GstCompositorPad * cpad,
+    gsize size)
+{
+  static GstAllocationParams params = { 0, 15, 0, 0, };
+  GstBuffer *buf = NULL;
+
+  if (cpad->pool && cpad->pool_size != size) {
+    gst_buffer_pool_set_active (cpad->pool, FALSE);
+    gst_object_unref (cpad->pool);
+    cpad->pool = NULL;
+  }
+
+  if (!cpad->pool) {
+    GstBufferPool *pool;
+    GstStructure *config;
+
+    pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+    gst_buffer_pool_config_set_allocator (config, NULL, &params);
+    if (!gst_buffer_pool_set_config (pool, config) ||
+        !gst_buffer_pool_set_active (pool, TRUE)) {
+      GST_WARNING_OBJECT (cpad, "Could not set up the conversion pool");
+      gst_object_unref (pool);
+      return NULL;
+    }
+
+    cpad->pool = pool;
+    cpad->pool_size = size;
+  }
+
+  if (gst_buffer_pool_acquire_buffer (cpad->pool, &buf, NULL) != GST_FLOW_OK)
+    return NULL;
+
+  return buf;
+}
+
 static gboolean
 gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
     GstVideoAggregator * vagg G_GNUC_UNUSED,
@@ -259,9 +370,6 @@ gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
   if (GST_VIDEO_INFO_FORMAT (current_info) == GST_VIDEO_FORMAT_UNKNOWN)
     return TRUE;
 
-  if (cpad->convert)
-    gst_video_converter_free (cpad->convert);
-
   cpad->convert = NULL;
 
   if (GST_VIDEO_INFO_MULTIVIEW_MODE (current_info) !=
@@ -309,7 +417,8 @@ gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
         GST_VIDEO_INFO_FORMAT (current_info),
         GST_VIDEO_INFO_FORMAT (&tmp_info));
 
-    cpad->convert = gst_video_converter_new (current_info, &tmp_info, NULL);
+    cpad->convert =
+        gst_compositor_pad_get_converter (cpad, current_info, &tmp_info);
     cpad->conversion_info = tmp_info;
     if (!cpad->convert) {
       g_free (colorimetry);
@@ -327,15 +436,125 @@ gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
   return TRUE;
 }
 
-/* Test whether rectangle2 contains rectangle 1 (geometrically) */
+/* Subtracts @cut from @rect, storing the remaining pieces in @out (which
+ * must have room for 4 rectangles). Returns the number of pieces. */
+static guint
+subtract_rectangle (const GstVideoRectangle * rect,
+    const GstVideoRectangle * cut, GstVideoRectangle * out)
+{
+  gint x1 = MAX (rect->x, cut->x);
+  gint y1 = MAX (rect->y, cut->y);
+  gint x2 = MIN (rect->x + rect->w, cut->x + cut->w);
+  gint y2 = MIN (rect->y + rect->h, cut->y + cut->h);
+  guint n = 0;
+
+  if (x1 >= x2 || y1 >= y2) {
+    out[n++] = *rect;
+    return n;
+  }
+
+  /* Above and below the cut, full width */
+  if (y1 > rect->y) {
+    out[n].x = rect->x;
+    out[n].y = rect->y;
+    out[n].w = rect->w;
+    out[n].h = y1 - rect->y;
+    n++;
+  }
+  if (y2 < rect->y + rect->h) {
+    out[n].x = rect->x;
+    out[n].y = y2;
+    out[n].w = rect->w;
+    out[n].h = rect->y + rect->h - y2;
+    n++;
+  }
+  /* Left and right of the cut, between the two above */
+  if (x1 > rect->x) {
+    out[n].x = rect->x;
+    out[n].y = y1;
+    out[n].w = x1 - rect->x;
+    out[n].h = y2 - y1;
+    n++;
+  }
+  if (x2 < rect->x + rect->w) {
+    out[n].x = x2;
+    out[n].y = y1;
+    out[n].w = rect->x + rect->w - x2;
+    out[n].h = y2 - y1;
+    n++;
+  }
+
+  return n;
+}
+
+/* Subtracts @cut from all @n_rects rectangles of @rects in place. Returns the
+ * new number of rectangles, or -1 if there would be more than @max_rects. */
+static gint
+subtract_rectangle_from_region (GstVideoRectangle * rects, guint n_rects,
+    guint max_rects, const GstVideoRectangle * cut)
+{
+  GstVideoRectangle result[COMPOSITOR_MAX_VISIBLE_RECTS];
+  GstVideoRectangle pieces[4];
+  guint i, j, n, n_result = 0;
+
+  g_assert (max_rects <= COMPOSITOR_MAX_VISIBLE_RECTS);
+
+  for (i = 0; i < n_rects; i++) {
+    n = subtract_rectangle (&rects[i], cut, pieces);
+    if (n_result + n > max_rects)
+      return -1;
+    for (j = 0; j < n; j++)
+      result[n_result++] = pieces[j];
+  }
+
+  memcpy (rects, result, n_result * sizeof (GstVideoRectangle));
+
+  return n_result;
+}
+
+/* Whether the pad's frame, once converted, overwrites everything below it */
 static gboolean
-is_rectangle_contained (GstVideoRectangle rect1, GstVideoRectangle rect2)
+_pad_is_opaque (GstVideoAggregatorPad * pad)
 {
-  if ((rect2.x <= rect1.x) && (rect2.y <= rect1.y) &&
-      ((rect2.x + rect2.w) >= (rect1.x + rect1.w)) &&
-      ((rect2.y + rect2.h) >= (rect1.y + rect1.h)))
-    return TRUE;
-  return FALSE;
+  GstCompositorPad *cpad = GST_COMPOSITOR_PAD (pad);
+
+  return pad->buffer && cpad->alpha == 1.0 &&
+      !GST_VIDEO_INFO_HAS_ALPHA (&pad->info);
+}
+
+/* The blend functions round positions up to the chroma subsampling of the
+ * format, so only count what is covered for sure, whatever the format */
+static GstVideoRectangle
+_get_cover_rectangle (gint x, gint y, gint w, gint h)
+{
+  GstVideoRectangle cover;
+
+  cover.x = GST_ROUND_UP_4 (x);
+  cover.y = GST_ROUND_UP_4 (y);
+  cover.w = MAX (0, x + w - cover.x);
+  cover.h = MAX (0, y + h - cover.y);
+
+  return cover;
+}
+
+/* Shrinks @rect to the 4 pixel grid starting at @x, @y */
+static GstVideoRectangle
+_align_rectangle_to_origin (const GstVideoRectangle * rect, gint x, gint y)
+{
+  GstVideoRectangle aligned;
+  gint x1, y1, x2, y2;
+
+  x1 = GST_ROUND_UP_4 (rect->x - x);
+  y1 = GST_ROUND_UP_4 (rect->y - y);
+  x2 = GST_ROUND_DOWN_4 (rect->x + rect->w - x);
+  y2 = GST_ROUND_DOWN_4 (rect->y + rect->h - y);
+
+  aligned.x = x + x1;
+  aligned.y = y + y1;
+  aligned.w = MAX (0, x2 - x1);
+  aligned.h = MAX (0, y2 - y1);
+
+  return aligned;
 }
 
 static GstVideoRectangle
@@ -358,6 +577,116 @@ clamp_rectangle (gint x, gint y, gint w, gint h, gint outer_width,
   return clamped;
 }
 
+/* Finds the parts of the pad's frame that are not covered by opaque
+ * higher-zorder frames. This looks at the other pads, so it is done for all
+ * pads before any frame is prepared, which can happen in parallel. */
+static void
+gst_compositor_pad_prepare_frame_start (GstVideoAggregatorPad * pad,
+    GstVideoAggregator * vagg)
+{
+  GstCompositor *comp = GST_COMPOSITOR (vagg);
+  GstCompositorPad *cpad = GST_COMPOSITOR_PAD (pad);
+  gint width, height;
+  gboolean frame_obscured = FALSE;
+  gint n_visible;
+  GList *l;
+  /* The rectangle representing this frame, clamped to the video's boundaries.
+   * Due to the clamping, this is different from the frame width/height. */
+  GstVideoRectangle frame_rect;
+
+  cpad->obscured = TRUE;
+  cpad->n_visible_rects = 0;
+
+  _mixer_pad_get_output_size (comp, cpad, GST_VIDEO_INFO_PAR_N (&vagg->info),
+      GST_VIDEO_INFO_PAR_D (&vagg->info), &width, &height);
+
+  if (cpad->alpha == 0.0) {
+    GST_DEBUG_OBJECT (vagg, "Pad has alpha 0.0, not converting frame");
+    return;
+  }
+
+  frame_rect = clamp_rectangle (cpad->xpos, cpad->ypos, width, height,
+      GST_VIDEO_INFO_WIDTH (&vagg->info), GST_VIDEO_INFO_HEIGHT (&vagg->info));
+
+  if (frame_rect.w == 0 || frame_rect.h == 0) {
+    GST_DEBUG_OBJECT (vagg, "Resulting frame is zero-width or zero-height "
+        "(w: %i, h: %i), skipping", frame_rect.w, frame_rect.h);
+    return;
+  }
+
+  /* Find the parts of this frame that are not covered by opaque
+   * higher-zorder frames. If nothing is left, the frame is obscured and
+   * does not need to be converted or blended at all. */
+  cpad->visible_rects[0] = frame_rect;
+  n_visible = 1;
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = g_list_find (GST_ELEMENT (vagg)->sinkpads, pad)->next; l;
+      l = l->next) {
+    GstVideoRectangle frame2_rect;
+    GstVideoAggregatorPad *pad2 = l->data;
+    GstCompositorPad *cpad2 = GST_COMPOSITOR_PAD (pad2);
+    gint pad2_width, pad2_height;
+
+    /* Check if there's a buffer to be aggregated, ensure it can't have an
+     * alpha channel and check opacity */
+    if (!_pad_is_opaque (pad2))
+      continue;
+
+    _mixer_pad_get_output_size (comp, cpad2, GST_VIDEO_INFO_PAR_N (&vagg->info),
+        GST_VIDEO_INFO_PAR_D (&vagg->info), &pad2_width, &pad2_height);
+
+    /* We don't need to clamp the coords of the second rectangle. The size is
+     * effectively what set_info and the conversion code in prepare_frame
+     * do to calculate the desired width/height */
+    frame2_rect = _get_cover_rectangle (cpad2->xpos, cpad2->ypos, pad2_width,
+        pad2_height);
+
+    /* Also align the covered part to this frame's origin, so that the
+     * visible parts can be blended without overlapping each other */
+    frame2_rect = _align_rectangle_to_origin (&frame2_rect, cpad->xpos,
+        cpad->ypos);
+    if (frame2_rect.w == 0 || frame2_rect.h == 0)
+      continue;
+
+    n_visible = subtract_rectangle_from_region (cpad->visible_rects,
+        n_visible, COMPOSITOR_MAX_VISIBLE_RECTS, &frame2_rect);
+    if (n_visible < 0) {
+      /* Too fragmented to be worth tracking, start over from the whole
+       * frame. A frame further up could still obscure all of it. */
+      cpad->visible_rects[0] = frame_rect;
+      n_visible = subtract_rectangle_from_region (cpad->visible_rects, 1,
+          COMPOSITOR_MAX_VISIBLE_RECTS, &frame2_rect);
+    }
+
+    if (n_visible == 0) {
+      frame_obscured = TRUE;
+      GST_DEBUG_OBJECT (pad, "%ix%i@(%i,%i) obscured by %s %ix%i@(%i,%i) "
+          "in output of size %ix%i; skipping frame", frame_rect.w, frame_rect.h,
+          frame_rect.x, frame_rect.y, GST_PAD_NAME (pad2), frame2_rect.w,
+          frame2_rect.h, frame2_rect.x, frame2_rect.y,
+          GST_VIDEO_INFO_WIDTH (&vagg->info),
+          GST_VIDEO_INFO_HEIGHT (&vagg->info));
+      break;
+    }
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  /* Only keep the visible region if the frame is really partially covered */
+  if (n_visible == 1 && cpad->visible_rects[0].x == frame_rect.x &&
+      cpad->visible_rects[0].y == frame_rect.y &&
+      cpad->visible_rects[0].w == frame_rect.w &&
+      cpad->visible_rects[0].h == frame_rect.h)
+    n_visible = 0;
+  if (frame_obscured)
+    return;
+
+  cpad->n_visible_rects = n_visible;
+  cpad->obscured = FALSE;
+}
+
+
+
 static gboolean
 gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
     GstVideoAggregator * vagg)
@@ -368,13 +697,7 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
   GstVideoFrame *converted_frame;
   GstBuffer *converted_buf = NULL;
   GstVideoFrame *frame;
-  static GstAllocationParams params = { 0, 15, 0, 0, };
   gint width, height;
-  gboolean frame_obscured = FALSE;
-  GList *l;
-  /* The rectangle representing this frame, clamped to the video's boundaries.
-   * Due to the clamping, this is different from the frame width/height above. */
-  GstVideoRectangle frame_rect;
 
   if (!pad->buffer)
     return TRUE;
@@ -405,8 +728,6 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
      * the only reason for conversion was a different
      * width or height
      */
-    if (cpad->convert)
-      gst_video_converter_free (cpad->convert);
     cpad->convert = NULL;
 
     colorimetry = gst_video_colorimetry_to_string (&pad->info.colorimetry);
@@ -440,7 +761,8 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
           GST_VIDEO_INFO_FORMAT (&pad->info),
           GST_VIDEO_INFO_FORMAT (&tmp_info));
 
-      cpad->convert = gst_video_converter_new (&pad->info, &tmp_info, NULL);
+      cpad->convert =
+          gst_compositor_pad_get_converter (cpad, &pad->info, &tmp_info);
       cpad->conversion_info = tmp_info;
 
       if (!cpad->convert) {
@@ -458,62 +780,7 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
     g_free (wanted_colorimetry);
   }
 
-  if (cpad->alpha == 0.0) {
-    GST_DEBUG_OBJECT (vagg, "Pad has alpha 0.0, not converting frame");
-    converted_frame = NULL;
-    goto done;
-  }
-
-  frame_rect = clamp_rectangle (cpad->xpos, cpad->ypos, width, height,
-      GST_VIDEO_INFO_WIDTH (&vagg->info), GST_VIDEO_INFO_HEIGHT (&vagg->info));
-
-  if (frame_rect.w == 0 || frame_rect.h == 0) {
-    GST_DEBUG_OBJECT (vagg, "Resulting frame is zero-width or zero-height "
-        "(w: %i, h: %i), skipping", frame_rect.w, frame_rect.h);
-    converted_frame = NULL;
-    goto done;
-  }
-
-  GST_OBJECT_LOCK (vagg);
-  /* Check if this frame is obscured by a higher-zorder frame
-   * TODO: Also skip a frame if it's obscured by a combination of
-   * higher-zorder frames */
-  for (l = g_list_find (GST_ELEMENT (vagg)->sinkpads, pad)->next; l;
-      l = l->next) {
-    GstVideoRectangle frame2_rect;
-    GstVideoAggregatorPad *pad2 = l->data;
-    GstCompositorPad *cpad2 = GST_COMPOSITOR_PAD (pad2);
-    gint pad2_width, pad2_height;
-
-    _mixer_pad_get_output_size (comp, cpad2, GST_VIDEO_INFO_PAR_N (&vagg->info),
-        GST_VIDEO_INFO_PAR_D (&vagg->info), &pad2_width, &pad2_height);
-
-    /* We don't need to clamp the coords of the second rectangle */
-    frame2_rect.x = cpad2->xpos;
-    frame2_rect.y = cpad2->ypos;
-    /* This is effectively what set_info and the above conversion
-     * code do to calculate the desired width/height */
-    frame2_rect.w = pad2_width;
-    frame2_rect.h = pad2_height;
-
-    /* Check if there's a buffer to be aggregated, ensure it can't have an alpha
-     * channel, then check opacity and frame boundaries */
-    if (pad2->buffer && cpad2->alpha == 1.0 &&
-        !GST_VIDEO_INFO_HAS_ALPHA (&pad2->info) &&
-        is_rectangle_contained (frame_rect, frame2_rect)) {
-      frame_obscured = TRUE;
-      GST_DEBUG_OBJECT (pad, "%ix%i@(%i,%i) obscured by %s %ix%i@(%i,%i) "
-          "in output of size %ix%i; skipping frame", frame_rect.w, frame_rect.h,
-          frame_rect.x, frame_rect.y, GST_PAD_NAME (pad2), frame2_rect.w,
-          frame2_rect.h, frame2_rect.x, frame2_rect.y,
-          GST_VIDEO_INFO_WIDTH (&vagg->info),
-          GST_VIDEO_INFO_HEIGHT (&vagg->info));
-      break;
-    }
-  }
-  GST_OBJECT_UNLOCK (vagg);
-
-  if (frame_obscured) {
+  if (cpad->obscured) {
     converted_frame = NULL;
     goto done;
   }
@@ -534,12 +801,15 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
     converted_size = GST_VIDEO_INFO_SIZE (&cpad->conversion_info);
     outsize = GST_VIDEO_INFO_SIZE (&vagg->info);
     converted_size = converted_size > outsize ? converted_size : outsize;
-    converted_buf = gst_buffer_new_allocate (NULL, converted_size, &params);
+    converted_buf =
+        gst_compositor_pad_acquire_converted_buffer (cpad, converted_size);
 
-    if (!gst_video_frame_map (converted_frame, &(cpad->conversion_info),
-            converted_buf, GST_MAP_READWRITE)) {
+    if (!converted_buf || !gst_video_frame_map (converted_frame,
+            &(cpad->conversion_info), converted_buf, GST_MAP_READWRITE)) {
       GST_WARNING_OBJECT (vagg, "Could not map converted frame");
 
+      if (converted_buf)
+        gst_buffer_unref (converted_buf);
       g_slice_free (GstVideoFrame, converted_frame);
       gst_video_frame_unmap (frame);
       g_slice_free (GstVideoFrame, frame);
@@ -566,6 +836,8 @@ gst_compositor_pad_clean_frame (GstVideoAggregatorPad * pad,
 {
   GstCompositorPad *cpad = GST_COMPOSITOR_PAD (pad);
 
+  cpad->n_visible_rects = 0;
+
   if (pad->aggregated_frame) {
     gst_video_frame_unmap (pad->aggregated_frame);
     g_slice_free (GstVideoFrame, pad->aggregated_frame);
@@ -583,10 +855,16 @@ gst_compositor_pad_finalize (GObject * object)
 {
   GstCompositorPad *pad = GST_COMPOSITOR_PAD (object);
 
-  if (pad->convert)
-    gst_video_converter_free (pad->convert);
+  g_list_free_full (pad->converters, (GDestroyNotify) compositor_converter_free);
+  pad->converters = NULL;
   pad->convert = NULL;
 
+  if (pad->pool) {
+    gst_buffer_pool_set_active (pad->pool, FALSE);
+    gst_object_unref (pad->pool);
+    pad->pool = NULL;
+  }
+
   G_OBJECT_CLASS (gst_compositor_pad_parent_class)->finalize (object);
 }
 
@@ -622,7 +900,25 @@ gst_compositor_pad_class_init (GstCompositorPadClass * klass)
           DEFAULT_PAD_ALPHA,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCompositorPad:converter-threads:
+   *
+   * Maximum number of threads the converter of this pad uses for scaling and
+   * converting its frames. 0 uses one thread per CPU core. A different value
+   * takes effect with the next caps or size change of the pad.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_CONVERTER_THREADS,
+      g_param_spec_uint ("converter-threads", "Converter threads",
+          "Maximum number of threads used to convert the frames of this pad "
+          "(0 = one per CPU core)", 0, G_MAXUINT,
+          DEFAULT_PAD_CONVERTER_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   vaggpadclass->set_info = GST_DEBUG_FUNCPTR (gst_compositor_pad_set_info);
+  vaggpadclass->prepare_frame_start =
+      GST_DEBUG_FUNCPTR (gst_compositor_pad_prepare_frame_start);
   vaggpadclass->prepare_frame =
       GST_DEBUG_FUNCPTR (gst_compositor_pad_prepare_frame);
   vaggpadclass->clean_frame =
@@ -635,6 +931,7 @@ gst_compositor_pad_init (GstCompositorPad * compo_pad)
   compo_pad->xpos = DEFAULT_PAD_XPOS;
   compo_pad->ypos = DEFAULT_PAD_YPOS;
   compo_pad->alpha = DEFAULT_PAD_ALPHA;
+  compo_pad->converter_threads = DEFAULT_PAD_CONVERTER_THREADS;
 }
 
 
@@ -643,9 +940,12 @@ gst_compositor_pad_init (GstCompositorPad * compo_pad)
 enum
 {
   PROP_0,
-  PROP_BACKGROUND
+  PROP_BACKGROUND,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 #define GST_TYPE_COMPOSITOR_BACKGROUND (gst_compositor_background_get_type())
 static GType
 gst_compositor_background_get_type (void)
@@ -679,6 +979,11 @@ gst_compositor_get_property (GObject * object,
     case PROP_BACKGROUND:
       g_value_set_enum (value, self->background);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->n_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -695,6 +1000,11 @@ gst_compositor_set_property (GObject * object,
     case PROP_BACKGROUND:
       self->background = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -963,24 +1273,95 @@ _negotiated_caps (GstAggregator * agg, GstCaps * caps)
   return GST_AGGREGATOR_CLASS (parent_class)->negotiated_src_caps (agg, caps);
 }
 
-static GstFlowReturn
-gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
+/* One input frame to be blended into the output, snapshotted from the pad
+ * so the stripes can be blended without holding the object lock */
+typedef struct
 {
-  GList *l;
-  GstCompositor *self = GST_COMPOSITOR (vagg);
+  GstVideoFrame *frame;
+  gint xpos, ypos;
+  gdouble alpha;
+  gboolean opaque;
+
+  /* Only these parts of the frame need blending if there are any */
+  const GstVideoRectangle *visible_rects;
+  guint n_visible_rects;
+} CompositorInput;
+
+typedef struct
+{
+  GstCompositor *self;
+  GstVideoFrame *outframe;
+  gint y, height;
   BlendFunction composite;
-  GstVideoFrame out_frame, *outframe;
+  CompositorInput *inputs;
+  guint n_inputs;
+} CompositorStripe;
+
+/* Stripe boundaries are aligned to 16 lines: this keeps them on a chroma
+ * line boundary for all subsampled formats and lines the checker pattern
+ * up with the one of the full frame, so the result does not depend on the
+ * number of stripes */
+#define STRIPE_ALIGN 16
+
+/* Makes @subframe a view of the @width x @height rectangle at @x, @y of
+ * @frame. @x and @y must be multiples of the chroma subsampling of the
+ * format and the subframe must not be unmapped. */
+static void
+_video_frame_get_subframe (GstVideoFrame * frame, gint x, gint y, gint width,
+    gint height, GstVideoFrame * subframe)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  guint comp, plane;
 
-  if (!gst_video_frame_map (&out_frame, &vagg->info, outbuf, GST_MAP_WRITE)) {
-    GST_WARNING_OBJECT (vagg, "Could not map output buffer");
-    return GST_FLOW_ERROR;
+  *subframe = *frame;
+  GST_VIDEO_INFO_WIDTH (&subframe->info) = width;
+  GST_VIDEO_INFO_HEIGHT (&subframe->info) = height;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (frame); plane++) {
+    for (comp = 0; comp < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo); comp++) {
+      if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, comp) == plane)
+        break;
+    }
+
+    subframe->data[plane] = (guint8 *) frame->data[plane] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, comp, y) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane) +
+        GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, comp, x) *
+        GST_VIDEO_FORMAT_INFO_PSTRIDE (finfo, comp);
   }
+}
 
-  outframe = &out_frame;
-  /* default to blending */
-  composite = self->blend;
-  /* TODO: If the frames to be composited completely obscure the background,
-   * don't bother drawing the background at all. */
+/* Whether the opaque inputs together cover all of @rect */
+static gboolean
+_inputs_cover_rectangle (CompositorInput * inputs, guint n_inputs,
+    const GstVideoRectangle * rect)
+{
+  GstVideoRectangle region[COMPOSITOR_MAX_VISIBLE_RECTS];
+  gint n_region = 1;
+  guint i;
+
+  region[0] = *rect;
+  for (i = 0; i < n_inputs && n_region > 0; i++) {
+    GstVideoRectangle cover;
+
+    if (!inputs[i].opaque)
+      continue;
+
+    cover = _get_cover_rectangle (inputs[i].xpos, inputs[i].ypos,
+        GST_VIDEO_FRAME_WIDTH (inputs[i].frame),
+        GST_VIDEO_FRAME_HEIGHT (inputs[i].frame));
+    n_region = subtract_rectangle_from_region (region, n_region,
+        COMPOSITOR_MAX_VISIBLE_RECTS, &cover);
+    if (n_region < 0)
+      return FALSE;
+  }
+
+  return n_region == 0;
+}
+
+static void
+gst_compositor_fill_background (GstCompositor * self, GstVideoFrame * outframe)
+{
   switch (self->background) {
     case COMPOSITOR_BACKGROUND_CHECKER:
       self->fill_checker (outframe);
@@ -1010,25 +1391,223 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
           pdata += plane_stride;
         }
       }
-
-      /* use overlay to keep background transparent */
-      composite = self->overlay;
       break;
     }
   }
+}
+
+/* Blends the @width x @height rectangle at @x, @y (in input coordinates) of
+ * @input into @dest, which starts at line @dest_y of the output */
+static void
+gst_compositor_blend_input_region (BlendFunction composite,
+    CompositorInput * input, gint x, gint y, gint width, gint height,
+    GstVideoFrame * dest, gint dest_y)
+{
+  GstVideoFrame subframe;
+  gint ypos = input->ypos + y;
+
+  /* Skip regions that don't intersect with the destination at all */
+  if (ypos >= dest_y + GST_VIDEO_FRAME_HEIGHT (dest) ||
+      ypos + height <= dest_y)
+    return;
+
+  if (x == 0 && y == 0 && width == GST_VIDEO_FRAME_WIDTH (input->frame) &&
+      height == GST_VIDEO_FRAME_HEIGHT (input->frame)) {
+    composite (input->frame, input->xpos, ypos - dest_y, input->alpha, dest);
+  } else {
+    _video_frame_get_subframe (input->frame, x, y, width, height, &subframe);
+    composite (&subframe, input->xpos + x, ypos - dest_y, input->alpha, dest);
+  }
+}
+
+/* Fills the background of one stripe and blends the contribution of every
+ * input to it, in z-order */
+static void
+gst_compositor_blend_stripe (CompositorStripe * stripe)
+{
+  GstVideoFrame stripe_frame;
+  GstVideoRectangle stripe_rect;
+  guint i, j;
+
+  _video_frame_get_subframe (stripe->outframe, 0, stripe->y,
+      GST_VIDEO_FRAME_WIDTH (stripe->outframe), stripe->height, &stripe_frame);
+
+  /* Don't bother drawing the background if opaque frames cover all of it */
+  stripe_rect.x = 0;
+  stripe_rect.y = stripe->y;
+  stripe_rect.w = GST_VIDEO_FRAME_WIDTH (stripe->outframe);
+  stripe_rect.h = stripe->height;
+  if (!_inputs_cover_rectangle (stripe->inputs, stripe->n_inputs,
+          &stripe_rect))
+    gst_compositor_fill_background (stripe->self, &stripe_frame);
+
+  for (i = 0; i < stripe->n_inputs; i++) {
+    CompositorInput *input = &stripe->inputs[i];
+    gint frame_width = GST_VIDEO_FRAME_WIDTH (input->frame);
+    gint frame_height = GST_VIDEO_FRAME_HEIGHT (input->frame);
+
+    if (input->n_visible_rects == 0) {
+      gst_compositor_blend_input_region (stripe->composite, input, 0, 0,
+          frame_width, frame_height, &stripe_frame, stripe->y);
+      continue;
+    }
+
+    /* Partially covered: only blend the visible parts. Their edges are on
+     * the 4 pixel grid of the frame, except where they were clamped to the
+     * output, and rounding those outwards only touches clipped pixels. */
+    for (j = 0; j < input->n_visible_rects; j++) {
+      const GstVideoRectangle *rect = &input->visible_rects[j];
+      gint x1, y1, x2, y2;
+
+      x1 = GST_ROUND_DOWN_4 (MAX (0, rect->x - input->xpos));
+      y1 = GST_ROUND_DOWN_4 (MAX (0, rect->y - input->ypos));
+      x2 = MIN (frame_width, GST_ROUND_UP_4 (rect->x + rect->w - input->xpos));
+      y2 = MIN (frame_height,
+          GST_ROUND_UP_4 (rect->y + rect->h - input->ypos));
+
+      if (x2 > x1 && y2 > y1)
+        gst_compositor_blend_input_region (stripe->composite, input, x1, y1,
+            x2 - x1, y2 - y1, &stripe_frame, stripe->y);
+    }
+  }
+}
+
+static void
+gst_compositor_blend_stripe_worker (CompositorStripe * stripe,
+    GstCompositor * self)
+{
+  gst_compositor_blend_stripe (stripe);
+
+  g_mutex_lock (&self->blend_lock);
+  if (--self->blend_pending == 0)
+    g_cond_signal (&self->blend_cond);
+  g_mutex_unlock (&self->blend_lock);
+}
+
+/* Makes sure the worker pool matches the n-threads property and returns the
+ * number of threads to use */
+static guint
+gst_compositor_ensure_blend_pool (GstCompositor * self)
+{
+  guint n_threads;
+
+  GST_OBJECT_LOCK (self);
+  n_threads = self->n_threads;
+  GST_OBJECT_UNLOCK (self);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  if (n_threads <= 1) {
+    if (self->blend_pool) {
+      g_thread_pool_free (self->blend_pool, FALSE, TRUE);
+      self->blend_pool = NULL;
+    }
+    return 1;
+  }
+
+  if (self->blend_pool == NULL) {
+    GError *err = NULL;
+
+    GST_DEBUG_OBJECT (self, "Blending with %u threads", n_threads);
+    self->blend_pool =
+        g_thread_pool_new ((GFunc) gst_compositor_blend_stripe_worker, self,
+        n_threads, FALSE, &err);
+    if (self->blend_pool == NULL) {
+      GST_WARNING_OBJECT (self, "Could not create worker pool: %s",
+          err->message);
+      g_clear_error (&err);
+      return 1;
+    }
+  } else if (g_thread_pool_get_max_threads (self->blend_pool) !=
+      (gint) n_threads) {
+    g_thread_pool_set_max_threads (self->blend_pool, n_threads, NULL);
+  }
+
+  return n_threads;
+}
+
+static GstFlowReturn
+gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
+{
+  GList *l;
+  GstCompositor *self = GST_COMPOSITOR (vagg);
+  BlendFunction composite;
+  GstVideoFrame out_frame, *outframe;
+  CompositorInput *inputs;
+  CompositorStripe *stripes;
+  guint n_inputs = 0, n_stripes, n_threads, i;
+  gint height, stripe_height;
+
+  if (!gst_video_frame_map (&out_frame, &vagg->info, outbuf, GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (vagg, "Could not map output buffer");
+    return GST_FLOW_ERROR;
+  }
+
+  outframe = &out_frame;
+  /* default to blending, use overlay to keep a transparent background
+   * transparent */
+  composite = self->blend;
+  if (self->background == COMPOSITOR_BACKGROUND_TRANSPARENT)
+    composite = self->overlay;
 
   GST_OBJECT_LOCK (vagg);
+  inputs = g_newa (CompositorInput, GST_ELEMENT (vagg)->numsinkpads);
   for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
     GstVideoAggregatorPad *pad = l->data;
     GstCompositorPad *compo_pad = GST_COMPOSITOR_PAD (pad);
 
     if (pad->aggregated_frame != NULL) {
-      composite (pad->aggregated_frame, compo_pad->xpos, compo_pad->ypos,
-          compo_pad->alpha, outframe);
+      inputs[n_inputs].frame = pad->aggregated_frame;
+      inputs[n_inputs].xpos = compo_pad->xpos;
+      inputs[n_inputs].ypos = compo_pad->ypos;
+      inputs[n_inputs].alpha = compo_pad->alpha;
+      inputs[n_inputs].opaque = _pad_is_opaque (pad);
+      inputs[n_inputs].visible_rects = compo_pad->visible_rects;
+      inputs[n_inputs].n_visible_rects = compo_pad->n_visible_rects;
+      n_inputs++;
     }
   }
   GST_OBJECT_UNLOCK (vagg);
 
+  /* Split the output into horizontal stripes, one per thread, each of them
+   * at least STRIPE_ALIGN lines high */
+  height = GST_VIDEO_FRAME_HEIGHT (outframe);
+  n_threads = gst_compositor_ensure_blend_pool (self);
+  n_stripes = MAX (1, MIN (n_threads, height / STRIPE_ALIGN));
+  stripe_height = GST_ROUND_UP_N ((height + n_stripes - 1) / n_stripes,
+      STRIPE_ALIGN);
+  n_stripes = (height + stripe_height - 1) / stripe_height;
+
+  stripes = g_newa (CompositorStripe, n_stripes);
+  for (i = 0; i < n_stripes; i++) {
+    stripes[i].self = self;
+    stripes[i].outframe = outframe;
+    stripes[i].y = i * stripe_height;
+    stripes[i].height = MIN (stripe_height, height - stripes[i].y);
+    stripes[i].composite = composite;
+    stripes[i].inputs = inputs;
+    stripes[i].n_inputs = n_inputs;
+  }
+
+  if (n_stripes == 1) {
+    gst_compositor_blend_stripe (&stripes[0]);
+  } else {
+    g_mutex_lock (&self->blend_lock);
+    self->blend_pending = n_stripes - 1;
+    g_mutex_unlock (&self->blend_lock);
+
+    /* Blend the first stripe from this thread while the pool does the rest */
+    for (i = 1; i < n_stripes; i++)
+      g_thread_pool_push (self->blend_pool, &stripes[i], NULL);
+    gst_compositor_blend_stripe (&stripes[0]);
+
+    g_mutex_lock (&self->blend_lock);
+    while (self->blend_pending > 0)
+      g_cond_wait (&self->blend_cond, &self->blend_lock);
+    g_mutex_unlock (&self->blend_lock);
+  }
+
   gst_video_frame_unmap (outframe);
 
   return GST_FLOW_OK;
@@ -1076,6 +1655,21 @@ _sink_query (GstAggregator * agg, GstAggregatorPad * bpad, GstQuery * query)
   }
 }
 
+static void
+gst_compositor_finalize (GObject * object)
+{
+  GstCompositor *self = GST_COMPOSITOR (object);
+
+  if (self->blend_pool)
+    g_thread_pool_free (self->blend_pool, FALSE, TRUE);
+  self->blend_pool = NULL;
+
+  g_mutex_clear (&self->blend_lock);
+  g_cond_clear (&self->blend_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 /* GObject boilerplate */
 static void
 gst_compositor_class_init (GstCompositorClass * klass)
@@ -1088,6 +1682,7 @@ gst_compositor_class_init (GstCompositorClass * klass)
 
   gobject_class->get_property = gst_compositor_get_property;
   gobject_class->set_property = gst_compositor_set_property;
+  gobject_class->finalize = gst_compositor_finalize;
 
   agg_class->sinkpads_type = GST_TYPE_COMPOSITOR_PAD;
   agg_class->sink_query = _sink_query;
@@ -1100,6 +1695,22 @@ gst_compositor_class_init (GstCompositorClass * klass)
           GST_TYPE_COMPOSITOR_BACKGROUND,
           DEFAULT_BACKGROUND, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCompositor:n-threads:
+   *
+   * Number of threads used to blend the output frame. The output is split
+   * into horizontal stripes and each thread blends all inputs into its own
+   * stripe, so the result is the same for any number of threads.
+   * 0 uses one thread per CPU.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of Threads",
+          "Number of threads used for blending (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
 
@@ -1113,6 +1724,9 @@ static void
 gst_compositor_init (GstCompositor * self)
 {
   self->background = DEFAULT_BACKGROUND;
+  self->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&self->blend_lock);
+  g_cond_init (&self->blend_cond);
   /* initialize variables */
 }
 
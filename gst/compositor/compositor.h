@@ -73,6 +73,16 @@ struct _GstCompositor
   BlendFunction blend, overlay;
   FillCheckerFunction fill_checker;
   FillColorFunction fill_color;
+
+  /* n-threads property, protected by the object lock */
+  guint n_threads;
+
+  /* Worker pool blending the output stripes, only accessed from
+   * aggregate_frames */
+  GThreadPool *blend_pool;
+  GMutex blend_lock;
+  GCond blend_cond;
+  guint blend_pending;
 };
 
 struct _GstCompositorClass
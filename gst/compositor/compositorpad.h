@@ -39,6 +39,13 @@ G_BEGIN_DECLS
 typedef struct _GstCompositorPad GstCompositorPad;
 typedef struct _GstCompositorPadClass GstCompositorPadClass;
 
+/* Maximum number of disjoint regions tracked for a partially covered pad,
+ * beyond that the whole pad is blended */
+#define COMPOSITOR_MAX_VISIBLE_RECTS 16
+
+/* Number of converters a pad keeps around for conversions it did before */
+#define COMPOSITOR_MAX_CACHED_CONVERTERS 4
+
 /**
  * GstCompositorPad:
  *
@@ -52,10 +59,27 @@ struct _GstCompositorPad
   gint xpos, ypos;
   gint width, height;
   gdouble alpha;
+  guint converter_threads;
 
+  /* current converter, owned by the converters cache */
   GstVideoConverter *convert;
   GstVideoInfo conversion_info;
   GstBuffer *converted_buffer;
+
+  /* most recently used first */
+  GList *converters;
+
+  /* pool of the converted frames */
+  GstBufferPool *pool;
+  gsize pool_size;
+
+  /* Parts of the pad not covered by opaque higher-zorder pads, in output
+   * coordinates. 0 rectangles means the whole frame is visible, unless
+   * nothing of it is visible at all, in which case obscured is set. Both
+   * are updated in prepare_frame_start. */
+  GstVideoRectangle visible_rects[COMPOSITOR_MAX_VISIBLE_RECTS];
+  guint n_visible_rects;
+  gboolean obscured;
 };
 
 struct _GstCompositorPadClass
@@ -54,6 +54,7 @@
 #define DEFAULT_FONT "Sans 15"
 #define DEFAULT_SILENT FALSE
 #define DEFAULT_LAST_MESSAGE NULL
+#define DEFAULT_MEASURE_LATENCY FALSE
 
 /* generic templates */
 static GstStaticPadTemplate fps_display_sink_template =
@@ -87,7 +88,8 @@ enum
   PROP_FRAMES_DROPPED,
   PROP_FRAMES_RENDERED,
   PROP_SILENT,
-  PROP_LAST_MESSAGE
+  PROP_LAST_MESSAGE,
+  PROP_MEASURE_LATENCY
       /* FILL ME */
 };
 
@@ -189,6 +191,27 @@ fps_display_sink_class_init (GstFPSDisplaySinkClass * klass)
   g_object_class_install_property (gobject_klass, PROP_LAST_MESSAGE,
       pspec_last_message);
 
+  /**
+   * GstFPSDisplaySink:measure-latency:
+   *
+   * Measure the latency of each frame, from its running time to the clock
+   * time at which it is rendered. For live sources that timestamp the frames
+   * when capturing them, this is the end-to-end latency of the pipeline.
+   *
+   * With every fps measurement, an element message named
+   * "fpsdisplaysink-latency" is posted with the number of frames measured
+   * during the interval, and the median (p50), 99th percentile (p99) and
+   * maximum latency as well as the jitter of the latency, all as
+   * #GstClockTime.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_klass, PROP_MEASURE_LATENCY,
+      g_param_spec_boolean ("measure-latency", "Measure latency",
+          "Post the latency statistics of the rendered frames as messages",
+          DEFAULT_MEASURE_LATENCY,
+          G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
+
   /**
    * GstFPSDisplaySink::fps-measurements:
    * @fpsdisplaysink: a #GstFPSDisplaySink
@@ -214,6 +237,94 @@ fps_display_sink_class_init (GstFPSDisplaySinkClass * klass)
       "Zeeshan Ali <zeeshan.ali@nokia.com>, Stefan Kost <stefan.kost@nokia.com>");
 }
 
+/* records the time between the running time of @buffer and when it is
+ * going to be rendered */
+static void
+fps_display_sink_measure_latency (GstFPSDisplaySink * self, GstBuffer * buffer)
+{
+  GstClock *clock;
+  GstClockTime base_time, now, running_time, render_time, latency;
+
+  if (self->segment.format != GST_FORMAT_TIME ||
+      !GST_BUFFER_PTS_IS_VALID (buffer))
+    return;
+
+  running_time = gst_segment_to_running_time (&self->segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buffer));
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return;
+
+  clock = gst_element_get_clock (GST_ELEMENT (self));
+  if (!clock)
+    return;
+  base_time = gst_element_get_base_time (GST_ELEMENT (self));
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+  if (now < base_time)
+    return;
+  now -= base_time;
+
+  /* a synchronized sink waits until the running time plus the latency of the
+   * pipeline before rendering */
+  render_time = now;
+  if (self->sync && running_time + self->latency > now)
+    render_time = running_time + self->latency;
+  latency = render_time > running_time ? render_time - running_time : 0;
+
+  if (GST_CLOCK_TIME_IS_VALID (self->last_latency)) {
+    GstClockTime diff = latency > self->last_latency ?
+        latency - self->last_latency : self->last_latency - latency;
+
+    /* smoothed like the interarrival jitter of RFC 3550 */
+    self->jitter = diff > self->jitter ?
+        self->jitter + (diff - self->jitter) / 16 :
+        self->jitter - (self->jitter - diff) / 16;
+  }
+  self->last_latency = latency;
+
+  g_array_append_val (self->latencies, latency);
+}
+
+static gint
+compare_latencies (gconstpointer a, gconstpointer b)
+{
+  GstClockTime la = *(const GstClockTime *) a;
+  GstClockTime lb = *(const GstClockTime *) b;
+
+  return la < lb ? -1 : (la > lb ? 1 : 0);
+}
+
+static void
+fps_display_sink_post_latency (GstFPSDisplaySink * self)
+{
+  GstClockTime *l;
+  guint n;
+
+  n = self->latencies->len;
+  if (n == 0)
+    return;
+
+  g_array_sort (self->latencies, compare_latencies);
+  l = (GstClockTime *) self->latencies->data;
+
+  GST_DEBUG_OBJECT (self, "%u frames, latency p50 %" GST_TIME_FORMAT
+      " p99 %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT " jitter %"
+      GST_TIME_FORMAT, n, GST_TIME_ARGS (l[(n - 1) / 2]),
+      GST_TIME_ARGS (l[(n - 1) * 99 / 100]), GST_TIME_ARGS (l[n - 1]),
+      GST_TIME_ARGS (self->jitter));
+
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self),
+          gst_structure_new ("fpsdisplaysink-latency",
+              "frames", G_TYPE_UINT, n,
+              "p50", G_TYPE_UINT64, l[(n - 1) / 2],
+              "p99", G_TYPE_UINT64, l[(n - 1) * 99 / 100],
+              "max", G_TYPE_UINT64, l[n - 1],
+              "jitter", G_TYPE_UINT64, self->jitter, NULL)));
+
+  g_array_set_size (self->latencies, 0);
+}
+
 static GstPadProbeReturn
 on_video_sink_data_flow (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data)
@@ -221,9 +332,30 @@ on_video_sink_data_flow (GstPad * pad, GstPadProbeInfo * info,
   GstMiniObject *mini_obj = GST_PAD_PROBE_INFO_DATA (info);
   GstFPSDisplaySink *self = GST_FPS_DISPLAY_SINK (user_data);
 
-  if (GST_IS_BUFFER (mini_obj)) {
+  if (GST_IS_EVENT (mini_obj)) {
+    GstEvent *event = GST_EVENT_CAST (mini_obj);
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_SEGMENT:
+        gst_event_copy_segment (event, &self->segment);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        gst_segment_init (&self->segment, GST_FORMAT_UNDEFINED);
+        self->last_latency = GST_CLOCK_TIME_NONE;
+        break;
+      case GST_EVENT_LATENCY:
+        /* sent upstream by the sink when the pipeline latency is known */
+        gst_event_parse_latency (event, &self->latency);
+        break;
+      default:
+        break;
+    }
+  } else if (GST_IS_BUFFER (mini_obj)) {
     GstClockTime ts;
 
+    if (self->measure_latency)
+      fps_display_sink_measure_latency (self, GST_BUFFER_CAST (mini_obj));
+
     /* assume the frame is going to be rendered. If it isnt', we'll get a qos
      * message and reset ->frames_rendered from there.
      */
@@ -336,6 +468,8 @@ fps_display_sink_init (GstFPSDisplaySink * self,
   self->min_fps = -1;
   self->silent = DEFAULT_SILENT;
   self->last_message = g_strdup (DEFAULT_LAST_MESSAGE);
+  self->measure_latency = DEFAULT_MEASURE_LATENCY;
+  self->latencies = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
 
   self->ghost_pad = gst_ghost_pad_new_no_target ("sink", GST_PAD_SINK);
   gst_element_add_pad (GST_ELEMENT (self), self->ghost_pad);
@@ -414,6 +548,9 @@ display_current_fps (gpointer data)
     g_object_notify_by_pspec ((GObject *) self, pspec_last_message);
   }
 
+  if (self->measure_latency)
+    fps_display_sink_post_latency (self);
+
   self->last_frames_rendered = frames_rendered;
   self->last_frames_dropped = frames_dropped;
   self->last_ts = current_ts;
@@ -437,6 +574,12 @@ fps_display_sink_start (GstFPSDisplaySink * self)
   /* init time stamps */
   self->last_ts = self->start_ts = self->interval_ts = GST_CLOCK_TIME_NONE;
 
+  gst_segment_init (&self->segment, GST_FORMAT_UNDEFINED);
+  self->latency = 0;
+  self->last_latency = GST_CLOCK_TIME_NONE;
+  self->jitter = 0;
+  g_array_set_size (self->latencies, 0);
+
   GST_DEBUG_OBJECT (self, "Use text-overlay? %d", self->use_text_overlay);
 
   if (self->use_text_overlay) {
@@ -517,6 +660,11 @@ fps_display_sink_dispose (GObject * object)
     self->text_overlay = NULL;
   }
 
+  if (self->latencies) {
+    g_array_free (self->latencies, TRUE);
+    self->latencies = NULL;
+  }
+
   GST_OBJECT_LOCK (self);
   g_free (self->last_message);
   self->last_message = NULL;
@@ -570,6 +718,9 @@ fps_display_sink_set_property (GObject * object, guint prop_id,
     case PROP_SILENT:
       self->silent = g_value_get_boolean (value);
       break;
+    case PROP_MEASURE_LATENCY:
+      self->measure_latency = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -618,6 +769,9 @@ fps_display_sink_get_property (GObject * object, guint prop_id,
       g_value_set_string (value, self->last_message);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_MEASURE_LATENCY:
+      g_value_set_boolean (value, self->measure_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
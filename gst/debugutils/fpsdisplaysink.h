@@ -59,6 +59,13 @@ struct _GstFPSDisplaySink
   GstClockTime interval_ts;
   guint data_probe_id;
 
+  /* latency measurements, only accessed from the streaming thread */
+  GstSegment segment;
+  GstClockTime latency;
+  GArray *latencies;
+  GstClockTime last_latency;
+  GstClockTime jitter;
+
   /* properties */
   gboolean sync;
   gboolean use_text_overlay;
@@ -68,6 +75,7 @@ struct _GstFPSDisplaySink
   gdouble min_fps;
   gboolean silent;
   gchar *last_message;
+  gboolean measure_latency;
 };
 
 struct _GstFPSDisplaySinkClass
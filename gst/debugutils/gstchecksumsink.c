@@ -23,8 +23,15 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
+#include <gst/video/video.h>
 #include "gstchecksumsink.h"
 
+/* not a GChecksumType, computed by the element itself */
+#define GST_CHECKSUM_SINK_HASH_CRC32C 0x100
+
+#define DEFAULT_HASH G_CHECKSUM_SHA1
+#define DEFAULT_SKIP_PADDING FALSE
+
 static void gst_checksum_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_checksum_sink_get_property (GObject * object, guint prop_id,
@@ -34,6 +41,8 @@ static void gst_checksum_sink_finalize (GObject * object);
 
 static gboolean gst_checksum_sink_start (GstBaseSink * sink);
 static gboolean gst_checksum_sink_stop (GstBaseSink * sink);
+static gboolean gst_checksum_sink_set_caps (GstBaseSink * sink,
+    GstCaps * caps);
 static GstFlowReturn
 gst_checksum_sink_render (GstBaseSink * sink, GstBuffer * buffer);
 
@@ -41,6 +50,7 @@ enum
 {
   PROP_0,
   PROP_HASH,
+  PROP_SKIP_PADDING,
 };
 
 static GstStaticPadTemplate gst_checksum_sink_sink_template =
@@ -69,6 +79,7 @@ gst_checksum_sink_hash_get_type (void)
       {G_CHECKSUM_SHA1, "SHA-1", "sha1"},
       {G_CHECKSUM_SHA256, "SHA-256", "sha256"},
       {G_CHECKSUM_SHA512, "SHA-512", "sha512"},
+      {GST_CHECKSUM_SINK_HASH_CRC32C, "CRC-32C", "crc32c"},
       {0, NULL, NULL},
     };
 
@@ -77,6 +88,51 @@ gst_checksum_sink_hash_get_type (void)
   return gtype;
 }
 
+/* CRC-32C (Castagnoli), processing 8 bytes per step with the
+ * slicing-by-8 tables */
+static guint32 crc32c_table[8][256];
+
+static void
+crc32c_init_table (void)
+{
+  guint32 c;
+  gint n, k;
+
+  for (n = 0; n < 256; n++) {
+    c = n;
+    for (k = 0; k < 8; k++)
+      c = (c & 1) ? (c >> 1) ^ 0x82f63b78 : c >> 1;
+    crc32c_table[0][n] = c;
+  }
+  for (n = 0; n < 256; n++) {
+    c = crc32c_table[0][n];
+    for (k = 1; k < 8; k++) {
+      c = crc32c_table[0][c & 0xff] ^ (c >> 8);
+      crc32c_table[k][n] = c;
+    }
+  }
+}
+
+static guint32
+crc32c_update (guint32 crc, const guint8 * data, gsize size)
+{
+  while (size >= 8) {
+    guint32 lo = GST_READ_UINT32_LE (data) ^ crc;
+    guint32 hi = GST_READ_UINT32_LE (data + 4);
+
+    crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+        crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+        crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+        crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size--)
+    crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+  return crc;
+}
+
 #define gst_checksum_sink_parent_class parent_class
 G_DEFINE_TYPE (GstChecksumSink, gst_checksum_sink, GST_TYPE_BASE_SINK);
 
@@ -93,6 +149,7 @@ gst_checksum_sink_class_init (GstChecksumSinkClass * klass)
   gobject_class->finalize = gst_checksum_sink_finalize;
   base_sink_class->start = GST_DEBUG_FUNCPTR (gst_checksum_sink_start);
   base_sink_class->stop = GST_DEBUG_FUNCPTR (gst_checksum_sink_stop);
+  base_sink_class->set_caps = GST_DEBUG_FUNCPTR (gst_checksum_sink_set_caps);
   base_sink_class->render = GST_DEBUG_FUNCPTR (gst_checksum_sink_render);
 
   gst_element_class_add_static_pad_template (element_class,
@@ -102,9 +159,25 @@ gst_checksum_sink_class_init (GstChecksumSinkClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_HASH,
       g_param_spec_enum ("hash", "Hash", "Checksum type",
-          gst_checksum_sink_hash_get_type (), G_CHECKSUM_SHA1,
+          gst_checksum_sink_hash_get_type (), DEFAULT_HASH,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstChecksumSink:skip-padding:
+   *
+   * For raw video, only checksum the visible pixels of each line of each
+   * plane, so that the result does not depend on the strides and the
+   * padding bytes between the planes.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_SKIP_PADDING,
+      g_param_spec_boolean ("skip-padding", "Skip padding",
+          "Only checksum the visible pixels of raw video frames",
+          DEFAULT_SKIP_PADDING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  crc32c_init_table ();
+
   gst_element_class_set_static_metadata (element_class, "Checksum sink",
       "Debug/Sink", "Calculates a checksum for buffers",
       "David Schleef <ds@schleef.org>");
@@ -114,7 +187,8 @@ static void
 gst_checksum_sink_init (GstChecksumSink * checksumsink)
 {
   gst_base_sink_set_sync (GST_BASE_SINK (checksumsink), FALSE);
-  checksumsink->hash = G_CHECKSUM_SHA1;
+  checksumsink->hash = DEFAULT_HASH;
+  checksumsink->skip_padding = DEFAULT_SKIP_PADDING;
 }
 
 static void
@@ -127,6 +201,9 @@ gst_checksum_sink_set_property (GObject * object, guint prop_id,
     case PROP_HASH:
       checksumsink->hash = g_value_get_enum (value);
       break;
+    case PROP_SKIP_PADDING:
+      checksumsink->skip_padding = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -143,6 +220,9 @@ gst_checksum_sink_get_property (GObject * object, guint prop_id,
     case PROP_HASH:
       g_value_set_enum (value, checksumsink->hash);
       break;
+    case PROP_SKIP_PADDING:
+      g_value_set_boolean (value, checksumsink->skip_padding);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -170,6 +250,119 @@ gst_checksum_sink_start (GstBaseSink * sink)
 static gboolean
 gst_checksum_sink_stop (GstBaseSink * sink)
 {
+  GST_CHECKSUM_SINK (sink)->is_video = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_checksum_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
+{
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (sink);
+  GstCapsFeatures *features;
+
+  checksumsink->is_video = FALSE;
+
+  features = gst_caps_get_features (caps, 0);
+  if (gst_structure_has_name (gst_caps_get_structure (caps, 0), "video/x-raw")
+      && (!features || gst_caps_features_is_equal (features,
+              GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY))
+      && gst_video_info_from_caps (&checksumsink->info, caps)) {
+    const GstVideoFormatInfo *finfo = checksumsink->info.finfo;
+
+    /* the lines of these can't be split from the padding */
+    checksumsink->is_video = !GST_VIDEO_FORMAT_INFO_IS_COMPLEX (finfo) &&
+        !GST_VIDEO_FORMAT_INFO_IS_TILED (finfo) &&
+        GST_VIDEO_FORMAT_INFO_FORMAT (finfo) != GST_VIDEO_FORMAT_ENCODED;
+  }
+
+  return TRUE;
+}
+
+typedef struct
+{
+  gint hash;
+  GChecksum *checksum;
+  guint32 crc;
+} GstChecksumSinkState;
+
+static void
+gst_checksum_sink_state_init (GstChecksumSinkState * state, gint hash)
+{
+  state->hash = hash;
+  if (hash == GST_CHECKSUM_SINK_HASH_CRC32C) {
+    state->checksum = NULL;
+    state->crc = 0xffffffff;
+  } else {
+    state->checksum = g_checksum_new (hash);
+  }
+}
+
+static void
+gst_checksum_sink_state_update (GstChecksumSinkState * state,
+    const guint8 * data, gsize size)
+{
+  if (state->checksum)
+    g_checksum_update (state->checksum, data, size);
+  else
+    state->crc = crc32c_update (state->crc, data, size);
+}
+
+static gchar *
+gst_checksum_sink_state_finish (GstChecksumSinkState * state)
+{
+  gchar *s;
+
+  if (state->checksum) {
+    s = g_strdup (g_checksum_get_string (state->checksum));
+    g_checksum_free (state->checksum);
+  } else {
+    s = g_strdup_printf ("%08x", state->crc ^ 0xffffffff);
+  }
+
+  return s;
+}
+
+/* updates @state with the visible part of each line of each plane */
+static gboolean
+gst_checksum_sink_update_video (GstChecksumSink * checksumsink,
+    GstChecksumSinkState * state, GstBuffer * buffer)
+{
+  GstVideoFrame frame;
+  const GstVideoFormatInfo *finfo = checksumsink->info.finfo;
+  gint plane, comp, line;
+
+  if (!gst_video_frame_map (&frame, &checksumsink->info, buffer, GST_MAP_READ))
+    return FALSE;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (&frame); plane++) {
+    const guint8 *data;
+    gint stride, width, height;
+
+    /* find the first component stored in the plane */
+    for (comp = 0; comp < GST_VIDEO_FRAME_N_COMPONENTS (&frame); comp++)
+      if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, comp) == plane)
+        break;
+
+    data = GST_VIDEO_FRAME_PLANE_DATA (&frame, plane);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, plane);
+    if (comp < GST_VIDEO_FRAME_N_COMPONENTS (&frame)) {
+      width = GST_VIDEO_FRAME_COMP_WIDTH (&frame, comp) *
+          GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, comp);
+      height = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, comp);
+    } else {
+      /* the palette of the paletted formats */
+      width = stride = 256 * 4;
+      height = 1;
+    }
+
+    for (line = 0; line < height; line++)
+      gst_checksum_sink_state_update (state, data + line * stride,
+          MIN (width, ABS (stride)));
+  }
+
+  gst_video_frame_unmap (&frame);
+
   return TRUE;
 }
 
@@ -179,11 +372,18 @@ gst_checksum_sink_render (GstBaseSink * sink, GstBuffer * buffer)
   gchar *s;
   GstMapInfo map;
   GstChecksumSink *checksumsink;
+  GstChecksumSinkState state;
 
   checksumsink = GST_CHECKSUM_SINK (sink);
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  s = g_compute_checksum_for_data (checksumsink->hash, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
+  gst_checksum_sink_state_init (&state, checksumsink->hash);
+
+  if (!checksumsink->skip_padding || !checksumsink->is_video ||
+      !gst_checksum_sink_update_video (checksumsink, &state, buffer)) {
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    gst_checksum_sink_state_update (&state, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+  }
+  s = gst_checksum_sink_state_finish (&state);
   g_print ("%" GST_TIME_FORMAT " %s\n",
       GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)), s);
 
@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
+#include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
@@ -37,7 +38,12 @@ typedef struct _GstChecksumSinkClass GstChecksumSinkClass;
 struct _GstChecksumSink
 {
   GstBaseSink base_checksumsink;
-  GChecksumType hash;
+  gint hash;
+  gboolean skip_padding;
+
+  /* set when the caps are raw video in system memory */
+  gboolean is_video;
+  GstVideoInfo info;
 };
 
 struct _GstChecksumSinkClass
@@ -24,6 +24,7 @@
 #include "config.h"
 #endif
 #include <string.h>
+#include <math.h>
 
 #include <gst/gst.h>
 #include <gst/base/gstcollectpads.h>
@@ -55,7 +56,8 @@ enum GstCompareMethod
 {
   GST_COMPARE_METHOD_MEM,
   GST_COMPARE_METHOD_MAX,
-  GST_COMPARE_METHOD_SSIM
+  GST_COMPARE_METHOD_SSIM,
+  GST_COMPARE_METHOD_PSNR
 };
 
 #define GST_COMPARE_METHOD_TYPE (gst_compare_method_get_type())
@@ -68,6 +70,7 @@ gst_compare_method_get_type (void)
     {GST_COMPARE_METHOD_MEM, "Memory", "mem"},
     {GST_COMPARE_METHOD_MAX, "Maximum metric", "max"},
     {GST_COMPARE_METHOD_SSIM, "SSIM (raw video)", "ssim"},
+    {GST_COMPARE_METHOD_PSNR, "PSNR in dB (raw video)", "psnr"},
     {0, NULL, NULL}
   };
 
@@ -124,6 +127,7 @@ gst_compare_finalize (GObject * object)
   GstCompare *comp = GST_COMPARE (object);
 
   gst_object_unref (comp->cpads);
+  g_free (comp->blocks);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -296,6 +300,14 @@ gst_compare_meta (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   }
 }
 
+/* delta reported for buffers that can not be compared, on the failing side
+ * of the threshold whether it is an upper or a lower bound */
+static gdouble
+gst_compare_mismatch (GstCompare * comp)
+{
+  return comp->upper ? comp->threshold + 1 : comp->threshold - 1;
+}
+
 /* when comparing contents, it is already ensured sizes are equal */
 
 static gint
@@ -346,12 +358,52 @@ gst_compare_max (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   return delta;
 }
 
-static double
-gst_compare_ssim_window (GstCompare * comp, guint8 * data1, guint8 * data2,
-    gint width, gint height, gint step, gint stride)
+/* the SSIM windows are 16x16 and overlap by half, so the sums are first
+ * accumulated once per 8x8 block and each window adds up 2x2 blocks */
+#define SSIM_WINDOW 16
+#define SSIM_BLOCK (SSIM_WINDOW / 2)
+
+typedef struct
+{
+  gint sum1, sum2, ssum1, ssum2, acov, count;
+} GstCompareBlock;
+
+static void
+gst_compare_ssim_block (GstCompareBlock * block, guint8 * data1,
+    guint8 * data2, gint width, gint height, gint step, gint stride)
 {
-  gint count = 0, i, j;
   gint sum1 = 0, sum2 = 0, ssum1 = 0, ssum2 = 0, acov = 0;
+  gint i, j;
+
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      gint p1 = data1[j * step];
+      gint p2 = data2[j * step];
+
+      sum1 += p1;
+      sum2 += p2;
+      ssum1 += p1 * p1;
+      ssum2 += p2 * p2;
+      acov += p1 * p2;
+    }
+    data1 += stride;
+    data2 += stride;
+  }
+
+  block->sum1 = sum1;
+  block->sum2 = sum2;
+  block->ssum1 = ssum1;
+  block->ssum2 = ssum2;
+  block->acov = acov;
+  block->count = width * height;
+}
+
+static double
+gst_compare_ssim_window (GstCompare * comp, const GstCompareBlock * b,
+    gint n_blocks, gint blocks_stride)
+{
+  gint sum1 = 0, sum2 = 0, ssum1 = 0, ssum2 = 0, acov = 0, count = 0;
+  gint i, j;
   gdouble avg1, avg2, var1, var2, cov;
 
   const gdouble k1 = 0.01;
@@ -360,28 +412,23 @@ gst_compare_ssim_window (GstCompare * comp, guint8 * data1, guint8 * data2,
   const gdouble c1 = (k1 * L) * (k1 * L);
   const gdouble c2 = (k2 * L) * (k2 * L);
 
-  /* For empty images, return maximum similarity */
-  if (height <= 0 || width <= 0)
-    return 1.0;
+  for (i = 0; i < n_blocks; i++) {
+    for (j = 0; j < n_blocks; j++) {
+      const GstCompareBlock *block = &b[i * blocks_stride + j];
 
-  /* plain and simple; no fancy optimizations */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      sum1 += *data1;
-      sum2 += *data2;
-      ssum1 += *data1 * *data1;
-      ssum2 += *data2 * *data2;
-      acov += *data1 * *data2;
-      count++;
-      data1 += step;
-      data2 += step;
+      sum1 += block->sum1;
+      sum2 += block->sum2;
+      ssum1 += block->ssum1;
+      ssum2 += block->ssum2;
+      acov += block->acov;
+      count += block->count;
     }
-    data1 -= j * step;
-    data2 -= j * step;
-    data1 += stride;
-    data2 += stride;
   }
 
+  /* For empty images, return maximum similarity */
+  if (count == 0)
+    return 1.0;
+
   avg1 = sum1 / count;
   avg2 = sum2 / count;
   var1 = ssum1 / count - avg1 * avg1;
@@ -397,19 +444,45 @@ static gdouble
 gst_compare_ssim_component (GstCompare * comp, guint8 * data1, guint8 * data2,
     gint width, gint height, gint step, gint stride)
 {
-  const gint window = 16;
   gdouble ssim_sum = 0;
-  gint count = 0, i, j;
+  gint count = 0, i, j, bw, bh;
+  gsize size;
+  GstCompareBlock *blocks;
+
+  if (width <= 0 || height <= 0)
+    return 1.0;
+
+  bw = (width + SSIM_BLOCK - 1) / SSIM_BLOCK;
+  bh = (height + SSIM_BLOCK - 1) / SSIM_BLOCK;
+  size = (gsize) bw *bh * sizeof (GstCompareBlock);
+  if (comp->blocks_size < size) {
+    g_free (comp->blocks);
+    comp->blocks = g_malloc (size);
+    comp->blocks_size = size;
+  }
+  blocks = comp->blocks;
+
+  for (j = 0; j < bh; j++) {
+    for (i = 0; i < bw; i++) {
+      gint x = i * SSIM_BLOCK, y = j * SSIM_BLOCK;
+
+      gst_compare_ssim_block (&blocks[j * bw + i],
+          data1 + step * x + y * stride, data2 + step * x + y * stride,
+          MIN (SSIM_BLOCK, width - x), MIN (SSIM_BLOCK, height - y), step,
+          stride);
+    }
+  }
 
-  for (j = 0; j + (window / 2) < height; j += (window / 2)) {
-    for (i = 0; i + (window / 2) < width; i += (window / 2)) {
+  /* a window starting at (i, j) is clipped to the image, but always covers
+   * at least part of the next block in each direction */
+  for (j = 0; j + SSIM_BLOCK < height; j += SSIM_BLOCK) {
+    for (i = 0; i + SSIM_BLOCK < width; i += SSIM_BLOCK) {
       gdouble ssim;
 
-      ssim = gst_compare_ssim_window (comp, data1 + step * i + j * stride,
-          data2 + step * i + j * stride,
-          MIN (window, width - i), MIN (window, height - j), step, stride);
-      GST_LOG_OBJECT (comp, "ssim for %dx%d at (%d, %d) = %f", window, window,
-          i, j, ssim);
+      ssim = gst_compare_ssim_window (comp,
+          &blocks[(j / SSIM_BLOCK) * bw + i / SSIM_BLOCK], 2, bw);
+      GST_LOG_OBJECT (comp, "ssim for %dx%d at (%d, %d) = %f", SSIM_WINDOW,
+          SSIM_WINDOW, i, j, ssim);
       ssim_sum += ssim;
       count++;
     }
@@ -422,6 +495,29 @@ gst_compare_ssim_component (GstCompare * comp, guint8 * data1, guint8 * data2,
   return (ssim_sum / count);
 }
 
+/* sets the weights of the components in @c, giving more weight to the luma
+ * of YUV formats */
+static gint
+gst_compare_get_weights (GstVideoInfo * info, gdouble c[4])
+{
+  gint i, comps;
+
+  comps = GST_VIDEO_INFO_N_COMPONENTS (info);
+  c[0] = 1.0;
+  c[1] = c[2] = c[3] = 0.0;
+  /* note that some are reported both yuv and gray */
+  for (i = 0; i < comps; ++i)
+    c[i] = 1.0;
+  /* increase luma weight if yuv */
+  if (GST_VIDEO_INFO_IS_YUV (info) && (comps > 1))
+    c[0] = comps - 1;
+  for (i = 0; i < comps; ++i)
+    c[i] /= (GST_VIDEO_INFO_IS_YUV (info) && (comps > 1)) ?
+        2 * (comps - 1) : comps;
+
+  return comps;
+}
+
 static gdouble
 gst_compare_ssim (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
     GstBuffer * buf2, GstCaps * caps2)
@@ -429,7 +525,7 @@ gst_compare_ssim (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   GstVideoInfo info1, info2;
   GstVideoFrame frame1, frame2;
   gint i, comps;
-  gdouble cssim[4], ssim, c[4] = { 1.0, 0.0, 0.0, 0.0 };
+  gdouble cssim[4], ssim, c[4];
 
   if (!caps1)
     goto invalid_input;
@@ -440,24 +536,15 @@ gst_compare_ssim (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   if (!caps2)
     goto invalid_input;
 
-  if (!gst_video_info_from_caps (&info2, caps1))
+  if (!gst_video_info_from_caps (&info2, caps2))
     goto invalid_input;
 
   if (GST_VIDEO_INFO_FORMAT (&info1) != GST_VIDEO_INFO_FORMAT (&info2) ||
       GST_VIDEO_INFO_WIDTH (&info1) != GST_VIDEO_INFO_WIDTH (&info2) ||
       GST_VIDEO_INFO_HEIGHT (&info1) != GST_VIDEO_INFO_HEIGHT (&info2))
-    return comp->threshold + 1;
+    goto mismatch;
 
-  comps = GST_VIDEO_INFO_N_COMPONENTS (&info1);
-  /* note that some are reported both yuv and gray */
-  for (i = 0; i < comps; ++i)
-    c[i] = 1.0;
-  /* increase luma weight if yuv */
-  if (GST_VIDEO_INFO_IS_YUV (&info1) && (comps > 1))
-    c[0] = comps - 1;
-  for (i = 0; i < comps; ++i)
-    c[i] /= (GST_VIDEO_INFO_IS_YUV (&info1) && (comps > 1)) ?
-        2 * (comps - 1) : comps;
+  comps = gst_compare_get_weights (&info1, c);
 
   gst_video_frame_map (&frame1, &info1, buf1, GST_MAP_READ);
   gst_video_frame_map (&frame2, &info2, buf2, GST_MAP_READ);
@@ -494,6 +581,12 @@ gst_compare_ssim (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   return ssim;
 
   /* ERRORS */
+mismatch:
+  {
+    GST_WARNING_OBJECT (comp, "video formats differ: %" GST_PTR_FORMAT
+        " and %" GST_PTR_FORMAT, caps1, caps2);
+    return gst_compare_mismatch (comp);
+  }
 invalid_input:
   {
     GST_ERROR_OBJECT (comp, "ssim method needs raw video input");
@@ -507,6 +600,105 @@ unsupported_input:
   }
 }
 
+/* sum of the squared differences of one component */
+static guint64
+gst_compare_sse_component (guint8 * data1, guint8 * data2, gint width,
+    gint height, gint step, gint stride)
+{
+  guint64 sse = 0;
+  gint i, j;
+
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      gint d = data1[j * step] - data2[j * step];
+
+      sse += d * d;
+    }
+    data1 += stride;
+    data2 += stride;
+  }
+
+  return sse;
+}
+
+static gdouble
+gst_compare_psnr (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
+    GstBuffer * buf2, GstCaps * caps2)
+{
+  GstVideoInfo info1, info2;
+  GstVideoFrame frame1, frame2;
+  gint i, comps;
+  gdouble mse = 0, c[4];
+
+  if (!caps1 || !gst_video_info_from_caps (&info1, caps1))
+    goto invalid_input;
+
+  if (!caps2 || !gst_video_info_from_caps (&info2, caps2))
+    goto invalid_input;
+
+  if (GST_VIDEO_INFO_FORMAT (&info1) != GST_VIDEO_INFO_FORMAT (&info2) ||
+      GST_VIDEO_INFO_WIDTH (&info1) != GST_VIDEO_INFO_WIDTH (&info2) ||
+      GST_VIDEO_INFO_HEIGHT (&info1) != GST_VIDEO_INFO_HEIGHT (&info2))
+    goto mismatch;
+
+  comps = gst_compare_get_weights (&info1, c);
+  for (i = 0; i < comps; i++) {
+    /* only support most common formats */
+    if (GST_VIDEO_INFO_COMP_DEPTH (&info1, i) != 8)
+      goto unsupported_input;
+  }
+
+  gst_video_frame_map (&frame1, &info1, buf1, GST_MAP_READ);
+  gst_video_frame_map (&frame2, &info2, buf2, GST_MAP_READ);
+
+  for (i = 0; i < comps; i++) {
+    gint cw, ch;
+    guint64 sse;
+
+    cw = GST_VIDEO_FRAME_COMP_WIDTH (&frame1, i);
+    ch = GST_VIDEO_FRAME_COMP_HEIGHT (&frame1, i);
+    if (cw <= 0 || ch <= 0)
+      continue;
+
+    sse = gst_compare_sse_component (GST_VIDEO_FRAME_COMP_DATA (&frame1, i),
+        GST_VIDEO_FRAME_COMP_DATA (&frame2, i), cw, ch,
+        GST_VIDEO_FRAME_COMP_PSTRIDE (&frame1, i),
+        GST_VIDEO_FRAME_COMP_STRIDE (&frame1, i));
+    GST_LOG_OBJECT (comp, "sse[%d] = %" G_GUINT64_FORMAT, i, sse);
+    mse += c[i] * sse / ((gdouble) cw * ch);
+  }
+
+  gst_video_frame_unmap (&frame1);
+  gst_video_frame_unmap (&frame2);
+
+  GST_DEBUG_OBJECT (comp, "mse = %f", mse);
+
+  /* identical frames */
+  if (mse == 0)
+    return G_MAXDOUBLE;
+
+  return 10.0 * log10 (255.0 * 255.0 / mse);
+
+  /* ERRORS */
+mismatch:
+  {
+    GST_WARNING_OBJECT (comp, "video formats differ: %" GST_PTR_FORMAT
+        " and %" GST_PTR_FORMAT, caps1, caps2);
+    return gst_compare_mismatch (comp);
+  }
+invalid_input:
+  {
+    GST_ERROR_OBJECT (comp, "psnr method needs raw video input");
+    return 0;
+  }
+unsupported_input:
+  {
+    GST_ERROR_OBJECT (comp, "raw video format not supported %" GST_PTR_FORMAT,
+        caps1);
+    return 0;
+  }
+}
+
 static void
 gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
     GstBuffer * buf2, GstCaps * caps2)
@@ -518,12 +710,14 @@ gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   gst_compare_meta (comp, buf1, caps1, buf2, caps2);
 
   size1 = gst_buffer_get_size (buf1);
-  size2 = gst_buffer_get_size (buf1);
+  size2 = gst_buffer_get_size (buf2);
 
   /* check content according to method */
   /* but at least size should match */
   if (size1 != size2) {
-    delta = comp->threshold + 1;
+    GST_WARNING_OBJECT (comp, "buffer sizes differ: %" G_GSIZE_FORMAT
+        " and %" G_GSIZE_FORMAT, size1, size2);
+    delta = gst_compare_mismatch (comp);
   } else {
     GstMapInfo map1, map2;
 
@@ -543,6 +737,9 @@ gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
       case GST_COMPARE_METHOD_SSIM:
         delta = gst_compare_ssim (comp, buf1, caps1, buf2, caps2);
         break;
+      case GST_COMPARE_METHOD_PSNR:
+        delta = gst_compare_psnr (comp, buf1, caps1, buf2, caps2);
+        break;
       default:
         g_assert_not_reached ();
         break;
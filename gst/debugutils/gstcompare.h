@@ -56,6 +56,10 @@ struct _GstCompare {
 
   gint count;
 
+  /* scratch space for the SSIM block sums */
+  gpointer blocks;
+  gsize blocks_size;
+
   /* properties */
   GstBufferCopyFlags meta;
   gboolean offset_ts;
@@ -993,6 +993,42 @@ gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
   return comp;
 }
 
+/* Pages are usually sent again with the same content well before their
+ * time out, in which case the composition made for the previous page can be
+ * kept, together with the pixels its rectangles cached for blending */
+static gboolean
+gst_dvbsub_overlay_subs_equal (DVBSubtitles * a, DVBSubtitles * b)
+{
+  guint i;
+
+  if (a->num_rects != b->num_rects)
+    return FALSE;
+
+  if (memcmp (&a->display_def, &b->display_def, sizeof (DVBSubtitleWindow)))
+    return FALSE;
+
+  for (i = 0; i < a->num_rects; i++) {
+    DVBSubtitleRect *ra = &a->rects[i];
+    DVBSubtitleRect *rb = &b->rects[i];
+
+    if (ra->x != rb->x || ra->y != rb->y || ra->w != rb->w || ra->h != rb->h)
+      return FALSE;
+
+    if (ra->pict.rowstride != rb->pict.rowstride ||
+        ra->pict.palette_bits_count != rb->pict.palette_bits_count)
+      return FALSE;
+
+    if (memcmp (ra->pict.palette, rb->pict.palette,
+            (1 << ra->pict.palette_bits_count) * sizeof (guint32)))
+      return FALSE;
+
+    if (memcmp (ra->pict.data, rb->pict.data, ra->pict.rowstride * ra->h))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_dvbsub_overlay_chain_video (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
@@ -1095,12 +1131,18 @@ gst_dvbsub_overlay_chain_video (GstPad * pad, GstObject * parent,
           GST_TIME_FORMAT ") - it has %u regions",
           GST_TIME_ARGS (vid_running_time), GST_TIME_ARGS (candidate->pts),
           candidate->num_rects);
+      if (overlay->current_subtitle && overlay->current_comp &&
+          gst_dvbsub_overlay_subs_equal (overlay->current_subtitle,
+              candidate)) {
+        GST_DEBUG_OBJECT (overlay, "page unchanged, keeping its composition");
+      } else {
+        if (overlay->current_comp)
+          gst_video_overlay_composition_unref (overlay->current_comp);
+        overlay->current_comp =
+            gst_dvbsub_overlay_subs_to_comp (overlay, candidate);
+      }
       dvb_subtitles_free (overlay->current_subtitle);
       overlay->current_subtitle = candidate;
-      if (overlay->current_comp)
-        gst_video_overlay_composition_unref (overlay->current_comp);
-      overlay->current_comp =
-          gst_dvbsub_overlay_subs_to_comp (overlay, overlay->current_subtitle);
     }
   }
 
@@ -53,19 +53,29 @@ enum
   LAST_SIGNAL
 };
 
+#define DVDSPU_CAPS "video/x-raw, " \
+    "format = (string) { I420, NV12, YV12 }, " \
+    "width = (int) [ 16, 4096 ], " "height = (int) [ 16, 4096 ]"
+
+/* Any other format or memory can still be used when downstream takes the
+ * SPU as overlay composition meta */
+#define DVDSPU_ALL_CAPS DVDSPU_CAPS ";" \
+    "video/x-raw(ANY), " \
+    "width = (int) [ 16, 4096 ], " "height = (int) [ 16, 4096 ]"
+
+static GstStaticCaps sw_template_caps = GST_STATIC_CAPS (DVDSPU_CAPS);
+
 static GstStaticPadTemplate video_sink_factory =
 GST_STATIC_PAD_TEMPLATE ("video",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("video/x-raw, " "format = (string) { I420, NV12, YV12 }, "
-        "width = (int) [ 16, 4096 ], " "height = (int) [ 16, 4096 ]")
+    GST_STATIC_CAPS (DVDSPU_ALL_CAPS)
     );
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("video/x-raw, " "format = (string) { I420, NV12, YV12 }, "
-        "width = (int) [ 16, 4096 ], " "height = (int) [ 16, 4096 ]")
+    GST_STATIC_CAPS (DVDSPU_ALL_CAPS)
     );
 
 static GstStaticPadTemplate subpic_sink_factory =
@@ -113,6 +123,7 @@ static void gst_dvd_spu_flush_spu_info (GstDVDSpu * dvdspu,
     gboolean process_events);
 static void gst_dvd_spu_advance_spu (GstDVDSpu * dvdspu, GstClockTime new_ts);
 static void gstspu_render (GstDVDSpu * dvdspu, GstBuffer * buf);
+static void gstspu_overlay (GstDVDSpu * dvdspu, GstBuffer * buf);
 static GstFlowReturn
 dvdspu_handle_vid_buffer (GstDVDSpu * dvdspu, GstBuffer * buf);
 static void gst_dvd_spu_handle_dvd_event (GstDVDSpu * dvdspu, GstEvent * event);
@@ -185,6 +196,11 @@ gst_dvd_spu_clear (GstDVDSpu * dvdspu)
   gst_buffer_replace (&dvdspu->ref_frame, NULL);
   gst_buffer_replace (&dvdspu->pending_frame, NULL);
 
+  if (dvdspu->composition) {
+    gst_video_overlay_composition_unref (dvdspu->composition);
+    dvdspu->composition = NULL;
+  }
+
   dvdspu->spu_state.info.fps_n = 25;
   dvdspu->spu_state.info.fps_d = 1;
 
@@ -260,6 +276,7 @@ gst_dvd_spu_flush_spu_info (GstDVDSpu * dvdspu, gboolean keep_events)
 
   state->flags &= ~(SPU_STATE_FLAGS_MASK);
   state->next_ts = GST_CLOCK_TIME_NONE;
+  dvdspu->composition_dirty = TRUE;
 
   switch (dvdspu->spu_input_type) {
     case SPU_INPUT_TYPE_VOBSUB:
@@ -315,6 +332,123 @@ gst_dvd_spu_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return res;
 }
 
+static gboolean
+gst_dvd_spu_can_handle_caps (GstCaps * incaps)
+{
+  GstCaps *caps;
+  gboolean ret;
+
+  caps = gst_static_caps_get (&sw_template_caps);
+  ret = gst_caps_is_subset (incaps, caps);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+/* Decides whether the SPU is blended into the video frames or attached to
+ * them as overlay composition meta, and configures the src pad accordingly.
+ * Attaching is preferred whenever downstream supports the meta in its
+ * allocation query, as the overlay then only needs to be rendered once per
+ * display set instead of being blended into every frame. */
+static gboolean
+gst_dvd_spu_negotiate (GstDVDSpu * dvdspu, GstCaps * caps)
+{
+  gboolean upstream_has_meta = FALSE;
+  gboolean caps_has_meta = FALSE;
+  gboolean alloc_has_meta = FALSE;
+  gboolean attach = FALSE;
+  gboolean ret = TRUE;
+  GstCapsFeatures *f;
+  GstCaps *overlay_caps;
+  GstQuery *query;
+
+  GST_DEBUG_OBJECT (dvdspu, "performing negotiation");
+
+  /* Clear any pending reconfigure flag */
+  gst_pad_check_reconfigure (dvdspu->srcpad);
+
+  if (!caps)
+    caps = gst_pad_get_current_caps (dvdspu->videosinkpad);
+  else
+    gst_caps_ref (caps);
+
+  if (!caps || gst_caps_is_empty (caps)) {
+    if (caps)
+      gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  if ((f = gst_caps_get_features (caps, 0))) {
+    upstream_has_meta = gst_caps_features_contains (f,
+        GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION);
+  }
+
+  if (upstream_has_meta) {
+    overlay_caps = gst_caps_ref (caps);
+  } else {
+    GstCaps *peercaps;
+
+    overlay_caps = gst_caps_copy (caps);
+    f = gst_caps_get_features (overlay_caps, 0);
+    gst_caps_features_add (f,
+        GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION);
+
+    peercaps = gst_pad_peer_query_caps (dvdspu->srcpad, NULL);
+    caps_has_meta = gst_caps_can_intersect (peercaps, overlay_caps);
+    gst_caps_unref (peercaps);
+
+    GST_DEBUG_OBJECT (dvdspu, "caps have overlay meta %d", caps_has_meta);
+  }
+
+  if (upstream_has_meta || caps_has_meta) {
+    /* Caps have to be set for downstream to answer the allocation query */
+    ret = gst_pad_set_caps (dvdspu->srcpad, overlay_caps);
+
+    query = gst_query_new_allocation (overlay_caps, FALSE);
+    if (!gst_pad_peer_query (dvdspu->srcpad, query))
+      GST_DEBUG_OBJECT (dvdspu, "ALLOCATION query failed");
+
+    alloc_has_meta = gst_query_find_allocation_meta (query,
+        GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, NULL);
+    gst_query_unref (query);
+
+    GST_DEBUG_OBJECT (dvdspu, "sink alloc has overlay meta %d",
+        alloc_has_meta);
+  }
+
+  if (upstream_has_meta || (caps_has_meta && alloc_has_meta)) {
+    attach = TRUE;
+  } else if (caps_has_meta) {
+    /* Don't attach unless we cannot handle the format */
+    attach = !gst_dvd_spu_can_handle_caps (caps);
+  } else {
+    ret = gst_dvd_spu_can_handle_caps (caps);
+  }
+
+  if (attach) {
+    GST_DEBUG_OBJECT (dvdspu, "Using caps %" GST_PTR_FORMAT, overlay_caps);
+    /* Caps were already sent */
+  } else if (ret) {
+    GST_DEBUG_OBJECT (dvdspu, "Using caps %" GST_PTR_FORMAT, caps);
+    ret = gst_pad_set_caps (dvdspu->srcpad, caps);
+  }
+
+  DVD_SPU_LOCK (dvdspu);
+  dvdspu->attach_compo_to_buffer = attach;
+  dvdspu->composition_dirty = TRUE;
+  DVD_SPU_UNLOCK (dvdspu);
+
+  gst_caps_unref (overlay_caps);
+  gst_caps_unref (caps);
+
+  if (!ret) {
+    GST_DEBUG_OBJECT (dvdspu, "negotiation failed, schedule reconfigure");
+    gst_pad_mark_reconfigure (dvdspu->srcpad);
+  }
+
+  return ret;
+}
+
 static gboolean
 gst_dvd_spu_video_set_caps (GstDVDSpu * dvdspu, GstPad * pad, GstCaps * caps)
 {
@@ -326,6 +460,21 @@ gst_dvd_spu_video_set_caps (GstDVDSpu * dvdspu, GstPad * pad, GstCaps * caps)
   if (!gst_video_info_from_caps (&info, caps))
     goto done;
 
+  /* When the frames are in a format or memory we cannot blend into, the SPU
+   * is only ever rendered into the scratch frames the overlay composition is
+   * built from, so render those in a format the renderers support */
+  if (!gst_dvd_spu_can_handle_caps (caps)) {
+    GstVideoInfo render_info;
+
+    gst_video_info_set_format (&render_info, GST_VIDEO_FORMAT_I420,
+        info.width, info.height);
+    render_info.fps_n = info.fps_n;
+    render_info.fps_d = info.fps_d;
+    render_info.par_n = info.par_n;
+    render_info.par_d = info.par_d;
+    info = render_info;
+  }
+
   DVD_SPU_LOCK (dvdspu);
 
   state = &dvdspu->spu_state;
@@ -337,34 +486,127 @@ gst_dvd_spu_video_set_caps (GstDVDSpu * dvdspu, GstPad * pad, GstCaps * caps)
   }
   DVD_SPU_UNLOCK (dvdspu);
 
-  res = TRUE;
+  res = gst_dvd_spu_negotiate (dvdspu, caps);
 done:
   return res;
 }
 
+/* Creates a new #GstCaps containing the given caps with the given caps
+ * feature added, followed by the given caps intersected by the filter. */
+static GstCaps *
+gst_dvd_spu_add_feature_and_intersect (GstCaps * caps,
+    const gchar * feature, GstCaps * filter)
+{
+  int i, caps_size;
+  GstCaps *new_caps;
+
+  new_caps = gst_caps_copy (caps);
+
+  caps_size = gst_caps_get_size (new_caps);
+  for (i = 0; i < caps_size; i++) {
+    GstCapsFeatures *features = gst_caps_get_features (new_caps, i);
+    if (!gst_caps_features_is_any (features)) {
+      gst_caps_features_add (features, feature);
+    }
+  }
+
+  gst_caps_append (new_caps, gst_caps_intersect_full (caps,
+          filter, GST_CAPS_INTERSECT_FIRST));
+
+  return new_caps;
+}
+
+/* Creates a new #GstCaps where each caps structure using the given feature
+ * is kept both with and without the feature, and every other structure is
+ * intersected by the filter. */
+static GstCaps *
+gst_dvd_spu_intersect_by_feature (GstCaps * caps,
+    const gchar * feature, GstCaps * filter)
+{
+  int i, caps_size;
+  GstCaps *new_caps;
+
+  new_caps = gst_caps_new_empty ();
+
+  caps_size = gst_caps_get_size (caps);
+  for (i = 0; i < caps_size; i++) {
+    GstStructure *caps_structure = gst_caps_get_structure (caps, i);
+    GstCapsFeatures *caps_features =
+        gst_caps_features_copy (gst_caps_get_features (caps, i));
+    GstCaps *filtered_caps;
+    GstCaps *simple_caps =
+        gst_caps_new_full (gst_structure_copy (caps_structure), NULL);
+    gst_caps_set_features (simple_caps, 0, caps_features);
+
+    if (gst_caps_features_contains (caps_features, feature)) {
+      gst_caps_append (new_caps, gst_caps_copy (simple_caps));
+
+      gst_caps_features_remove (caps_features, feature);
+      filtered_caps = gst_caps_ref (simple_caps);
+    } else {
+      filtered_caps = gst_caps_intersect_full (simple_caps, filter,
+          GST_CAPS_INTERSECT_FIRST);
+    }
+
+    gst_caps_unref (simple_caps);
+    gst_caps_append (new_caps, filtered_caps);
+  }
+
+  return new_caps;
+}
+
 static GstCaps *
 gst_dvd_spu_video_proxy_getcaps (GstPad * pad, GstCaps * filter)
 {
   GstDVDSpu *dvdspu = GST_DVD_SPU (gst_pad_get_parent (pad));
-  GstCaps *caps;
+  GstCaps *caps, *sw_caps, *peer_filter = NULL;
   GstPad *otherpad;
+  gboolean is_src = (pad == dvdspu->srcpad);
 
   /* Proxy the getcaps between videosink and the srcpad, ignoring the 
-   * subpicture sink pad */
-  otherpad = (pad == dvdspu->srcpad) ? dvdspu->videosinkpad : dvdspu->srcpad;
+   * subpicture sink pad. Downstream may take any format carrying the overlay
+   * composition meta, everything else has to be one we can blend into */
+  otherpad = is_src ? dvdspu->videosinkpad : dvdspu->srcpad;
+  sw_caps = gst_static_caps_get (&sw_template_caps);
+
+  if (filter) {
+    if (is_src)
+      peer_filter = gst_dvd_spu_intersect_by_feature (filter,
+          GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION, sw_caps);
+    else
+      peer_filter = gst_dvd_spu_add_feature_and_intersect (filter,
+          GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION, sw_caps);
+  }
+
+  caps = gst_pad_peer_query_caps (otherpad, peer_filter);
+  if (peer_filter)
+    gst_caps_unref (peer_filter);
 
-  caps = gst_pad_peer_query_caps (otherpad, filter);
   if (caps) {
-    GstCaps *temp, *templ;
+    GstCaps *temp;
 
-    templ = gst_pad_get_pad_template_caps (otherpad);
-    temp = gst_caps_intersect (caps, templ);
-    gst_caps_unref (templ);
+    if (gst_caps_is_any (caps))
+      temp = gst_pad_get_pad_template_caps (otherpad);
+    else if (is_src)
+      temp = gst_dvd_spu_add_feature_and_intersect (caps,
+          GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION, sw_caps);
+    else
+      temp = gst_dvd_spu_intersect_by_feature (caps,
+          GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION, sw_caps);
     gst_caps_unref (caps);
     caps = temp;
   } else {
     caps = gst_pad_get_pad_template_caps (pad);
   }
+  gst_caps_unref (sw_caps);
+
+  if (filter) {
+    GstCaps *temp;
+
+    temp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+    caps = temp;
+  }
 
   gst_object_unref (dvdspu);
   return caps;
@@ -404,11 +646,9 @@ gst_dvd_spu_video_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GstCaps *caps;
 
       gst_event_parse_caps (event, &caps);
+      /* The src pad caps are set while negotiating */
       res = gst_dvd_spu_video_set_caps (dvdspu, pad, caps);
-      if (res)
-        res = gst_pad_push_event (dvdspu->srcpad, event);
-      else
-        gst_event_unref (event);
+      gst_event_unref (event);
       break;
     }
     case GST_EVENT_CUSTOM_DOWNSTREAM:
@@ -557,6 +797,16 @@ gst_dvd_spu_video_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   GST_LOG_OBJECT (dvdspu, "video buffer %p with TS %" GST_TIME_FORMAT,
       buf, GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
 
+  if (gst_pad_check_reconfigure (dvdspu->srcpad)) {
+    if (!gst_dvd_spu_negotiate (dvdspu, NULL)) {
+      gst_pad_mark_reconfigure (dvdspu->srcpad);
+      gst_buffer_unref (buf);
+      if (GST_PAD_IS_FLUSHING (dvdspu->srcpad))
+        return GST_FLOW_FLUSHING;
+      return GST_FLOW_NOT_NEGOTIATED;
+    }
+  }
+
   ret = dvdspu_handle_vid_buffer (dvdspu, buf);
 
   return ret;
@@ -617,19 +867,24 @@ dvdspu_handle_vid_buffer (GstDVDSpu * dvdspu, GstBuffer * buf)
       ((dvdspu->spu_state.flags & SPU_STATE_FORCED_ONLY) == 0 &&
           (dvdspu->spu_state.flags & SPU_STATE_DISPLAY))) {
     if (using_ref == FALSE) {
-      GstBuffer *copy;
+      if (dvdspu->attach_compo_to_buffer) {
+        /* The frame contents are left untouched, a reference is enough */
+        gst_buffer_replace (&dvdspu->ref_frame, buf);
+      } else {
+        GstBuffer *copy;
 
-      /* Take a copy in case we hit a still frame and need the pristine 
-       * frame around */
-      copy = gst_buffer_copy (buf);
-      gst_buffer_replace (&dvdspu->ref_frame, copy);
-      gst_buffer_unref (copy);
+        /* Take a copy in case we hit a still frame and need the pristine 
+         * frame around */
+        copy = gst_buffer_copy (buf);
+        gst_buffer_replace (&dvdspu->ref_frame, copy);
+        gst_buffer_unref (copy);
+      }
     }
 
     /* Render the SPU overlay onto the buffer */
     buf = gst_buffer_make_writable (buf);
 
-    gstspu_render (dvdspu, buf);
+    gstspu_overlay (dvdspu, buf);
   } else {
     if (using_ref == FALSE) {
       /* Not going to draw anything on this frame, just store a reference
@@ -681,6 +936,155 @@ gstspu_render (GstDVDSpu * dvdspu, GstBuffer * buf)
   gst_video_frame_unmap (&frame);
 }
 
+/* With SPU LOCK. Returns the alpha value the renderers blended with at a
+ * pixel, from the same SPU rendered onto a black and a white frame */
+static inline guint
+gstspu_composition_alpha (GstVideoFrame * black, GstVideoFrame * white,
+    gint x, gint y)
+{
+  guint8 b = GST_VIDEO_FRAME_COMP_DATA (black, 0)[y *
+      GST_VIDEO_FRAME_COMP_STRIDE (black, 0) + x];
+  guint8 w = GST_VIDEO_FRAME_COMP_DATA (white, 0)[y *
+      GST_VIDEO_FRAME_COMP_STRIDE (white, 0) + x];
+
+  return 0xff - (w - b);
+}
+
+/* With SPU LOCK. Renders the current SPU state into an AYUV overlay
+ * rectangle covering the area the SPU draws to. The renderers blend
+ * premultiplied colours into the frame, so rendering onto a black and onto
+ * a white frame gives both the colour and the alpha of every pixel. Chroma
+ * is blended per 2x2 block, weighted by the alpha of the luma samples in
+ * that block. Returns NULL if nothing is drawn */
+static GstVideoOverlayComposition *
+gstspu_render_composition (GstDVDSpu * dvdspu)
+{
+  GstVideoInfo *info = &dvdspu->spu_state.info;
+  GstVideoOverlayComposition *composition = NULL;
+  GstVideoOverlayRectangle *rectangle;
+  GstBuffer *black, *white, *overlay = NULL;
+  GstVideoFrame bframe, wframe;
+  GstMapInfo map;
+  gint width = GST_VIDEO_INFO_WIDTH (info);
+  gint height = GST_VIDEO_INFO_HEIGHT (info);
+  gint left = width, right = -1, top = height, bottom = -1;
+  gint x, y, w, h;
+  gsize size = GST_VIDEO_INFO_SIZE (info);
+
+  black = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_memset (black, 0, 0x00, size);
+  white = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_memset (white, 0, 0xff, size);
+
+  gstspu_render (dvdspu, black);
+  gstspu_render (dvdspu, white);
+
+  if (!gst_video_frame_map (&bframe, info, black, GST_MAP_READ))
+    goto out;
+  if (!gst_video_frame_map (&wframe, info, white, GST_MAP_READ)) {
+    gst_video_frame_unmap (&bframe);
+    goto out;
+  }
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      if (gstspu_composition_alpha (&bframe, &wframe, x, y) == 0)
+        continue;
+      left = MIN (left, x);
+      right = MAX (right, x);
+      top = MIN (top, y);
+      bottom = MAX (bottom, y);
+    }
+  }
+
+  if (right < 0)
+    goto unmap;
+
+  w = right - left + 1;
+  h = bottom - top + 1;
+
+  overlay = gst_buffer_new_allocate (NULL, w * h * 4, NULL);
+  gst_buffer_add_video_meta (overlay, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, w, h);
+  gst_buffer_map (overlay, &map, GST_MAP_WRITE);
+
+  for (y = 0; y < h; y++) {
+    guint8 *out = map.data + y * w * 4;
+    gint sy = top + y;
+    guint8 *Y = GST_VIDEO_FRAME_COMP_DATA (&bframe, 0) +
+        sy * GST_VIDEO_FRAME_COMP_STRIDE (&bframe, 0);
+    guint8 *U = GST_VIDEO_FRAME_COMP_DATA (&bframe, 1) +
+        (sy / 2) * GST_VIDEO_FRAME_COMP_STRIDE (&bframe, 1);
+    guint8 *V = GST_VIDEO_FRAME_COMP_DATA (&bframe, 2) +
+        (sy / 2) * GST_VIDEO_FRAME_COMP_STRIDE (&bframe, 2);
+    gint u_pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (&bframe, 1);
+    gint v_pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (&bframe, 2);
+
+    for (x = 0; x < w; x++, out += 4) {
+      gint sx = left + x;
+      guint A = gstspu_composition_alpha (&bframe, &wframe, sx, sy);
+      guint block_A = 0;
+      gint bx, by;
+
+      out[0] = A;
+      out[1] = A ? MIN ((Y[sx] * 0xff + A / 2) / A, 0xff) : 0;
+
+      for (by = sy & ~1; by <= MIN (sy | 1, height - 1); by++)
+        for (bx = sx & ~1; bx <= MIN (sx | 1, width - 1); bx++)
+          block_A += gstspu_composition_alpha (&bframe, &wframe, bx, by);
+
+      if (block_A) {
+        out[2] = MIN (U[(sx / 2) * u_pstride] * 4 * 0xff / block_A, 0xff);
+        out[3] = MIN (V[(sx / 2) * v_pstride] * 4 * 0xff / block_A, 0xff);
+      } else {
+        out[2] = out[3] = 0x80;
+      }
+    }
+  }
+
+  gst_buffer_unmap (overlay, &map);
+
+  rectangle = gst_video_overlay_rectangle_new_raw (overlay, left, top, w, h,
+      GST_VIDEO_OVERLAY_FORMAT_FLAG_NONE);
+  composition = gst_video_overlay_composition_new (rectangle);
+  gst_video_overlay_rectangle_unref (rectangle);
+  gst_buffer_unref (overlay);
+
+  GST_LOG_OBJECT (dvdspu, "Rendered SPU overlay of %dx%d at %d,%d", w, h,
+      left, top);
+
+unmap:
+  gst_video_frame_unmap (&wframe);
+  gst_video_frame_unmap (&bframe);
+out:
+  gst_buffer_unref (black);
+  gst_buffer_unref (white);
+
+  return composition;
+}
+
+/* With SPU LOCK. Draws the SPU onto a writable buffer, either by blending
+ * it into the frame or by attaching the overlay of the current display set,
+ * which is only rendered again after the SPU state changed */
+static void
+gstspu_overlay (GstDVDSpu * dvdspu, GstBuffer * buf)
+{
+  if (!dvdspu->attach_compo_to_buffer) {
+    gstspu_render (dvdspu, buf);
+    return;
+  }
+
+  if (dvdspu->composition_dirty) {
+    if (dvdspu->composition)
+      gst_video_overlay_composition_unref (dvdspu->composition);
+    dvdspu->composition = gstspu_render_composition (dvdspu);
+    dvdspu->composition_dirty = FALSE;
+  }
+
+  if (dvdspu->composition)
+    gst_buffer_add_video_overlay_composition_meta (buf, dvdspu->composition);
+}
+
 /* With SPU LOCK */
 static void
 gst_dvd_spu_redraw_still (GstDVDSpu * dvdspu, gboolean force)
@@ -704,7 +1108,7 @@ gst_dvd_spu_redraw_still (GstDVDSpu * dvdspu, gboolean force)
       GST_BUFFER_DURATION (buf) = GST_CLOCK_TIME_NONE;
 
       /* Render the SPU overlay onto the buffer */
-      gstspu_render (dvdspu, buf);
+      gstspu_overlay (dvdspu, buf);
       gst_buffer_replace (&dvdspu->pending_frame, buf);
       gst_buffer_unref (buf);
     } else if (force) {
@@ -747,6 +1151,8 @@ gst_dvd_spu_handle_dvd_event (GstDVDSpu * dvdspu, GstEvent * event)
       break;
   }
 
+  dvdspu->composition_dirty = TRUE;
+
   if (hl_change && (dvdspu->spu_state.flags & SPU_STATE_STILL_FRAME)) {
     gst_dvd_spu_redraw_still (dvdspu, FALSE);
   }
@@ -783,6 +1189,10 @@ gst_dvd_spu_advance_spu (GstDVDSpu * dvdspu, GstClockTime new_ts)
         "Advancing SPU from TS %" GST_TIME_FORMAT " to %" GST_TIME_FORMAT,
         GST_TIME_ARGS (state->next_ts), GST_TIME_ARGS (new_ts));
 
+    /* Executing a due command may change what is displayed */
+    if (state->next_ts != GST_CLOCK_TIME_NONE)
+      dvdspu->composition_dirty = TRUE;
+
     if (!gstspu_execute_event (dvdspu)) {
       /* No current command buffer, try and get one */
       SpuPacket *packet = (SpuPacket *) g_queue_pop_head (dvdspu->pending_spus);
@@ -790,6 +1200,8 @@ gst_dvd_spu_advance_spu (GstDVDSpu * dvdspu, GstClockTime new_ts)
       if (packet == NULL)
         return;                 /* No SPU packets available */
 
+      dvdspu->composition_dirty = TRUE;
+
       GST_LOG_OBJECT (dvdspu,
           "Popped new SPU packet with TS %" GST_TIME_FORMAT
           ". Video position=%" GST_TIME_FORMAT " (%" GST_TIME_FORMAT
@@ -116,6 +116,12 @@ struct _GstDVDSpu {
 
   /* Buffer to push after handling a DVD event, if any */
   GstBuffer *pending_frame;
+
+  /* Attach the SPU as overlay composition meta instead of blending it */
+  gboolean attach_compo_to_buffer;
+  /* Overlay of the current display set, re-rendered when marked dirty */
+  GstVideoOverlayComposition *composition;
+  gboolean composition_dirty;
 };
 
 struct _GstDVDSpuClass {
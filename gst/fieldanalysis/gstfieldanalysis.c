@@ -82,6 +82,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_field_analysis_debug);
 #define DEFAULT_BLOCK_HEIGHT 16
 #define DEFAULT_BLOCK_THRESH 80
 #define DEFAULT_IGNORED_LINES 2
+#define DEFAULT_BLOCK_ROW_STEP 1
+#define DEFAULT_N_THREADS 1
 
 enum
 {
@@ -96,7 +98,9 @@ enum
   PROP_BLOCK_WIDTH,
   PROP_BLOCK_HEIGHT,
   PROP_BLOCK_THRESH,
-  PROP_IGNORED_LINES
+  PROP_IGNORED_LINES,
+  PROP_BLOCK_ROW_STEP,
+  PROP_N_THREADS
 };
 
 static GstStaticPadTemplate sink_factory =
@@ -274,6 +278,32 @@ gst_field_analysis_class_init (GstFieldAnalysisClass * klass)
           "Ignore this many lines from the top and bottom for windowed comb detection",
           2, G_MAXUINT64, DEFAULT_IGNORED_LINES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstFieldAnalysis:block-row-step:
+   *
+   * Only score every Nth row of blocks in windowed comb detection, trading
+   * detection accuracy for speed.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_BLOCK_ROW_STEP,
+      g_param_spec_uint64 ("block-row-step", "Block row step",
+          "Score only every Nth row of blocks for windowed comb detection",
+          1, G_MAXUINT64, DEFAULT_BLOCK_ROW_STEP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstFieldAnalysis:n-threads:
+   *
+   * Number of threads scoring bands of block rows in parallel in windowed
+   * comb detection. 0 uses one thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use for windowed comb detection "
+          "(0 = one per processor)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_field_analysis_change_state);
@@ -298,14 +328,31 @@ static gfloat same_parity_3_tap (GstFieldAnalysis * filter,
 static gfloat opposite_parity_5_tap (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2]);
 static guint64 block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores);
 static guint64 block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores);
 static guint64 block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores);
 static gfloat opposite_parity_windowed_comb (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2]);
 
+/* every band of windowed comb detection has its own comb mask and block
+ * scores, one after the other */
+static void
+gst_field_analysis_alloc_scores (GstFieldAnalysis * filter, gint width)
+{
+  const gint n_bands = MAX (filter->n_bands, 1);
+
+  g_free (filter->comb_mask);
+  filter->comb_mask = g_malloc (width * n_bands);
+  g_free (filter->block_scores);
+  filter->block_scores =
+      g_malloc0 ((width / filter->block_width) * n_bands * sizeof (guint));
+}
+
 static void
 gst_field_analysis_clear_frames (GstFieldAnalysis * filter)
 {
@@ -358,6 +405,10 @@ gst_field_analysis_init (GstFieldAnalysis * filter)
   filter->block_height = DEFAULT_BLOCK_HEIGHT;
   filter->block_thresh = DEFAULT_BLOCK_THRESH;
   filter->ignored_lines = DEFAULT_IGNORED_LINES;
+  filter->block_row_step = DEFAULT_BLOCK_ROW_STEP;
+  filter->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&filter->lock);
+  g_cond_init (&filter->cond);
 }
 
 static void
@@ -424,16 +475,8 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
     case PROP_BLOCK_WIDTH:
       filter->block_width = g_value_get_uint64 (value);
       if (GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame)) {
-        const gint frame_width =
-            GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame);
-        if (filter->block_scores) {
-          gsize nbytes = (frame_width / filter->block_width) * sizeof (guint);
-          filter->block_scores = g_realloc (filter->block_scores, nbytes);
-          memset (filter->block_scores, 0, nbytes);
-        } else {
-          filter->block_scores =
-              g_malloc0 ((frame_width / filter->block_width) * sizeof (guint));
-        }
+        gst_field_analysis_alloc_scores (filter,
+            GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame));
       }
       break;
     case PROP_BLOCK_HEIGHT:
@@ -445,6 +488,12 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       filter->ignored_lines = g_value_get_uint64 (value);
       break;
+    case PROP_BLOCK_ROW_STEP:
+      filter->block_row_step = g_value_get_uint64 (value);
+      break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -519,6 +568,12 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       g_value_set_uint64 (value, filter->ignored_lines);
       break;
+    case PROP_BLOCK_ROW_STEP:
+      g_value_set_uint64 (value, filter->block_row_step);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -568,19 +623,7 @@ gst_field_analysis_update_format (GstFieldAnalysis * filter, GstCaps * caps)
   width = GST_VIDEO_INFO_WIDTH (&filter->vinfo);
 
   /* update allocations for metric scores */
-  if (filter->comb_mask) {
-    filter->comb_mask = g_realloc (filter->comb_mask, width);
-  } else {
-    filter->comb_mask = g_malloc (width);
-  }
-  if (filter->block_scores) {
-    gsize nbytes = (width / filter->block_width) * sizeof (guint);
-    filter->block_scores = g_realloc (filter->block_scores, nbytes);
-    memset (filter->block_scores, 0, nbytes);
-  } else {
-    filter->block_scores =
-        g_malloc0 ((width / filter->block_width) * sizeof (guint));
-  }
+  gst_field_analysis_alloc_scores (filter, width);
 
   GST_OBJECT_UNLOCK (filter);
   return;
@@ -1037,11 +1080,10 @@ opposite_parity_5_tap (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
   guint64 block_score;
   guint8 *fjm2, *fjm1, *fj, *fjp1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1059,6 +1101,8 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
   fj = base_fj;
   fjp1 = base_fjp1;
 
+  memset (block_scores, 0, (width / block_width) * sizeof (guint));
+
   for (j = 0; j < block_height; j++) {
     /* we have to work one result ahead of ourselves which results in some small
      * peculiarities below */
@@ -1114,8 +1158,6 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1124,11 +1166,10 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
   guint64 block_score;
   guint8 *fjm1, *fj, *fjp1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1146,6 +1187,8 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
   fj = base_fj;
   fjp1 = base_fjp1;
 
+  memset (block_scores, 0, (width / block_width) * sizeof (guint));
+
   for (j = 0; j < block_height; j++) {
     /* we have to work one result ahead of ourselves which results in some small
      * peculiarities below */
@@ -1202,8 +1245,6 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1212,11 +1253,10 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
   guint64 block_score;
   guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1237,6 +1277,8 @@ block_score_for_row_5_tap (GstFieldAnalysis * filter,
   fjp1 = base_fjp1;
   fjp2 = fj + stridex2;
 
+  memset (block_scores, 0, (width / block_width) * sizeof (guint));
+
   for (j = 0; j < block_height; j++) {
     /* we have to work one result ahead of ourselves which results in some small
      * peculiarities below */
@@ -1313,11 +1355,63 @@ block_score_for_row_5_tap (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
+/* scores the rows of blocks of one band: returns 2 as soon as a block is
+ * above the block threshold, 1 if a block is above half of it, else 0 */
+static gint
+opposite_parity_windowed_comb_band (GstFieldAnalysis * filter, gint band)
+{
+  FieldAnalysisFields (*history)[2] = filter->history;
+  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  const gint stride = GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
+  const guint64 block_thresh = filter->block_thresh;
+  const guint64 block_height = filter->block_height;
+  const gint row_start = filter->n_block_rows * band / filter->n_bands;
+  const gint row_end = filter->n_block_rows * (band + 1) / filter->n_bands;
+  guint8 *comb_mask = filter->comb_mask + band * width;
+  guint *block_scores =
+      filter->block_scores + band * (width / filter->block_width);
+  gint row, result = 0;
+
+  for (row = row_start; row < row_end; row++) {
+    guint64 line_offset;
+    guint64 block_score;
+
+    if (row % filter->block_row_step)
+      continue;
+
+    line_offset = (filter->ignored_lines + row * block_height) * stride;
+    block_score =
+        filter->block_score_for_row (filter, history,
+        filter->base_fj + line_offset, filter->base_fjp1 + line_offset,
+        comb_mask, block_scores);
+
+    if (block_score > block_thresh)
+      return 2;
+    if (block_score > (block_thresh >> 1))
+      result = 1;
+  }
+
+  return result;
+}
+
+static void
+opposite_parity_windowed_comb_func (gpointer data, gpointer user_data)
+{
+  GstFieldAnalysis *filter = user_data;
+  gint band = GPOINTER_TO_INT (data) - 1;
+
+  filter->band_results[band] =
+      opposite_parity_windowed_comb_band (filter, band);
+
+  g_mutex_lock (&filter->lock);
+  if (--filter->pending_bands == 0)
+    g_cond_signal (&filter->cond);
+  g_mutex_unlock (&filter->lock);
+}
+
 /* a pass is made over the field using one of three comb-detection metrics
    and the results are then analysed block-wise. if the samples to the left
    and right are combed, they contribute to the block score. if the block
@@ -1331,57 +1425,65 @@ static gfloat
 opposite_parity_windowed_comb (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2])
 {
-  gint j;
-  gboolean slightly_combed;
+  gint i, result;
 
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride = GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
-  const guint64 block_thresh = filter->block_thresh;
   const guint64 block_height = filter->block_height;
-  guint8 *base_fj, *base_fjp1;
 
   if ((*history)[0].parity == TOP_FIELD) {
-    base_fj =
+    filter->base_fj =
         GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
         0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0);
-    base_fjp1 =
+    filter->base_fjp1 =
         GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
         0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
         0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0);
   } else {
-    base_fj =
+    filter->base_fj =
         GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
         0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame, 0);
-    base_fjp1 =
+    filter->base_fjp1 =
         GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
         0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
         0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
   }
+  filter->history = history;
 
-  /* we operate on a row of blocks of height block_height through each iteration */
-  slightly_combed = FALSE;
-  for (j = 0; j <= height - filter->ignored_lines - block_height;
-      j += block_height) {
-    guint64 line_offset = (filter->ignored_lines + j) * stride;
-    guint block_score =
-        filter->block_score_for_row (filter, history, base_fj + line_offset,
-        base_fjp1 + line_offset);
-
-    if (block_score > (block_thresh >> 1)
-        && block_score <= block_thresh) {
-      /* blend if nothing more combed comes along */
-      slightly_combed = TRUE;
-    } else if (block_score > block_thresh) {
-      if (GST_VIDEO_INFO_INTERLACE_MODE (&(*history)[0].frame.info) ==
-          GST_VIDEO_INTERLACE_MODE_INTERLEAVED) {
-        return 1.0f;            /* blend */
-      } else {
-        return 2.0f;            /* deinterlace */
-      }
+  /* we operate on a row of blocks of height block_height at a time */
+  if (block_height == 0 || height < filter->ignored_lines + block_height)
+    filter->n_block_rows = 0;
+  else
+    filter->n_block_rows =
+        (height - filter->ignored_lines - block_height) / block_height + 1;
+
+  if (filter->pool) {
+    filter->pending_bands = filter->n_bands - 1;
+    for (i = 1; i < filter->n_bands; i++)
+      g_thread_pool_push (filter->pool, GINT_TO_POINTER (i + 1), NULL);
+
+    result = opposite_parity_windowed_comb_band (filter, 0);
+
+    g_mutex_lock (&filter->lock);
+    while (filter->pending_bands > 0)
+      g_cond_wait (&filter->cond, &filter->lock);
+    g_mutex_unlock (&filter->lock);
+
+    for (i = 1; i < filter->n_bands; i++)
+      result = MAX (result, filter->band_results[i]);
+  } else {
+    result = opposite_parity_windowed_comb_band (filter, 0);
+  }
+
+  if (result == 2) {
+    if (GST_VIDEO_INFO_INTERLACE_MODE (&(*history)[0].frame.info) ==
+        GST_VIDEO_INTERLACE_MODE_INTERLEAVED) {
+      return 1.0f;              /* blend */
+    } else {
+      return 2.0f;              /* deinterlace */
     }
   }
 
-  return (gfloat) slightly_combed;      /* TRUE means blend, else don't */
+  return (gfloat) result;       /* TRUE means blend, else don't */
 }
 
 /* this is where the magic happens
@@ -1800,6 +1902,26 @@ gst_field_analysis_change_state (GstElement * element,
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      filter->n_bands = filter->n_threads;
+      if (filter->n_bands == 0)
+        filter->n_bands = g_get_num_processors ();
+
+      /* the streaming thread scores one of the bands itself */
+      if (filter->n_bands > 1) {
+        GError *err = NULL;
+
+        filter->pool =
+            g_thread_pool_new (opposite_parity_windowed_comb_func, filter,
+            filter->n_bands - 1, FALSE, &err);
+        if (!filter->pool) {
+          GST_ELEMENT_ERROR (filter, RESOURCE, FAILED,
+              ("Failed to create comb detection threads"),
+              ("%s", err->message));
+          g_clear_error (&err);
+          return GST_STATE_CHANGE_FAILURE;
+        }
+        filter->band_results = g_new0 (gint, filter->n_bands);
+      }
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -1816,6 +1938,13 @@ gst_field_analysis_change_state (GstElement * element,
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_field_analysis_reset (filter);
+      if (filter->pool) {
+        g_thread_pool_free (filter->pool, FALSE, TRUE);
+        filter->pool = NULL;
+      }
+      g_free (filter->band_results);
+      filter->band_results = NULL;
+      filter->n_bands = 0;
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
     default:
@@ -1831,6 +1960,8 @@ gst_field_analysis_finalize (GObject * object)
   GstFieldAnalysis *filter = GST_FIELDANALYSIS (object);
 
   gst_field_analysis_reset (filter);
+  g_mutex_clear (&filter->lock);
+  g_cond_clear (&filter->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -119,7 +119,7 @@ struct _GstFieldAnalysis
   GstVideoInfo vinfo;
   gfloat (*same_field) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]);
   gfloat (*same_frame) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]);
-  guint64 (*block_score_for_row) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], guint8 *, guint8 *);
+  guint64 (*block_score_for_row) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], guint8 *, guint8 *, guint8 *, guint *);
   gboolean is_telecine;
   gboolean first_buffer; /* indicates the first buffer for which a buffer will be output
                           * after a discont or flushing seek */
@@ -135,6 +135,19 @@ struct _GstFieldAnalysis
   guint64 block_width, block_height; /* width/height of window used for comb clusted detection */
   guint64 block_thresh;
   guint64 ignored_lines;
+  guint64 block_row_step; /* score only every Nth row of blocks */
+  guint n_threads;
+
+  /* windowed comb detection threads, each scoring a band of block rows */
+  GThreadPool *pool;
+  gint n_bands;
+  gint *band_results;
+  GMutex lock;
+  GCond cond;
+  gint pending_bands;
+  FieldAnalysisFields (*history)[2];
+  guint8 *base_fj, *base_fjp1;
+  gint n_block_rows;
 };
 
 struct _GstFieldAnalysisClass
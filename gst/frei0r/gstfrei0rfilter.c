@@ -35,6 +35,110 @@ typedef struct
   GstFrei0rFuncTable ftable;
 } GstFrei0rFilterClassData;
 
+#define DEFAULT_SLICE_THREADS 1
+
+static void
+gst_frei0r_filter_destroy_instances (GstFrei0rFilter * self,
+    GstFrei0rFilterClass * klass)
+{
+  guint i;
+
+  if (self->f0r_instance) {
+    klass->ftable->destruct (self->f0r_instance);
+    self->f0r_instance = NULL;
+  }
+
+  for (i = 0; i < self->n_slices; i++) {
+    if (self->slice_instances[i])
+      klass->ftable->destruct (self->slice_instances[i]);
+  }
+  g_free (self->slice_instances);
+  self->slice_instances = NULL;
+  self->n_slices = 0;
+}
+
+/* frei0r requires frame heights in multiples of 8, so all the bands but
+ * the last one are rounded to that */
+static void
+gst_frei0r_filter_get_slice (GstFrei0rFilter * self, guint slice,
+    gint * y, gint * height)
+{
+  gint band = GST_ROUND_UP_8 (self->height / self->n_slices);
+  gint start = MIN (slice * band, self->height);
+  gint end = slice == self->n_slices - 1 ? self->height :
+      MIN (start + band, self->height);
+
+  *y = start;
+  *height = end - start;
+}
+
+static void
+gst_frei0r_filter_update_slice (GstFrei0rFilter * self, guint slice)
+{
+  GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (self);
+  f0r_instance_t *instance = self->slice_instances[slice];
+  gsize offset;
+  gint y, height;
+
+  gst_frei0r_filter_get_slice (self, slice, &y, &height);
+  if (height <= 0)
+    return;
+
+  offset = (gsize) y * self->width;
+  if (klass->ftable->update2)
+    klass->ftable->update2 (instance, self->time, self->src + offset, NULL,
+        NULL, self->dest + offset);
+  else
+    klass->ftable->update (instance, self->time, self->src + offset,
+        self->dest + offset);
+}
+
+static void
+gst_frei0r_filter_slice_func (gpointer data, gpointer user_data)
+{
+  GstFrei0rFilter *self = user_data;
+
+  gst_frei0r_filter_update_slice (self, GPOINTER_TO_UINT (data) - 1);
+
+  g_mutex_lock (&self->lock);
+  if (--self->pending_slices == 0)
+    g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/* (re)creates one instance per band, each one configured with the
+ * current property values */
+static gboolean
+gst_frei0r_filter_create_slices (GstFrei0rFilter * self,
+    GstFrei0rFilterClass * klass, guint n_slices)
+{
+  guint i;
+
+  gst_frei0r_filter_destroy_instances (self, klass);
+
+  self->n_slices = n_slices;
+  self->slice_instances = g_new0 (f0r_instance_t *, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    gint y, height;
+
+    /* the rounding can leave the last bands empty */
+    gst_frei0r_filter_get_slice (self, i, &y, &height);
+    if (height <= 0)
+      continue;
+
+    self->slice_instances[i] =
+        gst_frei0r_instance_construct (klass->ftable, klass->properties,
+        klass->n_properties, self->property_cache, self->width, height);
+    if (!self->slice_instances[i]) {
+      self->n_slices = i;
+      gst_frei0r_filter_destroy_instances (self, klass);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_frei0r_filter_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     GstCaps * outcaps)
@@ -54,10 +158,8 @@ gst_frei0r_filter_set_caps (GstBaseTransform * trans, GstCaps * incaps,
   self->width = info.width;
   self->height = info.height;
 
-  if (self->f0r_instance && destroy_f0r_instance) {
-    klass->ftable->destruct (self->f0r_instance);
-    self->f0r_instance = NULL;
-  }
+  if (destroy_f0r_instance)
+    gst_frei0r_filter_destroy_instances (self, klass);
 
   return TRUE;
 }
@@ -68,10 +170,7 @@ gst_frei0r_filter_stop (GstBaseTransform * trans)
   GstFrei0rFilter *self = GST_FREI0R_FILTER (trans);
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (trans);
 
-  if (self->f0r_instance) {
-    klass->ftable->destruct (self->f0r_instance);
-    self->f0r_instance = NULL;
-  }
+  gst_frei0r_filter_destroy_instances (self, klass);
 
   self->width = self->height = 0;
 
@@ -104,31 +203,61 @@ gst_frei0r_filter_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (trans);
   gdouble time;
   GstMapInfo inmap, outmap;
+  guint n_slices;
 
   if (G_UNLIKELY (self->width <= 0 || self->height <= 0))
     return GST_FLOW_NOT_NEGOTIATED;
 
-  if (G_UNLIKELY (!self->f0r_instance)) {
+  time = ((gdouble) GST_BUFFER_TIMESTAMP (inbuf)) / GST_SECOND;
+
+  GST_OBJECT_LOCK (self);
+
+  n_slices = self->slice_threads;
+  if (n_slices == 0)
+    n_slices = g_get_num_processors ();
+  n_slices = CLAMP (n_slices, 1, MAX (self->height / 8, 1));
+
+  if (n_slices == 1 && !self->f0r_instance) {
+    gst_frei0r_filter_destroy_instances (self, klass);
     self->f0r_instance =
         gst_frei0r_instance_construct (klass->ftable, klass->properties,
         klass->n_properties, self->property_cache, self->width, self->height);
     if (G_UNLIKELY (!self->f0r_instance))
-      return GST_FLOW_ERROR;
+      goto construct_failed;
+  } else if (n_slices > 1 && self->n_slices != n_slices) {
+    if (!gst_frei0r_filter_create_slices (self, klass, n_slices))
+      goto construct_failed;
   }
 
-  time = ((gdouble) GST_BUFFER_TIMESTAMP (inbuf)) / GST_SECOND;
-
-  GST_OBJECT_LOCK (self);
-
   gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
   gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
 
-  if (klass->ftable->update2)
-    klass->ftable->update2 (self->f0r_instance, time,
-        (const guint32 *) inmap.data, NULL, NULL, (guint32 *) outmap.data);
-  else
-    klass->ftable->update (self->f0r_instance, time,
-        (const guint32 *) inmap.data, (guint32 *) outmap.data);
+  if (n_slices == 1) {
+    if (klass->ftable->update2)
+      klass->ftable->update2 (self->f0r_instance, time,
+          (const guint32 *) inmap.data, NULL, NULL, (guint32 *) outmap.data);
+    else
+      klass->ftable->update (self->f0r_instance, time,
+          (const guint32 *) inmap.data, (guint32 *) outmap.data);
+  } else {
+    guint i;
+
+    self->time = time;
+    self->src = (const guint32 *) inmap.data;
+    self->dest = (guint32 *) outmap.data;
+
+    self->pending_slices = n_slices - 1;
+    g_thread_pool_set_max_threads (self->pool, n_slices - 1, NULL);
+    for (i = 1; i < n_slices; i++)
+      g_thread_pool_push (self->pool, GUINT_TO_POINTER (i + 1), NULL);
+
+    gst_frei0r_filter_update_slice (self, 0);
+
+    g_mutex_lock (&self->lock);
+    while (self->pending_slices > 0)
+      g_cond_wait (&self->cond, &self->lock);
+    g_mutex_unlock (&self->lock);
+  }
 
   gst_buffer_unmap (outbuf, &outmap);
   gst_buffer_unmap (inbuf, &inmap);
@@ -136,6 +265,10 @@ gst_frei0r_filter_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   GST_OBJECT_UNLOCK (self);
 
   return GST_FLOW_OK;
+
+construct_failed:
+  GST_OBJECT_UNLOCK (self);
+  return GST_FLOW_ERROR;
 }
 
 static void
@@ -144,10 +277,11 @@ gst_frei0r_filter_finalize (GObject * object)
   GstFrei0rFilter *self = GST_FREI0R_FILTER (object);
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (object);
 
-  if (self->f0r_instance) {
-    klass->ftable->destruct (self->f0r_instance);
-    self->f0r_instance = NULL;
-  }
+  gst_frei0r_filter_destroy_instances (self, klass);
+
+  g_thread_pool_free (self->pool, FALSE, TRUE);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
 
   if (self->property_cache)
     gst_frei0r_property_cache_free (klass->properties, self->property_cache,
@@ -165,10 +299,14 @@ gst_frei0r_filter_get_property (GObject * object, guint prop_id, GValue * value,
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (object);
 
   GST_OBJECT_LOCK (self);
-  if (!gst_frei0r_get_property (self->f0r_instance, klass->ftable,
+  if (prop_id == klass->slice_threads_prop_id) {
+    g_value_set_uint (value, self->slice_threads);
+  } else if (!gst_frei0r_get_property (self->n_slices > 0 ?
+          self->slice_instances[0] : self->f0r_instance, klass->ftable,
           klass->properties, klass->n_properties, self->property_cache, prop_id,
-          value))
+          value)) {
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  }
   GST_OBJECT_UNLOCK (self);
 }
 
@@ -180,10 +318,22 @@ gst_frei0r_filter_set_property (GObject * object, guint prop_id,
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (object);
 
   GST_OBJECT_LOCK (self);
-  if (!gst_frei0r_set_property (self->f0r_instance, klass->ftable,
+  if (prop_id == klass->slice_threads_prop_id) {
+    self->slice_threads = g_value_get_uint (value);
+  } else if (!gst_frei0r_set_property (self->f0r_instance, klass->ftable,
           klass->properties, klass->n_properties, self->property_cache, prop_id,
-          value))
+          value)) {
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  } else {
+    guint i;
+
+    for (i = 0; i < self->n_slices; i++) {
+      if (self->slice_instances[i])
+        gst_frei0r_set_property (self->slice_instances[i], klass->ftable,
+            klass->properties, klass->n_properties, self->property_cache,
+            prop_id, value);
+    }
+  }
   GST_OBJECT_UNLOCK (self);
 }
 
@@ -198,6 +348,7 @@ gst_frei0r_filter_class_init (GstFrei0rFilterClass * klass,
   const gchar *desc;
   GstCaps *caps;
   gchar *author;
+  gint i;
 
   klass->ftable = &class_data->ftable;
   klass->info = &class_data->info;
@@ -212,6 +363,22 @@ gst_frei0r_filter_class_init (GstFrei0rFilterClass * klass,
   gst_frei0r_klass_install_properties (gobject_class, klass->ftable,
       klass->properties, klass->n_properties);
 
+  /* the frei0r properties use the ids from 1 on */
+  klass->slice_threads_prop_id = 1;
+  for (i = 0; i < klass->n_properties; i++)
+    klass->slice_threads_prop_id += klass->properties[i].n_prop_ids;
+
+  /* frei0r has no way for an effect to tell whether its output only depends
+   * on the pixel itself, so slicing is left to the user */
+  g_object_class_install_property (gobject_class,
+      klass->slice_threads_prop_id, g_param_spec_uint ("slice-threads",
+          "Slice threads",
+          "Number of threads running one effect instance each on a horizontal "
+          "band of the frame (0 = number of processors). Only use this with "
+          "effects that process each pixel independently of its position",
+          0, G_MAXINT, DEFAULT_SLICE_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   author =
       g_strdup_printf
       ("Sebastian Dröge <sebastian.droege@collabora.co.uk>, %s",
@@ -246,6 +413,13 @@ gst_frei0r_filter_init (GstFrei0rFilter * self, GstFrei0rFilterClass * klass)
 {
   self->property_cache =
       gst_frei0r_property_cache_init (klass->properties, klass->n_properties);
+  self->slice_threads = DEFAULT_SLICE_THREADS;
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  self->pool =
+      g_thread_pool_new (gst_frei0r_filter_slice_func, self, 1, FALSE, NULL);
+
   gst_pad_use_fixed_caps (GST_BASE_TRANSFORM_SINK_PAD (self));
   gst_pad_use_fixed_caps (GST_BASE_TRANSFORM_SRC_PAD (self));
 }
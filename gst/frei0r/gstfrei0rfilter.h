@@ -46,6 +46,22 @@ struct _GstFrei0rFilter {
 
   f0r_instance_t *f0r_instance;
   GstFrei0rPropertyValue *property_cache;
+
+  guint slice_threads;
+
+  /* one instance per horizontal band when slicing */
+  f0r_instance_t **slice_instances;
+  guint n_slices;
+
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending_slices;
+
+  /* current frame, for the slice threads */
+  gdouble time;
+  const guint32 *src;
+  guint32 *dest;
 };
 
 struct _GstFrei0rFilterClass {
@@ -56,6 +72,8 @@ struct _GstFrei0rFilterClass {
 
   GstFrei0rProperty *properties;
   gint n_properties;
+
+  guint slice_threads_prop_id;
 };
 
 GstFrei0rPluginRegisterReturn gst_frei0r_filter_register (GstPlugin *plugin, const gchar * vendor, const f0r_plugin_info_t *info, const GstFrei0rFuncTable *ftable);
@@ -60,9 +60,9 @@
 
 #ifdef HAVE_CONFIG_H
 #include <config.h>
-#include <string.h>
 #endif
 
+#include <string.h>
 #include <math.h>
 #include <gst/gst.h>
 
@@ -111,17 +111,37 @@ GST_STATIC_PAD_TEMPLATE ("src",
 enum
 {
   PROP_0,
-  PROP_SIGMA
+  PROP_SIGMA,
+  PROP_N_THREADS
+};
+
+/* the fixed point kernel sums to 1 << GAUSS_KERNEL_BITS, the rows blurred
+ * horizontally keep GAUSS_TMP_BITS bits of fraction in 16 bits, which is
+ * enough for the gains of the sharpening kernels */
+#define GAUSS_KERNEL_BITS 12
+#define GAUSS_TMP_BITS 4
+
+/* above this sigma, blurring uses a recursive filter whose cost does not
+ * depend on sigma */
+#define GAUSS_IIR_MIN_SIGMA 3.0
+
+enum
+{
+  PASS_FIR,
+  PASS_IIR_HORIZONTAL,
+  PASS_IIR_VERTICAL
 };
 
 static gboolean make_gaussian_kernel (GstGaussianBlur * gb, float sigma);
-static void gaussian_smooth (GstGaussianBlur * gb, guint8 * image,
-    guint8 * out_image);
+static void gaussian_smooth (GstGaussianBlur * gb);
+static gboolean gst_gaussianblur_start (GstBaseTransform * trans);
+static gboolean gst_gaussianblur_stop (GstBaseTransform * trans);
 
 #define gst_gaussianblur_parent_class parent_class
 G_DEFINE_TYPE (GstGaussianBlur, gst_gaussianblur, GST_TYPE_VIDEO_FILTER);
 
 #define DEFAULT_SIGMA 1.2
+#define DEFAULT_N_THREADS 1
 
 /* Initalize the gaussianblur's class. */
 static void
@@ -130,6 +150,7 @@ gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
   GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *gstelement_class = (GstElementClass *) klass;
   GstVideoFilterClass *vfilter_class = (GstVideoFilterClass *) klass;
+  GstBaseTransformClass *trans_class = (GstBaseTransformClass *) klass;
 
   gst_element_class_set_static_metadata (gstelement_class,
       "GstGaussianBlur",
@@ -152,6 +173,22 @@ gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
           -20.0, 20.0, DEFAULT_SIGMA,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGaussianBlur:n-threads:
+   *
+   * Number of threads the frames are blurred in, each one handling a
+   * stripe of the frame.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads to blur the frames in "
+          "(0 = number of processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  trans_class->start = GST_DEBUG_FUNCPTR (gst_gaussianblur_start);
+  trans_class->stop = GST_DEBUG_FUNCPTR (gst_gaussianblur_stop);
   vfilter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_gaussianblur_transform_frame);
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_gaussianblur_set_info);
@@ -162,15 +199,19 @@ gst_gaussianblur_set_info (GstVideoFilter * filter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
 {
   GstGaussianBlur *gb = GST_GAUSSIANBLUR (filter);
-  guint32 n_elems;
 
   gb->width = GST_VIDEO_INFO_WIDTH (in_info);
   gb->height = GST_VIDEO_INFO_HEIGHT (in_info);
 
   /* get stride */
   gb->stride = GST_VIDEO_INFO_COMP_STRIDE (in_info, 0);
-  n_elems = gb->stride * gb->height;
-  gb->tempim = g_malloc (sizeof (gfloat) * n_elems);
+
+  /* the frame blurred horizontally by the recursive filter, allocated
+   * when first needed */
+  g_free (gb->tempim);
+  gb->tempim = NULL;
+  /* the size of the scratch buffers depends on the width */
+  gb->band_tmp_size = 0;
 
   return TRUE;
 }
@@ -180,6 +221,9 @@ gst_gaussianblur_init (GstGaussianBlur * gb)
 {
   gb->sigma = (gfloat) DEFAULT_SIGMA;
   gb->cur_sigma = -1.0;
+  gb->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&gb->lock);
+  g_cond_init (&gb->cond);
 }
 
 static void
@@ -197,10 +241,44 @@ gst_gaussianblur_finalize (GObject * object)
   gb->kernel = NULL;
   g_free (gb->kernel_sum);
   gb->kernel_sum = NULL;
+  g_free (gb->kernel_fixed);
+  gb->kernel_fixed = NULL;
+
+  g_free (gb->band_tmp);
+  gb->band_tmp = NULL;
+
+  g_mutex_clear (&gb->lock);
+  g_cond_clear (&gb->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void gst_gaussianblur_band_func (gpointer data, gpointer user_data);
+
+static gboolean
+gst_gaussianblur_start (GstBaseTransform * trans)
+{
+  GstGaussianBlur *gb = GST_GAUSSIANBLUR (trans);
+
+  gb->pool = g_thread_pool_new (gst_gaussianblur_band_func, gb, 1, FALSE,
+      NULL);
+
+  return gb->pool != NULL;
+}
+
+static gboolean
+gst_gaussianblur_stop (GstBaseTransform * trans)
+{
+  GstGaussianBlur *gb = GST_GAUSSIANBLUR (trans);
+
+  if (gb->pool) {
+    g_thread_pool_free (gb->pool, FALSE, TRUE);
+    gb->pool = NULL;
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
@@ -209,7 +287,6 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
   GstClockTime timestamp;
   gint64 stream_time;
   gfloat sigma;
-  guint8 *src, *dest;
 
   /* GstController: update the properties */
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
@@ -232,6 +309,8 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
     filter->kernel = NULL;
     g_free (filter->kernel_sum);
     filter->kernel_sum = NULL;
+    g_free (filter->kernel_fixed);
+    filter->kernel_fixed = NULL;
     filter->cur_sigma = sigma;
   }
   if (filter->kernel == NULL &&
@@ -241,115 +320,280 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
     return GST_FLOW_ERROR;
   }
 
+  if (filter->cur_sigma == 0.0) {
+    gst_video_frame_copy (out_frame, in_frame);
+    return GST_FLOW_OK;
+  }
+
   /*
    * Perform gaussian smoothing on the image using the input standard
    * deviation.
    */
-  src = GST_VIDEO_FRAME_COMP_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_COMP_DATA (out_frame, 0);
-  gst_video_frame_copy (out_frame, in_frame);
-  if (filter->sigma != 0.0)
-    gaussian_smooth (filter, src, dest);
+  filter->src = GST_VIDEO_FRAME_COMP_DATA (in_frame, 0);
+  filter->src_stride = GST_VIDEO_FRAME_COMP_STRIDE (in_frame, 0);
+  filter->dest = GST_VIDEO_FRAME_COMP_DATA (out_frame, 0);
+  filter->dest_stride = GST_VIDEO_FRAME_COMP_STRIDE (out_frame, 0);
+  gaussian_smooth (filter);
 
   return GST_FLOW_OK;
 }
 
+/* Blurs @in_row horizontally into @out_row, in fixed point with
+ * GAUSS_TMP_BITS bits of fraction. The pixels at the edges are repeated.
+ * The loops run over all the components of the row so that the compiler
+ * can vectorize them. */
 static void
-blur_row_x (GstGaussianBlur * gb, guint8 * in_row, gfloat * out_row)
+blur_row_x (GstGaussianBlur * gb, const guint8 * in_row, guint8 * padded,
+    gint32 * acc, gint16 * out_row)
 {
-  int c, cc, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-
-  center = gb->windowsize / 2;
-
-  for (c = 0; c < gb->width; c++) {
-    /* Calculate min */
-    cc = center - c;
-    kmin = MAX (0, cc);
-    cc = kmin - cc;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->width - cc);
-    cc *= 4;
-
-    dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-    /* Calculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
-
-    for (k = kmin; k < kmax; k++) {
-      float coeff = gb->kernel[k];
-      dot[0] += (float) in_row[cc++] * coeff;
-      dot[1] += (float) in_row[cc++] * coeff;
-      dot[2] += (float) in_row[cc++] * coeff;
-      dot[3] += (float) in_row[cc++] * coeff;
+  gint center = gb->windowsize / 2;
+  gint n = gb->width * 4;
+  gint i, k;
+
+  for (i = 0; i < center; i++) {
+    memcpy (padded + i * 4, in_row, 4);
+    memcpy (padded + (center + gb->width + i) * 4, in_row + n - 4, 4);
+  }
+  memcpy (padded + center * 4, in_row, n);
+
+  for (i = 0; i < n; i++)
+    acc[i] = 0;
+  for (k = 0; k < gb->windowsize; k++) {
+    const guint8 *in = padded + k * 4;
+    gint32 coeff = gb->kernel_fixed[k];
+
+    for (i = 0; i < n; i++)
+      acc[i] += coeff * in[i];
+  }
+
+  for (i = 0; i < n; i++)
+    out_row[i] = (acc[i] + (1 << (GAUSS_KERNEL_BITS - GAUSS_TMP_BITS - 1)))
+        >> (GAUSS_KERNEL_BITS - GAUSS_TMP_BITS);
+}
+
+/* the bytes of scratch memory the kernel needs per band */
+static gsize
+gaussian_band_tmp_size (GstGaussianBlur * gb)
+{
+  gint center = gb->windowsize / 2;
+  gint n = gb->width * 4;
+
+  return GST_ROUND_UP_16 ((gb->width + 2 * center) * 4) +
+      GST_ROUND_UP_16 (n * sizeof (gint32)) +
+      gb->windowsize * GST_ROUND_UP_16 (n * sizeof (gint16));
+}
+
+/* Blurs rows @y0 to @y1 with the separable kernel. The rows blurred
+ * horizontally are kept in a ring of windowsize rows, the rows above and
+ * below the frame are copies of the first and last ones. */
+static void
+gaussian_smooth_fir (GstGaussianBlur * gb, guint band, gint y0, gint y1)
+{
+  gint center = gb->windowsize / 2;
+  gint n = gb->width * 4;
+  gint row_pitch = GST_ROUND_UP_16 (n * sizeof (gint16)) / sizeof (gint16);
+  guint8 *tmp = gb->band_tmp + band * gb->band_tmp_size;
+  guint8 *padded = tmp;
+  gint32 *acc = (gint32 *) (tmp + GST_ROUND_UP_16 ((gb->width +
+              2 * center) * 4));
+  gint16 *ring = (gint16 *) ((guint8 *) acc +
+      GST_ROUND_UP_16 (n * sizeof (gint32)));
+  gint next = y0 - center;
+  gint y, i, k;
+
+#define RING_ROW(r) (ring + ((((r) % gb->windowsize) + gb->windowsize) % \
+      gb->windowsize) * row_pitch)
+
+  for (y = y0; y < y1; y++) {
+    guint8 *out = gb->dest + y * gb->dest_stride;
+
+    while (next <= y + center) {
+      gint r = CLAMP (next, 0, gb->height - 1);
+
+      blur_row_x (gb, gb->src + r * gb->src_stride, padded, acc,
+          RING_ROW (next));
+      next++;
+    }
+
+    for (i = 0; i < n; i++)
+      acc[i] = 0;
+    for (k = 0; k < gb->windowsize; k++) {
+      const gint16 *in = RING_ROW (y - center + k);
+      gint32 coeff = gb->kernel_fixed[k];
+
+      for (i = 0; i < n; i++)
+        acc[i] += coeff * in[i];
+    }
+
+    for (i = 0; i < n; i++) {
+      gint32 v = (acc[i] + (1 << (GAUSS_KERNEL_BITS + GAUSS_TMP_BITS - 1)))
+          >> (GAUSS_KERNEL_BITS + GAUSS_TMP_BITS);
+
+      out[i] = CLAMP (v, 0, 255);
     }
+  }
+#undef RING_ROW
+}
 
-    out_row[c * 4] = dot[0] / sum;
-    out_row[c * 4 + 1] = dot[1] / sum;
-    out_row[c * 4 + 2] = dot[2] / sum;
-    out_row[c * 4 + 3] = dot[3] / sum;
+/* The recursive gaussian of Young and van Vliet, run forward then
+ * backward. Its state starts from the steady state of the edge pixels. */
+static void
+gaussian_smooth_iir_rows (GstGaussianBlur * gb, gint y0, gint y1)
+{
+  const gfloat *c = gb->iir_coeffs;
+  gint n = gb->width * 4;
+  gint x, y;
+
+  for (y = y0; y < y1; y++) {
+    const guint8 *in = gb->src + y * gb->src_stride;
+    gfloat *t = gb->tempim + (gsize) y * n;
+
+    for (x = 0; x < 4; x++)
+      t[x] = in[x];
+    for (x = 4; x < n; x++)
+      t[x] = c[0] * in[x] + c[1] * t[x - 4] + c[2] * t[MAX (x - 8, x & 3)] +
+          c[3] * t[MAX (x - 12, x & 3)];
+
+    for (x = n - 5; x >= 0; x--)
+      t[x] = c[0] * t[x] + c[1] * t[x + 4] +
+          c[2] * t[MIN (x + 8, n - 4 + (x & 3))] +
+          c[3] * t[MIN (x + 12, n - 4 + (x & 3))];
   }
 }
 
+/* the vertical pass of the recursive filter, on components @x0 to @x1 of
+ * all the rows */
 static void
-gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
+gaussian_smooth_iir_columns (GstGaussianBlur * gb, gint x0, gint x1)
 {
-  int r, c, rr, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-  guint8 *in_row = image;
-  float *tmp_out_row = gb->tempim;
-  float *tmp_in_pos;
-  gint y_avail = 0;
-  guint8 *out_row;
-
-  /* Apply the gaussian kernel */
-  center = gb->windowsize / 2;
-
-  /* Blur in the y - direction. */
-  for (r = 0; r < gb->height; r++) {
-    /* Calculate input row range */
-    rr = center - r;
-    kmin = MAX (0, rr);
-    rr = kmin - rr;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->height - rr);
-
-    /* Precalculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
-
-    /* Blur more input rows (x direction blur) */
-    while (y_avail <= (r + center) && y_avail < gb->height) {
-      blur_row_x (gb, in_row, tmp_out_row);
-      in_row += gb->stride;
-      tmp_out_row += gb->stride;
-      y_avail++;
+  const gfloat *c = gb->iir_coeffs;
+  gint n = gb->width * 4;
+  gint h = gb->height;
+  gint x, y;
+
+#define ROW(r) (gb->tempim + (gsize) (r) * n)
+
+  for (y = 1; y < h; y++) {
+    gfloat *t = ROW (y);
+    const gfloat *p1 = ROW (y - 1);
+    const gfloat *p2 = ROW (MAX (y - 2, 0));
+    const gfloat *p3 = ROW (MAX (y - 3, 0));
+
+    for (x = x0; x < x1; x++)
+      t[x] = c[0] * t[x] + c[1] * p1[x] + c[2] * p2[x] + c[3] * p3[x];
+  }
+
+  for (y = h - 1; y >= 0; y--) {
+    gfloat *t = ROW (y);
+    guint8 *out = gb->dest + y * gb->dest_stride;
+
+    if (y < h - 1) {
+      const gfloat *n1 = ROW (y + 1);
+      const gfloat *n2 = ROW (MIN (y + 2, h - 1));
+      const gfloat *n3 = ROW (MIN (y + 3, h - 1));
+
+      for (x = x0; x < x1; x++)
+        t[x] = c[0] * t[x] + c[1] * n1[x] + c[2] * n2[x] + c[3] * n3[x];
     }
 
-    tmp_in_pos = gb->tempim + (rr * gb->stride);
-    out_row = out_image + r * gb->stride;
+    for (x = x0; x < x1; x++)
+      out[x] = (guint8) CLAMP (t[x] + 0.5f, 0, 255);
+  }
+#undef ROW
+}
+
+static void
+gaussian_smooth_band (GstGaussianBlur * gb, guint band)
+{
+  gint n;
+
+  if (gb->pass == PASS_IIR_VERTICAL) {
+    /* in whole cache lines of the float rows */
+    n = gb->width * 4;
+    gaussian_smooth_iir_columns (gb,
+        band == 0 ? 0 : ((guint64) n * band / gb->n_bands) & ~15,
+        band == gb->n_bands - 1 ? n :
+        ((guint64) n * (band + 1) / gb->n_bands) & ~15);
+    return;
+  }
+
+  n = gb->height;
+  if (gb->pass == PASS_IIR_HORIZONTAL)
+    gaussian_smooth_iir_rows (gb, (guint64) n * band / gb->n_bands,
+        (guint64) n * (band + 1) / gb->n_bands);
+  else
+    gaussian_smooth_fir (gb, band, (guint64) n * band / gb->n_bands,
+        (guint64) n * (band + 1) / gb->n_bands);
+}
+
+static void
+gst_gaussianblur_band_func (gpointer data, gpointer user_data)
+{
+  GstGaussianBlur *gb = GST_GAUSSIANBLUR (user_data);
+
+  gaussian_smooth_band (gb, GPOINTER_TO_UINT (data) - 1);
+
+  g_mutex_lock (&gb->lock);
+  if (--gb->pending_bands == 0)
+    g_cond_signal (&gb->cond);
+  g_mutex_unlock (&gb->lock);
+}
+
+/* runs @pass on all the bands, the streaming thread handling the first
+ * one */
+static void
+gaussian_smooth_run (GstGaussianBlur * gb, gint pass)
+{
+  guint i;
 
-    for (c = 0; c < gb->width; c++) {
-      float *tmp = tmp_in_pos;
+  gb->pass = pass;
 
-      dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-      for (k = kmin; k < kmax; k++, tmp += gb->stride) {
-        float kern = gb->kernel[k];
-        dot[0] += tmp[0] * kern;
-        dot[1] += tmp[1] * kern;
-        dot[2] += tmp[2] * kern;
-        dot[3] += tmp[3] * kern;
-      }
+  if (gb->n_bands > 1) {
+    gb->pending_bands = gb->n_bands - 1;
+    for (i = 1; i < gb->n_bands; i++)
+      g_thread_pool_push (gb->pool, GUINT_TO_POINTER (i + 1), NULL);
+  }
 
-      *out_row++ = (guint8) CLAMP ((dot[0] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[1] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[2] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[3] / sum + 0.5), 0, 255);
+  gaussian_smooth_band (gb, 0);
 
-      tmp_in_pos += 4;
+  if (gb->n_bands > 1) {
+    g_mutex_lock (&gb->lock);
+    while (gb->pending_bands > 0)
+      g_cond_wait (&gb->cond, &gb->lock);
+    g_mutex_unlock (&gb->lock);
+  }
+}
+
+static void
+gaussian_smooth (GstGaussianBlur * gb)
+{
+  guint n_bands;
+
+  n_bands = gb->n_threads;
+  if (n_bands == 0)
+    n_bands = g_get_num_processors ();
+  /* at least 16 rows and 64 components per band */
+  n_bands = MIN (n_bands, MAX (1, MIN (gb->height / 16, gb->width / 16)));
+  if (gb->pool == NULL)
+    n_bands = 1;
+  gb->n_bands = n_bands;
+  if (n_bands > 1)
+    g_thread_pool_set_max_threads (gb->pool, n_bands - 1, NULL);
+
+  if (gb->use_iir) {
+    if (gb->tempim == NULL)
+      gb->tempim = g_new (gfloat, (gsize) gb->width * 4 * gb->height);
+    gaussian_smooth_run (gb, PASS_IIR_HORIZONTAL);
+    gaussian_smooth_run (gb, PASS_IIR_VERTICAL);
+  } else {
+    /* only reallocated when it grows */
+    gb->band_tmp_size = gaussian_band_tmp_size (gb);
+    if (gb->band_tmp_size * n_bands > gb->band_tmp_alloc) {
+      g_free (gb->band_tmp);
+      gb->band_tmp_alloc = gb->band_tmp_size * n_bands;
+      gb->band_tmp = g_malloc (gb->band_tmp_alloc);
     }
+    gaussian_smooth_run (gb, PASS_FIR);
   }
 }
 
@@ -359,7 +603,7 @@ gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
 static gboolean
 make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
 {
-  int i, center, left, right;
+  int i, center, left, right, fixed_sum;
   float sum, sum2;
   const float fe = -0.5 / (sigma * sigma);
   const float dx = 1.0 / (sigma * sqrt (2 * G_PI));
@@ -369,12 +613,31 @@ make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
 
   gb->kernel = g_new (float, gb->windowsize);
   gb->kernel_sum = g_new (float, gb->windowsize);
-  if (gb->kernel == NULL || gb->kernel_sum == NULL)
+  gb->kernel_fixed = g_new (gint16, gb->windowsize);
+  if (gb->kernel == NULL || gb->kernel_sum == NULL || gb->kernel_fixed == NULL)
     return FALSE;
 
+  gb->use_iir = sigma > GAUSS_IIR_MIN_SIGMA;
+  if (gb->use_iir) {
+    /* Young and van Vliet, "Recursive implementation of the Gaussian
+     * filter", 1995 */
+    gdouble q = 0.98711 * sigma - 0.96330;
+    gdouble b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q +
+        0.422205 * q * q * q;
+    gdouble b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+    gdouble b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+    gdouble b3 = 0.422205 * q * q * q;
+
+    gb->iir_coeffs[0] = 1.0 - (b1 + b2 + b3) / b0;
+    gb->iir_coeffs[1] = b1 / b0;
+    gb->iir_coeffs[2] = b2 / b0;
+    gb->iir_coeffs[3] = b3 / b0;
+  }
+
   if (gb->windowsize == 1) {
     gb->kernel[0] = 1.0;
     gb->kernel_sum[0] = 1.0;
+    gb->kernel_fixed[0] = 1 << GAUSS_KERNEL_BITS;
     return TRUE;
   }
 
@@ -404,6 +667,15 @@ make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
     gb->kernel_sum[i] = sum2;
   }
 
+  /* rounded so that the kernel sums exactly to 1 */
+  fixed_sum = 0;
+  for (i = 0; i < gb->windowsize; i++) {
+    gb->kernel_fixed[i] = (gint16) floor (gb->kernel[i] *
+        (1 << GAUSS_KERNEL_BITS) + 0.5);
+    fixed_sum += gb->kernel_fixed[i];
+  }
+  gb->kernel_fixed[center] += (1 << GAUSS_KERNEL_BITS) - fixed_sum;
+
 #if 0
   g_print ("Sigma %f: ", sigma);
   for (i = 0; i < gb->windowsize; i++)
@@ -430,6 +702,9 @@ gst_gaussianblur_set_property (GObject * object,
       gb->sigma = g_value_get_double (value);
       GST_OBJECT_UNLOCK (object);
       break;
+    case PROP_N_THREADS:
+      gb->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -447,6 +722,9 @@ gst_gaussianblur_get_property (GObject * object,
       g_value_set_double (value, gb->sigma);
       GST_OBJECT_UNLOCK (gb);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, gb->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
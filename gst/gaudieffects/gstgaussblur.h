@@ -73,6 +73,30 @@ struct _GstGaussianBlur
   float *kernel_sum;
   float *tempim;
   gint16 *smoothedim;
+
+  /* the kernel in fixed point, see GAUSS_KERNEL_BITS */
+  gint16 *kernel_fixed;
+  /* a recursive filter replaces the kernel for large sigmas */
+  gboolean use_iir;
+  gfloat iir_coeffs[4];
+
+  guint n_threads;
+  GThreadPool *pool;
+  guint n_bands;
+  GMutex lock;
+  GCond cond;
+  guint pending_bands;
+
+  /* scratch buffers of the bands */
+  guint8 *band_tmp;
+  gsize band_tmp_size;
+  gsize band_tmp_alloc;
+
+  /* the frame being processed */
+  gint pass;
+  const guint8 *src;
+  guint8 *dest;
+  gint src_stride, dest_stride;
 };
 
 struct _GstGaussianBlurClass
@@ -138,20 +138,24 @@ static guint16 gst_dp_crc_from_memory_maps (const GstMapInfo * maps,
 
 /* payloading functions */
 
-GstBuffer *
-gst_dp_payload_buffer (GstBuffer * buffer, GstDPHeaderFlag flags)
+/**
+ * gst_dp_write_buffer_header:
+ * @buffer: the #GstBuffer to make a header for
+ * @flags: the #GstDPHeaderFlag to create the header with
+ * @h: where to write the GST_DP_HEADER_LENGTH bytes of the header
+ *
+ * Writes the GDP header for @buffer, which must then be sent followed by
+ * the data of @buffer.
+ */
+void
+gst_dp_write_buffer_header (GstBuffer * buffer, GstDPHeaderFlag flags,
+    guint8 * h)
 {
-  GstBuffer *ret_buf;
-  GstMapInfo map;
-  GstMemory *mem;
-  guint8 *h;
   guint16 flags_mask;
   guint16 header_crc = 0, crc = 0;
   gsize buffer_size;
 
-  mem = gst_allocator_alloc (NULL, GST_DP_HEADER_LENGTH, NULL);
-  gst_memory_map (mem, &map, GST_MAP_READWRITE);
-  h = memset (map.data, 0, map.size);
+  memset (h, 0, GST_DP_HEADER_LENGTH);
 
   /* version, flags, type */
   GST_DP_INIT_HEADER (h, GST_DP_VERSION_1_0, flags, GST_DP_PAYLOAD_BUFFER);
@@ -213,6 +217,18 @@ gst_dp_payload_buffer (GstBuffer * buffer, GstDPHeaderFlag flags)
   GST_WRITE_UINT16_BE (h + 60, crc);
 
   GST_MEMDUMP ("payload header for buffer", h, GST_DP_HEADER_LENGTH);
+}
+
+GstBuffer *
+gst_dp_payload_buffer (GstBuffer * buffer, GstDPHeaderFlag flags)
+{
+  GstBuffer *ret_buf;
+  GstMapInfo map;
+  GstMemory *mem;
+
+  mem = gst_allocator_alloc (NULL, GST_DP_HEADER_LENGTH, NULL);
+  gst_memory_map (mem, &map, GST_MAP_READWRITE);
+  gst_dp_write_buffer_header (buffer, flags, map.data);
   gst_memory_unmap (mem, &map);
 
   ret_buf = gst_buffer_new ();
@@ -375,22 +391,68 @@ static const guint16 gst_dp_crc_table[256] = {
  *
  * Returns: a two-byte CRC checksum.
  */
+/* gst_dp_crc_tables[k][x] is the CRC register contribution of byte x
+ * followed by k zero bytes, so that 8 bytes can be processed with 8 table
+ * lookups and no dependency between them ("slicing-by-8") */
+static guint16 gst_dp_crc_tables[8][256];
+
+static gpointer
+gst_dp_crc_init_tables (gpointer data)
+{
+  guint k, x;
+
+  for (x = 0; x < 256; x++)
+    gst_dp_crc_tables[0][x] = gst_dp_crc_table[x];
+
+  for (k = 1; k < 8; k++) {
+    for (x = 0; x < 256; x++) {
+      guint16 prev = gst_dp_crc_tables[k - 1][x];
+
+      gst_dp_crc_tables[k][x] = (guint16) ((prev << 8) ^
+          gst_dp_crc_table[(prev >> 8) & 0x00ff]);
+    }
+  }
+
+  return NULL;
+}
+
 static guint16
-gst_dp_crc (const guint8 * buffer, guint length)
+gst_dp_crc_update (guint16 crc_register, const guint8 * buffer, gsize length)
 {
-  guint16 crc_register = CRC_INIT;
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, gst_dp_crc_init_tables, NULL);
+
+  while (length >= 8) {
+    crc_register =
+        gst_dp_crc_tables[7][(crc_register >> 8) ^ buffer[0]] ^
+        gst_dp_crc_tables[6][(crc_register & 0x00ff) ^ buffer[1]] ^
+        gst_dp_crc_tables[5][buffer[2]] ^
+        gst_dp_crc_tables[4][buffer[3]] ^
+        gst_dp_crc_tables[3][buffer[4]] ^
+        gst_dp_crc_tables[2][buffer[5]] ^
+        gst_dp_crc_tables[1][buffer[6]] ^ gst_dp_crc_tables[0][buffer[7]];
+    buffer += 8;
+    length -= 8;
+  }
+
+  while (length-- > 0) {
+    crc_register = (guint16) ((crc_register << 8) ^
+        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
+  }
 
+  return crc_register;
+}
+
+static guint16
+gst_dp_crc (const guint8 * buffer, guint length)
+{
   if (length == 0)
     return 0;
 
   g_assert (buffer != NULL);
 
-  /* calc CRC */
-  for (; length--;) {
-    crc_register = (guint16) ((crc_register << 8) ^
-        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-  }
-  return (0xffff ^ crc_register);
+  return (0xffff ^ gst_dp_crc_update (CRC_INIT, buffer, length));
 }
 
 static guint16
@@ -406,15 +468,8 @@ gst_dp_crc_from_memory_maps (const GstMapInfo * maps, guint n_maps)
 
   /* calc CRC */
   while (n_maps > 0) {
-    guint8 *buffer = maps->data;
-    gsize length = maps->size;
-
-    total_length += length;
-
-    while (length-- > 0) {
-      crc_register = (guint16) ((crc_register << 8) ^
-          gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-    }
+    total_length += maps->size;
+    crc_register = gst_dp_crc_update (crc_register, maps->data, maps->size);
     --n_maps;
     ++maps;
   }
@@ -92,6 +92,10 @@ GstEvent *      gst_dp_event_from_packet        (guint header_length,
 GstBuffer *     gst_dp_payload_buffer           (GstBuffer      * buffer,
                                                  GstDPHeaderFlag  flags);
 
+void            gst_dp_write_buffer_header      (GstBuffer      * buffer,
+                                                 GstDPHeaderFlag  flags,
+                                                 guint8         * h);
+
 GstBuffer *     gst_dp_payload_caps             (const GstCaps  * caps,
                                                  GstDPHeaderFlag  flags);
 
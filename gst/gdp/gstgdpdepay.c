@@ -154,7 +154,6 @@ gst_gdp_depay_finalize (GObject * gobject)
   this = GST_GDP_DEPAY (gobject);
   if (this->caps)
     gst_caps_unref (this->caps);
-  g_free (this->header);
   gst_adapter_clear (this->adapter);
   g_object_unref (this->adapter);
   if (this->allocator)
@@ -288,28 +287,22 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     switch (this->state) {
       case GST_GDP_DEPAY_STATE_HEADER:
       {
-        guint8 *header;
-
         /* collect a complete header, validate and store the header. Figure out
          * the payload length and switch to the PAYLOAD state */
         available = gst_adapter_available (this->adapter);
         if (available < GST_DP_HEADER_LENGTH)
           goto done;
 
+        /* the header is kept, we need it to make the payload */
         GST_LOG_OBJECT (this, "reading GDP header from adapter");
-        header = gst_adapter_take (this->adapter, GST_DP_HEADER_LENGTH);
-        if (!gst_dp_validate_header (GST_DP_HEADER_LENGTH, header)) {
-          g_free (header);
+        gst_adapter_copy (this->adapter, this->header, 0, GST_DP_HEADER_LENGTH);
+        gst_adapter_flush (this->adapter, GST_DP_HEADER_LENGTH);
+        if (!gst_dp_validate_header (GST_DP_HEADER_LENGTH, this->header))
           goto header_validate_error;
-        }
 
-        /* store types and payload length. Also store the header, which we need
-         * to make the payload. */
-        this->payload_length = gst_dp_header_payload_length (header);
-        this->payload_type = gst_dp_header_payload_type (header);
-        /* free previous header and store new one. */
-        g_free (this->header);
-        this->header = header;
+        /* store types and payload length */
+        this->payload_length = gst_dp_header_payload_length (this->header);
+        this->payload_type = gst_dp_header_payload_type (this->header);
 
         GST_LOG_OBJECT (this,
             "read GDP header, payload size %d, payload type %d, switching to state PAYLOAD",
@@ -340,7 +333,10 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           goto wrong_type;
         }
 
-        if (this->payload_length) {
+        /* buffer payloads are validated once copied into their buffer, to
+         * avoid merging them in the adapter first */
+        if (this->payload_length &&
+            this->payload_type != GST_DP_PAYLOAD_BUFFER) {
           const guint8 *data;
           gboolean res;
 
@@ -371,12 +367,20 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         /* now take the payload if there is any */
         if (this->payload_length > 0) {
           GstMapInfo map;
+          gboolean res;
 
-          gst_buffer_map (buf, &map, GST_MAP_WRITE);
+          gst_buffer_map (buf, &map, GST_MAP_READWRITE);
           gst_adapter_copy (this->adapter, map.data, 0, this->payload_length);
+          res = gst_dp_validate_payload (GST_DP_HEADER_LENGTH, this->header,
+              map.data);
           gst_buffer_unmap (buf, &map);
 
           gst_adapter_flush (this->adapter, this->payload_length);
+
+          if (!res) {
+            gst_buffer_unref (buf);
+            goto payload_validate_error;
+          }
         }
 
         if (GST_BUFFER_TIMESTAMP (buf) > -this->ts_offset)
@@ -23,6 +23,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
 
+#include "dataprotocol.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_GDP_DEPAY \
@@ -63,7 +65,7 @@ struct _GstGDPDepay
   GstGDPDepayState state;
   GstCaps *caps;
 
-  guint8 *header;
+  guint8 header[GST_DP_HEADER_LENGTH];
   guint32 payload_length;
   GstDPPayloadType payload_type;
 
@@ -58,12 +58,14 @@ GST_DEBUG_CATEGORY_STATIC (gst_gdp_pay_debug);
 
 #define DEFAULT_CRC_HEADER TRUE
 #define DEFAULT_CRC_PAYLOAD FALSE
+#define DEFAULT_BUFFER_LIST FALSE
 
 enum
 {
   PROP_0,
   PROP_CRC_HEADER,
-  PROP_CRC_PAYLOAD
+  PROP_CRC_PAYLOAD,
+  PROP_BUFFER_LIST
 };
 
 #define _do_init \
@@ -76,6 +78,8 @@ static void gst_gdp_pay_reset (GstGDPPay * this);
 
 static GstFlowReturn gst_gdp_pay_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_gdp_pay_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list);
 static gboolean gst_gdp_pay_src_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_gdp_pay_sink_event (GstPad * pad, GstObject * parent,
@@ -112,6 +116,19 @@ gst_gdp_pay_class_init (GstGDPPayClass * klass)
       g_param_spec_boolean ("crc-payload", "CRC Payload",
           "Calculate and store a CRC checksum on the payload",
           DEFAULT_CRC_PAYLOAD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstGDPPay:buffer-list:
+   *
+   * Push the GDP header and the payload of each buffer as separate buffers
+   * in a buffer list instead of merging them into one buffer. The headers
+   * come from a buffer pool, and the payload memory is not copied.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_LIST,
+      g_param_spec_boolean ("buffer-list", "Buffer List",
+          "Push header and payload as separate buffers in a buffer list",
+          DEFAULT_BUFFER_LIST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   gst_element_class_set_static_metadata (gstelement_class,
       "GDP Payloader", "GDP/Payloader",
       "Payloads GStreamer Data Protocol buffers",
@@ -132,6 +149,8 @@ gst_gdp_pay_init (GstGDPPay * gdppay)
       gst_pad_new_from_static_template (&gdp_pay_sink_template, "sink");
   gst_pad_set_chain_function (gdppay->sinkpad,
       GST_DEBUG_FUNCPTR (gst_gdp_pay_chain));
+  gst_pad_set_chain_list_function (gdppay->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gdp_pay_chain_list));
   gst_pad_set_event_function (gdppay->sinkpad,
       GST_DEBUG_FUNCPTR (gst_gdp_pay_sink_event));
   gst_element_add_pad (GST_ELEMENT (gdppay), gdppay->sinkpad);
@@ -145,6 +164,7 @@ gst_gdp_pay_init (GstGDPPay * gdppay)
   gdppay->crc_header = DEFAULT_CRC_HEADER;
   gdppay->crc_payload = DEFAULT_CRC_PAYLOAD;
   gdppay->header_flag = gdppay->crc_header | gdppay->crc_payload;
+  gdppay->buffer_list = DEFAULT_BUFFER_LIST;
   gdppay->offset = 0;
 }
 
@@ -183,6 +203,12 @@ gst_gdp_pay_reset (GstGDPPay * this)
   this->sent_streamheader = FALSE;
   this->reset_streamheader = FALSE;
   this->offset = 0;
+
+  if (this->header_pool) {
+    gst_buffer_pool_set_active (this->header_pool, FALSE);
+    gst_object_unref (this->header_pool);
+    this->header_pool = NULL;
+  }
 }
 
 /* set OFFSET and OFFSET_END with running count */
@@ -206,6 +232,55 @@ gst_gdp_pay_buffer_from_buffer (GstGDPPay * this, GstBuffer * buffer)
   return gst_dp_payload_buffer (buffer, this->header_flag);
 }
 
+/* appends a pooled GDP header for @buffer and @buffer itself to @list */
+static gboolean
+gst_gdp_pay_add_buffer_to_list (GstGDPPay * this, GstBuffer * buffer,
+    GstBufferList * list)
+{
+  GstBuffer *header;
+  GstMapInfo map;
+
+  if (!this->header_pool) {
+    GstStructure *config;
+
+    this->header_pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (this->header_pool);
+    gst_buffer_pool_config_set_params (config, NULL, GST_DP_HEADER_LENGTH, 0,
+        0);
+    if (!gst_buffer_pool_set_config (this->header_pool, config) ||
+        !gst_buffer_pool_set_active (this->header_pool, TRUE)) {
+      gst_object_unref (this->header_pool);
+      this->header_pool = NULL;
+      return FALSE;
+    }
+  }
+
+  if (gst_buffer_pool_acquire_buffer (this->header_pool, &header,
+          NULL) != GST_FLOW_OK)
+    return FALSE;
+
+  gst_buffer_map (header, &map, GST_MAP_WRITE);
+  gst_dp_write_buffer_header (buffer, this->header_flag, map.data);
+  gst_buffer_unmap (header, &map);
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER))
+    GST_BUFFER_FLAG_SET (header, GST_BUFFER_FLAG_HEADER);
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    GST_BUFFER_FLAG_SET (header, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  /* the offsets of the header cover the payload that follows it */
+  GST_BUFFER_OFFSET (header) = this->offset;
+  this->offset += GST_DP_HEADER_LENGTH + gst_buffer_get_size (buffer);
+  GST_BUFFER_OFFSET_END (header) = this->offset;
+  GST_BUFFER_TIMESTAMP (header) = GST_BUFFER_TIMESTAMP (buffer);
+  GST_BUFFER_DURATION (header) = GST_BUFFER_DURATION (buffer);
+
+  gst_buffer_list_add (list, header);
+  gst_buffer_list_add (list, gst_buffer_ref (buffer));
+
+  return TRUE;
+}
+
 static GstBuffer *
 gst_gdp_buffer_from_event (GstGDPPay * this, GstEvent * event)
 {
@@ -459,6 +534,18 @@ gst_gdp_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (!this->caps)
     goto no_caps;
 
+  if (this->buffer_list && this->sent_streamheader &&
+      !this->reset_streamheader) {
+    GstBufferList *list = gst_buffer_list_new_sized (2);
+
+    if (!gst_gdp_pay_add_buffer_to_list (this, buffer, list)) {
+      gst_buffer_list_unref (list);
+      goto no_buffer;
+    }
+    ret = gst_pad_push_list (this->srcpad, list);
+    goto done;
+  }
+
   /* create a GDP header packet,
    * then create a GST buffer of the header packet and the buffer contents */
   outbuffer = gst_gdp_pay_buffer_from_buffer (this, buffer);
@@ -507,6 +594,44 @@ no_buffer:
   }
 }
 
+static GstFlowReturn
+gst_gdp_pay_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstGDPPay *this = GST_GDP_PAY (parent);
+  GstBufferList *outlist;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+
+  /* outside of the steady state, let the buffer path deal with segments,
+   * caps and streamheaders */
+  if (!this->buffer_list || !this->have_segment || !this->caps ||
+      !this->sent_streamheader || this->reset_streamheader) {
+    for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+      ret = gst_gdp_pay_chain (pad, parent,
+          gst_buffer_ref (gst_buffer_list_get (list, i)));
+    gst_buffer_list_unref (list);
+    return ret;
+  }
+
+  outlist = gst_buffer_list_new_sized (2 * len);
+  for (i = 0; i < len; i++) {
+    if (!gst_gdp_pay_add_buffer_to_list (this, gst_buffer_list_get (list, i),
+            outlist)) {
+      GST_ELEMENT_ERROR (this, STREAM, ENCODE, (NULL),
+          ("Could not create GDP buffer from buffer"));
+      gst_buffer_list_unref (outlist);
+      gst_buffer_list_unref (list);
+      return GST_FLOW_ERROR;
+    }
+  }
+  gst_buffer_list_unref (list);
+
+  GST_LOG_OBJECT (this, "Pushing list of %u GDP buffers", len);
+  return gst_pad_push_list (this->srcpad, outlist);
+}
+
 static gboolean
 gst_gdp_pay_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -655,6 +780,9 @@ gst_gdp_pay_set_property (GObject * object, guint prop_id,
           g_value_get_boolean (value) ? GST_DP_HEADER_FLAG_CRC_PAYLOAD : 0;
       this->header_flag = this->crc_header | this->crc_payload;
       break;
+    case PROP_BUFFER_LIST:
+      this->buffer_list = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -677,6 +805,9 @@ gst_gdp_pay_get_property (GObject * object, guint prop_id,
     case PROP_CRC_PAYLOAD:
       g_value_set_boolean (value, this->crc_payload);
       break;
+    case PROP_BUFFER_LIST:
+      g_value_set_boolean (value, this->buffer_list);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -65,6 +65,9 @@ struct _GstGDPPay
   gboolean crc_header;
   gboolean crc_payload;
   GstDPHeaderFlag header_flag;
+
+  gboolean buffer_list;
+  GstBufferPool *header_pool; /* GDP headers in buffer-list mode */
 };
 
 struct _GstGDPPayClass
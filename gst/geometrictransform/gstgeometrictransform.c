@@ -49,7 +49,8 @@ static GstVideoFilterClass *parent_class = NULL;
 enum
 {
   PROP_0,
-  PROP_OFF_EDGE_PIXELS
+  PROP_OFF_EDGE_PIXELS,
+  PROP_N_THREADS
 };
 
 #define GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE ( \
@@ -75,6 +76,60 @@ gst_geometric_transform_off_edges_pixels_method_get_type (void)
 }
 
 #define DEFAULT_OFF_EDGE_PIXELS GST_GT_OFF_EDGES_PIXELS_IGNORE
+#define DEFAULT_N_THREADS 1
+
+#define MAP_ONE (1 << GST_GT_MAP_FRAC_BITS)
+
+/* the output is remapped in tiles of this size, so that the input pixels
+ * of neighbouring output pixels are likely to still be in the cache */
+#define TILE_WIDTH 64
+#define TILE_HEIGHT 64
+
+/* must be called with the object lock */
+static void
+gst_geometric_transform_make_entry (GstGeometricTransform * gt,
+    gdouble in_x, gdouble in_y, GstGeometricTransformMapEntry * entry)
+{
+  gint fixed_x, fixed_y;
+  gint int_x, int_y;
+
+  /* operate on out of edge pixels */
+  switch (gt->off_edge_pixels) {
+    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
+      in_x = CLAMP (in_x, 0, gt->width - 1);
+      in_y = CLAMP (in_y, 0, gt->height - 1);
+      break;
+
+    case GST_GT_OFF_EDGES_PIXELS_WRAP:
+      in_x = gst_gm_mod_float (in_x, gt->width);
+      in_y = gst_gm_mod_float (in_y, gt->height);
+      if (in_x < 0)
+        in_x += gt->width;
+      if (in_y < 0)
+        in_y += gt->height;
+      break;
+
+    default:
+      break;
+  }
+
+  /* only map the pixels whose truncated position is valid, written so
+   * that NaN is rejected too */
+  if (!(in_x > -1.0 && in_x < gt->width && in_y > -1.0 && in_y < gt->height)) {
+    entry->offset = -1;
+    entry->frac_x = entry->frac_y = 0;
+    return;
+  }
+
+  fixed_x = (gint) (MAX (in_x, 0.0) * MAP_ONE);
+  fixed_y = (gint) (MAX (in_y, 0.0) * MAP_ONE);
+  int_x = fixed_x >> GST_GT_MAP_FRAC_BITS;
+  int_y = fixed_y >> GST_GT_MAP_FRAC_BITS;
+
+  entry->offset = int_y * gt->row_stride + int_x * gt->pixel_stride;
+  entry->frac_x = int_x < gt->width - 1 ? fixed_x & (MAP_ONE - 1) : 0;
+  entry->frac_y = int_y < gt->height - 1 ? fixed_y & (MAP_ONE - 1) : 0;
+}
 
 /* must be called with the object lock */
 static gboolean
@@ -84,7 +139,7 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   gdouble in_x, in_y;
   gboolean ret = TRUE;
   GstGeometricTransformClass *klass;
-  gdouble *ptr;
+  GstGeometricTransformMapEntry *ptr;
 
   GST_INFO_OBJECT (gt, "Generating new transform map");
 
@@ -98,9 +153,9 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   g_return_val_if_fail (klass->map_func, FALSE);
 
   /*
-   * (x,y) pairs of the inverse mapping
+   * fixed point input positions of the inverse mapping
    */
-  gt->map = g_malloc0 (sizeof (gdouble) * gt->width * gt->height * 2);
+  gt->map = g_new (GstGeometricTransformMapEntry, gt->width * gt->height);
   ptr = gt->map;
 
   for (y = 0; y < gt->height; y++) {
@@ -111,9 +166,8 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
         goto end;
       }
 
-      ptr[0] = in_x;
-      ptr[1] = in_y;
-      ptr += 2;
+      gst_geometric_transform_make_entry (gt, in_x, in_y, ptr);
+      ptr++;
     }
   }
 
@@ -145,6 +199,7 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
 
   gt->width = in_info->width;
   gt->height = in_info->height;
+  gt->format = GST_VIDEO_INFO_FORMAT (in_info);
   gt->row_stride = in_info->stride[0];
   gt->pixel_stride = GST_VIDEO_INFO_COMP_PSTRIDE (in_info, 0);
 
@@ -164,48 +219,105 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   return ret;
 }
 
-static void
-gst_geometric_transform_do_map (GstGeometricTransform * gt, guint8 * in_data,
-    guint8 * out_data, gint x, gint y, gdouble in_x, gdouble in_y)
+static inline guint
+interpolate (guint p00, guint p10, guint p01, guint p11, guint fx, guint fy)
 {
-  gint in_offset;
-  gint out_offset;
+  /* fits in 32 bits for 16 bits samples */
+  guint top = p00 * (MAP_ONE - fx) + p10 * fx;
+  guint bottom = p01 * (MAP_ONE - fx) + p11 * fx;
 
-  out_offset = y * gt->row_stride + x * gt->pixel_stride;
+  return (top * (MAP_ONE - fy) + bottom * fy +
+      (1 << (2 * GST_GT_MAP_FRAC_BITS - 1))) >> (2 * GST_GT_MAP_FRAC_BITS);
+}
 
-  /* operate on out of edge pixels */
-  switch (gt->off_edge_pixels) {
-    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
-      in_x = CLAMP (in_x, 0, gt->width - 1);
-      in_y = CLAMP (in_y, 0, gt->height - 1);
-      break;
+static inline void
+gst_geometric_transform_do_map (GstGeometricTransform * gt,
+    const guint8 * in_data, guint8 * out,
+    const GstGeometricTransformMapEntry * entry)
+{
+  const guint8 *p00, *p10, *p01, *p11;
+  guint fx, fy;
+  gint i;
 
-    case GST_GT_OFF_EDGES_PIXELS_WRAP:
-      in_x = gst_gm_mod_float (in_x, gt->width);
-      in_y = gst_gm_mod_float (in_y, gt->height);
-      if (in_x < 0)
-        in_x += gt->width;
-      if (in_y < 0)
-        in_y += gt->height;
-      break;
+  /* off edges pixels are left as they are */
+  if (entry->offset < 0)
+    return;
 
+  p00 = in_data + entry->offset;
+  fx = entry->frac_x;
+  fy = entry->frac_y;
+
+  if (fx == 0 && fy == 0) {
+    memcpy (out, p00, gt->pixel_stride);
+    return;
+  }
+
+  /* bilinear interpolation */
+  p10 = fx ? p00 + gt->pixel_stride : p00;
+  p01 = fy ? p00 + gt->row_stride : p00;
+  p11 = fx ? p01 + gt->pixel_stride : p01;
+
+  switch (gt->format) {
+    case GST_VIDEO_FORMAT_GRAY16_LE:
+      GST_WRITE_UINT16_LE (out, interpolate (GST_READ_UINT16_LE (p00),
+              GST_READ_UINT16_LE (p10), GST_READ_UINT16_LE (p01),
+              GST_READ_UINT16_LE (p11), fx, fy));
+      break;
+    case GST_VIDEO_FORMAT_GRAY16_BE:
+      GST_WRITE_UINT16_BE (out, interpolate (GST_READ_UINT16_BE (p00),
+              GST_READ_UINT16_BE (p10), GST_READ_UINT16_BE (p01),
+              GST_READ_UINT16_BE (p11), fx, fy));
+      break;
     default:
+      for (i = 0; i < gt->pixel_stride; i++)
+        out[i] = interpolate (p00[i], p10[i], p01[i], p11[i], fx, fy);
       break;
   }
+}
 
-  {
-    gint trunc_x = (gint) in_x;
-    gint trunc_y = (gint) in_y;
-    /* only set the values if the values are valid */
-    if (trunc_x >= 0 && trunc_x < gt->width && trunc_y >= 0 &&
-        trunc_y < gt->height) {
-      in_offset = trunc_y * gt->row_stride + trunc_x * gt->pixel_stride;
-
-      memcpy (out_data + out_offset, in_data + in_offset, gt->pixel_stride);
+/* called with the object lock held by the streaming thread */
+static void
+gst_geometric_transform_remap_band (GstGeometricTransform * gt, gint band)
+{
+  gint y_start = gt->height * band / gt->n_bands;
+  gint y_end = gt->height * (band + 1) / gt->n_bands;
+  gint tile_x, tile_y, x, y;
+
+  for (tile_y = y_start; tile_y < y_end; tile_y += TILE_HEIGHT) {
+    gint tile_end_y = MIN (tile_y + TILE_HEIGHT, y_end);
+
+    for (tile_x = 0; tile_x < gt->width; tile_x += TILE_WIDTH) {
+      gint tile_width = MIN (TILE_WIDTH, gt->width - tile_x);
+
+      for (y = tile_y; y < tile_end_y; y++) {
+        const GstGeometricTransformMapEntry *entry =
+            gt->map + y * gt->width + tile_x;
+        guint8 *out = gt->out_data + y * gt->row_stride +
+            tile_x * gt->pixel_stride;
+
+        for (x = 0; x < tile_width; x++) {
+          gst_geometric_transform_do_map (gt, gt->in_data, out, entry);
+          entry++;
+          out += gt->pixel_stride;
+        }
+      }
     }
   }
 }
 
+static void
+gst_geometric_transform_remap_func (gpointer data, gpointer user_data)
+{
+  GstGeometricTransform *gt = user_data;
+
+  gst_geometric_transform_remap_band (gt, GPOINTER_TO_INT (data) - 1);
+
+  g_mutex_lock (&gt->lock);
+  if (--gt->pending_bands == 0)
+    g_cond_signal (&gt->cond);
+  g_mutex_unlock (&gt->lock);
+}
+
 static void
 gst_geometric_transform_before_transform (GstBaseTransform * trans,
     GstBuffer * outbuf)
@@ -231,7 +343,6 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
   GstGeometricTransformClass *klass;
   gint x, y, i;
   GstFlowReturn ret = GST_FLOW_OK;
-  gdouble *ptr;
   guint8 *in_data;
   guint8 *out_data;
 
@@ -261,24 +372,38 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
         }
       gst_geometric_transform_generate_map (gt);
     }
-    g_return_val_if_fail (gt->map, GST_FLOW_ERROR);
-    ptr = gt->map;
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        /* do the mapping */
-        gst_geometric_transform_do_map (gt, in_data, out_data, x, y, ptr[0],
-            ptr[1]);
-        ptr += 2;
-      }
+    if (!gt->map) {
+      ret = GST_FLOW_ERROR;
+      goto end;
+    }
+
+    gt->in_data = in_data;
+    gt->out_data = out_data;
+
+    if (gt->pool) {
+      gt->pending_bands = gt->n_bands - 1;
+      for (i = 1; i < gt->n_bands; i++)
+        g_thread_pool_push (gt->pool, GINT_TO_POINTER (i + 1), NULL);
+
+      gst_geometric_transform_remap_band (gt, 0);
+
+      g_mutex_lock (&gt->lock);
+      while (gt->pending_bands > 0)
+        g_cond_wait (&gt->cond, &gt->lock);
+      g_mutex_unlock (&gt->lock);
+    } else {
+      gst_geometric_transform_remap_band (gt, 0);
     }
   } else {
     for (y = 0; y < gt->height; y++) {
       for (x = 0; x < gt->width; x++) {
+        GstGeometricTransformMapEntry entry;
         gdouble in_x, in_y;
 
         if (klass->map_func (gt, x, y, &in_x, &in_y)) {
-          gst_geometric_transform_do_map (gt, in_data, out_data, x, y, in_x,
-              in_y);
+          gst_geometric_transform_make_entry (gt, in_x, in_y, &entry);
+          gst_geometric_transform_do_map (gt, in_data,
+              out_data + y * gt->row_stride + x * gt->pixel_stride, &entry);
         } else {
           GST_WARNING_OBJECT (gt, "Failed to do mapping for %d %d", x, y);
           ret = GST_FLOW_ERROR;
@@ -304,8 +429,13 @@ gst_geometric_transform_set_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       GST_OBJECT_LOCK (gt);
       gt->off_edge_pixels = g_value_get_enum (value);
+      /* the map has the off edge pixels handling applied */
+      gst_geometric_transform_set_need_remap (gt);
       GST_OBJECT_UNLOCK (gt);
       break;
+    case PROP_N_THREADS:
+      gt->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -324,18 +454,62 @@ gst_geometric_transform_get_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       g_value_set_enum (value, gt->off_edge_pixels);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, gt->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_geometric_transform_finalize (GObject * object)
+{
+  GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (object);
+
+  g_mutex_clear (&gt->lock);
+  g_cond_clear (&gt->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+gst_geometric_transform_start (GstBaseTransform * trans)
+{
+  GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (trans);
+
+  gt->n_bands = gt->n_threads;
+  if (gt->n_bands == 0)
+    gt->n_bands = g_get_num_processors ();
+
+  /* the streaming thread remaps one of the bands itself */
+  if (gt->n_bands > 1) {
+    GError *err = NULL;
+
+    gt->pool = g_thread_pool_new (gst_geometric_transform_remap_func, gt,
+        gt->n_bands - 1, FALSE, &err);
+    if (!gt->pool) {
+      GST_ELEMENT_ERROR (gt, RESOURCE, FAILED,
+          ("Failed to create remapping threads"), ("%s", err->message));
+      g_clear_error (&err);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
 
 static gboolean
 gst_geometric_transform_stop (GstBaseTransform * trans)
 {
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (trans);
 
+  if (gt->pool) {
+    g_thread_pool_free (gt->pool, FALSE, TRUE);
+    gt->pool = NULL;
+  }
+
   GST_INFO_OBJECT (gt, "Deleting transform map");
 
   gt->width = 0;
@@ -373,7 +547,9 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
 
   obj_class->set_property = gst_geometric_transform_set_property;
   obj_class->get_property = gst_geometric_transform_get_property;
+  obj_class->finalize = gst_geometric_transform_finalize;
 
+  trans_class->start = GST_DEBUG_FUNCPTR (gst_geometric_transform_start);
   trans_class->stop = GST_DEBUG_FUNCPTR (gst_geometric_transform_stop);
   trans_class->before_transform =
       GST_DEBUG_FUNCPTR (gst_geometric_transform_before_transform);
@@ -388,6 +564,20 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
           "What to do with off edge pixels",
           GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, DEFAULT_OFF_EDGE_PIXELS,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGeometricTransform:n-threads:
+   *
+   * Number of threads remapping bands of each frame in parallel. 0 uses
+   * one thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (obj_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = one per processor)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -396,8 +586,11 @@ gst_geometric_transform_init (GTypeInstance * instance, gpointer g_class)
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (instance);
 
   gt->off_edge_pixels = DEFAULT_OFF_EDGE_PIXELS;
+  gt->n_threads = DEFAULT_N_THREADS;
   gt->precalc_map = TRUE;
   gt->needs_remap = TRUE;
+  g_mutex_init (&gt->lock);
+  g_cond_init (&gt->cond);
 }
 
 GType
@@ -49,6 +49,21 @@ enum
 typedef struct _GstGeometricTransform GstGeometricTransform;
 typedef struct _GstGeometricTransformClass GstGeometricTransformClass;
 
+/* number of fractional bits of the source positions in the map */
+#define GST_GT_MAP_FRAC_BITS 8
+
+/*
+ * One entry of the precalculated map, giving the input pixels an output
+ * pixel is interpolated from. The off edge pixels handling is already
+ * applied; a fraction is 0 when there is no pixel on the right or below
+ * to interpolate with.
+ */
+typedef struct {
+  gint32 offset;                /* of the top left pixel, -1 if off edges */
+  guint16 frac_x;
+  guint16 frac_y;
+} GstGeometricTransformMapEntry;
+
 /**
  * GstGeometricTransformMapFunc:
  *
@@ -99,8 +114,18 @@ struct _GstGeometricTransform {
 
   /* properties */
   gint off_edge_pixels;
-
-  gdouble *map;
+  guint n_threads;
+
+  GstGeometricTransformMapEntry *map;
+
+  /* threads remapping bands of the output frame */
+  GThreadPool *pool;
+  gint n_bands;
+  GMutex lock;
+  GCond cond;
+  gint pending_bands;
+  guint8 *in_data;
+  guint8 *out_data;
 };
 
 struct _GstGeometricTransformClass {
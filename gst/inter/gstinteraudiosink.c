@@ -208,6 +208,9 @@ gst_inter_audio_sink_start (GstBaseSink * sink)
   interaudiosink->surface = gst_inter_surface_get (interaudiosink->channel);
   g_mutex_lock (&interaudiosink->surface->mutex);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
+  gst_inter_surface_reset_audio_ring (interaudiosink->surface);
+  interaudiosink->audio_ring_cookie =
+      interaudiosink->surface->audio_ring_cookie - 1;
 
   /* We want to write latency-time before syncing has happened */
   /* FIXME: The other side can change this value when it starts */
@@ -226,10 +229,15 @@ gst_inter_audio_sink_stop (GstBaseSink * sink)
   GST_DEBUG_OBJECT (interaudiosink, "stop");
 
   g_mutex_lock (&interaudiosink->surface->mutex);
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
+  gst_inter_surface_reset_audio_ring (interaudiosink->surface);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
+  if (interaudiosink->audio_ring) {
+    gst_inter_audio_ring_unref (interaudiosink->audio_ring);
+    interaudiosink->audio_ring = NULL;
+  }
+
   gst_inter_surface_unref (interaudiosink->surface);
   interaudiosink->surface = NULL;
 
@@ -253,12 +261,30 @@ gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   interaudiosink->surface->audio_info = info;
   interaudiosink->info = info;
   /* TODO: Ideally we would drain the source here */
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
+  gst_inter_surface_reset_audio_ring (interaudiosink->surface);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
   return TRUE;
 }
 
+static void
+gst_inter_audio_sink_write (GstInterAudioSink * interaudiosink,
+    GstInterAudioRing * ring, GstBuffer * buffer)
+{
+  GstMapInfo map;
+  guint written;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return;
+
+  written = gst_inter_audio_ring_write (ring, map.data, map.size);
+  if (written < map.size)
+    GST_DEBUG_OBJECT (interaudiosink, "ring full, dropping %" G_GSIZE_FORMAT
+        " bytes", map.size - written);
+
+  gst_buffer_unmap (buffer, &map);
+}
+
 static gboolean
 gst_inter_audio_sink_event (GstBaseSink * sink, GstEvent * event)
 {
@@ -266,14 +292,17 @@ gst_inter_audio_sink_event (GstBaseSink * sink, GstEvent * event)
 
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_EOS:{
+      GstInterAudioRing *ring;
       GstBuffer *tmp;
       guint n;
 
+      ring = gst_inter_surface_get_audio_ring (interaudiosink->surface,
+          &interaudiosink->audio_ring, &interaudiosink->audio_ring_cookie);
       if ((n = gst_adapter_available (interaudiosink->input_adapter)) > 0) {
-        g_mutex_lock (&interaudiosink->surface->mutex);
         tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-        gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
-        g_mutex_unlock (&interaudiosink->surface->mutex);
+        if (ring)
+          gst_inter_audio_sink_write (interaudiosink, ring, tmp);
+        gst_buffer_unref (tmp);
       }
       break;
     }
@@ -288,58 +317,45 @@ static GstFlowReturn
 gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
-  guint n, bpf;
-  guint64 period_time, buffer_time;
-  guint64 period_samples, buffer_samples;
+  GstInterAudioRing *ring;
+  guint n;
 
   GST_DEBUG_OBJECT (interaudiosink, "render %" G_GSIZE_FORMAT,
       gst_buffer_get_size (buffer));
-  bpf = interaudiosink->info.bpf;
 
-  g_mutex_lock (&interaudiosink->surface->mutex);
+  /* The samples are written to the ring without locking, the source drops
+   * the oldest ones if more than buffer-time is queued */
+  ring = gst_inter_surface_get_audio_ring (interaudiosink->surface,
+      &interaudiosink->audio_ring, &interaudiosink->audio_ring_cookie);
+
+  if (!ring) {
+    guint64 period_time, buffer_time;
 
-  buffer_time = interaudiosink->surface->audio_buffer_time;
-  period_time = interaudiosink->surface->audio_period_time;
+    g_mutex_lock (&interaudiosink->surface->mutex);
+    buffer_time = interaudiosink->surface->audio_buffer_time;
+    period_time = interaudiosink->surface->audio_period_time;
+    g_mutex_unlock (&interaudiosink->surface->mutex);
 
-  if (buffer_time < period_time) {
     GST_ERROR_OBJECT (interaudiosink,
         "Buffer time smaller than period time (%" GST_TIME_FORMAT " < %"
         GST_TIME_FORMAT ")", GST_TIME_ARGS (buffer_time),
         GST_TIME_ARGS (period_time));
-    g_mutex_unlock (&interaudiosink->surface->mutex);
     return GST_FLOW_ERROR;
   }
 
-  buffer_samples =
-      gst_util_uint64_scale (buffer_time, interaudiosink->info.rate,
-      GST_SECOND);
-  period_samples =
-      gst_util_uint64_scale (period_time, interaudiosink->info.rate,
-      GST_SECOND);
-
-  n = gst_adapter_available (interaudiosink->surface->audio_adapter) / bpf;
-  while (n > buffer_samples) {
-    GST_DEBUG_OBJECT (interaudiosink, "flushing %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (period_time));
-    gst_adapter_flush (interaudiosink->surface->audio_adapter,
-        period_samples * bpf);
-    n -= period_samples;
-  }
-
   n = gst_adapter_available (interaudiosink->input_adapter);
-  if (period_samples * bpf > gst_buffer_get_size (buffer) + n) {
+  if (ring->period_size > gst_buffer_get_size (buffer) + n) {
     gst_adapter_push (interaudiosink->input_adapter, gst_buffer_ref (buffer));
   } else {
     GstBuffer *tmp;
 
     if (n > 0) {
       tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-      gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
+      gst_inter_audio_sink_write (interaudiosink, ring, tmp);
+      gst_buffer_unref (tmp);
     }
-    gst_adapter_push (interaudiosink->surface->audio_adapter,
-        gst_buffer_ref (buffer));
+    gst_inter_audio_sink_write (interaudiosink, ring, buffer);
   }
-  g_mutex_unlock (&interaudiosink->surface->mutex);
 
   return GST_FLOW_OK;
 }
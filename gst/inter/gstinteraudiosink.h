@@ -43,6 +43,9 @@ struct _GstInterAudioSink
 
   GstAdapter *input_adapter;
   GstAudioInfo info;
+
+  GstInterAudioRing *audio_ring;
+  gint audio_ring_cookie;
 };
 
 struct _GstInterAudioSinkClass
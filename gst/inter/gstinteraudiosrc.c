@@ -287,6 +287,10 @@ gst_inter_audio_src_start (GstBaseSrc * src)
   interaudiosrc->surface->audio_buffer_time = interaudiosrc->buffer_time;
   interaudiosrc->surface->audio_latency_time = interaudiosrc->latency_time;
   interaudiosrc->surface->audio_period_time = interaudiosrc->period_time;
+  /* the ring is sized from the times */
+  gst_inter_surface_reset_audio_ring (interaudiosrc->surface);
+  interaudiosrc->audio_ring_cookie =
+      interaudiosrc->surface->audio_ring_cookie - 1;
   g_mutex_unlock (&interaudiosrc->surface->mutex);
 
   return TRUE;
@@ -302,6 +306,11 @@ gst_inter_audio_src_stop (GstBaseSrc * src)
   gst_inter_surface_unref (interaudiosrc->surface);
   interaudiosrc->surface = NULL;
 
+  if (interaudiosrc->audio_ring) {
+    gst_inter_audio_ring_unref (interaudiosrc->audio_ring);
+    interaudiosrc->audio_ring = NULL;
+  }
+
   return TRUE;
 }
 
@@ -335,10 +344,10 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
+  GstInterAudioRing *ring;
   GstCaps *caps;
   GstBuffer *buffer;
   guint n, bpf;
-  guint64 period_time;
   guint64 period_samples;
 
   GST_DEBUG_OBJECT (interaudiosrc, "create");
@@ -346,11 +355,13 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
   buffer = NULL;
   caps = NULL;
 
-  g_mutex_lock (&interaudiosrc->surface->mutex);
-  if (interaudiosrc->surface->audio_info.finfo) {
-    if (!gst_audio_info_is_equal (&interaudiosrc->surface->audio_info,
-            &interaudiosrc->info)) {
-      caps = gst_audio_info_to_caps (&interaudiosrc->surface->audio_info);
+  /* The ring carries the format of the samples in it, the surface mutex is
+   * only taken when the sink replaced it */
+  ring = gst_inter_surface_get_audio_ring (interaudiosrc->surface,
+      &interaudiosrc->audio_ring, &interaudiosrc->audio_ring_cookie);
+  if (ring) {
+    if (!gst_audio_info_is_equal (&ring->info, &interaudiosrc->info)) {
+      caps = gst_audio_info_to_caps (&ring->info);
       interaudiosrc->timestamp_offset +=
           gst_util_uint64_scale (interaudiosrc->n_samples, GST_SECOND,
           interaudiosrc->info.rate);
@@ -358,26 +369,34 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  bpf = interaudiosrc->surface->audio_info.bpf;
-  period_time = interaudiosrc->surface->audio_period_time;
-  period_samples =
-      gst_util_uint64_scale (period_time, interaudiosrc->info.rate, GST_SECOND);
+  bpf = ring ? ring->info.bpf : 0;
+  period_samples = gst_util_uint64_scale (interaudiosrc->period_time,
+      interaudiosrc->info.rate, GST_SECOND);
 
-  if (bpf > 0)
-    n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / bpf;
-  else
-    n = 0;
+  n = 0;
+  if (bpf > 0 && period_samples > 0) {
+    GstMemory *mem;
+    GstMapInfo map;
 
-  if (n > period_samples)
-    n = period_samples;
-  if (n > 0) {
-    buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
-        n * bpf);
-  } else {
+    mem = gst_allocator_alloc (NULL, period_samples * bpf, NULL);
+    if (gst_memory_map (mem, &map, GST_MAP_WRITE)) {
+      n = gst_inter_audio_ring_read (ring, map.data, map.size) / bpf;
+      gst_memory_unmap (mem, &map);
+    }
+
+    if (n > 0) {
+      gst_memory_resize (mem, 0, n * bpf);
+      buffer = gst_buffer_new ();
+      gst_buffer_append_memory (buffer, mem);
+    } else {
+      gst_memory_unref (mem);
+    }
+  }
+
+  if (n == 0) {
     buffer = gst_buffer_new ();
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
   }
-  g_mutex_unlock (&interaudiosrc->surface->mutex);
 
   if (caps) {
     gboolean ret = gst_base_src_set_caps (src, caps);
@@ -46,6 +46,9 @@ struct _GstInterAudioSrc
   GstClockTime timestamp_offset;
   GstAudioInfo info;
   guint64 buffer_time, latency_time, period_time;
+
+  GstInterAudioRing *audio_ring;
+  gint audio_ring_cookie;
 };
 
 struct _GstInterAudioSrcClass
@@ -48,7 +48,6 @@ gst_inter_surface_get (const char *name)
   surface->ref_count = 1;
   surface->name = g_strdup (name);
   g_mutex_init (&surface->mutex);
-  surface->audio_adapter = gst_adapter_new ();
   surface->audio_buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   surface->audio_latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   surface->audio_period_time = DEFAULT_AUDIO_PERIOD_TIME;
@@ -78,11 +77,147 @@ gst_inter_surface_unref (GstInterSurface * surface)
     }
 
     g_mutex_clear (&surface->mutex);
-    gst_buffer_replace (&surface->video_buffer, NULL);
+    gst_inter_surface_clear_video_frames (surface);
     gst_buffer_replace (&surface->sub_buffer, NULL);
-    gst_object_unref (surface->audio_adapter);
+    if (surface->audio_ring)
+      gst_inter_audio_ring_unref (surface->audio_ring);
     g_free (surface->name);
     g_free (surface);
   }
   g_mutex_unlock (&mutex);
 }
+
+/* must be called with the surface mutex. The frame numbers keep going up so
+ * that the sources see the frames rendered afterwards as new */
+void
+gst_inter_surface_clear_video_frames (GstInterSurface * surface)
+{
+  int i;
+
+  for (i = 0; i < GST_INTER_VIDEO_QUEUE_SIZE; i++)
+    gst_buffer_replace (&surface->video_frames[i], NULL);
+}
+
+static GstInterAudioRing *
+gst_inter_audio_ring_new (const GstAudioInfo * info, guint64 buffer_time,
+    guint64 period_time)
+{
+  GstInterAudioRing *ring;
+  guint64 buffer_size, period_size;
+
+  if (!info->finfo || info->bpf == 0 || buffer_time < period_time)
+    return NULL;
+
+  buffer_size = gst_util_uint64_scale (buffer_time, info->rate,
+      GST_SECOND) * info->bpf;
+  period_size = gst_util_uint64_scale (period_time, info->rate,
+      GST_SECOND) * info->bpf;
+  if (buffer_size + period_size > G_MAXINT)
+    return NULL;
+
+  ring = g_new0 (GstInterAudioRing, 1);
+  ring->ref_count = 1;
+  ring->info = *info;
+  ring->buffer_size = buffer_size;
+  ring->period_size = period_size;
+  /* room for the samples the source drops when it gets behind */
+  ring->size = 1;
+  while (ring->size < buffer_size + period_size)
+    ring->size <<= 1;
+  ring->data = g_malloc (ring->size);
+
+  return ring;
+}
+
+void
+gst_inter_audio_ring_unref (GstInterAudioRing * ring)
+{
+  if (g_atomic_int_dec_and_test (&ring->ref_count)) {
+    g_free (ring->data);
+    g_free (ring);
+  }
+}
+
+/* Called by the sink only. Returns the number of bytes written, less than
+ * @size if the source does not read */
+guint
+gst_inter_audio_ring_write (GstInterAudioRing * ring, const guint8 * data,
+    guint size)
+{
+  guint write_pos = g_atomic_int_get (&ring->write_pos);
+  guint read_pos = g_atomic_int_get (&ring->read_pos);
+  guint offset, len;
+
+  size = MIN (size, ring->size - (write_pos - read_pos));
+  size -= size % ring->info.bpf;
+
+  offset = write_pos & (ring->size - 1);
+  len = MIN (size, ring->size - offset);
+  memcpy (ring->data + offset, data, len);
+  memcpy (ring->data, data + len, size - len);
+
+  /* publishes the data */
+  g_atomic_int_set (&ring->write_pos, write_pos + size);
+
+  return size;
+}
+
+/* Called by the source only. Returns the number of bytes read, after
+ * dropping the oldest samples if more than the buffer time is queued */
+guint
+gst_inter_audio_ring_read (GstInterAudioRing * ring, guint8 * data,
+    guint size)
+{
+  guint write_pos = g_atomic_int_get (&ring->write_pos);
+  guint read_pos = g_atomic_int_get (&ring->read_pos);
+  guint offset, len;
+
+  if (write_pos - read_pos > ring->buffer_size)
+    read_pos = write_pos - ring->buffer_size;
+
+  size = MIN (size, write_pos - read_pos);
+  size -= size % ring->info.bpf;
+
+  offset = read_pos & (ring->size - 1);
+  len = MIN (size, ring->size - offset);
+  memcpy (data, ring->data + offset, len);
+  memcpy (data + len, ring->data, size - len);
+
+  /* frees the space */
+  g_atomic_int_set (&ring->read_pos, read_pos + size);
+
+  return size;
+}
+
+/* must be called with the surface mutex. Drops the queued samples and
+ * creates a ring for the current format and times, if any */
+void
+gst_inter_surface_reset_audio_ring (GstInterSurface * surface)
+{
+  if (surface->audio_ring)
+    gst_inter_audio_ring_unref (surface->audio_ring);
+
+  surface->audio_ring = gst_inter_audio_ring_new (&surface->audio_info,
+      surface->audio_buffer_time, surface->audio_period_time);
+  g_atomic_int_inc (&surface->audio_ring_cookie);
+}
+
+/* Updates *@ring to the current ring of the surface if it changed since
+ * *@cookie. Only takes the surface mutex if it did */
+GstInterAudioRing *
+gst_inter_surface_get_audio_ring (GstInterSurface * surface,
+    GstInterAudioRing ** ring, gint * cookie)
+{
+  if (g_atomic_int_get (&surface->audio_ring_cookie) != *cookie) {
+    g_mutex_lock (&surface->mutex);
+    if (*ring)
+      gst_inter_audio_ring_unref (*ring);
+    *ring = surface->audio_ring;
+    if (*ring)
+      g_atomic_int_inc (&(*ring)->ref_count);
+    *cookie = surface->audio_ring_cookie;
+    g_mutex_unlock (&surface->mutex);
+  }
+
+  return *ring;
+}
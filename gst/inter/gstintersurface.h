@@ -27,6 +27,28 @@
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterAudioRing GstInterAudioRing;
+
+#define GST_INTER_VIDEO_QUEUE_SIZE 4
+
+/* Single producer, single consumer ring of audio samples. The sink only
+ * moves write_pos and the source only read_pos, so neither takes a lock to
+ * move data. A new ring is created when the format or the times change */
+struct _GstInterAudioRing
+{
+  gint ref_count;
+
+  GstAudioInfo info;
+  guint8 *data;
+  /* in bytes, a power of two so that the positions can wrap around */
+  guint size;
+  /* the source drops older samples to keep at most buffer_size bytes */
+  guint buffer_size;
+  guint period_size;
+
+  volatile gint write_pos;
+  volatile gint read_pos;
+};
 
 struct _GstInterSurface
 {
@@ -37,17 +59,23 @@ struct _GstInterSurface
 
   /* video */
   GstVideoInfo video_info;
-  int video_buffer_count;
+  /* the last GST_INTER_VIDEO_QUEUE_SIZE frames, frame number n is at
+   * n % GST_INTER_VIDEO_QUEUE_SIZE. Each source keeps its own position */
+  GstBuffer *video_frames[GST_INTER_VIDEO_QUEUE_SIZE];
+  /* number of the latest frame, 0 if none was ever rendered */
+  guint64 video_seq;
 
   /* audio */
   GstAudioInfo audio_info;
   guint64 audio_buffer_time;
   guint64 audio_latency_time;
   guint64 audio_period_time;
+  /* replaced with the surface mutex held, audio_ring_cookie is incremented
+   * every time so that the elements know they need to get the new one */
+  GstInterAudioRing *audio_ring;
+  volatile gint audio_ring_cookie;
 
-  GstBuffer *video_buffer;
   GstBuffer *sub_buffer;
-  GstAdapter *audio_adapter;
 };
 
 #define DEFAULT_AUDIO_BUFFER_TIME  (GST_SECOND)
@@ -57,6 +85,16 @@ struct _GstInterSurface
 
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
+void gst_inter_surface_clear_video_frames (GstInterSurface *surface);
+void gst_inter_surface_reset_audio_ring (GstInterSurface *surface);
+GstInterAudioRing * gst_inter_surface_get_audio_ring (GstInterSurface *surface,
+    GstInterAudioRing **ring, gint *cookie);
+
+void gst_inter_audio_ring_unref (GstInterAudioRing *ring);
+guint gst_inter_audio_ring_write (GstInterAudioRing *ring, const guint8 *data,
+    guint size);
+guint gst_inter_audio_ring_read (GstInterAudioRing *ring, guint8 *data,
+    guint size);
 
 
 G_END_DECLS
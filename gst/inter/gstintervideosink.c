@@ -210,10 +210,7 @@ gst_inter_video_sink_stop (GstBaseSink * sink)
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
 
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = NULL;
+  gst_inter_surface_clear_video_frames (intervideosink->surface);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
   g_mutex_unlock (&intervideosink->surface->mutex);
 
@@ -235,6 +232,9 @@ gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   }
 
   g_mutex_lock (&intervideosink->surface->mutex);
+  /* queued frames are in the old format */
+  if (!gst_video_info_is_equal (&intervideosink->surface->video_info, &info))
+    gst_inter_surface_clear_video_frames (intervideosink->surface);
   intervideosink->surface->video_info = info;
   intervideosink->info = info;
   g_mutex_unlock (&intervideosink->surface->mutex);
@@ -251,11 +251,10 @@ gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
+  intervideosink->surface->video_seq++;
+  gst_buffer_replace (&intervideosink->surface->video_frames
+      [intervideosink->surface->video_seq % GST_INTER_VIDEO_QUEUE_SIZE],
+      buffer);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return GST_FLOW_OK;
@@ -276,6 +276,14 @@ gst_inter_video_src_start (GstBaseSrc * src)
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->video_buffer_count = 0;
+
+  /* start with the latest frame */
+  g_mutex_lock (&intervideosrc->surface->mutex);
+  intervideosrc->video_seq = intervideosrc->surface->video_seq;
+  if (intervideosrc->video_seq > 0)
+    intervideosrc->video_seq--;
+  g_mutex_unlock (&intervideosrc->surface->mutex);
 
   return TRUE;
 }
@@ -290,6 +298,7 @@ gst_inter_video_src_stop (GstBaseSrc * src)
   gst_inter_surface_unref (intervideosrc->surface);
   intervideosrc->surface = NULL;
   gst_buffer_replace (&intervideosrc->black_frame, NULL);
+  gst_buffer_replace (&intervideosrc->video_buffer, NULL);
 
   return TRUE;
 }
@@ -360,25 +369,43 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  if (intervideosrc->surface->video_buffer) {
+  /* Take the next frame we did not push yet, skipping the ones that were
+   * already dropped from the queue if we are too slow */
+  while (intervideosrc->video_seq < intervideosrc->surface->video_seq) {
+    GstBuffer *frame;
+
+    intervideosrc->video_seq++;
+    if (intervideosrc->surface->video_seq - intervideosrc->video_seq >=
+        GST_INTER_VIDEO_QUEUE_SIZE)
+      intervideosrc->video_seq = intervideosrc->surface->video_seq -
+          GST_INTER_VIDEO_QUEUE_SIZE + 1;
+
+    frame = intervideosrc->surface->video_frames[intervideosrc->video_seq %
+        GST_INTER_VIDEO_QUEUE_SIZE];
+    if (frame) {
+      gst_buffer_replace (&intervideosrc->video_buffer, frame);
+      intervideosrc->video_buffer_count = 0;
+      break;
+    }
+  }
+  g_mutex_unlock (&intervideosrc->surface->mutex);
+
+  if (intervideosrc->video_buffer) {
     /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+    buffer = gst_buffer_ref (intervideosrc->video_buffer);
 
     /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
-    }
+    if (intervideosrc->video_buffer_count == frames)
+      gst_buffer_replace (&intervideosrc->video_buffer, NULL);
   }
 
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
+  if (intervideosrc->video_buffer_count != 0 &&
+      intervideosrc->video_buffer_count != (frames + 1)) {
     /* This is a repeat of the stored buffer or of a black frame */
     is_gap = TRUE;
   }
 
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
+  intervideosrc->video_buffer_count++;
 
   if (caps) {
     gboolean ret;
@@ -46,6 +46,11 @@ struct _GstInterVideoSrc
 
   GstVideoInfo info;
   GstBuffer *black_frame;
+  /* number of the last frame taken from the surface, the frame itself and
+   * how many times it was pushed */
+  guint64 video_seq;
+  GstBuffer *video_buffer;
+  int video_buffer_count;
   int n_frames;
   GstClockTime timestamp_offset;
 };
@@ -920,10 +920,23 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     if (interlace->stored_fields > 0) {
       GST_DEBUG ("1 field from stored, 1 from current");
 
-      output_buffer = gst_buffer_new_and_alloc (gst_buffer_get_size (buffer));
-      /* take the first field from the stored frame */
-      copy_field (interlace, output_buffer, interlace->stored_frame,
-          interlace->field_index);
+      if (interlace->stored_fields == 1) {
+        /* The stored frame is not needed anymore once its last field is
+         * taken, so only the field from the incoming buffer is copied, into
+         * the stored frame, instead of copying both into a new buffer */
+        output_buffer = gst_buffer_make_writable (interlace->stored_frame);
+        interlace->stored_frame = NULL;
+        /* it may have been decorated when it was pushed itself */
+        GST_BUFFER_FLAG_UNSET (output_buffer, GST_BUFFER_FLAG_DISCONT |
+            GST_VIDEO_BUFFER_FLAG_TFF | GST_VIDEO_BUFFER_FLAG_RFF |
+            GST_VIDEO_BUFFER_FLAG_ONEFIELD | GST_VIDEO_BUFFER_FLAG_INTERLACED);
+      } else {
+        output_buffer =
+            gst_buffer_new_and_alloc (gst_buffer_get_size (buffer));
+        /* take the first field from the stored frame */
+        copy_field (interlace, output_buffer, interlace->stored_frame,
+            interlace->field_index);
+      }
       interlace->stored_fields--;
       /* take the second field from the incoming buffer */
       copy_field (interlace, output_buffer, buffer, interlace->field_index ^ 1);
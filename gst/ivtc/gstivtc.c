@@ -299,6 +299,7 @@ add_field (GstIvtc * ivtc, GstBuffer * buffer, int parity, int index)
   field->buffer = gst_buffer_ref (buffer);
   field->parity = parity;
   field->ts = ts;
+  field->next_score = -1;
 
   gst_video_frame_map (&ivtc->fields[i].frame, &ivtc->sink_video_info,
       buffer, GST_MAP_READ);
@@ -315,8 +316,15 @@ similarity (GstIvtc * ivtc, int i1, int i2)
   g_return_val_if_fail (i1 >= 0 && i1 < ivtc->n_fields, 0);
   g_return_val_if_fail (i2 >= 0 && i2 < ivtc->n_fields, 0);
 
-  f1 = &ivtc->fields[i1];
-  f2 = &ivtc->fields[i2];
+  f1 = &ivtc->fields[MIN (i1, i2)];
+  f2 = &ivtc->fields[MAX (i1, i2)];
+
+  /* Neighbouring fields are compared again once the window moved on, so
+   * their score is kept with the fields */
+  if (i2 == i1 + 1 || i1 == i2 + 1) {
+    if (f1->next_score >= 0)
+      return f1->next_score;
+  }
 
   if (f1->parity == TOP_FIELD) {
     score = get_comb_score (&f1->frame, &f2->frame);
@@ -326,6 +334,9 @@ similarity (GstIvtc * ivtc, int i1, int i2)
 
   GST_DEBUG ("score %d", score);
 
+  if (i2 == i1 + 1 || i1 == i2 + 1)
+    f1->next_score = score;
+
   return score;
 }
 
@@ -41,6 +41,8 @@ struct _GstIvtcField
   int parity;
   GstVideoFrame frame;
   GstClockTime ts;
+  /* comb score of this field woven with the next one, -1 if unknown */
+  int next_score;
 };
 
 #define GST_IVTC_MAX_FIELDS 10
@@ -190,7 +190,6 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   }
 
   gst_byte_reader_init (&reader, info.data, info.size);
-  gst_byte_writer_init_with_size (&writer, gst_buffer_get_size (inbuf), FALSE);
 
   /* main header */
   memset (&main_header, 0, sizeof (MainHeader));
@@ -202,9 +201,16 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   if (ret != GST_FLOW_OK)
     goto done;
 
+  /* the decimated size is known exactly now, write everything into a
+   * single allocation of that size */
+  gst_byte_writer_init_with_size (&writer,
+      sizeof_main_header (self, &main_header), TRUE);
+
   ret = write_main_header (self, &writer, &main_header);
-  if (ret != GST_FLOW_OK)
+  if (ret != GST_FLOW_OK) {
+    gst_byte_writer_reset (&writer);
     goto done;
+  }
 
   outbuf = gst_byte_writer_reset_and_get_buffer (&writer);
   gst_buffer_copy_into (outbuf, inbuf, GST_BUFFER_COPY_METADATA, 0, -1);
@@ -864,7 +864,7 @@ parse_packet (GstJP2kDecimator * self, GstByteReader * reader,
 
   if (plt) {
     guint32 length;
-    Packet *p;
+    Packet p = { 0, };
 
     if (plt->packet_lengths->len <= it->cur_packet) {
       GST_ERROR_OBJECT (self, "Truncated PLT");
@@ -880,14 +880,11 @@ parse_packet (GstJP2kDecimator * self, GstByteReader * reader,
       goto done;
     }
 
-    p = g_slice_new0 (Packet);
-
     /* If there is a SOP keep the seqno */
     if (sop && length > 6) {
       if (!gst_byte_reader_peek_uint16_be (reader, &marker)) {
         GST_ERROR_OBJECT (self, "Truncated file");
         ret = GST_FLOW_ERROR;
-        g_slice_free (Packet, p);
         goto done;
       }
 
@@ -899,34 +896,32 @@ parse_packet (GstJP2kDecimator * self, GstByteReader * reader,
         if (!gst_byte_reader_get_uint16_be (reader, &dummy)) {
           GST_ERROR_OBJECT (self, "Truncated file");
           ret = GST_FLOW_ERROR;
-          g_slice_free (Packet, p);
           goto done;
         }
 
         if (!gst_byte_reader_get_uint16_be (reader, &seqno)) {
           GST_ERROR_OBJECT (self, "Truncated file");
           ret = GST_FLOW_ERROR;
-          g_slice_free (Packet, p);
           goto done;
         }
-        p->data = gst_byte_reader_peek_data_unchecked (reader);
-        p->length = length - 6;
-        p->sop = TRUE;
-        p->eph = eph;
-        p->seqno = seqno;
+        p.data = gst_byte_reader_peek_data_unchecked (reader);
+        p.length = length - 6;
+        p.sop = TRUE;
+        p.eph = eph;
+        p.seqno = seqno;
         gst_byte_reader_skip_unchecked (reader, length - 6);
       }
     }
 
-    if (!p->data) {
-      p->data = gst_byte_reader_peek_data_unchecked (reader);
-      p->length = length;
-      p->sop = FALSE;
-      p->eph = eph;
+    if (!p.data) {
+      p.data = gst_byte_reader_peek_data_unchecked (reader);
+      p.length = length;
+      p.sop = FALSE;
+      p.eph = eph;
       gst_byte_reader_skip_unchecked (reader, length);
     }
 
-    tile->packets = g_list_prepend (tile->packets, p);
+    g_array_append_val (tile->packets, p);
   } else if (sop) {
     if (!gst_byte_reader_peek_uint16_be (reader, &marker)) {
       GST_ERROR_OBJECT (self, "Truncated file");
@@ -966,14 +961,14 @@ parse_packet (GstJP2kDecimator * self, GstByteReader * reader,
       }
 
       if (marker == MARKER_SOP || marker == MARKER_EOC || marker == MARKER_SOT) {
-        Packet *p = g_slice_new (Packet);
+        Packet p;
 
-        p->sop = TRUE;
-        p->eph = eph;
-        p->seqno = seqno;
-        p->data = packet_start_data;
-        p->length = reader->byte - packet_start_pos;
-        tile->packets = g_list_prepend (tile->packets, p);
+        p.sop = TRUE;
+        p.eph = eph;
+        p.seqno = seqno;
+        p.data = packet_start_data;
+        p.length = reader->byte - packet_start_pos;
+        g_array_append_val (tile->packets, p);
 
         if (marker == MARKER_EOC || marker == MARKER_SOT)
           goto done;
@@ -1020,14 +1015,26 @@ parse_packets (GstJP2kDecimator * self, GstByteReader * reader,
   if (ret != GST_FLOW_OK)
     goto done;
 
+  /* All packets of the tile are stored in a single array, which is
+   * allocated at once if the PLT tells how many there are */
+  if (!tile->packets) {
+    guint n_packets = 0;
+
+    if (tile->plt) {
+      PacketLengthTilePart *plt = tile->plt->data;
+
+      n_packets = plt->packet_lengths->len;
+    }
+    tile->packets =
+        g_array_sized_new (FALSE, FALSE, sizeof (Packet), n_packets);
+  }
+
   while ((it.next (&it))) {
     ret = parse_packet (self, reader, header, tile, &it);
     if (ret != GST_FLOW_OK)
       goto done;
   }
 
-  tile->packets = g_list_reverse (tile->packets);
-
 done:
 
   return ret;
@@ -1222,6 +1229,7 @@ sizeof_tile (GstJP2kDecimator * self, const Tile * tile)
 {
   guint size = 0;
   GList *l;
+  guint i;
 
   /* SOT */
   size += 2 + 2 + 2 + 4 + 1 + 1;
@@ -1250,9 +1258,9 @@ sizeof_tile (GstJP2kDecimator * self, const Tile * tile)
   /* SOD */
   size += 2;
 
-  for (l = tile->packets; l; l = l->next) {
-    Packet *p = l->data;
-    size += sizeof_packet (self, p);
+  if (tile->packets) {
+    for (i = 0; i < tile->packets->len; i++)
+      size += sizeof_packet (self, &g_array_index (tile->packets, Packet, i));
   }
 
   return size;
@@ -1290,12 +1298,8 @@ reset_tile (GstJP2kDecimator * self, const MainHeader * header, Tile * tile)
   }
   g_list_free (tile->com);
 
-  for (l = tile->packets; l; l = l->next) {
-    Packet *p = l->data;
-
-    g_slice_free (Packet, p);
-  }
-  g_list_free (tile->packets);
+  if (tile->packets)
+    g_array_free (tile->packets, TRUE);
 
   memset (tile, 0, sizeof (Tile));
 }
@@ -1355,6 +1359,7 @@ write_tile (GstJP2kDecimator * self, GstByteWriter * writer,
     const MainHeader * header, Tile * tile)
 {
   GList *l;
+  guint i;
   GstFlowReturn ret = GST_FLOW_OK;
 
   if (!gst_byte_writer_ensure_free_space (writer, 12)) {
@@ -1412,12 +1417,13 @@ write_tile (GstJP2kDecimator * self, GstByteWriter * writer,
     goto done;
   }
 
-  for (l = tile->packets; l; l = l->next) {
-    Packet *p = l->data;
-
-    ret = write_packet (self, writer, p);
-    if (ret != GST_FLOW_OK)
-      goto done;
+  if (tile->packets) {
+    for (i = 0; i < tile->packets->len; i++) {
+      ret = write_packet (self, writer,
+          &g_array_index (tile->packets, Packet, i));
+      if (ret != GST_FLOW_OK)
+        goto done;
+    }
   }
 
 done:
@@ -1758,7 +1764,7 @@ decimate_main_header (GstJP2kDecimator * self, MainHeader * header)
 
   for (i = 0; i < header->n_tiles; i++) {
     Tile *tile = &header->tiles[i];
-    GList *l;
+    guint n = 0;
     PacketIterator it;
     PacketLengthTilePart *plt = NULL;
 
@@ -1775,19 +1781,20 @@ decimate_main_header (GstJP2kDecimator * self, MainHeader * header)
 
     init_packet_iterator (self, &it, header, tile);
 
-    l = tile->packets;
     while ((it.next (&it))) {
       Packet *p;
 
-      if (l == NULL) {
+      if (!tile->packets || n >= tile->packets->len) {
         GST_ERROR_OBJECT (self, "Not enough packets");
         ret = GST_FLOW_ERROR;
-        g_array_free (plt->packet_lengths, TRUE);
-        g_slice_free (PacketLengthTilePart, plt);
+        if (plt) {
+          g_array_free (plt->packet_lengths, TRUE);
+          g_slice_free (PacketLengthTilePart, plt);
+        }
         goto done;
       }
 
-      p = l->data;
+      p = &g_array_index (tile->packets, Packet, n);
 
       if ((self->max_layers != 0 && it.cur_layer >= self->max_layers) ||
           (self->max_decomposition_levels != -1
@@ -1801,7 +1808,7 @@ decimate_main_header (GstJP2kDecimator * self, MainHeader * header)
         g_array_append_val (plt->packet_lengths, len);
       }
 
-      l = l->next;
+      n++;
     }
 
     if (plt) {
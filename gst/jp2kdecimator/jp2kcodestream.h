@@ -125,7 +125,7 @@ typedef struct
 
   GList *com;                   /* list of Buffer */
 
-  GList *packets;               /* list of Packet, codestream */
+  GArray *packets;              /* array of Packet, codestream order */
 
   /* TODO: COC, PPT */
 
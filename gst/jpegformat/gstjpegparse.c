@@ -204,21 +204,24 @@ static gboolean
 gst_jpeg_parse_skip_to_jpeg_header (GstJpegParse * parse, GstMapInfo * mapinfo,
     gint * skipsize)
 {
-  gboolean ret = TRUE;
-  GstByteReader reader;
+  const guint8 *data, *end, *p;
 
   if (mapinfo->size < 4)
     return FALSE;
 
-  gst_byte_reader_init (&reader, mapinfo->data, mapinfo->size);
-
-  *skipsize = gst_byte_reader_masked_scan_uint32 (&reader, 0xffffff00,
-      0xffd8ff00, 0, mapinfo->size);
-  if (*skipsize == -1) {
-    *skipsize = mapinfo->size - 3;      /* Last 3 bytes + 1 more may match header. */
-    ret = FALSE;
+  /* look for 0xff 0xd8 0xff followed by one more byte, memchr() is a lot
+   * faster at finding the candidates than scanning byte by byte */
+  data = mapinfo->data;
+  end = data + mapinfo->size - 3;
+  for (p = data; p < end && (p = memchr (p, 0xff, end - p)); p++) {
+    if (p[1] == 0xd8 && p[2] == 0xff) {
+      *skipsize = p - data;
+      return TRUE;
+    }
   }
-  return ret;
+
+  *skipsize = mapinfo->size - 3;        /* Last 3 bytes + 1 more may match header. */
+  return FALSE;
 }
 
 static inline gboolean
@@ -331,14 +334,21 @@ gst_jpeg_parse_get_image_length (GstJpegParse * parse, GstMapInfo * mapinfo)
       GST_DEBUG ("0x%08x: finding entropy segment length", offset + 2);
       noffset = offset + 2 + frame_len + eseglen;
       while (1) {
-        noffset = gst_byte_reader_masked_scan_uint32_peek (&reader, 0x0000ff00,
-            0x0000ff00, noffset, size - noffset, &value);
-        if (noffset < 0) {
+        const guint8 *marker = NULL;
+
+        /* in entropy coded data 0xff only shows up stuffed as 0xff00 or as
+         * the start of a marker, memchr() finds those candidates much faster
+         * than scanning byte by byte, libcs vectorize it */
+        if (noffset + 3 < size)
+          marker = memchr (mapinfo->data + noffset + 2, 0xff,
+              size - noffset - 3);
+        if (marker == NULL) {
           /* need more data */
           parse->priv->last_entropy_len = size - offset - 4 - frame_len - 2;
           goto need_more_data;
         }
-        if ((value & 0xff) != 0x00) {
+        noffset = marker - mapinfo->data - 2;
+        if (marker[1] != 0x00) {
           eseglen = noffset - offset - frame_len - 2;
           break;
         }
@@ -48,9 +48,12 @@ enum
   PROP_INCREMENTAL,
   PROP_USE_COPYRECT,
   PROP_SHARED,
-  PROP_VIEWONLY
+  PROP_VIEWONLY,
+  PROP_DAMAGE_ONLY
 };
 
+#define DEFAULT_DAMAGE_ONLY FALSE
+
 GST_DEBUG_CATEGORY_STATIC (rfbsrc_debug);
 GST_DEBUG_CATEGORY (rfbdecoder_debug);
 #define GST_CAT_DEFAULT rfbsrc_debug
@@ -78,7 +81,8 @@ static gboolean gst_rfb_src_event (GstBaseSrc * bsrc, GstEvent * event);
 static gboolean gst_rfb_src_unlock (GstBaseSrc * bsrc);
 static gboolean gst_rfb_src_decide_allocation (GstBaseSrc * bsrc,
     GstQuery * query);
-static GstFlowReturn gst_rfb_src_fill (GstPushSrc * psrc, GstBuffer * outbuf);
+static GstFlowReturn gst_rfb_src_create (GstPushSrc * psrc,
+    GstBuffer ** outbuf);
 
 #define gst_rfb_src_parent_class parent_class
 G_DEFINE_TYPE (GstRfbSrc, gst_rfb_src, GST_TYPE_PUSH_SRC);
@@ -147,12 +151,27 @@ gst_rfb_src_class_init (GstRfbSrcClass * klass)
       g_param_spec_boolean ("view-only", "Only view the desktop",
           "only view the desktop", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRfbSrc:damage-only:
+   *
+   * Only output a frame when the server updated part of the screen, and
+   * only copy the updated rectangles into the previous frame when it is not
+   * used downstream anymore. The updated rectangles are attached to the
+   * frames as #GstVideoRegionOfInterestMeta of type "damage".
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DAMAGE_ONLY,
+      g_param_spec_boolean ("damage-only", "Damage only",
+          "Only output frames for screen updates and attach the updated "
+          "rectangles as meta", DEFAULT_DAMAGE_ONLY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstbasesrc_class->negotiate = GST_DEBUG_FUNCPTR (gst_rfb_src_negotiate);
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_rfb_src_stop);
   gstbasesrc_class->event = GST_DEBUG_FUNCPTR (gst_rfb_src_event);
   gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_rfb_src_unlock);
-  gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_rfb_src_fill);
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_rfb_src_create);
   gstbasesrc_class->decide_allocation =
       GST_DEBUG_FUNCPTR (gst_rfb_src_decide_allocation);
 
@@ -186,6 +205,7 @@ gst_rfb_src_init (GstRfbSrc * src)
   src->incremental_update = TRUE;
 
   src->view_only = FALSE;
+  src->damage_only = DEFAULT_DAMAGE_ONLY;
 
   src->decoder = rfb_decoder_new ();
 }
@@ -284,6 +304,9 @@ gst_rfb_src_set_property (GObject * object, guint prop_id,
     case PROP_VIEWONLY:
       src->view_only = g_value_get_boolean (value);
       break;
+    case PROP_DAMAGE_ONLY:
+      src->damage_only = g_value_get_boolean (value);
+      break;
     default:
       break;
   }
@@ -332,6 +355,9 @@ gst_rfb_src_get_property (GObject * object, guint prop_id,
     case PROP_VIEWONLY:
       g_value_set_boolean (value, src->view_only);
       break;
+    case PROP_DAMAGE_ONLY:
+      g_value_set_boolean (value, src->damage_only);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -465,8 +491,7 @@ gst_rfb_src_negotiate (GstBaseSrc * bsrc)
       decoder->rect_height);
 
   decoder->frame = g_malloc (vinfo.size);
-  if (decoder->use_copyrect)
-    decoder->prev_frame = g_malloc (vinfo.size);
+  src->frame_size = vinfo.size;
 
   caps = gst_video_info_to_caps (&vinfo);
 
@@ -489,53 +514,112 @@ gst_rfb_src_stop (GstBaseSrc * bsrc)
     src->decoder->frame = NULL;
   }
 
-  if (src->decoder->prev_frame) {
-    g_free (src->decoder->prev_frame);
-    src->decoder->prev_frame = NULL;
-  }
+  gst_buffer_replace (&src->last_buffer, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+remove_damage_meta (GstBuffer * buffer, GstMeta ** meta, gpointer user_data)
+{
+  if ((*meta)->info->api == GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)
+    *meta = NULL;
 
   return TRUE;
 }
 
 static GstFlowReturn
-gst_rfb_src_fill (GstPushSrc * psrc, GstBuffer * outbuf)
+gst_rfb_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
   GstRfbSrc *src = GST_RFB_SRC (psrc);
   RfbDecoder *decoder = src->decoder;
+  GstBuffer *buf = NULL;
+  GstFlowReturn ret;
   GstMapInfo info;
-
-  rfb_decoder_send_update_request (decoder, src->incremental_update,
-      decoder->offset_x, decoder->offset_y, decoder->rect_width,
-      decoder->rect_height);
-
-  while (decoder->state != NULL) {
-    if (!rfb_decoder_iterate (decoder)) {
-      if (decoder->error != NULL) {
-        GST_ELEMENT_ERROR (src, RESOURCE, READ,
-            ("Error on VNC connection to host %s on port %d: %s",
-                src->host, src->port, decoder->error->message), (NULL));
-      } else {
-        GST_ELEMENT_ERROR (src, RESOURCE, READ,
-            ("Error on setup VNC connection to host %s on port %d", src->host,
-                src->port), (NULL));
+  gboolean full_copy = TRUE;
+  guint i;
+
+  do {
+    rfb_decoder_send_update_request (decoder, src->incremental_update,
+        decoder->offset_x, decoder->offset_y, decoder->rect_width,
+        decoder->rect_height);
+
+    while (decoder->state != NULL) {
+      if (!rfb_decoder_iterate (decoder)) {
+        if (decoder->error != NULL) {
+          GST_ELEMENT_ERROR (src, RESOURCE, READ,
+              ("Error on VNC connection to host %s on port %d: %s",
+                  src->host, src->port, decoder->error->message), (NULL));
+        } else {
+          GST_ELEMENT_ERROR (src, RESOURCE, READ,
+              ("Error on setup VNC connection to host %s on port %d",
+                  src->host, src->port), (NULL));
+        }
+        return GST_FLOW_ERROR;
       }
-      return GST_FLOW_ERROR;
     }
+    /* nothing changed, don't push a copy of the previous frame */
+  } while (src->damage_only && decoder->damage->len == 0);
+
+  /* once downstream released the previous frame, it only needs the damaged
+   * rectangles to be brought up to date */
+  if (src->damage_only && src->last_buffer &&
+      gst_buffer_is_writable (src->last_buffer) &&
+      gst_buffer_is_all_memory_writable (src->last_buffer)) {
+    buf = src->last_buffer;
+    src->last_buffer = NULL;
+    gst_buffer_foreach_meta (buf, remove_damage_meta, NULL);
+    full_copy = FALSE;
+  } else {
+    gst_buffer_replace (&src->last_buffer, NULL);
+
+    ret = GST_BASE_SRC_CLASS (parent_class)->alloc (GST_BASE_SRC (src),
+        GST_BUFFER_OFFSET_NONE, src->frame_size, &buf);
+    if (ret != GST_FLOW_OK)
+      return ret;
   }
 
-  if (!gst_buffer_map (outbuf, &info, GST_MAP_WRITE)) {
+  if (!gst_buffer_map (buf, &info, GST_MAP_WRITE)) {
     GST_ELEMENT_ERROR (src, RESOURCE, WRITE,
         ("Could not map the output frame"), (NULL));
+    gst_buffer_unref (buf);
     return GST_FLOW_ERROR;
   }
 
-  memcpy (info.data, decoder->frame, info.size);
+  if (full_copy) {
+    memcpy (info.data, decoder->frame, MIN (info.size, src->frame_size));
+  } else {
+    for (i = 0; i < decoder->damage->len; i++) {
+      RfbRectangle *rect = &g_array_index (decoder->damage, RfbRectangle, i);
+      gsize offset = (rect->y * decoder->rect_width + rect->x) *
+          decoder->bytespp;
+      guint line;
+
+      for (line = 0; line < rect->h; line++) {
+        memcpy (info.data + offset, decoder->frame + offset,
+            rect->w * decoder->bytespp);
+        offset += decoder->line_size;
+      }
+    }
+  }
+
+  gst_buffer_unmap (buf, &info);
 
-  GST_BUFFER_PTS (outbuf) =
+  GST_BUFFER_PTS (buf) =
       gst_clock_get_time (GST_ELEMENT_CLOCK (src)) -
       GST_ELEMENT_CAST (src)->base_time;
 
-  gst_buffer_unmap (outbuf, &info);
+  if (src->damage_only) {
+    for (i = 0; i < decoder->damage->len; i++) {
+      RfbRectangle *rect = &g_array_index (decoder->damage, RfbRectangle, i);
+
+      gst_buffer_add_video_region_of_interest_meta (buf, "damage", rect->x,
+          rect->y, rect->w, rect->h);
+    }
+    src->last_buffer = gst_buffer_ref (buf);
+  }
+
+  *outbuf = buf;
 
   return GST_FLOW_OK;
 }
@@ -58,6 +58,12 @@ struct _GstRfbSrc
   gboolean go;
   gboolean incremental_update;
   gboolean view_only;
+  gboolean damage_only;
+
+  /* size of the output frames */
+  gsize frame_size;
+  /* the last frame pushed, updated in place in damage-only mode */
+  GstBuffer *last_buffer;
 
   guint button_mask;
 
@@ -35,6 +35,8 @@ static gboolean rfb_decoder_state_framebuffer_update_rectangle (RfbDecoder *
     decoder);
 static gboolean rfb_decoder_state_set_colour_map_entries (RfbDecoder * decoder);
 static gboolean rfb_decoder_state_server_cut_text (RfbDecoder * decoder);
+static void rfb_decoder_add_damage (RfbDecoder * decoder, gint x, gint y,
+    gint w, gint h);
 static gboolean rfb_decoder_raw_encoding (RfbDecoder * decoder, gint start_x,
     gint start_y, gint rect_w, gint rect_h);
 static gboolean rfb_decoder_copyrect_encoding (RfbDecoder * decoder,
@@ -67,6 +69,7 @@ rfb_decoder_new (void)
   decoder->data = NULL;
   decoder->data_len = 0;
   decoder->error = NULL;
+  decoder->damage = g_array_new (FALSE, FALSE, sizeof (RfbRectangle));
 
   g_mutex_init (&decoder->write_lock);
 
@@ -82,6 +85,7 @@ rfb_decoder_free (RfbDecoder * decoder)
 
   g_clear_object (&decoder->socket_client);
   g_clear_object (&decoder->cancellable);
+  g_array_free (decoder->damage, TRUE);
   g_mutex_clear (&decoder->write_lock);
   g_free (decoder);
 }
@@ -292,11 +296,7 @@ rfb_decoder_send_update_request (RfbDecoder * decoder,
 
   rfb_decoder_send (decoder, data, 10);
 
-  /* create a backup of the prev frame for copyrect encoding */
-  if (decoder->use_copyrect) {
-    memcpy (decoder->prev_frame, decoder->frame,
-        decoder->rect_width * decoder->rect_height * decoder->bpp / 8);
-  }
+  g_array_set_size (decoder->damage, 0);
 
   decoder->state = rfb_decoder_state_normal;
 }
@@ -786,7 +786,10 @@ rfb_decoder_state_framebuffer_update (RfbDecoder * decoder)
   decoder->n_rects = RFB_GET_UINT16 (decoder->data + 1);
   GST_DEBUG ("Number of rectangles : %d", decoder->n_rects);
 
-  decoder->state = rfb_decoder_state_framebuffer_update_rectangle;
+  if (decoder->n_rects == 0)
+    decoder->state = NULL;
+  else
+    decoder->state = rfb_decoder_state_framebuffer_update_rectangle;
 
   return TRUE;
 }
@@ -842,6 +845,8 @@ rfb_decoder_state_framebuffer_update_rectangle (RfbDecoder * decoder)
   if (!ret)
     return FALSE;
 
+  rfb_decoder_add_damage (decoder, x, y, w, h);
+
   decoder->n_rects--;
   if (decoder->n_rects == 0) {
     decoder->state = NULL;
@@ -852,6 +857,27 @@ rfb_decoder_state_framebuffer_update_rectangle (RfbDecoder * decoder)
   return TRUE;
 }
 
+static void
+rfb_decoder_add_damage (RfbDecoder * decoder, gint x, gint y, gint w, gint h)
+{
+  RfbRectangle rect;
+  gint x2, y2;
+
+  x2 = MIN (x + w, (gint) decoder->rect_width);
+  y2 = MIN (y + h, (gint) decoder->rect_height);
+  x = MAX (x, 0);
+  y = MAX (y, 0);
+
+  if (x2 <= x || y2 <= y)
+    return;
+
+  rect.x = x;
+  rect.y = y;
+  rect.w = x2 - x;
+  rect.h = y2 - y;
+  g_array_append_val (decoder->damage, rect);
+}
+
 static gboolean
 rfb_decoder_raw_encoding (RfbDecoder * decoder, gint start_x, gint start_y,
     gint rect_w, gint rect_h)
@@ -901,14 +927,23 @@ rfb_decoder_copyrect_encoding (RfbDecoder * decoder, gint start_x, gint start_y,
   copyrect_width = rect_w * decoder->bytespp;
   line_width = decoder->line_size;
   src =
-      decoder->prev_frame + ((src_y * decoder->rect_width) +
+      decoder->frame + ((src_y * decoder->rect_width) +
       src_x) * decoder->bytespp;
   dst =
       decoder->frame + ((start_y * decoder->rect_width) +
       start_x) * decoder->bytespp;
 
+  /* the rectangles of an update apply in order, so the source is the frame
+   * as it is now; walk bottom up when the source is above the destination
+   * so that overlapping lines are read before they are overwritten */
+  if (src_y < start_y) {
+    src += (rect_h - 1) * line_width;
+    dst += (rect_h - 1) * line_width;
+    line_width = -line_width;
+  }
+
   while (rect_h--) {
-    memcpy (dst, src, copyrect_width);
+    memmove (dst, src, copyrect_width);
     src += line_width;
     dst += line_width;
   }
@@ -34,6 +34,13 @@ enum
 #define SUBENCODING_SUBRECTSCOLORED         16
 
 typedef struct _RfbDecoder RfbDecoder;
+typedef struct _RfbRectangle RfbRectangle;
+
+struct _RfbRectangle
+{
+  guint x, y;
+  guint w, h;
+};
 
 struct _RfbDecoder
 {
@@ -50,7 +57,6 @@ struct _RfbDecoder
   guint32 data_len;
   gpointer decoder_private;
   guint8 *frame;
-  guint8 *prev_frame;
 
   GError *error;
 
@@ -90,6 +96,10 @@ struct _RfbDecoder
 
   gint n_rects;
 
+  /* RfbRectangles of the frame updated since the last update request,
+   * clipped to the requested area */
+  GArray *damage;
+
   /* some many used values */
   guint bytespp;
   guint line_size;
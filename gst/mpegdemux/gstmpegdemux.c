@@ -51,6 +51,7 @@
 #include <gst/tag/tag.h>
 #include <gst/pbutils/pbutils.h>
 #include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
 
 #include "gstmpegdefs.h"
 #include "gstmpegdemux.h"
@@ -59,6 +60,13 @@
 #define SCAN_SCR_SZ                 12
 #define SCAN_PTS_SZ                 80
 
+/* Pulls of up to BLOCK_SZ are served from windows of this size, aligned on
+ * BLOCK_SZ */
+#define PULL_CACHE_SZ               (4 * BLOCK_SZ)
+
+/* Minimum SCR distance between two entries of the index, half a second */
+#define INDEX_INTERVAL              (CLOCK_FREQ / 2)
+
 #define SEGMENT_THRESHOLD (300*GST_MSECOND)
 #define VIDEO_SEGMENT_THRESHOLD (500*GST_MSECOND)
 
@@ -91,6 +99,7 @@ enum
 enum
 {
   PROP_0,
+  PROP_INDEX_LOCATION,
   /* FILL ME */
 };
 
@@ -138,6 +147,10 @@ static void gst_ps_demux_base_init (GstPsDemuxClass * klass);
 static void gst_ps_demux_class_init (GstPsDemuxClass * klass);
 static void gst_ps_demux_init (GstPsDemux * demux);
 static void gst_ps_demux_finalize (GstPsDemux * demux);
+static void gst_ps_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_ps_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_ps_demux_reset (GstPsDemux * demux);
 
 static gboolean gst_ps_demux_sink_event (GstPad * pad, GstObject * parent,
@@ -245,6 +258,23 @@ gst_ps_demux_class_init (GstPsDemuxClass * klass)
   gstelement_class = (GstElementClass *) klass;
 
   gobject_class->finalize = (GObjectFinalizeFunc) gst_ps_demux_finalize;
+  gobject_class->set_property = gst_ps_demux_set_property;
+  gobject_class->get_property = gst_ps_demux_get_property;
+
+  /**
+   * GstPsDemux:index-location:
+   *
+   * Location of a file to store the SCR/offset pairs seen while playing in
+   * pull mode in. If the file exists when starting, its pairs narrow down
+   * the search for the seek positions right away. The file is written again
+   * with all pairs, including the new ones, when stopping.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Location of the SCR/offset index file", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state = gst_ps_demux_change_state;
 }
@@ -275,6 +305,7 @@ gst_ps_demux_init (GstPsDemux * demux)
   demux->adapter = gst_adapter_new ();
   demux->rev_adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
+  demux->index = g_array_new (FALSE, FALSE, sizeof (GstPsDemuxIndexEntry));
 
   gst_ps_demux_reset (demux);
 }
@@ -289,10 +320,45 @@ gst_ps_demux_finalize (GstPsDemux * demux)
   gst_flow_combiner_free (demux->flowcombiner);
   g_object_unref (demux->adapter);
   g_object_unref (demux->rev_adapter);
+  g_array_free (demux->index, TRUE);
+  g_free (demux->index_location);
 
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (demux));
 }
 
+static void
+gst_ps_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPsDemux *demux = GST_PS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_LOCATION:
+      g_free (demux->index_location);
+      demux->index_location = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ps_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPsDemux *demux = GST_PS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_LOCATION:
+      g_value_set_string (value, demux->index_location);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_ps_demux_reset (GstPsDemux * demux)
 {
@@ -322,6 +388,8 @@ gst_ps_demux_reset (GstPsDemux * demux)
 
   gst_adapter_clear (demux->adapter);
   gst_adapter_clear (demux->rev_adapter);
+  gst_buffer_replace (&demux->pull_cache, NULL);
+  g_array_set_size (demux->index, 0);
 
   demux->adapter_offset = G_MAXUINT64;
   demux->first_scr = G_MAXUINT64;
@@ -1117,6 +1185,150 @@ not_supported:
   }
 }
 
+/* Returns the position of the first index entry whose SCR, or offset if
+ * @by_offset, is bigger than @value */
+static guint
+gst_ps_demux_index_upper_bound (GstPsDemux * demux, guint64 value,
+    gboolean by_offset)
+{
+  guint lo = 0, hi = demux->index->len;
+
+  while (lo < hi) {
+    guint mid = (lo + hi) / 2;
+    GstPsDemuxIndexEntry *entry =
+        &g_array_index (demux->index, GstPsDemuxIndexEntry, mid);
+
+    if ((by_offset ? entry->offset : entry->scr) <= value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static void
+gst_ps_demux_index_add (GstPsDemux * demux, guint64 scr, guint64 offset)
+{
+  GstPsDemuxIndexEntry entry, *prev = NULL, *next = NULL;
+  guint i;
+
+  i = gst_ps_demux_index_upper_bound (demux, offset, TRUE);
+  if (i > 0)
+    prev = &g_array_index (demux->index, GstPsDemuxIndexEntry, i - 1);
+  if (i < demux->index->len)
+    next = &g_array_index (demux->index, GstPsDemuxIndexEntry, i);
+
+  /* Packs after an SCR discontinuity can't be interpolated with, and
+   * entries closer than INDEX_INTERVAL don't help narrowing down seeks */
+  if (prev && (scr < prev->scr + INDEX_INTERVAL))
+    return;
+  if (next && (scr + INDEX_INTERVAL > next->scr))
+    return;
+
+  entry.scr = scr;
+  entry.offset = offset;
+  g_array_insert_val (demux->index, i, entry);
+}
+
+/* SCR/offset index files
+ *
+ * All values are big endian: "GSTPSIDX", guint32 version, guint32 number of
+ * entries, and for each entry: guint64 scr, guint64 offset
+ */
+#define INDEX_MAGIC "GSTPSIDX"
+#define INDEX_VERSION 1
+
+static void
+gst_ps_demux_load_index (GstPsDemux * demux)
+{
+  GstByteReader br;
+  GError *err = NULL;
+  gchar *contents;
+  gsize size;
+  const guint8 *magic;
+  guint32 version, n_entries, i;
+
+  if (demux->index_location == NULL)
+    return;
+
+  if (!g_file_test (demux->index_location, G_FILE_TEST_EXISTS)) {
+    GST_DEBUG_OBJECT (demux, "No index at %s yet", demux->index_location);
+    return;
+  }
+
+  if (!g_file_get_contents (demux->index_location, &contents, &size, &err)) {
+    GST_WARNING_OBJECT (demux, "Failed to load index: %s", err->message);
+    g_clear_error (&err);
+    return;
+  }
+
+  gst_byte_reader_init (&br, (const guint8 *) contents, size);
+  if (!gst_byte_reader_get_data (&br, 8, &magic) ||
+      memcmp (magic, INDEX_MAGIC, 8) != 0 ||
+      !gst_byte_reader_get_uint32_be (&br, &version) ||
+      version != INDEX_VERSION ||
+      !gst_byte_reader_get_uint32_be (&br, &n_entries) ||
+      gst_byte_reader_get_remaining (&br) / 16 < n_entries) {
+    GST_WARNING_OBJECT (demux, "Invalid index file %s",
+        demux->index_location);
+    g_free (contents);
+    return;
+  }
+
+  for (i = 0; i < n_entries; i++) {
+    guint64 scr = gst_byte_reader_get_uint64_be_unchecked (&br);
+    guint64 offset = gst_byte_reader_get_uint64_be_unchecked (&br);
+
+    gst_ps_demux_index_add (demux, scr, offset);
+  }
+  g_free (contents);
+
+  GST_INFO_OBJECT (demux, "Loaded %u index entries from %s",
+      demux->index->len, demux->index_location);
+}
+
+static void
+gst_ps_demux_save_index (GstPsDemux * demux)
+{
+  GstByteWriter bw;
+  GError *err = NULL;
+  gboolean ok = TRUE;
+  gsize size;
+  guint8 *data;
+  guint i;
+
+  if (demux->index_location == NULL || demux->index->len == 0)
+    return;
+
+  gst_byte_writer_init_with_size (&bw, 16 + 16 * demux->index->len, FALSE);
+  ok &= gst_byte_writer_put_data (&bw, (const guint8 *) INDEX_MAGIC, 8);
+  ok &= gst_byte_writer_put_uint32_be (&bw, INDEX_VERSION);
+  ok &= gst_byte_writer_put_uint32_be (&bw, demux->index->len);
+  for (i = 0; i < demux->index->len; i++) {
+    GstPsDemuxIndexEntry *entry =
+        &g_array_index (demux->index, GstPsDemuxIndexEntry, i);
+
+    ok &= gst_byte_writer_put_uint64_be (&bw, entry->scr);
+    ok &= gst_byte_writer_put_uint64_be (&bw, entry->offset);
+  }
+
+  size = gst_byte_writer_get_size (&bw);
+  data = gst_byte_writer_reset_and_get_data (&bw);
+  if (G_UNLIKELY (!ok)) {
+    GST_WARNING_OBJECT (demux, "Could not serialize index");
+  } else {
+    GST_DEBUG_OBJECT (demux, "Writing %u index entries to %s",
+        demux->index->len, demux->index_location);
+    if (!g_file_set_contents (demux->index_location, (const gchar *) data,
+            size, &err)) {
+      GST_WARNING_OBJECT (demux, "Failed to save index: %s", err->message);
+      g_clear_error (&err);
+    }
+  }
+  g_free (data);
+}
+
 #define MAX_RECURSION_COUNT 100
 
 /* Binary search for requested SCR */
@@ -1161,6 +1373,8 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   gboolean found;
   guint64 fscr, offset;
   guint64 scr = GSTTIME_TO_MPEGTIME (seeksegment->position + demux->base_time);
+  guint64 min_scr, min_scr_offset, max_scr, max_scr_offset;
+  guint i;
 
   /* In some clips the PTS values are completely unaligned with SCR values.
    * To improve the seek in that situation we apply a factor considering the
@@ -1175,9 +1389,40 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   GST_INFO_OBJECT (demux, "sink segment configured %" GST_SEGMENT_FORMAT
       ", trying to go at SCR: %" G_GUINT64_FORMAT, &demux->sink_segment, scr);
 
-  offset =
-      find_offset (demux, scr, demux->first_scr, demux->first_scr_offset,
-      demux->last_scr, demux->last_scr_offset, 0);
+  /* Start the search between the closest packs we know the SCR of */
+  min_scr = demux->first_scr;
+  min_scr_offset = demux->first_scr_offset;
+  max_scr = demux->last_scr;
+  max_scr_offset = demux->last_scr_offset;
+
+  i = gst_ps_demux_index_upper_bound (demux, scr, FALSE);
+  if (i > 0) {
+    GstPsDemuxIndexEntry *entry =
+        &g_array_index (demux->index, GstPsDemuxIndexEntry, i - 1);
+
+    if (entry->scr > min_scr && entry->scr < max_scr &&
+        entry->offset > min_scr_offset && entry->offset < max_scr_offset) {
+      min_scr = entry->scr;
+      min_scr_offset = entry->offset;
+    }
+  }
+  if (i < demux->index->len) {
+    GstPsDemuxIndexEntry *entry =
+        &g_array_index (demux->index, GstPsDemuxIndexEntry, i);
+
+    if (entry->scr > min_scr && entry->scr < max_scr &&
+        entry->offset > min_scr_offset && entry->offset < max_scr_offset) {
+      max_scr = entry->scr;
+      max_scr_offset = entry->offset;
+    }
+  }
+
+  GST_DEBUG_OBJECT (demux, "searching between SCR %" G_GUINT64_FORMAT
+      " at %" G_GUINT64_FORMAT " and SCR %" G_GUINT64_FORMAT " at %"
+      G_GUINT64_FORMAT, min_scr, min_scr_offset, max_scr, max_scr_offset);
+
+  offset = find_offset (demux, scr, min_scr, min_scr_offset, max_scr,
+      max_scr_offset, 0);
 
   if (offset == (guint64) - 1) {
     return FALSE;
@@ -1718,6 +1963,11 @@ gst_ps_demux_parse_pack_start (GstPsDemux * demux)
   }
   new_rate *= MPEG_MUX_RATE_MULT;
 
+  /* remember where this pack is to speed up later seeks */
+  if (demux->random_access && demux->sink_segment.rate >= 0 &&
+      demux->adapter_offset != G_MAXUINT64)
+    gst_ps_demux_index_add (demux, scr, demux->adapter_offset);
+
   /* scr adjusted is the new scr found + the colected adjustment */
   scr_adjusted = scr + demux->scr_adjust;
 
@@ -2584,6 +2834,67 @@ beach:
   return ret;
 }
 
+/* Pulls of up to BLOCK_SZ bytes are served from a read-ahead window, which
+ * is placed after the requested block, or before it when reading backwards.
+ * The duration scans, the seek search and forward and reverse playback then
+ * only go upstream once every few blocks. */
+static GstFlowReturn
+gst_ps_demux_pull_range (GstPsDemux * demux, guint64 offset, guint size,
+    GstBuffer ** buffer)
+{
+  GstFlowReturn ret;
+  GstBuffer *cache;
+  gboolean discont = FALSE;
+  guint64 start, end;
+  guint cache_size = PULL_CACHE_SZ;
+  gsize avail;
+
+  if (size > BLOCK_SZ)
+    return gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
+
+  if (demux->pull_cache && offset >= demux->pull_cache_offset &&
+      offset + size <= demux->pull_cache_offset +
+      gst_buffer_get_size (demux->pull_cache))
+    goto done;
+
+  if (demux->pull_cache && offset < demux->pull_cache_offset) {
+    end = ((offset + size + BLOCK_SZ - 1) / BLOCK_SZ) * BLOCK_SZ;
+    start = end > PULL_CACHE_SZ ? end - PULL_CACHE_SZ : 0;
+  } else {
+    start = (offset / BLOCK_SZ) * BLOCK_SZ;
+  }
+  if (demux->sink_segment.stop != (guint64) - 1 &&
+      start + cache_size > demux->sink_segment.stop &&
+      demux->sink_segment.stop >= offset + size)
+    cache_size = demux->sink_segment.stop - start;
+
+  cache = NULL;
+  ret = gst_pad_pull_range (demux->sinkpad, start, cache_size, &cache);
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    gst_buffer_replace (&demux->pull_cache, NULL);
+    return ret;
+  }
+  gst_buffer_replace (&demux->pull_cache, NULL);
+  demux->pull_cache = cache;
+  demux->pull_cache_offset = start;
+  discont = GST_BUFFER_IS_DISCONT (cache);
+
+done:
+  avail = gst_buffer_get_size (demux->pull_cache);
+  /* may get a short buffer at the end of the file */
+  if (G_UNLIKELY (offset >= demux->pull_cache_offset + avail))
+    return GST_FLOW_EOS;
+  size = MIN (size, demux->pull_cache_offset + avail - offset);
+
+  *buffer = gst_buffer_copy_region (demux->pull_cache, GST_BUFFER_COPY_MEMORY,
+      offset - demux->pull_cache_offset, size);
+  GST_BUFFER_OFFSET (*buffer) = offset;
+  if (discont)
+    GST_BUFFER_FLAG_SET (*buffer, GST_BUFFER_FLAG_DISCONT);
+
+  return GST_FLOW_OK;
+}
+
 static inline gboolean
 gst_ps_demux_scan_forward_ts (GstPsDemux * demux, guint64 * pos,
     SCAN_MODE mode, guint64 * rts, gint limit)
@@ -2608,7 +2919,7 @@ gst_ps_demux_scan_forward_ts (GstPsDemux * demux, guint64 * pos,
       to_read = demux->sink_segment.stop - offset;
     /* read some data */
     buffer = NULL;
-    ret = gst_pad_pull_range (demux->sinkpad, offset, to_read, &buffer);
+    ret = gst_ps_demux_pull_range (demux, offset, to_read, &buffer);
     if (G_UNLIKELY (ret != GST_FLOW_OK))
       return FALSE;
     gst_buffer_map (buffer, &map, GST_MAP_READ);
@@ -2668,7 +2979,7 @@ gst_ps_demux_scan_backward_ts (GstPsDemux * demux, guint64 * pos,
     }
     /* read some data */
     buffer = NULL;
-    ret = gst_pad_pull_range (demux->sinkpad, offset, to_read, &buffer);
+    ret = gst_ps_demux_pull_range (demux, offset, to_read, &buffer);
     if (G_UNLIKELY (ret != GST_FLOW_OK))
       return FALSE;
     gst_buffer_map (buffer, &map, GST_MAP_READ);
@@ -2812,7 +3123,7 @@ gst_ps_demux_pull_block (GstPad * pad, GstPsDemux * demux,
 {
   GstFlowReturn ret;
   GstBuffer *buffer = NULL;
-  ret = gst_pad_pull_range (pad, offset, size, &buffer);
+  ret = gst_ps_demux_pull_range (demux, offset, size, &buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_DEBUG_OBJECT (demux, "pull range at %" G_GUINT64_FORMAT
         " size %u failed", offset, size);
@@ -3181,6 +3492,7 @@ gst_ps_demux_change_state (GstElement * element, GstStateChange transition)
       demux->filter.gather_pes = TRUE;
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_ps_demux_load_index (demux);
       break;
     default:
       break;
@@ -3189,6 +3501,7 @@ gst_ps_demux_change_state (GstElement * element, GstStateChange transition)
   result = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_ps_demux_save_index (demux);
       gst_ps_demux_reset (demux);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
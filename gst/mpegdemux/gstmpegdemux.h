@@ -102,6 +102,13 @@ struct _GstPsStream
   GstTagList *pending_tags;
 };
 
+/* A pack whose SCR is known, see GstPsDemux::index */
+typedef struct
+{
+  guint64 scr;
+  guint64 offset;
+} GstPsDemuxIndexEntry;
+
 struct _GstPsDemux
 {
   GstElement parent;
@@ -156,6 +163,15 @@ struct _GstPsDemux
 
   /* Indicates an MPEG-2 stream */
   gboolean is_mpeg2_pack;
+
+  /* Read-ahead window small pulls are served from in pull mode */
+  GstBuffer *pull_cache;
+  guint64 pull_cache_offset;
+
+  /* GstPsDemuxIndexEntry of the packs seen while playing in pull mode,
+   * sorted by offset and SCR, and the file it is stored in */
+  GArray *index;
+  gchar *index_location;
 };
 
 struct _GstPsDemuxClass
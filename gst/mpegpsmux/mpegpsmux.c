@@ -54,10 +54,12 @@ GST_DEBUG_CATEGORY (mpegpsmux_debug);
 
 enum
 {
-  PROP_AGGREGATE_GOPS = 1
+  PROP_AGGREGATE_GOPS = 1,
+  PROP_BATCH_PACKETS
 };
 
 #define DEFAULT_AGGREGATE_GOPS FALSE
+#define DEFAULT_BATCH_PACKETS 0
 
 static GstStaticPadTemplate mpegpsmux_sink_factory =
     GST_STATIC_PAD_TEMPLATE ("sink_%u",
@@ -94,7 +96,7 @@ static void gst_mpegpsmux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static void mpegpsmux_finalize (GObject * object);
-static gboolean new_packet_cb (guint8 * data, guint len, void *user_data);
+static gboolean new_packet_cb (GstBuffer * buf, void *user_data);
 
 static gboolean mpegpsdemux_prepare_srcpad (MpegPsMux * mux);
 static GstFlowReturn mpegpsmux_collected (GstCollectPads * pads,
@@ -127,6 +129,22 @@ mpegpsmux_class_init (MpegPsMuxClass * klass)
           "Whether to aggregate GOPs and push them out as buffer lists",
           DEFAULT_AGGREGATE_GOPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * MpegPsMux:batch-packets:
+   *
+   * Collect at least this many packets (pack headers, system headers,
+   * program stream maps and PES packets) before pushing them downstream as
+   * one buffer list. Ignored when #MpegPsMux:aggregate-gops is set.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_PACKETS,
+      g_param_spec_uint ("batch-packets", "Batch packets",
+          "Collect at least this many packets before pushing them downstream "
+          "as one buffer list (0 = push every packet on its own)",
+          0, G_MAXUINT, DEFAULT_BATCH_PACKETS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class,
       &mpegpsmux_sink_factory);
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -156,6 +174,7 @@ mpegpsmux_init (MpegPsMux * mux)
   mux->first = TRUE;
   mux->last_flow_ret = GST_FLOW_OK;
   mux->last_ts = 0;             /* XXX: or -1? */
+  mux->batch_packets = DEFAULT_BATCH_PACKETS;
 }
 
 static void
@@ -190,6 +209,9 @@ gst_mpegpsmux_set_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_GOPS:
       mux->aggregate_gops = g_value_get_boolean (value);
       break;
+    case PROP_BATCH_PACKETS:
+      mux->batch_packets = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -206,6 +228,9 @@ gst_mpegpsmux_get_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_GOPS:
       g_value_set_boolean (value, mux->aggregate_gops);
       break;
+    case PROP_BATCH_PACKETS:
+      g_value_set_uint (value, mux->batch_packets);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -569,6 +594,13 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
       }
     }
     mux->last_ts = best->last_ts;
+
+    if (!mux->aggregate_gops && mux->gop_list != NULL &&
+        gst_buffer_list_length (mux->gop_list) >= mux->batch_packets) {
+      ret = mpegpsmux_push_gop_list (mux);
+      if (ret != GST_FLOW_OK)
+        goto done;
+    }
   } else {
     /* FIXME: Drain all remaining streams */
     /* At EOS */
@@ -659,23 +691,20 @@ mpegpsmux_release_pad (GstElement * element, GstPad * pad)
 }
 
 static gboolean
-new_packet_cb (guint8 * data, guint len, void *user_data)
+new_packet_cb (GstBuffer * buf, void *user_data)
 {
   /* Called when the PsMux has prepared a packet for output. Return FALSE
    * on error */
 
   MpegPsMux *mux = (MpegPsMux *) user_data;
-  GstBuffer *buf;
   GstFlowReturn ret;
 
-  GST_LOG_OBJECT (mux, "Outputting a packet of length %d", len);
-
-  data = g_memdup (data, len);
-  buf = gst_buffer_new_wrapped (data, len);
+  GST_LOG_OBJECT (mux, "Outputting a packet of length %" G_GSIZE_FORMAT,
+      gst_buffer_get_size (buf));
 
   GST_BUFFER_TIMESTAMP (buf) = mux->last_ts;
 
-  if (mux->aggregate_gops) {
+  if (mux->aggregate_gops || mux->batch_packets > 0) {
     if (mux->gop_list == NULL)
       mux->gop_list = gst_buffer_list_new ();
 
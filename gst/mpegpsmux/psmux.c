@@ -54,7 +54,7 @@
 #include "psmux.h"
 #include "crc.h"
 
-static gboolean psmux_packet_out (PsMux * mux);
+static gboolean psmux_packet_out (PsMux * mux, GstBuffer * buf);
 static gboolean psmux_write_pack_header (PsMux * mux);
 static gboolean psmux_write_system_header (PsMux * mux);
 static gboolean psmux_write_program_stream_map (PsMux * mux);
@@ -115,7 +115,8 @@ gboolean
 psmux_write_end_code (PsMux * mux)
 {
   guint8 end_code[4] = { 0, 0, 1, PSMUX_PROGRAM_END };
-  return mux->write_func (end_code, 4, mux->write_func_data);
+  return psmux_packet_out (mux, gst_buffer_new_wrapped (g_memdup (end_code,
+              4), 4));
 }
 
 
@@ -203,19 +204,21 @@ psmux_create_stream (PsMux * mux, PsMuxStreamType stream_type)
 }
 
 static gboolean
-psmux_packet_out (PsMux * mux)
+psmux_packet_out (PsMux * mux, GstBuffer * buf)
 {
   gboolean res;
-  if (G_UNLIKELY (mux->write_func == NULL))
+  gsize size = gst_buffer_get_size (buf);
+
+  if (G_UNLIKELY (mux->write_func == NULL)) {
+    gst_buffer_unref (buf);
     return TRUE;
+  }
 
-  res = mux->write_func (mux->packet_buf, mux->packet_bytes_written,
-      mux->write_func_data);
+  res = mux->write_func (buf, mux->write_func_data);
 
   if (res) {
-    mux->bit_size += mux->packet_bytes_written;
+    mux->bit_size += size;
   }
-  mux->packet_bytes_written = 0;
   return res;
 }
 
@@ -232,6 +235,7 @@ gboolean
 psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
 {
   gboolean res;
+  GstBuffer *buf;
 
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
@@ -279,14 +283,13 @@ psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
     mux->psm_pts = mux->pts;
   }
 
-  /* Write the packet */
-  if (!(mux->packet_bytes_written =
-          psmux_stream_get_data (stream, mux->packet_buf,
+  /* Write the packet, referencing the payload from the input buffers */
+  if (!(buf = psmux_stream_get_data (stream,
               mux->pes_max_payload + PSMUX_PES_MAX_HDR_LEN))) {
     return FALSE;
   }
 
-  res = psmux_packet_out (mux);
+  res = psmux_packet_out (mux, buf);
   if (!res) {
     GST_DEBUG_OBJECT (mux, "packet write false");
     return FALSE;
@@ -302,11 +305,17 @@ psmux_write_pack_header (PsMux * mux)
 {
   bits_buffer_t bw;
   guint64 scr = mux->pts;       /* XXX: is this correct? necessary to put any offset? */
+  GstBuffer *buf;
+  GstMapInfo map;
+
   if (mux->pts == -1)
     scr = 0;
 
+  buf = gst_buffer_new_allocate (NULL, 14, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+
   /* pack_start_code */
-  bits_initwrite (&bw, 14, mux->packet_buf);
+  bits_initwrite (&bw, 14, map.data);
   bits_write (&bw, 24, PSMUX_START_CODE_PREFIX);
   bits_write (&bw, 8, PSMUX_PACK_HEADER);
 
@@ -334,8 +343,8 @@ psmux_write_pack_header (PsMux * mux)
   bits_write (&bw, 5, 0x1f);
   bits_write (&bw, 3, 0);       /* pack_stuffing_length */
 
-  mux->packet_bytes_written = 14;
-  return psmux_packet_out (mux);
+  gst_buffer_unmap (buf, &map);
+  return psmux_packet_out (mux, buf);
 }
 
 static void
@@ -396,16 +405,10 @@ psmux_ensure_system_header (PsMux * mux)
 static gboolean
 psmux_write_system_header (PsMux * mux)
 {
-  GstMapInfo map;
-
   psmux_ensure_system_header (mux);
 
-  gst_buffer_map (mux->sys_header, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
-  gst_buffer_unmap (mux->sys_header, &map);
-
-  return psmux_packet_out (mux);
+  /* shares the memory of the cached header */
+  return psmux_packet_out (mux, gst_buffer_copy (mux->sys_header));
 }
 
 static void
@@ -480,16 +483,10 @@ psmux_ensure_program_stream_map (PsMux * mux)
 static gboolean
 psmux_write_program_stream_map (PsMux * mux)
 {
-  GstMapInfo map;
-
   psmux_ensure_program_stream_map (mux);
 
-  gst_buffer_map (mux->psm, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
-  gst_buffer_unmap (mux->psm, &map);
-
-  return psmux_packet_out (mux);
+  /* shares the memory of the cached map */
+  return psmux_packet_out (mux, gst_buffer_copy (mux->psm));
 }
 
 GList *
@@ -63,6 +63,7 @@ enum
 {
   PROP_0,
   PROP_PARSE_PRIVATE_SECTIONS,
+  PROP_INDEX_LOCATION,
   /* FILL ME */
 };
 
@@ -138,6 +139,23 @@ mpegts_base_class_init (MpegTSBaseClass * klass)
           "Parse private sections", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMpegTSBase:index-location:
+   *
+   * Location of a file to store the PCR/offset observations of the stream
+   * in. If the file exists when starting in pull mode and was built from
+   * the same stream, its observations are used for seeking right away. The
+   * end of the stream is then only scanned if upstream grew since. The file
+   * is written again with all observations, including the new ones, when
+   * stopping.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Location of the PCR/offset index file", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
 }
 
 static void
@@ -150,6 +168,10 @@ mpegts_base_set_property (GObject * object, guint prop_id,
     case PROP_PARSE_PRIVATE_SECTIONS:
       base->parse_private_sections = g_value_get_boolean (value);
       break;
+    case PROP_INDEX_LOCATION:
+      g_free (base->index_location);
+      base->index_location = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -165,6 +187,9 @@ mpegts_base_get_property (GObject * object, guint prop_id,
     case PROP_PARSE_PRIVATE_SECTIONS:
       g_value_set_boolean (value, base->parse_private_sections);
       break;
+    case PROP_INDEX_LOCATION:
+      g_value_set_string (value, base->index_location);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -195,6 +220,8 @@ mpegts_base_reset (MpegTSBase * base)
   /* ATSC */
   MPEGTS_BIT_SET (base->known_psi, 0x1ffb);
 
+  base->pid_filter_changed = FALSE;
+
   if (base->pat) {
     g_ptr_array_unref (base->pat);
     base->pat = NULL;
@@ -206,6 +233,7 @@ mpegts_base_reset (MpegTSBase * base)
   base->mode = BASE_MODE_STREAMING;
   base->seen_pat = FALSE;
   base->seek_offset = -1;
+  base->index_size = 0;
 
   g_hash_table_foreach_remove (base->programs, (GHRFunc) remove_each_program,
       base);
@@ -273,6 +301,7 @@ mpegts_base_finalize (GObject * object)
     base->pat = NULL;
   }
   g_hash_table_destroy (base->programs);
+  g_free (base->index_location);
 
   if (G_OBJECT_CLASS (parent_class)->finalize)
     G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -866,6 +895,8 @@ mpegts_base_deactivate_program (MpegTSBase * base, MpegTSBaseProgram * program)
     GST_DEBUG ("program stream_list is now %p", program->stream_list);
   }
 
+  base->pid_filter_changed = TRUE;
+
   /* Inform subclasses we're deactivating this program */
   if (klass->program_stopped)
     klass->program_stopped (base, program);
@@ -927,6 +958,7 @@ mpegts_base_activate_program (MpegTSBase * base, MpegTSBaseProgram * program,
 
   program->active = TRUE;
   program->initial_program = initial_program;
+  base->pid_filter_changed = TRUE;
 
   klass = GST_MPEGTS_BASE_GET_CLASS (base);
   if (klass->program_started != NULL)
@@ -1042,6 +1074,8 @@ mpegts_base_apply_pat (MpegTSBase * base, GstMpegtsSection * section)
     g_ptr_array_unref (old_pat);
   }
 
+  base->pid_filter_changed = TRUE;
+
   return TRUE;
 }
 
@@ -1199,6 +1233,7 @@ mpegts_base_parse_atsc_mgt (MpegTSBase * base, GstMpegtsSection * section)
         (table->table_type >= GST_MPEGTS_ATSC_MGT_TABLE_TYPE_ETT0 &&
             table->table_type <= GST_MPEGTS_ATSC_MGT_TABLE_TYPE_ETT127)) {
       MPEGTS_BIT_SET (base->known_psi, table->pid);
+      base->pid_filter_changed = TRUE;
     }
   }
 
@@ -1353,6 +1388,39 @@ mpegts_base_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return res;
 }
 
+/* Tell upstream which PIDs we handle, so that sources like dvbsrc can
+ * filter out all other PIDs */
+static void
+mpegts_base_push_pid_filter (MpegTSBase * base)
+{
+  GValue pids = G_VALUE_INIT;
+  GValue v = G_VALUE_INIT;
+  GstStructure *s;
+  guint pid;
+
+  base->pid_filter_changed = FALSE;
+
+  g_value_init (&pids, GST_TYPE_ARRAY);
+  g_value_init (&v, G_TYPE_UINT);
+
+  for (pid = 0; pid < 0x1fff; pid++) {
+    if (MPEGTS_BIT_IS_SET (base->is_pes, pid)
+        || MPEGTS_BIT_IS_SET (base->known_psi, pid)) {
+      g_value_set_uint (&v, pid);
+      gst_value_array_append_value (&pids, &v);
+    }
+  }
+  g_value_unset (&v);
+
+  GST_DEBUG_OBJECT (base, "Requesting %u PIDs from upstream",
+      gst_value_array_get_size (&pids));
+
+  s = gst_structure_new_empty ("mpegts-pid-filter");
+  gst_structure_take_value (s, "pids", &pids);
+  gst_pad_push_event (base->sinkpad,
+      gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, s));
+}
+
 static GstFlowReturn
 mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1390,9 +1458,16 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   }
 
   mpegts_packetizer_push (base->packetizer, buf);
+  base->input_buffer = buf;
 
   while (res == GST_FLOW_OK) {
-    pret = mpegts_packetizer_next_packet (base->packetizer, &packet);
+    /* Packets on PIDs we don't handle are dropped by the packetizer, unless
+     * the subclass wants to inspect all of them */
+    if (klass->inspect_packet)
+      pret = mpegts_packetizer_next_packet (base->packetizer, &packet);
+    else
+      pret = mpegts_packetizer_next_wanted_packet (base->packetizer, &packet,
+          base->is_pes, base->known_psi);
 
     /* If we don't have enough data, return */
     if (G_UNLIKELY (pret == PACKET_NEED_MORE))
@@ -1437,6 +1512,11 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   next:
     mpegts_packetizer_clear_packet (base->packetizer, &packet);
   }
+  base->input_buffer = NULL;
+
+  /* Subclasses inspecting all packets need all PIDs from upstream */
+  if (G_UNLIKELY (base->pid_filter_changed) && !klass->inspect_packet)
+    mpegts_base_push_pid_filter (base);
 
   if (klass->input_done) {
     if (res == GST_FLOW_OK)
@@ -1448,6 +1528,37 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return res;
 }
 
+/* Replaces the observations of the initial scan by those of the index if
+ * it matches the stream. Returns TRUE if the index already covers all of
+ * upstream, in which case the end doesn't need to be scanned */
+static gboolean
+mpegts_base_load_index (MpegTSBase * base, guint64 upstream_size)
+{
+  GError *err = NULL;
+  guint64 indexed_size;
+
+  if (base->index_location == NULL)
+    return FALSE;
+
+  if (!g_file_test (base->index_location, G_FILE_TEST_EXISTS)) {
+    GST_DEBUG_OBJECT (base, "No index at %s yet", base->index_location);
+    return FALSE;
+  }
+
+  if (!mpegts_packetizer_load_index (base->packetizer, base->index_location,
+          upstream_size, base->packetsize, &indexed_size, &err)) {
+    GST_WARNING_OBJECT (base, "Ignoring index: %s", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (base, "Loaded index from %s, built for %" G_GUINT64_FORMAT
+      " of %" G_GUINT64_FORMAT " bytes", base->index_location, indexed_size,
+      upstream_size);
+
+  return indexed_size == upstream_size;
+}
+
 static GstFlowReturn
 mpegts_base_scan (MpegTSBase * base)
 {
@@ -1511,6 +1622,14 @@ mpegts_base_scan (MpegTSBase * base)
     goto beach;
   upstream_size = tmpval;
 
+  /* Finish the groups of the initial scan before replacing them */
+  mpegts_packetizer_clear (base->packetizer);
+  if (mpegts_base_load_index (base, upstream_size)) {
+    GST_DEBUG ("Index covers all of upstream, not scanning the end");
+    base->index_size = upstream_size;
+    goto beach;
+  }
+
   /* The scanning takes place on the last 2048kB. Considering PCR should
    * be present at least every 100ms, this should cope with streams
    * up to 160Mbit/s */
@@ -1542,6 +1661,7 @@ mpegts_base_scan (MpegTSBase * base)
       if (base->packetizer->nb_seen_offsets > initial_pcr_seen) {
         GST_DEBUG ("Got last PCR(s) (total seen:%d)",
             base->packetizer->nb_seen_offsets);
+        base->index_size = upstream_size;
         break;
       }
     }
@@ -1813,6 +1933,26 @@ mpegts_base_sink_activate_mode (GstPad * pad, GstObject * parent,
   return res;
 }
 
+static void
+mpegts_base_save_index (MpegTSBase * base)
+{
+  GError *err = NULL;
+  guint16 packet_size;
+
+  if (base->index_location == NULL)
+    return;
+
+  packet_size = base->packetizer->packet_size;
+  if (packet_size == 0)
+    packet_size = base->packetsize;
+
+  if (!mpegts_packetizer_save_index (base->packetizer, base->index_location,
+          base->index_size, packet_size, &err)) {
+    GST_WARNING_OBJECT (base, "Failed to save index: %s", err->message);
+    g_clear_error (&err);
+  }
+}
+
 static GstStateChangeReturn
 mpegts_base_change_state (GstElement * element, GstStateChange transition)
 {
@@ -1833,6 +1973,7 @@ mpegts_base_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      mpegts_base_save_index (base);
       mpegts_base_reset (base);
       if (base->mode != BASE_MODE_PUSHING)
         base->mode = BASE_MODE_SCANNING;
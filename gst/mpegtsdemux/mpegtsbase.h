@@ -158,9 +158,23 @@ struct _MpegTSBase {
   gboolean push_data;
   gboolean push_section;
 
+  /* The buffer being processed by the chain function, for subclasses
+   * referencing the memory of the packets instead of copying them.
+   * NULL in pull mode */
+  GstBuffer *input_buffer;
+
   /* Whether the parent bin is streams-aware, meaning we can
    * add/remove streams at any point in time */
   gboolean streams_aware;
+
+  /* Whether the set of known PES/PSI PIDs changed and upstream should be
+   * told about it with a mpegts-pid-filter event */
+  gboolean pid_filter_changed;
+
+  /* PCR/offset index file, and the upstream size up to which the
+   * observations are known to reach (0 if the end wasn't scanned) */
+  gchar *index_location;
+  guint64 index_size;
 };
 
 struct _MpegTSBaseClass {
@@ -33,6 +33,9 @@
 #define PCR_GST_MAX_VALUE (PCR_MAX_VALUE * GST_MSECOND / (PCR_MSECOND))
 #define PTS_DTS_MAX_VALUE (((guint64)1) << 33)
 
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
+
 #include "mpegtspacketizer.h"
 #include "gstmpegdesc.h"
 
@@ -134,21 +137,15 @@ mpegts_packetizer_get_current_time (MpegTSPacketizer2 * packetizer,
       pcr_pid);
 }
 
+#define SUBTABLE_KEY(table_id, subtable_extension) \
+  GUINT_TO_POINTER (((guint) (table_id) << 16) | (subtable_extension))
+
 static inline MpegTSPacketizerStreamSubtable *
-find_subtable (GSList * subtables, guint8 table_id, guint16 subtable_extension)
+find_subtable (GHashTable * subtables, guint8 table_id,
+    guint16 subtable_extension)
 {
-  GSList *tmp;
-
-  /* FIXME: Make this an array ! */
-  for (tmp = subtables; tmp; tmp = tmp->next) {
-    MpegTSPacketizerStreamSubtable *sub =
-        (MpegTSPacketizerStreamSubtable *) tmp->data;
-    if (sub->table_id == table_id
-        && sub->subtable_extension == subtable_extension)
-      return sub;
-  }
-
-  return NULL;
+  return g_hash_table_lookup (subtables, SUBTABLE_KEY (table_id,
+          subtable_extension));
 }
 
 static gboolean
@@ -192,6 +189,13 @@ mpegts_packetizer_stream_subtable_new (guint8 table_id,
   return subtable;
 }
 
+static void
+mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
+    subtable)
+{
+  g_free (subtable);
+}
+
 static MpegTSPacketizerStream *
 mpegts_packetizer_stream_new (guint16 pid)
 {
@@ -199,7 +203,8 @@ mpegts_packetizer_stream_new (guint16 pid)
 
   stream = (MpegTSPacketizerStream *) g_new0 (MpegTSPacketizerStream, 1);
   stream->continuity_counter = CONTINUITY_UNSET;
-  stream->subtables = NULL;
+  stream->subtables = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) mpegts_packetizer_stream_subtable_free);
   stream->table_id = TABLE_ID_UNSET;
   stream->pid = pid;
   return stream;
@@ -216,20 +221,11 @@ mpegts_packetizer_clear_section (MpegTSPacketizerStream * stream)
   stream->section_data = NULL;
 }
 
-static void
-mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
-    subtable)
-{
-  g_free (subtable);
-}
-
 static void
 mpegts_packetizer_stream_free (MpegTSPacketizerStream * stream)
 {
   mpegts_packetizer_clear_section (stream);
-  g_slist_foreach (stream->subtables,
-      (GFunc) mpegts_packetizer_stream_subtable_free, NULL);
-  g_slist_free (stream->subtables);
+  g_hash_table_unref (stream->subtables);
   g_free (stream);
 }
 
@@ -516,7 +512,9 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
         stream->subtable_extension, stream->last_section_number);
     subtable->version_number = stream->version_number;
 
-    stream->subtables = g_slist_prepend (stream->subtables, subtable);
+    g_hash_table_insert (stream->subtables,
+        SUBTABLE_KEY (stream->table_id, stream->subtable_extension),
+        subtable);
   }
 
   GST_MEMDUMP ("Full section data", stream->section_data,
@@ -813,9 +811,10 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   return found;
 }
 
-MpegTSPacketizerPacketReturn
-mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
-    MpegTSPacketizerPacket * packet)
+static inline MpegTSPacketizerPacketReturn
+mpegts_packetizer_next_packet_filtered (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packet, const guint8 * pes_pids,
+    const guint8 * psi_pids)
 {
   guint8 *packet_data;
   guint packet_size;
@@ -851,6 +850,20 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
       GST_DEBUG ("lost sync");
       packetizer->need_sync = TRUE;
     } else {
+      if (pes_pids) {
+        guint16 pid = GST_READ_UINT16_BE (packet_data + 1) & 0x1FFF;
+
+        /* Skip packets on unwanted PIDs right away, without parsing them.
+         * The following ones are already mapped, so this loops through all
+         * of them in the mapped data before going back to the adapter */
+        if (!MPEGTS_BIT_IS_SET (pes_pids, pid)
+            && !MPEGTS_BIT_IS_SET (psi_pids, pid)) {
+          packetizer->map_offset += packet_size;
+          packetizer->offset += packet_size;
+          continue;
+        }
+      }
+
       /* ALL mpeg-ts variants contain 188 bytes of data. Those with bigger
        * packet sizes contain either extra data (timesync, FEC, ..) either
        * before or after the data */
@@ -866,6 +879,26 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
   }
 }
 
+MpegTSPacketizerPacketReturn
+mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packet)
+{
+  return mpegts_packetizer_next_packet_filtered (packetizer, packet, NULL,
+      NULL);
+}
+
+/* Like mpegts_packetizer_next_packet(), but only returns packets on PIDs
+ * set in either the @pes_pids or the @psi_pids bitfield and skips over
+ * all others with as little work as possible */
+MpegTSPacketizerPacketReturn
+mpegts_packetizer_next_wanted_packet (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packet, const guint8 * pes_pids,
+    const guint8 * psi_pids)
+{
+  return mpegts_packetizer_next_packet_filtered (packetizer, packet, pes_pids,
+      psi_pids);
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet (MpegTSPacketizer2 * packetizer)
 {
@@ -2539,3 +2572,303 @@ mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
   }
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
+
+/* PCR/offset index files
+ *
+ * These store the PCR/offset groups of all PCR PIDs, so that a stream can
+ * be seeked in without scanning it first. All values are big endian:
+ *
+ *   "GSTTSIDX", guint32 version,
+ *   guint64 upstream size (0 if its end wasn't scanned), guint16 packet size,
+ *   guint64 first pcr, guint64 first offset,
+ *   guint16 number of PIDs
+ *   for each PID: guint16 pid, guint32 number of groups
+ *     for each group: guint32 flags, guint64 first_pcr, first_offset,
+ *       pcr_offset, guint32 number of values
+ *       for each value: guint64 pcr, guint64 offset
+ *
+ * The upstream size, packet size and first PCR/offset observation identify
+ * the stream the index was built from.
+ */
+#define INDEX_MAGIC "GSTTSIDX"
+#define INDEX_VERSION 2
+#define INDEX_N_TABLES_POS 38
+
+/* Returns the PCR/offset of the group starting first in the stream.
+ * Must be called with the group lock taken */
+static gboolean
+_get_first_observation (MpegTSPacketizer2 * packetizer, guint64 * pcr,
+    guint64 * offset)
+{
+  gboolean found = FALSE;
+  guint i;
+
+  for (i = 0; i < packetizer->lastobsid; i++) {
+    MpegTSPCR *pcrtable = packetizer->observations[i];
+    PCROffsetGroup *group;
+
+    if (pcrtable->groups == NULL)
+      continue;
+
+    group = (PCROffsetGroup *) pcrtable->groups->data;
+    if (!found || group->first_offset < *offset) {
+      *pcr = group->first_pcr;
+      *offset = group->first_offset;
+      found = TRUE;
+    }
+  }
+
+  return found;
+}
+
+gboolean
+mpegts_packetizer_save_index (MpegTSPacketizer2 * packetizer,
+    const gchar * location, guint64 upstream_size, guint16 packet_size,
+    GError ** error)
+{
+  GstByteWriter bw;
+  gboolean ok = TRUE, res;
+  guint i, n_tables = 0;
+  guint64 first_pcr, first_offset;
+  gsize size;
+  guint8 *data;
+
+  PACKETIZER_GROUP_LOCK (packetizer);
+  if (!_get_first_observation (packetizer, &first_pcr, &first_offset)) {
+    PACKETIZER_GROUP_UNLOCK (packetizer);
+    GST_DEBUG ("No PCR observations, not writing index");
+    return TRUE;
+  }
+
+  gst_byte_writer_init (&bw);
+  ok &= gst_byte_writer_put_data (&bw, (const guint8 *) INDEX_MAGIC, 8);
+  ok &= gst_byte_writer_put_uint32_be (&bw, INDEX_VERSION);
+  ok &= gst_byte_writer_put_uint64_be (&bw, upstream_size);
+  ok &= gst_byte_writer_put_uint16_be (&bw, packet_size);
+  ok &= gst_byte_writer_put_uint64_be (&bw, first_pcr);
+  ok &= gst_byte_writer_put_uint64_be (&bw, first_offset);
+  /* Number of PIDs, filled in below */
+  ok &= gst_byte_writer_put_uint16_be (&bw, 0);
+
+  for (i = 0; i < packetizer->lastobsid; i++) {
+    MpegTSPCR *pcrtable = packetizer->observations[i];
+    PCROffsetCurrent *current = pcrtable->current;
+    GList *tmp;
+
+    if (pcrtable->groups == NULL)
+      continue;
+
+    ok &= gst_byte_writer_put_uint16_be (&bw, pcrtable->pid);
+    ok &= gst_byte_writer_put_uint32_be (&bw,
+        g_list_length (pcrtable->groups));
+
+    for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
+      PCROffsetGroup *group = (PCROffsetGroup *) tmp->data;
+      gboolean has_pending = current && current->group == group &&
+          (current->pending[current->last].offset !=
+          group->values[group->last_value].offset);
+      guint j;
+
+      ok &= gst_byte_writer_put_uint32_be (&bw, group->flags);
+      ok &= gst_byte_writer_put_uint64_be (&bw, group->first_pcr);
+      ok &= gst_byte_writer_put_uint64_be (&bw, group->first_offset);
+      ok &= gst_byte_writer_put_uint64_be (&bw, group->pcr_offset);
+      ok &= gst_byte_writer_put_uint32_be (&bw,
+          group->last_value + 1 + (has_pending ? 1 : 0));
+      for (j = 0; j <= group->last_value; j++) {
+        ok &= gst_byte_writer_put_uint64_be (&bw, group->values[j].pcr);
+        ok &= gst_byte_writer_put_uint64_be (&bw, group->values[j].offset);
+      }
+      /* The group being filled doesn't contain the latest observation yet */
+      if (has_pending) {
+        ok &= gst_byte_writer_put_uint64_be (&bw,
+            current->pending[current->last].pcr);
+        ok &= gst_byte_writer_put_uint64_be (&bw,
+            current->pending[current->last].offset);
+      }
+    }
+    n_tables++;
+  }
+  PACKETIZER_GROUP_UNLOCK (packetizer);
+
+  size = gst_byte_writer_get_size (&bw);
+  data = gst_byte_writer_reset_and_get_data (&bw);
+  if (G_UNLIKELY (!ok)) {
+    g_free (data);
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOMEM,
+        "Could not serialize index");
+    return FALSE;
+  }
+
+  GST_WRITE_UINT16_BE (data + INDEX_N_TABLES_POS, n_tables);
+
+  GST_DEBUG ("Writing index with %u PCR PIDs to %s", n_tables, location);
+  res = g_file_set_contents (location, (const gchar *) data, size, error);
+  g_free (data);
+
+  return res;
+}
+
+/* Reads one group from the index, checking that its values only go
+ * forward, both within the group and compared to the previous group
+ * (whose last offset is in @last_offset) */
+static PCROffsetGroup *
+_read_index_group (GstByteReader * br, guint64 * last_offset)
+{
+  PCROffsetGroup *group;
+  guint32 flags, n_values, k;
+  guint64 first_pcr, first_offset, pcr_offset, pcr, offset;
+
+  if (!gst_byte_reader_get_uint32_be (br, &flags) ||
+      !gst_byte_reader_get_uint64_be (br, &first_pcr) ||
+      !gst_byte_reader_get_uint64_be (br, &first_offset) ||
+      !gst_byte_reader_get_uint64_be (br, &pcr_offset) ||
+      !gst_byte_reader_get_uint32_be (br, &n_values) || n_values == 0 ||
+      gst_byte_reader_get_remaining (br) / 16 < n_values)
+    return NULL;
+
+  if (*last_offset != G_MAXUINT64 && first_offset < *last_offset) {
+    GST_WARNING ("Group offset %" G_GUINT64_FORMAT " goes backwards",
+        first_offset);
+    return NULL;
+  }
+
+  /* The first value is always 0/0 */
+  pcr = gst_byte_reader_get_uint64_be_unchecked (br);
+  offset = gst_byte_reader_get_uint64_be_unchecked (br);
+  if (pcr != 0 || offset != 0)
+    return NULL;
+
+  group = _new_group (first_pcr, first_offset, pcr_offset, flags);
+  for (k = 1; k < n_values; k++) {
+    PCROffset value;
+
+    value.pcr = gst_byte_reader_get_uint64_be_unchecked (br);
+    value.offset = gst_byte_reader_get_uint64_be_unchecked (br);
+    if (value.pcr < group->values[group->last_value].pcr ||
+        value.offset <= group->values[group->last_value].offset) {
+      GST_WARNING ("PCR/offset goes backwards in group at offset %"
+          G_GUINT64_FORMAT, first_offset);
+      pcr_offset_group_free (group);
+      return NULL;
+    }
+    _append_group_values (group, value);
+  }
+  *last_offset = first_offset + group->values[group->last_value].offset;
+
+  return group;
+}
+
+/* Loads the groups of an index file. The groups of the stream observed so
+ * far are used to check that the index belongs to it, and are then replaced.
+ * Must be called with no group being filled, e.g. after
+ * mpegts_packetizer_clear().
+ *
+ * @indexed_size is set to the size of upstream when the index was
+ * written. The index is rejected if it doesn't match the stream in any
+ * way, including upstream being smaller than it. */
+gboolean
+mpegts_packetizer_load_index (MpegTSPacketizer2 * packetizer,
+    const gchar * location, guint64 upstream_size, guint16 packet_size,
+    guint64 * indexed_size, GError ** error)
+{
+  GstByteReader br;
+  gchar *contents;
+  gsize size;
+  const guint8 *magic;
+  const gchar *reason = "Invalid index file";
+  guint32 version;
+  guint64 idx_size, idx_first_pcr, idx_first_offset, first_pcr, first_offset;
+  guint16 idx_packet_size, n_tables = 0;
+  guint16 pids[MAX_PCR_OBS_CHANNELS];
+  GList *groups[MAX_PCR_OBS_CHANNELS] = { NULL, };
+  guint i, n_new = 0;
+  gboolean has_first;
+
+  if (!g_file_get_contents (location, &contents, &size, error))
+    return FALSE;
+
+  gst_byte_reader_init (&br, (const guint8 *) contents, size);
+
+  if (!gst_byte_reader_get_data (&br, 8, &magic) ||
+      memcmp (magic, INDEX_MAGIC, 8) != 0 ||
+      !gst_byte_reader_get_uint32_be (&br, &version) ||
+      version != INDEX_VERSION ||
+      !gst_byte_reader_get_uint64_be (&br, &idx_size) ||
+      !gst_byte_reader_get_uint16_be (&br, &idx_packet_size) ||
+      !gst_byte_reader_get_uint64_be (&br, &idx_first_pcr) ||
+      !gst_byte_reader_get_uint64_be (&br, &idx_first_offset) ||
+      !gst_byte_reader_get_uint16_be (&br, &n_tables) ||
+      n_tables > MAX_PCR_OBS_CHANNELS)
+    goto invalid;
+
+  if (idx_packet_size != packet_size) {
+    reason = "Index was built for a different packet size";
+    goto invalid;
+  }
+  if (idx_size > upstream_size) {
+    reason = "Index was built for a larger stream";
+    goto invalid;
+  }
+
+  PACKETIZER_GROUP_LOCK (packetizer);
+  has_first = _get_first_observation (packetizer, &first_pcr, &first_offset);
+  PACKETIZER_GROUP_UNLOCK (packetizer);
+  if (!has_first || first_pcr != idx_first_pcr
+      || first_offset != idx_first_offset) {
+    reason = "Index was built for a different stream";
+    goto invalid;
+  }
+
+  /* Read and check everything before using any of it */
+  for (i = 0; i < n_tables; i++) {
+    guint64 last_offset = G_MAXUINT64;
+    guint32 n_groups, j;
+
+    if (!gst_byte_reader_get_uint16_be (&br, &pids[i]) || pids[i] >= 0x2000 ||
+        !gst_byte_reader_get_uint32_be (&br, &n_groups))
+      goto invalid;
+
+    for (j = 0; j < n_groups; j++) {
+      PCROffsetGroup *group = _read_index_group (&br, &last_offset);
+
+      if (group == NULL)
+        goto invalid;
+      groups[i] = g_list_prepend (groups[i], group);
+    }
+    groups[i] = g_list_reverse (groups[i]);
+
+    if (packetizer->observations[packetizer->pcrtablelut[pids[i]]] == NULL)
+      n_new++;
+  }
+
+  PACKETIZER_GROUP_LOCK (packetizer);
+  if (packetizer->lastobsid + n_new > MAX_PCR_OBS_CHANNELS - 1) {
+    PACKETIZER_GROUP_UNLOCK (packetizer);
+    reason = "Too many PCR PIDs in index";
+    goto invalid;
+  }
+  for (i = 0; i < n_tables; i++) {
+    MpegTSPCR *pcrtable = get_pcr_table (packetizer, pids[i]);
+
+    g_assert (pcrtable->current->group == NULL);
+    GST_DEBUG ("Loaded %u groups for PCR PID 0x%04x",
+        g_list_length (groups[i]), pids[i]);
+    g_list_free_full (pcrtable->groups, (GDestroyNotify) pcr_offset_group_free);
+    pcrtable->groups = groups[i];
+    groups[i] = NULL;
+  }
+  PACKETIZER_GROUP_UNLOCK (packetizer);
+
+  *indexed_size = idx_size;
+  g_free (contents);
+  return TRUE;
+
+invalid:
+  for (i = 0; i < n_tables && i < MAX_PCR_OBS_CHANNELS; i++)
+    g_list_free_full (groups[i], (GDestroyNotify) pcr_offset_group_free);
+  g_free (contents);
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+      "%s: %s", reason, location);
+  return FALSE;
+}
@@ -85,7 +85,10 @@ typedef struct
   guint8  section_number;
   guint8  last_section_number;
 
-  GSList *subtables;
+  /* MpegTSPacketizerStreamSubtable, by SUBTABLE_KEY (table_id,
+   * subtable_extension). EIT PIDs carry one subtable per table_id and
+   * service, so this can get large */
+  GHashTable *subtables;
 
   /* Upstream offset of the data contained in the section */
   guint64 offset;
@@ -345,6 +348,9 @@ G_GNUC_INTERNAL gboolean mpegts_packetizer_has_packets (MpegTSPacketizer2 *packe
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn mpegts_packetizer_next_packet (MpegTSPacketizer2 *packetizer,
   MpegTSPacketizerPacket *packet);
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
+mpegts_packetizer_next_wanted_packet (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packet, const guint8 *pes_pids, const guint8 *psi_pids);
+G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet(MpegTSPacketizer2 * packetizer);
 G_GNUC_INTERNAL void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetizer,
 				     MpegTSPacketizerPacket *packet);
@@ -375,6 +381,15 @@ mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
 G_GNUC_INTERNAL void
 mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
 					guint64 refoffset);
+G_GNUC_INTERNAL gboolean
+mpegts_packetizer_save_index (MpegTSPacketizer2 * packetizer,
+			      const gchar * location, guint64 upstream_size,
+			      guint16 packet_size, GError ** error);
+G_GNUC_INTERNAL gboolean
+mpegts_packetizer_load_index (MpegTSPacketizer2 * packetizer,
+			      const gchar * location, guint64 upstream_size,
+			      guint16 packet_size, guint64 * indexed_size,
+			      GError ** error);
 G_GNUC_INTERNAL void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
 					GstClockTime threshold);
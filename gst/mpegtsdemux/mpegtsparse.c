@@ -64,6 +64,22 @@ struct _MpegTSParsePad
 
   /* the return of the latest push */
   GstFlowReturn flow_return;
+
+  /* the packets for this pad from the current input buffer, which are
+   * pushed together once the input buffer is done. Runs of consecutive
+   * packets of the input buffer become one sub-buffer of it, the run being
+   * collected is run_offset/run_size. */
+  GstBufferList *pending;
+  gsize run_offset;
+  gsize run_size;
+
+  /* single program PAT replacing the PAT of the input */
+  guint8 pat_packet[MPEGTS_NORMAL_PACKETSIZE];
+  gboolean have_pat;
+  guint8 pat_version;
+  guint16 pat_ts_id;
+  guint16 pat_pmt_pid;
+  guint8 pat_cc;
 };
 
 static GstStaticPadTemplate src_template =
@@ -84,9 +100,12 @@ enum
   PROP_SET_TIMESTAMPS,
   PROP_SMOOTHING_LATENCY,
   PROP_PCR_PID,
+  PROP_REWRITE_PAT,
   /* FILL ME */
 };
 
+#define DEFAULT_REWRITE_PAT FALSE
+
 static void mpegts_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void mpegts_parse_get_property (GObject * object, guint prop_id,
@@ -123,6 +142,7 @@ static GstFlowReturn mpegts_parse_input_done (MpegTSBase * base,
     GstBuffer * buffer);
 static GstFlowReturn
 drain_pending_buffers (MpegTSParse2 * parse, gboolean drain_all);
+static void mpegts_parse_release_input (MpegTSParse2 * parse);
 
 static void
 mpegts_parse_dispose (GObject * object)
@@ -159,6 +179,19 @@ mpegts_parse_class_init (MpegTSParse2Class * klass)
       g_param_spec_int ("pcr-pid", "PID containing PCR",
           "Set the PID to use for PCR values (-1 for auto)",
           -1, G_MAXINT, -1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * MpegTSParse2:rewrite-pat:
+   *
+   * Replace the PAT on the program pads with one only listing the program
+   * of the pad, so that each of them carries a complete single program
+   * transport stream.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_REWRITE_PAT,
+      g_param_spec_boolean ("rewrite-pat", "Rewrite PAT",
+          "Give the program pads a PAT only listing their program",
+          DEFAULT_REWRITE_PAT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   element_class = GST_ELEMENT_CLASS (klass);
   element_class->pad_removed = mpegts_parse_pad_removed;
@@ -207,6 +240,7 @@ mpegts_parse_init (MpegTSParse2 * parse)
 
   parse->have_group_id = FALSE;
   parse->group_id = G_MAXUINT;
+  parse->rewrite_pat = DEFAULT_REWRITE_PAT;
 }
 
 static void
@@ -244,6 +278,8 @@ mpegts_parse_reset (MpegTSBase * base)
   g_list_free_full (parse->pending_buffers, (GDestroyNotify) gst_buffer_unref);
   parse->pending_buffers = NULL;
 
+  mpegts_parse_release_input (parse);
+
   parse->current_pcr = GST_CLOCK_TIME_NONE;
   parse->previous_pcr = GST_CLOCK_TIME_NONE;
   parse->base_pcr = GST_CLOCK_TIME_NONE;
@@ -270,6 +306,9 @@ mpegts_parse_set_property (GObject * object, guint prop_id,
     case PROP_PCR_PID:
       parse->pcr_pid = parse->user_pcr_pid = g_value_get_int (value);
       break;
+    case PROP_REWRITE_PAT:
+      parse->rewrite_pat = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -291,6 +330,9 @@ mpegts_parse_get_property (GObject * object, guint prop_id,
     case PROP_PCR_PID:
       g_value_set_int (value, parse->pcr_pid);
       break;
+    case PROP_REWRITE_PAT:
+      g_value_set_boolean (value, parse->rewrite_pat);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -357,6 +399,131 @@ prepare_src_pad (MpegTSBase * base, MpegTSParse2 * parse)
   return TRUE;
 }
 
+static void
+mpegts_parse_tspad_clear_pending (MpegTSParsePad * tspad)
+{
+  gst_buffer_list_unref (tspad->pending);
+  tspad->pending = gst_buffer_list_new ();
+  tspad->run_size = 0;
+}
+
+/* Adds the run of packets collected so far as a sub-buffer of the input */
+static void
+mpegts_parse_tspad_end_run (MpegTSParse2 * parse, MpegTSParsePad * tspad)
+{
+  if (tspad->run_size == 0)
+    return;
+
+  gst_buffer_list_add (tspad->pending,
+      gst_buffer_copy_region (parse->input_buffer, GST_BUFFER_COPY_MEMORY,
+          tspad->run_offset, tspad->run_size));
+  tspad->run_size = 0;
+}
+
+static void
+mpegts_parse_tspad_add_data (MpegTSParse2 * parse, MpegTSParsePad * tspad,
+    const guint8 * data, gsize size)
+{
+  MpegTSBase *base = (MpegTSBase *) parse;
+
+  if (parse->input_buffer != base->input_buffer) {
+    mpegts_parse_release_input (parse);
+    if (base->input_buffer &&
+        gst_buffer_map (base->input_buffer, &parse->input_map, GST_MAP_READ))
+      parse->input_buffer = gst_buffer_ref (base->input_buffer);
+  }
+
+  /* packets that are in the memory of the input buffer are referenced, the
+   * others (spanning two input buffers, or in pull mode) are copied */
+  if (parse->input_buffer && data >= parse->input_map.data &&
+      data + size <= parse->input_map.data + parse->input_map.size) {
+    gsize offset = data - parse->input_map.data;
+
+    if (tspad->run_size && tspad->run_offset + tspad->run_size == offset) {
+      tspad->run_size += size;
+    } else {
+      mpegts_parse_tspad_end_run (parse, tspad);
+      tspad->run_offset = offset;
+      tspad->run_size = size;
+    }
+  } else {
+    mpegts_parse_tspad_end_run (parse, tspad);
+    gst_buffer_list_add (tspad->pending,
+        gst_buffer_new_wrapped (g_memdup (data, size), size));
+  }
+}
+
+/* Ends the runs of all pads, which reference the input buffer, and lets go
+ * of it */
+static void
+mpegts_parse_release_input (MpegTSParse2 * parse)
+{
+  GList *tmp;
+
+  if (parse->input_buffer == NULL)
+    return;
+
+  GST_OBJECT_LOCK (parse);
+  for (tmp = parse->srcpads; tmp; tmp = tmp->next) {
+    MpegTSParsePad *tspad = gst_pad_get_element_private (tmp->data);
+
+    mpegts_parse_tspad_end_run (parse, tspad);
+  }
+  GST_OBJECT_UNLOCK (parse);
+
+  gst_buffer_unmap (parse->input_buffer, &parse->input_map);
+  gst_buffer_unref (parse->input_buffer);
+  parse->input_buffer = NULL;
+}
+
+static GstFlowReturn
+mpegts_parse_tspad_push_pending (MpegTSParse2 * parse, MpegTSParsePad * tspad)
+{
+  GstBufferList *list;
+  GstFlowReturn ret;
+
+  mpegts_parse_tspad_end_run (parse, tspad);
+
+  if (gst_buffer_list_length (tspad->pending) == 0)
+    return GST_FLOW_OK;
+
+  list = tspad->pending;
+  tspad->pending = gst_buffer_list_new ();
+
+  ret = gst_pad_push_list (tspad->pad, list);
+  ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+
+  GST_LOG_OBJECT (parse, "Returning %s", gst_flow_get_name (ret));
+  return ret;
+}
+
+static GstFlowReturn
+mpegts_parse_push_pending (MpegTSParse2 * parse)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *srcpads, *tmp;
+
+  GST_OBJECT_LOCK (parse);
+  srcpads = g_list_copy_deep (parse->srcpads, (GCopyFunc) gst_object_ref,
+      NULL);
+  GST_OBJECT_UNLOCK (parse);
+
+  /* every pad gets its data, each push updates the flow combiner, so the
+   * result of the last one accounts for all the pads */
+  for (tmp = srcpads; tmp; tmp = tmp->next) {
+    MpegTSParsePad *tspad = gst_pad_get_element_private (tmp->data);
+
+    if (tspad->run_size == 0 && gst_buffer_list_length (tspad->pending) == 0)
+      continue;
+
+    ret = mpegts_parse_tspad_push_pending (parse, tspad);
+  }
+
+  g_list_free_full (srcpads, gst_object_unref);
+
+  return ret;
+}
+
 static gboolean
 push_event (MpegTSBase * base, GstEvent * event)
 {
@@ -380,6 +547,14 @@ push_event (MpegTSBase * base, GstEvent * event)
   for (tmp = parse->srcpads; tmp; tmp = tmp->next) {
     GstPad *pad = (GstPad *) tmp->data;
     if (pad) {
+      MpegTSParsePad *tspad = gst_pad_get_element_private (pad);
+
+      /* keep queued packets in order with the event */
+      if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+        mpegts_parse_tspad_clear_pending (tspad);
+      else if (GST_EVENT_IS_SERIALIZED (event))
+        mpegts_parse_tspad_push_pending (parse, tspad);
+
       gst_event_ref (event);
       gst_pad_push_event (pad, event);
     }
@@ -407,6 +582,7 @@ mpegts_parse_create_tspad (MpegTSParse2 * parse, const gchar * pad_name)
   tspad->program = NULL;
   tspad->pushed = FALSE;
   tspad->flow_return = GST_FLOW_NOT_LINKED;
+  tspad->pending = gst_buffer_list_new ();
   gst_pad_set_element_private (pad, tspad);
   gst_flow_combiner_add_pad (parse->flowcombiner, pad);
 
@@ -416,6 +592,8 @@ mpegts_parse_create_tspad (MpegTSParse2 * parse, const gchar * pad_name)
 static void
 mpegts_parse_destroy_tspad (MpegTSParse2 * parse, MpegTSParsePad * tspad)
 {
+  gst_buffer_list_unref (tspad->pending);
+
   /* free the wrapper */
   g_free (tspad);
 }
@@ -525,6 +703,61 @@ mpegts_parse_release_pad (GstElement * element, GstPad * pad)
   gst_element_remove_pad (element, pad);
 }
 
+/* Updates the cached single program PAT of the pad from the PAT of the
+ * input, returns FALSE if there is none */
+static gboolean
+mpegts_parse_tspad_update_pat (MpegTSParse2 * parse, MpegTSParsePad * tspad,
+    GstMpegtsSection * section)
+{
+  MpegTSBaseProgram *program = (MpegTSBaseProgram *) tspad->program;
+  GstMpegtsPatProgram *pat_program;
+  GstMpegtsSection *pat;
+  GPtrArray *programs;
+  guint8 *data;
+  gsize size;
+
+  if (tspad->have_pat && tspad->pat_version == section->version_number &&
+      tspad->pat_ts_id == section->subtable_extension &&
+      tspad->pat_pmt_pid == program->pmt_pid)
+    return TRUE;
+
+  programs = gst_mpegts_pat_new ();
+  pat_program = gst_mpegts_pat_program_new ();
+  pat_program->program_number = program->program_number;
+  pat_program->network_or_program_map_PID = program->pmt_pid;
+  g_ptr_array_add (programs, pat_program);
+
+  pat = gst_mpegts_section_from_pat (programs, section->subtable_extension);
+  pat->version_number = section->version_number;
+  data = gst_mpegts_section_packetize (pat, &size);
+  if (data == NULL || size > MPEGTS_NORMAL_PACKETSIZE - 5) {
+    gst_mpegts_section_unref (pat);
+    tspad->have_pat = FALSE;
+    return FALSE;
+  }
+
+  /* sync byte, payload unit start on PID 0, payload only and a pointer field,
+   * the continuity counter is set for each packet */
+  memset (tspad->pat_packet, 0xff, MPEGTS_NORMAL_PACKETSIZE);
+  tspad->pat_packet[0] = 0x47;
+  tspad->pat_packet[1] = 0x40;
+  tspad->pat_packet[2] = 0x00;
+  tspad->pat_packet[3] = 0x10;
+  tspad->pat_packet[4] = 0x00;
+  memcpy (tspad->pat_packet + 5, data, size);
+  gst_mpegts_section_unref (pat);
+
+  tspad->have_pat = TRUE;
+  tspad->pat_version = section->version_number;
+  tspad->pat_ts_id = section->subtable_extension;
+  tspad->pat_pmt_pid = program->pmt_pid;
+
+  GST_DEBUG_OBJECT (parse, "New PAT for program %d, PMT PID 0x%04x",
+      program->program_number, program->pmt_pid);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 mpegts_parse_tspad_push_section (MpegTSParse2 * parse, MpegTSParsePad * tspad,
     GstMpegtsSection * section, MpegTSPacketizerPacket * packet)
@@ -553,15 +786,24 @@ mpegts_parse_tspad_push_section (MpegTSParse2 * parse, MpegTSParsePad * tspad,
       "pushing section: %d program number: %d table_id: %d", to_push,
       tspad->program_number, section->table_id);
 
-  if (to_push) {
-    GstBuffer *buf =
-        gst_buffer_new_and_alloc (packet->data_end - packet->data_start);
-    gst_buffer_fill (buf, 0, packet->data_start,
-        packet->data_end - packet->data_start);
-    ret = gst_pad_push (tspad->pad, buf);
-    ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+  if (to_push && parse->rewrite_pat && section->table_id == 0x00 &&
+      tspad->program) {
+    if (mpegts_parse_tspad_update_pat (parse, tspad, section)) {
+      guint8 *pat = g_memdup (tspad->pat_packet, MPEGTS_NORMAL_PACKETSIZE);
+
+      pat[3] = 0x10 | tspad->pat_cc;
+      tspad->pat_cc = (tspad->pat_cc + 1) & 0x0f;
+      mpegts_parse_tspad_end_run (parse, tspad);
+      gst_buffer_list_add (tspad->pending,
+          gst_buffer_new_wrapped (pat, MPEGTS_NORMAL_PACKETSIZE));
+      to_push = FALSE;
+    }
   }
 
+  if (to_push)
+    mpegts_parse_tspad_add_data (parse, tspad, packet->data_start,
+        packet->data_end - packet->data_start);
+
   GST_LOG_OBJECT (parse, "Returning %s", gst_flow_get_name (ret));
   return ret;
 }
@@ -584,13 +826,9 @@ mpegts_parse_tspad_push (MpegTSParse2 * parse, MpegTSParsePad * tspad,
   if (bp) {
     if (packet->pid == bp->pmt_pid || bp->streams == NULL
         || bp->streams[packet->pid]) {
-      GstBuffer *buf =
-          gst_buffer_new_and_alloc (packet->data_end - packet->data_start);
-      gst_buffer_fill (buf, 0, packet->data_start,
-          packet->data_end - packet->data_start);
       /* push if there's no filter or if the pid is in the filter */
-      ret = gst_pad_push (tspad->pad, buf);
-      ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+      mpegts_parse_tspad_add_data (parse, tspad, packet->data_start,
+          packet->data_end - packet->data_start);
     }
   }
   GST_DEBUG_OBJECT (parse, "Returning %s", gst_flow_get_name (ret));
@@ -865,6 +1103,15 @@ mpegts_parse_input_done (MpegTSBase * base, GstBuffer * buffer)
 
   GST_LOG_OBJECT (parse, "Received buffer %" GST_PTR_FORMAT, buffer);
 
+  /* push what was collected for the program pads from this buffer at once,
+   * instead of a buffer per packet */
+  ret = mpegts_parse_push_pending (parse);
+  if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED) {
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+  ret = GST_FLOW_OK;
+
   if (parse->current_pcr != GST_CLOCK_TIME_NONE) {
     GST_DEBUG_OBJECT (parse,
         "InputTS %" GST_TIME_FORMAT " PCR %" GST_TIME_FORMAT,
@@ -70,6 +70,11 @@ struct _MpegTSParse2 {
   /* state */
   gboolean first;
   gboolean set_timestamps;
+  gboolean rewrite_pat;
+
+  /* the input buffer the program pads reference packets from */
+  GstBuffer *input_buffer;
+  GstMapInfo input_map;
 
   /* Pending buffer state */
   GList *pending_buffers;
@@ -168,6 +168,9 @@ struct _TSDemuxStream
   guint current_size;
   /* Size of ->data */
   guint allocated_size;
+  /* Running average of the size of the PES packets without a packet
+   * length, used to size ->data up front */
+  guint pes_size_estimate;
 
   /* Current PTS/DTS for this stream (in running time) */
   GstClockTime pts;
@@ -2294,11 +2297,14 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
   data += header.header_size;
   length -= header.header_size;
 
-  /* Create the output buffer */
+  /* Create the output buffer. Video PES packets usually don't have a
+   * length, so size them from the packets seen so far, with some headroom
+   * for larger frames, instead of growing by several reallocations. */
   if (stream->expected_size)
     stream->allocated_size = MAX (stream->expected_size, length);
   else
-    stream->allocated_size = MAX (8192, length);
+    stream->allocated_size = MAX (MAX (8192, length),
+        stream->pes_size_estimate + stream->pes_size_estimate / 4);
 
   g_assert (stream->data == NULL);
   stream->data = g_malloc (stream->allocated_size);
@@ -2812,6 +2818,14 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     goto beach;
   }
 
+  if (stream->expected_size == 0) {
+    if (stream->pes_size_estimate == 0)
+      stream->pes_size_estimate = stream->current_size;
+    else
+      stream->pes_size_estimate =
+          ((guint64) stream->pes_size_estimate * 7 + stream->current_size) / 8;
+  }
+
   if (G_UNLIKELY (demux->program == NULL)) {
     GST_LOG_OBJECT (demux, "No program");
     g_free (stream->data);
@@ -113,11 +113,17 @@ enum
   PROP_PAT_INTERVAL,
   PROP_PMT_INTERVAL,
   PROP_ALIGNMENT,
-  PROP_SI_INTERVAL
+  PROP_SI_INTERVAL,
+  PROP_BATCH_PACKETS,
+  PROP_BATCH_DURATION,
+  PROP_BITRATE
 };
 
 #define MPEGTSMUX_DEFAULT_ALIGNMENT    -1
 #define MPEGTSMUX_DEFAULT_M2TS         FALSE
+#define MPEGTSMUX_DEFAULT_BATCH_PACKETS  0
+#define MPEGTSMUX_DEFAULT_BATCH_DURATION 0
+#define MPEGTSMUX_DEFAULT_BITRATE        0
 
 static GstStaticPadTemplate mpegtsmux_sink_factory =
     GST_STATIC_PAD_TEMPLATE ("sink_%d",
@@ -178,6 +184,7 @@ static void release_buffer_cb (guint8 * data, void *user_data);
 static GstFlowReturn mpegtsmux_collect_packet (MpegTsMux * mux,
     GstBuffer * buf);
 static GstFlowReturn mpegtsmux_push_packets (MpegTsMux * mux, gboolean force);
+static gboolean mpegtsmux_batch_is_complete (MpegTsMux * mux);
 static gboolean new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf,
     gint64 new_pcr);
 
@@ -303,6 +310,29 @@ mpegtsmux_class_init (MpegTsMuxClass * klass)
           "Set the interval (in ticks of the 90kHz clock) for writing out the Service"
           "Information tables", 1, G_MAXUINT, TSMUX_DEFAULT_SI_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_BATCH_PACKETS,
+      g_param_spec_uint ("batch-packets", "Batch packets",
+          "Collect at least this many packets before pushing them downstream "
+          "as one buffer list (0 = push after every input buffer)",
+          0, G_MAXUINT, MPEGTSMUX_DEFAULT_BATCH_PACKETS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_BATCH_DURATION, g_param_spec_uint64 ("batch-duration",
+          "Batch duration",
+          "Collect packets spanning at least this duration (in nanoseconds) "
+          "before pushing them downstream as one buffer list "
+          "(0 = push after every input buffer)",
+          0, G_MAXUINT64, MPEGTSMUX_DEFAULT_BATCH_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_BITRATE,
+      g_param_spec_uint64 ("bitrate", "Bitrate (in bits per second)",
+          "Set the target bitrate, will insert null packets as padding "
+          "to achieve a constant bitrate (0 = variable bitrate)",
+          0, G_MAXUINT64, MPEGTSMUX_DEFAULT_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -336,6 +366,9 @@ mpegtsmux_init (MpegTsMux * mux)
   mux->si_interval = TSMUX_DEFAULT_SI_INTERVAL;
   mux->prog_map = NULL;
   mux->alignment = MPEGTSMUX_DEFAULT_ALIGNMENT;
+  mux->batch_packets = MPEGTSMUX_DEFAULT_BATCH_PACKETS;
+  mux->batch_duration = MPEGTSMUX_DEFAULT_BATCH_DURATION;
+  mux->bitrate = MPEGTSMUX_DEFAULT_BITRATE;
 
   /* initial state */
   mpegtsmux_reset (mux, TRUE);
@@ -382,6 +415,7 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
   mux->previous_pcr = -1;
   mux->pcr_rate_num = mux->pcr_rate_den = 1;
   mux->last_ts = 0;
+  mux->batch_start_ts = GST_CLOCK_TIME_NONE;
   mux->is_delta = TRUE;
 
   mux->streamheader_sent = FALSE;
@@ -426,6 +460,7 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
     mux->tsmux = tsmux_new ();
     tsmux_set_write_func (mux->tsmux, new_packet_cb, mux);
     tsmux_set_alloc_func (mux->tsmux, alloc_packet_cb, mux);
+    tsmux_set_bitrate (mux->tsmux, mux->bitrate);
   }
 }
 
@@ -506,6 +541,17 @@ gst_mpegtsmux_set_property (GObject * object, guint prop_id,
       mux->si_interval = g_value_get_uint (value);
       tsmux_set_si_interval (mux->tsmux, mux->si_interval);
       break;
+    case PROP_BATCH_PACKETS:
+      mux->batch_packets = g_value_get_uint (value);
+      break;
+    case PROP_BATCH_DURATION:
+      mux->batch_duration = g_value_get_uint64 (value);
+      break;
+    case PROP_BITRATE:
+      mux->bitrate = g_value_get_uint64 (value);
+      if (mux->tsmux)
+        tsmux_set_bitrate (mux->tsmux, mux->bitrate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -537,6 +583,15 @@ gst_mpegtsmux_get_property (GObject * object, guint prop_id,
     case PROP_SI_INTERVAL:
       g_value_set_uint (value, mux->si_interval);
       break;
+    case PROP_BATCH_PACKETS:
+      g_value_set_uint (value, mux->batch_packets);
+      break;
+    case PROP_BATCH_DURATION:
+      g_value_set_uint64 (value, mux->batch_duration);
+      break;
+    case PROP_BITRATE:
+      g_value_set_uint64 (value, mux->bitrate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1367,6 +1422,8 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
       GST_INFO_OBJECT (mux, "pushing downstream force-key-unit event %d "
           "%" GST_TIME_FORMAT " count %d", gst_event_get_seqnum (event),
           GST_TIME_ARGS (running_time), count);
+      /* packets of the previous key unit must not end up after the event */
+      mpegtsmux_push_packets (mux, FALSE);
       gst_pad_push_event (mux->srcpad, event);
 
       /* output PAT */
@@ -1438,8 +1495,9 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
   GST_DEBUG_OBJECT (mux, "delta: %d", delta);
 
   stream_data = stream_data_new (buf);
-  tsmux_stream_add_data (best->stream, stream_data->map_info.data,
-      stream_data->map_info.size, stream_data, pts, dts, !delta);
+  tsmux_stream_add_data_buffer (best->stream, stream_data->buffer,
+      stream_data->map_info.data, stream_data->map_info.size, stream_data,
+      pts, dts, !delta);
 
   /* outgoing ts follows ts of PCR program stream */
   if (prog->pcr_stream == best->stream) {
@@ -1461,7 +1519,10 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
       goto write_fail;
     }
   }
-  /* flush packet cache */
+  /* flush packet cache, unless a larger batch was requested */
+  if (!mpegtsmux_batch_is_complete (mux))
+    return GST_FLOW_OK;
+
   return mpegtsmux_push_packets (mux, FALSE);
 
   /* ERRORS */
@@ -1599,6 +1660,30 @@ new_packet_common_init (MpegTsMux * mux, GstBuffer * buf, guint8 * data,
   }
 }
 
+/* Whether enough packets were collected to be pushed downstream, according
+ * to the batch-packets and batch-duration properties */
+static gboolean
+mpegtsmux_batch_is_complete (MpegTsMux * mux)
+{
+  gint packet_size;
+  gsize av;
+
+  if (mux->batch_packets == 0 && mux->batch_duration == 0)
+    return TRUE;
+
+  packet_size = mux->m2ts_mode ? M2TS_PACKET_LENGTH : NORMAL_TS_PACKET_LENGTH;
+  av = gst_adapter_available (mux->out_adapter);
+
+  if (mux->batch_packets > 0 && av / packet_size >= mux->batch_packets)
+    return TRUE;
+
+  if (mux->batch_duration > 0 && GST_CLOCK_TIME_IS_VALID (mux->batch_start_ts)
+      && mux->last_ts >= mux->batch_start_ts + mux->batch_duration)
+    return TRUE;
+
+  return FALSE;
+}
+
 static GstFlowReturn
 mpegtsmux_push_packets (MpegTsMux * mux, gboolean force)
 {
@@ -1709,6 +1794,11 @@ mpegtsmux_collect_packet (MpegTsMux * mux, GstBuffer * buf)
 {
   GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT,
       gst_buffer_get_size (buf));
+
+  /* first packet of a new batch */
+  if (gst_adapter_available (mux->out_adapter) == 0)
+    mux->batch_start_ts = GST_BUFFER_PTS (buf);
+
   gst_adapter_push (mux->out_adapter, buf);
 
   return GST_FLOW_OK;
@@ -1789,7 +1879,8 @@ new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf, gint64 new_pcr)
 
       GST_BUFFER_PTS (out_buf) = ts;
 
-      gst_buffer_map (out_buf, &map, GST_MAP_WRITE);
+      /* only map the prefix memory, see new_packet_cb() */
+      gst_buffer_map_range (out_buf, 0, 1, &map, GST_MAP_WRITE);
 
       /* The header is the bottom 30 bits of the PCR, apparently not
        * encoded into base + ext as in the packets themselves */
@@ -1805,7 +1896,7 @@ new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf, gint64 new_pcr)
   if (G_UNLIKELY (!buf))
     goto exit;
 
-  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  gst_buffer_map_range (buf, 0, 1, &map, GST_MAP_WRITE);
 
   /* Finally, output the passed in packet */
   /* Only write the bottom 30 bits of the PCR */
@@ -1841,20 +1932,18 @@ new_packet_cb (GstBuffer * buf, void *user_data, gint64 new_pcr)
 #endif
 
   if (mux->m2ts_mode) {
+    /* Prepend a separate memory for the timestamp prefix, so packets that
+     * reference payload memory do not need to be merged */
     offset = 4;
-    gst_buffer_set_size (buf, NORMAL_TS_PACKET_LENGTH + offset);
+    gst_buffer_prepend_memory (buf, gst_allocator_alloc (NULL, offset, NULL));
   }
 
-  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
-
-  if (offset) {
-    /* there should be a better way to do this */
-    memmove (map.data + offset, map.data, map.size - offset);
-  }
+  /* The TS header is always contained in the first memory after the prefix */
+  gst_buffer_map_range (buf, offset ? 1 : 0, 1, &map, GST_MAP_READ);
 
   GST_BUFFER_PTS (buf) = mux->last_ts;
   /* do common init (flags and streamheaders) */
-  new_packet_common_init (mux, buf, map.data + offset, map.size);
+  new_packet_common_init (mux, buf, map.data, map.size);
 
   gst_buffer_unmap (buf, &map);
 
@@ -1871,15 +1960,10 @@ new_packet_cb (GstBuffer * buf, void *user_data, gint64 new_pcr)
 static void
 alloc_packet_cb (GstBuffer ** _buf, void *user_data)
 {
-  MpegTsMux *mux = (MpegTsMux *) user_data;
   GstBuffer *buf;
-  gint offset = 0;
-
-  if (mux->m2ts_mode == TRUE)
-    offset = 4;
 
-  buf = gst_buffer_new_and_alloc (NORMAL_TS_PACKET_LENGTH + offset);
-  gst_buffer_set_size (buf, NORMAL_TS_PACKET_LENGTH);
+  /* any m2ts prefix is prepended as separate memory in new_packet_cb() */
+  buf = gst_buffer_new_and_alloc (NORMAL_TS_PACKET_LENGTH);
 
   *_buf = buf;
 }
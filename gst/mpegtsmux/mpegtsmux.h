@@ -139,6 +139,9 @@ struct MpegTsMux {
   guint pmt_interval;
   gint alignment;
   guint si_interval;
+  guint batch_packets;
+  GstClockTime batch_duration;
+  guint64 bitrate;
 
   /* state */
   gboolean first;
@@ -163,6 +166,7 @@ struct MpegTsMux {
   /* output buffer aggregation */
   GstAdapter *out_adapter;
   GstBuffer *out_buffer;
+  GstClockTime batch_start_ts;
 
 #if 0
   /* SPN/PTS index handling */
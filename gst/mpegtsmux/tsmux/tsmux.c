@@ -109,16 +109,23 @@
 /* Times per second to write PCR */
 #define TSMUX_DEFAULT_PCR_FREQ (25)
 
+/* Largest gap filled with null packets in CBR mode, a larger one is a
+ * timestamp discontinuity. 1 second */
+#define TSMUX_MAX_PADDING TSMUX_SYS_CLOCK_FREQ
+
 /* Base for all written PCR and DTS/PTS,
  * so we have some slack to go backwards */
 #define CLOCK_BASE (TSMUX_CLOCK_FREQ * 10 * 360)
 
 static gboolean tsmux_write_pat (TsMux * mux);
 static gboolean tsmux_write_pmt (TsMux * mux, TsMuxProgram * program);
+static void tsmux_section_clear_packets (TsMuxSection * section);
+
 static void
 tsmux_section_free (TsMuxSection * section)
 {
   gst_mpegts_section_unref (section->section);
+  tsmux_section_clear_packets (section);
   g_slice_free (TsMuxSection, section);
 }
 
@@ -153,6 +160,10 @@ tsmux_new (void)
   mux->si_sections = g_hash_table_new_full (g_direct_hash, g_direct_equal,
       NULL, (GDestroyNotify) tsmux_section_free);
 
+  mux->bitrate = 0;
+  mux->n_bytes = 0;
+  mux->first_pcr = -1;
+
   return mux;
 }
 
@@ -228,6 +239,42 @@ tsmux_get_pat_interval (TsMux * mux)
   return mux->pat_interval;
 }
 
+/**
+ * tsmux_set_bitrate:
+ * @mux: a #TsMux
+ * @bitrate: the output bitrate in bits per second, or 0
+ *
+ * Set the bitrate of the output. If @bitrate is not 0, packets are scheduled
+ * against a virtual clock running at @bitrate, null packets are inserted to
+ * keep the output at a constant bitrate and PCR values are derived from the
+ * output position. Setting a new bitrate restarts the virtual clock.
+ */
+void
+tsmux_set_bitrate (TsMux * mux, guint64 bitrate)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->bitrate = bitrate;
+  mux->n_bytes = 0;
+  mux->first_pcr = -1;
+}
+
+/**
+ * tsmux_get_bitrate:
+ * @mux: a #TsMux
+ *
+ * Get the configured output bitrate. See also tsmux_set_bitrate().
+ *
+ * Returns: the configured bitrate, 0 for variable bitrate output
+ */
+guint64
+tsmux_get_bitrate (TsMux * mux)
+{
+  g_return_val_if_fail (mux != NULL, 0);
+
+  return mux->bitrate;
+}
+
 /**
  * tsmux_set_si_interval:
  * @mux: a #TsMux
@@ -311,6 +358,7 @@ tsmux_free (TsMux * mux)
   /* Free PAT section */
   if (mux->pat.section)
     gst_mpegts_section_unref (mux->pat.section);
+  tsmux_section_clear_packets (&mux->pat);
 
   /* Free all programs */
   for (cur = mux->programs; cur; cur = cur->next) {
@@ -585,6 +633,10 @@ tsmux_get_buffer (TsMux * mux, GstBuffer ** buf)
 static gboolean
 tsmux_packet_out (TsMux * mux, GstBuffer * buf, gint64 pcr)
 {
+  /* position of the virtual output clock in CBR mode */
+  if (mux->bitrate && mux->first_pcr != -1)
+    mux->n_bytes += TSMUX_PACKET_LENGTH;
+
   if (G_UNLIKELY (mux->write_func == NULL)) {
     if (buf)
       gst_buffer_unref (buf);
@@ -841,25 +893,28 @@ tsmux_write_ts_header (guint8 * buf, TsMuxPacketInfo * pi,
   return TRUE;
 }
 
+/* Drop the cached packets of @section, needs to be called whenever
+ * the GstMpegtsSection of @section is replaced */
+static void
+tsmux_section_clear_packets (TsMuxSection * section)
+{
+  g_free (section->packets);
+  section->packets = NULL;
+  section->n_packets = 0;
+}
+
+/* Packetize @section into TS packets once, only the continuity counter
+ * changes between repetitions of the same section */
 static gboolean
-tsmux_section_write_packet (GstMpegtsSectionType * type,
-    TsMuxSection * section, TsMux * mux)
+tsmux_section_build_packets (TsMuxSection * section)
 {
-  GstBuffer *section_buffer;
-  GstBuffer *packet_buffer = NULL;
-  GstMemory *mem;
-  guint8 *packet;
+  TsMuxPacketInfo pi;
   guint8 *data;
+  guint8 *packet;
   gsize data_size = 0;
   gsize payload_written;
   guint len = 0, offset = 0, payload_len = 0;
-  guint extra_alloc_bytes = 0;
-
-  g_return_val_if_fail (section != NULL, FALSE);
-  g_return_val_if_fail (mux != NULL, FALSE);
-
-  /* Mark the start of new PES unit */
-  section->pi.packet_start_unit_indicator = TRUE;
+  guint n_packets;
 
   data = gst_mpegts_section_packetize (section->section, &data_size);
 
@@ -868,102 +923,94 @@ tsmux_section_write_packet (GstMpegtsSectionType * type,
     return FALSE;
   }
 
-  /* Mark payload data size */
-  section->pi.stream_avail = data_size;
-  payload_written = 0;
+  /* The first packet also carries the pointer byte */
+  n_packets = (data_size + 1 + TSMUX_PAYLOAD_LENGTH - 1) / TSMUX_PAYLOAD_LENGTH;
 
-  /* Wrap section data in a buffer without free function.
-     The data will be freed when the GstMpegtsSection is destroyed. */
-  section_buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
-      data, data_size, 0, data_size, NULL, NULL);
+  section->packets = g_malloc (n_packets * TSMUX_PACKET_LENGTH);
+  section->n_packets = n_packets;
 
-  TS_DEBUG ("Section buffer with size %" G_GSIZE_FORMAT " created",
-      gst_buffer_get_size (section_buffer));
-
-  while (section->pi.stream_avail > 0) {
+  /* Work on a copy, the continuity counter is patched in when emitting */
+  pi = section->pi;
+  pi.packet_count = 0;
+  pi.packet_start_unit_indicator = TRUE;
+  pi.stream_avail = data_size;
+  payload_written = 0;
+  packet = section->packets;
 
-    packet = g_malloc (TSMUX_PACKET_LENGTH);
+  while (pi.stream_avail > 0) {
+    g_assert (packet < section->packets + n_packets * TSMUX_PACKET_LENGTH);
 
-    if (section->pi.packet_start_unit_indicator) {
-      /* Wee need room for a pointer byte */
-      section->pi.stream_avail++;
+    if (pi.packet_start_unit_indicator) {
+      /* We need room for a pointer byte */
+      pi.stream_avail++;
 
-      if (!tsmux_write_ts_header (packet, &section->pi, &len, &offset))
+      if (!tsmux_write_ts_header (packet, &pi, &len, &offset))
         goto fail;
 
       /* Write the pointer byte */
       packet[offset++] = 0x00;
       payload_len = len - 1;
-
     } else {
-      if (!tsmux_write_ts_header (packet, &section->pi, &len, &offset))
+      if (!tsmux_write_ts_header (packet, &pi, &len, &offset))
         goto fail;
       payload_len = len;
     }
 
-    /* Wrap the TS header and adaption field in a GstMemory */
-    mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
-        packet, TSMUX_PACKET_LENGTH, 0, offset, packet, g_free);
-
-    TS_DEBUG ("Creating packet buffer at offset "
-        "%" G_GSIZE_FORMAT " with length %u", payload_written, payload_len);
-
-    /* If in M2TS mode, we will need to resize to 4 bytes after the end
-       of the buffer. For performance reasons, we will now try to include
-       4 extra bytes from the source buffer, then resize down, to avoid
-       having an extra 4 byte GstMemory appended. If the source buffer
-       does not have enough data for this, a new GstMemory will be used */
-    if (gst_buffer_get_size (section_buffer) - (payload_written +
-            payload_len) >= 4) {
-      /* enough space */
-      extra_alloc_bytes = 4;
-    }
-    packet_buffer = gst_buffer_copy_region (section_buffer, GST_BUFFER_COPY_ALL,
-        payload_written, payload_len + extra_alloc_bytes);
+    TS_DEBUG ("Creating packet at offset %" G_GSIZE_FORMAT
+        " with length %u", payload_written, payload_len);
 
-    /* Prepend the header to the section data */
-    gst_buffer_prepend_memory (packet_buffer, mem);
+    memcpy (packet + offset, data + payload_written, payload_len);
 
-    /* add an extra 4 bytes if it could not be reserved already */
-    if (extra_alloc_bytes == 4) {
-      /* we allocated those already, resize */
-      gst_buffer_set_size (packet_buffer,
-          gst_buffer_get_size (packet_buffer) - extra_alloc_bytes);
-    } else {
-      void *ptr = g_malloc (4);
-      GstMemory *extra =
-          gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, ptr, 4, 0, 0, ptr,
-          g_free);
-      gst_buffer_append_memory (packet_buffer, extra);
-    }
-
-    TS_DEBUG ("Writing %d bytes to section. %d bytes remaining",
-        len, section->pi.stream_avail - len);
-
-    /* Push the packet without PCR */
-    if (G_UNLIKELY (!tsmux_packet_out (mux, packet_buffer, -1))) {
-      /* Buffer given away */
-      packet_buffer = NULL;
-      goto fail;
-    }
-
-    packet_buffer = NULL;
-    section->pi.stream_avail -= len;
+    pi.stream_avail -= len;
     payload_written += payload_len;
-    section->pi.packet_start_unit_indicator = FALSE;
+    pi.packet_start_unit_indicator = FALSE;
+    packet += TSMUX_PACKET_LENGTH;
   }
 
-  gst_buffer_unref (section_buffer);
-
   return TRUE;
 
 fail:
-  g_free (packet);
-  if (section_buffer)
-    gst_buffer_unref (section_buffer);
+  tsmux_section_clear_packets (section);
   return FALSE;
 }
 
+static gboolean
+tsmux_section_write_packet (GstMpegtsSectionType * type,
+    TsMuxSection * section, TsMux * mux)
+{
+  guint i;
+
+  g_return_val_if_fail (section != NULL, FALSE);
+  g_return_val_if_fail (mux != NULL, FALSE);
+
+  if (section->packets == NULL && !tsmux_section_build_packets (section))
+    return FALSE;
+
+  TS_DEBUG ("Writing %u cached packets for section", section->n_packets);
+
+  for (i = 0; i < section->n_packets; i++) {
+    GstBuffer *buf = NULL;
+    GstMapInfo map;
+
+    if (!tsmux_get_buffer (mux, &buf))
+      return FALSE;
+
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
+    memcpy (map.data, section->packets + i * TSMUX_PACKET_LENGTH,
+        TSMUX_PACKET_LENGTH);
+    /* All section packets carry payload, so the counter always advances */
+    map.data[3] |= section->pi.packet_count & 0x0f;
+    section->pi.packet_count++;
+    gst_buffer_unmap (buf, &map);
+
+    /* Push the packet without PCR */
+    if (G_UNLIKELY (!tsmux_packet_out (mux, buf, -1)))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 tsmux_write_si (TsMux * mux)
 {
@@ -976,6 +1023,138 @@ tsmux_write_si (TsMux * mux)
 
 }
 
+/* Convert a timestamp in the 90kHz clock to the PCR at which its data
+ * should be output */
+static gint64
+tsmux_ts_to_pcr (gint64 ts)
+{
+  /* CLOCK_BASE >= TSMUX_PCR_OFFSET */
+  return (ts + CLOCK_BASE - TSMUX_PCR_OFFSET) *
+      (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
+}
+
+/* PCR at the start of the next output packet, in CBR mode */
+static gint64
+tsmux_get_current_pcr (TsMux * mux)
+{
+  g_assert (mux->first_pcr != -1);
+
+  return mux->first_pcr + gst_util_uint64_scale (mux->n_bytes * 8,
+      TSMUX_SYS_CLOCK_FREQ, mux->bitrate);
+}
+
+static gboolean
+tsmux_write_null_packet (TsMux * mux)
+{
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  map.data[0] = TSMUX_SYNC_BYTE;
+  /* null packet PID, payload only */
+  GST_WRITE_UINT16_BE (map.data + 1, 0x1FFF);
+  map.data[3] = 0x10;
+  memset (map.data + TSMUX_HEADER_LENGTH, 0xff, TSMUX_PAYLOAD_LENGTH);
+  gst_buffer_unmap (buf, &map);
+
+  return tsmux_packet_out (mux, buf, -1);
+}
+
+/* Write an adaptation field only packet carrying the PCR for all programs
+ * whose PCR interval elapsed, in CBR mode */
+static gboolean
+tsmux_write_pcr_packets (TsMux * mux)
+{
+  GList *cur;
+
+  for (cur = mux->programs; cur; cur = cur->next) {
+    TsMuxProgram *program = (TsMuxProgram *) cur->data;
+    TsMuxStream *stream = program->pcr_stream;
+    TsMuxPacketInfo pi;
+    GstBuffer *buf = NULL;
+    GstMapInfo map;
+    guint payload_len, payload_offs;
+    gint64 cur_pcr;
+
+    if (stream == NULL)
+      continue;
+
+    cur_pcr = tsmux_get_current_pcr (mux);
+    if (stream->last_pcr != -1 && cur_pcr - stream->last_pcr <=
+        (TSMUX_SYS_CLOCK_FREQ / TSMUX_DEFAULT_PCR_FREQ))
+      continue;
+
+    /* no payload, so the continuity counter keeps its last value */
+    memset (&pi, 0, sizeof (pi));
+    pi.pid = stream->pi.pid;
+    pi.packet_count = stream->pi.packet_count - 1;
+    pi.flags = TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
+    pi.pcr = cur_pcr;
+
+    if (!tsmux_get_buffer (mux, &buf))
+      return FALSE;
+
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
+    if (!tsmux_write_ts_header (map.data, &pi, &payload_len, &payload_offs)) {
+      gst_buffer_unmap (buf, &map);
+      gst_buffer_unref (buf);
+      return FALSE;
+    }
+    gst_buffer_unmap (buf, &map);
+
+    stream->last_pcr = cur_pcr;
+    if (!tsmux_packet_out (mux, buf, cur_pcr))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Output null and PCR packets until the virtual clock reaches the time
+ * the next packet of @stream is due, in CBR mode */
+static gboolean
+tsmux_pad_stream (TsMux * mux, TsMuxStream * stream)
+{
+  gint64 ts, target;
+
+  ts = stream->last_dts != G_MININT64 ? stream->last_dts : stream->last_pts;
+  if (ts == G_MININT64)
+    return TRUE;
+
+  target = tsmux_ts_to_pcr (ts);
+  if (mux->first_pcr == -1)
+    mux->first_pcr = target;
+
+  if (target - tsmux_get_current_pcr (mux) > TSMUX_MAX_PADDING) {
+    /* don't stuff the gap, restart the virtual clock at the new time */
+    GST_WARNING ("Timestamp discontinuity of %" G_GINT64_FORMAT
+        " ticks in CBR mode, resetting the output clock",
+        target - tsmux_get_current_pcr (mux));
+    mux->first_pcr = target;
+    mux->n_bytes = 0;
+  }
+
+  if (!tsmux_write_pcr_packets (mux))
+    return FALSE;
+
+  while (tsmux_get_current_pcr (mux) < target) {
+    if (!tsmux_write_null_packet (mux))
+      return FALSE;
+    if (!tsmux_write_pcr_packets (mux))
+      return FALSE;
+  }
+
+  if (tsmux_get_current_pcr (mux) - target > TSMUX_SYS_CLOCK_FREQ / 8) {
+    TS_DEBUG ("Output is %" G_GINT64_FORMAT " ticks late, bitrate too low",
+        tsmux_get_current_pcr (mux) - target);
+  }
+
+  return TRUE;
+}
+
 /**
  * tsmux_write_stream_packet:
  * @mux: a #TsMux
@@ -993,11 +1172,16 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   gboolean res;
   gint64 cur_pcr = -1;
   GstBuffer *buf = NULL;
+  GstBuffer *region = NULL;
   GstMapInfo map;
+  guint written;
 
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
 
+  if (mux->bitrate && !tsmux_pad_stream (mux, stream))
+    return FALSE;
+
   if (tsmux_stream_is_pcr (stream)) {
     gint64 cur_pts = tsmux_stream_get_pts (stream);
     gboolean write_pat;
@@ -1012,12 +1196,14 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
     /* FIXME: The current PCR needs more careful calculation than just
      * writing a fixed offset */
     if (cur_pts != G_MININT64) {
-      /* CLOCK_BASE >= TSMUX_PCR_OFFSET */
+      cur_pcr = tsmux_ts_to_pcr (cur_pts);
       cur_pts += CLOCK_BASE;
-      cur_pcr = (cur_pts - TSMUX_PCR_OFFSET) *
-          (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
     }
 
+    /* in CBR mode the PCR follows the output position */
+    if (mux->bitrate && mux->first_pcr != -1)
+      cur_pcr = tsmux_get_current_pcr (mux);
+
     /* Need to decide whether to write a new PCR in this packet */
     if (stream->last_pcr == -1 ||
         (cur_pcr - stream->last_pcr >
@@ -1079,6 +1265,14 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
     }
   }
 
+  /* tables may have been written meanwhile, the PCR must match the actual
+   * position of this packet */
+  if (mux->bitrate && mux->first_pcr != -1 && cur_pcr != -1) {
+    cur_pcr = tsmux_get_current_pcr (mux);
+    stream->pi.pcr = cur_pcr;
+    stream->last_pcr = cur_pcr;
+  }
+
   pi->packet_start_unit_indicator = tsmux_stream_at_pes_start (stream);
   if (pi->packet_start_unit_indicator) {
     tsmux_stream_initialize_pes_packet (stream);
@@ -1093,17 +1287,24 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   if (!tsmux_get_buffer (mux, &buf))
     return FALSE;
 
-  gst_buffer_map (buf, &map, GST_MAP_READ);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
 
   if (!tsmux_write_ts_header (map.data, pi, &payload_len, &payload_offs))
     goto fail;
 
-
-  if (!tsmux_stream_get_data (stream, map.data + payload_offs, payload_len))
+  /* Payload contained in a single input buffer is referenced rather than
+   * copied */
+  if (!tsmux_stream_get_data_region (stream, map.data + payload_offs,
+          payload_len, &written, &region))
     goto fail;
 
   gst_buffer_unmap (buf, &map);
 
+  if (region) {
+    gst_buffer_set_size (buf, payload_offs + written);
+    buf = gst_buffer_append (buf, region);
+  }
+
   GST_DEBUG_OBJECT (mux, "Writing PES of size %d",
       (int) gst_buffer_get_size (buf));
   res = tsmux_packet_out (mux, buf, cur_pcr);
@@ -1138,6 +1339,7 @@ tsmux_program_free (TsMuxProgram * program)
   /* Free PMT section */
   if (program->pmt.section)
     gst_mpegts_section_unref (program->pmt.section);
+  tsmux_section_clear_packets (&program->pmt);
 
   g_array_free (program->streams, TRUE);
   g_slice_free (TsMuxProgram, program);
@@ -1174,6 +1376,7 @@ tsmux_write_pat (TsMux * mux)
 
     if (mux->pat.section)
       gst_mpegts_section_unref (mux->pat.section);
+    tsmux_section_clear_packets (&mux->pat);
 
     mux->pat.section = gst_mpegts_section_from_pat (pat, mux->transport_id);
 
@@ -1255,6 +1458,7 @@ tsmux_write_pmt (TsMux * mux, TsMuxProgram * program)
 
     if (program->pmt.section)
       gst_mpegts_section_unref (program->pmt.section);
+    tsmux_section_clear_packets (&program->pmt);
 
     program->pmt.section = gst_mpegts_section_from_pmt (pmt, program->pmt_pid);
     program->pmt.section->version_number = program->pmt_version++;
@@ -106,6 +106,10 @@ typedef void (*TsMuxAllocFunc) (GstBuffer ** buf, void *user_data);
 struct TsMuxSection {
   TsMuxPacketInfo pi;
   GstMpegtsSection *section;
+
+  /* cached TS packets of @section, with a zero continuity counter */
+  guint8 *packets;
+  guint n_packets;
 };
 
 /* Information for the streams associated with one program */
@@ -176,6 +180,13 @@ struct TsMux {
   TsMuxAllocFunc alloc_func;
   void *alloc_func_data;
 
+  /* output bitrate in bits per second for CBR, 0 for VBR */
+  guint64 bitrate;
+  /* bytes output since the first PCR, in CBR mode */
+  guint64 n_bytes;
+  /* PCR of the first output packet in CBR mode, -1 if unknown */
+  gint64 first_pcr;
+
   /* scratch space for writing ES_info descriptors */
   guint8 es_info_buf[TSMUX_MAX_ES_INFO_LENGTH];
 };
@@ -190,6 +201,8 @@ void 		tsmux_set_alloc_func 		(TsMux *mux, TsMuxAllocFunc func, void *user_data)
 void 		tsmux_set_pat_interval          (TsMux *mux, guint interval);
 guint 		tsmux_get_pat_interval          (TsMux *mux);
 guint16		tsmux_get_new_pid 		(TsMux *mux);
+void 		tsmux_set_bitrate 		(TsMux *mux, guint64 bitrate);
+guint64 	tsmux_get_bitrate 		(TsMux *mux);
 
 /* pid/program management */
 TsMuxProgram *	tsmux_program_new 		(TsMux *mux, gint prog_id);
@@ -101,6 +101,9 @@ struct TsMuxStreamBuffer
   guint8 *data;
   guint32 size;
 
+  /* buffer that @data is the mapped content of, if any */
+  GstBuffer *buffer;
+
   /* PTS & DTS associated with the contents of this buffer */
   gint64 pts;
   gint64 dts;
@@ -475,9 +478,41 @@ tsmux_stream_initialize_pes_packet (TsMuxStream * stream)
 gboolean
 tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
 {
+  guint written;
+
+  return tsmux_stream_get_data_region (stream, buf, len, &written, NULL);
+}
+
+/**
+ * tsmux_stream_get_data_region:
+ * @stream: a #TsMuxStream
+ * @buf: a buffer to hold the result
+ * @len: the length of @buf
+ * @written: (out): the number of bytes written to @buf
+ * @region: (out) (allow-none): a buffer referencing the rest of the data
+ *
+ * Like tsmux_stream_get_data(), but if @region is not %NULL and the payload
+ * is contained in a single submitted #GstBuffer, only the PES header is
+ * written into @buf and the payload is returned in @region, sharing the
+ * memory of the submitted buffer. Otherwise @region is set to %NULL and all
+ * @len bytes are copied into @buf.
+ *
+ * Returns: TRUE if @len bytes could be retrieved.
+ */
+gboolean
+tsmux_stream_get_data_region (TsMuxStream * stream, guint8 * buf, guint len,
+    guint * written, GstBuffer ** region)
+{
+  TsMuxStreamBuffer *cur_buffer;
+  guint consumed;
+
   g_return_val_if_fail (stream != NULL, FALSE);
   g_return_val_if_fail (buf != NULL, FALSE);
 
+  *written = 0;
+  if (region)
+    *region = NULL;
+
   if (stream->state == TSMUX_STREAM_STATE_HEADER) {
     guint8 pes_hdr_length;
 
@@ -493,6 +528,7 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
 
     len -= pes_hdr_length;
     buf += pes_hdr_length;
+    *written = pes_hdr_length;
 
     stream->state = TSMUX_STREAM_STATE_PACKET;
   }
@@ -509,6 +545,28 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
     stream->pes_bytes_written = 0;
   }
 
+  if (stream->cur_buffer) {
+    cur_buffer = stream->cur_buffer;
+    consumed = stream->cur_buffer_consumed;
+  } else {
+    cur_buffer = stream->buffers ? stream->buffers->data : NULL;
+    consumed = 0;
+  }
+
+  if (region && len > 0 && cur_buffer && cur_buffer->buffer &&
+      cur_buffer->size - consumed >= len) {
+    /* Reference the payload instead of copying it */
+    *region = gst_buffer_copy_region (cur_buffer->buffer,
+        GST_BUFFER_COPY_MEMORY, consumed, len);
+    stream->cur_buffer = cur_buffer;
+    stream->cur_buffer_consumed = consumed;
+    tsmux_stream_consume (stream, len);
+
+    return TRUE;
+  }
+
+  *written += len;
+
   while (len > 0) {
     guint32 avail;
     guint8 *cur;
@@ -702,6 +760,31 @@ tsmux_stream_write_pes_header (TsMuxStream * stream, guint8 * data)
 void
 tsmux_stream_add_data (TsMuxStream * stream, guint8 * data, guint len,
     void *user_data, gint64 pts, gint64 dts, gboolean random_access)
+{
+  tsmux_stream_add_data_buffer (stream, NULL, data, len, user_data, pts, dts,
+      random_access);
+}
+
+/**
+ * tsmux_stream_add_data_buffer:
+ * @stream: a #TsMuxStream
+ * @buffer: (allow-none): the buffer @data is the mapped content of
+ * @data: data to add
+ * @len: length of @data
+ * @user_data: user data to pass to release func
+ * @pts: PTS of access unit in @data
+ * @dts: DTS of access unit in @data
+ * @random_access: TRUE if random access point (keyframe)
+ *
+ * Like tsmux_stream_add_data(), but also provides the #GstBuffer @data was
+ * mapped from, which allows tsmux_stream_get_data_region() to reference its
+ * memory instead of copying the data. @buffer must stay valid until the
+ * release function is called.
+ */
+void
+tsmux_stream_add_data_buffer (TsMuxStream * stream, GstBuffer * buffer,
+    guint8 * data, guint len, void *user_data, gint64 pts, gint64 dts,
+    gboolean random_access)
 {
   TsMuxStreamBuffer *packet;
 
@@ -710,6 +793,7 @@ tsmux_stream_add_data (TsMuxStream * stream, guint8 * data, guint len,
   packet = g_slice_new (TsMuxStreamBuffer);
   packet->data = data;
   packet->size = len;
+  packet->buffer = buffer;
   packet->user_data = user_data;
   packet->random_access = random_access;
 
@@ -243,6 +243,9 @@ void 		tsmux_stream_set_buffer_release_func 	(TsMuxStream *stream,
 void 		tsmux_stream_add_data 		(TsMuxStream *stream, guint8 *data, guint len, 
        						 void *user_data, gint64 pts, gint64 dts,
                                                  gboolean random_access);
+void 		tsmux_stream_add_data_buffer	(TsMuxStream *stream, GstBuffer *buffer,
+						 guint8 *data, guint len, void *user_data,
+						 gint64 pts, gint64 dts, gboolean random_access);
 
 void 		tsmux_stream_pcr_ref 		(TsMuxStream *stream);
 void 		tsmux_stream_pcr_unref  	(TsMuxStream *stream);
@@ -255,6 +258,8 @@ gint 		tsmux_stream_bytes_in_buffer 	(TsMuxStream *stream);
 gint 		tsmux_stream_bytes_avail 	(TsMuxStream *stream);
 gboolean 	tsmux_stream_initialize_pes_packet (TsMuxStream *stream);
 gboolean 	tsmux_stream_get_data 		(TsMuxStream *stream, guint8 *buf, guint len);
+gboolean 	tsmux_stream_get_data_region 	(TsMuxStream *stream, guint8 *buf, guint len,
+						 guint *written, GstBuffer **region);
 
 guint64 	tsmux_stream_get_pts 		(TsMuxStream *stream);
 
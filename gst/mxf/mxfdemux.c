@@ -261,6 +261,9 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   gst_adapter_clear (demux->adapter);
 
+  gst_buffer_replace (&demux->pull_cache, NULL);
+  demux->pull_cache_offset = 0;
+
   gst_mxf_demux_remove_pads (demux);
 
   if (demux->random_index_pack) {
@@ -286,6 +289,8 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
     for (l = demux->index_tables; l; l = l->next) {
       GstMXFDemuxIndexTable *t = l->data;
       g_array_free (t->offsets, TRUE);
+      if (t->positions)
+        g_array_free (t->positions, TRUE);
       g_free (t);
     }
     g_list_free (demux->index_tables);
@@ -301,12 +306,66 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
   demux->group_id = G_MAXUINT;
 }
 
+/* Partition packs, KLV headers, metadata sets and small essence elements
+ * are served as sub-buffers of one bigger pull, which saves most of the
+ * round trips upstream when parsing header metadata */
+#define PULL_CACHE_SIZE (64 * 1024)
+
+static GstFlowReturn
+gst_mxf_demux_pull_cached (GstMXFDemux * demux, guint64 offset,
+    guint size, GstBuffer ** buffer)
+{
+  GstFlowReturn ret;
+  gsize cache_size = 0;
+
+  if (demux->pull_cache)
+    cache_size = gst_buffer_get_size (demux->pull_cache);
+
+  if (!demux->pull_cache || offset < demux->pull_cache_offset ||
+      offset + size > demux->pull_cache_offset + cache_size) {
+    gst_buffer_replace (&demux->pull_cache, NULL);
+
+    ret = gst_pad_pull_range (demux->sinkpad, offset, PULL_CACHE_SIZE,
+        &demux->pull_cache);
+    if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+      GST_WARNING_OBJECT (demux,
+          "failed when pulling %u bytes from offset %" G_GUINT64_FORMAT ": %s",
+          size, offset, gst_flow_get_name (ret));
+      demux->pull_cache = NULL;
+      *buffer = NULL;
+      return ret;
+    }
+
+    demux->pull_cache_offset = offset;
+    cache_size = gst_buffer_get_size (demux->pull_cache);
+  }
+
+  /* short read at the end of the file */
+  if (G_UNLIKELY (offset + size > demux->pull_cache_offset + cache_size)) {
+    GST_WARNING_OBJECT (demux,
+        "partial pull got %" G_GSIZE_FORMAT " when expecting %u from offset %"
+        G_GUINT64_FORMAT, (gsize) (demux->pull_cache_offset + cache_size -
+            offset), size, offset);
+    *buffer = NULL;
+    return GST_FLOW_EOS;
+  }
+
+  *buffer = gst_buffer_copy_region (demux->pull_cache,
+      GST_BUFFER_COPY_MEMORY, offset - demux->pull_cache_offset, size);
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_mxf_demux_pull_range (GstMXFDemux * demux, guint64 offset,
     guint size, GstBuffer ** buffer)
 {
   GstFlowReturn ret;
 
+  if (size <= PULL_CACHE_SIZE / 4)
+    return gst_mxf_demux_pull_cached (demux, offset, size, buffer);
+
+  /* bigger essence elements are pulled directly, without any copy */
   ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_WARNING_OBJECT (demux,
@@ -1681,6 +1740,58 @@ gst_mxf_demux_pad_set_component (GstMXFDemux * demux, GstMXFDemuxPad * pad,
   return ret;
 }
 
+static GstMXFDemuxIndexTable *
+gst_mxf_demux_find_index_table (GstMXFDemux * demux,
+    GstMXFDemuxEssenceTrack * etrack)
+{
+  GList *l;
+
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *tmp = l->data;
+
+    if (tmp->body_sid == etrack->body_sid
+        && tmp->index_sid == etrack->index_sid)
+      return tmp;
+  }
+
+  return NULL;
+}
+
+/* Returns the edit unit starting at @offset, or the one whose content package
+ * contains it for interleaved essence, or -1 */
+static gint64
+gst_mxf_demux_index_table_find_position (GstMXFDemuxIndexTable * index_table,
+    guint64 offset)
+{
+  GstMXFDemuxIndexPosition *pos;
+  guint lo, hi, mid;
+
+  if (!index_table->positions || index_table->positions->len == 0)
+    return -1;
+
+  lo = 0;
+  hi = index_table->positions->len;
+  while (hi - lo > 1) {
+    mid = lo + (hi - lo) / 2;
+    pos = &g_array_index (index_table->positions, GstMXFDemuxIndexPosition,
+        mid);
+    if (pos->offset <= offset)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  pos = &g_array_index (index_table->positions, GstMXFDemuxIndexPosition, lo);
+  if (pos->offset == offset)
+    return pos->position;
+
+  /* past the last indexed edit unit we can't know where it ends */
+  if (pos->offset < offset && lo + 1 < index_table->positions->len)
+    return pos->position;
+
+  return -1;
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, gboolean peek)
@@ -1745,9 +1856,18 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   }
 
   if (etrack->position == -1) {
+    GstMXFDemuxIndexTable *index_table;
+
     GST_DEBUG_OBJECT (demux,
         "Unknown essence track position, looking into index");
-    if (etrack->offsets) {
+
+    index_table = gst_mxf_demux_find_index_table (demux, etrack);
+    if (index_table)
+      etrack->position =
+          gst_mxf_demux_index_table_find_position (index_table,
+          demux->offset - demux->run_in);
+
+    if (etrack->position == -1 && etrack->offsets) {
       for (i = 0; i < etrack->offsets->len; i++) {
         GstMXFDemuxIndex *idx =
             &g_array_index (etrack->offsets, GstMXFDemuxIndex, i);
@@ -1811,18 +1931,8 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
 
   /* Prefer keyframe information from index tables over everything else */
   if (demux->index_tables) {
-    GList *l;
-    GstMXFDemuxIndexTable *index_table = NULL;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
+    GstMXFDemuxIndexTable *index_table =
+        gst_mxf_demux_find_index_table (demux, etrack);
 
     if (index_table && index_table->offsets->len > etrack->position) {
       GstMXFDemuxIndex *index =
@@ -2818,25 +2928,13 @@ gst_mxf_demux_find_essence_element (GstMXFDemux * demux,
   gint i;
   guint64 offset;
   gint64 requested_position = *position;
-  GstMXFDemuxIndexTable *index_table = NULL;
+  GstMXFDemuxIndexTable *index_table;
 
   GST_DEBUG_OBJECT (demux, "Trying to find essence element %" G_GINT64_FORMAT
       " of track %u with body_sid %u (keyframe %d)", *position,
       etrack->track_number, etrack->body_sid, keyframe);
 
-  if (demux->index_tables) {
-    GList *l;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
-  }
+  index_table = gst_mxf_demux_find_index_table (demux, etrack);
 
 from_index:
 
@@ -2855,6 +2953,19 @@ from_index:
     return offset;
   }
 
+  /* Then in the index tables of the file, which usually makes walking the
+   * essence unnecessary */
+  if (index_table) {
+    offset = find_offset (index_table->offsets, position, keyframe);
+    if (offset != -1) {
+      GST_DEBUG_OBJECT (demux,
+          "Found edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
+          " in index at offset %" G_GUINT64_FORMAT, *position,
+          requested_position, offset);
+      return offset;
+    }
+  }
+
   GST_DEBUG_OBJECT (demux, "Not found in index");
   if (!demux->random_access) {
     offset = find_closest_offset (etrack->offsets, position, keyframe);
@@ -3665,6 +3776,151 @@ no_new_offset:
   }
 }
 
+/* Body partitions of @body_sid in file order, as nodes of the partitions
+ * list so that the partition following each of them is known too */
+static GPtrArray *
+gst_mxf_demux_get_body_partitions (GstMXFDemux * demux, guint32 body_sid)
+{
+  GPtrArray *partitions = g_ptr_array_new ();
+  GList *l;
+
+  for (l = demux->partitions; l; l = l->next) {
+    GstMXFDemuxPartition *partition = l->data;
+
+    if (partition->partition.body_sid == body_sid)
+      g_ptr_array_add (partitions, l);
+  }
+
+  return partitions;
+}
+
+/* Maps a stream offset of an index entry to a file offset, or returns -1 */
+static guint64
+gst_mxf_demux_stream_offset_to_offset (GstMXFDemux * demux,
+    GPtrArray * partitions, guint64 stream_offset)
+{
+  GstMXFDemuxPartition *offset_partition, *next_partition = NULL;
+  GList *node;
+  guint lo = 0, hi = partitions->len, mid;
+  guint64 offset;
+
+  if (partitions->len == 0)
+    return -1;
+
+  /* last partition starting at or before the stream offset */
+  while (hi - lo > 1) {
+    mid = lo + (hi - lo) / 2;
+    offset_partition =
+        ((GList *) g_ptr_array_index (partitions, mid))->data;
+    if (offset_partition->partition.body_offset <= stream_offset)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  node = g_ptr_array_index (partitions, lo);
+  offset_partition = node->data;
+  if (stream_offset < offset_partition->partition.body_offset)
+    return -1;
+
+  if (node->next)
+    next_partition = node->next->data;
+
+  offset =
+      offset_partition->partition.this_partition +
+      offset_partition->essence_container_offset + (stream_offset -
+      offset_partition->partition.body_offset);
+
+  if (next_partition && offset >= next_partition->partition.this_partition) {
+    GST_ERROR_OBJECT (demux,
+        "Invalid index table segment going into next unrelated partition");
+    return -1;
+  }
+
+  return offset;
+}
+
+static void
+gst_mxf_demux_index_table_add_entry (GstMXFDemuxIndexTable * t,
+    guint64 position, guint64 offset, gint8 temporal_offset, gboolean keyframe)
+{
+  GstMXFDemuxIndex *index;
+  guint64 pts_i = G_MAXUINT64;
+
+  if (temporal_offset > 0 ||
+      (temporal_offset < 0 && position >= -(gint) temporal_offset)) {
+    pts_i = position + temporal_offset;
+
+    if (t->offsets->len <= pts_i)
+      g_array_set_size (t->offsets, pts_i + 1);
+
+    index = &g_array_index (t->offsets, GstMXFDemuxIndex, pts_i);
+    if (!index->initialized) {
+      index->initialized = TRUE;
+      index->offset = 0;
+      index->pts = G_MAXUINT64;
+      index->dts = G_MAXUINT64;
+      index->keyframe = FALSE;
+    }
+
+    index->pts = position;
+  }
+
+  index = &g_array_index (t->offsets, GstMXFDemuxIndex, position);
+  if (!index->initialized) {
+    index->initialized = TRUE;
+    index->offset = 0;
+    index->pts = G_MAXUINT64;
+    index->dts = G_MAXUINT64;
+    index->keyframe = FALSE;
+  }
+
+  index->offset = offset;
+  index->keyframe = keyframe;
+  index->dts = pts_i;
+}
+
+static gint
+gst_mxf_demux_index_position_compare (const GstMXFDemuxIndexPosition * a,
+    const GstMXFDemuxIndexPosition * b)
+{
+  if (a->offset < b->offset)
+    return -1;
+  else if (a->offset > b->offset)
+    return 1;
+  return 0;
+}
+
+/* Builds the offset to edit unit map used to find the position of the
+ * essence elements after a seek */
+static void
+gst_mxf_demux_index_table_update_positions (GstMXFDemuxIndexTable * t)
+{
+  guint i;
+
+  if (t->positions)
+    g_array_set_size (t->positions, 0);
+  else
+    t->positions =
+        g_array_new (FALSE, FALSE, sizeof (GstMXFDemuxIndexPosition));
+
+  for (i = 0; i < t->offsets->len; i++) {
+    GstMXFDemuxIndex *index = &g_array_index (t->offsets, GstMXFDemuxIndex, i);
+    GstMXFDemuxIndexPosition pos;
+
+    if (!index->initialized || index->offset == 0)
+      continue;
+
+    pos.offset = index->offset;
+    pos.position = i;
+    g_array_append_val (t->positions, pos);
+  }
+
+  /* edit units are stored in increasing order, except for broken files */
+  g_array_sort (t->positions,
+      (GCompareFunc) gst_mxf_demux_index_position_compare);
+}
+
 static void
 collect_index_table_segments (GstMXFDemux * demux)
 {
@@ -3673,20 +3929,27 @@ collect_index_table_segments (GstMXFDemux * demux)
   guint64 old_offset = demux->offset;
   GstMXFDemuxPartition *old_partition = demux->current_partition;
 
-  if (!demux->random_index_pack)
-    return;
+  if (demux->random_index_pack) {
+    for (i = 0; i < demux->random_index_pack->len; i++) {
+      MXFRandomIndexPackEntry *e =
+          &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry,
+          i);
 
-  for (i = 0; i < demux->random_index_pack->len; i++) {
-    MXFRandomIndexPackEntry *e =
-        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+      if (e->offset < demux->run_in) {
+        GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
+        return;
+      }
 
-    if (e->offset < demux->run_in) {
-      GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
-      return;
+      demux->offset = e->offset;
+      read_partition_header (demux);
     }
-
-    demux->offset = e->offset;
+  } else if (demux->random_access && demux->footer_partition_pack_offset != 0) {
+    /* Without random index pack, the footer partition still usually
+     * contains the complete index */
+    demux->offset = demux->run_in + demux->footer_partition_pack_offset;
     read_partition_header (demux);
+  } else {
+    return;
   }
 
   demux->offset = old_offset;
@@ -3695,6 +3958,7 @@ collect_index_table_segments (GstMXFDemux * demux)
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
     GstMXFDemuxIndexTable *t = NULL;
+    GPtrArray *partitions;
     GList *k;
     guint64 start, end;
 
@@ -3721,6 +3985,8 @@ collect_index_table_segments (GstMXFDemux * demux)
     if (end > G_MAXINT / sizeof (GstMXFDemuxIndex)) {
       demux->index_tables = g_list_remove (demux->index_tables, t);
       g_array_free (t->offsets, TRUE);
+      if (t->positions)
+        g_array_free (t->positions, TRUE);
       g_free (t);
       continue;
     }
@@ -3728,79 +3994,37 @@ collect_index_table_segments (GstMXFDemux * demux)
     if (t->offsets->len < end)
       g_array_set_size (t->offsets, end);
 
-    for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
-        i++) {
-      guint64 offset = segment->index_entries[i].stream_offset;
-      GList *m;
-      GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
-
-      for (m = demux->partitions; m; m = m->next) {
-        GstMXFDemuxPartition *partition = m->data;
-
-        if (!next_partition && offset_partition)
-          next_partition = partition;
+    partitions = gst_mxf_demux_get_body_partitions (demux, t->body_sid);
 
-        if (partition->partition.body_sid != t->body_sid)
-          continue;
-        if (partition->partition.body_offset > offset)
-          break;
+    if (segment->n_index_entries == 0 && segment->edit_unit_byte_count != 0) {
+      /* constant bytes per edit unit, every edit unit is a keyframe */
+      for (i = 0; start + i < end; i++) {
+        guint64 offset = gst_mxf_demux_stream_offset_to_offset (demux,
+            partitions, (start + i) * segment->edit_unit_byte_count);
 
-        offset_partition = partition;
-        next_partition = NULL;
+        if (offset != -1)
+          gst_mxf_demux_index_table_add_entry (t, start + i, offset, 0, TRUE);
       }
+    }
 
-      if (offset_partition && offset >= offset_partition->partition.body_offset) {
-        offset =
-            offset_partition->partition.this_partition +
-            offset_partition->essence_container_offset + (offset -
-            offset_partition->partition.body_offset);
-
-        if (next_partition
-            && offset >= next_partition->partition.this_partition) {
-          GST_ERROR_OBJECT (demux,
-              "Invalid index table segment going into next unrelated partition");
-        } else {
-          GstMXFDemuxIndex *index;
-          gint8 temporal_offset = segment->index_entries[i].temporal_offset;
-          guint64 pts_i = G_MAXUINT64;
-
-          if (temporal_offset > 0 ||
-              (temporal_offset < 0 && start + i >= -(gint) temporal_offset)) {
-            pts_i = start + i + temporal_offset;
-
-            if (t->offsets->len < pts_i)
-              g_array_set_size (t->offsets, pts_i + 1);
-
-            index = &g_array_index (t->offsets, GstMXFDemuxIndex, pts_i);
-            if (!index->initialized) {
-              index->initialized = TRUE;
-              index->offset = 0;
-              index->pts = G_MAXUINT64;
-              index->dts = G_MAXUINT64;
-              index->keyframe = FALSE;
-            }
-
-            index->pts = start + i;
-          }
-
-          index = &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
-          if (!index->initialized) {
-            index->initialized = TRUE;
-            index->offset = 0;
-            index->pts = G_MAXUINT64;
-            index->dts = G_MAXUINT64;
-            index->keyframe = FALSE;
-          }
-
-          index->offset = offset;
-          index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
-              || (segment->index_entries[i].key_frame_offset == 0);
-          index->dts = pts_i;
-        }
-      }
+    for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
+        i++) {
+      guint64 offset = gst_mxf_demux_stream_offset_to_offset (demux,
+          partitions, segment->index_entries[i].stream_offset);
+
+      if (offset != -1)
+        gst_mxf_demux_index_table_add_entry (t, start + i, offset,
+            segment->index_entries[i].temporal_offset,
+            ! !(segment->index_entries[i].flags & 0x80)
+            || (segment->index_entries[i].key_frame_offset == 0));
     }
+
+    g_ptr_array_free (partitions, TRUE);
   }
 
+  for (l = demux->index_tables; l; l = l->next)
+    gst_mxf_demux_index_table_update_positions (l->data);
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *s = l->data;
     mxf_index_table_segment_reset (s);
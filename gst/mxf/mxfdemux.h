@@ -99,6 +99,12 @@ typedef struct
   gboolean initialized;
 } GstMXFDemuxIndex;
 
+typedef struct
+{
+  guint64 offset;
+  gint64 position;
+} GstMXFDemuxIndexPosition;
+
 typedef struct
 {
   guint32 body_sid;
@@ -106,6 +112,9 @@ typedef struct
 
   /* offsets indexed by DTS */
   GArray *offsets;
+
+  /* GstMXFDemuxIndexPosition of all known edit units, sorted by offset */
+  GArray *positions;
 } GstMXFDemuxIndexTable;
 
 struct _GstMXFDemuxPad
@@ -170,6 +179,10 @@ struct _GstMXFDemux
 
   guint64 offset;
 
+  /* read-ahead window for the small pulls in random access mode */
+  GstBuffer *pull_cache;
+  guint64 pull_cache_offset;
+
   gboolean random_access;
   gboolean flushing;
 
@@ -114,13 +114,20 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_DURATION
 };
 
+#define DEFAULT_PARTITION_DURATION 0
+
 #define gst_mxf_mux_parent_class parent_class
 G_DEFINE_TYPE (GstMXFMux, gst_mxf_mux, GST_TYPE_AGGREGATOR);
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -135,12 +142,54 @@ static GstAggregatorPad *gst_mxf_mux_create_new_pad (GstAggregator * aggregator,
 
 static void gst_mxf_mux_reset (GstMXFMux * mux);
 
+/* Pushes the queued essence as one buffer list */
+static GstFlowReturn
+gst_mxf_mux_flush (GstMXFMux * mux)
+{
+  GstBufferList *list = mux->pending;
+  GstBuffer *first;
+  GstFlowReturn ret;
+
+  if (!list)
+    return GST_FLOW_OK;
+  mux->pending = NULL;
+
+  /* the first one goes through the aggregator for the pending events */
+  first = gst_buffer_ref (gst_buffer_list_get (list, 0));
+  gst_buffer_list_remove (list, 0, 1);
+  ret = gst_aggregator_finish_buffer (GST_AGGREGATOR (mux), first);
+
+  if (ret == GST_FLOW_OK && gst_buffer_list_length (list) > 0)
+    ret = gst_pad_push_list (GST_AGGREGATOR_SRC_PAD (mux), list);
+  else
+    gst_buffer_list_unref (list);
+
+  return ret;
+}
+
+static void
+gst_mxf_mux_queue (GstMXFMux * mux, GstBuffer * buf)
+{
+  if (!mux->pending)
+    mux->pending = gst_buffer_list_new ();
+
+  mux->offset += gst_buffer_get_size (buf);
+  gst_buffer_list_add (mux->pending, buf);
+}
+
 static GstFlowReturn
 gst_mxf_mux_push (GstMXFMux * mux, GstBuffer * buf)
 {
   guint size = gst_buffer_get_size (buf);
   GstFlowReturn ret;
 
+  ret = gst_mxf_mux_flush (mux);
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (buf);
+    mux->offset += size;
+    return ret;
+  }
+
   ret = gst_aggregator_finish_buffer (GST_AGGREGATOR (mux), buf);
   mux->offset += size;
 
@@ -162,6 +211,23 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  /**
+   * GstMXFMux:partition-duration:
+   *
+   * Starts a new body partition at the first keyframe after this duration,
+   * with the index table segments that are complete by then. 0 writes all
+   * the essence into one body partition.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PARTITION_DURATION,
+      g_param_spec_uint64 ("partition-duration", "Partition duration",
+          "Duration of the body partitions (0 = single body partition)", 0,
+          G_MAXUINT64, DEFAULT_PARTITION_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -190,9 +256,48 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->body_partitions =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+  mux->partition_duration = DEFAULT_PARTITION_DURATION;
   gst_mxf_mux_reset (mux);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_DURATION:
+      GST_OBJECT_LOCK (mux);
+      mux->partition_duration = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_DURATION:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_uint64 (value, mux->partition_duration);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mxf_mux_finalize (GObject * object)
 {
@@ -216,6 +321,9 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  g_array_free (mux->body_partitions, TRUE);
+  mux->body_partitions = NULL;
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -267,6 +375,16 @@ gst_mxf_mux_reset (GstMXFMux * mux)
   g_array_set_size (mux->index_table, 0);
   mux->current_index_pos = 0;
   mux->last_keyframe_pos = 0;
+
+  if (mux->body_partitions)
+    g_array_set_size (mux->body_partitions, 0);
+  mux->partition_start = 0;
+  mux->n_written_index_segments = 0;
+
+  if (mux->pending) {
+    gst_buffer_list_unref (mux->pending);
+    mux->pending = NULL;
+  }
 }
 
 static gboolean
@@ -1285,10 +1403,12 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
         mxf_uuid_init (&s.instance_id, mux->metadata);
         memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
             sizeof (s.index_edit_rate));
+        /* segments are only added once the previous one is full */
         if (mux->index_table->len > 0)
           s.index_start_position =
               g_array_index (mux->index_table, MXFIndexTableSegment,
-              mux->index_table->len - 1).index_start_position;
+              mux->index_table->len - 1).index_start_position +
+              max_segment_size;
         else
           s.index_start_position = 0;
         s.index_duration = 0;
@@ -1343,7 +1463,8 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
             if (mux->index_table->len > 0)
               s.index_start_position =
                   g_array_index (mux->index_table, MXFIndexTableSegment,
-                  mux->index_table->len - 1).index_start_position;
+                  mux->index_table->len - 1).index_start_position +
+                  max_segment_size;
             else
               s.index_start_position = 0;
             s.index_duration = 0;
@@ -1406,19 +1527,16 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   GST_WRITE_UINT32_BE (map.data + 12, pad->source_track->parent.track_number);
   memcpy (map.data + 16, ber, slen);
   gst_buffer_unmap (outbuf, &map);
-  outbuf = gst_buffer_append (outbuf, buf);
 
   GST_DEBUG_OBJECT (pad,
-      "Pushing buffer of size %" G_GSIZE_FORMAT " for track %u",
-      gst_buffer_get_size (outbuf), pad->source_track->parent.track_id);
+      "Queueing buffer of size %" G_GSIZE_FORMAT " for track %u",
+      16 + slen + buf_size, pad->source_track->parent.track_id);
 
-  mux->partition.body_offset += gst_buffer_get_size (outbuf);
-  if ((ret = gst_mxf_mux_push (mux, outbuf)) != GST_FLOW_OK) {
-    GST_ERROR_OBJECT (pad,
-        "Failed pushing buffer for track %u, reason %s",
-        pad->source_track->parent.track_id, gst_flow_get_name (ret));
-    return ret;
-  }
+  /* The key and length and the essence are kept as separate buffers and
+   * pushed with the rest of the content package */
+  mux->partition.body_offset += 16 + slen + buf_size;
+  gst_mxf_mux_queue (mux, outbuf);
+  gst_mxf_mux_queue (mux, buf);
 
   pad->pos++;
   pad->last_timestamp =
@@ -1428,26 +1546,59 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   return ret;
 }
 
+/* Starts a new body partition. The body offset keeps counting from the
+ * previous body partitions, and the index table segments that are complete
+ * and can't be changed anymore by the temporal offsets of later edit units
+ * are repeated in it */
 static GstFlowReturn
 gst_mxf_mux_write_body_partition (GstMXFMux * mux)
 {
+  GstFlowReturn ret;
   GstBuffer *buf;
+  GList *index_buffers = NULL, *l;
+  guint index_byte_count = 0;
+  MXFRandomIndexPackEntry entry;
+
+  while (mux->n_written_index_segments + 2 <= mux->current_index_pos) {
+    MXFIndexTableSegment *segment = &g_array_index (mux->index_table,
+        MXFIndexTableSegment, mux->n_written_index_segments);
+
+    buf = mxf_index_table_segment_to_buffer (segment);
+    index_byte_count += gst_buffer_get_size (buf);
+    index_buffers = g_list_prepend (index_buffers, buf);
+    mux->n_written_index_segments++;
+  }
+  index_buffers = g_list_reverse (index_buffers);
 
   mux->partition.type = MXF_PARTITION_PACK_BODY;
   mux->partition.closed = TRUE;
   mux->partition.complete = TRUE;
+  mux->partition.prev_partition = mux->partition.this_partition;
   mux->partition.this_partition = mux->offset;
-  mux->partition.prev_partition = 0;
   mux->partition.footer_partition = 0;
   mux->partition.header_byte_count = 0;
-  mux->partition.index_byte_count = 0;
-  mux->partition.index_sid = 0;
-  mux->partition.body_offset = 0;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_byte_count ?
+      mux->preface->content_storage->essence_container_data[0]->index_sid : 0;
   mux->partition.body_sid =
       mux->preface->content_storage->essence_container_data[0]->body_sid;
 
+  entry.offset = mux->partition.this_partition;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->body_partitions, entry);
+
   buf = mxf_partition_pack_to_buffer (&mux->partition);
-  return gst_mxf_mux_push (mux, buf);
+  ret = gst_mxf_mux_push (mux, buf);
+
+  for (l = index_buffers; l; l = l->next) {
+    if (ret == GST_FLOW_OK)
+      ret = gst_mxf_mux_push (mux, l->data);
+    else
+      gst_buffer_unref (l->data);
+  }
+  g_list_free (index_buffers);
+
+  return ret;
 }
 
 static GstFlowReturn
@@ -1565,7 +1716,9 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
   {
     guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
+    guint64 first_body_partition =
+        g_array_index (mux->body_partitions, MXFRandomIndexPackEntry,
+        0).offset;
     guint64 footer_partition = mux->offset;
     GArray *rip;
     GstFlowReturn ret;
@@ -1608,13 +1761,13 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_list_free (index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
+    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry),
+        mux->body_partitions->len + 2);
     entry.offset = 0;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
+    g_array_append_vals (rip, mux->body_partitions->data,
+        mux->body_partitions->len);
     entry.offset = footer_partition;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
@@ -1648,7 +1801,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
         return ret;
       }
 
-      g_assert (mux->offset == body_partition);
+      g_assert (mux->offset == first_body_partition);
 
       mux->partition.type = MXF_PARTITION_PACK_BODY;
       mux->partition.closed = TRUE;
@@ -1677,6 +1830,45 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
   return GST_FLOW_OK;
 }
 
+/* Called before the first essence element of each content package */
+static GstFlowReturn
+gst_mxf_mux_start_content_package (GstMXFMux * mux)
+{
+  GstClockTime partition_duration;
+  GstBuffer *buffer = NULL;
+  gboolean keyframe;
+
+  GST_OBJECT_LOCK (mux);
+  partition_duration = mux->partition_duration;
+  GST_OBJECT_UNLOCK (mux);
+
+  if (partition_duration == 0 ||
+      mux->last_gc_timestamp < mux->partition_start + partition_duration)
+    return gst_mxf_mux_flush (mux);
+
+  /* only split at keyframes of the indexed stream, which comes first */
+  GST_OBJECT_LOCK (mux);
+  if (GST_ELEMENT_CAST (mux)->sinkpads)
+    buffer =
+        gst_aggregator_pad_get_buffer (GST_AGGREGATOR_PAD (GST_ELEMENT_CAST
+            (mux)->sinkpads->data));
+  GST_OBJECT_UNLOCK (mux);
+
+  if (!buffer)
+    return gst_mxf_mux_flush (mux);
+
+  keyframe = !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  gst_buffer_unref (buffer);
+  if (!keyframe)
+    return gst_mxf_mux_flush (mux);
+
+  GST_DEBUG_OBJECT (mux, "Starting new body partition at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (mux->last_gc_timestamp));
+  mux->partition_start = mux->last_gc_timestamp;
+
+  return gst_mxf_mux_write_body_partition (mux);
+}
+
 static gint
 _sort_mux_pads (gconstpointer a, gconstpointer b)
 {
@@ -1712,6 +1904,7 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
   GstFlowReturn ret;
   GList *l;
   gboolean eos = TRUE;
+  gboolean new_content_package = FALSE;
 
   if (timeout) {
     GST_ELEMENT_ERROR (mux, STREAM, MUX, (NULL),
@@ -1792,6 +1985,7 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
       } else if (!eos && !l->next) {
         mux->last_gc_position++;
         mux->last_gc_timestamp = next_gc_timestamp;
+        new_content_package = TRUE;
         eos = FALSE;
         if (buffer)
           gst_buffer_unref (buffer);
@@ -1804,6 +1998,14 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     GST_OBJECT_UNLOCK (mux);
   } while (!eos && best == NULL);
 
+  if (new_content_package && !eos) {
+    if ((ret = gst_mxf_mux_start_content_package (mux)) != GST_FLOW_OK) {
+      if (best)
+        gst_object_unref (best);
+      goto error;
+    }
+  }
+
   if (!eos && best) {
     ret = gst_mxf_mux_handle_buffer (mux, best);
     gst_object_unref (best);
@@ -72,6 +72,16 @@ typedef struct _GstMXFMux {
   GArray *index_table;
   guint current_index_pos;
   guint64 last_keyframe_pos;
+
+  /* properties */
+  GstClockTime partition_duration;
+
+  GstClockTime partition_start;
+  GArray *body_partitions; /* MXFRandomIndexPackEntry */
+  guint n_written_index_segments;
+
+  /* essence of the current content package, pushed at once */
+  GstBufferList *pending;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
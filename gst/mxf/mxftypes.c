@@ -1689,8 +1689,10 @@ mxf_local_tag_add_to_hash_table (const MXFPrimerPack * primer,
     local_tag = g_slice_new0 (MXFLocalTag);
     memcpy (&local_tag->ul, ul, sizeof (MXFUL));
     local_tag->size = tag_size;
-    local_tag->data = tag_size == 0 ? NULL : g_memdup (tag_data, tag_size);
-    local_tag->g_slice = FALSE;
+    /* unknown tags are plentiful in files with a lot of descriptive
+     * metadata, keep them in the slice allocator */
+    local_tag->data = tag_size == 0 ? NULL : g_slice_copy (tag_size, tag_data);
+    local_tag->g_slice = TRUE;
 
     g_hash_table_insert (*hash_table, &local_tag->ul, local_tag);
   } else {
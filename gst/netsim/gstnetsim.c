@@ -42,7 +42,9 @@ enum
   ARG_DELAY_PROBABILITY,
   ARG_DROP_PROBABILITY,
   ARG_DUPLICATE_PROBABILITY,
-  ARG_DROP_PACKETS
+  ARG_DROP_PACKETS,
+  ARG_MAX_KBPS,
+  ARG_MAX_BUCKET_SIZE
 };
 
 struct _GstNetSimPrivate
@@ -61,6 +63,18 @@ struct _GstNetSimPrivate
   gfloat drop_probability;
   gfloat duplicate_probability;
   guint drop_packets;
+  gint max_kbps;
+  gint max_bucket_size;
+
+  /* delayed packets, sorted on the time they are due, and the single
+   * source that releases them on the main loop */
+  GSequence *delayed;
+  GSource *delay_source;
+  guint64 delay_seqnum;
+
+  /* token bucket, in bits */
+  gint64 bucket_size;
+  gint64 bucket_time;
 };
 
 /* these numbers are nothing but wild guesses and dont reflect any reality */
@@ -70,6 +84,8 @@ struct _GstNetSimPrivate
 #define DEFAULT_DROP_PROBABILITY 0.0
 #define DEFAULT_DUPLICATE_PROBABILITY 0.0
 #define DEFAULT_DROP_PACKETS 0
+#define DEFAULT_MAX_KBPS -1
+#define DEFAULT_MAX_BUCKET_SIZE -1
 
 #define GST_NET_SIM_GET_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), GST_TYPE_NET_SIM, \
@@ -127,6 +143,99 @@ _main_loop_quit_and_remove_source (gpointer user_data)
   return FALSE;                 /* Remove source */
 }
 
+typedef struct
+{
+  GstBuffer *buf;
+  gint64 ready_time;
+  guint64 seqnum;
+} DelayedPacket;
+
+static void
+delayed_packet_free (DelayedPacket * packet)
+{
+  gst_buffer_unref (packet->buf);
+  g_slice_free (DelayedPacket, packet);
+}
+
+static gint
+delayed_packet_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const DelayedPacket *pa = a;
+  const DelayedPacket *pb = b;
+
+  (void) user_data;
+
+  if (pa->ready_time != pb->ready_time)
+    return pa->ready_time < pb->ready_time ? -1 : 1;
+  if (pa->seqnum != pb->seqnum)
+    return pa->seqnum < pb->seqnum ? -1 : 1;
+  return 0;
+}
+
+/* must be called with loop_mutex taken */
+static void
+gst_net_sim_update_delay_source (GstNetSim * netsim)
+{
+  GSequenceIter *first;
+
+  if (netsim->priv->delay_source == NULL)
+    return;
+
+  first = g_sequence_get_begin_iter (netsim->priv->delayed);
+  if (g_sequence_iter_is_end (first)) {
+    g_source_set_ready_time (netsim->priv->delay_source, -1);
+  } else {
+    DelayedPacket *packet = g_sequence_get (first);
+    g_source_set_ready_time (netsim->priv->delay_source, packet->ready_time);
+  }
+}
+
+static gboolean
+gst_net_sim_delay_source_dispatch (GSource * source, GSourceFunc callback,
+    gpointer user_data)
+{
+  (void) source;
+
+  return callback (user_data);
+}
+
+static GSourceFuncs gst_net_sim_delay_source_funcs = {
+  NULL, NULL, gst_net_sim_delay_source_dispatch, NULL
+};
+
+/* pushes all the packets that are due in one buffer list */
+static gboolean
+gst_net_sim_release_delayed (GstNetSim * netsim)
+{
+  GstBufferList *list = NULL;
+  GSequenceIter *iter;
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&netsim->priv->loop_mutex);
+  while (!g_sequence_iter_is_end (iter =
+          g_sequence_get_begin_iter (netsim->priv->delayed))) {
+    DelayedPacket *packet = g_sequence_get (iter);
+
+    if (packet->ready_time > now)
+      break;
+
+    if (list == NULL)
+      list = gst_buffer_list_new ();
+    gst_buffer_list_add (list, gst_buffer_ref (packet->buf));
+    g_sequence_remove (iter);
+  }
+  gst_net_sim_update_delay_source (netsim);
+  g_mutex_unlock (&netsim->priv->loop_mutex);
+
+  if (list) {
+    GST_DEBUG_OBJECT (netsim, "Pushing %u delayed packets now",
+        gst_buffer_list_length (list));
+    gst_pad_push_list (netsim->priv->srcpad, list);
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active)
@@ -142,7 +251,14 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
     if (netsim->priv->main_loop == NULL) {
       GMainContext *main_context = g_main_context_new ();
       netsim->priv->main_loop = g_main_loop_new (main_context, FALSE);
+
+      netsim->priv->delay_source =
+          g_source_new (&gst_net_sim_delay_source_funcs, sizeof (GSource));
+      g_source_set_callback (netsim->priv->delay_source,
+          (GSourceFunc) gst_net_sim_release_delayed, netsim, NULL);
+      g_source_attach (netsim->priv->delay_source, main_context);
       g_main_context_unref (main_context);
+      netsim->priv->bucket_time = -1;
 
       GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
       result = gst_pad_start_task (netsim->priv->srcpad,
@@ -162,6 +278,13 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
       /* Adds an Idle Source which quits the main loop from within.
        * This removes the possibility for run/quit race conditions. */
       GST_TRACE_OBJECT (netsim, "DEACT: Stopping main loop on deactivate");
+      g_source_destroy (netsim->priv->delay_source);
+      g_source_unref (netsim->priv->delay_source);
+      netsim->priv->delay_source = NULL;
+      g_sequence_remove_range (g_sequence_get_begin_iter
+          (netsim->priv->delayed),
+          g_sequence_get_end_iter (netsim->priv->delayed));
+
       source = g_idle_source_new ();
       g_source_set_callback (source, _main_loop_quit_and_remove_source,
           g_main_loop_ref (netsim->priv->main_loop),
@@ -188,39 +311,6 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
   return result;
 }
 
-typedef struct
-{
-  GstPad *pad;
-  GstBuffer *buf;
-} PushBufferCtx;
-
-G_INLINE_FUNC PushBufferCtx *
-push_buffer_ctx_new (GstPad * pad, GstBuffer * buf)
-{
-  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
-  ctx->pad = gst_object_ref (pad);
-  ctx->buf = gst_buffer_ref (buf);
-  return ctx;
-}
-
-G_INLINE_FUNC void
-push_buffer_ctx_free (PushBufferCtx * ctx)
-{
-  if (G_LIKELY (ctx != NULL)) {
-    gst_buffer_unref (ctx->buf);
-    gst_object_unref (ctx->pad);
-    g_slice_free (PushBufferCtx, ctx);
-  }
-}
-
-static gboolean
-push_buffer_ctx_push (PushBufferCtx * ctx)
-{
-  GST_DEBUG_OBJECT (ctx->pad, "Pushing buffer now");
-  gst_pad_push (ctx->pad, gst_buffer_ref (ctx->buf));
-  return FALSE;
-}
-
 static GstFlowReturn
 gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
 {
@@ -230,16 +320,17 @@ gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
   if (netsim->priv->main_loop != NULL && netsim->priv->delay_probability > 0 &&
       g_rand_double (netsim->priv->rand_seed) < netsim->priv->delay_probability)
   {
-    PushBufferCtx *ctx = push_buffer_ctx_new (netsim->priv->srcpad, buf);
+    DelayedPacket *packet = g_slice_new (DelayedPacket);
     gint delay = g_rand_int_range (netsim->priv->rand_seed,
         netsim->priv->min_delay, netsim->priv->max_delay);
-    GSource *source = g_timeout_source_new (delay);
 
     GST_DEBUG_OBJECT (netsim, "Delaying packet by %d", delay);
-    g_source_set_callback (source, (GSourceFunc) push_buffer_ctx_push,
-        ctx, (GDestroyNotify) push_buffer_ctx_free);
-    g_source_attach (source, g_main_loop_get_context (netsim->priv->main_loop));
-    g_source_unref (source);
+    packet->buf = gst_buffer_ref (buf);
+    packet->ready_time = g_get_monotonic_time () + (gint64) delay * 1000;
+    packet->seqnum = netsim->priv->delay_seqnum++;
+    g_sequence_insert_sorted (netsim->priv->delayed, packet,
+        delayed_packet_compare, NULL);
+    gst_net_sim_update_delay_source (netsim);
   } else {
     ret = gst_pad_push (netsim->priv->srcpad, gst_buffer_ref (buf));
   }
@@ -248,6 +339,49 @@ gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
   return ret;
 }
 
+/* refills the token bucket for the time elapsed since the last packet and
+ * takes the tokens for @buf out of it, returns FALSE if there are not
+ * enough of them */
+static gboolean
+gst_net_sim_token_bucket (GstNetSim * netsim, GstBuffer * buf)
+{
+  GstNetSimPrivate *priv = netsim->priv;
+  gint64 capacity, now, tokens;
+  gint64 bits = (gint64) gst_buffer_get_size (buf) * 8;
+
+  if (priv->max_kbps < 0)
+    return TRUE;
+
+  /* without an explicit bucket size, allow bursts of one second */
+  capacity = (gint64) (priv->max_bucket_size >= 0 ?
+      priv->max_bucket_size : priv->max_kbps) * 1000;
+
+  now = g_get_monotonic_time ();
+  if (priv->bucket_time < 0) {
+    priv->bucket_size = capacity;
+    priv->bucket_time = now;
+  } else if (priv->max_kbps > 0) {
+    /* only spend the time that makes up whole tokens */
+    tokens = (now - priv->bucket_time) * priv->max_kbps / 1000;
+    priv->bucket_time += tokens * 1000 / priv->max_kbps;
+    priv->bucket_size += tokens;
+  }
+
+  if (priv->bucket_size >= capacity) {
+    priv->bucket_size = capacity;
+    priv->bucket_time = now;
+  }
+
+  if (bits > priv->bucket_size) {
+    GST_LOG_OBJECT (netsim, "Packet of %" G_GINT64_FORMAT " bits exceeds the "
+        "%" G_GINT64_FORMAT " tokens left", bits, priv->bucket_size);
+    return FALSE;
+  }
+
+  priv->bucket_size -= bits;
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -256,7 +390,9 @@ gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   (void) pad;
 
-  if (netsim->priv->drop_packets > 0) {
+  if (!gst_net_sim_token_bucket (netsim, buf)) {
+    GST_DEBUG_OBJECT (netsim, "Dropping packet over the bandwidth limit");
+  } else if (netsim->priv->drop_packets > 0) {
     netsim->priv->drop_packets--;
     GST_DEBUG_OBJECT (netsim, "Dropping packet (%d left)",
         netsim->priv->drop_packets);
@@ -308,6 +444,12 @@ gst_net_sim_set_property (GObject * object,
     case ARG_DROP_PACKETS:
       netsim->priv->drop_packets = g_value_get_uint (value);
       break;
+    case ARG_MAX_KBPS:
+      netsim->priv->max_kbps = g_value_get_int (value);
+      break;
+    case ARG_MAX_BUCKET_SIZE:
+      netsim->priv->max_bucket_size = g_value_get_int (value);
+      break;
   }
 }
 
@@ -339,6 +481,12 @@ gst_net_sim_get_property (GObject * object,
     case ARG_DROP_PACKETS:
       g_value_set_uint (value, netsim->priv->drop_packets);
       break;
+    case ARG_MAX_KBPS:
+      g_value_set_int (value, netsim->priv->max_kbps);
+      break;
+    case ARG_MAX_BUCKET_SIZE:
+      g_value_set_int (value, netsim->priv->max_bucket_size);
+      break;
   }
 }
 
@@ -360,6 +508,9 @@ gst_net_sim_init (GstNetSim * netsim)
   g_cond_init (&netsim->priv->start_cond);
   netsim->priv->rand_seed = g_rand_new ();
   netsim->priv->main_loop = NULL;
+  netsim->priv->delayed =
+      g_sequence_new ((GDestroyNotify) delayed_packet_free);
+  netsim->priv->bucket_time = -1;
 
   GST_OBJECT_FLAG_SET (netsim->priv->sinkpad,
       GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
@@ -376,6 +527,7 @@ gst_net_sim_finalize (GObject * object)
   GstNetSim *netsim = GST_NET_SIM (object);
 
   g_rand_free (netsim->priv->rand_seed);
+  g_sequence_free (netsim->priv->delayed);
   g_mutex_clear (&netsim->priv->loop_mutex);
   g_cond_clear (&netsim->priv->start_cond);
 
@@ -454,6 +606,35 @@ gst_net_sim_class_init (GstNetSimClass * klass)
           0, G_MAXUINT, DEFAULT_DROP_PACKETS,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstNetSim:max-kbps:
+   *
+   * The maximum number of kilobits to let through per second. Packets are
+   * accounted for with a token bucket and dropped when it runs empty.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_KBPS,
+      g_param_spec_int ("max-kbps", "Maximum Kbps",
+          "The maximum number of kilobits to let through per second "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_MAX_KBPS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:max-bucket-size:
+   *
+   * The size of the token bucket in kilobits, which is how large a burst
+   * can be let through at once when #GstNetSim:max-kbps is set.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_BUCKET_SIZE,
+      g_param_spec_int ("max-bucket-size", "Maximum Bucket Size (Kb)",
+          "The size of the token bucket, related to burstiness resilience "
+          "(-1 = one second of max-kbps)", -1, G_MAXINT,
+          DEFAULT_MAX_BUCKET_SIZE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (netsim_debug, "netsim", 0, "Network simulator");
 }
 
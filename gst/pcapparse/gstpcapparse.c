@@ -91,6 +91,11 @@ static void gst_pcap_parse_reset (GstPcapParse * self);
 
 static GstFlowReturn gst_pcap_parse_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer);
+static gboolean gst_pcap_parse_sink_activate (GstPad * pad,
+    GstObject * parent);
+static gboolean gst_pcap_parse_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static void gst_pcap_parse_loop (GstPad * pad);
 static gboolean gst_pcap_sink_event (GstPad * pad,
     GstObject * parent, GstEvent * event);
 
@@ -157,6 +162,10 @@ gst_pcap_parse_init (GstPcapParse * self)
   self->sink_pad = gst_pad_new_from_static_template (&sink_template, "sink");
   gst_pad_set_chain_function (self->sink_pad,
       GST_DEBUG_FUNCPTR (gst_pcap_parse_chain));
+  gst_pad_set_activate_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_sink_activate));
+  gst_pad_set_activatemode_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_sink_activate_mode));
   gst_pad_use_fixed_caps (self->sink_pad);
   gst_pad_set_event_function (self->sink_pad,
       GST_DEBUG_FUNCPTR (gst_pcap_sink_event));
@@ -341,6 +350,10 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
 #define IP_PROTO_UDP      17
 #define IP_PROTO_TCP      6
 
+/* In pull mode the file is read in large blocks, the packets of a block are
+ * pushed in one list and most of them are sub-buffers of the block */
+#define PULL_BLOCK_SIZE   (512 * 1024)
+
 
 static gboolean
 gst_pcap_parse_scan_frame (GstPcapParse * self,
@@ -449,9 +462,8 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
 }
 
 static GstFlowReturn
-gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_pcap_parse_process (GstPcapParse * self, GstBuffer * buffer)
 {
-  GstPcapParse *self = GST_PCAP_PARSE (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstBufferList *list = NULL;
 
@@ -614,6 +626,113 @@ out:
   return ret;
 }
 
+static GstFlowReturn
+gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  return gst_pcap_parse_process (GST_PCAP_PARSE (parent), buffer);
+}
+
+static void
+gst_pcap_parse_loop (GstPad * pad)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (GST_PAD_PARENT (pad));
+  GstFlowReturn ret;
+  GstBuffer *buffer = NULL;
+
+  if (self->pull_offset == 0) {
+    gchar *stream_id;
+
+    stream_id = gst_pad_create_stream_id (self->src_pad,
+        GST_ELEMENT_CAST (self), NULL);
+    gst_pad_push_event (self->src_pad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+  }
+
+  ret = gst_pad_pull_range (pad, self->pull_offset, PULL_BLOCK_SIZE, &buffer);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  if (gst_buffer_get_size (buffer) == 0) {
+    gst_buffer_unref (buffer);
+    ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  self->pull_offset += gst_buffer_get_size (buffer);
+
+  ret = gst_pcap_parse_process (self, buffer);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  GST_DEBUG_OBJECT (self, "pausing task, reason %s", gst_flow_get_name (ret));
+  gst_pad_pause_task (pad);
+  if (ret == GST_FLOW_EOS) {
+    gst_pad_push_event (self->src_pad, gst_event_new_eos ());
+  } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+    GST_ELEMENT_FLOW_ERROR (self, ret);
+    gst_pad_push_event (self->src_pad, gst_event_new_eos ());
+  }
+}
+
+static gboolean
+gst_pcap_parse_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull_mode;
+
+  query = gst_query_new_scheduling ();
+
+  if (!gst_pad_peer_query (sinkpad, query)) {
+    gst_query_unref (query);
+    goto activate_push;
+  }
+
+  pull_mode = gst_query_has_scheduling_mode (query, GST_PAD_MODE_PULL);
+  gst_query_unref (query);
+
+  if (!pull_mode)
+    goto activate_push;
+
+  GST_DEBUG_OBJECT (sinkpad, "activating pull");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+
+activate_push:
+  GST_DEBUG_OBJECT (sinkpad, "activating push");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+}
+
+static gboolean
+gst_pcap_parse_sink_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (parent);
+  gboolean res;
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      res = TRUE;
+      break;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        gst_pcap_parse_reset (self);
+        self->pull_offset = 0;
+        res = gst_pad_start_task (pad, (GstTaskFunction) gst_pcap_parse_loop,
+            pad, NULL);
+      } else {
+        res = gst_pad_stop_task (pad);
+      }
+      break;
+    default:
+      res = FALSE;
+      break;
+  }
+
+  return res;
+}
+
 static gboolean
 gst_pcap_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -84,6 +84,9 @@ struct _GstPcapParse
   GstPcapParseLinktype linktype;
 
   gboolean newsegment_sent;
+
+  /* pull mode */
+  guint64 pull_offset;
 };
 
 struct _GstPcapParseClass
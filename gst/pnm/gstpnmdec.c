@@ -364,6 +364,21 @@ gst_pnmdec_handle_frame (GstVideoDecoder * decoder, GstVideoCodecFrame * frame)
   GstFlowReturn r = GST_FLOW_OK;
   gint bytes, i, total_bytes = 0;
 
+  /* Binary data that already has the GStreamer rowstride and range can be
+   * pushed as is, without copying it into a new frame */
+  if (s->mngr.info.encoding != GST_PNM_ENCODING_ASCII &&
+      s->mngr.info.type != GST_PNM_TYPE_BITMAP &&
+      s->mngr.info.width % 4 == 0 &&
+      (s->mngr.info.max == 255 || (s->mngr.info.max == 65535 &&
+              s->out_format == GST_VIDEO_FORMAT_GRAY16_BE)) &&
+      gst_buffer_get_size (frame->input_buffer) >= s->size) {
+    frame->output_buffer = gst_buffer_copy_region (frame->input_buffer,
+        GST_BUFFER_COPY_METADATA | GST_BUFFER_COPY_MEMORY, 0, s->size);
+    s->current_size = 0;
+    r = gst_video_decoder_finish_frame (GST_VIDEO_DECODER (s), frame);
+    goto out;
+  }
+
   r = gst_video_decoder_allocate_output_frame (decoder, frame);
   if (r != GST_FLOW_OK) {
     gst_video_decoder_drop_frame (GST_VIDEO_DECODER (s), frame);
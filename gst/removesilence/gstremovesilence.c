@@ -61,21 +61,21 @@ enum
 };
 
 
+#define REMOVE_SILENCE_CAPS \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+    GST_STATIC_CAPS (REMOVE_SILENCE_CAPS));
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+    GST_STATIC_CAPS (REMOVE_SILENCE_CAPS));
 
 
 #define DEBUG_INIT(bla) \
@@ -90,6 +90,8 @@ static void gst_remove_silence_set_property (GObject * object, guint prop_id,
 static void gst_remove_silence_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static gboolean gst_remove_silence_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
 static GstFlowReturn gst_remove_silence_transform_ip (GstBaseTransform * base,
     GstBuffer * buf);
 static void gst_remove_silence_finalize (GObject * obj);
@@ -131,6 +133,8 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
 
+  GST_BASE_TRANSFORM_CLASS (klass)->set_caps =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform_ip =
       GST_DEBUG_FUNCPTR (gst_remove_silence_transform_ip);
 }
@@ -145,6 +149,7 @@ gst_remove_silence_init (GstRemoveSilence * filter)
 {
   filter->vad = vad_new (DEFAULT_VAD_HYSTERESIS);
   filter->remove = FALSE;
+  gst_audio_info_init (&filter->info);
 
   if (!filter->vad) {
     GST_DEBUG ("Error initializing VAD !!");
@@ -201,18 +206,40 @@ gst_remove_silence_get_property (GObject * object, guint prop_id,
   }
 }
 
+static gboolean
+gst_remove_silence_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+
+  if (!gst_audio_info_from_caps (&filter->info, incaps)) {
+    GST_ERROR_OBJECT (filter, "invalid caps %" GST_PTR_FORMAT, incaps);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
 {
   GstRemoveSilence *filter = NULL;
   int frame_type;
   GstMapInfo map;
+  gint channels, frames;
 
   filter = GST_REMOVE_SILENCE (trans);
 
+  channels = GST_AUDIO_INFO_CHANNELS (&filter->info);
+
   gst_buffer_map (inbuf, &map, GST_MAP_READ);
-  frame_type =
-      vad_update (filter->vad, (gint16 *) map.data, map.size / sizeof (gint16));
+  frames = map.size / GST_AUDIO_INFO_BPF (&filter->info);
+  if (GST_AUDIO_INFO_FORMAT (&filter->info) == GST_AUDIO_FORMAT_F32)
+    frame_type =
+        vad_update_f32 (filter->vad, (gfloat *) map.data, frames, channels);
+  else
+    frame_type =
+        vad_update_s16 (filter->vad, (gint16 *) map.data, frames, channels);
   gst_buffer_unmap (inbuf, &map);
 
   if (frame_type == VAD_SILENCE) {
@@ -24,6 +24,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
 #include "vad_private.h"
 
 G_BEGIN_DECLS
@@ -43,6 +44,7 @@ typedef struct _GstRemoveSilence {
   GstBaseTransform parent;
   VADFilter* vad;
   gboolean remove;
+  GstAudioInfo info;
 } GstRemoveSilence;
 
 typedef struct _GstRemoveSilenceClass {
@@ -22,43 +22,24 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <glib.h>
 #include "vad_private.h"
 
-#define VAD_POWER_ALPHA     0x0800      /* Q16 */
-#define VAD_POWER_THRESHOLD 0x000010C7  /* -60 dB (square wave) */
+#define VAD_POWER_ALPHA     (1.0 / 32.0)
+#define VAD_POWER_THRESHOLD 1e-6        /* -60 dB (square wave) */
 #define VAD_ZCR_THRESHOLD   0
 #define VAD_BUFFER_SIZE     256
 
-
-union pgen
-{
-  guint64 a;
-  gpointer v;
-  guint64 *l;
-  guchar *b;
-  guint16 *w;
-  gint16 *s;
-};
-
-struct _cqueue_s
-{
-  union pgen base;
-  union pgen tail;
-  union pgen head;
-  gint size;
-};
-
-typedef struct _cqueue_s cqueue_t;
-
 struct _vad_s
 {
-  gint16 vad_buffer[VAD_BUFFER_SIZE];
-  cqueue_t cqueue;
+  /* signs of the last samples, for the zero crossing rate */
+  guint8 signs[VAD_BUFFER_SIZE];
+  gint n_signs;
   gint vad_state;
   guint64 hysteresis;
   guint64 vad_samples;
-  guint64 vad_power;
+  gdouble vad_power;
   long vad_zcr;
 };
 
@@ -75,9 +56,6 @@ void
 vad_reset (VADFilter * vad)
 {
   memset (vad, 0, sizeof (*vad));
-  vad->cqueue.base.s = vad->vad_buffer;
-  vad->cqueue.tail.a = vad->cqueue.head.a = 0;
-  vad->cqueue.size = VAD_BUFFER_SIZE;
   vad->vad_state = VAD_SILENCE;
 }
 
@@ -99,35 +77,37 @@ vad_get_hysteresis (struct _vad_s *p)
   return p->hysteresis;
 }
 
-gint
-vad_update (struct _vad_s * p, gint16 * data, gint len)
+/* Appends the signs of the last frames to the history and counts the zero
+ * crossings in it. */
+static void
+vad_update_zcr (struct _vad_s *p, const guint8 * signs, gint n)
 {
-  guint64 tail;
+  gint keep, i, crossings;
+
+  keep = MIN (p->n_signs, VAD_BUFFER_SIZE - n);
+  memmove (p->signs, p->signs + p->n_signs - keep, keep);
+  memcpy (p->signs + keep, signs, n);
+  p->n_signs = keep + n;
+
+  crossings = 0;
+  for (i = 1; i < p->n_signs; i++)
+    crossings += p->signs[i - 1] ^ p->signs[i];
+
+  /* +1 for every crossing, -1 for every pair without one */
+  p->vad_zcr = 2 * crossings - MAX (p->n_signs - 1, 0);
+}
+
+/* Smoothes the mean power of the block as if each of its samples had that
+ * power, with the same time constant as a per sample filter, and applies
+ * the hysteresis. */
+static gint
+vad_update_state (struct _vad_s *p, gdouble power, gint frames)
+{
+  gdouble decay;
   gint frame_type;
-  gint16 sample;
-  gint i;
-
-  for (i = 0; i < len; i++) {
-    p->vad_power = VAD_POWER_ALPHA * ((data[i] * data[i] >> 14) & 0xFFFF) +
-        (0xFFFF - VAD_POWER_ALPHA) * (p->vad_power >> 16) +
-        ((0xFFFF - VAD_POWER_ALPHA) * (p->vad_power & 0xFFFF) >> 16);
-    /* Update VAD buffer */
-    p->cqueue.base.s[p->cqueue.head.a] = data[i];
-    p->cqueue.head.a = (p->cqueue.head.a + 1) & (p->cqueue.size - 1);
-    if (p->cqueue.head.a == p->cqueue.tail.a)
-      p->cqueue.tail.a = (p->cqueue.tail.a + 1) & (p->cqueue.size - 1);
-  }
 
-  tail = p->cqueue.tail.a;
-  p->vad_zcr = 0;
-  for (;;) {
-    sample = p->cqueue.base.s[tail];
-    tail = (tail + 1) & (p->cqueue.size - 1);
-    if (tail == p->cqueue.head.a)
-      break;
-    p->vad_zcr +=
-        ((sample & 0x8000) != (p->cqueue.base.s[tail] & 0x8000)) ? 1 : -1;
-  }
+  decay = pow (1.0 - VAD_POWER_ALPHA, frames);
+  p->vad_power = decay * p->vad_power + (1.0 - decay) * power;
 
   frame_type = (p->vad_power > VAD_POWER_THRESHOLD
       && p->vad_zcr < VAD_ZCR_THRESHOLD) ? VAD_VOICE : VAD_SILENCE;
@@ -135,7 +115,7 @@ vad_update (struct _vad_s * p, gint16 * data, gint len)
   if (p->vad_state != frame_type) {
     /* Voice to silence transition */
     if (p->vad_state == VAD_VOICE) {
-      p->vad_samples += len;
+      p->vad_samples += frames;
       if (p->vad_samples >= p->hysteresis) {
         p->vad_state = frame_type;
         p->vad_samples = 0;
@@ -150,3 +130,71 @@ vad_update (struct _vad_s * p, gint16 * data, gint len)
 
   return p->vad_state;
 }
+
+/* The power of the block is computed over all channels at once without any
+ * branches, so that the compiler can vectorize it, and only the last
+ * VAD_BUFFER_SIZE frames are downmixed for the zero crossing rate. */
+gint
+vad_update_s16 (struct _vad_s * p, const gint16 * data, gint frames,
+    gint channels)
+{
+  guint8 signs[VAD_BUFFER_SIZE];
+  guint64 energy = 0;
+  gint i, j, n, first;
+
+  if (frames <= 0)
+    return p->vad_state;
+
+  n = frames * channels;
+  for (i = 0; i < n; i++)
+    energy += (gint32) data[i] * data[i];
+
+  first = MAX (frames - VAD_BUFFER_SIZE, 0);
+  for (i = first; i < frames; i++) {
+    gint32 sum = 0;
+
+    for (j = 0; j < channels; j++)
+      sum += data[i * channels + j];
+    signs[i - first] = sum < 0;
+  }
+  vad_update_zcr (p, signs, frames - first);
+
+  return vad_update_state (p,
+      energy / ((gdouble) n * G_MAXINT16 * G_MAXINT16), frames);
+}
+
+gint
+vad_update_f32 (struct _vad_s * p, const gfloat * data, gint frames,
+    gint channels)
+{
+  guint8 signs[VAD_BUFFER_SIZE];
+  gfloat energy[4] = { 0.0, };
+  gint i, j, n, first;
+
+  if (frames <= 0)
+    return p->vad_state;
+
+  /* independent partial sums, float additions can't be reordered */
+  n = frames * channels;
+  for (i = 0; i + 4 <= n; i += 4) {
+    energy[0] += data[i] * data[i];
+    energy[1] += data[i + 1] * data[i + 1];
+    energy[2] += data[i + 2] * data[i + 2];
+    energy[3] += data[i + 3] * data[i + 3];
+  }
+  for (; i < n; i++)
+    energy[0] += data[i] * data[i];
+
+  first = MAX (frames - VAD_BUFFER_SIZE, 0);
+  for (i = first; i < frames; i++) {
+    gfloat sum = 0.0;
+
+    for (j = 0; j < channels; j++)
+      sum += data[i * channels + j];
+    signs[i - first] = sum < 0.0;
+  }
+  vad_update_zcr (p, signs, frames - first);
+
+  return vad_update_state (p,
+      ((gdouble) energy[0] + energy[1] + energy[2] + energy[3]) / n, frames);
+}
@@ -29,7 +29,9 @@
 
 typedef struct _vad_s VADFilter;
 
-gint vad_update(VADFilter *p, gint16 *data, gint len);
+gint vad_update_s16(VADFilter *p, const gint16 *data, gint frames, gint channels);
+
+gint vad_update_f32(VADFilter *p, const gfloat *data, gint frames, gint channels);
 
 void vad_set_hysteresis(VADFilter *p, guint64 hysteresis);
 
@@ -650,11 +650,11 @@ gst_avwait_asink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
       video_running_time = GST_CLOCK_TIME_NONE;
     }
   }
+  /* Once the running time to start at is known, the audio can be cut
+   * against it directly and never has to wait for the video to catch up */
   while (!(self->video_eos_flag || self->audio_flush_flag
-          || self->shutdown_flag) && (video_running_time == GST_CLOCK_TIME_NONE
-          || gst_avwait_compare_guint64_with_signs (asign,
-              current_running_time, vsign, video_running_time) == 1
-          || self->running_time_to_wait_for == GST_CLOCK_TIME_NONE)) {
+          || self->shutdown_flag)
+      && self->running_time_to_wait_for == GST_CLOCK_TIME_NONE) {
     g_cond_wait (&self->cond, &self->mutex);
     vsign =
         gst_segment_to_running_time_full (&self->vsegment, GST_FORMAT_TIME,
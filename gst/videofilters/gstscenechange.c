@@ -81,6 +81,7 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include <string.h>
+#include <gst/video/gstvideolumameta.h>
 #include "gstscenechange.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
@@ -89,6 +90,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
 /* prototypes */
 
 
+static void gst_scene_change_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_scene_change_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
 static GstFlowReturn gst_scene_change_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
 
@@ -99,9 +104,12 @@ static gboolean is_shot_change (int frame_number);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_ANALYSIS_WIDTH
 };
 
+#define DEFAULT_ANALYSIS_WIDTH 0
+
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y42B, Y41B, Y444 }")
 
@@ -115,8 +123,12 @@ G_DEFINE_TYPE_WITH_CODE (GstSceneChange, gst_scene_change,
 static void
 gst_scene_change_class_init (GstSceneChangeClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
+  gobject_class->set_property = gst_scene_change_set_property;
+  gobject_class->get_property = gst_scene_change_get_property;
+
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
       gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
           gst_caps_from_string (VIDEO_CAPS)));
@@ -132,44 +144,108 @@ gst_scene_change_class_init (GstSceneChangeClass * klass)
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_scene_change_transform_frame_ip);
 
+  /**
+   * GstSceneChange:analysis-width:
+   *
+   * Maximum width of the luma that frames are compared at. Frames are
+   * decimated by powers of two until they fit, and the decimated luma is
+   * shared with other analysis elements through a #GstVideoLumaMeta.
+   * 0 compares the frames at full resolution.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ANALYSIS_WIDTH,
+      g_param_spec_uint ("analysis-width", "Analysis width",
+          "Maximum width of the luma the frames are compared at "
+          "(0 = full resolution)", 0, G_MAXINT, DEFAULT_ANALYSIS_WIDTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_scene_change_init (GstSceneChange * scenechange)
 {
+  scenechange->analysis_width = DEFAULT_ANALYSIS_WIDTH;
 }
 
+static void
+gst_scene_change_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  switch (property_id) {
+    case PROP_ANALYSIS_WIDTH:
+      scenechange->analysis_width = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_scene_change_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  switch (property_id) {
+    case PROP_ANALYSIS_WIDTH:
+      g_value_set_uint (value, scenechange->analysis_width);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
 
 static double
-get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
+get_score (const guint8 * d1, gint stride1, const guint8 * d2, gint stride2,
+    gint width, gint height)
 {
-  int i;
-  int j;
-  int score = 0;
-  int width, height;
-  guint8 *s1;
-  guint8 *s2;
+  guint64 score = 0;
+  int i, j;
 
-  width = f1->info.width;
-  height = f1->info.height;
+  if (width == 0 || height == 0)
+    return 0;
 
   for (j = 0; j < height; j++) {
-    s1 = (guint8 *) f1->data[0] + f1->info.stride[0] * j;
-    s2 = (guint8 *) f2->data[0] + f2->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      score += ABS (s1[i] - s2[i]);
-    }
+    guint score_row = 0;
+
+    /* a row of differences fits in 32 bits, which vectorizes better */
+    for (i = 0; i < width; i++)
+      score_row += ABS (d1[i] - d2[i]);
+    score += score_row;
+    d1 += stride1;
+    d2 += stride2;
   }
 
   return ((double) score) / (width * height);
 }
 
+
+static double
+get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
+{
+  return get_score (f1->data[0], f1->info.stride[0], f2->data[0],
+      f2->info.stride[0], MIN (f1->info.width, f2->info.width),
+      MIN (f1->info.height, f2->info.height));
+}
+
+static double
+get_luma_score (GstVideoLumaMeta * m1, GstVideoLumaMeta * m2)
+{
+  return get_score (m1->data, m1->stride, m2->data, m2->stride,
+      MIN (m1->width, m2->width), MIN (m1->height, m2->height));
+}
+
 static GstFlowReturn
 gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
 {
   GstSceneChange *scenechange = GST_SCENE_CHANGE (filter);
   GstVideoFrame oldframe;
+  GstVideoLumaMeta *luma = NULL, *oldluma = NULL;
   double score_min;
   double score_max;
   double threshold;
@@ -180,6 +256,19 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
 
   GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
 
+  /* attach the decimated luma before keeping a ref on the buffer, it is
+   * compared with the next frame's */
+  if (scenechange->analysis_width > 0) {
+    guint shift = gst_video_luma_meta_shift_for_width (frame->info.width,
+        scenechange->analysis_width);
+
+    luma = gst_buffer_get_video_luma_meta (frame->buffer, shift);
+    if (!luma && gst_buffer_is_writable (frame->buffer))
+      luma = gst_buffer_add_video_luma_meta (frame->buffer, frame, shift);
+    if (luma && scenechange->oldbuf)
+      oldluma = gst_buffer_get_video_luma_meta (scenechange->oldbuf, shift);
+  }
+
   if (!scenechange->oldbuf) {
     scenechange->n_diffs = 0;
     memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
@@ -188,17 +277,21 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
     return GST_FLOW_OK;
   }
 
-  ret =
-      gst_video_frame_map (&oldframe, &scenechange->oldinfo,
-      scenechange->oldbuf, GST_MAP_READ);
-  if (!ret) {
-    GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
-    return GST_FLOW_ERROR;
-  }
+  if (oldluma) {
+    score = get_luma_score (oldluma, luma);
+  } else {
+    ret =
+        gst_video_frame_map (&oldframe, &scenechange->oldinfo,
+        scenechange->oldbuf, GST_MAP_READ);
+    if (!ret) {
+      GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
+      return GST_FLOW_ERROR;
+    }
 
-  score = get_frame_score (&oldframe, frame);
+    score = get_frame_score (&oldframe, frame);
 
-  gst_video_frame_unmap (&oldframe);
+    gst_video_frame_unmap (&oldframe);
+  }
 
   gst_buffer_unref (scenechange->oldbuf);
   scenechange->oldbuf = gst_buffer_ref (frame->buffer);
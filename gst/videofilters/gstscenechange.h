@@ -45,6 +45,9 @@ struct _GstSceneChange
   GstBuffer *oldbuf;
   GstVideoInfo oldinfo;
   int count;
+
+  /* properties */
+  guint analysis_width;
 };
 
 struct _GstSceneChangeClass
@@ -79,7 +79,9 @@ enum
 /* pad templates */
 
 #define VIDEO_CAPS GST_VIDEO_CAPS_MAKE( \
-    "{ I420, Y444, Y42B, Y41B, YUY2, UYVY, AYUV, NV12, NV21, YV12 }")
+    "{ I420, Y444, Y42B, Y41B, YUY2, UYVY, AYUV, NV12, NV21, YV12, " \
+    "I420_10LE, I420_10BE, I422_10LE, I422_10BE, Y444_10LE, Y444_10BE, " \
+    "P010_10LE, P010_10BE }")
 
 
 /* class initialization */
@@ -199,6 +201,42 @@ gst_zebra_stripe_stop (GstBaseTransform * trans)
   return TRUE;
 }
 
+/* luma stored in 16 bit words, with the threshold and the stripe level
+ * scaled to the depth and shifted like the samples */
+static void
+gst_zebra_stripe_transform_16 (GstZebraStripe * zebrastripe,
+    GstVideoFrame * frame, int t)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  gboolean big_endian = !GST_VIDEO_FORMAT_INFO_IS_LE (finfo);
+  int depth = GST_VIDEO_FORMAT_INFO_DEPTH (finfo, 0);
+  int shift = GST_VIDEO_FORMAT_INFO_SHIFT (finfo, 0);
+  guint threshold = (guint) zebrastripe->y_threshold << (depth - 8 + shift);
+  guint16 black = (16 << (depth - 8)) << shift;
+  int width = frame->info.width;
+  int height = frame->info.height;
+  int i, j;
+
+  for (j = 0; j < height; j++) {
+    guint8 *data = (guint8 *) frame->data[0] + frame->info.stride[0] * j;
+
+    for (i = 0; i < width; i++) {
+      guint8 *p = data + 2 * i;
+
+      if (!((i + j + t) & 0x4))
+        continue;
+
+      if (big_endian) {
+        if (GST_READ_UINT16_BE (p) >= threshold)
+          GST_WRITE_UINT16_BE (p, black);
+      } else {
+        if (GST_READ_UINT16_LE (p) >= threshold)
+          GST_WRITE_UINT16_LE (p, black);
+      }
+    }
+  }
+}
+
 static GstFlowReturn
 gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
@@ -232,6 +270,16 @@ gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
     case GST_VIDEO_FORMAT_AYUV:
       y_position = 1;
       break;
+    case GST_VIDEO_FORMAT_I420_10LE:
+    case GST_VIDEO_FORMAT_I420_10BE:
+    case GST_VIDEO_FORMAT_I422_10LE:
+    case GST_VIDEO_FORMAT_I422_10BE:
+    case GST_VIDEO_FORMAT_Y444_10LE:
+    case GST_VIDEO_FORMAT_Y444_10BE:
+    case GST_VIDEO_FORMAT_P010_10LE:
+    case GST_VIDEO_FORMAT_P010_10BE:
+      gst_zebra_stripe_transform_16 (zebrastripe, frame, t);
+      return GST_FLOW_OK;
     default:
       g_assert_not_reached ();
   }
@@ -28,7 +28,8 @@
  *
  * This element acts like a synchronized audio/video "level". It gathers
  * all audio buffers sent between two video frames, and then sends a message
- * that contains the RMS value of all samples for these buffers.
+ * that contains the RMS value of all samples for these buffers, and since
+ * 1.14 their peak value, for each channel.
  *
  * ## Example launch line
  * |[
@@ -236,10 +237,10 @@ gst_videoframe_audiolevel_change_state (GstElement * element,
       gst_adapter_clear (self->adapter);
       g_queue_foreach (&self->vtimeq, (GFunc) g_free, NULL);
       g_queue_clear (&self->vtimeq);
-      if (self->CS) {
-        g_free (self->CS);
-        self->CS = NULL;
-      }
+      g_free (self->CS);
+      self->CS = NULL;
+      g_free (self->peak);
+      self->peak = NULL;
       g_mutex_unlock (&self->mutex);
       break;
     default:
@@ -262,10 +263,10 @@ gst_videoframe_audiolevel_finalize (GObject * object)
   g_queue_clear (&self->vtimeq);
   self->first_time = GST_CLOCK_TIME_NONE;
   self->total_frames = 0;
-  if (self->CS) {
-    g_free (self->CS);
-    self->CS = NULL;
-  }
+  g_free (self->CS);
+  self->CS = NULL;
+  g_free (self->peak);
+  self->peak = NULL;
 
   g_mutex_clear (&self->mutex);
   g_cond_clear (&self->cond);
@@ -273,54 +274,36 @@ gst_videoframe_audiolevel_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
-#define DEFINE_INT_LEVEL_CALCULATOR(TYPE, RESOLUTION)                         \
-static void inline                                                            \
-gst_videoframe_audiolevel_calculate_##TYPE (gpointer data, guint num, guint channels,        \
-                            gdouble *NCS)                                     \
-{                                                                             \
-  TYPE * in = (TYPE *)data;                                                   \
-  register guint j;                                                           \
-  gdouble squaresum = 0.0;           /* square sum of the input samples */    \
-  register gdouble square = 0.0;     /* Square */                             \
-  gdouble normalizer;                /* divisor to get a [-1.0, 1.0] range */ \
-                                                                              \
-  /* *NCS = 0.0; Normalized Cumulative Square */                              \
-                                                                              \
-  for (j = 0; j < num; j += channels) {                                       \
-    square = ((gdouble) in[j]) * in[j];                                       \
-    squaresum += square;                                                      \
-  }                                                                           \
-                                                                              \
-  normalizer = (gdouble) (G_GINT64_CONSTANT(1) << (RESOLUTION * 2));          \
-  *NCS = squaresum / normalizer;                                              \
-}
-
-DEFINE_INT_LEVEL_CALCULATOR (gint32, 31);
-DEFINE_INT_LEVEL_CALCULATOR (gint16, 15);
-DEFINE_INT_LEVEL_CALCULATOR (gint8, 7);
-
-#define DEFINE_FLOAT_LEVEL_CALCULATOR(TYPE)                                   \
-static void inline                                                            \
-gst_videoframe_audiolevel_calculate_##TYPE (gpointer data, guint num, guint channels,        \
-                            gdouble *NCS)                                     \
+/* All channels are accumulated in one pass over the interleaved samples,
+ * instead of one strided pass per channel, so that every cache line is
+ * only loaded once and the inner loop over the channels can be vectorized
+ * by the compiler. Squares and peaks stay in sample units and are
+ * normalized once per video frame. */
+#define DEFINE_LEVEL_CALCULATOR(TYPE)                                         \
+static void                                                                   \
+gst_videoframe_audiolevel_calculate_##TYPE (gconstpointer data, guint frames, \
+    guint channels, gdouble * CS, gdouble * peak)                             \
 {                                                                             \
-  TYPE * in = (TYPE *)data;                                                   \
-  register guint j;                                                           \
-  gdouble squaresum = 0.0;           /* square sum of the input samples */    \
-  register gdouble square = 0.0;     /* Square */                             \
+  const TYPE *in = (const TYPE *) data;                                       \
+  guint i, c;                                                                 \
                                                                               \
-  /* *NCS = 0.0; Normalized Cumulative Square */                              \
+  for (i = 0; i < frames; i++) {                                              \
+    for (c = 0; c < channels; c++) {                                          \
+      gdouble sample = (gdouble) in[c];                                       \
+      gdouble abs_sample = fabs (sample);                                     \
                                                                               \
-  for (j = 0; j < num; j += channels) {                                       \
-    square = ((gdouble) in[j]) * in[j];                                       \
-    squaresum += square;                                                      \
+      CS[c] += sample * sample;                                               \
+      peak[c] = MAX (peak[c], abs_sample);                                    \
+    }                                                                         \
+    in += channels;                                                           \
   }                                                                           \
-                                                                              \
-  *NCS = squaresum;                                                           \
 }
 
-DEFINE_FLOAT_LEVEL_CALCULATOR (gfloat);
-DEFINE_FLOAT_LEVEL_CALCULATOR (gdouble);
+DEFINE_LEVEL_CALCULATOR (gint32);
+DEFINE_LEVEL_CALCULATOR (gint16);
+DEFINE_LEVEL_CALCULATOR (gint8);
+DEFINE_LEVEL_CALCULATOR (gfloat);
+DEFINE_LEVEL_CALCULATOR (gdouble);
 
 static gboolean
 gst_videoframe_audiolevel_vsink_event (GstPad * pad, GstObject * parent,
@@ -402,18 +385,23 @@ gst_videoframe_audiolevel_asink_event (GstPad * pad, GstObject * parent,
       switch (GST_AUDIO_INFO_FORMAT (&self->ainfo)) {
         case GST_AUDIO_FORMAT_S8:
           self->process = gst_videoframe_audiolevel_calculate_gint8;
+          self->normalizer = (gdouble) (G_GINT64_CONSTANT (1) << 7);
           break;
         case GST_AUDIO_FORMAT_S16:
           self->process = gst_videoframe_audiolevel_calculate_gint16;
+          self->normalizer = (gdouble) (G_GINT64_CONSTANT (1) << 15);
           break;
         case GST_AUDIO_FORMAT_S32:
           self->process = gst_videoframe_audiolevel_calculate_gint32;
+          self->normalizer = (gdouble) (G_GINT64_CONSTANT (1) << 31);
           break;
         case GST_AUDIO_FORMAT_F32:
           self->process = gst_videoframe_audiolevel_calculate_gfloat;
+          self->normalizer = 1.0;
           break;
         case GST_AUDIO_FORMAT_F64:
           self->process = gst_videoframe_audiolevel_calculate_gdouble;
+          self->normalizer = 1.0;
           break;
         default:
           self->process = NULL;
@@ -423,9 +411,10 @@ gst_videoframe_audiolevel_asink_event (GstPad * pad, GstObject * parent,
       channels = GST_AUDIO_INFO_CHANNELS (&self->ainfo);
       self->first_time = GST_CLOCK_TIME_NONE;
       self->total_frames = 0;
-      if (self->CS)
-        g_free (self->CS);
+      g_free (self->CS);
       self->CS = g_new0 (gdouble, channels);
+      g_free (self->peak);
+      self->peak = g_new0 (gdouble, channels);
       break;
     }
     default:
@@ -435,83 +424,79 @@ gst_videoframe_audiolevel_asink_event (GstPad * pad, GstObject * parent,
   return gst_pad_event_default (pad, parent, event);
 }
 
+static void
+append_double (GValueArray * a, gdouble value)
+{
+  GValue v = G_VALUE_INIT;
+
+  g_value_init (&v, G_TYPE_DOUBLE);
+  g_value_set_double (&v, value);
+  g_value_array_append (a, &v);
+}
+
+/* Takes the samples straight from the adapter, without merging them into a
+ * buffer first, and returns the message for them. */
 static GstMessage *
-update_rms_from_buffer (GstVideoFrameAudioLevel * self, GstBuffer * inbuf)
+update_rms_from_adapter (GstVideoFrameAudioLevel * self, gsize bytes)
 {
-  GstMapInfo map;
-  guint8 *in_data;
-  gsize in_size;
-  gdouble CS;
+  const guint8 *in_data = NULL;
   guint i;
-  guint num_frames, frames;
-  guint num_int_samples = 0;    /* number of interleaved samples
-                                 * ie. total count for all channels combined */
-  gint channels, rate, bps;
-  GValue v = G_VALUE_INIT;
+  guint num_frames;
+  gint channels, rate, bpf;
   GValue va = G_VALUE_INIT;
-  GValueArray *a;
+  GValueArray *rms_array, *peak_array;
   GstStructure *s;
-  GstMessage *msg;
   GstClockTime duration, running_time;
 
   channels = GST_AUDIO_INFO_CHANNELS (&self->ainfo);
-  bps = GST_AUDIO_INFO_BPS (&self->ainfo);
+  bpf = GST_AUDIO_INFO_BPF (&self->ainfo);
   rate = GST_AUDIO_INFO_RATE (&self->ainfo);
 
-  gst_buffer_map (inbuf, &map, GST_MAP_READ);
-  in_data = map.data;
-  in_size = map.size;
-
-  num_int_samples = in_size / bps;
+  g_return_val_if_fail (bytes % bpf == 0, NULL);
 
-  GST_LOG_OBJECT (self, "analyzing %u sample frames at ts %" GST_TIME_FORMAT,
-      num_int_samples, GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (inbuf)));
+  num_frames = bytes / bpf;
 
-  g_return_val_if_fail (num_int_samples % channels == 0, NULL);
+  GST_LOG_OBJECT (self, "analyzing %u sample frames", num_frames);
 
-  num_frames = num_int_samples / channels;
-  frames = num_frames;
-  duration = GST_FRAMES_TO_CLOCK_TIME (frames, rate);
   if (num_frames > 0) {
-    for (i = 0; i < channels; ++i) {
-      self->process (in_data + (bps * i), num_int_samples, channels, &CS);
-      GST_LOG_OBJECT (self,
-          "[%d]: cumulative squares %lf, over %d samples/%d channels",
-          i, CS, num_int_samples, channels);
-      self->CS[i] += CS;
-    }
-    in_data += num_frames * bps;
+    in_data = gst_adapter_map (self->adapter, bytes);
+    self->process (in_data, num_frames, channels, self->CS, self->peak);
+    gst_adapter_unmap (self->adapter);
+    gst_adapter_flush (self->adapter, bytes);
 
     self->total_frames += num_frames;
   }
+  duration = GST_FRAMES_TO_CLOCK_TIME (num_frames, rate);
   running_time =
       self->first_time + gst_util_uint64_scale (self->total_frames, GST_SECOND,
       rate);
 
-  a = g_value_array_new (channels);
-  s = gst_structure_new ("videoframe-audiolevel", "running-time", G_TYPE_UINT64,
-      running_time, "duration", G_TYPE_UINT64, duration, NULL);
-
-  g_value_init (&v, G_TYPE_DOUBLE);
-  g_value_init (&va, G_TYPE_VALUE_ARRAY);
+  rms_array = g_value_array_new (channels);
+  peak_array = g_value_array_new (channels);
   for (i = 0; i < channels; i++) {
     gdouble rms;
-    if (frames == 0 || self->CS[i] == 0) {
+
+    if (num_frames == 0 || self->CS[i] == 0) {
       rms = 0;                  /* empty buffer */
     } else {
-      rms = sqrt (self->CS[i] / frames);
+      rms = sqrt (self->CS[i] / num_frames) / self->normalizer;
     }
+    append_double (rms_array, rms);
+    append_double (peak_array, self->peak[i] / self->normalizer);
     self->CS[i] = 0.0;
-    g_value_set_double (&v, rms);
-    g_value_array_append (a, &v);
+    self->peak[i] = 0.0;
   }
-  g_value_take_boxed (&va, a);
-  gst_structure_take_value (s, "rms", &va);
-  msg = gst_message_new_element (GST_OBJECT (self), s);
 
-  gst_buffer_unmap (inbuf, &map);
+  s = gst_structure_new ("videoframe-audiolevel", "running-time", G_TYPE_UINT64,
+      running_time, "duration", G_TYPE_UINT64, duration, NULL);
+  g_value_init (&va, G_TYPE_VALUE_ARRAY);
+  g_value_take_boxed (&va, rms_array);
+  gst_structure_take_value (s, "rms", &va);
+  g_value_init (&va, G_TYPE_VALUE_ARRAY);
+  g_value_take_boxed (&va, peak_array);
+  gst_structure_take_value (s, "peak", &va);
 
-  return msg;
+  return gst_message_new_element (GST_OBJECT (self), s);
 }
 
 static GstFlowReturn
@@ -544,7 +529,6 @@ gst_videoframe_audiolevel_asink_chain (GstPad * pad, GstObject * parent,
 {
   GstClockTime timestamp, cur_time;
   GstVideoFrameAudioLevel *self = GST_VIDEOFRAME_AUDIOLEVEL (parent);
-  GstBuffer *buf;
   gsize inbuf_size;
   guint64 start_offset, end_offset;
   GstClockTime running_time;
@@ -642,15 +626,12 @@ gst_videoframe_audiolevel_asink_chain (GstPad * pad, GstObject * parent,
       } else if (self->vsegment.position == GST_CLOCK_TIME_NONE) {
         /* g_queue_get_length is surely >= 2 at this point
          * so the adapter isn't empty */
-        buf =
-            gst_adapter_take_buffer (self->adapter,
-            gst_adapter_available (self->adapter));
-        if (buf != NULL) {
-          GstMessage *msg;
-          msg = update_rms_from_buffer (self, buf);
+        available_bytes = gst_adapter_available (self->adapter);
+        if (available_bytes > 0) {
+          msg = update_rms_from_adapter (self, available_bytes);
           g_mutex_unlock (&self->mutex);
-          gst_element_post_message (GST_ELEMENT (self), msg);
-          gst_buffer_unref (buf);
+          if (msg)
+            gst_element_post_message (GST_ELEMENT (self), msg);
           g_mutex_lock (&self->mutex);  /* we unlock again later */
         }
         break;
@@ -721,19 +702,13 @@ gst_videoframe_audiolevel_asink_chain (GstPad * pad, GstObject * parent,
       goto done;
     }
 
-    if (bytes > 0) {
-      buf = gst_adapter_take_buffer (self->adapter, bytes);
-      g_assert (buf != NULL);
-    } else {
-      /* Just an empty buffer */
-      buf = gst_buffer_new ();
-    }
-    msg = update_rms_from_buffer (self, buf);
+    /* with no bytes, this is the message for an empty buffer */
+    msg = update_rms_from_adapter (self, bytes);
     g_mutex_unlock (&self->mutex);
-    gst_element_post_message (GST_ELEMENT (self), msg);
+    if (msg)
+      gst_element_post_message (GST_ELEMENT (self), msg);
     g_mutex_lock (&self->mutex);
 
-    gst_buffer_unref (buf);
     g_free (vt0);
     if (available_bytes == bytes)
       break;
@@ -42,11 +42,13 @@ struct _GstVideoFrameAudioLevel
 
   GstAudioInfo ainfo;
 
-  gdouble *CS;                  /* normalized Cumulative Square */
+  gdouble *CS;                  /* Cumulative Square, in sample units */
+  gdouble *peak;                /* absolute peak, in sample units */
+  gdouble normalizer;           /* divisor to get a [-1.0, 1.0] range */
 
   GstSegment asegment, vsegment;
 
-  void (*process) (gpointer, guint, guint, gdouble *);
+  void (*process) (gconstpointer, guint, guint, gdouble *, gdouble *);
 
   GQueue vtimeq;
   GstAdapter *adapter;
@@ -446,6 +446,53 @@ gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
   return buf;
 }
 
+static const guint8 nal_start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+/* Returns a buffer with only the prefix of a NAL of @size for @format */
+static GstBuffer *
+gst_h264_parse_new_nal_prefix (GstH264Parse * h264parse, guint format,
+    guint size)
+{
+  GstBuffer *buf;
+  guint nl = h264parse->nal_length_size;
+  guint32 tmp;
+
+  if (format == GST_H264_PARSE_FORMAT_AVC
+      || format == GST_H264_PARSE_FORMAT_AVC3) {
+    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    buf = gst_buffer_new_allocate (NULL, nl, NULL);
+    gst_buffer_fill (buf, 0, &tmp, nl);
+  } else {
+    buf = gst_buffer_new ();
+    gst_buffer_append_memory (buf,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) nal_start_code, sizeof (nal_start_code), 0,
+            sizeof (nal_start_code), NULL, NULL));
+  }
+
+  return buf;
+}
+
+/* Like gst_h264_parse_wrap_nal(), but the returned buffer references the
+ * memory of the NAL in @src instead of copying it */
+static GstBuffer *
+gst_h264_parse_wrap_nal_region (GstH264Parse * h264parse, guint format,
+    GstBuffer * src, guint offset, guint size)
+{
+  guint nl = h264parse->nal_length_size;
+
+  /* packetized input already has the right length prefix in front */
+  if (h264parse->packetized && offset >= nl &&
+      (format == GST_H264_PARSE_FORMAT_AVC
+          || format == GST_H264_PARSE_FORMAT_AVC3))
+    return gst_buffer_copy_region (src, GST_BUFFER_COPY_MEMORY,
+        offset - nl, size + nl);
+
+  return gst_buffer_append (gst_h264_parse_new_nal_prefix (h264parse, format,
+          size), gst_buffer_copy_region (src, GST_BUFFER_COPY_MEMORY, offset,
+          size));
+}
+
 static void
 gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     GstH264NalUnitType naltype, GstH264NalUnit * nalu)
@@ -482,6 +529,34 @@ gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
   store[id] = buf;
 }
 
+/* Returns the id under which a byte-identical copy of @nalu was stored
+ * by gst_h264_parser_store_nal(), or -1 */
+static gint
+gst_h264_parser_find_stored_nal (GstH264Parse * h264parse,
+    GstH264NalUnitType naltype, GstH264NalUnit * nalu)
+{
+  GstBuffer **store;
+  guint i, store_size;
+
+  if (naltype == GST_H264_NAL_SPS || naltype == GST_H264_NAL_SUBSET_SPS) {
+    store_size = GST_H264_MAX_SPS_COUNT;
+    store = h264parse->sps_nals;
+  } else if (naltype == GST_H264_NAL_PPS) {
+    store_size = GST_H264_MAX_PPS_COUNT;
+    store = h264parse->pps_nals;
+  } else
+    return -1;
+
+  for (i = 0; i < store_size; i++) {
+    if (store[i] && gst_buffer_get_size (store[i]) == nalu->size &&
+        gst_buffer_memcmp (store[i], 0, nalu->data + nalu->offset,
+            nalu->size) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
 #ifndef GST_DISABLE_GST_DEBUG
 static const gchar *nal_names[] = {
   "Unknown",
@@ -707,6 +782,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   GstH264SPS sps = { 0, };
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264ParserResult pres;
+  gint id;
 
   /* nothing to do for broken input */
   if (G_UNLIKELY (nalu->size < 2)) {
@@ -724,12 +800,24 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     case GST_H264_NAL_SUBSET_SPS:
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
+
+      id = gst_h264_parser_find_stored_nal (h264parse, nal_type, nalu);
+      if (id >= 0 && nalparser->sps[id].valid)
+        goto repeated_sps;
+
       pres = gst_h264_parser_parse_subset_sps (nalparser, nalu, &sps, TRUE);
       goto process_sps;
 
     case GST_H264_NAL_SPS:
       /* reset state, everything else is obsolete */
       h264parse->state = 0;
+
+      /* streams commonly repeat the same SPS before every keyframe, there
+       * is nothing new to parse or to update the caps for then */
+      id = gst_h264_parser_find_stored_nal (h264parse, nal_type, nalu);
+      if (id >= 0 && nalparser->sps[id].valid)
+        goto repeated_sps;
+
       pres = gst_h264_parser_parse_sps (nalparser, nalu, &sps, TRUE);
 
     process_sps:
@@ -741,6 +829,16 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
 
       GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
       h264parse->update_caps = TRUE;
+      h264parse->sps_generation++;
+      gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
+      gst_h264_sps_clear (&sps);
+      goto got_sps;
+
+    repeated_sps:
+      GST_LOG_OBJECT (h264parse, "sps %d unchanged", id);
+      nalparser->last_sps = &nalparser->sps[id];
+
+    got_sps:
       h264parse->have_sps = TRUE;
       if (h264parse->push_codec && h264parse->have_pps) {
         /* SPS and PPS found in stream before the first pre_push_frame, no need
@@ -751,8 +849,6 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
-      gst_h264_sps_clear (&sps);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_SPS;
       h264parse->header |= TRUE;
       break;
@@ -762,6 +858,14 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
 
+      id = gst_h264_parser_find_stored_nal (h264parse, nal_type, nalu);
+      if (id >= 0 && nalparser->pps[id].valid &&
+          h264parse->pps_generation[id] == h264parse->sps_generation) {
+        GST_LOG_OBJECT (h264parse, "pps %d unchanged", id);
+        nalparser->last_pps = &nalparser->pps[id];
+        goto got_pps;
+      }
+
       pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
       /* arranged for a fallback pps.id, so use that one and only warn */
       if (pres != GST_H264_PARSER_OK) {
@@ -770,6 +874,15 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
           return FALSE;
       }
 
+      gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
+      /* a PPS with a broken link was not stored by the parser, so it has
+       * to be parsed again when repeated */
+      if (pps.id < GST_H264_MAX_PPS_COUNT)
+        h264parse->pps_generation[pps.id] = pres == GST_H264_PARSER_OK ?
+            h264parse->sps_generation : h264parse->sps_generation - 1;
+      gst_h264_pps_clear (&pps);
+
+    got_pps:
       /* parameters might have changed, force caps check */
       if (!h264parse->have_pps) {
         GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
@@ -785,8 +898,6 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
-      gst_h264_pps_clear (&pps);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_PPS;
       h264parse->header |= TRUE;
       break;
@@ -893,8 +1004,12 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h264parse, "collecting NAL in AVC frame");
-    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    if (h264parse->nal_buffer)
+      buf = gst_h264_parse_wrap_nal_region (h264parse, h264parse->format,
+          h264parse->nal_buffer, nalu->offset, nalu->size);
+    else
+      buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
+          nalu->data + nalu->offset, nalu->size);
     gst_adapter_push (h264parse->frame_out, buf);
   }
   return TRUE;
@@ -988,6 +1103,8 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
   parse_res = gst_h264_parser_identify_nalu_avc (h264parse->nalparser,
       map.data, 0, map.size, nl, &nalu);
 
+  h264parse->nal_buffer = buffer;
+
   while (parse_res == GST_H264_PARSER_OK) {
     GST_DEBUG_OBJECT (h264parse, "AVC nal offset %d", nalu.offset + nalu.size);
 
@@ -1018,6 +1135,7 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
         map.data, nalu.offset + nalu.size, map.size, nl, &nalu);
   }
 
+  h264parse->nal_buffer = NULL;
   gst_buffer_unmap (buffer, &map);
 
   if (!h264parse->split_packetized) {
@@ -2145,7 +2263,7 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h264parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h264parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2295,60 +2413,43 @@ gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
       }
     }
   } else {
-    /* insert config NALs into AU */
-    GstByteWriter bw;
+    /* insert config NALs into AU, referencing the memory of the AU and
+     * the stored NALs so only their prefixes need to be allocated */
     GstBuffer *new_buf;
-    const gboolean bs = h264parse->format == GST_H264_PARSE_FORMAT_BYTE;
-    const gint nls = 4 - h264parse->nal_length_size;
-    gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h264parse->idr_pos);
+    new_buf = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, 0,
+        h264parse->idr_pos);
     GST_DEBUG_OBJECT (h264parse, "- inserting SPS/PPS");
     for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
       if ((codec_nal = h264parse->sps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
         GST_DEBUG_OBJECT (h264parse, "inserting SPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+        new_buf = gst_buffer_append (new_buf,
+            gst_h264_parse_new_nal_prefix (h264parse, h264parse->format,
+                gst_buffer_get_size (codec_nal)));
+        new_buf = gst_buffer_append (new_buf, gst_buffer_ref (codec_nal));
         send_done = TRUE;
       }
     }
     for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
       if ((codec_nal = h264parse->pps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
         GST_DEBUG_OBJECT (h264parse, "inserting PPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+        new_buf = gst_buffer_append (new_buf,
+            gst_h264_parse_new_nal_prefix (h264parse, h264parse->format,
+                gst_buffer_get_size (codec_nal)));
+        new_buf = gst_buffer_append (new_buf, gst_buffer_ref (codec_nal));
         send_done = TRUE;
       }
     }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h264parse->idr_pos, -1);
+    new_buf = gst_buffer_append (new_buf,
+        gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY,
+            h264parse->idr_pos, -1));
     /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
     gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     /* should already be keyframe/IDR, but it may not have been,
      * so mark it as such to avoid being discarded by picky decoder */
     GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
     gst_buffer_replace (&frame->out_buffer, new_buf);
     gst_buffer_unref (new_buf);
-    /* some result checking seems to make some compilers happy */
-    if (G_UNLIKELY (!ok)) {
-      GST_ERROR_OBJECT (h264parse, "failed to insert SPS/PPS");
-    }
   }
 
   return send_done;
@@ -67,6 +67,9 @@ struct _GstH264Parse
   gboolean packetized;
   gboolean split_packetized;
   gboolean transform;
+  /* packetized input buffer the NALs being processed are from, so that
+   * they can be referenced instead of copied when transforming */
+  GstBuffer *nal_buffer;
 
   /* state */
   GstH264NalParser *nalparser;
@@ -90,6 +93,11 @@ struct _GstH264Parse
   /* collected SPS and PPS NALUs */
   GstBuffer *sps_nals[GST_H264_MAX_SPS_COUNT];
   GstBuffer *pps_nals[GST_H264_MAX_PPS_COUNT];
+  /* number of SPS that were parsed and found to differ from the stored
+   * ones, and its value when each PPS was last parsed. A repeated PPS can
+   * only skip parsing if no SPS it might depend on changed in-between */
+  guint sps_generation;
+  guint pps_generation[GST_H264_MAX_PPS_COUNT];
 
   /* Infos we need to keep track of */
   guint32 sei_cpb_removal_delay;
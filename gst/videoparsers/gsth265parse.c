@@ -391,6 +391,53 @@ gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
   return buf;
 }
 
+static const guint8 nal_start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+/* Returns a buffer with only the prefix of a NAL of @size for @format */
+static GstBuffer *
+gst_h265_parse_new_nal_prefix (GstH265Parse * h265parse, guint format,
+    guint size)
+{
+  GstBuffer *buf;
+  guint nl = h265parse->nal_length_size;
+  guint32 tmp;
+
+  if (format == GST_H265_PARSE_FORMAT_HVC1
+      || format == GST_H265_PARSE_FORMAT_HEV1) {
+    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    buf = gst_buffer_new_allocate (NULL, nl, NULL);
+    gst_buffer_fill (buf, 0, &tmp, nl);
+  } else {
+    buf = gst_buffer_new ();
+    gst_buffer_append_memory (buf,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) nal_start_code, sizeof (nal_start_code), 0,
+            sizeof (nal_start_code), NULL, NULL));
+  }
+
+  return buf;
+}
+
+/* Like gst_h265_parse_wrap_nal(), but the returned buffer references the
+ * memory of the NAL in @src instead of copying it */
+static GstBuffer *
+gst_h265_parse_wrap_nal_region (GstH265Parse * h265parse, guint format,
+    GstBuffer * src, guint offset, guint size)
+{
+  guint nl = h265parse->nal_length_size;
+
+  /* packetized input already has the right length prefix in front */
+  if (h265parse->packetized && offset >= nl &&
+      (format == GST_H265_PARSE_FORMAT_HVC1
+          || format == GST_H265_PARSE_FORMAT_HEV1))
+    return gst_buffer_copy_region (src, GST_BUFFER_COPY_MEMORY,
+        offset - nl, size + nl);
+
+  return gst_buffer_append (gst_h265_parse_new_nal_prefix (h265parse, format,
+          size), gst_buffer_copy_region (src, GST_BUFFER_COPY_MEMORY, offset,
+          size));
+}
+
 static void
 gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     GstH265NalUnitType naltype, GstH265NalUnit * nalu)
@@ -666,8 +713,12 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h265parse, "collecting NAL in HEVC frame");
-    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    if (h265parse->nal_buffer)
+      buf = gst_h265_parse_wrap_nal_region (h265parse, h265parse->format,
+          h265parse->nal_buffer, nalu->offset, nalu->size);
+    else
+      buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
+          nalu->data + nalu->offset, nalu->size);
     gst_adapter_push (h265parse->frame_out, buf);
   }
 }
@@ -754,6 +805,8 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
   parse_res = gst_h265_parser_identify_nalu_hevc (h265parse->nalparser,
       map.data, 0, map.size, nl, &nalu);
 
+  h265parse->nal_buffer = buffer;
+
   while (parse_res == GST_H265_PARSER_OK) {
     GST_DEBUG_OBJECT (h265parse, "HEVC nal offset %d", nalu.offset + nalu.size);
 
@@ -784,6 +837,7 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
         map.data, nalu.offset + nalu.size, map.size, nl, &nalu);
   }
 
+  h265parse->nal_buffer = NULL;
   gst_buffer_unmap (buffer, &map);
 
   if (!h265parse->split_packetized) {
@@ -1654,7 +1708,7 @@ gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h265parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h265parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -1892,71 +1946,48 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
             }
           }
         } else {
-          /* insert config NALs into AU */
-          GstByteWriter bw;
+          /* insert config NALs into AU, referencing the memory of the AU
+           * and the stored NALs so only their prefixes need to be
+           * allocated */
           GstBuffer *new_buf;
-          const gboolean bs = h265parse->format == GST_H265_PARSE_FORMAT_BYTE;
-          const gint nls = 4 - h265parse->nal_length_size;
-          gboolean ok;
 
-          gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer),
-              FALSE);
-          ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h265parse->idr_pos);
+          new_buf = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, 0,
+              h265parse->idr_pos);
           GST_DEBUG_OBJECT (h265parse, "- inserting VPS/SPS/PPS");
           for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
             if ((codec_nal = h265parse->vps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
               GST_DEBUG_OBJECT (h265parse, "inserting VPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+              new_buf = gst_buffer_append (new_buf,
+                  gst_h265_parse_new_nal_prefix (h265parse, h265parse->format,
+                      gst_buffer_get_size (codec_nal)));
+              new_buf = gst_buffer_append (new_buf, gst_buffer_ref (codec_nal));
               h265parse->last_report = new_ts;
             }
           }
           for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
             if ((codec_nal = h265parse->sps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
               GST_DEBUG_OBJECT (h265parse, "inserting SPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+              new_buf = gst_buffer_append (new_buf,
+                  gst_h265_parse_new_nal_prefix (h265parse, h265parse->format,
+                      gst_buffer_get_size (codec_nal)));
+              new_buf = gst_buffer_append (new_buf, gst_buffer_ref (codec_nal));
               h265parse->last_report = new_ts;
             }
           }
           for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
             if ((codec_nal = h265parse->pps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
               GST_DEBUG_OBJECT (h265parse, "inserting PPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+              new_buf = gst_buffer_append (new_buf,
+                  gst_h265_parse_new_nal_prefix (h265parse, h265parse->format,
+                      gst_buffer_get_size (codec_nal)));
+              new_buf = gst_buffer_append (new_buf, gst_buffer_ref (codec_nal));
               h265parse->last_report = new_ts;
             }
           }
-          ok &=
-              gst_byte_writer_put_buffer (&bw, buffer, h265parse->idr_pos, -1);
+          new_buf = gst_buffer_append (new_buf,
+              gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY,
+                  h265parse->idr_pos, -1));
           /* collect result and push */
-          new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
           gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0,
               -1);
           /* should already be keyframe/IDR, but it may not have been,
@@ -1964,10 +1995,6 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
           GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
           gst_buffer_replace (&frame->out_buffer, new_buf);
           gst_buffer_unref (new_buf);
-          /* some result checking seems to make some compilers happy */
-          if (G_UNLIKELY (!ok)) {
-            GST_ERROR_OBJECT (h265parse, "failed to insert SPS/PPS");
-          }
         }
       }
       /* we pushed whatever we had */
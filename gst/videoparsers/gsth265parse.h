@@ -60,6 +60,9 @@ struct _GstH265Parse
   gboolean packetized;
   gboolean split_packetized;
   gboolean transform;
+  /* packetized input buffer the NALs being processed are from, so that
+   * they can be referenced instead of copied when transforming */
+  GstBuffer *nal_buffer;
 
   /* state */
   GstH265Parser *nalparser;
@@ -0,0 +1,339 @@
+/* GStreamer VP9 Parser
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vp9parse
+ * @title: vp9parse
+ *
+ * Parses VP9 streams and splits superframes, which pack frames that are
+ * only decoded together with the frame that is shown, into one buffer per
+ * frame. The frames share the memory of the superframe, nothing is copied.
+ * Key frames are pushed without %GST_BUFFER_FLAG_DELTA_UNIT and frames that
+ * are never shown carry %GST_BUFFER_FLAG_DECODE_ONLY. The caps give the size,
+ * profile, bit depth and chroma format of the stream.
+ *
+ * The input is expected to contain whole superframes or frames per buffer,
+ * as demuxers produce it.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.webm ! matroskademux ! vp9parse ! fakesink
+ * ]|
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstvp9parse.h"
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY (vp9_parse_debug);
+#define GST_CAT_DEFAULT vp9_parse_debug
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9, width = (int)[1, MAX], "
+        "height = (int)[1, MAX], parsed = (boolean) true, "
+        "alignment = (string) frame")
+    );
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9")
+    );
+
+#define parent_class gst_vp9_parse_parent_class
+G_DEFINE_TYPE (GstVp9Parse, gst_vp9_parse, GST_TYPE_BASE_PARSE);
+
+static gboolean gst_vp9_parse_start (GstBaseParse * parse);
+static gboolean gst_vp9_parse_stop (GstBaseParse * parse);
+static GstFlowReturn gst_vp9_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+
+static void
+gst_vp9_parse_class_init (GstVp9ParseClass * klass)
+{
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (vp9_parse_debug, "vp9parse", 0, "vp9 parser");
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+  gst_element_class_set_static_metadata (gstelement_class, "VP9 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses VP9 streams and splits superframes into frames",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  /* Override BaseParse vfuncs */
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_vp9_parse_start);
+  parse_class->stop = GST_DEBUG_FUNCPTR (gst_vp9_parse_stop);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_vp9_parse_handle_frame);
+}
+
+static void
+gst_vp9_parse_init (GstVp9Parse * vp9parse)
+{
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (vp9parse));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (vp9parse));
+}
+
+static gboolean
+gst_vp9_parse_start (GstBaseParse * parse)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (vp9parse, "start");
+
+  vp9parse->parser = gst_vp9_parser_new ();
+
+  vp9parse->width = 0;
+  vp9parse->height = 0;
+  vp9parse->profile = GST_VP9_PROFILE_UNDEFINED;
+  vp9parse->bit_depth = 0;
+  vp9parse->subsampling_x = -1;
+  vp9parse->subsampling_y = -1;
+  vp9parse->update_caps = TRUE;
+
+  /* the frames of a superframe share its timestamps, don't let them be
+   * interpolated */
+  gst_base_parse_set_pts_interpolation (parse, FALSE);
+  gst_base_parse_set_infer_ts (parse, FALSE);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp9_parse_stop (GstBaseParse * parse)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (vp9parse, "stop");
+
+  g_clear_pointer (&vp9parse->parser, gst_vp9_parser_free);
+
+  return TRUE;
+}
+
+static const gchar *
+gst_vp9_parse_chroma_format (GstVp9Parse * vp9parse)
+{
+  if (vp9parse->subsampling_x == 1 && vp9parse->subsampling_y == 1)
+    return "4:2:0";
+  else if (vp9parse->subsampling_x == 1 && vp9parse->subsampling_y == 0)
+    return "4:2:2";
+  else if (vp9parse->subsampling_x == 0 && vp9parse->subsampling_y == 1)
+    return "4:4:0";
+  else if (vp9parse->subsampling_x == 0 && vp9parse->subsampling_y == 0)
+    return "4:4:4";
+
+  return NULL;
+}
+
+static gboolean
+gst_vp9_parse_set_caps (GstVp9Parse * vp9parse)
+{
+  GstCaps *caps, *sink_caps;
+  const gchar *chroma_format;
+  gchar *profile;
+  gboolean ret;
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (vp9parse));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-vp9");
+  }
+
+  profile = g_strdup_printf ("%u", vp9parse->profile);
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE,
+      "alignment", G_TYPE_STRING, "frame",
+      "width", G_TYPE_INT, vp9parse->width,
+      "height", G_TYPE_INT, vp9parse->height,
+      "profile", G_TYPE_STRING, profile, NULL);
+  g_free (profile);
+
+  if (vp9parse->bit_depth) {
+    gst_caps_set_simple (caps, "bit-depth-luma", G_TYPE_UINT,
+        vp9parse->bit_depth, "bit-depth-chroma", G_TYPE_UINT,
+        vp9parse->bit_depth, NULL);
+  }
+
+  chroma_format = gst_vp9_parse_chroma_format (vp9parse);
+  if (chroma_format)
+    gst_caps_set_simple (caps, "chroma-format", G_TYPE_STRING, chroma_format,
+        NULL);
+
+  GST_DEBUG_OBJECT (vp9parse, "setting caps %" GST_PTR_FORMAT, caps);
+
+  ret = gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (vp9parse), caps);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+/* Parses the frame header of the frame in @buffer, flags @buffer
+ * accordingly and updates the caps on key frames */
+static GstFlowReturn
+gst_vp9_parse_parse_frame (GstVp9Parse * vp9parse, GstBuffer * buffer,
+    const guint8 * data, gsize size)
+{
+  GstVp9FrameHdr frame_hdr;
+  GstVp9Parser *parser = vp9parse->parser;
+
+  if (gst_vp9_parser_parse_frame_header (parser, &frame_hdr, data,
+          size) != GST_VP9_PARSER_OK) {
+    GST_ELEMENT_ERROR (vp9parse, STREAM, DECODE, (NULL),
+        ("Failed to parse VP9 frame header"));
+    return GST_FLOW_ERROR;
+  }
+
+  if (frame_hdr.show_existing_frame) {
+    /* a reference to an already decoded frame, always shown */
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    return GST_FLOW_OK;
+  }
+
+  if (frame_hdr.frame_type == GST_VP9_KEY_FRAME) {
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    if (vp9parse->width != frame_hdr.width ||
+        vp9parse->height != frame_hdr.height ||
+        vp9parse->profile != frame_hdr.profile ||
+        vp9parse->bit_depth != parser->bit_depth ||
+        vp9parse->subsampling_x != parser->subsampling_x ||
+        vp9parse->subsampling_y != parser->subsampling_y) {
+      vp9parse->width = frame_hdr.width;
+      vp9parse->height = frame_hdr.height;
+      vp9parse->profile = frame_hdr.profile;
+      vp9parse->bit_depth = parser->bit_depth;
+      vp9parse->subsampling_x = parser->subsampling_x;
+      vp9parse->subsampling_y = parser->subsampling_y;
+      vp9parse->update_caps = TRUE;
+    }
+  } else {
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+
+  if (!frame_hdr.show_frame)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+
+  if (G_UNLIKELY (vp9parse->update_caps)) {
+    if (vp9parse->width == 0 || vp9parse->height == 0) {
+      GST_DEBUG_OBJECT (vp9parse, "no key frame yet, can't set caps");
+    } else {
+      if (!gst_vp9_parse_set_caps (vp9parse))
+        return GST_FLOW_NOT_NEGOTIATED;
+      vp9parse->update_caps = FALSE;
+    }
+  }
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_vp9_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+  GstVp9SuperframeInfo info;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gsize offset = 0;
+  guint i;
+
+  if (!gst_buffer_map (frame->buffer, &map, GST_MAP_READ))
+    return GST_FLOW_ERROR;
+
+  if (gst_vp9_parser_parse_superframe_info (vp9parse->parser, &info,
+          map.data, map.size) != GST_VP9_PARSER_OK) {
+    GST_WARNING_OBJECT (vp9parse, "invalid superframe, dropping");
+    gst_buffer_unmap (frame->buffer, &map);
+    frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+    return gst_base_parse_finish_frame (parse, frame, map.size);
+  }
+
+  if (info.frames_in_superframe == 1) {
+    ret = gst_vp9_parse_parse_frame (vp9parse, frame->buffer, map.data,
+        map.size);
+    gst_buffer_unmap (frame->buffer, &map);
+    if (ret != GST_FLOW_OK)
+      return ret;
+
+    if (vp9parse->update_caps)
+      frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+
+    return gst_base_parse_finish_frame (parse, frame, map.size);
+  }
+
+  GST_LOG_OBJECT (vp9parse, "splitting superframe of %u frames",
+      info.frames_in_superframe);
+
+  /* need to save buffer from invalidation upon _finish_frame */
+  buffer = gst_buffer_copy (frame->buffer);
+  gst_buffer_unmap (frame->buffer, &map);
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_ERROR;
+  }
+
+  for (i = 0; i < info.frames_in_superframe && ret == GST_FLOW_OK; i++) {
+    GstBaseParseFrame tmp_frame;
+    gsize size = info.frame_sizes[i];
+    gsize consumed = size;
+
+    /* the index at the end of the superframe goes with the last frame */
+    if (i == info.frames_in_superframe - 1)
+      consumed = map.size - offset;
+
+    gst_base_parse_frame_init (&tmp_frame);
+    tmp_frame.flags |= frame->flags;
+    tmp_frame.offset = frame->offset;
+    tmp_frame.overhead = frame->overhead;
+    tmp_frame.buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+        offset, size);
+
+    ret = gst_vp9_parse_parse_frame (vp9parse, tmp_frame.buffer,
+        map.data + offset, size);
+    if (ret == GST_FLOW_OK) {
+      /* pushed instead of the consumed data, which may include the index;
+       * it is a sub-buffer sharing the memory of the superframe */
+      tmp_frame.out_buffer = gst_buffer_ref (tmp_frame.buffer);
+      if (vp9parse->update_caps)
+        tmp_frame.flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+      ret = gst_base_parse_finish_frame (parse, &tmp_frame, consumed);
+    } else {
+      gst_base_parse_frame_free (&tmp_frame);
+    }
+
+    offset += consumed;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  return ret;
+}
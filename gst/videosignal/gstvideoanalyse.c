@@ -52,6 +52,7 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video/gstvideolumameta.h>
 #include "gstvideoanalyse.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_video_analyse_debug_category);
@@ -72,10 +73,12 @@ static GstFlowReturn gst_video_analyse_transform_frame_ip (GstVideoFilter *
 enum
 {
   PROP_0,
-  PROP_MESSAGE
+  PROP_MESSAGE,
+  PROP_ANALYSIS_WIDTH
 };
 
 #define DEFAULT_MESSAGE TRUE
+#define DEFAULT_ANALYSIS_WIDTH 0
 
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, YV12, Y444, Y42B, Y41B }")
@@ -116,12 +119,30 @@ gst_video_analyse_class_init (GstVideoAnalyseClass * klass)
           "Post statics messages",
           DEFAULT_MESSAGE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVideoAnalyse:analysis-width:
+   *
+   * Maximum width of the luma the statistics are computed on. Frames are
+   * decimated by powers of two until they fit, and the decimated luma is
+   * shared with other analysis elements through a #GstVideoLumaMeta.
+   * 0 uses every pixel of the frames.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_ANALYSIS_WIDTH, g_param_spec_uint ("analysis-width",
+          "Analysis width",
+          "Maximum width of the luma the statistics are computed on "
+          "(0 = full resolution)", 0, G_MAXINT, DEFAULT_ANALYSIS_WIDTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   //trans_class->passthrough_on_same_caps = TRUE;
 }
 
 static void
 gst_video_analyse_init (GstVideoAnalyse * videoanalyse)
 {
+  videoanalyse->analysis_width = DEFAULT_ANALYSIS_WIDTH;
 }
 
 void
@@ -136,6 +157,9 @@ gst_video_analyse_set_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       videoanalyse->message = g_value_get_boolean (value);
       break;
+    case PROP_ANALYSIS_WIDTH:
+      videoanalyse->analysis_width = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -154,6 +178,9 @@ gst_video_analyse_get_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       g_value_set_boolean (value, videoanalyse->message);
       break;
+    case PROP_ANALYSIS_WIDTH:
+      g_value_set_uint (value, videoanalyse->analysis_width);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -203,38 +230,46 @@ gst_video_analyse_post_message (GstVideoAnalyse * videoanalyse,
 }
 
 static void
-gst_video_analyse_planar (GstVideoAnalyse * videoanalyse, GstVideoFrame * frame)
+gst_video_analyse_planar (GstVideoAnalyse * videoanalyse, const guint8 * data,
+    gint stride, gint width, gint height)
 {
   guint64 sum;
   gint avg, diff;
   gint i, j;
-  guint8 *d;
-  gint width = frame->info.width;
-  gint height = frame->info.height;
-  gint stride;
+  const guint8 *d;
+
+  if (width == 0 || height == 0) {
+    videoanalyse->luma_average = videoanalyse->luma_variance = 0.0;
+    return;
+  }
 
-  d = frame->data[0];
-  stride = frame->info.stride[0];
+  /* the sums of a row fit in 32 bits, which vectorizes better */
+  d = data;
   sum = 0;
   /* do brightness as average of pixel brightness in 0.0 to 1.0 */
   for (i = 0; i < height; i++) {
+    guint row_sum = 0;
+
     for (j = 0; j < width; j++) {
-      sum += d[j];
+      row_sum += d[j];
     }
+    sum += row_sum;
     d += stride;
   }
   avg = sum / (width * height);
   videoanalyse->luma_average = sum / (255.0 * width * height);
 
-  d = frame->data[0];
-  stride = frame->info.stride[0];
+  d = data;
   sum = 0;
   /* do variance */
   for (i = 0; i < height; i++) {
+    guint row_sum = 0;
+
     for (j = 0; j < width; j++) {
       diff = (avg - d[j]);
-      sum += diff * diff;
+      row_sum += diff * diff;
     }
+    sum += row_sum;
     d += stride;
   }
   videoanalyse->luma_variance = sum / (255.0 * 255.0 * width * height);
@@ -245,10 +280,25 @@ gst_video_analyse_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
 {
   GstVideoAnalyse *videoanalyse = GST_VIDEO_ANALYSE (filter);
+  GstVideoLumaMeta *luma = NULL;
 
   GST_DEBUG_OBJECT (videoanalyse, "transform_frame_ip");
 
-  gst_video_analyse_planar (videoanalyse, frame);
+  if (videoanalyse->analysis_width > 0) {
+    guint shift = gst_video_luma_meta_shift_for_width (frame->info.width,
+        videoanalyse->analysis_width);
+
+    luma = gst_buffer_get_video_luma_meta (frame->buffer, shift);
+    if (!luma && gst_buffer_is_writable (frame->buffer))
+      luma = gst_buffer_add_video_luma_meta (frame->buffer, frame, shift);
+  }
+
+  if (luma)
+    gst_video_analyse_planar (videoanalyse, luma->data, luma->stride,
+        luma->width, luma->height);
+  else
+    gst_video_analyse_planar (videoanalyse, frame->data[0],
+        frame->info.stride[0], frame->info.width, frame->info.height);
 
   if (videoanalyse->message)
     gst_video_analyse_post_message (videoanalyse, frame);
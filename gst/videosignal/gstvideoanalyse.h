@@ -41,6 +41,7 @@ struct _GstVideoAnalyse
   /* properties */
   gboolean message;
   guint64 interval;
+  guint analysis_width;
   gdouble luma_average;
   gdouble luma_variance;
 };
@@ -22,6 +22,10 @@
  *
  * The gsty4mdec element decodes uncompressed video in YUV4MPEG format.
  *
+ * When upstream supports random access, the frames are pulled one at a time
+ * and pushed as sub-buffers of the data read from upstream, and seeking
+ * goes straight to the offset of the target frame.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v filesrc location=file.y4m ! y4mdec ! xvimagesink
@@ -41,6 +45,7 @@
 #include <string.h>
 
 #define MAX_SIZE 32768
+#define MAX_HEADER_LENGTH 80
 
 GST_DEBUG_CATEGORY (y4mdec_debug);
 #define GST_CAT_DEFAULT y4mdec_debug
@@ -55,8 +60,12 @@ static void gst_y4m_dec_get_property (GObject * object,
 static void gst_y4m_dec_dispose (GObject * object);
 static void gst_y4m_dec_finalize (GObject * object);
 
+static gboolean gst_y4m_dec_sink_activate (GstPad * pad, GstObject * parent);
+static gboolean gst_y4m_dec_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
 static GstFlowReturn gst_y4m_dec_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static void gst_y4m_dec_loop (GstPad * pad);
 static gboolean gst_y4m_dec_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 
@@ -127,6 +136,10 @@ gst_y4m_dec_init (GstY4mDec * y4mdec)
       GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_event));
   gst_pad_set_chain_function (y4mdec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_y4m_dec_chain));
+  gst_pad_set_activate_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate));
+  gst_pad_set_activatemode_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate_mode));
   gst_element_add_pad (GST_ELEMENT (y4mdec), y4mdec->sinkpad);
 
   y4mdec->srcpad = gst_pad_new_from_static_template (&gst_y4m_dec_src_template,
@@ -193,6 +206,68 @@ gst_y4m_dec_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static gboolean
+gst_y4m_dec_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull_mode;
+
+  query = gst_query_new_scheduling ();
+
+  if (!gst_pad_peer_query (sinkpad, query)) {
+    gst_query_unref (query);
+    goto activate_push;
+  }
+
+  pull_mode = gst_query_has_scheduling_mode_with_flags (query,
+      GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+  gst_query_unref (query);
+
+  if (!pull_mode)
+    goto activate_push;
+
+  GST_DEBUG_OBJECT (sinkpad, "activating pull");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+
+activate_push:
+  GST_DEBUG_OBJECT (sinkpad, "activating push");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+}
+
+static gboolean
+gst_y4m_dec_sink_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (parent);
+  gboolean res;
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      y4mdec->pull_mode = FALSE;
+      res = TRUE;
+      break;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        y4mdec->pull_mode = TRUE;
+        y4mdec->have_header = FALSE;
+        y4mdec->frame_index = 0;
+        y4mdec->offset = 0;
+        y4mdec->stop_frame = -1;
+        y4mdec->have_new_segment = TRUE;
+        res = gst_pad_start_task (pad, (GstTaskFunction) gst_y4m_dec_loop,
+            pad, NULL);
+      } else {
+        res = gst_pad_stop_task (pad);
+      }
+      break;
+    default:
+      res = FALSE;
+      break;
+  }
+
+  return res;
+}
+
 static GstStateChangeReturn
 gst_y4m_dec_change_state (GstElement * element, GstStateChange transition)
 {
@@ -481,13 +556,186 @@ error:
   return FALSE;
 }
 
+/* parses the stream header in the first MAX_HEADER_LENGTH bytes of @header,
+ * sets the caps and configures the pool used for stride conversion */
+static GstFlowReturn
+gst_y4m_dec_handle_header (GstY4mDec * y4mdec, char *header)
+{
+  gboolean ret;
+  GstCaps *caps;
+  GstQuery *query;
+  int i;
+
+  header[MAX_HEADER_LENGTH - 1] = 0;
+  for (i = 0; i < MAX_HEADER_LENGTH; i++) {
+    if (header[i] == 0x0a)
+      header[i] = 0;
+  }
+
+  ret = gst_y4m_dec_parse_header (y4mdec, header);
+  if (!ret) {
+    GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+        ("Failed to parse YUV4MPEG header"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+
+  y4mdec->header_size = strlen (header) + 1;
+
+  caps = gst_video_info_to_caps (&y4mdec->info);
+  ret = gst_pad_set_caps (y4mdec->srcpad, caps);
+
+  query = gst_query_new_allocation (caps, FALSE);
+  y4mdec->video_meta = FALSE;
+
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, FALSE);
+    gst_object_unref (y4mdec->pool);
+  }
+  y4mdec->pool = NULL;
+
+  if (gst_pad_peer_query (y4mdec->srcpad, query)) {
+    y4mdec->video_meta =
+        gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+    /* We only need a pool if we need to do stride conversion for downstream */
+    if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
+            sizeof (y4mdec->info)) != 0) {
+      GstBufferPool *pool = NULL;
+      GstAllocator *allocator = NULL;
+      GstAllocationParams params;
+      GstStructure *config;
+      guint size, min, max;
+
+      if (gst_query_get_n_allocation_params (query) > 0) {
+        gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+      } else {
+        allocator = NULL;
+        gst_allocation_params_init (&params);
+      }
+
+      if (gst_query_get_n_allocation_pools (query) > 0) {
+        gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
+            &max);
+        size = MAX (size, y4mdec->out_info.size);
+      } else {
+        pool = NULL;
+        size = y4mdec->out_info.size;
+        min = max = 0;
+      }
+
+      if (pool == NULL) {
+        pool = gst_video_buffer_pool_new ();
+      }
+
+      config = gst_buffer_pool_get_config (pool);
+      gst_buffer_pool_config_set_params (config, caps, size, min, max);
+      gst_buffer_pool_config_set_allocator (config, allocator, &params);
+      gst_buffer_pool_set_config (pool, config);
+
+      if (allocator)
+        gst_object_unref (allocator);
+
+      y4mdec->pool = pool;
+    }
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBufferPool *pool;
+    GstStructure *config;
+
+    /* No pool, create our own if we need to do stride conversion */
+    pool = gst_video_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
+        0);
+    gst_buffer_pool_set_config (pool, config);
+    y4mdec->pool = pool;
+  }
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, TRUE);
+  }
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+  if (!ret) {
+    GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
+    return GST_FLOW_ERROR;
+  }
+
+  y4mdec->have_header = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+/* timestamps the frame data in @buffer and pushes it, converting the
+ * strides if downstream can't handle the y4m layout */
+static GstFlowReturn
+gst_y4m_dec_push_frame (GstY4mDec * y4mdec, GstBuffer * buffer)
+{
+  GstFlowReturn flow_ret;
+
+  GST_BUFFER_TIMESTAMP (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+  GST_BUFFER_DURATION (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
+      GST_BUFFER_TIMESTAMP (buffer);
+
+  y4mdec->frame_index++;
+
+  if (y4mdec->video_meta) {
+    gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
+        y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
+        y4mdec->info.offset, y4mdec->info.stride);
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBuffer *outbuf;
+    GstVideoFrame iframe, oframe;
+    gint i, j;
+    gint w, h, istride, ostride;
+    guint8 *src, *dest;
+
+    /* Allocate a new buffer and do stride conversion */
+    g_assert (y4mdec->pool != NULL);
+
+    flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
+    if (flow_ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return flow_ret;
+    }
+
+    gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
+    gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+
+    for (i = 0; i < 3; i++) {
+      w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
+      h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
+      istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
+      ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
+      src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
+      dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+
+      for (j = 0; j < h; j++) {
+        memcpy (dest, src, w);
+
+        dest += ostride;
+        src += istride;
+      }
+    }
+
+    gst_video_frame_unmap (&iframe);
+    gst_video_frame_unmap (&oframe);
+    gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    gst_buffer_unref (buffer);
+    buffer = outbuf;
+  }
+
+  return gst_pad_push (y4mdec->srcpad, buffer);
+}
+
 static GstFlowReturn
 gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstY4mDec *y4mdec;
   int n_avail;
   GstFlowReturn flow_ret = GST_FLOW_OK;
-#define MAX_HEADER_LENGTH 80
   char header[MAX_HEADER_LENGTH];
   int i;
   int len;
@@ -505,111 +753,16 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   n_avail = gst_adapter_available (y4mdec->adapter);
 
   if (!y4mdec->have_header) {
-    gboolean ret;
-    GstCaps *caps;
-    GstQuery *query;
-
     if (n_avail < MAX_HEADER_LENGTH)
       return GST_FLOW_OK;
 
     gst_adapter_copy (y4mdec->adapter, (guint8 *) header, 0, MAX_HEADER_LENGTH);
 
-    header[MAX_HEADER_LENGTH - 1] = 0;
-    for (i = 0; i < MAX_HEADER_LENGTH; i++) {
-      if (header[i] == 0x0a)
-        header[i] = 0;
-    }
-
-    ret = gst_y4m_dec_parse_header (y4mdec, header);
-    if (!ret) {
-      GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
-          ("Failed to parse YUV4MPEG header"), (NULL));
-      return GST_FLOW_ERROR;
-    }
+    flow_ret = gst_y4m_dec_handle_header (y4mdec, header);
+    if (flow_ret != GST_FLOW_OK)
+      return flow_ret;
 
-    y4mdec->header_size = strlen (header) + 1;
     gst_adapter_flush (y4mdec->adapter, y4mdec->header_size);
-
-    caps = gst_video_info_to_caps (&y4mdec->info);
-    ret = gst_pad_set_caps (y4mdec->srcpad, caps);
-
-    query = gst_query_new_allocation (caps, FALSE);
-    y4mdec->video_meta = FALSE;
-
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, FALSE);
-      gst_object_unref (y4mdec->pool);
-    }
-    y4mdec->pool = NULL;
-
-    if (gst_pad_peer_query (y4mdec->srcpad, query)) {
-      y4mdec->video_meta =
-          gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
-
-      /* We only need a pool if we need to do stride conversion for downstream */
-      if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
-              sizeof (y4mdec->info)) != 0) {
-        GstBufferPool *pool = NULL;
-        GstAllocator *allocator = NULL;
-        GstAllocationParams params;
-        GstStructure *config;
-        guint size, min, max;
-
-        if (gst_query_get_n_allocation_params (query) > 0) {
-          gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
-        } else {
-          allocator = NULL;
-          gst_allocation_params_init (&params);
-        }
-
-        if (gst_query_get_n_allocation_pools (query) > 0) {
-          gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
-              &max);
-          size = MAX (size, y4mdec->out_info.size);
-        } else {
-          pool = NULL;
-          size = y4mdec->out_info.size;
-          min = max = 0;
-        }
-
-        if (pool == NULL) {
-          pool = gst_video_buffer_pool_new ();
-        }
-
-        config = gst_buffer_pool_get_config (pool);
-        gst_buffer_pool_config_set_params (config, caps, size, min, max);
-        gst_buffer_pool_config_set_allocator (config, allocator, &params);
-        gst_buffer_pool_set_config (pool, config);
-
-        if (allocator)
-          gst_object_unref (allocator);
-
-        y4mdec->pool = pool;
-      }
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBufferPool *pool;
-      GstStructure *config;
-
-      /* No pool, create our own if we need to do stride conversion */
-      pool = gst_video_buffer_pool_new ();
-      config = gst_buffer_pool_get_config (pool);
-      gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
-          0);
-      gst_buffer_pool_set_config (pool, config);
-      y4mdec->pool = pool;
-    }
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, TRUE);
-    }
-    gst_query_unref (query);
-    gst_caps_unref (caps);
-    if (!ret) {
-      GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
-      return GST_FLOW_ERROR;
-    }
-
-    y4mdec->have_header = TRUE;
   }
 
   if (y4mdec->have_new_segment) {
@@ -668,69 +821,185 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     buffer = gst_adapter_take_buffer (y4mdec->adapter, y4mdec->info.size);
 
-    GST_BUFFER_TIMESTAMP (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
-    GST_BUFFER_DURATION (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
-        GST_BUFFER_TIMESTAMP (buffer);
+    flow_ret = gst_y4m_dec_push_frame (y4mdec, buffer);
+    if (flow_ret != GST_FLOW_OK)
+      break;
+  }
 
-    y4mdec->frame_index++;
+  GST_DEBUG ("returning %d", flow_ret);
 
-    if (y4mdec->video_meta) {
-      gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
-          y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
-          y4mdec->info.offset, y4mdec->info.stride);
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBuffer *outbuf;
-      GstVideoFrame iframe, oframe;
-      gint i, j;
-      gint w, h, istride, ostride;
-      guint8 *src, *dest;
-
-      /* Allocate a new buffer and do stride conversion */
-      g_assert (y4mdec->pool != NULL);
-
-      flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
-      if (flow_ret != GST_FLOW_OK) {
-        gst_buffer_unref (buffer);
-        break;
-      }
+  return flow_ret;
+}
 
-      gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
-      gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+static void
+gst_y4m_dec_loop (GstPad * pad)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (GST_PAD_PARENT (pad));
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  GstBuffer *frame;
+  char header[MAX_HEADER_LENGTH];
+  gsize size;
+  int i;
+  int len;
 
-      for (i = 0; i < 3; i++) {
-        w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
-        h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
-        istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
-        ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
-        src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
-        dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+  if (!y4mdec->have_header) {
+    gchar *stream_id;
 
-        for (j = 0; j < h; j++) {
-          memcpy (dest, src, w);
+    stream_id = gst_pad_create_stream_id (y4mdec->srcpad,
+        GST_ELEMENT_CAST (y4mdec), NULL);
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
 
-          dest += ostride;
-          src += istride;
-        }
-      }
+    flow_ret = gst_pad_pull_range (pad, 0, MAX_HEADER_LENGTH, &buffer);
+    if (flow_ret != GST_FLOW_OK)
+      goto pause;
 
-      gst_video_frame_unmap (&iframe);
-      gst_video_frame_unmap (&oframe);
-      gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
-      gst_buffer_unref (buffer);
-      buffer = outbuf;
-    }
+    memset (header, 0, MAX_HEADER_LENGTH);
+    gst_buffer_extract (buffer, 0, header, MAX_HEADER_LENGTH);
+    gst_buffer_unref (buffer);
 
-    flow_ret = gst_pad_push (y4mdec->srcpad, buffer);
+    flow_ret = gst_y4m_dec_handle_header (y4mdec, header);
     if (flow_ret != GST_FLOW_OK)
-      break;
+      goto pause;
+
+    y4mdec->offset = gst_y4m_dec_frames_to_bytes (y4mdec, y4mdec->frame_index);
   }
 
-  GST_DEBUG ("returning %d", flow_ret);
+  if (y4mdec->have_new_segment) {
+    GstSegment seg;
 
-  return flow_ret;
+    gst_segment_init (&seg, GST_FORMAT_TIME);
+    seg.start = gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+    seg.stop = gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->stop_frame);
+    seg.time = seg.position = seg.start;
+
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_segment (&seg));
+    y4mdec->have_new_segment = FALSE;
+  }
+
+  if (y4mdec->stop_frame != -1 && y4mdec->frame_index >= y4mdec->stop_frame) {
+    flow_ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  /* All frames have the same size, so a frame and the usual "FRAME\n" before
+   * it are read in one go and the data pushed as a sub-buffer of it */
+  size = y4mdec->info.size + 6;
+  flow_ret = gst_pad_pull_range (pad, y4mdec->offset, size, &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  memset (header, 0, MAX_HEADER_LENGTH);
+  gst_buffer_extract (buffer, 0, header, MIN (size, MAX_HEADER_LENGTH));
+  header[MAX_HEADER_LENGTH - 1] = 0;
+  for (i = 0; i < MAX_HEADER_LENGTH; i++) {
+    if (header[i] == 0x0a)
+      header[i] = 0;
+  }
+  if (memcmp (header, "FRAME", 5) != 0) {
+    gst_buffer_unref (buffer);
+    GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+        ("Failed to parse YUV4MPEG frame"), (NULL));
+    flow_ret = GST_FLOW_ERROR;
+    goto pause;
+  }
+
+  len = strlen (header);
+  if (len + 1 != 6) {
+    /* frame parameters, pull again with the actual header length */
+    gst_buffer_unref (buffer);
+    size = y4mdec->info.size + len + 1;
+    flow_ret = gst_pad_pull_range (pad, y4mdec->offset, size, &buffer);
+    if (flow_ret != GST_FLOW_OK)
+      goto pause;
+  }
+
+  if (gst_buffer_get_size (buffer) < size) {
+    GST_DEBUG_OBJECT (y4mdec, "short frame at offset %" G_GUINT64_FORMAT,
+        y4mdec->offset);
+    gst_buffer_unref (buffer);
+    flow_ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  frame = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, len + 1,
+      y4mdec->info.size);
+  gst_buffer_unref (buffer);
+  y4mdec->offset += size;
+
+  flow_ret = gst_y4m_dec_push_frame (y4mdec, frame);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  GST_DEBUG_OBJECT (y4mdec, "pausing task, reason %s",
+      gst_flow_get_name (flow_ret));
+  gst_pad_pause_task (pad);
+  if (flow_ret == GST_FLOW_EOS) {
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_eos ());
+  } else if (flow_ret == GST_FLOW_NOT_LINKED || flow_ret < GST_FLOW_EOS) {
+    GST_ELEMENT_FLOW_ERROR (y4mdec, flow_ret);
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_eos ());
+  }
+}
+
+/* seeks in pull mode, the position of a frame only depends on its index */
+static gboolean
+gst_y4m_dec_do_seek (GstY4mDec * y4mdec, GstEvent * event)
+{
+  gdouble rate;
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+  gint64 framenum;
+  gboolean flush;
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
+      &start, &stop_type, &stop);
+
+  if (format != GST_FORMAT_TIME || rate <= 0.0 || !y4mdec->have_header) {
+    GST_DEBUG_OBJECT (y4mdec, "unsupported seek");
+    return FALSE;
+  }
+
+  flush = (flags & GST_SEEK_FLAG_FLUSH) != 0;
+  if (flush)
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_flush_start ());
+  else
+    gst_pad_pause_task (y4mdec->sinkpad);
+
+  GST_PAD_STREAM_LOCK (y4mdec->sinkpad);
+
+  if (flush)
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_flush_stop (TRUE));
+
+  if (start_type == GST_SEEK_TYPE_SET) {
+    framenum = gst_y4m_dec_timestamp_to_frames (y4mdec, start);
+    y4mdec->frame_index = framenum;
+    y4mdec->offset = gst_y4m_dec_frames_to_bytes (y4mdec, framenum);
+  }
+  if (stop_type == GST_SEEK_TYPE_SET) {
+    if (stop == -1)
+      y4mdec->stop_frame = -1;
+    else
+      y4mdec->stop_frame = gst_util_uint64_scale_ceil (stop,
+          y4mdec->info.fps_n, GST_SECOND * y4mdec->info.fps_d);
+  }
+  y4mdec->have_new_segment = TRUE;
+
+  GST_DEBUG_OBJECT (y4mdec, "seeking to frame %d, offset %" G_GUINT64_FORMAT,
+      y4mdec->frame_index, y4mdec->offset);
+
+  gst_pad_start_task (y4mdec->sinkpad, (GstTaskFunction) gst_y4m_dec_loop,
+      y4mdec->sinkpad, NULL);
+
+  GST_PAD_STREAM_UNLOCK (y4mdec->sinkpad);
+
+  return TRUE;
 }
 
 static gboolean
@@ -800,6 +1069,12 @@ gst_y4m_dec_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       gint64 framenum;
       guint64 byte;
 
+      if (y4mdec->pull_mode) {
+        res = gst_y4m_dec_do_seek (y4mdec, event);
+        gst_event_unref (event);
+        break;
+      }
+
       gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
           &start, &stop_type, &stop);
 
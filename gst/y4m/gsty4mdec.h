@@ -50,6 +50,11 @@ struct _GstY4mDec
   gboolean have_new_segment;
   GstSegment segment;
 
+  /* pull mode */
+  gboolean pull_mode;
+  guint64 offset;
+  gint64 stop_frame;
+
   GstVideoInfo info;
   GstVideoInfo out_info;
   gboolean video_meta;
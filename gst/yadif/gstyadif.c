@@ -72,10 +72,18 @@ static GstFlowReturn gst_yadif_transform (GstBaseTransform * trans,
 enum
 {
   PROP_0,
-  PROP_MODE
+  PROP_MODE,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_MODE GST_DEINTERLACE_MODE_AUTO
+#define DEFAULT_N_THREADS 1
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define YADIF_FORMATS "{Y42B,I420,Y444,I420_10LE,I422_10LE,Y444_10LE}"
+#else
+#define YADIF_FORMATS "{Y42B,I420,Y444,I420_10BE,I422_10BE,Y444_10BE}"
+#endif
 
 /* pad templates */
 
@@ -83,7 +91,7 @@ static GstStaticPadTemplate gst_yadif_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string){interleaved,mixed,progressive}")
     );
 
@@ -91,7 +99,7 @@ static GstStaticPadTemplate gst_yadif_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string)progressive")
     );
 
@@ -160,11 +168,27 @@ gst_yadif_class_init (GstYadifClass * klass)
           DEFAULT_MODE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstYadif:n-threads:
+   *
+   * Number of threads filtering slices of each frame in parallel. 0 uses
+   * one thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = one per processor)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_yadif_init (GstYadif * yadif)
 {
+  yadif->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&yadif->lock);
+  g_cond_init (&yadif->cond);
 }
 
 void
@@ -177,6 +201,9 @@ gst_yadif_set_property (GObject * object, guint property_id,
     case PROP_MODE:
       yadif->mode = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      yadif->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -193,6 +220,9 @@ gst_yadif_get_property (GObject * object, guint property_id,
     case PROP_MODE:
       g_value_set_enum (value, yadif->mode);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, yadif->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -212,9 +242,10 @@ gst_yadif_dispose (GObject * object)
 void
 gst_yadif_finalize (GObject * object)
 {
-  /* GstYadif *yadif = GST_YADIF (object); */
+  GstYadif *yadif = GST_YADIF (object);
 
-  /* clean up object here */
+  g_mutex_clear (&yadif->lock);
+  g_cond_clear (&yadif->cond);
 
   G_OBJECT_CLASS (gst_yadif_parent_class)->finalize (object);
 }
@@ -277,9 +308,45 @@ gst_yadif_get_unit_size (GstBaseTransform * trans, GstCaps * caps, gsize * size)
   return FALSE;
 }
 
+void yadif_filter (GstYadif * yadif, int parity, int tff, int slice,
+    int n_slices);
+
+static void
+gst_yadif_filter_slice (gpointer data, gpointer user_data)
+{
+  GstYadif *yadif = user_data;
+  int slice = GPOINTER_TO_INT (data) - 1;
+
+  yadif_filter (yadif, yadif->parity, yadif->tff, slice, yadif->n_slices);
+
+  g_mutex_lock (&yadif->lock);
+  if (--yadif->pending_slices == 0)
+    g_cond_signal (&yadif->cond);
+  g_mutex_unlock (&yadif->lock);
+}
+
 static gboolean
 gst_yadif_start (GstBaseTransform * trans)
 {
+  GstYadif *yadif = GST_YADIF (trans);
+
+  yadif->n_slices = yadif->n_threads;
+  if (yadif->n_slices == 0)
+    yadif->n_slices = g_get_num_processors ();
+
+  /* the streaming thread filters one of the slices itself */
+  if (yadif->n_slices > 1) {
+    GError *err = NULL;
+
+    yadif->pool = g_thread_pool_new (gst_yadif_filter_slice, yadif,
+        yadif->n_slices - 1, FALSE, &err);
+    if (!yadif->pool) {
+      GST_ELEMENT_ERROR (yadif, RESOURCE, FAILED,
+          ("Failed to create filter threads"), ("%s", err->message));
+      g_clear_error (&err);
+      return FALSE;
+    }
+  }
 
   return TRUE;
 }
@@ -287,12 +354,16 @@ gst_yadif_start (GstBaseTransform * trans)
 static gboolean
 gst_yadif_stop (GstBaseTransform * trans)
 {
+  GstYadif *yadif = GST_YADIF (trans);
+
+  if (yadif->pool) {
+    g_thread_pool_free (yadif->pool, FALSE, TRUE);
+    yadif->pool = NULL;
+  }
 
   return TRUE;
 }
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
-
 static GstFlowReturn
 gst_yadif_transform (GstBaseTransform * trans, GstBuffer * inbuf,
     GstBuffer * outbuf)
@@ -315,7 +386,25 @@ gst_yadif_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   yadif->next_frame = yadif->cur_frame;
   yadif->prev_frame = yadif->cur_frame;
 
-  yadif_filter (yadif, parity, tff);
+  if (yadif->pool) {
+    int i;
+
+    yadif->parity = parity;
+    yadif->tff = tff;
+    yadif->pending_slices = yadif->n_slices - 1;
+
+    for (i = 1; i < yadif->n_slices; i++)
+      g_thread_pool_push (yadif->pool, GINT_TO_POINTER (i + 1), NULL);
+
+    yadif_filter (yadif, parity, tff, 0, yadif->n_slices);
+
+    g_mutex_lock (&yadif->lock);
+    while (yadif->pending_slices > 0)
+      g_cond_wait (&yadif->cond, &yadif->lock);
+    g_mutex_unlock (&yadif->lock);
+  } else {
+    yadif_filter (yadif, parity, tff, 0, 1);
+  }
 
   gst_video_frame_unmap (&yadif->dest_frame);
   gst_video_frame_unmap (&yadif->cur_frame);
@@ -53,6 +53,16 @@ struct _GstYadif
   GstVideoFrame cur_frame;
   GstVideoFrame next_frame;
   GstVideoFrame dest_frame;
+
+  guint n_threads;
+
+  /* slice threading */
+  GThreadPool *pool;
+  gint n_slices;
+  gint parity, tff;
+  GMutex lock;
+  GCond cond;
+  gint pending_slices;
 };
 
 struct _GstYadifClass
@@ -36,38 +36,39 @@
 #define FFMIN3(a,b,c) FFMIN(FFMIN(a,b),c)
 
 
-#define PERM_RWP AV_PERM_WRITE | AV_PERM_PRESERVE | AV_PERM_REUSE
+/* The spatial check reads up to 3 pixels on each side of the current
+ * pixel, it is skipped for the pixels closer than that to the edges */
+#define EDGE 3
 
 #define CHECK(j)\
-    {   int score = FFABS(cur[mrefs-1+(j)] - cur[prefs-1-(j)])\
-                  + FFABS(cur[mrefs  +(j)] - cur[prefs  -(j)])\
-                  + FFABS(cur[mrefs+1+(j)] - cur[prefs+1-(j)]);\
+    {   int score = FFABS(cur[x+mrefs-1+(j)] - cur[x+prefs-1-(j)])\
+                  + FFABS(cur[x+mrefs  +(j)] - cur[x+prefs  -(j)])\
+                  + FFABS(cur[x+mrefs+1+(j)] - cur[x+prefs+1-(j)]);\
         if (score < spatial_score) {\
             spatial_score= score;\
-            spatial_pred= (cur[mrefs  +(j)] + cur[prefs  -(j)])>>1;\
+            spatial_pred= (cur[x+mrefs  +(j)] + cur[x+prefs  -(j)])>>1;\
 
 #define FILTER \
-    for (x = 0;  x < w; x++) { \
-        int c = cur[mrefs]; \
-        int d = (prev2[0] + next2[0])>>1; \
-        int e = cur[prefs]; \
-        int temporal_diff0 = FFABS(prev2[0] - next2[0]); \
-        int temporal_diff1 =(FFABS(prev[mrefs] - c) + FFABS(prev[prefs] - e) )>>1; \
-        int temporal_diff2 =(FFABS(next[mrefs] - c) + FFABS(next[prefs] - e) )>>1; \
+    for (x = start;  x < end; x++) { \
+        int c = cur[x+mrefs]; \
+        int d = (prev2[x] + next2[x])>>1; \
+        int e = cur[x+prefs]; \
+        int temporal_diff0 = FFABS(prev2[x] - next2[x]); \
+        int temporal_diff1 =(FFABS(prev[x+mrefs] - c) + FFABS(prev[x+prefs] - e) )>>1; \
+        int temporal_diff2 =(FFABS(next[x+mrefs] - c) + FFABS(next[x+prefs] - e) )>>1; \
         int diff = FFMAX3(temporal_diff0 >> 1, temporal_diff1, temporal_diff2); \
         int spatial_pred = (c+e) >> 1; \
-        int spatial_score = -1; \
  \
-        if (mrefs > 0 && prefs > 0) { \
-            spatial_score = FFABS(cur[mrefs - 1] - cur[prefs - 1]) + FFABS(c-e) \
-                            + FFABS(cur[mrefs + 1] - cur[prefs + 1]) - 1; \
+        if (x >= EDGE && x + EDGE < w) { \
+            int spatial_score = FFABS(cur[x+mrefs-1] - cur[x+prefs-1]) + FFABS(c-e) \
+                            + FFABS(cur[x+mrefs+1] - cur[x+prefs+1]) - 1; \
  \
             CHECK(-1) CHECK(-2) }} }} \
             CHECK( 1) CHECK( 2) }} }} \
         } \
         if (mode < 2) { \
-            int b = (prev2[2 * mrefs] + next2[2 * mrefs])>>1; \
-            int f = (prev2[2 * prefs] + next2[2 * prefs])>>1; \
+            int b = (prev2[x + 2 * mrefs] + next2[x + 2 * mrefs])>>1; \
+            int f = (prev2[x + 2 * prefs] + next2[x + 2 * prefs])>>1; \
             int max = FFMAX3(d - e, d - c, FFMIN(b - c, f - e)); \
             int min = FFMIN3(d - e, d - c, FFMAX(b - c, f - e)); \
  \
@@ -79,20 +80,15 @@
         else if (spatial_pred < d - diff) \
            spatial_pred = d - diff; \
  \
-        dst[0] = spatial_pred; \
- \
-        dst++; \
-        cur++; \
-        prev++; \
-        next++; \
-        prev2++; \
-        next2++; \
+        dst[x] = spatial_pred; \
     }
 
+/* filters the pixels from @start to @end of a line of width @w, @prefs and
+ * @mrefs are in bytes */
 static void
 filter_line_c (guint8 * dst,
     guint8 * prev, guint8 * cur, guint8 * next,
-    int w, int prefs, int mrefs, int parity, int mode)
+    int w, int prefs, int mrefs, int parity, int mode, int start, int end)
 {
   int x;
   guint8 *prev2 = parity ? prev : cur;
@@ -100,11 +96,10 @@ filter_line_c (guint8 * dst,
 
 FILTER}
 
-#if 0
 static void
 filter_line_c_16bit (guint16 * dst,
     guint16 * prev, guint16 * cur, guint16 * next,
-    int w, int prefs, int mrefs, int parity, int mode)
+    int w, int prefs, int mrefs, int parity, int mode, int start, int end)
 {
   int x;
   guint16 *prev2 = parity ? prev : cur;
@@ -113,51 +108,142 @@ filter_line_c_16bit (guint16 * dst,
   prefs /= 2;
 
 FILTER}
-#endif
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
+/* The SIMD versions filter @w pixels, a multiple of their step, and may
+ * read up to the given number of pixels past the last one */
+typedef void (*FilterLineFunc) (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+
+typedef struct
+{
+  FilterLineFunc filter_line;
+  FilterLineFunc filter_line_16bit;
+  int step, overread;
+} FilterLineImpl;
+
+void yadif_filter (GstYadif * yadif, int parity, int tff, int slice,
+    int n_slices);
 #ifdef HAVE_CPU_X86_64
 void filter_line_x86_64 (guint8 * dst,
     guint8 * prev, guint8 * cur, guint8 * next,
     int w, int prefs, int mrefs, int parity, int mode);
+gboolean yadif_have_avx2 (void);
+void yadif_filter_line_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_16bit_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+#endif
+#ifdef __ARM_NEON
+void yadif_filter_line_neon (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_16bit_neon (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
 #endif
 
+static const FilterLineImpl *
+get_filter_line_impl (void)
+{
+  static const FilterLineImpl *impl = NULL;
+
+  if (g_once_init_enter (&impl)) {
+    static FilterLineImpl ret = { NULL, NULL, 1, 0 };
+
+#ifdef HAVE_CPU_X86_64
+    if (yadif_have_avx2 ()) {
+      ret.filter_line = yadif_filter_line_avx2;
+      ret.filter_line_16bit = yadif_filter_line_16bit_avx2;
+      ret.step = 16;
+      ret.overread = 0;
+    } else {
+      /* the SSE2 version loads 16 bytes for 8 pixels */
+      ret.filter_line = filter_line_x86_64;
+      ret.step = 8;
+      ret.overread = 8;
+    }
+#elif defined (__ARM_NEON)
+    ret.filter_line = yadif_filter_line_neon;
+    ret.filter_line_16bit = yadif_filter_line_16bit_neon;
+    ret.step = 8;
+    ret.overread = 0;
+#endif
+
+    g_once_init_leave (&impl, &ret);
+  }
+
+  return impl;
+}
+
+static void
+filter_line (const FilterLineImpl * impl, guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode, int bps)
+{
+  FilterLineFunc simd = bps == 2 ? impl->filter_line_16bit : impl->filter_line;
+  int start = 0, end = 0;
+
+  /* the SIMD version does the middle of the line, where the spatial check
+   * applies to all pixels, the C version the edges */
+  if (simd && w >= 2 * EDGE + impl->overread + impl->step) {
+    int n = (w - 2 * EDGE - impl->overread) / impl->step * impl->step;
+    int offset = EDGE * bps;
+
+    simd (dst + offset, prev + offset, cur + offset, next + offset, n,
+        prefs, mrefs, parity, mode);
+    start = EDGE;
+    end = EDGE + n;
+  }
+
+  if (bps == 2) {
+    filter_line_c_16bit ((guint16 *) dst, (guint16 *) prev, (guint16 *) cur,
+        (guint16 *) next, w, prefs, mrefs, parity, mode, 0, start);
+    filter_line_c_16bit ((guint16 *) dst, (guint16 *) prev, (guint16 *) cur,
+        (guint16 *) next, w, prefs, mrefs, parity, mode, end, w);
+  } else {
+    filter_line_c (dst, prev, cur, next, w, prefs, mrefs, parity, mode, 0,
+        start);
+    filter_line_c (dst, prev, cur, next, w, prefs, mrefs, parity, mode, end,
+        w);
+  }
+}
+
+/* Filters the lines of slice @slice out of @n_slices of every plane. The
+ * slices don't overlap, so they can be filtered from different threads */
 void
-yadif_filter (GstYadif * yadif, int parity, int tff)
+yadif_filter (GstYadif * yadif, int parity, int tff, int slice, int n_slices)
 {
   int y, i;
   const GstVideoInfo *vi = &yadif->video_info;
   const GstVideoFormatInfo *vfi = vi->finfo;
+  const FilterLineImpl *impl = get_filter_line_impl ();
 
   for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (vfi); i++) {
     int w = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (vfi, i, vi->width);
     int h = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (vfi, i, vi->height);
     int refs = GST_VIDEO_INFO_COMP_STRIDE (vi, i);
     int df = GST_VIDEO_INFO_COMP_PSTRIDE (vi, i);
+    int y_start = h * slice / n_slices;
+    int y_end = h * (slice + 1) / n_slices;
     guint8 *prev_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->prev_frame, i);
     guint8 *cur_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->cur_frame, i);
     guint8 *next_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->next_frame, i);
     guint8 *dest_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->dest_frame, i);
 
-    for (y = 0; y < h; y++) {
+    for (y = y_start; y < y_end; y++) {
       if ((y ^ parity) & 1) {
         guint8 *prev = prev_data + y * refs;
         guint8 *cur = cur_data + y * refs;
         guint8 *next = next_data + y * refs;
         guint8 *dst = dest_data + y * refs;
         int mode = ((y == 1) || (y + 2 == h)) ? 2 : yadif->mode;
-#if HAVE_CPU_X86_64
-        if (0) {
-          filter_line_c (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        } else {
-          filter_line_x86_64 (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        }
-#else
-        filter_line_c (dst, prev, cur, next, w,
-            y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-#endif
+
+        filter_line (impl, dst, prev, cur, next, w,
+            y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode,
+            df);
       } else {
         guint8 *dst = dest_data + y * refs;
         guint8 *cur = cur_data + y * refs;
@@ -166,8 +252,4 @@ yadif_filter (GstYadif * yadif, int parity, int tff)
       }
     }
   }
-
-#if 0
-  emms_c ();
-#endif
 }
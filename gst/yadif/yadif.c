@@ -104,4 +104,333 @@ filter_line_x86_64 (guint8 * dst,
   yadif_filter_line_sse2 (dst, prev, cur, next, w, prefs, mrefs, parity, mode);
 }
 
+/* AVX2 version of the C filter, on 16 pixels at a time in 16 bit lanes,
+ * which is enough for up to 12 bit samples */
+#if defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_AVX2_INTRINSICS 1
 #endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+
+#define AVX2 __attribute__ ((target ("avx2")))
+
+static inline AVX2 __m256i
+load_8bit (const guint8 * p)
+{
+  return _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) p));
+}
+
+static inline AVX2 void
+store_8bit (guint8 * p, __m256i v)
+{
+  _mm_storeu_si128 ((__m128i *) p,
+      _mm_packus_epi16 (_mm256_castsi256_si128 (v),
+          _mm256_extracti128_si256 (v, 1)));
+}
+
+static inline AVX2 __m256i
+load_16bit (const guint16 * p)
+{
+  return _mm256_loadu_si256 ((const __m256i *) p);
+}
+
+static inline AVX2 void
+store_16bit (guint16 * p, __m256i v)
+{
+  _mm256_storeu_si256 ((__m256i *) p, v);
+}
+
+#define ABS_DIFF(a,b) _mm256_abs_epi16 (_mm256_sub_epi16 ((a), (b)))
+#define AVG(a,b) _mm256_srai_epi16 (_mm256_add_epi16 ((a), (b)), 1)
+
+/* score and prediction of the spatial direction j */
+#define AVX2_SCORE(j) \
+    _mm256_add_epi16 (_mm256_add_epi16 ( \
+            ABS_DIFF (LOAD (cur + x + mrefs - 1 + (j)), \
+                LOAD (cur + x + prefs - 1 - (j))), \
+            ABS_DIFF (LOAD (cur + x + mrefs + (j)), \
+                LOAD (cur + x + prefs - (j)))), \
+        ABS_DIFF (LOAD (cur + x + mrefs + 1 + (j)), \
+            LOAD (cur + x + prefs + 1 - (j))))
+#define AVX2_PRED(j) \
+    AVG (LOAD (cur + x + mrefs + (j)), LOAD (cur + x + prefs - (j)))
+
+/* like the nested CHECK() of the C version: direction 2 is only tried
+ * where direction 1 was better */
+#define AVX2_CHECK(j1, j2) { \
+      __m256i score = AVX2_SCORE (j1); \
+      __m256i better = _mm256_cmpgt_epi16 (spatial_score, score); \
+      spatial_score = _mm256_blendv_epi8 (spatial_score, score, better); \
+      spatial_pred = _mm256_blendv_epi8 (spatial_pred, AVX2_PRED (j1), better); \
+      score = AVX2_SCORE (j2); \
+      better = _mm256_and_si256 (better, \
+          _mm256_cmpgt_epi16 (spatial_score, score)); \
+      spatial_score = _mm256_blendv_epi8 (spatial_score, score, better); \
+      spatial_pred = _mm256_blendv_epi8 (spatial_pred, AVX2_PRED (j2), better); \
+    }
+
+#define AVX2_FILTER \
+  for (x = 0; x < w; x += 16) { \
+    __m256i c = LOAD (cur + x + mrefs); \
+    __m256i e = LOAD (cur + x + prefs); \
+    __m256i p2 = LOAD (prev2 + x); \
+    __m256i n2 = LOAD (next2 + x); \
+    __m256i d = AVG (p2, n2); \
+    __m256i temporal_diff0 = ABS_DIFF (p2, n2); \
+    __m256i temporal_diff1 = _mm256_srai_epi16 (_mm256_add_epi16 ( \
+            ABS_DIFF (LOAD (prev + x + mrefs), c), \
+            ABS_DIFF (LOAD (prev + x + prefs), e)), 1); \
+    __m256i temporal_diff2 = _mm256_srai_epi16 (_mm256_add_epi16 ( \
+            ABS_DIFF (LOAD (next + x + mrefs), c), \
+            ABS_DIFF (LOAD (next + x + prefs), e)), 1); \
+    __m256i diff = _mm256_max_epi16 (_mm256_max_epi16 ( \
+            _mm256_srai_epi16 (temporal_diff0, 1), temporal_diff1), \
+        temporal_diff2); \
+    __m256i spatial_pred = AVG (c, e); \
+    __m256i spatial_score = _mm256_sub_epi16 (_mm256_add_epi16 ( \
+            _mm256_add_epi16 (ABS_DIFF (LOAD (cur + x + mrefs - 1), \
+                    LOAD (cur + x + prefs - 1)), ABS_DIFF (c, e)), \
+            ABS_DIFF (LOAD (cur + x + mrefs + 1), \
+                LOAD (cur + x + prefs + 1))), _mm256_set1_epi16 (1)); \
+ \
+    AVX2_CHECK (-1, -2); \
+    AVX2_CHECK (1, 2); \
+ \
+    if (mode < 2) { \
+      __m256i b = AVG (LOAD (prev2 + x + 2 * mrefs), \
+          LOAD (next2 + x + 2 * mrefs)); \
+      __m256i f = AVG (LOAD (prev2 + x + 2 * prefs), \
+          LOAD (next2 + x + 2 * prefs)); \
+      __m256i de = _mm256_sub_epi16 (d, e); \
+      __m256i dc = _mm256_sub_epi16 (d, c); \
+      __m256i bc = _mm256_sub_epi16 (b, c); \
+      __m256i fe = _mm256_sub_epi16 (f, e); \
+      __m256i max = _mm256_max_epi16 (_mm256_max_epi16 (de, dc), \
+          _mm256_min_epi16 (bc, fe)); \
+      __m256i min = _mm256_min_epi16 (_mm256_min_epi16 (de, dc), \
+          _mm256_max_epi16 (bc, fe)); \
+ \
+      diff = _mm256_max_epi16 (_mm256_max_epi16 (diff, min), \
+          _mm256_sub_epi16 (_mm256_setzero_si256 (), max)); \
+    } \
+ \
+    spatial_pred = _mm256_max_epi16 (_mm256_min_epi16 (spatial_pred, \
+            _mm256_add_epi16 (d, diff)), _mm256_sub_epi16 (d, diff)); \
+    STORE (dst + x, spatial_pred); \
+  }
+
+gboolean yadif_have_avx2 (void);
+void yadif_filter_line_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_16bit_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+
+gboolean
+yadif_have_avx2 (void)
+{
+  __builtin_cpu_init ();
+
+  return __builtin_cpu_supports ("avx2");
+}
+
+#define LOAD load_8bit
+#define STORE store_8bit
+AVX2 void
+yadif_filter_line_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  int x;
+  guint8 *prev2 = parity ? prev : cur;
+  guint8 *next2 = parity ? cur : next;
+
+AVX2_FILTER}
+#undef LOAD
+#undef STORE
+
+#define LOAD load_16bit
+#define STORE store_16bit
+AVX2 void
+yadif_filter_line_16bit_avx2 (guint8 * dst_8,
+    guint8 * prev_8, guint8 * cur_8, guint8 * next_8,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  int x;
+  guint16 *dst = (guint16 *) dst_8;
+  guint16 *prev = (guint16 *) prev_8;
+  guint16 *cur = (guint16 *) cur_8;
+  guint16 *next = (guint16 *) next_8;
+  guint16 *prev2 = parity ? prev : cur;
+  guint16 *next2 = parity ? cur : next;
+
+  mrefs /= 2;
+  prefs /= 2;
+
+AVX2_FILTER}
+#undef LOAD
+#undef STORE
+
+#else /* !HAVE_AVX2_INTRINSICS */
+
+gboolean yadif_have_avx2 (void);
+void yadif_filter_line_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_16bit_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+
+gboolean
+yadif_have_avx2 (void)
+{
+  return FALSE;
+}
+
+void
+yadif_filter_line_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  g_assert_not_reached ();
+}
+
+void
+yadif_filter_line_16bit_avx2 (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  g_assert_not_reached ();
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
+
+#endif /* HAVE_CPU_X86_64 */
+
+/* NEON version of the C filter, on 8 pixels at a time in 16 bit lanes */
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+
+#define NEON_LOAD_8BIT(p) vreinterpretq_s16_u16 (vmovl_u8 (vld1_u8 (p)))
+#define NEON_STORE_8BIT(p,v) vst1_u8 ((p), vqmovun_s16 (v))
+#define NEON_LOAD_16BIT(p) vreinterpretq_s16_u16 (vld1q_u16 (p))
+#define NEON_STORE_16BIT(p,v) vst1q_u16 ((p), vreinterpretq_u16_s16 (v))
+
+#define NEON_ABS_DIFF(a,b) vabdq_s16 ((a), (b))
+#define NEON_AVG(a,b) vshrq_n_s16 (vaddq_s16 ((a), (b)), 1)
+
+#define NEON_SCORE(j) \
+    vaddq_s16 (vaddq_s16 ( \
+            NEON_ABS_DIFF (LOAD (cur + x + mrefs - 1 + (j)), \
+                LOAD (cur + x + prefs - 1 - (j))), \
+            NEON_ABS_DIFF (LOAD (cur + x + mrefs + (j)), \
+                LOAD (cur + x + prefs - (j)))), \
+        NEON_ABS_DIFF (LOAD (cur + x + mrefs + 1 + (j)), \
+            LOAD (cur + x + prefs + 1 - (j))))
+#define NEON_PRED(j) \
+    NEON_AVG (LOAD (cur + x + mrefs + (j)), LOAD (cur + x + prefs - (j)))
+
+#define NEON_CHECK(j1, j2) { \
+      int16x8_t score = NEON_SCORE (j1); \
+      uint16x8_t better = vcltq_s16 (score, spatial_score); \
+      spatial_score = vbslq_s16 (better, score, spatial_score); \
+      spatial_pred = vbslq_s16 (better, NEON_PRED (j1), spatial_pred); \
+      score = NEON_SCORE (j2); \
+      better = vandq_u16 (better, vcltq_s16 (score, spatial_score)); \
+      spatial_score = vbslq_s16 (better, score, spatial_score); \
+      spatial_pred = vbslq_s16 (better, NEON_PRED (j2), spatial_pred); \
+    }
+
+#define NEON_FILTER \
+  for (x = 0; x < w; x += 8) { \
+    int16x8_t c = LOAD (cur + x + mrefs); \
+    int16x8_t e = LOAD (cur + x + prefs); \
+    int16x8_t p2 = LOAD (prev2 + x); \
+    int16x8_t n2 = LOAD (next2 + x); \
+    int16x8_t d = NEON_AVG (p2, n2); \
+    int16x8_t temporal_diff0 = NEON_ABS_DIFF (p2, n2); \
+    int16x8_t temporal_diff1 = vshrq_n_s16 (vaddq_s16 ( \
+            NEON_ABS_DIFF (LOAD (prev + x + mrefs), c), \
+            NEON_ABS_DIFF (LOAD (prev + x + prefs), e)), 1); \
+    int16x8_t temporal_diff2 = vshrq_n_s16 (vaddq_s16 ( \
+            NEON_ABS_DIFF (LOAD (next + x + mrefs), c), \
+            NEON_ABS_DIFF (LOAD (next + x + prefs), e)), 1); \
+    int16x8_t diff = vmaxq_s16 (vmaxq_s16 (vshrq_n_s16 (temporal_diff0, 1), \
+            temporal_diff1), temporal_diff2); \
+    int16x8_t spatial_pred = NEON_AVG (c, e); \
+    int16x8_t spatial_score = vsubq_s16 (vaddq_s16 (vaddq_s16 ( \
+                NEON_ABS_DIFF (LOAD (cur + x + mrefs - 1), \
+                    LOAD (cur + x + prefs - 1)), NEON_ABS_DIFF (c, e)), \
+            NEON_ABS_DIFF (LOAD (cur + x + mrefs + 1), \
+                LOAD (cur + x + prefs + 1))), vdupq_n_s16 (1)); \
+ \
+    NEON_CHECK (-1, -2); \
+    NEON_CHECK (1, 2); \
+ \
+    if (mode < 2) { \
+      int16x8_t b = NEON_AVG (LOAD (prev2 + x + 2 * mrefs), \
+          LOAD (next2 + x + 2 * mrefs)); \
+      int16x8_t f = NEON_AVG (LOAD (prev2 + x + 2 * prefs), \
+          LOAD (next2 + x + 2 * prefs)); \
+      int16x8_t de = vsubq_s16 (d, e); \
+      int16x8_t dc = vsubq_s16 (d, c); \
+      int16x8_t bc = vsubq_s16 (b, c); \
+      int16x8_t fe = vsubq_s16 (f, e); \
+      int16x8_t max = vmaxq_s16 (vmaxq_s16 (de, dc), vminq_s16 (bc, fe)); \
+      int16x8_t min = vminq_s16 (vminq_s16 (de, dc), vmaxq_s16 (bc, fe)); \
+ \
+      diff = vmaxq_s16 (vmaxq_s16 (diff, min), vnegq_s16 (max)); \
+    } \
+ \
+    spatial_pred = vmaxq_s16 (vminq_s16 (spatial_pred, vaddq_s16 (d, diff)), \
+        vsubq_s16 (d, diff)); \
+    STORE (dst + x, spatial_pred); \
+  }
+
+void yadif_filter_line_neon (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+void yadif_filter_line_16bit_neon (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode);
+
+#define LOAD NEON_LOAD_8BIT
+#define STORE NEON_STORE_8BIT
+void
+yadif_filter_line_neon (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  int x;
+  guint8 *prev2 = parity ? prev : cur;
+  guint8 *next2 = parity ? cur : next;
+
+NEON_FILTER}
+#undef LOAD
+#undef STORE
+
+#define LOAD NEON_LOAD_16BIT
+#define STORE NEON_STORE_16BIT
+void
+yadif_filter_line_16bit_neon (guint8 * dst_8,
+    guint8 * prev_8, guint8 * cur_8, guint8 * next_8,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  int x;
+  guint16 *dst = (guint16 *) dst_8;
+  guint16 *prev = (guint16 *) prev_8;
+  guint16 *cur = (guint16 *) cur_8;
+  guint16 *next = (guint16 *) next_8;
+  guint16 *prev2 = parity ? prev : cur;
+  guint16 *next2 = parity ? cur : next;
+
+  mrefs /= 2;
+  prefs /= 2;
+
+NEON_FILTER}
+#undef LOAD
+#undef STORE
+
+#endif /* __ARM_NEON */
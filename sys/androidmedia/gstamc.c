@@ -2395,10 +2395,15 @@ gst_amc_color_format_copy (GstAmcColorFormatInfo * cinfo,
         vptr = GST_VIDEO_FRAME_COMP_DATA (&vframe, i);
         height = GST_VIDEO_FRAME_COMP_HEIGHT (&vframe, i);
 
-        for (j = 0; j < height; j++) {
-          orc_memcpy (*dest, *src, row_length);
-          cptr += c_stride;
-          vptr += v_stride;
+        if (c_stride == v_stride && height > 0) {
+          /* Same plane layout on both sides, copy the plane at once */
+          orc_memcpy (*dest, *src, (height - 1) * c_stride + row_length);
+        } else {
+          for (j = 0; j < height; j++) {
+            orc_memcpy (*dest, *src, row_length);
+            cptr += c_stride;
+            vptr += v_stride;
+          }
         }
       }
       gst_video_frame_unmap (&vframe);
@@ -2438,10 +2443,15 @@ gst_amc_color_format_copy (GstAmcColorFormatInfo * cinfo,
         vptr = GST_VIDEO_FRAME_COMP_DATA (&vframe, i);
         height = GST_VIDEO_FRAME_COMP_HEIGHT (&vframe, i);
 
-        for (j = 0; j < height; j++) {
-          orc_memcpy (*dest, *src, row_length);
-          cptr += c_stride;
-          vptr += v_stride;
+        if (c_stride == v_stride && height > 0) {
+          /* Same plane layout on both sides, copy the plane at once */
+          orc_memcpy (*dest, *src, (height - 1) * c_stride + row_length);
+        } else {
+          for (j = 0; j < height; j++) {
+            orc_memcpy (*dest, *src, row_length);
+            cptr += c_stride;
+            vptr += v_stride;
+          }
         }
       }
       gst_video_frame_unmap (&vframe);
@@ -2481,10 +2491,15 @@ gst_amc_color_format_copy (GstAmcColorFormatInfo * cinfo,
         vptr = GST_VIDEO_FRAME_COMP_DATA (&vframe, i);
         height = GST_VIDEO_FRAME_COMP_HEIGHT (&vframe, i);
 
-        for (j = 0; j < height; j++) {
-          orc_memcpy (*dest, *src, row_length);
-          cptr += c_stride;
-          vptr += v_stride;
+        if (c_stride == v_stride && height > 0) {
+          /* Same plane layout on both sides, copy the plane at once */
+          orc_memcpy (*dest, *src, (height - 1) * c_stride + row_length);
+        } else {
+          for (j = 0; j < height; j++) {
+            orc_memcpy (*dest, *src, row_length);
+            cptr += c_stride;
+            vptr += v_stride;
+          }
         }
       }
       gst_video_frame_unmap (&vframe);
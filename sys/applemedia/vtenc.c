@@ -1098,11 +1098,13 @@ gst_vtenc_encode_frame (GstVTEnc * self, GstVideoCodecFrame * frame)
     GstVideoFrame inframe, outframe;
     GstBuffer *outbuf;
     OSType pixel_format_type;
+    CVPixelBufferPoolRef pool;
     CVReturn cv_ret;
 
-    /* FIXME: iOS has special stride requirements that we don't know yet.
-     * Copy into a newly allocated pixelbuffer for now. Probably makes
-     * sense to create a buffer pool around these at some point.
+    /* iOS has special stride requirements that we don't know, so copy
+     * into a pixel buffer from the session's pool. Those are IOSurface
+     * backed buffers in the layout the encoder reads directly, and they are
+     * recycled instead of being allocated for every frame.
      */
 
     switch (GST_VIDEO_INFO_FORMAT (&self->video_info)) {
@@ -1120,9 +1122,23 @@ gst_vtenc_encode_frame (GstVTEnc * self, GstVideoCodecFrame * frame)
             GST_MAP_READ))
       goto cv_error;
 
-    cv_ret =
-        CVPixelBufferCreate (NULL, self->negotiated_width,
-        self->negotiated_height, pixel_format_type, NULL, &pbuf);
+    pool = VTCompressionSessionGetPixelBufferPool (self->session);
+    if (pool != NULL) {
+      cv_ret = CVPixelBufferPoolCreatePixelBuffer (NULL, pool, &pbuf);
+      /* The encoder picks the format of its pool, only use it if it is the
+       * one we are copying from */
+      if (cv_ret == kCVReturnSuccess &&
+          CVPixelBufferGetPixelFormatType (pbuf) != pixel_format_type) {
+        CVPixelBufferRelease (pbuf);
+        pbuf = NULL;
+        pool = NULL;
+      }
+    }
+    if (pool == NULL) {
+      cv_ret =
+          CVPixelBufferCreate (NULL, self->negotiated_width,
+          self->negotiated_height, pixel_format_type, NULL, &pbuf);
+    }
 
     if (cv_ret != kCVReturnSuccess) {
       gst_video_frame_unmap (&inframe);
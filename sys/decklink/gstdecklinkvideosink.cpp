@@ -115,6 +115,109 @@ private:
   gint m_refcount;
 };
 
+/* Video frame that hands the memory of a GstBuffer to the SDK, so that it
+ * is scheduled without copying it into a frame from CreateVideoFrame().
+ * The buffer stays mapped until the SDK releases the frame. */
+class GStreamerVideoOutputFrame:public IDeckLinkVideoFrame
+{
+public:
+  GStreamerVideoOutputFrame (GstVideoFrame * vframe, BMDPixelFormat format)
+  :IDeckLinkVideoFrame (), m_vframe (*vframe), m_format (format),
+      m_refcount (1)
+  {
+    g_mutex_init (&m_mutex);
+  }
+
+  virtual HRESULT WINAPI QueryInterface (REFIID, LPVOID *)
+  {
+    return E_NOINTERFACE;
+  }
+
+  virtual ULONG WINAPI AddRef (void)
+  {
+    ULONG ret;
+
+    g_mutex_lock (&m_mutex);
+    m_refcount++;
+    ret = m_refcount;
+    g_mutex_unlock (&m_mutex);
+
+    return ret;
+  }
+
+  virtual ULONG WINAPI Release (void)
+  {
+    ULONG ret;
+
+    g_mutex_lock (&m_mutex);
+    m_refcount--;
+    ret = m_refcount;
+    g_mutex_unlock (&m_mutex);
+
+    if (ret == 0) {
+      delete this;
+    }
+
+    return ret;
+  }
+
+  virtual long WINAPI GetWidth (void)
+  {
+    return GST_VIDEO_FRAME_WIDTH (&m_vframe);
+  }
+
+  virtual long WINAPI GetHeight (void)
+  {
+    return GST_VIDEO_FRAME_HEIGHT (&m_vframe);
+  }
+
+  virtual long WINAPI GetRowBytes (void)
+  {
+    return GST_VIDEO_FRAME_PLANE_STRIDE (&m_vframe, 0);
+  }
+
+  virtual BMDPixelFormat WINAPI GetPixelFormat (void)
+  {
+    return m_format;
+  }
+
+  virtual BMDFrameFlags WINAPI GetFlags (void)
+  {
+    return bmdFrameFlagDefault;
+  }
+
+  virtual HRESULT WINAPI GetBytes (void **buffer)
+  {
+    *buffer = GST_VIDEO_FRAME_PLANE_DATA (&m_vframe, 0);
+    return S_OK;
+  }
+
+  virtual HRESULT WINAPI GetTimecode (BMDTimecodeFormat, IDeckLinkTimecode **
+      timecode)
+  {
+    *timecode = NULL;
+    return S_FALSE;
+  }
+
+  virtual HRESULT WINAPI GetAncillaryData (IDeckLinkVideoFrameAncillary **
+      ancillary)
+  {
+    *ancillary = NULL;
+    return S_FALSE;
+  }
+
+  virtual ~ GStreamerVideoOutputFrame () {
+    gst_video_frame_unmap (&m_vframe);
+    g_mutex_clear (&m_mutex);
+  }
+
+private:
+  GstVideoFrame m_vframe;
+  BMDPixelFormat m_format;
+  GMutex m_mutex;
+  gint m_refcount;
+};
+
 enum
 {
   PROP_0,
@@ -540,6 +643,11 @@ convert_to_internal_clock (GstDecklinkVideoSink * self,
   } else {
     GST_LOG_OBJECT (self, "No clock conversion needed, same clocks");
   }
+
+  if (clock)
+    gst_object_unref (clock);
+  if (audio_clock)
+    gst_object_unref (audio_clock);
 }
 
 static GstFlowReturn
@@ -547,7 +655,8 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
 {
   GstDecklinkVideoSink *self = GST_DECKLINK_VIDEO_SINK_CAST (bsink);
   GstVideoFrame vframe;
-  IDeckLinkMutableVideoFrame *frame;
+  IDeckLinkVideoFrame *frame;
+  IDeckLinkMutableVideoFrame *mutable_frame;
   guint8 *outdata, *indata;
   GstFlowReturn flow_ret;
   HRESULT ret;
@@ -607,32 +716,44 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
   else
     running_time = 0;
 
+  if (!gst_video_frame_map (&vframe, &self->info, buffer, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (self, "Failed to map video frame");
+    return GST_FLOW_ERROR;
+  }
+
+  tc_meta = gst_buffer_get_video_time_code_meta (buffer);
+
+  /* Frames without a timecode and with the row size the device expects are
+   * scheduled directly from the buffer memory */
+  if (!tc_meta && GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0) ==
+      self->info.stride[0]) {
+    GST_LOG_OBJECT (self, "Scheduling buffer %p without copying", buffer);
+    frame = new GStreamerVideoOutputFrame (&vframe, format);
+    goto schedule;
+  }
+
   ret = self->output->output->CreateVideoFrame (self->info.width,
       self->info.height, self->info.stride[0], format, bmdFrameFlagDefault,
-      &frame);
+      &mutable_frame);
   if (ret != S_OK) {
+    gst_video_frame_unmap (&vframe);
     GST_ELEMENT_ERROR (self, STREAM, FAILED,
         (NULL), ("Failed to create video frame: 0x%08lx", (unsigned long) ret));
     return GST_FLOW_ERROR;
   }
+  frame = mutable_frame;
 
-  if (!gst_video_frame_map (&vframe, &self->info, buffer, GST_MAP_READ)) {
-    GST_ERROR_OBJECT (self, "Failed to map video frame");
-    flow_ret = GST_FLOW_ERROR;
-    goto out;
-  }
-
-  frame->GetBytes ((void **) &outdata);
+  mutable_frame->GetBytes ((void **) &outdata);
   indata = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0);
-  stride = MIN (GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0), frame->GetRowBytes());
+  stride = MIN (GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0),
+      mutable_frame->GetRowBytes ());
   for (i = 0; i < self->info.height; i++) {
     memcpy (outdata, indata, stride);
     indata += GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0);
-    outdata += frame->GetRowBytes ();
+    outdata += mutable_frame->GetRowBytes ();
   }
   gst_video_frame_unmap (&vframe);
 
-  tc_meta = gst_buffer_get_video_time_code_meta (buffer);
   if (tc_meta) {
     BMDTimecodeFlags bflags = (BMDTimecodeFlags) 0;
     gchar *tc_str;
@@ -646,7 +767,7 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
       bflags = (BMDTimecodeFlags) (bflags | bmdTimecodeFieldMark);
 
     tc_str = gst_video_time_code_to_string (&tc_meta->tc);
-    ret = frame->SetTimecodeFromComponents (self->timecode_format,
+    ret = mutable_frame->SetTimecodeFromComponents (self->timecode_format,
         (uint8_t) tc_meta->tc.hours,
         (uint8_t) tc_meta->tc.minutes,
         (uint8_t) tc_meta->tc.seconds, (uint8_t) tc_meta->tc.frames, bflags);
@@ -662,6 +783,7 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
     g_free (tc_str);
   }
 
+schedule:
   convert_to_internal_clock (self, &running_time, &running_time_duration);
 
   if (!self->output->started) {
@@ -43,6 +43,11 @@
  *  gst-launch-1.0 dvbsrc frequency=503000000 delsys="atsc" modulation="8vsb" pids=48:49:52 ! decodebin name=dec dec. ! videoconvert ! autovideosink dec. ! audioconvert ! autoaudiosink
  * ]| Captures and renders KOFY-HD in San Jose, California. This is an ATSC broadcast, PMT ID 48, Audio/Video elementary stream PIDs 49 and 52 respectively.
  *
+ * If the #GstDvbSrc:pids property is not set, dvbsrc captures the full
+ * transport stream until a downstream demuxer sends a custom upstream
+ * "mpegts-pid-filter" event. The "pids" field of that event holds an array
+ * of the PIDs the demuxer needs, and the PES filters are narrowed to only
+ * output those.
  */
 
 /*
@@ -563,6 +568,7 @@ static gboolean gst_dvbsrc_tune_fe (GstDvbSrc * object);
 
 static void gst_dvbsrc_set_pes_filters (GstDvbSrc * object);
 static void gst_dvbsrc_unset_pes_filters (GstDvbSrc * object);
+static gboolean gst_dvbsrc_event (GstBaseSrc * src, GstEvent * event);
 static gboolean gst_dvbsrc_is_valid_modulation (guint delsys, guint mod);
 static gboolean gst_dvbsrc_is_valid_trans_mode (guint delsys, guint mode);
 static gboolean gst_dvbsrc_is_valid_bandwidth (guint delsys, guint bw);
@@ -641,6 +647,7 @@ gst_dvbsrc_class_init (GstDvbSrcClass * klass)
   gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_dvbsrc_unlock_stop);
   gstbasesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_dvbsrc_is_seekable);
   gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_dvbsrc_get_size);
+  gstbasesrc_class->event = GST_DEBUG_FUNCPTR (gst_dvbsrc_event);
 
   gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_dvbsrc_create);
 
@@ -1045,6 +1052,7 @@ gst_dvbsrc_init (GstDvbSrc * object)
   /* PID 8192 on DVB gets the whole transport stream */
   object->pids[0] = 8192;
   object->pids[1] = G_MAXUINT16;
+  object->pids_set = FALSE;
   object->dvb_buffer_size = DEFAULT_DVB_BUFFER_SIZE;
 
   adapter = g_getenv ("GST_DVB_ADAPTER");
@@ -1114,13 +1122,20 @@ gst_dvbsrc_set_pids (GstDvbSrc * dvbsrc, const gchar * pid_string)
   gchar **pids;
   char **tmp;
 
+  /* the PES filters can't be changed during a read */
+  g_mutex_lock (&dvbsrc->tune_mutex);
+
   if (!strcmp (pid_string, "8192")) {
     /* get the whole TS */
     dvbsrc->pids[0] = 8192;
     dvbsrc->pids[1] = G_MAXUINT16;
+    dvbsrc->pids_set = FALSE;
     goto done;
   }
 
+  /* explicitly configured PIDs take precedence over downstream filters */
+  dvbsrc->pids_set = TRUE;
+
   /* always add the PAT and CAT pids */
   dvbsrc->pids[0] = 0;
   dvbsrc->pids[1] = 1;
@@ -1149,6 +1164,8 @@ done:
     gst_dvbsrc_set_pes_filters (dvbsrc);
   } else
     GST_INFO_OBJECT (dvbsrc, "Not setting PES filters because state < PAUSED");
+
+  g_mutex_unlock (&dvbsrc->tune_mutex);
 }
 
 static void
@@ -2745,6 +2762,71 @@ gst_dvbsrc_tune (GstDvbSrc * object)
 }
 
 
+/* Narrow the PES filters to the PIDs requested by downstream */
+static gboolean
+gst_dvbsrc_set_pid_filter (GstDvbSrc * object, const GstStructure * s)
+{
+  const GValue *pids;
+  guint16 new_pids[MAX_FILTERS];
+  guint i, n;
+
+  pids = gst_structure_get_value (s, "pids");
+  if (pids == NULL || !GST_VALUE_HOLDS_ARRAY (pids))
+    return FALSE;
+
+  /* Validate the whole request before touching the current filter */
+  n = gst_value_array_get_size (pids);
+  if (n == 0 || n > MAX_FILTERS) {
+    /* not enough filters, get the whole TS */
+    GST_INFO_OBJECT (object, "Capturing whole TS for %u requested PIDs", n);
+    new_pids[0] = 8192;
+    new_pids[1] = G_MAXUINT16;
+  } else {
+    for (i = 0; i < n; i++) {
+      const GValue *v = gst_value_array_get_value (pids, i);
+
+      if (!G_VALUE_HOLDS_UINT (v) || g_value_get_uint (v) >= 8192)
+        return FALSE;
+      new_pids[i] = g_value_get_uint (v);
+      GST_INFO_OBJECT (object, "Requested PID: %d", new_pids[i]);
+    }
+    if (n < MAX_FILTERS)
+      new_pids[n] = G_MAXUINT16;
+  }
+
+  /* the PES filters can't be changed during a read */
+  g_mutex_lock (&object->tune_mutex);
+
+  if (object->pids_set) {
+    g_mutex_unlock (&object->tune_mutex);
+    GST_DEBUG_OBJECT (object, "Ignoring PID filter, PIDs were set explicitly");
+    return FALSE;
+  }
+
+  memcpy (object->pids, new_pids, sizeof (new_pids));
+
+  if (GST_ELEMENT (object)->current_state > GST_STATE_READY) {
+    gst_dvbsrc_unset_pes_filters (object);
+    gst_dvbsrc_set_pes_filters (object);
+  }
+
+  g_mutex_unlock (&object->tune_mutex);
+
+  return TRUE;
+}
+
+static gboolean
+gst_dvbsrc_event (GstBaseSrc * src, GstEvent * event)
+{
+  GstDvbSrc *object = GST_DVBSRC (src);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_UPSTREAM &&
+      gst_event_has_name (event, "mpegts-pid-filter"))
+    return gst_dvbsrc_set_pid_filter (object, gst_event_get_structure (event));
+
+  return GST_BASE_SRC_CLASS (parent_class)->event (src, event);
+}
+
 static void
 gst_dvbsrc_unset_pes_filters (GstDvbSrc * object)
 {
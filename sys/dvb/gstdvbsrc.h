@@ -77,6 +77,7 @@ struct _GstDvbSrc
   GstPollFD poll_fd_dvr;
 
   guint16 pids[MAX_FILTERS];
+  gboolean pids_set;
   unsigned int freq;
   unsigned int sym_rate;
   int tone;
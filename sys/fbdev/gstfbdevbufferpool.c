@@ -0,0 +1,289 @@
+/* GStreamer fbdev plugin
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/mman.h>
+
+#include <gst/video/gstvideometa.h>
+
+#include "gstfbdevbufferpool.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_fbdev_buffer_pool_debug);
+#define GST_CAT_DEFAULT gst_fbdev_buffer_pool_debug
+
+#define parent_class gst_fbdev_buffer_pool_parent_class
+G_DEFINE_TYPE_WITH_CODE (GstFBDEVBufferPool, gst_fbdev_buffer_pool,
+    GST_TYPE_BUFFER_POOL,
+    GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "fbdevbufferpool", 0,
+        "fbdev buffer pool"));
+
+static const gchar **
+gst_fbdev_buffer_pool_get_options (GstBufferPool * pool)
+{
+  static const gchar *options[] = { GST_BUFFER_POOL_OPTION_VIDEO_META, NULL };
+  return options;
+}
+
+static gboolean
+gst_fbdev_buffer_pool_set_config (GstBufferPool * pool, GstStructure * config)
+{
+  GstFBDEVBufferPool *fbpool;
+  GstCaps *caps;
+  GstVideoInfo vinfo;
+  gint width, height;
+
+  fbpool = GST_FBDEV_BUFFER_POOL_CAST (pool);
+
+  if (!gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL))
+    goto wrong_config;
+
+  if (!caps)
+    goto no_caps;
+
+  if (!gst_video_info_from_caps (&vinfo, caps))
+    goto wrong_caps;
+
+  width = GST_VIDEO_INFO_WIDTH (&vinfo);
+  height = GST_VIDEO_INFO_HEIGHT (&vinfo);
+
+  /* the frames are rendered in place, so they have to fit on the screen
+   * with the pixel layout of the framebuffer */
+  if (GST_VIDEO_INFO_N_PLANES (&vinfo) != 1 ||
+      GST_VIDEO_INFO_COMP_PSTRIDE (&vinfo, 0) != fbpool->bytespp)
+    goto wrong_format;
+  if (width > fbpool->xres || height > fbpool->yres)
+    goto too_large;
+
+  fbpool->add_videometa = gst_buffer_pool_config_has_option (config,
+      GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  if (GST_VIDEO_INFO_PLANE_STRIDE (&vinfo, 0) != fbpool->line_length &&
+      !fbpool->add_videometa)
+    goto no_videometa;
+
+  /* centered like the frames the sink copies */
+  fbpool->offset = ((fbpool->yres - height) / 2) * fbpool->line_length +
+      ((fbpool->xres - width) / 2) * fbpool->bytespp;
+
+  GST_VIDEO_INFO_PLANE_STRIDE (&vinfo, 0) = fbpool->line_length;
+  GST_VIDEO_INFO_PLANE_OFFSET (&vinfo, 0) = 0;
+  GST_VIDEO_INFO_SIZE (&vinfo) = (height - 1) * fbpool->line_length +
+      width * fbpool->bytespp;
+  fbpool->vinfo = vinfo;
+
+  /* one buffer per page, no more */
+  gst_buffer_pool_config_set_params (config, caps, GST_VIDEO_INFO_SIZE (&vinfo),
+      fbpool->n_pages, fbpool->n_pages);
+
+  return GST_BUFFER_POOL_CLASS (parent_class)->set_config (pool, config);
+
+  /* ERRORS */
+wrong_config:
+  {
+    GST_WARNING_OBJECT (pool, "invalid config");
+    return FALSE;
+  }
+no_caps:
+  {
+    GST_WARNING_OBJECT (pool, "no caps in config");
+    return FALSE;
+  }
+wrong_caps:
+  {
+    GST_WARNING_OBJECT (pool,
+        "failed getting geometry from caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+wrong_format:
+  {
+    GST_DEBUG_OBJECT (pool, "format of %" GST_PTR_FORMAT " does not match "
+        "the framebuffer", caps);
+    return FALSE;
+  }
+too_large:
+  {
+    GST_DEBUG_OBJECT (pool, "%dx%d does not fit on the %dx%d screen", width,
+        height, fbpool->xres, fbpool->yres);
+    return FALSE;
+  }
+no_videometa:
+  {
+    GST_DEBUG_OBJECT (pool, "the framebuffer stride %d needs video meta",
+        fbpool->line_length);
+    return FALSE;
+  }
+}
+
+static GstFlowReturn
+gst_fbdev_buffer_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstFBDEVBufferPool *fbpool;
+  GstVideoInfo *vinfo;
+  GstMemory *mem;
+  GstBuffer *buf;
+  guint page;
+
+  fbpool = GST_FBDEV_BUFFER_POOL_CAST (pool);
+  vinfo = &fbpool->vinfo;
+
+  GST_OBJECT_LOCK (pool);
+  for (page = 0; page < fbpool->n_pages; page++) {
+    if (!(fbpool->used_pages & (1 << page)))
+      break;
+  }
+  if (page == fbpool->n_pages) {
+    GST_OBJECT_UNLOCK (pool);
+    goto no_page;
+  }
+  fbpool->used_pages |= 1 << page;
+  GST_OBJECT_UNLOCK (pool);
+
+  /* the memory keeps the pool, and with it the mapping, alive */
+  mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_NO_SHARE,
+      fbpool->framebuffer + page * fbpool->page_size + fbpool->offset,
+      GST_VIDEO_INFO_SIZE (vinfo), 0, GST_VIDEO_INFO_SIZE (vinfo),
+      gst_object_ref (pool), (GDestroyNotify) gst_object_unref);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+
+  if (fbpool->add_videometa) {
+    gst_buffer_add_video_meta_full (buf, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_INFO_FORMAT (vinfo), GST_VIDEO_INFO_WIDTH (vinfo),
+        GST_VIDEO_INFO_HEIGHT (vinfo), GST_VIDEO_INFO_N_PLANES (vinfo),
+        vinfo->offset, vinfo->stride);
+  }
+
+  GST_DEBUG_OBJECT (pool, "allocated buffer %p in page %u", buf, page);
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+no_page:
+  {
+    GST_WARNING_OBJECT (pool, "all %u pages are in use", fbpool->n_pages);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static void
+gst_fbdev_buffer_pool_free_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstFBDEVBufferPool *fbpool;
+  gint page;
+
+  fbpool = GST_FBDEV_BUFFER_POOL_CAST (pool);
+
+  page = gst_fbdev_buffer_pool_get_page (fbpool, buffer);
+  if (page >= 0) {
+    GST_OBJECT_LOCK (pool);
+    fbpool->used_pages &= ~(1 << page);
+    GST_OBJECT_UNLOCK (pool);
+  }
+
+  GST_BUFFER_POOL_CLASS (parent_class)->free_buffer (pool, buffer);
+}
+
+/* Returns the framebuffer page the buffer lives in, or -1 if its memory is
+ * not in the framebuffer anymore. */
+gint
+gst_fbdev_buffer_pool_get_page (GstFBDEVBufferPool * pool, GstBuffer * buffer)
+{
+  GstMapInfo map;
+  gint page = -1;
+
+  if (gst_buffer_n_memory (buffer) != 1)
+    return -1;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return -1;
+
+  if (map.data >= pool->framebuffer &&
+      map.data < pool->framebuffer + pool->n_pages * pool->page_size)
+    page = (map.data - pool->framebuffer) / pool->page_size;
+
+  gst_buffer_unmap (buffer, &map);
+
+  return page;
+}
+
+/* Makes the pool unmap the framebuffer when it is finalized, which is once
+ * the last of its buffers is gone, instead of the sink unmapping it while
+ * upstream may still be rendering into it. */
+void
+gst_fbdev_buffer_pool_take_mapping (GstFBDEVBufferPool * pool)
+{
+  pool->owns_mapping = TRUE;
+}
+
+static void
+gst_fbdev_buffer_pool_finalize (GObject * object)
+{
+  GstFBDEVBufferPool *fbpool = GST_FBDEV_BUFFER_POOL_CAST (object);
+
+  if (fbpool->owns_mapping)
+    munmap (fbpool->framebuffer, fbpool->mem_len);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_fbdev_buffer_pool_init (GstFBDEVBufferPool * pool)
+{
+}
+
+static void
+gst_fbdev_buffer_pool_class_init (GstFBDEVBufferPoolClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstBufferPoolClass *gstbufferpool_class = (GstBufferPoolClass *) klass;
+
+  gobject_class->finalize = gst_fbdev_buffer_pool_finalize;
+
+  gstbufferpool_class->get_options = gst_fbdev_buffer_pool_get_options;
+  gstbufferpool_class->set_config = gst_fbdev_buffer_pool_set_config;
+  gstbufferpool_class->alloc_buffer = gst_fbdev_buffer_pool_alloc_buffer;
+  gstbufferpool_class->free_buffer = gst_fbdev_buffer_pool_free_buffer;
+}
+
+/* the sink has to be started, its screen info is copied */
+GstBufferPool *
+gst_fbdev_buffer_pool_new (GstFBDEVSink * sink)
+{
+  GstFBDEVBufferPool *pool;
+
+  pool = g_object_new (GST_TYPE_FBDEV_BUFFER_POOL, NULL);
+  gst_object_ref_sink (pool);
+
+  pool->framebuffer = sink->framebuffer;
+  pool->mem_len = sink->fixinfo.smem_len;
+  pool->n_pages = sink->n_pages;
+  pool->line_length = sink->fixinfo.line_length;
+  pool->page_size = sink->varinfo.yres * pool->line_length;
+  pool->xres = sink->varinfo.xres;
+  pool->yres = sink->varinfo.yres;
+  pool->bytespp = pool->line_length / sink->varinfo.xres_virtual;
+
+  return GST_BUFFER_POOL_CAST (pool);
+}
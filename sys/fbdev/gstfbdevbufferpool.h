@@ -0,0 +1,81 @@
+/* GStreamer fbdev plugin
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_FBDEV_BUFFER_POOL_H__
+#define __GST_FBDEV_BUFFER_POOL_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "gstfbdevsink.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GstFBDEVBufferPool GstFBDEVBufferPool;
+typedef struct _GstFBDEVBufferPoolClass GstFBDEVBufferPoolClass;
+
+#define GST_TYPE_FBDEV_BUFFER_POOL \
+  (gst_fbdev_buffer_pool_get_type())
+#define GST_IS_FBDEV_BUFFER_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_FBDEV_BUFFER_POOL))
+#define GST_FBDEV_BUFFER_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_FBDEV_BUFFER_POOL, GstFBDEVBufferPool))
+#define GST_FBDEV_BUFFER_POOL_CAST(obj) \
+  ((GstFBDEVBufferPool*)(obj))
+
+/* Buffers living in the pages of the framebuffer, one buffer per page, so
+ * that upstream renders straight into scanout memory and the sink only has
+ * to pan the display to the page of the buffer it is given. */
+struct _GstFBDEVBufferPool
+{
+  GstBufferPool parent;
+
+  /*< private >*/
+  guint8 *framebuffer;
+  gsize mem_len;
+  gboolean owns_mapping;
+
+  guint n_pages;
+  gsize page_size;
+  gint xres, yres, line_length, bytespp;
+
+  GstVideoInfo vinfo;
+  gsize offset;
+  gboolean add_videometa;
+
+  /* pages of the outstanding buffers, protected by the object lock */
+  guint used_pages;
+};
+
+struct _GstFBDEVBufferPoolClass
+{
+  GstBufferPoolClass parent_class;
+};
+
+GType gst_fbdev_buffer_pool_get_type (void);
+
+GstBufferPool *gst_fbdev_buffer_pool_new (GstFBDEVSink * sink);
+
+gint gst_fbdev_buffer_pool_get_page (GstFBDEVBufferPool * pool,
+    GstBuffer * buffer);
+
+void gst_fbdev_buffer_pool_take_mapping (GstFBDEVBufferPool * pool);
+
+G_END_DECLS
+
+#endif /* __GST_FBDEV_BUFFER_POOL_H__ */
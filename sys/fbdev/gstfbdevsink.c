@@ -31,6 +31,7 @@
 #include <sys/time.h>
 #include <stdlib.h>
 
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
@@ -44,6 +45,7 @@
 #endif
 
 #include "gstfbdevsink.h"
+#include "gstfbdevbufferpool.h"
 
 enum
 {
@@ -64,6 +66,8 @@ static gboolean gst_fbdevsink_stop (GstBaseSink * bsink);
 
 static GstCaps *gst_fbdevsink_getcaps (GstBaseSink * bsink, GstCaps * filter);
 static gboolean gst_fbdevsink_setcaps (GstBaseSink * bsink, GstCaps * caps);
+static gboolean gst_fbdevsink_propose_allocation (GstBaseSink * bsink,
+    GstQuery * query);
 
 static void gst_fbdevsink_finalize (GObject * object);
 static void gst_fbdevsink_set_property (GObject * object,
@@ -255,6 +259,98 @@ gst_fbdevsink_setcaps (GstBaseSink * bsink, GstCaps * vscapslist)
   return TRUE;
 }
 
+static gboolean
+gst_fbdevsink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
+{
+  GstFBDEVSink *fbdevsink;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstCaps *caps, *pool_caps;
+  gboolean need_pool;
+  guint size;
+
+  fbdevsink = GST_FBDEVSINK (bsink);
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (!caps)
+    goto no_caps;
+
+  /* without a second page upstream would render into the frame on screen */
+  if (!need_pool || fbdevsink->n_pages < 2)
+    goto done;
+
+  /* there is only one set of pages, so an active pool is only proposed
+   * again for the caps it is configured for */
+  if (!fbdevsink->pool)
+    fbdevsink->pool = gst_fbdev_buffer_pool_new (fbdevsink);
+  pool = fbdevsink->pool;
+
+  config = gst_buffer_pool_get_config (pool);
+  if (gst_buffer_pool_is_active (pool)) {
+    gst_buffer_pool_config_get_params (config, &pool_caps, &size, NULL, NULL);
+    if (!gst_caps_is_equal (caps, pool_caps)) {
+      GST_DEBUG_OBJECT (fbdevsink, "framebuffer pool busy with %"
+          GST_PTR_FORMAT, pool_caps);
+      gst_structure_free (config);
+      goto done;
+    }
+  } else {
+    gst_buffer_pool_config_set_params (config, caps, 0, 0, 0);
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_META);
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      GST_DEBUG_OBJECT (fbdevsink, "%" GST_PTR_FORMAT " can't be rendered "
+          "in the framebuffer", caps);
+      goto done;
+    }
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_get_params (config, NULL, &size, NULL, NULL);
+  }
+  gst_structure_free (config);
+
+  gst_query_add_allocation_pool (query, pool, size, fbdevsink->n_pages,
+      fbdevsink->n_pages);
+
+done:
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  return TRUE;
+
+  /* ERRORS */
+no_caps:
+  {
+    GST_DEBUG_OBJECT (bsink, "no caps specified");
+    return FALSE;
+  }
+}
+
+/* Shows the given page, then waits for the vertical blank so that the page
+ * shown before is off screen and can be written to. */
+static void
+gst_fbdevsink_flip (GstFBDEVSink * fbdevsink, guint page)
+{
+  if (page != fbdevsink->cur_page) {
+    fbdevsink->varinfo.xoffset = 0;
+    fbdevsink->varinfo.yoffset = page * fbdevsink->varinfo.yres;
+    if (ioctl (fbdevsink->fd, FBIOPAN_DISPLAY, &fbdevsink->varinfo)) {
+      GST_WARNING_OBJECT (fbdevsink, "failed to pan to page %u: %s", page,
+          g_strerror (errno));
+      return;
+    }
+    fbdevsink->cur_page = page;
+  }
+#ifdef FBIO_WAITFORVSYNC
+  if (fbdevsink->wait_vsync) {
+    guint32 crtc = 0;
+
+    if (ioctl (fbdevsink->fd, FBIO_WAITFORVSYNC, &crtc)) {
+      GST_DEBUG_OBJECT (fbdevsink, "can't wait for vsync: %s",
+          g_strerror (errno));
+      fbdevsink->wait_vsync = FALSE;
+    }
+  }
+#endif
+}
 
 static GstFlowReturn
 gst_fbdevsink_show_frame (GstVideoSink * videosink, GstBuffer * buf)
@@ -262,18 +358,33 @@ gst_fbdevsink_show_frame (GstVideoSink * videosink, GstBuffer * buf)
 
   GstFBDEVSink *fbdevsink;
   GstMapInfo map;
+  guint page;
+  gint pool_page;
   int i;
 
   fbdevsink = GST_FBDEVSINK (videosink);
 
-  /* optimization could remove this memcpy by allocating the buffer
-     in framebuffer memory, but would only work when xres matches
-     the video width */
+  /* frames rendered in the framebuffer by upstream only need to be panned
+   * to, and kept until the next one is on screen */
+  if (fbdevsink->pool && buf->pool == fbdevsink->pool) {
+    pool_page = gst_fbdev_buffer_pool_get_page (GST_FBDEV_BUFFER_POOL_CAST
+        (fbdevsink->pool), buf);
+    if (pool_page >= 0) {
+      gst_fbdevsink_flip (fbdevsink, pool_page);
+      gst_buffer_replace (&fbdevsink->front_buffer, buf);
+      return GST_FLOW_OK;
+    }
+  }
+
+  /* others are copied into the page that is not on screen, if any */
+  page = (fbdevsink->cur_page + 1) % fbdevsink->n_pages;
+
   if (!gst_buffer_map (buf, &map, GST_MAP_READ))
     return GST_FLOW_ERROR;
 
   for (i = 0; i < fbdevsink->lines; i++) {
     memcpy (fbdevsink->framebuffer
+        + page * fbdevsink->varinfo.yres * fbdevsink->fixinfo.line_length
         + (i + fbdevsink->cy) * fbdevsink->fixinfo.line_length
         + fbdevsink->cx * fbdevsink->bytespp,
         map.data + i * fbdevsink->width * fbdevsink->bytespp,
@@ -282,6 +393,11 @@ gst_fbdevsink_show_frame (GstVideoSink * videosink, GstBuffer * buf)
 
   gst_buffer_unmap (buf, &map);
 
+  if (fbdevsink->n_pages > 1) {
+    gst_fbdevsink_flip (fbdevsink, page);
+    gst_buffer_replace (&fbdevsink->front_buffer, NULL);
+  }
+
   return GST_FLOW_OK;
 }
 
@@ -309,6 +425,41 @@ gst_fbdevsink_start (GstBaseSink * bsink)
   if (ioctl (fbdevsink->fd, FBIOGET_VSCREENINFO, &fbdevsink->varinfo))
     return FALSE;
 
+  /* make the virtual screen twice as high as the visible one, to have a
+   * back buffer to pan to */
+  fbdevsink->orig_varinfo = fbdevsink->varinfo;
+  fbdevsink->varinfo_changed = FALSE;
+  if (fbdevsink->varinfo.yres_virtual < 2 * fbdevsink->varinfo.yres) {
+    fbdevsink->varinfo.yres_virtual = 2 * fbdevsink->varinfo.yres;
+    if (ioctl (fbdevsink->fd, FBIOPUT_VSCREENINFO, &fbdevsink->varinfo) == 0) {
+      fbdevsink->varinfo_changed = TRUE;
+      if (ioctl (fbdevsink->fd, FBIOGET_FSCREENINFO, &fbdevsink->fixinfo))
+        return FALSE;
+    } else {
+      GST_DEBUG_OBJECT (fbdevsink, "can't double the virtual height: %s",
+          g_strerror (errno));
+    }
+    if (ioctl (fbdevsink->fd, FBIOGET_VSCREENINFO, &fbdevsink->varinfo))
+      return FALSE;
+  }
+
+  fbdevsink->n_pages = 1;
+  if (fbdevsink->fixinfo.ypanstep > 0 &&
+      fbdevsink->varinfo.yres_virtual >= 2 * fbdevsink->varinfo.yres &&
+      fbdevsink->fixinfo.smem_len >=
+      2 * fbdevsink->varinfo.yres * fbdevsink->fixinfo.line_length)
+    fbdevsink->n_pages = 2;
+  GST_DEBUG_OBJECT (fbdevsink, "using %u pages", fbdevsink->n_pages);
+
+  fbdevsink->cur_page = fbdevsink->varinfo.yoffset / fbdevsink->varinfo.yres;
+  if (fbdevsink->cur_page >= fbdevsink->n_pages ||
+      fbdevsink->varinfo.yoffset % fbdevsink->varinfo.yres) {
+    fbdevsink->varinfo.yoffset = 0;
+    ioctl (fbdevsink->fd, FBIOPAN_DISPLAY, &fbdevsink->varinfo);
+    fbdevsink->cur_page = 0;
+  }
+  fbdevsink->wait_vsync = TRUE;
+
   /* map the framebuffer */
   fbdevsink->framebuffer = mmap (0, fbdevsink->fixinfo.smem_len,
       PROT_WRITE, MAP_SHARED, fbdevsink->fd, 0);
@@ -325,8 +476,27 @@ gst_fbdevsink_stop (GstBaseSink * bsink)
 
   fbdevsink = GST_FBDEVSINK (bsink);
 
-  if (munmap (fbdevsink->framebuffer, fbdevsink->fixinfo.smem_len))
-    return FALSE;
+  gst_buffer_replace (&fbdevsink->front_buffer, NULL);
+
+  if (fbdevsink->varinfo_changed) {
+    ioctl (fbdevsink->fd, FBIOPUT_VSCREENINFO, &fbdevsink->orig_varinfo);
+    fbdevsink->varinfo_changed = FALSE;
+  }
+
+  if (fbdevsink->pool) {
+    /* upstream may still hold buffers of the pool, the last of them unmaps
+     * the framebuffer */
+    gst_buffer_pool_set_active (fbdevsink->pool, FALSE);
+    gst_fbdev_buffer_pool_take_mapping (GST_FBDEV_BUFFER_POOL_CAST
+        (fbdevsink->pool));
+    gst_object_unref (fbdevsink->pool);
+    fbdevsink->pool = NULL;
+    fbdevsink->framebuffer = NULL;
+  } else {
+    if (munmap (fbdevsink->framebuffer, fbdevsink->fixinfo.smem_len))
+      return FALSE;
+    fbdevsink->framebuffer = NULL;
+  }
 
   if (close (fbdevsink->fd))
     return FALSE;
@@ -427,6 +597,8 @@ gst_fbdevsink_class_init (GstFBDEVSinkClass * klass)
 
   basesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_fbdevsink_setcaps);
   basesink_class->get_caps = GST_DEBUG_FUNCPTR (gst_fbdevsink_getcaps);
+  basesink_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_fbdevsink_propose_allocation);
 #if 0
   basesink_class->get_times = GST_DEBUG_FUNCPTR (gst_fbdevsink_get_times);
 #endif
@@ -49,6 +49,8 @@ struct _GstFBDEVSink {
   /*< private >*/
   struct fb_fix_screeninfo fixinfo;
   struct fb_var_screeninfo varinfo;
+  struct fb_var_screeninfo orig_varinfo;
+  gboolean varinfo_changed;
 
   int fd;
   unsigned char *framebuffer;
@@ -59,6 +61,15 @@ struct _GstFBDEVSink {
   int cx, cy, linelen, lines, bytespp;
 
   int fps_n, fps_d;
+
+  /* pages of the virtual screen the display pans between, the one on
+   * screen and, when double buffering, the one rendered to */
+  guint n_pages;
+  guint cur_page;
+  gboolean wait_vsync;
+
+  GstBufferPool *pool;
+  GstBuffer *front_buffer;
 };
 
 struct _GstFBDEVSinkClass {
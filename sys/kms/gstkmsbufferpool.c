@@ -28,6 +28,7 @@
 #endif
 
 #include <gst/video/gstvideometa.h>
+#include <gst/gstbufferpoolstats-private.h>
 
 #include "gstkmsbufferpool.h"
 #include "gstkmsallocator.h"
@@ -41,6 +42,8 @@ struct _GstKMSBufferPoolPrivate
   GstVideoInfo vinfo;
   GstAllocator *allocator;
   gboolean add_videometa;
+
+  GstBufferPoolStats stats;
 };
 
 #define parent_class gst_kms_buffer_pool_parent_class
@@ -158,6 +161,8 @@ gst_kms_buffer_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
         GST_VIDEO_INFO_N_PLANES (info), info->offset, info->stride);
   }
 
+  gst_buffer_pool_stats_allocated (&priv->stats);
+
   return GST_FLOW_OK;
 
   /* ERROR */
@@ -168,6 +173,36 @@ no_memory:
   }
 }
 
+static GstFlowReturn
+gst_kms_buffer_pool_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstKMSBufferPoolPrivate *priv = GST_KMS_BUFFER_POOL_CAST (pool)->priv;
+
+  return gst_buffer_pool_stats_acquire_buffer (&priv->stats,
+      GST_BUFFER_POOL_CLASS (parent_class), pool, buffer, params);
+}
+
+static void
+gst_kms_buffer_pool_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstKMSBufferPoolPrivate *priv = GST_KMS_BUFFER_POOL_CAST (pool)->priv;
+
+  gst_buffer_pool_stats_released (&priv->stats);
+
+  GST_BUFFER_POOL_CLASS (parent_class)->release_buffer (pool, buffer);
+}
+
+static gboolean
+gst_kms_buffer_pool_stop (GstBufferPool * pool)
+{
+  GstKMSBufferPoolPrivate *priv = GST_KMS_BUFFER_POOL_CAST (pool)->priv;
+
+  gst_buffer_pool_stats_log (&priv->stats, pool);
+
+  return GST_BUFFER_POOL_CLASS (parent_class)->stop (pool);
+}
+
 static void
 gst_kms_buffer_pool_finalize (GObject * object)
 {
@@ -180,6 +215,8 @@ gst_kms_buffer_pool_finalize (GObject * object)
   if (priv->allocator)
     gst_object_unref (priv->allocator);
 
+  gst_buffer_pool_stats_clear (&priv->stats);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -188,6 +225,7 @@ gst_kms_buffer_pool_init (GstKMSBufferPool * pool)
 {
   pool->priv = gst_kms_buffer_pool_get_instance_private (pool);
   pool->priv->fd = -1;
+  gst_buffer_pool_stats_init (&pool->priv->stats);
 }
 
 static void
@@ -204,6 +242,9 @@ gst_kms_buffer_pool_class_init (GstKMSBufferPoolClass * klass)
   gstbufferpool_class->get_options = gst_kms_buffer_pool_get_options;
   gstbufferpool_class->set_config = gst_kms_buffer_pool_set_config;
   gstbufferpool_class->alloc_buffer = gst_kms_buffer_pool_alloc_buffer;
+  gstbufferpool_class->acquire_buffer = gst_kms_buffer_pool_acquire_buffer;
+  gstbufferpool_class->release_buffer = gst_kms_buffer_pool_release_buffer;
+  gstbufferpool_class->stop = gst_kms_buffer_pool_stop;
 }
 
 GstBufferPool *
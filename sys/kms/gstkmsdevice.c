@@ -0,0 +1,206 @@
+/* GStreamer
+ *
+ * Copyright (C) 2016 Igalia
+ *
+ * Authors:
+ *  Víctor Manuel Jáquez Leal <vjaquez@igalia.com>
+ *  Javier Martin <javiermartin@by.com.es>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <xf86drm.h>
+
+#include "gstkmsdevice.h"
+
+#define GST_CAT_DEFAULT kmsdevice_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+static GMutex devices_lock;
+static GList *devices;
+
+static gint
+kms_open (gchar ** driver)
+{
+  static const char *drivers[] = { "i915", "radeon", "nouveau", "vmwgfx",
+    "exynos", "amdgpu", "imx-drm", "rockchip", "atmel-hlcdc", "msm",
+    "xilinx_drm",
+  };
+  int i, fd = -1;
+
+  for (i = 0; i < G_N_ELEMENTS (drivers); i++) {
+    fd = drmOpen (drivers[i], NULL);
+    if (fd >= 0) {
+      if (driver)
+        *driver = g_strdup (drivers[i]);
+      break;
+    }
+  }
+
+  return fd;
+}
+
+/**
+ * gst_kms_device_open:
+ * @name: (allow-none): the DRM driver name
+ *
+ * Returns the DRM device for @name, opening it if no other sink in the
+ * process is using it yet. When @name is %NULL, an already opened device
+ * is reused; otherwise the first one from an internal list of drivers is
+ * opened.
+ *
+ * Returns: (transfer full): the device or %NULL if it could not be opened.
+ */
+GstKMSDevice *
+gst_kms_device_open (const gchar * name)
+{
+  GstKMSDevice *device = NULL;
+  gchar *driver = NULL;
+  GList *l;
+  gint fd;
+
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "kmsdevice", 0, "KMS device");
+
+  g_mutex_lock (&devices_lock);
+  for (l = devices; l; l = l->next) {
+    GstKMSDevice *d = l->data;
+
+    if (!name || g_strcmp0 (name, d->name) == 0) {
+      device = d;
+      device->refcount++;
+      GST_DEBUG ("reusing DRM device %s (fd %d)", device->name, device->fd);
+      goto done;
+    }
+  }
+
+  if (name) {
+    fd = drmOpen (name, NULL);
+    driver = g_strdup (name);
+  } else {
+    fd = kms_open (&driver);
+  }
+  if (fd < 0) {
+    g_free (driver);
+    goto done;
+  }
+
+  device = g_slice_new0 (GstKMSDevice);
+  device->name = driver;
+  device->fd = fd;
+  device->refcount = 1;
+  g_mutex_init (&device->lock);
+  g_cond_init (&device->cond);
+
+  devices = g_list_prepend (devices, device);
+  GST_DEBUG ("opened DRM device %s (fd %d)", device->name, device->fd);
+
+done:
+  g_mutex_unlock (&devices_lock);
+
+  return device;
+}
+
+/**
+ * gst_kms_device_close:
+ * @device: a #GstKMSDevice
+ *
+ * Drops a reference on @device, closing it once no sink uses it anymore.
+ */
+void
+gst_kms_device_close (GstKMSDevice * device)
+{
+  g_mutex_lock (&devices_lock);
+  if (--device->refcount > 0) {
+    g_mutex_unlock (&devices_lock);
+    return;
+  }
+  devices = g_list_remove (devices, device);
+  g_mutex_unlock (&devices_lock);
+
+  GST_DEBUG ("closing DRM device %s (fd %d)", device->name, device->fd);
+
+  drmClose (device->fd);
+  g_list_free (device->planes);
+  g_mutex_clear (&device->lock);
+  g_cond_clear (&device->cond);
+  g_free (device->name);
+  g_slice_free (GstKMSDevice, device);
+}
+
+/**
+ * gst_kms_device_claim_plane:
+ * @device: a #GstKMSDevice
+ * @plane_id: a DRM plane id
+ *
+ * Marks @plane_id as used by the calling sink, so that other sinks on the
+ * same device compose on other planes.
+ *
+ * Returns: %FALSE if the plane is already used by another sink.
+ */
+gboolean
+gst_kms_device_claim_plane (GstKMSDevice * device, guint32 plane_id)
+{
+  gboolean ret = FALSE;
+
+  g_mutex_lock (&device->lock);
+  if (!g_list_find (device->planes, GUINT_TO_POINTER (plane_id))) {
+    device->planes = g_list_prepend (device->planes,
+        GUINT_TO_POINTER (plane_id));
+    ret = TRUE;
+  }
+  g_mutex_unlock (&device->lock);
+
+  return ret;
+}
+
+/**
+ * gst_kms_device_release_plane:
+ * @device: a #GstKMSDevice
+ * @plane_id: a DRM plane id
+ *
+ * Makes @plane_id available again to other sinks.
+ */
+void
+gst_kms_device_release_plane (GstKMSDevice * device, guint32 plane_id)
+{
+  g_mutex_lock (&device->lock);
+  device->planes = g_list_remove (device->planes, GUINT_TO_POINTER (plane_id));
+  g_mutex_unlock (&device->lock);
+}
+
+/**
+ * gst_kms_device_is_plane_claimed:
+ * @device: a #GstKMSDevice
+ * @plane_id: a DRM plane id
+ *
+ * Returns: whether @plane_id is used by a sink.
+ */
+gboolean
+gst_kms_device_is_plane_claimed (GstKMSDevice * device, guint32 plane_id)
+{
+  gboolean ret;
+
+  g_mutex_lock (&device->lock);
+  ret = g_list_find (device->planes, GUINT_TO_POINTER (plane_id)) != NULL;
+  g_mutex_unlock (&device->lock);
+
+  return ret;
+}
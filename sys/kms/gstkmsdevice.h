@@ -0,0 +1,65 @@
+/* GStreamer
+ *
+ * Copyright (C) 2016 Igalia
+ *
+ * Authors:
+ *  Víctor Manuel Jáquez Leal <vjaquez@igalia.com>
+ *  Javier Martin <javiermartin@by.com.es>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef __GST_KMS_DEVICE_H__
+#define __GST_KMS_DEVICE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstKMSDevice GstKMSDevice;
+
+/* A DRM device opened once per process and shared by every sink using it:
+ * only the DRM master can program planes, so several sinks composing on
+ * different planes of the same display have to use the same file
+ * descriptor. */
+struct _GstKMSDevice
+{
+  gchar *name;
+  gint fd;
+
+  /*< private >*/
+  gint refcount;
+  GList *planes;                /* plane ids claimed by a sink */
+
+  /* serializes the reading of DRM events on fd */
+  GMutex lock;
+  GCond cond;
+  gboolean reading;
+};
+
+GstKMSDevice * gst_kms_device_open          (const gchar * name);
+void           gst_kms_device_close         (GstKMSDevice * device);
+gboolean       gst_kms_device_claim_plane   (GstKMSDevice * device,
+                                             guint32 plane_id);
+void           gst_kms_device_release_plane (GstKMSDevice * device,
+                                             guint32 plane_id);
+gboolean       gst_kms_device_is_plane_claimed (GstKMSDevice * device,
+                                             guint32 plane_id);
+
+G_END_DECLS
+
+#endif /* __GST_KMS_DEVICE_H__ */
@@ -31,10 +31,21 @@
  * kmssink is a simple video sink that renders video frames directly
  * in a plane of a DRM device.
  *
+ * When the driver supports atomic modesetting, frames are committed to the
+ * plane without waiting for the vertical blank: the sink only blocks when
+ * the previous frame has not reached the screen yet.
+ *
+ * Several kmssink instances in the same process can compose on different
+ * planes of the same display, each one scaled by the display controller to
+ * its #GstVideoOverlay render rectangle.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 videotestsrc ! kmssink
  * ]|
+ * |[
+ * gst-launch-1.0 videotestsrc ! kmssink videotestsrc pattern=ball ! kmssink
+ * ]| Displays both streams on two different planes.
  *
  */
 
@@ -51,13 +62,19 @@
 #include <xf86drmMode.h>
 #include <drm_fourcc.h>
 
+#include <errno.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include "gstkmssink.h"
 #include "gstkmsutils.h"
 #include "gstkmsbufferpool.h"
 #include "gstkmsallocator.h"
 
+#if defined (DRM_CLIENT_CAP_ATOMIC) && defined (DRM_MODE_ATOMIC_NONBLOCK)
+#define HAVE_DRM_ATOMIC 1
+#endif
+
 #define GST_PLUGIN_NAME "kmssink"
 #define GST_PLUGIN_DESC "Video sink using the Linux kernel mode setting API"
 
@@ -78,6 +95,7 @@ G_DEFINE_TYPE_WITH_CODE (GstKMSSink, gst_kms_sink, GST_TYPE_VIDEO_SINK,
         gst_kms_sink_video_overlay_init));
 
 static void gst_kms_sink_drain (GstKMSSink * self);
+static void gst_kms_sink_flush_pending (GstKMSSink * self);
 
 enum
 {
@@ -163,30 +181,9 @@ gst_kms_sink_video_overlay_init (GstVideoOverlayInterface * iface)
   iface->set_render_rectangle = gst_kms_sink_set_render_rectangle;
 }
 
-static int
-kms_open (gchar ** driver)
-{
-  static const char *drivers[] = { "i915", "radeon", "nouveau", "vmwgfx",
-    "exynos", "amdgpu", "imx-drm", "rockchip", "atmel-hlcdc", "msm",
-    "xilinx_drm",
-  };
-  int i, fd = -1;
-
-  for (i = 0; i < G_N_ELEMENTS (drivers); i++) {
-    fd = drmOpen (drivers[i], NULL);
-    if (fd >= 0) {
-      if (driver)
-        *driver = g_strdup (drivers[i]);
-      break;
-    }
-  }
-
-  return fd;
-}
-
 static drmModePlane *
-find_plane_for_crtc (int fd, drmModeRes * res, drmModePlaneRes * pres,
-    int crtc_id)
+find_plane_for_crtc (GstKMSDevice * device, drmModeRes * res,
+    drmModePlaneRes * pres, int crtc_id)
 {
   drmModePlane *plane;
   int i, pipe;
@@ -204,7 +201,10 @@ find_plane_for_crtc (int fd, drmModeRes * res, drmModePlaneRes * pres,
     return NULL;
 
   for (i = 0; i < pres->count_planes; i++) {
-    plane = drmModeGetPlane (fd, pres->planes[i]);
+    /* leave the planes used by other sinks alone */
+    if (gst_kms_device_is_plane_claimed (device, pres->planes[i]))
+      continue;
+    plane = drmModeGetPlane (device->fd, pres->planes[i]);
     if (plane->possible_crtcs & (1 << pipe))
       return plane;
     drmModeFreePlane (plane);
@@ -403,6 +403,85 @@ get_drm_caps (GstKMSSink * self)
   return TRUE;
 }
 
+#ifdef HAVE_DRM_ATOMIC
+static gboolean
+get_plane_properties (GstKMSSink * self)
+{
+  static const struct
+  {
+    const gchar *name;
+    gsize offset;
+  } prop_names[] = {
+    {"FB_ID", G_STRUCT_OFFSET (GstKMSSink, plane_props.fb_id)},
+    {"CRTC_ID", G_STRUCT_OFFSET (GstKMSSink, plane_props.crtc_id)},
+    {"SRC_X", G_STRUCT_OFFSET (GstKMSSink, plane_props.src_x)},
+    {"SRC_Y", G_STRUCT_OFFSET (GstKMSSink, plane_props.src_y)},
+    {"SRC_W", G_STRUCT_OFFSET (GstKMSSink, plane_props.src_w)},
+    {"SRC_H", G_STRUCT_OFFSET (GstKMSSink, plane_props.src_h)},
+    {"CRTC_X", G_STRUCT_OFFSET (GstKMSSink, plane_props.crtc_x)},
+    {"CRTC_Y", G_STRUCT_OFFSET (GstKMSSink, plane_props.crtc_y)},
+    {"CRTC_W", G_STRUCT_OFFSET (GstKMSSink, plane_props.crtc_w)},
+    {"CRTC_H", G_STRUCT_OFFSET (GstKMSSink, plane_props.crtc_h)},
+  };
+  drmModeObjectProperties *props;
+  drmModePropertyRes *prop;
+  guint i, j, found;
+
+  props = drmModeObjectGetProperties (self->fd, self->plane_id,
+      DRM_MODE_OBJECT_PLANE);
+  if (!props)
+    return FALSE;
+
+  found = 0;
+  memset (&self->plane_props, 0, sizeof (self->plane_props));
+  for (i = 0; i < props->count_props; i++) {
+    prop = drmModeGetProperty (self->fd, props->props[i]);
+    if (!prop)
+      continue;
+    for (j = 0; j < G_N_ELEMENTS (prop_names); j++) {
+      if (strcmp (prop->name, prop_names[j].name) == 0) {
+        G_STRUCT_MEMBER (guint32, self, prop_names[j].offset) = prop->prop_id;
+        found++;
+        break;
+      }
+    }
+    drmModeFreeProperty (prop);
+  }
+  drmModeFreeObjectProperties (props);
+
+  return found == G_N_ELEMENTS (prop_names);
+}
+#endif
+
+static void
+ensure_atomic (GstKMSSink * self)
+{
+  self->has_atomic = FALSE;
+
+#ifdef HAVE_DRM_ATOMIC
+  /* the mode is programmed with the legacy API for the time being */
+  if (self->modesetting_enabled)
+    goto done;
+
+  if (drmSetClientCap (self->fd, DRM_CLIENT_CAP_ATOMIC, 1)) {
+    GST_DEBUG_OBJECT (self, "driver does not support atomic modesetting");
+    goto done;
+  }
+
+  if (!get_plane_properties (self)) {
+    GST_WARNING_OBJECT (self, "could not get the atomic properties of plane "
+        "%d", self->plane_id);
+    goto done;
+  }
+
+  self->has_atomic = TRUE;
+
+done:
+#endif
+  GST_INFO_OBJECT (self, "atomic modesetting (%s)",
+      self->has_atomic ? "✓" : "✗");
+}
+
 static gboolean
 configure_mode_setting (GstKMSSink * self, GstVideoInfo * vinfo)
 {
@@ -583,10 +662,114 @@ cached_kmsmem_disposed_cb (GstKMSSink * self, GstMiniObject * obj)
   GST_OBJECT_UNLOCK (self);
 }
 
+/* number of dmabuf framebuffers kept around once the memories they were
+ * imported from are gone, enough for the pools of common decoders */
+#define FB_CACHE_SIZE 32
+
+typedef struct
+{
+  guint n_planes;
+  GstVideoFormat format;
+  gint width, height;
+  dev_t dev[GST_VIDEO_MAX_PLANES];
+  ino_t ino[GST_VIDEO_MAX_PLANES];
+  gsize offset[GST_VIDEO_MAX_PLANES];
+  gint stride[GST_VIDEO_MAX_PLANES];
+} DmabufKey;
+
+typedef struct
+{
+  DmabufKey key;
+  GstMemory *kmsmem;
+} FbCacheEntry;
+
+static void
+fb_cache_entry_free (FbCacheEntry * entry)
+{
+  gst_memory_unref (entry->kmsmem);
+  g_slice_free (FbCacheEntry, entry);
+}
+
+/* A dmabuf is identified by the inode behind its fd, which stays the same
+ * whichever fd or GstMemory it is handed in with. The cached framebuffer
+ * holds a reference on the dmabuf, so the inode cannot be reused for
+ * another buffer while the entry exists. */
+static gboolean
+get_dmabuf_key (GstKMSSink * self, gint * prime_fds, guint n_planes,
+    gsize * offsets, DmabufKey * key)
+{
+  struct stat st;
+  guint i;
+
+  memset (key, 0, sizeof (*key));
+  key->n_planes = n_planes;
+  key->format = GST_VIDEO_INFO_FORMAT (&self->vinfo);
+  key->width = GST_VIDEO_INFO_WIDTH (&self->vinfo);
+  key->height = GST_VIDEO_INFO_HEIGHT (&self->vinfo);
+
+  for (i = 0; i < n_planes; i++) {
+    if (fstat (prime_fds[i], &st) < 0)
+      return FALSE;
+    key->dev[i] = st.st_dev;
+    key->ino[i] = st.st_ino;
+    key->offset[i] = offsets[i];
+    key->stride[i] = GST_VIDEO_INFO_PLANE_STRIDE (&self->vinfo, i);
+  }
+
+  return TRUE;
+}
+
+static GstMemory *
+lookup_cached_fb (GstKMSSink * self, const DmabufKey * key)
+{
+  GList *iter;
+  GstMemory *kmsmem = NULL;
+
+  GST_OBJECT_LOCK (self);
+  for (iter = self->fb_cache.head; iter; iter = iter->next) {
+    FbCacheEntry *entry = iter->data;
+
+    if (memcmp (&entry->key, key, sizeof (*key)) == 0) {
+      g_queue_unlink (&self->fb_cache, iter);
+      g_queue_push_head_link (&self->fb_cache, iter);
+      kmsmem = gst_memory_ref (entry->kmsmem);
+      break;
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  return kmsmem;
+}
+
+static void
+add_cached_fb (GstKMSSink * self, const DmabufKey * key, GstMemory * kmsmem)
+{
+  FbCacheEntry *entry;
+
+  entry = g_slice_new (FbCacheEntry);
+  entry->key = *key;
+  entry->kmsmem = gst_memory_ref (kmsmem);
+
+  GST_OBJECT_LOCK (self);
+  g_queue_push_head (&self->fb_cache, entry);
+  if (self->fb_cache.length > FB_CACHE_SIZE)
+    entry = g_queue_pop_tail (&self->fb_cache);
+  else
+    entry = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (entry) {
+    GST_LOG_OBJECT (self, "evicting fb id %d from the cache",
+        ((GstKMSMemory *) entry->kmsmem)->fb_id);
+    fb_cache_entry_free (entry);
+  }
+}
+
 static void
 clear_cached_kmsmem (GstKMSSink * self)
 {
   GList *iter;
+  GQueue fb_cache;
 
   GST_OBJECT_LOCK (self);
 
@@ -603,7 +786,14 @@ clear_cached_kmsmem (GstKMSSink * self)
   g_list_free (self->mem_cache);
   self->mem_cache = NULL;
 
+  /* the framebuffers keep the upstream dmabufs alive, drop them too */
+  fb_cache = self->fb_cache;
+  g_queue_init (&self->fb_cache);
+
   GST_OBJECT_UNLOCK (self);
+
+  g_queue_foreach (&fb_cache, (GFunc) fb_cache_entry_free, NULL);
+  g_queue_clear (&fb_cache);
 }
 
 static void
@@ -641,12 +831,12 @@ gst_kms_sink_start (GstBaseSink * bsink)
   pres = NULL;
   plane = NULL;
 
-  if (self->devname)
-    self->fd = drmOpen (self->devname, NULL);
-  else
-    self->fd = kms_open (&self->devname);
-  if (self->fd < 0)
+  self->device = gst_kms_device_open (self->devname);
+  if (!self->device)
     goto open_failed;
+  self->fd = self->device->fd;
+  if (!self->devname)
+    self->devname = g_strdup (self->device->name);
 
   log_drm_version (self);
   if (!get_drm_caps (self))
@@ -685,7 +875,7 @@ retry_find_plane:
     goto plane_resources_failed;
 
   if (self->plane_id == -1)
-    plane = find_plane_for_crtc (self->fd, res, pres, crtc->crtc_id);
+    plane = find_plane_for_crtc (self->device, res, pres, crtc->crtc_id);
   else
     plane = drmModeGetPlane (self->fd, self->plane_id);
   if (!plane)
@@ -694,10 +884,19 @@ retry_find_plane:
   if (!ensure_allowed_caps (self, conn, plane, res))
     goto allowed_caps_failed;
 
+  /* the primary plane is programmed through the crtc when modesetting */
+  if (!self->modesetting_enabled) {
+    if (!gst_kms_device_claim_plane (self->device, plane->plane_id))
+      goto plane_busy;
+    self->plane_claimed = TRUE;
+  }
+
   self->conn_id = conn->connector_id;
   self->crtc_id = crtc->crtc_id;
   self->plane_id = plane->plane_id;
 
+  ensure_atomic (self);
+
   GST_INFO_OBJECT (self, "connector id = %d / crtc id = %d / plane id = %d",
       self->conn_id, self->crtc_id, self->plane_id);
 
@@ -729,8 +928,9 @@ bail:
   if (res)
     drmModeFreeResources (res);
 
-  if (!ret && self->fd >= 0) {
-    drmClose (self->fd);
+  if (!ret && self->device) {
+    gst_kms_device_close (self->device);
+    self->device = NULL;
     self->fd = -1;
   }
 
@@ -794,6 +994,13 @@ plane_failed:
     }
   }
 
+plane_busy:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, BUSY,
+        ("Plane %d is already used by another sink", plane->plane_id), (NULL));
+    goto bail;
+  }
+
 allowed_caps_failed:
   {
     GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
@@ -810,6 +1017,9 @@ gst_kms_sink_stop (GstBaseSink * bsink)
 
   self = GST_KMS_SINK (bsink);
 
+  /* the last committed frame has to be scanned out before releasing it */
+  gst_kms_sink_flush_pending (self);
+
   clear_cached_kmsmem (self);
 
   gst_buffer_replace (&self->last_buffer, NULL);
@@ -821,8 +1031,14 @@ gst_kms_sink_stop (GstBaseSink * bsink)
   gst_poll_restart (self->poll);
   gst_poll_fd_init (&self->pollfd);
 
-  if (self->fd >= 0) {
-    drmClose (self->fd);
+  if (self->plane_claimed) {
+    gst_kms_device_release_plane (self->device, self->plane_id);
+    self->plane_claimed = FALSE;
+  }
+
+  if (self->device) {
+    gst_kms_device_close (self->device);
+    self->device = NULL;
     self->fd = -1;
   }
 
@@ -1118,27 +1334,106 @@ no_pool:
 static void
 sync_handler (gint fd, guint frame, guint sec, guint usec, gpointer data)
 {
-  gboolean *waiting;
+  GstKMSSink *self;
 
-  waiting = data;
-  *waiting = FALSE;
+  /* the device is shared, so this can be dispatched from another sink */
+  self = data;
+  g_mutex_lock (&self->device->lock);
+  self->flip_pending = FALSE;
+  g_mutex_unlock (&self->device->lock);
 }
 
+/* Waits until the frame last submitted by this sink is on screen. Only one
+ * sink at a time reads the events of the device, dispatching them to their
+ * owners, whereas the others wait for it to finish. */
 static gboolean
-gst_kms_sink_sync (GstKMSSink * self)
+gst_kms_sink_wait_flip (GstKMSSink * self)
 {
+  GstKMSDevice *device;
   gint ret;
-  gboolean waiting;
+  gboolean res, failed;
   drmEventContext evctxt = {
     .version = DRM_EVENT_CONTEXT_VERSION,
     .page_flip_handler = sync_handler,
     .vblank_handler = sync_handler,
   };
+
+  device = self->device;
+  res = TRUE;
+
+  g_mutex_lock (&device->lock);
+  while (self->flip_pending) {
+    if (device->reading) {
+      g_cond_wait (&device->cond, &device->lock);
+      continue;
+    }
+    device->reading = TRUE;
+    g_mutex_unlock (&device->lock);
+
+    do {
+      ret = gst_poll_wait (self->poll, 3 * GST_SECOND);
+    } while (ret == -1 && (errno == EAGAIN || errno == EINTR));
+
+    failed = TRUE;
+    if (ret == -1) {
+      GST_WARNING_OBJECT (self, "poll failed: %s (%d)", strerror (errno),
+          errno);
+    } else if (ret == 0) {
+      GST_WARNING_OBJECT (self, "timeout waiting for the vertical blank");
+    } else if ((ret = drmHandleEvent (self->fd, &evctxt))) {
+      GST_ERROR_OBJECT (self, "drmHandleEvent failed: %s (%d)",
+          strerror (-ret), ret);
+    } else {
+      failed = FALSE;
+    }
+
+    g_mutex_lock (&device->lock);
+    device->reading = FALSE;
+    g_cond_broadcast (&device->cond);
+    if (failed) {
+      self->flip_pending = FALSE;
+      res = FALSE;
+    }
+  }
+  g_mutex_unlock (&device->lock);
+
+  return res;
+}
+
+static void
+gst_kms_sink_set_flip_pending (GstKMSSink * self, gboolean pending)
+{
+  g_mutex_lock (&self->device->lock);
+  self->flip_pending = pending;
+  g_mutex_unlock (&self->device->lock);
+}
+
+/* Waits for the frame committed by the previous call to show_frame() to be
+ * scanned out, so that it becomes the last buffer */
+static void
+gst_kms_sink_flush_pending (GstKMSSink * self)
+{
+  if (!self->device)
+    return;
+
+  if (!gst_kms_sink_wait_flip (self))
+    GST_WARNING_OBJECT (self, "page flip of the previous frame failed");
+
+  if (self->pending_buffer) {
+    gst_buffer_replace (&self->last_buffer, self->pending_buffer);
+    gst_buffer_replace (&self->pending_buffer, NULL);
+  }
+}
+
+static gboolean
+gst_kms_sink_sync (GstKMSSink * self)
+{
+  gint ret;
   drmVBlank vbl = {
     .request = {
           .type = DRM_VBLANK_RELATIVE | DRM_VBLANK_EVENT,
           .sequence = 1,
-          .signal = (gulong) & waiting,
+          .signal = (gulong) self,
         },
   };
 
@@ -1147,51 +1442,85 @@ gst_kms_sink_sync (GstKMSSink * self)
   else if (self->pipe > 1)
     vbl.request.type |= self->pipe << DRM_VBLANK_HIGH_CRTC_SHIFT;
 
-  waiting = TRUE;
+  gst_kms_sink_set_flip_pending (self, TRUE);
   if (!self->has_async_page_flip && !self->modesetting_enabled) {
     ret = drmWaitVBlank (self->fd, &vbl);
     if (ret)
       goto vblank_failed;
   } else {
     ret = drmModePageFlip (self->fd, self->crtc_id, self->buffer_id,
-        DRM_MODE_PAGE_FLIP_EVENT, &waiting);
+        DRM_MODE_PAGE_FLIP_EVENT, self);
     if (ret)
       goto pageflip_failed;
   }
 
-  while (waiting) {
-    do {
-      ret = gst_poll_wait (self->poll, 3 * GST_SECOND);
-    } while (ret == -1 && (errno == EAGAIN || errno == EINTR));
-
-    ret = drmHandleEvent (self->fd, &evctxt);
-    if (ret)
-      goto event_failed;
-  }
-
-  return TRUE;
+  return gst_kms_sink_wait_flip (self);
 
   /* ERRORS */
 vblank_failed:
   {
+    gst_kms_sink_set_flip_pending (self, FALSE);
     GST_WARNING_OBJECT (self, "drmWaitVBlank failed: %s (%d)", strerror (-ret),
         ret);
     return FALSE;
   }
 pageflip_failed:
   {
+    gst_kms_sink_set_flip_pending (self, FALSE);
     GST_WARNING_OBJECT (self, "drmModePageFlip failed: %s (%d)",
         strerror (-ret), ret);
     return FALSE;
   }
-event_failed:
-  {
-    GST_ERROR_OBJECT (self, "drmHandleEvent failed: %s (%d)", strerror (-ret),
-        ret);
-    return FALSE;
-  }
 }
 
+#ifdef HAVE_DRM_ATOMIC
+/* Commits @fb_id to the plane without waiting for it to be on screen: the
+ * page flip event is handled by the next call to gst_kms_sink_wait_flip() */
+static gint
+gst_kms_sink_atomic_commit (GstKMSSink * self, guint32 fb_id,
+    GstVideoRectangle * src, GstVideoRectangle * dst)
+{
+  drmModeAtomicReq *req;
+  gint ret;
+
+  req = drmModeAtomicAlloc ();
+  if (!req)
+    return -ENOMEM;
+
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.fb_id,
+      fb_id);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.crtc_id,
+      self->crtc_id);
+  /* source/cropping coordinates are given in Q16 */
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.src_x,
+      (guint64) src->x << 16);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.src_y,
+      (guint64) src->y << 16);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.src_w,
+      (guint64) src->w << 16);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.src_h,
+      (guint64) src->h << 16);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.crtc_x,
+      dst->x);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.crtc_y,
+      dst->y);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.crtc_w,
+      dst->w);
+  drmModeAtomicAddProperty (req, self->plane_id, self->plane_props.crtc_h,
+      dst->h);
+
+  gst_kms_sink_set_flip_pending (self, TRUE);
+  ret = drmModeAtomicCommit (self->fd, req,
+      DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, self);
+  if (ret)
+    gst_kms_sink_set_flip_pending (self, FALSE);
+
+  drmModeAtomicFree (req);
+
+  return ret;
+}
+#endif
+
 static gboolean
 gst_kms_sink_import_dmabuf (GstKMSSink * self, GstBuffer * inbuf,
     GstBuffer ** outbuf)
@@ -1200,6 +1529,8 @@ gst_kms_sink_import_dmabuf (GstKMSSink * self, GstBuffer * inbuf,
   GstVideoMeta *meta;
   guint i, n_mem, n_planes;
   GstKMSMemory *kmsmem;
+  DmabufKey key;
+  gboolean have_key;
   guint mems_idx[GST_VIDEO_MAX_PLANES];
   gsize mems_skip[GST_VIDEO_MAX_PLANES];
   GstMemory *mems[GST_VIDEO_MAX_PLANES];
@@ -1267,11 +1598,27 @@ gst_kms_sink_import_dmabuf (GstKMSSink * self, GstBuffer * inbuf,
   GST_LOG_OBJECT (self, "found these prime ids: %d, %d, %d, %d", prime_fds[0],
       prime_fds[1], prime_fds[2], prime_fds[3]);
 
+  /* the same dmabuf may come back wrapped in a new memory, check for a
+   * framebuffer of it before importing it again */
+  have_key = get_dmabuf_key (self, prime_fds, n_planes, mems_skip, &key);
+  if (have_key) {
+    kmsmem = (GstKMSMemory *) lookup_cached_fb (self, &key);
+    if (kmsmem) {
+      GST_LOG_OBJECT (self, "found fb id = %d for the dmabuf of DMABuf mem %p",
+          kmsmem->fb_id, mems[0]);
+      goto cache_mem;
+    }
+  }
+
   kmsmem = gst_kms_allocator_dmabuf_import (self->allocator, prime_fds,
       n_planes, mems_skip, &self->vinfo);
   if (!kmsmem)
     return FALSE;
 
+  if (have_key)
+    add_cached_fb (self, &key, GST_MEMORY_CAST (kmsmem));
+
+cache_mem:
   GST_LOG_OBJECT (self, "setting KMS mem %p to DMABuf mem %p with fb id = %d",
       kmsmem, mems[0], kmsmem->fb_id);
   set_cached_kmsmem (self, mems[0], GST_MEMORY_CAST (kmsmem));
@@ -1393,6 +1740,9 @@ gst_kms_sink_show_frame (GstVideoSink * vsink, GstBuffer * buf)
 
   buffer = NULL;
 
+  /* only one frame can be queued for the next vertical blank */
+  gst_kms_sink_flush_pending (self);
+
   if (buf)
     buffer = gst_kms_sink_get_input_buffer (self, buf);
   else if (self->last_buffer)
@@ -1460,13 +1810,19 @@ retry_set_plane:
   }
 
   GST_TRACE_OBJECT (self,
-      "drmModeSetPlane at (%i,%i) %ix%i sourcing at (%i,%i) %ix%i",
+      "%s at (%i,%i) %ix%i sourcing at (%i,%i) %ix%i",
+      self->has_atomic ? "drmModeAtomicCommit" : "drmModeSetPlane",
       result.x, result.y, result.w, result.h, src.x, src.y, src.w, src.h);
 
-  ret = drmModeSetPlane (self->fd, self->plane_id, self->crtc_id, fb_id, 0,
-      result.x, result.y, result.w, result.h,
-      /* source/cropping coordinates are given in Q16 */
-      src.x << 16, src.y << 16, src.w << 16, src.h << 16);
+#ifdef HAVE_DRM_ATOMIC
+  if (self->has_atomic)
+    ret = gst_kms_sink_atomic_commit (self, fb_id, &src, &result);
+  else
+#endif
+    ret = drmModeSetPlane (self->fd, self->plane_id, self->crtc_id, fb_id, 0,
+        result.x, result.y, result.w, result.h,
+        /* source/cropping coordinates are given in Q16 */
+        src.x << 16, src.y << 16, src.w << 16, src.h << 16);
   if (ret) {
     if (self->can_scale) {
       self->can_scale = FALSE;
@@ -1475,13 +1831,22 @@ retry_set_plane:
     goto set_plane_failed;
   }
 
+  /* the frame goes on screen at the next vertical blank, without blocking
+   * the streaming thread until then */
+  if (self->has_atomic) {
+    gst_buffer_replace (&self->pending_buffer, buffer);
+    goto done;
+  }
+
 sync_frame:
   /* Wait for the previous frame to complete redraw */
   if (!gst_kms_sink_sync (self))
-    goto bail;
+    goto sync_failed;
 
   if (buffer != self->last_buffer)
     gst_buffer_replace (&self->last_buffer, buffer);
+
+done:
   g_clear_pointer (&self->tmp_kmsmem, gst_memory_unref);
 
   GST_OBJECT_UNLOCK (self);
@@ -1505,7 +1870,14 @@ set_plane_failed:
         result.w, result.h, src.x, src.y, src.w, src.h, dst.x, dst.y, dst.w,
         dst.h);
     GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
-        (NULL), ("drmModeSetPlane failed: %s (%d)", strerror (-ret), ret));
+        (NULL), ("%s failed: %s (%d)",
+            self->has_atomic ? "drmModeAtomicCommit" : "drmModeSetPlane",
+            strerror (-ret), ret));
+    goto bail;
+  }
+sync_failed:
+  {
+    GST_OBJECT_UNLOCK (self);
     goto bail;
   }
 no_disp_ratio:
@@ -1524,6 +1896,8 @@ gst_kms_sink_drain (GstKMSSink * self)
 
   GST_DEBUG_OBJECT (self, "draining");
 
+  gst_kms_sink_flush_pending (self);
+
   if (!self->last_buffer)
     return;
 
@@ -1634,6 +2008,7 @@ gst_kms_sink_init (GstKMSSink * sink)
   gst_poll_fd_init (&sink->pollfd);
   sink->poll = gst_poll_new (TRUE);
   gst_video_info_init (&sink->vinfo);
+  g_queue_init (&sink->fb_cache);
 }
 
 static void
@@ -28,6 +28,8 @@
 
 #include <gst/video/gstvideosink.h>
 
+#include "gstkmsdevice.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_KMS_SINK \
@@ -48,6 +50,7 @@ struct _GstKMSSink {
   GstVideoSink videosink;
 
   /*< private >*/
+  GstKMSDevice *device;
   gint fd;
   gint conn_id;
   gint crtc_id;
@@ -62,6 +65,16 @@ struct _GstKMSSink {
   gboolean has_prime_import;
   gboolean has_async_page_flip;
   gboolean can_scale;
+  gboolean has_atomic;
+
+  /* atomic property ids of the plane */
+  struct {
+    guint32 fb_id;
+    guint32 crtc_id;
+    guint32 src_x, src_y, src_w, src_h;
+    guint32 crtc_x, crtc_y, crtc_w, crtc_h;
+  } plane_props;
+  gboolean plane_claimed;
 
   gboolean modesetting_enabled;
 
@@ -70,8 +83,14 @@ struct _GstKMSSink {
   GstBufferPool *pool;
   GstAllocator *allocator;
   GstBuffer *last_buffer;
+  /* committed, but not on screen until the next page flip event */
+  GstBuffer *pending_buffer;
+  gboolean flip_pending;
   GstMemory *tmp_kmsmem;
   GList *mem_cache;
+  /* framebuffers of imported dmabufs by dmabuf identity, most recently
+   * used first, for upstream wrapping the same dmabufs in new memories */
+  GQueue fb_cache;
 
   gchar *devname;
 
@@ -43,6 +43,7 @@
 #include "gstmsdkmjpegenc.h"
 #include "gstmsdkmpeg2enc.h"
 #include "gstmsdkvp8enc.h"
+#include "gstmsdkvpp.h"
 
 GST_DEBUG_CATEGORY (gst_msdkdec_debug);
 GST_DEBUG_CATEGORY (gst_msdkenc_debug);
@@ -54,6 +55,7 @@ GST_DEBUG_CATEGORY (gst_msdkmjpegdec_debug);
 GST_DEBUG_CATEGORY (gst_msdkmjpegenc_debug);
 GST_DEBUG_CATEGORY (gst_msdkmpeg2enc_debug);
 GST_DEBUG_CATEGORY (gst_msdkvp8enc_debug);
+GST_DEBUG_CATEGORY (gst_msdkvpp_debug);
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -77,6 +79,7 @@ plugin_init (GstPlugin * plugin)
   GST_DEBUG_CATEGORY_INIT (gst_msdkmpeg2enc_debug, "msdkmpeg2enc", 0,
       "msdkmpeg2enc");
   GST_DEBUG_CATEGORY_INIT (gst_msdkvp8enc_debug, "msdkvp8enc", 0, "msdkvp8enc");
+  GST_DEBUG_CATEGORY_INIT (gst_msdkvpp_debug, "msdkvpp", 0, "msdkvpp");
 
 
   if (!msdk_is_available ())
@@ -106,6 +109,9 @@ plugin_init (GstPlugin * plugin)
   ret = gst_element_register (plugin, "msdkvp8enc", GST_RANK_NONE,
       GST_TYPE_MSDKVP8ENC);
 
+  ret = gst_element_register (plugin, "msdkvpp", GST_RANK_NONE,
+      GST_TYPE_MSDKVPP);
+
   return ret;
 }
 
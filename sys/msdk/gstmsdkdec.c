@@ -36,6 +36,7 @@
 #include <stdlib.h>
 
 #include "gstmsdkdec.h"
+#include "gstmsdkmemory.h"
 
 GST_DEBUG_CATEGORY_EXTERN (gst_msdkdec_debug);
 #define GST_CAT_DEFAULT gst_msdkdec_debug
@@ -43,7 +44,12 @@ GST_DEBUG_CATEGORY_EXTERN (gst_msdkdec_debug);
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("video/x-raw, "
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE "), "
+        "format = (string) { NV12 }, "
+        "framerate = (fraction) [0, MAX], "
+        "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ],"
+        "interlace-mode = (string) progressive; "
+        "video/x-raw, "
         "format = (string) { NV12 }, "
         "framerate = (fraction) [0, MAX], "
         "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ],"
@@ -68,6 +74,8 @@ typedef struct _MsdkSurface
   mfxFrameSurface1 surface;
   GstVideoFrame data;
   GstVideoFrame copy;
+  /* in video memory, the surface as handed to downstream */
+  GstMemory *mem;
 } MsdkSurface;
 
 static void
@@ -138,6 +146,31 @@ clear_surface (gpointer surface)
   MsdkSurface *s = surface;
   s->surface.Data.Locked = 0;
   free_surface (surface);
+  if (s->mem) {
+    gst_memory_unref (s->mem);
+    s->mem = NULL;
+  }
+}
+
+/* a surface is free once neither MSDK nor downstream use it anymore */
+static MsdkSurface *
+get_video_surface (GstMsdkDec * thiz)
+{
+  MsdkSurface *i;
+  guint n;
+
+  /* Poll the pool for a maximum of 20 milisecnds */
+  for (n = 0; n < 2000; n++) {
+    for (i = (MsdkSurface *) thiz->surfaces->data;
+        i < (MsdkSurface *) thiz->surfaces->data + thiz->surfaces->len; i++) {
+      if (!i->surface.Data.Locked
+          && GST_MINI_OBJECT_REFCOUNT_VALUE (i->mem) == 1)
+        return i;
+    }
+    g_usleep (10);
+  }
+
+  return NULL;
 }
 
 static MsdkSurface *
@@ -145,6 +178,9 @@ get_surface (GstMsdkDec * thiz, GstBuffer * buffer)
 {
   MsdkSurface *i;
 
+  if (thiz->use_video_memory)
+    return get_video_surface (thiz);
+
   for (i = (MsdkSurface *) thiz->surfaces->data;
       i < (MsdkSurface *) thiz->surfaces->data + thiz->surfaces->len; i++) {
     if (!i->surface.Data.Locked)
@@ -197,12 +233,21 @@ static void
 gst_msdkdec_close_decoder (GstMsdkDec * thiz)
 {
   mfxStatus status;
+  guint i;
 
   if (!thiz->context)
     return;
 
   GST_DEBUG_OBJECT (thiz, "Closing decoder 0x%p", thiz->context);
 
+  /* the frames still used downstream can't be waited for afterwards */
+  for (i = 0; i < thiz->surfaces->len; i++) {
+    MsdkSurface *s = &g_array_index (thiz->surfaces, MsdkSurface, i);
+
+    if (s->mem)
+      gst_msdk_surface_memory_sync (s->mem);
+  }
+
   status = MFXVideoDECODE_Close (msdk_context_get_session (thiz->context));
   if (status != MFX_ERR_NONE && status != MFX_ERR_NOT_INITIALIZED) {
     GST_WARNING_OBJECT (thiz, "Decoder close failed (%s)",
@@ -226,6 +271,7 @@ gst_msdkdec_init_decoder (GstMsdkDec * thiz)
   mfxSession session;
   mfxStatus status;
   mfxFrameAllocRequest request;
+  mfxFrameAllocResponse response = { 0, };
   guint i;
 
   if (!thiz->input_state) {
@@ -245,8 +291,17 @@ gst_msdkdec_init_decoder (GstMsdkDec * thiz)
 
   GST_OBJECT_LOCK (thiz);
 
+  if (thiz->use_video_memory) {
+    if (!msdk_context_use_video_memory (thiz->context)) {
+      GST_ERROR_OBJECT (thiz, "Video memory is not available");
+      goto failed;
+    }
+    thiz->param.IOPattern = MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+  } else {
+    thiz->param.IOPattern = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+  }
+
   thiz->param.AsyncDepth = thiz->async_depth;
-  thiz->param.IOPattern = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
 
   thiz->param.mfx.FrameInfo.Width = GST_ROUND_UP_32 (info->width);
   thiz->param.mfx.FrameInfo.Height = GST_ROUND_UP_32 (info->height);
@@ -298,11 +353,34 @@ gst_msdkdec_init_decoder (GstMsdkDec * thiz)
     goto failed;
   }
 
+  if (thiz->use_video_memory) {
+    /* downstream holds on to some of the surfaces while it uses them */
+    request.NumFrameSuggested += thiz->downstream_buffers;
+    status = msdk_context_alloc_frames (thiz->context, &request, &response);
+    if (status != MFX_ERR_NONE) {
+      GST_ERROR_OBJECT (thiz, "Surfaces allocation failed (%s)",
+          msdk_status_to_string (status));
+      goto failed;
+    }
+    request.NumFrameSuggested = response.NumFrameActual;
+  }
+
   g_array_set_size (thiz->surfaces, 0);
   g_array_set_size (thiz->surfaces, request.NumFrameSuggested);
   for (i = 0; i < thiz->surfaces->len; i++) {
-    memcpy (&g_array_index (thiz->surfaces, MsdkSurface, i).surface.Info,
-        &thiz->param.mfx.FrameInfo, sizeof (mfxFrameInfo));
+    MsdkSurface *s = &g_array_index (thiz->surfaces, MsdkSurface, i);
+
+    memcpy (&s->surface.Info, &thiz->param.mfx.FrameInfo,
+        sizeof (mfxFrameInfo));
+    if (thiz->use_video_memory) {
+      s->surface.Data.MemId = response.mids[i];
+      s->mem = gst_msdk_surface_memory_new (thiz->context, &s->surface,
+          &thiz->output_info);
+      if (!s->mem) {
+        GST_ERROR_OBJECT (thiz, "Failed to wrap surface %u", i);
+        goto failed;
+      }
+    }
   }
 
   GST_DEBUG_OBJECT (thiz, "Required %d surfaces (%d suggested), allocated %d",
@@ -337,6 +415,7 @@ gst_msdkdec_init_decoder (GstMsdkDec * thiz)
 
 failed:
   GST_OBJECT_UNLOCK (thiz);
+  g_array_set_size (thiz->surfaces, 0);
   msdk_close_context (thiz->context);
   thiz->context = NULL;
   return FALSE;
@@ -362,6 +441,9 @@ gst_msdkdec_set_src_caps (GstMsdkDec * thiz)
   if (output_state->caps)
     gst_caps_unref (output_state->caps);
   output_state->caps = gst_video_info_to_caps (&output_state->info);
+  if (thiz->use_video_memory)
+    gst_caps_set_features (output_state->caps, 0,
+        gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE, NULL));
   gst_video_codec_state_unref (output_state);
 
   return TRUE;
@@ -404,19 +486,27 @@ gst_msdkdec_finish_task (GstMsdkDec * thiz, MsdkDecTask * task)
   mfxStatus status;
 
   if (G_LIKELY (task->sync_point)) {
-    status =
-        MFXVideoCORE_SyncOperation (msdk_context_get_session (thiz->context),
-        task->sync_point, 10000);
-    if (status != MFX_ERR_NONE)
-      return GST_FLOW_ERROR;
+    surface = (MsdkSurface *) task->surface;
+
+    /* frames in video memory are only waited for once they are accessed */
+    if (thiz->use_video_memory) {
+      gst_msdk_surface_memory_set_sync_point (surface->mem, task->sync_point);
+    } else {
+      status =
+          MFXVideoCORE_SyncOperation (msdk_context_get_session
+          (thiz->context), task->sync_point, 10000);
+      if (status != MFX_ERR_NONE)
+        return GST_FLOW_ERROR;
+    }
     frame = gst_video_decoder_get_oldest_frame (decoder);
 
     task->sync_point = NULL;
     task->surface->Data.Locked--;
-    surface = (MsdkSurface *) task->surface;
 
     if (G_LIKELY (frame)) {
-      if (G_LIKELY (surface->copy.buffer == NULL)) {
+      if (thiz->use_video_memory) {
+        frame->output_buffer = gst_msdk_surface_buffer_new (surface->mem);
+      } else if (G_LIKELY (surface->copy.buffer == NULL)) {
         frame->output_buffer = gst_buffer_ref (surface->data.buffer);
       } else {
         gst_video_frame_copy (&surface->copy, &surface->data);
@@ -463,6 +553,25 @@ gst_msdkdec_stop (GstVideoDecoder * decoder)
   return TRUE;
 }
 
+static gboolean
+gst_msdkdec_downstream_supports_video_memory (GstMsdkDec * thiz)
+{
+  GstCaps *caps, *peer_caps;
+  gboolean ret;
+
+  caps = gst_caps_from_string (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+      (GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE, "NV12"));
+  peer_caps = gst_pad_peer_query_caps (GST_VIDEO_DECODER_SRC_PAD (thiz), caps);
+  ret = !gst_caps_is_empty (peer_caps);
+  gst_caps_unref (peer_caps);
+  gst_caps_unref (caps);
+
+  GST_DEBUG_OBJECT (thiz, "downstream %s video memory",
+      ret ? "supports" : "does not support");
+
+  return ret;
+}
+
 static gboolean
 gst_msdkdec_set_format (GstVideoDecoder * decoder, GstVideoCodecState * state)
 {
@@ -472,13 +581,19 @@ gst_msdkdec_set_format (GstVideoDecoder * decoder, GstVideoCodecState * state)
     gst_video_codec_state_unref (thiz->input_state);
   thiz->input_state = gst_video_codec_state_ref (state);
 
-  if (!gst_msdkdec_init_decoder (thiz))
+  thiz->use_video_memory = thiz->hardware
+      && gst_msdkdec_downstream_supports_video_memory (thiz);
+
+  if (!gst_msdkdec_set_src_caps (thiz))
     return FALSE;
 
-  if (!gst_msdkdec_set_src_caps (thiz)) {
-    gst_msdkdec_close_decoder (thiz);
+  /* the surfaces are allocated upfront, including the ones downstream
+   * needs */
+  if (thiz->use_video_memory && !gst_video_decoder_negotiate (decoder))
+    return FALSE;
+
+  if (!gst_msdkdec_init_decoder (thiz))
     return FALSE;
-  }
 
   gst_msdkdec_set_latency (thiz);
 
@@ -513,9 +628,12 @@ gst_msdkdec_handle_frame (GstVideoDecoder * decoder, GstVideoCodecFrame * frame)
     if (flow != GST_FLOW_OK)
       goto exit;
     if (!surface) {
-      flow = allocate_output_buffer (thiz, &buffer);
-      if (flow != GST_FLOW_OK)
-        goto exit;
+      buffer = NULL;
+      if (!thiz->use_video_memory) {
+        flow = allocate_output_buffer (thiz, &buffer);
+        if (flow != GST_FLOW_OK)
+          goto exit;
+      }
       surface = get_surface (thiz, buffer);
       if (!surface) {
         /* Can't get a surface for some reason, finish tasks to see if
@@ -596,6 +714,15 @@ gst_msdkdec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
           query))
     return FALSE;
 
+  /* the output buffers wrap the decoder's own surfaces, only remember how
+   * many of them downstream needs */
+  if (thiz->use_video_memory) {
+    gst_query_parse_nth_allocation_pool (query, 0, NULL, NULL, &min_buffers,
+        NULL);
+    thiz->downstream_buffers = min_buffers;
+    return TRUE;
+  }
+
   /* Get the buffer pool config decided by the base class. The base
      class ensures that there will always be at least a 0th pool in
      the query. */
@@ -696,9 +823,12 @@ gst_msdkdec_drain (GstVideoDecoder * decoder)
     if (!gst_msdkdec_finish_task (thiz, task))
       return GST_FLOW_ERROR;
     if (!surface) {
-      flow = allocate_output_buffer (thiz, &buffer);
-      if (flow != GST_FLOW_OK)
-        return flow;
+      buffer = NULL;
+      if (!thiz->use_video_memory) {
+        flow = allocate_output_buffer (thiz, &buffer);
+        if (flow != GST_FLOW_OK)
+          return flow;
+      }
       surface = get_surface (thiz, buffer);
       if (!surface)
         return GST_FLOW_ERROR;
@@ -818,6 +948,8 @@ gst_msdkdec_class_init (GstMsdkDecClass * klass)
   element_class = GST_ELEMENT_CLASS (klass);
   decoder_class = GST_VIDEO_DECODER_CLASS (klass);
 
+  gst_msdk_surface_memory_init_once ();
+
   gobject_class->set_property = gst_msdkdec_set_property;
   gobject_class->get_property = gst_msdkdec_get_property;
   gobject_class->finalize = gst_msdkdec_finalize;
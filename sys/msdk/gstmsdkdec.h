@@ -64,6 +64,9 @@ struct _GstMsdkDec
   GstVideoInfo output_info;
   GstBufferPool *pool;
   GstVideoInfo pool_info;
+  /* decode into video memory surfaces handed to downstream as is */
+  gboolean use_video_memory;
+  guint downstream_buffers;
 
   /* MFX context */
   MsdkContext *context;
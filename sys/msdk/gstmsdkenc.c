@@ -45,6 +45,7 @@
 #include <stdlib.h>
 
 #include "gstmsdkenc.h"
+#include "gstmsdkmemory.h"
 
 static inline void *
 _aligned_alloc (size_t alignment, size_t size)
@@ -71,7 +72,12 @@ GST_DEBUG_CATEGORY_EXTERN (gst_msdkenc_debug);
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("video/x-raw, "
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE "), "
+        "format = (string) { NV12 }, "
+        "framerate = (fraction) [0, MAX], "
+        "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ],"
+        "interlace-mode = (string) progressive; "
+        "video/x-raw, "
         "format = (string) { NV12 }, "
         "framerate = (fraction) [0, MAX], "
         "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ],"
@@ -167,8 +173,17 @@ gst_msdkenc_init_encoder (GstMsdkEnc * thiz)
 
   GST_OBJECT_LOCK (thiz);
 
+  if (thiz->use_video_memory) {
+    if (!msdk_context_use_video_memory (thiz->context)) {
+      GST_ERROR_OBJECT (thiz, "Video memory is not available");
+      goto failed;
+    }
+    thiz->param.IOPattern = MFX_IOPATTERN_IN_VIDEO_MEMORY;
+  } else {
+    thiz->param.IOPattern = MFX_IOPATTERN_IN_SYSTEM_MEMORY;
+  }
+
   thiz->param.AsyncDepth = thiz->async_depth;
-  thiz->param.IOPattern = MFX_IOPATTERN_IN_SYSTEM_MEMORY;
 
   thiz->param.mfx.RateControlMethod = thiz->rate_control;
   thiz->param.mfx.TargetKbps = thiz->bitrate;
@@ -243,7 +258,10 @@ gst_msdkenc_init_encoder (GstMsdkEnc * thiz)
     memcpy (&thiz->surfaces[i].Info, &thiz->param.mfx.FrameInfo,
         sizeof (mfxFrameInfo));
   }
-  if (GST_ROUND_UP_32 (info->width) != info->width
+  if (thiz->use_video_memory) {
+    /* the surfaces point to the input frames */
+    thiz->surface_buffers = g_new0 (GstBuffer *, thiz->num_surfaces);
+  } else if (GST_ROUND_UP_32 (info->width) != info->width
       || GST_ROUND_UP_32 (info->height) != info->height) {
     guint width = GST_ROUND_UP_32 (info->width);
     guint height = GST_ROUND_UP_32 (info->height);
@@ -346,11 +364,15 @@ gst_msdkenc_close_encoder (GstMsdkEnc * thiz)
 
   for (i = 0; i < thiz->num_surfaces; i++) {
     mfxFrameSurface1 *surface = &thiz->surfaces[i];
-    if (surface->Data.MemId)
+    if (thiz->surface_buffers)
+      gst_buffer_replace (&thiz->surface_buffers[i], NULL);
+    else if (surface->Data.MemId)
       _aligned_free (surface->Data.MemId);
   }
   g_free (thiz->surfaces);
   thiz->surfaces = NULL;
+  g_free (thiz->surface_buffers);
+  thiz->surface_buffers = NULL;
 
   msdk_close_context (thiz->context);
   thiz->context = NULL;
@@ -371,12 +393,15 @@ gst_msdkenc_queue_frame (GstMsdkEnc * thiz, GstVideoCodecFrame * frame,
   GstVideoFrame vframe;
   FrameData *fdata;
 
-  if (!gst_video_frame_map (&vframe, info, frame->input_buffer, GST_MAP_READ))
+  /* frames in video memory are not mapped */
+  if (info && !gst_video_frame_map (&vframe, info, frame->input_buffer,
+          GST_MAP_READ))
     return NULL;
 
-  fdata = g_slice_new (FrameData);
+  fdata = g_slice_new0 (FrameData);
   fdata->frame = gst_video_codec_frame_ref (frame);
-  fdata->vframe = vframe;
+  if (info)
+    fdata->vframe = vframe;
 
   thiz->pending_frames = g_list_prepend (thiz->pending_frames, fdata);
 
@@ -394,7 +419,8 @@ gst_msdkenc_dequeue_frame (GstMsdkEnc * thiz, GstVideoCodecFrame * frame)
     if (fdata->frame != frame)
       continue;
 
-    gst_video_frame_unmap (&fdata->vframe);
+    if (fdata->vframe.buffer)
+      gst_video_frame_unmap (&fdata->vframe);
     gst_video_codec_frame_unref (fdata->frame);
     g_slice_free (FrameData, fdata);
 
@@ -411,7 +437,8 @@ gst_msdkenc_dequeue_all_frames (GstMsdkEnc * thiz)
   for (l = thiz->pending_frames; l; l = l->next) {
     FrameData *fdata = l->data;
 
-    gst_video_frame_unmap (&fdata->vframe);
+    if (fdata->vframe.buffer)
+      gst_video_frame_unmap (&fdata->vframe);
     gst_video_codec_frame_unref (fdata->frame);
     g_slice_free (FrameData, fdata);
   }
@@ -618,6 +645,10 @@ gst_msdkenc_set_format (GstVideoEncoder * encoder, GstVideoCodecState * state)
     if (thiz->input_state)
       gst_video_codec_state_unref (thiz->input_state);
     thiz->input_state = gst_video_codec_state_ref (state);
+
+    thiz->use_video_memory =
+        gst_caps_features_contains (gst_caps_get_features (state->caps, 0),
+        GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE);
   }
 
   if (klass->set_format) {
@@ -658,11 +689,26 @@ gst_msdkenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
   if (!surface)
     goto invalid_surface;
 
-  fdata = gst_msdkenc_queue_frame (thiz, frame, info);
-  if (!fdata)
-    goto invalid_frame;
+  if (thiz->use_video_memory) {
+    GstMemory *mem = gst_buffer_peek_memory (frame->input_buffer, 0);
 
-  msdk_frame_to_surface (&fdata->vframe, surface);
+    if (!gst_is_msdk_surface_memory (mem))
+      goto invalid_frame;
+    /* the decoder worked in its own session */
+    if (!gst_msdk_surface_memory_sync (mem))
+      goto invalid_frame;
+
+    fdata = gst_msdkenc_queue_frame (thiz, frame, NULL);
+    surface->Data.MemId = GST_MSDK_SURFACE_MEMORY_CAST (mem)->mid;
+    gst_buffer_replace (&thiz->surface_buffers[surface - thiz->surfaces],
+        frame->input_buffer);
+  } else {
+    fdata = gst_msdkenc_queue_frame (thiz, frame, info);
+    if (!fdata)
+      goto invalid_frame;
+
+    msdk_frame_to_surface (&fdata->vframe, surface);
+  }
   if (frame->pts != GST_CLOCK_TIME_NONE) {
     surface->Data.TimeStamp =
         gst_util_uint64_scale (frame->pts, 90000, GST_SECOND);
@@ -903,6 +949,8 @@ gst_msdkenc_class_init (GstMsdkEncClass * klass)
   element_class = GST_ELEMENT_CLASS (klass);
   gstencoder_class = GST_VIDEO_ENCODER_CLASS (klass);
 
+  gst_msdk_surface_memory_init_once ();
+
   gobject_class->set_property = gst_msdkenc_set_property;
   gobject_class->get_property = gst_msdkenc_get_property;
   gobject_class->finalize = gst_msdkenc_finalize;
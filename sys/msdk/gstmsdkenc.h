@@ -73,6 +73,10 @@ struct _GstMsdkEnc
   mfxVideoParam param;
   guint num_surfaces;
   mfxFrameSurface1 *surfaces;
+  /* with input in video memory, the buffers the surfaces are encoded from,
+   * kept until MSDK is done with them */
+  gboolean use_video_memory;
+  GstBuffer **surface_buffers;
   guint num_tasks;
   MsdkEncTask *tasks;
   guint next_task;
@@ -0,0 +1,282 @@
+/* GStreamer Intel MSDK plugin
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "gstmsdkmemory.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_msdk_memory_debug);
+#define GST_CAT_DEFAULT gst_msdk_memory_debug
+
+typedef struct _GstMsdkSurfaceAllocator GstMsdkSurfaceAllocator;
+typedef struct _GstMsdkSurfaceAllocatorClass GstMsdkSurfaceAllocatorClass;
+
+struct _GstMsdkSurfaceAllocator
+{
+  GstAllocator parent;
+};
+
+struct _GstMsdkSurfaceAllocatorClass
+{
+  GstAllocatorClass parent_class;
+};
+
+static GType gst_msdk_surface_allocator_get_type (void);
+G_DEFINE_TYPE (GstMsdkSurfaceAllocator, gst_msdk_surface_allocator,
+    GST_TYPE_ALLOCATOR);
+
+static GstAllocator *_msdk_surface_allocator;
+
+static gpointer
+_msdk_surface_mem_map (GstMsdkSurfaceMemory * mem, gsize maxsize,
+    GstMapFlags flags)
+{
+  gpointer ret = NULL;
+
+  if (!gst_msdk_surface_memory_sync (GST_MEMORY_CAST (mem)))
+    return NULL;
+
+  g_mutex_lock (&mem->lock);
+  if (mem->map_count == 0
+      && !msdk_context_map_frame (mem->context, mem->mid, &mem->data)) {
+    GST_WARNING ("failed to map surface %p", mem->mid);
+    goto done;
+  }
+  mem->map_count++;
+  ret = mem->data.Y;
+
+done:
+  g_mutex_unlock (&mem->lock);
+
+  return ret;
+}
+
+static void
+_msdk_surface_mem_unmap (GstMsdkSurfaceMemory * mem)
+{
+  g_mutex_lock (&mem->lock);
+  if (--mem->map_count == 0)
+    msdk_context_unmap_frame (mem->context, mem->mid, &mem->data);
+  g_mutex_unlock (&mem->lock);
+}
+
+static GstMemory *
+gst_msdk_surface_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  g_warning ("Use gst_msdk_surface_memory_new () to allocate from this "
+      "allocator");
+
+  return NULL;
+}
+
+static void
+gst_msdk_surface_allocator_free (GstAllocator * allocator, GstMemory * memory)
+{
+  GstMsdkSurfaceMemory *mem = GST_MSDK_SURFACE_MEMORY_CAST (memory);
+
+  /* the surface itself belongs to the context */
+  msdk_close_context (mem->context);
+
+  g_mutex_clear (&mem->lock);
+  g_slice_free (GstMsdkSurfaceMemory, mem);
+}
+
+static void
+gst_msdk_surface_allocator_class_init (GstMsdkSurfaceAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_msdk_surface_allocator_alloc;
+  allocator_class->free = gst_msdk_surface_allocator_free;
+}
+
+static void
+gst_msdk_surface_allocator_init (GstMsdkSurfaceAllocator * allocator)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (allocator);
+
+  alloc->mem_type = GST_MSDK_SURFACE_MEMORY_NAME;
+  alloc->mem_map = (GstMemoryMapFunction) _msdk_surface_mem_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) _msdk_surface_mem_unmap;
+
+  GST_OBJECT_FLAG_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+/**
+ * gst_msdk_surface_memory_init_once:
+ *
+ * Initializes the MSDK surface allocator. It is safe to call this function
+ * multiple times. This must be called before any other GstMsdkSurfaceMemory
+ * operation.
+ */
+void
+gst_msdk_surface_memory_init_once (void)
+{
+  static volatile gsize _init = 0;
+
+  if (g_once_init_enter (&_init)) {
+    GST_DEBUG_CATEGORY_INIT (gst_msdk_memory_debug, "msdkmemory", 0,
+        "MSDK Surface Memory");
+
+    _msdk_surface_allocator =
+        g_object_new (gst_msdk_surface_allocator_get_type (), NULL);
+    gst_object_ref_sink (_msdk_surface_allocator);
+    gst_allocator_register (GST_MSDK_SURFACE_MEMORY_NAME,
+        gst_object_ref (_msdk_surface_allocator));
+
+    g_once_init_leave (&_init, 1);
+  }
+}
+
+/**
+ * gst_msdk_surface_memory_new:
+ * @context: the #MsdkContext @surface was allocated from
+ * @surface: a surface in video memory
+ * @info: the #GstVideoInfo of the frame
+ *
+ * Wraps @surface, which must stay allocated as long as @context is alive.
+ * The memory keeps a reference on @context. The strides and offsets of the
+ * planes when mapped are in the info of the returned memory.
+ *
+ * Returns: (transfer full): a new #GstMsdkSurfaceMemory or %NULL on failure.
+ */
+GstMemory *
+gst_msdk_surface_memory_new (MsdkContext * context,
+    mfxFrameSurface1 * surface, GstVideoInfo * info)
+{
+  GstMsdkSurfaceMemory *mem;
+  mfxFrameData data = { 0, };
+  gsize uv_offset, size;
+
+  gst_msdk_surface_memory_init_once ();
+
+  /* the layout is only known once the surface is mapped */
+  if (!msdk_context_map_frame (context, surface->Data.MemId, &data))
+    return NULL;
+  uv_offset = data.UV - data.Y;
+  size = uv_offset + data.Pitch * GST_ROUND_UP_2 (surface->Info.Height) / 2;
+  msdk_context_unmap_frame (context, surface->Data.MemId, &data);
+
+  mem = g_slice_new0 (GstMsdkSurfaceMemory);
+  mem->context = msdk_context_ref (context);
+  mem->mid = surface->Data.MemId;
+  mem->frame_info = surface->Info;
+  g_mutex_init (&mem->lock);
+
+  mem->info = *info;
+  GST_VIDEO_INFO_PLANE_OFFSET (&mem->info, 0) = 0;
+  GST_VIDEO_INFO_PLANE_STRIDE (&mem->info, 0) = data.Pitch;
+  GST_VIDEO_INFO_PLANE_OFFSET (&mem->info, 1) = uv_offset;
+  GST_VIDEO_INFO_PLANE_STRIDE (&mem->info, 1) = data.Pitch;
+  GST_VIDEO_INFO_SIZE (&mem->info) = size;
+
+  /* sharing would need a sub-surface */
+  gst_memory_init (GST_MEMORY_CAST (mem), GST_MEMORY_FLAG_NO_SHARE,
+      _msdk_surface_allocator, NULL, size, 0, 0, size);
+
+  GST_LOG ("wrapped surface %p, pitch %u, %" G_GSIZE_FORMAT " bytes",
+      mem->mid, (guint) data.Pitch, size);
+
+  return GST_MEMORY_CAST (mem);
+}
+
+/**
+ * gst_msdk_surface_memory_set_sync_point:
+ * @mem: a #GstMsdkSurfaceMemory
+ * @sync_point: the operation writing into @mem
+ *
+ * Sets the operation to wait for before the content of @mem can be used.
+ */
+void
+gst_msdk_surface_memory_set_sync_point (GstMemory * mem,
+    mfxSyncPoint sync_point)
+{
+  GstMsdkSurfaceMemory *smem = GST_MSDK_SURFACE_MEMORY_CAST (mem);
+
+  g_mutex_lock (&smem->lock);
+  smem->sync_point = sync_point;
+  g_mutex_unlock (&smem->lock);
+}
+
+/**
+ * gst_msdk_surface_memory_sync:
+ * @mem: a #GstMsdkSurfaceMemory
+ *
+ * Waits for the operation writing into @mem to finish, if there is one.
+ *
+ * Returns: %FALSE if the operation failed.
+ */
+gboolean
+gst_msdk_surface_memory_sync (GstMemory * mem)
+{
+  GstMsdkSurfaceMemory *smem = GST_MSDK_SURFACE_MEMORY_CAST (mem);
+  mfxStatus status = MFX_ERR_NONE;
+
+  g_mutex_lock (&smem->lock);
+  if (smem->sync_point) {
+    status =
+        MFXVideoCORE_SyncOperation (msdk_context_get_session (smem->context),
+        smem->sync_point, 10000);
+    smem->sync_point = NULL;
+  }
+  g_mutex_unlock (&smem->lock);
+
+  if (status != MFX_ERR_NONE) {
+    GST_WARNING ("Waiting for surface %p failed (%s)", smem->mid,
+        msdk_status_to_string (status));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * gst_msdk_surface_buffer_new:
+ * @mem: a #GstMsdkSurfaceMemory
+ *
+ * Returns: (transfer full): a new #GstBuffer with a reference on @mem and
+ * the #GstVideoMeta describing its layout.
+ */
+GstBuffer *
+gst_msdk_surface_buffer_new (GstMemory * mem)
+{
+  GstVideoInfo *info = &GST_MSDK_SURFACE_MEMORY_CAST (mem)->info;
+  GstBuffer *buffer = gst_buffer_new ();
+
+  gst_buffer_append_memory (buffer, gst_memory_ref (mem));
+  gst_buffer_add_video_meta_full (buffer, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+      GST_VIDEO_INFO_HEIGHT (info), GST_VIDEO_INFO_N_PLANES (info),
+      info->offset, info->stride);
+
+  return buffer;
+}
@@ -0,0 +1,85 @@
+/* GStreamer Intel MSDK plugin
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __GST_MSDK_MEMORY_H__
+#define __GST_MSDK_MEMORY_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include "msdk.h"
+
+G_BEGIN_DECLS
+
+/* A frame in video memory, output by msdkdec or msdkvpp and used by msdkvpp
+ * or msdkenc without ever being copied to system memory. Mapping the memory
+ * waits for the operation writing into it to finish first. */
+
+#define GST_MSDK_SURFACE_MEMORY_NAME "MSDKSurface"
+#define GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE "memory:" GST_MSDK_SURFACE_MEMORY_NAME
+
+#define GST_MSDK_SURFACE_MEMORY_CAST(mem) ((GstMsdkSurfaceMemory *) (mem))
+
+typedef struct _GstMsdkSurfaceMemory GstMsdkSurfaceMemory;
+
+struct _GstMsdkSurfaceMemory
+{
+  GstMemory mem;
+
+  MsdkContext *context;
+  mfxMemId mid;
+  mfxFrameInfo frame_info;
+  /* the layout of the planes when mapped */
+  GstVideoInfo info;
+
+  /*< private >*/
+  GMutex lock;
+  mfxSyncPoint sync_point;
+  mfxFrameData data;
+  guint map_count;
+};
+
+static inline gboolean
+gst_is_msdk_surface_memory (GstMemory * mem)
+{
+  return mem != NULL && mem->allocator != NULL &&
+      g_strcmp0 (mem->allocator->mem_type, GST_MSDK_SURFACE_MEMORY_NAME) == 0;
+}
+
+void        gst_msdk_surface_memory_init_once       (void);
+GstMemory * gst_msdk_surface_memory_new             (MsdkContext * context,
+                                                     mfxFrameSurface1 * surface,
+                                                     GstVideoInfo * info);
+void        gst_msdk_surface_memory_set_sync_point  (GstMemory * mem,
+                                                     mfxSyncPoint sync_point);
+gboolean    gst_msdk_surface_memory_sync            (GstMemory * mem);
+GstBuffer * gst_msdk_surface_buffer_new             (GstMemory * mem);
+
+G_END_DECLS
+
+#endif /* __GST_MSDK_MEMORY_H__ */
@@ -0,0 +1,1045 @@
+/* GStreamer Intel MSDK plugin
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * SECTION:element-msdkvpp
+ * @title: msdkvpp
+ * @short_description: Intel MSDK video postprocessor
+ *
+ * Scales, converts, deinterlaces and denoises video frames with the video
+ * processing of Intel Media SDK. Frames decoded by msdkdec in video memory
+ * are processed without being copied, so a decoder can feed several
+ * msdkvpp elements through a tee, each of them producing one output of an
+ * encoding ladder for msdkenc.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=input.h264 ! h264parse ! msdkh264dec ! tee name=t \
+ *     t. ! queue ! msdkvpp ! video/x-raw(memory:MSDKSurface),width=1280,height=720 ! msdkh264enc ! filesink location=720p.h264 \
+ *     t. ! queue ! msdkvpp ! video/x-raw(memory:MSDKSurface),width=640,height=360 ! msdkh264enc ! filesink location=360p.h264
+ * ]|
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "gstmsdkvpp.h"
+#include "gstmsdkmemory.h"
+
+GST_DEBUG_CATEGORY_EXTERN (gst_msdkvpp_debug);
+#define GST_CAT_DEFAULT gst_msdkvpp_debug
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE "), "
+        "format = (string) { NV12 }, "
+        "framerate = (fraction) [0, MAX], "
+        "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ]; "
+        "video/x-raw, "
+        "format = (string) { NV12, YUY2, BGRA }, "
+        "framerate = (fraction) [0, MAX], "
+        "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ]")
+    );
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE "), "
+        "format = (string) { NV12 }, "
+        "framerate = (fraction) [0, MAX], "
+        "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ],"
+        "interlace-mode = (string) progressive; "
+        "video/x-raw, "
+        "format = (string) { NV12, BGRA }, "
+        "framerate = (fraction) [0, MAX], "
+        "width = (int) [ 16, MAX ], height = (int) [ 16, MAX ],"
+        "interlace-mode = (string) progressive")
+    );
+
+enum
+{
+  PROP_0,
+  PROP_HARDWARE,
+  PROP_ASYNC_DEPTH,
+  PROP_DEINTERLACE_MODE,
+  PROP_DENOISE,
+};
+
+#define PROP_HARDWARE_DEFAULT            TRUE
+#define PROP_ASYNC_DEPTH_DEFAULT         4
+#define PROP_DEINTERLACE_MODE_DEFAULT    GST_MSDKVPP_DEINTERLACE_MODE_ADVANCED
+#define PROP_DENOISE_DEFAULT             0
+
+#define gst_msdkvpp_parent_class parent_class
+G_DEFINE_TYPE (GstMsdkVPP, gst_msdkvpp, GST_TYPE_BASE_TRANSFORM);
+
+#define GST_MSDKVPP_DEINTERLACE_MODE_TYPE (gst_msdkvpp_deinterlace_mode_get_type())
+static GType
+gst_msdkvpp_deinterlace_mode_get_type (void)
+{
+  static GType type = 0;
+
+  static const GEnumValue values[] = {
+    {GST_MSDKVPP_DEINTERLACE_MODE_BOB, "Bob deinterlacing", "bob"},
+    {GST_MSDKVPP_DEINTERLACE_MODE_ADVANCED,
+        "Motion adaptive deinterlacing, with a frame of delay", "advanced"},
+    {0, NULL, NULL}
+  };
+
+  if (!type) {
+    type = g_enum_register_static ("GstMsdkVPPDeinterlaceMode", values);
+  }
+  return type;
+}
+
+static void
+msdk_vpp_alignment (GstVideoAlignment * alignment, GstVideoInfo * info)
+{
+  guint i, width, height;
+
+  width = GST_VIDEO_INFO_WIDTH (info);
+  height = GST_VIDEO_INFO_HEIGHT (info);
+  gst_video_alignment_reset (alignment);
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (info); i++)
+    alignment->stride_align[i] = 31;    /* 32-byte alignment */
+  if (width & 31)
+    alignment->padding_right = 32 - (width & 31);
+  if (height & 31)
+    alignment->padding_bottom = 32 - (height & 31);
+}
+
+static void
+msdk_vpp_frame_info (mfxFrameInfo * frame_info, GstVideoInfo * info)
+{
+  memset (frame_info, 0, sizeof (*frame_info));
+
+  frame_info->Width = GST_ROUND_UP_32 (info->width);
+  frame_info->Height = GST_ROUND_UP_32 (info->height);
+  frame_info->CropW = info->width;
+  frame_info->CropH = info->height;
+  frame_info->FrameRateExtN = info->fps_n;
+  frame_info->FrameRateExtD = info->fps_d;
+  frame_info->AspectRatioW = info->par_n;
+  frame_info->AspectRatioH = info->par_d;
+
+  switch (GST_VIDEO_INFO_INTERLACE_MODE (info)) {
+    case GST_VIDEO_INTERLACE_MODE_PROGRESSIVE:
+      frame_info->PicStruct = MFX_PICSTRUCT_PROGRESSIVE;
+      break;
+    case GST_VIDEO_INTERLACE_MODE_INTERLEAVED:
+      frame_info->PicStruct = MFX_PICSTRUCT_FIELD_TFF;
+      break;
+    default:
+      frame_info->PicStruct = MFX_PICSTRUCT_UNKNOWN;
+      break;
+  }
+
+  switch (GST_VIDEO_INFO_FORMAT (info)) {
+    case GST_VIDEO_FORMAT_YUY2:
+      frame_info->FourCC = MFX_FOURCC_YUY2;
+      frame_info->ChromaFormat = MFX_CHROMAFORMAT_YUV422;
+      break;
+    case GST_VIDEO_FORMAT_BGRA:
+      frame_info->FourCC = MFX_FOURCC_RGB4;
+      frame_info->ChromaFormat = MFX_CHROMAFORMAT_YUV444;
+      break;
+    default:
+      frame_info->FourCC = MFX_FOURCC_NV12;
+      frame_info->ChromaFormat = MFX_CHROMAFORMAT_YUV420;
+      break;
+  }
+}
+
+/* the surface points to the planes of the mapped frame */
+static void
+msdk_vpp_frame_to_surface (GstVideoFrame * frame, mfxFrameSurface1 * surface)
+{
+  guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+
+  surface->Data.Pitch = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+
+  switch (GST_VIDEO_FRAME_FORMAT (frame)) {
+    case GST_VIDEO_FORMAT_YUY2:
+      surface->Data.Y = data;
+      surface->Data.U = data + 1;
+      surface->Data.V = data + 3;
+      break;
+    case GST_VIDEO_FORMAT_BGRA:
+      surface->Data.B = data;
+      surface->Data.G = data + 1;
+      surface->Data.R = data + 2;
+      surface->Data.A = data + 3;
+      break;
+    default:
+      surface->Data.Y = data;
+      surface->Data.UV = GST_VIDEO_FRAME_PLANE_DATA (frame, 1);
+      break;
+  }
+}
+
+static gboolean
+gst_msdkvpp_caps_use_video_memory (GstCaps * caps)
+{
+  return gst_caps_features_contains (gst_caps_get_features (caps, 0),
+      GST_CAPS_FEATURE_MEMORY_MSDK_SURFACE);
+}
+
+static void
+release_surface (MsdkVPPSurface * s)
+{
+  if (s->frame.buffer)
+    gst_video_frame_unmap (&s->frame);
+  memset (&s->frame, 0, sizeof (s->frame));
+  gst_buffer_replace (&s->buffer, NULL);
+}
+
+static void
+clear_surface (gpointer surface)
+{
+  MsdkVPPSurface *s = surface;
+
+  release_surface (s);
+  if (s->mem) {
+    gst_memory_unref (s->mem);
+    s->mem = NULL;
+  }
+}
+
+/* a surface is free once neither MSDK nor downstream use it anymore */
+static MsdkVPPSurface *
+get_free_surface (GArray * surfaces)
+{
+  MsdkVPPSurface *i;
+  guint n;
+
+  /* Poll the pool for a maximum of 20 milisecnds */
+  for (n = 0; n < 2000; n++) {
+    for (i = (MsdkVPPSurface *) surfaces->data;
+        i < (MsdkVPPSurface *) surfaces->data + surfaces->len; i++) {
+      if (!i->surface.Data.Locked
+          && (!i->mem || GST_MINI_OBJECT_REFCOUNT_VALUE (i->mem) == 1))
+        return i;
+    }
+    g_usleep (10);
+  }
+
+  return NULL;
+}
+
+static GstBufferPool *
+gst_msdkvpp_create_buffer_pool (GstMsdkVPP * thiz, GstVideoInfo * info,
+    GstVideoInfo * pool_info)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstVideoAlignment align;
+  GstCaps *caps;
+
+  memcpy (pool_info, info, sizeof (GstVideoInfo));
+  msdk_vpp_alignment (&align, info);
+  gst_video_info_align (pool_info, &align);
+
+  pool = gst_video_buffer_pool_new ();
+  caps = gst_video_info_to_caps (info);
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps,
+      GST_VIDEO_INFO_SIZE (pool_info), 0, 0);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  gst_buffer_pool_config_add_option (config,
+      GST_BUFFER_POOL_OPTION_VIDEO_ALIGNMENT);
+  gst_buffer_pool_config_set_video_alignment (config, &align);
+  gst_caps_unref (caps);
+
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_ERROR_OBJECT (thiz, "Failed to configure buffer pool");
+    gst_object_unref (pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+static void
+gst_msdkvpp_close_vpp (GstMsdkVPP * thiz)
+{
+  mfxStatus status;
+  guint i;
+
+  if (!thiz->context)
+    return;
+
+  GST_DEBUG_OBJECT (thiz, "Closing VPP 0x%p", thiz->context);
+
+  /* the frames still used downstream can't be waited for afterwards */
+  for (i = 0; i < thiz->out_surfaces->len; i++) {
+    MsdkVPPSurface *s = &g_array_index (thiz->out_surfaces, MsdkVPPSurface, i);
+
+    if (s->mem)
+      gst_msdk_surface_memory_sync (s->mem);
+  }
+
+  status = MFXVideoVPP_Close (msdk_context_get_session (thiz->context));
+  if (status != MFX_ERR_NONE && status != MFX_ERR_NOT_INITIALIZED) {
+    GST_WARNING_OBJECT (thiz, "VPP close failed (%s)",
+        msdk_status_to_string (status));
+  }
+
+  g_array_set_size (thiz->in_surfaces, 0);
+  g_array_set_size (thiz->out_surfaces, 0);
+
+  msdk_close_context (thiz->context);
+  thiz->context = NULL;
+  memset (&thiz->param, 0, sizeof (thiz->param));
+}
+
+static gboolean
+gst_msdkvpp_init_vpp (GstMsdkVPP * thiz)
+{
+  mfxSession session;
+  mfxStatus status;
+  guint i, n_params = 0;
+
+  /* make sure that the VPP is closed */
+  gst_msdkvpp_close_vpp (thiz);
+
+  thiz->context = msdk_open_context (thiz->hardware);
+  if (!thiz->context) {
+    GST_ERROR_OBJECT (thiz, "Context creation failed");
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (thiz);
+
+  if (thiz->use_video_memory_in || thiz->use_video_memory_out) {
+    if (!msdk_context_use_video_memory (thiz->context)) {
+      GST_ERROR_OBJECT (thiz, "Video memory is not available");
+      goto failed;
+    }
+  }
+  thiz->param.IOPattern = thiz->use_video_memory_in ?
+      MFX_IOPATTERN_IN_VIDEO_MEMORY : MFX_IOPATTERN_IN_SYSTEM_MEMORY;
+  thiz->param.IOPattern |= thiz->use_video_memory_out ?
+      MFX_IOPATTERN_OUT_VIDEO_MEMORY : MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+  thiz->param.AsyncDepth = thiz->async_depth;
+
+  msdk_vpp_frame_info (&thiz->param.vpp.In, &thiz->sinkpad_info);
+  msdk_vpp_frame_info (&thiz->param.vpp.Out, &thiz->srcpad_info);
+
+  if (GST_VIDEO_INFO_IS_INTERLACED (&thiz->sinkpad_info)) {
+    memset (&thiz->deinterlace, 0, sizeof (thiz->deinterlace));
+    thiz->deinterlace.Header.BufferId = MFX_EXTBUFF_VPP_DEINTERLACING;
+    thiz->deinterlace.Header.BufferSz = sizeof (thiz->deinterlace);
+    thiz->deinterlace.Mode =
+        thiz->deinterlace_mode == GST_MSDKVPP_DEINTERLACE_MODE_BOB ?
+        MFX_DEINTERLACING_BOB : MFX_DEINTERLACING_ADVANCED;
+    thiz->extra_params[n_params++] = (mfxExtBuffer *) & thiz->deinterlace;
+  }
+
+  if (thiz->denoise_factor) {
+    memset (&thiz->denoise, 0, sizeof (thiz->denoise));
+    thiz->denoise.Header.BufferId = MFX_EXTBUFF_VPP_DENOISE;
+    thiz->denoise.Header.BufferSz = sizeof (thiz->denoise);
+    thiz->denoise.DenoiseFactor = thiz->denoise_factor;
+    thiz->extra_params[n_params++] = (mfxExtBuffer *) & thiz->denoise;
+  }
+
+  thiz->param.NumExtParam = n_params;
+  thiz->param.ExtParam = n_params ? thiz->extra_params : NULL;
+
+  session = msdk_context_get_session (thiz->context);
+  /* validate parameters and allow the Media SDK to make adjustments */
+  status = MFXVideoVPP_Query (session, &thiz->param, &thiz->param);
+  if (status < MFX_ERR_NONE) {
+    GST_ERROR_OBJECT (thiz, "Video VPP Query failed (%s)",
+        msdk_status_to_string (status));
+    goto failed;
+  } else if (status > MFX_ERR_NONE) {
+    GST_WARNING_OBJECT (thiz, "Video VPP Query returned: %s",
+        msdk_status_to_string (status));
+  }
+
+  status = MFXVideoVPP_QueryIOSurf (session, &thiz->param, thiz->request);
+  if (status < MFX_ERR_NONE) {
+    GST_ERROR_OBJECT (thiz, "Query IO surfaces failed (%s)",
+        msdk_status_to_string (status));
+    goto failed;
+  } else if (status > MFX_ERR_NONE) {
+    GST_WARNING_OBJECT (thiz, "Query IO surfaces returned: %s",
+        msdk_status_to_string (status));
+  }
+
+  /* the input frames are held until MSDK is done with them, the output
+   * surfaces in video memory are only allocated once downstream told how
+   * many of them it needs */
+  g_array_set_size (thiz->in_surfaces, thiz->request[0].NumFrameSuggested);
+  for (i = 0; i < thiz->in_surfaces->len; i++) {
+    MsdkVPPSurface *s = &g_array_index (thiz->in_surfaces, MsdkVPPSurface, i);
+
+    memcpy (&s->surface.Info, &thiz->param.vpp.In, sizeof (mfxFrameInfo));
+  }
+
+  GST_DEBUG_OBJECT (thiz, "Required %d input and %d output surfaces",
+      thiz->request[0].NumFrameSuggested, thiz->request[1].NumFrameSuggested);
+
+  status = MFXVideoVPP_Init (session, &thiz->param);
+  if (status < MFX_ERR_NONE) {
+    GST_ERROR_OBJECT (thiz, "Init failed (%s)", msdk_status_to_string (status));
+    goto failed;
+  } else if (status > MFX_ERR_NONE) {
+    GST_WARNING_OBJECT (thiz, "Init returned: %s",
+        msdk_status_to_string (status));
+  }
+
+  GST_OBJECT_UNLOCK (thiz);
+
+  return TRUE;
+
+failed:
+  GST_OBJECT_UNLOCK (thiz);
+  g_array_set_size (thiz->in_surfaces, 0);
+  msdk_close_context (thiz->context);
+  thiz->context = NULL;
+  return FALSE;
+}
+
+static gboolean
+gst_msdkvpp_alloc_video_surfaces (GstMsdkVPP * thiz)
+{
+  mfxFrameAllocRequest request;
+  mfxFrameAllocResponse response = { 0, };
+  mfxStatus status;
+  guint i;
+
+  /* downstream holds on to some of the surfaces while it uses them */
+  request = thiz->request[1];
+  request.NumFrameSuggested += thiz->downstream_buffers;
+  status = msdk_context_alloc_frames (thiz->context, &request, &response);
+  if (status != MFX_ERR_NONE) {
+    GST_ERROR_OBJECT (thiz, "Surfaces allocation failed (%s)",
+        msdk_status_to_string (status));
+    return FALSE;
+  }
+
+  g_array_set_size (thiz->out_surfaces, response.NumFrameActual);
+  for (i = 0; i < thiz->out_surfaces->len; i++) {
+    MsdkVPPSurface *s = &g_array_index (thiz->out_surfaces, MsdkVPPSurface, i);
+
+    memcpy (&s->surface.Info, &thiz->param.vpp.Out, sizeof (mfxFrameInfo));
+    s->surface.Data.MemId = response.mids[i];
+    s->mem = gst_msdk_surface_memory_new (thiz->context, &s->surface,
+        &thiz->srcpad_info);
+    if (!s->mem) {
+      GST_ERROR_OBJECT (thiz, "Failed to wrap surface %u", i);
+      g_array_set_size (thiz->out_surfaces, 0);
+      return FALSE;
+    }
+  }
+
+  GST_DEBUG_OBJECT (thiz, "Allocated %u output surfaces",
+      thiz->out_surfaces->len);
+
+  return TRUE;
+}
+
+static MsdkVPPSurface *
+gst_msdkvpp_get_in_surface (GstMsdkVPP * thiz, GstBuffer * inbuf)
+{
+  MsdkVPPSurface *s;
+  GstBuffer *buffer = NULL;
+  GstVideoFrame src;
+
+  s = get_free_surface (thiz->in_surfaces);
+  if (!s)
+    return NULL;
+
+  /* MSDK may have been holding on the frame as a reference */
+  release_surface (s);
+
+  if (thiz->use_video_memory_in) {
+    GstMemory *mem = gst_buffer_peek_memory (inbuf, 0);
+
+    if (!gst_is_msdk_surface_memory (mem))
+      return NULL;
+    /* the upstream element worked in its own session */
+    if (!gst_msdk_surface_memory_sync (mem))
+      return NULL;
+
+    s->surface.Data.MemId = GST_MSDK_SURFACE_MEMORY_CAST (mem)->mid;
+    s->buffer = gst_buffer_ref (inbuf);
+  } else if (inbuf->pool == thiz->sinkpad_pool) {
+    s->buffer = gst_buffer_ref (inbuf);
+  } else {
+    /* the frame lacks the padding MSDK reads into */
+    if (!gst_buffer_pool_set_active (thiz->sinkpad_pool, TRUE) ||
+        gst_buffer_pool_acquire_buffer (thiz->sinkpad_pool, &buffer,
+            NULL) != GST_FLOW_OK)
+      return NULL;
+    if (!gst_video_frame_map (&src, &thiz->sinkpad_info, inbuf, GST_MAP_READ))
+      goto failed;
+    if (!gst_video_frame_map (&s->frame, &thiz->sinkpad_pool_info, buffer,
+            GST_MAP_WRITE)) {
+      gst_video_frame_unmap (&src);
+      goto failed;
+    }
+    gst_video_frame_copy (&s->frame, &src);
+    gst_video_frame_unmap (&src);
+    gst_video_frame_unmap (&s->frame);
+    s->buffer = buffer;
+  }
+
+  if (!thiz->use_video_memory_in) {
+    if (!gst_video_frame_map (&s->frame, &thiz->sinkpad_pool_info, s->buffer,
+            GST_MAP_READ)) {
+      gst_buffer_replace (&s->buffer, NULL);
+      return NULL;
+    }
+    msdk_vpp_frame_to_surface (&s->frame, &s->surface);
+  }
+
+  if (GST_VIDEO_INFO_IS_INTERLACED (&thiz->sinkpad_info)) {
+    if (!GST_BUFFER_FLAG_IS_SET (inbuf, GST_VIDEO_BUFFER_FLAG_INTERLACED))
+      s->surface.Info.PicStruct = MFX_PICSTRUCT_PROGRESSIVE;
+    else if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_VIDEO_BUFFER_FLAG_TFF))
+      s->surface.Info.PicStruct = MFX_PICSTRUCT_FIELD_TFF;
+    else
+      s->surface.Info.PicStruct = MFX_PICSTRUCT_FIELD_BFF;
+  }
+
+  return s;
+
+failed:
+  gst_buffer_unref (buffer);
+  memset (&s->frame, 0, sizeof (s->frame));
+  return NULL;
+}
+
+static GstCaps *
+gst_msdkvpp_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  GstCaps *ret, *tmp, *templ;
+  GstStructure *s;
+  guint i, n;
+
+  /* size, format and memory can all change */
+  tmp = gst_caps_new_empty ();
+  n = gst_caps_get_size (caps);
+  for (i = 0; i < n; i++) {
+    s = gst_structure_copy (gst_caps_get_structure (caps, i));
+    gst_structure_remove_fields (s, "width", "height", "format",
+        "interlace-mode", "colorimetry", "chroma-site", NULL);
+    gst_caps_append_structure_full (tmp, s, gst_caps_features_new_any ());
+  }
+
+  if (direction == GST_PAD_SINK)
+    templ = gst_static_pad_template_get_caps (&src_factory);
+  else
+    templ = gst_static_pad_template_get_caps (&sink_factory);
+  ret = gst_caps_intersect (templ, tmp);
+  gst_caps_unref (templ);
+  gst_caps_unref (tmp);
+
+  if (filter) {
+    tmp = gst_caps_intersect_full (filter, ret, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (ret);
+    ret = tmp;
+  }
+
+  GST_DEBUG_OBJECT (trans, "transformed %" GST_PTR_FORMAT " into %"
+      GST_PTR_FORMAT, caps, ret);
+
+  return ret;
+}
+
+static GstCaps *
+gst_msdkvpp_fixate_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  const gchar *format;
+  gint width, height;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  /* keep the size and the format when downstream doesn't ask otherwise */
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+  if (gst_structure_get_int (ins, "width", &width))
+    gst_structure_fixate_field_nearest_int (outs, "width", width);
+  if (gst_structure_get_int (ins, "height", &height))
+    gst_structure_fixate_field_nearest_int (outs, "height", height);
+  format = gst_structure_get_string (ins, "format");
+  if (format)
+    gst_structure_fixate_field_string (outs, "format", format);
+
+  return gst_caps_fixate (othercaps);
+}
+
+static gboolean
+gst_msdkvpp_set_caps (GstBaseTransform * trans, GstCaps * caps,
+    GstCaps * out_caps)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (trans);
+  gboolean passthrough;
+
+  if (!gst_video_info_from_caps (&thiz->sinkpad_info, caps) ||
+      !gst_video_info_from_caps (&thiz->srcpad_info, out_caps))
+    return FALSE;
+
+  thiz->use_video_memory_in = gst_msdkvpp_caps_use_video_memory (caps);
+  thiz->use_video_memory_out = gst_msdkvpp_caps_use_video_memory (out_caps);
+
+  passthrough = gst_caps_is_equal (caps, out_caps) && !thiz->denoise_factor;
+  gst_base_transform_set_passthrough (trans, passthrough);
+
+  if (thiz->sinkpad_pool) {
+    gst_buffer_pool_set_active (thiz->sinkpad_pool, FALSE);
+    gst_object_unref (thiz->sinkpad_pool);
+    thiz->sinkpad_pool = NULL;
+  }
+
+  if (passthrough) {
+    gst_msdkvpp_close_vpp (thiz);
+    return TRUE;
+  }
+
+  if (!thiz->use_video_memory_in) {
+    thiz->sinkpad_pool = gst_msdkvpp_create_buffer_pool (thiz,
+        &thiz->sinkpad_info, &thiz->sinkpad_pool_info);
+    if (!thiz->sinkpad_pool)
+      return FALSE;
+  }
+
+  return gst_msdkvpp_init_vpp (thiz);
+}
+
+static gboolean
+gst_msdkvpp_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (trans);
+
+  /* passthrough, downstream answers */
+  if (!decide_query)
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->propose_allocation (trans,
+        decide_query, query);
+
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  /* the frames in video memory come from upstream's own surfaces */
+  if (thiz->sinkpad_pool)
+    gst_query_add_allocation_pool (query, thiz->sinkpad_pool,
+        GST_VIDEO_INFO_SIZE (&thiz->sinkpad_pool_info), 0, 0);
+
+  return TRUE;
+}
+
+static gboolean
+gst_msdkvpp_decide_allocation (GstBaseTransform * trans, GstQuery * query)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (trans);
+  GstBufferPool *pool;
+  guint min_buffers = 0;
+
+  if (thiz->srcpad_pool) {
+    gst_buffer_pool_set_active (thiz->srcpad_pool, FALSE);
+    gst_object_unref (thiz->srcpad_pool);
+    thiz->srcpad_pool = NULL;
+  }
+
+  /* the output buffers wrap the element's own surfaces, only remember how
+   * many of them downstream needs */
+  if (thiz->use_video_memory_out) {
+    if (gst_query_get_n_allocation_pools (query) > 0)
+      gst_query_parse_nth_allocation_pool (query, 0, NULL, NULL,
+          &min_buffers, NULL);
+    thiz->downstream_buffers = min_buffers;
+    return TRUE;
+  }
+
+  pool = gst_msdkvpp_create_buffer_pool (thiz, &thiz->srcpad_info,
+      &thiz->srcpad_pool_info);
+  if (!pool)
+    return FALSE;
+
+  if (gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL)) {
+    /* downstream copes with the padding of the aligned frames */
+    if (gst_query_get_n_allocation_pools (query) > 0) {
+      gst_query_parse_nth_allocation_pool (query, 0, NULL, NULL,
+          &min_buffers, NULL);
+      gst_query_set_nth_allocation_pool (query, 0, pool,
+          GST_VIDEO_INFO_SIZE (&thiz->srcpad_pool_info), min_buffers, 0);
+    } else {
+      gst_query_add_allocation_pool (query, pool,
+          GST_VIDEO_INFO_SIZE (&thiz->srcpad_pool_info), 0, 0);
+    }
+    gst_object_unref (pool);
+  } else {
+    /* process into a side pool and copy out of it */
+    thiz->srcpad_pool = pool;
+    if (!gst_buffer_pool_set_active (thiz->srcpad_pool, TRUE))
+      return FALSE;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (trans,
+      query);
+}
+
+static GstFlowReturn
+gst_msdkvpp_prepare_output_buffer (GstBaseTransform * trans,
+    GstBuffer * inbuf, GstBuffer ** outbuf)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (trans);
+  MsdkVPPSurface *s;
+
+  if (!thiz->use_video_memory_out || gst_base_transform_is_passthrough (trans))
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->prepare_output_buffer
+        (trans, inbuf, outbuf);
+
+  if (!thiz->context)
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  if (thiz->out_surfaces->len == 0 && !gst_msdkvpp_alloc_video_surfaces (thiz))
+    return GST_FLOW_ERROR;
+
+  s = get_free_surface (thiz->out_surfaces);
+  if (!s) {
+    GST_ERROR_OBJECT (thiz, "Couldn't get a surface");
+    return GST_FLOW_ERROR;
+  }
+
+  *outbuf = gst_msdk_surface_buffer_new (s->mem);
+  gst_buffer_copy_into (*outbuf, inbuf,
+      GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_msdkvpp_transform (GstBaseTransform * trans, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (trans);
+  GstFlowReturn ret = GST_FLOW_OK;
+  MsdkVPPSurface *in, *out = NULL;
+  MsdkVPPSurface sys_out = { {0,}, };
+  GstVideoFrame dest;
+  GstMemory *mem;
+  mfxSyncPoint sync_point = NULL;
+  mfxSession session;
+  mfxStatus status;
+  guint i;
+
+  if (G_UNLIKELY (thiz->context == NULL))
+    goto not_negotiated;
+
+  session = msdk_context_get_session (thiz->context);
+
+  in = gst_msdkvpp_get_in_surface (thiz, inbuf);
+  if (!in)
+    goto invalid_frame;
+
+  if (thiz->use_video_memory_out) {
+    mem = gst_buffer_peek_memory (outbuf, 0);
+    for (i = 0; i < thiz->out_surfaces->len; i++) {
+      MsdkVPPSurface *s =
+          &g_array_index (thiz->out_surfaces, MsdkVPPSurface, i);
+
+      if (s->mem == mem)
+        out = s;
+    }
+    if (!out)
+      goto invalid_frame;
+  } else {
+    out = &sys_out;
+    memcpy (&out->surface.Info, &thiz->param.vpp.Out, sizeof (mfxFrameInfo));
+    if (thiz->srcpad_pool) {
+      if (gst_buffer_pool_acquire_buffer (thiz->srcpad_pool, &out->buffer,
+              NULL) != GST_FLOW_OK)
+        goto invalid_frame;
+    } else {
+      out->buffer = gst_buffer_ref (outbuf);
+    }
+    if (!gst_video_frame_map (&out->frame, &thiz->srcpad_pool_info,
+            out->buffer, GST_MAP_WRITE)) {
+      gst_buffer_replace (&out->buffer, NULL);
+      goto invalid_frame;
+    }
+    msdk_vpp_frame_to_surface (&out->frame, &out->surface);
+  }
+
+  for (;;) {
+    status = MFXVideoVPP_RunFrameVPPAsync (session, &in->surface,
+        &out->surface, NULL, &sync_point);
+    if (status != MFX_WRN_DEVICE_BUSY)
+      break;
+    /* If device is busy, wait 1ms and retry, as per MSDK's recomendation */
+    g_usleep (1000);
+  }
+
+  if (status == MFX_ERR_MORE_DATA) {
+    /* the deinterlacer needs the next frame as a reference first */
+    ret = GST_BASE_TRANSFORM_FLOW_DROPPED;
+    goto done;
+  } else if (status < MFX_ERR_NONE) {
+    GST_ELEMENT_ERROR (thiz, STREAM, FAILED, (NULL),
+        ("RunFrameVPPAsync failed (%s)", msdk_status_to_string (status)));
+    ret = GST_FLOW_ERROR;
+    goto done;
+  }
+
+  /* frames in video memory are only waited for once they are accessed */
+  if (thiz->use_video_memory_out) {
+    gst_msdk_surface_memory_set_sync_point (out->mem, sync_point);
+  } else {
+    status = MFXVideoCORE_SyncOperation (session, sync_point, 10000);
+    if (status != MFX_ERR_NONE) {
+      GST_ELEMENT_ERROR (thiz, STREAM, FAILED, (NULL),
+          ("SyncOperation failed (%s)", msdk_status_to_string (status)));
+      ret = GST_FLOW_ERROR;
+      goto done;
+    }
+
+    if (thiz->srcpad_pool) {
+      if (!gst_video_frame_map (&dest, &thiz->srcpad_info, outbuf,
+              GST_MAP_WRITE)) {
+        ret = GST_FLOW_ERROR;
+        goto done;
+      }
+      gst_video_frame_copy (&dest, &out->frame);
+      gst_video_frame_unmap (&dest);
+    }
+  }
+
+  GST_BUFFER_FLAG_UNSET (outbuf, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+  GST_BUFFER_FLAG_UNSET (outbuf, GST_VIDEO_BUFFER_FLAG_TFF);
+
+done:
+  if (out == &sys_out)
+    release_surface (out);
+
+  return ret;
+
+/* ERRORS */
+not_negotiated:
+  {
+    GST_WARNING_OBJECT (thiz, "Got buffer before set_caps was called");
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+invalid_frame:
+  {
+    GST_ERROR_OBJECT (thiz, "Couldn't prepare frame");
+    return GST_FLOW_ERROR;
+  }
+}
+
+static gboolean
+gst_msdkvpp_stop (GstBaseTransform * trans)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (trans);
+
+  gst_msdkvpp_close_vpp (thiz);
+
+  if (thiz->sinkpad_pool) {
+    gst_buffer_pool_set_active (thiz->sinkpad_pool, FALSE);
+    gst_object_unref (thiz->sinkpad_pool);
+    thiz->sinkpad_pool = NULL;
+  }
+  if (thiz->srcpad_pool) {
+    gst_buffer_pool_set_active (thiz->srcpad_pool, FALSE);
+    gst_object_unref (thiz->srcpad_pool);
+    thiz->srcpad_pool = NULL;
+  }
+  gst_video_info_init (&thiz->sinkpad_info);
+  gst_video_info_init (&thiz->srcpad_info);
+
+  return TRUE;
+}
+
+static void
+gst_msdkvpp_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (object);
+  GstState state;
+
+  GST_OBJECT_LOCK (thiz);
+
+  state = GST_STATE (thiz);
+  if ((state != GST_STATE_READY && state != GST_STATE_NULL) &&
+      !(pspec->flags & GST_PARAM_MUTABLE_PLAYING))
+    goto wrong_state;
+
+  switch (prop_id) {
+    case PROP_HARDWARE:
+      thiz->hardware = g_value_get_boolean (value);
+      break;
+    case PROP_ASYNC_DEPTH:
+      thiz->async_depth = g_value_get_uint (value);
+      break;
+    case PROP_DEINTERLACE_MODE:
+      thiz->deinterlace_mode = g_value_get_enum (value);
+      break;
+    case PROP_DENOISE:
+      thiz->denoise_factor = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (thiz);
+  return;
+
+  /* ERROR */
+wrong_state:
+  {
+    GST_WARNING_OBJECT (thiz, "setting property in wrong state");
+    GST_OBJECT_UNLOCK (thiz);
+  }
+}
+
+static void
+gst_msdkvpp_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (object);
+
+  GST_OBJECT_LOCK (thiz);
+  switch (prop_id) {
+    case PROP_HARDWARE:
+      g_value_set_boolean (value, thiz->hardware);
+      break;
+    case PROP_ASYNC_DEPTH:
+      g_value_set_uint (value, thiz->async_depth);
+      break;
+    case PROP_DEINTERLACE_MODE:
+      g_value_set_enum (value, thiz->deinterlace_mode);
+      break;
+    case PROP_DENOISE:
+      g_value_set_uint (value, thiz->denoise_factor);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (thiz);
+}
+
+static void
+gst_msdkvpp_finalize (GObject * object)
+{
+  GstMsdkVPP *thiz = GST_MSDKVPP (object);
+
+  g_array_unref (thiz->in_surfaces);
+  g_array_unref (thiz->out_surfaces);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_msdkvpp_class_init (GstMsdkVPPClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+  GstBaseTransformClass *trans_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
+  trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+
+  gst_msdk_surface_memory_init_once ();
+
+  gobject_class->set_property = gst_msdkvpp_set_property;
+  gobject_class->get_property = gst_msdkvpp_get_property;
+  gobject_class->finalize = gst_msdkvpp_finalize;
+
+  trans_class->stop = GST_DEBUG_FUNCPTR (gst_msdkvpp_stop);
+  trans_class->transform_caps = GST_DEBUG_FUNCPTR (gst_msdkvpp_transform_caps);
+  trans_class->fixate_caps = GST_DEBUG_FUNCPTR (gst_msdkvpp_fixate_caps);
+  trans_class->set_caps = GST_DEBUG_FUNCPTR (gst_msdkvpp_set_caps);
+  trans_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_msdkvpp_propose_allocation);
+  trans_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_msdkvpp_decide_allocation);
+  trans_class->prepare_output_buffer =
+      GST_DEBUG_FUNCPTR (gst_msdkvpp_prepare_output_buffer);
+  trans_class->transform = GST_DEBUG_FUNCPTR (gst_msdkvpp_transform);
+
+  g_object_class_install_property (gobject_class, PROP_HARDWARE,
+      g_param_spec_boolean ("hardware", "Hardware",
+          "Enable hardware video processing",
+          PROP_HARDWARE_DEFAULT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ASYNC_DEPTH,
+      g_param_spec_uint ("async-depth", "Async Depth",
+          "Depth of asynchronous pipeline",
+          1, 20, PROP_ASYNC_DEPTH_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DEINTERLACE_MODE,
+      g_param_spec_enum ("deinterlace-mode", "Deinterlace Mode",
+          "Deinterlacing method used for interlaced input",
+          GST_MSDKVPP_DEINTERLACE_MODE_TYPE, PROP_DEINTERLACE_MODE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DENOISE,
+      g_param_spec_uint ("denoise", "Denoise",
+          "Denoising strength (0: disabled)",
+          0, 100, PROP_DENOISE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (element_class,
+      "Intel MSDK video postprocessor",
+      "Filter/Converter/Video/Scaler/Hardware",
+      "Video scaling, color conversion, deinterlacing and denoising based on "
+      "Intel Media SDK", "Scott D Phillips <scott.d.phillips@intel.com>");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_factory);
+  gst_element_class_add_static_pad_template (element_class, &src_factory);
+}
+
+static void
+gst_msdkvpp_init (GstMsdkVPP * thiz)
+{
+  gst_video_info_init (&thiz->sinkpad_info);
+  gst_video_info_init (&thiz->srcpad_info);
+  thiz->in_surfaces = g_array_new (FALSE, TRUE, sizeof (MsdkVPPSurface));
+  g_array_set_clear_func (thiz->in_surfaces, clear_surface);
+  thiz->out_surfaces = g_array_new (FALSE, TRUE, sizeof (MsdkVPPSurface));
+  g_array_set_clear_func (thiz->out_surfaces, clear_surface);
+  thiz->hardware = PROP_HARDWARE_DEFAULT;
+  thiz->async_depth = PROP_ASYNC_DEPTH_DEFAULT;
+  thiz->deinterlace_mode = PROP_DEINTERLACE_MODE_DEFAULT;
+  thiz->denoise_factor = PROP_DENOISE_DEFAULT;
+}
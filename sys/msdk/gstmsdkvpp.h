@@ -0,0 +1,114 @@
+/* GStreamer Intel MSDK plugin
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __GST_MSDKVPP_H__
+#define __GST_MSDKVPP_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/video/video.h>
+#include "msdk.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_MSDKVPP \
+  (gst_msdkvpp_get_type())
+#define GST_MSDKVPP(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_MSDKVPP,GstMsdkVPP))
+#define GST_MSDKVPP_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_MSDKVPP,GstMsdkVPPClass))
+#define GST_IS_MSDKVPP(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_MSDKVPP))
+#define GST_IS_MSDKVPP_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_MSDKVPP))
+
+typedef struct _GstMsdkVPP GstMsdkVPP;
+typedef struct _GstMsdkVPPClass GstMsdkVPPClass;
+typedef struct _MsdkVPPSurface MsdkVPPSurface;
+
+typedef enum
+{
+  GST_MSDKVPP_DEINTERLACE_MODE_BOB,
+  GST_MSDKVPP_DEINTERLACE_MODE_ADVANCED,
+} GstMsdkVPPDeinterlaceMode;
+
+struct _GstMsdkVPP
+{
+  GstBaseTransform element;
+
+  GstVideoInfo sinkpad_info;
+  GstVideoInfo srcpad_info;
+  /* both frames in video memory, processed without waiting */
+  gboolean use_video_memory_in;
+  gboolean use_video_memory_out;
+  guint downstream_buffers;
+
+  /* aligned system memory buffers, copied from or into when the peer
+   * can't use them */
+  GstBufferPool *sinkpad_pool;
+  GstVideoInfo sinkpad_pool_info;
+  GstBufferPool *srcpad_pool;
+  GstVideoInfo srcpad_pool_info;
+
+  /* MFX context */
+  MsdkContext *context;
+  mfxVideoParam param;
+  mfxExtBuffer *extra_params[2];
+  mfxExtVPPDeinterlacing deinterlace;
+  mfxExtVPPDenoise denoise;
+  mfxFrameAllocRequest request[2];
+  GArray *in_surfaces;
+  GArray *out_surfaces;
+
+  /* element properties */
+  gboolean hardware;
+  guint async_depth;
+  GstMsdkVPPDeinterlaceMode deinterlace_mode;
+  guint denoise_factor;
+};
+
+struct _GstMsdkVPPClass
+{
+  GstBaseTransformClass parent_class;
+};
+
+/* a surface and the buffer it is processed from or into */
+struct _MsdkVPPSurface
+{
+  mfxFrameSurface1 surface;
+  GstBuffer *buffer;
+  /* in video memory, the output surface as handed to downstream */
+  GstMemory *mem;
+};
+
+GType gst_msdkvpp_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_MSDKVPP_H__ */
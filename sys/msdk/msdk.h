@@ -48,9 +48,19 @@ void msdk_close_session (mfxSession session);
 gboolean msdk_is_available (void);
 
 MsdkContext *msdk_open_context (gboolean hardware);
+MsdkContext *msdk_context_ref (MsdkContext * context);
 void msdk_close_context (MsdkContext * context);
 mfxSession msdk_context_get_session (MsdkContext * context);
 
+/* frames in video memory, shared by all the contexts of the process */
+gboolean msdk_context_use_video_memory (MsdkContext * context);
+mfxStatus msdk_context_alloc_frames (MsdkContext * context,
+    mfxFrameAllocRequest * request, mfxFrameAllocResponse * response);
+gboolean msdk_context_map_frame (MsdkContext * context, mfxMemId mid,
+    mfxFrameData * data);
+void msdk_context_unmap_frame (MsdkContext * context, mfxMemId mid,
+    mfxFrameData * data);
+
 mfxFrameSurface1 *msdk_get_free_surface (mfxFrameSurface1 * surfaces,
     guint size);
 void msdk_frame_to_surface (GstVideoFrame * frame, mfxFrameSurface1 * surface);
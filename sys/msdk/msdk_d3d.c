@@ -48,3 +48,38 @@ msdk_context_get_session (MsdkContext * context)
 {
   return (mfxSession) context;
 }
+
+/* The context is the bare session here, which can't be shared. Frames are
+ * always in system memory on Windows, so no surface memory ever holds a
+ * reference on the context. */
+MsdkContext *
+msdk_context_ref (MsdkContext * context)
+{
+  g_return_val_if_reached (NULL);
+}
+
+gboolean
+msdk_context_use_video_memory (MsdkContext * context)
+{
+  return FALSE;
+}
+
+mfxStatus
+msdk_context_alloc_frames (MsdkContext * context,
+    mfxFrameAllocRequest * request, mfxFrameAllocResponse * response)
+{
+  return MFX_ERR_UNSUPPORTED;
+}
+
+gboolean
+msdk_context_map_frame (MsdkContext * context, mfxMemId mid,
+    mfxFrameData * data)
+{
+  return FALSE;
+}
+
+void
+msdk_context_unmap_frame (MsdkContext * context, mfxMemId mid,
+    mfxFrameData * data)
+{
+}
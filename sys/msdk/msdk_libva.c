@@ -43,67 +43,289 @@
 GST_DEBUG_CATEGORY_EXTERN (gst_msdkenc_debug);
 #define GST_CAT_DEFAULT gst_msdkenc_debug
 
+/* the mfxMemId of the frames in video memory */
+typedef struct
+{
+  VASurfaceID surface;
+  VAImage image;
+} MsdkVaSurface;
+
 struct _MsdkContext
 {
   mfxSession session;
-  gint fd;
   VADisplay dpy;
+  gint refcount;
+
+  mfxFrameAllocator allocator;
+
+  /* the decoder or VPP and the application share the surfaces output
+   * into */
+  mfxFrameAllocResponse output_response;
+  guint output_response_refs;
 };
 
-static gboolean
-msdk_use_vaapi_on_context (MsdkContext * context)
+/* All the contexts of the process use the same VA display, so that the
+ * surfaces of a decoder can be encoded from directly */
+static GMutex display_lock;
+static VADisplay display;
+static gint display_fd = -1;
+static guint display_refs;
+
+static VADisplay
+msdk_display_ref (void)
 {
-  gint fd;
   gint maj_ver, min_ver;
   VADisplay va_dpy = NULL;
   VAStatus va_status;
-  mfxStatus status;
+  gint fd;
   /* maybe /dev/dri/renderD128 */
   static const gchar *dri_path = "/dev/dri/card0";
 
+  g_mutex_lock (&display_lock);
+  if (display) {
+    display_refs++;
+    va_dpy = display;
+    goto done;
+  }
+
   fd = open (dri_path, O_RDWR);
   if (fd < 0) {
     GST_ERROR ("Couldn't open %s", dri_path);
-    return FALSE;
+    goto done;
   }
 
   va_dpy = vaGetDisplayDRM (fd);
   if (!va_dpy) {
     GST_ERROR ("Couldn't get a VA DRM display");
-    goto failed;
+    close (fd);
+    goto done;
   }
 
   va_status = vaInitialize (va_dpy, &maj_ver, &min_ver);
   if (va_status != VA_STATUS_SUCCESS) {
     GST_ERROR ("Couldn't initialize VA DRM display");
-    goto failed;
+    vaTerminate (va_dpy);
+    close (fd);
+    va_dpy = NULL;
+    goto done;
+  }
+
+  display = va_dpy;
+  display_fd = fd;
+  display_refs = 1;
+
+done:
+  g_mutex_unlock (&display_lock);
+  return va_dpy;
+}
+
+static void
+msdk_display_unref (void)
+{
+  g_mutex_lock (&display_lock);
+  if (--display_refs == 0) {
+    vaTerminate (display);
+    close (display_fd);
+    display = NULL;
+    display_fd = -1;
   }
+  g_mutex_unlock (&display_lock);
+}
+
+static gboolean
+msdk_use_vaapi_on_context (MsdkContext * context)
+{
+  VADisplay va_dpy;
+  mfxStatus status;
+
+  va_dpy = msdk_display_ref ();
+  if (!va_dpy)
+    return FALSE;
 
   status = MFXVideoCORE_SetHandle (context->session, MFX_HANDLE_VA_DISPLAY,
       (mfxHDL) va_dpy);
   if (status != MFX_ERR_NONE) {
     GST_ERROR ("Setting VAAPI handle failed (%s)",
         msdk_status_to_string (status));
-    goto failed;
+    msdk_display_unref ();
+    return FALSE;
   }
 
-  context->fd = fd;
   context->dpy = va_dpy;
 
   return TRUE;
+}
 
-failed:
-  if (va_dpy)
-    vaTerminate (va_dpy);
-  close (fd);
-  return FALSE;
+static void
+msdk_destroy_frames (MsdkContext * context, mfxFrameAllocResponse * response)
+{
+  VASurfaceID *surfaces;
+  guint i;
+
+  surfaces = g_new (VASurfaceID, response->NumFrameActual);
+  for (i = 0; i < response->NumFrameActual; i++)
+    surfaces[i] = ((MsdkVaSurface *) response->mids[i])->surface;
+
+  vaDestroySurfaces (context->dpy, surfaces, response->NumFrameActual);
+
+  g_free (surfaces);
+  g_free (response->mids[0]);
+  g_free (response->mids);
+  memset (response, 0, sizeof (*response));
+}
+
+/* the surfaces the application gets the output of an operation in */
+static inline gboolean
+msdk_is_output_request (mfxFrameAllocRequest * request)
+{
+  return (request->Type & MFX_MEMTYPE_EXTERNAL_FRAME)
+      && (request->Type & (MFX_MEMTYPE_FROM_DECODE | MFX_MEMTYPE_FROM_VPPOUT));
+}
+
+static mfxStatus
+msdk_frame_alloc (mfxHDL pthis, mfxFrameAllocRequest * request,
+    mfxFrameAllocResponse * response)
+{
+  MsdkContext *context = pthis;
+  VASurfaceAttrib attrib;
+  VASurfaceID *surfaces;
+  MsdkVaSurface *frames;
+  VAStatus va_status;
+  guint i, n;
+
+  if (!(request->Type & (MFX_MEMTYPE_VIDEO_MEMORY_DECODER_TARGET |
+              MFX_MEMTYPE_VIDEO_MEMORY_PROCESSOR_TARGET)))
+    return MFX_ERR_UNSUPPORTED;
+  if (request->Info.FourCC != MFX_FOURCC_NV12)
+    return MFX_ERR_UNSUPPORTED;
+
+  if (msdk_is_output_request (request) && context->output_response_refs > 0) {
+    if (request->NumFrameMin > context->output_response.NumFrameActual)
+      return MFX_ERR_MEMORY_ALLOC;
+    context->output_response_refs++;
+    *response = context->output_response;
+    return MFX_ERR_NONE;
+  }
+
+  n = request->NumFrameSuggested;
+  surfaces = g_new (VASurfaceID, n);
+
+  attrib.type = VASurfaceAttribPixelFormat;
+  attrib.flags = VA_SURFACE_ATTRIB_SETTABLE;
+  attrib.value.type = VAGenericValueTypeInteger;
+  attrib.value.value.i = VA_FOURCC_NV12;
+
+  va_status = vaCreateSurfaces (context->dpy, VA_RT_FORMAT_YUV420,
+      request->Info.Width, request->Info.Height, surfaces, n, &attrib, 1);
+  if (va_status != VA_STATUS_SUCCESS) {
+    GST_ERROR ("Failed to create %u VA surfaces (%s)", n,
+        vaErrorStr (va_status));
+    g_free (surfaces);
+    return MFX_ERR_MEMORY_ALLOC;
+  }
+
+  frames = g_new0 (MsdkVaSurface, n);
+  response->mids = g_new (mfxMemId, n);
+  for (i = 0; i < n; i++) {
+    frames[i].surface = surfaces[i];
+    frames[i].image.image_id = VA_INVALID_ID;
+    response->mids[i] = &frames[i];
+  }
+  response->NumFrameActual = n;
+  g_free (surfaces);
+
+  GST_DEBUG ("allocated %u %ux%u VA surfaces for type 0x%x", n,
+      request->Info.Width, request->Info.Height, request->Type);
+
+  if (msdk_is_output_request (request)) {
+    context->output_response = *response;
+    context->output_response_refs = 1;
+  }
+
+  return MFX_ERR_NONE;
+}
+
+static mfxStatus
+msdk_frame_free (mfxHDL pthis, mfxFrameAllocResponse * response)
+{
+  MsdkContext *context = pthis;
+
+  if (!response->mids)
+    return MFX_ERR_NONE;
+
+  if (response->mids == context->output_response.mids) {
+    if (--context->output_response_refs > 0)
+      return MFX_ERR_NONE;
+    memset (&context->output_response, 0, sizeof (context->output_response));
+  }
+
+  msdk_destroy_frames (context, response);
+
+  return MFX_ERR_NONE;
+}
+
+static mfxStatus
+msdk_frame_lock (mfxHDL pthis, mfxMemId mid, mfxFrameData * data)
+{
+  MsdkContext *context = pthis;
+  MsdkVaSurface *frame = mid;
+  guint8 *buf;
+
+  if (vaDeriveImage (context->dpy, frame->surface,
+          &frame->image) != VA_STATUS_SUCCESS)
+    return MFX_ERR_LOCK_MEMORY;
+
+  if (vaMapBuffer (context->dpy, frame->image.buf,
+          (void **) &buf) != VA_STATUS_SUCCESS) {
+    vaDestroyImage (context->dpy, frame->image.image_id);
+    frame->image.image_id = VA_INVALID_ID;
+    return MFX_ERR_LOCK_MEMORY;
+  }
+
+  data->Pitch = frame->image.pitches[0];
+  data->Y = buf + frame->image.offsets[0];
+  data->UV = buf + frame->image.offsets[1];
+
+  return MFX_ERR_NONE;
+}
+
+static mfxStatus
+msdk_frame_unlock (mfxHDL pthis, mfxMemId mid, mfxFrameData * data)
+{
+  MsdkContext *context = pthis;
+  MsdkVaSurface *frame = mid;
+
+  if (frame->image.image_id == VA_INVALID_ID)
+    return MFX_ERR_NONE;
+
+  vaUnmapBuffer (context->dpy, frame->image.buf);
+  vaDestroyImage (context->dpy, frame->image.image_id);
+  frame->image.image_id = VA_INVALID_ID;
+
+  if (data) {
+    data->Pitch = 0;
+    data->Y = NULL;
+    data->UV = NULL;
+  }
+
+  return MFX_ERR_NONE;
+}
+
+static mfxStatus
+msdk_frame_get_hdl (mfxHDL pthis, mfxMemId mid, mfxHDL * hdl)
+{
+  MsdkVaSurface *frame = mid;
+
+  *hdl = &frame->surface;
+
+  return MFX_ERR_NONE;
 }
 
 MsdkContext *
 msdk_open_context (gboolean hardware)
 {
   MsdkContext *context = g_slice_new0 (MsdkContext);
-  context->fd = -1;
+  context->refcount = 1;
 
   context->session = msdk_open_session (hardware);
   if (!context->session)
@@ -122,17 +344,29 @@ failed:
   return NULL;
 }
 
+MsdkContext *
+msdk_context_ref (MsdkContext * context)
+{
+  g_atomic_int_inc (&context->refcount);
+
+  return context;
+}
+
 void
 msdk_close_context (MsdkContext * context)
 {
   if (!context)
     return;
 
+  if (!g_atomic_int_dec_and_test (&context->refcount))
+    return;
+
   msdk_close_session (context->session);
+  /* the surfaces given out to the application outlive the decoder */
+  if (context->output_response_refs > 0)
+    msdk_destroy_frames (context, &context->output_response);
   if (context->dpy)
-    vaTerminate (context->dpy);
-  if (context->fd >= 0)
-    close (context->fd);
+    msdk_display_unref ();
   g_slice_free (MsdkContext, context);
 }
 
@@ -141,3 +375,50 @@ msdk_context_get_session (MsdkContext * context)
 {
   return context->session;
 }
+
+gboolean
+msdk_context_use_video_memory (MsdkContext * context)
+{
+  mfxStatus status;
+
+  if (!context->dpy)
+    return FALSE;
+
+  context->allocator.pthis = context;
+  context->allocator.Alloc = msdk_frame_alloc;
+  context->allocator.Lock = msdk_frame_lock;
+  context->allocator.Unlock = msdk_frame_unlock;
+  context->allocator.GetHDL = msdk_frame_get_hdl;
+  context->allocator.Free = msdk_frame_free;
+
+  status = MFXVideoCORE_SetFrameAllocator (context->session,
+      &context->allocator);
+  if (status != MFX_ERR_NONE) {
+    GST_ERROR ("Setting frame allocator failed (%s)",
+        msdk_status_to_string (status));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+mfxStatus
+msdk_context_alloc_frames (MsdkContext * context,
+    mfxFrameAllocRequest * request, mfxFrameAllocResponse * response)
+{
+  return msdk_frame_alloc (context, request, response);
+}
+
+gboolean
+msdk_context_map_frame (MsdkContext * context, mfxMemId mid,
+    mfxFrameData * data)
+{
+  return msdk_frame_lock (context, mid, data) == MFX_ERR_NONE;
+}
+
+void
+msdk_context_unmap_frame (MsdkContext * context, mfxMemId mid,
+    mfxFrameData * data)
+{
+  msdk_frame_unlock (context, mid, data);
+}
@@ -0,0 +1,387 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcudamemory.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_cuda_memory_debug);
+#define GST_CAT_DEFAULT gst_cuda_memory_debug
+
+typedef struct _GstCudaAllocator GstCudaAllocator;
+typedef struct _GstCudaAllocatorClass GstCudaAllocatorClass;
+
+struct _GstCudaAllocator
+{
+  GstAllocator parent;
+};
+
+struct _GstCudaAllocatorClass
+{
+  GstAllocatorClass parent_class;
+};
+
+static GType gst_cuda_allocator_get_type (void);
+G_DEFINE_TYPE (GstCudaAllocator, gst_cuda_allocator, GST_TYPE_ALLOCATOR);
+
+static GstAllocator *_cuda_allocator;
+
+static inline gboolean
+cuda_OK (CUresult result)
+{
+  const gchar *error_name, *error_text;
+
+  if (result != CUDA_SUCCESS) {
+    cuGetErrorName (result, &error_name);
+    cuGetErrorString (result, &error_text);
+    GST_WARNING ("CUDA call failed: %s, %s", error_name, error_text);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static guint
+_plane_height (GstVideoInfo * info, guint plane)
+{
+  guint i;
+
+  for (i = 0; i < GST_VIDEO_INFO_N_COMPONENTS (info); i++) {
+    if (GST_VIDEO_FORMAT_INFO_PLANE (info->finfo, i) == plane)
+      return GST_VIDEO_INFO_COMP_HEIGHT (info, i);
+  }
+
+  return 0;
+}
+
+static gpointer
+_cuda_mem_map_full (GstCudaMemory * mem, GstMapInfo * info, gsize maxsize)
+{
+  gpointer ret = NULL;
+
+  if ((info->flags & GST_MAP_CUDA) == GST_MAP_CUDA)
+    return (gpointer) (guintptr) mem->data;
+
+  /* a copy in host memory, for the elements that don't know about CUDA */
+  g_mutex_lock (&mem->lock);
+  if (!cuda_OK (cuCtxPushCurrent (mem->context)))
+    goto done;
+
+  if (!mem->host_data
+      && !cuda_OK (cuMemAllocHost (&mem->host_data, mem->mem.maxsize))) {
+    mem->host_data = NULL;
+    goto pop;
+  }
+
+  if ((info->flags & GST_MAP_READ) == GST_MAP_READ
+      && !cuda_OK (cuMemcpyDtoH (mem->host_data, mem->data, maxsize)))
+    goto pop;
+
+  ret = mem->host_data;
+
+pop:
+  cuCtxPopCurrent (NULL);
+done:
+  g_mutex_unlock (&mem->lock);
+
+  return ret;
+}
+
+static void
+_cuda_mem_unmap_full (GstCudaMemory * mem, GstMapInfo * info)
+{
+  if ((info->flags & GST_MAP_CUDA) == GST_MAP_CUDA)
+    return;
+
+  if ((info->flags & GST_MAP_WRITE) != GST_MAP_WRITE)
+    return;
+
+  g_mutex_lock (&mem->lock);
+  if (cuda_OK (cuCtxPushCurrent (mem->context))) {
+    if (!cuda_OK (cuMemcpyHtoD (mem->data, mem->host_data, mem->mem.maxsize)))
+      GST_WARNING ("failed to upload %p to the device", mem);
+    cuCtxPopCurrent (NULL);
+  }
+  g_mutex_unlock (&mem->lock);
+}
+
+static GstMemory *
+_cuda_mem_copy (GstCudaMemory * src, gssize offset, gssize size)
+{
+  GstCudaMemory *dest;
+
+  if (offset != 0 || (size != -1 && size != src->mem.size))
+    return NULL;
+
+  dest = (GstCudaMemory *) gst_cuda_memory_alloc (src->context, &src->info);
+  if (!dest)
+    return NULL;
+
+  if (!cuda_OK (cuCtxPushCurrent (src->context))) {
+    gst_memory_unref (GST_MEMORY_CAST (dest));
+    return NULL;
+  }
+  if (!cuda_OK (cuMemcpyDtoD (dest->data, src->data, src->mem.maxsize))) {
+    gst_memory_unref (GST_MEMORY_CAST (dest));
+    dest = NULL;
+  }
+  cuCtxPopCurrent (NULL);
+
+  return GST_MEMORY_CAST (dest);
+}
+
+static GstMemory *
+gst_cuda_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  g_warning ("Use gst_cuda_memory_alloc () to allocate from this allocator");
+
+  return NULL;
+}
+
+static void
+gst_cuda_allocator_free (GstAllocator * allocator, GstMemory * memory)
+{
+  GstCudaMemory *mem = (GstCudaMemory *) memory;
+
+  if (cuda_OK (cuCtxPushCurrent (mem->context))) {
+    cuda_OK (cuMemFree (mem->data));
+    if (mem->host_data)
+      cuda_OK (cuMemFreeHost (mem->host_data));
+    cuCtxPopCurrent (NULL);
+  }
+
+  g_mutex_clear (&mem->lock);
+  g_slice_free (GstCudaMemory, mem);
+}
+
+static void
+gst_cuda_allocator_class_init (GstCudaAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_cuda_allocator_alloc;
+  allocator_class->free = gst_cuda_allocator_free;
+}
+
+static void
+gst_cuda_allocator_init (GstCudaAllocator * allocator)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (allocator);
+
+  alloc->mem_type = GST_CUDA_MEMORY_TYPE_NAME;
+  alloc->mem_map_full = (GstMemoryMapFullFunction) _cuda_mem_map_full;
+  alloc->mem_unmap_full = (GstMemoryUnmapFullFunction) _cuda_mem_unmap_full;
+  alloc->mem_copy = (GstMemoryCopyFunction) _cuda_mem_copy;
+
+  GST_OBJECT_FLAG_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+/**
+ * gst_cuda_memory_init_once:
+ *
+ * Initializes the CUDA memory allocator. It is safe to call this function
+ * multiple times. This must be called before any other GstCudaMemory
+ * operation.
+ */
+void
+gst_cuda_memory_init_once (void)
+{
+  static volatile gsize _init = 0;
+
+  if (g_once_init_enter (&_init)) {
+    GST_DEBUG_CATEGORY_INIT (gst_cuda_memory_debug, "cudamemory", 0,
+        "CUDA Memory");
+
+    _cuda_allocator = g_object_new (gst_cuda_allocator_get_type (), NULL);
+    gst_object_ref_sink (_cuda_allocator);
+    gst_allocator_register (GST_CUDA_MEMORY_TYPE_NAME,
+        gst_object_ref (_cuda_allocator));
+
+    g_once_init_leave (&_init, 1);
+  }
+}
+
+/**
+ * gst_cuda_memory_alloc:
+ * @context: the CUDA context to allocate in
+ * @info: the #GstVideoInfo of the frame
+ *
+ * Allocates device memory for a frame described by @info. All the planes
+ * share one pitch: the strides and offsets of the resulting layout are in
+ * the info of the returned memory.
+ *
+ * Returns: (transfer full): a new #GstCudaMemory or %NULL on failure.
+ */
+GstMemory *
+gst_cuda_memory_alloc (CUcontext context, GstVideoInfo * info)
+{
+  GstCudaMemory *mem;
+  CUdeviceptr data;
+  gsize width = 0, rows = 0, pitch, offset;
+  guint i;
+
+  gst_cuda_memory_init_once ();
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (info); i++) {
+    width = MAX (width, GST_VIDEO_INFO_PLANE_STRIDE (info, i));
+    rows += _plane_height (info, i);
+  }
+
+  if (!cuda_OK (cuCtxPushCurrent (context)))
+    return NULL;
+  if (!cuda_OK (cuMemAllocPitch (&data, &pitch, width, rows, 16))) {
+    cuCtxPopCurrent (NULL);
+    return NULL;
+  }
+  cuCtxPopCurrent (NULL);
+
+  mem = g_slice_new0 (GstCudaMemory);
+  mem->context = context;
+  mem->data = data;
+  mem->pitch = pitch;
+  mem->info = *info;
+  g_mutex_init (&mem->lock);
+
+  for (i = 0, offset = 0; i < GST_VIDEO_INFO_N_PLANES (info); i++) {
+    GST_VIDEO_INFO_PLANE_OFFSET (&mem->info, i) = offset;
+    GST_VIDEO_INFO_PLANE_STRIDE (&mem->info, i) = pitch;
+    offset += pitch * _plane_height (info, i);
+  }
+  GST_VIDEO_INFO_SIZE (&mem->info) = offset;
+
+  gst_memory_init (GST_MEMORY_CAST (mem), 0, _cuda_allocator, NULL, offset, 0,
+      0, offset);
+
+  GST_LOG ("allocated %" G_GSIZE_FORMAT " bytes with pitch %" G_GSIZE_FORMAT
+      " at 0x%" G_GINT64_MODIFIER "x", offset, pitch, (guint64) data);
+
+  return GST_MEMORY_CAST (mem);
+}
+
+G_DEFINE_TYPE (GstCudaBufferPool, gst_cuda_buffer_pool, GST_TYPE_BUFFER_POOL);
+
+static const gchar **
+gst_cuda_buffer_pool_get_options (GstBufferPool * pool)
+{
+  static const gchar *options[] = { GST_BUFFER_POOL_OPTION_VIDEO_META, NULL };
+
+  return options;
+}
+
+static gboolean
+gst_cuda_buffer_pool_set_config (GstBufferPool * pool, GstStructure * config)
+{
+  GstCudaBufferPool *cpool = GST_CUDA_BUFFER_POOL (pool);
+  guint min_buffers, max_buffers;
+  GstCaps *caps = NULL;
+  GstMemory *mem;
+  gsize size;
+
+  if (!gst_buffer_pool_config_get_params (config, &caps, NULL, &min_buffers,
+          &max_buffers) || caps == NULL) {
+    GST_WARNING_OBJECT (pool, "invalid config");
+    return FALSE;
+  }
+
+  if (!gst_video_info_from_caps (&cpool->info, caps)) {
+    GST_WARNING_OBJECT (pool, "failed getting video info from caps %"
+        GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+
+  /* the pitch chosen by the driver is only known after an allocation, and
+   * the pool drops released buffers that don't have its size */
+  mem = gst_cuda_memory_alloc (cpool->context, &cpool->info);
+  if (!mem) {
+    GST_WARNING_OBJECT (pool, "failed to allocate CUDA memory");
+    return FALSE;
+  }
+  size = mem->size;
+  gst_memory_unref (mem);
+
+  gst_buffer_pool_config_set_params (config, caps, size, min_buffers,
+      max_buffers);
+
+  return GST_BUFFER_POOL_CLASS (gst_cuda_buffer_pool_parent_class)->set_config
+      (pool, config);
+}
+
+static GstFlowReturn
+gst_cuda_buffer_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstCudaBufferPool *cpool = GST_CUDA_BUFFER_POOL (pool);
+  GstVideoInfo *info = &cpool->info;
+  GstCudaMemory *mem;
+  GstBuffer *buf;
+
+  mem = (GstCudaMemory *) gst_cuda_memory_alloc (cpool->context, info);
+  if (!mem) {
+    GST_WARNING_OBJECT (pool, "failed to allocate CUDA memory");
+    return GST_FLOW_ERROR;
+  }
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, GST_MEMORY_CAST (mem));
+  gst_buffer_add_video_meta_full (buf, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+      GST_VIDEO_INFO_HEIGHT (info), GST_VIDEO_INFO_N_PLANES (info),
+      mem->info.offset, mem->info.stride);
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_cuda_buffer_pool_class_init (GstCudaBufferPoolClass * klass)
+{
+  GstBufferPoolClass *pool_class = (GstBufferPoolClass *) klass;
+
+  pool_class->get_options = gst_cuda_buffer_pool_get_options;
+  pool_class->set_config = gst_cuda_buffer_pool_set_config;
+  pool_class->alloc_buffer = gst_cuda_buffer_pool_alloc_buffer;
+}
+
+static void
+gst_cuda_buffer_pool_init (GstCudaBufferPool * pool)
+{
+}
+
+/**
+ * gst_cuda_buffer_pool_new:
+ * @context: the CUDA context to allocate in
+ *
+ * Returns: (transfer full): a #GstBufferPool of #GstCudaMemory frames
+ */
+GstBufferPool *
+gst_cuda_buffer_pool_new (CUcontext context)
+{
+  GstCudaBufferPool *pool;
+
+  gst_cuda_memory_init_once ();
+
+  pool = g_object_new (GST_TYPE_CUDA_BUFFER_POOL, NULL);
+  gst_object_ref_sink (pool);
+  pool->context = context;
+
+  return GST_BUFFER_POOL_CAST (pool);
+}
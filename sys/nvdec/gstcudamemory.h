@@ -0,0 +1,99 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CUDA_MEMORY_H__
+#define __GST_CUDA_MEMORY_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <cuda.h>
+
+G_BEGIN_DECLS
+
+/* Frames in CUDA device memory, allocated by nvdec and consumed in place by
+ * nvenc. The two plugins are built separately, so nvenc only relies on this
+ * header: memories are recognized by their type name and the layout of
+ * GstCudaMemory must stay compatible between them.
+ *
+ * Both elements use the primary context of the device, so the device
+ * pointers are valid in either of them. */
+
+#define GST_CUDA_MEMORY_TYPE_NAME "CUDAMemory"
+#define GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY "memory:" GST_CUDA_MEMORY_TYPE_NAME
+
+/* maps the device pointer instead of a copy of the data in host memory */
+#define GST_MAP_CUDA (GST_MAP_FLAG_LAST << 1)
+
+typedef struct _GstCudaMemory GstCudaMemory;
+
+/* all the planes are in one pitch-linear allocation, one after the other,
+ * which is the layout nvEncRegisterResource expects */
+struct _GstCudaMemory
+{
+  GstMemory mem;
+
+  CUcontext context;
+  CUdeviceptr data;
+  gsize pitch;
+  GstVideoInfo info;
+
+  /*< private >*/
+  GMutex lock;
+  gpointer host_data;
+  GstMapFlags host_map_flags;
+};
+
+static inline gboolean
+gst_is_cuda_memory (GstMemory * mem)
+{
+  return mem != NULL && mem->allocator != NULL &&
+      g_strcmp0 (mem->allocator->mem_type, GST_CUDA_MEMORY_TYPE_NAME) == 0;
+}
+
+void            gst_cuda_memory_init_once   (void);
+GstMemory *     gst_cuda_memory_alloc       (CUcontext context,
+                                             GstVideoInfo * info);
+
+#define GST_TYPE_CUDA_BUFFER_POOL      (gst_cuda_buffer_pool_get_type())
+#define GST_IS_CUDA_BUFFER_POOL(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_CUDA_BUFFER_POOL))
+#define GST_CUDA_BUFFER_POOL(obj)      (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_CUDA_BUFFER_POOL, GstCudaBufferPool))
+
+typedef struct _GstCudaBufferPool GstCudaBufferPool;
+typedef struct _GstCudaBufferPoolClass GstCudaBufferPoolClass;
+
+struct _GstCudaBufferPool
+{
+  GstBufferPool parent;
+
+  CUcontext context;
+
+  /*< private >*/
+  GstVideoInfo info;
+};
+
+struct _GstCudaBufferPoolClass
+{
+  GstBufferPoolClass parent_class;
+};
+
+GType           gst_cuda_buffer_pool_get_type (void);
+GstBufferPool * gst_cuda_buffer_pool_new      (CUcontext context);
+
+G_END_DECLS
+
+#endif /* __GST_CUDA_MEMORY_H__ */
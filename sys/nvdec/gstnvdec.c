@@ -30,6 +30,7 @@
 #endif
 
 #include "gstnvdec.h"
+#include "gstcudamemory.h"
 
 #include <cudaGL.h>
 
@@ -80,11 +81,11 @@ gst_nvdec_cuda_context_finalize (GObject * object)
   }
 
   if (self->context) {
-    GST_DEBUG ("destroying CUDA context");
-    if (cuda_OK (cuCtxDestroy (self->context)))
+    GST_DEBUG ("releasing CUDA context");
+    if (cuda_OK (cuDevicePrimaryCtxRelease (self->device)))
       self->context = NULL;
     else
-      GST_ERROR ("failed to destroy CUDA context");
+      GST_ERROR ("failed to release CUDA context");
   }
 
   G_OBJECT_CLASS (gst_nvdec_cuda_context_parent_class)->finalize (object);
@@ -102,11 +103,14 @@ gst_nvdec_cuda_context_init (GstNvDecCudaContext * self)
   if (!cuda_OK (cuInit (0)))
     GST_ERROR ("failed to init CUDA");
 
-  if (!cuda_OK (cuCtxCreate (&self->context, CU_CTX_SCHED_AUTO, 0)))
-    GST_ERROR ("failed to create CUDA context");
-
-  if (!cuda_OK (cuCtxPopCurrent (NULL)))
-    GST_ERROR ("failed to pop current CUDA context");
+  /* the primary context is shared with the other CUDA users of the process,
+   * nvenc in particular, so that they can use our device memory directly */
+  if (!cuda_OK (cuDeviceGet (&self->device, 0))
+      || !cuda_OK (cuDevicePrimaryCtxRetain (&self->context, self->device))) {
+    GST_ERROR ("failed to retain CUDA context");
+    self->context = NULL;
+    return;
+  }
 
   if (!cuda_OK (cuvidCtxLockCreate (&self->lock, self->context)))
     GST_ERROR ("failed to create CUDA context lock");
@@ -229,6 +233,8 @@ static GstStaticPadTemplate gst_nvdec_src_template =
 GST_STATIC_PAD_TEMPLATE (GST_VIDEO_DECODER_SRC_NAME,
     GST_PAD_SRC, GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY, "NV12") "; "
+        GST_VIDEO_CAPS_MAKE_WITH_FEATURES
         (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, "NV12") ", texture-target=2D")
     );
 
@@ -261,6 +267,8 @@ gst_nvdec_class_init (GstNvDecClass * klass)
   video_decoder_class->src_query = GST_DEBUG_FUNCPTR (gst_nvdec_src_query);
 
   element_class->set_context = GST_DEBUG_FUNCPTR (gst_nvdec_set_context);
+
+  gst_cuda_memory_init_once ();
 }
 
 static void
@@ -626,6 +634,90 @@ unlock_cuda_context:
     GST_WARNING_OBJECT (nvdec, "failed to unlock CUDA context");
 }
 
+/* the decoded surfaces are only valid while mapped, so they are still copied
+ * but without leaving the GPU */
+static gboolean
+copy_video_frame_to_cuda_memory (GstNvDec * nvdec,
+    CUVIDPARSERDISPINFO * dispinfo, GstBuffer * buffer)
+{
+  GstMemory *mem = gst_buffer_peek_memory (buffer, 0);
+  GstCudaMemory *cuda_mem = (GstCudaMemory *) mem;
+  CUVIDPROCPARAMS proc_params = { 0, };
+  CUDA_MEMCPY2D mcpy2d = { 0, };
+  gboolean ret = FALSE;
+  CUdeviceptr dptr;
+  guint pitch, i;
+
+  if (!gst_is_cuda_memory (mem)) {
+    GST_WARNING_OBJECT (nvdec, "output buffer is not in CUDA memory");
+    return FALSE;
+  }
+
+  proc_params.progressive_frame = dispinfo->progressive_frame;
+  proc_params.top_field_first = dispinfo->top_field_first;
+  proc_params.unpaired_field = dispinfo->repeat_first_field == -1;
+
+  if (!cuda_OK (cuvidCtxLock (nvdec->cuda_context->lock, 0))) {
+    GST_WARNING_OBJECT (nvdec, "failed to lock CUDA context");
+    return FALSE;
+  }
+
+  if (!cuda_OK (cuvidMapVideoFrame (nvdec->decoder, dispinfo->picture_index,
+              &dptr, &pitch, &proc_params))) {
+    GST_WARNING_OBJECT (nvdec, "failed to map CUDA video frame");
+    goto unlock_cuda_context;
+  }
+
+  mcpy2d.srcMemoryType = CU_MEMORYTYPE_DEVICE;
+  mcpy2d.srcPitch = pitch;
+  mcpy2d.dstMemoryType = CU_MEMORYTYPE_DEVICE;
+  mcpy2d.dstPitch = cuda_mem->pitch;
+  mcpy2d.WidthInBytes = nvdec->width;
+
+  ret = TRUE;
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&cuda_mem->info); i++) {
+    mcpy2d.srcDevice = dptr + (i * pitch * nvdec->height);
+    mcpy2d.dstDevice = cuda_mem->data +
+        GST_VIDEO_INFO_PLANE_OFFSET (&cuda_mem->info, i);
+    mcpy2d.Height = nvdec->height / (i + 1);
+
+    if (!cuda_OK (cuMemcpy2D (&mcpy2d))) {
+      GST_WARNING_OBJECT (nvdec, "memcpy to CUDA memory failed");
+      ret = FALSE;
+    }
+  }
+
+  if (!cuda_OK (cuvidUnmapVideoFrame (nvdec->decoder, dptr)))
+    GST_WARNING_OBJECT (nvdec, "failed to unmap CUDA video frame");
+
+unlock_cuda_context:
+  if (!cuda_OK (cuvidCtxUnlock (nvdec->cuda_context->lock, 0)))
+    GST_WARNING_OBJECT (nvdec, "failed to unlock CUDA context");
+
+  return ret;
+}
+
+/* prefers CUDA memory when downstream can take it in place */
+static gboolean
+gst_nvdec_downstream_supports_cuda_memory (GstNvDec * nvdec)
+{
+  GstCaps *cuda_caps, *peer_caps;
+  gboolean ret;
+
+  cuda_caps = gst_caps_from_string (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+      (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY, "NV12"));
+  peer_caps =
+      gst_pad_peer_query_caps (GST_VIDEO_DECODER_SRC_PAD (nvdec), cuda_caps);
+  ret = !gst_caps_is_empty (peer_caps);
+  gst_caps_unref (peer_caps);
+  gst_caps_unref (cuda_caps);
+
+  GST_DEBUG_OBJECT (nvdec, "downstream %s CUDA memory",
+      ret ? "supports" : "does not support");
+
+  return ret;
+}
+
 static GstFlowReturn
 handle_pending_frames (GstNvDec * nvdec)
 {
@@ -681,6 +773,9 @@ handle_pending_frames (GstNvDec * nvdec)
           nvdec->fps_n = fps_n;
           nvdec->fps_d = fps_d;
 
+          nvdec->cuda_output =
+              gst_nvdec_downstream_supports_cuda_memory (nvdec);
+
           state = gst_video_decoder_set_output_state (decoder,
               GST_VIDEO_FORMAT_NV12, nvdec->width, nvdec->height,
               nvdec->input_state);
@@ -690,10 +785,18 @@ handle_pending_frames (GstNvDec * nvdec)
               "height", G_TYPE_INT, nvdec->height,
               "framerate", GST_TYPE_FRACTION, nvdec->fps_n, nvdec->fps_d,
               "interlace-mode", G_TYPE_STRING, format->progressive_sequence
-              ? "progressive" : "interleaved",
-              "texture-target", G_TYPE_STRING, "2D", NULL);
-          gst_caps_set_features (state->caps, 0,
-              gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, NULL));
+              ? "progressive" : "interleaved", NULL);
+          if (nvdec->cuda_output) {
+            gst_caps_set_features (state->caps, 0,
+                gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY,
+                    NULL));
+          } else {
+            gst_caps_set_simple (state->caps, "texture-target", G_TYPE_STRING,
+                "2D", NULL);
+            gst_caps_set_features (state->caps, 0,
+                gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_GL_MEMORY,
+                    NULL));
+          }
           gst_video_codec_state_unref (state);
 
           if (!gst_video_decoder_negotiate (decoder)) {
@@ -764,26 +867,32 @@ handle_pending_frames (GstNvDec * nvdec)
           break;
         }
 
-        num_resources = gst_buffer_n_memory (pending_frame->output_buffer);
-        resources = g_new (CUgraphicsResource, num_resources);
+        if (nvdec->cuda_output) {
+          if (!copy_video_frame_to_cuda_memory (nvdec, dispinfo,
+                  pending_frame->output_buffer))
+            GST_WARNING_OBJECT (nvdec, "failed to copy the decoded frame");
+        } else {
+          num_resources = gst_buffer_n_memory (pending_frame->output_buffer);
+          resources = g_new (CUgraphicsResource, num_resources);
+
+          for (i = 0; i < num_resources; i++) {
+            mem = gst_buffer_get_memory (pending_frame->output_buffer, i);
+            resources[i] =
+                ensure_cuda_graphics_resource (mem, nvdec->cuda_context);
+            GST_MINI_OBJECT_FLAG_SET (mem,
+                GST_GL_BASE_MEMORY_TRANSFER_NEED_DOWNLOAD);
+            gst_memory_unref (mem);
+          }
 
-        for (i = 0; i < num_resources; i++) {
-          mem = gst_buffer_get_memory (pending_frame->output_buffer, i);
-          resources[i] =
-              ensure_cuda_graphics_resource (mem, nvdec->cuda_context);
-          GST_MINI_OBJECT_FLAG_SET (mem,
-              GST_GL_BASE_MEMORY_TRANSFER_NEED_DOWNLOAD);
-          gst_memory_unref (mem);
+          args[0] = nvdec;
+          args[1] = dispinfo;
+          args[2] = resources;
+          args[3] = GUINT_TO_POINTER (num_resources);
+          gst_gl_context_thread_add (nvdec->gl_context,
+              (GstGLContextThreadFunc) copy_video_frame_to_gl_textures, args);
+          g_free (resources);
         }
 
-        args[0] = nvdec;
-        args[1] = dispinfo;
-        args[2] = resources;
-        args[3] = GUINT_TO_POINTER (num_resources);
-        gst_gl_context_thread_add (nvdec->gl_context,
-            (GstGLContextThreadFunc) copy_video_frame_to_gl_textures, args);
-        g_free (resources);
-
         if (!dispinfo->progressive_frame) {
           GST_BUFFER_FLAG_SET (pending_frame->output_buffer,
               GST_VIDEO_BUFFER_FLAG_INTERLACED);
@@ -855,6 +964,51 @@ gst_nvdec_handle_frame (GstVideoDecoder * decoder, GstVideoCodecFrame * frame)
   return handle_pending_frames (nvdec);
 }
 
+static gboolean
+gst_nvdec_decide_cuda_allocation (GstNvDec * nvdec, GstQuery * query)
+{
+  GstCaps *outcaps;
+  GstBufferPool *pool = NULL;
+  guint n, size = 0, min = 0, max = 0;
+  GstStructure *config;
+
+  gst_query_parse_allocation (query, &outcaps, NULL);
+  n = gst_query_get_n_allocation_pools (query);
+  if (n > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+    if (!GST_IS_CUDA_BUFFER_POOL (pool)) {
+      gst_object_unref (pool);
+      pool = NULL;
+    }
+  }
+
+  if (!pool)
+    pool = gst_cuda_buffer_pool_new (nvdec->cuda_context->context);
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, outcaps, size, min, max);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_ERROR_OBJECT (nvdec, "failed to configure the CUDA buffer pool");
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  /* the pool computes the size from the pitch of the device allocations */
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_get_params (config, NULL, &size, NULL, NULL);
+  gst_structure_free (config);
+
+  if (n > 0)
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+  gst_object_unref (pool);
+
+  return GST_VIDEO_DECODER_CLASS (gst_nvdec_parent_class)->decide_allocation
+      (GST_VIDEO_DECODER (nvdec), query);
+}
+
 static gboolean
 gst_nvdec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 {
@@ -867,6 +1021,9 @@ gst_nvdec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 
   GST_DEBUG_OBJECT (nvdec, "decide allocation");
 
+  if (nvdec->cuda_output)
+    return gst_nvdec_decide_cuda_allocation (nvdec, query);
+
   if (!gst_gl_ensure_element_data (nvdec, &nvdec->gl_display,
           &nvdec->other_gl_context)) {
     GST_ERROR_OBJECT (nvdec, "failed to ensure OpenGL display");
@@ -40,6 +40,7 @@ struct _GstNvDecCudaContext
 {
   GObject parent;
 
+  CUdevice device;
   CUcontext context;
   CUvideoctxlock lock;
 };
@@ -70,6 +71,8 @@ struct _GstNvDec
   GstGLContext *other_gl_context;
 
   GstNvDecCudaContext *cuda_context;
+  /* whether the frames are output in CUDA memory instead of GL textures */
+  gboolean cuda_output;
   CUvideoparser parser;
   CUvideodecoder decoder;
   GAsyncQueue *decode_queue;
@@ -27,6 +27,8 @@
 
 #include <string.h>
 
+#include "gstcudamemory.h"
+
 #if HAVE_NVENC_GST_GL
 #include <cuda.h>
 #include <cuda_runtime_api.h>
@@ -146,6 +148,12 @@ static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
         "width = (int) [ 16, 4096 ], height = (int) [ 16, 2160 ], "
         "framerate = (fraction) [0, MAX],"
         "interlace-mode = { progressive, mixed, interleaved } "
+        ";"
+        "video/x-raw(" GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY "), "
+        "format = (string) NV12, "
+        "width = (int) [ 16, 4096 ], height = (int) [ 16, 2160 ], "
+        "framerate = (fraction) [0, MAX],"
+        "interlace-mode = { progressive, mixed, interleaved } "
 #if HAVE_NVENC_GST_GL
         ";"
         "video/x-raw(memory:GLMemory), "
@@ -166,6 +174,9 @@ enum
   PROP_QP_MIN,
   PROP_QP_MAX,
   PROP_QP_CONST,
+  PROP_ASYNC_DEPTH,
+  PROP_RC_LOOKAHEAD,
+  PROP_BFRAMES,
 };
 
 #define DEFAULT_PRESET GST_NV_PRESET_DEFAULT
@@ -174,6 +185,9 @@ enum
 #define DEFAULT_QP_MIN -1
 #define DEFAULT_QP_MAX -1
 #define DEFAULT_QP_CONST -1
+#define DEFAULT_ASYNC_DEPTH 0
+#define DEFAULT_RC_LOOKAHEAD 0
+#define DEFAULT_BFRAMES -1
 
 /* This lock is needed to prevent the situation where multiple encoders are
  * initialised at the same time which appears to cause excessive CPU usage over
@@ -194,6 +208,20 @@ struct gl_input_resource
 };
 #endif
 
+/* an input slot for a frame in CUDA memory, which is kept alive until it is
+ * encoded */
+struct cuda_input_resource
+{
+  GstBuffer *buffer;
+  NV_ENC_MAP_INPUT_RESOURCE nv_mapped_resource;
+};
+
+struct cuda_registered_resource
+{
+  guint64 data;                 /* the key */
+  NV_ENC_REGISTER_RESOURCE nv_resource;
+};
+
 struct frame_state
 {
   gint n_buffers;
@@ -222,7 +250,8 @@ static void gst_nv_base_enc_get_property (GObject * object, guint prop_id,
 static void gst_nv_base_enc_finalize (GObject * obj);
 static GstCaps *gst_nv_base_enc_getcaps (GstVideoEncoder * enc,
     GstCaps * filter);
-static gboolean gst_nv_base_enc_stop_bitstream_thread (GstNvBaseEnc * nvenc);
+static gboolean gst_nv_base_enc_stop_bitstream_thread (GstNvBaseEnc * nvenc,
+    gboolean force);
 
 static void
 gst_nv_base_enc_class_init (GstNvBaseEncClass * klass)
@@ -284,6 +313,62 @@ gst_nv_base_enc_class_init (GstNvBaseEncClass * klass)
       g_param_spec_uint ("bitrate", "Bitrate",
           "Bitrate in kbit/sec (0 = from NVENC preset)", 0, 2000 * 1024,
           DEFAULT_BITRATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNvBaseEnc:async-depth:
+   *
+   * The number of frames that can be queued in the encoder at once. More
+   * frames in flight keep the GPU busy when many encoders share it, at the
+   * cost of latency and memory.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_DEPTH,
+      g_param_spec_uint ("async-depth", "Async Depth",
+          "Number of frames in flight in the encoder "
+          "(0 = automatic, from the frame size)", 0, 256,
+          DEFAULT_ASYNC_DEPTH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstNvBaseEnc:rc-lookahead:
+   *
+   * The number of frames the rate control looks ahead to distribute the
+   * bits, 0 disables lookahead.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_RC_LOOKAHEAD,
+      g_param_spec_uint ("rc-lookahead", "Rate Control Lookahead",
+          "Number of frames for rate control lookahead (0 = disabled)", 0, 32,
+          DEFAULT_RC_LOOKAHEAD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstNvBaseEnc:bframes:
+   *
+   * The number of B-frames between two reference frames.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_BFRAMES,
+      g_param_spec_int ("bframes", "B-Frames",
+          "Number of B-frames between reference frames "
+          "(-1 = from NVENC preset)", -1, 4, DEFAULT_BFRAMES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static gint
+_get_encode_cap (GstNvBaseEnc * nvenc, NV_ENC_CAPS cap)
+{
+  GstNvBaseEncClass *nvenc_class = GST_NV_BASE_ENC_GET_CLASS (nvenc);
+  NV_ENC_CAPS_PARAM caps_param = { 0, };
+  gint val = 0;
+
+  caps_param.version = NV_ENC_CAPS_PARAM_VER;
+  caps_param.capsToQuery = cap;
+
+  if (NvEncGetEncodeCaps (nvenc->encoder, nvenc_class->codec_id,
+          &caps_param, &val) != NV_ENC_SUCCESS)
+    return 0;
+
+  return val;
 }
 
 static gboolean
@@ -506,7 +591,7 @@ gst_nv_base_enc_stop (GstVideoEncoder * enc)
 {
   GstNvBaseEnc *nvenc = GST_NV_BASE_ENC (enc);
 
-  gst_nv_base_enc_stop_bitstream_thread (nvenc);
+  gst_nv_base_enc_stop_bitstream_thread (nvenc, TRUE);
 
   gst_nv_base_enc_free_buffers (nvenc);
 
@@ -655,6 +740,13 @@ gst_nv_base_enc_init (GstNvBaseEnc * nvenc)
   nvenc->qp_max = DEFAULT_QP_MAX;
   nvenc->qp_const = DEFAULT_QP_CONST;
   nvenc->bitrate = DEFAULT_BITRATE;
+  nvenc->async_depth = DEFAULT_ASYNC_DEPTH;
+  nvenc->rc_lookahead = DEFAULT_RC_LOOKAHEAD;
+  nvenc->bframes = DEFAULT_BFRAMES;
+  g_queue_init (&nvenc->pending_bitstreams);
+
+  nvenc->cuda_resources = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+      NULL, g_free);
 
   GST_VIDEO_ENCODER_STREAM_LOCK (encoder);
   GST_VIDEO_ENCODER_STREAM_UNLOCK (encoder);
@@ -663,39 +755,11 @@ gst_nv_base_enc_init (GstNvBaseEnc * nvenc)
 static void
 gst_nv_base_enc_finalize (GObject * obj)
 {
-  G_OBJECT_CLASS (gst_nv_base_enc_parent_class)->finalize (obj);
-}
-
-static GstVideoCodecFrame *
-_find_frame_with_output_buffer (GstNvBaseEnc * nvenc, NV_ENC_OUTPUT_PTR out_buf)
-{
-  GList *l, *walk = gst_video_encoder_get_frames (GST_VIDEO_ENCODER (nvenc));
-  GstVideoCodecFrame *ret = NULL;
-  gint i;
+  GstNvBaseEnc *nvenc = GST_NV_BASE_ENC (obj);
 
-  for (l = walk; l; l = l->next) {
-    GstVideoCodecFrame *frame = (GstVideoCodecFrame *) l->data;
-    struct frame_state *state = frame->user_data;
-
-    if (!state)
-      continue;
-
-    for (i = 0; i < N_BUFFERS_PER_FRAME; i++) {
-
-      if (!state->out_bufs[i])
-        break;
+  g_hash_table_unref (nvenc->cuda_resources);
 
-      if (state->out_bufs[i] == out_buf)
-        ret = frame;
-    }
-  }
-
-  if (ret)
-    gst_video_codec_frame_ref (ret);
-
-  g_list_free_full (walk, (GDestroyNotify) gst_video_codec_frame_unref);
-
-  return ret;
+  G_OBJECT_CLASS (gst_nv_base_enc_parent_class)->finalize (obj);
 }
 
 static gpointer
@@ -707,7 +771,7 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
   /* overview of operation:
    * 1. retreive the next buffer submitted to the bitstream pool
    * 2. wait for that buffer to be ready from nvenc (LockBitsream)
-   * 3. retreive the GstVideoCodecFrame associated with that buffer
+   * 3. retreive the GstVideoCodecFrame the picture in that buffer belongs to
    * 4. for each buffer in the frame
    * 4.1 (step 2): wait for that buffer to be ready from nvenc (LockBitsream)
    * 4.2 create an output GstBuffer from the nvenc buffers
@@ -763,14 +827,17 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
 
         GST_LOG_OBJECT (nvenc, "picture type %d", lock_bs.pictureType);
 
-        tmp_frame = _find_frame_with_output_buffer (nvenc, out_buf);
+        /* with B-frames, the pictures come out in coding order and not
+         * necessarily in the output buffer of their own frame */
+        tmp_frame = gst_video_encoder_get_frame (enc, lock_bs.frameIdx);
         g_assert (tmp_frame != NULL);
-        if (frame)
+        if (frame) {
           g_assert (frame == tmp_frame);
+          gst_video_codec_frame_unref (tmp_frame);
+        }
         frame = tmp_frame;
 
         state = frame->user_data;
-        g_assert (state->out_bufs[i] == out_buf);
 
         /* copy into output buffer */
         buffers[i] =
@@ -784,21 +851,20 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
         }
 
         /* TODO: use lock_bs.outputTimeStamp and lock_bs.outputDuration */
-        /* TODO: check pts/dts is handled properly if there are B-frames */
 
-        nv_ret = NvEncUnlockBitstream (nvenc->encoder, state->out_bufs[i]);
+        nv_ret = NvEncUnlockBitstream (nvenc->encoder, out_buf);
         if (nv_ret != NV_ENC_SUCCESS) {
           /* FIXME: what to do here? */
           GST_ELEMENT_ERROR (nvenc, STREAM, ENCODE, (NULL),
               ("Failed to unlock bitstream buffer %p, ret %d",
                   lock_bs.outputBitstream, nv_ret));
-          state->out_bufs[i] = SHUTDOWN_COOKIE;
+          out_buf = SHUTDOWN_COOKIE;
           break;
         }
 
         GST_LOG_OBJECT (nvenc, "returning bitstream buffer %p to pool",
-            state->out_bufs[i]);
-        g_async_queue_push (nvenc->bitstream_pool, state->out_bufs[i]);
+            out_buf);
+        g_async_queue_push (nvenc->bitstream_pool, out_buf);
       }
 
       if (out_buf == SHUTDOWN_COOKIE)
@@ -835,6 +901,23 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
             sizeof (in_gl_resource->nv_mapped_resource));
       }
 #endif
+      if (nvenc->cuda_input) {
+        struct cuda_input_resource *in_cuda_resource = in_buf;
+
+        nv_ret =
+            NvEncUnmapInputResource (nvenc->encoder,
+            in_cuda_resource->nv_mapped_resource.mappedResource);
+        if (nv_ret != NV_ENC_SUCCESS) {
+          GST_ERROR_OBJECT (nvenc, "Failed to unmap input resource %p, ret %d",
+              in_cuda_resource, nv_ret);
+          break;
+        }
+
+        memset (&in_cuda_resource->nv_mapped_resource, 0,
+            sizeof (in_cuda_resource->nv_mapped_resource));
+        /* the decoder can reuse the frame */
+        gst_buffer_replace (&in_cuda_resource->buffer, NULL);
+      }
 
       g_async_queue_push (nvenc->in_bufs_pool, in_buf);
     }
@@ -876,22 +959,25 @@ gst_nv_base_enc_start_bitstream_thread (GstNvBaseEnc * nvenc)
   return TRUE;
 }
 
+/* with @force, the buffers still queued for the thread are dropped,
+ * otherwise it outputs them before exiting */
 static gboolean
-gst_nv_base_enc_stop_bitstream_thread (GstNvBaseEnc * nvenc)
+gst_nv_base_enc_stop_bitstream_thread (GstNvBaseEnc * nvenc, gboolean force)
 {
   gpointer out_buf;
 
   if (nvenc->bitstream_thread == NULL)
     return TRUE;
 
-  /* FIXME */
-  GST_FIXME_OBJECT (nvenc, "stop bitstream reading thread properly");
   g_async_queue_lock (nvenc->bitstream_queue);
   g_async_queue_lock (nvenc->bitstream_pool);
-  while ((out_buf = g_async_queue_try_pop_unlocked (nvenc->bitstream_queue))) {
+  while (force
+      && (out_buf = g_async_queue_try_pop_unlocked (nvenc->bitstream_queue))) {
     GST_INFO_OBJECT (nvenc, "stole bitstream buffer %p from queue", out_buf);
     g_async_queue_push_unlocked (nvenc->bitstream_pool, out_buf);
   }
+  while ((out_buf = g_queue_pop_head (&nvenc->pending_bitstreams)))
+    g_async_queue_push_unlocked (nvenc->bitstream_pool, out_buf);
   g_async_queue_push_unlocked (nvenc->bitstream_queue, SHUTDOWN_COOKIE);
   g_async_queue_unlock (nvenc->bitstream_pool);
   g_async_queue_unlock (nvenc->bitstream_queue);
@@ -913,6 +999,8 @@ gst_nv_base_enc_reset_queues (GstNvBaseEnc * nvenc, gboolean refill)
 
   GST_INFO_OBJECT (nvenc, "clearing queues");
 
+  g_queue_clear (&nvenc->pending_bitstreams);
+
   while ((ptr = g_async_queue_try_pop (nvenc->bitstream_queue))) {
     /* do nothing */
   }
@@ -932,6 +1020,19 @@ gst_nv_base_enc_reset_queues (GstNvBaseEnc * nvenc, gboolean refill)
   }
 }
 
+static void
+_unregister_cuda_resource (gpointer key,
+    struct cuda_registered_resource *resource, GstNvBaseEnc * nvenc)
+{
+  NVENCSTATUS nv_ret;
+
+  nv_ret = NvEncUnregisterResource (nvenc->encoder,
+      resource->nv_resource.registeredResource);
+  if (nv_ret != NV_ENC_SUCCESS)
+    GST_ERROR_OBJECT (nvenc, "Failed to unregister CUDA resource %p, ret %d",
+        resource, nv_ret);
+}
+
 static void
 gst_nv_base_enc_free_buffers (GstNvBaseEnc * nvenc)
 {
@@ -962,7 +1063,12 @@ gst_nv_base_enc_free_buffers (GstNvBaseEnc * nvenc)
       cuCtxPopCurrent (NULL);
     } else
 #endif
-    {
+    if (nvenc->cuda_input) {
+      struct cuda_input_resource *in_cuda_resource = nvenc->input_bufs[i];
+
+      gst_buffer_replace (&in_cuda_resource->buffer, NULL);
+      g_free (in_cuda_resource);
+    } else {
       NV_ENC_INPUT_PTR in_buf = (NV_ENC_INPUT_PTR) nvenc->input_bufs[i];
 
       GST_DEBUG_OBJECT (nvenc, "Destroying input buffer %p", in_buf);
@@ -981,6 +1087,14 @@ gst_nv_base_enc_free_buffers (GstNvBaseEnc * nvenc)
     }
   }
 
+  if (g_hash_table_size (nvenc->cuda_resources) > 0) {
+    cuCtxPushCurrent (nvenc->cuda_ctx);
+    g_hash_table_foreach (nvenc->cuda_resources,
+        (GHFunc) _unregister_cuda_resource, nvenc);
+    g_hash_table_remove_all (nvenc->cuda_resources);
+    cuCtxPopCurrent (NULL);
+  }
+
   nvenc->n_bufs = 0;
   g_free (nvenc->output_bufs);
   nvenc->output_bufs = NULL;
@@ -1185,6 +1299,29 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
     }
   }
 
+  if (nvenc->bframes >= 0) {
+    gint max_bframes = _get_encode_cap (nvenc, NV_ENC_CAPS_NUM_MAX_BFRAMES);
+
+    if (nvenc->bframes > max_bframes)
+      GST_WARNING_OBJECT (nvenc, "%d B-frames requested, but the encoder "
+          "supports at most %d", nvenc->bframes, max_bframes);
+    params->encodeConfig->frameIntervalP = MIN (nvenc->bframes,
+        max_bframes) + 1;
+  }
+
+  if (nvenc->rc_lookahead > 0) {
+#if NVENCAPI_MAJOR_VERSION >= 6
+    if (_get_encode_cap (nvenc, NV_ENC_CAPS_SUPPORT_LOOKAHEAD)) {
+      params->encodeConfig->rcParams.enableLookahead = 1;
+      params->encodeConfig->rcParams.lookaheadDepth = nvenc->rc_lookahead;
+    } else {
+      GST_WARNING_OBJECT (nvenc, "Encoder does not support lookahead");
+    }
+#else
+    GST_WARNING_OBJECT (nvenc, "Lookahead needs NVENC API 6.0 or newer");
+#endif
+  }
+
   g_assert (nvenc_class->set_encoder_config);
   if (!nvenc_class->set_encoder_config (nvenc, state, params->encodeConfig)) {
     GST_ERROR_OBJECT (enc, "Subclass failed to set encoder configuration");
@@ -1209,6 +1346,7 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
   if (!old_state) {
     nvenc->input_info = *info;
     nvenc->gl_input = FALSE;
+    nvenc->cuda_input = FALSE;
   }
 
   if (nvenc->input_state)
@@ -1218,9 +1356,7 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
 
   /* now allocate some buffers only on first configuration */
   if (!old_state) {
-#if HAVE_NVENC_GST_GL
     GstCapsFeatures *features;
-#endif
     guint num_macroblocks, i;
     guint input_width, input_height;
 
@@ -1229,13 +1365,32 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
 
     num_macroblocks = (GST_ROUND_UP_16 (input_width) >> 4)
         * (GST_ROUND_UP_16 (input_height) >> 4);
-    nvenc->n_bufs = (num_macroblocks >= 8160) ? 32 : 48;
+    if (nvenc->async_depth > 0)
+      nvenc->n_bufs = nvenc->async_depth;
+    else
+      nvenc->n_bufs = (num_macroblocks >= 8160) ? 32 : 48;
+    /* the encoder holds on to the frames it reorders and looks ahead at
+     * before it outputs anything, so make sure it never starves */
+    nvenc->n_bufs = MAX (nvenc->n_bufs,
+        params->encodeConfig->frameIntervalP + nvenc->rc_lookahead + 4);
+    GST_DEBUG_OBJECT (nvenc, "using %u buffers in flight", nvenc->n_bufs);
 
     /* input buffers */
     nvenc->input_bufs = g_new0 (gpointer, nvenc->n_bufs);
 
-#if HAVE_NVENC_GST_GL
     features = gst_caps_get_features (state->caps, 0);
+    if (gst_caps_features_contains (features,
+            GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY)) {
+      /* the frames are registered as they come, only the slots limiting the
+       * number of frames in flight are allocated here */
+      nvenc->cuda_input = TRUE;
+
+      for (i = 0; i < nvenc->n_bufs; ++i) {
+        nvenc->input_bufs[i] = g_new0 (struct cuda_input_resource, 1);
+        g_async_queue_push (nvenc->in_bufs_pool, nvenc->input_bufs[i]);
+      }
+    } else
+#if HAVE_NVENC_GST_GL
     if (gst_caps_features_contains (features,
             GST_CAPS_FEATURE_MEMORY_GL_MEMORY)) {
       guint pixel_depth = 0;
@@ -1537,6 +1692,68 @@ _map_gl_input_buffer (GstGLContext * context, struct map_gl_input *data)
 }
 #endif
 
+/* registering is expensive, but the frames come from the pool of the
+ * decoder so there is only a handful of different ones */
+static struct cuda_registered_resource *
+_ensure_cuda_resource (GstNvBaseEnc * nvenc, GstCudaMemory * mem)
+{
+  struct cuda_registered_resource *resource;
+  GstVideoInfo *info = &nvenc->input_info;
+  guint64 data = mem->data;
+  NVENCSTATUS nv_ret;
+
+  resource = g_hash_table_lookup (nvenc->cuda_resources, &data);
+  if (resource && resource->nv_resource.pitch == mem->pitch)
+    return resource;
+
+  cuCtxPushCurrent (nvenc->cuda_ctx);
+
+  /* the memory was freed and the address reused with another layout */
+  if (resource) {
+    _unregister_cuda_resource (NULL, resource, nvenc);
+    g_hash_table_remove (nvenc->cuda_resources, &data);
+  }
+
+  resource = g_new0 (struct cuda_registered_resource, 1);
+  resource->data = data;
+  resource->nv_resource.version = NV_ENC_REGISTER_RESOURCE_VER;
+  resource->nv_resource.resourceType = NV_ENC_INPUT_RESOURCE_TYPE_CUDADEVICEPTR;
+  resource->nv_resource.width = GST_VIDEO_INFO_WIDTH (info);
+  resource->nv_resource.height = GST_VIDEO_INFO_HEIGHT (info);
+  resource->nv_resource.pitch = mem->pitch;
+  resource->nv_resource.bufferFormat =
+      gst_nvenc_get_nv_buffer_format (GST_VIDEO_INFO_FORMAT (info));
+  resource->nv_resource.resourceToRegister = (gpointer) (guintptr) mem->data;
+
+  nv_ret = NvEncRegisterResource (nvenc->encoder, &resource->nv_resource);
+  cuCtxPopCurrent (NULL);
+
+  if (nv_ret != NV_ENC_SUCCESS) {
+    GST_ERROR_OBJECT (nvenc, "Failed to register CUDA memory %p, ret %d",
+        mem, nv_ret);
+    g_free (resource);
+    return NULL;
+  }
+
+  GST_DEBUG_OBJECT (nvenc, "registered CUDA memory at 0x%" G_GINT64_MODIFIER
+      "x", data);
+  g_hash_table_insert (nvenc->cuda_resources, &resource->data, resource);
+
+  return resource;
+}
+
+/* hands the output buffers of the pictures the encoder held back to the
+ * bitstream thread, in submission order which is the order NVENC fills them
+ * in */
+static void
+_flush_pending_bitstreams (GstNvBaseEnc * nvenc)
+{
+  gpointer out_buf;
+
+  while ((out_buf = g_queue_pop_head (&nvenc->pending_bitstreams)))
+    g_async_queue_push (nvenc->bitstream_queue, out_buf);
+}
+
 static GstFlowReturn
 _acquire_input_buffer (GstNvBaseEnc * nvenc, gpointer * input)
 {
@@ -1599,9 +1816,11 @@ _submit_input_buffer (GstNvBaseEnc * nvenc, GstVideoCodecFrame * frame,
   if (nv_ret == NV_ENC_SUCCESS) {
     GST_LOG_OBJECT (nvenc, "Encoded picture");
   } else if (nv_ret == NV_ENC_ERR_NEED_MORE_INPUT) {
-    /* FIXME: we should probably queue pending output buffers here and only
-     * submit them to the async queue once we got sucess back */
+    /* the output buffer must not be locked before the encoder returns
+     * success for a later picture */
     GST_DEBUG_OBJECT (nvenc, "Encoded picture (encoder needs more input)");
+    g_queue_push_tail (&nvenc->pending_bitstreams, outputBufferPtr);
+    return GST_FLOW_OK;
   } else {
     GST_ERROR_OBJECT (nvenc, "Failed to encode picture: %d", nv_ret);
     GST_DEBUG_OBJECT (nvenc, "re-enqueueing input buffer %p", inputBuffer);
@@ -1612,6 +1831,7 @@ _submit_input_buffer (GstNvBaseEnc * nvenc, GstVideoCodecFrame * frame,
     return GST_FLOW_ERROR;
   }
 
+  _flush_pending_bitstreams (nvenc);
   g_async_queue_push (nvenc->bitstream_queue, outputBufferPtr);
 
   return GST_FLOW_OK;
@@ -1637,6 +1857,8 @@ gst_nv_base_enc_handle_frame (GstVideoEncoder * enc, GstVideoCodecFrame * frame)
   if (nvenc->gl_input)
     in_map_flags |= GST_MAP_GL;
 #endif
+  if (nvenc->cuda_input)
+    in_map_flags |= GST_MAP_CUDA;
 
   if (!gst_video_frame_map (&vframe, info, frame->input_buffer, in_map_flags))
     return GST_FLOW_ERROR;
@@ -1714,7 +1936,66 @@ gst_nv_base_enc_handle_frame (GstVideoEncoder * enc, GstVideoCodecFrame * frame)
   }
 #endif
 
-  if (!nvenc->gl_input) {
+  if (nvenc->cuda_input) {
+    struct cuda_input_resource *in_cuda_resource = input_buffer;
+    struct cuda_registered_resource *resource;
+    GstMemory *mem = gst_buffer_peek_memory (frame->input_buffer, 0);
+
+    GST_LOG_OBJECT (enc, "got input buffer %p", in_cuda_resource);
+
+    if (!gst_is_cuda_memory (mem)) {
+      GST_ERROR_OBJECT (nvenc, "Input buffer is not in CUDA memory");
+      g_async_queue_push (nvenc->in_bufs_pool, in_cuda_resource);
+      goto error;
+    }
+
+    if (((GstCudaMemory *) mem)->context != nvenc->cuda_ctx)
+      GST_WARNING_OBJECT (nvenc, "CUDA memory from another context");
+
+    resource = _ensure_cuda_resource (nvenc, (GstCudaMemory *) mem);
+    if (!resource) {
+      g_async_queue_push (nvenc->in_bufs_pool, in_cuda_resource);
+      goto error;
+    }
+
+    in_cuda_resource->nv_mapped_resource.version =
+        NV_ENC_MAP_INPUT_RESOURCE_VER;
+    in_cuda_resource->nv_mapped_resource.registeredResource =
+        resource->nv_resource.registeredResource;
+
+    nv_ret =
+        NvEncMapInputResource (nvenc->encoder,
+        &in_cuda_resource->nv_mapped_resource);
+    if (nv_ret != NV_ENC_SUCCESS) {
+      GST_ERROR_OBJECT (nvenc, "Failed to map input resource %p, ret %d",
+          in_cuda_resource, nv_ret);
+      g_async_queue_push (nvenc->in_bufs_pool, in_cuda_resource);
+      goto error;
+    }
+    in_cuda_resource->buffer = gst_buffer_ref (frame->input_buffer);
+
+    out_buf = g_async_queue_try_pop (nvenc->bitstream_pool);
+    if (out_buf == NULL) {
+      GST_DEBUG_OBJECT (nvenc, "wait for output buf to become available again");
+      out_buf = g_async_queue_pop (nvenc->bitstream_pool);
+    }
+
+    state->in_bufs[frame_n] = in_cuda_resource;
+    state->out_bufs[frame_n++] = out_buf;
+
+    frame->user_data = state;
+    frame->user_data_destroy_notify = (GDestroyNotify) g_free;
+
+    flow =
+        _submit_input_buffer (nvenc, frame, &vframe, in_cuda_resource,
+        in_cuda_resource->nv_mapped_resource.mappedResource,
+        in_cuda_resource->nv_mapped_resource.mappedBufferFmt, out_buf);
+
+    /* encoder will keep frame in list internally, we'll look it up again later
+     * in the thread where we get the output buffers and finish it there */
+    gst_video_codec_frame_unref (frame);
+    frame = NULL;
+  } else if (!nvenc->gl_input) {
     NV_ENC_LOCK_INPUT_BUFFER in_buf_lock = { 0, };
     NV_ENC_INPUT_PTR in_buf = input_buffer;
     guint8 *src, *dest;
@@ -1831,6 +2112,8 @@ gst_nv_base_enc_drain_encoder (GstNvBaseEnc * nvenc)
     return FALSE;
   }
 
+  _flush_pending_bitstreams (nvenc);
+
   return TRUE;
 }
 
@@ -1844,7 +2127,7 @@ gst_nv_base_enc_finish (GstVideoEncoder * enc)
   gst_nv_base_enc_drain_encoder (nvenc);
 
   /* wait for encoder to output the remaining buffers */
-  gst_nv_base_enc_stop_bitstream_thread (nvenc);
+  gst_nv_base_enc_stop_bitstream_thread (nvenc, FALSE);
 
   return GST_FLOW_OK;
 }
@@ -1888,6 +2171,15 @@ gst_nv_base_enc_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE:
       nvenc->bitrate = g_value_get_uint (value);
       break;
+    case PROP_ASYNC_DEPTH:
+      nvenc->async_depth = g_value_get_uint (value);
+      break;
+    case PROP_RC_LOOKAHEAD:
+      nvenc->rc_lookahead = g_value_get_uint (value);
+      break;
+    case PROP_BFRAMES:
+      nvenc->bframes = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1922,6 +2214,15 @@ gst_nv_base_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_BITRATE:
       g_value_set_uint (value, nvenc->bitrate);
       break;
+    case PROP_ASYNC_DEPTH:
+      g_value_set_uint (value, nvenc->async_depth);
+      break;
+    case PROP_RC_LOOKAHEAD:
+      g_value_set_uint (value, nvenc->rc_lookahead);
+      break;
+    case PROP_BFRAMES:
+      g_value_set_int (value, nvenc->bframes);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -69,6 +69,9 @@ typedef struct {
   gint            qp_max;
   gint            qp_const;
   guint           bitrate;
+  guint           async_depth;
+  guint           rc_lookahead;
+  gint            bframes;
 
   CUcontext       cuda_ctx;
   void          * encoder;
@@ -78,6 +81,10 @@ typedef struct {
 
   GstVideoCodecState *input_state;
   gboolean            gl_input;
+  gboolean            cuda_input;
+
+  /* device memory from nvdec registered with the encoder, by address */
+  GHashTable         *cuda_resources;
 
   /* allocated buffers */
   gpointer          *input_bufs;   /* array of n_allocs input buffers  */
@@ -91,6 +98,10 @@ typedef struct {
   /* output bufs in use (input bufs in use are tracked via the codec frames) */
   GAsyncQueue    *bitstream_queue;
 
+  /* output bufs submitted while the encoder held back pictures for
+   * reordering or lookahead, they are only ready once it returns success */
+  GQueue          pending_bitstreams;
+
   /* we spawn a thread that does the (blocking) waits for output buffers
    * to become available, so we can continue to feed data to the encoder
    * while we wait */
@@ -256,7 +256,7 @@ gst_nvenc_get_nv_buffer_format (GstVideoFormat fmt)
 CUcontext
 gst_nvenc_create_cuda_context (guint device_id)
 {
-  CUcontext cuda_ctx, old_ctx;
+  CUcontext cuda_ctx;
   CUresult cres = CUDA_SUCCESS;
   CUdevice cdev = 0, cuda_dev = -1;
   int dev_count = 0;
@@ -300,16 +300,14 @@ gst_nvenc_create_cuda_context (guint device_id)
     return NULL;
   }
 
-  if (cuCtxCreate (&cuda_ctx, 0, cuda_dev) != CUDA_SUCCESS) {
-    GST_WARNING ("Failed to create CUDA context for cuda device %d", cuda_dev);
+  /* the primary context is shared with nvdec, whose device memory can then
+   * be encoded in place */
+  if (cuDevicePrimaryCtxRetain (&cuda_ctx, cuda_dev) != CUDA_SUCCESS) {
+    GST_WARNING ("Failed to retain CUDA context for cuda device %d", cuda_dev);
     return NULL;
   }
 
-  if (cuCtxPopCurrent (&old_ctx) != CUDA_SUCCESS) {
-    return NULL;
-  }
-
-  GST_INFO ("Created CUDA context %p", cuda_ctx);
+  GST_INFO ("Retained CUDA context %p", cuda_ctx);
 
   return cuda_ctx;
 }
@@ -317,8 +315,17 @@ gst_nvenc_create_cuda_context (guint device_id)
 gboolean
 gst_nvenc_destroy_cuda_context (CUcontext ctx)
 {
-  GST_INFO ("Destroying CUDA context %p", ctx);
-  return (cuCtxDestroy (ctx) == CUDA_SUCCESS);
+  CUdevice cuda_dev;
+  gboolean ret;
+
+  GST_INFO ("Releasing CUDA context %p", ctx);
+
+  if (cuCtxPushCurrent (ctx) != CUDA_SUCCESS)
+    return FALSE;
+  ret = cuCtxGetDevice (&cuda_dev) == CUDA_SUCCESS;
+  cuCtxPopCurrent (NULL);
+
+  return ret && cuDevicePrimaryCtxRelease (cuda_dev) == CUDA_SUCCESS;
 }
 
 static gboolean
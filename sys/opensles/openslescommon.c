@@ -141,3 +141,21 @@ gst_to_opensles_stream_type (GstOpenSLESStreamType stream_type)
       return SL_ANDROID_STREAM_MEDIA;
   }
 }
+
+/* Takes @caps and returns them with a copy fixed to @rate in front, so that
+ * negotiation picks the native rate of the device when upstream or
+ * downstream can do it. Only the native rate allows Android to use its fast
+ * mixer, any other rate is resampled by AudioFlinger first. */
+GstCaps *
+gst_opensles_caps_prefer_rate (GstCaps * caps, gint rate)
+{
+  GstCaps *preferred;
+
+  if (rate <= 0)
+    return caps;
+
+  preferred = gst_caps_copy (caps);
+  gst_caps_set_simple (preferred, "rate", G_TYPE_INT, rate, NULL);
+
+  return gst_caps_merge (preferred, caps);
+}
@@ -62,6 +62,8 @@ GType gst_opensles_stream_type_get_type (void);
 
 SLint32 gst_to_opensles_stream_type (GstOpenSLESStreamType stream_type);
 
+GstCaps * gst_opensles_caps_prefer_rate (GstCaps * caps, gint rate);
+
 G_END_DECLS
 
 #endif /* __OPENSLESCOMMON_H__ */
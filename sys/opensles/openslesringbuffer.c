@@ -103,6 +103,75 @@ _opensles_format (GstAudioRingBufferSpec * spec, SLDataFormat_PCM * format)
           G_BIG_ENDIAN) ? SL_BYTEORDER_BIGENDIAN : SL_BYTEORDER_LITTLEENDIAN);
 }
 
+/* Sizes the segments as a whole number of device bursts, so that each
+ * enqueued buffer matches what the fast mixer or fast capture thread consumes
+ * per cycle. With low-latency a segment is a single burst, otherwise as many
+ * bursts as fit in latency-time. This only helps at the native rate, at any
+ * other rate the stream goes through the normal mixer anyway. */
+static void
+_opensles_adjust_segments (GstOpenSLESRingBuffer * thiz,
+    GstAudioRingBufferSpec * spec)
+{
+  gint bpf = GST_AUDIO_INFO_BPF (&spec->info);
+  gint rate = GST_AUDIO_INFO_RATE (&spec->info);
+  gint burst, bursts, latency_frames, buffer_frames;
+
+  if (thiz->native_frames_per_buffer <= 0)
+    return;
+
+  if (thiz->native_rate > 0 && rate != thiz->native_rate) {
+    GST_INFO_OBJECT (thiz, "rate %d is not the native rate %d, no fast path",
+        rate, thiz->native_rate);
+    return;
+  }
+
+  burst = thiz->native_frames_per_buffer;
+  if (thiz->low_latency) {
+    bursts = 1;
+  } else {
+    latency_frames = gst_util_uint64_scale_int (spec->latency_time, rate,
+        G_USEC_PER_SEC);
+    bursts = MAX (1, latency_frames / burst);
+  }
+
+  buffer_frames = gst_util_uint64_scale_int (spec->buffer_time, rate,
+      G_USEC_PER_SEC);
+
+  spec->segsize = burst * bursts * bpf;
+  spec->segtotal = MAX (2, buffer_frames / (burst * bursts));
+
+  GST_INFO_OBJECT (thiz, "%d bursts of %d frames per segment, %d segments",
+      bursts, burst, spec->segtotal);
+}
+
+/* Asks for the low latency performance mode on Android 7.1 and newer. Has to
+ * be done between creating and realizing the player or recorder. */
+static void
+_opensles_set_performance_mode (GstOpenSLESRingBuffer * thiz,
+    SLObjectItf object)
+{
+#ifdef SL_ANDROID_KEY_PERFORMANCE_MODE
+  SLAndroidConfigurationItf config;
+  SLuint32 mode = SL_ANDROID_PERFORMANCE_LATENCY;
+  SLresult result;
+
+  result = (*object)->GetInterface (object, SL_IID_ANDROIDCONFIGURATION,
+      &config);
+  if (result != SL_RESULT_SUCCESS) {
+    GST_WARNING_OBJECT (thiz,
+        "Could not get configuration interface 0x%08x", (guint32) result);
+    return;
+  }
+
+  result = (*config)->SetConfiguration (config,
+      SL_ANDROID_KEY_PERFORMANCE_MODE, &mode, sizeof (mode));
+  if (result != SL_RESULT_SUCCESS) {
+    GST_WARNING_OBJECT (thiz, "Failed to set performance mode (0x%08x)",
+        (guint32) result);
+  }
+#endif
+}
+
 /* 
  * Recorder related functions
  */
@@ -115,6 +184,7 @@ _opensles_recorder_acquire (GstAudioRingBuffer * rb,
   SLresult result;
   SLDataFormat_PCM format;
   SLAndroidConfigurationItf config;
+  GstOpenSLESRecordingPreset preset_type;
 
   /* Configure audio source */
   SLDataLocator_IODevice loc_dev = {
@@ -147,9 +217,15 @@ _opensles_recorder_acquire (GstAudioRingBuffer * rb,
     goto failed;
   }
 
+  /* Fast capture is only used without input effects, which is what the voice
+   * recognition preset gives */
+  preset_type = thiz->preset;
+  if (thiz->low_latency && preset_type == GST_OPENSLES_RECORDING_PRESET_NONE)
+    preset_type = GST_OPENSLES_RECORDING_PRESET_VOICE_RECOGNITION;
+
   /* Set the recording preset if we have one */
-  if (thiz->preset != GST_OPENSLES_RECORDING_PRESET_NONE) {
-    SLint32 preset = gst_to_opensles_recording_preset (thiz->preset);
+  if (preset_type != GST_OPENSLES_RECORDING_PRESET_NONE) {
+    SLint32 preset = gst_to_opensles_recording_preset (preset_type);
 
     result = (*thiz->recorderObject)->GetInterface (thiz->recorderObject,
         SL_IID_ANDROIDCONFIGURATION, &config);
@@ -168,6 +244,9 @@ _opensles_recorder_acquire (GstAudioRingBuffer * rb,
     }
   }
 
+  if (thiz->low_latency)
+    _opensles_set_performance_mode (thiz, thiz->recorderObject);
+
   /* Realize the audio recorder object */
   result =
       (*thiz->recorderObject)->Realize (thiz->recorderObject, SL_BOOLEAN_FALSE);
@@ -440,6 +519,9 @@ _opensles_player_acquire (GstAudioRingBuffer * rb,
     }
   }
 
+  if (thiz->low_latency)
+    _opensles_set_performance_mode (thiz, thiz->playerObject);
+
   /* Realize the player object */
   result =
       (*thiz->playerObject)->Realize (thiz->playerObject, SL_BOOLEAN_FALSE);
@@ -834,6 +916,8 @@ gst_opensles_ringbuffer_acquire (GstAudioRingBuffer * rb,
 
   thiz = GST_OPENSLES_RING_BUFFER_CAST (rb);
 
+  _opensles_adjust_segments (thiz, spec);
+
   /* Instantiate and configure the OpenSL ES interfaces */
   if (!thiz->acquire (rb, spec)) {
     return FALSE;
@@ -97,6 +97,12 @@ struct _GstOpenSLESRingBuffer
   gint segqueued; /* ATOMIC */
   gboolean is_queue_callback_registered;
 
+  /* native output or input configuration of the device as reported by
+   * AudioManager, 0 if unknown */
+  gint native_rate;
+  gint native_frames_per_buffer;
+  gboolean low_latency;
+
   /* vmethods */
   AcquireFunc acquire;
   StateFunc start;
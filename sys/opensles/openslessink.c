@@ -28,6 +28,10 @@
  * |[
  * gst-launch-1.0 -v filesrc location=music.ogg ! oggdemux ! vorbisdec ! audioconvert ! audioresample ! opeslessink
  * ]| Play an Ogg/Vorbis file.
+ * |[
+ * gst-launch-1.0 -v audiotestsrc ! audioresample ! openslessink native-rate=48000 native-frames-per-buffer=192 low-latency=true
+ * ]| Play a test tone on Android's fast mixer path, with the native
+ * configuration the application got from AudioManager.
  *
  */
 
@@ -47,6 +51,9 @@ enum
   PROP_VOLUME,
   PROP_MUTE,
   PROP_STREAM_TYPE,
+  PROP_NATIVE_RATE,
+  PROP_NATIVE_FRAMES_PER_BUFFER,
+  PROP_LOW_LATENCY,
   PROP_LAST
 };
 
@@ -55,6 +62,10 @@ enum
 
 #define DEFAULT_STREAM_TYPE GST_OPENSLES_STREAM_TYPE_NONE
 
+#define DEFAULT_NATIVE_RATE 0
+#define DEFAULT_NATIVE_FRAMES_PER_BUFFER 0
+#define DEFAULT_LOW_LATENCY FALSE
+
 
 /* According to Android's NDK doc the following are the supported rates */
 #define RATES "8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100"
@@ -90,6 +101,11 @@ gst_opensles_sink_create_ringbuffer (GstAudioBaseSink * base)
 
   GST_OPENSLES_RING_BUFFER (rb)->stream_type = sink->stream_type;
 
+  GST_OPENSLES_RING_BUFFER (rb)->native_rate = sink->native_rate;
+  GST_OPENSLES_RING_BUFFER (rb)->native_frames_per_buffer =
+      sink->native_frames_per_buffer;
+  GST_OPENSLES_RING_BUFFER (rb)->low_latency = sink->low_latency;
+
   return rb;
 }
 
@@ -216,6 +232,15 @@ gst_opensles_sink_set_property (GObject * object, guint prop_id,
     case PROP_STREAM_TYPE:
       sink->stream_type = g_value_get_enum (value);
       break;
+    case PROP_NATIVE_RATE:
+      sink->native_rate = g_value_get_int (value);
+      break;
+    case PROP_NATIVE_FRAMES_PER_BUFFER:
+      sink->native_frames_per_buffer = g_value_get_int (value);
+      break;
+    case PROP_LOW_LATENCY:
+      sink->low_latency = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -237,21 +262,50 @@ gst_opensles_sink_get_property (GObject * object, guint prop_id,
     case PROP_STREAM_TYPE:
       g_value_set_enum (value, sink->stream_type);
       break;
+    case PROP_NATIVE_RATE:
+      g_value_set_int (value, sink->native_rate);
+      break;
+    case PROP_NATIVE_FRAMES_PER_BUFFER:
+      g_value_set_int (value, sink->native_frames_per_buffer);
+      break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, sink->low_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static GstCaps *
+gst_opensles_sink_getcaps (GstBaseSink * bsink, GstCaps * filter)
+{
+  GstOpenSLESSink *sink = GST_OPENSLES_SINK (bsink);
+  GstCaps *caps, *tmp;
+
+  caps = gst_pad_get_pad_template_caps (GST_BASE_SINK_PAD (bsink));
+  caps = gst_opensles_caps_prefer_rate (caps, sink->native_rate);
+
+  if (filter) {
+    tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+    caps = tmp;
+  }
+
+  return caps;
+}
+
 static void
 gst_opensles_sink_class_init (GstOpenSLESSinkClass * klass)
 {
   GObjectClass *gobject_class;
   GstElementClass *gstelement_class;
+  GstBaseSinkClass *gstbasesink_class;
   GstAudioBaseSinkClass *gstbaseaudiosink_class;
 
   gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
+  gstbasesink_class = (GstBaseSinkClass *) klass;
   gstbaseaudiosink_class = (GstAudioBaseSinkClass *) klass;
 
   gobject_class->set_property = gst_opensles_sink_set_property;
@@ -271,6 +325,52 @@ gst_opensles_sink_class_init (GstOpenSLESSinkClass * klass)
           GST_TYPE_OPENSLES_STREAM_TYPE, DEFAULT_STREAM_TYPE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOpenSLESSink:native-rate:
+   *
+   * The native output sample rate of the device, as reported by Android's
+   * AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE, or 0 if unknown. The rate is
+   * preferred during negotiation, because Android only uses its fast mixer
+   * path at this rate.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_NATIVE_RATE,
+      g_param_spec_int ("native-rate", "Native rate",
+          "Native sample rate of the device (0 = unknown)", 0, G_MAXINT,
+          DEFAULT_NATIVE_RATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstOpenSLESSink:native-frames-per-buffer:
+   *
+   * The burst size of the device in frames, as reported by Android's
+   * AudioManager.PROPERTY_OUTPUT_FRAMES_PER_BUFFER, or 0 if unknown. At the
+   * native rate the segments are sized to a multiple of it.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_NATIVE_FRAMES_PER_BUFFER,
+      g_param_spec_int ("native-frames-per-buffer", "Native frames per buffer",
+          "Burst size of the device in frames (0 = unknown)", 0, G_MAXINT,
+          DEFAULT_NATIVE_FRAMES_PER_BUFFER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstOpenSLESSink:low-latency:
+   *
+   * Use segments of a single device burst and ask for the low latency
+   * performance mode on Android 7.1 and newer.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Use the smallest buffers the device allows", DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
 
   gst_element_class_set_static_metadata (gstelement_class, "OpenSL ES Sink",
@@ -278,6 +378,8 @@ gst_opensles_sink_class_init (GstOpenSLESSinkClass * klass)
       "Output sound using the OpenSL ES APIs",
       "Josep Torra <support@fluendo.com>");
 
+  gstbasesink_class->get_caps = GST_DEBUG_FUNCPTR (gst_opensles_sink_getcaps);
+
   gstbaseaudiosink_class->create_ringbuffer =
       GST_DEBUG_FUNCPTR (gst_opensles_sink_create_ringbuffer);
 }
@@ -288,6 +390,9 @@ gst_opensles_sink_init (GstOpenSLESSink * sink)
   sink->stream_type = DEFAULT_STREAM_TYPE;
   sink->volume = DEFAULT_VOLUME;
   sink->mute = DEFAULT_MUTE;
+  sink->native_rate = DEFAULT_NATIVE_RATE;
+  sink->native_frames_per_buffer = DEFAULT_NATIVE_FRAMES_PER_BUFFER;
+  sink->low_latency = DEFAULT_LOW_LATENCY;
 
   _opensles_query_capabilities (sink);
 
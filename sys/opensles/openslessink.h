@@ -44,6 +44,10 @@ struct _GstOpenSLESSink
 
   gfloat volume;
   gboolean mute;
+
+  gint native_rate;
+  gint native_frames_per_buffer;
+  gboolean low_latency;
 };
 
 struct _GstOpenSLESSinkClass
@@ -63,10 +63,17 @@ enum
 {
   PROP_0,
   PROP_PRESET,
+  PROP_NATIVE_RATE,
+  PROP_NATIVE_FRAMES_PER_BUFFER,
+  PROP_LOW_LATENCY
 };
 
 #define DEFAULT_PRESET GST_OPENSLES_RECORDING_PRESET_NONE
 
+#define DEFAULT_NATIVE_RATE 0
+#define DEFAULT_NATIVE_FRAMES_PER_BUFFER 0
+#define DEFAULT_LOW_LATENCY FALSE
+
 
 static void
 gst_opensles_src_set_property (GObject * object, guint prop_id,
@@ -78,6 +85,15 @@ gst_opensles_src_set_property (GObject * object, guint prop_id,
     case PROP_PRESET:
       src->preset = g_value_get_enum (value);
       break;
+    case PROP_NATIVE_RATE:
+      src->native_rate = g_value_get_int (value);
+      break;
+    case PROP_NATIVE_FRAMES_PER_BUFFER:
+      src->native_frames_per_buffer = g_value_get_int (value);
+      break;
+    case PROP_LOW_LATENCY:
+      src->low_latency = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -94,6 +110,15 @@ gst_opensles_src_get_property (GObject * object, guint prop_id,
     case PROP_PRESET:
       g_value_set_enum (value, src->preset);
       break;
+    case PROP_NATIVE_RATE:
+      g_value_set_int (value, src->native_rate);
+      break;
+    case PROP_NATIVE_FRAMES_PER_BUFFER:
+      g_value_set_int (value, src->native_frames_per_buffer);
+      break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, src->low_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -103,23 +128,49 @@ gst_opensles_src_get_property (GObject * object, guint prop_id,
 static GstAudioRingBuffer *
 gst_opensles_src_create_ringbuffer (GstAudioBaseSrc * base)
 {
+  GstOpenSLESSrc *src = GST_OPENSLES_SRC (base);
   GstAudioRingBuffer *rb;
 
   rb = gst_opensles_ringbuffer_new (RB_MODE_SRC);
-  GST_OPENSLES_RING_BUFFER (rb)->preset = GST_OPENSLES_SRC (base)->preset;
+  GST_OPENSLES_RING_BUFFER (rb)->preset = src->preset;
+
+  GST_OPENSLES_RING_BUFFER (rb)->native_rate = src->native_rate;
+  GST_OPENSLES_RING_BUFFER (rb)->native_frames_per_buffer =
+      src->native_frames_per_buffer;
+  GST_OPENSLES_RING_BUFFER (rb)->low_latency = src->low_latency;
 
   return rb;
 }
 
+static GstCaps *
+gst_opensles_src_getcaps (GstBaseSrc * bsrc, GstCaps * filter)
+{
+  GstOpenSLESSrc *src = GST_OPENSLES_SRC (bsrc);
+  GstCaps *caps, *tmp;
+
+  caps = gst_pad_get_pad_template_caps (GST_BASE_SRC_PAD (bsrc));
+  caps = gst_opensles_caps_prefer_rate (caps, src->native_rate);
+
+  if (filter) {
+    tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+    caps = tmp;
+  }
+
+  return caps;
+}
+
 static void
 gst_opensles_src_class_init (GstOpenSLESSrcClass * klass)
 {
   GObjectClass *gobject_class;
   GstElementClass *gstelement_class;
+  GstBaseSrcClass *gstbasesrc_class;
   GstAudioBaseSrcClass *gstaudiobasesrc_class;
 
   gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
+  gstbasesrc_class = (GstBaseSrcClass *) klass;
   gstaudiobasesrc_class = (GstAudioBaseSrcClass *) klass;
 
   gobject_class->set_property = gst_opensles_src_set_property;
@@ -130,6 +181,54 @@ gst_opensles_src_class_init (GstOpenSLESSrcClass * klass)
           GST_TYPE_OPENSLES_RECORDING_PRESET, DEFAULT_PRESET,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOpenSLESSrc:native-rate:
+   *
+   * The native sample rate of the device, as reported by Android's
+   * AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE, or 0 if unknown. The rate is
+   * preferred during negotiation, because Android only uses its fast capture
+   * path at this rate.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_NATIVE_RATE,
+      g_param_spec_int ("native-rate", "Native rate",
+          "Native sample rate of the device (0 = unknown)", 0, G_MAXINT,
+          DEFAULT_NATIVE_RATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstOpenSLESSrc:native-frames-per-buffer:
+   *
+   * The burst size of the device in frames, as reported by Android's
+   * AudioManager.PROPERTY_OUTPUT_FRAMES_PER_BUFFER, or 0 if unknown. At the
+   * native rate the segments are sized to a multiple of it.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_NATIVE_FRAMES_PER_BUFFER,
+      g_param_spec_int ("native-frames-per-buffer", "Native frames per buffer",
+          "Burst size of the device in frames (0 = unknown)", 0, G_MAXINT,
+          DEFAULT_NATIVE_FRAMES_PER_BUFFER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstOpenSLESSrc:low-latency:
+   *
+   * Use segments of a single device burst and ask for the low latency
+   * performance mode on Android 7.1 and newer. Without a
+   * #GstOpenSLESSrc:preset the voice recognition preset is used, as it is the
+   * one without input effects.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Use the smallest buffers the device allows", DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
 
   gst_element_class_set_static_metadata (gstelement_class, "OpenSL ES Src",
@@ -137,6 +236,8 @@ gst_opensles_src_class_init (GstOpenSLESSrcClass * klass)
       "Input sound using the OpenSL ES APIs",
       "Josep Torra <support@fluendo.com>");
 
+  gstbasesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_opensles_src_getcaps);
+
   gstaudiobasesrc_class->create_ringbuffer =
       GST_DEBUG_FUNCPTR (gst_opensles_src_create_ringbuffer);
 }
@@ -150,4 +251,7 @@ gst_opensles_src_init (GstOpenSLESSrc * src)
   GST_AUDIO_BASE_SRC (src)->latency_time = 20000;
 
   src->preset = DEFAULT_PRESET;
+  src->native_rate = DEFAULT_NATIVE_RATE;
+  src->native_frames_per_buffer = DEFAULT_NATIVE_FRAMES_PER_BUFFER;
+  src->low_latency = DEFAULT_LOW_LATENCY;
 }
@@ -40,6 +40,10 @@ struct _GstOpenSLESSrc
 {
   GstAudioBaseSrc src;
   GstOpenSLESRecordingPreset preset;
+
+  gint native_rate;
+  gint native_frames_per_buffer;
+  gboolean low_latency;
 };
 
 struct _GstOpenSLESSrcClass
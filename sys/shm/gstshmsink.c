@@ -39,6 +39,7 @@
 #include "gstshmsink.h"
 
 #include <gst/gst.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
 
@@ -58,7 +59,9 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_RING_SLOTS,
+  PROP_SEND_FDS
 };
 
 struct GstShmClient
@@ -69,6 +72,8 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_RING_SLOTS (0)
+#define DEFAULT_SEND_FDS (FALSE)
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -352,6 +357,8 @@ gst_shm_sink_init (GstShmSink * self)
   g_cond_init (&self->cond);
   self->size = DEFAULT_SIZE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
+  self->ring_slots = DEFAULT_RING_SLOTS;
+  self->send_fds = DEFAULT_SEND_FDS;
   self->perms = DEFAULT_PERMS;
 
   gst_allocation_params_init (&self->params);
@@ -415,6 +422,41 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:ring-slots:
+   *
+   * When set, the shared memory area is split into this many slots of the
+   * size of the largest buffer seen so far, each buffer is written to a free
+   * slot and the sources take the latest one without any acknowledgement.
+   * Buffers only get dropped if all slots are held by slow sources. The area
+   * is recreated, and the sources told about it, when a larger buffer comes.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_RING_SLOTS,
+      g_param_spec_uint ("ring-slots",
+          "Ring slots",
+          "Number of fixed size slots the shared memory area is split into "
+          "(0 = disabled, minimum 2)",
+          0, G_MAXUINT, DEFAULT_RING_SLOTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstShmSink:send-fds:
+   *
+   * Send buffers made of a single dmabuf or memfd backed memory to the
+   * sources as file descriptors over the control socket instead of copying
+   * them into the shared memory area. The sources must support it, older
+   * ones fail when they get such a buffer.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_SEND_FDS,
+      g_param_spec_boolean ("send-fds",
+          "Send file descriptors",
+          "Pass the file descriptors of fd backed memory instead of copying it",
+          DEFAULT_SEND_FDS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
       g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
@@ -474,7 +516,8 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       break;
     case PROP_SHM_SIZE:
       GST_OBJECT_LOCK (object);
-      if (self->pipe) {
+      /* a ring is sized from the buffers */
+      if (self->pipe && !sp_writer_get_ring (self->pipe, NULL, NULL)) {
         if (sp_writer_resize (self->pipe, g_value_get_uint (value)) < 0) {
           /* Swap allocators, so we can know immediately if the memory is
            * ours */
@@ -503,6 +546,18 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_RING_SLOTS:
+      GST_OBJECT_LOCK (object);
+      self->ring_slots = g_value_get_uint (value);
+      if (self->ring_slots == 1)
+        self->ring_slots = 2;
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_SEND_FDS:
+      GST_OBJECT_LOCK (object);
+      self->send_fds = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
@@ -532,6 +587,12 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_RING_SLOTS:
+      g_value_set_uint (value, self->ring_slots);
+      break;
+    case PROP_SEND_FDS:
+      g_value_set_boolean (value, self->send_fds);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -656,6 +717,84 @@ gst_shm_sink_can_render (GstShmSink * self, GstClockTime time)
   return TRUE;
 }
 
+/* Called with the object lock, releases it */
+static GstFlowReturn
+gst_shm_sink_render_ring (GstShmSink * self, GstBuffer * buf)
+{
+  gsize size = gst_buffer_get_size (buf);
+  size_t slot_size = 0;
+  unsigned int n_slots = 0;
+  char *slot;
+
+  if (!sp_writer_get_ring (self->pipe, &slot_size, &n_slots) ||
+      size > slot_size || n_slots != self->ring_slots) {
+    slot_size = MAX (size, slot_size);
+
+    if (sp_writer_set_ring (self->pipe, slot_size, self->ring_slots) < 0) {
+      GST_OBJECT_UNLOCK (self);
+      GST_ELEMENT_ERROR (self, RESOURCE, NO_SPACE_LEFT,
+          ("Could not create the shared memory ring"),
+          ("Could not create a ring of %u slots of %" G_GSIZE_FORMAT " bytes",
+              self->ring_slots, slot_size));
+      return GST_FLOW_ERROR;
+    }
+
+    /* memory from the old allocator is not in the ring */
+    gst_object_unref (self->allocator);
+    self->allocator = gst_shm_sink_allocator_new (self);
+
+    GST_DEBUG_OBJECT (self, "Created ring of %u slots of %" G_GSIZE_FORMAT
+        " bytes", self->ring_slots, slot_size);
+  }
+
+  slot = sp_writer_ring_acquire (self->pipe);
+  if (slot == NULL) {
+    GST_OBJECT_UNLOCK (self);
+    GST_DEBUG_OBJECT (self, "All ring slots are in use, dropping buffer %p",
+        buf);
+    return GST_FLOW_OK;
+  }
+
+  gst_buffer_extract (buf, 0, slot, size);
+  sp_writer_ring_publish (self->pipe, slot, size);
+  GST_OBJECT_UNLOCK (self);
+
+  return GST_FLOW_OK;
+}
+
+/* Called with the object lock, releases it */
+static GstFlowReturn
+gst_shm_sink_render_fd (GstShmSink * self, GstBuffer * buf)
+{
+  GstMemory *memory = gst_buffer_peek_memory (buf, 0);
+  gsize offset, maxsize, size;
+  unsigned int flags = 0;
+  int rv;
+
+  size = gst_memory_get_sizes (memory, &offset, &maxsize);
+  if (gst_is_dmabuf_memory (memory))
+    flags |= SHM_FD_BUFFER_FLAG_DMABUF;
+
+  /* the buffer is kept until all clients are done with the memory */
+  gst_buffer_ref (buf);
+  rv = sp_writer_send_fd (self->pipe, gst_fd_memory_get_fd (memory), offset,
+      size, maxsize, flags, buf);
+  GST_OBJECT_UNLOCK (self);
+
+  if (rv <= 0)
+    gst_buffer_unref (buf);
+
+  if (rv == 0) {
+    GST_DEBUG_OBJECT (self, "No clients connected, unreffing buffer");
+  } else if (rv < 0) {
+    GST_ELEMENT_ERROR (self, STREAM, FAILED, ("Invalid fd memory"),
+        ("The shmpipe library rejects the memory of buffer %p", buf));
+    return GST_FLOW_ERROR;
+  }
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
@@ -674,12 +813,31 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
       goto flushing;
   }
 
+  if (self->ring_slots > 0)
+    return gst_shm_sink_render_ring (self, buf);
+
+  /* ring mode was turned off, go back to a regular area */
+  if (sp_writer_get_ring (self->pipe, NULL, NULL)) {
+    if (sp_writer_resize (self->pipe, self->size) < 0) {
+      GST_OBJECT_UNLOCK (self);
+      GST_ELEMENT_ERROR (self, RESOURCE, NO_SPACE_LEFT,
+          ("Could not create the shared memory area"),
+          ("Could not create an area of %u bytes", self->size));
+      return GST_FLOW_ERROR;
+    }
+    gst_object_unref (self->allocator);
+    self->allocator = gst_shm_sink_allocator_new (self);
+  }
+
   while (!gst_shm_sink_can_render (self, GST_BUFFER_TIMESTAMP (buf))) {
     g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
     if (self->unlock)
       goto flushing;
   }
 
+  if (self->send_fds && gst_buffer_n_memory (buf) == 1 &&
+      gst_is_fd_memory (gst_buffer_peek_memory (buf, 0)))
+    return gst_shm_sink_render_fd (self, buf);
 
   if (gst_buffer_n_memory (buf) > 1) {
     GST_LOG_OBJECT (self, "Buffer %p has %d GstMemory, we only support a single"
@@ -955,7 +1113,8 @@ gst_shm_sink_propose_allocation (GstBaseSink * sink, GstQuery * query)
 {
   GstShmSink *self = GST_SHM_SINK (sink);
 
-  if (self->allocator)
+  /* buffers are copied into the ring slots anyway */
+  if (self->allocator && !self->ring_slots)
     gst_query_add_allocation_param (query, GST_ALLOCATOR (self->allocator),
         NULL);
 
@@ -41,8 +41,10 @@
 #include "gstshmsrc.h"
 
 #include <gst/gst.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
+#include <unistd.h>
 
 /* signals */
 enum
@@ -56,15 +58,27 @@ enum
   PROP_0,
   PROP_SOCKET_PATH,
   PROP_IS_LIVE,
-  PROP_SHM_AREA_NAME
+  PROP_SHM_AREA_NAME,
+  PROP_SKIP_TO_LATEST
 };
 
+#define DEFAULT_SKIP_TO_LATEST (TRUE)
+
 struct GstShmBuffer
 {
   char *buf;
   GstShmPipe *pipe;
 };
 
+/* attached to the memory imported from a file descriptor */
+struct GstShmFdBuffer
+{
+  unsigned long id;
+  GstShmPipe *pipe;
+};
+
+static GQuark fd_buffer_quark;
+
 
 GST_DEBUG_CATEGORY_STATIC (shmsrc_debug);
 #define GST_CAT_DEFAULT shmsrc_debug
@@ -139,6 +153,20 @@ gst_shm_src_class_init (GstShmSrcClass * klass)
           "The name of the shared memory area used to get buffers",
           NULL, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSrc:skip-to-latest:
+   *
+   * When the matching shmsink is in ring mode, take the latest buffer
+   * written to the ring instead of the one following the previous buffer,
+   * dropping the ones in between.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_SKIP_TO_LATEST,
+      g_param_spec_boolean ("skip-to-latest", "Skip to latest",
+          "Always take the latest buffer from a ring, dropping older ones",
+          DEFAULT_SKIP_TO_LATEST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -148,6 +176,8 @@ gst_shm_src_class_init (GstShmSrcClass * klass)
       "Olivier Crete <olivier.crete@collabora.co.uk>");
 
   GST_DEBUG_CATEGORY_INIT (shmsrc_debug, "shmsrc", 0, "Shared Memory Source");
+
+  fd_buffer_quark = g_quark_from_static_string ("GstShmSrcFdBuffer");
 }
 
 static void
@@ -155,6 +185,7 @@ gst_shm_src_init (GstShmSrc * self)
 {
   self->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&self->pollfd);
+  self->skip_to_latest = DEFAULT_SKIP_TO_LATEST;
 }
 
 static void
@@ -164,6 +195,10 @@ gst_shm_src_finalize (GObject * object)
 
   gst_poll_free (self->poll);
   g_free (self->socket_path);
+  if (self->fd_allocator)
+    gst_object_unref (self->fd_allocator);
+  if (self->dmabuf_allocator)
+    gst_object_unref (self->dmabuf_allocator);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -191,6 +226,11 @@ gst_shm_src_set_property (GObject * object, guint prop_id,
       gst_base_src_set_live (GST_BASE_SRC (object),
           g_value_get_boolean (value));
       break;
+    case PROP_SKIP_TO_LATEST:
+      GST_OBJECT_LOCK (object);
+      self->skip_to_latest = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -218,6 +258,11 @@ gst_shm_src_get_property (GObject * object, guint prop_id,
         g_value_set_string (value, sp_get_shm_area_name (self->pipe->pipe));
       GST_OBJECT_UNLOCK (object);
       break;
+    case PROP_SKIP_TO_LATEST:
+      GST_OBJECT_LOCK (object);
+      g_value_set_boolean (value, self->skip_to_latest);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -318,6 +363,65 @@ free_buffer (gpointer data)
   g_slice_free (struct GstShmBuffer, gsb);
 }
 
+static void
+free_fd_buffer (gpointer data)
+{
+  struct GstShmFdBuffer *gsb = data;
+
+  GST_LOG ("Freeing fd buffer %lu", gsb->id);
+
+  GST_OBJECT_LOCK (gsb->pipe->src);
+  sp_client_recv_finish_fd (gsb->pipe->pipe, gsb->id);
+  GST_OBJECT_UNLOCK (gsb->pipe->src);
+
+  gst_shm_pipe_dec (gsb->pipe);
+
+  g_slice_free (struct GstShmFdBuffer, gsb);
+}
+
+/* Imports a buffer passed as a file descriptor, which then belongs to the
+ * returned memory */
+static GstMemory *
+gst_shm_src_import_fd (GstShmSrc * self, ShmFdBuffer * fd_buffer, gsize size)
+{
+  GstMemory *memory;
+  struct GstShmFdBuffer *gsb;
+
+  if (fd_buffer->flags & SHM_FD_BUFFER_FLAG_DMABUF) {
+    if (!self->dmabuf_allocator)
+      self->dmabuf_allocator = gst_dmabuf_allocator_new ();
+    memory = gst_dmabuf_allocator_alloc (self->dmabuf_allocator,
+        fd_buffer->fd, fd_buffer->maxsize);
+  } else {
+    if (!self->fd_allocator)
+      self->fd_allocator = gst_fd_allocator_new ();
+    memory = gst_fd_allocator_alloc (self->fd_allocator, fd_buffer->fd,
+        fd_buffer->maxsize, GST_FD_MEMORY_FLAG_NONE);
+  }
+
+  if (!memory) {
+    close (fd_buffer->fd);
+    GST_OBJECT_LOCK (self);
+    sp_client_recv_finish_fd (self->pipe->pipe, fd_buffer->id);
+    GST_OBJECT_UNLOCK (self);
+    return NULL;
+  }
+
+  gst_memory_resize (memory, fd_buffer->offset, size);
+  GST_MINI_OBJECT_FLAG_SET (memory, GST_MEMORY_FLAG_READONLY);
+
+  /* the sink is told once the memory, which may be shared by several
+   * buffers downstream, is freed */
+  gsb = g_slice_new0 (struct GstShmFdBuffer);
+  gsb->id = fd_buffer->id;
+  gsb->pipe = self->pipe;
+  gst_shm_pipe_inc (self->pipe);
+  gst_mini_object_set_qdata (GST_MINI_OBJECT (memory), fd_buffer_quark, gsb,
+      free_fd_buffer);
+
+  return memory;
+}
+
 static GstFlowReturn
 gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
@@ -325,9 +429,26 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   gchar *buf = NULL;
   int rv = 0;
   struct GstShmBuffer *gsb;
+  ShmFdBuffer fd_buffer = { -1, };
 
   do {
-    if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
+    GstClockTime timeout = GST_CLOCK_TIME_NONE;
+
+    /* Buffers in a ring are not announced on the socket, it is only checked
+     * for new areas and errors once the ring has been looked at */
+    GST_OBJECT_LOCK (self);
+    if (sp_client_is_ring (self->pipe->pipe)) {
+      rv = sp_client_ring_recv (self->pipe->pipe, &buf, self->skip_to_latest);
+      GST_OBJECT_UNLOCK (self);
+      if (buf)
+        break;
+      sp_client_ring_wait (self->pipe->pipe, 100 * 1000);
+      timeout = 0;
+    } else {
+      GST_OBJECT_UNLOCK (self);
+    }
+
+    if (gst_poll_wait (self->poll, timeout) < 0) {
       if (errno == EBUSY)
         return GST_FLOW_FLUSHING;
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -354,7 +475,7 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
       buf = NULL;
       GST_LOG_OBJECT (self, "Reading from pipe");
       GST_OBJECT_LOCK (self);
-      rv = sp_client_recv (self->pipe->pipe, &buf);
+      rv = sp_client_recv_fd (self->pipe->pipe, &buf, &fd_buffer);
       GST_OBJECT_UNLOCK (self);
       if (rv < 0) {
         GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -362,7 +483,25 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
         return GST_FLOW_ERROR;
       }
     }
-  } while (buf == NULL);
+  } while (buf == NULL && fd_buffer.fd < 0);
+
+  if (fd_buffer.fd >= 0) {
+    GstMemory *memory;
+
+    GST_LOG_OBJECT (self, "Got fd %d of size %d", fd_buffer.fd, rv);
+
+    memory = gst_shm_src_import_fd (self, &fd_buffer, rv);
+    if (!memory) {
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+          ("Could not import the memory of fd %d", fd_buffer.fd));
+      return GST_FLOW_ERROR;
+    }
+
+    *outbuf = gst_buffer_new ();
+    gst_buffer_append_memory (*outbuf, memory);
+
+    return GST_FLOW_OK;
+  }
 
   GST_LOG_OBJECT (self, "Got buffer %p of size %d", buf, rv);
 
@@ -415,6 +554,11 @@ gst_shm_src_unlock (GstBaseSrc * bsrc)
   self->unlocked = TRUE;
   gst_poll_set_flushing (self->poll, TRUE);
 
+  GST_OBJECT_LOCK (self);
+  if (self->pipe)
+    sp_client_ring_wakeup (self->pipe->pipe);
+  GST_OBJECT_UNLOCK (self);
+
   return TRUE;
 }
 
@@ -56,6 +56,10 @@ struct _GstShmSrc
 
   GstFlowReturn flow_return;
   gboolean unlocked;
+  gboolean skip_to_latest;
+
+  GstAllocator *fd_allocator;
+  GstAllocator *dmabuf_allocator;
 };
 
 struct _GstShmSrcClass
@@ -46,6 +46,12 @@
 #include <limits.h>
 #include <sys/mman.h>
 #include <assert.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 
 #include "shmalloc.h"
 
@@ -67,23 +73,85 @@
  * type 4: ack buffer
  * offset
  *
+ * type 5: new ring area
+ * Same payload as type 1
+ *
+ * type 6: new fd buffer
+ * size
+ * offset
+ * maxsize
+ * id
+ * flags
+ * The file descriptor of the memory is passed along with the command as
+ * SCM_RIGHTS ancillary data. It is acknowledged with a type 4 command with
+ * an area id of -1 and the id as offset.
+ *
  * Type 4 goes from the client to the server
  * The rest are from the server to the client
- * The client should never write in the SHM
+ * The client should never write in the SHM, except in the header of a ring
+ * area
+ *
+ * A ring area starts with a ShmRingHeader followed by the slots, which all
+ * have the same size. No buffer or ack commands are exchanged for it: the
+ * writer publishes a frame by bumping the sequence numbers in the header and
+ * waking up the readers through a futex in it, a reader takes the frame it
+ * wants by counting itself in the "readers" field of its slot. The writer
+ * never reuses a slot that has readers, nor the one with the latest frame.
  */
 
 
 #define LISTEN_BACKLOG 10
 
+#define SHM_RING_MAGIC 0x474e4952       /* "RING" */
+#define SHM_RING_ALIGN 4096
+#define SHM_RING_ALIGN_UP(x) (((x) + SHM_RING_ALIGN - 1) & ~(SHM_RING_ALIGN - 1))
+
 enum
 {
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_NEW_RING_AREA = 5,
+  COMMAND_NEW_FD_BUFFER = 6
 };
 
+/* area id of the buffers whose memory is passed as a file descriptor */
+#define FD_BUFFER_AREA_ID (-1)
+
 typedef struct _ShmArea ShmArea;
+typedef struct _ShmRingSlot ShmRingSlot;
+typedef struct _ShmRingHeader ShmRingHeader;
+
+/* seq is the sequence number of the frame in the slot, 0 while the writer
+ * is filling it. readers is the number of readers holding it */
+struct _ShmRingSlot
+{
+  uint64_t seq;
+  uint64_t size;
+  int32_t readers;
+  uint32_t padding;
+};
+
+struct _ShmRingHeader
+{
+  uint32_t magic;
+  uint32_t n_slots;
+  uint64_t slot_size;
+  uint64_t data_offset;
+  /* sequence number of the latest frame, 0 if there is none yet */
+  uint64_t write_seq;
+  /* incremented for every frame, readers wait on it */
+  int32_t futex;
+  /* number of readers waiting on the futex */
+  int32_t waiters;
+  ShmRingSlot slots[0];
+};
+
+/* Everything in a ring header is accessed by several processes */
+#define ring_load(p) __atomic_load_n ((p), __ATOMIC_SEQ_CST)
+#define ring_store(p, v) __atomic_store_n ((p), (v), __ATOMIC_SEQ_CST)
+#define ring_add(p, v) __atomic_add_fetch ((p), (v), __ATOMIC_SEQ_CST)
 
 struct _ShmArea
 {
@@ -101,6 +169,9 @@ struct _ShmArea
 
   ShmAllocSpace *allocspace;
 
+  /* start of shm_area_buf if this is a ring area, NULL otherwise */
+  ShmRingHeader *ring;
+
   ShmArea *next;
 };
 
@@ -108,6 +179,7 @@ struct _ShmBuffer
 {
   int use_count;
 
+  /* NULL for fd buffers, then offset is the id of the buffer */
   ShmArea *shm_area;
   unsigned long offset;
   size_t size;
@@ -141,6 +213,16 @@ struct _ShmPipe
   ShmClient *clients;
 
   mode_t perms;
+
+  /* writer: id of the last fd buffer sent */
+  unsigned long next_fd_buffer_id;
+
+  /* writer: slot of the last frame written in the ring */
+  unsigned int ring_slot;
+  /* reader: sequence number of the last frame taken from the ring, and
+   * futex value the next wait is for */
+  uint64_t ring_seq;
+  int32_t ring_token;
 };
 
 struct _ShmClient
@@ -179,10 +261,19 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      unsigned long size;
+      unsigned long offset;
+      unsigned long maxsize;
+      unsigned long id;
+      unsigned int flags;
+    } fd_buffer;
   } payload;
 };
 
-static ShmArea *sp_open_shm (char *path, int id, mode_t perms, size_t size);
+static ShmArea *sp_open_shm (char *path, int id, mode_t perms, size_t size,
+    int ring);
 static void sp_close_shm (ShmArea * area);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
@@ -244,7 +335,7 @@ sp_writer_create (const char *path, size_t size, mode_t perms)
   if (listen (self->main_socket, LISTEN_BACKLOG) < 0)
     RETURN_ERROR ("listen() failed (%d): %s\n", errno, strerror (errno));
 
-  self->shm_area = sp_open_shm (NULL, ++self->next_area_id, perms, size);
+  self->shm_area = sp_open_shm (NULL, ++self->next_area_id, perms, size, 0);
 
   self->perms = perms;
 
@@ -263,16 +354,28 @@ sp_writer_create (const char *path, size_t size, mode_t perms)
   return NULL;                                            \
   } while (0)
 
+/* Readers update the header of a ring area, so everyone who can read it must
+ * be able to write it */
+static mode_t
+sp_area_perms (mode_t perms, int ring)
+{
+  if (ring)
+    perms |= (perms & (S_IRUSR | S_IRGRP | S_IROTH)) >> 1;
+
+  return perms;
+}
+
 /**
  * sp_open_shm:
  * @path: Path of the shm area for a reader,
  *  NULL if this is a writer (then it will allocate its own path)
+ * @ring: whether this is a ring area
  *
  * Opens a ShmArea
  */
 
 static ShmArea *
-sp_open_shm (char *path, int id, mode_t perms, size_t size)
+sp_open_shm (char *path, int id, mode_t perms, size_t size, int ring)
 {
   ShmArea *area = spalloc_new (ShmArea);
   char tmppath[32];
@@ -291,7 +394,7 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
 
 
   if (path)
-    flags = O_RDONLY;
+    flags = ring ? O_RDWR : O_RDONLY;
   else
 #ifdef HAVE_OSX
     flags = O_RDWR | O_CREAT | O_EXCL;
@@ -306,7 +409,7 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
   } else {
     do {
       snprintf (tmppath, sizeof (tmppath), "/shmpipe.%5d.%5d", getpid (), i++);
-      area->shm_fd = shm_open (tmppath, flags, perms);
+      area->shm_fd = shm_open (tmppath, flags, sp_area_perms (perms, ring));
     } while (area->shm_fd < 0 && errno == EEXIST);
   }
 
@@ -324,7 +427,7 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
     prot = PROT_READ | PROT_WRITE;
   } else {
     area->shm_area_name = strdup (path);
-    prot = PROT_READ;
+    prot = ring ? PROT_READ | PROT_WRITE : PROT_READ;
   }
 
   area->shm_area_buf = mmap (NULL, size, prot, MAP_SHARED, area->shm_fd, 0);
@@ -334,8 +437,22 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
 
   area->id = id;
 
-  if (!path)
+  if (ring) {
+    ShmRingHeader *header = (ShmRingHeader *) area->shm_area_buf;
+
+    /* the writer fills the header in after creating the area */
+    if (path && (size < sizeof (ShmRingHeader)
+            || ring_load (&header->magic) != SHM_RING_MAGIC
+            || header->n_slots == 0
+            || header->data_offset < sizeof (ShmRingHeader) +
+            header->n_slots * sizeof (ShmRingSlot)
+            || header->data_offset + header->n_slots * header->slot_size >
+            size))
+      RETURN_ERROR ("Invalid ring header in %s\n", path);
+    area->ring = header;
+  } else if (!path) {
     area->allocspace = shm_alloc_space_new (area->shm_area_len);
+  }
 
   return area;
 }
@@ -464,7 +581,7 @@ sp_writer_setperms_shm (ShmPipe * self, mode_t perms)
 
   self->perms = perms;
   for (area = self->shm_area; area; area = area->next)
-    ret |= fchmod (area->shm_fd, perms);
+    ret |= fchmod (area->shm_fd, sp_area_perms (perms, area->ring != NULL));
 
   ret |= chmod (self->socket_path, perms);
 
@@ -485,28 +602,73 @@ send_command (int fd, struct CommandBuffer *cb, unsigned short int type,
   return 1;
 }
 
-int
-sp_writer_resize (ShmPipe * self, size_t size)
+static int
+send_command_with_fd (int fd, struct CommandBuffer *cb,
+    unsigned short int type, int area_id, int passed_fd)
 {
-  ShmArea *newarea;
-  ShmArea *old_current;
-  ShmClient *client;
-  int c = 0;
-  int pathlen;
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr cmsg;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  struct cmsghdr *cmsg;
 
-  if (self->shm_area->shm_area_len == size)
+  cb->type = type;
+  cb->area_id = area_id;
+
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  memset (&control, 0, sizeof (control));
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &passed_fd, sizeof (int));
+
+  if (sendmsg (fd, &msg, MSG_NOSIGNAL) != sizeof (struct CommandBuffer))
     return 0;
 
-  newarea = sp_open_shm (NULL, ++self->next_area_id, self->perms, size);
+  return 1;
+}
 
-  if (!newarea)
-    return -1;
+static int
+send_new_area (int fd, ShmArea * area)
+{
+  struct CommandBuffer cb = { 0 };
+  int pathlen = strlen (area->shm_area_name) + 1;
+
+  cb.payload.new_shm_area.size = area->shm_area_len;
+  cb.payload.new_shm_area.path_size = pathlen;
+  if (!send_command (fd, &cb, area->ring ? COMMAND_NEW_RING_AREA :
+          COMMAND_NEW_SHM_AREA, area->id))
+    return 0;
+
+  if (send (fd, area->shm_area_name, pathlen, MSG_NOSIGNAL) != pathlen)
+    return 0;
+
+  return 1;
+}
+
+/* Makes @newarea the area new buffers are written to, and tells the clients
+ * to switch to it */
+static int
+sp_writer_replace_area (ShmPipe * self, ShmArea * newarea)
+{
+  ShmArea *old_current;
+  ShmClient *client;
+  int c = 0;
 
   old_current = self->shm_area;
   newarea->next = self->shm_area;
   self->shm_area = newarea;
-
-  pathlen = strlen (newarea->shm_area_name) + 1;
+  self->ring_slot = 0;
 
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
@@ -515,13 +677,7 @@ sp_writer_resize (ShmPipe * self, size_t size)
             old_current->id))
       continue;
 
-    cb.payload.new_shm_area.size = newarea->shm_area_len;
-    cb.payload.new_shm_area.path_size = pathlen;
-    if (!send_command (client->fd, &cb, COMMAND_NEW_SHM_AREA, newarea->id))
-      continue;
-
-    if (send (client->fd, newarea->shm_area_name, pathlen, MSG_NOSIGNAL) !=
-        pathlen)
+    if (!send_new_area (client->fd, newarea))
       continue;
     c++;
   }
@@ -532,13 +688,147 @@ sp_writer_resize (ShmPipe * self, size_t size)
   return c;
 }
 
+int
+sp_writer_resize (ShmPipe * self, size_t size)
+{
+  ShmArea *newarea;
+
+  if (self->shm_area->shm_area_len == size && !self->shm_area->ring)
+    return 0;
+
+  newarea = sp_open_shm (NULL, ++self->next_area_id, self->perms, size, 0);
+
+  if (!newarea)
+    return -1;
+
+  return sp_writer_replace_area (self, newarea);
+}
+
+/* Replaces the shm area with a ring of @n_slots slots of @slot_size bytes.
+ * Returns the number of clients that were told about it, -1 on error */
+int
+sp_writer_set_ring (ShmPipe * self, size_t slot_size, unsigned int n_slots)
+{
+  ShmArea *newarea;
+  ShmRingHeader *header;
+  size_t header_size;
+
+  /* the slot of the latest frame is never reused */
+  if (n_slots < 2 || slot_size == 0)
+    return -1;
+
+  slot_size = SHM_RING_ALIGN_UP (slot_size);
+  header_size = SHM_RING_ALIGN_UP (sizeof (ShmRingHeader) +
+      n_slots * sizeof (ShmRingSlot));
+
+  newarea = sp_open_shm (NULL, ++self->next_area_id, self->perms,
+      header_size + n_slots * slot_size, 1);
+
+  if (!newarea)
+    return -1;
+
+  /* the area was zeroed by ftruncate() */
+  header = newarea->ring;
+  header->n_slots = n_slots;
+  header->slot_size = slot_size;
+  header->data_offset = header_size;
+  ring_store (&header->magic, SHM_RING_MAGIC);
+
+  return sp_writer_replace_area (self, newarea);
+}
+
+int
+sp_writer_get_ring (ShmPipe * self, size_t * slot_size,
+    unsigned int *n_slots)
+{
+  ShmRingHeader *header = self->shm_area ? self->shm_area->ring : NULL;
+
+  if (!header)
+    return 0;
+
+  if (slot_size)
+    *slot_size = header->slot_size;
+  if (n_slots)
+    *n_slots = header->n_slots;
+
+  return 1;
+}
+
+/* Returns a free slot to write the next frame to, NULL if all of them are
+ * held by readers */
+char *
+sp_writer_ring_acquire (ShmPipe * self)
+{
+  ShmArea *area = self->shm_area;
+  ShmRingHeader *header = area->ring;
+  uint64_t latest;
+  unsigned int i;
+
+  if (!header)
+    return NULL;
+
+  latest = ring_load (&header->write_seq);
+
+  for (i = 1; i <= header->n_slots; i++) {
+    unsigned int idx = (self->ring_slot + i) % header->n_slots;
+    ShmRingSlot *slot = &header->slots[idx];
+    uint64_t seq = ring_load (&slot->seq);
+
+    /* keep the latest frame for the readers that are about to take it */
+    if (seq != 0 && seq == latest)
+      continue;
+
+    /* Invalidate the slot before checking for readers: a reader taking it
+     * at the same time either sees the invalid sequence number and gives
+     * up, or is seen here */
+    ring_store (&slot->seq, 0);
+    if (ring_load (&slot->readers) == 0) {
+      self->ring_slot = idx;
+      return area->shm_area_buf + header->data_offset +
+          idx * header->slot_size;
+    }
+    ring_store (&slot->seq, seq);
+  }
+
+  return NULL;
+}
+
+/* Makes the frame written in the slot returned by sp_writer_ring_acquire()
+ * available to the readers */
+void
+sp_writer_ring_publish (ShmPipe * self, char *buf, size_t size)
+{
+  ShmRingHeader *header = self->shm_area->ring;
+  ShmRingSlot *slot = &header->slots[self->ring_slot];
+  uint64_t seq = header->write_seq + 1;
+
+  assert (buf == self->shm_area->shm_area_buf + header->data_offset +
+      self->ring_slot * header->slot_size);
+  assert (size <= header->slot_size);
+
+  ring_store (&slot->size, size);
+  ring_store (&slot->seq, seq);
+  ring_store (&header->write_seq, seq);
+
+  ring_add (&header->futex, 1);
+  if (ring_load (&header->waiters) > 0) {
+#ifdef __linux__
+    syscall (SYS_futex, &header->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+  }
+}
+
 ShmBlock *
 sp_writer_alloc_block (ShmPipe * self, size_t size)
 {
   ShmBlock *block;
-  ShmAllocBlock *ablock =
-      shm_alloc_space_alloc_block (self->shm_area->allocspace, size);
+  ShmAllocBlock *ablock;
+
+  /* there is no allocator in a ring area */
+  if (!self->shm_area->allocspace)
+    return NULL;
 
+  ablock = shm_alloc_space_alloc_block (self->shm_area->allocspace, size);
   if (!ablock)
     return NULL;
 
@@ -591,7 +881,7 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
     return 0;
 
   for (area = self->shm_area; area; area = area->next) {
-    if (buf >= area->shm_area_buf &&
+    if (area->allocspace && buf >= area->shm_area_buf &&
         buf < (area->shm_area_buf + area->shm_area_len)) {
       offset = buf - area->shm_area_buf;
       ablock = shm_alloc_space_block_get (area->allocspace, offset);
@@ -639,33 +929,142 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   return c;
 }
 
+/* Sends the memory behind @fd to all clients, without copying it. The
+ * clients get their own file descriptor for it, the tag is given back once
+ * they have all released it. Returns the number of clients this has
+ * successfully been sent to */
+
+int
+sp_writer_send_fd (ShmPipe * self, int fd, size_t offset, size_t size,
+    size_t maxsize, unsigned int flags, void *tag)
+{
+  ShmBuffer *sb;
+  ShmClient *client = NULL;
+  int i = 0;
+  int c = 0;
+
+  if (self->num_clients == 0)
+    return 0;
+
+  if (fd < 0 || offset + size > maxsize)
+    return -1;
+
+  sb = spalloc_alloc (sizeof (ShmBuffer) + sizeof (int) * self->num_clients);
+  memset (sb, 0, sizeof (ShmBuffer));
+  memset (sb->clients, -1, sizeof (int) * self->num_clients);
+  sb->offset = ++self->next_fd_buffer_id;
+  sb->size = size;
+  sb->num_clients = self->num_clients;
+  sb->tag = tag;
+
+  for (client = self->clients; client; client = client->next) {
+    struct CommandBuffer cb = { 0 };
+    cb.payload.fd_buffer.size = size;
+    cb.payload.fd_buffer.offset = offset;
+    cb.payload.fd_buffer.maxsize = maxsize;
+    cb.payload.fd_buffer.id = sb->offset;
+    cb.payload.fd_buffer.flags = flags;
+    if (!send_command_with_fd (client->fd, &cb, COMMAND_NEW_FD_BUFFER,
+            FD_BUFFER_AREA_ID, fd))
+      continue;
+    sb->clients[i++] = client->fd;
+    c++;
+  }
+
+  if (c == 0) {
+    spalloc_free1 (sizeof (ShmBuffer) + sizeof (int) * sb->num_clients, sb);
+    return 0;
+  }
+
+  sb->use_count = c;
+
+  sb->next = self->buffers;
+  self->buffers = sb;
+
+  return c;
+}
+
+/* Also receives the file descriptor passed along with the command, if any,
+ * into @passed_fd. It is closed if @passed_fd is NULL */
 static int
-recv_command (int fd, struct CommandBuffer *cb)
+recv_command (int fd, struct CommandBuffer *cb, int *passed_fd)
 {
   int retval;
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr cmsg;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  struct cmsghdr *cmsg;
+
+  if (passed_fd)
+    *passed_fd = -1;
+
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  retval = recvmsg (fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+
+  for (cmsg = retval > 0 ? CMSG_FIRSTHDR (&msg) : NULL; cmsg;
+      cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      int received_fd;
+
+      memcpy (&received_fd, CMSG_DATA (cmsg), sizeof (int));
+      if (passed_fd && *passed_fd < 0)
+        *passed_fd = received_fd;
+      else
+        close (received_fd);
+    }
+  }
 
-  retval = recv (fd, cb, sizeof (struct CommandBuffer), MSG_DONTWAIT);
   if (retval == sizeof (struct CommandBuffer)) {
     return 1;
   } else {
+    if (passed_fd && *passed_fd >= 0) {
+      close (*passed_fd);
+      *passed_fd = -1;
+    }
     return 0;
   }
 }
 
 long int
 sp_client_recv (ShmPipe * self, char **buf)
+{
+  return sp_client_recv_fd (self, buf, NULL);
+}
+
+long int
+sp_client_recv_fd (ShmPipe * self, char **buf, ShmFdBuffer * fd_buffer)
 {
   char *area_name = NULL;
   ShmArea *newarea;
   ShmArea *area;
   struct CommandBuffer cb;
   int retval;
+  int passed_fd = -1;
 
-  if (!recv_command (self->main_socket, &cb))
+  if (fd_buffer)
+    fd_buffer->fd = -1;
+
+  if (!recv_command (self->main_socket, &cb, &passed_fd))
     return -1;
 
+  if (cb.type != COMMAND_NEW_FD_BUFFER && passed_fd >= 0) {
+    close (passed_fd);
+    passed_fd = -1;
+  }
+
   switch (cb.type) {
     case COMMAND_NEW_SHM_AREA:
+    case COMMAND_NEW_RING_AREA:
       assert (cb.payload.new_shm_area.path_size > 0);
       assert (cb.payload.new_shm_area.size > 0);
 
@@ -680,13 +1079,14 @@ sp_client_recv (ShmPipe * self, char **buf)
       area_name[retval] = 0;
 
       newarea = sp_open_shm (area_name, cb.area_id, 0,
-          cb.payload.new_shm_area.size);
+          cb.payload.new_shm_area.size, cb.type == COMMAND_NEW_RING_AREA);
       free (area_name);
       if (!newarea)
         return -4;
 
       newarea->next = self->shm_area;
       self->shm_area = newarea;
+      self->ring_seq = 0;
       break;
 
     case COMMAND_CLOSE_SHM_AREA:
@@ -709,6 +1109,24 @@ sp_client_recv (ShmPipe * self, char **buf)
       }
       return -23;
 
+    case COMMAND_NEW_FD_BUFFER:
+      if (passed_fd < 0)
+        return -24;
+
+      /* a caller that can't take file descriptors just drops the buffer */
+      if (!fd_buffer) {
+        close (passed_fd);
+        sp_client_recv_finish_fd (self, cb.payload.fd_buffer.id);
+        return 0;
+      }
+
+      fd_buffer->fd = passed_fd;
+      fd_buffer->offset = cb.payload.fd_buffer.offset;
+      fd_buffer->maxsize = cb.payload.fd_buffer.maxsize;
+      fd_buffer->id = cb.payload.fd_buffer.id;
+      fd_buffer->flags = cb.payload.fd_buffer.flags;
+      return cb.payload.fd_buffer.size;
+
     default:
       return -99;
   }
@@ -722,14 +1140,16 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
   ShmBuffer *buf = NULL, *prev_buf = NULL;
   struct CommandBuffer cb;
 
-  if (!recv_command (client->fd, &cb))
+  if (!recv_command (client->fd, &cb, NULL))
     return -1;
 
   switch (cb.type) {
     case COMMAND_ACK_BUFFER:
 
       for (buf = self->buffers; buf; buf = buf->next) {
-        if (buf->shm_area->id == cb.area_id &&
+        int area_id = buf->shm_area ? buf->shm_area->id : FD_BUFFER_AREA_ID;
+
+        if (area_id == cb.area_id &&
             buf->offset == cb.payload.ack_buffer.offset) {
           return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
         }
@@ -761,6 +1181,15 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
 
   offset = buf - shm_area->shm_area_buf;
 
+  if (shm_area->ring) {
+    ShmRingHeader *header = shm_area->ring;
+
+    ring_add (&header->slots[(offset - header->data_offset) /
+            header->slot_size].readers, -1);
+    sp_shm_area_dec (self, shm_area);
+    return 1;
+  }
+
   sp_shm_area_dec (self, shm_area);
 
   cb.payload.ack_buffer.offset = offset;
@@ -768,6 +1197,147 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
       self->shm_area->id);
 }
 
+/* Releases a buffer received with sp_client_recv_fd(), the file descriptor
+ * itself is closed by the caller */
+int
+sp_client_recv_finish_fd (ShmPipe * self, unsigned long id)
+{
+  struct CommandBuffer cb = { 0 };
+
+  cb.payload.ack_buffer.offset = id;
+  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER,
+      FD_BUFFER_AREA_ID);
+}
+
+int
+sp_client_is_ring (ShmPipe * self)
+{
+  return self->shm_area && self->shm_area->ring;
+}
+
+static int
+sp_ring_find_slot (ShmRingHeader * header, uint64_t seq)
+{
+  unsigned int i;
+
+  for (i = 0; i < header->n_slots; i++)
+    if (ring_load (&header->slots[i].seq) == seq)
+      return i;
+
+  return -1;
+}
+
+/* Takes the latest frame from the ring, or if @latest is 0 the one following
+ * the previous frame taken, as long as it is still there. Returns the size
+ * of the frame, 0 if there is no new one and a negative number if the
+ * current area is not a ring. The frame must be released with
+ * sp_client_recv_finish() */
+long int
+sp_client_ring_recv (ShmPipe * self, char **buf, int latest)
+{
+  ShmArea *area = self->shm_area;
+  ShmRingHeader *header;
+
+  if (!area || !area->ring)
+    return -1;
+
+  header = area->ring;
+
+  for (;;) {
+    uint64_t write_seq, seq, size;
+    ShmRingSlot *slot;
+    int idx = -1;
+
+    /* read before the sequence number so that no frame is missed by
+     * sp_client_ring_wait() */
+    self->ring_token = ring_load (&header->futex);
+    write_seq = ring_load (&header->write_seq);
+
+    if (write_seq <= self->ring_seq)
+      return 0;
+
+    seq = write_seq;
+    if (!latest && self->ring_seq > 0 && self->ring_seq + 1 < write_seq) {
+      seq = self->ring_seq + 1;
+      idx = sp_ring_find_slot (header, seq);
+      if (idx < 0)
+        seq = write_seq;
+    }
+    if (idx < 0)
+      idx = sp_ring_find_slot (header, seq);
+    /* overwritten in the meantime, there is a newer frame */
+    if (idx < 0)
+      continue;
+
+    slot = &header->slots[idx];
+    ring_add (&slot->readers, 1);
+    if (ring_load (&slot->seq) != seq) {
+      ring_add (&slot->readers, -1);
+      continue;
+    }
+
+    self->ring_seq = seq;
+    size = ring_load (&slot->size);
+    /* written by the other process, checked like the ring header */
+    if (size > header->slot_size) {
+      fprintf (stderr, "Invalid size %llu of ring frame %llu\n",
+          (unsigned long long) size, (unsigned long long) seq);
+      ring_add (&slot->readers, -1);
+      continue;
+    }
+
+    sp_shm_area_inc (area);
+    *buf = area->shm_area_buf + header->data_offset + idx * header->slot_size;
+    return size;
+  }
+}
+
+/* Waits for at most @timeout_us microseconds for a frame newer than what
+ * sp_client_ring_recv() saw, or for sp_client_ring_wakeup() */
+int
+sp_client_ring_wait (ShmPipe * self, unsigned long timeout_us)
+{
+  ShmRingHeader *header = self->shm_area ? self->shm_area->ring : NULL;
+  struct timespec ts;
+
+  if (!header)
+    return -1;
+
+  ring_add (&header->waiters, 1);
+#ifdef __linux__
+  ts.tv_sec = timeout_us / 1000000;
+  ts.tv_nsec = (timeout_us % 1000000) * 1000;
+  syscall (SYS_futex, &header->futex, FUTEX_WAIT, self->ring_token, &ts,
+      NULL, 0);
+#else
+  /* no futex, poll every millisecond */
+  ts.tv_sec = 0;
+  ts.tv_nsec = 1000000;
+  while (timeout_us > 0 && ring_load (&header->futex) == self->ring_token) {
+    nanosleep (&ts, NULL);
+    timeout_us = timeout_us > 1000 ? timeout_us - 1000 : 0;
+  }
+#endif
+  ring_add (&header->waiters, -1);
+
+  return 0;
+}
+
+/* Interrupts sp_client_ring_wait() */
+void
+sp_client_ring_wakeup (ShmPipe * self)
+{
+  ShmRingHeader *header = self->shm_area ? self->shm_area->ring : NULL;
+
+  if (!header)
+    return;
+
+  ring_add (&header->futex, 1);
+#ifdef __linux__
+  syscall (SYS_futex, &header->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
 ShmPipe *
 sp_client_open (const char *path)
 {
@@ -810,8 +1380,6 @@ sp_writer_accept_client (ShmPipe * self)
 {
   ShmClient *client = NULL;
   int fd;
-  struct CommandBuffer cb = { 0 };
-  int pathlen = strlen (self->shm_area->shm_area_name) + 1;
 
 
   fd = accept (self->main_socket, NULL, NULL);
@@ -821,19 +1389,11 @@ sp_writer_accept_client (ShmPipe * self)
     return NULL;
   }
 
-  cb.payload.new_shm_area.size = self->shm_area->shm_area_len;
-  cb.payload.new_shm_area.path_size = pathlen;
-  if (!send_command (fd, &cb, COMMAND_NEW_SHM_AREA, self->shm_area->id)) {
+  if (!send_new_area (fd, self->shm_area)) {
     fprintf (stderr, "Sending new shm area failed: %s", strerror (errno));
     goto error;
   }
 
-  if (send (fd, self->shm_area->shm_area_name, pathlen, MSG_NOSIGNAL) !=
-      pathlen) {
-    fprintf (stderr, "Sending new shm area path failed: %s", strerror (errno));
-    goto error;
-  }
-
   client = spalloc_new (ShmClient);
   client->fd = fd;
 
@@ -883,8 +1443,10 @@ sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf, ShmBuffer * prev_buf,
 
     if (tag)
       *tag = buf->tag;
-    shm_alloc_space_block_dec (buf->ablock);
-    sp_shm_area_dec (self, buf->shm_area);
+    if (buf->shm_area) {
+      shm_alloc_space_block_dec (buf->ablock);
+      sp_shm_area_dec (self, buf->shm_area);
+    }
     spalloc_free1 (sizeof (ShmBuffer) + sizeof (int) * buf->num_clients, buf);
     return 0;
   }
@@ -933,6 +1495,16 @@ again:
 
   self->num_clients--;
 
+  /* The slots held by a reader that died are never released. They are known
+   * to be free again once there are no readers left */
+  if (self->num_clients == 0 && self->shm_area && self->shm_area->ring) {
+    ShmRingHeader *header = self->shm_area->ring;
+    unsigned int i;
+
+    for (i = 0; i < header->n_slots; i++)
+      ring_store (&header->slots[i].readers, 0);
+  }
+
   spalloc_free (ShmClient, client);
 }
 
@@ -56,6 +56,22 @@
  * buffers are no longer valid. If was valid buffer was received, the
  * client must release it with sp_client_recv_finish() when it is done
  * reading from it.
+ *
+ * In ring mode, enabled by the writer with sp_writer_set_ring(), the shm
+ * area is split into fixed size slots and no message is exchanged per
+ * buffer. The writer gets a free slot with sp_writer_ring_acquire(), writes
+ * into it and calls sp_writer_ring_publish(). Once sp_client_is_ring()
+ * returns true, the reader takes frames with sp_client_ring_recv(), waits
+ * for new ones with sp_client_ring_wait() and still releases them with
+ * sp_client_recv_finish(). It must keep handling the messages on the socket,
+ * as the writer can replace the area.
+ *
+ * Memory that already lives in a file descriptor (e.g. dmabuf or memfd) can
+ * be sent as is with sp_writer_send_fd(), the descriptor is passed over the
+ * control socket. Clients receive it with sp_client_recv_fd(), own the
+ * descriptor they get and release the buffer with
+ * sp_client_recv_finish_fd(). sp_client_recv() acknowledges such buffers
+ * right away and drops them.
  */
 
 
@@ -76,6 +92,19 @@ extern "C" {
 typedef struct _ShmClient ShmClient;
 typedef struct _ShmPipe ShmPipe;
 typedef struct _ShmBlock ShmBlock;
+typedef struct _ShmFdBuffer ShmFdBuffer;
+
+/* flags of sp_writer_send_fd(), only meaningful to the elements */
+#define SHM_FD_BUFFER_FLAG_DMABUF (1 << 0)
+
+struct _ShmFdBuffer
+{
+  int fd;
+  size_t offset;
+  size_t maxsize;
+  unsigned long id;
+  unsigned int flags;
+};
 typedef struct _ShmBuffer ShmBuffer;
 
 typedef void (*sp_buffer_free_callback) (void * tag, void * user_data);
@@ -89,6 +118,14 @@ void sp_set_data (ShmPipe * self, void *data);
 
 int sp_writer_setperms_shm (ShmPipe * self, mode_t perms);
 int sp_writer_resize (ShmPipe * self, size_t size);
+int sp_writer_set_ring (ShmPipe * self, size_t slot_size,
+    unsigned int n_slots);
+int sp_writer_get_ring (ShmPipe * self, size_t * slot_size,
+    unsigned int * n_slots);
+char *sp_writer_ring_acquire (ShmPipe * self);
+void sp_writer_ring_publish (ShmPipe * self, char *buf, size_t size);
+int sp_writer_send_fd (ShmPipe * self, int fd, size_t offset, size_t size,
+    size_t maxsize, unsigned int flags, void *tag);
 
 int sp_get_fd (ShmPipe * self);
 const char *sp_get_shm_area_name (ShmPipe *self);
@@ -115,8 +152,16 @@ void *sp_writer_buf_get_tag (ShmBuffer * buffer);
 ShmPipe *sp_client_open (const char *path);
 long int sp_client_recv (ShmPipe * self, char **buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
+long int sp_client_recv_fd (ShmPipe * self, char **buf,
+    ShmFdBuffer * fd_buffer);
+int sp_client_recv_finish_fd (ShmPipe * self, unsigned long id);
 void sp_client_close (ShmPipe * self);
 
+int sp_client_is_ring (ShmPipe * self);
+long int sp_client_ring_recv (ShmPipe * self, char **buf, int latest);
+int sp_client_ring_wait (ShmPipe * self, unsigned long timeout_us);
+void sp_client_ring_wakeup (ShmPipe * self);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,9 @@
  * gst-launch-1.0 -v uridecodebin uri=file:///path/to/audio.ogg ! audioconvert ! audioresample ! tinyalsasink
  * ]| Play an Ogg/Vorbis file and output audio via ALSA using the tinyalsa
  * library.
+ * |[
+ * gst-launch-1.0 -v audiotestsrc ! tinyalsasink mmap=true buffer-time=8000 latency-time=2000
+ * ]| Play a test tone with four 2 ms periods written through mmap.
  *
  */
 
@@ -62,11 +65,13 @@ enum
   PROP_0,
   PROP_CARD,
   PROP_DEVICE,
+  PROP_MMAP,
   PROP_LAST
 };
 
 #define DEFAULT_CARD 0
 #define DEFAULT_DEVICE 0
+#define DEFAULT_MMAP FALSE
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -91,6 +96,10 @@ gst_tinyalsa_sink_get_property (GObject * object, guint prop_id,
       g_value_set_uint (value, sink->device);
       break;
 
+    case PROP_MMAP:
+      g_value_set_boolean (value, sink->mmap);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -112,6 +121,10 @@ gst_tinyalsa_sink_set_property (GObject * object, guint prop_id,
       sink->device = g_value_get_uint (value);
       break;
 
+    case PROP_MMAP:
+      sink->mmap = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -307,11 +320,36 @@ gst_tinyalsa_sink_prepare (GstAudioSink * asink, GstAudioRingBufferSpec * spec)
       CLAMP (config.period_size, period_size_min, period_size_max);
   config.period_count = CLAMP (config.period_count, periods_min, periods_max);
 
+  /* With mmap the data is written straight into the hardware buffer, so
+   * playback can start as soon as the first period is there instead of
+   * waiting for the whole buffer to fill up */
+  if (sink->mmap) {
+    config.start_threshold = config.period_size;
+    config.avail_min = config.period_size;
+  }
+
   /* mutex with getcaps */
   GST_OBJECT_LOCK (sink);
 
-  sink->pcm = pcm_open (sink->card, sink->device, PCM_OUT | PCM_NORESTART,
-      &config);
+  sink->use_mmap = sink->mmap;
+  if (sink->use_mmap) {
+    sink->pcm = pcm_open (sink->card, sink->device,
+        PCM_OUT | PCM_NORESTART | PCM_MMAP, &config);
+
+    if (!sink->pcm || !pcm_is_ready (sink->pcm)) {
+      GST_WARNING_OBJECT (sink, "Could not open device for mmap: %s",
+          pcm_get_error (sink->pcm));
+      if (sink->pcm)
+        pcm_close (sink->pcm);
+      sink->use_mmap = FALSE;
+      config.start_threshold = 0;
+      config.avail_min = 0;
+    }
+  }
+
+  if (!sink->use_mmap)
+    sink->pcm = pcm_open (sink->card, sink->device, PCM_OUT | PCM_NORESTART,
+        &config);
 
   GST_OBJECT_UNLOCK (sink);
 
@@ -330,8 +368,9 @@ gst_tinyalsa_sink_prepare (GstAudioSink * asink, GstAudioRingBufferSpec * spec)
   spec->segsize = pcm_frames_to_bytes (sink->pcm, config.period_size);
   spec->segtotal = config.period_count;
 
-  GST_DEBUG_OBJECT (sink, "Configured for %u periods of %u frames",
-      config.period_count, config.period_size);
+  GST_DEBUG_OBJECT (sink, "Configured for %u periods of %u frames%s",
+      config.period_count, config.period_size,
+      sink->use_mmap ? " with mmap" : "");
 
   return TRUE;
 
@@ -388,7 +427,10 @@ gst_tinyalsa_sink_write (GstAudioSink * asink, gpointer data, guint length)
 again:
   GST_DEBUG_OBJECT (sink, "Starting write");
 
-  ret = pcm_write (sink->pcm, data, length);
+  if (sink->use_mmap)
+    ret = pcm_mmap_write (sink->pcm, data, length);
+  else
+    ret = pcm_write (sink->pcm, data, length);
   if (ret == -EPIPE) {
     GST_WARNING_OBJECT (sink, "Got an underrun");
 
@@ -487,6 +529,24 @@ gst_tinyalsa_sink_class_init (GstTinyalsaSinkClass * klass)
           0, G_MAXUINT, DEFAULT_CARD,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstTinyalsaSink:mmap:
+   *
+   * Write the audio directly into the mmap()ed hardware buffer and start
+   * playback once the first period is written. Together with small
+   * #GstAudioBaseSink:buffer-time and #GstAudioBaseSink:latency-time
+   * values this gives the lowest output latency. Falls back to regular
+   * writes if the device does not support mmap.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_MMAP,
+      g_param_spec_boolean ("mmap", "Mmap",
+          "Write to the device through mmap for lower latency",
+          DEFAULT_MMAP, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (tinyalsa_sink_debug, "tinyalsasink", 0,
       "tinyalsa Sink");
 }
@@ -496,6 +556,7 @@ gst_tinyalsa_sink_init (GstTinyalsaSink * sink)
 {
   sink->card = DEFAULT_CARD;
   sink->device = DEFAULT_DEVICE;
+  sink->mmap = DEFAULT_MMAP;
 
   sink->cached_caps = NULL;
 }
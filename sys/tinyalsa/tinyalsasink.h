@@ -43,7 +43,10 @@ struct _GstTinyalsaSink {
   int card;
   int device;
 
+  gboolean mmap;
+
   struct pcm *pcm;
+  gboolean use_mmap;
 
   GstCaps *cached_caps; /* for queries made while the device is open */
 };
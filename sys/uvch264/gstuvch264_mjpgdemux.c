@@ -467,6 +467,15 @@ _pts_to_timestamp (GstUvcH264MjpgDemux * self, GstBuffer * buf, guint32 pts)
   return TRUE;
 }
 
+static GstMemory *
+_share_memory (GstMemory * mem, gssize offset, gssize size)
+{
+  if (GST_MEMORY_FLAG_IS_SET (mem, GST_MEMORY_FLAG_NO_SHARE))
+    return gst_memory_copy (mem, offset, size);
+
+  return gst_memory_share (mem, offset, size);
+}
+
 static GstFlowReturn
 gst_uvc_h264_mjpg_demux_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buf)
@@ -491,6 +500,8 @@ gst_uvc_h264_mjpg_demux_chain (GstPad * pad,
   }
 
   last_offset = 0;
+  /* The JPEG and auxiliary data is shared from the mapped memory instead of
+   * being copied, the input stays alive until the outputs are released */
   gst_buffer_map (buf, &info, GST_MAP_READ);
 
   jpeg_buf = gst_buffer_copy_region (buf, GST_BUFFER_COPY_METADATA, 0, 0);
@@ -520,7 +531,7 @@ gst_uvc_h264_mjpg_demux_chain (GstPad * pad,
 
       /* Add JPEG data between the last offset and this market */
       if (i - last_offset > 0) {
-        GstMemory *m = gst_memory_copy (info.memory, last_offset,
+        GstMemory *m = _share_memory (info.memory, last_offset,
             i - last_offset);
         gst_buffer_append_memory (jpeg_buf, m);
       }
@@ -646,7 +657,7 @@ gst_uvc_h264_mjpg_demux_chain (GstPad * pad,
 
       if (segment_size > 0) {
         GstMemory *m;
-        m = gst_memory_copy (info.memory, i, segment_size);
+        m = _share_memory (info.memory, i, segment_size);
 
         GST_BUFFER_DURATION (aux_buf) =
             aux_header.frame_interval * 100 * GST_NSECOND;
@@ -705,7 +716,7 @@ gst_uvc_h264_mjpg_demux_chain (GstPad * pad,
       /* The APP4 markers must be before the SOS marker, so this is the end */
       GST_DEBUG_OBJECT (self, "Found SOS marker.");
 
-      m = gst_memory_copy (info.memory, last_offset, info.size - last_offset);
+      m = _share_memory (info.memory, last_offset, info.size - last_offset);
       gst_buffer_append_memory (jpeg_buf, m);
       last_offset = info.size;
       break;
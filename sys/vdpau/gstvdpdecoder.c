@@ -25,6 +25,7 @@
 #include "gstvdpdecoder.h"
 #include "gstvdpvideomemory.h"
 #include "gstvdpvideobufferpool.h"
+#include "gstvdpglupload.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_vdp_decoder_debug);
 #define GST_CAT_DEFAULT gst_vdp_decoder_debug
@@ -185,6 +186,19 @@ gst_vdp_decoder_decide_allocation (GstVideoDecoder * video_decoder,
   gboolean update_pool;
 
   gst_query_parse_allocation (query, &outcaps, NULL);
+
+  /* The buffers still hold video surfaces in the decoded format, only the
+   * upload downstream converts them to RGBA */
+  if (vdp_decoder->use_gl_upload) {
+    GstVideoCodecState *state;
+
+    state = gst_video_decoder_get_output_state (video_decoder);
+    outcaps = gst_video_info_to_caps (&state->info);
+    gst_video_codec_state_unref (state);
+  } else {
+    gst_caps_ref (outcaps);
+  }
+
   gst_video_info_init (&vinfo);
   gst_video_info_from_caps (&vinfo, outcaps);
 
@@ -216,8 +230,14 @@ gst_vdp_decoder_decide_allocation (GstVideoDecoder * video_decoder,
   gst_buffer_pool_config_set_params (config, outcaps, size, min, max);
   gst_buffer_pool_config_add_option (config,
       GST_BUFFER_POOL_OPTION_VDP_VIDEO_META);
-  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  if (vdp_decoder->use_gl_upload)
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_GL_TEXTURE_UPLOAD_META);
+  else
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_META);
   gst_buffer_pool_set_config (pool, config);
+  gst_caps_unref (outcaps);
 
   if (update_pool)
     gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
@@ -231,6 +251,51 @@ gst_vdp_decoder_decide_allocation (GstVideoDecoder * video_decoder,
 
 }
 
+/* Picks GL texture upload when downstream prefers it to system memory */
+static gboolean
+gst_vdp_decoder_negotiate (GstVideoDecoder * video_decoder)
+{
+  GstVdpDecoder *vdp_decoder = GST_VDP_DECODER (video_decoder);
+  GstVideoCodecState *state;
+  GstCaps *templ, *peer_caps, *caps;
+
+  state = gst_video_decoder_get_output_state (video_decoder);
+  if (!state)
+    return FALSE;
+
+  vdp_decoder->use_gl_upload = FALSE;
+
+  templ = gst_pad_get_pad_template_caps (GST_VIDEO_DECODER_SRC_PAD
+      (video_decoder));
+  peer_caps =
+      gst_pad_peer_query_caps (GST_VIDEO_DECODER_SRC_PAD (video_decoder),
+      templ);
+  gst_caps_unref (templ);
+
+  if (peer_caps && !gst_caps_is_empty (peer_caps)
+      && !gst_caps_is_any (peer_caps)) {
+    vdp_decoder->use_gl_upload =
+        gst_caps_features_contains (gst_caps_get_features (peer_caps, 0),
+        GST_CAPS_FEATURE_META_GST_VIDEO_GL_TEXTURE_UPLOAD_META);
+  }
+  if (peer_caps)
+    gst_caps_unref (peer_caps);
+
+  caps = gst_video_info_to_caps (&state->info);
+  if (vdp_decoder->use_gl_upload) {
+    GST_DEBUG_OBJECT (vdp_decoder, "outputting GL texture upload meta");
+    gst_caps_set_simple (caps, "format", G_TYPE_STRING, "RGBA", NULL);
+    gst_caps_set_features (caps, 0,
+        gst_caps_features_new
+        (GST_CAPS_FEATURE_META_GST_VIDEO_GL_TEXTURE_UPLOAD_META, NULL));
+  }
+  gst_caps_replace (&state->caps, caps);
+  gst_caps_unref (caps);
+  gst_video_codec_state_unref (state);
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->negotiate (video_decoder);
+}
+
 static gboolean
 gst_vdp_decoder_start (GstVideoDecoder * video_decoder)
 {
@@ -348,12 +413,14 @@ gst_vdp_decoder_class_init (GstVdpDecoderClass * klass)
   video_decoder_class->start = gst_vdp_decoder_start;
   video_decoder_class->stop = gst_vdp_decoder_stop;
   video_decoder_class->decide_allocation = gst_vdp_decoder_decide_allocation;
+  video_decoder_class->negotiate = gst_vdp_decoder_negotiate;
 
   GST_FIXME ("Actually create srcpad template from hw capabilities");
   src_caps =
       gst_caps_from_string (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
       (GST_CAPS_FEATURE_MEMORY_VDPAU,
-          "{ YV12 }") ";" GST_VIDEO_CAPS_MAKE ("{ YV12 }"));
+          "{ YV12 }") ";" GST_VDP_GL_UPLOAD_CAPS ";"
+      GST_VIDEO_CAPS_MAKE ("{ YV12 }"));
   src_template =
       gst_pad_template_new (GST_VIDEO_DECODER_SRC_NAME, GST_PAD_SRC,
       GST_PAD_ALWAYS, src_caps);
@@ -49,6 +49,9 @@ struct _GstVdpDecoder {
 
   GstVideoInfo info;
 
+  /* output RGBA textures through GstVideoGLTextureUploadMeta */
+  gboolean use_gl_upload;
+
   /* properties */
   gchar *display;
 };
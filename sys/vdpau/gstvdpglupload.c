@@ -0,0 +1,377 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Uploads decoded VdpVideoSurfaces into GL textures without reading them
+ * back. The upload callback of GstVideoGLTextureUploadMeta is called by the
+ * GL elements with their context current. It converts the video surface
+ * into an RGBA VdpOutputSurface with a video mixer, which is registered
+ * with GL through GL_NV_vdpau_interop, and copies it into the texture that
+ * was passed in.
+ *
+ * GL is not linked, the entry points are looked up in the libGL that the
+ * GL elements already loaded. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gmodule.h>
+
+#include "gstvdpglupload.h"
+#include "gstvdpvideomemory.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_vdp_gl_upload_debug);
+#define GST_CAT_DEFAULT gst_vdp_gl_upload_debug
+
+/* The subset of the GL and GL_NV_vdpau_interop API used here */
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef gintptr GLvdpauSurfaceNV;
+
+#define GL_TEXTURE_2D                   0x0DE1
+#define GL_TEXTURE_BINDING_2D           0x8069
+#define GL_READ_FRAMEBUFFER             0x8CA8
+#define GL_READ_FRAMEBUFFER_BINDING     0x8CAA
+#define GL_COLOR_ATTACHMENT0            0x8CE0
+#define GL_FRAMEBUFFER_COMPLETE         0x8CD5
+#define GL_READ_ONLY                    0x88B8
+
+typedef struct
+{
+  GMutex lock;
+
+  GstVdpDevice *device;
+
+  /* GL state, bound to the first context an upload is done in */
+  gpointer gl_context;
+  gboolean gl_failed;
+
+  gpointer (*GetCurrentContext) (void);
+  void (*GenTextures) (GLsizei n, GLuint * textures);
+  void (*BindTexture) (GLenum target, GLuint texture);
+  void (*GetIntegerv) (GLenum pname, GLint * data);
+  void (*GenFramebuffers) (GLsizei n, GLuint * framebuffers);
+  void (*BindFramebuffer) (GLenum target, GLuint framebuffer);
+  void (*FramebufferTexture2D) (GLenum target, GLenum attachment,
+      GLenum textarget, GLuint texture, GLint level);
+  GLenum (*CheckFramebufferStatus) (GLenum target);
+  void (*CopyTexSubImage2D) (GLenum target, GLint level, GLint xoffset,
+      GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height);
+  void (*VDPAUInitNV) (gconstpointer vdp_device,
+      gconstpointer get_proc_address);
+  GLvdpauSurfaceNV (*VDPAURegisterOutputSurfaceNV) (gconstpointer surface,
+      GLenum target, GLsizei n_textures, const GLuint * textures);
+  void (*VDPAUUnregisterSurfaceNV) (GLvdpauSurfaceNV surface);
+  void (*VDPAUSurfaceAccessNV) (GLvdpauSurfaceNV surface, GLenum access);
+  void (*VDPAUMapSurfacesNV) (GLsizei n_surfaces,
+      const GLvdpauSurfaceNV * surfaces);
+  void (*VDPAUUnmapSurfacesNV) (GLsizei n_surfaces,
+      const GLvdpauSurfaceNV * surfaces);
+
+  GLuint texture;
+  GLuint fbo;
+
+  /* conversion into an RGBA surface, recreated when the size changes */
+  VdpVideoMixer mixer;
+  VdpOutputSurface surface;
+  GLvdpauSurfaceNV gl_surface;
+  guint width, height;
+  VdpChromaType chroma_type;
+} GstVdpGLInterop;
+
+static GQuark interop_quark;
+
+/* The GL objects belong to the GL context and go away with it, only the
+ * VDPAU objects are released here */
+static void
+gst_vdp_gl_interop_free (GstVdpGLInterop * interop)
+{
+  GstVdpDevice *device = interop->device;
+
+  if (interop->mixer != VDP_INVALID_HANDLE)
+    device->vdp_video_mixer_destroy (interop->mixer);
+  if (interop->surface != VDP_INVALID_HANDLE)
+    device->vdp_output_surface_destroy (interop->surface);
+
+  g_mutex_clear (&interop->lock);
+  g_slice_free (GstVdpGLInterop, interop);
+}
+
+static GstVdpGLInterop *
+gst_vdp_gl_interop_get (GstVdpDevice * device)
+{
+  static GMutex lock;
+  GstVdpGLInterop *interop;
+
+  g_mutex_lock (&lock);
+  interop = g_object_get_qdata (G_OBJECT (device), interop_quark);
+  if (!interop) {
+    interop = g_slice_new0 (GstVdpGLInterop);
+    g_mutex_init (&interop->lock);
+    /* owned by the device, so no reference is held */
+    interop->device = device;
+    interop->mixer = VDP_INVALID_HANDLE;
+    interop->surface = VDP_INVALID_HANDLE;
+    g_object_set_qdata_full (G_OBJECT (device), interop_quark, interop,
+        (GDestroyNotify) gst_vdp_gl_interop_free);
+  }
+  g_mutex_unlock (&lock);
+
+  return interop;
+}
+
+static gboolean
+gst_vdp_gl_interop_init_gl (GstVdpGLInterop * interop)
+{
+  gpointer (*get_proc_address) (const gchar * name) = NULL;
+  GModule *module;
+  guint i;
+  struct
+  {
+    const gchar *name;
+    gpointer *func;
+  } funcs[] = {
+    {"glXGetCurrentContext", (gpointer *) & interop->GetCurrentContext},
+    {"glGenTextures", (gpointer *) & interop->GenTextures},
+    {"glBindTexture", (gpointer *) & interop->BindTexture},
+    {"glGetIntegerv", (gpointer *) & interop->GetIntegerv},
+    {"glGenFramebuffers", (gpointer *) & interop->GenFramebuffers},
+    {"glBindFramebuffer", (gpointer *) & interop->BindFramebuffer},
+    {"glFramebufferTexture2D", (gpointer *) & interop->FramebufferTexture2D},
+    {"glCheckFramebufferStatus",
+        (gpointer *) & interop->CheckFramebufferStatus},
+    {"glCopyTexSubImage2D", (gpointer *) & interop->CopyTexSubImage2D},
+    {"glVDPAUInitNV", (gpointer *) & interop->VDPAUInitNV},
+    {"glVDPAURegisterOutputSurfaceNV",
+        (gpointer *) & interop->VDPAURegisterOutputSurfaceNV},
+    {"glVDPAUUnregisterSurfaceNV",
+        (gpointer *) & interop->VDPAUUnregisterSurfaceNV},
+    {"glVDPAUSurfaceAccessNV", (gpointer *) & interop->VDPAUSurfaceAccessNV},
+    {"glVDPAUMapSurfacesNV", (gpointer *) & interop->VDPAUMapSurfacesNV},
+    {"glVDPAUUnmapSurfacesNV", (gpointer *) & interop->VDPAUUnmapSurfacesNV},
+  };
+
+  module = g_module_open ("libGL.so.1", G_MODULE_BIND_LAZY);
+  if (!module) {
+    GST_WARNING ("libGL is not available");
+    return FALSE;
+  }
+
+  if (!g_module_symbol (module, "glXGetProcAddressARB",
+          (gpointer *) & get_proc_address) || !get_proc_address) {
+    GST_WARNING ("no glXGetProcAddressARB");
+    g_module_close (module);
+    return FALSE;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (funcs); i++) {
+    *funcs[i].func = get_proc_address (funcs[i].name);
+    if (!*funcs[i].func) {
+      GST_WARNING ("GL function %s is not available", funcs[i].name);
+      g_module_close (module);
+      return FALSE;
+    }
+  }
+
+  /* the module stays open for the GL functions to remain valid */
+
+  interop->gl_context = interop->GetCurrentContext ();
+  if (!interop->gl_context) {
+    GST_WARNING ("no current GLX context, GL_NV_vdpau_interop requires GLX");
+    return FALSE;
+  }
+
+  interop->VDPAUInitNV (GSIZE_TO_POINTER (interop->device->device),
+      interop->device->vdp_get_proc_address);
+  interop->GenTextures (1, &interop->texture);
+  interop->GenFramebuffers (1, &interop->fbo);
+
+  GST_INFO ("initialized GL_NV_vdpau_interop in context %p",
+      interop->gl_context);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vdp_gl_interop_ensure_surface (GstVdpGLInterop * interop,
+    GstVdpVideoMemory * vmem)
+{
+  GstVdpDevice *device = interop->device;
+  guint width = GST_VIDEO_INFO_WIDTH (vmem->info);
+  guint height = GST_VIDEO_INFO_HEIGHT (vmem->info);
+  VdpVideoMixerParameter params[] = {
+    VDP_VIDEO_MIXER_PARAMETER_VIDEO_SURFACE_WIDTH,
+    VDP_VIDEO_MIXER_PARAMETER_VIDEO_SURFACE_HEIGHT,
+    VDP_VIDEO_MIXER_PARAMETER_CHROMA_TYPE
+  };
+  uint32_t mixer_width = width, mixer_height = height;
+  VdpChromaType chroma_type = vmem->chroma_type;
+  const void *param_values[] = { &mixer_width, &mixer_height, &chroma_type };
+  VdpStatus status;
+  GLint old_fbo = 0;
+  gboolean ret;
+
+  if (interop->surface != VDP_INVALID_HANDLE && interop->width == width &&
+      interop->height == height && interop->chroma_type == chroma_type)
+    return TRUE;
+
+  if (interop->surface != VDP_INVALID_HANDLE) {
+    interop->VDPAUUnregisterSurfaceNV (interop->gl_surface);
+    device->vdp_output_surface_destroy (interop->surface);
+    interop->surface = VDP_INVALID_HANDLE;
+  }
+  if (interop->mixer != VDP_INVALID_HANDLE) {
+    device->vdp_video_mixer_destroy (interop->mixer);
+    interop->mixer = VDP_INVALID_HANDLE;
+  }
+
+  status = device->vdp_video_mixer_create (device->device, 0, NULL,
+      G_N_ELEMENTS (params), params, param_values, &interop->mixer);
+  if (status != VDP_STATUS_OK) {
+    GST_WARNING ("Failed to create video mixer: %s",
+        device->vdp_get_error_string (status));
+    interop->mixer = VDP_INVALID_HANDLE;
+    return FALSE;
+  }
+
+  status = device->vdp_output_surface_create (device->device,
+      VDP_RGBA_FORMAT_R8G8B8A8, width, height, &interop->surface);
+  if (status != VDP_STATUS_OK) {
+    GST_WARNING ("Failed to create output surface: %s",
+        device->vdp_get_error_string (status));
+    interop->surface = VDP_INVALID_HANDLE;
+    return FALSE;
+  }
+
+  interop->gl_surface =
+      interop->VDPAURegisterOutputSurfaceNV (GSIZE_TO_POINTER
+      (interop->surface), GL_TEXTURE_2D, 1, &interop->texture);
+  interop->VDPAUSurfaceAccessNV (interop->gl_surface, GL_READ_ONLY);
+
+  /* the texture is only ever read from, through the framebuffer */
+  interop->GetIntegerv (GL_READ_FRAMEBUFFER_BINDING, &old_fbo);
+  interop->BindFramebuffer (GL_READ_FRAMEBUFFER, interop->fbo);
+  interop->VDPAUMapSurfacesNV (1, &interop->gl_surface);
+  interop->FramebufferTexture2D (GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_2D, interop->texture, 0);
+  ret = interop->CheckFramebufferStatus (GL_READ_FRAMEBUFFER) ==
+      GL_FRAMEBUFFER_COMPLETE;
+  interop->VDPAUUnmapSurfacesNV (1, &interop->gl_surface);
+  interop->BindFramebuffer (GL_READ_FRAMEBUFFER, old_fbo);
+
+  if (!ret) {
+    GST_WARNING ("registered surface can't be read through a framebuffer");
+    return FALSE;
+  }
+
+  interop->width = width;
+  interop->height = height;
+  interop->chroma_type = chroma_type;
+
+  return TRUE;
+}
+
+static gboolean
+gst_vdp_gl_upload (GstVideoGLTextureUploadMeta * meta, guint texture_id[4])
+{
+  GstVdpVideoMemory *vmem;
+  GstVdpGLInterop *interop;
+  GstVdpDevice *device;
+  VdpStatus status;
+  GLint old_fbo = 0, old_texture = 0;
+  gboolean ret = FALSE;
+
+  vmem = (GstVdpVideoMemory *) gst_buffer_peek_memory (meta->buffer, 0);
+  if (!gst_memory_is_type ((GstMemory *) vmem, GST_VDP_VIDEO_MEMORY_ALLOCATOR))
+    return FALSE;
+
+  device = vmem->device;
+  interop = gst_vdp_gl_interop_get (device);
+
+  g_mutex_lock (&interop->lock);
+
+  if (interop->gl_failed)
+    goto done;
+
+  if (!interop->gl_context && !gst_vdp_gl_interop_init_gl (interop)) {
+    interop->gl_failed = TRUE;
+    goto done;
+  }
+
+  if (interop->GetCurrentContext () != interop->gl_context) {
+    GST_WARNING ("upload in GL context %p, interop was set up in %p",
+        interop->GetCurrentContext (), interop->gl_context);
+    goto done;
+  }
+
+  if (!gst_vdp_gl_interop_ensure_surface (interop, vmem))
+    goto done;
+
+  status = device->vdp_video_mixer_render (interop->mixer, VDP_INVALID_HANDLE,
+      NULL, VDP_VIDEO_MIXER_PICTURE_STRUCTURE_FRAME, 0, NULL, vmem->surface,
+      0, NULL, NULL, interop->surface, NULL, NULL, 0, NULL);
+  if (status != VDP_STATUS_OK) {
+    GST_WARNING ("Failed to render into the output surface: %s",
+        device->vdp_get_error_string (status));
+    goto done;
+  }
+
+  interop->GetIntegerv (GL_READ_FRAMEBUFFER_BINDING, &old_fbo);
+  interop->GetIntegerv (GL_TEXTURE_BINDING_2D, &old_texture);
+
+  interop->VDPAUMapSurfacesNV (1, &interop->gl_surface);
+  interop->BindFramebuffer (GL_READ_FRAMEBUFFER, interop->fbo);
+  interop->BindTexture (GL_TEXTURE_2D, texture_id[0]);
+  interop->CopyTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, 0, 0, interop->width,
+      interop->height);
+  interop->VDPAUUnmapSurfacesNV (1, &interop->gl_surface);
+
+  interop->BindTexture (GL_TEXTURE_2D, old_texture);
+  interop->BindFramebuffer (GL_READ_FRAMEBUFFER, old_fbo);
+
+  GST_TRACE ("uploaded surface %u into texture %u", vmem->surface,
+      texture_id[0]);
+
+  ret = TRUE;
+
+done:
+  g_mutex_unlock (&interop->lock);
+
+  return ret;
+}
+
+gboolean
+gst_vdp_gl_upload_add_meta (GstBuffer * buffer)
+{
+  GstVideoGLTextureType texture_type[4] = { GST_VIDEO_GL_TEXTURE_TYPE_RGBA, };
+  static gsize once = 0;
+
+  if (g_once_init_enter (&once)) {
+    GST_DEBUG_CATEGORY_INIT (gst_vdp_gl_upload_debug, "vdpglupload", 0,
+        "VDPAU GL texture upload");
+    interop_quark = g_quark_from_static_string ("GstVdpGLInterop");
+    g_once_init_leave (&once, 1);
+  }
+
+  return gst_buffer_add_video_gl_texture_upload_meta (buffer,
+      GST_VIDEO_GL_TEXTURE_ORIENTATION_X_NORMAL_Y_NORMAL, 1, texture_type,
+      gst_vdp_gl_upload, NULL, NULL, NULL) != NULL;
+}
@@ -0,0 +1,38 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VDP_GL_UPLOAD_H_
+#define _GST_VDP_GL_UPLOAD_H_
+
+#include <gst/gst.h>
+#include <gst/video/gstvideometa.h>
+
+G_BEGIN_DECLS
+
+/* Caps of buffers whose VdpVideoSurface is turned into an RGBA texture by
+ * GstVideoGLTextureUploadMeta, using GL_NV_vdpau_interop */
+#define GST_VDP_GL_UPLOAD_CAPS \
+    GST_VIDEO_CAPS_MAKE_WITH_FEATURES ( \
+        GST_CAPS_FEATURE_META_GST_VIDEO_GL_TEXTURE_UPLOAD_META, "RGBA")
+
+gboolean gst_vdp_gl_upload_add_meta (GstBuffer * buffer);
+
+G_END_DECLS
+
+#endif /* _GST_VDP_GL_UPLOAD_H_ */
@@ -25,6 +25,7 @@
 
 #include "gstvdpvideobufferpool.h"
 #include "gstvdpvideomemory.h"
+#include "gstvdpglupload.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_vdp_vidbufpool_debug);
 #define GST_CAT_DEFAULT gst_vdp_vidbufpool_debug
@@ -43,7 +44,8 @@ static const gchar **
 gst_vdp_video_buffer_pool_get_options (GstBufferPool * pool)
 {
   static const gchar *options[] = { GST_BUFFER_POOL_OPTION_VIDEO_META,
-    GST_BUFFER_POOL_OPTION_VDP_VIDEO_META, NULL
+    GST_BUFFER_POOL_OPTION_VDP_VIDEO_META,
+    GST_BUFFER_POOL_OPTION_VIDEO_GL_TEXTURE_UPLOAD_META, NULL
   };
 
   return options;
@@ -84,6 +86,9 @@ gst_vdp_video_buffer_pool_set_config (GstBufferPool * pool,
   vdppool->add_vdpmeta = gst_buffer_pool_config_has_option (config,
       GST_BUFFER_POOL_OPTION_VDP_VIDEO_META);
 
+  vdppool->add_gl_upload_meta = gst_buffer_pool_config_has_option (config,
+      GST_BUFFER_POOL_OPTION_VIDEO_GL_TEXTURE_UPLOAD_META);
+
   return GST_BUFFER_POOL_CLASS (parent_class)->set_config (pool, config);
 
   /* ERRORS */
@@ -146,6 +151,11 @@ gst_vdp_video_buffer_pool_alloc (GstBufferPool * pool, GstBuffer ** buffer,
     vmeta->unmap = gst_vdp_video_memory_unmap;
   }
 
+  if (vdppool->add_gl_upload_meta) {
+    GST_DEBUG_OBJECT (pool, "adding GstVideoGLTextureUploadMeta");
+    gst_vdp_gl_upload_add_meta (buf);
+  }
+
   *buffer = buf;
 
   return GST_FLOW_OK;
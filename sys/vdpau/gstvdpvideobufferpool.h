@@ -71,6 +71,7 @@ struct _GstVdpVideoBufferPool
 	
   gboolean      add_videometa;
   gboolean      add_vdpmeta;
+  gboolean      add_gl_upload_meta;
 };
 
 struct _GstVdpVideoBufferPoolClass
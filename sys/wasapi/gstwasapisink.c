@@ -30,6 +30,10 @@
  * |[
  * gst-launch-1.0 -v audiotestsrc samplesperbuffer=160 ! wasapisink
  * ]| Generate 20 ms buffers and render to the default audio device.
+ * |[
+ * gst-launch-1.0 -v audiotestsrc ! wasapisink exclusive=true low-latency=true
+ * ]| Open the default audio device exclusively and render with its minimum
+ * period.
  *
  */
 #ifdef HAVE_CONFIG_H
@@ -41,6 +45,16 @@
 GST_DEBUG_CATEGORY_STATIC (gst_wasapi_sink_debug);
 #define GST_CAT_DEFAULT gst_wasapi_sink_debug
 
+#define DEFAULT_EXCLUSIVE       FALSE
+#define DEFAULT_LOW_LATENCY     FALSE
+
+enum
+{
+  PROP_0,
+  PROP_EXCLUSIVE,
+  PROP_LOW_LATENCY
+};
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -51,6 +65,10 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
 
 static void gst_wasapi_sink_dispose (GObject * object);
 static void gst_wasapi_sink_finalize (GObject * object);
+static void gst_wasapi_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_wasapi_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstCaps *gst_wasapi_sink_get_caps (GstBaseSink * bsink,
     GstCaps * filter);
@@ -76,6 +94,38 @@ gst_wasapi_sink_class_init (GstWasapiSinkClass * klass)
 
   gobject_class->dispose = gst_wasapi_sink_dispose;
   gobject_class->finalize = gst_wasapi_sink_finalize;
+  gobject_class->set_property = gst_wasapi_sink_set_property;
+  gobject_class->get_property = gst_wasapi_sink_get_property;
+
+  /**
+   * GstWasapiSink:exclusive:
+   *
+   * Open the device in exclusive mode. The audio engine is bypassed and the
+   * device buffer is a single device period, so the format has to be one
+   * that the device supports natively.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_EXCLUSIVE,
+      g_param_spec_boolean ("exclusive", "Exclusive",
+          "Open the device in exclusive mode", DEFAULT_EXCLUSIVE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstWasapiSink:low-latency:
+   *
+   * Use the smallest buffer the device allows instead of the one given by
+   * #GstAudioBaseSink:buffer-time: the minimum device period in exclusive
+   * mode and the engine period in shared mode.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Use the smallest buffer the device allows", DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
   gst_element_class_set_static_metadata (gstelement_class, "WasapiSrc",
@@ -101,6 +151,8 @@ static void
 gst_wasapi_sink_init (GstWasapiSink * self)
 {
   self->event_handle = CreateEvent (NULL, FALSE, FALSE, NULL);
+  self->exclusive = DEFAULT_EXCLUSIVE;
+  self->low_latency = DEFAULT_LOW_LATENCY;
 
   CoInitialize (NULL);
 }
@@ -126,6 +178,44 @@ gst_wasapi_sink_finalize (GObject * object)
   G_OBJECT_CLASS (gst_wasapi_sink_parent_class)->finalize (object);
 }
 
+static void
+gst_wasapi_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWasapiSink *self = GST_WASAPI_SINK (object);
+
+  switch (prop_id) {
+    case PROP_EXCLUSIVE:
+      self->exclusive = g_value_get_boolean (value);
+      break;
+    case PROP_LOW_LATENCY:
+      self->low_latency = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_wasapi_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWasapiSink *self = GST_WASAPI_SINK (object);
+
+  switch (prop_id) {
+    case PROP_EXCLUSIVE:
+      g_value_set_boolean (value, self->exclusive);
+      break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, self->low_latency);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static GstCaps *
 gst_wasapi_sink_get_caps (GstBaseSink * bsink, GstCaps * filter)
 {
@@ -174,28 +264,15 @@ gst_wasapi_sink_prepare (GstAudioSink * asink, GstAudioRingBufferSpec * spec)
   GstWasapiSink *self = GST_WASAPI_SINK (asink);
   gboolean res = FALSE;
   HRESULT hr;
-  REFERENCE_TIME latency_rt, def_period, min_period;
-  WAVEFORMATEXTENSIBLE format;
+  REFERENCE_TIME latency_rt;
   IAudioRenderClient *render_client = NULL;
 
-  hr = IAudioClient_GetDevicePeriod (self->client, &def_period, &min_period);
-  if (hr != S_OK) {
-    GST_ERROR_OBJECT (self, "IAudioClient::GetDevicePeriod () failed");
-    goto beach;
-  }
-
-  gst_wasapi_util_audio_info_to_waveformatex (&spec->info, &format);
   self->info = spec->info;
 
-  hr = IAudioClient_Initialize (self->client, AUDCLNT_SHAREMODE_SHARED,
-      AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-      spec->buffer_time / 100, 0, (WAVEFORMATEX *) & format, NULL);
-  if (hr != S_OK) {
-    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ, (NULL),
-        ("IAudioClient::Initialize () failed: %s",
-            gst_wasapi_util_hresult_to_string (hr)));
+  if (!gst_wasapi_util_initialize_audioclient (GST_ELEMENT (self), spec,
+          FALSE, self->exclusive, self->low_latency, &self->client,
+          &self->buffer_frames))
     goto beach;
-  }
 
   hr = IAudioClient_GetStreamLatency (self->client, &latency_rt);
   if (hr != S_OK) {
@@ -203,12 +280,8 @@ gst_wasapi_sink_prepare (GstAudioSink * asink, GstAudioRingBufferSpec * spec)
     goto beach;
   }
 
-  GST_INFO_OBJECT (self, "default period: %d (%d ms), "
-      "minimum period: %d (%d ms), "
-      "latency: %d (%d ms)",
-      (guint32) def_period, (guint32) def_period / 10000,
-      (guint32) min_period, (guint32) min_period / 10000,
-      (guint32) latency_rt, (guint32) latency_rt / 10000);
+  GST_INFO_OBJECT (self, "latency: %d (%d ms)", (guint32) latency_rt,
+      (guint32) latency_rt / 10000);
 
   /* FIXME: What to do with the latency? */
 
@@ -255,6 +328,11 @@ gst_wasapi_sink_unprepare (GstAudioSink * asink)
     self->render_client = NULL;
   }
 
+  /* the ringbuffer thread that was registered is gone by now */
+  gst_wasapi_util_revert_thread_characteristics (self->thread_handle);
+  self->thread_handle = NULL;
+  self->thread_registered = FALSE;
+
   return TRUE;
 }
 
@@ -264,11 +342,40 @@ gst_wasapi_sink_write (GstAudioSink * asink, gpointer data, guint length)
   GstWasapiSink *self = GST_WASAPI_SINK (asink);
   HRESULT hr;
   gint16 *dst = NULL;
+  guint32 padding;
   guint nsamples;
 
-  nsamples = length / self->info.bpf;
+  if (G_UNLIKELY (!self->thread_registered)) {
+    self->thread_handle =
+        gst_wasapi_util_set_thread_characteristics (GST_ELEMENT (self));
+    self->thread_registered = TRUE;
+  }
+
+  if (self->exclusive) {
+    /* every event asks for the whole buffer, which is one segment */
+    WaitForSingleObject (self->event_handle, INFINITE);
+    nsamples = self->buffer_frames;
+  } else {
+    /* only wait when the engine has not consumed anything yet */
+    for (;;) {
+      hr = IAudioClient_GetCurrentPadding (self->client, &padding);
+      if (hr != S_OK) {
+        GST_ELEMENT_ERROR (self, RESOURCE, WRITE, (NULL),
+            ("IAudioClient::GetCurrentPadding () failed: %s",
+                gst_wasapi_util_hresult_to_string (hr)));
+        return 0;
+      }
+
+      nsamples = self->buffer_frames - padding;
+      if (nsamples > 0)
+        break;
+
+      WaitForSingleObject (self->event_handle, INFINITE);
+    }
+  }
 
-  WaitForSingleObject (self->event_handle, INFINITE);
+  nsamples = MIN (nsamples, length / self->info.bpf);
+  length = nsamples * self->info.bpf;
 
   hr = IAudioRenderClient_GetBuffer (self->render_client, nsamples,
       (BYTE **) & dst);
@@ -47,6 +47,15 @@ struct _GstWasapiSink
   IAudioClient * client;
   IAudioRenderClient * render_client;
   HANDLE event_handle;
+
+  /* properties */
+  gboolean exclusive;
+  gboolean low_latency;
+
+  guint32 buffer_frames;
+  /* MMCSS registration of the ringbuffer thread */
+  gboolean thread_registered;
+  gpointer thread_handle;
 };
 
 struct _GstWasapiSinkClass
@@ -28,6 +28,10 @@
  * |[
  * gst-launch-1.0 -v wasapisrc ! fakesink
  * ]| Capture from the default audio device and render to fakesink.
+ * |[
+ * gst-launch-1.0 -v wasapisrc exclusive=true low-latency=true ! fakesink
+ * ]| Open the default capture device exclusively and capture with its minimum
+ * period.
  *
  */
 #ifdef HAVE_CONFIG_H
@@ -39,6 +43,16 @@
 GST_DEBUG_CATEGORY_STATIC (gst_wasapi_src_debug);
 #define GST_CAT_DEFAULT gst_wasapi_src_debug
 
+#define DEFAULT_EXCLUSIVE       FALSE
+#define DEFAULT_LOW_LATENCY     FALSE
+
+enum
+{
+  PROP_0,
+  PROP_EXCLUSIVE,
+  PROP_LOW_LATENCY
+};
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -49,6 +63,10 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
 
 static void gst_wasapi_src_dispose (GObject * object);
 static void gst_wasapi_src_finalize (GObject * object);
+static void gst_wasapi_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_wasapi_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstCaps *gst_wasapi_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter);
 
@@ -77,6 +95,38 @@ gst_wasapi_src_class_init (GstWasapiSrcClass * klass)
 
   gobject_class->dispose = gst_wasapi_src_dispose;
   gobject_class->finalize = gst_wasapi_src_finalize;
+  gobject_class->set_property = gst_wasapi_src_set_property;
+  gobject_class->get_property = gst_wasapi_src_get_property;
+
+  /**
+   * GstWasapiSrc:exclusive:
+   *
+   * Open the device in exclusive mode. The audio engine is bypassed and the
+   * device buffer is a single device period, so the format has to be one
+   * that the device supports natively.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_EXCLUSIVE,
+      g_param_spec_boolean ("exclusive", "Exclusive",
+          "Open the device in exclusive mode", DEFAULT_EXCLUSIVE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstWasapiSrc:low-latency:
+   *
+   * Use the smallest buffer the device allows instead of the one given by
+   * #GstAudioBaseSrc:buffer-time: the minimum device period in exclusive
+   * mode and the engine period in shared mode.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Use the smallest buffer the device allows", DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_set_static_metadata (gstelement_class, "WasapiSrc",
@@ -110,6 +160,8 @@ gst_wasapi_src_init (GstWasapiSrc * self)
       (GDestroyNotify) gst_object_unref);
 
   self->event_handle = CreateEvent (NULL, FALSE, FALSE, NULL);
+  self->exclusive = DEFAULT_EXCLUSIVE;
+  self->low_latency = DEFAULT_LOW_LATENCY;
 
   CoInitialize (NULL);
 }
@@ -135,6 +187,44 @@ gst_wasapi_src_finalize (GObject * object)
   G_OBJECT_CLASS (gst_wasapi_src_parent_class)->finalize (object);
 }
 
+static void
+gst_wasapi_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWasapiSrc *self = GST_WASAPI_SRC (object);
+
+  switch (prop_id) {
+    case PROP_EXCLUSIVE:
+      self->exclusive = g_value_get_boolean (value);
+      break;
+    case PROP_LOW_LATENCY:
+      self->low_latency = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_wasapi_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWasapiSrc *self = GST_WASAPI_SRC (object);
+
+  switch (prop_id) {
+    case PROP_EXCLUSIVE:
+      g_value_set_boolean (value, self->exclusive);
+      break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, self->low_latency);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static GstCaps *
 gst_wasapi_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
 {
@@ -185,28 +275,15 @@ gst_wasapi_src_prepare (GstAudioSrc * asrc, GstAudioRingBufferSpec * spec)
   IAudioClock *client_clock = NULL;
   guint64 client_clock_freq = 0;
   IAudioCaptureClient *capture_client = NULL;
-  REFERENCE_TIME latency_rt, def_period, min_period;
-  WAVEFORMATEXTENSIBLE format;
+  REFERENCE_TIME latency_rt;
   HRESULT hr;
 
-  hr = IAudioClient_GetDevicePeriod (self->client, &def_period, &min_period);
-  if (hr != S_OK) {
-    GST_ERROR_OBJECT (self, "IAudioClient::GetDevicePeriod () failed");
-    goto beach;
-  }
-
-  gst_wasapi_util_audio_info_to_waveformatex (&spec->info, &format);
   self->info = spec->info;
 
-  hr = IAudioClient_Initialize (self->client, AUDCLNT_SHAREMODE_SHARED,
-      AUDCLNT_STREAMFLAGS_EVENTCALLBACK, spec->buffer_time / 100, 0,
-      (WAVEFORMATEX *) & format, NULL);
-  if (hr != S_OK) {
-    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ, (NULL),
-        ("IAudioClient::Initialize () failed: %s",
-            gst_wasapi_util_hresult_to_string (hr)));
+  if (!gst_wasapi_util_initialize_audioclient (GST_ELEMENT (self), spec,
+          TRUE, self->exclusive, self->low_latency, &self->client,
+          &self->buffer_frames))
     goto beach;
-  }
 
   hr = IAudioClient_GetStreamLatency (self->client, &latency_rt);
   if (hr != S_OK) {
@@ -214,12 +291,8 @@ gst_wasapi_src_prepare (GstAudioSrc * asrc, GstAudioRingBufferSpec * spec)
     goto beach;
   }
 
-  GST_INFO_OBJECT (self, "default period: %d (%d ms), "
-      "minimum period: %d (%d ms), "
-      "latency: %d (%d ms)",
-      (guint32) def_period, (guint32) def_period / 10000,
-      (guint32) min_period, (guint32) min_period / 10000,
-      (guint32) latency_rt, (guint32) latency_rt / 10000);
+  GST_INFO_OBJECT (self, "latency: %d (%d ms)", (guint32) latency_rt,
+      (guint32) latency_rt / 10000);
 
   /* FIXME: What to do with the latency? */
 
@@ -288,6 +361,11 @@ gst_wasapi_src_unprepare (GstAudioSrc * asrc)
     self->client_clock = NULL;
   }
 
+  /* the ringbuffer thread that was registered is gone by now */
+  gst_wasapi_util_revert_thread_characteristics (self->thread_handle);
+  self->thread_handle = NULL;
+  self->thread_registered = FALSE;
+
   return TRUE;
 }
 
@@ -304,6 +382,12 @@ gst_wasapi_src_read (GstAudioSrc * asrc, gpointer data, guint length,
   guint i;
   gint16 *dst;
 
+  if (G_UNLIKELY (!self->thread_registered)) {
+    self->thread_handle =
+        gst_wasapi_util_set_thread_characteristics (GST_ELEMENT (self));
+    self->thread_registered = TRUE;
+  }
+
   WaitForSingleObject (self->event_handle, INFINITE);
 
   do {
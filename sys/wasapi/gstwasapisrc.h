@@ -49,6 +49,15 @@ struct _GstWasapiSrc
   guint64 client_clock_freq;
   IAudioCaptureClient * capture_client;
   HANDLE event_handle;
+
+  /* properties */
+  gboolean exclusive;
+  gboolean low_latency;
+
+  guint32 buffer_frames;
+  /* MMCSS registration of the ringbuffer thread */
+  gboolean thread_registered;
+  gpointer thread_handle;
 };
 
 struct _GstWasapiSrcClass
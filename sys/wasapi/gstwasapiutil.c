@@ -23,6 +23,11 @@
 #include "gstwasapiutil.h"
 
 #include <mmdeviceapi.h>
+#include <avrt.h>
+
+#ifndef AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED
+#define AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED AUDCLNT_ERR(0x019)
+#endif
 
 /* These seem to be missing in the Windows SDK... */
 const CLSID CLSID_MMDeviceEnumerator = { 0xbcde0395, 0xe52f, 0x467c,
@@ -121,6 +126,9 @@ gst_wasapi_util_hresult_to_string (HRESULT hr)
     case AUDCLNT_E_CPUUSAGE_EXCEEDED:
       s = "AUDCLNT_E_CPUUSAGE_EXCEEDED";
       break;
+    case AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED:
+      s = "AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED";
+      break;
     case AUDCLNT_S_BUFFER_EMPTY:
       s = "AUDCLNT_S_BUFFER_EMPTY";
       break;
@@ -202,6 +210,7 @@ gst_wasapi_util_get_render_client (GstElement * element, IAudioClient * client,
   }
 
   *ret_render_client = render_client;
+  res = TRUE;
 
 beach:
   return res;
@@ -224,6 +233,7 @@ gst_wasapi_util_get_capture_client (GstElement * element, IAudioClient * client,
   }
 
   *ret_capture_client = capture_client;
+  res = TRUE;
 
 beach:
   return res;
@@ -246,6 +256,7 @@ gst_wasapi_util_get_clock (GstElement * element, IAudioClient * client,
   }
 
   *ret_clock = clock;
+  res = TRUE;
 
 beach:
   return res;
@@ -270,6 +281,147 @@ gst_wasapi_util_audio_info_to_waveformatex (GstAudioInfo * info,
   format->SubFormat = KSDATAFORMAT_SUBTYPE_PCM;
 }
 
+/* Initializes @client for the format in @spec with event callbacks.
+ *
+ * In exclusive mode the device buffer is a single period, the minimum one
+ * with @low_latency and the default one otherwise, and the device signals the
+ * event each time it wants the whole buffer. In shared mode the buffer is
+ * the one asked for in @spec, or as small as the audio engine allows with
+ * @low_latency.
+ *
+ * Unless the shared buffer is the one asked for, the segments of @spec are
+ * changed to one device period so that the ringbuffer thread does exactly one
+ * read or write per event. @client may be replaced by a new client of the
+ * same device if the exclusive period has to be realigned. */
+gboolean
+gst_wasapi_util_initialize_audioclient (GstElement * element,
+    GstAudioRingBufferSpec * spec, gboolean capture, gboolean exclusive,
+    gboolean low_latency, IAudioClient ** client, guint32 * ret_buffer_frames)
+{
+  HRESULT hr;
+  REFERENCE_TIME def_period, min_period, period, buffer_duration;
+  AUDCLNT_SHAREMODE sharemode;
+  WAVEFORMATEXTENSIBLE format;
+  UINT32 buffer_frames;
+  guint64 period_frames;
+
+  hr = IAudioClient_GetDevicePeriod (*client, &def_period, &min_period);
+  if (hr != S_OK) {
+    GST_ERROR_OBJECT (element, "IAudioClient::GetDevicePeriod () failed");
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (element, "default period: %d (%d ms), "
+      "minimum period: %d (%d ms)",
+      (guint32) def_period, (guint32) def_period / 10000,
+      (guint32) min_period, (guint32) min_period / 10000);
+
+  gst_wasapi_util_audio_info_to_waveformatex (&spec->info, &format);
+
+  if (exclusive) {
+    sharemode = AUDCLNT_SHAREMODE_EXCLUSIVE;
+    period = low_latency ? min_period : def_period;
+    buffer_duration = period;
+  } else {
+    /* the periodicity is always the engine's in shared mode */
+    sharemode = AUDCLNT_SHAREMODE_SHARED;
+    period = def_period;
+    /* buffer_time is in microseconds, REFERENCE_TIME in 100 ns units */
+    buffer_duration = low_latency ? def_period : spec->buffer_time * 10;
+  }
+
+  hr = IAudioClient_Initialize (*client, sharemode,
+      AUDCLNT_STREAMFLAGS_EVENTCALLBACK, buffer_duration,
+      exclusive ? period : 0, (WAVEFORMATEX *) & format, NULL);
+
+  if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+    /* the buffer size that failed is the next aligned one, and a client that
+     * failed to initialize can't be initialized again */
+    hr = IAudioClient_GetBufferSize (*client, &buffer_frames);
+    if (hr != S_OK) {
+      GST_ERROR_OBJECT (element, "IAudioClient::GetBufferSize () failed");
+      return FALSE;
+    }
+
+    period = gst_util_uint64_scale_round (buffer_frames, 10000000,
+        format.Format.nSamplesPerSec);
+    buffer_duration = period;
+
+    GST_INFO_OBJECT (element, "realigning the period to %u frames, %d (%d ms)",
+        (guint) buffer_frames, (guint32) period, (guint32) period / 10000);
+
+    IUnknown_Release (*client);
+    *client = NULL;
+    if (!gst_wasapi_util_get_default_device_client (element, capture, client))
+      return FALSE;
+
+    hr = IAudioClient_Initialize (*client, sharemode,
+        AUDCLNT_STREAMFLAGS_EVENTCALLBACK, buffer_duration, period,
+        (WAVEFORMATEX *) & format, NULL);
+  }
+
+  if (hr != S_OK) {
+    GST_ELEMENT_ERROR (element, RESOURCE, OPEN_READ, (NULL),
+        ("IAudioClient::Initialize () failed: %s",
+            gst_wasapi_util_hresult_to_string (hr)));
+    return FALSE;
+  }
+
+  hr = IAudioClient_GetBufferSize (*client, &buffer_frames);
+  if (hr != S_OK) {
+    GST_ERROR_OBJECT (element, "IAudioClient::GetBufferSize () failed");
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (element, "%s mode, buffer of %u frames",
+      exclusive ? "exclusive" : "shared", (guint) buffer_frames);
+
+  if (exclusive || low_latency) {
+    if (exclusive)
+      period_frames = buffer_frames;
+    else
+      period_frames = gst_util_uint64_scale_round (period,
+          format.Format.nSamplesPerSec, 10000000);
+
+    spec->segsize = period_frames * GST_AUDIO_INFO_BPF (&spec->info);
+    spec->segtotal = 2;
+
+    GST_INFO_OBJECT (element, "segments of %d bytes", spec->segsize);
+  }
+
+  *ret_buffer_frames = buffer_frames;
+
+  return TRUE;
+}
+
+/* Registers the calling thread with the multimedia class scheduler so that
+ * it isn't starved by normal priority threads while a period is due. */
+gpointer
+gst_wasapi_util_set_thread_characteristics (GstElement * element)
+{
+  HANDLE handle;
+  DWORD task_index = 0;
+
+  handle = AvSetMmThreadCharacteristicsW (L"Pro Audio", &task_index);
+  if (handle == NULL) {
+    GST_WARNING_OBJECT (element, "AvSetMmThreadCharacteristics () failed: %u",
+        (guint) GetLastError ());
+    return NULL;
+  }
+
+  GST_DEBUG_OBJECT (element, "thread registered as Pro Audio task %u",
+      (guint) task_index);
+
+  return handle;
+}
+
+void
+gst_wasapi_util_revert_thread_characteristics (gpointer handle)
+{
+  if (handle != NULL)
+    AvRevertMmThreadCharacteristics ((HANDLE) handle);
+}
+
 #if 0
 static WAVEFORMATEXTENSIBLE *
 gst_wasapi_src_probe_device_format (GstWasapiSrc * self, IMMDevice * device)
@@ -51,5 +51,18 @@ void
 gst_wasapi_util_audio_info_to_waveformatex (GstAudioInfo *info,
                                        WAVEFORMATEXTENSIBLE *format);
 
+gboolean
+gst_wasapi_util_initialize_audioclient (GstElement * element,
+                                        GstAudioRingBufferSpec * spec,
+                                        gboolean capture,
+                                        gboolean exclusive,
+                                        gboolean low_latency,
+                                        IAudioClient ** client,
+                                        guint32 * ret_buffer_frames);
+
+gpointer gst_wasapi_util_set_thread_characteristics (GstElement * element);
+
+void gst_wasapi_util_revert_thread_characteristics (gpointer handle);
+
 #endif /* __GST_WASAPI_UTIL_H__ */
 
@@ -136,6 +136,8 @@ on_appSinkNewSample (GstAppSink * appsink, gpointer user_data)
         testOutputStream, buffer, priv->user_data);
 
   testOutputStream->segment_received_size += gst_buffer_get_size (buffer);
+  if (engine->first_buffer_time == 0)
+    engine->first_buffer_time = g_get_monotonic_time ();
 
   gst_sample_unref (sample);
 
@@ -182,6 +184,19 @@ on_appsink_event (GstPad * pad, GstPadProbeInfo * info, gpointer data)
   GST_DEBUG ("Received event %" GST_PTR_FORMAT " on pad %" GST_PTR_FORMAT,
       event, pad);
 
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+    GstPad *stream_pad = gst_pad_get_peer (pad);
+
+    if (stream_pad) {
+      GST_TEST_LOCK (priv);
+      stream = getTestOutputDataByPad (priv, stream_pad, FALSE);
+      if (stream)
+        stream->caps_events++;
+      GST_TEST_UNLOCK (priv);
+      gst_object_unref (stream_pad);
+    }
+  }
+
   if (priv->callbacks->appsink_event) {
     GstPad *stream_pad = gst_pad_get_peer (pad);
     fail_unless (stream_pad != NULL);
@@ -586,6 +601,7 @@ gst_adaptive_demux_test_run (const gchar * element_name,
   GST_TEST_UNLOCK (priv);
 
   GST_DEBUG ("Starting pipeline");
+  priv->engine.start_time = g_get_monotonic_time ();
   stateChange = gst_element_set_state (priv->engine.pipeline, GST_STATE_PAUSED);
   fail_unless (stateChange != GST_STATE_CHANGE_FAILURE);
   /* wait for completion of the move to PAUSED */
@@ -44,6 +44,9 @@ typedef struct _GstAdaptiveDemuxTestOutputStream {
   guint64 segment_received_size;
   /* the total size received so far on this stream, excluding current segment */
   guint64 total_received_size;
+  /* the number of caps events received, each one after the first one
+   * being a switch to another representation or variant */
+  guint caps_events;
 } GstAdaptiveDemuxTestOutputStream;
 
 /* GstAdaptiveDemuxTestCallbacks: contains various callbacks that can
@@ -172,6 +175,10 @@ struct _GstAdaptiveDemuxTestEngine
   GstElement *manifest_source;
   GMainLoop *loop;
   GPtrArray *output_streams; /* GPtrArray<GstAdaptiveDemuxTestOutputStream> */
+  /* monotonic time when the pipeline was started and when the first
+   * buffer reached an AppSink element, for measuring the startup time */
+  gint64 start_time;
+  gint64 first_buffer_time;
   /* mutex to lock accesses to this structure when data is shared 
    * between threads */
   GMutex lock;
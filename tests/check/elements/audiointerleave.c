@@ -647,8 +647,8 @@ test_audiointerleave_2ch_pipeline (gboolean interleaved)
   msg = gst_bus_poll (GST_ELEMENT_BUS (pipeline), GST_MESSAGE_EOS, -1);
   gst_message_unref (msg);
 
-  /* 48000 samples per buffer * 2 sources * 4 buffers */
-  fail_unless (have_data == 48000 * 2 * 4 * sizeof (gfloat));
+  fail_unless (have_data ==
+      samples_per_buffer * 2 * num_buffers * sizeof (gfloat));
 
   gst_element_set_state (pipeline, GST_STATE_NULL);
   gst_element_release_request_pad (interleave, sinkpad0);
@@ -673,6 +673,139 @@ GST_START_TEST (test_audiointerleave_2ch_pipeline_non_audiointerleaved)
 
 GST_END_TEST;
 
+static void
+sink_handoff_float32_planar (GstElement * element, GstBuffer * buffer,
+    GstPad * pad, gpointer user_data)
+{
+  GstMapInfo map;
+  gfloat *data;
+  GstCaps *caps;
+  GstStructure *s;
+  gint i, plane_samples;
+
+  caps = gst_pad_get_current_caps (pad);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless_equals_string (gst_structure_get_string (s, "layout"),
+      "non-interleaved");
+  gst_caps_unref (caps);
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  data = (gfloat *) map.data;
+  plane_samples = map.size / sizeof (gfloat) / 2;
+
+  /* all of the first channel, then all of the second one */
+  for (i = 0; i < plane_samples; i++) {
+    fail_unless_equals_float (data[i], -1.0);
+    fail_unless_equals_float (data[plane_samples + i], 1.0);
+  }
+  have_data += map.size;
+
+  gst_buffer_unmap (buffer, &map);
+}
+
+static void
+test_audiointerleave_2ch_pipeline_planar (gint samples_per_buffer,
+    gint num_buffers)
+{
+  GstElement *pipeline, *src1, *src2, *interleave, *capsfilter, *sink;
+  GstPad *sinkpad0, *sinkpad1, *tmp;
+  GstMessage *msg;
+  GstCaps *caps;
+
+  have_data = 0;
+
+  pipeline = (GstElement *) gst_pipeline_new ("pipeline");
+  fail_unless (pipeline != NULL);
+
+  src1 = gst_element_factory_make ("fakesrc", "src1");
+  fail_unless (src1 != NULL);
+  g_object_set (src1, "num-buffers", num_buffers, NULL);
+  g_object_set (src1, "sizetype", 2,
+      "sizemax", (int) (samples_per_buffer * sizeof (gfloat)),
+      "datarate", (int) 48000 * sizeof (gfloat), NULL);
+  g_object_set (src1, "signal-handoffs", TRUE, NULL);
+  g_object_set (src1, "format", GST_FORMAT_TIME, NULL);
+  g_signal_connect (src1, "handoff",
+      G_CALLBACK (src_handoff_float32_audiointerleaved), GINT_TO_POINTER (0));
+  gst_bin_add (GST_BIN (pipeline), src1);
+
+  src2 = gst_element_factory_make ("fakesrc", "src2");
+  fail_unless (src2 != NULL);
+  g_object_set (src2, "num-buffers", num_buffers, NULL);
+  g_object_set (src2, "sizetype", 2,
+      "sizemax", (int) (samples_per_buffer * sizeof (gfloat)),
+      "datarate", (int) 48000 * sizeof (gfloat), NULL);
+  g_object_set (src2, "signal-handoffs", TRUE, NULL);
+  g_object_set (src2, "format", GST_FORMAT_TIME, NULL);
+  g_signal_connect (src2, "handoff",
+      G_CALLBACK (src_handoff_float32_audiointerleaved), GINT_TO_POINTER (1));
+  gst_bin_add (GST_BIN (pipeline), src2);
+
+  interleave = gst_element_factory_make ("audiointerleave", "audiointerleave");
+  fail_unless (interleave != NULL);
+  gst_bin_add (GST_BIN (pipeline), gst_object_ref (interleave));
+
+  sinkpad0 = gst_element_get_request_pad (interleave, "sink_%u");
+  fail_unless (sinkpad0 != NULL);
+  tmp = gst_element_get_static_pad (src1, "src");
+  fail_unless (gst_pad_link (tmp, sinkpad0) == GST_PAD_LINK_OK);
+  gst_object_unref (tmp);
+
+  sinkpad1 = gst_element_get_request_pad (interleave, "sink_%u");
+  fail_unless (sinkpad1 != NULL);
+  tmp = gst_element_get_static_pad (src2, "src");
+  fail_unless (gst_pad_link (tmp, sinkpad1) == GST_PAD_LINK_OK);
+  gst_object_unref (tmp);
+
+  capsfilter = gst_element_factory_make ("capsfilter", "capsfilter");
+  fail_unless (capsfilter != NULL);
+  caps = gst_caps_from_string ("audio/x-raw, layout = non-interleaved");
+  g_object_set (capsfilter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  gst_bin_add (GST_BIN (pipeline), capsfilter);
+
+  sink = gst_element_factory_make ("fakesink", "sink");
+  fail_unless (sink != NULL);
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (sink_handoff_float32_planar),
+      NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+
+  fail_unless (gst_element_link_many (interleave, capsfilter, sink, NULL));
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  msg = gst_bus_poll (GST_ELEMENT_BUS (pipeline), GST_MESSAGE_EOS, -1);
+  gst_message_unref (msg);
+
+  fail_unless (have_data ==
+      samples_per_buffer * 2 * num_buffers * sizeof (gfloat));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_element_release_request_pad (interleave, sinkpad0);
+  gst_object_unref (sinkpad0);
+  gst_element_release_request_pad (interleave, sinkpad1);
+  gst_object_unref (sinkpad1);
+  gst_object_unref (interleave);
+  gst_object_unref (pipeline);
+}
+
+GST_START_TEST (test_audiointerleave_2ch_pipeline_planar_output)
+{
+  test_audiointerleave_2ch_pipeline_planar (48000, 4);
+}
+
+GST_END_TEST;
+
+/* 3000 samples don't fill the last 10ms output buffer, which then only has
+ * 120 samples in each plane */
+GST_START_TEST (test_audiointerleave_2ch_pipeline_planar_output_partial)
+{
+  test_audiointerleave_2ch_pipeline_planar (1000, 3);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_audiointerleave_2ch_pipeline_input_chanpos)
 {
   GstElement *pipeline, *queue, *src1, *src2, *interleave, *sink;
@@ -751,8 +884,8 @@ GST_START_TEST (test_audiointerleave_2ch_pipeline_input_chanpos)
   msg = gst_bus_poll (GST_ELEMENT_BUS (pipeline), GST_MESSAGE_EOS, -1);
   gst_message_unref (msg);
 
-  /* 48000 samples per buffer * 2 sources * 4 buffers */
-  fail_unless (have_data == 48000 * 2 * 4 * sizeof (gfloat));
+  fail_unless (have_data ==
+      samples_per_buffer * 2 * num_buffers * sizeof (gfloat));
 
   gst_element_set_state (pipeline, GST_STATE_NULL);
   gst_element_release_request_pad (interleave, sinkpad0);
@@ -857,8 +990,8 @@ GST_START_TEST (test_audiointerleave_2ch_pipeline_custom_chanpos)
   msg = gst_bus_poll (GST_ELEMENT_BUS (pipeline), GST_MESSAGE_EOS, -1);
   gst_message_unref (msg);
 
-  /* 48000 samples per buffer * 2 sources * 4 buffers */
-  fail_unless (have_data == 48000 * 2 * 4 * sizeof (gfloat));
+  fail_unless (have_data ==
+      samples_per_buffer * 2 * num_buffers * sizeof (gfloat));
 
   gst_element_set_state (pipeline, GST_STATE_NULL);
   gst_element_release_request_pad (interleave, sinkpad0);
@@ -949,8 +1082,8 @@ GST_START_TEST (test_audiointerleave_2ch_pipeline_no_chanpos)
   msg = gst_bus_poll (GST_ELEMENT_BUS (pipeline), GST_MESSAGE_EOS, -1);
   gst_message_unref (msg);
 
-  /* 48000 samples per buffer * 2 sources * 4 buffers */
-  fail_unless (have_data == 48000 * 2 * 4 * sizeof (gfloat));
+  fail_unless (have_data ==
+      samples_per_buffer * 2 * num_buffers * sizeof (gfloat));
 
   gst_element_set_state (pipeline, GST_STATE_NULL);
   gst_element_release_request_pad (interleave, sinkpad0);
@@ -1117,6 +1250,9 @@ audiointerleave_suite (void)
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_audiointerleaved);
   tcase_add_test (tc_chain,
       test_audiointerleave_2ch_pipeline_non_audiointerleaved);
+  tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_planar_output);
+  tcase_add_test (tc_chain,
+      test_audiointerleave_2ch_pipeline_planar_output_partial);
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_input_chanpos);
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_custom_chanpos);
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_no_chanpos);
@@ -26,23 +26,30 @@
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 
-/* Define 2 element factories for testing with */
+/* Define 3 element factories for testing with */
 typedef GstBin TestElement1;
 typedef GstBinClass TestElement1Class;
 typedef GstBin TestElement2;
 typedef GstBinClass TestElement2Class;
+typedef GstBin TestElement3;
+typedef GstBinClass TestElement3Class;
 
 GType test_element1_get_type (void);
 G_DEFINE_TYPE (TestElement1, test_element1, GST_TYPE_BIN);
 GType test_element2_get_type (void);
 G_DEFINE_TYPE (TestElement2, test_element2, GST_TYPE_BIN);
+GType test_element3_get_type (void);
+G_DEFINE_TYPE (TestElement3, test_element3, GST_TYPE_BIN);
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC, GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("test/caps,type=(int)[1,2]"));
+    GST_STATIC_CAPS ("test/caps,type=(int)[1,3]"));
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK, GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("test/caps,type=(int)[1,2]"));
+    GST_STATIC_CAPS ("test/caps,type=(int)[1,3]"));
+
+/* Number of accept-caps queries received by each test element */
+static gint accept_caps_queries[3];
 
 static void
 setup (void)
@@ -52,6 +59,10 @@ setup (void)
           test_element1_get_type ()));
   fail_unless (gst_element_register (NULL, "testelement2", GST_RANK_NONE,
           test_element2_get_type ()));
+  fail_unless (gst_element_register (NULL, "testelement3", GST_RANK_NONE,
+          test_element3_get_type ()));
+
+  memset (accept_caps_queries, 0, sizeof (accept_caps_queries));
 }
 
 static void
@@ -59,21 +70,23 @@ teardown (void)
 {
 }
 
+/* Sets the factories of @autoconvert to the NULL-terminated list of
+ * @desired_features, in that order */
 static void
-set_autoconvert_factories (GstElement * autoconvert)
+set_autoconvert_factory_list (GstElement * autoconvert,
+    const gchar ** desired_features)
 {
-  const gchar *desired_features[] = { "testelement1", "testelement2" };
   GstElementFactory *feature;
   GList *factories = NULL;
   gint i;
 
-  for (i = 0; i < G_N_ELEMENTS (desired_features); i++) {
+  for (i = 0; desired_features[i] != NULL; i++) {
     feature =
         GST_ELEMENT_FACTORY_CAST (gst_registry_find_feature
         (gst_registry_get (), desired_features[i], GST_TYPE_ELEMENT_FACTORY));
     fail_if (feature == NULL, "Test element %s was not found in registry",
         desired_features[i]);
-    factories = g_list_prepend (factories, feature);
+    factories = g_list_append (factories, feature);
   }
 
   g_object_set (G_OBJECT (autoconvert), "factories", factories, NULL);
@@ -81,6 +94,14 @@ set_autoconvert_factories (GstElement * autoconvert)
   g_list_free_full (factories, gst_object_unref);
 }
 
+static void
+set_autoconvert_factories (GstElement * autoconvert)
+{
+  const gchar *desired_features[] = { "testelement2", "testelement1", NULL };
+
+  set_autoconvert_factory_list (autoconvert, desired_features);
+}
+
 GST_START_TEST (test_autoconvert_simple)
 {
   GstPad *test_src_pad, *test_sink_pad;
@@ -150,6 +171,69 @@ GST_START_TEST (test_autoconvert_simple)
 
 GST_END_TEST;
 
+GST_START_TEST (test_autoconvert_cached_factory)
+{
+  GstPad *test_src_pad, *test_sink_pad;
+  GstElement *autoconvert = gst_check_setup_element ("autoconvert");
+  const gchar *desired_features[] =
+      { "testelement3", "testelement2", "testelement1", NULL };
+  GstCaps *caps;
+
+  set_autoconvert_factory_list (autoconvert, desired_features);
+
+  test_src_pad = gst_check_setup_src_pad (autoconvert, &src_factory);
+  gst_pad_set_active (test_src_pad, TRUE);
+  test_sink_pad = gst_check_setup_sink_pad (autoconvert, &sink_factory);
+  gst_pad_set_active (test_sink_pad, TRUE);
+
+  gst_element_set_state (GST_ELEMENT_CAST (autoconvert), GST_STATE_PLAYING);
+
+  /* caps 1 goes through testelement3 and testelement2 before testelement1
+   * is picked */
+  caps = gst_caps_from_string ("test/caps,type=(int)1");
+  gst_check_setup_events (test_src_pad, autoconvert, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+  fail_unless (gst_pad_push (test_src_pad, gst_buffer_new_and_alloc (4096))
+      == GST_FLOW_OK);
+  fail_unless (accept_caps_queries[1] > 0);
+  fail_unless_equals_int (accept_caps_queries[2], 0);
+
+  /* caps 3 is accepted by testelement3, the first factory in the list */
+  GST_LOG ("Changing caps to caps 3");
+  caps = gst_caps_from_string ("test/caps,type=(int)3");
+  fail_unless (gst_pad_set_caps (test_src_pad, caps));
+  gst_caps_unref (caps);
+  fail_unless (gst_pad_push (test_src_pad, gst_buffer_new_and_alloc (4096))
+      == GST_FLOW_OK);
+  fail_unless (accept_caps_queries[2] > 0);
+
+  /* Going back to caps 1 must reuse the cached testelement1 instead of
+   * trying testelement2 again */
+  accept_caps_queries[1] = 0;
+  accept_caps_queries[0] = 0;
+  GST_LOG ("Changing caps back to caps 1");
+  caps = gst_caps_from_string ("test/caps,type=(int)1");
+  fail_unless (gst_pad_set_caps (test_src_pad, caps));
+  gst_caps_unref (caps);
+  fail_unless (gst_pad_push (test_src_pad, gst_buffer_new_and_alloc (4096))
+      == GST_FLOW_OK);
+  fail_unless_equals_int (accept_caps_queries[1], 0);
+  fail_unless (accept_caps_queries[0] > 0);
+
+  fail_unless_equals_int (g_list_length (buffers), 3);
+
+  gst_element_set_state ((GstElement *) autoconvert, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (test_src_pad, FALSE);
+  gst_pad_set_active (test_sink_pad, FALSE);
+  gst_check_teardown_src_pad (autoconvert);
+  gst_check_teardown_sink_pad (autoconvert);
+  gst_check_teardown_element (autoconvert);
+}
+
+GST_END_TEST;
+
 static Suite *
 autoconvert_suite (void)
 {
@@ -159,14 +243,28 @@ autoconvert_suite (void)
   suite_add_tcase (s, tc_basic);
   tcase_add_checked_fixture (tc_basic, setup, teardown);
   tcase_add_test (tc_basic, test_autoconvert_simple);
+  tcase_add_test (tc_basic, test_autoconvert_cached_factory);
 
   return s;
 }
 
 /* Implementation of the test elements */
 
+static GstPadProbeReturn
+count_accept_caps_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_ACCEPT_CAPS)
+    g_atomic_int_inc ((gint *) user_data);
+
+  return GST_PAD_PROBE_OK;
+}
+
 static void
-configure_test_element (GstBin * bin, const gchar * capsfilter)
+configure_test_element (GstBin * bin, const gchar * capsfilter,
+    gint * accept_caps_counter)
 {
   GstElement *filter;
   GstElement *identity;
@@ -187,6 +285,9 @@ configure_test_element (GstBin * bin, const gchar * capsfilter)
   test_static_templ = gst_static_pad_template_get (&sink_factory);
   pad = gst_element_get_static_pad (filter, "sink");
   ghostpad = gst_ghost_pad_new_from_template ("sink", pad, test_static_templ);
+  gst_pad_add_probe (ghostpad,
+      GST_PAD_PROBE_TYPE_QUERY_BOTH | GST_PAD_PROBE_TYPE_PUSH,
+      count_accept_caps_probe, accept_caps_counter, NULL);
   gst_element_add_pad (GST_ELEMENT_CAST (bin), ghostpad);
   gst_object_unref (pad);
   gst_object_unref (test_static_templ);
@@ -211,7 +312,8 @@ test_element1_class_init (TestElement1Class * klass)
 static void
 test_element1_init (TestElement1 * elem)
 {
-  configure_test_element (GST_BIN_CAST (elem), "test/caps,type=(int)1");
+  configure_test_element (GST_BIN_CAST (elem), "test/caps,type=(int)1",
+      &accept_caps_queries[0]);
 }
 
 static void
@@ -227,7 +329,24 @@ test_element2_class_init (TestElement2Class * klass)
 static void
 test_element2_init (TestElement2 * elem)
 {
-  configure_test_element (GST_BIN_CAST (elem), "test/caps,type=(int)2");
+  configure_test_element (GST_BIN_CAST (elem), "test/caps,type=(int)2",
+      &accept_caps_queries[1]);
+}
+
+static void
+test_element3_class_init (TestElement3Class * klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class, &src_factory);
+  gst_element_class_add_static_pad_template (element_class, &sink_factory);
+}
+
+static void
+test_element3_init (TestElement3 * elem)
+{
+  configure_test_element (GST_BIN_CAST (elem), "test/caps,type=(int)3",
+      &accept_caps_queries[2]);
 }
 
 GST_CHECK_MAIN (autoconvert);
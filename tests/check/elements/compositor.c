@@ -1740,6 +1740,131 @@ GST_START_TEST (test_obscured_skipped)
 
 GST_END_TEST;
 
+static GstBuffer *
+_run_threaded_blend (const gchar * format, guint n_threads)
+{
+  GstElement *pipeline, *sink;
+  GstSample *sample;
+  GstBuffer *buffer;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=1 pattern=smpte ! "
+      "video/x-raw,format=%s,width=100,height=75 ! "
+      "compositor name=c n-threads=%u background=white "
+      "sink_1::xpos=13 sink_1::ypos=21 sink_1::alpha=0.5 ! "
+      "video/x-raw,width=160,height=120 ! appsink name=sink sync=false "
+      "videotestsrc num-buffers=1 pattern=ball ! "
+      "video/x-raw,format=%s,width=50,height=61 ! c.", format, n_threads,
+      format);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (sink, "pull-sample", &sample);
+  fail_unless (sample != NULL);
+  buffer = gst_buffer_ref (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+
+  return buffer;
+}
+
+GST_START_TEST (test_threaded_blend)
+{
+  const gchar *formats[] = { "I420", "NV12", "AYUV", "YUY2", "RGB" };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    GstBuffer *serial, *threaded;
+    GstMapInfo serial_map, threaded_map;
+
+    GST_INFO ("testing format %s", formats[i]);
+    serial = _run_threaded_blend (formats[i], 1);
+    threaded = _run_threaded_blend (formats[i], 4);
+
+    fail_unless (gst_buffer_map (serial, &serial_map, GST_MAP_READ));
+    fail_unless (gst_buffer_map (threaded, &threaded_map, GST_MAP_READ));
+    fail_unless_equals_int (serial_map.size, threaded_map.size);
+    fail_unless (memcmp (serial_map.data, threaded_map.data,
+            serial_map.size) == 0);
+    gst_buffer_unmap (serial, &serial_map);
+    gst_buffer_unmap (threaded, &threaded_map);
+
+    gst_buffer_unref (serial);
+    gst_buffer_unref (threaded);
+  }
+}
+
+GST_END_TEST;
+
+static GstBuffer *
+_run_threaded_convert (guint n_threads)
+{
+  GstElement *pipeline, *sink;
+  GstSample *sample;
+  GstBuffer *buffer;
+  gchar *desc;
+
+  /* both pads are scaled and converted to the output format */
+  desc = g_strdup_printf ("videotestsrc num-buffers=3 pattern=smpte ! "
+      "video/x-raw,format=I420,width=100,height=75 ! "
+      "compositor name=c background=white "
+      "sink_0::width=160 sink_0::height=120 "
+      "sink_0::converter-threads=%u sink_1::converter-threads=%u "
+      "sink_1::xpos=13 sink_1::ypos=21 sink_1::width=64 sink_1::height=48 ! "
+      "video/x-raw,format=AYUV,width=160,height=120 ! "
+      "appsink name=sink sync=false "
+      "videotestsrc num-buffers=3 pattern=ball ! "
+      "video/x-raw,format=NV12,width=50,height=60 ! c.", n_threads, n_threads);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (sink, "pull-sample", &sample);
+  fail_unless (sample != NULL);
+  buffer = gst_buffer_ref (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+
+  return buffer;
+}
+
+GST_START_TEST (test_threaded_convert)
+{
+  GstBuffer *serial, *threaded;
+  GstMapInfo serial_map, threaded_map;
+
+  serial = _run_threaded_convert (1);
+  threaded = _run_threaded_convert (4);
+
+  fail_unless (gst_buffer_map (serial, &serial_map, GST_MAP_READ));
+  fail_unless (gst_buffer_map (threaded, &threaded_map, GST_MAP_READ));
+  fail_unless_equals_int (serial_map.size, threaded_map.size);
+  fail_unless (memcmp (serial_map.data, threaded_map.data,
+          serial_map.size) == 0);
+  gst_buffer_unmap (serial, &serial_map);
+  gst_buffer_unmap (threaded, &threaded_map);
+
+  gst_buffer_unref (serial);
+  gst_buffer_unref (threaded);
+}
+
+GST_END_TEST;
+
 static void
 _pipeline_eos (GstBus * bus, GstMessage * message, GstPipeline * bin)
 {
@@ -2099,6 +2224,8 @@ compositor_suite (void)
   tcase_add_test (tc_chain, test_flush_start_flush_stop);
   tcase_add_test (tc_chain, test_segment_base_handling);
   tcase_add_test (tc_chain, test_obscured_skipped);
+  tcase_add_test (tc_chain, test_threaded_blend);
+  tcase_add_test (tc_chain, test_threaded_convert);
   tcase_add_test (tc_chain, test_ignore_eos);
   tcase_add_test (tc_chain, test_pad_z_order);
   tcase_add_test (tc_chain, test_pad_numbering);
@@ -184,6 +184,37 @@ GST_START_TEST (dash_isoff_moof_parse)
 
 GST_END_TEST;
 
+GST_START_TEST (dash_isoff_moof_parse_truncated_trun)
+{
+  /* INDENT-OFF */
+  static const guint8 data[] = {
+    0, 0, 0, 68, 'm', 'o', 'o', 'f',
+    0, 0, 0, 16, 'm', 'f', 'h', 'd',
+    0, 0, 0, 0, 0, 0, 0, 1,
+    0, 0, 0, 44, 't', 'r', 'a', 'f',
+    0, 0, 0, 16, 't', 'f', 'h', 'd',
+    0, 0, 0, 0, 0, 0, 0, 1,
+    /* claims 2^28 samples with a size each, but only has one */
+    0, 0, 0, 20, 't', 'r', 'u', 'n',
+    0, 0, 0x02, 0, 0x10, 0, 0, 0,
+    0, 0, 0x10, 0
+  };
+  /* INDENT-ON */
+  GstByteReader reader = GST_BYTE_READER_INIT (data, sizeof (data));
+  guint32 type;
+  guint header_size;
+  guint64 size;
+
+  fail_unless (gst_isoff_parse_box_header (&reader, &type, NULL,
+          &header_size, &size));
+  fail_unless (type == GST_MAKE_FOURCC ('m', 'o', 'o', 'f'));
+  fail_unless_equals_uint64 (size, sizeof (data));
+
+  fail_unless (gst_isoff_moof_box_parse (&reader) == NULL);
+}
+
+GST_END_TEST;
+
 static Suite *
 dash_isoff_suite (void)
 {
@@ -203,6 +234,7 @@ dash_isoff_suite (void)
 
 
   tcase_add_test (tc_moof, dash_isoff_moof_parse);
+  tcase_add_test (tc_moof, dash_isoff_moof_parse_truncated_trun);
   suite_add_tcase (s, tc_moof);
 
   return s;
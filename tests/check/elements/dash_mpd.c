@@ -456,6 +456,37 @@ GST_START_TEST (dash_mpdparser_period_segmentBase)
 
 GST_END_TEST;
 
+/*
+ * Test parsing Period SegmentBase availabilityTimeOffset attribute
+ *
+ */
+GST_START_TEST (dash_mpdparser_period_segmentBase_availabilityTimeOffset)
+{
+  GstPeriodNode *periodNode;
+  GstSegmentBaseType *segmentBase;
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-main:2011\">"
+      "  <Period>"
+      "    <SegmentBase availabilityTimeOffset=\"1.5\">"
+      "    </SegmentBase></Period></MPD>";
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  periodNode = (GstPeriodNode *) mpdclient->mpd_node->Periods->data;
+  segmentBase = periodNode->SegmentBase;
+  assert_equals_float (segmentBase->availabilityTimeOffset, 1.5);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test parsing Period SegmentBase Initialization attributes
  *
@@ -4843,6 +4874,243 @@ GST_START_TEST (dash_mpdparser_segment_timeline)
 
 GST_END_TEST;
 
+/*
+ * Test that contiguous S nodes of the same duration are stored as a
+ * single repeated segment
+ *
+ */
+GST_START_TEST (dash_mpdparser_compact_segment_timeline)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaSegment *segment;
+  GstMediaFragmentInfo fragment;
+  GstFlowReturn flow;
+  gint i;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-main:2011\""
+      "     mediaPresentationDuration=\"P0Y0M0DT3H3M30S\">"
+      "  <Period>"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"TestMedia$Number$\" startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2\"></S>"
+      "            <S t=\"2\" d=\"2\"></S>"
+      "            <S d=\"2\" r=\"1\"></S>"
+      "            <S t=\"8\" d=\"3\"></S>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  /* process the xml data */
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  /* get the list of adaptation sets of the first period */
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+
+  /* setup streaming from the first adaptation set */
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  /* the first three S nodes describe four contiguous 2s segments */
+  assert_equals_int (activeStream->segments->len, 2);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->number, 1);
+  assert_equals_int (segment->repeat, 3);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  assert_equals_int (segment->number, 5);
+  assert_equals_int (segment->repeat, 0);
+  assert_equals_uint64 (segment->start, 8 * GST_SECOND);
+
+  for (i = 0; i < 4; i++) {
+    gchar *uri = g_strdup_printf ("/TestMedia%d", i + 1);
+
+    ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+    assert_equals_int (ret, TRUE);
+    assert_equals_string (fragment.uri, uri);
+    assert_equals_uint64 (fragment.timestamp, 2 * i * GST_SECOND);
+    assert_equals_uint64 (fragment.duration, 2 * GST_SECOND);
+    gst_media_fragment_info_clear (&fragment);
+    g_free (uri);
+
+    flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+    assert_equals_int (flow, GST_FLOW_OK);
+  }
+
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/TestMedia5");
+  assert_equals_uint64 (fragment.timestamp, 8 * GST_SECOND);
+  assert_equals_uint64 (fragment.duration, 3 * GST_SECOND);
+  gst_media_fragment_info_clear (&fragment);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test merging the SegmentTimeline of a live MPD refresh
+ *
+ */
+GST_START_TEST (dash_mpdparser_merge_update)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaSegment *segment;
+  GstMediaFragmentInfo fragment;
+  GstClockTime ts;
+  GstFlowReturn flow;
+  GstMpdClient *update;
+  gint i;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     type=\"dynamic\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"TestMedia$Number$\" startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"10\" d=\"2\" r=\"1\"></S>"
+      "            <S d=\"3\" r=\"1\"></S>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  /* the first segment left the time shift buffer and two were added */
+  const gchar *xml_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     type=\"dynamic\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"TestMedia$Number$\" startNumber=\"3\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"14\" d=\"3\" r=\"3\"></S>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  /* the numbering does not continue the one of the current timeline */
+  const gchar *xml_renumbered =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     type=\"dynamic\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"TestMedia$Number$\" startNumber=\"10\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"20\" d=\"3\" r=\"3\"></S>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  /* process the xml data */
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  /* get the list of adaptation sets of the first period */
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+
+  /* setup streaming from the first adaptation set */
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 2);
+
+  /* move to the 4th segment */
+  for (i = 0; i < 3; i++) {
+    flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+    assert_equals_int (flow, GST_FLOW_OK);
+  }
+
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_merge_update (mpdclient, update);
+  assert_equals_int (ret, TRUE);
+  gst_mpd_client_free (update);
+
+  /* the new segments extend the last one, the first one was dropped */
+  assert_equals_int (activeStream->segments->len, 1);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->number, 3);
+  assert_equals_int (segment->repeat, 3);
+  assert_equals_uint64 (segment->start, 14 * GST_SECOND);
+
+  /* the stream kept its position */
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/TestMedia4");
+  assert_equals_uint64 (fragment.timestamp, 17 * GST_SECOND);
+  assert_equals_uint64 (fragment.duration, 3 * GST_SECOND);
+  gst_media_fragment_info_clear (&fragment);
+
+  ret = gst_mpd_client_get_last_fragment_timestamp_end (mpdclient, 0, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 26 * GST_SECOND);
+
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_parse (update, xml_renumbered, (gint) strlen (xml_renumbered));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_merge_update (mpdclient, update);
+  assert_equals_int (ret, FALSE);
+  gst_mpd_client_free (update);
+
+  /* the current client was left untouched */
+  assert_equals_int (activeStream->segments->len, 1);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->repeat, 3);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test SegmentList with multiple inherited segmentURLs
  *
@@ -5800,6 +6068,8 @@ dash_suite (void)
   tcase_add_test (tc_simpleMPD, dash_mpdparser_period);
   tcase_add_test (tc_simpleMPD, dash_mpdparser_period_baseURL);
   tcase_add_test (tc_simpleMPD, dash_mpdparser_period_segmentBase);
+  tcase_add_test (tc_simpleMPD,
+      dash_mpdparser_period_segmentBase_availabilityTimeOffset);
   tcase_add_test (tc_simpleMPD,
       dash_mpdparser_period_segmentBase_initialization);
   tcase_add_test (tc_simpleMPD,
@@ -5936,6 +6206,8 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_compact_segment_timeline);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_merge_update);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
   /* tests checking the parsing of missing/incomplete attributes of xml */
@@ -724,6 +724,86 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+#define NETWORK_PROFILE_BANDWIDTH 8000000
+#define NETWORK_PROFILE_RTT (20 * GST_MSECOND)
+
+static void
+testNetworkProfilePostTest (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  gint64 now = g_get_monotonic_time ();
+  guint i;
+
+  /* the master playlist, the media playlist and the first fragment each
+   * take a round trip before the first buffer */
+  fail_unless (engine->first_buffer_time != 0);
+  fail_unless (engine->first_buffer_time - engine->start_time >=
+      3 * NETWORK_PROFILE_RTT / GST_USECOND);
+  GST_INFO ("startup time %" G_GINT64_FORMAT " us",
+      engine->first_buffer_time - engine->start_time);
+
+  for (i = 0; i < engine->output_streams->len; ++i) {
+    GstAdaptiveDemuxTestOutputStream *stream =
+        g_ptr_array_index (engine->output_streams, i);
+    guint64 size = stream->total_received_size + stream->segment_received_size;
+
+    fail_unless (stream->caps_events >= 1);
+    GST_INFO ("stream %s: %u switches, average bitrate %" G_GUINT64_FORMAT
+        " bps", stream->name, stream->caps_events - 1,
+        gst_util_uint64_scale (size * 8, G_USEC_PER_SEC,
+            MAX (now - engine->start_time, 1)));
+  }
+}
+
+/*
+ * Test the measurements of a stream played over a simulated network
+ *
+ */
+GST_START_TEST (testNetworkProfile)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *master_playlist =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:4\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=1251135, CODECS=\"avc1.42001f mp4a.40.2\", RESOLUTION=640x352\n"
+      "1200.m3u8\n";
+  const gchar *media_playlist =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/master.m3u8", (guint8 *) master_playlist, 0},
+    {"http://unit.test/1200.m3u8", (guint8 *) media_playlist, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {NULL, NULL, 0}
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 3 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+  engine_callbacks.post_test = testNetworkProfilePostTest;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_test_http_src_set_network_profile (NETWORK_PROFILE_BANDWIDTH,
+      NETWORK_PROFILE_RTT);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      "http://unit.test/master.m3u8", &engine_callbacks, engineTestData);
+  gst_test_http_src_set_network_profile (0, 0);
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -735,6 +815,7 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testMediaPlaylistNotFound);
   tcase_add_test (tc_basicTest, testFragmentNotFound);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
+  tcase_add_test (tc_basicTest, testNetworkProfile);
   tcase_add_test (tc_basicTest, testSeek);
   tcase_add_test (tc_basicTest, testSeekKeyUnitPosition);
   tcase_add_test (tc_basicTest, testSeekPosition);
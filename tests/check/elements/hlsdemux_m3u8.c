@@ -322,6 +322,26 @@ http://example.com/hi.m3u8\r\n\
 #EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=65000,CODECS=\"mp4a.40.5\"\r\n\
 http://example.com/audio-only.m3u8";
 
+static const gchar *LOW_LATENCY_PLAYLIST = "#EXTM3U \n\
+#EXT-X-TARGETDURATION:4\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n\
+#EXT-X-PART-INF:PART-TARGET=1.0\n\
+#EXT-X-MEDIA-SEQUENCE:100\n\
+#EXTINF:4.0,\n\
+fileSequence100.ts\n\
+#EXTINF:4.0,\n\
+fileSequence101.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"filePart102.0.ts\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"filePart102.1.ts\"\n\
+#EXT-X-PART:DURATION=1.0,URI=\"filePart102.2.ts\"\n\
+#EXT-X-PART:DURATION=1.0,URI=\"filePart102.3.ts\"\n\
+#EXTINF:4.0,\n\
+fileSequence102.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"filePart103.0.ts\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"filePart103.1.ts\"\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"filePart103.2.ts\"\n";
+
 static GstHLSMasterPlaylist *
 load_playlist (const gchar * data)
 {
@@ -701,6 +721,45 @@ GST_START_TEST (test_update_playlist)
 
 GST_END_TEST;
 
+GST_START_TEST (test_update_playlist_reuses_files)
+{
+  static const gchar *LIVE_PLAYLIST_UPDATE = "#EXTM3U\n"
+      "#EXT-X-TARGETDURATION:8\n"
+      "#EXT-X-MEDIA-SEQUENCE:2681\n"
+      "#EXTINF:8,\n"
+      "https://priv.example.com/fileSequence2681.ts\n"
+      "#EXTINF:8,\n"
+      "https://priv.example.com/fileSequence2682.ts\n"
+      "#EXTINF:8,\n"
+      "https://priv.example.com/fileSequence2683.ts\n"
+      "#EXTINF:8,\n"
+      "https://priv.example.com/fileSequence2684.ts";
+  GstHLSMasterPlaylist *master;
+  GstM3U8MediaFile *file;
+  GstM3U8 *pl;
+  gboolean ret;
+
+  master = load_playlist (LIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  assert_equals_int64 (file->sequence, 2681);
+
+  ret = gst_m3u8_update (pl, g_strdup (LIVE_PLAYLIST_UPDATE));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (g_list_length (pl->files), 4);
+
+  /* the already known segments are kept, the new one is appended */
+  fail_unless (g_list_nth_data (pl->files, 0) == file);
+  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  assert_equals_int64 (file->sequence, 2684);
+  assert_equals_string (file->uri,
+      "https://priv.example.com/fileSequence2684.ts");
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_playlist_media_files)
 {
   GstHLSMasterPlaylist *master;
@@ -1395,6 +1454,85 @@ GST_START_TEST (test_stream_inf_tag)
 
 GST_END_TEST;
 
+GST_START_TEST (test_low_latency_playlist)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *mf;
+  GstClockTime timestamp;
+  gboolean discont;
+  gchar *uri;
+  gint i;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  fail_unless (gst_m3u8_is_low_latency (pl));
+  fail_unless (pl->can_block_reload);
+  assert_equals_uint64 (pl->part_target, GST_SECOND);
+  assert_equals_uint64 (pl->part_hold_back, 3 * GST_SECOND);
+  assert_equals_int (g_list_length (pl->files), 3);
+
+  mf = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  fail_unless (mf->partial_segments != NULL);
+  assert_equals_int (mf->partial_segments->len, 4);
+  fail_unless (pl->pending_file != NULL);
+  assert_equals_int64 (pl->pending_file->sequence, 103);
+  assert_equals_int (pl->pending_file->partial_segments->len, 2);
+  assert_equals_string (pl->preload_hint_uri,
+      "http://localhost/filePart103.2.ts");
+
+  /* starts on the independent part PART-HOLD-BACK away from the live edge */
+  assert_equals_int64 (pl->sequence, 102);
+  assert_equals_int (pl->part, 0);
+
+  for (i = 0; i < 4; i++) {
+    gchar *expected = g_strdup_printf ("http://localhost/filePart102.%d.ts", i);
+
+    mf = gst_m3u8_get_next_fragment (pl, TRUE, &timestamp, &discont);
+    fail_unless (mf != NULL);
+    assert_equals_string (mf->uri, expected);
+    assert_equals_uint64 (timestamp, (8 + i) * GST_SECOND);
+    assert_equals_uint64 (mf->duration, GST_SECOND);
+    assert_equals_int (discont, FALSE);
+    gst_m3u8_media_file_unref (mf);
+    g_free (expected);
+
+    gst_m3u8_advance_fragment (pl, TRUE);
+  }
+
+  /* continues with the parts of the segment being produced */
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, &timestamp, &discont);
+  fail_unless (mf != NULL);
+  assert_equals_string (mf->uri, "http://localhost/filePart103.0.ts");
+  assert_equals_uint64 (timestamp, 12 * GST_SECOND);
+  gst_m3u8_media_file_unref (mf);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  gst_m3u8_advance_fragment (pl, TRUE);
+
+  /* then the preload hint */
+  fail_unless (!gst_m3u8_has_next_fragment (pl, TRUE));
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, &timestamp, &discont);
+  fail_unless (mf != NULL);
+  assert_equals_string (mf->uri, "http://localhost/filePart103.2.ts");
+  assert_equals_uint64 (timestamp, 14 * GST_SECOND);
+  gst_m3u8_media_file_unref (mf);
+  gst_m3u8_advance_fragment (pl, TRUE);
+
+  /* nothing more until the playlist is reloaded */
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, &timestamp, &discont);
+  fail_unless (mf == NULL);
+
+  uri = gst_m3u8_get_blocking_reload_uri (pl, "http://localhost/test.m3u8");
+  assert_equals_string (uri,
+      "http://localhost/test.m3u8?_HLS_msn=103&_HLS_part=2");
+  g_free (uri);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 static Suite *
 hlsdemux_suite (void)
 {
@@ -1421,6 +1559,7 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
   tcase_add_test (tc_m3u8, test_update_playlist);
+  tcase_add_test (tc_m3u8, test_update_playlist_reuses_files);
   tcase_add_test (tc_m3u8, test_playlist_media_files);
   tcase_add_test (tc_m3u8, test_playlist_byte_range_media_files);
   tcase_add_test (tc_m3u8, test_get_next_fragment);
@@ -1437,6 +1576,7 @@ hlsdemux_suite (void)
 #endif
   tcase_add_test (tc_m3u8, test_url_with_slash_query_param);
   tcase_add_test (tc_m3u8, test_stream_inf_tag);
+  tcase_add_test (tc_m3u8, test_low_latency_playlist);
   return s;
 }
 
@@ -774,6 +774,110 @@ GST_START_TEST (test_align)
 
 GST_END_TEST;
 
+static void
+push_batch_input (guint n_bufs, GstClockTime ts)
+{
+  guint i;
+
+  for (i = 0; i < n_bufs; ++i) {
+    GstBuffer *inbuffer;
+
+    inbuffer = gst_buffer_new_and_alloc (100);
+    GST_BUFFER_TIMESTAMP (inbuffer) = ts + i * 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+  }
+}
+
+GST_START_TEST (test_batch)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "batch-packets", 1000,
+      "batch-duration", 200 * GST_MSECOND, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* neither enough packets nor enough time collected yet */
+  push_batch_input (5, 0);
+  fail_unless (buffers == NULL);
+
+  /* this one completes the 200ms batch */
+  push_batch_input (1, 200 * GST_MSECOND);
+  fail_unless (buffers != NULL);
+  gst_check_drop_buffers ();
+
+  /* remaining packets are pushed on EOS */
+  push_batch_input (2, 240 * GST_MSECOND);
+  fail_unless (buffers == NULL);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  fail_unless (buffers != NULL);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_cbr)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GList *l;
+  gsize total = 0;
+  guint null_packets = 0;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "bitrate", (guint64) 2000000, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* one second of small buffers, far below the requested bitrate */
+  push_batch_input (26, 0);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  for (l = buffers; l; l = l->next) {
+    GstMapInfo map;
+    gsize i;
+
+    gst_buffer_map (GST_BUFFER (l->data), &map, GST_MAP_READ);
+    fail_unless (map.size % 188 == 0);
+    for (i = 0; i < map.size; i += 188) {
+      fail_unless_equals_int (map.data[i], 0x47);
+      if ((GST_READ_UINT16_BE (map.data + i + 1) & 0x1fff) == 0x1fff)
+        null_packets++;
+    }
+    total += map.size;
+    gst_buffer_unmap (GST_BUFFER (l->data), &map);
+  }
+
+  /* the last buffer is due after ~1s at 2 Mbit/s, minus one frame */
+  GST_LOG ("%" G_GSIZE_FORMAT " bytes, %u null packets", total, null_packets);
+  fail_unless (null_packets > 0);
+  fail_unless (total >= 2000000 / 8 * 9 / 10);
+  fail_unless (total <= 2000000 / 8 + 10 * 188);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
 static void
 test_keyframe_propagation_check_output (GList * bufs)
 {
@@ -818,6 +922,8 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_propagate_flow_status);
   tcase_add_test (tc_chain, test_multiple_state_change);
   tcase_add_test (tc_chain, test_align);
+  tcase_add_test (tc_chain, test_batch);
+  tcase_add_test (tc_chain, test_cbr);
   tcase_add_test (tc_chain, test_keyframe_flag_propagation);
 
   return s;
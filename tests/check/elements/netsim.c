@@ -49,6 +49,49 @@ GST_START_TEST (netsim_stress_delayed)
 
 GST_END_TEST;
 
+GST_START_TEST (netsim_delayed_batch)
+{
+  GstHarness *h =
+      gst_harness_new_parse ("netsim delay-probability=1.0 min-delay=10 "
+      "max-delay=11");
+  gint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (GST_FLOW_OK,
+        gst_harness_push (h, gst_harness_create_buffer (h, 100)));
+
+  /* all three are released by the same timer, in order */
+  for (i = 0; i < 3; i++)
+    gst_buffer_unref (gst_harness_pull (h));
+  fail_unless_equals_int (0, gst_harness_buffers_in_queue (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_token_bucket)
+{
+  /* a bucket of 1000 bits that never refills */
+  GstHarness *h =
+      gst_harness_new_parse ("netsim max-kbps=0 max-bucket-size=1");
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  fail_unless_equals_int (GST_FLOW_OK,
+      gst_harness_push (h, gst_harness_create_buffer (h, 100)));
+  fail_unless_equals_int (GST_FLOW_OK,
+      gst_harness_push (h, gst_harness_create_buffer (h, 100)));
+
+  fail_unless_equals_int (1, gst_harness_buffers_in_queue (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 netsim_suite (void)
 {
@@ -58,6 +101,8 @@ netsim_suite (void)
   suite_add_tcase (s, (tc_chain = tcase_create ("general")));
   tcase_add_test (tc_chain, netsim_stress);
   tcase_add_test (tc_chain, netsim_stress_delayed);
+  tcase_add_test (tc_chain, netsim_delayed_batch);
+  tcase_add_test (tc_chain, netsim_token_bucket);
 
   return s;
 }
@@ -169,6 +169,41 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_shm_ring)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  GstSegment segment;
+
+  g_object_set (sink, "ring-slots", 3, NULL);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  buf = gst_buffer_new_allocate (NULL, 1000, NULL);
+  gst_buffer_memset (buf, 0, 0x42, 1000);
+
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (buffers == NULL)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+  fail_unless (g_list_length (buffers) == 1);
+
+  buf = buffers->data;
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless (map.size == 1000);
+  fail_unless (map.data[0] == 0x42 && map.data[999] == 0x42);
+  gst_buffer_unmap (buf, &map);
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
 static Suite *
 shm_suite (void)
 {
@@ -179,6 +214,7 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_ring);
   suite_add_tcase (s, tc);
 
   return s;
@@ -30,6 +30,9 @@
 #include <gst/check/gstcheck.h>
 
 #include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include <string.h>
 
 GST_START_TEST (test_create_and_unref)
 {
@@ -204,6 +207,84 @@ GST_START_TEST (test_roc)
 
 GST_END_TEST;
 
+#define TEST_SSRC 1356955624
+#define TEST_KEY "012345678901234567890123456789012345678901234567890123456789"
+
+static GstBuffer *
+create_rtp_buffer (guint16 seqnum)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+  guint8 *payload;
+
+  buf = gst_rtp_buffer_new_allocate (160, 0, 0);
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, 8);
+  gst_rtp_buffer_set_ssrc (&rtp, TEST_SSRC);
+  gst_rtp_buffer_set_seq (&rtp, seqnum);
+  gst_rtp_buffer_set_timestamp (&rtp, seqnum * 160);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  memset (payload, seqnum & 0xff, 160);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buf;
+}
+
+GST_START_TEST (test_buffer_list)
+{
+  GstHarness *enc, *dec;
+  GstBufferList *list;
+  GstBuffer *buf;
+  guint i;
+
+  enc = gst_harness_new_with_padnames ("srtpenc", "rtp_sink_0", "rtp_src_0");
+  gst_util_set_object_arg (G_OBJECT (enc->element), "key", TEST_KEY);
+  gst_harness_set_src_caps_str (enc, "application/x-rtp, payload=(int)8, "
+      "ssrc=(uint)1356955624");
+
+  dec = gst_harness_new_with_padnames ("srtpdec", "rtp_sink", "rtp_src");
+  gst_harness_set_src_caps_str (dec, "application/x-srtp, payload=(int)8, "
+      "ssrc=(uint)1356955624, srtp-key=(buffer)" TEST_KEY ", "
+      "srtp-cipher=(string)aes-128-icm, srtp-auth=(string)hmac-sha1-80, "
+      "srtcp-cipher=(string)aes-128-icm, srtcp-auth=(string)hmac-sha1-80");
+
+  /* the packets are protected in the list, and unprotected again */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 10; i++)
+    gst_buffer_list_add (list, create_rtp_buffer (i));
+  fail_unless_equals_int (gst_harness_push_list (enc, list), GST_FLOW_OK);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 10; i++) {
+    buf = gst_harness_pull (enc);
+    fail_unless (buf != NULL);
+    fail_unless (gst_buffer_get_size (buf) > 12 + 160);
+    gst_buffer_list_add (list, buf);
+  }
+  fail_unless_equals_int (gst_harness_push_list (dec, list), GST_FLOW_OK);
+
+  for (i = 0; i < 10; i++) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint8 *payload;
+
+    buf = gst_harness_pull (dec);
+    fail_unless (buf != NULL);
+    fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+    fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), i);
+    fail_unless_equals_int (gst_rtp_buffer_get_payload_len (&rtp), 160);
+    payload = gst_rtp_buffer_get_payload (&rtp);
+    fail_unless_equals_int (payload[0], i);
+    fail_unless_equals_int (payload[159], i);
+    gst_rtp_buffer_unmap (&rtp);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (enc);
+  gst_harness_teardown (dec);
+}
+
+GST_END_TEST;
+
 static Suite *
 srtp_suite (void)
 {
@@ -214,6 +295,7 @@ srtp_suite (void)
   tcase_add_test (tc_chain, test_create_and_unref);
   tcase_add_test (tc_chain, test_play);
   tcase_add_test (tc_chain, test_roc);
+  tcase_add_test (tc_chain, test_buffer_list);
 
   return s;
 }
@@ -115,6 +115,8 @@ typedef struct _PluginInitContext
 static const GstTestHTTPSrcCallbacks *gst_test_http_src_callbacks = NULL;
 static gpointer gst_test_http_src_callback_user_data = NULL;
 static guint gst_test_http_src_blocksize = 0;
+static guint64 gst_test_http_src_bandwidth = 0;
+static GstClockTime gst_test_http_src_rtt = 0;
 
 static GstStaticPadTemplate gst_dashdemux_test_source_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -369,6 +371,11 @@ gst_test_http_src_start (GstBaseSrc * basesrc)
   src->http_headers_event =
       gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM_STICKY, http_headers);
   g_mutex_unlock (&src->mutex);
+
+  /* simulate the round trip of the request */
+  if (gst_test_http_src_rtt > 0)
+    g_usleep (gst_test_http_src_rtt / GST_USECOND);
+
   return TRUE;
 }
 
@@ -537,6 +544,12 @@ http_events:
   }
 
   g_mutex_unlock (&src->mutex);
+
+  /* simulate the time the data takes on the network */
+  if (ret == GST_FLOW_OK && gst_test_http_src_bandwidth > 0)
+    g_usleep (gst_util_uint64_scale (bytes_read * 8, G_USEC_PER_SEC,
+            gst_test_http_src_bandwidth));
+
   return ret;
 }
 
@@ -723,3 +736,10 @@ gst_test_http_src_set_default_blocksize (guint blocksize)
 {
   gst_test_http_src_blocksize = blocksize;
 }
+
+void
+gst_test_http_src_set_network_profile (guint64 bandwidth, GstClockTime rtt)
+{
+  gst_test_http_src_bandwidth = bandwidth;
+  gst_test_http_src_rtt = rtt;
+}
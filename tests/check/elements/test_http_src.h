@@ -141,6 +141,17 @@ void gst_test_http_src_install_callbacks (const GstTestHTTPSrcCallbacks *callbac
  */
 void gst_test_http_src_set_default_blocksize (guint blocksize);
 
+/**
+ * gst_test_http_src_set_network_profile:
+ * @bandwidth: the simulated bandwidth in bits per second (0=unlimited)
+ * @rtt: the simulated round trip time of each request
+ *
+ * Makes all instances of #GstTestHTTPSrc wait for @rtt when opening a URI
+ * and deliver their data no faster than @bandwidth, so that tests can
+ * measure the behaviour of a demuxer on a given network.
+ */
+void gst_test_http_src_set_network_profile (guint64 bandwidth, GstClockTime rtt);
+
 G_END_DECLS
 
 #endif /* __GST_TEST_HTTP_SRC_H__ */
@@ -153,6 +153,40 @@ GST_START_TEST (test_still_image_with_sample)
 
 GST_END_TEST;
 
+GST_START_TEST (test_still_image_async)
+{
+  GstMessage *zbar_msg;
+  const GstStructure *s;
+  GstElement *pipeline;
+
+  pipeline = setup_pipeline ();
+  gst_child_proxy_set ((GstChildProxy *) pipeline, "zbar::async", TRUE, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  zbar_msg = get_zbar_msg_until_eos (pipeline);
+
+  /* the scanner may still be busy at EOS, stopping waits for it */
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  if (zbar_msg == NULL)
+    zbar_msg = gst_bus_pop_filtered (GST_ELEMENT_BUS (pipeline),
+        GST_MESSAGE_ELEMENT);
+  fail_unless (zbar_msg != NULL);
+
+  s = gst_message_get_structure (zbar_msg);
+  fail_unless (gst_structure_has_name (s, "barcode"));
+  fail_unless_equals_string (gst_structure_get_string (s, "symbol"),
+      "9876543210128");
+
+  gst_object_unref (pipeline);
+  gst_message_unref (zbar_msg);
+}
+
+GST_END_TEST;
+
 static Suite *
 zbar_suite (void)
 {
@@ -167,6 +201,7 @@ zbar_suite (void)
   } else {
     tcase_add_test (tc_chain, test_still_image);
     tcase_add_test (tc_chain, test_still_image_with_sample);
+    tcase_add_test (tc_chain, test_still_image_async);
   }
 
   return s;
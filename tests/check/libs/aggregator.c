@@ -612,6 +612,128 @@ GST_START_TEST (test_two_src_pipeline)
 
 GST_END_TEST;
 
+GST_START_TEST (test_stats)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  GstElement *pipeline, *src, *src1, *agg, *sink;
+  GstStructure *stats;
+  const GValue *pad_stats;
+  guint64 aggregates;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  src = gst_element_factory_make ("fakesrc", NULL);
+  g_object_set (src, "num-buffers", NUM_BUFFERS, "sizetype", 2, "sizemax", 4,
+      NULL);
+  src1 = gst_element_factory_make ("fakesrc", NULL);
+  g_object_set (src1, "num-buffers", NUM_BUFFERS, "sizetype", 2, "sizemax", 4,
+      NULL);
+  agg = gst_check_setup_element ("testaggregator");
+  sink = gst_check_setup_element ("fakesink");
+
+  fail_unless (gst_bin_add (GST_BIN (pipeline), src));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), src1));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), agg));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), sink));
+  fail_unless (gst_element_link (src, agg));
+  fail_unless (gst_element_link (src1, agg));
+  fail_unless (gst_element_link (agg, sink));
+
+  bus = gst_element_get_bus (pipeline);
+  fail_if (bus == NULL);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  fail_if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  g_object_get (agg, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_has_name (stats, "application/x-aggregator-stats"));
+  fail_unless (gst_structure_get_uint64 (stats, "aggregates", &aggregates));
+  fail_unless (aggregates > 0);
+  pad_stats = gst_structure_get_value (stats, "pad-stats");
+  fail_unless (pad_stats != NULL);
+  fail_unless_equals_int (gst_value_array_get_size (pad_stats), 2);
+  gst_structure_free (stats);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+#define MANY_PADS_NUM_PADS 32
+#define MANY_PADS_NUM_BUFFERS 1000
+static void
+_test_many_pads_throughput (gboolean coalesce_wakeups)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  GstElement *pipeline, *src, *agg, *sink;
+  gint64 start, elapsed;
+  gint count = 0;
+  gint i;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  agg = gst_check_setup_element ("testaggregator");
+  g_object_set (agg, "coalesce-wakeups", coalesce_wakeups, NULL);
+  sink = gst_check_setup_element ("fakesink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", (GCallback) handoff, &count);
+
+  fail_unless (gst_bin_add (GST_BIN (pipeline), agg));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), sink));
+  fail_unless (gst_element_link (agg, sink));
+
+  for (i = 0; i < MANY_PADS_NUM_PADS; i++) {
+    src = gst_element_factory_make ("fakesrc", NULL);
+    g_object_set (src, "num-buffers", MANY_PADS_NUM_BUFFERS, "sizetype", 2,
+        "sizemax", 4, NULL);
+    fail_unless (gst_bin_add (GST_BIN (pipeline), src));
+    fail_unless (gst_element_link (src, agg));
+  }
+
+  bus = gst_element_get_bus (pipeline);
+  fail_if (bus == NULL);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  fail_if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  elapsed = g_get_monotonic_time () - start;
+
+  fail_unless_equals_int (count, MANY_PADS_NUM_BUFFERS);
+
+  /* Not a pass/fail criterion, but useful to compare locking changes with
+   * GST_DEBUG=check:4 */
+  GST_INFO ("aggregated %d buffers from %d pads in %" G_GINT64_FORMAT
+      " us (%.1f us per output buffer, coalesce-wakeups %d)",
+      MANY_PADS_NUM_BUFFERS, MANY_PADS_NUM_PADS, elapsed,
+      (gdouble) elapsed / MANY_PADS_NUM_BUFFERS, coalesce_wakeups);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_START_TEST (test_many_pads_throughput)
+{
+  _test_many_pads_throughput (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_many_pads_throughput_coalesced)
+{
+  _test_many_pads_throughput (TRUE);
+}
+
+GST_END_TEST;
+
 static GstPadProbeReturn
 _drop_buffer_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 {
@@ -1185,6 +1307,9 @@ gst_aggregator_suite (void)
   tcase_add_test (general, test_infinite_seek_50_src_live);
   tcase_add_test (general, test_linear_pipeline);
   tcase_add_test (general, test_two_src_pipeline);
+  tcase_add_test (general, test_stats);
+  tcase_add_test (general, test_many_pads_throughput);
+  tcase_add_test (general, test_many_pads_throughput_coalesced);
   tcase_add_test (general, test_timeout_pipeline);
   tcase_add_test (general, test_timeout_pipeline_with_wait);
   tcase_add_test (general, test_add_remove);
@@ -211,6 +211,67 @@ GST_START_TEST (test_h264_parse_slice_eoseq_slice)
 
 GST_END_TEST;
 
+#define SCAN_NUM_NALS 64
+#define SCAN_NAL_SIZE (64 * 1024)
+
+/* Identifies all NALs of a large buffer of slices with random payload, as
+ * in high bitrate intra streams, where scanning for the next start code
+ * is most of the work */
+GST_START_TEST (test_h264_parse_scan_start_codes)
+{
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  GstH264NalParser *const parser = gst_h264_nal_parser_new ();
+  gsize buf_size = SCAN_NUM_NALS * (SCAN_NAL_SIZE + 4);
+  guint8 *buf = g_malloc (buf_size);
+  GRand *rand = g_rand_new_with_seed (0);
+  guint i, j, offset = 0, n_nals = 0;
+  gint64 start, elapsed;
+
+  for (i = 0; i < SCAN_NUM_NALS; i++) {
+    guint8 *nal = buf + i * (SCAN_NAL_SIZE + 4);
+
+    nal[0] = nal[1] = nal[2] = 0x00;
+    nal[3] = 0x01;
+    nal[4] = 0x25;              /* IDR slice */
+    for (j = 5; j < SCAN_NAL_SIZE + 4; j++) {
+      nal[j] = g_rand_int (rand) & 0xff;
+      /* emulation prevention */
+      if (nal[j - 2] == 0x00 && nal[j - 1] == 0x00 && nal[j] <= 0x03)
+        nal[j] = 0x03;
+    }
+    /* trailing bits */
+    nal[SCAN_NAL_SIZE + 3] = 0x80;
+  }
+
+  start = g_get_monotonic_time ();
+  do {
+    res = gst_h264_parser_identify_nalu (parser, buf, offset, buf_size, &nalu);
+    if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+      break;
+
+    assert_equals_int (nalu.type, GST_H264_NAL_SLICE_IDR);
+    /* 4 byte start codes are only reported as such for SPS/PPS/AUD */
+    assert_equals_int (nalu.sc_offset, n_nals * (SCAN_NAL_SIZE + 4) + 1);
+    n_nals++;
+    offset = nalu.offset + nalu.size;
+  } while (res == GST_H264_PARSER_OK);
+  elapsed = g_get_monotonic_time () - start;
+
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  assert_equals_int (n_nals, SCAN_NUM_NALS);
+
+  GST_INFO ("scanned %" G_GSIZE_FORMAT " bytes in %" G_GINT64_FORMAT
+      " us (%.1f MB/s)", buf_size, elapsed,
+      elapsed > 0 ? (gdouble) buf_size / elapsed : 0.0);
+
+  g_rand_free (rand);
+  g_free (buf);
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 h264parser_suite (void)
 {
@@ -221,6 +282,7 @@ h264parser_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_h264_parse_slice_dpa);
   tcase_add_test (tc_chain, test_h264_parse_slice_eoseq_slice);
+  tcase_add_test (tc_chain, test_h264_parse_scan_start_codes);
 
   return s;
 }
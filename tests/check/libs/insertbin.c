@@ -365,6 +365,73 @@ GST_START_TEST (test_insertbin_simple)
 
 GST_END_TEST;
 
+GST_START_TEST (test_insertbin_prepare_keyframe)
+{
+  GstElement *insertbin;
+  GstElement *elem;
+  GstPad *srcpad;
+  GstPad *sinkpad;
+  GstBuffer *buffer;
+  GstCaps *caps;
+
+  insertbin = gst_insert_bin_new (NULL);
+  g_object_set (insertbin, "prepare-elements", TRUE, "swap-on-keyframe", TRUE,
+      NULL);
+  srcpad = gst_check_setup_src_pad (insertbin, &srcpad_template);
+  sinkpad = gst_check_setup_sink_pad (insertbin, &sinkpad_template);
+
+  fail_unless (gst_pad_set_active (srcpad, TRUE));
+  fail_unless (gst_pad_set_active (sinkpad, TRUE));
+  fail_unless (gst_element_set_state (insertbin,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_new_empty_simple ("video/test");
+  gst_check_setup_events (srcpad, insertbin, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+
+  push_thread = g_thread_self ();
+  push_buffer (srcpad, 0);
+
+  /* an element that does not accept the current caps is rejected right away,
+   * without waiting for a keyframe */
+  elem = gst_element_factory_make ("capsfilter", NULL);
+  caps = gst_caps_new_empty_simple ("video/other");
+  g_object_set (elem, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  gst_insert_bin_append (GST_INSERT_BIN (insertbin), elem, fail_cb, NULL);
+  check_reset_cb_count (1);
+
+  /* the element is prepared before the stream is blocked, and only linked in
+   * front of the next keyframe */
+  elem = gst_element_factory_make ("identity", NULL);
+  gst_insert_bin_append (GST_INSERT_BIN (insertbin), elem, success_cb, NULL);
+  fail_unless (cb_count == 0);
+  fail_unless (GST_STATE (elem) == GST_STATE_PAUSED);
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  fail_unless (gst_pad_push (srcpad, buffer) == GST_FLOW_OK);
+  fail_unless (cb_count == 0);
+  fail_unless (GST_OBJECT_PARENT (elem) == NULL);
+  gst_check_drop_buffers ();
+
+  push_buffer (srcpad, 1);
+  fail_unless (GST_OBJECT_PARENT (elem) == GST_OBJECT (insertbin));
+  fail_unless (GST_STATE (elem) == GST_STATE_PLAYING);
+
+  fail_unless (gst_element_set_state (insertbin,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  push_thread = NULL;
+
+  gst_check_teardown_sink_pad (insertbin);
+  gst_check_teardown_src_pad (insertbin);
+  gst_check_teardown_element (insertbin);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 insert_bin_suite (void)
@@ -374,6 +441,7 @@ insert_bin_suite (void)
 
   suite_add_tcase (s, tc_basic);
   tcase_add_test (tc_basic, test_insertbin_simple);
+  tcase_add_test (tc_basic, test_insertbin_prepare_keyframe);
 
   return s;
 }
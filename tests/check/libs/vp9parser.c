@@ -0,0 +1,87 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstvp9parser.h>
+
+/* two frames of 3 and 260 bytes, followed by an index with 2 bytes per
+ * frame size */
+static guint8 vp9_superframe_data[3 + 260 + 6];
+
+static void
+make_superframe (void)
+{
+  guint8 *index = vp9_superframe_data + 3 + 260;
+  guint8 marker = 0xc0 | ((2 - 1) << 3) | (2 - 1);
+
+  memset (vp9_superframe_data, 0x82, 3 + 260);
+  index[0] = marker;
+  GST_WRITE_UINT16_LE (index + 1, 3);
+  GST_WRITE_UINT16_LE (index + 3, 260);
+  index[5] = marker;
+}
+
+GST_START_TEST (test_vp9_parse_superframe)
+{
+  GstVp9Parser *parser;
+  GstVp9SuperframeInfo info;
+
+  make_superframe ();
+  parser = gst_vp9_parser_new ();
+
+  assert_equals_int (gst_vp9_parser_parse_superframe_info (parser, &info,
+          vp9_superframe_data, sizeof (vp9_superframe_data)),
+      GST_VP9_PARSER_OK);
+  assert_equals_int (info.frames_in_superframe, 2);
+  assert_equals_int (info.bytes_per_framesize, 2);
+  assert_equals_int (info.frame_sizes[0], 3);
+  assert_equals_int (info.frame_sizes[1], 260);
+  assert_equals_int (info.superframe_index_size, 6);
+
+  /* without the index, it is a single frame */
+  assert_equals_int (gst_vp9_parser_parse_superframe_info (parser, &info,
+          vp9_superframe_data, 3 + 260), GST_VP9_PARSER_OK);
+  assert_equals_int (info.frames_in_superframe, 1);
+  assert_equals_int (info.frame_sizes[0], 3 + 260);
+  assert_equals_int (info.superframe_index_size, 0);
+
+  /* an index referring to more data than there is */
+  GST_WRITE_UINT16_LE (vp9_superframe_data + 3 + 260 + 3, 261);
+  assert_equals_int (gst_vp9_parser_parse_superframe_info (parser, &info,
+          vp9_superframe_data, sizeof (vp9_superframe_data)),
+      GST_VP9_PARSER_BROKEN_DATA);
+
+  gst_vp9_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static Suite *
+vp9parsers_suite (void)
+{
+  Suite *s = suite_create ("VP9 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_vp9_parse_superframe);
+
+  return s;
+}
+
+GST_CHECK_MAIN (vp9parsers);
@@ -0,0 +1,531 @@
+/*
+ * parse-bench.c - Measure the speed of the codec and MPEG-TS section parsers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Parses the given files a number of times and reports the throughput and
+ * the time spent per unit (NAL unit, start code packet, frame or section).
+ *
+ *   parse-bench --codec=h264 --iterations=20 stream.h264
+ *   parse-bench --codec=ts --csv capture.ts >> results.csv
+ *
+ * The h264, h265 and mpeg2 codecs take byte-stream (start code) files, vp9
+ * takes IVF files and ts takes MPEG transport streams, of which the PSI and
+ * SI sections are parsed. */
+
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+#include <gst/codecparsers/gstmpegvideoparser.h>
+#include <gst/codecparsers/gstvp9parser.h>
+#include <gst/mpegts/mpegts.h>
+
+#define IVF_FILE_HDR_SIZE       32
+#define IVF_FRAME_HDR_SIZE      12
+#define TS_PACKET_SIZE          188
+
+typedef struct
+{
+  const gchar *name;
+  /* prepares the data once, before the measurements */
+  gpointer (*prepare) (const guint8 * data, gsize size);
+  /* parses everything and returns the number of units */
+  guint (*run) (gpointer prepared, const guint8 * data, gsize size);
+  void (*free) (gpointer prepared);
+} ParseBenchmark;
+
+static guint
+run_h264 (gpointer prepared, const guint8 * data, gsize size)
+{
+  GstH264NalParser *parser;
+  GstH264NalUnit nalu;
+  GstH264ParserResult res;
+  guint offset = 0, count = 0;
+
+  parser = gst_h264_nal_parser_new ();
+
+  do {
+    res = gst_h264_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+      break;
+
+    switch (nalu.type) {
+      case GST_H264_NAL_SLICE:
+      case GST_H264_NAL_SLICE_IDR:{
+        GstH264SliceHdr slice;
+
+        gst_h264_parser_parse_slice_hdr (parser, &nalu, &slice, TRUE, TRUE);
+        break;
+      }
+      case GST_H264_NAL_SEI:{
+        GArray *messages = NULL;
+
+        if (gst_h264_parser_parse_sei (parser, &nalu, &messages) ==
+            GST_H264_PARSER_OK)
+          g_array_free (messages, TRUE);
+        break;
+      }
+      default:
+        /* updates the parameter sets */
+        gst_h264_parser_parse_nal (parser, &nalu);
+        break;
+    }
+
+    offset = nalu.offset + nalu.size;
+    count++;
+  } while (res == GST_H264_PARSER_OK);
+
+  gst_h264_nal_parser_free (parser);
+
+  return count;
+}
+
+static guint
+run_h265 (gpointer prepared, const guint8 * data, gsize size)
+{
+  GstH265Parser *parser;
+  GstH265NalUnit nalu;
+  GstH265ParserResult res;
+  guint offset = 0, count = 0;
+
+  parser = gst_h265_parser_new ();
+
+  do {
+    res = gst_h265_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H265_PARSER_OK && res != GST_H265_PARSER_NO_NAL_END)
+      break;
+
+    if (nalu.type <= GST_H265_NAL_SLICE_CRA_NUT) {
+      GstH265SliceHdr slice;
+
+      gst_h265_parser_parse_slice_hdr (parser, &nalu, &slice);
+    } else if (nalu.type == GST_H265_NAL_PREFIX_SEI ||
+        nalu.type == GST_H265_NAL_SUFFIX_SEI) {
+      GArray *messages = NULL;
+
+      if (gst_h265_parser_parse_sei (parser, &nalu, &messages) ==
+          GST_H265_PARSER_OK)
+        g_array_free (messages, TRUE);
+    } else {
+      /* updates the parameter sets */
+      gst_h265_parser_parse_nal (parser, &nalu);
+    }
+
+    offset = nalu.offset + nalu.size;
+    count++;
+  } while (res == GST_H265_PARSER_OK);
+
+  gst_h265_parser_free (parser);
+
+  return count;
+}
+
+static guint
+run_mpeg2 (gpointer prepared, const guint8 * data, gsize size)
+{
+  GstMpegVideoPacket packet;
+  GstMpegVideoSequenceHdr seqhdr;
+  GstMpegVideoPictureHdr pichdr;
+  GstMpegVideoPictureExt picext;
+  GstMpegVideoGop gop;
+  guint offset = 0, count = 0;
+
+  while (offset < size && gst_mpeg_video_parse (&packet, data, size, offset)) {
+    switch (packet.type) {
+      case GST_MPEG_VIDEO_PACKET_SEQUENCE:
+        gst_mpeg_video_packet_parse_sequence_header (&packet, &seqhdr);
+        break;
+      case GST_MPEG_VIDEO_PACKET_PICTURE:
+        gst_mpeg_video_packet_parse_picture_header (&packet, &pichdr);
+        break;
+      case GST_MPEG_VIDEO_PACKET_GOP:
+        gst_mpeg_video_packet_parse_gop (&packet, &gop);
+        break;
+      case GST_MPEG_VIDEO_PACKET_EXTENSION:
+        if (packet.size > 0 && (packet.data[packet.offset] >> 4) ==
+            GST_MPEG_VIDEO_PACKET_EXT_PICTURE)
+          gst_mpeg_video_packet_parse_picture_extension (&packet, &picext);
+        break;
+      default:
+        break;
+    }
+    count++;
+
+    if (packet.size < 0)
+      break;
+    offset = packet.offset + packet.size;
+  }
+
+  return count;
+}
+
+static guint
+run_vp9 (gpointer prepared, const guint8 * data, gsize size)
+{
+  GstVp9Parser *parser;
+  GstVp9FrameHdr frame_hdr;
+  gsize offset = IVF_FILE_HDR_SIZE;
+  guint count = 0;
+
+  parser = gst_vp9_parser_new ();
+
+  while (offset + IVF_FRAME_HDR_SIZE <= size) {
+    guint32 frame_size = GST_READ_UINT32_LE (data + offset);
+
+    offset += IVF_FRAME_HDR_SIZE;
+    if (frame_size > size - offset)
+      break;
+
+    gst_vp9_parser_parse_frame_header (parser, &frame_hdr, data + offset,
+        frame_size);
+    offset += frame_size;
+    count++;
+  }
+
+  gst_vp9_parser_free (parser);
+
+  return count;
+}
+
+/* Sections of a transport stream, extracted before the measurements so that
+ * only gst_mpegts_section_*() is timed */
+typedef struct
+{
+  guint16 pid;
+  GBytes *data;
+} TsSection;
+
+typedef struct
+{
+  GArray *sections;
+  GHashTable *pending;          /* pid -> GByteArray */
+  GHashTable *pmt_pids;
+} TsPrepared;
+
+static void
+ts_add_section (TsPrepared * ts, guint16 pid, const guint8 * data, gsize size)
+{
+  TsSection section;
+
+  section.pid = pid;
+  section.data = g_bytes_new (data, size);
+  g_array_append_val (ts->sections, section);
+
+  /* the PMTs are on the pids listed in the PAT */
+  if (pid == 0x0000 && data[0] == 0x00) {
+    GstMpegtsSection *s;
+    GPtrArray *pat;
+    guint i;
+
+    s = gst_mpegts_section_new (pid, g_memdup (data, size), size);
+    if (s && (pat = gst_mpegts_section_get_pat (s))) {
+      for (i = 0; i < pat->len; i++) {
+        GstMpegtsPatProgram *program = g_ptr_array_index (pat, i);
+
+        if (program->program_number != 0)
+          g_hash_table_add (ts->pmt_pids,
+              GUINT_TO_POINTER (program->network_or_program_map_PID));
+      }
+      g_ptr_array_unref (pat);
+    }
+    if (s)
+      gst_mpegts_section_unref (s);
+  }
+}
+
+static void
+ts_push_payload (TsPrepared * ts, guint16 pid, const guint8 * payload,
+    gsize size, gboolean unit_start)
+{
+  GByteArray *acc;
+
+  acc = g_hash_table_lookup (ts->pending, GUINT_TO_POINTER (pid));
+  if (!acc) {
+    acc = g_byte_array_new ();
+    g_hash_table_insert (ts->pending, GUINT_TO_POINTER (pid), acc);
+  }
+
+  if (unit_start) {
+    guint pointer = payload[0];
+
+    if (pointer + 1 > size)
+      return;
+    /* the end of the previous section comes before the pointer */
+    g_byte_array_append (acc, payload + 1, pointer);
+    payload += pointer + 1;
+    size -= pointer + 1;
+    while (acc->len >= 3) {
+      gsize section_size = 3 + (GST_READ_UINT16_BE (acc->data + 1) & 0x0fff);
+
+      if (acc->data[0] == 0xff || acc->len < section_size)
+        break;
+      ts_add_section (ts, pid, acc->data, section_size);
+      g_byte_array_remove_range (acc, 0, section_size);
+    }
+    g_byte_array_set_size (acc, 0);
+  } else if (acc->len == 0) {
+    /* not in a section */
+    return;
+  }
+
+  g_byte_array_append (acc, payload, size);
+  while (acc->len >= 3) {
+    gsize section_size = 3 + (GST_READ_UINT16_BE (acc->data + 1) & 0x0fff);
+
+    if (acc->data[0] == 0xff) {
+      /* stuffing until the next unit start */
+      g_byte_array_set_size (acc, 0);
+      break;
+    }
+    if (acc->len < section_size)
+      break;
+    ts_add_section (ts, pid, acc->data, section_size);
+    g_byte_array_remove_range (acc, 0, section_size);
+  }
+}
+
+static gpointer
+prepare_ts (const guint8 * data, gsize size)
+{
+  TsPrepared *ts;
+  gsize offset;
+
+  ts = g_new0 (TsPrepared, 1);
+  ts->sections = g_array_new (FALSE, FALSE, sizeof (TsSection));
+  ts->pending = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) g_byte_array_unref);
+  ts->pmt_pids = g_hash_table_new (NULL, NULL);
+
+  for (offset = 0; offset + TS_PACKET_SIZE <= size; offset += TS_PACKET_SIZE) {
+    const guint8 *p = data + offset;
+    guint16 pid;
+    guint header_size = 4;
+
+    if (p[0] != 0x47)
+      continue;
+
+    pid = GST_READ_UINT16_BE (p + 1) & 0x1fff;
+    /* PSI and DVB SI, and the PMTs */
+    if (pid > 0x001f && !g_hash_table_contains (ts->pmt_pids,
+            GUINT_TO_POINTER (pid)))
+      continue;
+
+    /* no payload */
+    if (!(p[3] & 0x10))
+      continue;
+    if (p[3] & 0x20)
+      header_size += 1 + p[4];
+    if (header_size >= TS_PACKET_SIZE)
+      continue;
+
+    ts_push_payload (ts, pid, p + header_size, TS_PACKET_SIZE - header_size,
+        (p[1] & 0x40) != 0);
+  }
+
+  return ts;
+}
+
+static guint
+run_ts (gpointer prepared, const guint8 * data, gsize size)
+{
+  TsPrepared *ts = prepared;
+  guint i, count = 0;
+
+  for (i = 0; i < ts->sections->len; i++) {
+    TsSection *s = &g_array_index (ts->sections, TsSection, i);
+    GstMpegtsSection *section;
+    gconstpointer section_data;
+    gsize section_size;
+
+    section_data = g_bytes_get_data (s->data, &section_size);
+    section = gst_mpegts_section_new (s->pid,
+        g_memdup (section_data, section_size), section_size);
+    if (!section)
+      continue;
+
+    switch (GST_MPEGTS_SECTION_TYPE (section)) {
+      case GST_MPEGTS_SECTION_PAT:{
+        GPtrArray *pat = gst_mpegts_section_get_pat (section);
+
+        if (pat)
+          g_ptr_array_unref (pat);
+        break;
+      }
+      case GST_MPEGTS_SECTION_PMT:
+        gst_mpegts_section_get_pmt (section);
+        break;
+      case GST_MPEGTS_SECTION_NIT:
+        gst_mpegts_section_get_nit (section);
+        break;
+      case GST_MPEGTS_SECTION_SDT:
+        gst_mpegts_section_get_sdt (section);
+        break;
+      case GST_MPEGTS_SECTION_EIT:
+        gst_mpegts_section_get_eit (section);
+        break;
+      case GST_MPEGTS_SECTION_TDT:{
+        GstDateTime *dt = gst_mpegts_section_get_tdt (section);
+
+        if (dt)
+          gst_date_time_unref (dt);
+        break;
+      }
+      case GST_MPEGTS_SECTION_TOT:
+        gst_mpegts_section_get_tot (section);
+        break;
+      default:
+        break;
+    }
+
+    gst_mpegts_section_unref (section);
+    count++;
+  }
+
+  return count;
+}
+
+static void
+free_ts (gpointer prepared)
+{
+  TsPrepared *ts = prepared;
+  guint i;
+
+  for (i = 0; i < ts->sections->len; i++)
+    g_bytes_unref (g_array_index (ts->sections, TsSection, i).data);
+  g_array_free (ts->sections, TRUE);
+  g_hash_table_unref (ts->pending);
+  g_hash_table_unref (ts->pmt_pids);
+  g_free (ts);
+}
+
+static const ParseBenchmark benchmarks[] = {
+  {"h264", NULL, run_h264, NULL},
+  {"h265", NULL, run_h265, NULL},
+  {"mpeg2", NULL, run_mpeg2, NULL},
+  {"vp9", NULL, run_vp9, NULL},
+  {"ts", prepare_ts, run_ts, free_ts},
+};
+
+static gchar *codec = NULL;
+static gint iterations = 10;
+static gboolean csv = FALSE;
+
+static GOptionEntry entries[] = {
+  {"codec", 'c', 0, G_OPTION_ARG_STRING, &codec,
+      "Parser to measure: h264, h265, mpeg2, vp9 or ts", "CODEC"},
+  {"iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+      "Number of times each file is parsed", "N"},
+  {"csv", 0, 0, G_OPTION_ARG_NONE, &csv,
+      "Print the results as comma separated values", NULL},
+  {NULL}
+};
+
+static void
+bench_file (const ParseBenchmark * bench, const gchar * filename)
+{
+  GError *error = NULL;
+  gchar *contents;
+  gsize size;
+  gpointer prepared = NULL;
+  guint units = 0;
+  gint64 start, elapsed;
+  gdouble seconds, mb_per_sec, ns_per_unit;
+  gint i;
+
+  if (!g_file_get_contents (filename, &contents, &size, &error)) {
+    g_printerr ("Could not read %s: %s\n", filename, error->message);
+    g_clear_error (&error);
+    return;
+  }
+
+  if (bench->prepare)
+    prepared = bench->prepare ((const guint8 *) contents, size);
+
+  /* one run to warm up the caches */
+  bench->run (prepared, (const guint8 *) contents, size);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    units += bench->run (prepared, (const guint8 *) contents, size);
+  elapsed = g_get_monotonic_time () - start;
+
+  seconds = elapsed / (gdouble) G_USEC_PER_SEC;
+  mb_per_sec =
+      seconds > 0 ? (size * (gdouble) iterations) / (1024 * 1024) / seconds : 0;
+  ns_per_unit = units > 0 ? elapsed * 1000.0 / units : 0;
+
+  if (csv) {
+    g_print ("%s,%s,%d,%" G_GSIZE_FORMAT ",%u,%f,%f,%f\n", bench->name,
+        filename, iterations, size, units / iterations, seconds, mb_per_sec,
+        ns_per_unit);
+  } else {
+    g_print ("%s: %s\n", bench->name, filename);
+    g_print ("  %-32s : %" G_GSIZE_FORMAT "\n", "bytes", size);
+    g_print ("  %-32s : %u\n", "units per iteration", units / iterations);
+    g_print ("  %-32s : %.3f\n", "seconds", seconds);
+    g_print ("  %-32s : %.2f\n", "MB/s", mb_per_sec);
+    g_print ("  %-32s : %.1f\n", "ns per unit", ns_per_unit);
+  }
+
+  if (bench->free)
+    bench->free (prepared);
+  g_free (contents);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *error = NULL;
+  const ParseBenchmark *bench = NULL;
+  gint i;
+
+  ctx = g_option_context_new ("FILE... - measure the codec parsers");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error)) {
+    g_printerr ("Error initializing: %s\n", error->message);
+    g_option_context_free (ctx);
+    g_clear_error (&error);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  gst_mpegts_initialize ();
+
+  for (i = 0; codec && i < G_N_ELEMENTS (benchmarks); i++) {
+    if (g_strcmp0 (codec, benchmarks[i].name) == 0)
+      bench = &benchmarks[i];
+  }
+  if (!bench || argc < 2 || iterations < 1) {
+    g_printerr ("Usage: %s --codec=h264|h265|mpeg2|vp9|ts FILE...\n",
+        argv[0]);
+    return 1;
+  }
+
+  if (csv)
+    g_print ("codec,file,iterations,bytes,units,seconds,mb_per_sec,"
+        "ns_per_unit\n");
+
+  for (i = 1; i < argc; i++)
+    bench_file (bench, argv[i]);
+
+  g_free (codec);
+
+  return 0;
+}
@@ -0,0 +1,243 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures how the aggregator based mixers scale with the number of inputs.
+ *
+ * For each combination of input count, size and format, a pipeline with that
+ * many test sources feeding the mixer is run unsynchronized until EOS, and
+ * the output buffers per second, the CPU time per input and the time until
+ * the first output buffer are reported:
+ *
+ *   mixer-bench --mixer=compositor --inputs=1,4,16,64 \
+ *       --sizes=640x360,1920x1080 --formats=I420,BGRA
+ *   mixer-bench --mixer=audiomixer --inputs=2,8,32 --csv
+ *
+ * Each source is followed by a queue so that generating the test data runs
+ * in its own thread and mostly stays out of the mixer's measurements. */
+
+#include <stdio.h>
+#include <time.h>
+#include <gst/gst.h>
+
+static gchar *mixer = NULL;
+static gchar *inputs = NULL;
+static gchar *sizes = NULL;
+static gchar *formats = NULL;
+static gint num_buffers = 300;
+static gboolean csv = FALSE;
+
+static GOptionEntry entries[] = {
+  {"mixer", 'm', 0, G_OPTION_ARG_STRING, &mixer,
+      "Mixer element: compositor, glvideomixer or audiomixer", "NAME"},
+  {"inputs", 'i', 0, G_OPTION_ARG_STRING, &inputs,
+      "Comma separated numbers of inputs (default 1,2,4,8,16,32,64)", "LIST"},
+  {"sizes", 's', 0, G_OPTION_ARG_STRING, &sizes,
+      "Comma separated video sizes (default 1280x720)", "LIST"},
+  {"formats", 'f', 0, G_OPTION_ARG_STRING, &formats,
+      "Comma separated raw formats (default I420 for video, S16LE for audio)",
+      "LIST"},
+  {"buffers", 'n', 0, G_OPTION_ARG_INT, &num_buffers,
+      "Number of buffers produced by each input", "N"},
+  {"csv", 0, 0, G_OPTION_ARG_NONE, &csv,
+      "Print the results as comma separated values", NULL},
+  {NULL}
+};
+
+typedef struct
+{
+  guint buffers;
+  gint64 first_buffer;          /* monotonic time */
+} BenchCounters;
+
+static void
+handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    BenchCounters * counters)
+{
+  if (counters->buffers++ == 0)
+    counters->first_buffer = g_get_monotonic_time ();
+}
+
+static gchar *
+make_pipeline_description (gboolean audio, guint n_inputs, gint width,
+    gint height, const gchar * format)
+{
+  GString *desc;
+  guint i;
+
+  desc = g_string_new (NULL);
+  g_string_append_printf (desc, "%s name=mix ! fakesink name=sink sync=false "
+      "signal-handoffs=true ", mixer);
+
+  for (i = 0; i < n_inputs; i++) {
+    if (audio) {
+      g_string_append_printf (desc, "audiotestsrc num-buffers=%d "
+          "samplesperbuffer=1024 ! audio/x-raw,format=%s,rate=48000,"
+          "channels=2 ! queue ! mix. ", num_buffers, format);
+    } else {
+      g_string_append_printf (desc, "videotestsrc num-buffers=%d "
+          "pattern=ball ! video/x-raw,format=%s,width=%d,height=%d,"
+          "framerate=30/1 ! queue ! mix. ", num_buffers, format, width,
+          height);
+    }
+  }
+
+  return g_string_free (desc, FALSE);
+}
+
+static void
+run_one (gboolean audio, guint n_inputs, gint width, gint height,
+    const gchar * format)
+{
+  GstElement *pipeline, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *error = NULL;
+  BenchCounters counters = { 0, };
+  gchar *desc;
+  gint64 start, elapsed;
+  clock_t cpu_start, cpu;
+  gdouble seconds, cpu_seconds;
+
+  desc = make_pipeline_description (audio, n_inputs, width, height, format);
+  pipeline = gst_parse_launch (desc, &error);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("Could not create the pipeline: %s\n", error->message);
+    g_clear_error (&error);
+    return;
+  }
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff), &counters);
+  gst_object_unref (sink);
+
+  bus = gst_element_get_bus (pipeline);
+
+  cpu_start = clock ();
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = g_get_monotonic_time () - start;
+  cpu = clock () - cpu_start;
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &error, NULL);
+    g_printerr ("%s with %u inputs failed: %s\n", mixer, n_inputs,
+        error->message);
+    g_clear_error (&error);
+  } else {
+    seconds = elapsed / (gdouble) G_USEC_PER_SEC;
+    cpu_seconds = cpu / (gdouble) CLOCKS_PER_SEC;
+
+    if (csv) {
+      g_print ("%s,%u,%dx%d,%s,%u,%f,%f,%f,%f\n", mixer, n_inputs, width,
+          height, format, counters.buffers, seconds,
+          counters.buffers / seconds, cpu_seconds / n_inputs,
+          (counters.first_buffer - start) / 1000.0);
+    } else {
+      if (audio)
+        g_print ("%s, %u inputs, %s:\n", mixer, n_inputs, format);
+      else
+        g_print ("%s, %u inputs, %dx%d %s:\n", mixer, n_inputs, width, height,
+            format);
+      g_print ("  %-32s : %u\n", "output buffers", counters.buffers);
+      g_print ("  %-32s : %.2f\n", "output buffers per second",
+          counters.buffers / seconds);
+      g_print ("  %-32s : %.1f%%\n", "CPU usage",
+          100.0 * cpu_seconds / seconds);
+      g_print ("  %-32s : %.3f\n", "CPU seconds per input",
+          cpu_seconds / n_inputs);
+      g_print ("  %-32s : %.1f\n", "ms until the first buffer",
+          (counters.first_buffer - start) / 1000.0);
+    }
+  }
+
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gchar **input_list, **size_list, **format_list;
+  gboolean audio;
+  gint i, j, k;
+
+  ctx = g_option_context_new (NULL);
+  g_option_context_set_summary (ctx, "Measures the throughput of a mixer "
+      "with an increasing number of inputs.");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    if (err)
+      g_printerr ("Error initializing: %s\n", err->message);
+    else
+      g_printerr ("Error initializing: Unknown error!\n");
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (!mixer)
+    mixer = g_strdup ("compositor");
+  audio = g_strcmp0 (mixer, "audiomixer") == 0;
+
+  input_list = g_strsplit (inputs ? inputs : "1,2,4,8,16,32,64", ",", -1);
+  size_list = g_strsplit (sizes && !audio ? sizes : "1280x720", ",", -1);
+  format_list = g_strsplit (formats ? formats : (audio ? "S16LE" : "I420"),
+      ",", -1);
+
+  if (csv)
+    g_print ("mixer,inputs,size,format,buffers,seconds,buffers_per_sec,"
+        "cpu_seconds_per_input,first_buffer_ms\n");
+
+  for (k = 0; format_list[k]; k++) {
+    for (j = 0; size_list[j]; j++) {
+      gint width, height;
+
+      if (sscanf (size_list[j], "%dx%d", &width, &height) != 2) {
+        g_printerr ("Invalid size %s\n", size_list[j]);
+        continue;
+      }
+
+      for (i = 0; input_list[i]; i++) {
+        guint n_inputs = g_ascii_strtoull (input_list[i], NULL, 10);
+
+        if (n_inputs > 0)
+          run_one (audio, n_inputs, width, height, format_list[k]);
+      }
+    }
+  }
+
+  g_strfreev (input_list);
+  g_strfreev (size_list);
+  g_strfreev (format_list);
+  g_free (mixer);
+  g_free (inputs);
+  g_free (sizes);
+  g_free (formats);
+
+  return 0;
+}